@@ -0,0 +1,19 @@
+include(ExternalProject)
+
+set(dlpack_URL https://github.com/dmlc/dlpack.git)
+set(dlpack_TAG v0.8)
+
+# Download DLPack (header-only)
+ExternalProject_Add(
+  dlpack
+  PREFIX dlpack
+  GIT_REPOSITORY ${dlpack_URL}
+  GIT_TAG ${dlpack_TAG}
+  CONFIGURE_COMMAND ""
+  BUILD_COMMAND ""
+  INSTALL_COMMAND ""
+)
+ExternalProject_Get_Property(dlpack source_dir)
+set(DLPACK_SOURCE_DIR ${source_dir})
+
+set(dlpack_INCLUDE_DIRS ${DLPACK_SOURCE_DIR}/include)
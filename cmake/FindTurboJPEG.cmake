@@ -0,0 +1,34 @@
+#
+# Find the libjpeg-turbo TurboJPEG library
+#
+# Sets:
+#  TurboJPEG_INCLUDE_DIRS - location of turbojpeg.h
+#  TurboJPEG_LIBRARIES    - the TurboJPEG library
+#  TurboJPEG_FOUND        - truthy if TurboJPEG was found.
+#
+
+find_package(PkgConfig QUIET)
+if (PKG_CONFIG_FOUND)
+  pkg_check_modules(PC_TurboJPEG QUIET libturbojpeg)
+endif()
+
+find_path(
+  TurboJPEG_INCLUDE_DIRS
+  turbojpeg.h
+  HINTS ${PC_TurboJPEG_INCLUDEDIR} ${PC_TurboJPEG_INCLUDE_DIRS}
+  PATH_SUFFIXES include
+  PATHS ${TurboJPEG_BASE_DIR}
+  )
+find_library(
+  TurboJPEG_LIBRARIES
+  NAMES turbojpeg libturbojpeg
+  HINTS ${PC_TurboJPEG_LIBDIR} ${PC_TurboJPEG_LIBRARY_DIRS}
+  PATH_SUFFIXES lib lib64
+  PATHS ${TurboJPEG_BASE_DIR}
+  )
+
+mark_as_advanced(TurboJPEG_INCLUDE_DIRS TurboJPEG_LIBRARIES)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(
+  TurboJPEG DEFAULT_MSG TurboJPEG_INCLUDE_DIRS TurboJPEG_LIBRARIES)
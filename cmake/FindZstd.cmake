@@ -0,0 +1,34 @@
+#
+# Find the Zstandard compression library
+#
+# Sets:
+#  Zstd_INCLUDE_DIRS - location of zstd.h
+#  Zstd_LIBRARIES    - the zstd library
+#  Zstd_FOUND        - truthy if zstd was found.
+#
+
+find_package(PkgConfig QUIET)
+if (PKG_CONFIG_FOUND)
+  pkg_check_modules(PC_Zstd QUIET libzstd)
+endif()
+
+find_path(
+  Zstd_INCLUDE_DIRS
+  zstd.h
+  HINTS ${PC_Zstd_INCLUDEDIR} ${PC_Zstd_INCLUDE_DIRS}
+  PATH_SUFFIXES include
+  PATHS ${Zstd_BASE_DIR}
+  )
+find_library(
+  Zstd_LIBRARIES
+  NAMES zstd libzstd
+  HINTS ${PC_Zstd_LIBDIR} ${PC_Zstd_LIBRARY_DIRS}
+  PATH_SUFFIXES lib lib64
+  PATHS ${Zstd_BASE_DIR}
+  )
+
+mark_as_advanced(Zstd_INCLUDE_DIRS Zstd_LIBRARIES)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(
+  Zstd DEFAULT_MSG Zstd_INCLUDE_DIRS Zstd_LIBRARIES)
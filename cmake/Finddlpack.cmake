@@ -0,0 +1,37 @@
+# Try to find DLPack
+#
+# Sets the following imported targets if DLPack is found with a config:
+# dlpack::dlpack
+#
+# If DLPack is not found with a CMake config, legacy variables are set:
+# dlpack_FOUND
+# dlpack_INCLUDE_DIRS - directories with DLPack headers
+
+find_package(dlpack CONFIG)
+
+if (NOT TARGET dlpack::dlpack)
+  find_path(dlpack_INCLUDE_DIRS
+    NAMES
+    dlpack/dlpack.h
+    PATH_SUFFIXES
+    include
+    PATHS
+    ${DLPACK_ROOT_DIR}
+    $ENV{DLPACK_ROOT_DIR}
+    )
+
+  include(FindPackageHandleStandardArgs)
+  find_package_handle_standard_args(dlpack
+    REQUIRED_VARS dlpack_INCLUDE_DIRS
+    )
+
+  if (dlpack_INCLUDE_DIRS)
+    message(STATUS "Found DLPack (include: ${dlpack_INCLUDE_DIRS})")
+  endif()
+  mark_as_advanced(dlpack_FOUND)
+  if (dlpack_FOUND)
+    add_library(dlpack::dlpack INTERFACE IMPORTED)
+    set_target_properties(dlpack::dlpack PROPERTIES
+      INTERFACE_INCLUDE_DIRECTORIES "${dlpack_INCLUDE_DIRS}")
+  endif()
+endif()
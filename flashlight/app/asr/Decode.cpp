@@ -10,6 +10,7 @@
 #include <fstream>
 #include <future>
 #include <iomanip>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -20,6 +21,7 @@
 
 #include "flashlight/fl/flashlight.h"
 
+#include "flashlight/fl/common/BoundedQueue.h"
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/lib/text/decoder/LexiconDecoder.h"
 #include "flashlight/lib/text/decoder/LexiconFreeDecoder.h"
@@ -28,18 +30,20 @@
 #include "flashlight/lib/text/decoder/lm/ConvLM.h"
 #include "flashlight/lib/text/decoder/lm/KenLM.h"
 #include "flashlight/lib/text/decoder/lm/ZeroLM.h"
+#include "flashlight/pkg/runtime/common/ChunkedForward.h"
 #include "flashlight/pkg/runtime/common/SequentialBuilder.h"
 #include "flashlight/pkg/runtime/common/Serializer.h"
 #include "flashlight/pkg/runtime/plugin/ModulePlugin.h"
 #include "flashlight/pkg/speech/common/Defines.h"
 #include "flashlight/pkg/speech/common/Flags.h"
-#include "flashlight/pkg/speech/common/ProducerConsumerQueue.h"
+#include "flashlight/pkg/speech/common/MemoryBudget.h"
 #include "flashlight/pkg/speech/criterion/criterion.h"
 #include "flashlight/pkg/speech/data/FeatureTransforms.h"
 #include "flashlight/pkg/speech/data/Utils.h"
 #include "flashlight/pkg/speech/decoder/ConvLmModule.h"
 #include "flashlight/pkg/speech/decoder/DecodeUtils.h"
 #include "flashlight/pkg/speech/decoder/Defines.h"
+#include "flashlight/pkg/speech/decoder/EmissionStore.h"
 #include "flashlight/pkg/speech/decoder/TranscriptionUtils.h"
 #include "flashlight/pkg/speech/runtime/runtime.h"
 
@@ -244,6 +248,13 @@ int main(int argc, char** argv) {
 
   std::shared_ptr<fl::lib::text::LM> lm =
       std::make_shared<fl::lib::text::ZeroLM>();
+  // the ConvLM scores are cached, and batched across the decoder threads
+  // sharing the LM when they wait for each other
+  ConvLmScoreOptions convLmScoreOptions;
+  convLmScoreOptions.cacheSize = FLAGS_lm_cache_size;
+  convLmScoreOptions.maxBatchSize = FLAGS_lm_batch_size;
+  convLmScoreOptions.maxWaitUs = FLAGS_lm_batch_wait_us;
+  GetConvLmScoreFunc getConvLmScoreFunc;
   if (!FLAGS_lm.empty()) {
     if (FLAGS_lmtype == "kenlm") {
       lm = std::make_shared<fl::lib::text::KenLM>(FLAGS_lm, usrDict);
@@ -262,7 +273,8 @@ int main(int argc, char** argv) {
       }
       convLmModel->eval();
 
-      auto getConvLmScoreFunc = buildGetConvLmScoreFunction(convLmModel);
+      getConvLmScoreFunc =
+          buildGetConvLmScoreFunction(convLmModel, convLmScoreOptions);
       lm = std::make_shared<fl::lib::text::ConvLM>(
           getConvLmScoreFunc,
           FLAGS_lm_vocab,
@@ -360,8 +372,26 @@ int main(int argc, char** argv) {
   LOG(INFO) << "[Dataset] Dataset loaded, with " << nSamples << " samples.";
 
   /* ===================== AM Forwarding ===================== */
-  using EmissionQueue = fl::lib::ProducerConsumerQueue<EmissionTargetPair>;
+  // The emissions are paired with the bytes they hold in the memory budget,
+  // which are released once they are decoded
+  using EmissionQueue = fl::BoundedQueue<std::pair<EmissionTargetPair, size_t>>;
   EmissionQueue emissionQueue(FLAGS_emission_queue_size);
+  // AM forward and decoding run concurrently, with the utterances in flight
+  // bounded by the budget such that both nets fit in the device memory
+  fl::lib::MemoryBudget memoryBudget(
+      static_cast<size_t>(FLAGS_decoder_memory_budget) << 20);
+
+  // the emissions of `test`, in an emission store or in a file per sample
+  fs::path emissionDir;
+  std::unique_ptr<EmissionStore> emissionStore;
+  if (!FLAGS_emission_dir.empty()) {
+    emissionDir = fs::path(FLAGS_emission_dir) / cleanFilepath(FLAGS_test);
+    if (EmissionStore::isEmissionStore(emissionDir)) {
+      emissionStore = std::make_unique<EmissionStore>(emissionDir);
+      LOG(INFO) << "[EmissionStore] Loaded the index of "
+                << emissionStore->size() << " emissions from " << emissionDir;
+    }
+  }
 
   auto runAmForward = [&network,
                        &usePlugin,
@@ -371,6 +401,9 @@ int main(int argc, char** argv) {
                        &tokenDict,
                        &wordDict,
                        &emissionQueue,
+                       &memoryBudget,
+                       &emissionDir,
+                       &emissionStore,
                        &isSeq2seqCrit](int tid) {
     // Initialize AM
     fl::setDevice(tid);
@@ -394,6 +427,21 @@ int main(int argc, char** argv) {
     localDs = std::make_shared<fl::PrefetchDataset>(
         localDs, FLAGS_nthread, FLAGS_nthread);
 
+    // long utterances may run in chunks of time, whose emissions are stitched
+    Tensor duration;
+    auto amForward = [&](const fl::Variable& input) {
+      if (usePlugin) {
+        return localNetwork->forward({input, fl::noGrad(duration)}).front();
+      }
+      return fl::pkg::runtime::forwardSequentialModuleWithPadMask(
+          input, localNetwork, duration);
+    };
+    std::unique_ptr<fl::pkg::runtime::ChunkedForward> chunkedForward;
+    if (FLAGS_am_chunk_frames > 0) {
+      chunkedForward = std::make_unique<fl::pkg::runtime::ChunkedForward>(
+          amForward, getAmChunkOptions());
+    }
+
     for (auto& sample : *localDs) {
       auto sampleId = readSampleIds(sample[kSampleIdx]).front();
 
@@ -422,34 +470,31 @@ int main(int argc, char** argv) {
       targetUnit.wordTargetStr = wordTargetStr;
       targetUnit.tokenTarget = tokenTarget;
 
+      // the activations of the forward pass scale with the input size
+      const size_t cost = sample[kInputIdx].bytes();
+      memoryBudget.acquire(cost);
+
       /* 3. Load Emissions */
       EmissionUnit emissionUnit;
       if (FLAGS_emission_dir.empty()) {
-        fl::Variable rawEmission;
-        if (usePlugin) {
-          rawEmission = localNetwork
-                            ->forward(
-                                {fl::input(sample[kInputIdx]),
-                                 fl::noGrad(sample[kDurationIdx])})
-                            .front();
-        } else {
-          rawEmission = fl::pkg::runtime::forwardSequentialModuleWithPadMask(
-              fl::input(sample[kInputIdx]), localNetwork, sample[kDurationIdx]);
-        }
+        duration = sample[kDurationIdx];
+        fl::Variable rawEmission = chunkedForward
+            ? chunkedForward->forward(sample[kInputIdx])
+            : amForward(fl::input(sample[kInputIdx]));
         emissionUnit = EmissionUnit(
             rawEmission.tensor().toHostVector<float>(),
             sampleId,
             rawEmission.dim(1),
             rawEmission.dim(0));
+      } else if (emissionStore) {
+        emissionUnit = emissionStore->get(sampleId);
       } else {
-        auto cleanTestPath = cleanFilepath(FLAGS_test);
-        fs::path emissionDir = fs::path(FLAGS_emission_dir) / cleanTestPath;
         fs::path savePath = emissionDir / (sampleId + ".bin");
         std::string eVersion;
         Serializer::load(savePath, eVersion, emissionUnit);
       }
 
-      emissionQueue.add({emissionUnit, targetUnit});
+      emissionQueue.push({{emissionUnit, targetUnit}, cost});
     }
 
     localNetwork.reset(); // AM is only used in running forward pass. So we will
@@ -468,9 +513,12 @@ int main(int argc, char** argv) {
                      &criterionType,
                      &transition,
                      &usrDict,
+                     &getConvLmScoreFunc,
+                     &convLmScoreOptions,
                      &tokenDict,
                      &wordDict,
                      &emissionQueue,
+                     &memoryBudget,
                      &writeHyp,
                      &writeRef,
                      &writeLog,
@@ -499,15 +547,19 @@ int main(int argc, char** argv) {
     // Make a copy for non-main threads.
     if (tid != 0) {
       if (FLAGS_lmtype == "convlm") {
-        LOG(INFO) << "[ConvLM]: Loading LM from " << FLAGS_lm;
-        std::shared_ptr<fl::Module> convLmModel;
-        std::string convlmVersion;
-        Serializer::load(FLAGS_lm, convlmVersion, convLmModel);
-        convLmModel->eval();
-
-        auto getConvLmScoreFunc = buildGetConvLmScoreFunction(convLmModel);
+        // the threads batch their queries to the LM of the first one
+        auto localGetConvLmScoreFunc = getConvLmScoreFunc;
+        if (FLAGS_lm_batch_wait_us <= 0) {
+          LOG(INFO) << "[ConvLM]: Loading LM from " << FLAGS_lm;
+          std::shared_ptr<fl::Module> convLmModel;
+          std::string convlmVersion;
+          Serializer::load(FLAGS_lm, convlmVersion, convLmModel);
+          convLmModel->eval();
+          localGetConvLmScoreFunc =
+              buildGetConvLmScoreFunction(convLmModel, convLmScoreOptions);
+        }
         localLm = std::make_shared<fl::lib::text::ConvLM>(
-            getConvLmScoreFunc,
+            localGetConvLmScoreFunc,
             FLAGS_lm_vocab,
             usrDict,
             FLAGS_lm_memory,
@@ -621,10 +673,10 @@ int main(int argc, char** argv) {
     }
     /* 3. Get data and run decoder */
     TestMeters meters;
-    EmissionTargetPair emissionTargetPair;
-    while (emissionQueue.get(emissionTargetPair)) {
-      const auto& emissionUnit = emissionTargetPair.first;
-      const auto& targetUnit = emissionTargetPair.second;
+    std::pair<EmissionTargetPair, size_t> queued;
+    while (emissionQueue.pop(queued)) {
+      const auto& emissionUnit = queued.first.first;
+      const auto& targetUnit = queued.first.second;
 
       const auto& nFrames = emissionUnit.nFrames;
       const auto& nTokens = emissionUnit.nTokens;
@@ -637,6 +689,7 @@ int main(int argc, char** argv) {
       meters.timer.resume();
       const auto& results = decoder->decode(emission.data(), nFrames, nTokens);
       meters.timer.stop();
+      memoryBudget.release(queued.second);
 
       int nTopHyps = FLAGS_isbeamdump ? results.size() : 1;
       for (int i = 0; i < nTopHyps; i++) {
@@ -756,53 +809,25 @@ int main(int argc, char** argv) {
     // TODO possibly try catch for futures to proper logging of all errors
     // https://github.com/facebookresearch/gtn/blob/master/gtn/parallel/parallel_map.h#L154
 
-    // We have to run AM forwarding and decoding in sequential to avoid GPU
-    // OOM with two large neural nets.
-    if (FLAGS_lmtype == "convlm") {
-      // 1. AM forwarding
-      {
-        std::vector<std::future<void>> futs(nAmThreads);
-        fl::ThreadPool threadPool(nAmThreads);
-        for (int i = 0; i < nAmThreads; i++) {
-          futs[i] = threadPool.enqueue(runAmForward, i);
-        }
-        for (int i = 0; i < nAmThreads; i++) {
-          futs[i].get();
-        }
-        emissionQueue.finishAdding();
-      }
-      // 2. Decoding
-      {
-        std::vector<std::future<void>> futs(nDecoderThreads);
-        fl::ThreadPool threadPool(nDecoderThreads);
-        for (int i = 0; i < nDecoderThreads; i++) {
-          futs[i] = threadPool.enqueue(runDecoder, i);
-        }
-        for (int i = 0; i < nDecoderThreads; i++) {
-          futs[i].get();
-        }
-      }
+    // AM forwarding and decoding are pipelined, the memory budget bounds the
+    // utterances in flight when both nets share a device.
+    std::vector<std::future<void>> futs(nAmThreads + nDecoderThreads);
+    fl::ThreadPool threadPool(nAmThreads + nDecoderThreads);
+    // AM forwarding threads
+    for (int i = 0; i < nAmThreads; i++) {
+      futs[i] = threadPool.enqueue(runAmForward, i);
+    }
+    // Decoding threads
+    for (int i = 0; i < nDecoderThreads; i++) {
+      futs[i + nAmThreads] = threadPool.enqueue(runDecoder, i);
     }
-    // Non-convLM decoding. AM forwarding and decoding can be run in parallel.
-    else {
-      std::vector<std::future<void>> futs(nAmThreads + nDecoderThreads);
-      fl::ThreadPool threadPool(nAmThreads + nDecoderThreads);
-      // AM forwarding threads
-      for (int i = 0; i < nAmThreads; i++) {
-        futs[i] = threadPool.enqueue(runAmForward, i);
-      }
-      // Decoding threads
-      for (int i = 0; i < nDecoderThreads; i++) {
-        futs[i + nAmThreads] = threadPool.enqueue(runDecoder, i);
-      }
 
-      for (int i = 0; i < nAmThreads; i++) {
-        futs[i].get();
-      }
-      emissionQueue.finishAdding();
-      for (int i = nAmThreads; i < nAmThreads + nDecoderThreads; i++) {
-        futs[i].get();
-      }
+    for (int i = 0; i < nAmThreads; i++) {
+      futs[i].get();
+    }
+    emissionQueue.close();
+    for (int i = nAmThreads; i < nAmThreads + nDecoderThreads; i++) {
+      futs[i].get();
     }
   };
   auto timer = fl::TimeMeter();
@@ -6,8 +6,11 @@
  */
 
 #include <stdlib.h>
+#include <deque>
 #include <fstream>
+#include <future>
 #include <iomanip>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -20,6 +23,7 @@
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/lib/text/dictionary/Dictionary.h"
 #include "flashlight/lib/text/dictionary/Utils.h"
+#include "flashlight/pkg/runtime/common/ChunkedForward.h"
 #include "flashlight/pkg/runtime/common/DistributedUtils.h"
 #include "flashlight/pkg/runtime/common/SequentialBuilder.h"
 #include "flashlight/pkg/runtime/common/Serializer.h"
@@ -30,6 +34,7 @@
 #include "flashlight/pkg/speech/data/FeatureTransforms.h"
 #include "flashlight/pkg/speech/data/Utils.h"
 #include "flashlight/pkg/speech/decoder/Defines.h"
+#include "flashlight/pkg/speech/decoder/EmissionStore.h"
 #include "flashlight/pkg/speech/decoder/TranscriptionUtils.h"
 #include "flashlight/pkg/speech/runtime/runtime.h"
 
@@ -293,19 +298,18 @@ int main(int argc, char** argv) {
     TestMeters meters;
     meters.timer.resume();
     int cnt = 0;
-    for (auto& sample : *localDs) {
-      fl::Variable rawEmission;
-      if (usePlugin) {
-        rawEmission = localNetwork
-                          ->forward(
-                              {fl::input(sample[kInputIdx]),
-                               fl::noGrad(sample[kDurationIdx])})
-                          .front();
-      } else {
-        rawEmission = fl::pkg::runtime::forwardSequentialModuleWithPadMask(
-            fl::input(sample[kInputIdx]), localNetwork, sample[kDurationIdx]);
-      }
-      auto emission = rawEmission.tensor().toHostVector<float>();
+    // emissions being written in the background, a few at a time, to their
+    // own files or to the shard of the thread of an emission store
+    constexpr size_t kMaxPendingSaves = 8;
+    std::deque<std::future<void>> pendingSaves;
+    std::unique_ptr<EmissionStoreWriter> emissionWriter;
+    if (!emissionDir.empty() && FLAGS_emission_store) {
+      emissionWriter = std::make_unique<EmissionStoreWriter>(
+          emissionDir, tid, FLAGS_emission_fp16, kMaxPendingSaves);
+    }
+    auto process = [&](const std::vector<Tensor>& sample,
+                       const fl::Variable& rawEmission,
+                       const std::vector<int>& tokenPrediction) {
       auto tokenTarget = sample[kTargetIdx].toHostVector<int>();
       auto wordTarget = sample[kWordIdx].toHostVector<int>();
       auto sampleId = readSampleIds(sample[kSampleIdx]).front();
@@ -327,8 +331,6 @@ int main(int argc, char** argv) {
       }
 
       // Tokens
-      auto tokenPrediction =
-          localCriterion->viterbiPath(rawEmission.tensor()).toHostVector<int>();
       auto letterPrediction = tknPrediction2Ltr(
           tokenPrediction,
           tokenDict,
@@ -369,20 +371,106 @@ int main(int argc, char** argv) {
                   << "\%]" << std::endl;
       }
 
-      /* Save emission and targets */
-      int nTokens = rawEmission.dim(0);
-      int nFrames = rawEmission.dim(1);
-      EmissionUnit emissionUnit(emission, sampleId, nFrames, nTokens);
-
       // Update counters
       sliceNumWords[tid] += wordTarget.size();
       sliceNumTokens[tid] += letterTarget.size();
       sliceNumSamples[tid]++;
 
-      if (!emissionDir.empty()) {
+      /* Save emission and targets */
+      if (emissionWriter) {
+        emissionWriter->add(sampleId, rawEmission.tensor());
+      } else if (!emissionDir.empty()) {
+        int nTokens = rawEmission.dim(0);
+        int nFrames = rawEmission.dim(1);
+        EmissionUnit emissionUnit(
+            rawEmission.tensor().toHostVector<float>(),
+            sampleId,
+            nFrames,
+            nTokens);
         fs::path savePath = fs::path(emissionDir) / (sampleId + ".bin");
-        Serializer::save(savePath, FL_APP_ASR_VERSION, emissionUnit);
+        if (pendingSaves.size() >= kMaxPendingSaves) {
+          pendingSaves.front().get();
+          pendingSaves.pop_front();
+        }
+        // in the format of Serializer::save
+        pendingSaves.push_back(fl::saveAsync(
+            savePath.string(),
+            std::string(FL_APP_ASR_VERSION),
+            emissionUnit));
+      }
+    };
+
+    // Seq2seq predictions of a beam search, batched over utterances
+    auto s2sCriterion =
+        std::dynamic_pointer_cast<Seq2SeqCriterion>(localCriterion);
+    const bool batchedBeam = s2sCriterion && FLAGS_test_beamsize > 0;
+    std::vector<std::pair<std::vector<Tensor>, fl::Variable>> pending;
+    auto flush = [&]() {
+      if (pending.empty()) {
+        return;
+      }
+      int maxT = 0;
+      std::vector<int> sizes;
+      for (const auto& item : pending) {
+        sizes.push_back(item.second.dim(1));
+        maxT = std::max(maxT, sizes.back());
+      }
+      std::vector<Tensor> padded;
+      for (const auto& item : pending) {
+        const auto& emission = item.second.tensor();
+        padded.push_back(fl::pad(
+            fl::reshape(emission, {emission.dim(0), emission.dim(1), 1}),
+            {{0, 0}, {0, maxT - static_cast<int>(emission.dim(1))}, {0, 0}}));
       }
+      auto predictions = s2sCriterion->batchedBeamPath(
+          fl::concatenate(padded, 2),
+          Tensor::fromVector({1, static_cast<Dim>(sizes.size())}, sizes),
+          FLAGS_test_beamsize);
+      for (size_t i = 0; i < pending.size(); ++i) {
+        process(pending[i].first, pending[i].second, predictions[i]);
+      }
+      pending.clear();
+    };
+
+    // long utterances may run in chunks of time, whose emissions are stitched
+    Tensor duration;
+    auto amForward = [&](const fl::Variable& input) {
+      if (usePlugin) {
+        return localNetwork->forward({input, fl::noGrad(duration)}).front();
+      }
+      return fl::pkg::runtime::forwardSequentialModuleWithPadMask(
+          input, localNetwork, duration);
+    };
+    std::unique_ptr<fl::pkg::runtime::ChunkedForward> chunkedForward;
+    if (FLAGS_am_chunk_frames > 0) {
+      chunkedForward = std::make_unique<fl::pkg::runtime::ChunkedForward>(
+          amForward, getAmChunkOptions());
+    }
+
+    for (auto& sample : *localDs) {
+      duration = sample[kDurationIdx];
+      fl::Variable rawEmission = chunkedForward
+          ? chunkedForward->forward(sample[kInputIdx])
+          : amForward(fl::input(sample[kInputIdx]));
+      if (batchedBeam) {
+        pending.emplace_back(sample, rawEmission);
+        if (static_cast<int>(pending.size()) >= FLAGS_test_batchsize) {
+          flush();
+        }
+      } else {
+        process(
+            sample,
+            rawEmission,
+            localCriterion->viterbiPath(rawEmission.tensor())
+                .toHostVector<int>());
+      }
+    }
+    flush();
+    for (auto& save : pendingSaves) {
+      save.get();
+    }
+    if (emissionWriter) {
+      emissionWriter->flush();
     }
 
     meters.timer.stop();
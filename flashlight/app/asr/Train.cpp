@@ -8,7 +8,9 @@
 #include <cstdlib>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <random>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -18,6 +20,7 @@
 #include <glog/logging.h>
 
 #include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/common/Metrics.h"
 #include "flashlight/fl/contrib/contrib.h"
 #include "flashlight/fl/flashlight.h"
 #include "flashlight/fl/tensor/Compute.h"
@@ -45,6 +48,7 @@
 
 using fl::lib::format;
 using fl::lib::join;
+using fl::pkg::runtime::AsyncSerializer;
 using fl::pkg::runtime::getCurrentDate;
 using fl::pkg::runtime::getCurrentTime;
 using fl::pkg::runtime::getRunFile;
@@ -94,6 +98,19 @@ DEFINE_int64(
     ipl_maxtsz,
     std::numeric_limits<int64_t>::max(),
     "maximum length of targets in words");
+DEFINE_bool(
+    ipl_async,
+    false,
+    "regenerate pl in the background with a snapshot of the model, "
+    "while training continues with the previous pl");
+
+// Extra flags for validation
+DEFINE_bool(
+    valid_async,
+    false,
+    "run validation in the background with a snapshot of the model, while "
+    "training continues; its metrics are logged and its best models saved "
+    "at the next report");
 
 } // namespace
 
@@ -175,6 +192,9 @@ int main(int argc, char** argv) {
   if (runPath.empty()) {
     LOG(FATAL) << "'runpath' specified by --rundir, --runname cannot be empty";
   }
+  if (FLAGS_accumulation_steps < 1) {
+    LOG(FATAL) << "'accumulation_steps' must be positive";
+  }
 
   fl::setSeed(FLAGS_seed);
   fl::DynamicBenchmark::setBenchmarkMode(FLAGS_fl_benchmark_mode);
@@ -265,6 +285,7 @@ int main(int argc, char** argv) {
   }
   bool isSeq2seqCrit = FLAGS_criterion == kSeq2SeqTransformerCriterion ||
       FLAGS_criterion == kSeq2SeqRNNCriterion;
+  bool isCtcCrit = FLAGS_criterion == kCtcCriterion;
   if (isSeq2seqCrit) {
     tokenDict.addEntry(fl::pkg::speech::kEosToken);
     tokenDict.addEntry(fl::lib::text::kPadToken);
@@ -282,6 +303,9 @@ int main(int argc, char** argv) {
   }
 
   /* ===================== Create Dataset ===================== */
+  const auto loaderAffinity = FLAGS_nthread_numa_affinity
+      ? fl::ThreadAffinityPolicy::DeviceNumaNode
+      : fl::ThreadAffinityPolicy::None;
   fl::lib::audio::FeatureParams featParams(
       FLAGS_samplerate,
       FLAGS_framesizems,
@@ -330,6 +354,17 @@ int main(int argc, char** argv) {
   int wordpadVal = kTargetPadValue;
   auto padVal = std::make_tuple(0, targetpadVal, wordpadVal);
 
+  std::shared_ptr<const FeatureStore> featureStore;
+  if (!FLAGS_feature_store.empty()) {
+    featureStore = std::make_shared<FeatureStore>(FLAGS_feature_store);
+    LOG(INFO) << "Loaded feature store " << FLAGS_feature_store << " with "
+              << featureStore->size() << " samples";
+    if (!sfxConf.empty()) {
+      LOG(INFO) << "Sound effects are applied to the training audio, "
+                << "which doesn't use the feature store";
+    }
+  }
+
   auto _trainSplits = fl::lib::split(",", FLAGS_train, true);
   std::vector<fs::path> trainSplits;
   std::transform(
@@ -349,7 +384,8 @@ int main(int argc, char** argv) {
       worldSize,
       false, // allowEmpty
       FLAGS_batching_strategy,
-      FLAGS_batching_max_duration);
+      FLAGS_batching_max_duration,
+      sfxConf.empty() ? featureStore : nullptr);
 
   std::map<std::string, std::shared_ptr<fl::Dataset>> validds;
   int64_t validBatchSize =
@@ -367,8 +403,10 @@ int main(int argc, char** argv) {
         padVal,
         worldRank,
         worldSize,
-        true // allowEmpty
-    );
+        true, // allowEmpty
+        kBatchStrategyNone,
+        0, // maxDurationPerBatch
+        featureStore);
   }
 
   /* =========== Create Network & Optimizers / Reload Snapshot ============ */
@@ -470,26 +508,30 @@ int main(int argc, char** argv) {
   FL_LOG_MASTER(INFO) << "[Network Params: " << numTotalParams(network) << "]";
   FL_LOG_MASTER(INFO) << "[Criterion] " << criterion->prettyString();
 
+  // the decoder of validation, also for the snapshots of async validation
+  auto createDecodeMaster = [&](std::shared_ptr<fl::Module> net) {
+    std::vector<float> dummyTransition;
+    return std::make_shared<WordDecodeMaster>(
+        net,
+        lm,
+        dummyTransition,
+        usePlugin,
+        tokenDict,
+        wordDict,
+        DecodeMasterTrainOptions{
+            .repLabel = int32_t(FLAGS_replabel),
+            .wordSepIsPartOfToken = FLAGS_usewordpiece,
+            .surround = FLAGS_surround,
+            .wordSep = FLAGS_wordseparator,
+            .targetPadIdx = targetpadVal});
+  };
   if (!FLAGS_lm.empty()) {
     FL_LOG_MASTER(INFO) << "[Beam-search Decoder] Constructing language model "
                            "and beam search decoder";
-    std::vector<float> dummyTransition;
     if (FLAGS_decodertype == "wrd" && FLAGS_lmtype == "kenlm" &&
         FLAGS_criterion == "ctc") {
       lm = std::make_shared<fl::lib::text::KenLM>(FLAGS_lm, wordDict);
-      dm = std::make_shared<WordDecodeMaster>(
-          network,
-          lm,
-          dummyTransition,
-          usePlugin,
-          tokenDict,
-          wordDict,
-          DecodeMasterTrainOptions{
-              .repLabel = int32_t(FLAGS_replabel),
-              .wordSepIsPartOfToken = FLAGS_usewordpiece,
-              .surround = FLAGS_surround,
-              .wordSep = FLAGS_wordseparator,
-              .targetPadIdx = targetpadVal});
+      dm = createDecodeMaster(network);
     } else {
       throw std::runtime_error(
           "Other decoders are not supported yet during training");
@@ -544,6 +586,28 @@ int main(int argc, char** argv) {
     meters.valid[s.first] = DatasetMeters();
   }
 
+  /* ===================== Metrics ===================== */
+  meters.timer.exportMetric(
+      "fl_train_batch_seconds", "Mean time per batch of the current epoch");
+  meters.sampletimer.exportMetric(
+      "fl_train_sample_seconds", "Mean time per sample of the current epoch");
+  meters.train.loss.exportMetric(
+      "fl_train_loss", "Mean training loss since the last report");
+  for (auto& [tag, validMeters] : meters.valid) {
+    validMeters.loss.exportMetric(
+        "fl_valid_loss", "Mean loss of the last validation", {{"set", tag}});
+  }
+  meters.stats.exportMetrics({{"set", "train"}});
+  if (FLAGS_metrics_port > 0) {
+    fl::MetricsRegistry::getInstance().startHttpServer(
+        FLAGS_metrics_port + worldRank);
+  }
+  if (!FLAGS_metrics_file.empty()) {
+    fl::MetricsRegistry::getInstance().startFileDump(
+        FLAGS_metrics_file + "." + std::to_string(worldRank),
+        FLAGS_metrics_interval);
+  }
+
   // best perf so far on valid datasets
   std::unordered_map<std::string, double> validminerrs;
   for (const auto& s : validTagSets) {
@@ -639,8 +703,11 @@ int main(int argc, char** argv) {
           double lr,
           double lrcrit) {
         syncMeter(mtrs);
-        plGenerator.setModelWER(
-            mtrs.valid[validTagSets.front().first].wrdEdit.errorRate()[0]);
+        // there are no results before the first async validation is finished
+        const auto& firstValid = mtrs.valid[validTagSets.front().first];
+        if (firstValid.wrdEdit.value()[1] > 0) {
+          plGenerator.setModelWER(firstValid.wrdEdit.errorRate()[0]);
+        }
 
         if (isMaster) {
           auto scaleFactor =
@@ -658,18 +725,58 @@ int main(int argc, char** argv) {
         }
       };
 
-  auto saveModels = [&](int iter, int totalUpdates) {
+  // the best model files to save after the last validation, on the valid
+  // sets on which it is the best so far
+  auto bestModelFiles = [&]() {
+    std::vector<fs::path> filenames;
+    // save if better than ever for one valid
+    for (const auto& v : validminerrs) {
+      double verr = meters.valid[v.first].wrdEdit.errorRate()[0];
+      if (verr < validminerrs[v.first]) {
+        validminerrs[v.first] = verr;
+        std::string cleaned_v = cleanFilepath(v.first);
+        filenames.emplace_back(
+            getRunFile("model_" + cleaned_v + ".bin", runIdx, runPath));
+      }
+    }
+
+    // save if better than ever for one valid with lm decoding
+    for (const auto& v : validMinWerWithDecoder) {
+      double verr = validWerWithDecoder[v.first];
+      if (verr < validMinWerWithDecoder[v.first]) {
+        validMinWerWithDecoder[v.first] = verr;
+        std::string cleaned_v = cleanFilepath(v.first);
+        filenames.emplace_back(getRunFile(
+            "model_" + cleaned_v + "_decoder.bin", runIdx, runPath));
+      }
+    }
+    return filenames;
+  };
+
+  AsyncSerializer asyncSerializer;
+  auto saveModels = [&](int iter, int totalUpdates, bool saveBest) {
     if (isMaster) {
       // Save last epoch
       config[kEpoch] = std::to_string(iter);
       config[kUpdates] = std::to_string(totalUpdates);
 
-      std::string filename;
+      std::vector<fs::path> filenames;
       if (FLAGS_itersave) {
-        filename =
-            getRunFile(format("model_iter_%03d.bin", iter), runIdx, runPath);
-        Serializer::save(
-            filename,
+        filenames.emplace_back(
+            getRunFile(format("model_iter_%03d.bin", iter), runIdx, runPath));
+      }
+
+      // save last model
+      filenames.emplace_back(getRunFile("model_last.bin", runIdx, runPath));
+
+      if (saveBest) {
+        auto bestFiles = bestModelFiles();
+        filenames.insert(filenames.end(), bestFiles.begin(), bestFiles.end());
+      }
+
+      if (FLAGS_asyncsave) {
+        asyncSerializer.save(
+            filenames,
             FL_APP_ASR_VERSION,
             config,
             network,
@@ -677,30 +784,10 @@ int main(int argc, char** argv) {
             dynamicScaler,
             netoptim,
             critoptim);
-      }
-
-      // save last model
-      filename = getRunFile("model_last.bin", runIdx, runPath);
-      Serializer::save(
-          filename,
-          FL_APP_ASR_VERSION,
-          config,
-          network,
-          criterion,
-          dynamicScaler,
-          netoptim,
-          critoptim);
-
-      // save if better than ever for one valid
-      for (const auto& v : validminerrs) {
-        double verr = meters.valid[v.first].wrdEdit.errorRate()[0];
-        if (verr < validminerrs[v.first]) {
-          validminerrs[v.first] = verr;
-          std::string cleaned_v = cleanFilepath(v.first);
-          std::string vfname =
-              getRunFile("model_" + cleaned_v + ".bin", runIdx, runPath);
+      } else {
+        for (const auto& filename : filenames) {
           Serializer::save(
-              vfname,
+              filename,
               FL_APP_ASR_VERSION,
               config,
               network,
@@ -710,32 +797,39 @@ int main(int argc, char** argv) {
               critoptim);
         }
       }
+      // print brief stats on memory allocation (so far)
+      fl::detail::getMemMgrInfo("Memory Manager Stats", /* device id = */ 0);
+    }
+  };
 
-      // save if better than ever for one valid with lm decoding
-      for (const auto& v : validMinWerWithDecoder) {
-        double verr = validWerWithDecoder[v.first];
-        if (verr < validMinWerWithDecoder[v.first]) {
-          validMinWerWithDecoder[v.first] = verr;
-          std::string cleaned_v = cleanFilepath(v.first);
-          std::string vfname = getRunFile(
-              "model_" + cleaned_v + "_decoder.bin", runIdx, runPath);
-          Serializer::save(
-              vfname,
-              FL_APP_ASR_VERSION,
-              config,
-              network,
-              criterion,
-              dynamicScaler,
-              netoptim,
-              critoptim);
+  // async validation saves the best models once its results are ready, with
+  // the checkpoint of the snapshot which saveModels would have saved
+  auto serializeModels = [&](int iter, int totalUpdates) {
+    config[kEpoch] = std::to_string(iter);
+    config[kUpdates] = std::to_string(totalUpdates);
+    std::ostringstream buffer;
+    {
+      cereal::BinaryOutputArchive ar(buffer);
+      ar(std::string(FL_APP_ASR_VERSION));
+      ar(config, network, criterion, dynamicScaler, netoptim, critoptim);
+    }
+    return buffer.str();
+  };
+  auto saveBestModels = [&](const std::string& checkpoint) {
+    if (isMaster) {
+      for (const auto& filename : bestModelFiles()) {
+        std::ofstream file(filename, std::ios::binary);
+        file.write(checkpoint.data(), checkpoint.size());
+        if (!file) {
+          throw std::runtime_error(
+              "failed to write the model file " + filename.string());
         }
       }
-      // print brief stats on memory allocation (so far)
-      fl::detail::getMemMgrInfo("Memory Manager Stats", /* device id = */ 0);
     }
   };
 
-  auto evalOutput = [&tokenDict, &criterion, &isSeq2seqCrit](
+  auto evalOutput = [&tokenDict, &isSeq2seqCrit](
+                        const std::shared_ptr<SequenceCriterion>& crit,
                         const fl::Tensor& op,
                         const fl::Tensor& target,
                         const fl::Tensor& inputSizes,
@@ -743,11 +837,11 @@ int main(int argc, char** argv) {
     auto batchsz = op.dim(2);
     for (int b = 0; b < batchsz; ++b) {
       auto tgt = target(fl::span, b);
-      auto viterbipath = criterion
-                             ->viterbiPath(
-                                 op(fl::span, fl::span, b),
-                                 inputSizes(fl::span, fl::range(b, b + 1)))
-                             .toHostVector<int>();
+      auto viterbipath =
+          crit->viterbiPath(
+                  op(fl::span, fl::span, b),
+                  inputSizes(fl::span, fl::range(b, b + 1)))
+              .toHostVector<int>();
       auto tgtraw = tgt.toHostVector<int>();
 
       // Remove `-1`s appended to the target for batching (if any)
@@ -783,17 +877,30 @@ int main(int argc, char** argv) {
     }
   };
 
+  std::vector<double> lmweights;
+  for (double lmweight = FLAGS_lmweight_low; lmweight <= FLAGS_lmweight_high;
+       lmweight += FLAGS_lmweight_step) {
+    lmweights.push_back(lmweight);
+  }
+
+  // validates a model, with `viterbiCrit` for the edit distance of the
+  // predictions, and returns the word edit distance stats of the beam-search
+  // decoding for each lm weight. There's no collective communication, so it
+  // may run in the background.
   auto test = [&evalOutput,
-               &dm,
+               &lmweights,
                &lexicon,
                &usePlugin,
                &isSeq2seqCrit,
-               &worldRank](
+               &isCtcCrit,
+               &worldRank,
+               loaderAffinity](
                   std::shared_ptr<fl::Module> ntwrk,
                   std::shared_ptr<SequenceCriterion> crit,
+                  std::shared_ptr<SequenceCriterion> viterbiCrit,
+                  std::shared_ptr<WordDecodeMaster> decoder,
                   std::shared_ptr<fl::Dataset> validds,
-                  DatasetMeters& mtrs,
-                  double& dmErr) {
+                  DatasetMeters& mtrs) {
     ntwrk->eval();
     crit->eval();
     mtrs.tknEdit.reset();
@@ -801,26 +908,25 @@ int main(int argc, char** argv) {
     mtrs.loss.reset();
 
     auto curValidset = loadPrefetchDataset(
-        validds, FLAGS_nthread, false /* shuffle */, 0 /* seed */);
-
-    if (dm) {
+        validds,
+        FLAGS_nthread,
+        false /* shuffle */,
+        0 /* seed */,
+        loaderAffinity);
+
+    std::vector<std::vector<int64_t>> wordEditDst;
+    if (decoder) {
       fl::TimeMeter timer;
       timer.resume();
       FL_LOG_MASTER(INFO) << "[Beam-search decoder]   * DM: compute emissions"
                           << curValidset->size();
-      auto eds = dm->forward(curValidset);
+      auto eds = decoder->forward(curValidset);
       FL_LOG_MASTER(INFO) << "[Beam-search decoder]   * DM: decode";
-      std::vector<double> lmweights;
-      for (double lmweight = FLAGS_lmweight_low;
-           lmweight <= FLAGS_lmweight_high;
-           lmweight += FLAGS_lmweight_step) {
-        lmweights.push_back(lmweight);
-      }
-      std::vector<std::vector<int64_t>> wordEditDst(lmweights.size());
+      wordEditDst.resize(lmweights.size());
       std::vector<std::thread> threads;
       for (int i = 0; i < lmweights.size(); i++) {
         threads.push_back(std::thread(
-            [&lmweights, &wordEditDst, dm, eds, &lexicon, i, worldRank]() {
+            [&lmweights, &wordEditDst, decoder, eds, &lexicon, i, worldRank]() {
               double lmweight = lmweights[i];
               fl::setDevice(worldRank % 8);
               DecodeMasterLexiconOptions opt = {
@@ -839,34 +945,14 @@ int main(int argc, char** argv) {
                       (FLAGS_smearing == "max"
                            ? fl::lib::text::SmearingMode::MAX
                            : fl::lib::text::SmearingMode::NONE)};
-              auto pds = dm->decode(eds, lexicon, opt);
+              auto pds = decoder->decode(eds, lexicon, opt);
               // return token distance and word distance stats
-              wordEditDst[i] = dm->computeMetrics(pds).second;
+              wordEditDst[i] = decoder->computeMetrics(pds).second;
             }));
       }
       for (auto& thread : threads) {
         thread.join();
       }
-      dmErr = DBL_MAX;
-      for (int i = 0; i < lmweights.size(); i++) {
-        // TODO{fl::Tensor} - consider using a scalar Tensor
-        fl::Tensor currentEditDist =
-            fl::full({1}, (long long)(wordEditDst[i][0]));
-        fl::Tensor currentTokens =
-            fl::full({1}, (long long)(wordEditDst[i][1]));
-        if (FLAGS_enable_distributed) {
-          fl::allReduce(currentEditDist);
-          fl::allReduce(currentTokens);
-        }
-        double wer = (double)currentEditDist.scalar<long long>() /
-            currentTokens.scalar<long long>() * 100.0;
-        FL_LOG_MASTER(INFO)
-            << "[Beam-search decoder]   * DM: lmweight=" << lmweights[i]
-            << " WER: " << wer;
-        dmErr = std::min(dmErr, wer);
-      }
-      FL_LOG_MASTER(INFO) << "[Beam-search decoder]   * DM: done with best WER "
-                          << dmErr;
       timer.stop();
       FL_LOG_MASTER(INFO)
           << "[Beam-search decoder] time spent on grid-search for decoding: "
@@ -890,13 +976,48 @@ int main(int argc, char** argv) {
       if (isSeq2seqCrit) {
         critArgs.push_back(fl::Variable(batch[kDurationIdx], false));
         critArgs.push_back(fl::Variable(batch[kTargetSizeIdx], false));
+      } else if (isCtcCrit) {
+        // the padded frames of the batch are ignored
+        critArgs.push_back(fl::Variable(batch[kDurationIdx], false));
       }
       auto loss = crit->forward(critArgs).front();
       mtrs.loss.add(loss.tensor());
-      evalOutput(output.tensor(), batch[kTargetIdx], batch[kDurationIdx], mtrs);
+      evalOutput(
+          viterbiCrit,
+          output.tensor(),
+          batch[kTargetIdx],
+          batch[kDurationIdx],
+          mtrs);
     }
+    return wordEditDst;
   };
 
+  // the best WER over the lm weights of the decoding of all processes
+  auto reduceDecoderWer =
+      [&lmweights](const std::vector<std::vector<int64_t>>& wordEditDst) {
+        double dmErr = DBL_MAX;
+        for (int i = 0; i < lmweights.size(); i++) {
+          // TODO{fl::Tensor} - consider using a scalar Tensor
+          fl::Tensor currentEditDist =
+              fl::full({1}, (long long)(wordEditDst[i][0]));
+          fl::Tensor currentTokens =
+              fl::full({1}, (long long)(wordEditDst[i][1]));
+          if (FLAGS_enable_distributed) {
+            fl::allReduce(currentEditDist);
+            fl::allReduce(currentTokens);
+          }
+          double wer = (double)currentEditDist.scalar<long long>() /
+              currentTokens.scalar<long long>() * 100.0;
+          FL_LOG_MASTER(INFO)
+              << "[Beam-search decoder]   * DM: lmweight=" << lmweights[i]
+              << " WER: " << wer;
+          dmErr = std::min(dmErr, wer);
+        }
+        FL_LOG_MASTER(INFO)
+            << "[Beam-search decoder]   * DM: done with best WER " << dmErr;
+        return dmErr;
+      };
+
   int64_t curEpoch = startEpoch;
   // Try reloading existing PL
   auto unsupDataDir = plGenerator.reloadPl(curEpoch);
@@ -917,9 +1038,15 @@ int main(int argc, char** argv) {
 
   auto train = [&meters,
                 &validWerWithDecoder,
+                &criterion,
+                &dm,
+                &createDecodeMaster,
                 &test,
+                &reduceDecoderWer,
                 &logStatus,
                 &saveModels,
+                &serializeModels,
+                &saveBestModels,
                 &evalOutput,
                 &validds,
                 &curEpoch,
@@ -927,8 +1054,11 @@ int main(int argc, char** argv) {
                 &plGenerator,
                 &usePlugin,
                 &isSeq2seqCrit,
+                &isCtcCrit,
+                isMaster,
                 reducer,
-                dynamicScaler](
+                dynamicScaler,
+                loaderAffinity](
                    std::shared_ptr<fl::Module> ntwrk,
                    std::shared_ptr<SequenceCriterion> crit,
                    std::shared_ptr<fl::Dataset> trainset,
@@ -985,6 +1115,70 @@ int main(int argc, char** argv) {
       meters.optimtimer.reset();
       meters.timer.reset();
     };
+
+    // the validation running in the background with a snapshot of the model,
+    // which writes to the valid meters, and the checkpoint of the snapshot
+    using WordEditDsts =
+        std::vector<std::pair<std::string, std::vector<std::vector<int64_t>>>>;
+    std::future<WordEditDsts> asyncValid;
+    std::string asyncValidCheckpoint;
+    auto startAsyncValidation = [&](int64_t totalEpochs,
+                                    int64_t totalUpdates) {
+      // the snapshot isn't updated by training
+      std::shared_ptr<fl::Module> ntwrkCopy;
+      std::shared_ptr<SequenceCriterion> critCopy;
+      std::shared_ptr<SequenceCriterion> viterbiCritCopy;
+      {
+        std::stringstream snapshot;
+        fl::save(snapshot, ntwrk, crit, criterion);
+        fl::load(snapshot, ntwrkCopy, critCopy, viterbiCritCopy);
+      }
+      if (isMaster) {
+        asyncValidCheckpoint = serializeModels(totalEpochs, totalUpdates);
+      }
+      auto decoder = dm ? createDecodeMaster(ntwrkCopy) : nullptr;
+      const int device = fl::getDevice();
+      asyncValid = std::async(
+          std::launch::async,
+          [&test,
+           &validds,
+           &meters,
+           ntwrkCopy,
+           critCopy,
+           viterbiCritCopy,
+           decoder,
+           device]() {
+            fl::setDevice(device);
+            WordEditDsts wordEditDsts;
+            for (auto& vds : validds) {
+              wordEditDsts.emplace_back(
+                  vds.first,
+                  test(
+                      ntwrkCopy,
+                      critCopy,
+                      viterbiCritCopy,
+                      decoder,
+                      vds.second,
+                      meters.valid.at(vds.first)));
+            }
+            return wordEditDsts;
+          });
+    };
+    // returns whether a validation was running
+    auto finishAsyncValidation = [&]() {
+      if (!asyncValid.valid()) {
+        return false;
+      }
+      auto wordEditDsts = asyncValid.get();
+      // collective communication is only done by the training thread
+      for (const auto& [tag, wordEditDst] : wordEditDsts) {
+        if (validWerWithDecoder.find(tag) != validWerWithDecoder.end()) {
+          validWerWithDecoder[tag] = reduceDecoderWer(wordEditDst);
+        }
+      }
+      return true;
+    };
+
     auto runValAndSaveModel = [&](int64_t totalEpochs,
                                   int64_t totalUpdates,
                                   double lr,
@@ -997,12 +1191,19 @@ int main(int argc, char** argv) {
       meters.bwdtimer.stop();
       meters.optimtimer.stop();
 
-      // valid
-      for (auto& vds : validds) {
-        double decodedWer;
-        test(ntwrk, crit, vds.second, meters.valid[vds.first], decodedWer);
-        if (validWerWithDecoder.find(vds.first) != validWerWithDecoder.end()) {
-          validWerWithDecoder[vds.first] = decodedWer;
+      // valid, which with async validation are the results of the previous
+      // report
+      bool hasAsyncResults = false;
+      if (FLAGS_valid_async) {
+        hasAsyncResults = finishAsyncValidation();
+      } else {
+        for (auto& vds : validds) {
+          auto wordEditDst = test(
+              ntwrk, crit, criterion, dm, vds.second, meters.valid[vds.first]);
+          if (validWerWithDecoder.find(vds.first) !=
+              validWerWithDecoder.end()) {
+            validWerWithDecoder[vds.first] = reduceDecoderWer(wordEditDst);
+          }
         }
       }
 
@@ -1015,10 +1216,16 @@ int main(int argc, char** argv) {
       }
       // save last and best models
       try {
-        saveModels(totalEpochs, totalUpdates);
+        saveModels(totalEpochs, totalUpdates, !FLAGS_valid_async);
+        if (hasAsyncResults) {
+          saveBestModels(asyncValidCheckpoint);
+        }
       } catch (const std::exception& ex) {
         LOG(FATAL) << "Error while saving models: " << ex.what();
       }
+      if (FLAGS_valid_async) {
+        startAsyncValidation(totalEpochs, totalUpdates);
+      }
       // reset meters for next readings
       meters.train.loss.reset();
       meters.train.tknEdit.reset();
@@ -1045,13 +1252,26 @@ int main(int argc, char** argv) {
       std::hash<std::string> hasher;
       FL_LOG_MASTER(INFO) << "Shuffling trainset";
       auto curTrainset = loadPrefetchDataset(
-          trainset, FLAGS_nthread, true /* shuffle */, curEpoch /* seed */);
+          trainset,
+          FLAGS_nthread,
+          true /* shuffle */,
+          curEpoch /* seed */,
+          loaderAffinity);
       fl::sync();
       meters.sampletimer.resume();
       meters.runtime.resume();
       meters.timer.resume();
       FL_LOG_MASTER(INFO) << "Epoch " << curEpoch << " started!";
-      for (auto& batch : *curTrainset) {
+      // the gradients of `accumulation_steps` batches are accumulated in an
+      // update, and reduced once. The batches left at the end of an epoch
+      // which don't fill an update are dropped.
+      std::vector<std::vector<fl::Tensor>> microBatches;
+      for (auto& nextBatch : *curTrainset) {
+        microBatches.push_back(nextBatch);
+        if (static_cast<int64_t>(microBatches.size()) <
+            FLAGS_accumulation_steps) {
+          continue;
+        }
         ++curBatch;
         double lrScheduleScale;
         if (FLAGS_lrcosine) {
@@ -1071,12 +1291,23 @@ int main(int argc, char** argv) {
         fl::sync();
         meters.timer.incUnit();
         meters.sampletimer.stopAndIncUnit();
-        meters.stats.add(batch[kDurationIdx], batch[kTargetSizeIdx]);
-        if (fl::any(fl::isnan(batch[kInputIdx])).asScalar<bool>() ||
-            fl::any(fl::isnan(batch[kTargetIdx])).asScalar<bool>()) {
-          LOG(FATAL) << "Sample has NaN values - "
-                     << join(",", readSampleIds(batch[kSampleIdx]));
+        float totalBatchSize = 0;
+        for (const auto& batch : microBatches) {
+          meters.stats.add(batch[kDurationIdx], batch[kTargetSizeIdx]);
+          if (fl::any(fl::isnan(batch[kInputIdx])).asScalar<bool>() ||
+              fl::any(fl::isnan(batch[kTargetIdx])).asScalar<bool>()) {
+            LOG(FATAL) << "Sample has NaN values - "
+                       << join(",", readSampleIds(batch[kSampleIdx]));
+          }
+          totalBatchSize += batch[kInputIdx].dim(3);
         }
+        // TODO{fl::Tensor} -- change me to use a scalar tensor?
+        fl::Tensor totalBatchSizeArr =
+            fl::full({1}, totalBatchSize, fl::dtype::f32);
+        if (reducer) {
+          fl::allReduce(totalBatchSizeArr);
+        }
+        totalBatchSize = totalBatchSizeArr.scalar<float>();
 
         // Ensure no samples are skipped while adjusting the loss scale factor.
         // When gradient values are Inf/NaN, the model update is skipped and the
@@ -1086,74 +1317,92 @@ int main(int argc, char** argv) {
         // - https://bit.ly/35F5GqX
         // - https://bit.ly/3mn2qr0
         while (true) {
-          // forward
-          meters.fwdtimer.resume();
-          auto input = fl::input(batch[kInputIdx]);
-          if (FLAGS_saug_start_update >= 0 &&
-              curBatch >= FLAGS_saug_start_update) {
-            input = saug->forward({input}).front();
-          }
-          fl::Variable output;
-          if (usePlugin) {
-            output = ntwrk->forward({input, fl::noGrad(batch[kDurationIdx])})
-                         .front();
-          } else {
-            output = fl::pkg::runtime::forwardSequentialModuleWithPadMask(
-                input, ntwrk, batch[kDurationIdx]);
-          }
-          fl::sync();
-
-          // forward crit
-          meters.critfwdtimer.resume();
-          std::vector<fl::Variable> critArgs = {
-              output, fl::Variable(batch[kTargetIdx], false)};
-          if (isSeq2seqCrit) {
-            critArgs.push_back(fl::Variable(batch[kDurationIdx], false));
-            critArgs.push_back(fl::Variable(batch[kTargetSizeIdx], false));
-          }
-          auto loss = crit->forward(critArgs).front();
-          fl::sync();
-          meters.fwdtimer.stopAndIncUnit();
-          meters.critfwdtimer.stopAndIncUnit();
-
-          if (fl::any(fl::isnan(loss.tensor())).asScalar<bool>() ||
-              fl::any(fl::isinf(loss.tensor())).asScalar<bool>()) {
-            LOG(FATAL) << "Loss has NaN values. Samples - "
-                       << join(",", readSampleIds(batch[kSampleIdx]));
-          }
-
-          if (hasher(join(",", readSampleIds(batch[kSampleIdx]))) % 100 <=
-              FLAGS_pcttraineval) {
-            evalOutput(
-                output.tensor(),
-                batch[kTargetIdx],
-                batch[kDurationIdx],
-                meters.train);
-          }
-
-          // backward
-          meters.bwdtimer.resume();
           netopt->zeroGrad();
           critopt->zeroGrad();
-
-          float totalBatchSize = batch[kInputIdx].dim(3);
-          // TODO{fl::Tensor} -- change me to use a scalar tensor?
-          fl::Tensor totalBatchSizeArr =
-              fl::full({1}, batch[kInputIdx].dim(3), fl::dtype::f32);
-          if (reducer) {
-            fl::allReduce(totalBatchSizeArr);
+          std::vector<fl::Tensor> losses;
+          bool scaleIsValid = true;
+          for (int i = 0; i < microBatches.size(); ++i) {
+            const auto& batch = microBatches[i];
+            const bool isLast = i + 1 == microBatches.size();
+            // forward
+            meters.fwdtimer.resume();
+            auto input = fl::input(batch[kInputIdx]);
+            if (FLAGS_saug_start_update >= 0 &&
+                curBatch >= FLAGS_saug_start_update) {
+              input = saug->forward({input}).front();
+            }
+            fl::Variable output;
+            if (usePlugin) {
+              output =
+                  ntwrk->forward({input, fl::noGrad(batch[kDurationIdx])})
+                      .front();
+            } else {
+              output = fl::pkg::runtime::forwardSequentialModuleWithPadMask(
+                  input, ntwrk, batch[kDurationIdx]);
+            }
+            fl::sync();
+
+            // forward crit
+            meters.critfwdtimer.resume();
+            std::vector<fl::Variable> critArgs = {
+                output, fl::Variable(batch[kTargetIdx], false)};
+            if (isSeq2seqCrit) {
+              critArgs.push_back(fl::Variable(batch[kDurationIdx], false));
+              critArgs.push_back(fl::Variable(batch[kTargetSizeIdx], false));
+            } else if (isCtcCrit) {
+              // the padded frames of the batch are ignored
+              critArgs.push_back(fl::Variable(batch[kDurationIdx], false));
+            }
+            auto loss = crit->forward(critArgs).front();
+            fl::sync();
+            meters.fwdtimer.stopAndIncUnit();
+            meters.critfwdtimer.stopAndIncUnit();
+
+            if (fl::any(fl::isnan(loss.tensor())).asScalar<bool>() ||
+                fl::any(fl::isinf(loss.tensor())).asScalar<bool>()) {
+              LOG(FATAL) << "Loss has NaN values. Samples - "
+                         << join(",", readSampleIds(batch[kSampleIdx]));
+            }
+
+            if (hasher(join(",", readSampleIds(batch[kSampleIdx]))) % 100 <=
+                FLAGS_pcttraineval) {
+              evalOutput(
+                  criterion,
+                  output.tensor(),
+                  batch[kTargetIdx],
+                  batch[kDurationIdx],
+                  meters.train);
+            }
+
+            // backward, which reduces the accumulated gradients with the last
+            // batch only
+            meters.bwdtimer.resume();
+            auto scaledLoss = loss / totalBatchSize;
+            if (isLast) {
+              scaleIsValid = fl::pkg::runtime::backwardWithScaling(
+                  scaledLoss, params, dynamicScaler, reducer);
+            } else {
+              if (reducer) {
+                reducer->setDeferred(true);
+              }
+              (dynamicScaler ? dynamicScaler->scale(scaledLoss) : scaledLoss)
+                  .backward();
+              if (reducer) {
+                reducer->setDeferred(false);
+              }
+            }
+            fl::sync();
+            meters.bwdtimer.stopAndIncUnit();
+            losses.push_back(loss.tensor());
           }
-          totalBatchSize = totalBatchSizeArr.scalar<float>();
-          auto scaledLoss = loss / totalBatchSize;
-          bool scaleIsValid = fl::pkg::runtime::backwardWithScaling(
-              scaledLoss, params, dynamicScaler, reducer);
-          fl::sync();
-          meters.bwdtimer.stopAndIncUnit();
+          // the whole update is retried with the adjusted scale
           if (!scaleIsValid) {
             continue;
           }
 
-          meters.train.loss.add(loss.tensor());
+          for (const auto& loss : losses) {
+            meters.train.loss.add(loss);
+          }
           break;
         }
 
@@ -1172,6 +1421,7 @@ int main(int argc, char** argv) {
         netopt->step();
         fl::sync();
         meters.optimtimer.stopAndIncUnit();
+        microBatches.clear();
 
         if (FLAGS_reportiters > 0 && curBatch % FLAGS_reportiters == 0) {
           runValAndSaveModel(
@@ -1194,8 +1444,15 @@ int main(int argc, char** argv) {
       }
 
       // Try regenerate PL
-      auto newUnsupDataDir =
-          plGenerator.regeneratePl(curEpoch, ntwrk, crit, usePlugin);
+      std::string newUnsupDataDir;
+      if (FLAGS_ipl_async) {
+        // the pl of the previous relabeling are used once they're all ready
+        newUnsupDataDir = plGenerator.finishPlRegeneration();
+        plGenerator.startPlRegeneration(curEpoch, ntwrk, crit, usePlugin);
+      } else {
+        newUnsupDataDir =
+            plGenerator.regeneratePl(curEpoch, ntwrk, crit, usePlugin);
+      }
       if (!newUnsupDataDir.empty()) {
         trainset = plGenerator.createTrainSet(
             FLAGS_datadir,
@@ -1205,6 +1462,26 @@ int main(int argc, char** argv) {
             FLAGS_batching_max_duration);
       }
     }
+
+    // the results of the last async validation
+    if (finishAsyncValidation()) {
+      try {
+        logStatus(
+            meters,
+            validWerWithDecoder,
+            curEpoch,
+            curBatch,
+            netopt->getLr(),
+            critopt->getLr());
+      } catch (const std::exception& ex) {
+        LOG(ERROR) << "Error while writing logs: " << ex.what();
+      }
+      try {
+        saveBestModels(asyncValidCheckpoint);
+      } catch (const std::exception& ex) {
+        LOG(FATAL) << "Error while saving models: " << ex.what();
+      }
+    }
   };
 
   /* ===================== Train ===================== */
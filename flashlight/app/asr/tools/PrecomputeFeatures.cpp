@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Precomputes the input features of the samples of the train, valid and test
+ * lists into a feature store, see `FeatureStore`, such that training reads
+ * them with --feature_store instead of decoding and featurizing the audio of
+ * every sample at every epoch.
+ *
+ * The features are computed with the featurization flags of training, e.g.
+ * given with the --flagsfile of the training, and without sound effects.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/lib/text/String.h"
+#include "flashlight/pkg/speech/common/Defines.h"
+#include "flashlight/pkg/speech/common/Flags.h"
+#include "flashlight/pkg/speech/data/FeatureStore.h"
+#include "flashlight/pkg/speech/data/FeatureTransforms.h"
+#include "flashlight/pkg/speech/data/ListFileDataset.h"
+#include "flashlight/pkg/speech/data/Utils.h"
+#include "flashlight/pkg/speech/runtime/runtime.h"
+
+namespace {
+
+DEFINE_int64(
+    feature_store_chunk_size,
+    10000,
+    "Number of samples of a chunk file of the feature store");
+
+} // namespace
+
+using namespace fl::pkg::speech;
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  gflags::SetUsageMessage(
+      "Usage: \n " + std::string(argv[0]) +
+      " --flagsfile=[train flags] --feature_store=[output directory]");
+  if (argc <= 1) {
+    LOG(FATAL) << gflags::ProgramUsage();
+  }
+
+  fl::init();
+
+  /* ===================== Parse Options ===================== */
+  LOG(INFO) << "Parsing command line flags";
+  gflags::ParseCommandLineFlags(&argc, &argv, false);
+  auto flagsfile = FLAGS_flagsfile;
+  if (!flagsfile.empty()) {
+    LOG(INFO) << "Reading flags from file " << flagsfile;
+    gflags::ReadFromFlagsFile(flagsfile, argv[0], true);
+    // override with user-specified flags
+    gflags::ParseCommandLineFlags(&argc, &argv, false);
+  }
+  if (FLAGS_feature_store.empty()) {
+    LOG(FATAL) << "--feature_store must specify the output directory";
+  }
+
+  /* ===================== Create Featurization ===================== */
+  fl::lib::audio::FeatureParams featParams(
+      FLAGS_samplerate,
+      FLAGS_framesizems,
+      FLAGS_framestridems,
+      FLAGS_filterbanks,
+      FLAGS_lowfreqfilterbank,
+      FLAGS_highfreqfilterbank,
+      FLAGS_mfcccoeffs,
+      kLifterParam /* lifterparam */,
+      FLAGS_devwin /* delta window */,
+      FLAGS_devwin /* delta-delta window */);
+  featParams.useEnergy = false;
+  featParams.usePower = false;
+  featParams.zeroMeanFrame = false;
+  FeatureType featType =
+      getFeatureType(FLAGS_features_type, FLAGS_channels, featParams).second;
+  auto inputTransform = inputFeatures(
+      featParams, featType, {FLAGS_localnrmlleftctx, FLAGS_localnrmlrightctx});
+
+  /* ===================== Write Feature Store ===================== */
+  std::vector<std::string> lists;
+  for (const auto& list : fl::lib::split(",", FLAGS_train, true)) {
+    lists.push_back(list);
+  }
+  for (const auto& set : parseValidSets(FLAGS_valid)) {
+    lists.push_back(set.second);
+  }
+  for (const auto& list : fl::lib::split(",", FLAGS_test, true)) {
+    lists.push_back(list);
+  }
+
+  FeatureStoreWriter writer(
+      FLAGS_feature_store, FLAGS_feature_store_chunk_size);
+  int64_t numSamples = 0;
+  for (const auto& list : lists) {
+    LOG(INFO) << "Precomputing features of " << list;
+    auto listDs = std::make_shared<ListFileDataset>(
+        fs::path(FLAGS_datadir) / list, inputTransform);
+    auto ds = loadPrefetchDataset(listDs, FLAGS_nthread, false /* shuffle */);
+    for (auto& sample : *ds) {
+      auto idVec = sample[kSampleIdx].toHostVector<char>();
+      writer.add(std::string(idVec.begin(), idVec.end()), sample[kInputIdx]);
+      ++numSamples;
+    }
+  }
+  writer.close();
+  LOG(INFO) << "Wrote the features of " << numSamples << " samples to "
+            << FLAGS_feature_store;
+  return 0;
+}
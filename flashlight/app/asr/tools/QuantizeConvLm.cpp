@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Quantizes a serialized ConvLM to int8 for decoding on CPU, calibrating it on
+ * the sentences of a text file, e.g. of the transcriptions of a dev set. The
+ * quantized model is decoded like the original one, with
+ * --lmtype=convlm --lm=[quantized model].
+ */
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "flashlight/fl/flashlight.h"
+#include "flashlight/lib/text/dictionary/Defines.h"
+#include "flashlight/lib/text/dictionary/Dictionary.h"
+#include "flashlight/pkg/runtime/common/Serializer.h"
+#include "flashlight/pkg/speech/decoder/ConvLmModule.h"
+
+namespace {
+
+DEFINE_string(lm, "", "ConvLM to quantize");
+DEFINE_string(lm_vocab, "", "Dictionary of the tokens of the ConvLM");
+DEFINE_string(
+    calibration,
+    "",
+    "Text file of one sentence of space-separated tokens per line, on which "
+    "the ConvLM is calibrated");
+DEFINE_int64(
+    calibration_size,
+    1000,
+    "Number of sentences to calibrate on, or all of them if negative");
+DEFINE_string(output, "", "Path of the quantized ConvLM");
+
+} // namespace
+
+using fl::pkg::runtime::Serializer;
+
+int main(int argc, char** argv) {
+  fl::init();
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  gflags::SetUsageMessage(
+      "Usage: \n " + std::string(argv[0]) +
+      " --lm=[ConvLM] --lm_vocab=[dictionary] --calibration=[text file]"
+      " --output=[quantized ConvLM]");
+  if (argc <= 1) {
+    LOG(FATAL) << gflags::ProgramUsage();
+  }
+  gflags::ParseCommandLineFlags(&argc, &argv, false);
+  if (FLAGS_lm.empty() || FLAGS_lm_vocab.empty() ||
+      FLAGS_calibration.empty() || FLAGS_output.empty()) {
+    LOG(FATAL) << "--lm, --lm_vocab, --calibration and --output must be set";
+  }
+
+  fl::lib::text::Dictionary dictionary(FLAGS_lm_vocab);
+  if (dictionary.contains(fl::lib::text::kUnkToken)) {
+    dictionary.setDefaultIndex(
+        dictionary.getIndex(fl::lib::text::kUnkToken));
+  }
+  // the decoder starts the sentences from the end of the previous one
+  const bool hasEos = dictionary.contains(fl::lib::text::kEosToken);
+  std::vector<std::vector<int>> sequences;
+  std::ifstream text(FLAGS_calibration);
+  if (!text) {
+    LOG(FATAL) << "Unable to open " << FLAGS_calibration;
+  }
+  std::string line;
+  while ((FLAGS_calibration_size < 0 ||
+          sequences.size() < FLAGS_calibration_size) &&
+         std::getline(text, line)) {
+    std::vector<int> sequence;
+    if (hasEos) {
+      sequence.push_back(dictionary.getIndex(fl::lib::text::kEosToken));
+    }
+    std::istringstream tokens(line);
+    std::string token;
+    while (tokens >> token) {
+      sequence.push_back(dictionary.getIndex(token));
+    }
+    if (!sequence.empty()) {
+      sequences.push_back(std::move(sequence));
+    }
+  }
+
+  std::shared_ptr<fl::Module> network;
+  std::string version;
+  Serializer::load(FLAGS_lm, version, network);
+  LOG(INFO) << "[ConvLM] " << network->prettyString();
+
+  fl::pkg::speech::quantizeConvLm(*network, sequences);
+  LOG(INFO) << "[Quantized ConvLM] " << network->prettyString();
+  Serializer::save(FLAGS_output, version, network);
+  LOG(INFO) << "Quantized " << FLAGS_lm << " on " << sequences.size()
+            << " sentences to " << FLAGS_output;
+  return 0;
+}
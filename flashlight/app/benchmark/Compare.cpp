@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Compares benchmark results against baselines, e.g. after an upgrade of
+ * ArrayFire or oneDNN, and fails if any of them regressed beyond a tolerance.
+ * Reads the JSON lines of `benchmark --json_output` and the JSON of
+ * `TensorBenchmark --benchmark_out`, in any number of files:
+ *
+ *   benchmark_compare --baseline=<files> --current=<files>
+ *     [--tolerance=0.05] [--memory_tolerance=0.05] [--output=<report.json>]
+ *
+ * Runs are matched by name, including their backend, and timings and peak
+ * memory are compared, lower being better. The report is written as JSON,
+ * with the status of each run and metric: ok, regression, improvement,
+ * missing (from the current results) or new (not in the baselines). Exits
+ * with 1 if any metric regressed.
+ */
+
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include "flashlight/lib/text/String.h"
+
+DEFINE_string(baseline, "", "Comma-separated files of the baseline results");
+DEFINE_string(current, "", "Comma-separated files of the current results");
+DEFINE_double(
+    tolerance,
+    0.05,
+    "Relative increase of a timing beyond which it regressed");
+DEFINE_double(
+    memory_tolerance,
+    0.05,
+    "Relative increase of the peak memory beyond which it regressed");
+DEFINE_bool(
+    fail_on_missing,
+    false,
+    "Also fail if baseline runs are missing from the current results");
+DEFINE_string(output, "", "File of the JSON report, if any");
+
+namespace {
+
+// The scalar members of a JSON object, strings unescaped
+using JsonObject = std::map<std::string, std::string>;
+
+/**
+ * Collects the objects of JSON documents, at any depth, with their scalar
+ * members; which is all the results files hold. Documents may follow each
+ * other, e.g. JSON lines.
+ */
+class JsonObjectReader {
+ public:
+  explicit JsonObjectReader(const std::string& text) : text_(text) {}
+
+  std::vector<JsonObject> read() {
+    std::vector<JsonObject> objects;
+    skipSpace();
+    while (pos_ < text_.size()) {
+      parseValue(objects);
+      skipSpace();
+    }
+    return objects;
+  }
+
+ private:
+  const std::string& text_;
+  size_t pos_{0};
+
+  [[noreturn]] void fail(const std::string& what) const {
+    throw std::runtime_error(
+        "JsonObjectReader - " + what + " at offset " + std::to_string(pos_));
+  }
+
+  bool isSpace() const {
+    return std::isspace(static_cast<unsigned char>(text_[pos_]));
+  }
+
+  void skipSpace() {
+    while (pos_ < text_.size() && isSpace()) {
+      ++pos_;
+    }
+  }
+
+  void expect(char c) {
+    skipSpace();
+    if (pos_ >= text_.size() || text_[pos_] != c) {
+      fail(std::string("expected '") + c + "'");
+    }
+    ++pos_;
+  }
+
+  std::string parseString() {
+    expect('"');
+    std::string value;
+    while (pos_ < text_.size() && text_[pos_] != '"') {
+      char c = text_[pos_++];
+      if (c == '\\' && pos_ < text_.size()) {
+        c = text_[pos_++];
+        switch (c) {
+          case 'n':
+            c = '\n';
+            break;
+          case 't':
+            c = '\t';
+            break;
+          case 'u':
+            // not in results files, kept verbatim
+            value += "\\u";
+            continue;
+          default:
+            break;
+        }
+      }
+      value += c;
+    }
+    expect('"');
+    return value;
+  }
+
+  // Returns the value if it's a scalar
+  std::string parseValue(std::vector<JsonObject>& objects) {
+    skipSpace();
+    if (pos_ >= text_.size()) {
+      fail("unexpected end");
+    }
+    switch (text_[pos_]) {
+      case '{':
+        parseObject(objects);
+        return "";
+      case '[':
+        ++pos_;
+        skipSpace();
+        if (pos_ < text_.size() && text_[pos_] == ']') {
+          ++pos_;
+          return "";
+        }
+        while (true) {
+          parseValue(objects);
+          skipSpace();
+          if (pos_ < text_.size() && text_[pos_] == ',') {
+            ++pos_;
+            continue;
+          }
+          expect(']');
+          return "";
+        }
+      case '"':
+        return parseString();
+      default: {
+        const auto start = pos_;
+        while (pos_ < text_.size() && !isSpace() && text_[pos_] != ',' &&
+               text_[pos_] != '}' && text_[pos_] != ']') {
+          ++pos_;
+        }
+        if (pos_ == start) {
+          fail("expected a value");
+        }
+        return text_.substr(start, pos_ - start);
+      }
+    }
+  }
+
+  void parseObject(std::vector<JsonObject>& objects) {
+    expect('{');
+    JsonObject object;
+    skipSpace();
+    if (pos_ < text_.size() && text_[pos_] == '}') {
+      ++pos_;
+      objects.push_back(std::move(object));
+      return;
+    }
+    while (true) {
+      auto key = parseString();
+      expect(':');
+      skipSpace();
+      const bool scalar = pos_ < text_.size() && text_[pos_] != '{' &&
+          text_[pos_] != '[';
+      auto value = parseValue(objects);
+      if (scalar) {
+        object[std::move(key)] = std::move(value);
+      }
+      skipSpace();
+      if (pos_ < text_.size() && text_[pos_] == ',') {
+        ++pos_;
+        continue;
+      }
+      expect('}');
+      break;
+    }
+    objects.push_back(std::move(object));
+  }
+};
+
+struct Metric {
+  double value;
+  double tolerance;
+};
+
+// The metrics of each run, by name of run and metric
+using Results = std::map<std::string, std::map<std::string, Metric>>;
+
+Results readResults(const std::string& files) {
+  Results results;
+  for (const auto& path : fl::lib::split(',', files, true)) {
+    std::ifstream file(path);
+    if (!file) {
+      throw std::runtime_error("readResults - unable to open " + path);
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    for (auto& object : JsonObjectReader(text.str()).read()) {
+      if (object.count("model")) {
+        // a run of benchmark, e.g. of several batch sizes or processes
+        const auto name = object["model"] + " bs=" + object["batch_samples"] +
+            " ws=" + object["world_size"];
+        auto& metrics = results[name];
+        metrics["batch_time_ms"] = {
+            std::stod(object["batch_time_ms"]), FLAGS_tolerance};
+        metrics["peak_memory_bytes"] = {
+            std::stod(object["peak_memory_bytes"]), FLAGS_memory_tolerance};
+      } else if (object.count("name") && object.count("real_time")) {
+        // a benchmark of TensorBenchmark
+        results[object["name"]]["real_time_us"] = {
+            std::stod(object["real_time"]), FLAGS_tolerance};
+      }
+    }
+  }
+  return results;
+}
+
+struct Comparison {
+  std::string name;
+  std::string metric;
+  double baseline{NAN};
+  double current{NAN};
+  std::string status;
+};
+
+std::vector<Comparison> compare(
+    const Results& baselines,
+    const Results& currents) {
+  std::vector<Comparison> comparisons;
+  for (const auto& [name, metrics] : baselines) {
+    auto current = currents.find(name);
+    for (const auto& [metric, baseline] : metrics) {
+      Comparison comparison{name, metric, baseline.value};
+      if (current == currents.end() || !current->second.count(metric)) {
+        comparison.status = "missing";
+      } else {
+        comparison.current = current->second.at(metric).value;
+        // the values are times and bytes, of which 0 means not measured
+        if (comparison.current > baseline.value * (1 + baseline.tolerance) &&
+            baseline.value > 0) {
+          comparison.status = "regression";
+        } else if (
+            comparison.current < baseline.value * (1 - baseline.tolerance)) {
+          comparison.status = "improvement";
+        } else {
+          comparison.status = "ok";
+        }
+      }
+      comparisons.push_back(std::move(comparison));
+    }
+  }
+  for (const auto& [name, metrics] : currents) {
+    for (const auto& [metric, current] : metrics) {
+      auto baseline = baselines.find(name);
+      if (baseline == baselines.end() || !baseline->second.count(metric)) {
+        Comparison comparison{name, metric};
+        comparison.current = current.value;
+        comparison.status = "new";
+        comparisons.push_back(std::move(comparison));
+      }
+    }
+  }
+  return comparisons;
+}
+
+std::string jsonString(const std::string& value) {
+  std::string escaped = "\"";
+  for (const char c : value) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped + "\"";
+}
+
+std::string jsonNumber(double value) {
+  if (std::isnan(value)) {
+    return "null";
+  }
+  std::ostringstream ss;
+  ss << std::setprecision(9) << value;
+  return ss.str();
+}
+
+void writeReport(
+    std::ostream& out,
+    const std::vector<Comparison>& comparisons,
+    const std::map<std::string, int>& counts) {
+  out << "{\n  \"tolerance\": " << FLAGS_tolerance
+      << ",\n  \"memory_tolerance\": " << FLAGS_memory_tolerance
+      << ",\n  \"counts\": {";
+  bool first = true;
+  for (const auto& [status, count] : counts) {
+    out << (first ? "" : ", ") << jsonString(status) << ": " << count;
+    first = false;
+  }
+  out << "},\n  \"results\": [";
+  for (size_t i = 0; i < comparisons.size(); ++i) {
+    const auto& comparison = comparisons[i];
+    const double ratio = comparison.current / comparison.baseline;
+    out << (i == 0 ? "\n" : ",\n") << "    {\"name\": "
+        << jsonString(comparison.name)
+        << ", \"metric\": " << jsonString(comparison.metric)
+        << ", \"baseline\": " << jsonNumber(comparison.baseline)
+        << ", \"current\": " << jsonNumber(comparison.current)
+        << ", \"ratio\": " << jsonNumber(std::isfinite(ratio) ? ratio : NAN)
+        << ", \"status\": " << jsonString(comparison.status) << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage(
+      "Usage: \n " + std::string(argv[0]) +
+      " --baseline=[files] --current=[files] [--output=report.json]");
+  gflags::ParseCommandLineFlags(&argc, &argv, false);
+  if (FLAGS_baseline.empty() || FLAGS_current.empty()) {
+    std::cerr << gflags::ProgramUsage() << std::endl;
+    return 2;
+  }
+
+  const auto comparisons =
+      compare(readResults(FLAGS_baseline), readResults(FLAGS_current));
+  std::map<std::string, int> counts;
+  for (const auto& comparison : comparisons) {
+    ++counts[comparison.status];
+    if (comparison.status != "ok") {
+      std::cout << std::left << std::setw(12) << comparison.status
+                << comparison.name << " " << comparison.metric << ": "
+                << jsonNumber(comparison.baseline) << " -> "
+                << jsonNumber(comparison.current) << std::endl;
+    }
+  }
+  for (const auto& [status, count] : counts) {
+    std::cout << count << " " << status << std::endl;
+  }
+
+  if (!FLAGS_output.empty()) {
+    std::ofstream out(FLAGS_output);
+    if (!out) {
+      std::cerr << "Unable to open " << FLAGS_output << std::endl;
+      return 2;
+    }
+    writeReport(out, comparisons, counts);
+  }
+  const bool failed = counts["regression"] > 0 ||
+      (FLAGS_fail_on_missing && counts["missing"] > 0);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,433 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Measures the throughput of the data pipeline of a recipe without a model,
+ * to tell whether its training is input-bound without running it. The
+ * pipeline is built from the flags of the recipe, e.g. its flags file, as by
+ * app/asr/Train.cpp (`asr`), the LM Trainer (`lm`) or the ImageNet examples
+ * (`imagenet`), and iterated for every number of prefetch threads and
+ * prefetch depth of the sweep:
+ *
+ *   benchmark_dataset --pipeline=asr --flagsfile=train.cfg
+ *     [--sweep_threads=0,1,4,8] [--sweep_prefetch_sizes=2,8]
+ *     [--max_batches=200] [--warmup_batches=10]
+ *
+ * Each run reports its batches/s and samples/s, the CPU time of the process
+ * over the wall time, in cores, and the time spent per batch in each stage of
+ * the pipeline, as recorded by the `DatasetProfiler`.
+ */
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "flashlight/app/imgclass/examples/Defines.h"
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/dataset/datasets.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/lib/text/String.h"
+#include "flashlight/lib/text/dictionary/Dictionary.h"
+#include "flashlight/lib/text/dictionary/Utils.h"
+#include "flashlight/pkg/speech/augmentation/SoundEffectConfig.h"
+#include "flashlight/pkg/speech/common/Defines.h"
+#include "flashlight/pkg/speech/common/Flags.h"
+#include "flashlight/pkg/speech/data/FeatureTransforms.h"
+#include "flashlight/pkg/speech/data/Utils.h"
+#include "flashlight/pkg/speech/runtime/runtime.h"
+#include "flashlight/pkg/text/data/TextDataset.h"
+#include "flashlight/pkg/text/data/TokenCorpus.h"
+#include "flashlight/pkg/vision/dataset/DistributedDataset.h"
+#include "flashlight/pkg/vision/dataset/Imagenet.h"
+#include "flashlight/pkg/vision/dataset/Transforms.h"
+
+DEFINE_string(
+    pipeline,
+    "asr",
+    "Data pipeline to benchmark, of asr (the flags of fl_asr_train), lm (of "
+    "fl_lm_train) and imagenet (of the ImageNet examples)");
+DEFINE_string(
+    sweep_threads,
+    "0,1,4,8",
+    "Comma-separated numbers of prefetch threads to sweep over; 0 reads the "
+    "pipeline on the main thread");
+DEFINE_string(
+    sweep_prefetch_sizes,
+    "2,8",
+    "Comma-separated prefetch depths to sweep over, in units of the "
+    "prefetched dataset: batches for asr and lm, samples for imagenet");
+DEFINE_int64(max_batches, 200, "Number of batches read by a run");
+DEFINE_int64(
+    warmup_batches,
+    10,
+    "Number of batches read before timing a run, e.g. to fill the queues");
+
+// The flags of the LM Trainer and of the ImageNet examples which shape their
+// pipelines; the ASR flags, and `--seed` of the shuffling, are those of
+// fl_pkg_speech
+DEFINE_string(data_dir, "", "[lm, imagenet] Directory of the data");
+DEFINE_string(
+    data_train,
+    "",
+    "[lm] Comma-separated training data files, or a corpus compiled with "
+    "fl_lm_corpus_builder, in '--data_dir'");
+DEFINE_int64(
+    data_batch_size,
+    256,
+    "[lm, imagenet] Batch size, per process");
+DEFINE_int64(
+    data_tokens_per_sample,
+    1024,
+    "[lm] Max number of tokens per sample");
+DEFINE_string(
+    data_sample_break_mode,
+    "none",
+    "[lm] How to split sentences to form samples, of none and eos");
+DEFINE_bool(
+    data_use_dynamic_batching,
+    false,
+    "[lm] Batch sentences of similar lengths by a budget of tokens");
+DEFINE_string(dictionary, "", "[lm] Path to the dictionary file");
+DEFINE_int64(
+    dictionary_max_size,
+    -1,
+    "[lm] Number of rows to use from the dictionary file");
+
+using namespace fl::pkg::speech;
+
+namespace {
+
+// Builds the pipeline for a number of prefetch threads and prefetch depth
+using PipelineFactory = std::function<std::shared_ptr<fl::Dataset>(
+    int64_t numThreads,
+    int64_t prefetchSize)>;
+
+/* ------------------------------- ASR ------------------------------- */
+// The training pipeline of app/asr/Train.cpp
+PipelineFactory asrPipeline() {
+  fl::lib::text::Dictionary tokenDict(FLAGS_tokens);
+  for (int64_t r = 1; r <= FLAGS_replabel; ++r) {
+    tokenDict.addEntry("<" + std::to_string(r) + ">");
+  }
+  if (FLAGS_criterion == kCtcCriterion) {
+    tokenDict.addEntry(kBlankToken);
+  }
+  const bool isSeq2seqCrit = FLAGS_criterion == kSeq2SeqTransformerCriterion ||
+      FLAGS_criterion == kSeq2SeqRNNCriterion;
+  if (isSeq2seqCrit) {
+    tokenDict.addEntry(fl::pkg::speech::kEosToken);
+    tokenDict.addEntry(fl::lib::text::kPadToken);
+  }
+
+  fl::lib::text::Dictionary wordDict;
+  fl::lib::text::LexiconMap lexicon;
+  if (!FLAGS_lexicon.empty()) {
+    lexicon = fl::lib::text::loadWords(FLAGS_lexicon, FLAGS_maxword);
+    wordDict = fl::lib::text::createWordDict(lexicon);
+  }
+
+  fl::lib::audio::FeatureParams featParams(
+      FLAGS_samplerate,
+      FLAGS_framesizems,
+      FLAGS_framestridems,
+      FLAGS_filterbanks,
+      FLAGS_lowfreqfilterbank,
+      FLAGS_highfreqfilterbank,
+      FLAGS_mfcccoeffs,
+      kLifterParam /* lifterparam */,
+      FLAGS_devwin /* delta window */,
+      FLAGS_devwin /* delta-delta window */);
+  featParams.useEnergy = false;
+  featParams.usePower = false;
+  featParams.zeroMeanFrame = false;
+  const FeatureType featType =
+      getFeatureType(FLAGS_features_type, FLAGS_channels, featParams).second;
+
+  TargetGenerationConfig targetGenConfig(
+      FLAGS_wordseparator,
+      FLAGS_sampletarget,
+      FLAGS_criterion,
+      FLAGS_surround,
+      isSeq2seqCrit,
+      FLAGS_replabel,
+      true /* skip unk */,
+      FLAGS_usewordpiece /* fallback2LetterWordSepLeft */,
+      !FLAGS_usewordpiece /* fallback2LetterWordSepLeft */);
+
+  const auto sfxConf = (FLAGS_sfx_config.empty())
+      ? std::vector<sfx::SoundEffectConfig>()
+      : sfx::readSoundEffectConfigFile(FLAGS_sfx_config);
+  auto inputTransform = inputFeatures(
+      featParams,
+      featType,
+      {FLAGS_localnrmlleftctx, FLAGS_localnrmlrightctx},
+      sfxConf,
+      std::max(0L, FLAGS_sfx_start_update));
+  auto targetTransform = targetFeatures(tokenDict, lexicon, targetGenConfig);
+  auto wordTransform = wordFeatures(wordDict);
+  const int targetpadVal = isSeq2seqCrit
+      ? tokenDict.getIndex(fl::lib::text::kPadToken)
+      : kTargetPadValue;
+  auto padVal = std::make_tuple(0, targetpadVal, kTargetPadValue);
+
+  std::shared_ptr<const FeatureStore> featureStore;
+  if (!FLAGS_feature_store.empty() && sfxConf.empty()) {
+    featureStore = std::make_shared<FeatureStore>(FLAGS_feature_store);
+  }
+
+  std::vector<fs::path> trainSplits;
+  for (const auto& split : fl::lib::split(',', FLAGS_train, true)) {
+    trainSplits.emplace_back(split);
+  }
+  auto trainds = createDataset(
+      trainSplits,
+      FLAGS_datadir,
+      FLAGS_batchsize,
+      inputTransform,
+      targetTransform,
+      wordTransform,
+      padVal,
+      0, // worldRank
+      1, // worldSize
+      false, // allowEmpty
+      FLAGS_batching_strategy,
+      FLAGS_batching_max_duration,
+      featureStore);
+
+  return [trainds](int64_t numThreads, int64_t prefetchSize) {
+    std::shared_ptr<fl::Dataset> dataset =
+        std::make_shared<fl::ShuffleDataset>(trainds, FLAGS_seed);
+    if (numThreads > 0) {
+      dataset = std::make_shared<fl::PrefetchDataset>(
+          dataset, numThreads, prefetchSize);
+    }
+    return dataset;
+  };
+}
+
+/* ------------------------------- LM ------------------------------- */
+// The training pipeline of the LM Trainer, which reads it on the main thread
+PipelineFactory lmPipeline() {
+  std::ifstream stream(FLAGS_dictionary);
+  if (!stream) {
+    throw std::runtime_error("lmPipeline - invalid dictionary filepath");
+  }
+  fl::lib::text::Dictionary dictionary;
+  std::string line;
+  while (std::getline(stream, line)) {
+    auto tkns = fl::lib::splitOnWhitespace(line, true);
+    if (tkns.empty()) {
+      continue;
+    }
+    dictionary.addEntry(tkns.front());
+    if (dictionary.entrySize() == FLAGS_dictionary_max_size &&
+        FLAGS_dictionary_max_size > 0) {
+      break;
+    }
+  }
+  dictionary.setDefaultIndex(dictionary.getIndex(fl::lib::text::kUnkToken));
+
+  std::shared_ptr<fl::Dataset> trainds;
+  const fs::path corpusPath = fs::path(FLAGS_data_dir) / FLAGS_data_train;
+  if (fl::pkg::text::TokenCorpus::isTokenCorpus(corpusPath)) {
+    trainds = std::make_shared<fl::pkg::text::TextDataset>(
+        corpusPath,
+        0, // worldRank
+        1, // worldSize
+        dictionary,
+        FLAGS_data_tokens_per_sample,
+        FLAGS_data_batch_size,
+        FLAGS_data_sample_break_mode,
+        FLAGS_data_use_dynamic_batching);
+  } else {
+    fl::lib::text::Tokenizer tokenizer;
+    fl::lib::text::PartialFileReader partialFileReader(0, 1);
+    trainds = std::make_shared<fl::pkg::text::TextDataset>(
+        FLAGS_data_dir,
+        FLAGS_data_train,
+        partialFileReader,
+        tokenizer,
+        dictionary,
+        FLAGS_data_tokens_per_sample,
+        FLAGS_data_batch_size,
+        FLAGS_data_sample_break_mode,
+        FLAGS_data_use_dynamic_batching);
+  }
+
+  return [trainds](int64_t numThreads, int64_t prefetchSize) {
+    std::shared_ptr<fl::Dataset> dataset =
+        std::make_shared<fl::ShuffleDataset>(trainds, FLAGS_seed);
+    if (numThreads > 0) {
+      dataset = std::make_shared<fl::PrefetchDataset>(
+          dataset, numThreads, prefetchSize);
+    }
+    return dataset;
+  };
+}
+
+/* ----------------------------- ImageNet ----------------------------- */
+// The training pipeline of the ImageNet examples, which prefetch the samples
+// before batching them
+PipelineFactory imagenetPipeline() {
+  const int randomResizeMax = 480;
+  const int randomResizeMin = 256;
+  const int randomCropSize = 224;
+  const float horizontalFlipProb = 0.5f;
+  auto trainTransforms = fl::pkg::vision::compose(
+      {fl::pkg::vision::randomResizeTransform(randomResizeMin, randomResizeMax),
+       fl::pkg::vision::randomCropTransform(randomCropSize, randomCropSize),
+       fl::pkg::vision::normalizeImage(
+           fl::app::image::kImageNetMean, fl::app::image::kImageNetStd),
+       fl::pkg::vision::randomHorizontalFlipTransform(horizontalFlipProb)});
+  const auto labelMap = fl::pkg::vision::getImagenetLabels(
+      fs::path(FLAGS_data_dir) / "labels.txt");
+  auto trainds = fl::pkg::vision::imagenetDataset(
+      fs::path(FLAGS_data_dir) / "train", labelMap, {trainTransforms});
+
+  return [trainds](int64_t numThreads, int64_t prefetchSize) {
+    auto dataset = std::make_shared<fl::pkg::vision::DistributedDataset>(
+        trainds,
+        0, // worldRank
+        1, // worldSize
+        FLAGS_data_batch_size,
+        1, // train_n_repeatedaug
+        numThreads,
+        prefetchSize,
+        fl::BatchDatasetPolicy::SKIP_LAST,
+        FLAGS_seed);
+    return std::static_pointer_cast<fl::Dataset>(dataset);
+  };
+}
+
+/* ------------------------------- Runs ------------------------------- */
+double cpuSeconds() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+      1e-6 * (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+std::vector<int64_t> parseSweep(const std::string& values) {
+  std::vector<int64_t> sweep;
+  for (const auto& value : fl::lib::split(',', values, true)) {
+    sweep.push_back(std::stol(value));
+  }
+  return sweep;
+}
+
+void runPipeline(
+    const PipelineFactory& factory,
+    int64_t numThreads,
+    int64_t prefetchSize) {
+  auto dataset = factory(numThreads, prefetchSize);
+  const int64_t numBatches = std::min(
+      dataset->size(), FLAGS_warmup_batches + FLAGS_max_batches);
+  if (numBatches <= FLAGS_warmup_batches) {
+    throw std::runtime_error(
+        "runPipeline - the pipeline has too few batches: " +
+        std::to_string(dataset->size()));
+  }
+
+  auto& profiler = fl::DatasetProfiler::getInstance();
+  int64_t idx = 0;
+  for (; idx < FLAGS_warmup_batches; ++idx) {
+    dataset->get(idx);
+  }
+  profiler.enable();
+  const auto start = std::chrono::steady_clock::now();
+  const double cpuStart = cpuSeconds();
+  int64_t samples = 0;
+  for (; idx < numBatches; ++idx) {
+    const auto batch = dataset->get(idx);
+    // the batch dimension is the last one of the inputs
+    if (!batch.empty() && batch.front().ndim() > 0) {
+      samples += batch.front().dim(batch.front().ndim() - 1);
+    }
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  const double cores = (cpuSeconds() - cpuStart) / seconds;
+  profiler.disable();
+  const auto stages = profiler.stats();
+  const int64_t timedBatches = numBatches - FLAGS_warmup_batches;
+
+  std::cout << std::fixed << std::setprecision(2) << FLAGS_pipeline
+            << " threads=" << numThreads << " prefetch=" << prefetchSize
+            << ": " << timedBatches / seconds << " batches/s, "
+            << samples / seconds << " samples/s, CPU " << cores << " of "
+            << std::thread::hardware_concurrency() << " cores" << std::endl;
+  for (const auto& [stage, stats] : stages) {
+    std::cout << "  " << std::left << std::setw(24) << stage << std::right
+              << std::setprecision(3) << std::setw(10)
+              << 1e3 * stats.selfSeconds / timedBatches << " ms/batch self, "
+              << std::setw(10) << 1e3 * stats.totalSeconds / timedBatches
+              << " ms/batch total";
+    if (stats.waits > 0) {
+      std::cout << ", waited " << 1e3 * stats.waitSeconds / timedBatches
+                << " ms/batch";
+    }
+    std::cout << std::endl;
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  fl::init();
+  google::InitGoogleLogging(argv[0]);
+  gflags::SetUsageMessage(
+      "Usage: \n " + std::string(argv[0]) +
+      " --pipeline=[asr|lm|imagenet] [--flagsfile=<recipe flags>]"
+      " [--sweep_threads=0,1,4,8] [--sweep_prefetch_sizes=2,8]");
+  gflags::ParseCommandLineFlags(&argc, &argv, false);
+  if (!FLAGS_flagsfile.empty()) {
+    gflags::ReadFromFlagsFile(FLAGS_flagsfile, argv[0], true);
+    // the command line overrides the flags file
+    gflags::ParseCommandLineFlags(&argc, &argv, false);
+  }
+  handleDeprecatedFlags();
+
+  PipelineFactory factory;
+  if (FLAGS_pipeline == "asr") {
+    factory = asrPipeline();
+  } else if (FLAGS_pipeline == "lm") {
+    factory = lmPipeline();
+  } else if (FLAGS_pipeline == "imagenet") {
+    factory = imagenetPipeline();
+  } else {
+    std::cerr << "Unknown pipeline " << FLAGS_pipeline << "\n"
+              << gflags::ProgramUsage() << std::endl;
+    return 2;
+  }
+
+  for (const auto numThreads : parseSweep(FLAGS_sweep_threads)) {
+    if (numThreads == 0) {
+      // nothing is prefetched
+      runPipeline(factory, 0, 0);
+      continue;
+    }
+    for (const auto prefetchSize : parseSweep(FLAGS_sweep_prefetch_sizes)) {
+      runPipeline(factory, numThreads, prefetchSize);
+    }
+  }
+  return 0;
+}
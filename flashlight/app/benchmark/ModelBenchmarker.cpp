@@ -7,6 +7,10 @@
 
 #include "flashlight/app/benchmark/ModelBenchmarker.h"
 
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
 #include "flashlight/pkg/runtime/common/DistributedUtils.h"
 #include "flashlight/fl/flashlight.h"
 
@@ -27,6 +31,7 @@ ModelBenchmarker::ModelBenchmarker(
 }
 
 void ModelBenchmarker::runBenchmark(const std::vector<fl::Variable>& input) {
+  reset();
   model_->train();
 
   // Warmup
@@ -42,44 +47,95 @@ void ModelBenchmarker::runBenchmark(const std::vector<fl::Variable>& input) {
   }
   fl::sync();
 
-  // Benchmark
+  // Benchmark, timing the work of the stream of the model rather than the
+  // host, so that phases run asynchronously as in training
+  useStream(input.front().tensor().stream());
   for (int i = 0; i < kRunUpdates; i++) {
+    batchTimers_.emplace_back(*stream_);
+    batchTimers_.back().start();
     batchTimerMeter_.resume();
     optimizer_->zeroGrad();
 
     // 1. model forward
     fwdTimeMeter_.resume();
     auto output = model_->forward(input);
-    fl::sync();
     fwdTimeMeter_.stopAndIncUnit();
 
     // 2. criterion forward
     critFwdTimeMeter_.resume();
     auto loss = criterion_(output);
-    fl::sync();
     critFwdTimeMeter_.stopAndIncUnit();
 
     // 3. backward
     bwdTimeMeter_.resume();
     loss.backward();
+    bwdTimeMeter_.stopAndIncUnit();
+
+    // 4. reduce the gradients which weren't reduced during the backward
     if (reducer_) {
+      allreduceTimeMeter_.resume();
       reducer_->finalize();
+      allreduceTimeMeter_.stopAndIncUnit();
     }
-    fl::sync();
-    bwdTimeMeter_.stopAndIncUnit();
 
-    // 4. optimize
+    // 5. optimize
     optimTimeMeter_.resume();
     optimizer_->step();
-    fl::sync();
     optimTimeMeter_.stopAndIncUnit();
 
     batchTimerMeter_.stopAndIncUnit();
+    batchTimers_.back().stop();
+  }
+  fl::sync();
+
+  peakMemoryBytes_ = fl::detail::getMemMgrPeakBytes(fl::getDevice());
+  syncMeters();
+}
+
+void ModelBenchmarker::runInferenceBenchmark(
+    const std::vector<fl::Variable>& input) {
+  reset();
+  model_->eval();
+
+  // Warmup
+  for (int i = 0; i < kWarmupUpdates; i++) {
+    model_->forward(input);
+  }
+  fl::sync();
+
+  // Benchmark
+  useStream(input.front().tensor().stream());
+  for (int i = 0; i < kRunUpdates; i++) {
+    batchTimers_.emplace_back(*stream_);
+    batchTimers_.back().start();
+    batchTimerMeter_.resume();
+    fwdTimeMeter_.resume();
+    model_->forward(input);
+    fwdTimeMeter_.stopAndIncUnit();
+    batchTimerMeter_.stopAndIncUnit();
+    batchTimers_.back().stop();
   }
+  fl::sync();
 
+  peakMemoryBytes_ = fl::detail::getMemMgrPeakBytes(fl::getDevice());
   syncMeters();
 }
 
+void ModelBenchmarker::reset() {
+  for (auto* meter :
+       {&batchTimerMeter_,
+        &fwdTimeMeter_,
+        &critFwdTimeMeter_,
+        &bwdTimeMeter_,
+        &allreduceTimeMeter_,
+        &optimTimeMeter_}) {
+    meter->reset();
+  }
+  batchTimers_.clear();
+  fl::sync();
+  fl::detail::resetMemMgrPeakBytes(fl::getDevice());
+}
+
 double ModelBenchmarker::getBatchTime() const {
   return batchTimerMeter_.value();
 }
@@ -96,15 +152,60 @@ double ModelBenchmarker::getBackwardTime() const {
   return bwdTimeMeter_.value();
 }
 
+double ModelBenchmarker::getAllreduceTime() const {
+  return allreduceTimeMeter_.value();
+}
+
 double ModelBenchmarker::getOptimizationTime() const {
   return optimTimeMeter_.value();
 }
 
+double ModelBenchmarker::getBatchTimePercentile(double percentile) const {
+  if (percentile < 0 || percentile > 100) {
+    throw std::invalid_argument(
+        "ModelBenchmarker::getBatchTimePercentile - percentile must be in "
+        "[0, 100]");
+  }
+  if (batchTimers_.empty()) {
+    return 0;
+  }
+  // nearest rank
+  std::vector<double> times;
+  for (const auto& timer : batchTimers_) {
+    times.push_back(timer.elapsedSeconds());
+  }
+  const size_t rank = std::max<size_t>(
+      1, std::ceil(percentile / 100 * static_cast<double>(times.size())));
+  std::nth_element(times.begin(), times.begin() + rank - 1, times.end());
+  return times[rank - 1];
+}
+
+size_t ModelBenchmarker::getPeakMemoryBytes() const {
+  return peakMemoryBytes_;
+}
+
+void ModelBenchmarker::useStream(const fl::Stream& stream) {
+  if (stream_ == &stream) {
+    return;
+  }
+  stream_ = &stream;
+  for (auto* meter :
+       {&batchTimerMeter_,
+        &fwdTimeMeter_,
+        &critFwdTimeMeter_,
+        &bwdTimeMeter_,
+        &allreduceTimeMeter_,
+        &optimTimeMeter_}) {
+    meter->setStream(stream_);
+  }
+}
+
 void ModelBenchmarker::syncMeters() {
   fl::pkg::runtime::syncMeter(batchTimerMeter_);
   fl::pkg::runtime::syncMeter(fwdTimeMeter_);
   fl::pkg::runtime::syncMeter(critFwdTimeMeter_);
   fl::pkg::runtime::syncMeter(bwdTimeMeter_);
+  fl::pkg::runtime::syncMeter(allreduceTimeMeter_);
   fl::pkg::runtime::syncMeter(optimTimeMeter_);
 }
 
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
 #include "flashlight/fl/flashlight.h"
@@ -26,13 +27,30 @@ class ModelBenchmarker {
 
   void runBenchmark(const std::vector<fl::Variable>& input);
 
+  // Times the forward of the model in eval mode, without the criterion,
+  // backward and optimization
+  void runInferenceBenchmark(const std::vector<fl::Variable>& input);
+
   // Return time splits in seconds
   double getBatchTime() const;
   double getForwardTime() const;
   double getCriterionTime() const;
+  // Excludes the reductions of the gradients which don't overlap it, see
+  // `getAllreduceTime`
   double getBackwardTime() const;
+  // Time finalizing the reduction of the gradients after the backward, 0
+  // without distributed training
+  double getAllreduceTime() const;
   double getOptimizationTime() const;
 
+  // Returns the time of the batches of the last benchmark at a percentile in
+  // [0, 100], in seconds, on this process
+  double getBatchTimePercentile(double percentile) const;
+
+  // Returns the most bytes held by the memory manager of the device during the
+  // last benchmark, or 0 if the backend doesn't track it
+  size_t getPeakMemoryBytes() const;
+
  private:
   std::shared_ptr<fl::Module> model_;
   Criterion criterion_;
@@ -44,7 +62,18 @@ class ModelBenchmarker {
   fl::TimeMeter fwdTimeMeter_{true};
   fl::TimeMeter critFwdTimeMeter_{true};
   fl::TimeMeter bwdTimeMeter_{true};
+  fl::TimeMeter allreduceTimeMeter_{true};
   fl::TimeMeter optimTimeMeter_{true};
+  // the stream the meters time, that of the inputs
+  const fl::Stream* stream_{nullptr};
+  std::vector<fl::StreamTimer> batchTimers_;
+  size_t peakMemoryBytes_{0};
+
+  // Resets the statistics of the previous benchmark
+  void reset();
+
+  // Times the work of given stream with the meters
+  void useStream(const fl::Stream& stream);
 
   void syncMeters();
 
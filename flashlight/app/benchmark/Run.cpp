@@ -5,13 +5,29 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include <gflags/gflags.h>
 
 #include "flashlight/app/benchmark/ModelBenchmarker.h"
 #include "flashlight/app/benchmark/Utils.h"
+#include "flashlight/app/benchmark/models/AsrConformer.h"
+#include "flashlight/app/benchmark/models/AsrTds.h"
 #include "flashlight/app/benchmark/models/AsrTransformer.h"
+#include "flashlight/app/benchmark/models/ConvLm.h"
 #include "flashlight/app/benchmark/models/LmTransformer.h"
+#include "flashlight/fl/tensor/DefaultTensorType.h"
 #include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/TensorAdapter.h"
+#if FL_USE_JIT
+#include "flashlight/fl/tensor/backend/jit/JitTensor.h"
+#endif
 #include "flashlight/lib/text/String.h"
 #include "flashlight/pkg/runtime/common/DistributedUtils.h"
 #include "flashlight/pkg/speech/criterion/criterion.h"
@@ -22,6 +38,37 @@
 #include "flashlight/pkg/vision/models/ViT.h"
 
 DEFINE_bool(log_verbose, false, "Log out detailed running time benchmark");
+DEFINE_string(
+    json_output,
+    "",
+    "File to which the statistics of each run are appended, as a JSON object "
+    "per line");
+
+DEFINE_string(
+    models,
+    "vit,vit_inference,resnet34,resnet50,resnet50_inference,detr,lm,convlm,"
+    "convlm_inference,asr,conformer,conformer_inference,tds,tds_inference",
+    "Comma-separated models to benchmark, of vit, resnet34, resnet50, detr, "
+    "lm, convlm, asr, conformer and tds. The forward of a model is benchmarked "
+    "in eval mode with the suffix _inference, e.g. vit_inference");
+DEFINE_string(
+    batch_sizes,
+    "",
+    "Comma-separated batch sizes per process to sweep over, in tokens for the "
+    "LMs and utterances for ASR. Each model runs with its default one if "
+    "empty");
+DEFINE_string(
+    precisions,
+    "fp32,amp",
+    "Comma-separated precisions to sweep over, of fp32 and amp");
+DEFINE_string(
+    backends,
+    "",
+    "Comma-separated tensor backends to run the models on, of those built "
+    "among ArrayFire, OneDnn, Jit(ArrayFire) and Jit(OneDnn). The runs are "
+    "named <backend>/<model>; the backends which aren't built, and the runs "
+    "a backend doesn't support, are skipped. Only the default backend runs "
+    "if empty");
 
 DEFINE_bool(distributed_enable, false, "Enable distributed training");
 DEFINE_int64(
@@ -42,12 +89,54 @@ DEFINE_string(
     "Shared file path used for setting up rendezvous."
     "If empty, uses MPI to initialize.");
 
+// the backend of the runs with --backends, prefixing their names
+std::string currentBackend;
+
+/*
+ * Benchmarks the training of a model, or its forward in eval mode without the
+ * criterion if `inference`, and prints the statistics of the run.
+ */
+void benchmarkModel(
+    std::string name,
+    bool fp16,
+    bool inference,
+    std::shared_ptr<fl::Module>& model,
+    const fl::app::benchmark::Criterion& criterion,
+    const std::vector<fl::Variable>& input,
+    const fl::app::benchmark::BatchUnits& batch) {
+  fl::app::benchmark::ModelBenchmarker benchmarker(
+      model,
+      inference ? fl::app::benchmark::Criterion() : criterion,
+      fl::getWorldSize());
+  if (inference) {
+    std::vector<fl::Variable> inferenceInput;
+    for (const auto& in : input) {
+      inferenceInput.push_back(fl::noGrad(in.tensor()));
+    }
+    benchmarker.runInferenceBenchmark(inferenceInput);
+    name += " inference";
+  } else {
+    benchmarker.runBenchmark(input);
+  }
+  if (!currentBackend.empty()) {
+    name = currentBackend + "/" + name;
+  }
+
+  fl::app::benchmark::printInfo(
+      std::move(name),
+      fp16,
+      benchmarker,
+      batch,
+      FLAGS_log_verbose,
+      FLAGS_json_output);
+}
+
 /* ------------------------------- ViTBase ------------------------------- */
-void runViTBase(bool fp16 = false) {
+void runViTBase(int batchsize, bool fp16, bool inference) {
   fl::app::benchmark::init();
 
   // Data
-  const int batchsize = 64, imgSize = 224;
+  const int imgSize = 224;
   auto input = fl::input(fl::rand({imgSize, imgSize, 3, batchsize}));
   auto target = fl::noGrad(fl::rand({1000, batchsize}));
   if (fp16) {
@@ -74,21 +163,22 @@ void runViTBase(bool fp16 = false) {
   };
 
   // Test
-  fl::app::benchmark::ModelBenchmarker benchmarker(
-      model, criterion, fl::getWorldSize());
-  benchmarker.runBenchmark({input});
-
-  // Print
-  fl::app::benchmark::printInfo(
-      "ViTBase", fp16, benchmarker, batchsize, FLAGS_log_verbose);
+  benchmarkModel(
+      "ViTBase",
+      fp16,
+      inference,
+      model,
+      criterion,
+      {input},
+      {batchsize, batchsize});
 }
 
 /* ------------------------------- ResNet34 ------------------------------- */
-void runResNet34(bool fp16 = false) {
+void runResNet34(int batchsize, bool fp16, bool inference) {
   fl::app::benchmark::init();
 
   // Data
-  const int batchsize = 192, imgSize = 224;
+  const int imgSize = 224;
   auto input = fl::input(fl::rand({imgSize, imgSize, 3, batchsize}));
   auto target = fl::noGrad(fl::rand({batchsize}) * 1000).astype(fl::dtype::s32);
   if (fp16) {
@@ -104,21 +194,22 @@ void runResNet34(bool fp16 = false) {
   };
 
   // Test
-  fl::app::benchmark::ModelBenchmarker benchmarker(
-      model, criterion, fl::getWorldSize());
-  benchmarker.runBenchmark({input});
-
-  // Print
-  fl::app::benchmark::printInfo(
-      "ResNet34", fp16, benchmarker, batchsize, FLAGS_log_verbose);
+  benchmarkModel(
+      "ResNet34",
+      fp16,
+      inference,
+      model,
+      criterion,
+      {input},
+      {batchsize, batchsize});
 }
 
 /* ------------------------------- ResNet50 ------------------------------- */
-void runResNet50(bool fp16 = false) {
+void runResNet50(int batchsize, bool fp16, bool inference) {
   fl::app::benchmark::init();
 
   // Data
-  const int batchsize = 192, imgSize = 224;
+  const int imgSize = 224;
   auto input = fl::input(fl::rand({imgSize, imgSize, 3, batchsize}));
   auto target = fl::noGrad(fl::rand({batchsize}) * 1000).astype(fl::dtype::s32);
   if (fp16) {
@@ -134,22 +225,23 @@ void runResNet50(bool fp16 = false) {
   };
 
   // Test
-  fl::app::benchmark::ModelBenchmarker benchmarker(
-      model, criterion, fl::getWorldSize());
-  benchmarker.runBenchmark({input});
-
-  // Print
-  fl::app::benchmark::printInfo(
-      "ResNet50", fp16, benchmarker, batchsize, FLAGS_log_verbose);
+  benchmarkModel(
+      "ResNet50",
+      fp16,
+      inference,
+      model,
+      criterion,
+      {input},
+      {batchsize, batchsize});
 }
 
 /* ------------------------------- Detr ------------------------------- */
-void runDetr(bool fp16 = false) {
+void runDetr(int batchsize, bool fp16, bool inference) {
   fl::app::benchmark::init();
 
   // Data
   const auto dataType = fp16 ? fl::dtype::f16 : fl::dtype::f32;
-  const int batchsize = 12, numObjs = 4;
+  const int numObjs = 4;
   const int imgSize = 800;
   auto input = fl::input(fl::rand({imgSize, imgSize, 3, batchsize}, dataType));
   auto mask = fl::input(fl::rand({imgSize, imgSize, 1, batchsize}));
@@ -220,21 +312,22 @@ void runDetr(bool fp16 = false) {
   };
 
   // Test
-  fl::app::benchmark::ModelBenchmarker benchmarker(
-      model, criterion, fl::getWorldSize());
-  benchmarker.runBenchmark({input, mask});
-
-  // Print
-  fl::app::benchmark::printInfo(
-      "Detr", fp16, benchmarker, batchsize, FLAGS_log_verbose);
+  benchmarkModel(
+      "Detr",
+      fp16,
+      inference,
+      model,
+      criterion,
+      {input, mask},
+      {batchsize, batchsize});
 }
 
 /* ----------------------------- LM Transformer ----------------------------- */
-void runLmTransformer(bool fp16 = false) {
+void runLmTransformer(int batchsize, bool fp16, bool inference) {
   fl::app::benchmark::init();
 
   // Data
-  const int batchsize = 2048, numTokens = 150000;
+  const int numTokens = 150000;
   const std::vector<int> cutoff{10000, 50000, numTokens};
   auto rawInput = fl::rand({batchsize}) * cutoff[0];
   auto mask1 = fl::rand({batchsize}) < 0.2;
@@ -262,24 +355,26 @@ void runLmTransformer(bool fp16 = false) {
   };
 
   // Test
-  fl::app::benchmark::ModelBenchmarker benchmarker(
-      model, criterion, fl::getWorldSize());
-  benchmarker.runBenchmark({input});
-
-  // Print
-  fl::app::benchmark::printInfo(
-      "LM Transformer", fp16, benchmarker, batchsize, FLAGS_log_verbose);
+  benchmarkModel(
+      "LM Transformer",
+      fp16,
+      inference,
+      model,
+      criterion,
+      {input},
+      // a sequence of `batchsize` tokens
+      {batchsize, 1, batchsize});
 }
 
 /* ---------------------------- ASR Transformer ---------------------------- */
-void runAsrTransformer(bool fp16 = false) {
+void runAsrTransformer(int batchsize, bool fp16, bool inference) {
   fl::app::benchmark::init();
   if (fp16) {
     fl::OptimMode::get().setOptimLevel(fl::OptimLevel::O1);
   }
 
   // Data
-  const int batchsize = 8, numFrames = 1500, numFeatures = 80;
+  const int numFrames = 1500, numFeatures = 80;
   const int numTarget = 30, targetLength = 100;
 
   auto input = fl::input(fl::rand({numFrames, 1, numFeatures, batchsize}));
@@ -302,17 +397,166 @@ void runAsrTransformer(bool fp16 = false) {
   };
 
   // Test
-  fl::app::benchmark::ModelBenchmarker benchmarker(
-      model, criterion, fl::getWorldSize());
-  benchmarker.runBenchmark({input, lengths});
-
-  // Print
-  fl::app::benchmark::printInfo(
+  benchmarkModel(
       "ASR Transformer",
       fp16,
-      benchmarker,
-      batchsize * numFrames / 100,
-      FLAGS_log_verbose);
+      inference,
+      model,
+      criterion,
+      {input, lengths},
+      // seconds of audio, of 10ms frames
+      {batchsize * numFrames / 100, batchsize, batchsize * numFrames});
+}
+
+/* ---------------------------- ASR Conformer ---------------------------- */
+void runAsrConformer(int batchsize, bool fp16, bool inference) {
+  fl::app::benchmark::init();
+  if (fp16) {
+    fl::OptimMode::get().setOptimLevel(fl::OptimLevel::O1);
+  }
+
+  // Data
+  const int numFrames = 1500, numFeatures = 80;
+  const int numTarget = 30, targetLength = 100;
+
+  auto input = fl::input(fl::rand({numFrames, 1, numFeatures, batchsize}));
+  auto lengths = fl::input(fl::full({1, batchsize}, numFrames));
+  auto target = fl::noGrad(fl::rand({targetLength, batchsize}) * numTarget)
+                    .astype(fl::dtype::s32);
+
+  // Model
+  std::shared_ptr<fl::Module> model =
+      std::make_shared<fl::app::benchmark::AsrConformer>(
+          numFeatures, numTarget);
+
+  // Criterion
+  auto ctc = std::make_shared<fl::pkg::speech::CTCLoss>(
+      fl::lib::seq::CriterionScaleMode::NONE);
+
+  auto criterion =
+      [&ctc, &target](const std::vector<fl::Variable>& input) -> fl::Variable {
+    return ctc->forward({input.front(), target}).front();
+  };
+
+  // Test
+  benchmarkModel(
+      "ASR Conformer",
+      fp16,
+      inference,
+      model,
+      criterion,
+      {input, lengths},
+      // seconds of audio, of 10ms frames
+      {batchsize * numFrames / 100, batchsize, batchsize * numFrames});
+}
+
+/* ------------------------------- ASR TDS ------------------------------- */
+void runAsrTds(int batchsize, bool fp16, bool inference) {
+  fl::app::benchmark::init();
+  if (fp16) {
+    fl::OptimMode::get().setOptimLevel(fl::OptimLevel::O1);
+  }
+
+  // Data
+  const int numFrames = 1500, numFeatures = 80;
+  const int numTarget = 30, targetLength = 100;
+
+  auto input = fl::input(fl::rand({numFrames, 1, numFeatures, batchsize}));
+  auto target = fl::noGrad(fl::rand({targetLength, batchsize}) * numTarget)
+                    .astype(fl::dtype::s32);
+
+  // Model
+  std::shared_ptr<fl::Module> model =
+      std::make_shared<fl::app::benchmark::AsrTds>(numFeatures, numTarget);
+
+  // Criterion
+  auto ctc = std::make_shared<fl::pkg::speech::CTCLoss>(
+      fl::lib::seq::CriterionScaleMode::NONE);
+
+  auto criterion =
+      [&ctc, &target](const std::vector<fl::Variable>& input) -> fl::Variable {
+    return ctc->forward({input.front(), target}).front();
+  };
+
+  // Test
+  benchmarkModel(
+      "ASR TDS",
+      fp16,
+      inference,
+      model,
+      criterion,
+      {input},
+      // seconds of audio, of 10ms frames
+      {batchsize * numFrames / 100, batchsize, batchsize * numFrames});
+}
+
+/* -------------------------------- ConvLM -------------------------------- */
+void runConvLm(int batchsize, bool fp16, bool inference) {
+  fl::app::benchmark::init();
+  if (fp16) {
+    fl::OptimMode::get().setOptimLevel(fl::OptimLevel::O1);
+  }
+
+  // Data
+  // sequences of 256 tokens, as the context of the ConvLM of the decoder
+  const int numTokens = 150000, seqLength = 256;
+  const int numSequences = std::max(1, batchsize / seqLength);
+  const std::vector<int> cutoff{10000, 50000, numTokens};
+  const fl::Shape dims = {seqLength, numSequences};
+  auto rawInput = fl::rand(dims) * cutoff[0];
+  auto mask1 = fl::rand(dims) < 0.2;
+  auto mask2 = fl::rand(dims) < 0.05;
+  rawInput = rawInput + mask1 * cutoff[0] + mask2 * cutoff[1];
+  auto input = fl::input(rawInput.astype(fl::dtype::s32));
+  auto target = fl::noGrad(rawInput.astype(fl::dtype::s32));
+
+  // Model
+  std::shared_ptr<fl::Module> model =
+      std::make_shared<fl::app::benchmark::ConvLm>(numTokens);
+
+  // Criterion
+  auto softmax = std::make_shared<fl::AdaptiveSoftMax>(
+      1024, // adsm_input_size
+      cutoff);
+  auto adsm = std::make_shared<fl::AdaptiveSoftMaxLoss>(
+      softmax, fl::ReduceMode::SUM, 1 // padIdx
+  );
+
+  auto criterion =
+      [&adsm, &target](const std::vector<fl::Variable>& input) -> fl::Variable {
+    adsm->train();
+    return adsm->forward(input.front().astype(fl::dtype::f32), target);
+  };
+
+  // Test
+  benchmarkModel(
+      "ConvLM",
+      fp16,
+      inference,
+      model,
+      criterion,
+      {input},
+      {seqLength * numSequences, numSequences, seqLength * numSequences});
+}
+
+// The backends which are built, with a function making each the default
+std::map<std::string, std::function<void()>> availableBackends() {
+  std::map<std::string, std::function<void()>> backends;
+#if FL_USE_ARRAYFIRE
+  backends["ArrayFire"] = fl::setDefaultTensorType<fl::ArrayFireTensor>;
+#endif
+#if FL_USE_ONEDNN
+  backends["OneDnn"] = fl::setDefaultTensorType<fl::OneDnnTensor>;
+#endif
+#if FL_USE_JIT && FL_USE_ARRAYFIRE
+  backends["Jit(ArrayFire)"] =
+      fl::setDefaultTensorType<fl::JitTensor<fl::ArrayFireTensor>>;
+#endif
+#if FL_USE_JIT && FL_USE_ONEDNN
+  backends["Jit(OneDnn)"] =
+      fl::setDefaultTensorType<fl::JitTensor<fl::OneDnnTensor>>;
+#endif
+  return backends;
 }
 
 int main(int argc, char** argv) {
@@ -327,21 +571,97 @@ int main(int argc, char** argv) {
         FLAGS_distributed_rndv_filepath);
   }
 
-  runViTBase();
-  runViTBase(true);
-
-  runResNet34();
-  runResNet34(true);
-
-  runResNet50();
-  runResNet50(true);
-
-  runDetr();
-  runDetr(true);
+  struct Model {
+    std::function<void(int, bool, bool)> run;
+    int defaultBatchSize;
+  };
+  const std::map<std::string, Model> models = {
+      {"vit", {runViTBase, 64}},
+      {"resnet34", {runResNet34, 192}},
+      {"resnet50", {runResNet50, 192}},
+      {"detr", {runDetr, 12}},
+      {"lm", {runLmTransformer, 2048}},
+      {"convlm", {runConvLm, 2048}},
+      {"asr", {runAsrTransformer, 8}},
+      {"conformer", {runAsrConformer, 8}},
+      {"tds", {runAsrTds, 8}}};
+  const std::string kInferenceSuffix = "_inference";
+
+  std::vector<int> batchSizes;
+  for (const auto& batchSize : fl::lib::split(',', FLAGS_batch_sizes, true)) {
+    batchSizes.push_back(std::stoi(batchSize));
+  }
+  std::vector<bool> precisions;
+  for (const auto& precision : fl::lib::split(',', FLAGS_precisions, true)) {
+    if (precision != "fp32" && precision != "amp") {
+      throw std::invalid_argument("Unknown precision " + precision);
+    }
+    precisions.push_back(precision == "amp");
+  }
 
-  runLmTransformer();
-  runLmTransformer(true);
+  struct Run {
+    std::string name;
+    const Model* model;
+    int batchSize;
+    bool fp16;
+    bool inference;
+  };
+  std::vector<Run> runs;
+  for (auto name : fl::lib::split(',', FLAGS_models, true)) {
+    // the inference variant of a model, e.g. vit_inference
+    const bool inference = name.size() > kInferenceSuffix.size() &&
+        name.compare(
+            name.size() - kInferenceSuffix.size(),
+            kInferenceSuffix.size(),
+            kInferenceSuffix) == 0;
+    if (inference) {
+      name.resize(name.size() - kInferenceSuffix.size());
+    }
+    auto model = models.find(name);
+    if (model == models.end()) {
+      throw std::invalid_argument("Unknown model " + name);
+    }
+    const auto& sizes = batchSizes.empty()
+        ? std::vector<int>{model->second.defaultBatchSize}
+        : batchSizes;
+    for (const int batchSize : sizes) {
+      for (const bool fp16 : precisions) {
+        runs.push_back(
+            {name + (inference ? kInferenceSuffix : ""),
+             &model->second,
+             batchSize,
+             fp16,
+             inference});
+      }
+    }
+  }
 
-  runAsrTransformer();
-  runAsrTransformer(true);
+  const auto backends = availableBackends();
+  const auto backendNames = fl::lib::split(',', FLAGS_backends, true);
+  if (backendNames.empty()) {
+    for (const auto& run : runs) {
+      run.model->run(run.batchSize, run.fp16, run.inference);
+    }
+    return 0;
+  }
+  for (const auto& backendName : backendNames) {
+    auto backend = backends.find(backendName);
+    if (backend == backends.end()) {
+      std::cerr << "Backend " << backendName << " isn't built, skipped"
+                << std::endl;
+      continue;
+    }
+    backend->second();
+    currentBackend = backendName;
+    for (const auto& run : runs) {
+      // not every backend implements every op
+      try {
+        run.model->run(run.batchSize, run.fp16, run.inference);
+      } catch (const std::exception& ex) {
+        std::cerr << backendName << "/" << run.name << " skipped: " << ex.what()
+                  << std::endl;
+      }
+    }
+  }
+  return 0;
 }
@@ -7,7 +7,9 @@
 
 #include "flashlight/app/benchmark/Utils.h"
 
+#include <fstream>
 #include <iomanip>
+#include <stdexcept>
 
 #include "flashlight/fl/flashlight.h"
 #include "flashlight/lib/text/String.h"
@@ -25,33 +27,86 @@ void printInfo(
     std::string&& name,
     bool fp16,
     const fl::app::benchmark::ModelBenchmarker& benchmarker,
-    int numUnits,
-    bool verbose) {
+    const BatchUnits& batch,
+    bool verbose,
+    const std::string& jsonPath) {
   if (fl::getWorldRank() != 0) {
     return;
   }
   name += fp16 ? " + AMP" : "";
+  const double batchTime = benchmarker.getBatchTime();
+  const int worldSize = fl::getWorldSize();
+  const double throughput = batch.units * worldSize / batchTime;
+  const double samplesPerSec = batch.samples * worldSize / batchTime;
+  const double tokensPerSec = batch.tokens * worldSize / batchTime;
+  // the percentiles are those of the batches of this process
+  const double p50 = benchmarker.getBatchTimePercentile(50);
+  const double p90 = benchmarker.getBatchTimePercentile(90);
+  const double p99 = benchmarker.getBatchTimePercentile(99);
+  const double peakMemoryGb = benchmarker.getPeakMemoryBytes() / 1e9;
+
   std::cout << std::fixed << std::setprecision(2);
   std::cout << "\n----- " + name + " -----" << std::endl;
 
-  std::cout << "Throughput: "
-            << (numUnits * fl::getWorldSize() / benchmarker.getBatchTime());
+  std::cout << "Throughput: " << throughput;
+  std::cout << "\nSamples/sec: " << samplesPerSec;
+  if (batch.tokens > 0) {
+    std::cout << "\nTokens/sec: " << tokensPerSec;
+  }
+  std::cout << "\nBatch Time p50/p90/p99(ms): " << p50 * 1000 << " / "
+            << p90 * 1000 << " / " << p99 * 1000;
+  std::cout << "\nPeak Memory(GB): " << peakMemoryGb;
   std::cout << std::endl;
 
   if (verbose) {
-    std::cout << "\nBatch Time(ms): " << benchmarker.getBatchTime() * 1000;
+    std::cout << "\nBatch Time(ms): " << batchTime * 1000;
     std::cout << "\nModel Forward Time(ms): "
               << benchmarker.getForwardTime() * 1000;
     std::cout << "\nCriterion Forward Time(ms): "
               << benchmarker.getCriterionTime() * 1000;
     std::cout << "\nBackward Time(ms): "
               << benchmarker.getBackwardTime() * 1000;
+    std::cout << "\nAllreduce Time(ms): "
+              << benchmarker.getAllreduceTime() * 1000;
     std::cout << "\nOptimization Time(ms): "
               << benchmarker.getOptimizationTime() * 1000;
     std::cout << std::endl;
 
     fl::detail::getMemMgrInfo("Memory Manager Stats", /* device id = */ 0);
   }
+
+  if (!jsonPath.empty()) {
+    std::ofstream json(jsonPath, std::ios_base::app);
+    if (!json) {
+      throw std::runtime_error("printInfo - unable to open " + jsonPath);
+    }
+    // the names of the models have no characters to escape
+    json << std::setprecision(6) << "{\"model\": \"" << name << "\""
+         << ", \"precision\": \"" << (fp16 ? "amp" : "fp32") << "\""
+         << ", \"world_size\": " << worldSize
+         << ", \"batch_samples\": " << batch.samples
+         << ", \"batch_tokens\": " << batch.tokens
+         << ", \"throughput\": " << throughput
+         << ", \"samples_per_sec\": " << samplesPerSec
+         << ", \"tokens_per_sec\": " << tokensPerSec
+         << ", \"batch_time_ms\": " << batchTime * 1000
+         << ", \"batch_time_p50_ms\": " << p50 * 1000
+         << ", \"batch_time_p90_ms\": " << p90 * 1000
+         << ", \"batch_time_p99_ms\": " << p99 * 1000
+         << ", \"forward_time_ms\": " << benchmarker.getForwardTime() * 1000
+         << ", \"criterion_time_ms\": "
+         << benchmarker.getCriterionTime() * 1000
+         << ", \"backward_time_ms\": " << benchmarker.getBackwardTime() * 1000
+         << ", \"allreduce_time_ms\": "
+         << benchmarker.getAllreduceTime() * 1000
+         << ", \"optimization_time_ms\": "
+         << benchmarker.getOptimizationTime() * 1000
+         << ", \"peak_memory_bytes\": " << benchmarker.getPeakMemoryBytes()
+         << "}" << std::endl;
+    if (!json) {
+      throw std::runtime_error("printInfo - failed to write " + jsonPath);
+    }
+  }
 }
 
 } // namespace benchmark
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 #include "flashlight/app/benchmark/ModelBenchmarker.h"
@@ -20,16 +21,32 @@ namespace benchmark {
  */
 void init();
 
+/**
+ * The amounts of data of the batch of a process, from which the throughputs
+ * of a run are computed.
+ */
+struct BatchUnits {
+  // in the units of the throughput of the model, e.g. images, tokens or
+  // seconds of audio
+  int64_t units;
+  // e.g. images, sequences or utterances
+  int64_t samples;
+  // the tokens or frames of the samples, 0 if they have none
+  int64_t tokens{0};
+};
+
 /**
  * Log out the statistics of the current run. Details will also be logged out
- * when `verbose` is on.
+ * when `verbose` is on. If `jsonPath` isn't empty, they are also appended to
+ * it as a JSON object of one line.
  */
 void printInfo(
     std::string&& name,
     bool fp16,
     const fl::app::benchmark::ModelBenchmarker& benchmarker,
-    int numUnits,
-    bool verbose = false);
+    const BatchUnits& batch,
+    bool verbose = false,
+    const std::string& jsonPath = "");
 
 } // namespace benchmark
 } // namespace app
@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/app/benchmark/models/AsrConformer.h"
+
+namespace fl {
+namespace app {
+namespace benchmark {
+
+AsrConformer::AsrConformer(int64_t nFeature, int64_t nLabel) {
+  const int modelDim = 512;
+  const float dropout = 0.1;
+  convFrontend_->add(std::make_shared<fl::View>(Shape({-1, 1, nFeature, 0})));
+  // Time x 1 x nFeature x Batch
+  std::vector<int> lnDims = {0, 1, 2};
+  convFrontend_->add(std::make_shared<fl::LayerNorm>(lnDims));
+  convFrontend_->add(std::make_shared<fl::Conv2D>(
+      nFeature, 2 * modelDim, 7, 1, 3, 1, -1, 0, 1, 1));
+  convFrontend_->add(std::make_shared<fl::GatedLinearUnit>(2));
+  convFrontend_->add(std::make_shared<fl::Dropout>(dropout));
+  convFrontend_->add(std::make_shared<fl::Reorder>(Shape({2, 0, 3, 1})));
+  // nFeature x Time x Batch x 1
+  add(convFrontend_);
+  for (int idx = 0; idx < 16; idx++) {
+    auto layer = std::make_shared<fl::Conformer>(
+        modelDim, 64, 2048, 8, 33, 31, dropout, dropout);
+    conformers_.push_back(layer);
+    add(layer);
+  }
+  linear_ = std::make_shared<fl::Linear>(modelDim, nLabel);
+  add(linear_);
+}
+
+std::vector<fl::Variable> AsrConformer::forward(
+    const std::vector<fl::Variable>& input) {
+  auto out = input[0];
+  auto xSizes = input[1].tensor();
+  // expected input dims T x C x 1 x B
+  int B = out.dim(3);
+  out = convFrontend_->forward(out);
+  out = fl::moddims(out, {out.dim(0), out.dim(1), out.dim(2)});
+  // the lengths of the inputs, subsampled by the frontend
+  int subsampledT = out.dim(1);
+  auto inputMaxSize = fl::tile(fl::amax(xSizes, {0}), {1, B});
+  Tensor inputNotPaddedSize = fl::ceil(xSizes * subsampledT / inputMaxSize);
+  auto padMask = fl::iota({subsampledT, 1}, {1, B}) <
+      fl::tile(inputNotPaddedSize, {subsampledT, 1});
+  for (auto& conformer : conformers_) {
+    out = conformer->forward({out, fl::noGrad(padMask)}).front();
+  }
+  out = linear_->forward(out);
+  return {out.astype(input[0].type())};
+}
+
+std::string AsrConformer::prettyString() const {
+  std::ostringstream ss;
+  ss << "AsrConformer: ";
+  ss << convFrontend_->prettyString() << "\n";
+  for (const auto& conformer : conformers_) {
+    ss << conformer->prettyString() << "\n";
+  }
+  ss << linear_->prettyString() << "\n";
+  return ss.str();
+}
+
+} // namespace benchmark
+} // namespace app
+} // namespace fl
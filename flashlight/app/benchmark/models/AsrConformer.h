@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "flashlight/fl/contrib/modules/modules.h"
+#include "flashlight/fl/flashlight.h"
+#include "flashlight/fl/nn/modules/modules.h"
+
+namespace fl {
+namespace app {
+namespace benchmark {
+
+/**
+ * This is a typical [Conformer](https://arxiv.org/abs/2005.08100) model
+ * designed for speech recognition, whose convolutional frontend subsamples the
+ * input by 3. We use CTC criterion on top of it in this benchmark.
+ */
+class AsrConformer : public fl::Container {
+ public:
+  AsrConformer(int64_t nFeature, int64_t nLabel);
+
+  std::vector<fl::Variable> forward(
+      const std::vector<fl::Variable>& input) override;
+
+  std::string prettyString() const override;
+
+ private:
+  AsrConformer() = default;
+
+  std::shared_ptr<fl::Sequential> convFrontend_{
+      std::make_shared<fl::Sequential>()};
+  std::vector<std::shared_ptr<fl::Conformer>> conformers_;
+  std::shared_ptr<fl::Linear> linear_;
+};
+
+} // namespace benchmark
+} // namespace app
+} // namespace fl
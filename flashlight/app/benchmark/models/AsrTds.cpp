@@ -0,0 +1,66 @@
+/**
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/app/benchmark/models/AsrTds.h"
+
+namespace fl {
+namespace app {
+namespace benchmark {
+
+AsrTds::AsrTds(int64_t nFeature, int64_t nLabel) : nFeature_(nFeature) {
+  const double dropout = 0.2;
+  const int kernelSize = 21;
+  // the channels and blocks of the groups
+  const std::vector<std::pair<int, int>> groups = {{10, 2}, {14, 3}, {18, 6}};
+  tds_->add(std::make_shared<fl::View>(Shape({-1, nFeature, 1, 0})));
+  // Time x nFeature x 1 x Batch
+  int nIn = 1;
+  for (const auto& [channels, nBlocks] : groups) {
+    tds_->add(std::make_shared<fl::Conv2D>(
+        nIn, channels, kernelSize, 1, 2, 1, -1, -1, 1, 1));
+    tds_->add(std::make_shared<fl::ReLU>());
+    tds_->add(std::make_shared<fl::Dropout>(dropout));
+    std::vector<int> lnDims = {0, 1, 2};
+    tds_->add(std::make_shared<fl::LayerNorm>(lnDims));
+    for (int idx = 0; idx < nBlocks; idx++) {
+      tds_->add(std::make_shared<fl::TDSBlock>(
+          channels, kernelSize, nFeature, dropout));
+    }
+    nIn = channels;
+  }
+  // Time x nFeature x nChannel x Batch
+  add(tds_);
+  nChannel_ = nIn;
+  decoder_->add(std::make_shared<fl::Linear>(nFeature * nChannel_, 1024));
+  decoder_->add(std::make_shared<fl::ReLU>());
+  decoder_->add(std::make_shared<fl::Dropout>(dropout));
+  decoder_->add(std::make_shared<fl::Linear>(1024, nLabel));
+  add(decoder_);
+}
+
+std::vector<fl::Variable> AsrTds::forward(
+    const std::vector<fl::Variable>& input) {
+  auto out = tds_->forward(input[0]);
+  int T = out.dim(0), B = out.dim(3);
+  // (nFeature * nChannel) x Time x Batch
+  out = fl::moddims(
+      fl::reorder(out, {1, 2, 0, 3}), {nFeature_ * nChannel_, T, B});
+  out = decoder_->forward(out);
+  return {out.astype(input[0].type())};
+}
+
+std::string AsrTds::prettyString() const {
+  std::ostringstream ss;
+  ss << "AsrTds: ";
+  ss << tds_->prettyString() << "\n";
+  ss << decoder_->prettyString() << "\n";
+  return ss.str();
+}
+
+} // namespace benchmark
+} // namespace app
+} // namespace fl
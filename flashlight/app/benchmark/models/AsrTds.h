@@ -0,0 +1,44 @@
+/**
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "flashlight/fl/contrib/modules/modules.h"
+#include "flashlight/fl/flashlight.h"
+#include "flashlight/fl/nn/modules/modules.h"
+
+namespace fl {
+namespace app {
+namespace benchmark {
+
+/**
+ * This is a typical [TDS](https://arxiv.org/abs/1904.02619) model designed for
+ * speech recognition, of three groups of TDS blocks each following a
+ * convolution which subsamples the input by 2. We use CTC criterion on top of
+ * it in this benchmark.
+ */
+class AsrTds : public fl::Container {
+ public:
+  AsrTds(int64_t nFeature, int64_t nLabel);
+
+  std::vector<fl::Variable> forward(
+      const std::vector<fl::Variable>& input) override;
+
+  std::string prettyString() const override;
+
+ private:
+  AsrTds() = default;
+
+  int64_t nFeature_;
+  int64_t nChannel_;
+  std::shared_ptr<fl::Sequential> tds_{std::make_shared<fl::Sequential>()};
+  std::shared_ptr<fl::Sequential> decoder_{std::make_shared<fl::Sequential>()};
+};
+
+} // namespace benchmark
+} // namespace app
+} // namespace fl
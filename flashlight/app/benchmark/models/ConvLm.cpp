@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/app/benchmark/models/ConvLm.h"
+
+namespace fl {
+namespace app {
+namespace benchmark {
+
+ConvLm::ConvLm(int64_t nLabel) {
+  const int embeddingDim = 1024, kernelSize = 4;
+  embedding_ = std::make_shared<fl::Embedding>(embeddingDim, nLabel);
+  add(embedding_);
+  for (int idx = 0; idx < 14; idx++) {
+    // Time x 1 x nFeature x Batch
+    auto block = std::make_shared<fl::Sequential>();
+    block->add(std::make_shared<fl::AsymmetricConv1D>(
+        embeddingDim,
+        2 * embeddingDim,
+        kernelSize,
+        1,
+        fl::PaddingMode::SAME,
+        /* futurePart = */ 0));
+    block->add(std::make_shared<fl::GatedLinearUnit>(2));
+    block->add(std::make_shared<fl::Dropout>(0.1));
+    blocks_.push_back(block);
+    add(block);
+  }
+}
+
+std::vector<fl::Variable> ConvLm::forward(
+    const std::vector<fl::Variable>& input) {
+  // Time x Batch
+  int T = input[0].dim(0), B = input[0].dim(1);
+  auto out = embedding_->forward(input[0]);
+  out = fl::reorder(fl::moddims(out, {out.dim(0), T, B, 1}), {1, 3, 0, 2});
+  // Time x 1 x nFeature x Batch
+  for (auto& block : blocks_) {
+    out = out + block->forward(out);
+  }
+  // nFeature x Time x Batch x 1
+  return {fl::reorder(out, {2, 0, 3, 1})};
+}
+
+std::string ConvLm::prettyString() const {
+  std::ostringstream ss;
+  ss << "ConvLm: ";
+  ss << embedding_->prettyString() << "\n";
+  for (const auto& block : blocks_) {
+    ss << block->prettyString() << "\n";
+  }
+  return ss.str();
+}
+
+} // namespace benchmark
+} // namespace app
+} // namespace fl
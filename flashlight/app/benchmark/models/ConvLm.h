@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "flashlight/fl/contrib/modules/modules.h"
+#include "flashlight/fl/flashlight.h"
+#include "flashlight/fl/nn/modules/modules.h"
+
+namespace fl {
+namespace app {
+namespace benchmark {
+
+/**
+ * This is a typical [gated convolutional language
+ * model](https://arxiv.org/abs/1612.08083), of residual blocks of causal
+ * convolutions and gated linear units, as the ConvLM of the speech decoder.
+ * We use [adaptive softmax](https://arxiv.org/abs/1609.04309) criterion on top
+ * of it in this benchmark.
+ */
+class ConvLm : public fl::Container {
+ public:
+  explicit ConvLm(int64_t nLabel);
+
+  std::vector<fl::Variable> forward(
+      const std::vector<fl::Variable>& input) override;
+
+  std::string prettyString() const override;
+
+ private:
+  ConvLm() = default;
+
+  std::shared_ptr<fl::Embedding> embedding_;
+  std::vector<std::shared_ptr<fl::Sequential>> blocks_;
+};
+
+} // namespace benchmark
+} // namespace app
+} // namespace fl
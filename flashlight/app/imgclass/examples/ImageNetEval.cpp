@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <chrono>
 #include <exception>
 #include <iomanip>
 
@@ -16,6 +17,7 @@
 #include "flashlight/fl/dataset/datasets.h"
 #include "flashlight/fl/meter/meters.h"
 #include "flashlight/fl/optim/optim.h"
+#include "flashlight/fl/tensor/Compute.h"
 #include "flashlight/fl/tensor/Init.h"
 #include "flashlight/pkg/runtime/common/DistributedUtils.h"
 #include "flashlight/pkg/vision/dataset/DistributedDataset.h"
@@ -28,6 +30,15 @@
 
 DEFINE_string(data_dir, "", "Directory of imagenet data");
 DEFINE_uint64(data_batch_size, 256, "Batch size per gpus");
+DEFINE_int64(
+    data_prefetch_thread,
+    10,
+    "Number of threads decoding batches ahead of the evaluation");
+DEFINE_bool(
+    data_fused_eval,
+    true,
+    "Decode, crop and normalize each batch at once on the device, instead of "
+    "transforming the images one by one on the host");
 DEFINE_string(exp_checkpoint_path, "/tmp/model", "Checkpointing prefix path");
 
 DEFINE_bool(distributed_enable, true, "Enable distributed evaluation");
@@ -85,30 +96,49 @@ int main(int argc, char** argv) {
   const int imageSize = 224;
   // Conventional image resize parameter used for evaluation
   const int randomResizeMin = imageSize / .875;
-  ImageTransform testTransforms = compose(
-      {fl::pkg::vision::resizeTransform(randomResizeMin),
-       fl::pkg::vision::centerCropTransform(imageSize),
-       fl::pkg::vision::normalizeImage(
-           fl::app::image::kImageNetMean, fl::app::image::kImageNetStd)});
-
   auto labelMap = getImagenetLabels(labelPath);
-  auto testDataset = fl::pkg::vision::DistributedDataset(
-      imagenetDataset(testList, labelMap, {testTransforms}),
-      worldRank,
-      worldSize,
-      FLAGS_data_batch_size,
-      1, // train_n_repeatedaug
-      10, // prefetch threads
-      FLAGS_data_batch_size,
-      fl::BatchDatasetPolicy::INCLUDE_LAST);
-  FL_LOG_MASTER(INFO) << "[testDataset size] " << testDataset.size();
+  std::shared_ptr<Dataset> testDataset;
+  if (FLAGS_data_fused_eval) {
+    testDataset = std::make_shared<PrefetchDataset>(
+        imagenetEvalDataset(
+            testList,
+            labelMap,
+            FLAGS_data_batch_size,
+            worldRank,
+            worldSize,
+            randomResizeMin,
+            imageSize,
+            fl::app::image::kImageNetMean,
+            fl::app::image::kImageNetStd),
+        FLAGS_data_prefetch_thread,
+        FLAGS_data_prefetch_thread);
+  } else {
+    ImageTransform testTransforms = compose(
+        {fl::pkg::vision::resizeTransform(randomResizeMin),
+         fl::pkg::vision::centerCropTransform(imageSize),
+         fl::pkg::vision::normalizeImage(
+             fl::app::image::kImageNetMean, fl::app::image::kImageNetStd)});
+    testDataset = std::make_shared<fl::pkg::vision::DistributedDataset>(
+        imagenetDataset(testList, labelMap, {testTransforms}),
+        worldRank,
+        worldSize,
+        FLAGS_data_batch_size,
+        1, // train_n_repeatedaug
+        FLAGS_data_prefetch_thread,
+        FLAGS_data_batch_size,
+        fl::BatchDatasetPolicy::INCLUDE_LAST);
+  }
+  FL_LOG_MASTER(INFO) << "[testDataset size] " << testDataset->size();
 
   // The main evaluation loop
   TopKMeter top5Acc(5);
   TopKMeter top1Acc(1);
 
+  // The meters count on the device, such that the loop is not synchronized
+  // with the host until the end of the evaluation
   model->eval();
-  for (auto& example : testDataset) {
+  auto start = std::chrono::steady_clock::now();
+  for (auto& example : *testDataset) {
     auto inputs = noGrad(example[kImagenetInputIdx]);
     auto output = model->forward({inputs}).front();
     auto target = noGrad(example[kImagenetTargetIdx]);
@@ -116,9 +146,15 @@ int main(int argc, char** argv) {
     top5Acc.add(output.tensor(), target.tensor());
     top1Acc.add(output.tensor(), target.tensor());
   }
+  fl::sync();
+  const double elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
   fl::pkg::runtime::syncMeter(top5Acc);
   fl::pkg::runtime::syncMeter(top1Acc);
 
+  FL_LOG_MASTER(INFO) << "Evaluated " << top1Acc.getStats().second
+                      << " images in " << elapsed << "s";
   FL_LOG_MASTER(INFO) << "Top 5 acc: " << top5Acc.value();
   FL_LOG_MASTER(INFO) << "Top 1 acc: " << top1Acc.value();
 }
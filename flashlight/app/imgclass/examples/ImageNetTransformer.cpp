@@ -349,6 +349,15 @@ int main(int argc, char** argv) {
   if (FLAGS_exp_checkpoint_epoch >= 0) {
     loadModel();
   }
+  // resumes after the last batch of the checkpoint rather than replaying its
+  // epoch
+  const int64_t epochBatches = trainDataset->size();
+  int64_t startBatch = std::max<int64_t>(
+      0, batchIdx - static_cast<int64_t>(epoch) * epochBatches);
+  if (epochBatches > 0) {
+    epoch += startBatch / epochBatches;
+    startBatch %= epochBatches;
+  }
 
   auto betaGeneratorMixup = fl::lib::beta_distribution<float>(
       FLAGS_train_aug_p_mixup, FLAGS_train_aug_p_mixup);
@@ -384,7 +393,8 @@ int main(int argc, char** argv) {
   TimeMeter timeMeter;
   AverageValueMeter trainLossMeter;
   for (; epoch < FLAGS_train_epochs; epoch++) {
-    trainDataset->resample(epoch);
+    trainDataset->resample(epoch, startBatch);
+    startBatch = 0;
     lrScheduler(epoch);
 
     timeMeter.resume();
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <fstream>
+
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/lib/text/String.h"
+#include "flashlight/lib/text/dictionary/Defines.h"
+#include "flashlight/lib/text/dictionary/Dictionary.h"
+#include "flashlight/lib/text/tokenizer/Tokenizer.h"
+#include "flashlight/pkg/runtime/Runtime.h"
+#include "flashlight/pkg/text/data/TokenCorpus.h"
+
+/**
+ * Build a pre-tokenized corpus for LM training
+ *
+ * Usage:
+ *
+ *  corpus_builder \
+ *   --data_dir=/tmp \
+ *   --data_train=test1.txt,test2.txt \
+ *   --dictionary=dictionary.txt \
+ *   --dictionary_max_size=200000 \
+ *   --corpus=/tmp/train.tok
+ *
+ * -------------------------------
+ *
+ * It tokenizes the files once with the dictionary and saves their token
+ * indices as a `TokenCorpus`, which the training then maps with
+ * `--data_train=train.tok` instead of tokenizing the files on every rank. The
+ * dictionary and its maximum size must be those of the training.
+ */
+
+namespace {
+DEFINE_string(
+    data_dir,
+    "",
+    "Prefix for the 'data_train' files.");
+DEFINE_string(
+    data_train,
+    "",
+    "Comma-separated list of data files; '--data_dir' will be used to add prefix for the files.");
+DEFINE_string(
+    dictionary,
+    "",
+    "Path to the dictionary file, which defines tokens set of language model.");
+DEFINE_int64(
+    dictionary_max_size,
+    -1,
+    "Number of rows to use from the dictionary file (top rows), cutting the number of target classes.");
+DEFINE_string(corpus, "", "Path to the corpus file to write");
+} // namespace
+
+int main(int argc, char** argv) {
+  fl::init();
+  std::string exec(argv[0]);
+  gflags::SetUsageMessage(
+      "Tokenization of the text data into a corpus. \n Usage: " + exec +
+      " \n Compulsory: [--data_train] [--dictionary] [--corpus]");
+  LOG(INFO) << "Parsing command line flags";
+  gflags::ParseCommandLineFlags(&argc, &argv, false);
+  LOG(INFO) << "Gflags after parsing \n"
+            << fl::pkg::runtime::serializeGflags("; ");
+
+  if (argc <= 1 || FLAGS_data_train.empty() || FLAGS_dictionary.empty() ||
+      FLAGS_corpus.empty()) {
+    throw std::invalid_argument(gflags::ProgramUsage());
+  }
+
+  // the dictionary as read by the training
+  fl::lib::text::Dictionary dictionary;
+  std::ifstream stream(FLAGS_dictionary);
+  if (!stream) {
+    throw std::runtime_error("BuildCorpus - invalid dictionary filepath");
+  }
+  std::string line;
+  while (std::getline(stream, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    auto tkns = fl::lib::splitOnWhitespace(line, true);
+    if (tkns.empty()) {
+      continue;
+    }
+    dictionary.addEntry(tkns.front());
+    if (dictionary.entrySize() == FLAGS_dictionary_max_size &&
+        FLAGS_dictionary_max_size > 0) {
+      break;
+    }
+  }
+  if (!dictionary.isContiguous()) {
+    throw std::runtime_error("Invalid dictionary format - not contiguous");
+  }
+  dictionary.setDefaultIndex(
+      dictionary.getIndex(fl::lib::text::kUnkToken));
+
+  const auto numTokens = fl::pkg::text::TokenCorpus::compile(
+      FLAGS_data_dir,
+      FLAGS_data_train,
+      fl::lib::text::Tokenizer(),
+      dictionary,
+      FLAGS_corpus);
+  LOG(INFO) << "  Saved " << numTokens << " tokens to: " << FLAGS_corpus;
+
+  return 0;
+}
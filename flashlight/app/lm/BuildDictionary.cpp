@@ -12,11 +12,15 @@
 #include <sstream>
 
 #include "flashlight/app/lm/common/Defines.h"
+#include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/fl/common/Logging.h"
+#include "flashlight/fl/distributed/DistributedApi.h"
 #include "flashlight/fl/tensor/Init.h"
 #include "flashlight/lib/text/String.h"
 #include "flashlight/lib/text/tokenizer/Tokenizer.h"
 #include "flashlight/pkg/runtime/Runtime.h"
+#include "flashlight/pkg/runtime/common/DistributedUtils.h"
+#include "flashlight/pkg/text/data/TokenCounter.h"
 
 /**
  * Build dictioinary for LM training
@@ -38,6 +42,12 @@
  * filter by appearance and then be saved out as dictionary. If `write_meta` is
  * on, the meta data of each training file will also be generated in the same
  * folder with suffix `.desc`.
+ *
+ * Each file is split into byte ranges which `n_workers` threads count in
+ * parallel. With `--distributed_enable`, several processes split the files
+ * as well: each one counts its part of the ranges and saves its counts next
+ * to the dictionary, which the process of rank 0 merges. The meta data is only
+ * generated by a single process.
  */
 
 namespace {
@@ -68,6 +78,28 @@ DEFINE_bool(
     write_meta,
     false,
     "Generate (true) or not (false) the meta data of a file");
+
+DEFINE_bool(
+    distributed_enable,
+    false,
+    "Count the tokens with several processes");
+DEFINE_int64(
+    distributed_world_rank,
+    0,
+    "rank of the process (Used if distributed_rndv_filepath is not empty)");
+DEFINE_int64(
+    distributed_world_size,
+    1,
+    "total number of the process (Used if distributed_rndv_filepath is not empty)");
+DEFINE_int64(
+    distributed_max_devices_per_node,
+    8,
+    "the maximum number of devices per node");
+DEFINE_string(
+    distributed_rndv_filepath,
+    "",
+    "Shared file path used for setting up rendezvous."
+    "If empty, uses MPI to initialize.");
 } // namespace
 
 int main(int argc, char** argv) {
@@ -88,12 +120,13 @@ int main(int argc, char** argv) {
   auto tokenizer = fl::lib::text::Tokenizer();
   auto files = fl::lib::split(',', FLAGS_data_train);
 
-  for (const auto& file : files) {
-    LOG(INFO) << "Parsing " << file;
-    tokenizer.countTokens(
-        fs::path(FLAGS_data_dir) / file, FLAGS_n_workers, FLAGS_write_meta);
+  std::vector<std::pair<std::string, int64_t>> tokenCountPairs;
+  if (FLAGS_write_meta) {
+    for (const auto& file : files) {
+      LOG(INFO) << "Parsing " << file;
+      tokenizer.countTokens(
+          fs::path(FLAGS_data_dir) / file, FLAGS_n_workers, FLAGS_write_meta);
 
-    if (FLAGS_write_meta) {
       auto metaPath = file + ".desc";
 
       std::ofstream stream(metaPath);
@@ -109,15 +142,66 @@ int main(int argc, char** argv) {
       }
       LOG(INFO) << "  Meta data saved to: " << metaPath;
     }
-  }
 
-  LOG(INFO) << " --- Data Loading completed. --- ";
-  LOG(INFO) << "  Loaded " << tokenizer.totalTokens() << " tokens";
-  LOG(INFO) << "  Loaded " << tokenizer.totalSentences() << " sentences";
+    LOG(INFO) << " --- Data Loading completed. --- ";
+    LOG(INFO) << "  Loaded " << tokenizer.totalTokens() << " tokens";
+    LOG(INFO) << "  Loaded " << tokenizer.totalSentences() << " sentences";
+
+    tokenizer.pruneTokens(
+        FLAGS_dictionary_max_size, FLAGS_dictionary_min_appearence);
+    for (const auto& tcp : tokenizer.getDictionary()) {
+      tokenCountPairs.emplace_back(tcp.first, tcp.second);
+    }
+  } else {
+    int worldRank = 0;
+    int worldSize = 1;
+    if (FLAGS_distributed_enable) {
+      fl::pkg::runtime::initDistributed(
+          FLAGS_distributed_world_rank,
+          FLAGS_distributed_world_size,
+          FLAGS_distributed_max_devices_per_node,
+          FLAGS_distributed_rndv_filepath);
+      worldRank = fl::getWorldRank();
+      worldSize = fl::getWorldSize();
+    }
+
+    fl::pkg::text::TokenCounts counts;
+    for (const auto& file : files) {
+      LOG(INFO) << "Parsing " << file << " (" << worldRank << "/" << worldSize
+                << ")";
+      counts.merge(fl::pkg::text::countTokens(
+          fs::path(FLAGS_data_dir) / file,
+          tokenizer,
+          worldRank,
+          worldSize,
+          FLAGS_n_workers));
+    }
+    if (worldSize > 1) {
+      // the counts of each rank are merged by rank 0 through files
+      const auto partPath = [](int rank) {
+        return FLAGS_dictionary + ".part" + std::to_string(rank);
+      };
+      counts.save(partPath(worldRank));
+      fl::barrier();
+      if (worldRank != 0) {
+        return 0;
+      }
+      for (int rank = 1; rank < worldSize; ++rank) {
+        counts.merge(fl::pkg::text::TokenCounts::load(partPath(rank)));
+      }
+      for (int rank = 0; rank < worldSize; ++rank) {
+        fs::remove(partPath(rank));
+      }
+    }
+
+    LOG(INFO) << " --- Data Loading completed. --- ";
+    LOG(INFO) << "  Loaded " << counts.numTokens << " tokens";
+    LOG(INFO) << "  Loaded " << counts.numSentences << " sentences";
+
+    tokenCountPairs = counts.prune(
+        FLAGS_dictionary_max_size, FLAGS_dictionary_min_appearence);
+  }
 
-  tokenizer.pruneTokens(
-      FLAGS_dictionary_max_size, FLAGS_dictionary_min_appearence);
-  auto tokenCountPairs = tokenizer.getDictionary();
   std::ofstream stream(FLAGS_dictionary);
   if (!stream) {
     throw std::runtime_error("BuildDictionary - invalid dictionary filepath");
@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/app/lm/Inference.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+
+#include "flashlight/fl/autograd/Functions.h"
+#include "flashlight/fl/autograd/InferenceMode.h"
+#include "flashlight/fl/nn/Utils.h"
+#include "flashlight/fl/nn/modules/Loss.h"
+#include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/pkg/runtime/common/Serializer.h"
+#include "flashlight/pkg/runtime/plugin/ModulePlugin.h"
+
+namespace fl {
+namespace app {
+namespace lm {
+
+LmInference::LmInference(
+    std::shared_ptr<fl::Module> network,
+    std::shared_ptr<fl::Module> criterion,
+    const LmInferenceOptions& options /* = {} */)
+    : network_(std::move(network)),
+      criterion_(std::move(criterion)),
+      lm_(dynamic_cast<StatefulLm*>(network_.get())),
+      options_(options),
+      device_(fl::getDevice()) {
+  if (!lm_) {
+    throw std::invalid_argument(
+        "LmInference - the network must implement StatefulLm");
+  }
+  network_->eval();
+  if (criterion_) {
+    criterion_->eval();
+  }
+  pools_ = lm_->createBlockPools(options_.numBlocks, options_.blockSize);
+  // blocks are taken from the back
+  freeBlocks_.resize(options_.numBlocks);
+  for (int64_t i = 0; i < options_.numBlocks; ++i) {
+    freeBlocks_[i] = options_.numBlocks - 1 - i;
+  }
+}
+
+std::unique_ptr<LmInference> LmInference::load(
+    const std::string& archFile,
+    const std::string& checkpointPath,
+    const LmInferenceOptions& options /* = {} */) {
+  // registers the serialized types of the architecture
+  (void)fl::pkg::runtime::ModulePlugin(archFile);
+  std::shared_ptr<fl::Module> network, criterion;
+  std::string version;
+  fl::pkg::runtime::Serializer::load(
+      checkpointPath, version, network, criterion);
+  return std::make_unique<LmInference>(network, criterion, options);
+}
+
+LmInference::SessionId LmInference::createSession() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const SessionId id = nextSession_++;
+  sessions_.emplace(id, Session());
+  return id;
+}
+
+void LmInference::releaseSession(SessionId session) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(session);
+  if (it == sessions_.end() || it->second.busy) {
+    throw std::invalid_argument(
+        "LmInference::releaseSession - unknown or busy session");
+  }
+  freeBlocks_.insert(
+      freeBlocks_.end(), it->second.blocks.begin(), it->second.blocks.end());
+  sessions_.erase(it);
+}
+
+int64_t LmInference::freeBlocks() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return freeBlocks_.size();
+}
+
+bool LmInference::isFull() const {
+  return options_.maxBatchSize > 0 && queue_.size() >= options_.maxBatchSize;
+}
+
+LmInference::Session& LmInference::acquire(SessionId session) {
+  auto it = sessions_.find(session);
+  if (it == sessions_.end() || it->second.busy) {
+    throw std::invalid_argument(
+        "LmInference - unknown session, or session serving another request");
+  }
+  it->second.busy = true;
+  return it->second;
+}
+
+void LmInference::release(Session& session) {
+  session.busy = false;
+  condition_.notify_all();
+}
+
+std::vector<float> LmInference::append(
+    SessionId id,
+    const std::vector<int>& tokens) {
+  if (tokens.empty()) {
+    return {};
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto& session = acquire(id);
+  const int64_t blockSize = options_.blockSize;
+  const int64_t needed =
+      (session.length + int64_t(tokens.size()) + blockSize - 1) / blockSize -
+      session.blocks.size();
+  if (needed > int64_t(freeBlocks_.size())) {
+    release(session);
+    throw std::runtime_error(
+        "LmInference::append - out of key/value blocks, release sessions or "
+        "increase the number of blocks");
+  }
+  for (int64_t i = 0; i < needed; ++i) {
+    session.blocks.push_back(freeBlocks_.back());
+    freeBlocks_.pop_back();
+  }
+
+  Request request;
+  request.session = &session;
+  request.tokens = tokens;
+  queue_.push_back(&request);
+  condition_.notify_all();
+  const auto deadline = std::chrono::steady_clock::now() +
+      std::chrono::microseconds(options_.maxWaitUs);
+  while (!request.done) {
+    if (request.taken || forwarding_) {
+      condition_.wait(lock, [&request, this]() {
+        return request.done || (!request.taken && !forwarding_);
+      });
+      continue;
+    }
+    if (!isFull() && std::chrono::steady_clock::now() < deadline) {
+      condition_.wait_until(lock, deadline, [&request, this]() {
+        return request.taken || forwarding_ || isFull();
+      });
+      continue;
+    }
+    forwardQueue(lock);
+  }
+  release(session);
+  if (request.error) {
+    std::rethrow_exception(request.error);
+  }
+  return std::move(request.logProbs);
+}
+
+std::vector<float> LmInference::nextLogProbs(
+    SessionId id,
+    const std::vector<int>& candidates) {
+  Tensor next;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto& session = acquire(id);
+    next = session.nextLogProbs;
+    release(session);
+  }
+  if (next.isEmpty()) {
+    throw std::invalid_argument(
+        "LmInference::nextLogProbs - the session has no tokens");
+  }
+  if (candidates.empty()) {
+    return {};
+  }
+  const int device = fl::getDevice();
+  fl::setDevice(device_);
+  auto result = next(Tensor::fromVector(candidates)).toHostVector<float>();
+  fl::setDevice(device);
+  return result;
+}
+
+std::vector<float> LmInference::score(const std::vector<int>& tokens) {
+  const auto session = createSession();
+  std::vector<float> result;
+  try {
+    result = append(session, tokens);
+  } catch (...) {
+    releaseSession(session);
+    throw;
+  }
+  releaseSession(session);
+  return result;
+}
+
+Tensor LmInference::logProbs(const Variable& output) const {
+  if (auto adsm = std::dynamic_pointer_cast<fl::AdaptiveSoftMaxLoss>(
+          criterion_)) {
+    return adsm->getActivation()->forward(output).tensor().astype(
+        fl::dtype::f32);
+  }
+  return fl::logSoftmax(output, 0).tensor().astype(fl::dtype::f32);
+}
+
+void LmInference::forwardQueue(std::unique_lock<std::mutex>& lock) {
+  std::vector<Request*> batch;
+  while (!queue_.empty() &&
+         (options_.maxBatchSize <= 0 || batch.size() < options_.maxBatchSize)) {
+    auto* request = queue_.front();
+    queue_.pop_front();
+    request->taken = true;
+    batch.push_back(request);
+  }
+  forwarding_ = true;
+  lock.unlock();
+
+  // the sessions of the batch are busy, and only read by this call
+  std::vector<std::vector<float>> logProbs(batch.size());
+  std::vector<Tensor> nextLogProbs(batch.size());
+  std::exception_ptr error;
+  try {
+    const int device = fl::getDevice();
+    fl::setDevice(device_);
+    fl::InferenceModeGuard guard;
+
+    // the tokens are padded to the longest request, after their own
+    const int64_t batchSize = batch.size();
+    int64_t nSteps = 0;
+    for (const auto* request : batch) {
+      nSteps = std::max<int64_t>(nSteps, request->tokens.size());
+    }
+    std::vector<int> inputs(nSteps * batchSize, 0);
+    std::vector<TransformerPagedSequence> sequences(batchSize);
+    for (int64_t b = 0; b < batchSize; ++b) {
+      const auto& request = *batch[b];
+      std::copy(
+          request.tokens.begin(),
+          request.tokens.end(),
+          inputs.begin() + b * nSteps);
+      sequences[b].blocks = request.session->blocks;
+      sequences[b].length = request.session->length;
+      sequences[b].steps = request.tokens.size();
+    }
+    auto output = lm_->forwardPaged(
+        fl::input(Tensor::fromVector({nSteps, batchSize}, inputs)),
+        pools_,
+        sequences);
+    auto scores = this->logProbs(output);
+    const int64_t nClasses = scores.dim(0);
+
+    // a token is scored by the output of the previous one, the first by
+    // that of the previous request of its session
+    std::vector<int64_t> scoreIdx, firstIdx;
+    std::vector<Tensor> previous;
+    for (int64_t b = 0; b < batchSize; ++b) {
+      const auto& request = *batch[b];
+      if (request.session->length > 0) {
+        firstIdx.push_back(
+            request.tokens[0] + nClasses * int64_t(previous.size()));
+        previous.push_back(request.session->nextLogProbs);
+      }
+      for (int64_t i = 1; i < request.tokens.size(); ++i) {
+        scoreIdx.push_back(
+            request.tokens[i] + nClasses * (i - 1 + nSteps * b));
+      }
+      nextLogProbs[b] =
+          scores(fl::span, int64_t(request.tokens.size()) - 1, b).copy();
+    }
+    std::vector<float> tokenScores, firstScores;
+    if (!scoreIdx.empty()) {
+      tokenScores =
+          scores.flatten()(Tensor::fromVector(scoreIdx)).toHostVector<float>();
+    }
+    if (!previous.empty()) {
+      firstScores = fl::concatenate(previous, 0)(Tensor::fromVector(firstIdx))
+                        .toHostVector<float>();
+    }
+    size_t token = 0, first = 0;
+    for (int64_t b = 0; b < batchSize; ++b) {
+      const auto& request = *batch[b];
+      if (request.session->length > 0) {
+        logProbs[b].push_back(firstScores[first++]);
+      }
+      const size_t n = request.tokens.size() - 1;
+      logProbs[b].insert(
+          logProbs[b].end(),
+          tokenScores.begin() + token,
+          tokenScores.begin() + token + n);
+      token += n;
+    }
+    fl::setDevice(device);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  lock.lock();
+  for (size_t b = 0; b < batch.size(); ++b) {
+    auto* request = batch[b];
+    if (!error) {
+      request->session->length += request->tokens.size();
+      request->session->nextLogProbs = std::move(nextLogProbs[b]);
+      request->logProbs = std::move(logProbs[b]);
+    }
+    request->error = error;
+    request->done = true;
+  }
+  forwarding_ = false;
+  condition_.notify_all();
+}
+
+} // namespace lm
+} // namespace app
+} // namespace fl
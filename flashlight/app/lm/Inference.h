@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flashlight/app/lm/StatefulLm.h"
+#include "flashlight/fl/nn/modules/Module.h"
+
+namespace fl {
+namespace app {
+namespace lm {
+
+struct LmInferenceOptions {
+  // the number of key/value blocks of each layer, shared by the sessions
+  int64_t numBlocks{4096};
+  // the number of tokens of a block
+  int64_t blockSize{16};
+  // the largest number of requests of a batched forward, 0 for no limit
+  int maxBatchSize{0};
+  // the time a request waits for others to be batched with, in microseconds
+  int maxWaitUs{0};
+};
+
+/**
+ * Serves a trained transformer LM, e.g. for the online rescoring of the
+ * hypotheses of a decoder, with the log-probabilities of tokens given their
+ * prefixes.
+ *
+ * Requests are made on sessions, each of which is a sequence of tokens whose
+ * keys and values are cached, such that a request only forwards its own
+ * tokens. The caches of the sessions are paged in fixed-size blocks of pools
+ * shared by all of them (see `fl::TransformerBlockPool`), so that the memory
+ * of released sessions is reused by others whatever their lengths.
+ *
+ * The requests of concurrent calls, e.g. of several decoder threads, are
+ * forwarded in a batch, as in `buildGetConvLmScoreFunction`: a request waits
+ * up to `maxWaitUs` for others, or until the batch holds `maxBatchSize`
+ * requests. A session serves one request at a time.
+ *
+ * The network is an architecture plugin implementing `StatefulLm`, whose
+ * output is normalized with the adaptive softmax of the criterion, if any,
+ * or with a log-softmax. It runs on the device which is current when the
+ * `LmInference` is constructed.
+ */
+class LmInference {
+ public:
+  using SessionId = int64_t;
+
+  LmInference(
+      std::shared_ptr<fl::Module> network,
+      std::shared_ptr<fl::Module> criterion,
+      const LmInferenceOptions& options = {});
+
+  /**
+   * Loads a checkpoint of the `Trainer` once, with the architecture plugin it
+   * was trained with.
+   */
+  static std::unique_ptr<LmInference> load(
+      const std::string& archFile,
+      const std::string& checkpointPath,
+      const LmInferenceOptions& options = {});
+
+  /** @return a new session, of no tokens */
+  SessionId createSession();
+
+  /** Releases the blocks of a session, which can't be used anymore. */
+  void releaseSession(SessionId session);
+
+  /**
+   * Appends tokens to a session, e.g. a prefix to score or its continuation.
+   *
+   * @return the log-probability of each token given the previous tokens of
+   * the session, except for the first token of the session, which has no
+   * previous tokens, e.g. <eos>, and isn't scored.
+   */
+  std::vector<float> append(SessionId session, const std::vector<int>& tokens);
+
+  /**
+   * @return the log-probabilities of candidate tokens following the tokens
+   * of a session, which are cached without forwarding the network, e.g. to
+   * rescore the extensions of a hypothesis. The session must have tokens.
+   */
+  std::vector<float> nextLogProbs(
+      SessionId session,
+      const std::vector<int>& candidates);
+
+  /**
+   * @return the log-probabilities of each token of a sequence given the
+   * previous ones, except for the first, in a session of its own.
+   */
+  std::vector<float> score(const std::vector<int>& tokens);
+
+  /** @return the number of key/value blocks which aren't used by sessions */
+  int64_t freeBlocks() const;
+
+ private:
+  struct Session {
+    std::vector<int64_t> blocks;
+    int64_t length{0};
+    // the log-probabilities of the token following the session
+    Tensor nextLogProbs;
+    bool busy{false};
+  };
+
+  // the tokens of a call to `append`, forwarded in a batch
+  struct Request {
+    Session* session;
+    std::vector<int> tokens;
+    std::vector<float> logProbs;
+    std::exception_ptr error;
+    bool taken{false};
+    bool done{false};
+  };
+
+  std::shared_ptr<fl::Module> network_;
+  std::shared_ptr<fl::Module> criterion_;
+  StatefulLm* lm_;
+  LmInferenceOptions options_;
+  int device_;
+  std::vector<TransformerBlockPool> pools_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::unordered_map<SessionId, Session> sessions_;
+  SessionId nextSession_{0};
+  std::vector<int64_t> freeBlocks_;
+  std::deque<Request*> queue_;
+  bool forwarding_{false};
+
+  bool isFull() const;
+  // marks a session busy, with the mutex locked
+  Session& acquire(SessionId session);
+  void release(Session& session);
+  void forwardQueue(std::unique_lock<std::mutex>& lock);
+  Tensor logProbs(const Variable& output) const;
+};
+
+} // namespace lm
+} // namespace app
+} // namespace fl
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/contrib/modules/Transformer.h"
+
+namespace fl {
+namespace app {
+namespace lm {
+
+/**
+ * The state of a `StatefulLm` after some tokens of its input streams, e.g. the
+ * keys and values of the attention of a transformer, or the hidden state of a
+ * recurrent or convolutional model.
+ */
+struct StatefulLmState {
+  virtual ~StatefulLmState() = default;
+};
+
+using StatefulLmStatePtr = std::shared_ptr<StatefulLmState>;
+
+/**
+ * An interface for the language models of architecture plugins which forward
+ * long streams of tokens window by window, carrying the context of the
+ * previous windows rather than recomputing it, e.g. for the strided
+ * evaluation of the `Trainer` (see `--data_valid_stride`). A plugin implements
+ * it along with `fl::Module`.
+ */
+class StatefulLm {
+ public:
+  virtual ~StatefulLm() = default;
+
+  /**
+   * Forwards the next tokens of the streams in eval mode.
+   *
+   * @param input the next tokens, of size T x B
+   * @param state the state of the previous tokens, null for the first ones,
+   * which is consumed
+   * @param context the maximum number of previous tokens the returned state
+   * keeps, i.e. which the next tokens attend to
+   * @return the output for the tokens, as that of `forward`, and the state
+   * of the streams including them
+   */
+  virtual std::pair<Variable, StatefulLmStatePtr> forwardStateful(
+      const Variable& input,
+      StatefulLmStatePtr state,
+      int64_t context) = 0;
+
+  /**
+   * Creates the pools of key/value blocks of the layers for `forwardPaged`,
+   * one per layer.
+   */
+  virtual std::vector<TransformerBlockPool> createBlockPools(
+      int64_t numBlocks,
+      int64_t blockSize) const = 0;
+
+  /**
+   * Forwards the next tokens of a batch of sequences of different lengths in
+   * eval mode, whose previous tokens are paged in the blocks of the pools,
+   * e.g. of the requests of `LmInference`. See
+   * `fl::Transformer::forwardPaged`.
+   *
+   * @param input the next tokens, of size T x B, padded after the
+   * `sequences[b].steps` ones of each sequence
+   * @param pools the pools of the layers, from `createBlockPools`
+   * @param sequences the blocks and lengths of the B sequences
+   * @return the output for the tokens, as that of `forward`
+   */
+  virtual Variable forwardPaged(
+      const Variable& input,
+      std::vector<TransformerBlockPool>& pools,
+      const std::vector<TransformerPagedSequence>& sequences) = 0;
+};
+
+} // namespace lm
+} // namespace app
+} // namespace fl
@@ -30,6 +30,11 @@ int main(int argc, char** argv) {
   FL_LOG_MASTER(INFO) << "Running evaluation with model: "
                       << FLAGS_exp_init_model_path << ", on dataset: "
                       << fs::path(FLAGS_data_dir) / FLAGS_data_valid;
+  if (FLAGS_data_valid_stride > 0) {
+    const auto context = FLAGS_data_tokens_per_sample - FLAGS_data_valid_stride;
+    FL_LOG_MASTER(INFO) << "Strided evaluation of " << FLAGS_data_valid_stride
+                        << " tokens with a context of " << context << " tokens";
+  }
 
   auto loss = trainer.runEvaluation();
   FL_LOG_MASTER(INFO) << "Valid Loss: " << format("%.2f", loss)
@@ -28,8 +28,10 @@ int main(int argc, char** argv) {
 
   /* Select mode */
   std::string mode;
-  if (fs::exists(
-          fs::path(FLAGS_exp_rundir) / (FLAGS_exp_model_name + ".bin"))) {
+  const auto checkPoint =
+      fs::path(FLAGS_exp_rundir) / (FLAGS_exp_model_name + ".bin");
+  if (fs::exists(checkPoint) ||
+      fl::ShardedCheckpoint::exists(checkPoint.string() + ".shards")) {
     mode = "continue";
   } else if (!FLAGS_exp_init_model_path.empty()) {
     mode = "fork";
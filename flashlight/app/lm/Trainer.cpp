@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <fstream>
 
+#include "flashlight/app/lm/StatefulLm.h"
 #include "flashlight/fl/tensor/Compute.h"
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/TensorBase.h"
@@ -73,6 +74,17 @@ DEFINE_string(
     exp_init_model_path,
     "",
     "Initialization model full path, used as init model to start training.");
+DEFINE_bool(
+    exp_sharded_checkpoint,
+    false,
+    "Save checkpoints as one shard per process, written in the background, "
+    "in a directory of the checkpoint path with a '.shards' suffix. They can "
+    "be loaded with any number of processes.");
+DEFINE_bool(
+    exp_async_checkpoint,
+    false,
+    "Write checkpoints in the background, after serializing them to host "
+    "memory, such that training resumes during the writes.");
 
 /* DATA OPTIONS */
 DEFINE_string(
@@ -82,18 +94,21 @@ DEFINE_string(
 DEFINE_string(
     data_train,
     "",
-    "Comma-separated list of training data files; '--data_dir' will be used to add prefix for the files.");
+    "Comma-separated list of training data files, or a corpus compiled with "
+    "fl_lm_corpus_builder; '--data_dir' will be used to add prefix for the files.");
 DEFINE_string(
     data_valid,
     "",
-    "Comma-separated list of validation/test data files; \
+    "Comma-separated list of validation/test data files, or a corpus \
+    compiled with fl_lm_corpus_builder; \
     '--data_dir' will be used to add prefix for the files.");
 DEFINE_int64(
     data_batch_size,
     1,
     "Batch size of data (per process in distributed training). \
     If '--data_use_dynamic_batching=true' is used can be different \
-    to have '--data_tokens_per_sample' * '--data_batch_size' tokens in the batch.");
+    to have up to '--data_tokens_per_sample' * '--data_batch_size' tokens \
+    in the batch, padding included.");
 DEFINE_int64(
     data_tokens_per_sample,
     1024,
@@ -109,7 +124,17 @@ DEFINE_string(
 DEFINE_bool(
     data_use_dynamic_batching,
     false,
-    "if or not use dynamic batching in case of '--data_sample_break_mode=eos'.");
+    "if or not use dynamic batching in case of '--data_sample_break_mode=eos': \
+    batches of sentences of similar length, by a budget of tokens.");
+DEFINE_int64(
+    data_valid_stride,
+    0,
+    "If positive, evaluate the validation data as '--data_batch_size' \
+    contiguous streams, '--data_valid_stride' new tokens at a time, each with \
+    the context of the previous '--data_tokens_per_sample' - \
+    '--data_valid_stride' tokens of its stream. The context is carried over \
+    if the architecture is a StatefulLm, e.g. the key/value caches of a \
+    transformer, and recomputed otherwise.");
 
 /* DICTIONARY OPTIONS */
 DEFINE_string(
@@ -166,6 +191,12 @@ DEFINE_double(
     0.0,
     "L2 penalty coefficient for the parameters during optimization process.");
 
+DEFINE_int64(
+    train_accumulation_steps,
+    1,
+    "Number of micro-batches whose gradients are accumulated in each update, \
+    and reduced once in distributed training, for an effective batch of \
+    '--train_accumulation_steps' * '--data_batch_size' per process.");
 DEFINE_double(
     train_max_grad_norm,
     0.0,
@@ -293,7 +324,12 @@ void Trainer::runTraining() {
 
   while (batchIdx_ < FLAGS_train_total_updates) {
     // Advance epoch
-    if (batchIdx_ && batchIdx_ % trainDataset_->size() == 0) {
+    // an update reads `train_accumulation_steps` batches
+    const int64_t readBatches = batchIdx_ * FLAGS_train_accumulation_steps;
+    if (batchIdx_ &&
+        readBatches / trainDataset_->size() !=
+            (readBatches - FLAGS_train_accumulation_steps) /
+                trainDataset_->size()) {
       stopTimers();
       ++epoch_;
       trainDataset_->shuffle(FLAGS_train_seed + epoch_);
@@ -337,45 +373,59 @@ void Trainer::trainStep() {
   network_->train();
   criterion_->train();
   setLr();
-  bool skipBatch = false;
 
-  // 1. Sample
-  fl::Variable input, target;
+  // 1. Sample the micro-batches of the update, whose gradients are
+  // accumulated and then reduced once
+  const int64_t accumulationSteps = FLAGS_train_accumulation_steps;
+  std::vector<std::pair<fl::Variable, fl::Variable>> microBatches;
   sampleTimerMeter_.resume();
-  std::tie(input, target) = getInputAndTarget(trainDataset_->get(batchIdx_));
-  Tensor inputSizes =
-      fl::sum(input.tensor() != kPadIdx_, {0}, /* keepDims = */ true);
+  Tensor numTokensArr = fl::fromScalar(0.f);
+  for (int64_t i = 0; i < accumulationSteps; ++i) {
+    microBatches.push_back(getInputAndTarget(
+        trainDataset_->get(batchIdx_ * accumulationSteps + i)));
+    numTokensArr = numTokensArr +
+        fl::countNonzero(microBatches.back().second.tensor() != kPadIdx_)
+            .astype(fl::dtype::f32);
+  }
+  if (FLAGS_distributed_enable) {
+    fl::allReduce(numTokensArr);
+  }
   sampleTimerMeter_.stopAndIncUnit();
 
   while (true) {
-    // 2. Forward
-    fwdTimeMeter_.resume();
-    auto output = network_->forward({input, fl::noGrad(inputSizes)}).front();
-    fl::sync();
-    critFwdTimeMeter_.resume();
-    auto loss = criterion_->forward({output, target}).front();
-    fl::sync();
-    fwdTimeMeter_.stopAndIncUnit();
-    critFwdTimeMeter_.stopAndIncUnit();
-
-    // 3. Backward
-    bwdTimeMeter_.resume();
     optimizer_->zeroGrad();
-    float numTokens =
-        fl::countNonzero(target.tensor() != kPadIdx_).asScalar<float>();
-    Tensor numTokensArr = fl::fromScalar(numTokens);
-    if (FLAGS_distributed_enable) {
-      fl::allReduce(numTokensArr);
-    }
-    auto scaledLoss = loss / fl::Variable(numTokensArr, false);
-    if (dynamicScaler) {
-      scaledLoss = dynamicScaler->scale(scaledLoss);
+    std::vector<fl::Variable> losses;
+    for (const auto& [input, target] : microBatches) {
+      Tensor inputSizes =
+          fl::sum(input.tensor() != kPadIdx_, {0}, /* keepDims = */ true);
+
+      // 2. Forward
+      fwdTimeMeter_.resume();
+      auto output = network_->forward({input, fl::noGrad(inputSizes)}).front();
+      fl::sync();
+      critFwdTimeMeter_.resume();
+      auto loss = criterion_->forward({output, target}).front();
+      fl::sync();
+      fwdTimeMeter_.stopAndIncUnit();
+      critFwdTimeMeter_.stopAndIncUnit();
+
+      // 3. Backward, which accumulates the gradients of the micro-batches
+      bwdTimeMeter_.resume();
+      auto scaledLoss = loss / fl::Variable(numTokensArr, false);
+      if (dynamicScaler) {
+        scaledLoss = dynamicScaler->scale(scaledLoss);
+      }
+      scaledLoss.backward();
+      fl::sync();
+      bwdTimeMeter_.stopAndIncUnit();
+      losses.push_back(loss);
     }
-    scaledLoss.backward();
+    bwdTimeMeter_.resume();
     reduceGrads();
     fl::sync();
-    bwdTimeMeter_.stopAndIncUnit();
+    bwdTimeMeter_.stop();
 
+    // the whole update is retried with the adjusted scale
     if (dynamicScaler) {
       if (!dynamicScaler->unscale(parameters_)) {
         continue;
@@ -383,12 +433,17 @@ void Trainer::trainStep() {
       dynamicScaler->update();
     }
 
-    if (numTokens > 0) {
-      auto weight =
-          numTokens / (FLAGS_data_tokens_per_sample * FLAGS_data_batch_size);
-      trainLossMeter_.add(
-          fl::mean(loss.tensor()).scalar<float>() / numTokens, weight);
-      tokenCountMeter_.add(numTokens);
+    for (int64_t i = 0; i < accumulationSteps; ++i) {
+      const auto& target = microBatches[i].second;
+      float numTokens =
+          fl::countNonzero(target.tensor() != kPadIdx_).asScalar<float>();
+      if (numTokens > 0) {
+        auto weight =
+            numTokens / (FLAGS_data_tokens_per_sample * FLAGS_data_batch_size);
+        trainLossMeter_.add(
+            fl::mean(losses[i].tensor()).scalar<float>() / numTokens, weight);
+        tokenCountMeter_.add(numTokens);
+      }
     }
     break;
   }
@@ -404,22 +459,87 @@ void Trainer::trainStep() {
 void Trainer::evalStep() {
   network_->eval();
   criterion_->eval();
+  if (FLAGS_data_valid_stride > 0) {
+    evalStridedStep();
+    return;
+  }
 
   for (const auto& sample : *validDataset_) {
     fl::Variable input, target;
     std::tie(input, target) = getInputAndTarget(sample);
     Tensor inputSizes = fl::sum(input.tensor() != kPadIdx_, {0});
     auto output = network_->forward({input, fl::noGrad(inputSizes)}).front();
-    auto loss = criterion_->forward({output, target}).front();
-    auto numTokens =
-        fl::countNonzero(target.tensor() != kPadIdx_).scalar<unsigned>();
-    if (numTokens > 0) {
-      auto weight = numTokens /
-          static_cast<double>(
-                        FLAGS_data_tokens_per_sample * FLAGS_data_batch_size);
-      validLossMeter_.add(
-          fl::mean(loss.tensor()).asScalar<double>() / numTokens, weight);
+    addValidLoss(output, target, FLAGS_data_tokens_per_sample);
+  }
+}
+
+void Trainer::evalStridedStep() {
+  // each batch continues the streams of the previous one, whose last
+  // `context` tokens are the context of its tokens
+  const int64_t context =
+      FLAGS_data_tokens_per_sample - FLAGS_data_valid_stride;
+  auto* statefulLm = dynamic_cast<StatefulLm*>(network_.get());
+  StatefulLmStatePtr state;
+  // the context of a model which isn't stateful, which is recomputed
+  Tensor history;
+  Tensor lastTokens;
+
+  for (const auto& sample : *validDataset_) {
+    const auto& tokens = sample[0];
+    const auto T = tokens.dim(0);
+    // the last token of the previous batch predicts the first one
+    Tensor inputTokens, targetTokens;
+    if (!lastTokens.isEmpty()) {
+      inputTokens = T > 1
+          ? fl::concatenate({lastTokens, tokens(fl::range(0, T - 1))})
+          : lastTokens;
+      targetTokens = tokens;
+    } else if (T > 1) {
+      inputTokens = tokens(fl::range(0, T - 1));
+      targetTokens = tokens(fl::range(1, T));
+    }
+    lastTokens = tokens(fl::range(T - 1, T));
+    if (inputTokens.isEmpty()) {
+      continue;
+    }
+
+    fl::Variable output;
+    if (statefulLm) {
+      std::tie(output, state) = statefulLm->forwardStateful(
+          fl::Variable(inputTokens, false), std::move(state), context);
+    } else {
+      auto window = history.isEmpty()
+          ? inputTokens
+          : fl::concatenate({history, inputTokens});
+      const auto length = window.dim(0);
+      Tensor inputSizes = fl::sum(window != kPadIdx_, {0});
+      output = network_
+                   ->forward(
+                       {fl::Variable(window, false), fl::noGrad(inputSizes)})
+                   .front();
+      output = output(fl::span, fl::range(length - inputTokens.dim(0), length));
+      if (context > 0) {
+        history = window(
+            fl::range(std::max<int64_t>(length - context, 0), length));
+      }
     }
+    addValidLoss(
+        output, fl::Variable(targetTokens, false), FLAGS_data_valid_stride);
+  }
+}
+
+void Trainer::addValidLoss(
+    const fl::Variable& output,
+    const fl::Variable& target,
+    int64_t tokensPerSample) {
+  auto loss = criterion_->forward({output, target}).front();
+  auto numTokens =
+      fl::countNonzero(target.tensor() != kPadIdx_).scalar<unsigned>();
+  if (numTokens > 0) {
+    auto weight = numTokens /
+        static_cast<double>(tokensPerSample * FLAGS_data_batch_size);
+    validLossMeter_.add(
+        fl::mean(loss.tensor()).asScalar<double>() / numTokens, weight);
   }
 }
 
@@ -453,22 +573,40 @@ void Trainer::initTrain() {
 void Trainer::initContinue() {
   fs::path checkPoint =
       fs::path(FLAGS_exp_rundir) / (FLAGS_exp_model_name + ".bin");
-  if (!fs::exists(checkPoint)) {
+  const auto shardedCheckPoint = shardedCheckpointPath(checkPoint);
+  const bool sharded = fl::ShardedCheckpoint::exists(shardedCheckPoint) &&
+      (FLAGS_exp_sharded_checkpoint || !fs::exists(checkPoint));
+  if (!sharded && !fs::exists(checkPoint)) {
     throw std::invalid_argument(
         "Checkpoint doesn't exist to continue training: " +
         checkPoint.string());
   }
-  FL_LOG_MASTER(INFO) << "Continue training from file: " << checkPoint;
-  fl::pkg::runtime::Serializer::load(
-      checkPoint,
-      version_,
-      network_,
-      criterion_,
-      optimizer_,
-      epoch_,
-      batchIdx_,
-      gflagsStr_,
-      dynamicScaler);
+  if (sharded) {
+    FL_LOG_MASTER(INFO) << "Continue training from sharded checkpoint: "
+                        << shardedCheckPoint;
+    fl::ShardedCheckpoint::load(
+        shardedCheckPoint,
+        version_,
+        network_,
+        criterion_,
+        optimizer_,
+        epoch_,
+        batchIdx_,
+        gflagsStr_,
+        dynamicScaler);
+  } else {
+    FL_LOG_MASTER(INFO) << "Continue training from file: " << checkPoint;
+    fl::pkg::runtime::Serializer::load(
+        checkPoint,
+        version_,
+        network_,
+        criterion_,
+        optimizer_,
+        epoch_,
+        batchIdx_,
+        gflagsStr_,
+        dynamicScaler);
+  }
 
   // overwrite flags using the ones from command line
   gflags::ReadFlagsFromString(gflagsStr_, gflags::GetArgv0(), true);
@@ -554,38 +692,77 @@ void Trainer::createDictionary() {
 }
 
 void Trainer::createTrainDatasets() {
-  fl::lib::text::Tokenizer tokenizer;
-  fl::lib::text::PartialFileReader partialFileReader(
-      fl::getWorldRank(), fl::getWorldSize());
-  trainDataset_ = std::make_shared<TextDataset>(
-      FLAGS_data_dir,
-      FLAGS_data_train,
-      partialFileReader,
-      tokenizer,
-      dictionary_,
-      FLAGS_data_tokens_per_sample,
-      FLAGS_data_batch_size,
-      FLAGS_data_sample_break_mode,
-      true);
+  const fs::path corpusPath = fs::path(FLAGS_data_dir) / FLAGS_data_train;
+  if (TokenCorpus::isTokenCorpus(corpusPath)) {
+    trainDataset_ = std::make_shared<TextDataset>(
+        corpusPath,
+        fl::getWorldRank(),
+        fl::getWorldSize(),
+        dictionary_,
+        FLAGS_data_tokens_per_sample,
+        FLAGS_data_batch_size,
+        FLAGS_data_sample_break_mode,
+        true);
+  } else {
+    fl::lib::text::Tokenizer tokenizer;
+    fl::lib::text::PartialFileReader partialFileReader(
+        fl::getWorldRank(), fl::getWorldSize());
+    trainDataset_ = std::make_shared<TextDataset>(
+        FLAGS_data_dir,
+        FLAGS_data_train,
+        partialFileReader,
+        tokenizer,
+        dictionary_,
+        FLAGS_data_tokens_per_sample,
+        FLAGS_data_batch_size,
+        FLAGS_data_sample_break_mode,
+        true);
+  }
+  if (FLAGS_distributed_enable && fl::getWorldSize() > 1) {
+    // the ranks form different numbers of batches of their data, e.g. with
+    // dynamic batching, and should run an epoch in the same number of steps
+    const int numBatches = trainDataset_->size();
+    auto allNumBatches =
+        fl::allGather(fl::full({1}, numBatches, fl::dtype::s32));
+    trainDataset_->balanceBatches(fl::amax(allNumBatches).asScalar<int>());
+  }
   FL_LOG_MASTER(INFO) << "train dataset: " << trainDataset_->size()
                       << " samples";
 }
 
 void Trainer::createValidDatasets() {
-  fl::lib::text::Tokenizer tokenizer;
-  fl::lib::text::PartialFileReader partialFileReader(
-      fl::getWorldRank(), fl::getWorldSize());
-
-  validDataset_ = std::make_shared<TextDataset>(
-      FLAGS_data_dir,
-      FLAGS_data_valid,
-      partialFileReader,
-      tokenizer,
-      dictionary_,
-      FLAGS_data_tokens_per_sample,
-      FLAGS_data_batch_size,
-      "eos",
-      FLAGS_data_use_dynamic_batching);
+  const fs::path corpusPath = fs::path(FLAGS_data_dir) / FLAGS_data_valid;
+  // strided evaluation reads batches of `data_valid_stride` tokens of streams
+  const bool strided = FLAGS_data_valid_stride > 0;
+  const int64_t tokensPerSample =
+      strided ? FLAGS_data_valid_stride : FLAGS_data_tokens_per_sample;
+  const std::string sampleBreakMode = strided ? "stream" : "eos";
+  const bool useDynamicBatching = !strided && FLAGS_data_use_dynamic_batching;
+  if (TokenCorpus::isTokenCorpus(corpusPath)) {
+    validDataset_ = std::make_shared<TextDataset>(
+        corpusPath,
+        fl::getWorldRank(),
+        fl::getWorldSize(),
+        dictionary_,
+        tokensPerSample,
+        FLAGS_data_batch_size,
+        sampleBreakMode,
+        useDynamicBatching);
+  } else {
+    fl::lib::text::Tokenizer tokenizer;
+    fl::lib::text::PartialFileReader partialFileReader(
+        fl::getWorldRank(), fl::getWorldSize());
+    validDataset_ = std::make_shared<TextDataset>(
+        FLAGS_data_dir,
+        FLAGS_data_valid,
+        partialFileReader,
+        tokenizer,
+        dictionary_,
+        tokensPerSample,
+        FLAGS_data_batch_size,
+        sampleBreakMode,
+        useDynamicBatching);
+  }
   FL_LOG_MASTER(INFO) << "valid dataset: " << validDataset_->size()
                       << " samples";
 }
@@ -793,6 +970,19 @@ void Trainer::checkArgs() const {
     throw std::invalid_argument(
         "'--dictionary_max_size' should be positive or -1");
   }
+  if (FLAGS_train_accumulation_steps < 1) {
+    throw std::invalid_argument(
+        "'--train_accumulation_steps' should be positive");
+  }
+  if (FLAGS_data_valid_stride < 0 ||
+      FLAGS_data_valid_stride > FLAGS_data_tokens_per_sample) {
+    throw std::invalid_argument(
+        "'--data_valid_stride' should be in [0, '--data_tokens_per_sample']");
+  }
+  if (FLAGS_data_valid_stride > 0 && FLAGS_train_task != "autoreg") {
+    throw std::invalid_argument(
+        "'--data_valid_stride' is only supported with '--train_task=autoreg'");
+  }
 }
 
 /* ============= Meter helpers ============= */
@@ -835,12 +1025,52 @@ void Trainer::stopTimers() {
 /* ============= Logging helpers ============= */
 void Trainer::saveCheckpoint(const fs::path& path, const std::string& suffix)
     const {
+  if (FLAGS_exp_sharded_checkpoint) {
+    // all processes write their shard, in the background
+    FL_LOG_MASTER(INFO) << "saving sharded model checkpoint (epoch=" << epoch_
+                        << " batch=" << batchIdx_
+                        << ") to: " << shardedCheckpointPath(path);
+    auto save = [this](const fs::path& shardedPath) {
+      shardedCheckpoint_.save(
+          shardedPath,
+          std::string(FL_APP_LM_VERSION),
+          network_,
+          criterion_,
+          optimizer_,
+          epoch_,
+          batchIdx_,
+          gflagsStr_,
+          dynamicScaler);
+    };
+    save(shardedCheckpointPath(path));
+    if (!suffix.empty()) {
+      save(shardedCheckpointPath(path / suffix));
+    }
+    return;
+  }
   if (!isMaster()) {
     return;
   }
 
   FL_LOG_MASTER(INFO) << "saving model checkpoint (epoch=" << epoch_
                       << " batch=" << batchIdx_ << ") to: " << path;
+  if (FLAGS_exp_async_checkpoint) {
+    std::vector<fs::path> paths = {path};
+    if (!suffix.empty()) {
+      paths.push_back(path / suffix);
+    }
+    asyncSerializer_.save(
+        paths,
+        FL_APP_LM_VERSION,
+        network_,
+        criterion_,
+        optimizer_,
+        epoch_,
+        batchIdx_,
+        gflagsStr_,
+        dynamicScaler);
+    return;
+  }
   Serializer::save(
       path,
       FL_APP_LM_VERSION,
@@ -866,6 +1096,10 @@ void Trainer::saveCheckpoint(const fs::path& path, const std::string& suffix)
   }
 }
 
+fs::path Trainer::shardedCheckpointPath(const fs::path& path) {
+  return fs::path(path.string() + ".shards");
+}
+
 void Trainer::logMemoryManagerStatus() const {
   if (isMaster()) {
     fl::detail::getMemMgrInfo("Memory Manager Stats", /* device id = */ 0);
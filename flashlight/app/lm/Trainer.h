@@ -51,6 +51,8 @@ DECLARE_string(distributed_rndv_filepath);
 DECLARE_string(exp_rundir);
 DECLARE_string(exp_model_name);
 DECLARE_string(exp_init_model_path);
+DECLARE_bool(exp_sharded_checkpoint);
+DECLARE_bool(exp_async_checkpoint);
 
 /* DATA OPTIONS */
 DECLARE_string(data_dir);
@@ -60,6 +62,7 @@ DECLARE_int64(data_batch_size);
 DECLARE_int64(data_tokens_per_sample);
 DECLARE_string(data_sample_break_mode);
 DECLARE_bool(data_use_dynamic_batching);
+DECLARE_int64(data_valid_stride);
 
 /* DICTIONARY OPTIONS */
 DECLARE_string(dictionary);
@@ -77,6 +80,7 @@ DECLARE_double(train_lr);
 DECLARE_string(train_lr_schedule);
 DECLARE_double(train_momentum);
 DECLARE_double(train_weight_decay);
+DECLARE_int64(train_accumulation_steps);
 DECLARE_double(train_max_grad_norm);
 DECLARE_int64(train_save_updates);
 DECLARE_int64(train_report_updates);
@@ -126,6 +130,9 @@ class Trainer {
   std::shared_ptr<fl::pkg::text::TextDataset> validDataset_;
 
   std::shared_ptr<fl::Reducer> reducer_;
+  // written in the background, so saving waits for the previous checkpoint
+  mutable fl::ShardedCheckpoint shardedCheckpoint_;
+  mutable fl::pkg::runtime::AsyncSerializer asyncSerializer_;
   std::shared_ptr<fl::FirstOrderOptimizer> optimizer_;
   std::vector<fl::Variable> parameters_;
 
@@ -161,6 +168,12 @@ class Trainer {
       const std::vector<Tensor>& sample) const;
   void setLr();
   void reduceGrads();
+  // Evaluates the streams of the validation data with a sliding window
+  void evalStridedStep();
+  void addValidLoss(
+      const fl::Variable& output,
+      const fl::Variable& target,
+      int64_t tokensPerSample);
 
   /* Stateless training helpers */
   void init() const;
@@ -176,6 +189,8 @@ class Trainer {
   /* Logging helpers */
   void saveCheckpoint(const fs::path& path, const std::string& suffix = "")
       const;
+  // The directory of the sharded checkpoint of a checkpoint path
+  static fs::path shardedCheckpointPath(const fs::path& path);
   void logMemoryManagerStatus() const;
   std::string getProgress() const;
 };
@@ -5,10 +5,16 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include "flashlight/app/lm/StatefulLm.h"
 #include "flashlight/fl/contrib/modules/modules.h"
 #include "flashlight/fl/flashlight.h"
 #include "flashlight/fl/nn/modules/modules.h"
 
+// The attention caches of the layers, of at most `context` steps each
+struct TransformerLmState : fl::app::lm::StatefulLmState {
+  std::vector<fl::TransformerCache> caches;
+};
+
 /**
  * This is example of plugin for language model architecture which is expected
  * the input with size Time x Batch x 1 x 1 and used with the adaptive softmax
@@ -16,7 +22,7 @@
  * This architecture is using also adaptive embedding and sinusoidal positional
  * embedding.
  */
-class LmModel : public fl::Container {
+class LmModel : public fl::Container, public fl::app::lm::StatefulLm {
  public:
   LmModel(int64_t nLabel) {
     // Time x B x 1 x 1
@@ -53,6 +59,64 @@ class LmModel : public fl::Container {
     return {out.astype(f32)};
   }
 
+  std::pair<fl::Variable, fl::app::lm::StatefulLmStatePtr> forwardStateful(
+      const fl::Variable& input,
+      fl::app::lm::StatefulLmStatePtr state,
+      int64_t context) override {
+    auto inState = std::static_pointer_cast<TransformerLmState>(state);
+    auto outState = std::make_shared<TransformerLmState>();
+    // the new tokens follow the cached ones, and dropout is skipped in eval
+    const int64_t position = inState ? inState->caches.front().length : 0;
+    auto out = frontend_->module(0)->forward({input}).front();
+    out = std::dynamic_pointer_cast<fl::SinusoidalPositionEmbedding>(
+              frontend_->module(1))
+              ->forward({out}, position)
+              .front();
+    out = out.astype(f16);
+    for (int trIdx = 0; trIdx < transformers_.size(); trIdx++) {
+      fl::TransformerCache cache;
+      if (inState) {
+        cache = std::move(inState->caches[trIdx]);
+      }
+      std::tie(out, cache) = transformers_[trIdx]->forwardIncremental(
+          out, std::move(cache), context + input.dim(0));
+      cache.keepLast(context);
+      outState->caches.push_back(std::move(cache));
+    }
+    return {out.astype(f32), outState};
+  }
+
+  std::vector<fl::TransformerBlockPool> createBlockPools(
+      int64_t numBlocks,
+      int64_t blockSize) const override {
+    std::vector<fl::TransformerBlockPool> pools;
+    for (const auto& layer : transformers_) {
+      pools.push_back(layer->createBlockPool(numBlocks, blockSize, f16));
+    }
+    return pools;
+  }
+
+  fl::Variable forwardPaged(
+      const fl::Variable& input,
+      std::vector<fl::TransformerBlockPool>& pools,
+      const std::vector<fl::TransformerPagedSequence>& sequences) override {
+    // the new tokens of each sequence follow its paged ones
+    std::vector<int64_t> positions;
+    for (const auto& seq : sequences) {
+      positions.push_back(seq.length);
+    }
+    auto out = frontend_->module(0)->forward({input}).front();
+    out = std::dynamic_pointer_cast<fl::SinusoidalPositionEmbedding>(
+              frontend_->module(1))
+              ->forward({out}, positions)
+              .front();
+    out = out.astype(f16);
+    for (int trIdx = 0; trIdx < transformers_.size(); trIdx++) {
+      out = transformers_[trIdx]->forwardPaged(out, pools[trIdx], sequences);
+    }
+    return out.astype(f32);
+  }
+
   std::string prettyString() const override {
     std::ostringstream ss;
     ss << "LmModel: ";
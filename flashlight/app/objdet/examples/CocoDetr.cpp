@@ -28,6 +28,7 @@
 #include "flashlight/pkg/vision/dataset/Transforms.h"
 #include "flashlight/pkg/vision/models/Detr.h"
 #include "flashlight/pkg/vision/models/Resnet50Backbone.h"
+#include "flashlight/pkg/vision/nn/FrozenBatchNorm.h"
 #include "flashlight/pkg/vision/nn/Transformer.h"
 
 using namespace fl;
@@ -92,6 +93,10 @@ DEFINE_string(
     "Directory to dump images to run evaluation script on");
 DEFINE_string(eval_command, "", "Command to run  on dumped tensors");
 DEFINE_bool(eval_only, false, "Weather to just run eval");
+DEFINE_bool(
+    model_fold_frozen_bn,
+    true,
+    "Fold the frozen batch norms of the backbone into its convolutions");
 
 /* AMP OPTIONS */
 DEFINE_bool(
@@ -114,6 +119,11 @@ DEFINE_double(
     fl_amp_max_scale_factor,
     65536.,
     "[train] Maximum value for the loss scale factor in mixed precision training");
+DEFINE_string(
+    fl_amp_half_type,
+    "f16",
+    "[train] The half precision type of mixed precision training, f16 or "
+    "bf16. bf16 has the range of f32 and is trained without loss scaling.");
 DEFINE_string(
     fl_optim_mode,
     "",
@@ -280,11 +290,15 @@ int main(int argc, char** argv) {
         ? fl::OptimLevel::DEFAULT
         : fl::OptimMode::toOptimLevel(FLAGS_fl_optim_mode);
     fl::OptimMode::get().setOptimLevel(flOptimLevel);
-
-    dynamicScaler = std::make_shared<fl::pkg::runtime::DynamicScaler>(
-        FLAGS_fl_amp_scale_factor,
-        FLAGS_fl_amp_max_scale_factor,
-        FLAGS_fl_amp_scale_factor_update_interval);
+    fl::OptimMode::get().setHalfPrecisionType(
+        fl::stringToDtype(FLAGS_fl_amp_half_type));
+
+    if (fl::OptimMode::get().getHalfPrecisionType() == fl::dtype::f16) {
+      dynamicScaler = std::make_shared<fl::pkg::runtime::DynamicScaler>(
+          FLAGS_fl_amp_scale_factor,
+          FLAGS_fl_amp_max_scale_factor,
+          FLAGS_fl_amp_scale_factor_update_interval);
+    }
   }
   fl::DynamicBenchmark::setBenchmarkMode(true);
 
@@ -326,6 +340,11 @@ int main(int argc, char** argv) {
     // "/checkpoint/padentomasello/models/detr/model_pytorch_initializaition";
     fl::load(FLAGS_model_pytorch_init, detr);
   }
+  if (FLAGS_model_fold_frozen_bn) {
+    // before the optimizers take the parameters of the model
+    const int numFolded = fl::foldFrozenBatchNorm(*detr);
+    FL_LOG_MASTER(INFO) << "Folded " << numFolded << " frozen batch norms";
+  }
   detr->train();
 
   /////////////////////////
@@ -442,8 +461,8 @@ int main(int argc, char** argv) {
   auto dataType = fl::dtype::f32;
   if (FLAGS_fl_amp_use_mixed_precision && FLAGS_fl_optim_mode.empty()) {
     // In case AMP is activated with DEFAULT mode,
-    // we manually cast input to fp16.
-    dataType = fl::dtype::f16;
+    // we manually cast input to half precision.
+    dataType = fl::OptimMode::get().getHalfPrecisionType();
   }
   for (int epoch = startEpoch; epoch < FLAGS_train_epochs; epoch++) {
     int idx = 0;
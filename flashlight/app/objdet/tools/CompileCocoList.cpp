@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Compiles the list of images and annotations of a `CocoDataset` into a
+ * binary `CocoIndex`, which the dataset maps instead of parsing the list, e.g.
+ * compiled to the train.lst and val.lst of the --data_dir of fl_img_coco_detr.
+ */
+
+#include <string>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "flashlight/pkg/vision/dataset/CocoIndex.h"
+
+namespace {
+
+DEFINE_string(input, "", "List file to compile");
+DEFINE_string(output, "", "Path of the compiled index of the list file");
+
+} // namespace
+
+using namespace fl::pkg::vision;
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  gflags::SetUsageMessage(
+      "Usage: \n " + std::string(argv[0]) +
+      " --input=[list file] --output=[index file]");
+  if (argc <= 1) {
+    LOG(FATAL) << gflags::ProgramUsage();
+  }
+  gflags::ParseCommandLineFlags(&argc, &argv, false);
+  if (FLAGS_input.empty() || FLAGS_output.empty()) {
+    LOG(FATAL) << "--input and --output must specify the list and index files";
+  }
+
+  auto numImages = CocoIndex::compile(FLAGS_input, FLAGS_output);
+  LOG(INFO) << "Compiled " << numImages << " images of " << FLAGS_input
+            << " to " << FLAGS_output;
+  return 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/autograd/ActivationOffload.h"
+
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/runtime/DeviceManager.h"
+#include "flashlight/fl/runtime/Stream.h"
+#include "flashlight/fl/tensor/Compute.h"
+
+namespace fl {
+
+namespace {
+
+// the number of restored tensors whose host copies are kept, to free them
+// without waiting on copies still in flight
+constexpr size_t kMaxRetired = 8;
+
+// copies back to device run on a separate stream when the device has one, to
+// overlap with computations
+const Stream& getCopyStream(const Stream& computeStream) {
+  if (computeStream.type() != StreamType::CUDA) {
+    return computeStream;
+  }
+  thread_local std::shared_ptr<Stream> copyStream;
+  if (!copyStream || &copyStream->device() != &computeStream.device()) {
+    copyStream = DeviceManager::getInstance().getStreamFromPool(
+        DeviceType::CUDA, StreamPriority::Low);
+  }
+  return *copyStream;
+}
+
+} // namespace
+
+ActivationOffloadScope::ActivationOffloadScope(
+    size_t budgetBytes,
+    unsigned prefetchDistance)
+    : prevBudgetBytes_(
+          detail::ActivationOffloader::getInstance().budgetBytes()),
+      prevPrefetchDistance_(
+          detail::ActivationOffloader::getInstance().prefetchDistance()) {
+  detail::ActivationOffloader::getInstance().setBudget(
+      budgetBytes, prefetchDistance);
+}
+
+ActivationOffloadScope::~ActivationOffloadScope() {
+  detail::ActivationOffloader::getInstance().setBudget(
+      prevBudgetBytes_, prevPrefetchDistance_);
+}
+
+namespace detail {
+
+OffloadedTensor::OffloadedTensor(Shape shape, fl::dtype type, size_t bytes)
+    : shape(std::move(shape)),
+      type(type),
+      bytes(bytes),
+      host(fl::allocPinnedHost(bytes)) {}
+
+OffloadedTensor::~OffloadedTensor() {
+  if (offloaded) {
+    offloaded->sync();
+  }
+  if (loaded) {
+    loaded->sync();
+  }
+  fl::freePinnedHost(host);
+}
+
+ActivationOffloader& ActivationOffloader::getInstance() {
+  // never destroyed, since Variables may outlive static destruction
+  static auto* instance = new ActivationOffloader();
+  return *instance;
+}
+
+bool ActivationOffloader::isEnabled() const {
+  return budgetBytes_ > 0;
+}
+
+size_t ActivationOffloader::budgetBytes() const {
+  return budgetBytes_;
+}
+
+unsigned ActivationOffloader::prefetchDistance() const {
+  return prefetchDistance_;
+}
+
+void ActivationOffloader::setBudget(
+    size_t budgetBytes,
+    unsigned prefetchDistance) {
+  budgetBytes_ = budgetBytes;
+  prefetchDistance_ = prefetchDistance;
+}
+
+void ActivationOffloader::save(const Variable& var) {
+  auto& data = *var.sharedData_;
+  // only the outputs of autograd functions are activations
+  if (!data.offloadable || data.offloaded || !var.sharedGrad_->gradFunc ||
+      data.data.isEmpty()) {
+    return;
+  }
+
+  // destroyed after unlocking, since destroying the last reference to some
+  // data releases it
+  std::vector<std::shared_ptr<Variable::SharedData>> offloaded;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (data.saved) {
+    // saved again, hence needed earlier during the backward pass
+    auto& iter = entries_.at(&data);
+    lru_.splice(lru_.end(), lru_, iter);
+    return;
+  }
+  data.saved = true;
+  const size_t bytes = data.data.bytes();
+  lru_.push_back({&data, var.sharedData_, bytes});
+  entries_.emplace(&data, std::prev(lru_.end()));
+  residentBytes_ += bytes;
+
+  while (residentBytes_ > budgetBytes_ && !lru_.empty()) {
+    auto entry = std::move(lru_.front());
+    lru_.pop_front();
+    entries_.erase(entry.key);
+    residentBytes_ -= entry.bytes;
+    // data being destroyed needs no offloading
+    if (auto saved = entry.data.lock()) {
+      saved->saved = false;
+      offload(*saved);
+      offloaded.push_back(std::move(saved));
+    }
+  }
+}
+
+void ActivationOffloader::release(const Variable::SharedData* data) {
+  if (data->offloaded) {
+    --numOffloaded_;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto iter = entries_.find(data);
+  if (iter == entries_.end()) {
+    return;
+  }
+  residentBytes_ -= iter->second->bytes;
+  lru_.erase(iter->second);
+  entries_.erase(iter);
+}
+
+size_t ActivationOffloader::residentBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return residentBytes_;
+}
+
+size_t ActivationOffloader::numOffloaded() const {
+  return numOffloaded_;
+}
+
+void ActivationOffloader::offload(Variable::SharedData& data) {
+  auto& tensor = data.data;
+  auto offloaded = std::make_shared<OffloadedTensor>(
+      tensor.shape(), tensor.type(), tensor.bytes());
+  const auto& stream = tensor.stream();
+  stream.copyAsync(offloaded->host, tensor.device<void>(), offloaded->bytes);
+  tensor.unlock();
+  offloaded->offloaded = stream.recordEvent();
+  // the memory is reused in stream order, i.e., after the copy
+  tensor = Tensor();
+  data.offloaded = std::move(offloaded);
+  ++numOffloaded_;
+}
+
+void ActivationOffloader::prefetchInputs(const Variable& var) {
+  for (const auto& input : var.sharedGrad_->inputs) {
+    const auto& offloaded = input.sharedData_->offloaded;
+    if (offloaded) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!offloaded->loaded) {
+        prefetch(*offloaded);
+      }
+    }
+  }
+}
+
+void ActivationOffloader::prefetch(OffloadedTensor& offloaded) {
+  offloaded.prefetched = Tensor(offloaded.shape, offloaded.type);
+  const auto& computeStream = offloaded.prefetched.stream();
+  const auto& copyStream = getCopyStream(computeStream);
+  copyStream.relativeSync(*offloaded.offloaded);
+  if (&copyStream != &computeStream) {
+    // the new buffer may still be used by earlier computations
+    copyStream.relativeSync(computeStream);
+  }
+  copyStream.copyAsync(
+      offloaded.prefetched.device<void>(), offloaded.host, offloaded.bytes);
+  offloaded.prefetched.unlock();
+  offloaded.loaded = copyStream.recordEvent();
+}
+
+void ActivationOffloader::restore(Variable::SharedData& data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& offloaded = *data.offloaded;
+  if (!offloaded.loaded) {
+    prefetch(offloaded);
+  }
+  data.data = std::move(offloaded.prefetched);
+  data.data.stream().relativeSync(*offloaded.loaded);
+  retired_.push_back(std::move(data.offloaded));
+  --numOffloaded_;
+  if (retired_.size() > kMaxRetired) {
+    retired_.pop_front();
+  }
+}
+
+} // namespace detail
+} // namespace fl
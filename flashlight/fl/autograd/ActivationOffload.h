@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/runtime/Event.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+/**
+ * An RAII scope in which the activations saved by autograd for the backward
+ * pass are kept within a device memory budget. Once the saved activations
+ * exceed `budgetBytes`, the least recently saved ones are copied to pinned
+ * host memory and their device memory is released. `Variable::backward`
+ * prefetches them back asynchronously ahead of their use.
+ *
+ * This trades host-device bandwidth for device memory, e.g. to train on
+ * longer sequences. Offloading is transparent: `Variable::tensor()` brings an
+ * offloaded activation back if it's used before the backward pass. Only the
+ * outputs of autograd functions are offloaded, not parameters or inputs, and
+ * memory is only released if nothing else, e.g. a gradient function, holds
+ * the tensor.
+ *
+ * Example:
+ * \code
+   {
+     fl::ActivationOffloadScope offload(4UL << 30); // 4 GiB
+     auto loss = criterion(model(input), target);
+     loss.backward();
+   }
+ * \endcode
+ */
+class ActivationOffloadScope {
+  const size_t prevBudgetBytes_;
+  const unsigned prevPrefetchDistance_;
+
+ public:
+  /**
+   * @param[in] budgetBytes the device memory saved activations may occupy.
+   * @param[in] prefetchDistance how many nodes of the autograd graph ahead of
+   * the one being differentiated the backward pass prefetches activations.
+   */
+  explicit ActivationOffloadScope(
+      size_t budgetBytes,
+      unsigned prefetchDistance = 2);
+  ~ActivationOffloadScope();
+
+  // no copy/move
+  ActivationOffloadScope(const ActivationOffloadScope&) = delete;
+  ActivationOffloadScope(ActivationOffloadScope&&) = delete;
+  ActivationOffloadScope& operator=(const ActivationOffloadScope&) = delete;
+  ActivationOffloadScope& operator=(ActivationOffloadScope&&) = delete;
+};
+
+namespace detail {
+
+/**
+ * The host copy of an offloaded Variable's tensor, and the device copy it's
+ * being prefetched to, if any.
+ */
+struct OffloadedTensor {
+  Shape shape;
+  fl::dtype type;
+  size_t bytes;
+  void* host{nullptr}; // pinned, see fl::allocPinnedHost
+  std::unique_ptr<Event> offloaded; // completes when `host` holds the data
+  Tensor prefetched;
+  std::unique_ptr<Event> loaded; // completes when `prefetched` holds the data
+
+  OffloadedTensor(Shape shape, fl::dtype type, size_t bytes);
+  // waits for pending copies
+  ~OffloadedTensor();
+};
+
+/**
+ * Tracks the activations saved on device in the order they were last saved,
+ * and offloads them to stay within the budget of the ActivationOffloadScope.
+ */
+class ActivationOffloader {
+ public:
+  static ActivationOffloader& getInstance();
+
+  /**
+   * @return whether activations are currently offloaded when saved.
+   */
+  bool isEnabled() const;
+
+  size_t budgetBytes() const;
+  unsigned prefetchDistance() const;
+  void setBudget(size_t budgetBytes, unsigned prefetchDistance);
+
+  /**
+   * Record that `var` was saved as the input of an autograd function, and
+   * offload the least recently saved activations if they exceed the budget.
+   */
+  void save(const Variable& var);
+
+  /**
+   * Stop tracking the given (destroyed) Variable data.
+   */
+  void release(const Variable::SharedData* data);
+
+  /**
+   * @return the bytes of the saved activations currently on device.
+   */
+  size_t residentBytes() const;
+
+  /**
+   * @return the number of tensors currently offloaded to host memory.
+   */
+  size_t numOffloaded() const;
+
+  /**
+   * Enqueue the copy of the offloaded inputs of `var` back to device, see
+   * `Variable::backward`.
+   */
+  void prefetchInputs(const Variable& var);
+
+  /**
+   * Make the tensor of given offloaded Variable data available on device
+   * again.
+   */
+  void restore(Variable::SharedData& data);
+
+ private:
+  struct Entry {
+    const Variable::SharedData* key;
+    std::weak_ptr<Variable::SharedData> data;
+    size_t bytes;
+  };
+
+  ActivationOffloader() = default;
+
+  // assumes `mutex_` is held
+  void offload(Variable::SharedData& data);
+  void prefetch(OffloadedTensor& offloaded);
+
+  mutable std::mutex mutex_;
+  std::atomic<size_t> budgetBytes_{0}; // 0 disables offloading
+  std::atomic<unsigned> prefetchDistance_{0};
+  std::atomic<size_t> numOffloaded_{0};
+  size_t residentBytes_{0};
+  std::list<Entry> lru_; // least recently saved first
+  std::unordered_map<const Variable::SharedData*, std::list<Entry>::iterator>
+      entries_;
+  // host copies of restored tensors, freed once later ones are restored so
+  // that their copies complete meanwhile
+  std::deque<std::shared_ptr<OffloadedTensor>> retired_;
+};
+
+} // namespace detail
+} // namespace fl
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/autograd/Autocast.h"
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "flashlight/fl/autograd/Variable.h"
+
+namespace fl {
+
+namespace {
+
+// Functions which run in half precision
+const std::unordered_set<std::string> kAutocastHalfFunctions = {
+    "matmul",
+    "matmulTN",
+    "matmulNT",
+    "linear",
+    "conv2d",
+    "rnn"};
+
+// Functions which run in f32
+const std::unordered_set<std::string> kAutocastFullFunctions = {
+    "batchnorm",
+    "layerNorm",
+    "reciprocal",
+    "erf",
+    "exp",
+    "log",
+    "log1p",
+    "pow",
+    "sum",
+    "sumAs",
+    "mean",
+    "var",
+    "norm",
+    "normalize",
+    "softmax",
+    "logSoftmax",
+    "categoricalCrossEntropy",
+    "gelu"};
+
+thread_local bool autocastEnabled = false;
+thread_local fl::dtype autocastType = fl::dtype::f16;
+// the number of enclosing scopes, the cache is cleared when the last exits
+thread_local unsigned autocastDepth = 0;
+
+bool isFloatingPointType(const fl::dtype type) {
+  return type == fl::dtype::f16 || type == fl::dtype::bf16 ||
+      type == fl::dtype::f32 || type == fl::dtype::f64;
+}
+
+// the type an input of a function of the given type is cast to, if any
+std::optional<fl::dtype> getAutocastType(
+    const fl::dtype type,
+    const char* funcname) {
+  if (!isFloatingPointType(type)) {
+    return std::nullopt;
+  }
+  // TODO: tiny, but this lookup incurs an extra alloc from char* to string
+  const std::string name(funcname);
+  if (kAutocastHalfFunctions.count(name) && type != autocastType) {
+    return autocastType;
+  }
+  if (kAutocastFullFunctions.count(name) && isHalfPrecisionType(type)) {
+    return fl::dtype::f32;
+  }
+  return std::nullopt;
+}
+
+} // namespace
+
+namespace detail {
+
+/**
+ * The casts of the parameters within the outermost autocast scope of the
+ * calling thread, by the array of the parameter.
+ */
+class AutocastCache {
+  struct Entry {
+    // keeps the parameter alive, so that its array isn't reused, and its
+    // version, to detect modifications in place
+    Variable param;
+    uint64_t version;
+    Variable cast;
+  };
+
+  static std::unordered_map<const Tensor*, Entry>& cache() {
+    thread_local std::unordered_map<const Tensor*, Entry> cache;
+    return cache;
+  }
+
+ public:
+  static Variable cast(const Variable& in, const fl::dtype type) {
+    const bool isParam = in.isCalcGrad() && in.getInputs().empty();
+    if (!isParam) {
+      return in.astype(type);
+    }
+    auto& entry = cache()[&in.tensor()];
+    if (entry.param.isEmpty() || entry.version != in.version() ||
+        entry.cast.type() != type) {
+      entry = {in, in.version(), in.astype(type)};
+    }
+    return entry.cast;
+  }
+
+  static void clear() {
+    cache().clear();
+  }
+};
+
+} // namespace detail
+
+AutocastGuard::AutocastGuard(bool enabled, fl::dtype type)
+    : prevEnabled_(autocastEnabled), prevType_(autocastType) {
+  if (enabled && !isHalfPrecisionType(type)) {
+    throw std::invalid_argument(
+        "AutocastGuard::AutocastGuard - half precision type must be f16 or "
+        "bf16");
+  }
+  autocastEnabled = enabled;
+  if (enabled) {
+    autocastType = type;
+  }
+  ++autocastDepth;
+}
+
+AutocastGuard::~AutocastGuard() {
+  autocastEnabled = prevEnabled_;
+  autocastType = prevType_;
+  if (--autocastDepth == 0) {
+    detail::AutocastCache::clear();
+  }
+}
+
+bool AutocastGuard::isEnabled() {
+  return autocastEnabled;
+}
+
+fl::dtype AutocastGuard::halfPrecisionType() {
+  return autocastType;
+}
+
+namespace detail {
+
+Variable autocast(const Variable& in, const char* funcname) {
+  const auto type = getAutocastType(in.type(), funcname);
+  if (!type || in.isEmpty()) {
+    return in;
+  }
+  if (isHalfPrecisionType(*type)) {
+    return AutocastCache::cast(in, *type);
+  }
+  return in.astype(*type);
+}
+
+Tensor autocast(const Tensor& in, const char* funcname) {
+  const auto type = getAutocastType(in.type(), funcname);
+  return type && !in.isEmpty() ? in.astype(*type) : in;
+}
+
+bool isAutocastPromotable(const Variable& lhs, const Variable& rhs) {
+  return lhs.type() != rhs.type() && isFloatingPointType(lhs.type()) &&
+      isFloatingPointType(rhs.type());
+}
+
+std::pair<Variable, Variable> autocastPromote(
+    const Variable& lhs,
+    const Variable& rhs) {
+  if (!isAutocastPromotable(lhs, rhs)) {
+    return {lhs, rhs};
+  }
+  auto type = fl::getTypeSize(lhs.type()) >= fl::getTypeSize(rhs.type())
+      ? lhs.type()
+      : rhs.type();
+  if (isHalfPrecisionType(lhs.type()) && isHalfPrecisionType(rhs.type())) {
+    // f16 and bf16, neither of which holds the other
+    type = fl::dtype::f32;
+  }
+  return {
+      lhs.type() == type ? lhs : lhs.astype(type),
+      rhs.type() == type ? rhs : rhs.astype(type)};
+}
+
+} // namespace detail
+
+} // namespace fl
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <utility>
+
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/Types.h"
+
+namespace fl {
+
+class Variable;
+
+/**
+ * An RAII scope of automatic mixed precision, in which autograd functions,
+ * called on the same thread, pick the precision they compute in, rather than
+ * requiring `PrecisionCast` modules and `astype` calls in the model:
+ * - matmul, linear, conv2d and rnn run in half precision (f16 or bf16), i.e.
+ *   their floating point inputs are cast to it;
+ * - softmax, logSoftmax, normalizations, losses, reductions and the
+ *   elementwise ops which lack precision in half (exp, log, pow, ...) run in
+ *   f32, i.e. their half precision inputs are cast to f32;
+ * - +, -, * and / of a half and a full precision operand run in full
+ *   precision, e.g. residual connections around half precision ops;
+ * - other functions run in the type of their inputs.
+ *
+ * Each parameter, i.e. leaf which requires gradients, is cast to half
+ * precision once per scope, however many functions use it, and its gradient
+ * flows back through the cast. The casts are released when the outermost scope
+ * exits, so a scope should span one forward pass, within which the parameters
+ * aren't updated. Gradients of parameters keep their type, so optimizers, and
+ * loss scaling with `fl::pkg::runtime::DynamicScaler` for f16, are unchanged.
+ *
+ * The scope takes precedence over the process-wide `OptimMode`.
+ *
+ * Example:
+ * \code
+   Variable loss;
+   {
+     fl::AutocastGuard autocast;
+     loss = criterion(model(input), target); // loss is f32
+   }
+   loss.backward();
+ * \endcode
+ */
+class AutocastGuard {
+  const bool prevEnabled_;
+  const fl::dtype prevType_;
+
+ public:
+  /**
+   * @param[in] enabled whether autocast is enabled within the scope, e.g.
+   * false to run a part of the model as is within an enclosing scope.
+   * @param[in] type the half precision type, `fl::dtype::f16` or
+   * `fl::dtype::bf16`.
+   */
+  explicit AutocastGuard(
+      bool enabled = true,
+      fl::dtype type = fl::dtype::f16);
+  ~AutocastGuard();
+
+  /**
+   * @return whether autocast is enabled on the calling thread.
+   */
+  static bool isEnabled();
+
+  /**
+   * @return the half precision type of the innermost scope on the calling
+   * thread.
+   */
+  static fl::dtype halfPrecisionType();
+
+  // no copy/move
+  AutocastGuard(const AutocastGuard&) = delete;
+  AutocastGuard(AutocastGuard&&) = delete;
+  AutocastGuard& operator=(const AutocastGuard&) = delete;
+  AutocastGuard& operator=(AutocastGuard&&) = delete;
+};
+
+namespace detail {
+
+/**
+ * Casts an input of the autograd function `funcname` to the type it computes
+ * in under autocast, see `AutocastGuard`. Casts of parameters are cached.
+ */
+Variable autocast(const Variable& in, const char* funcname);
+Tensor autocast(const Tensor& in, const char* funcname);
+
+/**
+ * Whether the operands of a binary op have different floating point types,
+ * which autocast promotes to the wider one.
+ */
+bool isAutocastPromotable(const Variable& lhs, const Variable& rhs);
+
+/**
+ * @return the operands of a binary op, cast to the wider of their types.
+ */
+std::pair<Variable, Variable> autocastPromote(
+    const Variable& lhs,
+    const Variable& rhs);
+
+} // namespace detail
+
+} // namespace fl
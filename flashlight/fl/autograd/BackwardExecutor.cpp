@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/autograd/BackwardExecutor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "flashlight/fl/autograd/ActivationOffload.h"
+#include "flashlight/fl/common/threadpool/ThreadPool.h"
+#include "flashlight/fl/runtime/Device.h"
+#include "flashlight/fl/runtime/Event.h"
+#include "flashlight/fl/runtime/Stream.h"
+
+namespace fl {
+
+namespace {
+
+// the stream of the worker thread of an executor, if any
+thread_local std::shared_ptr<Stream> workerStream;
+
+} // namespace
+
+struct BackwardExecutor::Job {
+  std::vector<Variable> dag;
+  bool retainGraph;
+  // the event marking the forward pass on the stream of the caller
+  std::shared_ptr<Event> start;
+
+  // per node: the distinct positions of its inputs, in increasing order
+  std::vector<std::vector<size_t>> inputs;
+  // per node: the number of its consumers which haven't run yet
+  std::unique_ptr<std::atomic<size_t>[]> pendingConsumers;
+  // per node: held by the consumers adding to its gradient
+  std::unique_ptr<std::mutex[]> gradMutexes;
+  // per node: marks the consumers which added to its gradient on their
+  // streams, guarded by its mutex
+  std::vector<std::vector<std::shared_ptr<Event>>> gradEvents;
+
+  std::mutex mutex;
+  std::condition_variable finished;
+  // the nodes scheduled which haven't finished running
+  size_t inFlight{0};
+  std::exception_ptr error;
+  std::atomic<bool> failed{false};
+};
+
+BackwardExecutor::BackwardExecutor(
+    size_t numThreads,
+    std::vector<std::shared_ptr<Stream>> streams)
+    : numThreads_(numThreads), streams_(std::move(streams)) {
+  if (numThreads == 0) {
+    throw std::invalid_argument(
+        "[BackwardExecutor::BackwardExecutor] numThreads must be positive");
+  }
+  for (const auto& stream : streams_) {
+    if (!stream) {
+      throw std::invalid_argument(
+          "[BackwardExecutor::BackwardExecutor] streams can't be null");
+    }
+    // threads select their stream concurrently, with the device only
+    // reading its streams
+    stream->device().addStream(stream);
+  }
+  pool_ = std::make_unique<ThreadPool>(numThreads, [this](size_t id) {
+    if (!streams_.empty()) {
+      workerStream = streams_[id % streams_.size()];
+      workerStream->device().setCurrentStream(workerStream);
+    }
+  });
+}
+
+BackwardExecutor::~BackwardExecutor() = default;
+
+size_t BackwardExecutor::numThreads() const {
+  return numThreads_;
+}
+
+void BackwardExecutor::backward(
+    const Variable& var,
+    const Variable& grad,
+    bool retainGraph) {
+  Variable root = var;
+  root.addGrad(grad);
+
+  Job job;
+  job.dag = root.build();
+  job.retainGraph = retainGraph;
+  const size_t numNodes = job.dag.size();
+  const Stream& callerStream = root.tensor().stream();
+  if (!streams_.empty()) {
+    job.start = callerStream.recordEvent();
+  }
+
+  std::unordered_map<const void*, size_t> positions;
+  for (size_t i = 0; i < numNodes; ++i) {
+    positions[job.dag[i].sharedGrad_.get()] = i;
+  }
+  job.inputs.resize(numNodes);
+  job.pendingConsumers = std::make_unique<std::atomic<size_t>[]>(numNodes);
+  job.gradMutexes = std::make_unique<std::mutex[]>(numNodes);
+  job.gradEvents.resize(numNodes);
+  for (size_t i = 0; i < numNodes; ++i) {
+    job.pendingConsumers[i] = 0;
+  }
+  for (size_t i = 0; i < numNodes; ++i) {
+    auto& inputs = job.inputs[i];
+    for (const auto& input : job.dag[i].getInputs()) {
+      inputs.push_back(positions.at(input.sharedGrad_.get()));
+    }
+    std::sort(inputs.begin(), inputs.end());
+    inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+    for (const auto input : inputs) {
+      ++job.pendingConsumers[input];
+    }
+  }
+
+  // the root is the last node of the topological order, and has no consumers
+  job.inFlight = 1;
+  pool_->enqueue([this, &job, numNodes] { run(job, numNodes - 1); });
+  {
+    std::unique_lock<std::mutex> lock(job.mutex);
+    job.finished.wait(lock, [&job] { return job.inFlight == 0; });
+  }
+
+  if (!streams_.empty()) {
+    // work on the stream of the caller waits on the gradients
+    std::unordered_set<const Stream*> waitOns;
+    for (const auto& stream : streams_) {
+      waitOns.insert(stream.get());
+    }
+    callerStream.relativeSync(waitOns);
+  }
+  if (job.error) {
+    std::rethrow_exception(job.error);
+  }
+}
+
+void BackwardExecutor::backward(const Variable& var, bool retainGraph) {
+  auto ones = Variable(fl::full(var.shape(), 1, var.type()), false);
+  backward(var, ones, retainGraph);
+}
+
+void BackwardExecutor::run(Job& job, size_t pos) {
+  const auto& inputs = job.inputs[pos];
+  if (!job.failed) {
+    try {
+      auto& node = job.dag[pos];
+      if (workerStream) {
+        workerStream->relativeSync(*job.start);
+        // the consumers of the node are done adding to its gradient
+        for (const auto& event : job.gradEvents[pos]) {
+          workerStream->relativeSync(*event);
+        }
+      }
+      {
+        // inputs are locked in increasing order, which can't deadlock
+        std::vector<std::unique_lock<std::mutex>> locks;
+        locks.reserve(inputs.size());
+        for (const auto input : inputs) {
+          locks.emplace_back(job.gradMutexes[input]);
+          if (workerStream) {
+            for (const auto& event : job.gradEvents[input]) {
+              workerStream->relativeSync(*event);
+            }
+          }
+        }
+        node.calcGradInputs(job.retainGraph);
+        if (workerStream && !inputs.empty()) {
+          std::shared_ptr<Event> event = workerStream->recordEvent();
+          for (const auto input : inputs) {
+            job.gradEvents[input].push_back(event);
+          }
+        }
+      }
+      node.applyGradHook();
+      if (!job.retainGraph) {
+        node = Variable();
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(job.mutex);
+      if (!job.error) {
+        job.error = std::current_exception();
+      }
+      job.failed = true;
+    }
+  }
+
+  std::vector<size_t> ready;
+  if (!job.failed) {
+    for (const auto input : inputs) {
+      if (--job.pendingConsumers[input] == 0) {
+        ready.push_back(input);
+      }
+    }
+  }
+  auto& offloader = detail::ActivationOffloader::getInstance();
+  for (const auto input : ready) {
+    // bring offloaded activations back while the node waits for a thread
+    if (offloader.numOffloaded() > 0) {
+      offloader.prefetchInputs(job.dag[input]);
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(job.mutex);
+    job.inFlight += ready.size();
+    --job.inFlight;
+    for (const auto input : ready) {
+      pool_->enqueue([this, &job, input] { run(job, input); });
+    }
+    if (job.inFlight == 0) {
+      job.finished.notify_all();
+    }
+  }
+}
+
+} // namespace fl
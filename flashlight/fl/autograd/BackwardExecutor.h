@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "flashlight/fl/autograd/Variable.h"
+
+namespace fl {
+
+class Stream;
+class ThreadPool;
+
+/**
+ * Runs backward passes with the gradient functions of independent branches of
+ * the graph running concurrently on a pool of threads, each of which may run on
+ * its own stream, e.g. for the parallel convolution and attention modules of
+ * Conformer, such that small kernels of one branch don't wait for those of the
+ * other.
+ *
+ * A node runs once all nodes consuming it have added their gradients to its
+ * gradient, as it does in `Variable::backward`. Nodes adding to the gradient
+ * of the same input don't run concurrently, and gradient hooks run on the pool.
+ * The order in which the gradients of a node with more than two consumers are
+ * summed depends on scheduling, so gradients can differ from those of
+ * `Variable::backward` by rounding.
+ *
+ * Example:
+ * \code
+   fl::BackwardExecutor executor(
+       4, {device.getStreamFromPool(), device.getStreamFromPool()});
+   auto loss = criterion(model(input), target);
+   executor.backward(loss);
+ * \endcode
+ */
+class BackwardExecutor {
+ public:
+  /**
+   * @param[in] numThreads the number of threads running gradient functions.
+   * @param[in] streams the streams the threads run on, assigned round-robin,
+   * e.g. from `Device::getStreamFromPool`. If empty, the threads use the
+   * default stream of the tensor backend.
+   */
+  explicit BackwardExecutor(
+      size_t numThreads,
+      std::vector<std::shared_ptr<Stream>> streams = {});
+  ~BackwardExecutor();
+
+  // no copy/move
+  BackwardExecutor(const BackwardExecutor&) = delete;
+  BackwardExecutor(BackwardExecutor&&) = delete;
+  BackwardExecutor& operator=(const BackwardExecutor&) = delete;
+  BackwardExecutor& operator=(BackwardExecutor&&) = delete;
+
+  /**
+   * Runs the backward pass of `var` like `Variable::backward`, and returns
+   * once all gradient functions ran. Rethrows the first exception thrown by a
+   * gradient function, once running ones finished.
+   *
+   * @param[in] var the Variable to differentiate
+   * @param[in] grad the gradient of `var`
+   * @param[in] retainGraph whether to keep the graph for another backward pass
+   */
+  void backward(
+      const Variable& var,
+      const Variable& grad,
+      bool retainGraph = false);
+
+  /**
+   * Runs the backward pass of `var` with a gradient of 1.0 for all of its
+   * elements, see above.
+   */
+  void backward(const Variable& var, bool retainGraph = false);
+
+  /**
+   * @return the number of threads running gradient functions
+   */
+  size_t numThreads() const;
+
+ private:
+  struct Job;
+
+  // Runs the node at `pos` of the graph of `job`, then schedules its inputs
+  // all of whose consumers ran
+  void run(Job& job, size_t pos);
+
+  size_t numThreads_;
+  std::vector<std::shared_ptr<Stream>> streams_;
+  std::unique_ptr<ThreadPool> pool_;
+};
+
+} // namespace fl
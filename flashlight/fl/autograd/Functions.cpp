@@ -7,6 +7,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <sstream>
 #include <stdexcept>
 #include <vector>
 
@@ -17,6 +22,7 @@
 #include "flashlight/fl/common/DynamicBenchmark.h"
 #include "flashlight/fl/tensor/Compute.h"
 #include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/Profile.h"
 #include "flashlight/fl/tensor/Random.h"
 #include "flashlight/fl/tensor/TensorBackend.h"
 #include "flashlight/fl/tensor/TensorBase.h"
@@ -30,7 +36,7 @@ Tensor tileAs(const Tensor& input, const Shape& rdims) {
     return tile(input, rdims);
   }
 
-  Shape dims(std::vector<Dim>(rdims.ndim(), 1));
+  Shape dims(Shape::Dims(rdims.ndim(), 1));
   Shape idims = input.shape();
   for (int i = 0; i < rdims.ndim(); i++) {
     int idimsSize = i + 1 > idims.ndim() ? 1 : idims[i];
@@ -71,7 +77,7 @@ Shape expandedShapeFromReducedDims(
   }
 
   unsigned preNDims = input.ndim() + axes.size();
-  Shape newShape(std::vector<Dim>(preNDims, 1));
+  Shape newShape(Shape::Dims(preNDims, 1));
   unsigned axesIdx = 0;
   unsigned inputIdx = 0;
   for (unsigned i = 0; i < preNDims; ++i) {
@@ -111,7 +117,17 @@ bool areVariableTypesEqual(const Variable& a, const Variable& b) {
 
 } // namespace detail
 
+// Under autocast, binary ops of different floating point types run in the
+// wider one, e.g. residual connections around half precision ops
+#define FL_AUTOCAST_PROMOTE(OP, LHS, RHS)                                  \
+  if (AutocastGuard::isEnabled() && detail::isAutocastPromotable(LHS, RHS)) { \
+    const auto [promotedLhs, promotedRhs] = detail::autocastPromote(LHS, RHS); \
+    return OP(promotedLhs, promotedRhs);                                   \
+  }
+
 Variable operator+(const Variable& lhs, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator+", lhs.tensor());
+  FL_AUTOCAST_PROMOTE(operator+, lhs, rhs);
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   auto result = lhs.tensor() + rhs.tensor();
   auto gradFunc = [](std::vector<Variable>& inputs,
@@ -123,6 +139,7 @@ Variable operator+(const Variable& lhs, const Variable& rhs) {
 }
 
 Variable operator+(const Variable& lhs, const double& rhsVal) {
+  FL_PROFILE_OP("autograd::operator+", lhs.tensor());
   auto result = (lhs.tensor() + rhsVal).astype(lhs.type());
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -132,10 +149,13 @@ Variable operator+(const Variable& lhs, const double& rhsVal) {
 }
 
 Variable operator+(const double& lhsVal, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator+", rhs.tensor());
   return rhs + lhsVal;
 }
 
 Variable operator-(const Variable& lhs, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator-", lhs.tensor());
+  FL_AUTOCAST_PROMOTE(operator-, lhs, rhs);
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   auto result = lhs.tensor() - rhs.tensor();
   auto gradFunc = [](std::vector<Variable>& inputs,
@@ -147,6 +167,7 @@ Variable operator-(const Variable& lhs, const Variable& rhs) {
 }
 
 Variable operator-(const Variable& lhs, const double& rhsVal) {
+  FL_PROFILE_OP("autograd::operator-", lhs.tensor());
   auto result = (lhs.tensor() - rhsVal).astype(lhs.type());
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -156,6 +177,7 @@ Variable operator-(const Variable& lhs, const double& rhsVal) {
 }
 
 Variable operator-(const double& lhsVal, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator-", rhs.tensor());
   auto result = (lhsVal - rhs.tensor()).astype(rhs.type());
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -165,6 +187,8 @@ Variable operator-(const double& lhsVal, const Variable& rhs) {
 }
 
 Variable operator*(const Variable& lhs, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator*", lhs.tensor());
+  FL_AUTOCAST_PROMOTE(operator*, lhs, rhs);
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   auto result = lhs.tensor() * rhs.tensor();
   auto gradFunc = [](std::vector<Variable>& inputs,
@@ -186,6 +210,7 @@ Variable operator*(const Variable& lhs, const Variable& rhs) {
 }
 
 Variable operator*(const Variable& lhs, const double& rhsVal) {
+  FL_PROFILE_OP("autograd::operator*", lhs.tensor());
   auto result = (lhs.tensor() * rhsVal).astype(lhs.type());
   auto gradFunc =
       [rhsVal](std::vector<Variable>& inputs, const Variable& gradOutput) {
@@ -195,10 +220,13 @@ Variable operator*(const Variable& lhs, const double& rhsVal) {
 }
 
 Variable operator*(const double& lhsVal, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator*", rhs.tensor());
   return rhs * lhsVal;
 }
 
 Variable operator/(const Variable& lhs, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator/", lhs.tensor());
+  FL_AUTOCAST_PROMOTE(operator/, lhs, rhs);
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   auto result = lhs.tensor() / rhs.tensor();
   auto gradFunc = [](std::vector<Variable>& inputs,
@@ -218,6 +246,7 @@ Variable operator/(const Variable& lhs, const Variable& rhs) {
 }
 
 Variable operator/(const Variable& lhs, const double& rhsVal) {
+  FL_PROFILE_OP("autograd::operator/", lhs.tensor());
   auto result = (lhs.tensor() / rhsVal).astype(lhs.type());
   auto gradFunc =
       [rhsVal](std::vector<Variable>& inputs, const Variable& gradOutput) {
@@ -227,6 +256,7 @@ Variable operator/(const Variable& lhs, const double& rhsVal) {
 }
 
 Variable operator/(const double& lhsVal, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator/", rhs.tensor());
   auto result = (lhsVal / rhs.tensor()).astype(rhs.type());
   auto gradFunc = [lhsVal](
                       std::vector<Variable>& inputs,
@@ -238,81 +268,96 @@ Variable operator/(const double& lhsVal, const Variable& rhs) {
 }
 
 Variable operator>(const Variable& lhs, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator>", lhs.tensor());
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   auto result = lhs.tensor() > rhs.tensor();
   return Variable(result, false);
 }
 
 Variable operator>(const Variable& lhs, const double& rhsVal) {
+  FL_PROFILE_OP("autograd::operator>", lhs.tensor());
   auto result = (lhs.tensor() > rhsVal).astype(lhs.type());
   return Variable(result, false);
 }
 
 Variable operator>(const double& lhsVal, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator>", rhs.tensor());
   auto result = (lhsVal > rhs.tensor()).astype(rhs.type());
   return Variable(result, false);
 }
 
 Variable operator<(const Variable& lhs, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator<", lhs.tensor());
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   auto result = lhs.tensor() < rhs.tensor();
   return Variable(result, false);
 }
 
 Variable operator<(const Variable& lhs, const double& rhsVal) {
+  FL_PROFILE_OP("autograd::operator<", lhs.tensor());
   auto result = (lhs.tensor() < rhsVal).astype(lhs.type());
   return Variable(result, false);
 }
 
 Variable operator<(const double& lhsVal, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator<", rhs.tensor());
   auto result = (lhsVal < rhs.tensor()).astype(rhs.type());
   return Variable(result, false);
 }
 
 Variable operator>=(const Variable& lhs, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator>=", lhs.tensor());
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   auto result = lhs.tensor() >= rhs.tensor();
   return Variable(result, false);
 }
 
 Variable operator>=(const Variable& lhs, const double& rhsVal) {
+  FL_PROFILE_OP("autograd::operator>=", lhs.tensor());
   auto result = (lhs.tensor() >= rhsVal).astype(lhs.type());
   return Variable(result, false);
 }
 
 Variable operator>=(const double& lhsVal, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator>=", rhs.tensor());
   auto result = (lhsVal >= rhs.tensor()).astype(rhs.type());
   return Variable(result, false);
 }
 
 Variable operator<=(const Variable& lhs, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator<=", lhs.tensor());
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   auto result = lhs.tensor() <= rhs.tensor();
   return Variable(result, false);
 }
 
 Variable operator<=(const Variable& lhs, const double& rhsVal) {
+  FL_PROFILE_OP("autograd::operator<=", lhs.tensor());
   auto result = (lhs.tensor() <= rhsVal).astype(lhs.type());
   return Variable(result, false);
 }
 
 Variable operator<=(const double& lhsVal, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator<=", rhs.tensor());
   auto result = (lhsVal <= rhs.tensor()).astype(rhs.type());
   return Variable(result, false);
 }
 
 Variable operator&&(const Variable& lhs, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::operator&&", lhs.tensor());
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   auto result = lhs.tensor() && rhs.tensor();
   return Variable(result, false);
 }
 
 Variable operator!(const Variable& input) {
+  FL_PROFILE_OP("autograd::operator!", input.tensor());
   auto result = (!input.tensor()).astype(input.type());
   return Variable(result, false);
 }
 
 Variable max(const Variable& lhs, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::max", lhs.tensor());
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   auto result = fl::maximum(lhs.tensor(), rhs.tensor());
   auto gradFunc = [](std::vector<Variable>& inputs,
@@ -327,6 +372,7 @@ Variable max(const Variable& lhs, const Variable& rhs) {
 }
 
 Variable max(const Variable& lhs, const double& rhsVal) {
+  FL_PROFILE_OP("autograd::max", lhs.tensor());
   auto result = fl::maximum(lhs.tensor(), rhsVal).astype(lhs.type());
   auto gradFunc =
       [rhsVal](std::vector<Variable>& inputs, const Variable& gradOutput) {
@@ -338,10 +384,12 @@ Variable max(const Variable& lhs, const double& rhsVal) {
 }
 
 Variable max(const double& lhsVal, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::max", rhs.tensor());
   return max(rhs, lhsVal);
 }
 
 Variable min(const Variable& lhs, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::min", lhs.tensor());
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   auto result = fl::minimum(lhs.tensor(), rhs.tensor());
   auto gradFunc = [](std::vector<Variable>& inputs,
@@ -356,6 +404,7 @@ Variable min(const Variable& lhs, const Variable& rhs) {
 }
 
 Variable min(const Variable& lhs, const double& rhsVal) {
+  FL_PROFILE_OP("autograd::min", lhs.tensor());
   auto result = fl::minimum(lhs.tensor(), rhsVal).astype(lhs.type());
   auto gradFunc =
       [rhsVal](std::vector<Variable>& inputs, const Variable& gradOutput) {
@@ -367,10 +416,12 @@ Variable min(const Variable& lhs, const double& rhsVal) {
 }
 
 Variable min(const double& lhsVal, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::min", rhs.tensor());
   return min(rhs, lhsVal);
 }
 
 Variable negate(const Variable& input) {
+  FL_PROFILE_OP("autograd::negate", input.tensor());
   auto result = (0.0 - input.tensor()).astype(input.type());
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -380,6 +431,7 @@ Variable negate(const Variable& input) {
 }
 
 Variable reciprocal(const Variable& input) {
+  FL_PROFILE_OP("autograd::reciprocal", input.tensor());
   auto result = 1.0 / FL_ADJUST_INPUT_TYPE(input.tensor());
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -391,6 +443,7 @@ Variable reciprocal(const Variable& input) {
 }
 
 Variable exp(const Variable& input) {
+  FL_PROFILE_OP("autograd::exp", input.tensor());
   auto result = fl::exp(FL_ADJUST_INPUT_TYPE(input.tensor()));
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -401,6 +454,7 @@ Variable exp(const Variable& input) {
 }
 
 Variable log(const Variable& input) {
+  FL_PROFILE_OP("autograd::log", input.tensor());
   auto result = fl::log(FL_ADJUST_INPUT_TYPE(input.tensor()));
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -411,6 +465,7 @@ Variable log(const Variable& input) {
 }
 
 Variable log1p(const Variable& input) {
+  FL_PROFILE_OP("autograd::log1p", input.tensor());
   auto result = fl::log1p(FL_ADJUST_INPUT_TYPE(input.tensor()));
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -421,6 +476,7 @@ Variable log1p(const Variable& input) {
 }
 
 Variable pow(const Variable& input, double p) {
+  FL_PROFILE_OP("autograd::pow", input.tensor());
   auto result = fl::power(FL_ADJUST_INPUT_TYPE(input.tensor()), p);
   auto gradFunc = [p](std::vector<Variable>& inputs,
                       const Variable& gradOutput) {
@@ -432,6 +488,7 @@ Variable pow(const Variable& input, double p) {
 }
 
 Variable sin(const Variable& input) {
+  FL_PROFILE_OP("autograd::sin", input.tensor());
   auto result = fl::sin(input.tensor());
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -442,6 +499,7 @@ Variable sin(const Variable& input) {
 }
 
 Variable cos(const Variable& input) {
+  FL_PROFILE_OP("autograd::cos", input.tensor());
   auto result = fl::cos(input.tensor());
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -452,6 +510,7 @@ Variable cos(const Variable& input) {
 }
 
 Variable tanh(const Variable& input) {
+  FL_PROFILE_OP("autograd::tanh", input.tensor());
   auto result = fl::tanh(input.tensor());
   auto gradFunc =
       [result](std::vector<Variable>& inputs, const Variable& gradOutput) {
@@ -463,6 +522,7 @@ Variable tanh(const Variable& input) {
 }
 
 Variable clamp(const Variable& input, const double lo, const double hi) {
+  FL_PROFILE_OP("autograd::clamp", input.tensor());
   auto result = fl::clip(input.tensor(), lo, hi);
   auto gradFunc = [lo, hi, result](
                       std::vector<Variable>& inputs,
@@ -475,6 +535,7 @@ Variable clamp(const Variable& input, const double lo, const double hi) {
 }
 
 Variable sqrt(const Variable& input) {
+  FL_PROFILE_OP("autograd::sqrt", input.tensor());
   auto result = fl::sqrt(input.tensor());
   auto gradFunc = [result](
                       std::vector<Variable>& inputs,
@@ -486,6 +547,7 @@ Variable sqrt(const Variable& input) {
 }
 
 Variable sigmoid(const Variable& input) {
+  FL_PROFILE_OP("autograd::sigmoid", input.tensor());
   auto result = fl::sigmoid(input.tensor());
   auto gradFunc =
       [result](std::vector<Variable>& inputs, const Variable& gradOutput) {
@@ -496,10 +558,12 @@ Variable sigmoid(const Variable& input) {
 }
 
 Variable swish(const Variable& input, double beta) {
+  FL_PROFILE_OP("autograd::swish", input.tensor());
   return input * sigmoid(beta * input);
 }
 
 Variable erf(const Variable& input) {
+  FL_PROFILE_OP("autograd::erf", input.tensor());
   auto result = fl::erf(FL_ADJUST_INPUT_TYPE(input.tensor()));
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -511,6 +575,7 @@ Variable erf(const Variable& input) {
 }
 
 Variable transpose(const Variable& input, const Shape& dims /* = {} */) {
+  FL_PROFILE_OP("autograd::transpose", input.tensor());
   auto result = fl::transpose(input.tensor(), dims);
   auto gradFunc = [inputDims = input.shape(), ndim = input.ndim(), dims](
                       std::vector<Variable>& inputs,
@@ -535,6 +600,7 @@ Variable transpose(const Variable& input, const Shape& dims /* = {} */) {
 }
 
 Variable tileAs(const Variable& input, const Shape& rdims) {
+  FL_PROFILE_OP("autograd::tileAs", input.tensor());
   auto result = detail::tileAs(input.tensor(), rdims);
 
   Shape inDims = input.shape();
@@ -548,10 +614,12 @@ Variable tileAs(const Variable& input, const Shape& rdims) {
 }
 
 Variable tileAs(const Variable& input, const Variable& reference) {
+  FL_PROFILE_OP("autograd::tileAs", input.tensor());
   return tileAs(input, reference.shape());
 }
 
 Variable sumAs(const Variable& input, const Shape& rdims) {
+  FL_PROFILE_OP("autograd::sumAs", input.tensor());
   auto result = detail::sumAs(FL_ADJUST_INPUT_TYPE(input.tensor()), rdims);
   auto idims = input.tensor().shape();
   auto gradFunc =
@@ -562,6 +630,7 @@ Variable sumAs(const Variable& input, const Shape& rdims) {
 }
 
 Variable sumAs(const Variable& input, const Variable& reference) {
+  FL_PROFILE_OP("autograd::sumAs", input.tensor());
   return sumAs(input, reference.shape());
 }
 
@@ -569,6 +638,7 @@ Variable concatenate(const std::vector<Variable>& concatInputs, int dim) {
   if (concatInputs.empty()) {
     throw std::invalid_argument("cannot concatenate zero variables");
   }
+  FL_PROFILE_OP("autograd::concatenate", concatInputs.front().tensor());
 
   if (concatInputs.size() == 1) {
     return concatInputs[0];
@@ -638,6 +708,7 @@ Variable concatenate(const std::vector<Variable>& concatInputs, int dim) {
 }
 
 std::vector<Variable> split(const Variable& input, long splitSize, int dim) {
+  FL_PROFILE_OP("autograd::split", input.tensor());
   if (splitSize <= 0) {
     throw std::invalid_argument("split size must be a positive integer");
   }
@@ -652,6 +723,7 @@ std::vector<Variable> split(const Variable& input, long splitSize, int dim) {
 
 std::vector<Variable>
 split(const Variable& input, const std::vector<long>& splitSizes, int dim) {
+  FL_PROFILE_OP("autograd::split", input.tensor());
   if (dim >= input.ndim()) {
     throw std::invalid_argument(
         "split: passed dim is larger than the number of dimensions "
@@ -679,6 +751,7 @@ split(const Variable& input, const std::vector<long>& splitSizes, int dim) {
 }
 
 Variable tile(const Variable& input, const Shape& dims) {
+  FL_PROFILE_OP("autograd::tile", input.tensor());
   Tensor result = fl::tile(input.tensor(), dims);
   Shape idims = input.shape();
   auto gradFunc =
@@ -693,6 +766,7 @@ Variable sum(
     const Variable& input,
     const std::vector<int>& axes,
     bool keepDims /* = false*/) {
+  FL_PROFILE_OP("autograd::sum", input.tensor());
   auto result = FL_ADJUST_INPUT_TYPE(input.tensor());
   result = fl::sum(result, axes, keepDims);
 
@@ -713,6 +787,7 @@ Variable mean(
     const Variable& input,
     const std::vector<int>& axes,
     bool keepDims /* = false*/) {
+  FL_PROFILE_OP("autograd::mean", input.tensor());
   auto result = FL_ADJUST_INPUT_TYPE(input.tensor());
   result = mean(result, axes, keepDims);
 
@@ -747,6 +822,7 @@ Variable var(
     const std::vector<int>& axes,
     const bool isbiased /* = false */,
     bool keepDims /* = false*/) {
+  FL_PROFILE_OP("autograd::var", in.tensor());
   Tensor input = FL_ADJUST_INPUT_TYPE(in.tensor());
   auto result = sum(input * input, axes, keepDims);
 
@@ -786,6 +862,7 @@ Variable norm(
     const std::vector<int>& axes,
     double p /* = 2 */,
     bool keepDims /* = false */) {
+  FL_PROFILE_OP("autograd::norm", input.tensor());
   if (p <= 0) {
     throw std::out_of_range("Lp norm: p must be > 0");
   }
@@ -818,13 +895,17 @@ Variable normalize(
     const std::vector<int>& axes,
     double p /* = 2 */,
     double eps /* = 1e-12 */) {
+  FL_PROFILE_OP("autograd::normalize", in.tensor());
   auto input = FL_ADJUST_INPUT_TYPE(in);
   Variable norm = fl::norm(input, axes, p);
   Variable invscale = max(norm, eps);
   return input / tileAs(invscale, input);
 }
 
-Variable matmul(const Variable& lhs, const Variable& rhs) {
+Variable matmul(const Variable& lhsIn, const Variable& rhsIn) {
+  FL_PROFILE_OP("autograd::matmul", lhsIn.tensor());
+  auto lhs = FL_AUTOCAST_INPUT_TYPE(lhsIn);
+  auto rhs = FL_AUTOCAST_INPUT_TYPE(rhsIn);
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   // lhs:Input[0] -- [M, N]
   // rhs:Input[1] -- [N, K]
@@ -877,7 +958,10 @@ Variable matmul(const Variable& lhs, const Variable& rhs) {
   return Variable(result, {lhs, rhs}, gradFunc);
 }
 
-Variable matmulTN(const Variable& lhs, const Variable& rhs) {
+Variable matmulTN(const Variable& lhsIn, const Variable& rhsIn) {
+  FL_PROFILE_OP("autograd::matmulTN", lhsIn.tensor());
+  auto lhs = FL_AUTOCAST_INPUT_TYPE(lhsIn);
+  auto rhs = FL_AUTOCAST_INPUT_TYPE(rhsIn);
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   // lhs:Input[0] -- [N, M]
   // rhs:Input[1] -- [N, K]
@@ -910,7 +994,10 @@ Variable matmulTN(const Variable& lhs, const Variable& rhs) {
   return Variable(result, {lhs, rhs}, gradFunc);
 }
 
-Variable matmulNT(const Variable& lhs, const Variable& rhs) {
+Variable matmulNT(const Variable& lhsIn, const Variable& rhsIn) {
+  FL_PROFILE_OP("autograd::matmulNT", lhsIn.tensor());
+  auto lhs = FL_AUTOCAST_INPUT_TYPE(lhsIn);
+  auto rhs = FL_AUTOCAST_INPUT_TYPE(rhsIn);
   FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
   // lhs:Input[0] -- [M, N]
   // rhs:Input[1] -- [K, N]
@@ -946,6 +1033,7 @@ Variable matmulNT(const Variable& lhs, const Variable& rhs) {
 }
 
 Variable abs(const Variable& input) {
+  FL_PROFILE_OP("autograd::abs", input.tensor());
   auto result = fl::abs(input.tensor());
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -957,6 +1045,7 @@ Variable abs(const Variable& input) {
 }
 
 Variable flat(const Variable& input) {
+  FL_PROFILE_OP("autograd::flat", input.tensor());
   auto result = input.tensor().flatten();
   Shape idims = input.shape();
   auto gradFunc =
@@ -967,6 +1056,7 @@ Variable flat(const Variable& input) {
 }
 
 Variable moddims(const Variable& input, const Shape& dims) {
+  FL_PROFILE_OP("autograd::moddims", input.tensor());
   if (input.ndim() == 0) {
     return input;
   }
@@ -1018,10 +1108,51 @@ Variable moddims(const Variable& input, const Shape& dims) {
   return Variable(result, {input.withoutData()}, gradFunc);
 }
 
+namespace {
+
+// Whether the backend of `tensor` has single-pass softmax kernels for its
+// type. Otherwise, softmax is composed of reductions and elementwise ops.
+bool hasFusedSoftmax(const Tensor& tensor, const int dim) {
+  if (dim < 0 || dim >= tensor.ndim() ||
+      !detail::TensorExtensionRegistrar::getInstance()
+           .isTensorExtensionRegistered(
+               tensor.backendType(), TensorExtensionType::Autograd)) {
+    return false;
+  }
+  return tensor.backend().getExtension<AutogradExtension>().isDataTypeSupported(
+      tensor.type());
+}
+
+Variable fusedSoftmax(
+    const Variable& input,
+    const Tensor& inputArr,
+    const int dim,
+    const bool log) {
+  auto result = detail::softmax(inputArr, dim, log, /* payload = */ nullptr);
+  auto gradFunc = [dim, log, result](
+                      std::vector<Variable>& inputs,
+                      const Variable& gradOutput) {
+    auto grad = detail::softmaxBackward(
+        gradOutput.tensor().astype(result.type()),
+        result,
+        dim,
+        log,
+        /* payload = */ nullptr);
+    inputs[0].addGrad(Variable(grad.astype(inputs[0].type()), false));
+  };
+  return Variable(result, {input.withoutData()}, gradFunc);
+}
+
+} // namespace
+
 Variable softmax(const Variable& input, const int dim) {
+  FL_PROFILE_OP("autograd::softmax", input.tensor());
   Tensor inputArr = FL_ADJUST_INPUT_TYPE(input.tensor());
+  if (hasFusedSoftmax(inputArr, dim)) {
+    return fusedSoftmax(input, inputArr, dim, /* log = */ false);
+  }
   auto maxvals = amax(inputArr, {dim}, /* keepDims = */ true);
-  Shape tiledims(std::vector<Dim>(input.ndim(), 1));
+  Shape tiledims(Shape::Dims(input.ndim(), 1));
   tiledims[dim] = input.dim(dim);
 
   auto expInput = fl::exp(inputArr - fl::tile(maxvals, tiledims));
@@ -1042,10 +1173,14 @@ Variable softmax(const Variable& input, const int dim) {
 }
 
 Variable logSoftmax(const Variable& input, const int dim) {
+  FL_PROFILE_OP("autograd::logSoftmax", input.tensor());
   Tensor inputArr = FL_ADJUST_INPUT_TYPE(input.tensor());
+  if (hasFusedSoftmax(inputArr, dim)) {
+    return fusedSoftmax(input, inputArr, dim, /* log = */ true);
+  }
   auto maxvals = amax(inputArr, {dim}, /* keepDims = */ true);
   // TODO{fl::Tensor}{rewrite}
-  Shape tiledims(std::vector<Dim>(input.ndim(), 1));
+  Shape tiledims(Shape::Dims(input.ndim(), 1));
   tiledims[dim] = input.dim(dim);
   auto result = inputArr -
       fl::tile(fl::log(fl::sum(
@@ -1070,6 +1205,7 @@ Variable logSoftmax(const Variable& input, const int dim) {
 }
 
 Variable binaryCrossEntropy(const Variable& inputs, const Variable& targets) {
+  FL_PROFILE_OP("autograd::binaryCrossEntropy", inputs.tensor());
   auto targetsTyped = targets.astype(inputs.type());
   return negate(
       targetsTyped * log(inputs) + (1 - targetsTyped) * log(1 - inputs));
@@ -1080,6 +1216,7 @@ Variable categoricalCrossEntropy(
     const Variable& targets,
     ReduceMode reduction /* =ReduceMode::MEAN */,
     int ignoreIndex /* = -1 */) {
+  FL_PROFILE_OP("autograd::categoricalCrossEntropy", in.tensor());
   auto input = FL_ADJUST_INPUT_TYPE(in);
   // input -- [C, X1, X2, X3]
   // target -- [X1, X2, X3, 1]
@@ -1158,6 +1295,7 @@ Variable weightedCategoricalCrossEntropy(
     const Variable& targets,
     const Variable& weight,
     int ignoreIndex /* = -1 */) {
+  FL_PROFILE_OP("autograd::weightedCategoricalCrossEntropy", input.tensor());
   // input -- [C, X1, X2, X3]
   // target -- [X1, X2, X3]
   if (input.ndim() < targets.ndim() - 1) {
@@ -1222,6 +1360,7 @@ Variable weightedCategoricalCrossEntropy(
 }
 
 Variable reorder(const Variable& input, const Shape& shape) {
+  FL_PROFILE_OP("autograd::reorder", input.tensor());
   auto result = fl::transpose(input.tensor(), shape);
   if (!result.isContiguous()) {
     result = result.asContiguousTensor();
@@ -1236,7 +1375,7 @@ Variable reorder(const Variable& input, const Shape& shape) {
 
   auto gradFunc =
       [dimGrad](std::vector<Variable>& inputs, const Variable& gradOutput) {
-        Shape reordered(std::vector<Dim>(dimGrad.size()));
+        Shape reordered(Shape::Dims(dimGrad.size()));
         for (unsigned i = 0; i < dimGrad.size(); ++i) {
           reordered[i] = dimGrad[i].second;
         }
@@ -1248,15 +1387,17 @@ Variable reorder(const Variable& input, const Shape& shape) {
 }
 
 Variable linear(const Variable& input, const Variable& weight) {
+  FL_PROFILE_OP("autograd::linear", input.tensor());
   auto dummyBias = Variable(Tensor().astype(input.type()), false);
   return linear(input, weight, dummyBias);
 }
 
 Variable linear(const Variable& in, const Variable& wt, const Variable& bs) {
-  FL_VARIABLE_DTYPES_MATCH_CHECK(in, wt, bs);
+  FL_PROFILE_OP("autograd::linear", in.tensor());
   auto input = FL_ADJUST_INPUT_TYPE(in);
   auto weight = FL_ADJUST_INPUT_TYPE(wt);
   auto bias = FL_ADJUST_INPUT_TYPE(bs);
+  FL_VARIABLE_DTYPES_MATCH_CHECK(input, weight, bias);
 
   Shape to2d({input.dim(0), input.elements() / input.dim(0)});
   auto to4d = input.shape();
@@ -1318,10 +1459,23 @@ Variable conv2d(
     int dx,
     int dy,
     int groups,
-    std::shared_ptr<detail::ConvBenchmarks> benchmarks) {
+    std::shared_ptr<detail::ConvBenchmarks> benchmarks,
+    MemoryFormat format /* = MemoryFormat::WHCN */) {
+  FL_PROFILE_OP("autograd::conv2d", input.tensor());
   auto dummyBias = Variable(Tensor(input.type()), false);
   return conv2d(
-      input, weights, dummyBias, sx, sy, px, py, dx, dy, groups, benchmarks);
+      input,
+      weights,
+      dummyBias,
+      sx,
+      sy,
+      px,
+      py,
+      dx,
+      dy,
+      groups,
+      benchmarks,
+      format);
 }
 
 Variable conv2d(
@@ -1335,8 +1489,9 @@ Variable conv2d(
     int dx,
     int dy,
     int groups,
-    std::shared_ptr<detail::ConvBenchmarks> benchmarks) {
-  FL_VARIABLE_DTYPES_MATCH_CHECK(in, wt, bs);
+    std::shared_ptr<detail::ConvBenchmarks> benchmarks,
+    MemoryFormat format /* = MemoryFormat::WHCN */) {
+  FL_PROFILE_OP("autograd::conv2d", in.tensor());
 
   auto payload = detail::createAutogradPayload(in, wt, bs);
 
@@ -1345,6 +1500,7 @@ Variable conv2d(
   auto input = FL_ADJUST_INPUT_TYPE(in);
   auto weights = FL_ADJUST_INPUT_TYPE(wt);
   auto bias = FL_ADJUST_INPUT_TYPE(bs);
+  FL_VARIABLE_DTYPES_MATCH_CHECK(input, weights, bias);
 
   Tensor output = detail::conv2d(
       input.tensor(),
@@ -1357,10 +1513,11 @@ Variable conv2d(
       dx,
       dy,
       groups,
+      format,
       payload);
 
   auto gradFunc =
-      [sx, sy, px, py, dx, dy, hasBias, groups, benchmarks, payload](
+      [sx, sy, px, py, dx, dy, hasBias, groups, benchmarks, format, payload](
           std::vector<Variable>& inputs, const Variable& gradOutput) {
         // Create benchmarks if needed
         auto& autogradExtension =
@@ -1373,18 +1530,18 @@ Variable conv2d(
           if (!benchmarks->bwdFilterBenchmark) {
             benchmarks->bwdFilterBenchmark =
                 autogradExtension.createBenchmarkOptions();
-            filterBench = benchmarks->bwdFilterBenchmark;
           }
           if (!benchmarks->bwdDataBenchmark) {
             benchmarks->bwdDataBenchmark =
                 autogradExtension.createBenchmarkOptions();
-            dataBench = benchmarks->bwdDataBenchmark;
           }
           if (!benchmarks->bwdBiasBenchmark) {
             benchmarks->bwdBiasBenchmark =
                 autogradExtension.createBenchmarkOptions();
-            biasBench = benchmarks->bwdBiasBenchmark;
           }
+          filterBench = benchmarks->bwdFilterBenchmark;
+          dataBench = benchmarks->bwdDataBenchmark;
+          biasBench = benchmarks->bwdBiasBenchmark;
         }
 
         // Bias gradients
@@ -1417,6 +1574,7 @@ Variable conv2d(
                   dx,
                   dy,
                   groups,
+                  format,
                   dataBench,
                   payload);
 
@@ -1439,6 +1597,7 @@ Variable conv2d(
                                                 dx,
                                                 dy,
                                                 groups,
+                                                format,
                                                 filterBench,
                                                 biasBench,
                                                 payload);
@@ -1464,12 +1623,14 @@ Variable pool2d(
     int sy,
     int px,
     int py,
-    PoolingMode mode /* = PoolingMode::MAX */) {
+    PoolingMode mode /* = PoolingMode::MAX */,
+    MemoryFormat format /* = MemoryFormat::WHCN */) {
+  FL_PROFILE_OP("autograd::pool2d", input.tensor());
   auto payload = detail::createAutogradPayload(input);
-  Tensor output =
-      fl::detail::pool2d(input.tensor(), wx, wy, sx, sy, px, py, mode, payload);
+  Tensor output = fl::detail::pool2d(
+      input.tensor(), wx, wy, sx, sy, px, py, mode, format, payload);
 
-  auto gradFunc = [wx, wy, sx, sy, px, py, mode, output, payload](
+  auto gradFunc = [wx, wy, sx, sy, px, py, mode, format, output, payload](
                       std::vector<Variable>& inputs,
                       const Variable& gradOutput) {
     auto& in = inputs[0];
@@ -1489,6 +1650,7 @@ Variable pool2d(
             px,
             py,
             mode,
+            format,
             payload),
         false));
   };
@@ -1505,6 +1667,7 @@ Variable batchnorm(
     bool train,
     double momentum,
     double epsilon) {
+  FL_PROFILE_OP("autograd::batchnorm", _input.tensor());
   auto payload = detail::createAutogradPayload(_input, weight, bias);
   auto input = FL_ADJUST_INPUT_TYPE(_input);
 
@@ -1564,7 +1727,66 @@ Variable batchnorm(
   return Variable(output, {input, weight, bias}, gradFunc);
 }
 
+Variable layerNorm(
+    const Variable& _input,
+    const Variable& weight,
+    const Variable& bias,
+    const int numAxes,
+    const double epsilon) {
+  FL_PROFILE_OP("autograd::layerNorm", _input.tensor());
+  auto payload = detail::createAutogradPayload(_input, weight, bias);
+  auto input = FL_ADJUST_INPUT_TYPE(_input);
+
+  Tensor saveMean, saveRstd;
+  Tensor output = fl::detail::layerNorm(
+      saveMean,
+      saveRstd,
+      input.tensor(),
+      weight.tensor(),
+      bias.tensor(),
+      numAxes,
+      epsilon,
+      payload);
+
+  auto gradFunc =
+      [saveMean = std::move(saveMean),
+       saveRstd = std::move(saveRstd),
+       numAxes,
+       epsilon,
+       payload](std::vector<Variable>& inputs, const Variable& _gradOutput) {
+        auto& in = inputs[0];
+        auto& wt = inputs[1];
+        auto& bs = inputs[2];
+        if (!in.isCalcGrad() && !wt.isCalcGrad() && !bs.isCalcGrad()) {
+          return;
+        }
+
+        auto gradOutput = detail::adjustInputType(_gradOutput, "layerNorm");
+        auto [gradIn, gradWt, gradBs] = detail::layerNormBackward(
+            gradOutput.tensor(),
+            saveMean,
+            saveRstd,
+            detail::adjustInputType(in.tensor(), "layerNorm"),
+            wt.tensor(),
+            numAxes,
+            epsilon,
+            payload);
+
+        in.addGrad(Variable(gradIn.astype(in.type()), false));
+        if (!wt.isEmpty()) {
+          wt.addGrad(Variable(
+              fl::reshape(gradWt, wt.shape()).astype(wt.type()), false));
+        }
+        if (!bs.isEmpty()) {
+          bs.addGrad(Variable(
+              fl::reshape(gradBs, bs.shape()).astype(bs.type()), false));
+        }
+      };
+  return Variable(output, {input, weight, bias}, gradFunc);
+}
+
 Variable gatedlinearunit(const Variable& input, const int dim) {
+  FL_PROFILE_OP("autograd::gatedlinearunit", input.tensor());
   if (dim >= input.ndim()) {
     throw std::invalid_argument(
         "gatedlinearunit - passed dim is great than the "
@@ -1603,35 +1825,65 @@ Variable gatedlinearunit(const Variable& input, const int dim) {
   return Variable(fhalfout * shalfout, {input.withoutData()}, gradFunc);
 }
 
-std::tuple<Variable, Variable, Variable> rnn(
-    const Variable& input,
-    const Variable& hiddenState,
-    const Variable& cellState,
-    const Variable& weights,
+namespace {
+
+// The rnn of fl::rnn, on sequences of the given lengths, which the backend
+// must support, or on full sequences without lengths
+std::tuple<Variable, Variable, Variable> rnnImpl(
+    const Variable& in,
+    const Variable& hiddenIn,
+    const Variable& cellIn,
+    const Variable& wt,
+    const std::vector<int>& sequenceLengths,
     int hiddenSize,
     int numLayers,
     RnnMode mode,
     bool bidirectional,
     float dropProb) {
+  FL_PROFILE_OP("autograd::rnn", in.tensor());
+  auto input = FL_AUTOCAST_INPUT_TYPE(in);
+  auto hiddenState = FL_AUTOCAST_INPUT_TYPE(hiddenIn);
+  auto cellState = FL_AUTOCAST_INPUT_TYPE(cellIn);
+  auto weights = FL_AUTOCAST_INPUT_TYPE(wt);
   auto payload =
       detail::createAutogradPayload(input, hiddenState, cellState, weights);
 
   Tensor output, hiddenOut, cellStateOut;
-  std::tie(output, hiddenOut, cellStateOut) = detail::rnn(
-      input.tensor(),
-      hiddenState.tensor(),
-      cellState.tensor(),
-      weights.tensor(),
-      hiddenSize,
-      numLayers,
-      mode,
-      bidirectional,
-      dropProb,
-      payload);
+  if (sequenceLengths.empty()) {
+    std::tie(output, hiddenOut, cellStateOut) = detail::rnn(
+        input.tensor(),
+        hiddenState.tensor(),
+        cellState.tensor(),
+        weights.tensor(),
+        hiddenSize,
+        numLayers,
+        mode,
+        bidirectional,
+        dropProb,
+        payload);
+  } else {
+    std::tie(output, hiddenOut, cellStateOut) =
+        input.tensor()
+            .backend()
+            .getExtension<AutogradExtension>()
+            .variableLengthRnn(
+                input.tensor(),
+                hiddenState.tensor(),
+                cellState.tensor(),
+                weights.tensor(),
+                sequenceLengths,
+                hiddenSize,
+                numLayers,
+                mode,
+                bidirectional,
+                dropProb,
+                payload);
+  }
 
   auto gradData = std::make_shared<detail::RNNGradData>();
 
   auto gradFunc = [output,
+                   sequenceLengths,
                    numLayers,
                    hiddenSize,
                    mode,
@@ -1651,20 +1903,36 @@ std::tuple<Variable, Variable, Variable> rnn(
       return;
     }
 
-    auto [dy, dhy, dcy, dweights] =
-        input.tensor().backend().getExtension<AutogradExtension>().rnnBackward(
-            input.tensor(),
-            hiddenState.tensor(),
-            cellState.tensor(),
-            weights.tensor(),
-            gradData,
-            output,
-            numLayers,
-            hiddenSize,
-            mode,
-            bidirectional,
-            dropProb,
-            payload);
+    auto& extension =
+        input.tensor().backend().getExtension<AutogradExtension>();
+    auto [dy, dhy, dcy, dweights] = sequenceLengths.empty()
+        ? extension.rnnBackward(
+              input.tensor(),
+              hiddenState.tensor(),
+              cellState.tensor(),
+              weights.tensor(),
+              gradData,
+              output,
+              numLayers,
+              hiddenSize,
+              mode,
+              bidirectional,
+              dropProb,
+              payload)
+        : extension.variableLengthRnnBackward(
+              input.tensor(),
+              hiddenState.tensor(),
+              cellState.tensor(),
+              weights.tensor(),
+              sequenceLengths,
+              gradData,
+              output,
+              numLayers,
+              hiddenSize,
+              mode,
+              bidirectional,
+              dropProb,
+              payload);
 
     input.addGrad(Variable(dy.astype(input.type()), false));
     hiddenState.addGrad(Variable(dhy.astype(hiddenState.type()), false));
@@ -1704,7 +1972,234 @@ std::tuple<Variable, Variable, Variable> rnn(
   return std::make_tuple(yv, hyv, cyv);
 }
 
-Variable embedding(const Variable& input, const Variable& embeddings) {
+// Runs an rnn only on the steps of each sample, on backends without
+// variable-length rnns. Unidirectional rnns run the steps between consecutive
+// lengths on the samples which are at least as long, passing on their states,
+// while bidirectional ones, whose reverse direction starts at the last step of
+// each sample, run the samples of each length separately.
+std::tuple<Variable, Variable, Variable> rnnOverSteps(
+    const Variable& input,
+    const Variable& hiddenState,
+    const Variable& cellState,
+    const Variable& weights,
+    const std::vector<int>& sequenceLengths,
+    int hiddenSize,
+    int numLayers,
+    RnnMode mode,
+    bool bidirectional,
+    float dropProb) {
+  const int batchSize = sequenceLengths.size();
+  const int seqLength = input.dim(2);
+  const bool hasCellState = mode == RnnMode::LSTM;
+
+  // samples by decreasing length, and the first sample of each length
+  std::vector<int> order(batchSize);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int lhs, int rhs) {
+    return sequenceLengths[lhs] > sequenceLengths[rhs];
+  });
+  std::vector<std::pair<int, int>> groups; // {first sample, length}
+  for (int i = 0; i < batchSize; ++i) {
+    const int length = sequenceLengths[order[i]];
+    if (groups.empty() || groups.back().second != length) {
+      groups.emplace_back(i, length);
+    }
+  }
+  auto groupEnd = [&](const size_t group) {
+    return group + 1 < groups.size() ? groups[group + 1].first : batchSize;
+  };
+  auto samples = [](const Variable& var, const int begin, const int end) {
+    return var.isEmpty() ? var : var(fl::span, fl::range(begin, end));
+  };
+
+  const auto sortIdx = Tensor::fromVector(order);
+  const auto x = input(fl::span, sortIdx);
+  auto h = hiddenState.isEmpty() ? hiddenState : hiddenState(fl::span, sortIdx);
+  auto c = cellState.isEmpty() || !hasCellState ? cellState
+                                                 : cellState(fl::span, sortIdx);
+
+  std::vector<Variable> ys, hys, cys;
+  if (!bidirectional) {
+    int numSamples = batchSize;
+    int step = 0;
+    for (int group = groups.size() - 1; group >= 0; --group) {
+      const int end = groupEnd(group);
+      if (end < numSamples) {
+        // the samples from `end` on ended at the last step
+        hys.push_back(samples(h, end, numSamples));
+        h = samples(h, 0, end);
+        if (hasCellState) {
+          cys.push_back(samples(c, end, numSamples));
+          c = samples(c, 0, end);
+        }
+        numSamples = end;
+      }
+      const int length = groups[group].second;
+      Variable y;
+      std::tie(y, h, c) = rnnImpl(
+          x(fl::span, fl::range(0, end), fl::range(step, length)),
+          h,
+          c,
+          weights,
+          {},
+          hiddenSize,
+          numLayers,
+          mode,
+          bidirectional,
+          dropProb);
+      ys.push_back(
+          end < batchSize ? padding(y, {{0, 0}, {0, batchSize - end}}, 0) : y);
+      step = length;
+    }
+    hys.push_back(h);
+    cys.push_back(c);
+    std::reverse(hys.begin(), hys.end());
+    std::reverse(cys.begin(), cys.end());
+  } else {
+    for (size_t group = 0; group < groups.size(); ++group) {
+      const int begin = groups[group].first;
+      const int end = groupEnd(group);
+      const int length = groups[group].second;
+      auto [y, hy, cy] = rnnImpl(
+          x(fl::span, fl::range(begin, end), fl::range(0, length)),
+          samples(h, begin, end),
+          hasCellState ? samples(c, begin, end) : c,
+          weights,
+          {},
+          hiddenSize,
+          numLayers,
+          mode,
+          bidirectional,
+          dropProb);
+      ys.push_back(
+          length < seqLength
+              ? padding(y, {{0, 0}, {0, 0}, {0, seqLength - length}}, 0)
+              : y);
+      hys.push_back(hy);
+      cys.push_back(cy);
+    }
+  }
+
+  std::vector<int> inverseOrder(batchSize);
+  for (int i = 0; i < batchSize; ++i) {
+    inverseOrder[order[i]] = i;
+  }
+  const auto unsortIdx = Tensor::fromVector(inverseOrder);
+  auto unsort = [&](const Variable& var) {
+    return var(fl::span, unsortIdx);
+  };
+
+  auto output = concatenate(ys, bidirectional ? 1 : 2);
+  const int maxLength = groups.front().second;
+  if (!bidirectional && maxLength < seqLength) {
+    output = padding(output, {{0, 0}, {0, 0}, {0, seqLength - maxLength}}, 0);
+  }
+  return std::make_tuple(
+      unsort(output),
+      unsort(concatenate(hys, 1)),
+      hasCellState ? unsort(concatenate(cys, 1)) : cys.back());
+}
+
+} // namespace
+
+std::tuple<Variable, Variable, Variable> rnn(
+    const Variable& input,
+    const Variable& hiddenState,
+    const Variable& cellState,
+    const Variable& weights,
+    int hiddenSize,
+    int numLayers,
+    RnnMode mode,
+    bool bidirectional,
+    float dropProb) {
+  return rnnImpl(
+      input,
+      hiddenState,
+      cellState,
+      weights,
+      {},
+      hiddenSize,
+      numLayers,
+      mode,
+      bidirectional,
+      dropProb);
+}
+
+std::tuple<Variable, Variable, Variable> rnn(
+    const Variable& input,
+    const Variable& hiddenState,
+    const Variable& cellState,
+    const Variable& weights,
+    const std::vector<int>& sequenceLengths,
+    int hiddenSize,
+    int numLayers,
+    RnnMode mode,
+    bool bidirectional,
+    float dropProb) {
+  const int batchSize = input.ndim() < 2 ? 1 : input.dim(1);
+  const int seqLength = input.ndim() < 3 ? 1 : input.dim(2);
+  if (sequenceLengths.size() != batchSize) {
+    throw std::invalid_argument(
+        "rnn: expected a sequence length for each of the " +
+        std::to_string(batchSize) + " samples, got " +
+        std::to_string(sequenceLengths.size()));
+  }
+  bool allFull = true;
+  for (const int length : sequenceLengths) {
+    if (length < 1 || length > seqLength) {
+      throw std::invalid_argument(
+          "rnn: sequence length " + std::to_string(length) +
+          " is not in [1, " + std::to_string(seqLength) + "]");
+    }
+    allFull = allFull && length == seqLength;
+  }
+
+  if (allFull) {
+    return rnn(
+        input,
+        hiddenState,
+        cellState,
+        weights,
+        hiddenSize,
+        numLayers,
+        mode,
+        bidirectional,
+        dropProb);
+  }
+  if (input.tensor()
+          .backend()
+          .getExtension<AutogradExtension>()
+          .isVariableLengthRnnSupported()) {
+    return rnnImpl(
+        input,
+        hiddenState,
+        cellState,
+        weights,
+        sequenceLengths,
+        hiddenSize,
+        numLayers,
+        mode,
+        bidirectional,
+        dropProb);
+  }
+  return rnnOverSteps(
+      input,
+      hiddenState,
+      cellState,
+      weights,
+      sequenceLengths,
+      hiddenSize,
+      numLayers,
+      mode,
+      bidirectional,
+      dropProb);
+}
+
+Variable embedding(
+    const Variable& input,
+    const Variable& embeddings,
+    bool sparseGrad /* = false */) {
+  FL_PROFILE_OP("autograd::embedding", input.tensor());
   // TODO{fl::Tensor}{4-dims} - relax this
   if (input.ndim() >= 4) {
     throw std::invalid_argument("embedding input must have 3 or fewer dims");
@@ -1720,8 +2215,9 @@ Variable embedding(const Variable& input, const Variable& embeddings) {
   Shape resultDims(rDims);
   Tensor result = fl::reshape(embeddings.tensor()(fl::span, idxs), resultDims);
 
-  auto gradFunc = [](std::vector<Variable>& inputs,
-                     const Variable& gradOutput) {
+  auto gradFunc = [sparseGrad](
+                      std::vector<Variable>& inputs,
+                      const Variable& gradOutput) {
     auto& w = inputs[1];
     if (!w.isCalcGrad()) {
       return;
@@ -1730,6 +2226,10 @@ Variable embedding(const Variable& input, const Variable& embeddings) {
     auto ip = inputs[0].tensor().flatten();
     unsigned size = ip.elements();
     auto deltas = fl::reshape(gradOutput.tensor(), {w.dim(0), size});
+    if (sparseGrad) {
+      w.addGrad(Variable::rowSparse(ip, deltas, w.shape()));
+      return;
+    }
 
     // Sparse Tensor
     auto sp = Tensor(
@@ -1752,6 +2252,7 @@ Variable padding(
     const Variable& input,
     std::vector<std::pair<int, int>> pad,
     double val) {
+  FL_PROFILE_OP("autograd::padding", input.tensor());
   if (pad.size() > input.ndim()) {
     throw std::invalid_argument(
         "padding: number of padding dimensions exceeds number "
@@ -1774,21 +2275,138 @@ Variable padding(
   return Variable(result, {input.withoutData()}, gradFunc);
 }
 
+namespace {
+
+// Packs a boolean mask into bytes of 8 of its elements, by their flat index
+Tensor packMask(const Tensor& mask) {
+  const Dim elements = mask.elements();
+  const Dim bytes = (elements + 7) / 8;
+  auto bits = mask.flatten().astype(fl::dtype::u8);
+  if (bytes * 8 > elements) {
+    bits = fl::concatenate(
+        {bits, fl::full({bytes * 8 - elements}, 0, fl::dtype::u8)}, 0);
+  }
+  // the bits of the elements are distinct, so their sum is their bitwise or
+  const auto shifts = fl::arange({8, 1}, 0, fl::dtype::u8);
+  return fl::sum(fl::reshape(bits, {8, bytes}) << shifts, {0})
+      .astype(fl::dtype::u8);
+}
+
+// The boolean mask of the given shape packed by packMask
+Tensor unpackMask(const Tensor& packed, const Shape& shape) {
+  const Dim bytes = packed.elements();
+  const auto shifts = fl::arange({8, 1}, 0, fl::dtype::u8);
+  auto bits =
+      (fl::tile(fl::reshape(packed, {1, bytes}), {8, 1}) >> shifts) & 1;
+  return fl::reshape(bits.flatten()(fl::range(0, shape.elements())), shape) !=
+      0;
+}
+
+// The dropout of `input` with the elements where `keep` is true, whose
+// gradient gets the mask from `getKeep`. Only what `getKeep` captures is saved
+// for the backward pass, and the forward pass is elementwise, such that
+// backends with a JIT fuse it with the ops computing its input.
+Variable applyDropout(
+    const Variable& input,
+    const Tensor& keep,
+    const double p,
+    std::function<Tensor(const Shape&)> getKeep) {
+  const double scale = 1.0 / (1.0 - p);
+  auto result = input.tensor() * (keep.astype(input.type()) * scale);
+  auto gradFunc = [scale, getKeep = std::move(getKeep)](
+                      std::vector<Variable>& inputs,
+                      const Variable& gradOutput) {
+    const auto& grad = gradOutput.tensor();
+    inputs[0].addGrad(Variable(
+        grad * (getKeep(grad.shape()).astype(grad.type()) * scale), false));
+  };
+  return Variable(result, {input.withoutData()}, gradFunc);
+}
+
+} // namespace
+
 Variable dropout(const Variable& input, double p) {
+  FL_PROFILE_OP("autograd::dropout", input.tensor());
   if (p > 0.0) {
-    auto mask = Variable(
-        (fl::rand(input.shape(), input.type()) > p).astype(input.type()), false);
-    return 1.0 / (1.0 - p) * mask * input;
+    auto keep = fl::rand(input.shape(), input.type()) > p;
+    // the mask is saved with a bit per element
+    auto packed = packMask(keep);
+    return applyDropout(input, keep, p, [packed](const Shape& shape) {
+      return unpackMask(packed, shape);
+    });
+  } else {
+    return input;
+  }
+}
+
+Variable dropout(const Variable& input, double p, RandomState& state) {
+  FL_PROFILE_OP("autograd::dropout", input.tensor());
+  if (p > 0.0) {
+    // the mask is drawn again from the state in the backward pass
+    const RandomState maskState = state;
+    const auto type = input.type();
+    return applyDropout(
+        input,
+        fl::rand(input.shape(), state, type) > p,
+        p,
+        [maskState, type, p](const Shape& shape) {
+          auto state = maskState;
+          return fl::rand(shape, state, type) > p;
+        });
   } else {
     return input;
   }
 }
 
 Variable relu(const Variable& input) {
+  FL_PROFILE_OP("autograd::relu", input.tensor());
   return max(input, 0.0);
 }
 
+Variable& addInPlace(Variable& lhs, const Variable& rhs) {
+  FL_PROFILE_OP("autograd::addInPlace", lhs.tensor());
+  FL_VARIABLE_DTYPES_MATCH_CHECK(lhs, rhs);
+  if (lhs.shape() != rhs.shape()) {
+    throw std::invalid_argument(
+        "addInPlace: the Variables must have the same shape");
+  }
+  auto gradFunc = [](std::vector<Variable>& inputs,
+                     const Variable& gradOutput) {
+    inputs[0].addGrad(Variable(gradOutput.tensor(), false));
+    inputs[1].addGrad(Variable(gradOutput.tensor(), false));
+  };
+  lhs.recordInPlace({lhs.withoutData(), rhs.withoutData()}, gradFunc);
+  lhs.tensor() += rhs.tensor();
+  return lhs;
+}
+
+Variable& scaleInPlace(Variable& input, double scale) {
+  FL_PROFILE_OP("autograd::scaleInPlace", input.tensor());
+  auto gradFunc =
+      [scale](std::vector<Variable>& inputs, const Variable& gradOutput) {
+        inputs[0].addGrad(Variable(gradOutput.tensor() * scale, false));
+      };
+  input.recordInPlace({input.withoutData()}, gradFunc);
+  input.tensor() *= scale;
+  return input;
+}
+
+Variable& reluInPlace(Variable& input) {
+  FL_PROFILE_OP("autograd::reluInPlace", input.tensor());
+  // the gradient is masked by the output, which is saved
+  auto gradFunc = [](std::vector<Variable>& inputs,
+                     const Variable& gradOutput) {
+    auto mask = (inputs[0].tensor() > 0).astype(gradOutput.type());
+    inputs[0].addGrad(Variable(mask * gradOutput.tensor(), false));
+  };
+  auto previous = input;
+  input.recordInPlace({previous}, gradFunc);
+  input.tensor() *= (input.tensor() > 0).astype(input.type());
+  return input;
+}
+
 Variable gelu(const Variable& in) {
+  FL_PROFILE_OP("autograd::gelu", in.tensor());
   auto input = FL_ADJUST_INPUT_TYPE(in);
   return 0.5 * input *
       (1.0 +
@@ -1796,6 +2414,7 @@ Variable gelu(const Variable& in) {
 }
 
 fl::Variable relativePositionEmbeddingRotate(const fl::Variable& input) {
+  FL_PROFILE_OP("autograd::relativePositionEmbeddingRotate", input.tensor());
   if (input.ndim() != 3) {
     throw std::invalid_argument(
         "relativePositionEmbeddingRotate - "
@@ -1825,6 +2444,354 @@ fl::Variable relativePositionEmbeddingRotate(const fl::Variable& input) {
   return fl::Variable(data, {input}, gradFunc);
 }
 
+namespace {
+
+// keys per tile of scaledDotProductAttention, which bounds its intermediate
+// scores to Tq x kAttentionTileSize per sequence
+constexpr Dim kAttentionTileSize = 128;
+
+// A seed for dropout masks which are drawn again by the backward pass, from
+// the random numbers in use, e.g. those of a RandomStateScope
+uint64_t drawDropoutSeed() {
+  constexpr int kSeedDrawBits = 24;
+  auto draws = (fl::rand({2}) * (1 << kSeedDrawBits))
+                   .astype(fl::dtype::s64)
+                   .toHostVector<int64_t>();
+  return (static_cast<uint64_t>(draws[0]) << kSeedDrawBits) |
+      static_cast<uint64_t>(draws[1]);
+}
+
+// The rows [begin, end) of a tensor, or the tensor itself if they're all of
+// them, which saves copies when attention isn't packed
+Tensor attentionRows(const Tensor& tensor, const Dim begin, const Dim end) {
+  return begin == 0 && end == tensor.dim(0) ? tensor
+                                            : tensor(fl::range(begin, end));
+}
+
+void setAttentionRows(
+    Tensor& tensor,
+    const Dim begin,
+    const Dim end,
+    const Tensor& rows) {
+  if (begin == 0 && end == tensor.dim(0)) {
+    tensor = rows;
+  } else {
+    tensor(fl::range(begin, end)) = rows;
+  }
+}
+
+// The segment of each step of packed sequences given their offsets
+Tensor packedSegmentIds(const std::vector<int64_t>& segmentOffsets) {
+  std::vector<int> ids(segmentOffsets.back());
+  for (size_t i = 0; i + 1 < segmentOffsets.size(); ++i) {
+    std::fill(
+        ids.begin() + segmentOffsets[i],
+        ids.begin() + segmentOffsets[i + 1],
+        static_cast<int>(i));
+  }
+  return Tensor::fromVector(ids);
+}
+
+// The queries which attend to some of the keys in [begin, end): those of the
+// segments overlapping the keys for packed sequences, which are contiguous,
+// and those after the first key if causal, of which each has a key in the
+// range to attend to
+std::pair<Dim, Dim> attentionQueryRange(
+    const std::vector<int64_t>& segmentOffsets,
+    const bool causal,
+    const Dim begin,
+    const Dim end,
+    const Dim queryLen) {
+  Dim queryBegin = causal ? begin : 0;
+  Dim queryEnd = queryLen;
+  if (!segmentOffsets.empty()) {
+    // the last offset at or before a step starts its segment
+    auto first =
+        std::upper_bound(segmentOffsets.begin(), segmentOffsets.end(), begin);
+    auto last = std::upper_bound(
+        segmentOffsets.begin(), segmentOffsets.end(), end - 1);
+    queryBegin = std::max<Dim>(queryBegin, *std::prev(first));
+    queryEnd = *last;
+  }
+  return {queryBegin, queryEnd};
+}
+
+// The scores of the scaled queries in [queryBegin, queryEnd) for the keys in
+// [begin, end), with the mask added, and with the keys of other segments and
+// of the future masked for packed or causal attention, in the given type
+Tensor attentionScores(
+    const Tensor& scaledQuery,
+    const Tensor& key,
+    const Tensor& mask,
+    const Tensor& segmentIds,
+    const bool causal,
+    const Dim queryBegin,
+    const Dim queryEnd,
+    const Dim begin,
+    const Dim end,
+    const fl::dtype type) {
+  auto scores = fl::matmul(
+                    attentionRows(scaledQuery, queryBegin, queryEnd),
+                    key(fl::range(begin, end)),
+                    /* lhsProp = */ MatrixProperty::None,
+                    /* rhsProp = */ MatrixProperty::Transpose)
+                    .astype(type);
+  if (!mask.isEmpty()) {
+    auto tileMask = mask.dim(0) == 1
+        ? mask
+        : attentionRows(mask, queryBegin, queryEnd);
+    if (mask.dim(1) != 1) {
+      tileMask = tileMask(fl::span, fl::range(begin, end));
+    }
+    scores = scores + detail::tileAs(tileMask.astype(type), scores.shape());
+  }
+  if (segmentIds.isEmpty() && !causal) {
+    return scores;
+  }
+  const Dim nQueries = queryEnd - queryBegin;
+  const Dim nKeys = end - begin;
+  const Shape tileShape = {nQueries, nKeys};
+  Tensor attends;
+  if (!segmentIds.isEmpty()) {
+    attends = detail::tileAs(
+                  fl::reshape(
+                      segmentIds(fl::range(queryBegin, queryEnd)),
+                      {nQueries, 1}),
+                  tileShape) ==
+        detail::tileAs(
+            fl::reshape(segmentIds(fl::range(begin, end)), {1, nKeys}),
+            tileShape);
+  }
+  if (causal) {
+    auto past = fl::arange(tileShape, 1, fl::dtype::s64) + begin <=
+        fl::arange(tileShape, 0, fl::dtype::s64) + queryBegin;
+    attends = attends.isEmpty() ? past : attends && past;
+  }
+  return scores +
+      detail::tileAs(fl::log(attends.astype(type)), scores.shape());
+}
+
+// The scaled dropout mask of a tile of attention weights
+Tensor attentionDropoutMask(
+    const Shape& shape,
+    const double p,
+    RandomState& state,
+    const fl::dtype type) {
+  return (fl::rand(shape, state, type) > p).astype(type) / (1.0 - p);
+}
+
+} // namespace
+
+Variable scaledDotProductAttention(
+    const Variable& query,
+    const Variable& key,
+    const Variable& value,
+    const Variable& mask,
+    double pDropout /* = 0.0 */,
+    std::optional<double> scale /* = std::nullopt */,
+    const std::vector<int64_t>& segmentOffsets /* = {} */,
+    bool causal /* = false */) {
+  FL_PROFILE_OP("autograd::scaledDotProductAttention", query.tensor());
+  FL_VARIABLE_DTYPES_MATCH_CHECK(query, key, value);
+  if (query.ndim() != 3 || key.ndim() != 3 || value.ndim() != 3) {
+    throw std::invalid_argument(
+        "scaledDotProductAttention: query, key and value must have 3 "
+        "dimensions: Time x Dim x Batch");
+  }
+  const Dim queryLen = query.dim(0);
+  const Dim keyLen = key.dim(0);
+  const Dim valueDim = value.dim(1);
+  const Dim batch = query.dim(2);
+  if (key.dim(1) != query.dim(1) || value.dim(0) != keyLen ||
+      key.dim(2) != batch || value.dim(2) != batch) {
+    std::stringstream ss;
+    ss << "scaledDotProductAttention: incompatible query " << query.shape()
+       << ", key " << key.shape() << " and value " << value.shape();
+    throw std::invalid_argument(ss.str());
+  }
+  if (!mask.isEmpty()) {
+    const Shape scoresShape = {queryLen, keyLen, batch};
+    for (int i = 0; i < mask.ndim(); ++i) {
+      if (i >= 3 || (mask.dim(i) != 1 && mask.dim(i) != scoresShape[i])) {
+        std::stringstream ss;
+        ss << "scaledDotProductAttention: mask " << mask.shape()
+           << " doesn't broadcast to the scores " << scoresShape;
+        throw std::invalid_argument(ss.str());
+      }
+    }
+    if (mask.isCalcGrad()) {
+      throw std::invalid_argument(
+          "scaledDotProductAttention: the mask can't require gradients");
+    }
+  }
+  if (causal && queryLen != keyLen) {
+    throw std::invalid_argument(
+        "scaledDotProductAttention: causal attention requires queries and "
+        "keys of the same length");
+  }
+  Tensor segmentIds;
+  if (!segmentOffsets.empty()) {
+    if (queryLen != keyLen || segmentOffsets.front() != 0 ||
+        segmentOffsets.back() != keyLen ||
+        !std::is_sorted(segmentOffsets.begin(), segmentOffsets.end())) {
+      throw std::invalid_argument(
+          "scaledDotProductAttention: the segment offsets must increase from "
+          "0 to the length of the queries and keys");
+    }
+    segmentIds = packedSegmentIds(segmentOffsets);
+  }
+
+  const double scoresScale =
+      scale.value_or(1.0 / std::sqrt(static_cast<double>(query.dim(1))));
+  // the softmax is computed in full precision
+  const auto statsType =
+      query.type() == fl::dtype::f64 ? fl::dtype::f64 : fl::dtype::f32;
+  const uint64_t seed = pDropout > 0.0 ? drawDropoutSeed() : 0;
+
+  auto scaledQuery = query.tensor() * scoresScale;
+  auto maxScores = fl::full(
+      {queryLen, 1, batch}, std::numeric_limits<float>::lowest(), statsType);
+  auto sumExp = fl::full({queryLen, 1, batch}, 0.0, statsType);
+  auto output = fl::full({queryLen, valueDim, batch}, 0.0, statsType);
+  RandomState state(seed);
+  for (Dim begin = 0; begin < keyLen; begin += kAttentionTileSize) {
+    const Dim end = std::min(begin + kAttentionTileSize, keyLen);
+    const auto [queryBegin, queryEnd] =
+        attentionQueryRange(segmentOffsets, causal, begin, end, queryLen);
+    auto scores = attentionScores(
+        scaledQuery,
+        key.tensor(),
+        mask.tensor(),
+        segmentIds,
+        causal,
+        queryBegin,
+        queryEnd,
+        begin,
+        end,
+        statsType);
+    auto tileMaxScores = attentionRows(maxScores, queryBegin, queryEnd);
+    auto newMaxScores = fl::maximum(
+        tileMaxScores, fl::amax(scores, {1}, /* keepDims = */ true));
+    auto correction = fl::exp(tileMaxScores - newMaxScores);
+    auto weights =
+        fl::exp(scores - detail::tileAs(newMaxScores, scores.shape()));
+    setAttentionRows(
+        sumExp,
+        queryBegin,
+        queryEnd,
+        attentionRows(sumExp, queryBegin, queryEnd) * correction +
+            fl::sum(weights, {1}, /* keepDims = */ true));
+    if (pDropout > 0.0) {
+      weights = weights *
+          attentionDropoutMask(weights.shape(), pDropout, state, statsType);
+    }
+    auto tileOutput = attentionRows(output, queryBegin, queryEnd);
+    setAttentionRows(
+        output,
+        queryBegin,
+        queryEnd,
+        tileOutput * detail::tileAs(correction, tileOutput.shape()) +
+            fl::matmul(weights.astype(value.type()),
+                       value.tensor()(fl::range(begin, end)))
+                .astype(statsType));
+    setAttentionRows(maxScores, queryBegin, queryEnd, newMaxScores);
+  }
+  output = output / detail::tileAs(sumExp, output.shape());
+  auto logSumExp = maxScores + fl::log(sumExp);
+  fl::eval(output);
+  fl::eval(logSumExp);
+
+  auto gradFunc = [scoresScale,
+                   statsType,
+                   pDropout,
+                   seed,
+                   output,
+                   logSumExp,
+                   segmentOffsets,
+                   causal,
+                   segmentIds](
+                      std::vector<Variable>& inputs,
+                      const Variable& gradOutput) {
+    const auto& query = inputs[0].tensor();
+    const auto& key = inputs[1].tensor();
+    const auto& value = inputs[2].tensor();
+    const Dim keyLen = key.dim(0);
+    auto gradOut = gradOutput.tensor().astype(statsType);
+    // the gradient of the scores is `weights * (gradWeights - delta)`
+    auto delta = fl::sum(gradOut * output, {1}, /* keepDims = */ true);
+    auto scaledQuery = query * scoresScale;
+    auto gradQuery = fl::full(query.shape(), 0.0, statsType);
+    auto gradKey = fl::full(key.shape(), 0.0, statsType);
+    auto gradValue = fl::full(value.shape(), 0.0, statsType);
+    RandomState state(seed);
+    for (Dim begin = 0; begin < keyLen; begin += kAttentionTileSize) {
+      const Dim end = std::min(begin + kAttentionTileSize, keyLen);
+      const auto tile = fl::range(begin, end);
+      const auto [queryBegin, queryEnd] =
+          attentionQueryRange(
+              segmentOffsets, causal, begin, end, query.dim(0));
+      auto scores = attentionScores(
+          scaledQuery,
+          key,
+          inputs[3].tensor(),
+          segmentIds,
+          causal,
+          queryBegin,
+          queryEnd,
+          begin,
+          end,
+          statsType);
+      auto weights = fl::exp(
+          scores -
+          detail::tileAs(
+              attentionRows(logSumExp, queryBegin, queryEnd), scores.shape()));
+      auto tileGradOut = attentionRows(gradOut, queryBegin, queryEnd);
+      auto gradWeights = fl::matmul(
+          tileGradOut,
+          value(tile).astype(statsType),
+          /* lhsProp = */ MatrixProperty::None,
+          /* rhsProp = */ MatrixProperty::Transpose);
+      auto droppedWeights = weights;
+      if (pDropout > 0.0) {
+        auto dropoutMask =
+            attentionDropoutMask(weights.shape(), pDropout, state, statsType);
+        droppedWeights = weights * dropoutMask;
+        gradWeights = gradWeights * dropoutMask;
+      }
+      gradValue(tile) = fl::matmul(
+          droppedWeights,
+          tileGradOut,
+          /* lhsProp = */ MatrixProperty::Transpose);
+      auto gradScores = weights *
+          (gradWeights -
+           detail::tileAs(
+               attentionRows(delta, queryBegin, queryEnd), weights.shape()));
+      setAttentionRows(
+          gradQuery,
+          queryBegin,
+          queryEnd,
+          attentionRows(gradQuery, queryBegin, queryEnd) +
+              fl::matmul(gradScores, key(tile).astype(statsType)));
+      gradKey(tile) = fl::matmul(
+          gradScores,
+          attentionRows(scaledQuery, queryBegin, queryEnd).astype(statsType),
+          /* lhsProp = */ MatrixProperty::Transpose);
+    }
+    if (inputs[0].isCalcGrad()) {
+      inputs[0].addGrad(
+          Variable((gradQuery * scoresScale).astype(query.type()), false));
+    }
+    if (inputs[1].isCalcGrad()) {
+      inputs[1].addGrad(Variable(gradKey.astype(key.type()), false));
+    }
+    if (inputs[2].isCalcGrad()) {
+      inputs[2].addGrad(Variable(gradValue.astype(value.type()), false));
+    }
+  };
+  return Variable(
+      output.astype(query.type()), {query, key, value, mask}, gradFunc);
+}
+
 fl::Variable multiheadAttention(
     const fl::Variable& query,
     const fl::Variable& key,
@@ -1835,6 +2802,7 @@ fl::Variable multiheadAttention(
     const int32_t nHeads,
     const double pDropout,
     const int32_t offset /* = 0 */) {
+  FL_PROFILE_OP("autograd::multiheadAttention", query.tensor());
   if (query.ndim() != 3) {
     throw std::invalid_argument(
         "multiheadAttention - query input tensor should be 3 dimensions: "
@@ -1859,6 +2827,36 @@ fl::Variable multiheadAttention(
   auto k = moddims(key, {-1, headDim, nHeads * bsz});
   auto v = moddims(value, {-1, headDim, nHeads * bsz});
 
+  if (!padMask.isEmpty() && padMask.dim(0) != query.dim(0)) {
+    throw std::invalid_argument(
+        "multiheadAttention: invalid padding mask size");
+  }
+  if (posEmb.isEmpty()) {
+    // the attention weights of a relative positional embedding are computed
+    // in full, other attention doesn't materialize them
+    Variable scoresMask;
+    if (!mask.isEmpty()) {
+      scoresMask = mask.astype(q.type());
+    }
+    if (!padMask.isEmpty()) {
+      auto padMaskTile = moddims(
+          tileAs(
+              moddims(padMask, {1, padMask.dim(0), 1, bsz}),
+              {1, padMask.dim(0), nHeads, bsz}),
+          {1, padMask.dim(0), nHeads * bsz});
+      padMaskTile = padMaskTile.astype(q.type());
+      if (scoresMask.isEmpty()) {
+        scoresMask = padMaskTile;
+      } else {
+        const Shape scoresShape = {q.dim(0), k.dim(0), nHeads * bsz};
+        scoresMask =
+            tileAs(scoresMask, scoresShape) + tileAs(padMaskTile, scoresShape);
+      }
+    }
+    auto result = scaledDotProductAttention(q, k, v, scoresMask, pDropout);
+    return moddims(result, {-1, headDim * nHeads, bsz});
+  }
+
   q = q / std::sqrt(float(headDim));
   auto scores = matmulNT(q, k);
   if (!posEmb.isEmpty()) {
@@ -1872,10 +2870,6 @@ fl::Variable multiheadAttention(
     scores = scores + tileAs(mask.astype(scores.type()), scores);
   }
   if (!padMask.isEmpty()) {
-    if (padMask.dim(0) != query.dim(0)) {
-      throw std::invalid_argument(
-          "multiheadAttention: invalid padding mask size");
-    }
     auto padMaskTile = moddims(padMask, {1, padMask.dim(0), 1, bsz});
     padMaskTile =
         tileAs(padMaskTile, {padMask.dim(0), padMask.dim(0), nHeads, bsz});
@@ -8,9 +8,12 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "flashlight/fl/autograd/Autocast.h"
+#include "flashlight/fl/autograd/InferenceMode.h"
 #include "flashlight/fl/common/Defines.h"
 #include "flashlight/fl/common/Types.h"
 #include "flashlight/fl/common/Utils.h"
@@ -19,6 +22,7 @@
 namespace fl {
 
 class Variable;
+struct RandomState;
 
 namespace detail {
 
@@ -50,12 +54,17 @@ bool areVariableTypesEqual(
 }
 
 /**
- * Performs type conversion based on the optim level. Operations that lack
- * sufficient precision are automatically upcast to f32 before computation.
- * These are typically operations that require accumulations or reductions.
+ * Performs type conversion based on the autocast scope of the calling thread,
+ * if any (see `AutocastGuard`), or the optim level otherwise. Operations that
+ * lack sufficient precision are automatically upcast to f32 before
+ * computation. These are typically operations that require accumulations or
+ * reductions.
  */
 template <typename T>
 T adjustInputType(const T& in, const char* funcname) {
+  if (AutocastGuard::isEnabled()) {
+    return autocast(in, funcname);
+  }
   OptimLevel optimLevel = OptimMode::get().getOptimLevel();
   // Fastpath - DEFAULT mode never casts tensors
   if (optimLevel == OptimLevel::DEFAULT) {
@@ -67,11 +76,12 @@ T adjustInputType(const T& in, const char* funcname) {
   // TODO: tiny, but this lookup incurs an extra alloc from char* to string
   if (funcs.find(std::string(funcname)) == funcs.end() &&
       optimLevel != OptimLevel::DEFAULT) {
-    // Not in the excluded list - cast to f16
-    res = in.astype(fl::dtype::f16);
+    // Not in the excluded list - cast to f16 (or bf16)
+    res = in.astype(OptimMode::get().getHalfPrecisionType());
   } else {
-    // Upcast to f32 only if we have an f16 input - otherwise, leave as is
-    if (in.type() == fl::dtype::f16) {
+    // Upcast to f32 only if we have an f16 or bf16 input - otherwise, leave
+    // as is
+    if (isHalfPrecisionType(in.type())) {
       res = in.astype(fl::dtype::f32);
     } else {
       res = in;
@@ -83,7 +93,8 @@ T adjustInputType(const T& in, const char* funcname) {
 
 template <typename H, typename... T>
 std::shared_ptr<AutogradPayload> createAutogradPayload(H head, T... tail) {
-  return (head.isCalcGrad() || ... || tail.isCalcGrad())
+  return !InferenceModeGuard::isEnabled() &&
+          (head.isCalcGrad() || ... || tail.isCalcGrad())
       ? std::make_shared<AutogradPayload>()
       : nullptr;
 }
@@ -96,6 +107,13 @@ std::shared_ptr<AutogradPayload> createAutogradPayload(H head, T... tail) {
  */
 #define FL_ADJUST_INPUT_TYPE(INPUT) detail::adjustInputType(INPUT, __func__)
 
+/**
+ * Adjusts the input type to operators based on the autocast scope only, for
+ * operators the optimization mode leaves as is.
+ */
+#define FL_AUTOCAST_INPUT_TYPE(INPUT) \
+  (AutocastGuard::isEnabled() ? detail::autocast(INPUT, __func__) : INPUT)
+
 /**
  * Checks if a variadic number of Variables have the same types.
  */
@@ -646,6 +664,11 @@ linear(const Variable& input, const Variable& weight, const Variable& bias);
  * @param groups number of filter groups
  * @param benchmarks [optional] a `ConvBenchmarks` instance to use to
  * dynamically benchmark configuration attributes for computations.
+ * @param format the layout of the input, weights and output. The input,
+ * weights and output of a `MemoryFormat::CWHN` convolution have shapes
+ * [\f$C_{in}\f$, \f$X_{in}\f$, \f$Y_{in}\f$, \f$N\f$], [\f$C_{in}\f$,
+ * \f$K_x\f$, \f$K_y\f$, \f$C_{out}\f$] and [\f$C_{out}\f$, \f$X_{out}\f$,
+ * \f$Y_{out}\f$, \f$N\f$]
  * @return a Variable with shape [\f$X_{out}\f$, \f$Y_{out}\f$, \f$C_{out}\f$,
  * \f$N\f$]]
  */
@@ -659,7 +682,8 @@ Variable conv2d(
     int dx = 1,
     int dy = 1,
     int groups = 1,
-    std::shared_ptr<detail::ConvBenchmarks> benchmarks = nullptr);
+    std::shared_ptr<detail::ConvBenchmarks> benchmarks = nullptr,
+    MemoryFormat format = MemoryFormat::WHCN);
 
 /**
  * Applies a 2D convolution over an input signal given filter weights and
@@ -691,6 +715,11 @@ Variable conv2d(
  * @param groups number of filter groups
  * @param benchmarks [optional] a `ConvBenchmarks` instance to use to
  * dynamically benchmark configuration attributes for computations.
+ * @param format the layout of the input, weights and output. The input,
+ * weights and output of a `MemoryFormat::CWHN` convolution have shapes
+ * [\f$C_{in}\f$, \f$X_{in}\f$, \f$Y_{in}\f$, \f$N\f$], [\f$C_{in}\f$,
+ * \f$K_x\f$, \f$K_y\f$, \f$C_{out}\f$] and [\f$C_{out}\f$, \f$X_{out}\f$,
+ * \f$Y_{out}\f$, \f$N\f$]
  * @param bias a Variable with shape [\f$C_{out}\f$]
  * @return a Variable with shape [\f$X_{out}\f$, \f$Y_{out}\f$, \f$C_{out}\f$,
  * \f$N\f$]]
@@ -706,7 +735,8 @@ Variable conv2d(
     int dx = 1,
     int dy = 1,
     int groups = 1,
-    std::shared_ptr<detail::ConvBenchmarks> benchmarks = nullptr);
+    std::shared_ptr<detail::ConvBenchmarks> benchmarks = nullptr,
+    MemoryFormat format = MemoryFormat::WHCN);
 
 /**
  * Applies a 2D pooling over an input signal composed of several input planes.
@@ -724,6 +754,8 @@ Variable conv2d(
  * - MAX
  * - AVG_INCLUDE_PADDING
  * - AVG_EXCLUDE_PADDING
+ * @param format the layout of the input and output, of shape [\f$C\f$,
+ * \f$X\f$, \f$Y\f$, \f$N\f$] if `MemoryFormat::CWHN`
  */
 Variable pool2d(
     const Variable& input,
@@ -733,7 +765,8 @@ Variable pool2d(
     int sy = 1,
     int px = 0,
     int py = 0,
-    PoolingMode mode = PoolingMode::MAX);
+    PoolingMode mode = PoolingMode::MAX,
+    MemoryFormat format = MemoryFormat::WHCN);
 
 /**
  * Applies a softmax function on Variable `input` along dimension `dim`, so that
@@ -889,6 +922,34 @@ std::tuple<Variable, Variable, Variable> rnn(
     bool bidirectional,
     float dropout);
 
+/**
+ * Applies an RNN unit to a batch of sequences of different lengths, padded to
+ * the length of the input, without computing on the padding. Each sample only
+ * runs over its first `sequenceLengths[i]` steps: the output past them is
+ * zero, and the hidden and cell states are those after its last step, where
+ * the reverse direction of bidirectional RNNs also starts.
+ *
+ * Backends which support variable-length sequences, e.g. cuDNN, run them in
+ * one call, while the others, e.g. oneDNN, run the steps between consecutive
+ * lengths on the samples which are at least as long (or for bidirectional
+ * RNNs, the samples of each length separately).
+ *
+ * @param sequenceLengths the length of each sample, in [1, sequence length]
+ *
+ * See the overload without lengths for the other parameters and the outputs.
+ */
+std::tuple<Variable, Variable, Variable> rnn(
+    const Variable& input,
+    const Variable& hiddenState,
+    const Variable& cellState,
+    const Variable& weights,
+    const std::vector<int>& sequenceLengths,
+    int hiddenSize,
+    int numLayers,
+    RnnMode mode,
+    bool bidirectional,
+    float dropout);
+
 /**
  * Looks up embeddings in a fixed dictionary and size.
  * @param input a Variable of a list of indices with shape [\f$B_1\f$,
@@ -896,10 +957,16 @@ std::tuple<Variable, Variable, Variable> rnn(
  * @param embeddings a Variable of an embedding matrix with shape [\f$D\f$,
  * \f$N\f$], where \f$N\f$ is the number of items and \f$D\f$ is the embedding
  * size.
+ * @param sparseGrad whether the gradient of `embeddings` is row-sparse, i.e.
+ * only has the rows of the embeddings which are looked up. See
+ * `Variable::rowSparse`.
  * @return a Variable of embeddings with shape [\f$D\f$, \f$B_1\f$, \f$B_2\f$,
  * \f$B_3\f$]
  */
-Variable embedding(const Variable& input, const Variable& embeddings);
+Variable embedding(
+    const Variable& input,
+    const Variable& embeddings,
+    bool sparseGrad = false);
 
 /**
  * Applies Batch Normalization over a 4D input (a mini-batch of 2D inputs with
@@ -940,6 +1007,26 @@ Variable batchnorm(
     double momentum,
     double epsilon);
 
+/**
+ * Applies layer normalization over the first `numAxes` axes of `input`, in a
+ * single pass of the backend of its autograd extension. Only the mean and the
+ * reciprocal standard deviation of each slice are kept for the backward pass,
+ * which also takes a single pass.
+ *
+ * @param input the input Variable
+ * @param weight if non-empty, the scale of each element of a slice
+ * @param bias if non-empty, the shift of each element of a slice
+ * @param numAxes the number of leading axes to normalize along
+ * @param epsilon added to the variance for numerical stability
+ * @return the normalized Variable, with the same shape as `input`
+ */
+Variable layerNorm(
+    const Variable& input,
+    const Variable& weight,
+    const Variable& bias,
+    const int numAxes,
+    const double epsilon);
+
 /**
  * Applies asymmetric padding on a Variable `input`.
  * @param input input Variable
@@ -961,6 +1048,18 @@ Variable padding(
  */
 Variable dropout(const Variable& input, double p);
 
+/**
+ * Applies dropout on a Variable `input`, with a mask drawn from a
+ * counter-based generator, such that it's reproducible given `state`. See
+ * `RandomState`.
+ * @param input input Variable
+ * @param p the probability of dropout
+ * @param state the state of the generator, which is advanced by the number of
+ * elements of `input`
+ * @return a droped out Variable
+ */
+Variable dropout(const Variable& input, double p, RandomState& state);
+
 /**
  * Applies the [rectified linear
  * unit](https://en.wikipedia.org/wiki/Rectifier_(neural_networks)) function
@@ -969,6 +1068,30 @@ Variable dropout(const Variable& input, double p);
  */
 Variable relu(const Variable& input);
 
+/**
+ * Adds `rhs` to `lhs` in place, i.e. without allocating an output, e.g. for
+ * residual connections. `lhs` becomes the output in the computation graph,
+ * see `Variable::recordInPlace`; copies of it made before keep its value
+ * before the addition in the graph, but share the modified array.
+ * \f[ lhs = lhs + rhs \f]
+ * @return `lhs`
+ */
+Variable& addInPlace(Variable& lhs, const Variable& rhs);
+
+/**
+ * Multiplies each element of `input` by a scalar in place. See `addInPlace`.
+ * \f[ input_i = input_i \times scale \f]
+ * @return `input`
+ */
+Variable& scaleInPlace(Variable& input, double scale);
+
+/**
+ * Applies the rectified linear unit function element-wise to `input` in place.
+ * See `relu` and `addInPlace`.
+ * @return `input`
+ */
+Variable& reluInPlace(Variable& input);
+
 /**
  * Applies the [Gaussian Error linear
  * Unit](https://arxiv.org/abs/1606.08415) function
@@ -982,6 +1105,49 @@ Variable gelu(const Variable& input);
  */
 Variable relativePositionalEmbeddingRotate(const Variable& input);
 
+/**
+ * Scaled dot-product attention, `softmax(scale * query * key^T + mask) *
+ * value` with dropout on the attention weights, for batches of sequences,
+ * e.g. one per head and sample of multihead attention.
+ *
+ * The scores of the queries are computed for tiles of keys at a time, with
+ * the softmax computed online over the tiles as in [Dao et al
+ * (2022)](https://arxiv.org/abs/2205.14135). Rather than the full `Tq x Tk`
+ * attention weights of each sequence, only the inputs, the output and the
+ * softmax statistics of each query are kept for the backward pass, which
+ * recomputes the weights tile by tile, and the same dropout masks from a
+ * counter-based random number generator.
+ *
+ * @param query queries of size Tq x D x N
+ * @param key keys of size Tk x D x N
+ * @param value values of size Tk x Dv x N
+ * @param mask if non-empty, added to the scores, of size Tq x Tk x N where
+ * any dimension may be 1 to broadcast, e.g. Tq x Tk for a causal mask, or
+ * 1 x Tk x N for a padding mask. It doesn't receive gradients.
+ * @param pDropout dropout probability of the attention weights
+ * @param scale the scale of the scores, `1 / sqrt(D)` by default
+ * @param segmentOffsets if non-empty, the queries and keys are packed
+ * sequences concatenated along time, of which the i-th one spans the steps
+ * [segmentOffsets[i], segmentOffsets[i + 1]), e.g. from `fl::packBatch`, and
+ * which only attend to themselves. The block-diagonal mask isn't
+ * materialized: the scores of a tile of keys are only computed for the
+ * queries of the sequences it overlaps.
+ * @param causal if true, a query doesn't attend to the keys after it, as with
+ * a causal mask which isn't materialized, and the scores of a tile of keys
+ * aren't computed for the queries before it. It requires queries and keys of
+ * the same length.
+ * @return the attended values, of size Tq x Dv x N
+ */
+Variable scaledDotProductAttention(
+    const Variable& query,
+    const Variable& key,
+    const Variable& value,
+    const Variable& mask,
+    double pDropout = 0.0,
+    std::optional<double> scale = std::nullopt,
+    const std::vector<int64_t>& segmentOffsets = {},
+    bool causal = false);
+
 /**
  * Multihead Attention function
  * For details, see [Vaswani et al (2017)](https://arxiv.org/abs/1706.03762).
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/autograd/GradientArena.h"
+
+#include <stdexcept>
+#include <utility>
+
+#include "flashlight/fl/tensor/Index.h"
+
+namespace fl {
+
+namespace detail {
+
+void GradientArenaSlot::add(const Tensor& grad) {
+  auto flat = fl::reshape(grad, {shape.elements()});
+  auto slot = (*buffer)(fl::range(offset, offset + shape.elements()));
+  if (hasGrad) {
+    slot += flat;
+  } else {
+    slot = flat;
+    hasGrad = true;
+  }
+}
+
+Tensor GradientArenaSlot::get() const {
+  return fl::reshape(
+      (*buffer)(fl::range(offset, offset + shape.elements())), shape);
+}
+
+} // namespace detail
+
+GradientArena::GradientArena(const std::vector<Variable>& params) {
+  // lay out the slots by type first, then allocate each buffer once
+  std::map<fl::dtype, Dim> sizes;
+  for (const auto& param : params) {
+    if (param.sharedGrad_->arenaSlot) {
+      bool isDuplicate = false;
+      for (const auto& other : params_) {
+        isDuplicate |= other.sharedGrad_ == param.sharedGrad_;
+      }
+      if (isDuplicate) {
+        continue;
+      }
+      throw std::invalid_argument(
+          "[GradientArena::GradientArena] a parameter already belongs to a "
+          "gradient arena");
+    }
+    auto slot = std::make_shared<detail::GradientArenaSlot>();
+    slot->offset = sizes[param.type()];
+    slot->shape = param.shape();
+    sizes[param.type()] += param.elements();
+    buffers_[param.type()].slots.push_back(slot);
+    param.sharedGrad_->arenaSlot = std::move(slot);
+    params_.push_back(param);
+  }
+
+  for (auto& [type, buffer] : buffers_) {
+    buffer.data = std::make_shared<Tensor>(fl::full({sizes[type]}, 0, type));
+    for (auto& slot : buffer.slots) {
+      slot->buffer = buffer.data;
+    }
+  }
+  for (auto& param : params_) {
+    auto& grad = param.sharedGrad_->grad;
+    if (grad) {
+      param.sharedGrad_->arenaSlot->add(grad->tensor());
+      grad.reset();
+    }
+  }
+}
+
+GradientArena::~GradientArena() {
+  for (auto& param : params_) {
+    auto& sharedGrad = *param.sharedGrad_;
+    if (sharedGrad.arenaSlot->hasGrad && !sharedGrad.grad) {
+      sharedGrad.grad = std::make_unique<Variable>(
+          sharedGrad.arenaSlot->get().copy(), false);
+    }
+    sharedGrad.arenaSlot.reset();
+  }
+}
+
+std::vector<fl::dtype> GradientArena::types() const {
+  std::vector<fl::dtype> types;
+  for (const auto& [type, buffer] : buffers_) {
+    types.push_back(type);
+  }
+  return types;
+}
+
+Tensor& GradientArena::buffer(fl::dtype type) {
+  auto it = buffers_.find(type);
+  if (it == buffers_.end()) {
+    throw std::invalid_argument(
+        "[GradientArena::buffer] the arena has no parameters of type " +
+        dtypeToString(type));
+  }
+  for (auto& slot : it->second.slots) {
+    if (!slot->hasGrad) {
+      (*slot->buffer)(fl::range(slot->offset, slot->offset +
+                                    slot->shape.elements())) = 0;
+      slot->hasGrad = true;
+    }
+  }
+  // gradients are views of the buffer before it's modified
+  for (auto& param : params_) {
+    if (param.type() == type) {
+      param.sharedGrad_->grad.reset();
+    }
+  }
+  return *it->second.data;
+}
+
+void GradientArena::zeroGrad() {
+  for (auto& param : params_) {
+    param.zeroGrad();
+  }
+}
+
+size_t GradientArena::bytes() const {
+  size_t bytes = 0;
+  for (const auto& [type, buffer] : buffers_) {
+    bytes += buffer.data->bytes();
+  }
+  return bytes;
+}
+
+const std::vector<Variable>& GradientArena::params() const {
+  return params_;
+}
+
+std::shared_ptr<const Tensor> GradientArena::findBuffer(
+    const std::vector<Variable>& params) {
+  if (params.empty() || !params.front().sharedGrad_->arenaSlot) {
+    return nullptr;
+  }
+  const auto& buffer = params.front().sharedGrad_->arenaSlot->buffer;
+  Dim offset = 0;
+  for (const auto& param : params) {
+    const auto& slot = param.sharedGrad_->arenaSlot;
+    if (!slot || slot->buffer != buffer || slot->offset != offset ||
+        !slot->hasGrad) {
+      return nullptr;
+    }
+    offset += slot->shape.elements();
+  }
+  if (offset != buffer->elements()) {
+    return nullptr;
+  }
+  return buffer;
+}
+
+} // namespace fl
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+namespace detail {
+
+/**
+ * Where the gradient of a parameter lives in the buffer of a GradientArena.
+ */
+struct GradientArenaSlot {
+  std::shared_ptr<Tensor> buffer;
+  Dim offset;
+  Shape shape;
+  /// Whether the slot holds a gradient, or stale data
+  bool hasGrad{false};
+
+  /// Accumulates `grad` in the slot, overwriting stale data
+  void add(const Tensor& grad);
+  /// A view of the slot with the shape of the parameter
+  Tensor get() const;
+};
+
+} // namespace detail
+
+/**
+ * An opt-in storage of the gradients of parameters, in one preallocated flat
+ * buffer per type. While the arena exists, `Variable::addGrad` accumulates the
+ * gradients of its parameters in place in their slot of the buffer rather than
+ * in separately allocated tensors, and `Variable::grad` returns a view of the
+ * slot.
+ *
+ * Operations over all gradients, e.g. `allReduce(GradientArena&)` or
+ * `clipGradNorm(GradientArena&)`, then run over a few buffers, without
+ * gathering gradients into contiguous buffers first.
+ *
+ * Row-sparse gradients are added to the arena densely. Gradients obtained from
+ * `Variable::grad` and modified in place aren't written back to the arena, and
+ * are invalidated by the next update of the arena.
+ *
+ * Example:
+ * \code
+   fl::GradientArena arena(model.params());
+   for (auto& batch : dataset) {
+     auto loss = criterion(model(batch[0]), batch[1]);
+     arena.zeroGrad();
+     loss.backward();
+     fl::allReduce(arena, 1.0 / fl::getWorldSize());
+     fl::clipGradNorm(arena, maxNorm);
+     optimizer.step();
+   }
+ * \endcode
+ */
+class GradientArena {
+ public:
+  /**
+   * Allocates the buffers of the gradients of `params`, which may only belong
+   * to one arena at a time. Existing gradients are moved into the arena.
+   *
+   * @param[in] params the parameters whose gradients to store
+   */
+  explicit GradientArena(const std::vector<Variable>& params);
+
+  /**
+   * Moves the gradients of the parameters out of the arena, to separate
+   * tensors.
+   */
+  ~GradientArena();
+
+  // no copy/move
+  GradientArena(const GradientArena&) = delete;
+  GradientArena(GradientArena&&) = delete;
+  GradientArena& operator=(const GradientArena&) = delete;
+  GradientArena& operator=(GradientArena&&) = delete;
+
+  /**
+   * @return the types of the buffers, i.e. of the parameters
+   */
+  std::vector<fl::dtype> types() const;
+
+  /**
+   * Returns the flat buffer of the gradients of the parameters of the given
+   * type, which may be modified in place. Parameters without a gradient are
+   * given zero gradients, so that the buffer holds all gradients, and
+   * gradients previously obtained from `Variable::grad` are invalidated.
+   *
+   * @param[in] type the type of the buffer
+   * @return the buffer, a 1D tensor
+   */
+  Tensor& buffer(fl::dtype type);
+
+  /**
+   * Removes the gradients of all parameters, without writing to the buffers.
+   */
+  void zeroGrad();
+
+  /**
+   * @return the size of the buffers in bytes
+   */
+  size_t bytes() const;
+
+  /**
+   * @return the parameters whose gradients are in the arena
+   */
+  const std::vector<Variable>& params() const;
+
+  /**
+   * Returns the buffer of an arena if it holds the gradients of exactly
+   * `params`, in order, e.g. for an optimizer to read all gradients at once.
+   *
+   * @param[in] params the parameters whose gradients to find
+   * @return the buffer, or nullptr if there is none
+   */
+  static std::shared_ptr<const Tensor> findBuffer(
+      const std::vector<Variable>& params);
+
+ private:
+  struct Buffer {
+    std::shared_ptr<Tensor> data;
+    std::vector<std::shared_ptr<detail::GradientArenaSlot>> slots;
+  };
+
+  std::vector<Variable> params_;
+  std::map<fl::dtype, Buffer> buffers_;
+};
+
+} // namespace fl
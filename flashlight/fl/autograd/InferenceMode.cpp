@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/autograd/InferenceMode.h"
+
+namespace fl {
+
+namespace {
+
+thread_local bool inferenceModeEnabled = false;
+
+} // namespace
+
+InferenceModeGuard::InferenceModeGuard(bool enabled)
+    : prevEnabled_(inferenceModeEnabled) {
+  inferenceModeEnabled = enabled;
+}
+
+InferenceModeGuard::~InferenceModeGuard() {
+  inferenceModeEnabled = prevEnabled_;
+}
+
+bool InferenceModeGuard::isEnabled() {
+  return inferenceModeEnabled;
+}
+
+} // namespace fl
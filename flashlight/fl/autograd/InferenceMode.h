@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+namespace fl {
+
+/**
+ * An RAII scope in which autograd functions, called on the same thread, don't
+ * build the computation graph: their outputs are plain data Variables which
+ * don't require gradients, whose inputs and gradient functions aren't kept.
+ * Activations are thus released as soon as they aren't used anymore, and the
+ * host overhead of recording nodes, e.g. autograd payloads of the tensor
+ * backend, is skipped. This is for serving and decoding, where no backward
+ * pass follows.
+ *
+ * Variables which require gradients, e.g. parameters, may be modified in place
+ * within the scope.
+ *
+ * Example:
+ * \code
+   {
+     fl::InferenceModeGuard guard;
+     auto output = model(input); // output.isCalcGrad() is false
+   }
+ * \endcode
+ */
+class InferenceModeGuard {
+  const bool prevEnabled_;
+
+ public:
+  /**
+   * @param[in] enabled whether inference mode is enabled within the scope,
+   * e.g. false to build the graph within an enclosing scope.
+   */
+  explicit InferenceModeGuard(bool enabled = true);
+  ~InferenceModeGuard();
+
+  /**
+   * @return whether inference mode is enabled on the calling thread.
+   */
+  static bool isEnabled();
+
+  // no copy/move
+  InferenceModeGuard(const InferenceModeGuard&) = delete;
+  InferenceModeGuard(InferenceModeGuard&&) = delete;
+  InferenceModeGuard& operator=(const InferenceModeGuard&) = delete;
+  InferenceModeGuard& operator=(InferenceModeGuard&&) = delete;
+};
+
+} // namespace fl
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/autograd/SavedMemoryProfile.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+#include "flashlight/fl/autograd/ActivationOffload.h"
+
+namespace fl {
+
+namespace {
+
+// the modules running on this thread, each with the path of its parents
+thread_local std::vector<std::string> moduleStack;
+
+std::string demangle(const char* name) {
+#if defined(__GNUG__)
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if (status == 0 && demangled) {
+    std::string result(demangled);
+    std::free(demangled);
+    return result;
+  }
+#endif
+  return name;
+}
+
+// The function which defines a gradient function, e.g. "fl::tanh" from
+// "fl::tanh(fl::Variable const&)::{lambda(...)#1}", or the gradient function
+// itself if it isn't a lambda
+std::string opName(const Variable::GradFunc& gradFunc) {
+  auto name = demangle(gradFunc.target_type().name());
+  // unwrap gradient functions allocated from the pool
+  const std::string pooled = "fl::detail::PooledGradFunc<";
+  if (name.compare(0, pooled.size(), pooled) == 0 && name.back() == '>') {
+    name = name.substr(pooled.size(), name.size() - pooled.size() - 1);
+  }
+  for (const char* lambda : {"::{lambda", "::$_"}) {
+    auto pos = name.find(lambda);
+    if (pos != std::string::npos) {
+      name.resize(pos);
+      // drop the argument list, e.g. of "fl::Variable::operator()(...)"
+      const std::string callOperator = "operator()";
+      auto opPos = name.find(callOperator);
+      auto args = name.find(
+          '(',
+          opPos == std::string::npos ? 0 : opPos + callOperator.size());
+      return name.substr(0, args);
+    }
+  }
+  return name;
+}
+
+std::string formatBytes(size_t bytes) {
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(2);
+  if (bytes >= (1UL << 30)) {
+    ss << static_cast<double>(bytes) / (1UL << 30) << " GiB";
+  } else if (bytes >= (1UL << 20)) {
+    ss << static_cast<double>(bytes) / (1UL << 20) << " MiB";
+  } else if (bytes >= (1UL << 10)) {
+    ss << static_cast<double>(bytes) / (1UL << 10) << " KiB";
+  } else {
+    ss << bytes << " B";
+  }
+  return ss.str();
+}
+
+} // namespace
+
+std::vector<SavedMemoryProfile::Entry> SavedMemoryProfile::entries() const {
+  std::vector<Entry> entries;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [key, entry] : entries_) {
+      entries.push_back(entry);
+    }
+  }
+  std::stable_sort(
+      entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.bytes > b.bytes;
+      });
+  return entries;
+}
+
+std::vector<std::pair<std::string, size_t>> SavedMemoryProfile::moduleBytes()
+    const {
+  std::map<std::string, size_t> bytes;
+  for (const auto& entry : entries()) {
+    bytes[entry.module] += entry.bytes;
+  }
+  std::vector<std::pair<std::string, size_t>> result(
+      bytes.begin(), bytes.end());
+  std::stable_sort(
+      result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.second > b.second;
+      });
+  return result;
+}
+
+size_t SavedMemoryProfile::totalBytes() const {
+  size_t bytes = 0;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& [key, entry] : entries_) {
+    bytes += entry.bytes;
+  }
+  return bytes;
+}
+
+void SavedMemoryProfile::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  counted_.clear();
+}
+
+std::string SavedMemoryProfile::prettyString() const {
+  const auto entries = this->entries();
+  std::ostringstream ss;
+  ss << "Saved memory: " << formatBytes(totalBytes()) << "\n";
+  for (const auto& [module, bytes] : moduleBytes()) {
+    ss << (module.empty() ? "(no module)" : module) << ": "
+       << formatBytes(bytes) << "\n";
+    for (const auto& entry : entries) {
+      if (entry.module == module) {
+        ss << "\t" << entry.op << ": " << formatBytes(entry.bytes) << " ("
+           << entry.nodes << (entry.nodes == 1 ? " node" : " nodes")
+           << ", outputs " << formatBytes(entry.outputBytes) << ")\n";
+      }
+    }
+  }
+  return ss.str();
+}
+
+SavedMemoryProfileScope::SavedMemoryProfileScope(SavedMemoryProfile& profile)
+    : prevProfile_(detail::SavedMemoryProfiler::getInstance().profile()) {
+  detail::SavedMemoryProfiler::getInstance().setProfile(&profile);
+}
+
+SavedMemoryProfileScope::~SavedMemoryProfileScope() {
+  detail::SavedMemoryProfiler::getInstance().setProfile(prevProfile_);
+}
+
+namespace detail {
+
+SavedMemoryProfiler& SavedMemoryProfiler::getInstance() {
+  // never destroyed, since Variables may outlive static destruction
+  static auto* instance = new SavedMemoryProfiler();
+  return *instance;
+}
+
+bool SavedMemoryProfiler::isEnabled() const {
+  return profile_.load() != nullptr;
+}
+
+SavedMemoryProfile* SavedMemoryProfiler::profile() const {
+  return profile_.load();
+}
+
+void SavedMemoryProfiler::setProfile(SavedMemoryProfile* profile) {
+  profile_.store(profile);
+}
+
+void SavedMemoryProfiler::record(const Variable& var) {
+  auto* profile = profile_.load();
+  if (!profile) {
+    return;
+  }
+  const auto op = opName(var.sharedGrad_->gradFunc);
+  const std::string module = moduleStack.empty() ? "" : moduleStack.back();
+
+  std::lock_guard<std::mutex> lock(profile->mutex_);
+  size_t bytes = 0;
+  for (const auto& input : var.sharedGrad_->inputs) {
+    const auto& data = input.sharedData_;
+    // placeholders of inputs whose data isn't needed, see withoutData
+    if (!data->offloadable) {
+      continue;
+    }
+    auto [iter, inserted] = profile->counted_.emplace(data.get(), data);
+    if (!inserted) {
+      if (!iter->second.expired()) {
+        continue;
+      }
+      // the address of destroyed data is reused
+      iter->second = data;
+    }
+    bytes += data->offloaded ? data->offloaded->bytes : data->data.bytes();
+  }
+  auto& entry = profile->entries_[{module, op}];
+  entry.module = module;
+  entry.op = op;
+  ++entry.nodes;
+  entry.bytes += bytes;
+  entry.outputBytes += var.sharedData_->data.bytes();
+}
+
+void SavedMemoryProfiler::pushModule(const std::string& name) {
+  moduleStack.push_back(
+      moduleStack.empty() ? name : moduleStack.back() + " / " + name);
+}
+
+void SavedMemoryProfiler::popModule() {
+  moduleStack.pop_back();
+}
+
+} // namespace detail
+
+} // namespace fl
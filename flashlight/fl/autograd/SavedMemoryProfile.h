@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/autograd/Variable.h"
+
+namespace fl {
+
+namespace detail {
+class SavedMemoryProfiler;
+} // namespace detail
+
+/**
+ * The device memory retained by the autograd graph for the backward pass,
+ * attributed to the ops which created its nodes and the modules whose forward
+ * pass created them, as recorded by a `SavedMemoryProfileScope`.
+ */
+class SavedMemoryProfile {
+ public:
+  struct Entry {
+    /// The module, see `Module::prettyString`, nested modules separated by
+    /// " / ", or empty outside of modules
+    std::string module;
+    /// The autograd function which created the nodes, e.g. "fl::tanh"
+    std::string op;
+    /// The number of nodes
+    size_t nodes{0};
+    /// The bytes of the inputs the nodes save. Saved inputs are counted once,
+    /// by the first node saving them
+    size_t bytes{0};
+    /// The bytes of the outputs of the nodes. Gradient functions may capture
+    /// their output, e.g. `fl::tanh`, which this bounds
+    size_t outputBytes{0};
+  };
+
+  /**
+   * @return the entries, sorted by decreasing bytes
+   */
+  std::vector<Entry> entries() const;
+
+  /**
+   * @return the bytes of the entries of each module, sorted by decreasing bytes
+   */
+  std::vector<std::pair<std::string, size_t>> moduleBytes() const;
+
+  /**
+   * @return the bytes of all entries
+   */
+  size_t totalBytes() const;
+
+  /**
+   * Removes all entries.
+   */
+  void clear();
+
+  /**
+   * @return a table of the entries, per module, sorted by decreasing bytes
+   */
+  std::string prettyString() const;
+
+ private:
+  friend class detail::SavedMemoryProfiler;
+
+  // keyed by module then op
+  std::map<std::pair<std::string, std::string>, Entry> entries_;
+  // the data already counted, which may have been destroyed since
+  std::map<const void*, std::weak_ptr<const void>> counted_;
+  mutable std::mutex mutex_;
+};
+
+/**
+ * An RAII scope in which the nodes added to the autograd graph are recorded
+ * in a `SavedMemoryProfile`, with the bytes of the inputs they save for the
+ * backward pass. This tells which ops and modules dominate activation memory,
+ * e.g. where to apply `Checkpoint`.
+ *
+ * Only the inputs and outputs of nodes are inspected: tensors captured by
+ * gradient functions, e.g. autograd payloads of the tensor backend, aren't
+ * counted. The memory of nodes is attributed to the innermost module running
+ * `Module::operator()`, or run by `Sequential`, on the calling thread.
+ *
+ * Example:
+ * \code
+   fl::SavedMemoryProfile profile;
+   {
+     fl::SavedMemoryProfileScope scope(profile);
+     auto output = model(input);
+   }
+   std::cout << profile.prettyString();
+ * \endcode
+ */
+class SavedMemoryProfileScope {
+  SavedMemoryProfile* const prevProfile_;
+
+ public:
+  /**
+   * @param[in] profile where to record the nodes, which should outlive the
+   * scope.
+   */
+  explicit SavedMemoryProfileScope(SavedMemoryProfile& profile);
+  ~SavedMemoryProfileScope();
+
+  // no copy/move
+  SavedMemoryProfileScope(const SavedMemoryProfileScope&) = delete;
+  SavedMemoryProfileScope(SavedMemoryProfileScope&&) = delete;
+  SavedMemoryProfileScope& operator=(const SavedMemoryProfileScope&) = delete;
+  SavedMemoryProfileScope& operator=(SavedMemoryProfileScope&&) = delete;
+};
+
+namespace detail {
+
+/**
+ * Records the nodes added to the autograd graph in the profile of the active
+ * SavedMemoryProfileScope, and the modules running on each thread.
+ */
+class SavedMemoryProfiler {
+ public:
+  static SavedMemoryProfiler& getInstance();
+
+  /**
+   * @return whether nodes are currently recorded.
+   */
+  bool isEnabled() const;
+
+  SavedMemoryProfile* profile() const;
+  void setProfile(SavedMemoryProfile* profile);
+
+  /**
+   * Record the node of `var`, an output of an autograd function.
+   */
+  void record(const Variable& var);
+
+  /**
+   * Attribute the nodes recorded on the calling thread to the given module,
+   * nested in the current one, until `popModule`.
+   */
+  void pushModule(const std::string& name);
+  void popModule();
+
+ private:
+  SavedMemoryProfiler() = default;
+
+  std::atomic<SavedMemoryProfile*> profile_{nullptr};
+};
+
+} // namespace detail
+
+} // namespace fl
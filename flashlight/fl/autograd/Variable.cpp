@@ -11,18 +11,96 @@
 #include <cassert>
 #include <functional>
 #include <memory>
+#include <sstream>
 #include <stdexcept>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 
+#include "flashlight/fl/autograd/ActivationOffload.h"
 #include "flashlight/fl/autograd/Functions.h"
+#include "flashlight/fl/autograd/GradientArena.h"
+#include "flashlight/fl/autograd/SavedMemoryProfile.h"
 #include "flashlight/fl/common/Utils.h"
 #include "flashlight/fl/tensor/Compute.h"
 #include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/Profile.h"
 #include "flashlight/fl/tensor/Shape.h"
 
 namespace fl {
 
+namespace detail {
+
+struct RowSparseData {
+  Tensor indices;
+  Tensor values;
+  Shape shape;
+  /// Whether `indices` are sorted and unique
+  bool coalesced{false};
+};
+
+} // namespace detail
+
+namespace {
+
+// Sorts the indices of a row-sparse Variable and sums the values of repeated
+// ones
+void coalesce(detail::RowSparseData& sparse) {
+  if (sparse.coalesced) {
+    return;
+  }
+  const Dim size = sparse.indices.elements();
+  if (size > 1) {
+    Tensor sorted, order;
+    fl::sort(sorted, order, sparse.indices, 0);
+    // 1 for the first of each run of equal indices
+    auto isFirst = fl::concatenate(
+        0,
+        fl::full({1}, 1, fl::dtype::s32),
+        (sorted(fl::range(1, size)) != sorted(fl::range(0, size - 1)))
+            .astype(fl::dtype::s32));
+    auto runs = fl::cumsum(isFirst, 0) - 1;
+    auto unique = sorted(fl::nonzero(isFirst));
+
+    // Sums the values of each run, as a sparse [size, runs] matrix product
+    auto sp = Tensor(
+        size,
+        unique.elements(),
+        fl::full({size}, 1, sparse.values.type()),
+        fl::arange({size + 1}, 0, fl::dtype::s32),
+        runs.astype(fl::dtype::s32),
+        fl::StorageType::CSR);
+    sparse.values = transpose(fl::matmul(
+        sp,
+        transpose(sparse.values(fl::span, order)),
+        /* lhsProp = */ MatrixProperty::Transpose));
+    sparse.indices = unique;
+  }
+  sparse.coalesced = true;
+}
+
+Tensor toDense(detail::RowSparseData& sparse) {
+  coalesce(sparse);
+  auto dense = fl::full(sparse.shape, 0, sparse.values.type());
+  if (!sparse.indices.isEmpty()) {
+    dense(fl::span, sparse.indices) = sparse.values;
+  }
+  return dense;
+}
+
+} // namespace
+
+Variable::SharedData::~SharedData() {
+  if (saved || offloaded) {
+    detail::ActivationOffloader::getInstance().release(this);
+  }
+}
+
+Variable::Variable(
+    std::shared_ptr<SharedData> sharedData,
+    std::shared_ptr<SharedGrad> sharedGrad)
+    : sharedData_(std::move(sharedData)), sharedGrad_(std::move(sharedGrad)) {}
+
 Variable::Variable(Tensor data, bool calcGrad) {
   sharedData_->data = std::move(data);
   sharedGrad_->calcGrad = calcGrad;
@@ -33,16 +111,97 @@ Variable::Variable(
     std::vector<Variable> inputs,
     GradFunc gradFunc) {
   sharedData_->data = std::move(data);
+  setGradFunc(std::move(inputs), std::move(gradFunc));
+}
+
+void Variable::setGradFunc(std::vector<Variable> inputs, GradFunc gradFunc) {
+  if (InferenceModeGuard::isEnabled()) {
+    return;
+  }
   if (std::any_of(inputs.begin(), inputs.end(), [](const Variable& input) {
         return input.isCalcGrad();
       })) {
     sharedGrad_->calcGrad = true;
+    sharedGrad_->inputVersions.reserve(inputs.size());
+    for (const auto& input : inputs) {
+      sharedGrad_->inputVersions.push_back(input.sharedData_->version);
+    }
     sharedGrad_->inputs = std::move(inputs);
+#if FL_BUILD_PROFILING
+    // the gradient is timed as that of the innermost op, e.g. the autograd
+    // function creating this Variable
+    if (OpProfiler::getInstance().isEnabled()) {
+      if (auto op = OpProfiler::getInstance().currentRange()) {
+        gradFunc = [name = op->first + " backward",
+                    shape = op->second,
+                    gradFunc = std::move(gradFunc)](
+                       std::vector<Variable>& inputs,
+                       const Variable& gradOutput) {
+          OpProfileRange range(name, shape, &gradOutput.tensor().stream());
+          gradFunc(inputs, gradOutput);
+        };
+      }
+    }
+#endif
     sharedGrad_->gradFunc = std::move(gradFunc);
+    auto& offloader = detail::ActivationOffloader::getInstance();
+    if (offloader.isEnabled()) {
+      for (const auto& input : sharedGrad_->inputs) {
+        offloader.save(input);
+      }
+    }
+    auto& profiler = detail::SavedMemoryProfiler::getInstance();
+    if (profiler.isEnabled()) {
+      profiler.record(*this);
+    }
+  }
+}
+
+uint64_t Variable::version() const {
+  return sharedData_->version;
+}
+
+void Variable::recordInPlace(std::vector<Variable> inputs, GradFunc gradFunc) {
+  if (InferenceModeGuard::isEnabled()) {
+    // nodes saving the array before must still detect the modification
+    ++sharedData_->version;
+    return;
+  }
+  if (sharedGrad_->calcGrad && !sharedGrad_->gradFunc) {
+    throw std::invalid_argument(
+        "Variable::recordInPlace: a leaf Variable which requires gradients "
+        "can't be modified in place");
+  }
+  // inputs which are copies of this Variable are saved at the new version
+  ++sharedData_->version;
+  sharedGrad_ = std::allocate_shared<SharedGrad>(PoolAllocator<SharedGrad>());
+  setGradFunc(std::move(inputs), std::move(gradFunc));
+}
+
+Variable Variable::rowSparse(
+    Tensor indices,
+    Tensor values,
+    const Shape& shape,
+    bool calcGrad /* = false */) {
+  const Dim numRows = indices.elements();
+  if (shape.ndim() != 2 || values.elements() != shape[0] * numRows) {
+    std::stringstream ss;
+    ss << "Variable::rowSparse: values with shape " << values.shape()
+       << " don't match " << numRows
+       << " rows of a matrix with shape " << shape;
+    throw std::invalid_argument(ss.str());
   }
+  Variable var(Tensor(values.type()), calcGrad);
+  auto sparse = std::make_shared<detail::RowSparseData>();
+  sparse->indices = indices.flatten().astype(fl::dtype::s32);
+  sparse->values = fl::reshape(values, {shape[0], numRows});
+  sparse->shape = shape;
+  var.sharedData_->sparse = std::move(sparse);
+  return var;
 }
 
 Variable Variable::operator()(const std::vector<Index>& indices) const {
+  FL_PROFILE_OP("autograd::index", tensor());
   auto result = tensor()(indices);
   auto inDims = shape();
   auto inType = type();
@@ -62,6 +221,7 @@ Variable Variable::operator()(const std::vector<Index>& indices) const {
 }
 
 Variable Variable::flat(const fl::Index& index) const {
+  FL_PROFILE_OP("autograd::flat", tensor());
   auto result = tensor().flat(index);
   auto inDims = shape();
   auto inType = type();
@@ -81,10 +241,40 @@ Variable Variable::flat(const fl::Index& index) const {
 }
 
 Tensor& Variable::tensor() const {
+  if (sharedData_->offloaded) {
+    detail::ActivationOffloader::getInstance().restore(*sharedData_);
+  }
+  if (sharedData_->sparse) {
+    sharedData_->data = toDense(*sharedData_->sparse);
+    sharedData_->sparse.reset();
+  }
   return sharedData_->data;
 }
 
+bool Variable::isRowSparse() const {
+  return sharedData_->sparse != nullptr;
+}
+
+Tensor& Variable::sparseIndices() const {
+  if (!sharedData_->sparse) {
+    throw std::logic_error(
+        "Variable::sparseIndices: the Variable isn't row-sparse");
+  }
+  coalesce(*sharedData_->sparse);
+  return sharedData_->sparse->indices;
+}
+
+Tensor& Variable::sparseValues() const {
+  if (!sharedData_->sparse) {
+    throw std::logic_error(
+        "Variable::sparseValues: the Variable isn't row-sparse");
+  }
+  coalesce(*sharedData_->sparse);
+  return sharedData_->sparse->values;
+}
+
 Variable Variable::astype(fl::dtype newType) const {
+  FL_PROFILE_OP("autograd::astype", tensor());
   auto output = tensor().astype(newType);
   auto gradFunc = [](std::vector<Variable>& inputs,
                      const Variable& gradOutput) {
@@ -100,6 +290,10 @@ Variable& Variable::grad() const {
     throw std::logic_error("gradient calculation disabled for this Variable");
   }
 
+  const auto& slot = sharedGrad_->arenaSlot;
+  if (!sharedGrad_->grad && slot && slot->hasGrad) {
+    sharedGrad_->grad = std::make_unique<Variable>(slot->get(), false);
+  }
   if (!sharedGrad_->grad) {
     throw std::logic_error("gradient not calculated yet for this Variable");
   }
@@ -119,14 +313,28 @@ bool Variable::isGradAvailable() const {
   if (!sharedGrad_->calcGrad) {
     return false;
   }
-  return sharedGrad_->grad != nullptr;
+  const auto& slot = sharedGrad_->arenaSlot;
+  return sharedGrad_->grad != nullptr || (slot && slot->hasGrad);
 }
 
 Shape Variable::shape() const {
+  // avoid restoring offloaded tensors for their metadata only
+  if (sharedData_->offloaded) {
+    return sharedData_->offloaded->shape;
+  }
+  if (sharedData_->sparse) {
+    return sharedData_->sparse->shape;
+  }
   return tensor().shape();
 }
 
 bool Variable::isEmpty() const {
+  if (sharedData_->offloaded) {
+    return false; // only non-empty tensors are offloaded
+  }
+  if (sharedData_->sparse) {
+    return sharedData_->sparse->shape.elements() == 0;
+  }
   return tensor().isEmpty();
 }
 
@@ -142,23 +350,36 @@ Variable Variable::asContiguous() const {
 }
 
 fl::dtype Variable::type() const {
+  if (sharedData_->offloaded) {
+    return sharedData_->offloaded->type;
+  }
+  if (sharedData_->sparse) {
+    return sharedData_->sparse->values.type();
+  }
   return tensor().type();
 }
 
 Dim Variable::elements() const {
-  return tensor().elements();
+  return shape().elements();
 }
 
 size_t Variable::bytes() const {
+  if (sharedData_->offloaded) {
+    return sharedData_->offloaded->bytes;
+  }
+  if (sharedData_->sparse) {
+    return sharedData_->sparse->indices.bytes() +
+        sharedData_->sparse->values.bytes();
+  }
   return tensor().bytes();
 }
 
 unsigned Variable::ndim() const {
-  return tensor().ndim();
+  return shape().ndim();
 }
 
 Dim Variable::dim(unsigned dim) const {
-  return tensor().dim(dim);
+  return shape().dim(dim);
 }
 
 void Variable::eval() const {
@@ -167,6 +388,9 @@ void Variable::eval() const {
 
 void Variable::zeroGrad() {
   sharedGrad_->grad.reset();
+  if (sharedGrad_->arenaSlot) {
+    sharedGrad_->arenaSlot->hasGrad = false;
+  }
 }
 
 void Variable::setCalcGrad(bool calcGrad) {
@@ -174,7 +398,8 @@ void Variable::setCalcGrad(bool calcGrad) {
   if (!calcGrad) {
     sharedGrad_->gradFunc = nullptr;
     sharedGrad_->inputs.clear();
-    sharedGrad_->grad.reset();
+    sharedGrad_->inputVersions.clear();
+    zeroGrad();
   }
 }
 
@@ -198,7 +423,30 @@ void Variable::addGrad(const Variable& childGrad) {
          << childGrad.shape() << std::endl;
       throw std::invalid_argument(ss.str());
     }
-    if (sharedGrad_->grad) {
+    if (sharedGrad_->arenaSlot) {
+      // Accumulate in place in the arena, of which `grad` would be a stale
+      // view
+      sharedGrad_->grad.reset();
+      sharedGrad_->arenaSlot->add(childGrad.tensor());
+    } else if (sharedGrad_->grad && sharedGrad_->grad->isRowSparse() &&
+               childGrad.isRowSparse()) {
+      // Rows are summed once coalesced
+      const auto& sparse = *sharedGrad_->grad->sharedData_->sparse;
+      const auto& childSparse = *childGrad.sharedData_->sparse;
+      sharedGrad_->grad = std::make_unique<Variable>(Variable::rowSparse(
+          fl::concatenate(0, sparse.indices, childSparse.indices),
+          fl::concatenate(1, sparse.values, childSparse.values),
+          sparse.shape));
+    } else if (sharedGrad_->grad && (sharedGrad_->grad->isRowSparse() ||
+                                     childGrad.isRowSparse())) {
+      // Add the rows to a copy of the dense gradient
+      const bool isChildSparse = childGrad.isRowSparse();
+      const auto& sparse = isChildSparse ? childGrad : *sharedGrad_->grad;
+      Tensor sum = isChildSparse ? sharedGrad_->grad->tensor()
+                                 : childGrad.tensor();
+      sum(fl::span, sparse.sparseIndices()) += sparse.sparseValues();
+      sharedGrad_->grad = std::make_unique<Variable>(std::move(sum), false);
+    } else if (sharedGrad_->grad) {
       // Prevent increment of array refcount to avoid a copy
       // if getting a device pointer. See
       // https://git.io/fp9oM for more
@@ -223,8 +471,8 @@ void Variable::clearGradHook() {
 
 void Variable::applyGradHook() {
   if (sharedGrad_->onGradAvailable) {
-    assert(sharedGrad_->grad);
-    sharedGrad_->onGradAvailable(*sharedGrad_->grad);
+    assert(isGradAvailable());
+    sharedGrad_->onGradAvailable(grad());
   }
 }
 
@@ -234,17 +482,52 @@ void Variable::calcGradInputs(bool retainGraph) {
       throw std::logic_error("gradient was not propagated to this Variable");
     }
 
+    const auto& inputs = sharedGrad_->inputs;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (inputs[i].sharedData_->version != sharedGrad_->inputVersions[i]) {
+        throw std::logic_error(
+            "Variable::backward: an input saved for the gradient computation "
+            "was modified in place after it was saved");
+      }
+    }
     sharedGrad_->gradFunc(sharedGrad_->inputs, *sharedGrad_->grad);
   }
   if (!retainGraph) {
     sharedGrad_->inputs.clear();
+    sharedGrad_->inputVersions.clear();
   }
 }
 
 void Variable::backward(const Variable& grad, bool retainGraph) {
   addGrad(grad);
   auto dag = build();
+  propagateGrads(dag, retainGraph);
+}
+
+void Variable::backward(
+    const Variable& grad,
+    BackwardCache& cache,
+    bool retainGraph) {
+  addGrad(grad);
+  auto dag = build(cache);
+  propagateGrads(dag, retainGraph);
+}
+
+void Variable::propagateGrads(DAG& dag, bool retainGraph) {
+  auto& offloader = detail::ActivationOffloader::getInstance();
+  const size_t prefetchDistance = offloader.prefetchDistance();
   for (auto iter = dag.rbegin(); iter != dag.rend(); iter++) {
+    // bring offloaded activations back ahead of their use, so that their
+    // copies overlap with the computation of the nodes in between
+    if (offloader.numOffloaded() > 0) {
+      const bool first = iter == dag.rbegin();
+      const auto last = std::min(
+          static_cast<size_t>(std::distance(iter, dag.rend())) - 1,
+          prefetchDistance);
+      for (size_t ahead = first ? 0 : last; ahead <= last; ++ahead) {
+        offloader.prefetchInputs(*(iter + ahead));
+      }
+    }
     iter->calcGradInputs(retainGraph);
     iter->applyGradHook();
     if (!retainGraph) {
@@ -258,12 +541,23 @@ void Variable::backward(bool retainGraph) {
   backward(ones, retainGraph);
 }
 
+void Variable::backward(BackwardCache& cache, bool retainGraph) {
+  auto ones = Variable(fl::full(shape(), 1, this->type()), false);
+  backward(ones, cache, retainGraph);
+}
+
 Variable Variable::withoutData() const {
-  Variable other;
-  other.sharedGrad_ = sharedGrad_;
+  if (InferenceModeGuard::isEnabled()) {
+    // inputs aren't kept, so there's no data to release
+    return *this;
+  }
+  Variable other(
+      std::allocate_shared<SharedData>(PoolAllocator<SharedData>()),
+      sharedGrad_);
   // Ensure the type of the underlying [but empty] Tensor data is of the same
   // type and shape
   other.tensor() = Tensor(shape(), this->type());
+  other.sharedData_->offloadable = false;
   return other;
 }
 
@@ -289,4 +583,76 @@ Variable::DAG Variable::build() const {
   return dag;
 }
 
+Variable::DAG Variable::build(BackwardCache& cache) const {
+  const auto& offsets = cache.inputOffsets_;
+  const auto& positions = cache.inputPositions_;
+  if (!offsets.empty()) {
+    // Walk the graph in reverse cached order: each node is placed by the
+    // first node consuming it, which comes after it
+    const size_t numNodes = offsets.size() - 1;
+    DAG dag(numNodes);
+    std::vector<SharedGrad*> ids(numNodes, nullptr);
+    dag.back() = *this;
+    ids.back() = sharedGrad_.get();
+    bool matches = true;
+    for (size_t i = numNodes; i-- > 0 && matches;) {
+      const auto& inputs = dag[i].getInputs();
+      if (!ids[i] || inputs.size() != offsets[i + 1] - offsets[i]) {
+        matches = false;
+        break;
+      }
+      for (size_t j = 0; j < inputs.size(); ++j) {
+        const auto pos = positions[offsets[i] + j];
+        const auto id = inputs[j].sharedGrad_.get();
+        if (!ids[pos]) {
+          ids[pos] = id;
+          dag[pos] = inputs[j];
+        } else if (ids[pos] != id) {
+          matches = false;
+          break;
+        }
+      }
+    }
+    // distinct nodes of the cached graph must be distinct in this one
+    if (matches) {
+      std::sort(ids.begin(), ids.end());
+      matches = std::adjacent_find(ids.begin(), ids.end()) == ids.end();
+    }
+    if (matches) {
+      ++cache.hits_;
+      return dag;
+    }
+  }
+
+  ++cache.misses_;
+  auto dag = build();
+  std::unordered_map<SharedGrad*, size_t> nodePositions;
+  for (size_t i = 0; i < dag.size(); ++i) {
+    nodePositions[dag[i].sharedGrad_.get()] = i;
+  }
+  cache.clear();
+  cache.inputOffsets_.push_back(0);
+  for (const auto& node : dag) {
+    for (const auto& input : node.getInputs()) {
+      cache.inputPositions_.push_back(
+          nodePositions.at(input.sharedGrad_.get()));
+    }
+    cache.inputOffsets_.push_back(cache.inputPositions_.size());
+  }
+  return dag;
+}
+
+size_t BackwardCache::hits() const {
+  return hits_;
+}
+
+size_t BackwardCache::misses() const {
+  return misses_;
+}
+
+void BackwardCache::clear() {
+  inputOffsets_.clear();
+  inputPositions_.clear();
+}
+
 } // namespace fl
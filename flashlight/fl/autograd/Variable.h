@@ -8,16 +8,85 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "flashlight/fl/autograd/InferenceMode.h"
 #include "flashlight/fl/common/Defines.h"
+#include "flashlight/fl/common/PoolAllocator.h"
 #include "flashlight/fl/common/Serialization.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
 namespace fl {
 
+class BackwardExecutor;
+class GradientArena;
+
+namespace detail {
+class ActivationOffloader;
+class AutocastCache;
+struct GradientArenaSlot;
+struct OffloadedTensor;
+struct RowSparseData;
+class SavedMemoryProfiler;
+template <typename F>
+struct PooledGradFunc;
+} // namespace detail
+
+/**
+ * A cache of the topological order of an autograd graph, which
+ * `Variable::backward` reuses for graphs with the same structure, e.g. those
+ * of the training steps of a static model, instead of sorting them again.
+ *
+ * A graph is checked to have the cached structure by walking it in the cached
+ * order and comparing the inputs of each node with the cached ones, which
+ * doesn't hash nodes. Otherwise, it's sorted, and its order replaces the
+ * cached one.
+ *
+ * Example:
+ * \code
+   fl::BackwardCache cache;
+   for (auto& batch : dataset) {
+     auto loss = criterion(model(batch[0]), batch[1]);
+     loss.backward(cache);
+     // ...
+   }
+ * \endcode
+ */
+class BackwardCache {
+ public:
+  BackwardCache() = default;
+
+  /**
+   * @return how many graphs reused the cached order
+   */
+  size_t hits() const;
+
+  /**
+   * @return how many graphs were sorted
+   */
+  size_t misses() const;
+
+  /**
+   * Removes the cached order.
+   */
+  void clear();
+
+ private:
+  friend class Variable;
+
+  // The positions in the order of the inputs of each node, with those of node
+  // i in [inputOffsets_[i], inputOffsets_[i + 1]) of inputPositions_
+  std::vector<size_t> inputOffsets_;
+  std::vector<size_t> inputPositions_;
+  size_t hits_{0};
+  size_t misses_{0};
+};
+
 /**
  *  Variable wraps an Arrayfire array and facilitates easy backpropagation
  *
@@ -89,6 +158,47 @@ class Variable {
    */
   Variable(Tensor data, std::vector<Variable> inputs, GradFunc gradFunc);
 
+  /**
+   * Creates a Variable like above from any callable gradient function, e.g. a
+   * lambda, which is only converted to a `GradFunc` if the graph is built,
+   * i.e. not under an `InferenceModeGuard`.
+   */
+  template <
+      typename F,
+      typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, GradFunc>>>
+  Variable(Tensor data, std::vector<Variable> inputs, F&& gradFunc) {
+    sharedData_->data = std::move(data);
+    if (!InferenceModeGuard::isEnabled()) {
+      setGradFunc(
+          std::move(inputs),
+          GradFunc(detail::PooledGradFunc<std::decay_t<F>>{
+              std::forward<F>(gradFunc)}));
+    }
+  }
+
+  /**
+   * Creates a row-sparse Variable, which wraps a matrix that is zero except
+   * for some of its rows, i.e. slices along its second axis. This is mostly
+   * useful for gradients which only a few rows of a large matrix contribute
+   * to, such as the gradient of an embedding table for a batch.
+   *
+   * The dense matrix is only computed if `tensor()` is called, after which the
+   * Variable isn't row-sparse anymore.
+   *
+   * @param[in] indices a 1D integer Tensor with the indices of \f$K\f$ rows,
+   * which may repeat, in which case their values are summed
+   * @param[in] values a Tensor with shape [`shape[0]`, \f$K\f$] with the
+   * values of the rows
+   * @param[in] shape the 2D shape of the dense matrix
+   * @param[in] calcGrad specifies whether to the gradient is required for this
+   * Variable
+   */
+  static Variable rowSparse(
+      Tensor indices,
+      Tensor values,
+      const Shape& shape,
+      bool calcGrad = false);
+
   Variable operator()(const std::vector<Index>& indices) const;
 
   /**
@@ -110,10 +220,28 @@ class Variable {
   Variable flat(const fl::Index& index) const;
 
   /**
-   * @return a reference to the underlying Flashlight Tensor.
+   * @return a reference to the underlying Flashlight Tensor. Row-sparse
+   * Variables are made dense.
    */
   Tensor& tensor() const;
 
+  /**
+   * Returns whether the Variable is row-sparse, see `rowSparse`.
+   */
+  bool isRowSparse() const;
+
+  /**
+   * @return a reference to the s32 indices of the rows of a row-sparse
+   * Variable, which are sorted and unique. They must be kept so if modified.
+   */
+  Tensor& sparseIndices() const;
+
+  /**
+   * @return a reference to the values of the rows of a row-sparse Variable,
+   * in the order of `sparseIndices()`.
+   */
+  Tensor& sparseValues() const;
+
   /**
    * Creates a new variable based on the current variable whose type will be
    * adjusted based on the input type.
@@ -268,6 +396,54 @@ class Variable {
    */
   void backward(bool retainGraph = false);
 
+  /**
+   * Run backward pass on the Variable, reusing the topological order of the
+   * graph from `cache` if the graph has the same structure as the last one
+   * run with it. See `BackwardCache`.
+   * @param[in] grad gradient w.r.t to the Variable
+   * @param[in,out] cache the cache of the topological order
+   * @param[in] retainGraph If False, clears the input Variables stored
+   * by the Variable
+   */
+  void backward(
+      const Variable& grad,
+      BackwardCache& cache,
+      bool retainGraph = false);
+
+  /**
+   * Run backward pass on the Variable with a gradient of 1.0 for all of its
+   * elements, reusing the topological order of the graph from `cache`. See
+   * `BackwardCache`.
+   * @param[in,out] cache the cache of the topological order
+   * @param[in] retainGraph If False, clears the input Variables stored
+   * by the Variable
+   */
+  void backward(BackwardCache& cache, bool retainGraph = false);
+
+  /**
+   * Returns the version of the array wrapped by the Variable, i.e. the number
+   * of times it was modified in place by autograd functions, see
+   * `recordInPlace`.
+   */
+  uint64_t version() const;
+
+  /**
+   * Records that an autograd function is about to modify the array wrapped by
+   * the Variable in place: the version of the array is incremented, and the
+   * Variable is given a new node in the computation graph, with `inputs` and
+   * `gradFunc`. Copies of the Variable made before, which share the array,
+   * keep the previous node, and can thus be inputs of the new one.
+   *
+   * The backward pass throws if an input of a node was modified in place
+   * after the node saved it. Leaves which require gradients can't be modified
+   * in place.
+   *
+   * @param[in] inputs a vector specifying inputs for the new node
+   * @param[in] gradFunc function specifying how to calculate gradient of the
+   * input Variables
+   */
+  void recordInPlace(std::vector<Variable> inputs, GradFunc gradFunc);
+
   /**
    * Returns a copy of this variable after removing its underlying array.
    * The new Variable is used to store the inputs for a Variable
@@ -276,6 +452,12 @@ class Variable {
   Variable withoutData() const;
 
  private:
+  friend class BackwardExecutor;
+  friend class GradientArena;
+  friend class detail::ActivationOffloader;
+  friend class detail::AutocastCache;
+  friend class detail::SavedMemoryProfiler;
+
   using DAG = std::vector<Variable>;
 
   /**
@@ -289,6 +471,17 @@ class Variable {
    */
   DAG build() const;
 
+  /**
+   * Builds the computation graph like `build()`, reusing the order in `cache`
+   * if the graph has the same structure, or caching its order otherwise.
+   */
+  DAG build(BackwardCache& cache) const;
+
+  /**
+   * Propagates gradients through `dag`, which is topologically sorted.
+   */
+  static void propagateGrads(DAG& dag, bool retainGraph);
+
   /**
    * Calculate the gradient of inputs.
    * @param[in] retainGraph If False, clears the inputs stored
@@ -301,9 +494,36 @@ class Variable {
    */
   void applyGradHook();
 
+  /**
+   * Sets the inputs and gradient function of the Variable's node, if any
+   * input requires gradients, and the versions of the inputs it saves.
+   */
+  void setGradFunc(std::vector<Variable> inputs, GradFunc gradFunc);
+
+  struct SharedData;
+  struct SharedGrad;
+
+  // Shares the given data and gradient, without allocating others first
+  Variable(
+      std::shared_ptr<SharedData> sharedData,
+      std::shared_ptr<SharedGrad> sharedGrad);
+
   struct SharedData {
     /// Array wrapped by this Variable
     Tensor data;
+    /// Rows of a row-sparse Variable, which `data` is computed from on first
+    /// access
+    std::shared_ptr<detail::RowSparseData> sparse;
+    /// Host copy of `data` while it's offloaded, see ActivationOffloadScope
+    std::shared_ptr<detail::OffloadedTensor> offloaded;
+    /// Whether `data` is tracked as a saved activation
+    bool saved{false};
+    /// Whether `data` may be offloaded, i.e., isn't a placeholder
+    bool offloadable{true};
+    /// Number of in-place modifications of `data`, see recordInPlace
+    uint64_t version{0};
+
+    ~SharedData();
 
     FL_SAVE_LOAD(data)
   };
@@ -313,19 +533,28 @@ class Variable {
     bool calcGrad{false};
     /// Inputs of this Variable
     std::vector<Variable> inputs;
+    /// Versions of the data of `inputs` when they were saved
+    std::vector<uint64_t> inputVersions;
     /// Gradient with respect to this Variable
     std::unique_ptr<Variable> grad{nullptr};
     /// Function for calculating the gradient of the input Variables
     GradFunc gradFunc{nullptr};
     /// Function applied to gradient after it's computed during bwd pass
     GradHook onGradAvailable{nullptr};
+    /// Slot of the gradient in a GradientArena, if any, in which case `grad`
+    /// is a view of the slot created on first access
+    std::shared_ptr<detail::GradientArenaSlot> arenaSlot;
 
    private:
     FL_SAVE_LOAD(calcGrad);
   };
 
-  std::shared_ptr<SharedData> sharedData_ = std::make_shared<SharedData>();
-  std::shared_ptr<SharedGrad> sharedGrad_ = std::make_shared<SharedGrad>();
+  // every Variable has both, thus they come from a pool with their control
+  // blocks, see detail::BlockPool
+  std::shared_ptr<SharedData> sharedData_ =
+      std::allocate_shared<SharedData>(PoolAllocator<SharedData>());
+  std::shared_ptr<SharedGrad> sharedGrad_ =
+      std::allocate_shared<SharedGrad>(PoolAllocator<SharedGrad>());
 
   // NB: array only; we don't try to serialize the autograd graph
   // Saving the sharedData ptr helps to avoid saving variables which share the
@@ -333,4 +562,39 @@ class Variable {
   FL_SAVE_LOAD(sharedData_, sharedGrad_)
 };
 
+namespace detail {
+
+/**
+ * A gradient function whose closure is allocated from `BlockPool` when it
+ * doesn't fit in a `Variable::GradFunc`, as `std::function` implementations
+ * which store callables with a new-expression, e.g. libstdc++'s, then use its
+ * class-specific allocation functions.
+ */
+template <typename F>
+struct PooledGradFunc final {
+  F func;
+
+  void operator()(std::vector<Variable>& inputs, const Variable& gradOutput) {
+    func(inputs, gradOutput);
+  }
+
+  static void* operator new(const size_t bytes) {
+    return BlockPool::allocate(bytes);
+  }
+
+  static void operator delete(void* ptr, const size_t bytes) noexcept {
+    BlockPool::deallocate(ptr, bytes);
+  }
+};
+
+// copies of a Variable share its data; only the tensor is snapshotted
+template <>
+struct AsyncSaveSnapshot<Variable> {
+  static Variable take(const Variable& variable) {
+    return Variable(variable.tensor(), variable.isCalcGrad());
+  }
+};
+
+} // namespace detail
+
 } // namespace fl
@@ -7,6 +7,12 @@
 
 #pragma once
 
+#include "flashlight/fl/autograd/ActivationOffload.h"
+#include "flashlight/fl/autograd/Autocast.h"
+#include "flashlight/fl/autograd/BackwardExecutor.h"
 #include "flashlight/fl/autograd/Functions.h"
+#include "flashlight/fl/autograd/GradientArena.h"
+#include "flashlight/fl/autograd/InferenceMode.h"
+#include "flashlight/fl/autograd/SavedMemoryProfile.h"
 #include "flashlight/fl/autograd/Utils.h"
 #include "flashlight/fl/autograd/Variable.h"
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <stdexcept>
+
 #include "flashlight/fl/autograd/tensor/AutogradOps.h"
 #include "flashlight/fl/common/Defines.h"
 #include "flashlight/fl/tensor/TensorExtension.h"
@@ -66,6 +68,7 @@ class AutogradExtension : public TensorExtension<AutogradExtension> {
       const int dx,
       const int dy,
       const int groups,
+      const MemoryFormat format,
       std::shared_ptr<detail::AutogradPayload> payload) = 0;
 
   virtual Tensor pool2d(
@@ -77,6 +80,7 @@ class AutogradExtension : public TensorExtension<AutogradExtension> {
       const int px,
       const int py,
       const PoolingMode mode,
+      const MemoryFormat format,
       std::shared_ptr<detail::AutogradPayload> payload) = 0;
 
   virtual Tensor batchnorm(
@@ -105,6 +109,79 @@ class AutogradExtension : public TensorExtension<AutogradExtension> {
       const float dropout,
       std::shared_ptr<detail::AutogradPayload> payload) = 0;
 
+  virtual Tensor softmax(
+      const Tensor& input,
+      const int axis,
+      const bool log,
+      std::shared_ptr<detail::AutogradPayload> payload) = 0;
+
+  virtual Tensor layerNorm(
+      Tensor& saveMean,
+      Tensor& saveRstd,
+      const Tensor& input,
+      const Tensor& weight,
+      const Tensor& bias,
+      const int numAxes,
+      const double epsilon,
+      std::shared_ptr<detail::AutogradPayload> payload) = 0;
+
+  // ]----- int8 inference, see fl::quantizedLinear and fl::quantizedConv2d.
+  // Forward only, and not supported by all backends.
+  virtual Tensor quantizedLinear(
+      const Tensor& /* input */,
+      const Tensor& /* weights */,
+      const Tensor& /* weightScales */,
+      const Tensor& /* bias */,
+      const float /* inputScale */,
+      std::shared_ptr<detail::AutogradPayload> /* payload */) {
+    throw std::runtime_error(
+        "[AutogradExtension::quantizedLinear] int8 inference is not "
+        "supported by this backend");
+  }
+
+  virtual Tensor quantizedConv2d(
+      const Tensor& /* input */,
+      const Tensor& /* weights */,
+      const Tensor& /* weightScales */,
+      const Tensor& /* bias */,
+      const float /* inputScale */,
+      const int /* sx */,
+      const int /* sy */,
+      const int /* px */,
+      const int /* py */,
+      const int /* dx */,
+      const int /* dy */,
+      const int /* groups */,
+      std::shared_ptr<detail::AutogradPayload> /* payload */) {
+    throw std::runtime_error(
+        "[AutogradExtension::quantizedConv2d] int8 inference is not "
+        "supported by this backend");
+  }
+
+  // ]----- rnn over sequences of per-sample lengths, see fl::rnn. Backends
+  // which don't support them leave these, and fl::rnn then runs rnn only on
+  // the steps of each sample.
+  virtual bool isVariableLengthRnnSupported() const {
+    return false;
+  }
+
+  virtual std::tuple<Tensor, Tensor, Tensor> variableLengthRnn(
+      const Tensor& /* input */,
+      const Tensor& /* hiddenState */,
+      const Tensor& /* cellState */,
+      const Tensor& /* weights */,
+      const std::vector<int>& /* sequenceLengths */,
+      const int /* hiddenSize */,
+      const int /* numLayers */,
+      const RnnMode /* mode */,
+      const bool /* bidirectional */,
+      const float /* dropout */,
+      std::shared_ptr<detail::AutogradPayload> /* payload */) {
+    throw std::runtime_error(
+        "[AutogradExtension::variableLengthRnn] variable-length sequences "
+        "are not supported by this backend");
+  }
+
   /**************************** Backward ****************************/
   // ]----- conv2d
   virtual Tensor conv2dBackwardData(
@@ -118,6 +195,7 @@ class AutogradExtension : public TensorExtension<AutogradExtension> {
       const int dx,
       const int dy,
       const int groups,
+      const MemoryFormat format,
       std::shared_ptr<DynamicBenchmark> dataGradBenchmark,
       std::shared_ptr<detail::AutogradPayload> payload) = 0;
 
@@ -133,6 +211,7 @@ class AutogradExtension : public TensorExtension<AutogradExtension> {
       const int dx,
       const int dy,
       const int groups,
+      const MemoryFormat format,
       std::shared_ptr<DynamicBenchmark> filterBench,
       std::shared_ptr<DynamicBenchmark> biasBench,
       std::shared_ptr<detail::AutogradPayload> autogradPayload) = 0;
@@ -149,6 +228,7 @@ class AutogradExtension : public TensorExtension<AutogradExtension> {
       const int px,
       const int py,
       const PoolingMode mode,
+      const MemoryFormat format,
       std::shared_ptr<detail::AutogradPayload> payload) = 0;
 
   // ]----- batchnorm
@@ -177,6 +257,44 @@ class AutogradExtension : public TensorExtension<AutogradExtension> {
       const bool bidirectional,
       const float dropProb,
       std::shared_ptr<detail::AutogradPayload> payload) = 0;
+
+  virtual std::tuple<Tensor, Tensor, Tensor, Tensor> variableLengthRnnBackward(
+      const Tensor& /* input */,
+      const Tensor& /* hiddenState */,
+      const Tensor& /* cellState */,
+      const Tensor& /* weights */,
+      const std::vector<int>& /* sequenceLengths */,
+      const std::shared_ptr<detail::RNNGradData> /* gradData */,
+      const Tensor& /* output */,
+      const int /* numLayers */,
+      const int /* hiddenSize */,
+      const RnnMode /* mode */,
+      const bool /* bidirectional */,
+      const float /* dropProb */,
+      std::shared_ptr<detail::AutogradPayload> /* payload */) {
+    throw std::runtime_error(
+        "[AutogradExtension::variableLengthRnnBackward] variable-length "
+        "sequences are not supported by this backend");
+  }
+
+  // ]----- softmax
+  virtual Tensor softmaxBackward(
+      const Tensor& gradOutput,
+      const Tensor& output,
+      const int axis,
+      const bool log,
+      std::shared_ptr<detail::AutogradPayload> payload) = 0;
+
+  // ]----- layerNorm
+  virtual std::tuple<Tensor, Tensor, Tensor> layerNormBackward(
+      const Tensor& gradOutput,
+      const Tensor& saveMean,
+      const Tensor& saveRstd,
+      const Tensor& input,
+      const Tensor& weight,
+      const int numAxes,
+      const double epsilon,
+      std::shared_ptr<detail::AutogradPayload> payload) = 0;
 };
 
 } // namespace fl
@@ -19,6 +19,9 @@
 #if FL_USE_ONEDNN
   #include "flashlight/fl/autograd/tensor/backend/onednn/OneDnnAutogradExtension.h"
 #endif // FL_USE_ONEDNN
+#if FL_USE_TENSOR_STUB
+  #include "flashlight/fl/autograd/tensor/backend/stub/StubAutogradExtension.h"
+#endif // FL_USE_TENSOR_STUB
 
 namespace fl {
 
@@ -41,4 +44,9 @@ FL_REGISTER_TENSOR_EXTENSION(OneDnnAutogradExtension, ArrayFire);
          // FL_ARRAYFIRE_USE_OPENCL)
 #endif // FL_USE_ONEDNN
 
+#if FL_USE_TENSOR_STUB
+// Shape and FLOP propagation for dry runs
+FL_REGISTER_TENSOR_EXTENSION(StubAutogradExtension, Stub);
+#endif // FL_USE_TENSOR_STUB
+
 } // namespace fl
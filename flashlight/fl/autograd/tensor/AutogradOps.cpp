@@ -21,9 +21,11 @@ Tensor conv2d(
     const int py,
     const int dx,
     const int dy,
-    const int groups) {
+    const int groups,
+    const MemoryFormat format /* = MemoryFormat::WHCN */) {
   auto dummyBias = Tensor(input.type());
-  return conv2d(input, weights, dummyBias, sx, sy, px, py, dx, dy, groups);
+  return conv2d(
+      input, weights, dummyBias, sx, sy, px, py, dx, dy, groups, format);
 }
 
 Tensor conv2d(
@@ -36,7 +38,8 @@ Tensor conv2d(
     const int py,
     const int dx,
     const int dy,
-    const int groups) {
+    const int groups,
+    const MemoryFormat format /* = MemoryFormat::WHCN */) {
   return detail::conv2d(
       input,
       weights,
@@ -48,6 +51,7 @@ Tensor conv2d(
       dx,
       dy,
       groups,
+      format,
       /* payload = */ nullptr);
 }
 
@@ -59,9 +63,10 @@ Tensor pool2d(
     const int sy,
     const int px,
     const int py,
-    const PoolingMode mode) {
+    const PoolingMode mode,
+    const MemoryFormat format /* = MemoryFormat::WHCN */) {
   return detail::pool2d(
-      input, wx, wy, sx, sy, px, py, mode, /* payload = */ nullptr);
+      input, wx, wy, sx, sy, px, py, mode, format, /* payload = */ nullptr);
 }
 
 Tensor batchnorm(
@@ -141,6 +146,79 @@ std::tuple<Tensor, Tensor, Tensor> rnn(
       /* payload = */ nullptr);
 }
 
+Tensor quantizedLinear(
+    const Tensor& input,
+    const Tensor& weights,
+    const Tensor& weightScales,
+    const Tensor& bias,
+    const float inputScale) {
+  return detail::quantizedLinear(
+      input,
+      weights,
+      weightScales,
+      bias,
+      inputScale,
+      /* payload = */ nullptr);
+}
+
+Tensor quantizedConv2d(
+    const Tensor& input,
+    const Tensor& weights,
+    const Tensor& weightScales,
+    const Tensor& bias,
+    const float inputScale,
+    const int sx,
+    const int sy,
+    const int px,
+    const int py,
+    const int dx,
+    const int dy,
+    const int groups) {
+  return detail::quantizedConv2d(
+      input,
+      weights,
+      weightScales,
+      bias,
+      inputScale,
+      sx,
+      sy,
+      px,
+      py,
+      dx,
+      dy,
+      groups,
+      /* payload = */ nullptr);
+}
+
+Tensor softmax(const Tensor& input, const int axis) {
+  return detail::softmax(
+      input, axis, /* log = */ false, /* payload = */ nullptr);
+}
+
+Tensor logSoftmax(const Tensor& input, const int axis) {
+  return detail::softmax(
+      input, axis, /* log = */ true, /* payload = */ nullptr);
+}
+
+Tensor layerNorm(
+    const Tensor& input,
+    const Tensor& weight,
+    const Tensor& bias,
+    const int numAxes,
+    const double epsilon) {
+  Tensor saveMean; // empty
+  Tensor saveRstd; // empty
+  return detail::layerNorm(
+      saveMean,
+      saveRstd,
+      input,
+      weight,
+      bias,
+      numAxes,
+      epsilon,
+      /* payload = */ nullptr);
+}
+
 namespace detail {
 
 Tensor conv2d(
@@ -154,9 +232,10 @@ Tensor conv2d(
     const int dx,
     const int dy,
     const int groups,
+    const MemoryFormat format,
     std::shared_ptr<detail::AutogradPayload> payload) {
   return input.backend().getExtension<AutogradExtension>().conv2d(
-      input, weights, bias, sx, sy, px, py, dx, dy, groups, payload);
+      input, weights, bias, sx, sy, px, py, dx, dy, groups, format, payload);
 }
 
 Tensor batchnorm(
@@ -196,9 +275,10 @@ Tensor pool2d(
     const int px,
     const int py,
     const PoolingMode mode,
+    const MemoryFormat format,
     std::shared_ptr<detail::AutogradPayload> payload) {
   return input.backend().getExtension<AutogradExtension>().pool2d(
-      input, wx, wy, sx, sy, px, py, mode, payload);
+      input, wx, wy, sx, sy, px, py, mode, format, payload);
 }
 
 std::tuple<Tensor, Tensor, Tensor> rnn(
@@ -225,6 +305,69 @@ std::tuple<Tensor, Tensor, Tensor> rnn(
       payload);
 }
 
+Tensor quantizedLinear(
+    const Tensor& input,
+    const Tensor& weights,
+    const Tensor& weightScales,
+    const Tensor& bias,
+    const float inputScale,
+    std::shared_ptr<detail::AutogradPayload> payload) {
+  return input.backend().getExtension<AutogradExtension>().quantizedLinear(
+      input, weights, weightScales, bias, inputScale, payload);
+}
+
+Tensor quantizedConv2d(
+    const Tensor& input,
+    const Tensor& weights,
+    const Tensor& weightScales,
+    const Tensor& bias,
+    const float inputScale,
+    const int sx,
+    const int sy,
+    const int px,
+    const int py,
+    const int dx,
+    const int dy,
+    const int groups,
+    std::shared_ptr<detail::AutogradPayload> payload) {
+  return input.backend().getExtension<AutogradExtension>().quantizedConv2d(
+      input,
+      weights,
+      weightScales,
+      bias,
+      inputScale,
+      sx,
+      sy,
+      px,
+      py,
+      dx,
+      dy,
+      groups,
+      payload);
+}
+
+Tensor softmax(
+    const Tensor& input,
+    const int axis,
+    const bool log,
+    std::shared_ptr<detail::AutogradPayload> payload) {
+  return input.backend().getExtension<AutogradExtension>().softmax(
+      input, axis, log, payload);
+}
+
+Tensor layerNorm(
+    Tensor& saveMean,
+    Tensor& saveRstd,
+    const Tensor& input,
+    const Tensor& weight,
+    const Tensor& bias,
+    const int numAxes,
+    const double epsilon,
+    std::shared_ptr<detail::AutogradPayload> payload) {
+  return input.backend().getExtension<AutogradExtension>().layerNorm(
+      saveMean, saveRstd, input, weight, bias, numAxes, epsilon, payload);
+}
+
 Tensor conv2dBackwardData(
     const Tensor& gradOutput,
     const Tensor& input,
@@ -236,6 +379,7 @@ Tensor conv2dBackwardData(
     const int dx,
     const int dy,
     const int groups,
+    const MemoryFormat format,
     std::shared_ptr<DynamicBenchmark> dataGradBenchmark,
     std::shared_ptr<detail::AutogradPayload> payload) {
   return input.backend().getExtension<AutogradExtension>().conv2dBackwardData(
@@ -249,6 +393,7 @@ Tensor conv2dBackwardData(
       dx,
       dy,
       groups,
+      format,
       dataGradBenchmark,
       payload);
 }
@@ -265,6 +410,7 @@ std::pair<Tensor, Tensor> conv2dBackwardFilterBias(
     const int dx,
     const int dy,
     const int groups,
+    const MemoryFormat format,
     std::shared_ptr<DynamicBenchmark> filterGradBenchmark,
     std::shared_ptr<DynamicBenchmark> biasGradBenchmark,
     std::shared_ptr<detail::AutogradPayload> payload) {
@@ -282,6 +428,7 @@ std::pair<Tensor, Tensor> conv2dBackwardFilterBias(
           dx,
           dy,
           groups,
+          format,
           filterGradBenchmark,
           biasGradBenchmark,
           payload);
@@ -298,9 +445,21 @@ Tensor pool2dBackward(
     const int px,
     const int py,
     const PoolingMode mode,
+    const MemoryFormat format,
     std::shared_ptr<detail::AutogradPayload> payload) {
   return input.backend().getExtension<AutogradExtension>().pool2dBackward(
-      gradOutput, input, poolOutput, wx, wy, sx, sy, px, py, mode, payload);
+      gradOutput,
+      input,
+      poolOutput,
+      wx,
+      wy,
+      sx,
+      sy,
+      px,
+      py,
+      mode,
+      format,
+      payload);
 }
 
 // Returns the gradinets with respect tot he input, hidden state cell state, and
@@ -360,6 +519,36 @@ std::tuple<Tensor, Tensor, Tensor, Tensor> rnnBackward(
       payload);
 }
 
+Tensor softmaxBackward(
+    const Tensor& gradOutput,
+    const Tensor& output,
+    const int axis,
+    const bool log,
+    std::shared_ptr<detail::AutogradPayload> payload) {
+  return output.backend().getExtension<AutogradExtension>().softmaxBackward(
+      gradOutput, output, axis, log, payload);
+}
+
+std::tuple<Tensor, Tensor, Tensor> layerNormBackward(
+    const Tensor& gradOutput,
+    const Tensor& saveMean,
+    const Tensor& saveRstd,
+    const Tensor& input,
+    const Tensor& weight,
+    const int numAxes,
+    const double epsilon,
+    std::shared_ptr<detail::AutogradPayload> payload) {
+  return input.backend().getExtension<AutogradExtension>().layerNormBackward(
+      gradOutput,
+      saveMean,
+      saveRstd,
+      input,
+      weight,
+      numAxes,
+      epsilon,
+      payload);
+}
+
 } // namespace detail
 
 } // namespace fl
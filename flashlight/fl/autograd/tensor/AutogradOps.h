@@ -51,6 +51,11 @@ struct AutogradPayload;
  * @param groups number of filter groups
  * @param benchmarks [optional] a `ConvBenchmarks` instance to use to
  * dynamically benchmark configuration attributes for computations.
+ * @param format the layout of the input, weights and output. The input,
+ * weights and output of a `MemoryFormat::CWHN` convolution have shapes
+ * [\f$C_{in}\f$, \f$X_{in}\f$, \f$Y_{in}\f$, \f$N\f$], [\f$C_{in}\f$,
+ * \f$K_x\f$, \f$K_y\f$, \f$C_{out}\f$] and [\f$C_{out}\f$, \f$X_{out}\f$,
+ * \f$Y_{out}\f$, \f$N\f$]
  * @return a Tensor with shape [\f$X_{out}\f$, \f$Y_{out}\f$, \f$C_{out}\f$,
  * \f$N\f$]]
  */
@@ -63,7 +68,8 @@ Tensor conv2d(
     const int py = 0,
     const int dx = 1,
     const int dy = 1,
-    const int groups = 1);
+    const int groups = 1,
+    const MemoryFormat format = MemoryFormat::WHCN);
 
 /**
  * Applies a 2D convolution over an input signal given filter weights and
@@ -97,6 +103,11 @@ Tensor conv2d(
  * @param groups number of filter groups
  * @param benchmarks [optional] a `ConvBenchmarks` instance to use to
  * dynamically benchmark configuration attributes for computations.
+ * @param format the layout of the input, weights and output. The input,
+ * weights and output of a `MemoryFormat::CWHN` convolution have shapes
+ * [\f$C_{in}\f$, \f$X_{in}\f$, \f$Y_{in}\f$, \f$N\f$], [\f$C_{in}\f$,
+ * \f$K_x\f$, \f$K_y\f$, \f$C_{out}\f$] and [\f$C_{out}\f$, \f$X_{out}\f$,
+ * \f$Y_{out}\f$, \f$N\f$]
  * @param bias a Tensor with shape [\f$C_{out}\f$]
  * @return a Tensor with shape [\f$X_{out}\f$, \f$Y_{out}\f$, \f$C_{out}\f$,
  * \f$N\f$]]
@@ -111,7 +122,8 @@ Tensor conv2d(
     const int py = 0,
     const int dx = 1,
     const int dy = 1,
-    const int groups = 1);
+    const int groups = 1,
+    const MemoryFormat format = MemoryFormat::WHCN);
 
 /**
  * Applies a 2D pooling over an input signal composed of several input planes.
@@ -129,6 +141,8 @@ Tensor conv2d(
  * - MAX
  * - AVG_INCLUDE_PADDING
  * - AVG_EXCLUDE_PADDING
+ * @param format the layout of the input and output, of shape [\f$C\f$,
+ * \f$X\f$, \f$Y\f$, \f$N\f$] if `MemoryFormat::CWHN`
  */
 Tensor pool2d(
     const Tensor& input,
@@ -138,7 +152,8 @@ Tensor pool2d(
     const int sy = 1,
     const int px = 0,
     const int py = 0,
-    const PoolingMode mode = PoolingMode::MAX);
+    const PoolingMode mode = PoolingMode::MAX,
+    const MemoryFormat format = MemoryFormat::WHCN);
 
 /**
 * Applies Batch Normalization over a 4D input (a mini-batch of 2D inputs with
@@ -240,6 +255,90 @@ std::tuple<Tensor, Tensor, Tensor> rnn(
     const bool bidirectional,
     const float dropout);
 
+/**
+ * Applies a linear transformation \f$y = Wx + b\f$ with int8 arithmetic,
+ * for inference. The input and weights are quantized symmetrically, i.e.
+ * \f$x \approx s_x q_x\f$ and \f$W_{o,:} \approx s_o q_{o,:}\f$ for
+ * \f$q\f$ in \f$[-127, 127]\f$, and the int32 accumulator is dequantized
+ * into a float32 output.
+ *
+ * @param input a float32 Tensor with shape [\f$C_{in}\f$, *]
+ * @param weights a float32 Tensor with shape [\f$C_{out}\f$, \f$C_{in}\f$]
+ * @param weightScales a Tensor with shape [\f$C_{out}\f$] with the positive
+ * per output channel scales \f$s_o\f$ of the weights
+ * @param bias a Tensor with shape [\f$C_{out}\f$], or an empty Tensor
+ * @param inputScale the positive scale \f$s_x\f$ of the input, which values
+ * beyond \f$127 s_x\f$ saturate
+ * @return a float32 Tensor with shape [\f$C_{out}\f$, *]
+ */
+Tensor quantizedLinear(
+    const Tensor& input,
+    const Tensor& weights,
+    const Tensor& weightScales,
+    const Tensor& bias,
+    const float inputScale);
+
+/**
+ * Applies a 2D convolution with int8 arithmetic, for inference. The input
+ * and weights are quantized as in `quantizedLinear`, with a scale per output
+ * channel for the weights, and the output is float32. See `conv2d` for the
+ * shapes and the other parameters.
+ *
+ * @param weightScales a Tensor with shape [\f$C_{out}\f$] with the positive
+ * per output channel scales of the weights
+ * @param bias a Tensor with shape [\f$C_{out}\f$], or an empty Tensor
+ * @param inputScale the positive scale of the input
+ */
+Tensor quantizedConv2d(
+    const Tensor& input,
+    const Tensor& weights,
+    const Tensor& weightScales,
+    const Tensor& bias,
+    const float inputScale,
+    const int sx = 1,
+    const int sy = 1,
+    const int px = 0,
+    const int py = 0,
+    const int dx = 1,
+    const int dy = 1,
+    const int groups = 1);
+
+/**
+ * Computes the softmax of `input` along `axis` in a single pass, i.e.
+ * \f$\exp(x_i - \max_j x_j) / \sum_j \exp(x_j - \max_j x_j)\f$.
+ *
+ * @param input the Tensor to normalize
+ * @param axis the axis along which to normalize
+ * @return a Tensor with the same shape and type as `input`
+ */
+Tensor softmax(const Tensor& input, const int axis);
+
+/**
+ * Computes the log of the softmax of `input` along `axis` in a single pass,
+ * without computing the softmax itself. See `softmax`.
+ */
+Tensor logSoftmax(const Tensor& input, const int axis);
+
+/**
+ * Applies layer normalization over the first `numAxes` axes of `input`, i.e.
+ * normalizes each of its slices along those axes to zero mean and unit
+ * variance, before scaling by `weight` and shifting by `bias`, in a single
+ * pass.
+ *
+ * @param input the Tensor to normalize
+ * @param weight if non-empty, the scale, with as many elements as a slice
+ * @param bias if non-empty, the shift, with as many elements as a slice
+ * @param numAxes the number of leading axes to normalize along
+ * @param epsilon added to the variance for numerical stability
+ * @return a Tensor with the same shape and type as `input`
+ */
+Tensor layerNorm(
+    const Tensor& input,
+    const Tensor& weight,
+    const Tensor& bias,
+    const int numAxes,
+    const double epsilon);
+
 namespace detail {
 
 Tensor conv2d(
@@ -253,6 +352,7 @@ Tensor conv2d(
     const int dx,
     const int dy,
     const int groups,
+    const MemoryFormat format,
     std::shared_ptr<detail::AutogradPayload> payload);
 
 Tensor batchnorm(
@@ -278,6 +378,7 @@ Tensor pool2d(
     const int px,
     const int py,
     const PoolingMode mode,
+    const MemoryFormat format,
     std::shared_ptr<detail::AutogradPayload> payload);
 
 std::tuple<Tensor, Tensor, Tensor> rnn(
@@ -292,6 +393,50 @@ std::tuple<Tensor, Tensor, Tensor> rnn(
     const float dropout,
     std::shared_ptr<detail::AutogradPayload> payload);
 
+// The payload caches the quantized weights, and thus must only be reused with
+// the same weights
+Tensor quantizedLinear(
+    const Tensor& input,
+    const Tensor& weights,
+    const Tensor& weightScales,
+    const Tensor& bias,
+    const float inputScale,
+    std::shared_ptr<detail::AutogradPayload> payload);
+
+Tensor quantizedConv2d(
+    const Tensor& input,
+    const Tensor& weights,
+    const Tensor& weightScales,
+    const Tensor& bias,
+    const float inputScale,
+    const int sx,
+    const int sy,
+    const int px,
+    const int py,
+    const int dx,
+    const int dy,
+    const int groups,
+    std::shared_ptr<detail::AutogradPayload> payload);
+
+// Computes logSoftmax if `log`, else softmax
+Tensor softmax(
+    const Tensor& input,
+    const int axis,
+    const bool log,
+    std::shared_ptr<detail::AutogradPayload> payload);
+
+// Sets `saveMean` and `saveRstd` to the mean and reciprocal standard deviation
+// of each slice, which are all the backward pass needs
+Tensor layerNorm(
+    Tensor& saveMean,
+    Tensor& saveRstd,
+    const Tensor& input,
+    const Tensor& weight,
+    const Tensor& bias,
+    const int numAxes,
+    const double epsilon,
+    std::shared_ptr<detail::AutogradPayload> payload);
+
 // Returns the gradient with respect to the input
 Tensor conv2dBackwardData(
     const Tensor& gradOutput,
@@ -304,6 +449,7 @@ Tensor conv2dBackwardData(
     const int dx,
     const int dy,
     const int groups,
+    const MemoryFormat format,
     std::shared_ptr<DynamicBenchmark> dataGradBenchmark,
     std::shared_ptr<detail::AutogradPayload> payload);
 
@@ -320,6 +466,7 @@ std::pair<Tensor, Tensor> conv2dBackwardFilterBias(
     const int dx,
     const int dy,
     const int groups,
+    const MemoryFormat format,
     std::shared_ptr<DynamicBenchmark> filterBench,
     std::shared_ptr<DynamicBenchmark> biasBench,
     std::shared_ptr<detail::AutogradPayload> payload);
@@ -335,6 +482,7 @@ Tensor pool2dBackward(
     const int px,
     const int py,
     const PoolingMode mode,
+    const MemoryFormat format,
     std::shared_ptr<detail::AutogradPayload> payload);
 
 // Returns the gradinets with respect tot he input, weight, and bias,
@@ -376,6 +524,27 @@ std::tuple<Tensor, Tensor, Tensor, Tensor> rnnBackward(
     const float dropProb,
     std::shared_ptr<detail::AutogradPayload> payload);
 
+// Returns the gradient with respect to the input of softmax (or logSoftmax
+// if `log`) given its output
+Tensor softmaxBackward(
+    const Tensor& gradOutput,
+    const Tensor& output,
+    const int axis,
+    const bool log,
+    std::shared_ptr<detail::AutogradPayload> payload);
+
+// Returns the gradients with respect to the input, weight and bias of
+// layerNorm, where an empty `weight` is all ones
+std::tuple<Tensor, Tensor, Tensor> layerNormBackward(
+    const Tensor& gradOutput,
+    const Tensor& saveMean,
+    const Tensor& saveRstd,
+    const Tensor& input,
+    const Tensor& weight,
+    const int numAxes,
+    const double epsilon,
+    std::shared_ptr<detail::AutogradPayload> payload);
+
 } // namespace detail
 
 } // namespace fl
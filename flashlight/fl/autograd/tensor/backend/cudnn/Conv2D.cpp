@@ -8,7 +8,9 @@
 #include "flashlight/fl/autograd/tensor/backend/cudnn/CudnnAutogradExtension.h"
 
 #include <array>
+#include <sstream>
 #include <stdexcept>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -17,6 +19,7 @@
 #include "flashlight/fl/autograd/tensor/backend/cudnn/CudnnUtils.h"
 #include "flashlight/fl/common/DevicePtr.h"
 #include "flashlight/fl/common/DynamicBenchmark.h"
+#include "flashlight/fl/runtime/CUDAUtils.h"
 #include "flashlight/fl/tensor/Compute.h"
 
 namespace fl {
@@ -227,6 +230,29 @@ void setCudnnConvMathType(
       kKernelModesToCudnnMathType.at(kernelOptions->currentOption())));
 }
 
+// The key of the benchmarks of a convolution gradient in the BenchmarkCache,
+// whose options are only valid for the device model and cuDNN version
+std::string getBenchmarkKey(
+    const std::string& name,
+    const Tensor& input,
+    const Tensor& weight,
+    const int sx,
+    const int sy,
+    const int px,
+    const int py,
+    const int dx,
+    const int dy,
+    const int groups,
+    const MemoryFormat format) {
+  std::ostringstream ss;
+  ss << "cudnn" << CUDNN_VERSION << ' ' << fl::cuda::getActiveDeviceModel()
+     << ' ' << name << ' ' << input.type() << ' ' << input.shape() << ' '
+     << weight.shape() << ' ' << sx << ' ' << sy << ' ' << px << ' ' << py
+     << ' ' << dx << ' ' << dy << ' ' << groups << ' '
+     << static_cast<int>(format);
+  return ss.str();
+}
+
 void setDefaultMathType(ConvDescriptor& cDesc, const Tensor& input) {
   if (input.type() == fl::dtype::f16) {
     CUDNN_CHECK_ERR(cudnnSetConvolutionMathType(
@@ -250,18 +276,19 @@ Tensor CudnnAutogradExtension::conv2d(
     const int dx,
     const int dy,
     const int groups,
+    const MemoryFormat format,
     std::shared_ptr<detail::AutogradPayload>) {
   if (input.ndim() != 4) {
     throw std::invalid_argument(
         "conv2d: expects input tensor to be 4 dimensions: "
-        "in WHCN ordering. Given tensor has " +
+        "in WHCN or CWHN ordering. Given tensor has " +
         std::to_string(input.ndim()) + " dimensions.");
   }
 
   auto hasBias = bias.elements() > 0;
 
-  auto inDesc = TensorDescriptor(input);
-  auto wtDesc = FilterDescriptor(weights);
+  auto inDesc = TensorDescriptor(input, format);
+  auto wtDesc = FilterDescriptor(weights, format);
   auto convDesc = ConvDescriptor(input.type(), px, py, sx, sy, dx, dy, groups);
   if (input.type() == fl::dtype::f16) {
     CUDNN_CHECK_ERR(cudnnSetConvolutionMathType(
@@ -278,8 +305,11 @@ Tensor CudnnAutogradExtension::conv2d(
       wtDesc.descriptor,
       4,
       odims.data()));
-  auto output = Tensor({odims[3], odims[2], odims[1], odims[0]}, input.type());
-  auto outDesc = TensorDescriptor(output);
+  // cuDNN gives the output dims in NCHW order
+  auto output = format == MemoryFormat::CWHN
+      ? Tensor({odims[1], odims[3], odims[2], odims[0]}, input.type())
+      : Tensor({odims[3], odims[2], odims[1], odims[0]}, input.type());
+  auto outDesc = TensorDescriptor(output, format);
 
   auto handle = getCudnnHandle();
   const auto& cudnnStream = getCudnnStream();
@@ -337,7 +367,7 @@ Tensor CudnnAutogradExtension::conv2d(
         outPtr.get()));
 
     if (hasBias) {
-      auto bsDesc = TensorDescriptor(bias);
+      auto bsDesc = TensorDescriptor(bias, format);
       DevicePtr bsPtr(bias);
       // ensure cudnn compute stream waits on stream of bias tensor
       relativeSync(cudnnStream, {bias});
@@ -367,6 +397,7 @@ Tensor CudnnAutogradExtension::conv2dBackwardData(
     const int dx,
     const int dy,
     const int groups,
+    const MemoryFormat format,
     std::shared_ptr<DynamicBenchmark> dataGradBenchmark,
     std::shared_ptr<detail::AutogradPayload>) {
   auto hndl = getCudnnHandle();
@@ -381,12 +412,26 @@ Tensor CudnnAutogradExtension::conv2dBackwardData(
   // benchmarking suggests input or weight casting should occur, these
   // descriptors may not be used/new ones with the correct types will be
   // used instead.
-  auto iDesc = TensorDescriptor(input);
-  auto wDesc = FilterDescriptor(weight);
+  auto iDesc = TensorDescriptor(input, format);
+  auto wDesc = FilterDescriptor(weight, format);
   auto cDesc = ConvDescriptor(input.type(), px, py, sx, sy, dx, dy, groups);
-  auto oDesc = TensorDescriptor(gradOutput);
+  auto oDesc = TensorDescriptor(gradOutput, format);
 
   setDefaultMathType(cDesc, input);
+  if (dataGradBenchmark) {
+    dataGradBenchmark->setCacheKey(getBenchmarkKey(
+        "conv2dBackwardData",
+        input,
+        weight,
+        sx,
+        sy,
+        px,
+        py,
+        dx,
+        dy,
+        groups,
+        format));
+  }
 
   // Gradients with respect to the input
   auto convolutionBackwardData =
@@ -398,7 +443,7 @@ Tensor CudnnAutogradExtension::conv2dBackwardData(
           FilterDescriptor& wDesc,
           ConvDescriptor& cDesc,
           TensorDescriptor& oDesc) -> Tensor {
-    if (dataGradBenchmark && DynamicBenchmark::getBenchmarkMode()) {
+    if (dataGradBenchmark && dataGradBenchmark->useOptions()) {
       setCudnnConvMathType(
           cDesc,
           dataGradBenchmark->getOptions<DynamicBenchmarkOptions<KernelMode>>());
@@ -463,7 +508,7 @@ Tensor CudnnAutogradExtension::conv2dBackwardData(
 
   Tensor dataGradOut;
 
-  if (dataGradBenchmark && DynamicBenchmark::getBenchmarkMode()) {
+  if (dataGradBenchmark && dataGradBenchmark->useOptions()) {
     KernelMode dataBwdOption =
         dataGradBenchmark->getOptions<DynamicBenchmarkOptions<KernelMode>>()
             ->currentOption();
@@ -491,11 +536,11 @@ Tensor CudnnAutogradExtension::conv2dBackwardData(
           },
           /* incrementCount = */ false);
 
-      auto iDescF32 = TensorDescriptor(inTensorF32);
-      auto wDescF32 = FilterDescriptor(wtTensorF32);
+      auto iDescF32 = TensorDescriptor(inTensorF32, format);
+      auto wDescF32 = FilterDescriptor(wtTensorF32, format);
       auto cDescF32 =
           ConvDescriptor(fl::dtype::f32, px, py, sx, sy, dx, dy, groups);
-      auto oDescF32 = TensorDescriptor(gradOutputTensorF32);
+      auto oDescF32 = TensorDescriptor(gradOutputTensorF32, format);
       // core bwd data computation
       dataGradBenchmark->audit([&dataGradOut,
                                 &convolutionBackwardData,
@@ -552,6 +597,7 @@ std::pair<Tensor, Tensor> CudnnAutogradExtension::conv2dBackwardFilterBias(
     const int dx,
     const int dy,
     const int groups,
+    const MemoryFormat format,
     std::shared_ptr<DynamicBenchmark> filterGradBenchmark,
     std::shared_ptr<DynamicBenchmark> biasGradBenchmark,
     std::shared_ptr<detail::AutogradPayload>) {
@@ -567,12 +613,40 @@ std::pair<Tensor, Tensor> CudnnAutogradExtension::conv2dBackwardFilterBias(
   // benchmarking suggests input or weight casting should occur, these
   // descriptors may not be used/new ones with the correct types will be
   // used instead.
-  auto iDesc = TensorDescriptor(input);
-  auto wDesc = FilterDescriptor(weight);
+  auto iDesc = TensorDescriptor(input, format);
+  auto wDesc = FilterDescriptor(weight, format);
   auto cDesc = ConvDescriptor(input.type(), px, py, sx, sy, dx, dy, groups);
-  auto oDesc = TensorDescriptor(gradOutput);
+  auto oDesc = TensorDescriptor(gradOutput, format);
 
   setDefaultMathType(cDesc, input);
+  if (filterGradBenchmark) {
+    filterGradBenchmark->setCacheKey(getBenchmarkKey(
+        "conv2dBackwardFilter",
+        input,
+        weight,
+        sx,
+        sy,
+        px,
+        py,
+        dx,
+        dy,
+        groups,
+        format));
+  }
+  if (biasGradBenchmark) {
+    biasGradBenchmark->setCacheKey(getBenchmarkKey(
+        "conv2dBackwardBias",
+        input,
+        weight,
+        sx,
+        sy,
+        px,
+        py,
+        dx,
+        dy,
+        groups,
+        format));
+  }
 
   // Gradients with respect to the filter
   auto convolutionBackwardFilter =
@@ -584,7 +658,7 @@ std::pair<Tensor, Tensor> CudnnAutogradExtension::conv2dBackwardFilterBias(
           FilterDescriptor& wDesc,
           ConvDescriptor& cDesc,
           TensorDescriptor& oDesc) -> Tensor {
-    if (filterGradBenchmark && DynamicBenchmark::getBenchmarkMode()) {
+    if (filterGradBenchmark && filterGradBenchmark->useOptions()) {
       setCudnnConvMathType(
           cDesc,
           filterGradBenchmark
@@ -650,7 +724,7 @@ std::pair<Tensor, Tensor> CudnnAutogradExtension::conv2dBackwardFilterBias(
 
   Tensor filterGradOut;
 
-  if (filterGradBenchmark && DynamicBenchmark::getBenchmarkMode()) {
+  if (filterGradBenchmark && filterGradBenchmark->useOptions()) {
     KernelMode dataBwdOption =
         filterGradBenchmark->getOptions<DynamicBenchmarkOptions<KernelMode>>()
             ->currentOption();
@@ -678,11 +752,11 @@ std::pair<Tensor, Tensor> CudnnAutogradExtension::conv2dBackwardFilterBias(
           },
           /* incrementCount = */ false);
 
-      auto iDescF32 = TensorDescriptor(inTensorF32);
-      auto wDescF32 = FilterDescriptor(wtTensorF32);
+      auto iDescF32 = TensorDescriptor(inTensorF32, format);
+      auto wDescF32 = FilterDescriptor(wtTensorF32, format);
       auto cDescF32 =
           ConvDescriptor(fl::dtype::f32, px, py, sx, sy, dx, dy, groups);
-      auto oDescF32 = TensorDescriptor(gradOutputTensorF32);
+      auto oDescF32 = TensorDescriptor(gradOutputTensorF32, format);
       // core bwd data computation
       filterGradBenchmark->audit([&filterGradOut,
                                   &convolutionBackwardFilter,
@@ -723,7 +797,7 @@ std::pair<Tensor, Tensor> CudnnAutogradExtension::conv2dBackwardFilterBias(
         input, weight, gradOutput, iDesc, wDesc, cDesc, oDesc);
   }
 
-  auto convolutionBackwardBias = [&hndl, &cudnnStream, oneg, zerog](
+  auto convolutionBackwardBias = [&hndl, &cudnnStream, oneg, zerog, format](
                                      const Tensor& bsTensor,
                                      const Tensor& gradOutput,
                                      const TensorDescriptor& oDesc) -> Tensor {
@@ -733,7 +807,7 @@ std::pair<Tensor, Tensor> CudnnAutogradExtension::conv2dBackwardFilterBias(
       DevicePtr gradResultPtr(gradOutput);
       // ensure cudnn compute stream waits on gradient tensor streams
       relativeSync(cudnnStream, {gradOutput, gradBias});
-      auto bDesc = TensorDescriptor(bsTensor);
+      auto bDesc = TensorDescriptor(bsTensor, format);
       CUDNN_CHECK_ERR(cudnnConvolutionBackwardBias(
           hndl,
           oneg,
@@ -751,7 +825,7 @@ std::pair<Tensor, Tensor> CudnnAutogradExtension::conv2dBackwardFilterBias(
   Tensor biasGradOut;
 
   if (!bias.isEmpty()) {
-    if (biasGradBenchmark && DynamicBenchmark::getBenchmarkMode()) {
+    if (biasGradBenchmark && biasGradBenchmark->useOptions()) {
       KernelMode biasBwdOption =
           biasGradBenchmark->getOptions<DynamicBenchmarkOptions<KernelMode>>()
               ->currentOption();
@@ -772,7 +846,7 @@ std::pair<Tensor, Tensor> CudnnAutogradExtension::conv2dBackwardFilterBias(
               gradOutputF32 = gradOutput.astype(fl::dtype::f32);
             },
             /* incrementCount = */ false);
-        auto oDescF32 = TensorDescriptor(gradOutputF32);
+        auto oDescF32 = TensorDescriptor(gradOutputF32, format);
         // Perform bias gradient computation
         biasGradBenchmark->audit([&biasGradOut,
                                   &convolutionBackwardBias,
@@ -37,6 +37,7 @@ class CudnnAutogradExtension : public AutogradExtension {
       const int dx,
       const int dy,
       const int groups,
+      const MemoryFormat format,
       std::shared_ptr<detail::AutogradPayload> payload) override;
 
   Tensor pool2d(
@@ -48,6 +49,7 @@ class CudnnAutogradExtension : public AutogradExtension {
       const int px,
       const int py,
       const PoolingMode mode,
+      const MemoryFormat format,
       std::shared_ptr<detail::AutogradPayload> payload) override;
 
   Tensor batchnorm(
@@ -76,6 +78,37 @@ class CudnnAutogradExtension : public AutogradExtension {
       const float dropout,
       std::shared_ptr<detail::AutogradPayload> payload) override;
 
+  bool isVariableLengthRnnSupported() const override;
+
+  std::tuple<Tensor, Tensor, Tensor> variableLengthRnn(
+      const Tensor& input,
+      const Tensor& hiddenState,
+      const Tensor& cellState,
+      const Tensor& weights,
+      const std::vector<int>& sequenceLengths,
+      const int hiddenSize,
+      const int numLayers,
+      const RnnMode mode,
+      const bool bidirectional,
+      const float dropout,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  Tensor softmax(
+      const Tensor& input,
+      const int axis,
+      const bool log,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  Tensor layerNorm(
+      Tensor& saveMean,
+      Tensor& saveRstd,
+      const Tensor& input,
+      const Tensor& weight,
+      const Tensor& bias,
+      const int numAxes,
+      const double epsilon,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
   /**************************** Backward ****************************/
   // ]----- Convolution
   Tensor conv2dBackwardData(
@@ -89,6 +122,7 @@ class CudnnAutogradExtension : public AutogradExtension {
       const int dx,
       const int dy,
       const int groups,
+      const MemoryFormat format,
       std::shared_ptr<DynamicBenchmark> dataGradBenchmark,
       std::shared_ptr<detail::AutogradPayload> payload) override;
 
@@ -104,6 +138,7 @@ class CudnnAutogradExtension : public AutogradExtension {
       const int dx,
       const int dy,
       const int groups,
+      const MemoryFormat format,
       std::shared_ptr<DynamicBenchmark> filterBench,
       std::shared_ptr<DynamicBenchmark> biasBench,
       std::shared_ptr<detail::AutogradPayload> autogradPayload) override;
@@ -120,6 +155,7 @@ class CudnnAutogradExtension : public AutogradExtension {
       const int px,
       const int py,
       const PoolingMode mode,
+      const MemoryFormat format,
       std::shared_ptr<detail::AutogradPayload> payload) override;
 
   // ]----- batchnorm
@@ -148,6 +184,40 @@ class CudnnAutogradExtension : public AutogradExtension {
       const bool bidirectional,
       const float dropProb,
       std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  std::tuple<Tensor, Tensor, Tensor, Tensor> variableLengthRnnBackward(
+      const Tensor& input,
+      const Tensor& hiddenState,
+      const Tensor& cellState,
+      const Tensor& weights,
+      const std::vector<int>& sequenceLengths,
+      const std::shared_ptr<detail::RNNGradData> gradData,
+      const Tensor& output,
+      const int numLayers,
+      const int hiddenSize,
+      const RnnMode mode,
+      const bool bidirectional,
+      const float dropProb,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  // ]----- softmax
+  Tensor softmaxBackward(
+      const Tensor& gradOutput,
+      const Tensor& output,
+      const int axis,
+      const bool log,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  // ]----- layerNorm
+  std::tuple<Tensor, Tensor, Tensor> layerNormBackward(
+      const Tensor& gradOutput,
+      const Tensor& saveMean,
+      const Tensor& saveRstd,
+      const Tensor& input,
+      const Tensor& weight,
+      const int numAxes,
+      const double epsilon,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
 };
 
 } // namespace fl
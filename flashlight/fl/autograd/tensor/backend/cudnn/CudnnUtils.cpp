@@ -59,14 +59,7 @@ const DeviceHandle& getActiveDeviceHandle() {
   int id = cudaDevice.nativeId();
   // lazily initialize cuda stream for cudnn
   if (handles.count(id) == 0) {
-#ifdef NO_CUDNN_DESTROY_HANDLE
-    // NOTE unmanaged so to avoid CUDA driver shut down prior to stream
-    // destruction. This is safe because this object is always part of a global
-    // map -- the resource won't be relased until program shutdown anyway.
-    auto stream = fl::CUDAStream::createUnmanaged();
-#else
-    auto stream = fl::CUDAStream::createManaged();
-#endif
+    auto stream = cudaDevice.getCUDAStreamFromPool(fl::StreamPriority::Low);
     handles.emplace(id, DeviceHandle(stream));
   }
   return handles.at(id);
@@ -161,7 +154,9 @@ TensorDescriptor::TensorDescriptor(const fl::dtype type, const Shape& flDims) {
       descriptor, cudnntype, dims.size(), dims.data(), strides.data()));
 }
 
-TensorDescriptor::TensorDescriptor(const Tensor& input) {
+TensorDescriptor::TensorDescriptor(
+    const Tensor& input,
+    const MemoryFormat format /* = MemoryFormat::WHCN */) {
   CUDNN_CHECK_ERR(cudnnCreateTensorDescriptor(&descriptor));
   cudnnDataType_t cudnntype = cudnnMapToType(input.type());
 
@@ -181,6 +176,12 @@ TensorDescriptor::TensorDescriptor(const Tensor& input) {
     dims[3 - i] = flDims[i];
   }
 
+  if (format == MemoryFormat::CWHN) {
+    // {N, H, W, C} -> {N, C, H, W}, whose strides make the descriptor NHWC
+    dims = {dims[0], dims[3], dims[1], dims[2]};
+    strides = {strides[0], strides[3], strides[1], strides[2]};
+  }
+
   CUDNN_CHECK_ERR(cudnnSetTensorNdDescriptor(
       descriptor /* descriptor handle */,
       cudnntype /* = dataType */,
@@ -235,7 +236,9 @@ PoolingDescriptor::~PoolingDescriptor() {
   CUDNN_CHECK_ERR(cudnnDestroyPoolingDescriptor(descriptor));
 }
 
-FilterDescriptor::FilterDescriptor(const Tensor& input) {
+FilterDescriptor::FilterDescriptor(
+    const Tensor& input,
+    const MemoryFormat format /* = MemoryFormat::WHCN */) {
   CUDNN_CHECK_ERR(cudnnCreateFilterDescriptor(&descriptor));
   cudnnDataType_t cudnntype = cudnnMapToType(input.type());
 
@@ -247,8 +250,15 @@ FilterDescriptor::FilterDescriptor(const Tensor& input) {
     dims[3 - i] = flDims[i];
   }
 
+  auto tensorFormat = CUDNN_TENSOR_NCHW;
+  if (format == MemoryFormat::CWHN) {
+    // the dims of a filter are always given in KCHW order
+    dims = {dims[0], dims[3], dims[1], dims[2]};
+    tensorFormat = CUDNN_TENSOR_NHWC;
+  }
+
   CUDNN_CHECK_ERR(cudnnSetFilterNdDescriptor(
-      descriptor, cudnntype, CUDNN_TENSOR_NCHW, 4, dims.data()));
+      descriptor, cudnntype, tensorFormat, 4, dims.data()));
 }
 
 FilterDescriptor::~FilterDescriptor() {
@@ -343,6 +353,27 @@ RNNDescriptor::~RNNDescriptor() {
   CUDNN_CHECK_ERR(cudnnDestroyRNNDescriptor(descriptor));
 }
 
+RNNDataDescriptor::RNNDataDescriptor(
+    fl::dtype type,
+    int maxSeqLength,
+    int vectorSize,
+    const std::vector<int>& seqLengths) {
+  CUDNN_CHECK_ERR(cudnnCreateRNNDataDescriptor(&descriptor));
+  CUDNN_CHECK_ERR(cudnnSetRNNDataDescriptor(
+      descriptor,
+      cudnnMapToType(type),
+      CUDNN_RNN_DATA_LAYOUT_SEQ_MAJOR_UNPACKED,
+      maxSeqLength,
+      seqLengths.size(),
+      vectorSize,
+      seqLengths.data(),
+      /* paddingFill = */ nullptr));
+}
+
+RNNDataDescriptor::~RNNDataDescriptor() {
+  CUDNN_CHECK_ERR(cudnnDestroyRNNDataDescriptor(descriptor));
+}
+
 ConvDescriptor::ConvDescriptor(
     fl::dtype type,
     int px,
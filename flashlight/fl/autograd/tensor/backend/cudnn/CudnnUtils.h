@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include <cudnn.h>
 
 #include "flashlight/fl/common/Defines.h"
@@ -17,7 +19,10 @@ namespace fl {
 
 class TensorDescriptor {
  public:
-  explicit TensorDescriptor(const Tensor& a);
+  // The descriptor of an image of the given layout, with cuDNN's NCHW dims
+  explicit TensorDescriptor(
+      const Tensor& a,
+      const MemoryFormat format = MemoryFormat::WHCN);
 
   TensorDescriptor(const fl::dtype type, const Shape& af_dims);
 
@@ -39,7 +44,9 @@ class TensorDescriptorArray {
 
 class FilterDescriptor {
  public:
-  explicit FilterDescriptor(const Tensor& a);
+  explicit FilterDescriptor(
+      const Tensor& a,
+      const MemoryFormat format = MemoryFormat::WHCN);
   cudnnFilterDescriptor_t descriptor;
   ~FilterDescriptor();
 };
@@ -95,6 +102,20 @@ class RNNDescriptor {
   ~RNNDescriptor();
 };
 
+// The descriptor of a batch of sequences of the given lengths, padded to
+// `maxSeqLength` steps and laid out as [steps, batch, features] in row-major
+// order, i.e. as the [input size, batch size, sequence length] RNN tensors
+class RNNDataDescriptor {
+ public:
+  RNNDataDescriptor(
+      fl::dtype type,
+      int maxSeqLength,
+      int vectorSize,
+      const std::vector<int>& seqLengths);
+  cudnnRNNDataDescriptor_t descriptor;
+  ~RNNDataDescriptor();
+};
+
 #define CUDNN_CHECK_ERR(expr) ::fl::cudnnCheckErr((expr))
 
 void cudnnCheckErr(cudnnStatus_t status);
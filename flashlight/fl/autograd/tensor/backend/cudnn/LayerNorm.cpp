@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/autograd/tensor/backend/cudnn/CudnnAutogradExtension.h"
+
+#include <stdexcept>
+#include <string>
+
+#include <cudnn.h>
+
+#include "flashlight/fl/autograd/tensor/backend/cudnn/CudnnUtils.h"
+#include "flashlight/fl/common/DevicePtr.h"
+
+namespace fl {
+
+namespace {
+
+// The statistics of spatial batchnorm over a single sample are those of layer
+// normalization if each slice is a channel. Views a tensor normalized along
+// its first `numAxes` axes as [slice, 1, rows, 1], such that the contiguous
+// data is unchanged.
+Shape getLayerNormShape(
+    const Tensor& input,
+    const int numAxes,
+    const char* caller) {
+  if (numAxes < 1 || numAxes > input.ndim()) {
+    throw std::invalid_argument(
+        std::string("[") + caller + "] invalid number of axes " +
+        std::to_string(numAxes) + " for a tensor with " +
+        std::to_string(input.ndim()) + " dimensions");
+  }
+  Dim sliceSize = 1;
+  for (int i = 0; i < numAxes; ++i) {
+    sliceSize *= input.dim(i);
+  }
+  return {sliceSize, 1, input.elements() / sliceSize, 1};
+}
+
+// Scale, shift and statistics can't be fp16 (must be fp32)
+fl::dtype getScalarsType(const Tensor& input) {
+  return input.type() == fl::dtype::f16 ? fl::dtype::f32 : input.type();
+}
+
+// Views `x` as [slice, rows] to broadcast per-row statistics or per-element
+// weights over it
+Tensor asSlices(const Tensor& x, const Shape& shape) {
+  return fl::reshape(x, {shape[0], shape[2]});
+}
+
+} // namespace
+
+Tensor CudnnAutogradExtension::layerNorm(
+    Tensor& saveMean,
+    Tensor& saveRstd,
+    const Tensor& inputIn,
+    const Tensor& weight,
+    const Tensor& bias,
+    const int numAxes,
+    const double epsilon,
+    std::shared_ptr<detail::AutogradPayload>) {
+  auto input = inputIn.asContiguousTensor();
+  auto shape =
+      getLayerNormShape(input, numAxes, "CudnnAutogradExtension::layerNorm");
+  const Dim sliceSize = shape[0];
+  const Dim rows = shape[2];
+  const auto scalarsType = getScalarsType(input);
+
+  auto output = Tensor(input.shape(), input.type());
+  // the per-channel affine transform of batchnorm is the identity, and the
+  // per-element one of layer normalization is applied to its output
+  auto ones = fl::full({rows}, 1.0, scalarsType);
+  auto zeros = fl::full({rows}, 0.0, scalarsType);
+  saveMean = Tensor({rows}, scalarsType);
+  saveRstd = Tensor({rows}, scalarsType);
+
+  auto inDesc = TensorDescriptor(input.type(), shape);
+  auto wtDesc = TensorDescriptor(scalarsType, {1, 1, rows});
+  {
+    DevicePtr inRaw(input);
+    DevicePtr outRaw(output);
+    DevicePtr onesRaw(ones);
+    DevicePtr zerosRaw(zeros);
+    DevicePtr saveMeanRaw(saveMean);
+    DevicePtr saveRstdRaw(saveRstd);
+    const auto& cudnnStream = getCudnnStream();
+    // ensure cudnn compute stream waits on streams of input/output tensors
+    relativeSync(
+        cudnnStream, {input, output, ones, zeros, saveMean, saveRstd});
+
+    CUDNN_CHECK_ERR(cudnnBatchNormalizationForwardTraining(
+        getCudnnHandle(),
+        CUDNN_BATCHNORM_SPATIAL,
+        kOne(scalarsType),
+        kZero(scalarsType),
+        inDesc.descriptor,
+        inRaw.get(),
+        inDesc.descriptor,
+        outRaw.get(),
+        wtDesc.descriptor,
+        onesRaw.get(),
+        zerosRaw.get(),
+        /* exponentialAverageFactor = */ 0.0,
+        /* resultRunningMean = */ nullptr,
+        /* resultRunningVariance = */ nullptr,
+        epsilon,
+        saveMeanRaw.get(),
+        saveRstdRaw.get()));
+
+    // ensure output stream waits on cudnn compute stream
+    relativeSync({output, saveMean, saveRstd}, cudnnStream);
+  }
+
+  if (weight.isEmpty() && bias.isEmpty()) {
+    return output;
+  }
+  auto slices = asSlices(output, shape);
+  if (!weight.isEmpty()) {
+    slices = slices *
+        fl::tile(
+            fl::reshape(weight, {sliceSize, 1}).astype(input.type()),
+            {1, rows});
+  }
+  if (!bias.isEmpty()) {
+    slices = slices +
+        fl::tile(
+            fl::reshape(bias, {sliceSize, 1}).astype(input.type()), {1, rows});
+  }
+  return fl::reshape(slices, input.shape());
+}
+
+std::tuple<Tensor, Tensor, Tensor> CudnnAutogradExtension::layerNormBackward(
+    const Tensor& gradOutputIn,
+    const Tensor& saveMean,
+    const Tensor& saveRstd,
+    const Tensor& inputIn,
+    const Tensor& weight,
+    const int numAxes,
+    const double epsilon,
+    std::shared_ptr<detail::AutogradPayload>) {
+  auto input = inputIn.asContiguousTensor();
+  auto shape = getLayerNormShape(
+      input, numAxes, "CudnnAutogradExtension::layerNormBackward");
+  const Dim sliceSize = shape[0];
+  const Dim rows = shape[2];
+  const auto scalarsType = getScalarsType(input);
+
+  auto gradOutput = asSlices(gradOutputIn, shape);
+  // gradients of the per-element affine transform
+  auto normalized =
+      (asSlices(input, shape).astype(scalarsType) -
+       fl::tile(fl::reshape(saveMean, {1, rows}), {sliceSize, 1})) *
+      fl::tile(fl::reshape(saveRstd, {1, rows}), {sliceSize, 1});
+  auto gradWeight =
+      fl::sum(gradOutput.astype(scalarsType) * normalized, {1});
+  auto gradBias = fl::sum(gradOutput.astype(scalarsType), {1});
+  auto gradNormalized = weight.isEmpty()
+      ? gradOutput.asContiguousTensor()
+      : (gradOutput *
+         fl::tile(
+             fl::reshape(weight, {sliceSize, 1}).astype(input.type()),
+             {1, rows}))
+            .asContiguousTensor();
+
+  auto ones = fl::full({rows}, 1.0, scalarsType);
+  auto iDesc = TensorDescriptor(input.type(), shape);
+  auto wDesc = TensorDescriptor(scalarsType, {1, 1, rows});
+  auto gradIn = Tensor(input.shape(), input.type());
+  // CuDNN doesn't support calculating only the gradients required
+  auto gradScale = Tensor({rows}, scalarsType);
+  auto gradShift = Tensor({rows}, scalarsType);
+  {
+    DevicePtr iRaw(input);
+    DevicePtr onesRaw(ones);
+    DevicePtr gradInRaw(gradIn);
+    DevicePtr gradScaleRaw(gradScale);
+    DevicePtr gradShiftRaw(gradShift);
+    DevicePtr gradNormalizedRaw(gradNormalized);
+    DevicePtr saveMeanRaw(saveMean);
+    DevicePtr saveRstdRaw(saveRstd);
+    const auto& cudnnStream = getCudnnStream();
+    // ensure cudnn compute stream waits on streams of input/output tensors
+    relativeSync(
+        cudnnStream,
+        {input,
+         gradNormalized,
+         gradIn,
+         ones,
+         gradScale,
+         gradShift,
+         saveMean,
+         saveRstd});
+
+    CUDNN_CHECK_ERR(cudnnBatchNormalizationBackward(
+        getCudnnHandle(),
+        CUDNN_BATCHNORM_SPATIAL,
+        kOne(scalarsType),
+        kZero(scalarsType),
+        kOne(scalarsType),
+        kZero(scalarsType),
+        iDesc.descriptor,
+        iRaw.get(),
+        iDesc.descriptor,
+        gradNormalizedRaw.get(),
+        iDesc.descriptor,
+        gradInRaw.get(),
+        wDesc.descriptor,
+        onesRaw.get(),
+        gradScaleRaw.get(),
+        gradShiftRaw.get(),
+        epsilon,
+        saveMeanRaw.get(),
+        saveRstdRaw.get()));
+    // ensure streams of gradients wait on the cudnn compute stream
+    relativeSync({gradIn}, cudnnStream);
+  }
+
+  return std::make_tuple(gradIn, gradWeight, gradBias);
+}
+
+} // namespace fl
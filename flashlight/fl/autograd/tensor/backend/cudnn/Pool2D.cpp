@@ -23,25 +23,25 @@ Tensor CudnnAutogradExtension::pool2d(
     const int px,
     const int py,
     const PoolingMode mode,
+    const MemoryFormat format,
     std::shared_ptr<detail::AutogradPayload>) {
-  auto inDesc = TensorDescriptor(input);
+  auto inDesc = TensorDescriptor(input, format);
 
   // init pooling descriptor
   auto poolDesc = PoolingDescriptor(wx, wy, sx, sy, px, py, mode);
 
   // init output descriptor
-  auto ix = input.dim(0);
-  auto iy = input.ndim() < 2 ? 1 : input.dim(1);
+  const bool channelsLast = format == MemoryFormat::CWHN;
+  auto dim = [&input](int i) { return input.ndim() <= i ? 1 : input.dim(i); };
+  auto ix = dim(channelsLast ? 1 : 0);
+  auto iy = dim(channelsLast ? 2 : 1);
   auto ox = 1 + (ix + 2 * px - wx) / sx;
   auto oy = 1 + (iy + 2 * py - wy) / sy;
 
-  auto output = Tensor(
-      {ox,
-       oy,
-       input.ndim() < 3 ? 1 : input.dim(2),
-       input.ndim() < 4 ? 1 : input.dim(3)},
-      input.type());
-  auto outDesc = TensorDescriptor(output);
+  auto output = channelsLast
+      ? Tensor({dim(0), ox, oy, dim(3)}, input.type())
+      : Tensor({ox, oy, dim(2), dim(3)}, input.type());
+  auto outDesc = TensorDescriptor(output, format);
   {
     DevicePtr inputraw(input);
     DevicePtr resultraw(output);
@@ -81,9 +81,10 @@ Tensor CudnnAutogradExtension::pool2dBackward(
     const int px,
     const int py,
     const PoolingMode mode,
+    const MemoryFormat format,
     std::shared_ptr<detail::AutogradPayload>) {
-  auto i_desc = TensorDescriptor(input);
-  auto o_desc = TensorDescriptor(poolOutput);
+  auto i_desc = TensorDescriptor(input, format);
+  auto o_desc = TensorDescriptor(poolOutput, format);
   auto p_desc = PoolingDescriptor(wx, wy, sx, sy, px, py, mode);
 
   auto gradInput = Tensor(input.shape(), input.type());
@@ -55,6 +55,49 @@ struct CudnnRnnAutogradPayload : public detail::AutogradPayloadData {
   Tensor reserveSpace;
 };
 
+// Descriptors of the RNN data and states of variable-length sequences, for
+// the *Ex cuDNN RNN functions
+struct VariableLengthRnnDescriptors {
+  DropoutDescriptor dropout;
+  RNNDescriptor rnn;
+  TensorDescriptorArray xs; // for the workspace and parameter sizes
+  RNNDataDescriptor x;
+  RNNDataDescriptor y;
+  TensorDescriptor h;
+  size_t workspaceSize;
+
+  VariableLengthRnnDescriptors(
+      const Tensor& input,
+      const std::vector<int>& sequenceLengths,
+      const int hiddenSize,
+      const int numLayers,
+      const RnnMode mode,
+      const bool bidirectional,
+      const float dropProb)
+      : dropout(dropProb),
+        rnn(input.type(), hiddenSize, numLayers, mode, bidirectional, dropout),
+        xs(input.dim(2),
+           input.type(),
+           {1, 1, input.dim(0), static_cast<Dim>(sequenceLengths.size())}),
+        x(input.type(), input.dim(2), input.dim(0), sequenceLengths),
+        y(input.type(),
+          input.dim(2),
+          hiddenSize * (bidirectional ? 2 : 1),
+          sequenceLengths),
+        h(input.type(),
+          {1,
+           hiddenSize,
+           static_cast<Dim>(sequenceLengths.size()),
+           numLayers * (bidirectional ? 2 : 1)}) {
+    setCudnnRnnMathType(input, rnn);
+    // the steps past the length of each sample are padding
+    CUDNN_CHECK_ERR(
+        cudnnSetRNNPaddingMode(rnn.descriptor, CUDNN_RNN_PADDED_IO_ENABLED));
+    workspaceSize =
+        getWorkspaceSize(getCudnnHandle(), rnn, input.dim(2), xs);
+  }
+};
+
 } // namespace
 
 std::tuple<Tensor, Tensor, Tensor> CudnnAutogradExtension::rnn(
@@ -372,4 +415,275 @@ std::tuple<Tensor, Tensor, Tensor, Tensor> CudnnAutogradExtension::rnnBackward(
   return std::make_tuple(dx, dhx, dcx, dw);
 }
 
+bool CudnnAutogradExtension::isVariableLengthRnnSupported() const {
+  return true;
+}
+
+std::tuple<Tensor, Tensor, Tensor> CudnnAutogradExtension::variableLengthRnn(
+    const Tensor& input,
+    const Tensor& hiddenStateIn,
+    const Tensor& cellStateIn,
+    const Tensor& weights,
+    const std::vector<int>& sequenceLengths,
+    const int hiddenSize,
+    const int numLayers,
+    const RnnMode mode,
+    const bool bidirectional,
+    const float dropProb,
+    std::shared_ptr<detail::AutogradPayload> autogradPayload) {
+  FL_TENSOR_DTYPES_MATCH_CHECK(input, hiddenStateIn, cellStateIn, weights);
+  if (input.ndim() != 3 || input.dim(1) != sequenceLengths.size()) {
+    throw std::invalid_argument(
+        "CudnnAutogradExtension::variableLengthRnn expected an input of "
+        "shape [input size, batch size, sequence length] with a sequence "
+        "length per sample");
+  }
+
+  auto payload = std::make_shared<CudnnRnnAutogradPayload>();
+  if (autogradPayload) {
+    autogradPayload->data = payload;
+  }
+
+  Tensor x = input.asContiguousTensor();
+  Tensor hiddenState = hiddenStateIn.asContiguousTensor();
+  Tensor cellState = cellStateIn.asContiguousTensor();
+  Tensor contiguousWeights = weights.asContiguousTensor();
+
+  const int batchSize = x.dim(1);
+  const int seqLength = x.dim(2);
+  const int totalLayers = numLayers * (bidirectional ? 2 : 1);
+  const int outSize = hiddenSize * (bidirectional ? 2 : 1);
+  const Shape hShape = {hiddenSize, batchSize, totalLayers};
+  if (!hiddenState.isEmpty() && hiddenState.elements() != hShape.elements()) {
+    throw std::invalid_argument("invalid hidden state dims for RNN");
+  }
+  if (!cellState.isEmpty() &&
+      !(mode == RnnMode::LSTM && cellState.elements() == hShape.elements())) {
+    throw std::invalid_argument("invalid cell state dims for RNN");
+  }
+
+  VariableLengthRnnDescriptors descs(
+      x,
+      sequenceLengths,
+      hiddenSize,
+      numLayers,
+      mode,
+      bidirectional,
+      dropProb);
+
+  auto handle = getCudnnHandle();
+  const auto& cudnnStream = getCudnnStream();
+
+  size_t paramSize;
+  CUDNN_CHECK_ERR(cudnnGetRNNParamsSize(
+      handle,
+      descs.rnn.descriptor,
+      descs.xs.descriptors[0],
+      &paramSize,
+      cudnnMapToType(weights.type())));
+  if (paramSize != weights.bytes()) {
+    throw std::invalid_argument(
+        "invalid # of parameters or wrong input shape for RNN");
+  }
+  FilterDescriptor wDesc(contiguousWeights);
+
+  // cuDNN leaves the output past the length of each sample
+  Tensor y = fl::full({outSize, batchSize, seqLength}, 0, x.type());
+  Tensor hy(hShape, x.type());
+  Tensor cy;
+  if (mode == RnnMode::LSTM) {
+    cy = Tensor(hShape, x.type());
+  }
+
+  size_t reserveSize =
+      getReserveSize(handle, descs.rnn, seqLength, descs.xs);
+  Tensor workspace(
+      {static_cast<long long>(descs.workspaceSize)}, fl::dtype::b8);
+  // Space must be reused between forward and backward for cuDNN
+  payload->reserveSpace =
+      Tensor({static_cast<long long>(reserveSize)}, fl::dtype::b8);
+
+  {
+    DevicePtr xRaw(x);
+    DevicePtr hxRaw(hiddenState);
+    DevicePtr cxRaw(cellState);
+    DevicePtr wRaw(contiguousWeights);
+    DevicePtr yRaw(y);
+    DevicePtr hyRaw(hy);
+    DevicePtr cyRaw(cy);
+    DevicePtr workspaceRaw(workspace);
+    DevicePtr reserveSpaceRaw(payload->reserveSpace);
+    // ensure cudnn compute stream waits on input/output tensor streams
+    relativeSync(cudnnStream, {
+      x, hiddenState, cellState, contiguousWeights, y, hy, cy, workspace,
+      payload->reserveSpace,
+    });
+
+    CUDNN_CHECK_ERR(cudnnRNNForwardTrainingEx(
+        handle,
+        descs.rnn.descriptor,
+        descs.x.descriptor,
+        xRaw.get(),
+        descs.h.descriptor,
+        hxRaw.get(),
+        descs.h.descriptor,
+        cxRaw.get(),
+        wDesc.descriptor,
+        wRaw.get(),
+        descs.y.descriptor,
+        yRaw.get(),
+        descs.h.descriptor,
+        hyRaw.get(),
+        descs.h.descriptor,
+        cyRaw.get(),
+        /* kDesc = */ nullptr,
+        /* keys = */ nullptr,
+        /* cDesc = */ nullptr,
+        /* cAttn = */ nullptr,
+        /* iDesc = */ nullptr,
+        /* iAttn = */ nullptr,
+        /* qDesc = */ nullptr,
+        /* queries = */ nullptr,
+        workspaceRaw.get(),
+        descs.workspaceSize,
+        reserveSpaceRaw.get(),
+        reserveSize));
+  }
+
+  // ensure output tensor streams wait on cudnn compute stream
+  relativeSync({y, hy, cy}, cudnnStream);
+  return std::make_tuple(y, hy, cy);
+}
+
+std::tuple<Tensor, Tensor, Tensor, Tensor>
+CudnnAutogradExtension::variableLengthRnnBackward(
+    const Tensor& input,
+    const Tensor& hiddenState,
+    const Tensor& cellState,
+    const Tensor& weights,
+    const std::vector<int>& sequenceLengths,
+    const std::shared_ptr<detail::RNNGradData> gradData,
+    const Tensor& output,
+    const int numLayers,
+    const int hiddenSize,
+    const RnnMode mode,
+    const bool bidirectional,
+    const float dropProb,
+    std::shared_ptr<detail::AutogradPayload> autogradPayload) {
+  if (!autogradPayload) {
+    throw std::invalid_argument(
+        "CudnnAutogradExtension::variableLengthRnnBackward given null "
+        "detail::AutogradPayload");
+  }
+  auto payload =
+      std::static_pointer_cast<CudnnRnnAutogradPayload>(autogradPayload->data);
+
+  auto handle = getCudnnHandle();
+  const auto& cudnnStream = getCudnnStream();
+
+  auto x = input.asContiguousTensor();
+  auto& y = output;
+  VariableLengthRnnDescriptors descs(
+      x,
+      sequenceLengths,
+      hiddenSize,
+      numLayers,
+      mode,
+      bidirectional,
+      dropProb);
+  FilterDescriptor wDesc(weights);
+
+  auto& dy = gradData->dy;
+  if (dy.isEmpty()) {
+    dy = fl::full(y.shape(), 0.0, y.type());
+  }
+  auto& dhy = gradData->dhy;
+  auto& dcy = gradData->dcy;
+
+  // cuDNN leaves the gradients past the length of each sample
+  Tensor dx = fl::full(x.shape(), 0, x.type());
+  Tensor dhx(hiddenState.shape(), hiddenState.type());
+  Tensor dcx(cellState.shape(), cellState.type());
+  Tensor dw = fl::full(weights.shape(), 0, weights.type());
+  FilterDescriptor dwDesc(dw);
+
+  Tensor workspace(
+      {static_cast<long long>(descs.workspaceSize)}, fl::dtype::b8);
+
+  {
+    DevicePtr xRaw(x);
+    DevicePtr yRaw(y);
+    DevicePtr dyRaw(dy);
+    DevicePtr dhyRaw(dhy);
+    DevicePtr dcyRaw(dcy);
+    DevicePtr wRaw(weights);
+    DevicePtr hxRaw(hiddenState);
+    DevicePtr cxRaw(cellState);
+    DevicePtr dxRaw(dx);
+    DevicePtr dhxRaw(dhx);
+    DevicePtr dcxRaw(dcx);
+    DevicePtr dwRaw(dw);
+    DevicePtr workspaceRaw(workspace);
+    DevicePtr reserveSpaceRaw(payload->reserveSpace);
+    // ensure cudnn compute stream waits on input/output tensor streams
+    relativeSync(cudnnStream, {
+      x, y, dy, dhy, dcy, weights, hiddenState, cellState, dx, dhx, dcx, dw,
+      workspace, payload->reserveSpace,
+    });
+
+    // updates the reserve space, also if only the weight gradients are needed
+    CUDNN_CHECK_ERR(cudnnRNNBackwardDataEx(
+        handle,
+        descs.rnn.descriptor,
+        descs.y.descriptor,
+        yRaw.get(),
+        descs.y.descriptor,
+        dyRaw.get(),
+        /* dcDesc = */ nullptr,
+        /* dcAttn = */ nullptr,
+        descs.h.descriptor,
+        dhyRaw.get(),
+        descs.h.descriptor,
+        dcyRaw.get(),
+        wDesc.descriptor,
+        wRaw.get(),
+        descs.h.descriptor,
+        hxRaw.get(),
+        descs.h.descriptor,
+        cxRaw.get(),
+        descs.x.descriptor,
+        dxRaw.get(),
+        descs.h.descriptor,
+        dhxRaw.get(),
+        descs.h.descriptor,
+        dcxRaw.get(),
+        /* dkDesc = */ nullptr,
+        /* dkeys = */ nullptr,
+        workspaceRaw.get(),
+        descs.workspaceSize,
+        reserveSpaceRaw.get(),
+        payload->reserveSpace.bytes()));
+
+    CUDNN_CHECK_ERR(cudnnRNNBackwardWeightsEx(
+        handle,
+        descs.rnn.descriptor,
+        descs.x.descriptor,
+        xRaw.get(),
+        descs.h.descriptor,
+        hxRaw.get(),
+        descs.y.descriptor,
+        yRaw.get(),
+        workspaceRaw.get(),
+        descs.workspaceSize,
+        dwDesc.descriptor,
+        dwRaw.get(),
+        reserveSpaceRaw.get(),
+        payload->reserveSpace.bytes()));
+  }
+
+  // ensure output tensor streams wait on cudnn compute stream
+  relativeSync({dx, dhx, dcx, dw}, cudnnStream);
+  return std::make_tuple(dx, dhx, dcx, dw);
+}
+
 } // namespace fl
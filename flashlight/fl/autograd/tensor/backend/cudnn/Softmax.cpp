@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/autograd/tensor/backend/cudnn/CudnnAutogradExtension.h"
+
+#include <stdexcept>
+
+#include "flashlight/fl/autograd/tensor/backend/cudnn/CudnnUtils.h"
+#include "flashlight/fl/common/DevicePtr.h"
+
+namespace fl {
+
+namespace {
+
+// cuDNN normalizes along channels, which are the second slowest axis. Views
+// a tensor normalized along `axis` as [inner, 1, axis, outer], such that the
+// contiguous data is unchanged.
+Shape getSoftmaxShape(const Shape& shape, const int axis, const char* caller) {
+  if (axis < 0 || axis >= shape.ndim()) {
+    throw std::invalid_argument(
+        std::string("[") + caller + "] invalid axis " + std::to_string(axis) +
+        " for a tensor with " + std::to_string(shape.ndim()) + " dimensions");
+  }
+  Dim inner = 1;
+  for (int i = 0; i < axis; ++i) {
+    inner *= shape[i];
+  }
+  Dim outer = 1;
+  for (int i = axis + 1; i < shape.ndim(); ++i) {
+    outer *= shape[i];
+  }
+  return {inner, 1, shape[axis], outer};
+}
+
+cudnnSoftmaxAlgorithm_t getSoftmaxAlgorithm(const bool log) {
+  return log ? CUDNN_SOFTMAX_LOG : CUDNN_SOFTMAX_ACCURATE;
+}
+
+} // namespace
+
+Tensor CudnnAutogradExtension::softmax(
+    const Tensor& inputIn,
+    const int axis,
+    const bool log,
+    std::shared_ptr<detail::AutogradPayload>) {
+  auto input = inputIn.asContiguousTensor();
+  auto desc = TensorDescriptor(
+      input.type(),
+      getSoftmaxShape(input.shape(), axis, "CudnnAutogradExtension::softmax"));
+  auto output = Tensor(input.shape(), input.type());
+  {
+    DevicePtr inputraw(input);
+    DevicePtr outputraw(output);
+    const auto& cudnnStream = getCudnnStream();
+    // ensure cudnn compute stream waits on streams of input/output tensors
+    relativeSync(cudnnStream, {input, output});
+
+    CUDNN_CHECK_ERR(cudnnSoftmaxForward(
+        getCudnnHandle(),
+        getSoftmaxAlgorithm(log),
+        CUDNN_SOFTMAX_MODE_CHANNEL,
+        kOne(input.type()),
+        desc.descriptor,
+        inputraw.get(),
+        kZero(input.type()),
+        desc.descriptor,
+        outputraw.get()));
+
+    // ensure output tensor stream waits on cudnn compute stream
+    relativeSync({output}, cudnnStream);
+  }
+  return output;
+}
+
+Tensor CudnnAutogradExtension::softmaxBackward(
+    const Tensor& gradOutputIn,
+    const Tensor& outputIn,
+    const int axis,
+    const bool log,
+    std::shared_ptr<detail::AutogradPayload>) {
+  auto gradOutput = gradOutputIn.asContiguousTensor();
+  auto output = outputIn.asContiguousTensor();
+  auto desc = TensorDescriptor(
+      output.type(),
+      getSoftmaxShape(
+          output.shape(), axis, "CudnnAutogradExtension::softmaxBackward"));
+  auto gradInput = Tensor(output.shape(), output.type());
+  {
+    DevicePtr outputraw(output);
+    DevicePtr gradoutputraw(gradOutput);
+    DevicePtr gradinputraw(gradInput);
+    const auto& cudnnStream = getCudnnStream();
+    // ensure cudnn compute stream waits on input/output tensor streams
+    relativeSync(cudnnStream, {output, gradOutput, gradInput});
+
+    CUDNN_CHECK_ERR(cudnnSoftmaxBackward(
+        getCudnnHandle(),
+        getSoftmaxAlgorithm(log),
+        CUDNN_SOFTMAX_MODE_CHANNEL,
+        kOne(output.type()),
+        desc.descriptor,
+        outputraw.get(),
+        desc.descriptor,
+        gradoutputraw.get(),
+        kZero(output.type()),
+        desc.descriptor,
+        gradinputraw.get()));
+
+    // ensure gradient input tensor stream waits on cudnn compute stream
+    relativeSync({gradInput}, cudnnStream);
+  }
+  return gradInput;
+}
+
+} // namespace fl
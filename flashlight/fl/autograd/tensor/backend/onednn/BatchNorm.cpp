@@ -15,6 +15,7 @@
 
 #include "flashlight/fl/autograd/tensor/backend/onednn/DnnlUtils.h"
 #include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/backend/onednn/PrimitiveCache.h"
 
 namespace fl {
 
@@ -173,12 +174,20 @@ Tensor OneDnnAutogradExtension::batchnorm(
       ? dnnl::normalization_flags::none
       : dnnl::normalization_flags::use_global_stats;
   flag = flag | dnnl::normalization_flags::use_scale_shift;
-  auto fwdDesc = dnnl::batch_normalization_forward::desc(
-      kind, inputOutputMemDesc, epsilon, flag);
-  payload->fwdPrimDesc =
-      dnnl::batch_normalization_forward::primitive_desc(fwdDesc, dnnlEngine);
+  auto [fwdPrimDesc, bn] =
+      detail::OneDnnPrimitiveCache::getInstance()
+          .get<dnnl::batch_normalization_forward>(
+              detail::OneDnnPrimitiveKey("batchnormForward")
+                  << kind << inputOutputMemDesc << epsilon << flag
+                  << dnnlEngine,
+              [&]() {
+                auto fwdDesc = dnnl::batch_normalization_forward::desc(
+                    kind, inputOutputMemDesc, epsilon, flag);
+                return dnnl::batch_normalization_forward::primitive_desc(
+                    fwdDesc, dnnlEngine);
+              });
+  payload->fwdPrimDesc = fwdPrimDesc;
   payload->outputMemoryDescriptor = outputMemory.getDescriptor();
-  auto bn = dnnl::batch_normalization_forward(payload->fwdPrimDesc);
   std::unordered_map<int, dnnl::memory> bnFwdArgs = {
       {DNNL_ARG_SRC, inputMemory.getMemory()},
       {DNNL_ARG_MEAN, meanMemory.getMemory()},
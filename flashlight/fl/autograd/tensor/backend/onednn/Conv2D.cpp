@@ -15,6 +15,9 @@
 #include <dnnl.hpp>
 
 #include "flashlight/fl/autograd/tensor/backend/onednn/DnnlUtils.h"
+#include "flashlight/fl/tensor/backend/onednn/OneDnnTensor.h"
+#include "flashlight/fl/tensor/backend/onednn/PrimitiveCache.h"
+#include "flashlight/fl/tensor/backend/onednn/Utils.h"
 
 using namespace dnnl;
 
@@ -22,19 +25,46 @@ namespace fl {
 
 namespace {
 
-// Input, output: WHCN; weights: WHIO
-constexpr size_t kWIdx = 0;
-constexpr size_t kHIdx = 1;
-constexpr size_t kIOChannelSizeIdx = 2;
 constexpr size_t kIOBatchSizeIdx = 3;
 constexpr size_t kWeightOutputChannelSizeIdx = 3;
 
 // Use memory::format_tag::any for memory formatting even if convolution
 // inputs are shaped in a particular way.
 constexpr auto formatAny = memory::format_tag::any;
-constexpr auto formatNCHW = memory::format_tag::nchw;
 constexpr auto formatBias = memory::format_tag::x;
 
+// The axes of the input, output and weights and their OneDNN format tags in
+// a memory format, see `convLayout`.
+struct ConvLayout {
+  size_t wIdx;
+  size_t hIdx;
+  size_t channelIdx;
+  memory::format_tag data;
+  memory::format_tag weight;
+  memory::format_tag groupedWeight;
+};
+
+// WHCN: input, output: WHCN; weights: WHIO, i.e. NCHW and OIHW row-major.
+// CWHN: input, output: CWHN; weights: IWHO, i.e. NHWC and OHWI row-major.
+ConvLayout convLayout(const MemoryFormat format) {
+  if (format == MemoryFormat::CWHN) {
+    return {
+        1,
+        2,
+        0,
+        memory::format_tag::nhwc,
+        memory::format_tag::ohwi,
+        memory::format_tag::gohwi};
+  }
+  return {
+      0,
+      1,
+      2,
+      memory::format_tag::nchw,
+      memory::format_tag::oihw,
+      memory::format_tag::goihw};
+}
+
 struct OneDnnConv2DPayload : detail::AutogradPayloadData {
   memory::dims inputDims;
   memory::dims weightDims;
@@ -52,6 +82,27 @@ struct OneDnnConv2DPayload : detail::AutogradPayloadData {
   convolution_forward::primitive_desc fwdPrimDesc;
 };
 
+// Whether given tensor is a OneDnnTensor whose memory has given dims and is
+// in a blocked layout, e.g. as left by a previous convolution.
+bool hasBlockedLayout(const Tensor& tensor, const memory::dims& dims) {
+  if (tensor.backendType() != TensorBackendType::OneDnn) {
+    return false;
+  }
+  const auto& oneDnnTensor = toOneDnnTensor(tensor);
+  return oneDnnTensor.hasBlockedLayout() &&
+      oneDnnTensor.memoryDescInAnyLayout().dims() == dims;
+}
+
+// View the memory of a OneDnnTensor in its current layout on given engine,
+// which may differ from the OneDNN backend's one.
+memory viewInAnyLayout(const Tensor& tensor, const engine& dnnlEngine) {
+  auto& oneDnnTensor = toOneDnnTensor(tensor);
+  return memory(
+      oneDnnTensor.memoryDescInAnyLayout(),
+      dnnlEngine,
+      oneDnnTensor.memoryInAnyLayout().get_data_handle());
+}
+
 } // namespace
 
 Tensor OneDnnAutogradExtension::conv2d(
@@ -65,6 +116,7 @@ Tensor OneDnnAutogradExtension::conv2d(
     const int dx,
     const int dy,
     const int groups,
+    const MemoryFormat format,
     std::shared_ptr<detail::AutogradPayload> autogradPayload) {
   if (input.type() == fl::dtype::f16) {
     throw std::runtime_error("Half precision is not supported in CPU.");
@@ -77,55 +129,56 @@ Tensor OneDnnAutogradExtension::conv2d(
   }
 
   // flashlight input, weight, and output shapes in column-major:
-  // - Input is WHCN
-  // - Weights are WHIO
-  // - Output is WHCN
+  // - Input is WHCN (CWHN)
+  // - Weights are WHIO (IWHO)
+  // - Output is WHCN (CWHN)
   // Since ArrayFire is column major, getting a raw pointer (1D
   // representation) of these shapes and viewing as if the representation is
-  // row major transposes along all axis into NCHW for the input and output
-  // and OIHW for the weights
-  auto output = Tensor(
-      {1 +
-           (input.dim(kWIdx) + (2 * px) - (1 + (weights.dim(kWIdx) - 1) * dx)) /
-               sx,
-       1 +
-           (input.dim(kHIdx) + (2 * py) - (1 + (weights.dim(kHIdx) - 1) * dy)) /
-               sy,
-       weights.dim(kWeightOutputChannelSizeIdx),
-       input.dim(kIOBatchSizeIdx)},
-      input.type());
+  // row major transposes along all axis into NCHW (NHWC) for the input and
+  // output and OIHW (OHWI) for the weights
+  const auto layout = convLayout(format);
+  const auto wIdx = layout.wIdx;
+  const auto hIdx = layout.hIdx;
+  const auto channelIdx = layout.channelIdx;
+  const Dim ox = 1 +
+      (input.dim(wIdx) + (2 * px) - (1 + (weights.dim(wIdx) - 1) * dx)) / sx;
+  const Dim oy = 1 +
+      (input.dim(hIdx) + (2 * py) - (1 + (weights.dim(hIdx) - 1) * dy)) / sy;
+  const Dim outputChannels = weights.dim(kWeightOutputChannelSizeIdx);
+  const Shape outputShape = format == MemoryFormat::CWHN
+      ? Shape({outputChannels, ox, oy, input.dim(kIOBatchSizeIdx)})
+      : Shape({ox, oy, outputChannels, input.dim(kIOBatchSizeIdx)});
   auto hasBias = bias.elements() > 0;
 
   auto dataType = detail::dnnlMapToType(input.type());
-  auto formatWeight =
-      (groups == 1) ? memory::format_tag::oihw : memory::format_tag::goihw;
+  auto formatWeight = (groups == 1) ? layout.weight : layout.groupedWeight;
 
   /********************************* Forward *******************************/
   // Create memory dims
   payload->inputDims = detail::convertToDnnlDims(
       {input.dim(kIOBatchSizeIdx),
-       input.dim(kIOChannelSizeIdx),
-       input.dim(kHIdx),
-       input.dim(kWIdx)});
+       input.dim(channelIdx),
+       input.dim(hIdx),
+       input.dim(wIdx)});
   if (groups == 1) {
     payload->weightDims = detail::convertToDnnlDims(
         {weights.dim(kWeightOutputChannelSizeIdx),
-         input.dim(kIOChannelSizeIdx),
-         weights.dim(kHIdx),
-         weights.dim(kWIdx)});
+         input.dim(channelIdx),
+         weights.dim(hIdx),
+         weights.dim(wIdx)});
   } else {
     payload->weightDims = detail::convertToDnnlDims(
         {groups,
          weights.dim(kWeightOutputChannelSizeIdx) / groups,
-         input.dim(kIOChannelSizeIdx) / groups,
-         weights.dim(kHIdx),
-         weights.dim(kWIdx)});
+         input.dim(channelIdx) / groups,
+         weights.dim(hIdx),
+         weights.dim(wIdx)});
   }
   payload->outputDims = detail::convertToDnnlDims(
       {input.dim(kIOBatchSizeIdx),
        weights.dim(kWeightOutputChannelSizeIdx),
-       output.dim(kHIdx),
-       output.dim(kWIdx)});
+       oy,
+       ox});
   payload->biasDims =
       detail::convertToDnnlDims({weights.dim(kWeightOutputChannelSizeIdx)});
   payload->strideDims = {sy, sx};
@@ -147,43 +200,52 @@ Tensor OneDnnAutogradExtension::conv2d(
   auto forwardMode =
       train ? prop_kind::forward_training : prop_kind::forward_inference;
 
-  // Convolution descriptor
-  std::shared_ptr<convolution_forward::desc> fwdDescriptor;
+  // Primitive descriptor and convolution, from the cache if the same
+  // convolution ran before
+  auto& dnnlEngine = detail::DnnlEngine::getInstance().getEngine();
+  detail::OneDnnPrimitiveKey fwdKey("conv2dForward");
+  fwdKey << forwardMode << static_cast<int64_t>(hasBias)
+         << payload->inputMemDesc << payload->weightMemDesc
+         << payload->outputMemDesc << payload->strideDims
+         << payload->dilationDims << payload->paddingDims << dnnlEngine;
   if (hasBias) {
-    fwdDescriptor = std::make_shared<convolution_forward::desc>(
-        forwardMode,
-        algorithm::convolution_direct,
-        payload->inputMemDesc,
-        payload->weightMemDesc,
-        payload->biasMemDesc,
-        payload->outputMemDesc,
-        payload->strideDims,
-        payload->dilationDims,
-        payload->paddingDims,
-        payload->paddingDims);
-  } else {
-    fwdDescriptor = std::make_shared<convolution_forward::desc>(
-        forwardMode,
-        algorithm::convolution_direct,
-        payload->inputMemDesc,
-        payload->weightMemDesc,
-        payload->outputMemDesc,
-        payload->strideDims,
-        payload->dilationDims,
-        payload->paddingDims,
-        payload->paddingDims);
+    fwdKey << payload->biasMemDesc;
   }
-
-  // Primitive descriptor
-  auto& dnnlEngine = detail::DnnlEngine::getInstance().getEngine();
-  payload->fwdPrimDesc =
-      convolution_forward::primitive_desc(*fwdDescriptor, dnnlEngine);
+  const auto fwdCached =
+      detail::OneDnnPrimitiveCache::getInstance().get<convolution_forward>(
+          fwdKey, [&]() {
+            // Convolution descriptor
+            std::shared_ptr<convolution_forward::desc> fwdDescriptor;
+            if (hasBias) {
+              fwdDescriptor = std::make_shared<convolution_forward::desc>(
+                  forwardMode,
+                  algorithm::convolution_direct,
+                  payload->inputMemDesc,
+                  payload->weightMemDesc,
+                  payload->biasMemDesc,
+                  payload->outputMemDesc,
+                  payload->strideDims,
+                  payload->dilationDims,
+                  payload->paddingDims,
+                  payload->paddingDims);
+            } else {
+              fwdDescriptor = std::make_shared<convolution_forward::desc>(
+                  forwardMode,
+                  algorithm::convolution_direct,
+                  payload->inputMemDesc,
+                  payload->weightMemDesc,
+                  payload->outputMemDesc,
+                  payload->strideDims,
+                  payload->dilationDims,
+                  payload->paddingDims,
+                  payload->paddingDims);
+            }
+            return convolution_forward::primitive_desc(
+                *fwdDescriptor, dnnlEngine);
+          });
+  payload->fwdPrimDesc = fwdCached.first;
 
   // Create memory
-  const detail::DnnlMemoryWrapper inputMemInit(
-      input, {payload->inputDims}, formatNCHW);
-  const detail::DnnlMemoryWrapper outputMemInit(
-      output, {payload->outputDims}, formatNCHW);
   const detail::DnnlMemoryWrapper weightsMem(
       weights, {payload->weightDims}, formatWeight);
 
@@ -198,27 +260,51 @@ Tensor OneDnnAutogradExtension::conv2d(
   auto inputDesc = payload->fwdPrimDesc.src_desc();
   auto weightsDesc = payload->fwdPrimDesc.weights_desc();
   auto outputDesc = payload->fwdPrimDesc.dst_desc();
-  // Input
+  // Input - OneDnnTensors already in a blocked layout are used as is, or
+  // reordered directly from it. Blocked memory has the NCHW dims of a WHCN
+  // tensor, thus CWHN tensors are always plain
+  const bool blockedLayouts = format == MemoryFormat::WHCN;
+  detail::DnnlMemoryWrapper inputMemInit;
+  memory inputMemInitMemory;
+  if (blockedLayouts && hasBlockedLayout(input, payload->inputDims)) {
+    inputMemInitMemory = viewInAnyLayout(input, dnnlEngine);
+  } else {
+    inputMemInit =
+        detail::DnnlMemoryWrapper(input, {payload->inputDims}, layout.data);
+    inputMemInitMemory = inputMemInit.getMemory();
+  }
   auto inputMemory = detail::dnnlAlignOrdering(
-      network, fwdArgs, inputMemInit.getMemory(), inputDesc);
+      network, fwdArgs, inputMemInitMemory, inputDesc);
   auto weightsMemory = detail::dnnlAlignOrdering(
       network, fwdArgs, weightsMem.getMemory(), weightsDesc);
-  // Output - adds a reorder after the conv if needed
-  auto outputMemory = outputMemInit.getMemory();
-  if (outputMemInit.getMemory().get_desc() != outputDesc) {
-    outputMemory = memory(outputDesc, dnnlEngine);
+  // Output - OneDnnTensors are left in the layout the convolution prefers,
+  // and reordered into the plain one lazily. Otherwise, adds a reorder after
+  // the conv if needed
+  Tensor output;
+  detail::DnnlMemoryWrapper outputMemInit;
+  memory outputMemory;
+  const bool keepBlockedOutput = blockedLayouts &&
+      input.backendType() == TensorBackendType::OneDnn &&
+      !detail::isPlainLayout(outputDesc);
+  if (keepBlockedOutput) {
+    output = toTensor<OneDnnTensor>(
+        outputShape,
+        memory(outputDesc, OneDnnBackend::getInstance().engine()));
+    outputMemory = viewInAnyLayout(output, dnnlEngine);
+  } else {
+    output = Tensor(outputShape, input.type());
+    outputMemInit =
+        detail::DnnlMemoryWrapper(output, {payload->outputDims}, layout.data);
+    outputMemory = outputMemInit.getMemory();
+    if (outputMemInit.getMemory().get_desc() != outputDesc) {
+      outputMemory = memory(outputDesc, dnnlEngine);
+    }
   }
 
-  // Create convolution
-  std::shared_ptr<convolution_forward> conv;
+  // Convolution
   const detail::DnnlMemoryWrapper biasMemory(
       bias, payload->biasDims, formatBias);
-  if (hasBias) {
-    conv = std::make_shared<convolution_forward>(payload->fwdPrimDesc);
-  } else {
-    conv = std::make_shared<convolution_forward>(payload->fwdPrimDesc);
-  }
-  network.push_back(*conv);
+  network.push_back(fwdCached.second);
 
   // Conv fwd args
   std::unordered_map<int, dnnl::memory> convFwdArgs = {
@@ -231,8 +317,9 @@ Tensor OneDnnAutogradExtension::conv2d(
   fwdArgs.push_back(convFwdArgs);
 
   // Add output reordering if needed
-  if (outputMemory != outputMemInit.getMemory()) {
-    network.push_back(dnnl::reorder(outputMemory, outputMemInit.getMemory()));
+  if (!keepBlockedOutput && outputMemory != outputMemInit.getMemory()) {
+    network.push_back(
+        detail::getCachedReorder(outputMemory, outputMemInit.getMemory()));
     fwdArgs.push_back(
         {{DNNL_ARG_FROM, outputMemory},
          {DNNL_ARG_TO, outputMemInit.getMemory()}});
@@ -255,6 +342,7 @@ Tensor OneDnnAutogradExtension::conv2dBackwardData(
     const int dx,
     const int dy,
     const int groups,
+    const MemoryFormat format,
     std::shared_ptr<DynamicBenchmark>,
     std::shared_ptr<detail::AutogradPayload> autogradPayload) {
   if (!autogradPayload) {
@@ -268,8 +356,8 @@ Tensor OneDnnAutogradExtension::conv2dBackwardData(
   auto gradInput = Tensor(input.shape(), input.type()); // Result
 
   auto dataType = detail::dnnlMapToType(input.type());
-  auto formatWeight =
-      (groups == 1) ? memory::format_tag::oihw : memory::format_tag::goihw;
+  const auto layout = convLayout(format);
+  auto formatWeight = (groups == 1) ? layout.weight : layout.groupedWeight;
   auto& dnnlEngineBwd = detail::DnnlEngine::getInstance().getEngine();
 
   // Backward descriptor
@@ -289,9 +377,9 @@ Tensor OneDnnAutogradExtension::conv2dBackwardData(
 
   // Create memory
   const detail::DnnlMemoryWrapper gradOutputMemInit(
-      gradOutput, payload->outputDims, formatNCHW);
+      gradOutput, payload->outputDims, layout.data);
   const detail::DnnlMemoryWrapper gradInputMemInit(
-      gradInput, payload->inputDims, formatNCHW);
+      gradInput, payload->inputDims, layout.data);
   const detail::DnnlMemoryWrapper weightsMemInitBwd(
       weights, payload->weightDims, formatWeight);
 
@@ -354,6 +442,7 @@ std::pair<Tensor, Tensor> OneDnnAutogradExtension::conv2dBackwardFilterBias(
     const int dx,
     const int dy,
     const int groups,
+    const MemoryFormat format,
     std::shared_ptr<DynamicBenchmark>,
     std::shared_ptr<DynamicBenchmark>,
     std::shared_ptr<detail::AutogradPayload> autogradPayload) {
@@ -368,8 +457,8 @@ std::pair<Tensor, Tensor> OneDnnAutogradExtension::conv2dBackwardFilterBias(
   auto gradWeights = Tensor(weights.shape(), weights.type()); // Result
 
   auto dataType = detail::dnnlMapToType(input.type());
-  auto formatWeight =
-      (groups == 1) ? memory::format_tag::oihw : memory::format_tag::goihw;
+  const auto layout = convLayout(format);
+  auto formatWeight = (groups == 1) ? layout.weight : layout.groupedWeight;
   auto& dnnlEngineBwd = detail::DnnlEngine::getInstance().getEngine();
 
   Tensor gradBias;
@@ -409,9 +498,9 @@ std::pair<Tensor, Tensor> OneDnnAutogradExtension::conv2dBackwardFilterBias(
 
   // Create memory
   const detail::DnnlMemoryWrapper inputRawMemInitBwd(
-      input, payload->inputDims, formatNCHW);
+      input, payload->inputDims, layout.data);
   const detail::DnnlMemoryWrapper gradOutputMemInit(
-      gradOutput, payload->outputDims, formatNCHW);
+      gradOutput, payload->outputDims, layout.data);
   const detail::DnnlMemoryWrapper gradWeightsMemInit(
       gradWeights, payload->weightDims, formatWeight);
 
@@ -17,6 +17,7 @@
 #include "flashlight/fl/common/Defines.h"
 #include "flashlight/fl/tensor/Compute.h"
 #include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/backend/onednn/PrimitiveCache.h"
 
 #if FL_BACKEND_OPENCL
   #include "flashlight/fl/common/OpenClUtils.h"
@@ -111,7 +112,7 @@ dnnl::memory dnnlAlignOrdering(
     // use the ordering requested by the descriptor
     memoryOut =
         dnnl::memory(desc, detail::DnnlEngine::getInstance().getEngine());
-    net.push_back(dnnl::reorder(memory, memoryOut));
+    net.push_back(getCachedReorder(memory, memoryOut));
     netArgs.push_back({{DNNL_ARG_FROM, memory}, {DNNL_ARG_TO, memoryOut}});
   }
   return memoryOut;
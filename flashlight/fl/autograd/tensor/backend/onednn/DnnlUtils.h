@@ -136,6 +136,8 @@ inline dnnl::memory::data_type dnnlMapToType(const fl::dtype t) {
     return dnnl::memory::data_type::f16;
   } else if (t == fl::dtype::f32) {
     return dnnl::memory::data_type::f32;
+  } else if (t == fl::dtype::bf16) {
+    return dnnl::memory::data_type::bf16;
   } else if (t == fl::dtype::f64) {
     throw std::invalid_argument("float64 is not supported by DNNL");
   } else {
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/autograd/tensor/backend/onednn/OneDnnAutogradExtension.h"
+
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <dnnl.hpp>
+
+#include "flashlight/fl/autograd/tensor/backend/onednn/DnnlUtils.h"
+#include "flashlight/fl/tensor/Index.h"
+
+using namespace dnnl;
+
+namespace fl {
+
+namespace {
+
+constexpr auto formatAB = memory::format_tag::ab;
+constexpr auto formatX = memory::format_tag::x;
+
+// oneDNN normalizes along the last, contiguous dimension. Views a tensor
+// normalized along its first `numAxes` axes as [rows, slice] in oneDNN order,
+// such that the contiguous data is unchanged.
+memory::dims getLayerNormDims(
+    const Tensor& input,
+    const int numAxes,
+    const char* caller) {
+  if (numAxes < 1 || numAxes > input.ndim()) {
+    throw std::invalid_argument(
+        std::string("[") + caller + "] invalid number of axes " +
+        std::to_string(numAxes) + " for a tensor with " +
+        std::to_string(input.ndim()) + " dimensions");
+  }
+  if (input.type() == fl::dtype::f16) {
+    throw std::invalid_argument(
+        std::string("[") + caller + "] f16 inputs are not supported");
+  }
+  Dim sliceSize = 1;
+  for (int i = 0; i < numAxes; ++i) {
+    sliceSize *= input.dim(i);
+  }
+  return {input.elements() / sliceSize, sliceSize};
+}
+
+// oneDNN only accepts weight and bias as a combined input
+Tensor getScaleShift(
+    const Tensor& weight,
+    const Tensor& bias,
+    const Dim sliceSize,
+    const fl::dtype type) {
+  auto weightNonempty = weight.isEmpty()
+      ? fl::full({sliceSize}, 1., type)
+      : fl::reshape(weight, {sliceSize}).astype(type);
+  auto biasNonempty = bias.isEmpty()
+      ? fl::full({sliceSize}, 0., type)
+      : fl::reshape(bias, {sliceSize}).astype(type);
+  return fl::concatenate(0, weightNonempty, biasNonempty);
+}
+
+layer_normalization_forward::primitive_desc getForwardPrimitiveDesc(
+    const memory::desc& inputDesc,
+    const double epsilon) {
+  auto fwdDesc = layer_normalization_forward::desc(
+      prop_kind::forward_training,
+      inputDesc,
+      epsilon,
+      normalization_flags::use_scale_shift);
+  return layer_normalization_forward::primitive_desc(
+      fwdDesc, detail::DnnlEngine::getInstance().getEngine());
+}
+
+// The variance oneDNN computes, from which the backward pass starts
+struct OneDnnLayerNormPayload : detail::AutogradPayloadData {
+  Tensor variance;
+};
+
+} // namespace
+
+Tensor OneDnnAutogradExtension::layerNorm(
+    Tensor& saveMean,
+    Tensor& saveRstd,
+    const Tensor& inputIn,
+    const Tensor& weight,
+    const Tensor& bias,
+    const int numAxes,
+    const double epsilon,
+    std::shared_ptr<detail::AutogradPayload> autogradPayload) {
+  auto input = inputIn.asContiguousTensor();
+  auto dims =
+      getLayerNormDims(input, numAxes, "OneDnnAutogradExtension::layerNorm");
+  const Dim rows = dims[0];
+  const Dim sliceSize = dims[1];
+
+  auto output = Tensor(input.shape(), input.type());
+  saveMean = Tensor({rows}, input.type());
+  auto variance = Tensor({rows}, input.type());
+  auto scaleShift = getScaleShift(weight, bias, sliceSize, input.type());
+
+  const detail::DnnlMemoryWrapper inputMem(input, dims, formatAB);
+  const detail::DnnlMemoryWrapper outputMem(output, dims, formatAB);
+  const detail::DnnlMemoryWrapper meanMem(saveMean, {rows}, formatX);
+  const detail::DnnlMemoryWrapper varianceMem(variance, {rows}, formatX);
+  const detail::DnnlMemoryWrapper scaleShiftMem(
+      scaleShift, {2, sliceSize}, formatAB);
+  auto fwdPrimDesc = getForwardPrimitiveDesc(inputMem.getDescriptor(), epsilon);
+
+  std::vector<primitive> network{layer_normalization_forward(fwdPrimDesc)};
+  std::vector<std::unordered_map<int, memory>> args{
+      {{DNNL_ARG_SRC, inputMem.getMemory()},
+       {DNNL_ARG_DST, outputMem.getMemory()},
+       {DNNL_ARG_MEAN, meanMem.getMemory()},
+       {DNNL_ARG_VARIANCE, varianceMem.getMemory()},
+       {DNNL_ARG_SCALE_SHIFT, scaleShiftMem.getMemory()}}};
+  detail::executeNetwork(network, args);
+
+  saveRstd = 1.0 / fl::sqrt(variance + epsilon);
+  if (autogradPayload) {
+    auto payload = std::make_shared<OneDnnLayerNormPayload>();
+    payload->variance = variance;
+    autogradPayload->data = payload;
+  }
+  return output;
+}
+
+std::tuple<Tensor, Tensor, Tensor> OneDnnAutogradExtension::layerNormBackward(
+    const Tensor& gradOutputIn,
+    const Tensor& saveMean,
+    const Tensor& saveRstd,
+    const Tensor& inputIn,
+    const Tensor& weight,
+    const int numAxes,
+    const double epsilon,
+    std::shared_ptr<detail::AutogradPayload> autogradPayload) {
+  auto input = inputIn.asContiguousTensor();
+  auto gradOutput = gradOutputIn.asContiguousTensor();
+  auto dims = getLayerNormDims(
+      input, numAxes, "OneDnnAutogradExtension::layerNormBackward");
+  const Dim rows = dims[0];
+  const Dim sliceSize = dims[1];
+
+  // without the variance of the forward pass, recover it from the rstd
+  Tensor variance;
+  if (autogradPayload && autogradPayload->data) {
+    variance = std::static_pointer_cast<OneDnnLayerNormPayload>(
+                   autogradPayload->data)
+                   ->variance;
+  } else {
+    variance = 1.0 / (saveRstd * saveRstd) - epsilon;
+  }
+  auto scaleShift = getScaleShift(weight, Tensor(), sliceSize, input.type());
+  auto gradInput = Tensor(input.shape(), input.type());
+  auto gradScaleShift = Tensor(scaleShift.shape(), scaleShift.type());
+
+  const detail::DnnlMemoryWrapper inputMem(input, dims, formatAB);
+  const detail::DnnlMemoryWrapper gradOutputMem(gradOutput, dims, formatAB);
+  const detail::DnnlMemoryWrapper gradInputMem(gradInput, dims, formatAB);
+  const detail::DnnlMemoryWrapper meanMem(saveMean, {rows}, formatX);
+  const detail::DnnlMemoryWrapper varianceMem(variance, {rows}, formatX);
+  const detail::DnnlMemoryWrapper scaleShiftMem(
+      scaleShift, {2, sliceSize}, formatAB);
+  const detail::DnnlMemoryWrapper gradScaleShiftMem(
+      gradScaleShift, {2, sliceSize}, formatAB);
+  // The backward primitive descriptor takes the forward one as a hint
+  auto fwdPrimDesc = getForwardPrimitiveDesc(inputMem.getDescriptor(), epsilon);
+  auto bwdDesc = layer_normalization_backward::desc(
+      prop_kind::backward,
+      gradOutputMem.getDescriptor(),
+      inputMem.getDescriptor(),
+      epsilon,
+      normalization_flags::use_scale_shift);
+  auto bwdPrimDesc = layer_normalization_backward::primitive_desc(
+      bwdDesc, detail::DnnlEngine::getInstance().getEngine(), fwdPrimDesc);
+
+  std::vector<primitive> network{layer_normalization_backward(bwdPrimDesc)};
+  std::vector<std::unordered_map<int, memory>> args{
+      {{DNNL_ARG_SRC, inputMem.getMemory()},
+       {DNNL_ARG_MEAN, meanMem.getMemory()},
+       {DNNL_ARG_VARIANCE, varianceMem.getMemory()},
+       {DNNL_ARG_SCALE_SHIFT, scaleShiftMem.getMemory()},
+       {DNNL_ARG_DIFF_DST, gradOutputMem.getMemory()},
+       {DNNL_ARG_DIFF_SRC, gradInputMem.getMemory()},
+       {DNNL_ARG_DIFF_SCALE_SHIFT, gradScaleShiftMem.getMemory()}}};
+  detail::executeNetwork(network, args);
+
+  return {
+      gradInput,
+      gradScaleShift(fl::range(0, sliceSize)), // weight grad
+      gradScaleShift(fl::range(sliceSize, 2 * sliceSize)) // bias grad
+  };
+}
+
+} // namespace fl
@@ -29,6 +29,7 @@ class OneDnnAutogradExtension : public AutogradExtension {
       const int dx,
       const int dy,
       const int groups,
+      const MemoryFormat format,
       std::shared_ptr<detail::AutogradPayload> payload) override;
 
   Tensor pool2d(
@@ -40,6 +41,7 @@ class OneDnnAutogradExtension : public AutogradExtension {
       const int px,
       const int py,
       const PoolingMode mode,
+      const MemoryFormat format,
       std::shared_ptr<detail::AutogradPayload> payload) override;
 
   Tensor batchnorm(
@@ -68,6 +70,45 @@ class OneDnnAutogradExtension : public AutogradExtension {
       const float dropout,
       std::shared_ptr<detail::AutogradPayload> payload) override;
 
+  Tensor softmax(
+      const Tensor& input,
+      const int axis,
+      const bool log,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  Tensor layerNorm(
+      Tensor& saveMean,
+      Tensor& saveRstd,
+      const Tensor& input,
+      const Tensor& weight,
+      const Tensor& bias,
+      const int numAxes,
+      const double epsilon,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  Tensor quantizedLinear(
+      const Tensor& input,
+      const Tensor& weights,
+      const Tensor& weightScales,
+      const Tensor& bias,
+      const float inputScale,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  Tensor quantizedConv2d(
+      const Tensor& input,
+      const Tensor& weights,
+      const Tensor& weightScales,
+      const Tensor& bias,
+      const float inputScale,
+      const int sx,
+      const int sy,
+      const int px,
+      const int py,
+      const int dx,
+      const int dy,
+      const int groups,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
   /**************************** Backward ****************************/
   // ]----- Convolution
   Tensor conv2dBackwardData(
@@ -81,6 +122,7 @@ class OneDnnAutogradExtension : public AutogradExtension {
       const int dx,
       const int dy,
       const int groups,
+      const MemoryFormat format,
       std::shared_ptr<DynamicBenchmark> dataGradBenchmark,
       std::shared_ptr<detail::AutogradPayload> payload) override;
 
@@ -96,6 +138,7 @@ class OneDnnAutogradExtension : public AutogradExtension {
       const int dx,
       const int dy,
       const int groups,
+      const MemoryFormat format,
       std::shared_ptr<DynamicBenchmark> filterBench,
       std::shared_ptr<DynamicBenchmark> biasBench,
       std::shared_ptr<detail::AutogradPayload> autogradPayload) override;
@@ -112,6 +155,7 @@ class OneDnnAutogradExtension : public AutogradExtension {
       const int px,
       const int py,
       const PoolingMode mode,
+      const MemoryFormat format,
       std::shared_ptr<detail::AutogradPayload> payload) override;
 
   // ]----- batchnorm
@@ -140,6 +184,25 @@ class OneDnnAutogradExtension : public AutogradExtension {
       const bool bidirectional,
       const float dropProb,
       std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  // ]----- softmax
+  Tensor softmaxBackward(
+      const Tensor& gradOutput,
+      const Tensor& output,
+      const int axis,
+      const bool log,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  // ]----- layerNorm
+  std::tuple<Tensor, Tensor, Tensor> layerNormBackward(
+      const Tensor& gradOutput,
+      const Tensor& saveMean,
+      const Tensor& saveRstd,
+      const Tensor& input,
+      const Tensor& weight,
+      const int numAxes,
+      const double epsilon,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
 };
 
 } // namespace fl
@@ -15,6 +15,7 @@
 #include "flashlight/fl/autograd/tensor/backend/onednn/DnnlUtils.h"
 #include "flashlight/fl/tensor/Shape.h"
 #include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/backend/onednn/PrimitiveCache.h"
 
 using namespace dnnl;
 
@@ -30,7 +31,12 @@ constexpr size_t kBatchSizeIdx = 3;
 // Use memory::format_tag::any for memory formatting even if pool
 // inputs are shaped in a particular way.
 constexpr auto formatAny = memory::format_tag::any;
-constexpr auto formatNCHW = memory::format_tag::nchw;
+
+// WHCN and CWHN tensors are NCHW and NHWC in row-major order
+memory::format_tag dataFormat(const MemoryFormat format) {
+  return format == MemoryFormat::CWHN ? memory::format_tag::nhwc
+                                      : memory::format_tag::nchw;
+}
 
 struct DimsData {
   memory::dims inputDims;
@@ -40,6 +46,7 @@ struct DimsData {
   std::vector<int64_t> paddingDims;
 };
 
+// The input and output shapes are given in WHCN order
 DimsData getDimsData(
     const Shape& input,
     const Shape& output,
@@ -84,6 +91,7 @@ Tensor OneDnnAutogradExtension::pool2d(
     const int px,
     const int py,
     const PoolingMode mode,
+    const MemoryFormat format,
     std::shared_ptr<detail::AutogradPayload> autogradPayload) {
   const bool train = (autogradPayload != nullptr);
   auto payload = std::make_shared<OneDnnPool2DPayload>();
@@ -91,48 +99,61 @@ Tensor OneDnnAutogradExtension::pool2d(
     autogradPayload->data = payload;
   }
 
-  // inputX x inputY x channels x batch
-  auto ix = input.dim(kWIdx);
-  auto iy = input.ndim() > kHIdx ? input.dim(kHIdx) : 1;
-  auto c = input.ndim() > kChannelSizeIdx ? input.dim(kChannelSizeIdx) : 1;
-  auto b = input.ndim() > kBatchSizeIdx ? input.dim(kBatchSizeIdx) : 1;
-
-  auto output = Tensor(
-      {1 + (ix + 2 * px - wx) / sx, 1 + (iy + 2 * py - wy) / sy, c, b},
-      input.type());
+  // inputX x inputY x channels x batch, or channels x inputX x inputY x batch
+  const bool channelsLast = format == MemoryFormat::CWHN;
+  auto dim = [&input](size_t i) {
+    return input.ndim() > i ? input.dim(i) : 1;
+  };
+  auto ix = dim(channelsLast ? kWIdx + 1 : kWIdx);
+  auto iy = dim(channelsLast ? kHIdx + 1 : kHIdx);
+  auto c = dim(channelsLast ? 0 : kChannelSizeIdx);
+  auto b = dim(kBatchSizeIdx);
+  auto ox = 1 + (ix + 2 * px - wx) / sx;
+  auto oy = 1 + (iy + 2 * py - wy) / sy;
+
+  auto output = channelsLast ? Tensor({c, ox, oy, b}, input.type())
+                             : Tensor({ox, oy, c, b}, input.type());
 
   payload->dimsData =
-      getDimsData({ix, iy, c, b}, output.shape(), wx, wy, sx, sy, px, py);
+      getDimsData({ix, iy, c, b}, {ox, oy, c, b}, wx, wy, sx, sy, px, py);
   auto& d = payload->dimsData;
   auto dataType = detail::dnnlMapToType(input.type());
+  const auto formatData = dataFormat(format);
 
   // Memory desc
-  auto inputMD = memory::desc({d.inputDims}, dataType, formatNCHW);
+  auto inputMD = memory::desc({d.inputDims}, dataType, formatData);
   auto outputMD = memory::desc({d.outputDims}, dataType, formatAny);
 
   // Memory
   auto& dnnlEngine = detail::DnnlEngine::getInstance().getEngine();
   const detail::DnnlMemoryWrapper inputMemInit(
-      input, {d.inputDims}, formatNCHW);
+      input, {d.inputDims}, formatData);
   const detail::DnnlMemoryWrapper outputMemInit(
-      output, {d.outputDims}, formatNCHW);
+      output, {d.outputDims}, formatData);
 
   // Choose a mode based on whether gradients are needed
   auto forwardMode = train ? prop_kind::forward : prop_kind::forward_inference;
 
-  // Descriptors
+  // Descriptors and layer, from the cache if the same pooling ran before
   auto poolingMode = detail::dnnlMapToPoolingMode(mode);
-  auto desc = pooling_forward::desc(
-      forwardMode,
-      poolingMode,
-      inputMD,
-      outputMD,
-      d.strideDims,
-      d.windowDims,
-      d.paddingDims,
-      d.paddingDims);
-  payload->poolingFwdPrimDesc =
-      pooling_forward::primitive_desc(desc, dnnlEngine);
+  const auto fwdCached =
+      detail::OneDnnPrimitiveCache::getInstance().get<pooling_forward>(
+          detail::OneDnnPrimitiveKey("pool2dForward")
+              << forwardMode << poolingMode << inputMD << outputMD
+              << d.strideDims << d.windowDims << d.paddingDims << dnnlEngine,
+          [&]() {
+            auto desc = pooling_forward::desc(
+                forwardMode,
+                poolingMode,
+                inputMD,
+                outputMD,
+                d.strideDims,
+                d.windowDims,
+                d.paddingDims,
+                d.paddingDims);
+            return pooling_forward::primitive_desc(desc, dnnlEngine);
+          });
+  payload->poolingFwdPrimDesc = fwdCached.first;
   auto& primDesc = payload->poolingFwdPrimDesc;
 
   // Network
@@ -147,25 +168,21 @@ Tensor OneDnnAutogradExtension::pool2d(
   if (outputMemInit.getMemory().get_desc() != outputDesc) {
     payload->outputMemory = memory(outputDesc, dnnlEngine);
   }
-  // Workspace and layer (only training mode requires a workspace)
-  std::shared_ptr<pooling_forward> pooling;
+  // Workspace (only training mode requires a workspace)
   std::unordered_map<int, dnnl::memory> fwdPoolingArgs;
   fwdPoolingArgs[DNNL_ARG_SRC] = inputMemory;
   fwdPoolingArgs[DNNL_ARG_DST] = payload->outputMemory;
   if (train) {
     payload->workspace = memory(primDesc.workspace_desc(), dnnlEngine);
-    pooling = std::make_shared<pooling_forward>(primDesc);
     fwdPoolingArgs[DNNL_ARG_WORKSPACE] = payload->workspace;
-  } else {
-    pooling = std::make_shared<pooling_forward>(primDesc);
   }
-  network.push_back(*pooling);
+  network.push_back(fwdCached.second);
   fwdArgs.push_back(fwdPoolingArgs);
 
   // Add output reordering if needed
   if (payload->outputMemory != outputMemInit.getMemory()) {
-    network.push_back(
-        dnnl::reorder(payload->outputMemory, outputMemInit.getMemory()));
+    network.push_back(detail::getCachedReorder(
+        payload->outputMemory, outputMemInit.getMemory()));
     fwdArgs.push_back(
         {{DNNL_ARG_FROM, payload->outputMemory},
          {DNNL_ARG_TO, outputMemInit.getMemory()}});
@@ -186,6 +203,7 @@ Tensor OneDnnAutogradExtension::pool2dBackward(
     const int px,
     const int py,
     const PoolingMode mode,
+    const MemoryFormat format,
     std::shared_ptr<detail::AutogradPayload> autogradPayload) {
   if (!autogradPayload) {
     throw std::invalid_argument(
@@ -194,7 +212,7 @@ Tensor OneDnnAutogradExtension::pool2dBackward(
   auto payload =
       std::static_pointer_cast<OneDnnPool2DPayload>(autogradPayload->data);
 
-  auto gradInput = Tensor(input.shape(), fl::dtype::f32);
+  auto gradInput = Tensor(input.shape(), input.type());
   auto& dnnlEngineBwd = detail::DnnlEngine::getInstance().getEngine();
 
   DimsData& d = payload->dimsData;
@@ -203,9 +221,9 @@ Tensor OneDnnAutogradExtension::pool2dBackward(
 
   // Memory
   const detail::DnnlMemoryWrapper gradInputMemInit(
-      gradInput, {d.inputDims}, formatNCHW);
+      gradInput, {d.inputDims}, dataFormat(format));
   const detail::DnnlMemoryWrapper gradOutputMemInit(
-      gradOutput, {d.outputDims}, formatNCHW);
+      gradOutput, {d.outputDims}, dataFormat(format));
 
   // Descriptors
   // Memory descriptors from initialized memory must be used since
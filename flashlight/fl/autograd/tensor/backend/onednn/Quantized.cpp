@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/autograd/tensor/backend/onednn/OneDnnAutogradExtension.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <dnnl.hpp>
+
+#include "flashlight/fl/autograd/tensor/backend/onednn/DnnlUtils.h"
+
+using namespace dnnl;
+
+namespace fl {
+
+namespace {
+
+// Input, output: WHCN; weights: WHIO
+constexpr size_t kWIdx = 0;
+constexpr size_t kHIdx = 1;
+constexpr size_t kIOChannelSizeIdx = 2;
+constexpr size_t kIOBatchSizeIdx = 3;
+constexpr size_t kWeightOutputChannelSizeIdx = 3;
+
+constexpr auto formatAny = memory::format_tag::any;
+constexpr auto formatNCHW = memory::format_tag::nchw;
+constexpr auto formatAB = memory::format_tag::ab;
+
+// Persists the weights quantized to int8 across calls, in the layout
+// preferred by the primitive.
+struct OneDnnQuantizedPayload : detail::AutogradPayloadData {
+  memory weights;
+  std::vector<float> weightScales;
+};
+
+void checkQuantizedInputs(
+    const Tensor& input,
+    const Tensor& weightScales,
+    const Dim numOutputChannels,
+    const float inputScale,
+    const std::string& caller) {
+  if (input.type() != fl::dtype::f32) {
+    throw std::invalid_argument(
+        "[" + caller + "] int8 inference expects float32 inputs");
+  }
+  if (!(inputScale > 0)) {
+    throw std::invalid_argument(
+        "[" + caller + "] the input scale must be positive");
+  }
+  if (weightScales.elements() != numOutputChannels) {
+    throw std::invalid_argument(
+        "[" + caller + "] expects one weight scale per output channel");
+  }
+}
+
+// Returns the payload caching the quantized weights, or a new one if
+// there's nothing to cache them in.
+std::shared_ptr<OneDnnQuantizedPayload> getPayload(
+    const std::shared_ptr<detail::AutogradPayload>& autogradPayload) {
+  if (!autogradPayload) {
+    return std::make_shared<OneDnnQuantizedPayload>();
+  }
+  if (!autogradPayload->data) {
+    autogradPayload->data = std::make_shared<OneDnnQuantizedPayload>();
+  }
+  return std::static_pointer_cast<OneDnnQuantizedPayload>(
+      autogradPayload->data);
+}
+
+std::vector<float> getScales(
+    const std::vector<float>& scales,
+    const float factor,
+    const bool inverse) {
+  std::vector<float> result(scales.size());
+  for (size_t i = 0; i < scales.size(); ++i) {
+    result[i] = inverse ? 1 / (scales[i] * factor) : scales[i] * factor;
+  }
+  return result;
+}
+
+// Adds a reorder of given memory into given int8 descriptor, quantizing it
+// with given scales along the axes in `mask`, see
+// dnnl::primitive_attr::set_output_scales.
+memory quantize(
+    std::vector<primitive>& network,
+    std::vector<std::unordered_map<int, memory>>& args,
+    const memory& from,
+    const memory::desc& desc,
+    const int mask,
+    const std::vector<float>& scales) {
+  auto& dnnlEngine = detail::DnnlEngine::getInstance().getEngine();
+  auto to = memory(desc, dnnlEngine);
+  primitive_attr attr;
+  attr.set_output_scales(mask, scales);
+  auto reorderPrimDesc = reorder::primitive_desc(
+      dnnlEngine, from.get_desc(), dnnlEngine, desc, attr);
+  network.push_back(reorder(reorderPrimDesc));
+  args.push_back({{DNNL_ARG_FROM, from}, {DNNL_ARG_TO, to}});
+  return to;
+}
+
+// Quantizes the weights once, with a scale per output channel, unless the
+// payload already holds them in the primitive's layout.
+memory getQuantizedWeights(
+    std::vector<primitive>& network,
+    std::vector<std::unordered_map<int, memory>>& args,
+    OneDnnQuantizedPayload& payload,
+    const detail::DnnlMemoryWrapper& weights,
+    const memory::desc& desc,
+    const int mask) {
+  if (!payload.weights || payload.weights.get_desc() != desc) {
+    payload.weights = quantize(
+        network,
+        args,
+        weights.getMemory(),
+        desc,
+        mask,
+        getScales(payload.weightScales, 1, /* inverse = */ true));
+  }
+  return payload.weights;
+}
+
+// Dequantizes the output with the product of the input and weight scales
+// along the output channel axis, then adds the bias after it, if any.
+primitive_attr getOutputAttr(
+    const OneDnnQuantizedPayload& payload,
+    const float inputScale,
+    const memory::desc& biasDesc,
+    const bool hasBias) {
+  primitive_attr attr;
+  attr.set_output_scales(
+      1 << 1, getScales(payload.weightScales, inputScale, false));
+  if (hasBias) {
+    post_ops postOps;
+    postOps.append_binary(algorithm::binary_add, biasDesc);
+    attr.set_post_ops(postOps);
+  }
+  return attr;
+}
+
+} // namespace
+
+Tensor OneDnnAutogradExtension::quantizedLinear(
+    const Tensor& input,
+    const Tensor& weights,
+    const Tensor& weightScales,
+    const Tensor& bias,
+    const float inputScale,
+    std::shared_ptr<detail::AutogradPayload> autogradPayload) {
+  const auto nIn = weights.dim(1);
+  const auto nOut = weights.dim(0);
+  checkQuantizedInputs(
+      input,
+      weightScales,
+      nOut,
+      inputScale,
+      "OneDnnAutogradExtension::quantizedLinear");
+  if (input.ndim() == 0 || input.dim(0) != nIn) {
+    throw std::invalid_argument(
+        "[OneDnnAutogradExtension::quantizedLinear] "
+        "input and weights sizes mismatch");
+  }
+  auto payload = getPayload(autogradPayload);
+  if (payload->weightScales.empty()) {
+    payload->weightScales = weightScales.toHostVector<float>();
+  }
+  const bool hasBias = bias.elements() > 0;
+
+  // Viewing the column-major input [in, *] and weights [out, in] as if they
+  // were row-major gives [*, in] and [in, out], whose product is the
+  // row-major view of the output [out, *]
+  auto outputDims = input.shape().get();
+  outputDims[0] = nOut;
+  const Shape outputShape(outputDims);
+  const memory::dims inputDims = {input.elements() / nIn, nIn};
+  const memory::dims weightDims = {nIn, nOut};
+  const memory::dims dstDims = {input.elements() / nIn, nOut};
+  const memory::dims biasDims = {1, nOut};
+
+  const auto s8 = memory::data_type::s8;
+  const auto f32 = memory::data_type::f32;
+  const auto biasDesc = memory::desc(biasDims, f32, formatAB);
+  const auto matmulDesc = matmul::desc(
+      memory::desc(inputDims, s8, formatAny),
+      memory::desc(weightDims, s8, formatAny),
+      memory::desc(dstDims, f32, formatAB));
+  auto& dnnlEngine = detail::DnnlEngine::getInstance().getEngine();
+  const auto matmulPrimDesc = matmul::primitive_desc(
+      matmulDesc,
+      getOutputAttr(*payload, inputScale, biasDesc, hasBias),
+      dnnlEngine);
+
+  std::vector<primitive> network;
+  std::vector<std::unordered_map<int, memory>> fwdArgs;
+  const detail::DnnlMemoryWrapper inputMem(input, inputDims, formatAB);
+  const auto inputMemory = quantize(
+      network,
+      fwdArgs,
+      inputMem.getMemory(),
+      matmulPrimDesc.src_desc(),
+      0,
+      {1 / inputScale});
+  const detail::DnnlMemoryWrapper weightsMem(weights, weightDims, formatAB);
+  const auto weightsMemory = getQuantizedWeights(
+      network,
+      fwdArgs,
+      *payload,
+      weightsMem,
+      matmulPrimDesc.weights_desc(),
+      1 << 1);
+
+  auto output = Tensor(outputShape, fl::dtype::f32);
+  const detail::DnnlMemoryWrapper outputMem(output, dstDims, formatAB);
+  std::unordered_map<int, memory> matmulArgs = {
+      {DNNL_ARG_SRC, inputMemory},
+      {DNNL_ARG_WEIGHTS, weightsMemory},
+      {DNNL_ARG_DST, outputMem.getMemory()}};
+  detail::DnnlMemoryWrapper biasMem;
+  if (hasBias) {
+    biasMem = detail::DnnlMemoryWrapper(bias, biasDims, formatAB);
+    matmulArgs[DNNL_ARG_ATTR_MULTIPLE_POST_OP(0) | DNNL_ARG_SRC_1] =
+        biasMem.getMemory();
+  }
+  network.push_back(matmul(matmulPrimDesc));
+  fwdArgs.push_back(matmulArgs);
+
+  detail::executeNetwork(network, fwdArgs);
+  return output;
+}
+
+Tensor OneDnnAutogradExtension::quantizedConv2d(
+    const Tensor& input,
+    const Tensor& weights,
+    const Tensor& weightScales,
+    const Tensor& bias,
+    const float inputScale,
+    const int sx,
+    const int sy,
+    const int px,
+    const int py,
+    const int dx,
+    const int dy,
+    const int groups,
+    std::shared_ptr<detail::AutogradPayload> autogradPayload) {
+  const auto nOut = weights.dim(kWeightOutputChannelSizeIdx);
+  checkQuantizedInputs(
+      input,
+      weightScales,
+      nOut,
+      inputScale,
+      "OneDnnAutogradExtension::quantizedConv2d");
+  auto payload = getPayload(autogradPayload);
+  if (payload->weightScales.empty()) {
+    payload->weightScales = weightScales.toHostVector<float>();
+  }
+  const bool hasBias = bias.elements() > 0;
+
+  // See OneDnnAutogradExtension::conv2d: the column-major WHCN input and
+  // output and WHIO weights are viewed as row-major NCHW and OIHW
+  const Shape outputShape(
+      {1 +
+           (input.dim(kWIdx) + (2 * px) - (1 + (weights.dim(kWIdx) - 1) * dx)) /
+               sx,
+       1 +
+           (input.dim(kHIdx) + (2 * py) - (1 + (weights.dim(kHIdx) - 1) * dy)) /
+               sy,
+       nOut,
+       input.dim(kIOBatchSizeIdx)});
+  const auto inputDims = detail::convertToDnnlDims(
+      {input.dim(kIOBatchSizeIdx),
+       input.dim(kIOChannelSizeIdx),
+       input.dim(kHIdx),
+       input.dim(kWIdx)});
+  memory::dims weightDims;
+  if (groups == 1) {
+    weightDims = detail::convertToDnnlDims(
+        {nOut,
+         input.dim(kIOChannelSizeIdx),
+         weights.dim(kHIdx),
+         weights.dim(kWIdx)});
+  } else {
+    weightDims = detail::convertToDnnlDims(
+        {groups,
+         nOut / groups,
+         input.dim(kIOChannelSizeIdx) / groups,
+         weights.dim(kHIdx),
+         weights.dim(kWIdx)});
+  }
+  const auto outputDims = detail::convertToDnnlDims(
+      {input.dim(kIOBatchSizeIdx),
+       nOut,
+       outputShape[kHIdx],
+       outputShape[kWIdx]});
+  const auto biasDims = detail::convertToDnnlDims({1, nOut, 1, 1});
+  const memory::dims strideDims = {sy, sx};
+  const memory::dims paddingDims = {py, px};
+  // NB: DNNL treats a dilation of 0 as a standard convolution
+  const memory::dims dilationDims = {dy - 1, dx - 1};
+
+  const auto s8 = memory::data_type::s8;
+  const auto f32 = memory::data_type::f32;
+  const auto formatWeight =
+      (groups == 1) ? memory::format_tag::oihw : memory::format_tag::goihw;
+  const auto biasDesc = memory::desc(biasDims, f32, formatNCHW);
+  const auto convDesc = convolution_forward::desc(
+      prop_kind::forward_inference,
+      algorithm::convolution_direct,
+      memory::desc(inputDims, s8, formatAny),
+      memory::desc(weightDims, s8, formatAny),
+      memory::desc(outputDims, f32, formatAny),
+      strideDims,
+      dilationDims,
+      paddingDims,
+      paddingDims);
+  auto& dnnlEngine = detail::DnnlEngine::getInstance().getEngine();
+  const auto convPrimDesc = convolution_forward::primitive_desc(
+      convDesc,
+      getOutputAttr(*payload, inputScale, biasDesc, hasBias),
+      dnnlEngine);
+
+  std::vector<primitive> network;
+  std::vector<std::unordered_map<int, memory>> fwdArgs;
+  const detail::DnnlMemoryWrapper inputMem(input, inputDims, formatNCHW);
+  const auto inputMemory = quantize(
+      network,
+      fwdArgs,
+      inputMem.getMemory(),
+      convPrimDesc.src_desc(),
+      0,
+      {1 / inputScale});
+  // the output channels are the first axis of OIHW weights, and the first
+  // two of GOIHW ones
+  const detail::DnnlMemoryWrapper weightsMem(weights, weightDims, formatWeight);
+  const auto weightsMemory = getQuantizedWeights(
+      network,
+      fwdArgs,
+      *payload,
+      weightsMem,
+      convPrimDesc.weights_desc(),
+      groups == 1 ? 1 << 0 : (1 << 0) | (1 << 1));
+
+  auto output = Tensor(outputShape, fl::dtype::f32);
+  const detail::DnnlMemoryWrapper outputMem(output, outputDims, formatNCHW);
+  auto outputMemory = outputMem.getMemory();
+  if (outputMemory.get_desc() != convPrimDesc.dst_desc()) {
+    outputMemory = memory(convPrimDesc.dst_desc(), dnnlEngine);
+  }
+  std::unordered_map<int, memory> convArgs = {
+      {DNNL_ARG_SRC, inputMemory},
+      {DNNL_ARG_WEIGHTS, weightsMemory},
+      {DNNL_ARG_DST, outputMemory}};
+  detail::DnnlMemoryWrapper biasMem;
+  if (hasBias) {
+    biasMem = detail::DnnlMemoryWrapper(bias, biasDims, formatNCHW);
+    convArgs[DNNL_ARG_ATTR_MULTIPLE_POST_OP(0) | DNNL_ARG_SRC_1] =
+        biasMem.getMemory();
+  }
+  network.push_back(convolution_forward(convPrimDesc));
+  fwdArgs.push_back(convArgs);
+
+  if (outputMemory != outputMem.getMemory()) {
+    network.push_back(reorder(outputMemory, outputMem.getMemory()));
+    fwdArgs.push_back(
+        {{DNNL_ARG_FROM, outputMemory}, {DNNL_ARG_TO, outputMem.getMemory()}});
+  }
+
+  detail::executeNetwork(network, fwdArgs);
+  return output;
+}
+
+} // namespace fl
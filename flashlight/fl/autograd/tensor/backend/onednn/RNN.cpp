@@ -7,14 +7,22 @@
 
 #include "flashlight/fl/autograd/tensor/backend/onednn/OneDnnAutogradExtension.h"
 
+#include <array>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
+#include <string>
 #include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <dnnl.hpp>
 
 #include "flashlight/fl/autograd/tensor/backend/onednn/DnnlUtils.h"
+#include "flashlight/fl/common/DevicePtr.h"
 #include "flashlight/fl/tensor/Index.h"
 
 namespace fl {
@@ -231,8 +239,48 @@ struct RnnResult {
   Tensor cy; // cell output
 };
 
+// A forward primitive, which only depends on the configuration and shapes of
+// the RNN, not on its data
+struct RnnPrimitive {
+  dnnl::primitive primitive;
+  dnnl::memory::desc workspaceDesc;
+};
+
+// The input and hidden weights of one forward primitive, reordered into its
+// layout
+using PackedWeights = std::pair<dnnl::memory, dnnl::memory>;
+
+// Weights parsed from the flat weights of an RNN and reordered for its
+// primitives, which are reused for as long as the flat weights keep the same
+// buffer, e.g. across inference steps until the next optimizer update
+struct PrepackedWeights {
+  std::string key;
+  // holds the buffer of the flat weights, whose address is part of the key,
+  // such that it can't be reused by other weights
+  Tensor weights;
+  ParsedWeightsAndBias parsed;
+  // for the first layer, and the others if it's run separately
+  std::array<PackedWeights, 2> packed;
+};
+
+constexpr size_t kMaxCachedPrimitives = 64;
+constexpr size_t kMaxPrepackedWeights = 8;
+
+std::mutex rnnCacheMutex;
+std::unordered_map<std::string, RnnPrimitive> rnnPrimitiveCache;
+// most recently used first
+std::list<std::shared_ptr<PrepackedWeights>> prepackedWeightsCache;
+
+template <typename... Args>
+std::string makeRnnKey(const Args&... args) {
+  std::ostringstream ss;
+  ((ss << args << ' '), ...);
+  return ss.str();
+}
+
 /*
- * Does forward for a single onednn RNN primitive
+ * Does forward for a single onednn RNN primitive. If `packedWeights` is given,
+ * it holds the weights reordered for the primitive, or is set to them.
  */
 RnnResult rnnImpl(
     const Tensor& input,
@@ -249,7 +297,8 @@ RnnResult rnnImpl(
     dnnl::rnn_direction direction,
     int directionMult,
     dnnl::prop_kind kind,
-    float dropout) {
+    float dropout,
+    PackedWeights* packedWeights = nullptr) {
   RnnResult result;
   auto dnnlEngine = detail::DnnlEngine::getInstance().getEngine();
 
@@ -298,23 +347,64 @@ RnnResult rnnImpl(
         hiddenState.asContiguousTensor(), {hDims}, ldnc);
   }
   const detail::DnnlMemoryWrapper hiddenOutMemInit(hy, {hDims}, ldnc);
-  const detail::DnnlMemoryWrapper weightsInputMemRawInit(
-      weightsInput.asContiguousTensor(), {weightsInputDims}, ldgoi);
-  const detail::DnnlMemoryWrapper weightsHiddenMemRawInit(
-      weightsHidden.asContiguousTensor(), {weightsHiddenDims}, ldgoi);
   const detail::DnnlMemoryWrapper biasMemInit(
       bias.asContiguousTensor(), {biasDims}, ldgo);
+  // LSTM-only: input and output cell state
+  detail::DnnlMemoryWrapper cellInMemInit;
+  detail::DnnlMemoryWrapper cellOutMemInit;
+  if (mode == RnnMode::LSTM) {
+    if (!cellState.isEmpty()) {
+      cellInMemInit = detail::DnnlMemoryWrapper(
+          cellState.asContiguousTensor(), {cDims}, ldnc);
+    }
+    cellOutMemInit = detail::DnnlMemoryWrapper(cy, cDims, ldnc);
+  }
 
   // TODO(jacobkahn): don't force a format tag - use any and do a reorder based
   // on the format of the primitive - what it says - like you're supposed to
   // Primitive for reordering input weights: ldgoi --> ldigo
   auto weightsInputMemDesc = dnnl::memory::desc(
       weightsInputDims, dType, dnnl::memory::format_tag::ldigo);
-  auto weightsInputMemInit = dnnl::memory(weightsInputMemDesc, dnnlEngine);
   // Primitive for reordering iter/hidden weights: ldgoi --> ldigo
   auto weightsHiddenMemDesc = dnnl::memory::desc(
       weightsHiddenDims, dType, dnnl::memory::format_tag::ldigo);
-  auto weightsHiddenMemInit = dnnl::memory(weightsHiddenMemDesc, dnnlEngine);
+
+  std::vector<dnnl::primitive> network;
+  std::vector<std::unordered_map<int, dnnl::memory>> fwdArgs;
+  // the raw weights, which must outlive their reorders
+  detail::DnnlMemoryWrapper weightsInputMemRawInit;
+  detail::DnnlMemoryWrapper weightsHiddenMemRawInit;
+  dnnl::memory weightsInputMemInit;
+  dnnl::memory weightsHiddenMemInit;
+  if (packedWeights && packedWeights->first) {
+    std::tie(weightsInputMemInit, weightsHiddenMemInit) = *packedWeights;
+  } else {
+    weightsInputMemRawInit = detail::DnnlMemoryWrapper(
+        weightsInput.asContiguousTensor(), {weightsInputDims}, ldgoi);
+    weightsHiddenMemRawInit = detail::DnnlMemoryWrapper(
+        weightsHidden.asContiguousTensor(), {weightsHiddenDims}, ldgoi);
+    weightsInputMemInit = dnnl::memory(weightsInputMemDesc, dnnlEngine);
+    weightsHiddenMemInit = dnnl::memory(weightsHiddenMemDesc, dnnlEngine);
+    // reorder input weights
+    network.push_back(dnnl::reorder(
+        weightsInputMemRawInit.getMemory(), weightsInputMemInit));
+    fwdArgs.push_back(
+        {{DNNL_ARG_FROM, weightsInputMemRawInit.getMemory()},
+         {DNNL_ARG_TO, weightsInputMemInit}});
+    // reorder iter weights
+    network.push_back(dnnl::reorder(
+        weightsHiddenMemRawInit.getMemory(), weightsHiddenMemInit));
+    fwdArgs.push_back(
+        {{DNNL_ARG_FROM, weightsHiddenMemRawInit.getMemory()},
+         {DNNL_ARG_TO, weightsHiddenMemInit}});
+    if (packedWeights) {
+      // the raw weights must be reordered before the packed ones are reused
+      detail::executeNetwork(network, fwdArgs);
+      network.clear();
+      fwdArgs.clear();
+      *packedWeights = {weightsInputMemInit, weightsHiddenMemInit};
+    }
+  }
 
   // Add arguments
   std::unordered_map<int, dnnl::memory> rnnFwdArgs = {
@@ -325,27 +415,41 @@ RnnResult rnnImpl(
       {DNNL_ARG_BIAS, biasMemInit.getMemory()},
       {DNNL_ARG_DST_LAYER, outputMemInit.getMemory()},
       {DNNL_ARG_DST_ITER, hiddenOutMemInit.getMemory()}};
+  if (mode == RnnMode::LSTM) {
+    rnnFwdArgs.insert({DNNL_ARG_SRC_ITER_C, cellInMemInit.getMemory()});
+    rnnFwdArgs.insert({DNNL_ARG_DST_ITER_C, cellOutMemInit.getMemory()});
+  }
 
-  // Workspace memory, if needed
-  dnnl::memory workspace;
-  std::vector<dnnl::primitive> network;
-  std::vector<std::unordered_map<int, dnnl::memory>> fwdArgs;
-
-  // reorder input weights
-  network.push_back(
-      dnnl::reorder(weightsInputMemRawInit.getMemory(), weightsInputMemInit));
-  fwdArgs.push_back(
-      {{DNNL_ARG_FROM, weightsInputMemRawInit.getMemory()},
-       {DNNL_ARG_TO, weightsInputMemInit}});
-  // reorder iter weights
-  network.push_back(
-      dnnl::reorder(weightsHiddenMemRawInit.getMemory(), weightsHiddenMemInit));
-  fwdArgs.push_back(
-      {{DNNL_ARG_FROM, weightsHiddenMemRawInit.getMemory()},
-       {DNNL_ARG_TO, weightsHiddenMemInit}});
+  // Primitives only depend on the descriptors of their arguments, which only
+  // depend on the following
+  const auto primitiveKey = makeRnnKey(
+      static_cast<int>(mode),
+      static_cast<int>(kind),
+      static_cast<int>(direction),
+      static_cast<int>(activation),
+      static_cast<int>(dType),
+      seqLength,
+      batchSize,
+      inSize,
+      hiddenSize,
+      numLayers,
+      hiddenState.isEmpty(),
+      cellState.isEmpty());
+  RnnPrimitive rnnPrimitive;
+  bool cached = false;
+  {
+    std::lock_guard<std::mutex> lock(rnnCacheMutex);
+    auto it = rnnPrimitiveCache.find(primitiveKey);
+    if (it != rnnPrimitiveCache.end()) {
+      rnnPrimitive = it->second;
+      cached = true;
+    }
+  }
 
   // Initialize descriptors
-  if (mode == RnnMode::RELU || mode == RnnMode::TANH) {
+  if (cached) {
+    // reused as is
+  } else if (mode == RnnMode::RELU || mode == RnnMode::TANH) {
     auto vanilla = dnnl::vanilla_rnn_forward::desc(
         kind,
         activation,
@@ -359,24 +463,11 @@ RnnResult rnnImpl(
         hiddenOutMemInit.getDescriptor());
     auto vanillaPd =
         dnnl::vanilla_rnn_forward::primitive_desc(vanilla, dnnlEngine);
-    network.push_back(dnnl::vanilla_rnn_forward(vanillaPd));
-    workspace = dnnl::memory(vanillaPd.workspace_desc(), dnnlEngine);
+    rnnPrimitive = {
+        dnnl::vanilla_rnn_forward(vanillaPd), vanillaPd.workspace_desc()};
 
   } else if (mode == RnnMode::LSTM) {
     // LSTM-only
-    // input cell state
-    // TODO(jacobkahn): function that takes the array and
-    // returns the desciptor and memory -- takes an argument for
-    // which determines whether or not it's ok to return empty
-    // descriptors if the array is empty
-    detail::DnnlMemoryWrapper cellInMemInit;
-    if (!cellState.isEmpty()) {
-      cellInMemInit = detail::DnnlMemoryWrapper(
-          cellState.asContiguousTensor(), {cDims}, ldnc);
-    }
-    // output cell state
-    detail::DnnlMemoryWrapper cellOutMemInit(cy, cDims, ldnc);
-
     auto lstm = dnnl::lstm_forward::desc(
         kind,
         direction,
@@ -390,10 +481,7 @@ RnnResult rnnImpl(
         hiddenOutMemInit.getDescriptor(),
         cellOutMemInit.getDescriptor());
     auto lstmPd = dnnl::lstm_forward::primitive_desc(lstm, dnnlEngine);
-    network.push_back(dnnl::lstm_forward(lstmPd));
-    workspace = dnnl::memory(lstmPd.workspace_desc(), dnnlEngine);
-    rnnFwdArgs.insert({DNNL_ARG_SRC_ITER_C, cellInMemInit.getMemory()});
-    rnnFwdArgs.insert({DNNL_ARG_DST_ITER_C, cellOutMemInit.getMemory()});
+    rnnPrimitive = {dnnl::lstm_forward(lstmPd), lstmPd.workspace_desc()};
 
   } else if (mode == RnnMode::GRU) {
     // Use a linear-before-reset GRU so we can have parity with cuDNN
@@ -408,10 +496,20 @@ RnnResult rnnImpl(
         outputMemInit.getDescriptor(),
         hiddenOutMemInit.getDescriptor());
     auto gruPd = dnnl::lbr_gru_forward::primitive_desc(gru, dnnlEngine);
-    network.push_back(dnnl::lbr_gru_forward(gruPd));
-    workspace = dnnl::memory(gruPd.workspace_desc(), dnnlEngine);
+    rnnPrimitive = {dnnl::lbr_gru_forward(gruPd), gruPd.workspace_desc()};
   }
+  if (!cached) {
+    std::lock_guard<std::mutex> lock(rnnCacheMutex);
+    if (rnnPrimitiveCache.size() >= kMaxCachedPrimitives) {
+      rnnPrimitiveCache.clear();
+    }
+    rnnPrimitiveCache.emplace(primitiveKey, rnnPrimitive);
+  }
+
+  // Workspace memory, if needed
+  auto workspace = dnnl::memory(rnnPrimitive.workspaceDesc, dnnlEngine);
   rnnFwdArgs.insert({DNNL_ARG_WORKSPACE, workspace});
+  network.push_back(rnnPrimitive.primitive);
   fwdArgs.push_back(rnnFwdArgs);
 
   detail::executeNetwork(network, fwdArgs);
@@ -423,6 +521,50 @@ RnnResult rnnImpl(
   return result;
 }
 
+// Returns the weights of an RNN parsed and, once its primitives ran, reordered
+// into their layout, reusing those of the same flat weights if cached.
+std::shared_ptr<PrepackedWeights> getPrepackedWeights(
+    const Tensor& weights,
+    RnnMode mode,
+    int numLayers,
+    int directionMult,
+    int inSize,
+    int numGates,
+    int hiddenSize) {
+  const auto key = makeRnnKey(
+      DevicePtr(weights).get(),
+      weights.elements(),
+      static_cast<int>(weights.type()),
+      static_cast<int>(mode),
+      numLayers,
+      directionMult,
+      inSize,
+      hiddenSize);
+  {
+    std::lock_guard<std::mutex> lock(rnnCacheMutex);
+    for (auto it = prepackedWeightsCache.begin();
+         it != prepackedWeightsCache.end();
+         ++it) {
+      if ((*it)->key == key) {
+        prepackedWeightsCache.splice(
+            prepackedWeightsCache.begin(), prepackedWeightsCache, it);
+        return prepackedWeightsCache.front();
+      }
+    }
+  }
+  auto prepacked = std::make_shared<PrepackedWeights>();
+  prepacked->key = key;
+  prepacked->weights = weights.shallowCopy();
+  prepacked->parsed = parseWeights(
+      weights, mode, numLayers, directionMult, inSize, numGates, hiddenSize);
+  std::lock_guard<std::mutex> lock(rnnCacheMutex);
+  prepackedWeightsCache.push_front(prepacked);
+  if (prepackedWeightsCache.size() > kMaxPrepackedWeights) {
+    prepackedWeightsCache.pop_back();
+  }
+  return prepacked;
+}
+
 } // namespace
 
 std::tuple<Tensor, Tensor, Tensor> OneDnnAutogradExtension::rnn(
@@ -475,9 +617,33 @@ std::tuple<Tensor, Tensor, Tensor> OneDnnAutogradExtension::rnn(
   // In Flashlight, all RNN weights are stored as one contiguous tensor, so we
   // have to parse out the input weights, input biases, hidden weights, and
   // hidden biases from one tensor. Order doesn't matter since the arrangement
-  // is a black box
-  auto parsedWeights = parseWeights(
-      weights, mode, numLayers, directionMult, inSize, numGates, hiddenSize);
+  // is a black box. In inference, the parsed weights are cached along with
+  // their layout for the primitives until the weights are updated
+  std::shared_ptr<PrepackedWeights> prepacked;
+  ParsedWeightsAndBias parsedWeights;
+  if (train) {
+    parsedWeights = parseWeights(
+        weights, mode, numLayers, directionMult, inSize, numGates, hiddenSize);
+  } else {
+    prepacked = getPrepackedWeights(
+        weights, mode, numLayers, directionMult, inSize, numGates, hiddenSize);
+    parsedWeights = prepacked->parsed;
+  }
+  // Runs a primitive with the packed weights at the given index if cached
+  auto run = [&](size_t index, auto&&... args) {
+    if (!prepacked) {
+      return rnnImpl(args...);
+    }
+    PackedWeights packed;
+    {
+      std::lock_guard<std::mutex> lock(rnnCacheMutex);
+      packed = prepacked->packed[index];
+    }
+    auto result = rnnImpl(args..., &packed);
+    std::lock_guard<std::mutex> lock(rnnCacheMutex);
+    prepacked->packed[index] = packed;
+    return result;
+  };
 
   RnnResult result;
   // The oneDNN RNN primitive has an API limitation where input size and
@@ -491,7 +657,8 @@ std::tuple<Tensor, Tensor, Tensor> OneDnnAutogradExtension::rnn(
   if (input.dim(0) == hiddenSize || numLayers == 1) {
     // Input and hidden size are the same, or we only have one layer, which
     // means we can call the impl as is and parse weights "normally"
-    result = rnnImpl(
+    result = run(
+        0,
         input,
         hiddenState,
         cellState,
@@ -511,7 +678,8 @@ std::tuple<Tensor, Tensor, Tensor> OneDnnAutogradExtension::rnn(
     // We require more than one layer with different input and hidden states -
     // see the above. Seek to the first layer's hidden/cell state, weights, and
     // bias
-    RnnResult resultL1 = rnnImpl(
+    RnnResult resultL1 = run(
+        0,
         input,
         hiddenState(fl::span, fl::span, 0),
         cellState(fl::span, fl::span, 0),
@@ -530,7 +698,8 @@ std::tuple<Tensor, Tensor, Tensor> OneDnnAutogradExtension::rnn(
 
     /* Layers [2..N] */
     // Seek  past the first layer's hidden/cell state, weights, and bias
-    RnnResult resultL2N = rnnImpl(
+    RnnResult resultL2N = run(
+        1,
         resultL1.y, // fixme
         hiddenState(fl::span, fl::span, fl::range(1, fl::end)),
         cellState(fl::span, fl::span, fl::range(1, fl::end)),
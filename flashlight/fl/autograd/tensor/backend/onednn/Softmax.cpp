@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/autograd/tensor/backend/onednn/OneDnnAutogradExtension.h"
+
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <dnnl.hpp>
+
+#include "flashlight/fl/autograd/tensor/backend/onednn/DnnlUtils.h"
+
+using namespace dnnl;
+
+namespace fl {
+
+namespace {
+
+constexpr auto formatABC = memory::format_tag::abc;
+// The normalized axis of the [outer, axis, inner] view
+constexpr int kSoftmaxAxis = 1;
+
+// Views a tensor normalized along `axis` as [outer, axis, inner] in oneDNN
+// order, such that the contiguous data is unchanged.
+memory::dims getSoftmaxDims(
+    const Shape& shape,
+    const int axis,
+    const char* caller) {
+  if (axis < 0 || axis >= shape.ndim()) {
+    throw std::invalid_argument(
+        std::string("[") + caller + "] invalid axis " + std::to_string(axis) +
+        " for a tensor with " + std::to_string(shape.ndim()) + " dimensions");
+  }
+  Dim inner = 1;
+  for (int i = 0; i < axis; ++i) {
+    inner *= shape[i];
+  }
+  Dim outer = 1;
+  for (int i = axis + 1; i < shape.ndim(); ++i) {
+    outer *= shape[i];
+  }
+  return {outer, shape[axis], inner};
+}
+
+// Softmax and logSoftmax primitives have the same interface.
+template <typename Forward>
+Tensor softmaxForwardImpl(const Tensor& input, const memory::dims& dims) {
+  auto output = Tensor(input.shape(), input.type());
+  auto& dnnlEngine = detail::DnnlEngine::getInstance().getEngine();
+
+  const detail::DnnlMemoryWrapper inputMem(input, dims, formatABC);
+  const detail::DnnlMemoryWrapper outputMem(output, dims, formatABC);
+  auto fwdDesc = typename Forward::desc(
+      prop_kind::forward_training, inputMem.getDescriptor(), kSoftmaxAxis);
+  auto fwdPrimDesc = typename Forward::primitive_desc(fwdDesc, dnnlEngine);
+
+  std::vector<primitive> network{Forward(fwdPrimDesc)};
+  std::vector<std::unordered_map<int, memory>> args{
+      {{DNNL_ARG_SRC, inputMem.getMemory()},
+       {DNNL_ARG_DST, outputMem.getMemory()}}};
+  detail::executeNetwork(network, args);
+  return output;
+}
+
+template <typename Forward, typename Backward>
+Tensor softmaxBackwardImpl(
+    const Tensor& gradOutput,
+    const Tensor& output,
+    const memory::dims& dims) {
+  auto gradInput = Tensor(output.shape(), output.type());
+  auto& dnnlEngine = detail::DnnlEngine::getInstance().getEngine();
+
+  const detail::DnnlMemoryWrapper outputMem(output, dims, formatABC);
+  const detail::DnnlMemoryWrapper gradOutputMem(gradOutput, dims, formatABC);
+  const detail::DnnlMemoryWrapper gradInputMem(gradInput, dims, formatABC);
+  // The backward primitive descriptor takes the forward one as a hint
+  auto fwdDesc = typename Forward::desc(
+      prop_kind::forward_training, outputMem.getDescriptor(), kSoftmaxAxis);
+  auto fwdPrimDesc = typename Forward::primitive_desc(fwdDesc, dnnlEngine);
+  auto bwdDesc = typename Backward::desc(
+      gradOutputMem.getDescriptor(), outputMem.getDescriptor(), kSoftmaxAxis);
+  auto bwdPrimDesc =
+      typename Backward::primitive_desc(bwdDesc, dnnlEngine, fwdPrimDesc);
+
+  std::vector<primitive> network{Backward(bwdPrimDesc)};
+  std::vector<std::unordered_map<int, memory>> args{
+      {{DNNL_ARG_DST, outputMem.getMemory()},
+       {DNNL_ARG_DIFF_DST, gradOutputMem.getMemory()},
+       {DNNL_ARG_DIFF_SRC, gradInputMem.getMemory()}}};
+  detail::executeNetwork(network, args);
+  return gradInput;
+}
+
+} // namespace
+
+Tensor OneDnnAutogradExtension::softmax(
+    const Tensor& inputIn,
+    const int axis,
+    const bool log,
+    std::shared_ptr<detail::AutogradPayload>) {
+  auto input = inputIn.asContiguousTensor();
+  auto dims = getSoftmaxDims(
+      input.shape(), axis, "OneDnnAutogradExtension::softmax");
+  if (log) {
+    return softmaxForwardImpl<logsoftmax_forward>(input, dims);
+  }
+  return softmaxForwardImpl<softmax_forward>(input, dims);
+}
+
+Tensor OneDnnAutogradExtension::softmaxBackward(
+    const Tensor& gradOutputIn,
+    const Tensor& outputIn,
+    const int axis,
+    const bool log,
+    std::shared_ptr<detail::AutogradPayload>) {
+  auto gradOutput = gradOutputIn.asContiguousTensor();
+  auto output = outputIn.asContiguousTensor();
+  auto dims = getSoftmaxDims(
+      output.shape(), axis, "OneDnnAutogradExtension::softmaxBackward");
+  if (log) {
+    return softmaxBackwardImpl<logsoftmax_forward, logsoftmax_backward>(
+        gradOutput, output, dims);
+  }
+  return softmaxBackwardImpl<softmax_forward, softmax_backward>(
+      gradOutput, output, dims);
+}
+
+} // namespace fl
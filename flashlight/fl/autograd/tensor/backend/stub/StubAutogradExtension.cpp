@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/autograd/tensor/backend/stub/StubAutogradExtension.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/backend/stub/StubBackend.h"
+#include "flashlight/fl/tensor/backend/stub/StubTensor.h"
+
+namespace fl {
+
+namespace {
+
+// The dimensions of images and weights, whatever their layout
+struct ImageDims {
+  Dim x;
+  Dim y;
+  Dim channels;
+  Dim batch;
+};
+
+Dim getDim(const Shape& shape, const int i) {
+  return i < shape.ndim() ? shape.dim(i) : 1;
+}
+
+ImageDims getImageDims(const Shape& shape, const MemoryFormat format) {
+  if (format == MemoryFormat::CWHN) {
+    return {getDim(shape, 1), getDim(shape, 2), getDim(shape, 0),
+            getDim(shape, 3)};
+  }
+  return {getDim(shape, 0), getDim(shape, 1), getDim(shape, 2),
+          getDim(shape, 3)};
+}
+
+Shape getImageShape(const ImageDims& dims, const MemoryFormat format) {
+  if (format == MemoryFormat::CWHN) {
+    return {dims.channels, dims.x, dims.y, dims.batch};
+  }
+  return {dims.x, dims.y, dims.channels, dims.batch};
+}
+
+Dim getOutputDim(
+    const Dim inputDim,
+    const Dim kernelDim,
+    const int stride,
+    const int padding,
+    const int dilation,
+    const char* caller) {
+  const Dim dim =
+      1 + (inputDim + 2 * padding - (1 + (kernelDim - 1) * dilation)) / stride;
+  if (dim < 1) {
+    std::ostringstream ss;
+    ss << caller << " - a kernel of size " << kernelDim
+       << " doesn't fit in an input of size " << inputDim;
+    throw std::invalid_argument(ss.str());
+  }
+  return dim;
+}
+
+// The weights have the output channels in their last dimension, and the
+// input channels per group where the input has its own
+ImageDims getConvOutputDims(
+    const Shape& inputShape,
+    const Shape& weightShape,
+    const int sx,
+    const int sy,
+    const int px,
+    const int py,
+    const int dx,
+    const int dy,
+    const MemoryFormat format) {
+  constexpr auto caller = "StubAutogradExtension::conv2d";
+  const auto input = getImageDims(inputShape, format);
+  const auto weights = getImageDims(weightShape, format);
+  return {
+      getOutputDim(input.x, weights.x, sx, px, dx, caller),
+      getOutputDim(input.y, weights.y, sy, py, dy, caller),
+      weights.batch,
+      input.batch};
+}
+
+// A multiply-add per output element and weight of its group
+uint64_t getConvFlops(
+    const Shape& outputShape,
+    const Shape& weightShape,
+    const MemoryFormat format) {
+  const auto weights = getImageDims(weightShape, format);
+  return 2 * static_cast<uint64_t>(outputShape.elements()) * weights.x *
+      weights.y * weights.channels;
+}
+
+Tensor makeTensor(const Shape& shape, const dtype type) {
+  return Tensor(std::make_unique<StubTensor>(shape, type, nullptr, Location{}));
+}
+
+void addFlops(const uint64_t flops) {
+  StubBackend::getInstance().addFlops(flops);
+}
+
+Dim getNumFeatures(const Shape& shape, const std::vector<int>& axes) {
+  Dim features = 1;
+  for (const auto axis : axes) {
+    features *= getDim(shape, axis);
+  }
+  return features;
+}
+
+Dim getLayerNormRows(const Shape& shape, const int numAxes) {
+  if (numAxes < 1 || numAxes > shape.ndim()) {
+    std::ostringstream ss;
+    ss << "StubAutogradExtension::layerNorm - invalid number of axes "
+       << numAxes << " for a tensor of shape " << shape;
+    throw std::invalid_argument(ss.str());
+  }
+  Dim sliceSize = 1;
+  for (int i = 0; i < numAxes; ++i) {
+    sliceSize *= shape.dim(i);
+  }
+  return shape.elements() / sliceSize;
+}
+
+int getNumGates(const RnnMode mode) {
+  switch (mode) {
+    case RnnMode::LSTM:
+      return 4;
+    case RnnMode::GRU:
+      return 3;
+    default:
+      return 1;
+  }
+}
+
+// The multiply-adds of the gates of each layer and direction per step
+uint64_t getRnnFlops(
+    const Shape& inputShape,
+    const int hiddenSize,
+    const int numLayers,
+    const RnnMode mode,
+    const bool bidirectional) {
+  const uint64_t batchSteps = getDim(inputShape, 1) * getDim(inputShape, 2);
+  const int directions = bidirectional ? 2 : 1;
+  uint64_t flops = 0;
+  Dim inputSize = getDim(inputShape, 0);
+  for (int layer = 0; layer < numLayers; ++layer) {
+    flops += 2 * batchSteps * directions * getNumGates(mode) * hiddenSize *
+        (inputSize + hiddenSize);
+    inputSize = hiddenSize * directions;
+  }
+  return flops;
+}
+
+} // namespace
+
+bool StubAutogradExtension::isDataTypeSupported(
+    const fl::dtype& /* dtype */) const {
+  return true;
+}
+
+/**************************** Forward ****************************/
+
+Tensor StubAutogradExtension::conv2d(
+    const Tensor& input,
+    const Tensor& weights,
+    const Tensor& bias,
+    const int sx,
+    const int sy,
+    const int px,
+    const int py,
+    const int dx,
+    const int dy,
+    const int /* groups */,
+    const MemoryFormat format,
+    std::shared_ptr<detail::AutogradPayload> /* payload */) {
+  const auto outputShape = getImageShape(
+      getConvOutputDims(
+          input.shape(), weights.shape(), sx, sy, px, py, dx, dy, format),
+      format);
+  addFlops(getConvFlops(outputShape, weights.shape(), format));
+  if (!bias.isEmpty()) {
+    addFlops(outputShape.elements());
+  }
+  return makeTensor(outputShape, input.type());
+}
+
+Tensor StubAutogradExtension::pool2d(
+    const Tensor& input,
+    const int wx,
+    const int wy,
+    const int sx,
+    const int sy,
+    const int px,
+    const int py,
+    const PoolingMode /* mode */,
+    const MemoryFormat format,
+    std::shared_ptr<detail::AutogradPayload> /* payload */) {
+  constexpr auto caller = "StubAutogradExtension::pool2d";
+  auto dims = getImageDims(input.shape(), format);
+  dims.x = getOutputDim(dims.x, wx, sx, px, 1, caller);
+  dims.y = getOutputDim(dims.y, wy, sy, py, 1, caller);
+  const auto outputShape = getImageShape(dims, format);
+  // an operation per output element and element of its window
+  addFlops(static_cast<uint64_t>(outputShape.elements()) * wx * wy);
+  return makeTensor(outputShape, input.type());
+}
+
+Tensor StubAutogradExtension::batchnorm(
+    Tensor& saveMean,
+    Tensor& saveVar,
+    const Tensor& input,
+    const Tensor& /* weight */,
+    const Tensor& /* bias */,
+    Tensor& runningMean,
+    Tensor& runningVar,
+    const std::vector<int>& axes,
+    const bool /* train */,
+    const double /* momentum */,
+    const double /* epsilon */,
+    std::shared_ptr<detail::AutogradPayload> /* payload */) {
+  const Dim features = getNumFeatures(input.shape(), axes);
+  if (runningMean.isEmpty()) {
+    runningMean = makeTensor({features}, input.type());
+  }
+  if (runningVar.isEmpty()) {
+    runningVar = makeTensor({features}, input.type());
+  }
+  saveMean = makeTensor({features}, input.type());
+  saveVar = makeTensor({features}, input.type());
+  // the statistics, then the normalization and the affine transform
+  addFlops(4 * static_cast<uint64_t>(input.elements()));
+  return makeTensor(input.shape(), input.type());
+}
+
+std::tuple<Tensor, Tensor, Tensor> StubAutogradExtension::rnn(
+    const Tensor& input,
+    const Tensor& /* hiddenState */,
+    const Tensor& /* cellState */,
+    const Tensor& /* weights */,
+    const int hiddenSize,
+    const int numLayers,
+    const RnnMode mode,
+    const bool bidirectional,
+    const float /* dropout */,
+    std::shared_ptr<detail::AutogradPayload> /* payload */) {
+  const int directions = bidirectional ? 2 : 1;
+  const Dim batchSize = getDim(input.shape(), 1);
+  const Dim seqLength = getDim(input.shape(), 2);
+  addFlops(getRnnFlops(
+      input.shape(), hiddenSize, numLayers, mode, bidirectional));
+  auto output =
+      makeTensor({hiddenSize * directions, batchSize, seqLength}, input.type());
+  const Shape hiddenShape({hiddenSize, batchSize, numLayers * directions});
+  auto hiddenOut = makeTensor(hiddenShape, input.type());
+  Tensor cellOut;
+  if (mode == RnnMode::LSTM) {
+    cellOut = makeTensor(hiddenShape, input.type());
+  }
+  return {output, hiddenOut, cellOut};
+}
+
+Tensor StubAutogradExtension::softmax(
+    const Tensor& input,
+    const int /* axis */,
+    const bool /* log */,
+    std::shared_ptr<detail::AutogradPayload> /* payload */) {
+  // the max, the exponential, the sum and the normalization
+  addFlops(4 * static_cast<uint64_t>(input.elements()));
+  return makeTensor(input.shape(), input.type());
+}
+
+Tensor StubAutogradExtension::layerNorm(
+    Tensor& saveMean,
+    Tensor& saveRstd,
+    const Tensor& input,
+    const Tensor& /* weight */,
+    const Tensor& /* bias */,
+    const int numAxes,
+    const double /* epsilon */,
+    std::shared_ptr<detail::AutogradPayload> /* payload */) {
+  const Dim rows = getLayerNormRows(input.shape(), numAxes);
+  saveMean = makeTensor({rows}, input.type());
+  saveRstd = makeTensor({rows}, input.type());
+  addFlops(4 * static_cast<uint64_t>(input.elements()));
+  return makeTensor(input.shape(), input.type());
+}
+
+/**************************** Backward ****************************/
+
+Tensor StubAutogradExtension::conv2dBackwardData(
+    const Tensor& gradOutput,
+    const Tensor& input,
+    const Tensor& weight,
+    const int /* sx */,
+    const int /* sy */,
+    const int /* px */,
+    const int /* py */,
+    const int /* dx */,
+    const int /* dy */,
+    const int /* groups */,
+    const MemoryFormat format,
+    std::shared_ptr<DynamicBenchmark> /* dataGradBenchmark */,
+    std::shared_ptr<detail::AutogradPayload> /* payload */) {
+  addFlops(getConvFlops(gradOutput.shape(), weight.shape(), format));
+  return makeTensor(input.shape(), input.type());
+}
+
+std::pair<Tensor, Tensor> StubAutogradExtension::conv2dBackwardFilterBias(
+    const Tensor& gradOutput,
+    const Tensor& /* input */,
+    const Tensor& weights,
+    const Tensor& bias,
+    const int /* sx */,
+    const int /* sy */,
+    const int /* px */,
+    const int /* py */,
+    const int /* dx */,
+    const int /* dy */,
+    const int /* groups */,
+    const MemoryFormat format,
+    std::shared_ptr<DynamicBenchmark> /* filterBench */,
+    std::shared_ptr<DynamicBenchmark> /* biasBench */,
+    std::shared_ptr<detail::AutogradPayload> /* autogradPayload */) {
+  addFlops(getConvFlops(gradOutput.shape(), weights.shape(), format));
+  Tensor biasGrad;
+  if (!bias.isEmpty()) {
+    addFlops(gradOutput.elements());
+    biasGrad = makeTensor(bias.shape(), bias.type());
+  }
+  return {makeTensor(weights.shape(), weights.type()), biasGrad};
+}
+
+Tensor StubAutogradExtension::pool2dBackward(
+    const Tensor& gradOutput,
+    const Tensor& input,
+    const Tensor& /* poolOutput */,
+    const int wx,
+    const int wy,
+    const int /* sx */,
+    const int /* sy */,
+    const int /* px */,
+    const int /* py */,
+    const PoolingMode /* mode */,
+    const MemoryFormat /* format */,
+    std::shared_ptr<detail::AutogradPayload> /* payload */) {
+  addFlops(static_cast<uint64_t>(gradOutput.elements()) * wx * wy);
+  return makeTensor(input.shape(), input.type());
+}
+
+std::tuple<Tensor, Tensor, Tensor> StubAutogradExtension::batchnormBackward(
+    const Tensor& /* gradOutput */,
+    const Tensor& /* saveMean */,
+    const Tensor& /* saveVar */,
+    const Tensor& input,
+    const Tensor& weight,
+    const std::vector<int>& axes,
+    const bool /* train */,
+    const float /* epsilon */,
+    std::shared_ptr<detail::AutogradPayload> /* payload */) {
+  const Dim features = getNumFeatures(input.shape(), axes);
+  const auto type = weight.isEmpty() ? input.type() : weight.type();
+  addFlops(6 * static_cast<uint64_t>(input.elements()));
+  return {
+      makeTensor(input.shape(), input.type()),
+      makeTensor({features}, type),
+      makeTensor({features}, type)};
+}
+
+std::tuple<Tensor, Tensor, Tensor, Tensor> StubAutogradExtension::rnnBackward(
+    const Tensor& input,
+    const Tensor& hiddenState,
+    const Tensor& cellState,
+    const Tensor& weights,
+    const std::shared_ptr<detail::RNNGradData> /* gradData */,
+    const Tensor& /* output */,
+    const int numLayers,
+    const int hiddenSize,
+    const RnnMode mode,
+    const bool bidirectional,
+    const float /* dropProb */,
+    std::shared_ptr<detail::AutogradPayload> /* payload */) {
+  // the gradients of the data and of the weights
+  addFlops(
+      2 *
+      getRnnFlops(input.shape(), hiddenSize, numLayers, mode, bidirectional));
+  return {
+      makeTensor(input.shape(), input.type()),
+      makeTensor(hiddenState.shape(), hiddenState.type()),
+      makeTensor(cellState.shape(), cellState.type()),
+      makeTensor(weights.shape(), weights.type())};
+}
+
+Tensor StubAutogradExtension::softmaxBackward(
+    const Tensor& /* gradOutput */,
+    const Tensor& output,
+    const int /* axis */,
+    const bool /* log */,
+    std::shared_ptr<detail::AutogradPayload> /* payload */) {
+  addFlops(4 * static_cast<uint64_t>(output.elements()));
+  return makeTensor(output.shape(), output.type());
+}
+
+std::tuple<Tensor, Tensor, Tensor> StubAutogradExtension::layerNormBackward(
+    const Tensor& /* gradOutput */,
+    const Tensor& /* saveMean */,
+    const Tensor& /* saveRstd */,
+    const Tensor& input,
+    const Tensor& weight,
+    const int numAxes,
+    const double /* epsilon */,
+    std::shared_ptr<detail::AutogradPayload> /* payload */) {
+  const Dim sliceSize =
+      input.elements() / getLayerNormRows(input.shape(), numAxes);
+  const auto type = weight.isEmpty() ? input.type() : weight.type();
+  addFlops(6 * static_cast<uint64_t>(input.elements()));
+  // the gradients of the affine transform, as for the fused kernels
+  return {
+      makeTensor(input.shape(), input.type()),
+      makeTensor({sliceSize}, type),
+      makeTensor({sliceSize}, type)};
+}
+
+} // namespace fl
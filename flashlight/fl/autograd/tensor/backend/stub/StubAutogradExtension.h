@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "flashlight/fl/autograd/tensor/AutogradExtension.h"
+
+namespace fl {
+
+/**
+ * The autograd extension of the `StubBackend`, whose ops give the shapes and
+ * types of the outputs and count on the backend the floating point operations
+ * the ops would take, such that models with convolutions, normalizations or
+ * RNNs can run a dry run.
+ */
+class StubAutogradExtension : public AutogradExtension {
+ public:
+  bool isDataTypeSupported(const fl::dtype& dtype) const override;
+
+  /**************************** Forward ****************************/
+  Tensor conv2d(
+      const Tensor& input,
+      const Tensor& weights,
+      const Tensor& bias,
+      const int sx,
+      const int sy,
+      const int px,
+      const int py,
+      const int dx,
+      const int dy,
+      const int groups,
+      const MemoryFormat format,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  Tensor pool2d(
+      const Tensor& input,
+      const int wx,
+      const int wy,
+      const int sx,
+      const int sy,
+      const int px,
+      const int py,
+      const PoolingMode mode,
+      const MemoryFormat format,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  Tensor batchnorm(
+      Tensor& saveMean,
+      Tensor& saveVar,
+      const Tensor& input,
+      const Tensor& weight,
+      const Tensor& bias,
+      Tensor& runningMean,
+      Tensor& runningVar,
+      const std::vector<int>& axes,
+      const bool train,
+      const double momentum,
+      const double epsilon,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  std::tuple<Tensor, Tensor, Tensor> rnn(
+      const Tensor& input,
+      const Tensor& hiddenState,
+      const Tensor& cellState,
+      const Tensor& weights,
+      const int hiddenSize,
+      const int numLayers,
+      const RnnMode mode,
+      const bool bidirectional,
+      const float dropout,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  Tensor softmax(
+      const Tensor& input,
+      const int axis,
+      const bool log,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  Tensor layerNorm(
+      Tensor& saveMean,
+      Tensor& saveRstd,
+      const Tensor& input,
+      const Tensor& weight,
+      const Tensor& bias,
+      const int numAxes,
+      const double epsilon,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  /**************************** Backward ****************************/
+  // ]----- Convolution
+  Tensor conv2dBackwardData(
+      const Tensor& gradOutput,
+      const Tensor& input,
+      const Tensor& weight,
+      const int sx,
+      const int sy,
+      const int px,
+      const int py,
+      const int dx,
+      const int dy,
+      const int groups,
+      const MemoryFormat format,
+      std::shared_ptr<DynamicBenchmark> dataGradBenchmark,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  std::pair<Tensor, Tensor> conv2dBackwardFilterBias(
+      const Tensor& gradOutput,
+      const Tensor& input,
+      const Tensor& weights,
+      const Tensor& bias,
+      const int sx,
+      const int sy,
+      const int px,
+      const int py,
+      const int dx,
+      const int dy,
+      const int groups,
+      const MemoryFormat format,
+      std::shared_ptr<DynamicBenchmark> filterBench,
+      std::shared_ptr<DynamicBenchmark> biasBench,
+      std::shared_ptr<detail::AutogradPayload> autogradPayload) override;
+
+  // ]----- pool2D
+  Tensor pool2dBackward(
+      const Tensor& gradOutput,
+      const Tensor& input,
+      const Tensor& poolOutput,
+      const int wx,
+      const int wy,
+      const int sx,
+      const int sy,
+      const int px,
+      const int py,
+      const PoolingMode mode,
+      const MemoryFormat format,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  // ]----- batchnorm
+  std::tuple<Tensor, Tensor, Tensor> batchnormBackward(
+      const Tensor& gradOutput,
+      const Tensor& saveMean,
+      const Tensor& saveVar,
+      const Tensor& input,
+      const Tensor& weight,
+      const std::vector<int>& axes,
+      const bool train,
+      const float epsilon,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  // ]----- rnn
+  std::tuple<Tensor, Tensor, Tensor, Tensor> rnnBackward(
+      const Tensor& input,
+      const Tensor& hiddenState,
+      const Tensor& cellState,
+      const Tensor& weights,
+      const std::shared_ptr<detail::RNNGradData> gradData,
+      const Tensor& output,
+      const int numLayers,
+      const int hiddenSize,
+      const RnnMode mode,
+      const bool bidirectional,
+      const float dropProb,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  // ]----- softmax
+  Tensor softmaxBackward(
+      const Tensor& gradOutput,
+      const Tensor& output,
+      const int axis,
+      const bool log,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+
+  // ]----- layerNorm
+  std::tuple<Tensor, Tensor, Tensor> layerNormBackward(
+      const Tensor& gradOutput,
+      const Tensor& saveMean,
+      const Tensor& saveRstd,
+      const Tensor& input,
+      const Tensor& weight,
+      const int numAxes,
+      const double epsilon,
+      std::shared_ptr<detail::AutogradPayload> payload) override;
+};
+
+} // namespace fl
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/common/BenchmarkCache.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include "flashlight/fl/common/DynamicBenchmark.h"
+#include "flashlight/fl/common/Utils.h"
+
+namespace fl {
+
+namespace {
+
+using CacheMap = std::map<std::string, size_t>;
+
+std::mutex cacheMutex;
+// whether entries were added or replaced since the cache was loaded
+bool cacheChanged = false;
+
+// Parses serialized entries, skipping malformed lines
+CacheMap parseEntries(const std::string& data) {
+  CacheMap entries;
+  std::istringstream ss(data);
+  std::string line;
+  while (std::getline(ss, line)) {
+    const auto tab = line.rfind('\t');
+    if (tab == std::string::npos || tab == 0) {
+      continue;
+    }
+    try {
+      entries[line.substr(0, tab)] = std::stoull(line.substr(tab + 1));
+    } catch (const std::exception&) {
+      continue;
+    }
+  }
+  return entries;
+}
+
+std::string readFile(const fs::path& path) {
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error(
+        "[BenchmarkCache] can't read file " + path.string());
+  }
+  std::ostringstream ss;
+  ss << file.rdbuf();
+  return ss.str();
+}
+
+void saveToEnvFile();
+
+// Must be called with cacheMutex held
+CacheMap& getCache() {
+  static CacheMap cache = []() {
+    CacheMap init;
+    const auto path = getEnvVar(BenchmarkCache::kCacheFileEnv);
+    if (!path.empty()) {
+      if (fs::exists(path)) {
+        init = parseEntries(readFile(path));
+      }
+      // registered after the construction of the cache, so runs before its
+      // destruction
+      std::atexit(saveToEnvFile);
+    }
+    return init;
+  }();
+  return cache;
+}
+
+void saveToEnvFile() {
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (!cacheChanged || DynamicBenchmark::isFrozen()) {
+      return;
+    }
+  }
+  const auto path = getEnvVar(BenchmarkCache::kCacheFileEnv);
+  try {
+    BenchmarkCache::save(path);
+  } catch (const std::exception& ex) {
+    std::cerr << "[BenchmarkCache] can't save to " << path << ": " << ex.what()
+              << std::endl;
+  }
+}
+
+std::string serializeEntries(const CacheMap& entries) {
+  std::ostringstream ss;
+  for (const auto& [key, optionIndex] : entries) {
+    ss << key << '\t' << optionIndex << '\n';
+  }
+  return ss.str();
+}
+
+} // namespace
+
+std::optional<size_t> BenchmarkCache::get(const std::string& key) {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  const auto& cache = getCache();
+  auto it = cache.find(key);
+  if (it == cache.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void BenchmarkCache::set(const std::string& key, size_t optionIndex) {
+  if (key.empty() || key.find_first_of("\t\n") != std::string::npos) {
+    throw std::invalid_argument(
+        "[BenchmarkCache::set] keys must be non-empty and can't contain tabs "
+        "or newlines");
+  }
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  auto [it, inserted] = getCache().emplace(key, optionIndex);
+  if (!inserted && it->second != optionIndex) {
+    it->second = optionIndex;
+    inserted = true;
+  }
+  cacheChanged |= inserted;
+}
+
+std::vector<std::pair<std::string, size_t>> BenchmarkCache::entries() {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  const auto& cache = getCache();
+  return {cache.begin(), cache.end()};
+}
+
+void BenchmarkCache::clear() {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  getCache().clear();
+}
+
+size_t BenchmarkCache::deserialize(
+    const std::string& data,
+    bool overwrite /* = true */) {
+  const auto parsed = parseEntries(data);
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  auto& cache = getCache();
+  size_t merged = 0;
+  for (const auto& [key, optionIndex] : parsed) {
+    auto it = cache.find(key);
+    if (it == cache.end()) {
+      cache.emplace(key, optionIndex);
+      ++merged;
+    } else if (overwrite && it->second != optionIndex) {
+      it->second = optionIndex;
+      ++merged;
+    }
+  }
+  cacheChanged |= merged > 0;
+  return merged;
+}
+
+std::string BenchmarkCache::serialize() {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  return serializeEntries(getCache());
+}
+
+size_t BenchmarkCache::load(const fs::path& path, bool overwrite /* = true */) {
+  return deserialize(readFile(path), overwrite);
+}
+
+void BenchmarkCache::save(const fs::path& path) {
+  CacheMap entries;
+  if (fs::exists(path)) {
+    entries = parseEntries(readFile(path));
+  }
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (const auto& [key, optionIndex] : getCache()) {
+      entries[key] = optionIndex;
+    }
+  }
+
+  // write to a file of a unique name in the same directory, then move it over
+  // the destination, which replaces it atomically
+  auto tmpPath = path;
+  tmpPath += ".tmp" + std::to_string(std::random_device()());
+  {
+    std::ofstream file(tmpPath);
+    file << serializeEntries(entries);
+    if (!file) {
+      throw std::runtime_error(
+          "[BenchmarkCache::save] can't write file " + tmpPath.string());
+    }
+  }
+  fs::rename(tmpPath, path);
+}
+
+} // namespace fl
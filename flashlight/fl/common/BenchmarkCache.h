@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/common/Filesystem.h"
+
+namespace fl {
+
+/**
+ * A process-wide cache of the options chosen by `DynamicBenchmark`s, keyed by
+ * the operation and shapes they were benchmarked for (see
+ * `DynamicBenchmark::setCacheKey`), such that a benchmark whose key is cached
+ * uses the cached option right away rather than timing each option again.
+ *
+ * The cache can be saved to a file and loaded by later runs, on the same
+ * hardware and libraries. If the `FL_BENCHMARK_CACHE` environment variable
+ * names a file, it's loaded on first use of the cache, if it exists, and
+ * saved at exit if entries changed, unless `DynamicBenchmark` frozen mode is
+ * on, such that jobs warm-start from the benchmarks of previous ones.
+ */
+class BenchmarkCache {
+ public:
+  /** The name of the environment variable of the file loaded on first use */
+  static constexpr const char* kCacheFileEnv = "FL_BENCHMARK_CACHE";
+
+  /**
+   * @return the index of the option cached for a key, if any.
+   */
+  static std::optional<size_t> get(const std::string& key);
+
+  /**
+   * Caches the index of the option chosen for a key, replacing any previous
+   * one. Keys can't contain tabs or newlines.
+   */
+  static void set(const std::string& key, size_t optionIndex);
+
+  /**
+   * @return all cached keys and option indices, sorted by key.
+   */
+  static std::vector<std::pair<std::string, size_t>> entries();
+
+  /** Removes all entries. */
+  static void clear();
+
+  /**
+   * Merges entries serialized by `serialize`. Keys which are already cached
+   * keep their option unless `overwrite` is true.
+   *
+   * @return the number of entries which were added or replaced.
+   */
+  static size_t deserialize(const std::string& data, bool overwrite = true);
+
+  /**
+   * @return the entries as text, with one tab-separated key and option index
+   * per line.
+   */
+  static std::string serialize();
+
+  /**
+   * Merges the entries of a file written by `save`, see `deserialize`.
+   * Throws if the file can't be read.
+   */
+  static size_t load(const fs::path& path, bool overwrite = true);
+
+  /**
+   * Saves the entries to a file, merged with those already in it. The file is
+   * replaced atomically, so concurrent readers never see partial contents.
+   */
+  static void save(const fs::path& path);
+};
+
+} // namespace fl
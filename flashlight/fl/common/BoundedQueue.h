@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace fl {
+
+/**
+ * A bounded multi-producer multi-consumer FIFO queue on a ring buffer, to hand
+ * off items between threads, e.g. samples from loading workers to a training
+ * loop, without per-item allocations.
+ *
+ * `tryPush` and `tryPop` are lock-free: each slot of the ring carries a
+ * sequence number, which tells producers and consumers claiming the slot with
+ * a CAS whether it is free or holds an item, as in D. Vyukov's bounded MPMC
+ * queue.
+ * The blocking `push` and `pop` only take a mutex to sleep while the queue is
+ * full or empty, and their counterparts only notify when a thread sleeps.
+ *
+ * After `close`, pushes fail and pops return the remaining items, then fail,
+ * which ends the consumer loops:
+  \code{.cpp}
+  BoundedQueue<Sample> queue(16);
+  // producer threads
+  while (queue.push(load())) {}
+  // once the producers are done
+  queue.close();
+  // consumer threads
+  Sample sample;
+  while (queue.pop(sample)) {
+    // ...
+  }
+  \endcode
+ *
+ * Items are moved in and out of default-constructed slots, so `T` must be
+ * default constructible and move assignable.
+ */
+template <typename T>
+class BoundedQueue {
+ public:
+  /**
+   * @param[in] capacity the maximum number of queued items, not 0
+   */
+  explicit BoundedQueue(size_t capacity)
+      : capacity_(capacity), slots_(new Slot[capacity]) {
+    if (capacity == 0) {
+      throw std::invalid_argument("BoundedQueue - capacity must be positive");
+    }
+  }
+
+  // no copy/move
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  /**
+   * Pushes an item unless the queue is full or closed.
+   * @return whether the item was pushed; if not, `item` is left as is
+   */
+  bool tryPush(T& item) {
+    if (closed_.load(std::memory_order_acquire) || !enqueue(item)) {
+      return false;
+    }
+    notify(waitingConsumers_, notEmpty_);
+    return true;
+  }
+
+  bool tryPush(T&& item) {
+    return tryPush(item);
+  }
+
+  /**
+   * Pushes an item, waiting while the queue is full.
+   * @return whether the item was pushed, i.e. false if the queue is closed
+   */
+  bool push(T& item) {
+    while (!tryPush(item)) {
+      if (closed_.load(std::memory_order_acquire)) {
+        return false;
+      }
+      wait(waitingProducers_, notFull_, [this]() {
+        return closed_.load(std::memory_order_acquire) || canEnqueue();
+      });
+    }
+    return true;
+  }
+
+  bool push(T&& item) {
+    return push(item);
+  }
+
+  /**
+   * Pops the oldest item unless the queue is empty.
+   * @return whether an item was popped into `item`
+   */
+  bool tryPop(T& item) {
+    if (!dequeue(item)) {
+      return false;
+    }
+    notify(waitingProducers_, notFull_);
+    return true;
+  }
+
+  /**
+   * Pops the oldest item, waiting while the queue is empty and open.
+   * @return whether an item was popped into `item`, i.e. false if the queue is
+   * closed and empty
+   */
+  bool pop(T& item) {
+    for (;;) {
+      // items pushed before the queue was closed are still popped
+      const bool closed = closed_.load(std::memory_order_acquire);
+      if (tryPop(item)) {
+        return true;
+      }
+      if (closed) {
+        return false;
+      }
+      wait(waitingConsumers_, notEmpty_, [this]() {
+        return closed_.load(std::memory_order_acquire) || canDequeue();
+      });
+    }
+  }
+
+  /**
+   * Closes the queue: wakes up the waiting threads, fails further pushes, and
+   * lets pops fail once the queue is empty. Pushes concurrent to `close` may
+   * either succeed or fail.
+   */
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(waitMutex_);
+      closed_.store(true, std::memory_order_release);
+    }
+    notFull_.notify_all();
+    notEmpty_.notify_all();
+  }
+
+  bool isClosed() const {
+    return closed_.load(std::memory_order_acquire);
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  /**
+   * @return the number of queued items, which is approximate while other
+   * threads push or pop
+   */
+  size_t size() const {
+    const auto tail = dequeuePos_.load(std::memory_order_relaxed);
+    const auto head = enqueuePos_.load(std::memory_order_relaxed);
+    return head > tail ? std::min(head - tail, capacity_) : 0;
+  }
+
+ private:
+  // padded to a cache line, such that threads claiming adjacent slots don't
+  // contend on it
+  struct alignas(64) Slot {
+    std::atomic<size_t> sequence{0};
+    T item;
+  };
+
+  // The i-th lap over the ring of the positions of pushes and pops: a slot
+  // whose sequence is 2i is free for the push of lap i; at 2i + 1, it holds
+  // the item of the pop of lap i.
+  size_t lap(size_t pos) const {
+    return pos / capacity_;
+  }
+
+  bool enqueue(T& item) {
+    auto pos = enqueuePos_.load(std::memory_order_relaxed);
+    for (;;) {
+      auto& slot = slots_[pos % capacity_];
+      const auto sequence = slot.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(sequence - 2 * lap(pos));
+      if (diff == 0) {
+        if (enqueuePos_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          slot.item = std::move(item);
+          slot.sequence.store(2 * lap(pos) + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // full
+      } else {
+        pos = enqueuePos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool dequeue(T& item) {
+    auto pos = dequeuePos_.load(std::memory_order_relaxed);
+    for (;;) {
+      auto& slot = slots_[pos % capacity_];
+      const auto sequence = slot.sequence.load(std::memory_order_acquire);
+      const auto diff =
+          static_cast<std::ptrdiff_t>(sequence - (2 * lap(pos) + 1));
+      if (diff == 0) {
+        if (dequeuePos_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          item = std::move(slot.item);
+          slot.sequence.store(2 * lap(pos) + 2, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // empty
+      } else {
+        pos = dequeuePos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool canEnqueue() const {
+    const auto pos = enqueuePos_.load(std::memory_order_relaxed);
+    return slots_[pos % capacity_].sequence.load(std::memory_order_acquire) ==
+        2 * lap(pos);
+  }
+
+  bool canDequeue() const {
+    const auto pos = dequeuePos_.load(std::memory_order_relaxed);
+    return slots_[pos % capacity_].sequence.load(std::memory_order_acquire) ==
+        2 * lap(pos) + 1;
+  }
+
+  // The waiter registers before checking the predicate and the notifier checks
+  // for waiters after its update, both behind full fences, so either the
+  // waiter sees the update or the notifier sees the waiter.
+  template <typename Predicate>
+  void wait(
+      std::atomic<size_t>& waiting,
+      std::condition_variable& condition,
+      Predicate predicate) {
+    std::unique_lock<std::mutex> lock(waitMutex_);
+    waiting.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    condition.wait(lock, predicate);
+    waiting.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void notify(
+      std::atomic<size_t>& waiting,
+      std::condition_variable& condition) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed) > 0) {
+      // the waiter is either asleep or yet to check the predicate
+      std::lock_guard<std::mutex> lock(waitMutex_);
+      condition.notify_one();
+    }
+  }
+
+  const size_t capacity_;
+  const std::unique_ptr<Slot[]> slots_;
+  alignas(64) std::atomic<size_t> enqueuePos_{0};
+  alignas(64) std::atomic<size_t> dequeuePos_{0};
+  alignas(64) std::atomic<bool> closed_{false};
+  std::atomic<size_t> waitingProducers_{0};
+  std::atomic<size_t> waitingConsumers_{0};
+  std::mutex waitMutex_;
+  std::condition_variable notFull_;
+  std::condition_variable notEmpty_;
+};
+
+} // namespace fl
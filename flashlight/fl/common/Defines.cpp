@@ -21,6 +21,19 @@ void OptimMode::setOptimLevel(OptimLevel level) {
   optimLevel_ = level;
 }
 
+fl::dtype OptimMode::getHalfPrecisionType() {
+  return halfPrecisionType_;
+}
+
+void OptimMode::setHalfPrecisionType(fl::dtype type) {
+  if (!isHalfPrecisionType(type)) {
+    throw std::invalid_argument(
+        "OptimMode::setHalfPrecisionType - expects f16 or bf16, given " +
+        dtypeToString(type));
+  }
+  halfPrecisionType_ = type;
+}
+
 OptimMode& OptimMode::get() {
   static OptimMode optimMode;
   return optimMode;
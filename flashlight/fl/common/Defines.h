@@ -11,6 +11,8 @@
 #include <string>
 #include <unordered_map>
 
+#include "flashlight/fl/tensor/Types.h"
+
 namespace fl {
 
 /**
@@ -43,6 +45,20 @@ enum class PoolingMode {
   AVG_EXCLUDE_PADDING = 2,
 };
 
+/**
+ * Memory layout of the images of convolutions and pooling
+ */
+enum class MemoryFormat {
+  /// Images of shape [W, H, C, N], with weights of shape [W, H, C_in, C_out].
+  /// The default layout of flashlight.
+  WHCN = 0,
+
+  /// Channels-last images of shape [C, W, H, N], i.e. NHWC in row-major
+  /// order, with weights of shape [C_in, W, H, C_out]. The fast layout of
+  /// tensor-core convolutions in half precision.
+  CWHN = 1,
+};
+
 /**
  * RNN network type
  */
@@ -69,11 +85,39 @@ enum class DistributedBackend {
 enum class DistributedInit {
   MPI = 0,
   FILE_SYSTEM = 1,
+  /// Through a TCP store served by the process of rank 0
+  TCP = 2,
+  /// The ranks are threads of this process, one per CUDA device, which run
+  /// the function given to `runOnDevices`
+  LOCAL = 3,
 };
 
 namespace DistributedConstants {
 constexpr const char* kMaxDevicePerNode = "MAX_DEVICE_PER_NODE";
 constexpr const char* kFilePath = "FILE_PATH";
+/// The host name or address of the process of rank 0, and the port of its
+/// store, for `DistributedInit::TCP`
+constexpr const char* kStoreHost = "STORE_HOST";
+constexpr const char* kStorePort = "STORE_PORT";
+/// The allreduce algorithm of the NCCL backend, one of the following modes
+constexpr const char* kAllReduceMode = "ALLREDUCE_MODE";
+/// An allreduce over all processes at once (the default)
+constexpr const char* kAllReduceModeFlat = "FLAT";
+/// A reduce-scatter within each node, an allreduce of the shards across nodes
+/// and an all-gather within each node, for slower links between nodes than
+/// within them
+constexpr const char* kAllReduceModeHierarchical = "HIERARCHICAL";
+/// The number of threads running the asynchronous operations of the Gloo
+/// backend, each with its own connections (2 by default)
+constexpr const char* kCommThreads = "COMM_THREADS";
+/// The allreduce algorithm of the Gloo backend, one of the following
+constexpr const char* kGlooAlgorithm = "GLOO_ALGORITHM";
+/// Chosen by message size: bcube for small messages, halving-doubling for
+/// medium ones and a chunked ring for large ones (the default)
+constexpr const char* kGlooAlgorithmAuto = "AUTO";
+constexpr const char* kGlooAlgorithmRing = "RING";
+constexpr const char* kGlooAlgorithmBcube = "BCUBE";
+constexpr const char* kGlooAlgorithmHalvingDoubling = "HALVING_DOUBLING";
 constexpr const std::size_t kCoalesceCacheSize = ((size_t)(20) << 20); // 20 MB
 } // namespace DistributedConstants
 
@@ -132,6 +176,24 @@ class OptimMode {
    */
   void setOptimLevel(OptimLevel level);
 
+  /**
+   * Gets the 16-bit floating point type to which operations are cast with
+   * optimization levels other than `OptimLevel::DEFAULT`. Not thread safe.
+   *
+   * @return the half precision type, f16 by default.
+   */
+  fl::dtype getHalfPrecisionType();
+
+  /**
+   * Sets the 16-bit floating point type to which operations are cast with
+   * optimization levels other than `OptimLevel::DEFAULT`, i.e. `fl::dtype::f16`
+   * or `fl::dtype::bf16`. bf16 has the exponent range of f32, so training with
+   * it needs no loss scaling. Not thread safe.
+   *
+   * @param[in] type the half precision type to set
+   */
+  void setHalfPrecisionType(fl::dtype type);
+
   /**
    *
    */
@@ -141,6 +203,7 @@ class OptimMode {
 
  private:
   OptimLevel optimLevel_{OptimLevel::DEFAULT};
+  fl::dtype halfPrecisionType_{fl::dtype::f16};
 };
 
 /** @} */
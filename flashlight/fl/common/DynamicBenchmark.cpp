@@ -7,12 +7,15 @@
  */
 
 #include "flashlight/fl/common/DynamicBenchmark.h"
+
+#include "flashlight/fl/common/BenchmarkCache.h"
 #include "flashlight/fl/tensor/Compute.h"
 
 namespace fl {
 
 // Default value for benchmark mode
 bool DynamicBenchmark::benchmarkMode_ = false;
+bool DynamicBenchmark::frozen_ = false;
 
 void DynamicBenchmark::audit(
     const std::function<void()>& function,
@@ -20,7 +23,7 @@ void DynamicBenchmark::audit(
   // Only run the benchmarking components if some options are yet to be
   // fully-timed and benchmark mode is on - otherwise, only run the passed
   // lambda
-  if (options_->timingsComplete() || !benchmarkMode_) {
+  if (options_->timingsComplete() || !benchmarkMode_ || frozen_) {
     function();
   } else {
     start();
@@ -38,6 +41,21 @@ void DynamicBenchmark::stop(bool incrementCount) {
   fl::sync();
   auto elapsedTime = fl::Timer::stop(currentTimer_);
   options_->accumulateTimeToCurrentOption(elapsedTime, incrementCount);
+  if (!cacheKey_.empty() && options_->timingsComplete()) {
+    BenchmarkCache::set(cacheKey_, options_->currentOptionIndex());
+  }
+}
+
+void DynamicBenchmark::setCacheKey(const std::string& key) {
+  cacheKey_ = key;
+  if (options_->timingsComplete()) {
+    return;
+  }
+  auto cached = BenchmarkCache::get(key);
+  // options cached by other versions may be out of range
+  if (cached && *cached < options_->numOptions()) {
+    options_->setOptionIndex(*cached);
+  }
 }
 
 void DynamicBenchmark::setBenchmarkMode(bool mode) {
@@ -48,4 +66,16 @@ bool DynamicBenchmark::getBenchmarkMode() {
   return benchmarkMode_;
 }
 
+bool DynamicBenchmark::useOptions() const {
+  return benchmarkMode_ && (!frozen_ || options_->timingsComplete());
+}
+
+void DynamicBenchmark::setFrozen(bool frozen) {
+  frozen_ = frozen;
+}
+
+bool DynamicBenchmark::isFrozen() {
+  return frozen_;
+}
+
 } // namespace fl
@@ -11,6 +11,7 @@
 #include <functional>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -42,6 +43,24 @@ struct DynamicBenchmarkOptionsBase {
         "- unimplemented");
   }
 
+  virtual size_t numOptions() const {
+    throw std::logic_error(
+        "DynamicBenchmarkOptionsBase::numOptions "
+        "- unimplemented");
+  }
+
+  virtual size_t currentOptionIndex() {
+    throw std::logic_error(
+        "DynamicBenchmarkOptionsBase::currentOptionIndex "
+        "- unimplemented");
+  }
+
+  virtual void setOptionIndex(size_t) {
+    throw std::logic_error(
+        "DynamicBenchmarkOptionsBase::setOptionIndex "
+        "- unimplemented");
+  }
+
  protected:
   // Not intended for construction
   DynamicBenchmarkOptionsBase() = default;
@@ -141,6 +160,38 @@ struct DynamicBenchmarkOptions : DynamicBenchmarkOptionsBase {
     return timingsComplete_;
   }
 
+  /**
+   * @return the number of options.
+   */
+  size_t numOptions() const override {
+    return options_.size();
+  }
+
+  /**
+   * @return the index of the current option, see `currentOption`.
+   */
+  size_t currentOptionIndex() override {
+    updateState();
+    return currentOptionIdx_;
+  }
+
+  /**
+   * Fixes the option at the given index, e.g. one benchmarked by a previous
+   * run, which completes the timings.
+   *
+   * @param[in] idx the index of the option to use
+   */
+  void setOptionIndex(size_t idx) override {
+    if (idx >= options_.size()) {
+      throw std::invalid_argument(
+          "Options::setOptionIndex: index " + std::to_string(idx) +
+          " is out of range for " + std::to_string(options_.size()) +
+          " options");
+    }
+    currentOptionIdx_ = idx;
+    timingsComplete_ = true;
+  }
+
   /**
    * Adds time to the current option tally.
    *
@@ -213,6 +264,23 @@ class DynamicBenchmark {
    */
   void audit(const std::function<void()>& function, bool incrementCount = true);
 
+  /**
+   * Sets the key of what is benchmarked, e.g. an operation and the shapes of
+   * its inputs. If the timings aren't complete and the `BenchmarkCache` has an
+   * option for the key, that option is used right away; otherwise, the option
+   * chosen once the timings complete is cached for the key.
+   *
+   * @param[in] key the key in the `BenchmarkCache`
+   */
+  void setCacheKey(const std::string& key);
+
+  /**
+   * @return whether callers should use the current option of the benchmark
+   * rather than their default: when benchmark mode is on, unless frozen mode
+   * is on and no option was chosen, e.g. none was cached for the key.
+   */
+  bool useOptions() const;
+
   /**
    * Gets the benchmarks' underlying `DynamicBenchmarkOptionsBase` instance.
    *
@@ -238,6 +306,21 @@ class DynamicBenchmark {
    */
   static bool getBenchmarkMode();
 
+  /**
+   * Sets global frozen mode, e.g. for production inference. If frozen mode is
+   * on, `DynamicBenchmark`s never time their options: those whose key is in
+   * the `BenchmarkCache` use the cached option, and others the callers'
+   * default (see `useOptions`). The cache isn't updated.
+   *
+   * @param[in] frozen the new value of frozen mode
+   */
+  static void setFrozen(bool frozen);
+
+  /**
+   * @return whether frozen mode is globally enabled
+   */
+  static bool isFrozen();
+
  private:
   // Starts the benchmark timer
   void start();
@@ -245,12 +328,16 @@ class DynamicBenchmark {
   void stop(bool incrementCount);
 
   std::shared_ptr<DynamicBenchmarkOptionsBase> options_;
+  // The key of the chosen option in the BenchmarkCache, if any
+  std::string cacheKey_;
   // Timer for current benchmark iteration
   fl::Timer currentTimer_;
 
   // Global fl benchmark mode - if off, no benchmarks will run, and audited
   // functions will be run directly without timings
   static bool benchmarkMode_;
+  // Global frozen mode - if on, no options are timed
+  static bool frozen_;
 };
 
 // Specific benchmark implementations
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/common/MappedCheckpoint.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "flashlight/fl/tensor/Compute.h"
+
+namespace fl {
+
+namespace {
+
+// The file starts with the magic and the size of the archive of the header
+constexpr char kMagic[8] = {'F', 'L', 'M', 'C', 'K', 'P', 'T', '\0'};
+constexpr uint64_t kPrefixBytes = sizeof(kMagic) + sizeof(uint64_t);
+constexpr uint32_t kVersion = 1;
+// the data region starts on a page, such that it can be mapped on its own
+constexpr uint64_t kDataAlignment = 4096;
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+std::string serializeHeader(
+    const std::string& structure,
+    const std::vector<MappedCheckpoint::TensorInfo>& infos) {
+  std::ostringstream header;
+  {
+    cereal::BinaryOutputArchive ar(header);
+    ar(kVersion, structure, infos);
+  }
+  return header.str();
+}
+
+void writeZeros(std::ostream& file, uint64_t bytes) {
+  static const char zeros[kDataAlignment] = {};
+  while (bytes > 0) {
+    const auto n = std::min(bytes, kDataAlignment);
+    file.write(zeros, n);
+    bytes -= n;
+  }
+}
+
+} // namespace
+
+void MappedCheckpoint::write(
+    const fs::path& path,
+    const std::string& structure,
+    const std::vector<Tensor>& tensors) {
+  std::vector<TensorInfo> infos;
+  for (const auto& tensor : tensors) {
+    if (tensor.isSparse()) {
+      throw std::invalid_argument(
+          "MappedCheckpoint::save - sparse tensors aren't supported");
+    }
+    infos.push_back({tensor.shape(), tensor.type(), 0, tensor.bytes()});
+  }
+  // the offsets are fixed-size fields, so they don't change the header size
+  const uint64_t headerBytes = serializeHeader(structure, infos).size();
+  uint64_t offset = alignUp(kPrefixBytes + headerBytes, kDataAlignment);
+  for (auto& info : infos) {
+    offset = alignUp(offset, kTensorAlignment);
+    info.offset = offset;
+    offset += info.bytes;
+  }
+  const auto header = serializeHeader(structure, infos);
+
+  // written beside the destination, then moved over it, such that readers
+  // never map a partial file
+  auto tmpPath = path;
+  tmpPath += ".tmp" + std::to_string(std::random_device()());
+  {
+    std::ofstream file(tmpPath, std::ios::binary);
+    if (!file) {
+      throw std::runtime_error(
+          "MappedCheckpoint::save - can't write file " + tmpPath.string());
+    }
+    const uint64_t size = header.size();
+    file.write(kMagic, sizeof(kMagic));
+    file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    file << header;
+    uint64_t position = kPrefixBytes + header.size();
+    std::vector<uint8_t> buffer;
+    for (size_t i = 0; i < tensors.size() && file; ++i) {
+      writeZeros(file, infos[i].offset - position);
+      buffer.resize(infos[i].bytes);
+      if (!buffer.empty()) {
+        tensors[i].host(buffer.data());
+      }
+      file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+      position = infos[i].offset + infos[i].bytes;
+    }
+    if (!file) {
+      fs::remove(tmpPath);
+      throw std::runtime_error(
+          "MappedCheckpoint::save - can't write file " + tmpPath.string());
+    }
+  }
+  fs::rename(tmpPath, path);
+}
+
+MappedCheckpoint::MappedCheckpoint(const fs::path& path)
+    : path_(path.string()) {
+  const int fd = ::open(path_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(
+        "MappedCheckpoint::MappedCheckpoint - could not open file " + path_ +
+        ": " + std::strerror(errno));
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error(
+        "MappedCheckpoint::MappedCheckpoint - could not stat file " + path_);
+  }
+  size_ = st.st_size;
+  if (size_ < kPrefixBytes) {
+    ::close(fd);
+    throw std::runtime_error(
+        "MappedCheckpoint::MappedCheckpoint - " + path_ +
+        " isn't a mapped checkpoint");
+  }
+  void* data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  // the mapping stays valid after closing its file
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error(
+        "MappedCheckpoint::MappedCheckpoint - could not map file " + path_ +
+        ": " + std::strerror(errno));
+  }
+  data_ = static_cast<const uint8_t*>(data);
+
+  try {
+    uint64_t headerBytes;
+    std::memcpy(&headerBytes, data_ + sizeof(kMagic), sizeof(headerBytes));
+    if (std::memcmp(data_, kMagic, sizeof(kMagic)) != 0 ||
+        headerBytes > size_ - kPrefixBytes) {
+      throw std::runtime_error(
+          "MappedCheckpoint::MappedCheckpoint - " + path_ +
+          " isn't a mapped checkpoint");
+    }
+    std::istringstream header(std::string(
+        reinterpret_cast<const char*>(data_ + kPrefixBytes), headerBytes));
+    uint32_t version;
+    {
+      cereal::BinaryInputArchive ar(header);
+      ar(version);
+      if (version > kVersion) {
+        throw std::runtime_error(
+            "MappedCheckpoint::MappedCheckpoint - " + path_ +
+            " has an unsupported version " + std::to_string(version));
+      }
+      ar(structure_, tensorInfos_);
+    }
+    for (const auto& info : tensorInfos_) {
+      if (info.bytes != info.shape.elements() * fl::getTypeSize(info.type) ||
+          info.offset > size_ || info.bytes > size_ - info.offset) {
+        throw std::runtime_error(
+            "MappedCheckpoint::MappedCheckpoint - " + path_ +
+            " has an invalid tensor table, or is truncated");
+      }
+    }
+  } catch (...) {
+    ::munmap(const_cast<uint8_t*>(data_), size_);
+    throw;
+  }
+}
+
+MappedCheckpoint::~MappedCheckpoint() {
+  if (data_) {
+    ::munmap(const_cast<uint8_t*>(data_), size_);
+  }
+}
+
+size_t MappedCheckpoint::numTensors() const {
+  return tensorInfos_.size();
+}
+
+const MappedCheckpoint::TensorInfo& MappedCheckpoint::tensorInfo(
+    size_t index) const {
+  if (index >= tensorInfos_.size()) {
+    throw std::out_of_range(
+        "MappedCheckpoint::tensorInfo - index out of range");
+  }
+  return tensorInfos_[index];
+}
+
+Tensor MappedCheckpoint::tensor(size_t index) const {
+  const auto& info = tensorInfo(index);
+  if (info.bytes == 0) {
+    return Tensor(info.shape, info.type);
+  }
+  return Tensor::fromBuffer(
+      info.shape, info.type, data_ + info.offset, Location::Host);
+}
+
+std::vector<Tensor> MappedCheckpoint::tensors(
+    unsigned numThreads /* = 0 */) const {
+  std::vector<Tensor> result(tensorInfos_.size());
+  if (result.empty()) {
+    return result;
+  }
+  if (numThreads == 0) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  numThreads = std::min<size_t>(numThreads, result.size());
+  // all the pages are read: have the kernel read ahead
+  const auto dataStart = tensorInfos_.front().offset / kDataAlignment *
+      kDataAlignment;
+  ::madvise(
+      const_cast<uint8_t*>(data_) + dataStart,
+      size_ - dataStart,
+      MADV_WILLNEED);
+
+  // the largest tensors first, for the threads to finish together
+  std::vector<size_t> order(result.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    return tensorInfos_[a].bytes > tensorInfos_[b].bytes;
+  });
+  std::atomic<size_t> next{0};
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  auto upload = [&]() {
+    try {
+      for (size_t i = next++; i < order.size(); i = next++) {
+        result[order[i]] = tensor(order[i]);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(errorMutex);
+      error = std::current_exception();
+      next = order.size();
+    }
+  };
+  const int deviceId = fl::getDevice();
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < numThreads; ++i) {
+    threads.emplace_back([&upload, deviceId]() {
+      fl::setDevice(deviceId);
+      upload();
+    });
+  }
+  upload();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return result;
+}
+
+bool MappedCheckpoint::isMappedCheckpoint(const fs::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  return file.read(magic, sizeof(magic)) &&
+      std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+} // namespace fl
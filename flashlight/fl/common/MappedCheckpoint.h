@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/common/Serialization.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+/**
+ * A checkpoint file whose tensors are stored raw, to be memory-mapped when
+ * loading rather than streamed through a cereal archive, e.g. to serve large
+ * models: loading doesn't copy the tensors to the host first, the pages of the
+ * file are shared by the processes which map it, and the tensors are uploaded
+ * in parallel, or one at a time on demand with `tensor`.
+ *
+ * The file holds a small header, a cereal binary archive of the structure of
+ * the objects, e.g. modules, and of the shape, type and offset of each
+ * tensor; then the data of the tensors, at aligned offsets of a page-aligned
+ * region.
+ *
+ * Example:
+ * \code
+   fl::MappedCheckpoint::save("model.flc", network);
+
+   // loading, possibly in several processes
+   fl::MappedCheckpoint checkpoint("model.flc");
+   checkpoint.load(network);
+ * \endcode
+ */
+class MappedCheckpoint {
+ public:
+  /** The alignment of the data of each tensor in the file, in bytes. */
+  static constexpr uint64_t kTensorAlignment = 64;
+
+  /** The shape, type and location in the file of the data of a tensor. */
+  struct TensorInfo {
+    Shape shape;
+    dtype type;
+    uint64_t offset; // from the start of the file
+    uint64_t bytes;
+
+    template <class Archive>
+    void serialize(Archive& ar) {
+      ar(shape, type, offset, bytes);
+    }
+  };
+
+  /**
+   * Saves objects to a file, replaced atomically. The tensors are copied to
+   * the host and written one at a time.
+   *
+   * @param[in] path the file to write
+   * @param[in] args the objects to save, as with `fl::save`
+   */
+  template <typename... Args>
+  static void save(const fs::path& path, const Args&... args) {
+    detail::ExternalTensors external;
+    std::ostringstream structure;
+    {
+      detail::ExternalTensorsScope scope(&external);
+      cereal::BinaryOutputArchive ar(structure);
+      ar(args...);
+    }
+    write(path, structure.str(), external.tensors);
+  }
+
+  /**
+   * Maps a file written by `save`. The mapping is shared: its pages are read
+   * from the page cache, and kept in it for other processes mapping the file.
+   *
+   * @param[in] path the file to map
+   */
+  explicit MappedCheckpoint(const fs::path& path);
+  ~MappedCheckpoint();
+
+  MappedCheckpoint(const MappedCheckpoint&) = delete;
+  MappedCheckpoint& operator=(const MappedCheckpoint&) = delete;
+
+  /**
+   * Loads the objects of the checkpoint, after uploading its tensors to the
+   * current device on one thread per hardware thread.
+   *
+   * @param[out] args the objects to load, in the order they were saved
+   */
+  template <typename... Args>
+  void load(Args&... args) const {
+    loadWith(0, args...);
+  }
+
+  /**
+   * Like `load`, with a given number of threads uploading the tensors, 0 for
+   * one per hardware thread.
+   */
+  template <typename... Args>
+  void loadWith(unsigned numThreads, Args&... args) const {
+    detail::ExternalTensors external;
+    external.tensors = tensors(numThreads);
+    std::istringstream structure(structure_);
+    detail::ExternalTensorsScope scope(&external);
+    cereal::BinaryInputArchive ar(structure);
+    ar(args...);
+  }
+
+  /** @return the number of tensors of the checkpoint, in the order saved. */
+  size_t numTensors() const;
+
+  const TensorInfo& tensorInfo(size_t index) const;
+
+  /**
+   * Uploads a tensor of the checkpoint to the current device from the
+   * mapping, reading only its pages, e.g. to load the weights of a model
+   * lazily.
+   */
+  Tensor tensor(size_t index) const;
+
+  /**
+   * Uploads all the tensors of the checkpoint to the current device.
+   *
+   * @param[in] numThreads the number of threads uploading the tensors, 0 for
+   * one per hardware thread
+   */
+  std::vector<Tensor> tensors(unsigned numThreads = 0) const;
+
+  /** @return whether a file is a checkpoint written by `save`. */
+  static bool isMappedCheckpoint(const fs::path& path);
+
+ private:
+  // Writes the structure, the table of the tensors and their data
+  static void write(
+      const fs::path& path,
+      const std::string& structure,
+      const std::vector<Tensor>& tensors);
+
+  std::string path_;
+  const uint8_t* data_{nullptr};
+  size_t size_{0};
+  std::string structure_;
+  std::vector<TensorInfo> tensorInfos_;
+};
+
+} // namespace fl
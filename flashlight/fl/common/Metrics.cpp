@@ -0,0 +1,506 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/common/Metrics.h"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace fl {
+
+namespace {
+
+// the time a client has to send its request
+constexpr int kHttpRequestTimeoutMs = 1000;
+constexpr size_t kMaxHttpRequestBytes = 8192;
+
+void atomicAdd(std::atomic<double>& target, double value) {
+  double current = target.load(std::memory_order_relaxed);
+  while (!target.compare_exchange_weak(
+      current, current + value, std::memory_order_relaxed)) {
+  }
+}
+
+bool isValidName(const std::string& name, bool allowColon) {
+  if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+    return false;
+  }
+  return std::all_of(name.begin(), name.end(), [allowColon](char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' ||
+        (allowColon && c == ':');
+  });
+}
+
+std::string escape(const std::string& value, bool quotes) {
+  std::string escaped;
+  for (const char c : value) {
+    if (c == '\\') {
+      escaped += "\\\\";
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else if (c == '"' && quotes) {
+      escaped += "\\\"";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// Serializes labels as {a="x",b="y"}, or "" if none
+std::string serializeLabels(const MetricLabels& labels) {
+  std::string serialized;
+  for (const auto& [name, value] : labels) {
+    serialized += (serialized.empty() ? "" : ",") + name + "=\"" +
+        escape(value, /* quotes = */ true) + "\"";
+  }
+  return serialized.empty() ? "" : "{" + serialized + "}";
+}
+
+// Adds a label to serialized labels
+std::string withLabel(
+    const std::string& labels,
+    const std::string& name,
+    const std::string& value) {
+  const auto label = name + "=\"" + value + "\"";
+  return labels.empty() ? "{" + label + "}"
+                        : labels.substr(0, labels.size() - 1) + "," + label +
+          "}";
+}
+
+std::string formatValue(double value) {
+  if (std::isinf(value)) {
+    return value > 0 ? "+Inf" : "-Inf";
+  }
+  if (std::isnan(value)) {
+    return "NaN";
+  }
+  // the shortest of the precisions which round-trip, for readability
+  std::ostringstream ss;
+  ss << std::setprecision(std::numeric_limits<double>::digits10) << value;
+  if (std::stod(ss.str()) != value) {
+    ss.str("");
+    ss << std::setprecision(std::numeric_limits<double>::max_digits10)
+       << value;
+  }
+  return ss.str();
+}
+
+std::runtime_error socketError(const std::string& what) {
+  return std::runtime_error(
+      "MetricsRegistry: " + what + " failed: " + std::strerror(errno));
+}
+
+void sendAll(int fd, const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    auto n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return; // the client went away
+    }
+    sent += n;
+  }
+}
+
+} // namespace
+
+void CounterMetric::inc(double value /* = 1 */) {
+  atomicAdd(value_, value);
+}
+
+double CounterMetric::value() const {
+  return value_.load(std::memory_order_relaxed);
+}
+
+void GaugeMetric::set(double value) {
+  value_.store(value, std::memory_order_relaxed);
+}
+
+void GaugeMetric::add(double value) {
+  atomicAdd(value_, value);
+}
+
+double GaugeMetric::value() const {
+  return value_.load(std::memory_order_relaxed);
+}
+
+HistogramMetric::HistogramMetric(std::vector<double> bounds)
+    : bounds_(std::move(bounds)),
+      counts_(new std::atomic<uint64_t>[bounds_.size() + 1]) {
+  if (!std::is_sorted(bounds_.begin(), bounds_.end()) ||
+      std::adjacent_find(bounds_.begin(), bounds_.end()) != bounds_.end()) {
+    throw std::invalid_argument(
+        "HistogramMetric - bounds must be strictly increasing");
+  }
+  for (size_t i = 0; i <= bounds_.size(); ++i) {
+    counts_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void HistogramMetric::observe(double value) {
+  // buckets are inclusive of their upper bound
+  const size_t bucket =
+      std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+  counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+  atomicAdd(sum_, value);
+}
+
+const std::vector<double>& HistogramMetric::bounds() const {
+  return bounds_;
+}
+
+std::vector<uint64_t> HistogramMetric::bucketCounts() const {
+  std::vector<uint64_t> counts(bounds_.size() + 1);
+  for (size_t i = 0; i < counts.size(); ++i) {
+    counts[i] = counts_[i].load(std::memory_order_relaxed);
+  }
+  return counts;
+}
+
+double HistogramMetric::sum() const {
+  return sum_.load(std::memory_order_relaxed);
+}
+
+std::vector<double>
+HistogramMetric::exponentialBounds(double start, double factor, size_t count) {
+  if (start <= 0 || factor <= 1) {
+    throw std::invalid_argument(
+        "HistogramMetric::exponentialBounds - start must be positive and "
+        "factor greater than 1");
+  }
+  std::vector<double> bounds(count);
+  for (size_t i = 0; i < count; ++i) {
+    bounds[i] = start;
+    start *= factor;
+  }
+  return bounds;
+}
+
+// Serves GET /metrics on a thread, one connection at a time.
+class MetricsRegistry::HttpServer {
+ public:
+  HttpServer(const MetricsRegistry& registry, int port) : registry_(registry) {
+    listenFd_ = ::socket(AF_INET6, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+      throw socketError("socket");
+    }
+    int one = 1;
+    int zero = 0;
+    ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    // accept IPv4 connections too
+    ::setsockopt(listenFd_, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+    sockaddr_in6 addr{};
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(port);
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) <
+            0 ||
+        ::listen(listenFd_, SOMAXCONN) < 0) {
+      auto error = socketError("bind on port " + std::to_string(port));
+      ::close(listenFd_);
+      throw error;
+    }
+    if (::pipe(wakeFds_) < 0) {
+      auto error = socketError("pipe");
+      ::close(listenFd_);
+      throw error;
+    }
+    thread_ = std::thread([this]() { run(); });
+  }
+
+  ~HttpServer() {
+    char stop = 0;
+    while (::write(wakeFds_[1], &stop, 1) < 0 && errno == EINTR) {
+    }
+    thread_.join();
+    ::close(listenFd_);
+    ::close(wakeFds_[0]);
+    ::close(wakeFds_[1]);
+  }
+
+ private:
+  void run() {
+    while (true) {
+      pollfd fds[] = {{wakeFds_[0], POLLIN, 0}, {listenFd_, POLLIN, 0}};
+      if (::poll(fds, 2, -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      if (fds[0].revents) {
+        return;
+      }
+      if (fds[1].revents & POLLIN) {
+        int fd = ::accept(listenFd_, nullptr, nullptr);
+        if (fd >= 0) {
+          handle(fd);
+          ::close(fd);
+        }
+      }
+    }
+  }
+
+  void handle(int fd) {
+    // reads the request line and headers, ignoring any body
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.size() < kMaxHttpRequestBytes) {
+      pollfd pfd{fd, POLLIN, 0};
+      if (::poll(&pfd, 1, kHttpRequestTimeoutMs) <= 0) {
+        return;
+      }
+      auto n = ::recv(fd, buffer, sizeof(buffer), 0);
+      if (n <= 0) {
+        return;
+      }
+      request.append(buffer, n);
+    }
+    std::istringstream line(request.substr(0, request.find("\r\n")));
+    std::string method, target;
+    line >> method >> target;
+    std::string status = "200 OK";
+    std::string body;
+    if (method != "GET") {
+      status = "405 Method Not Allowed";
+    } else if (target != "/metrics" && target.rfind("/metrics?", 0) != 0) {
+      status = "404 Not Found";
+    } else {
+      body = registry_.serialize();
+    }
+    std::ostringstream response;
+    response << "HTTP/1.1 " << status << "\r\n"
+             << "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << body;
+    sendAll(fd, response.str());
+  }
+
+  const MetricsRegistry& registry_;
+  int listenFd_{-1};
+  int wakeFds_[2];
+  std::thread thread_;
+};
+
+MetricsRegistry& MetricsRegistry::getInstance() {
+  static MetricsRegistry instance;
+  return instance;
+}
+
+MetricsRegistry::~MetricsRegistry() {
+  stopHttpServer();
+  stopFileDump();
+}
+
+MetricsRegistry::Family& MetricsRegistry::getFamily(
+    const std::string& name,
+    const std::string& help,
+    Type type) {
+  if (!isValidName(name, /* allowColon = */ true)) {
+    throw std::invalid_argument(
+        "MetricsRegistry - invalid metric name '" + name + "'");
+  }
+  auto it = families_.find(name);
+  if (it == families_.end()) {
+    it = families_.emplace(name, Family{type, help}).first;
+  } else if (it->second.type != type) {
+    throw std::invalid_argument(
+        "MetricsRegistry - metric '" + name +
+        "' is already registered with another type");
+  }
+  return it->second;
+}
+
+namespace {
+
+std::string labelsKey(const MetricLabels& labels) {
+  for (const auto& [name, value] : labels) {
+    // the reserved names of histogram buckets and of the exposition format
+    if (!isValidName(name, /* allowColon = */ false) || name == "le" ||
+        name.rfind("__", 0) == 0) {
+      throw std::invalid_argument(
+          "MetricsRegistry - invalid label name '" + name + "'");
+    }
+  }
+  return serializeLabels(labels);
+}
+
+} // namespace
+
+CounterMetric& MetricsRegistry::counter(
+    const std::string& name,
+    const std::string& help,
+    const MetricLabels& labels /* = {} */) {
+  const auto key = labelsKey(labels);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& metric = getFamily(name, help, Type::Counter).counters[key];
+  if (!metric) {
+    metric = std::make_unique<CounterMetric>();
+  }
+  return *metric;
+}
+
+GaugeMetric& MetricsRegistry::gauge(
+    const std::string& name,
+    const std::string& help,
+    const MetricLabels& labels /* = {} */) {
+  const auto key = labelsKey(labels);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& metric = getFamily(name, help, Type::Gauge).gauges[key];
+  if (!metric) {
+    metric = std::make_unique<GaugeMetric>();
+  }
+  return *metric;
+}
+
+HistogramMetric& MetricsRegistry::histogram(
+    const std::string& name,
+    const std::string& help,
+    const std::vector<double>& bounds,
+    const MetricLabels& labels /* = {} */) {
+  const auto key = labelsKey(labels);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& family = getFamily(name, help, Type::Histogram);
+  if (family.histograms.empty()) {
+    family.bounds = bounds;
+  }
+  auto& metric = family.histograms[key];
+  if (!metric) {
+    metric = std::make_unique<HistogramMetric>(family.bounds);
+  }
+  return *metric;
+}
+
+std::string MetricsRegistry::serialize() const {
+  std::ostringstream ss;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& [name, family] : families_) {
+    ss << "# HELP " << name << " " << escape(family.help, /* quotes = */ false)
+       << "\n# TYPE " << name << " ";
+    switch (family.type) {
+      case Type::Counter:
+        ss << "counter\n";
+        for (const auto& [labels, counter] : family.counters) {
+          ss << name << labels << " " << formatValue(counter->value()) << "\n";
+        }
+        break;
+      case Type::Gauge:
+        ss << "gauge\n";
+        for (const auto& [labels, gauge] : family.gauges) {
+          ss << name << labels << " " << formatValue(gauge->value()) << "\n";
+        }
+        break;
+      case Type::Histogram:
+        ss << "histogram\n";
+        for (const auto& [labels, histogram] : family.histograms) {
+          const auto counts = histogram->bucketCounts();
+          const auto& bounds = histogram->bounds();
+          uint64_t cumulative = 0;
+          for (size_t i = 0; i < counts.size(); ++i) {
+            cumulative += counts[i];
+            const auto le = i < bounds.size()
+                ? formatValue(bounds[i])
+                : std::string("+Inf");
+            ss << name << "_bucket" << withLabel(labels, "le", le) << " "
+               << cumulative << "\n";
+          }
+          ss << name << "_sum" << labels << " "
+             << formatValue(histogram->sum()) << "\n"
+             << name << "_count" << labels << " " << cumulative << "\n";
+        }
+        break;
+    }
+  }
+  return ss.str();
+}
+
+void MetricsRegistry::writeToFile(const fs::path& path) const {
+  // write to a file of a unique name in the same directory, then move it over
+  // the destination, which replaces it atomically
+  auto tmpPath = path;
+  tmpPath += ".tmp" + std::to_string(std::random_device()());
+  {
+    std::ofstream file(tmpPath);
+    file << serialize();
+    if (!file) {
+      throw std::runtime_error(
+          "MetricsRegistry::writeToFile - can't write file " +
+          tmpPath.string());
+    }
+  }
+  fs::rename(tmpPath, path);
+}
+
+void MetricsRegistry::startFileDump(
+    const fs::path& path,
+    double intervalSeconds) {
+  if (intervalSeconds <= 0) {
+    throw std::invalid_argument(
+        "MetricsRegistry::startFileDump - the interval must be positive");
+  }
+  stopFileDump();
+  std::lock_guard<std::mutex> lock(dumpMutex_);
+  stopDump_ = false;
+  dumpThread_ = std::thread([this, path, intervalSeconds]() {
+    const auto interval = std::chrono::duration<double>(intervalSeconds);
+    std::unique_lock<std::mutex> lock(dumpMutex_);
+    while (true) {
+      const bool stopping = dumpCondition_.wait_for(
+          lock, interval, [this]() { return stopDump_; });
+      try {
+        writeToFile(path);
+      } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+      }
+      if (stopping) {
+        return;
+      }
+    }
+  });
+}
+
+void MetricsRegistry::stopFileDump() {
+  {
+    std::lock_guard<std::mutex> lock(dumpMutex_);
+    stopDump_ = true;
+  }
+  dumpCondition_.notify_all();
+  if (dumpThread_.joinable()) {
+    dumpThread_.join();
+  }
+}
+
+void MetricsRegistry::startHttpServer(int port) {
+  stopHttpServer();
+  httpServer_ = std::make_unique<HttpServer>(*this, port);
+}
+
+void MetricsRegistry::stopHttpServer() {
+  httpServer_.reset();
+}
+
+} // namespace fl
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flashlight/fl/common/Filesystem.h"
+
+namespace fl {
+
+/**
+ * The labels of a metric, e.g. {{"device", "0"}}, which distinguish the
+ * metrics of a name.
+ */
+using MetricLabels = std::map<std::string, std::string>;
+
+/**
+ * A monotonically increasing value, e.g. a number of samples or of seconds.
+ * Recording is lock-free.
+ */
+class CounterMetric {
+ public:
+  /** Increases the counter by a non-negative value. */
+  void inc(double value = 1);
+  double value() const;
+
+ private:
+  std::atomic<double> value_{0};
+};
+
+/**
+ * A value which can go up and down, e.g. the bytes held by an allocator or
+ * the loss of the last update. Recording is lock-free.
+ */
+class GaugeMetric {
+ public:
+  void set(double value);
+  void add(double value);
+  double value() const;
+
+ private:
+  std::atomic<double> value_{0};
+};
+
+/**
+ * Counts observed values, e.g. latencies, in buckets of given upper bounds,
+ * with their sum. Recording is lock-free.
+ */
+class HistogramMetric {
+ public:
+  /**
+   * @param[in] bounds the increasing upper bounds of the buckets; values above
+   * the last one are counted in an implicit +Inf bucket.
+   */
+  explicit HistogramMetric(std::vector<double> bounds);
+
+  void observe(double value);
+
+  const std::vector<double>& bounds() const;
+
+  /**
+   * @return the number of values of each bucket, the last of which is the
+   * +Inf bucket; not cumulative.
+   */
+  std::vector<uint64_t> bucketCounts() const;
+
+  double sum() const;
+
+  /**
+   * @return `count` buckets of geometrically increasing bounds, from `start`.
+   */
+  static std::vector<double>
+  exponentialBounds(double start, double factor, size_t count);
+
+ private:
+  const std::vector<double> bounds_;
+  std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+  std::atomic<double> sum_{0};
+};
+
+/**
+ * A process-wide registry of metrics, e.g. of meters, the caching memory
+ * manager, the `DatasetProfiler` and the gradient reducers, exported in the
+ * Prometheus text format: over HTTP for scraping, or to a file rewritten
+ * periodically, e.g. for the textfile collector of the node exporter.
+ *
+ * Metrics are registered once and live as long as the process, so that
+ * callers keep a reference to them and record without looking them up:
+ * registering locks the registry, recording doesn't.
+ *
+ * Example:
+ * \code
+   auto& registry = fl::MetricsRegistry::getInstance();
+   auto& samples = registry.counter(
+       "train_samples_total", "Number of samples trained on");
+   registry.startHttpServer(9100); // serves GET /metrics
+   for (auto& batch : *trainset) {
+     // train
+     samples.inc(batchSize);
+   }
+ * \endcode
+ */
+class MetricsRegistry {
+ public:
+  static MetricsRegistry& getInstance();
+
+  ~MetricsRegistry();
+
+  /**
+   * Registers a counter, or gets the one already registered with the same
+   * name and labels. Names and label names must be valid Prometheus names,
+   * and a name belongs to metrics of a single type.
+   *
+   * @param[in] name the name of the metric, e.g. "fl_dataset_waits_total".
+   * @param[in] help the description of the metric, kept from the first
+   * registration of the name.
+   * @param[in] labels the labels of the metric.
+   */
+  CounterMetric& counter(
+      const std::string& name,
+      const std::string& help,
+      const MetricLabels& labels = {});
+
+  /** Registers a gauge, see `counter`. */
+  GaugeMetric& gauge(
+      const std::string& name,
+      const std::string& help,
+      const MetricLabels& labels = {});
+
+  /**
+   * Registers a histogram, see `counter`. The metrics of a name have the
+   * bounds of its first registration.
+   */
+  HistogramMetric& histogram(
+      const std::string& name,
+      const std::string& help,
+      const std::vector<double>& bounds,
+      const MetricLabels& labels = {});
+
+  /**
+   * @return the metrics in the Prometheus text exposition format, version
+   * 0.0.4.
+   */
+  std::string serialize() const;
+
+  /**
+   * Writes the serialized metrics to a file, which is replaced atomically.
+   */
+  void writeToFile(const fs::path& path) const;
+
+  /**
+   * Starts writing the metrics to a file every `intervalSeconds` on a thread,
+   * replacing the previous dump, if any, and until `stopFileDump`.
+   */
+  void startFileDump(const fs::path& path, double intervalSeconds);
+
+  /** Stops the periodic dump, after writing the file a last time. */
+  void stopFileDump();
+
+  /**
+   * Serves the metrics over HTTP on given port, at /metrics, on a thread,
+   * until `stopHttpServer`. Throws if the port can't be bound.
+   */
+  void startHttpServer(int port);
+
+  void stopHttpServer();
+
+ private:
+  enum class Type { Counter, Gauge, Histogram };
+
+  struct Family {
+    Type type;
+    std::string help;
+    std::vector<double> bounds; // of histograms
+    // the metrics by serialized labels
+    std::map<std::string, std::unique_ptr<CounterMetric>> counters;
+    std::map<std::string, std::unique_ptr<GaugeMetric>> gauges;
+    std::map<std::string, std::unique_ptr<HistogramMetric>> histograms;
+  };
+
+  class HttpServer;
+
+  MetricsRegistry() = default;
+
+  Family&
+  getFamily(const std::string& name, const std::string& help, Type type);
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Family> families_;
+
+  std::mutex dumpMutex_;
+  std::condition_variable dumpCondition_;
+  bool stopDump_{false};
+  std::thread dumpThread_;
+  std::unique_ptr<HttpServer> httpServer_;
+};
+
+} // namespace fl
@@ -21,6 +21,17 @@ Plugin::Plugin(const std::string& name) : name_(name) {
     std::string err = dlerror();
     throw std::runtime_error("unable to load library <" + name + ">: " + err);
   }
+  using AbiFunction = const char* (*)();
+  auto abi = reinterpret_cast<AbiFunction>(dlsym(handle_, "flPluginAbi"));
+  if (abi && std::string(abi()) != FL_PLUGIN_ABI) {
+    const std::string pluginAbi = abi();
+    dlclose(handle_);
+    handle_ = nullptr;
+    throw std::runtime_error(
+        "library <" + name + "> was built with ABI <" + pluginAbi +
+        ">, incompatible with the ABI of flashlight <" FL_PLUGIN_ABI
+        ">: rebuild it with the compile definitions of flashlight");
+  }
 }
 
 void* Plugin::getRawSymbol(const std::string& symbol) {
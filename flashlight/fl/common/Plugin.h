@@ -10,8 +10,51 @@
 
 #include <string>
 
+#define FL_PLUGIN_STRINGIFY_(x) #x
+#define FL_PLUGIN_STRINGIFY(x) FL_PLUGIN_STRINGIFY_(x)
+
+#if defined(_LIBCPP_VERSION)
+#define FL_PLUGIN_STDLIB_ABI "libc++-" FL_PLUGIN_STRINGIFY(_LIBCPP_ABI_VERSION)
+#elif defined(__GLIBCXX__)
+#define FL_PLUGIN_STDLIB_ABI \
+  "libstdc++-cxx11abi" FL_PLUGIN_STRINGIFY(_GLIBCXX_USE_CXX11_ABI)
+#else
+#define FL_PLUGIN_STDLIB_ABI "unknown"
+#endif
+
+/**
+ * The ABI of the code including this header: its C++ standard library ABI
+ * and the flashlight configuration it is built with, whose compile
+ * definitions change the layout of flashlight's types.
+ */
+#define FL_PLUGIN_ABI                                 \
+  FL_PLUGIN_STDLIB_ABI                                \
+  " arrayfire=" FL_PLUGIN_STRINGIFY(FL_USE_ARRAYFIRE) \
+  " onednn=" FL_PLUGIN_STRINGIFY(FL_USE_ONEDNN)       \
+  " stub=" FL_PLUGIN_STRINGIFY(FL_USE_TENSOR_STUB)    \
+  " cuda=" FL_PLUGIN_STRINGIFY(FL_BACKEND_CUDA)       \
+  " cpu=" FL_PLUGIN_STRINGIFY(FL_BACKEND_CPU)
+
+/**
+ * Records the ABI a plugin is built with, for `Plugin` to refuse loading it
+ * into an incompatible flashlight rather than fail later. Used once, at
+ * namespace scope, in a source of the plugin.
+ */
+#define FL_PLUGIN_DEFINE_ABI()           \
+  extern "C" const char* flPluginAbi() { \
+    return FL_PLUGIN_ABI;                \
+  }
+
 namespace fl {
 
+/**
+ * A shared library loaded at runtime, e.g. a model architecture.
+ *
+ * Plugins defining their ABI with `FL_PLUGIN_DEFINE_ABI` are checked when
+ * loading: those built with another C++ standard library ABI, or against
+ * another flashlight configuration, throw instead of loading. Plugins which
+ * don't define it are loaded as is.
+ */
 class Plugin {
  public:
   explicit Plugin(const std::string& name);
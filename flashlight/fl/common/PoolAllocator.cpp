@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/common/PoolAllocator.h"
+
+#include <algorithm>
+#include <array>
+#include <new>
+
+namespace fl {
+namespace detail {
+
+namespace {
+
+constexpr size_t kNumSizes = BlockPool::kMaxBlockSize / BlockPool::kGranularity;
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct LocalLists {
+  std::array<FreeBlock*, kNumSizes> heads{};
+  std::array<size_t, kNumSizes> counts{};
+
+  ~LocalLists();
+};
+
+// Set once the lists of the thread are destroyed, after which blocks freed by
+// the thread, e.g. by the destructors of other thread-locals, are deleted
+thread_local bool tListsDestroyed = false;
+
+LocalLists::~LocalLists() {
+  tListsDestroyed = true;
+  for (auto* head : heads) {
+    while (head) {
+      auto* next = head->next;
+      ::operator delete(head);
+      head = next;
+    }
+  }
+}
+
+LocalLists* localLists() {
+  if (tListsDestroyed) {
+    return nullptr;
+  }
+  thread_local LocalLists lists;
+  return &lists;
+}
+
+size_t sizeIndex(const size_t bytes) {
+  return (std::max<size_t>(bytes, 1) - 1) / BlockPool::kGranularity;
+}
+
+} // namespace
+
+void* BlockPool::allocate(const size_t bytes) {
+  if (bytes > kMaxBlockSize) {
+    return ::operator new(bytes);
+  }
+  const auto index = sizeIndex(bytes);
+  auto* lists = localLists();
+  if (lists && lists->heads[index]) {
+    auto* block = lists->heads[index];
+    lists->heads[index] = block->next;
+    --lists->counts[index];
+    return block;
+  }
+  return ::operator new((index + 1) * kGranularity);
+}
+
+void BlockPool::deallocate(void* ptr, const size_t bytes) noexcept {
+  if (!ptr) {
+    return;
+  }
+  auto* lists = bytes > kMaxBlockSize ? nullptr : localLists();
+  const auto index = sizeIndex(bytes);
+  if (!lists || lists->counts[index] >= kMaxCachedBlocks) {
+    ::operator delete(ptr);
+    return;
+  }
+  auto* block = static_cast<FreeBlock*>(ptr);
+  block->next = lists->heads[index];
+  lists->heads[index] = block;
+  ++lists->counts[index];
+}
+
+size_t BlockPool::cachedBlocks(const size_t bytes) {
+  auto* lists = bytes > kMaxBlockSize ? nullptr : localLists();
+  return lists ? lists->counts[sizeIndex(bytes)] : 0;
+}
+
+} // namespace detail
+} // namespace fl
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace fl {
+namespace detail {
+
+/**
+ * Per-thread free lists of small memory blocks, by size rounded up to
+ * `kGranularity` bytes, for objects which are created and destroyed at a
+ * high rate, e.g. the nodes of autograd graphs, which are all freed after
+ * each backward pass and created again by the next forward pass.
+ *
+ * Freed blocks are kept on the list of the freeing thread, up to
+ * `kMaxCachedBlocks` per size, and reused by its next allocations of that
+ * size. Blocks are individually allocated with `operator new`, so they may be
+ * freed by any thread, also after the thread which allocated them exited.
+ * Blocks larger than `kMaxBlockSize` bypass the lists.
+ */
+class BlockPool {
+ public:
+  static constexpr size_t kGranularity = 16;
+  static constexpr size_t kMaxBlockSize = 512;
+  static constexpr size_t kMaxCachedBlocks = 4096;
+
+  /**
+   * @return a block of at least `bytes` bytes, aligned as by `operator new`
+   */
+  static void* allocate(size_t bytes);
+
+  /**
+   * Frees a block from `allocate`, given the same number of bytes.
+   */
+  static void deallocate(void* ptr, size_t bytes) noexcept;
+
+  /**
+   * @return the number of free blocks of the given size kept by the calling
+   * thread
+   */
+  static size_t cachedBlocks(size_t bytes);
+};
+
+} // namespace detail
+
+/**
+ * A standard allocator from `detail::BlockPool`, e.g. to allocate an object
+ * and its control block in one pooled block with `std::allocate_shared`.
+ */
+template <typename T>
+class PoolAllocator {
+  // over-aligned types can't use the blocks of operator new
+  static constexpr bool kUsePool = alignof(T) <= alignof(std::max_align_t);
+
+ public:
+  using value_type = T;
+
+  PoolAllocator() noexcept = default;
+
+  template <typename U>
+  /* implicit */ PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+  T* allocate(const size_t n) {
+    if (!kUsePool) {
+      return std::allocator<T>().allocate(n);
+    }
+    return static_cast<T*>(detail::BlockPool::allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, const size_t n) noexcept {
+    if (!kUsePool) {
+      std::allocator<T>().deallocate(ptr, n);
+      return;
+    }
+    detail::BlockPool::deallocate(ptr, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U>&) const noexcept {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const PoolAllocator<U>&) const noexcept {
+    return false;
+  }
+};
+
+} // namespace fl
@@ -11,10 +11,13 @@
  */
 
 #include <fstream>
+#include <future>
 #include <stdexcept>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
+#include "flashlight/fl/tensor/Compute.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
 #pragma once
@@ -139,6 +142,55 @@ void save(std::ostream& ostr, const Args&... args) {
   ar(args...);
 }
 
+namespace detail {
+
+/**
+ * Takes the snapshot of an arg of `saveAsync`: a copy by default, which for a
+ * `Tensor` is a reference copied on write. Specialized for types which share
+ * their state when copied, e.g. `Variable`.
+ */
+template <typename T>
+struct AsyncSaveSnapshot {
+  static T take(const T& value) {
+    return value;
+  }
+};
+
+template <typename T>
+struct AsyncSaveSnapshot<std::vector<T>> {
+  static std::vector<T> take(const std::vector<T>& values) {
+    std::vector<T> snapshot;
+    snapshot.reserve(values.size());
+    for (const auto& value : values) {
+      snapshot.push_back(AsyncSaveSnapshot<T>::take(value));
+    }
+    return snapshot;
+  }
+};
+
+} // namespace detail
+
+template <typename... Args>
+std::future<void> saveAsync(const std::string& filepath, const Args&... args) {
+  // tensors are read from the background thread on the current device
+  const int device = fl::getDevice();
+  return std::async(
+      std::launch::async,
+      [filepath,
+       device,
+       snapshot = std::make_tuple(
+           detail::AsyncSaveSnapshot<Args>::take(args)...)]() {
+        fl::setDevice(device);
+        std::ofstream ofs(filepath, std::ios::binary);
+        if (!ofs.is_open()) {
+          throw std::runtime_error(
+              "saveAsync - failed to open file for writing: " + filepath);
+        }
+        std::apply(
+            [&ofs](const auto&... values) { save(ofs, values...); }, snapshot);
+      });
+}
+
 template <typename... Args>
 void load(const std::string& filepath, Args&... args) {
   std::ifstream ifs(filepath, std::ios::binary);
@@ -206,6 +258,11 @@ void save(
     throw cereal::Exception(
         "Serialzation of sparse Tensor is not supported yet!");
   }
+  if (auto* external = fl::detail::ExternalTensors::current()) {
+    external->tensors.push_back(tensor);
+    ar(static_cast<uint64_t>(external->tensors.size() - 1));
+    return;
+  }
   std::vector<uint8_t> vec(tensor.bytes());
   tensor.host(vec.data());
   ar(tensor.shape(), tensor.type(), vec);
@@ -213,6 +270,15 @@ void save(
 
 template <class Archive>
 void load(Archive& ar, fl::Tensor& tensor, const uint32_t /* version */) {
+  if (auto* external = fl::detail::ExternalTensors::current()) {
+    uint64_t index;
+    ar(index);
+    if (index >= external->tensors.size()) {
+      throw cereal::Exception("External tensor index out of range");
+    }
+    tensor = external->tensors[index];
+    return;
+  }
   fl::Shape dims;
   fl::dtype ty;
   std::vector<uint8_t> vec;
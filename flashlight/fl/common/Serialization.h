@@ -12,8 +12,11 @@
 #pragma once
 
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 #include "flashlight/fl/tensor/TensorBase.h"
 
@@ -64,6 +67,25 @@ void save(const std::string& filepath, const Args&... args);
 template <typename... Args>
 void save(std::ostream& ostr, const Args&... args);
 
+/**
+ * Save (serialize) the specified args to a binary file (via Cereal) in the
+ * background, e.g. to dump activations or emissions without blocking
+ * computation.
+ *
+ * The args are snapshotted when called, so they can be modified right after:
+ * tensors by reference, which is copy-on-write with ArrayFire, such that they
+ * are copied to the host in the background, and other values by copy. Objects
+ * referenced by pointers, e.g. `shared_ptr` to Module, aren't snapshotted and
+ * must not be modified until the save is done.
+ *
+ * @param filepath the file path to save to
+ * @param args the objects to save (e.g. Tensor, or a vector of them)
+ * @return a future ready once the file is written, which rethrows the error
+ * of the save, if any
+ */
+template <typename... Args>
+std::future<void> saveAsync(const std::string& filepath, const Args&... args);
+
 /**
  * Load (deserialize) the specified args from a binary file (via Cereal).
  * @param filepath the file path to load from
@@ -145,6 +167,39 @@ struct SerializeAs;
 template <typename T>
 struct CerealSave;
 
+/**
+ * While set for a thread, e.g. with `ExternalTensorsScope`, the tensors it
+ * serializes with cereal are kept in, or read from, the list rather than the
+ * archive, which only holds their index in the list, such that their data can
+ * be stored elsewhere. Archives written this way can only be read this way.
+ */
+struct ExternalTensors {
+  std::vector<Tensor> tensors;
+
+  /** @return the list of the tensors of this thread, if any */
+  static ExternalTensors*& current() {
+    thread_local ExternalTensors* externalTensors = nullptr;
+    return externalTensors;
+  }
+};
+
+/** Sets the external tensors of this thread for the lifetime of the scope. */
+class ExternalTensorsScope {
+ public:
+  explicit ExternalTensorsScope(ExternalTensors* externalTensors)
+      : previous_(ExternalTensors::current()) {
+    ExternalTensors::current() = externalTensors;
+  }
+  ~ExternalTensorsScope() {
+    ExternalTensors::current() = previous_;
+  }
+  ExternalTensorsScope(const ExternalTensorsScope&) = delete;
+  ExternalTensorsScope& operator=(const ExternalTensorsScope&) = delete;
+
+ private:
+  ExternalTensors* previous_;
+};
+
 } // namespace detail
 
 /**
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fl {
+
+/**
+ * A vector which stores up to `N` elements inline, without a heap allocation,
+ * and falls back to a `std::vector` beyond them, e.g. for the dimensions of
+ * shapes, which are small and copied on every tensor op.
+ *
+ * It has the interface of `std::vector` that its uses need, and converts to a
+ * `std::vector`, such that code written against vectors keeps working. Only
+ * trivially copyable elements are supported; as with `std::vector`, mutations
+ * which change the size may invalidate iterators.
+ */
+template <typename T, size_t N>
+class SmallVector {
+  static_assert(
+      std::is_trivially_copyable<T>::value,
+      "SmallVector - elements must be trivially copyable");
+  static_assert(N > 0, "SmallVector - the inline capacity must be positive");
+
+  size_t size_{0};
+  T inline_[N]{};
+  // holds all elements when there are more than N, else is empty
+  std::vector<T> heap_;
+
+  bool isInline() const {
+    return size_ <= N;
+  }
+
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  /// The number of elements stored without a heap allocation
+  static constexpr size_t kInlineCapacity = N;
+
+  SmallVector() = default;
+
+  explicit SmallVector(size_t count, const T& value = T()) {
+    resize(count, value);
+  }
+
+  template <
+      typename InputIt,
+      typename = typename std::iterator_traits<InputIt>::iterator_category>
+  SmallVector(InputIt first, InputIt last) {
+    assign(first, last);
+  }
+
+  /* implicit */ SmallVector(std::initializer_list<T> init)
+      : SmallVector(init.begin(), init.end()) {}
+
+  explicit SmallVector(const std::vector<T>& vec)
+      : SmallVector(vec.begin(), vec.end()) {}
+
+  /**
+   * @return a copy of the elements in a `std::vector`
+   */
+  /* implicit */ operator std::vector<T>() const {
+    return std::vector<T>(begin(), end());
+  }
+
+  template <typename InputIt>
+  void assign(InputIt first, InputIt last) {
+    clear();
+    for (; first != last; ++first) {
+      push_back(*first);
+    }
+  }
+
+  /**************************** Accessors *****************************/
+  T* data() {
+    return isInline() ? inline_ : heap_.data();
+  }
+
+  const T* data() const {
+    return isInline() ? inline_ : heap_.data();
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  T& operator[](const size_t i) {
+    return data()[i];
+  }
+
+  const T& operator[](const size_t i) const {
+    return data()[i];
+  }
+
+  T& at(const size_t i) {
+    if (i >= size_) {
+      throw std::out_of_range("SmallVector::at - index out of range");
+    }
+    return data()[i];
+  }
+
+  const T& at(const size_t i) const {
+    return const_cast<SmallVector*>(this)->at(i);
+  }
+
+  T& front() {
+    return data()[0];
+  }
+
+  const T& front() const {
+    return data()[0];
+  }
+
+  T& back() {
+    return data()[size_ - 1];
+  }
+
+  const T& back() const {
+    return data()[size_ - 1];
+  }
+
+  /**************************** Iterators *****************************/
+  iterator begin() {
+    return data();
+  }
+
+  const_iterator begin() const {
+    return data();
+  }
+
+  const_iterator cbegin() const {
+    return data();
+  }
+
+  iterator end() {
+    return data() + size_;
+  }
+
+  const_iterator end() const {
+    return data() + size_;
+  }
+
+  const_iterator cend() const {
+    return data() + size_;
+  }
+
+  reverse_iterator rbegin() {
+    return reverse_iterator(end());
+  }
+
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+
+  reverse_iterator rend() {
+    return reverse_iterator(begin());
+  }
+
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  /**************************** Modifiers *****************************/
+  void resize(const size_t count, const T& value = T()) {
+    const T fill = value; // may be an element
+    if (count > N) {
+      if (isInline()) {
+        heap_.assign(inline_, inline_ + size_);
+      }
+      heap_.resize(count, fill);
+    } else if (!isInline()) {
+      std::copy_n(heap_.begin(), count, inline_);
+      heap_.clear();
+    } else if (count > size_) {
+      std::fill(inline_ + size_, inline_ + count, fill);
+    }
+    size_ = count;
+  }
+
+  void reserve(const size_t capacity) {
+    if (capacity > N) {
+      heap_.reserve(capacity);
+    }
+  }
+
+  void clear() {
+    resize(0);
+  }
+
+  void push_back(const T& value) {
+    resize(size_ + 1, value);
+  }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    push_back(T(std::forward<Args>(args)...));
+    return back();
+  }
+
+  void pop_back() {
+    resize(size_ - 1);
+  }
+
+  iterator insert(const_iterator pos, const size_t count, const T& value) {
+    const T fill = value; // may be an element
+    const auto offset = pos - begin();
+    resize(size_ + count);
+    std::copy_backward(begin() + offset, end() - count, end());
+    std::fill_n(begin() + offset, count, fill);
+    return begin() + offset;
+  }
+
+  iterator insert(const_iterator pos, const T& value) {
+    return insert(pos, 1, value);
+  }
+
+  template <
+      typename InputIt,
+      typename = typename std::iterator_traits<InputIt>::iterator_category>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    // copy first, as the range may be of this vector
+    const SmallVector items(first, last);
+    const auto offset = pos - begin();
+    resize(size_ + items.size());
+    std::copy_backward(begin() + offset, end() - items.size(), end());
+    std::copy(items.begin(), items.end(), begin() + offset);
+    return begin() + offset;
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    const auto offset = first - begin();
+    const auto count = last - first;
+    std::copy(begin() + offset + count, end(), begin() + offset);
+    resize(size_ - count);
+    return begin() + offset;
+  }
+
+  iterator erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+  }
+
+  /*************************** Comparisons ****************************/
+  bool operator==(const SmallVector& other) const {
+    return std::equal(begin(), end(), other.begin(), other.end());
+  }
+
+  bool operator!=(const SmallVector& other) const {
+    return !(*this == other);
+  }
+
+  bool operator==(const std::vector<T>& other) const {
+    return std::equal(begin(), end(), other.begin(), other.end());
+  }
+
+  bool operator!=(const std::vector<T>& other) const {
+    return !(*this == other);
+  }
+};
+
+} // namespace fl
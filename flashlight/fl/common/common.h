@@ -7,9 +7,11 @@
 
 #pragma once
 
+#include "flashlight/fl/common/BenchmarkCache.h"
 #include "flashlight/fl/common/Defines.h"
 #include "flashlight/fl/common/DynamicBenchmark.h"
 #include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/common/MappedCheckpoint.h"
 #include "flashlight/fl/common/Serialization.h"
 #include "flashlight/fl/common/Timer.h"
 #include "flashlight/fl/common/Types.h"
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/common/threadpool/ThreadPool.h"
+
+#include <algorithm>
+
+namespace fl {
+
+namespace {
+
+// the pool the calling thread is a worker of, if any, and its index
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentIndex = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(
+    size_t threads,
+    const std::function<void(size_t)>& initFn /* = nullptr */) {
+  // without workers, tasks run on the threads waiting for them
+  const size_t numQueues = std::max<size_t>(threads, 1);
+  for (size_t i = 0; i < numQueues; ++i) {
+    queues_.push_back(std::make_unique<WorkerQueue>());
+  }
+  for (size_t id = 0; id < threads; ++id) {
+    workers_.emplace_back([this, initFn, id] {
+      currentPool = this;
+      currentIndex = id;
+      if (initFn) {
+        initFn(id);
+      }
+      for (;;) {
+        Task task;
+        if (tryPop(task, id)) {
+          run(task);
+          continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this] { return stop_ || pending_ > 0; });
+        if (stop_ && pending_ == 0) {
+          return;
+        }
+      }
+    });
+  }
+}
+
+void ThreadPool::push(Task task, TaskPriority priority) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // don't allow enqueueing after stopping the pool
+    if (stop_) {
+      throw std::runtime_error("enqueue on stopped ThreadPool");
+    }
+    ++pending_;
+    ++unfinished_;
+  }
+  // tasks of tasks stay on their worker, the others are spread round-robin
+  const size_t worker = currentWorker();
+  const size_t idx = worker < queues_.size()
+      ? worker
+      : nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+  {
+    auto& queue = *queues_[idx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks[static_cast<size_t>(priority)].push_back(std::move(task));
+  }
+  condition_.notify_one();
+}
+
+bool ThreadPool::tryPop(Task& task, size_t self) {
+  const size_t numQueues = queues_.size();
+  const size_t first = self < numQueues ? self : 0;
+  for (size_t p = kNumPriorities; p-- > 0;) {
+    for (size_t k = 0; k < numQueues; ++k) {
+      auto& queue = *queues_[(first + k) % numQueues];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      auto& tasks = queue.tasks[p];
+      if (tasks.empty()) {
+        continue;
+      }
+      // run own tasks in order, steal the most recently enqueued ones
+      if (k == 0) {
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      } else {
+        task = std::move(tasks.back());
+        tasks.pop_back();
+      }
+      --pending_;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::runPendingTask() {
+  Task task;
+  if (!tryPop(task, currentWorker())) {
+    return false;
+  }
+  run(task);
+  return true;
+}
+
+void ThreadPool::run(Task& task) {
+  task(); // exceptions are stored in the future
+  if (--unfinished_ == 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_.notify_all();
+  }
+}
+
+size_t ThreadPool::currentWorker() const {
+  return currentPool == this ? currentIndex : queues_.size();
+}
+
+void ThreadPool::wait() {
+  if (currentWorker() < queues_.size()) {
+    throw std::logic_error(
+        "ThreadPool::wait - can't wait for all tasks from a task of the pool");
+  }
+  while (unfinished_ > 0) {
+    if (runPendingTask()) {
+      continue;
+    }
+    // the remaining tasks are running on workers
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait_for(lock, std::chrono::microseconds(100), [this] {
+      return unfinished_ == 0;
+    });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  condition_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+  // without workers, the queued tasks are left
+  Task task;
+  while (tryPop(task, queues_.size())) {
+    run(task);
+  }
+}
+
+} // namespace fl
@@ -5,27 +5,45 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+// The interface originates from https://github.com/progschj/ThreadPool
 // Copyright (c) 2012 Jakob Progsch, Vaclav Zeman
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <stdexcept>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace fl {
 
 /**
-* A simple C++11 Thread Pool implementation.
-* Source - https://github.com/progschj/ThreadPool
-*
-* Basic usage:
+ * The priority of a task of a `ThreadPool`: workers run queued tasks of
+ * higher priority first, e.g. the sample a consumer waits for before the ones
+ * prefetched speculatively.
+ */
+enum class TaskPriority { Low = 0, Normal = 1, High = 2 };
+
+/**
+ * A work-stealing thread pool. Each worker has its own task queues, one per
+ * `TaskPriority`: tasks enqueued by a task go to the queue of its worker, the
+ * others are spread over the workers, and idle workers steal the tasks of
+ * others, such that enqueuing threads don't contend on a single queue.
+ *
+ * Waiting for a task with `wait` runs queued tasks on the waiting thread in
+ * the meantime, so tasks may wait for tasks they enqueue without deadlocking
+ * the pool, even if all workers do.
+ *
+ * Basic usage:
   \code
     // create thread pool with 4 worker threads
     ThreadPool pool(4);
@@ -35,8 +53,12 @@ namespace fl {
 
     // get result from future
     std::cout << result.get() << std::endl;
+
+    // a task which is needed first
+    auto urgent = pool.enqueueWithPriority(TaskPriority::High, [] { ... });
+    pool.wait(urgent); // runs tasks while waiting
   \endcode
-*/
+ */
 class ThreadPool {
  public:
   /**
@@ -50,84 +72,107 @@ class ThreadPool {
       const std::function<void(size_t)>& initFn = nullptr);
 
   /**
-   * add new work item to the pool
+   * add new work item to the pool, of `TaskPriority::Normal`
    * \param [in] f function to be executed in threadpool
    * \param [in] args varadic arguments for the function
    */
   template <class F, class... Args>
   auto enqueue(F&& f, Args&&... args)
       -> std::future<typename std::result_of_t<F(Args...)>>;
-  ///  destructor joins all threads.
+
+  /**
+   * add new work item to the pool, run before queued items of lower priority
+   * \param [in] priority the priority of the item
+   * \param [in] f function to be executed in threadpool
+   * \param [in] args varadic arguments for the function
+   */
+  template <class F, class... Args>
+  auto enqueueWithPriority(TaskPriority priority, F&& f, Args&&... args)
+      -> std::future<typename std::result_of_t<F(Args...)>>;
+
+  /**
+   * Waits until a future of a task of the pool is ready, running queued tasks
+   * on the calling thread in the meantime. May be called from tasks.
+   * \param [in] future the future, e.g. returned by `enqueue`
+   */
+  template <class Future>
+  void wait(const Future& future);
+
+  /**
+   * Waits until all tasks enqueued so far have completed, running queued
+   * tasks on the calling thread in the meantime. Throws if called from a task
+   * of the pool, which would wait for itself.
+   */
+  void wait();
+
+  ///  destructor runs the queued tasks and joins all threads.
   ~ThreadPool();
 
  private:
+  using Task = std::function<void()>;
+  static constexpr size_t kNumPriorities = 3;
+
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::array<std::deque<Task>, kNumPriorities> tasks;
+  };
+
+  void push(Task task, TaskPriority priority);
+  // pops the queued task of highest priority, from the queue of `self` first
+  // and stolen from the other queues otherwise
+  bool tryPop(Task& task, size_t self);
+  // runs a queued task on the calling thread, if any
+  bool runPendingTask();
+  void run(Task& task);
+  // the worker the calling thread is, or `queues_.size()` if none
+  size_t currentWorker() const;
+
   // need to keep track of threads so we can join them
-  std::vector<std::thread> workers;
-  // the task queue
-  std::queue<std::function<void()>> tasks;
-
-  // synchronization
-  std::mutex queue_mutex;
-  std::condition_variable condition;
-  bool stop;
-}; // namespace flclassThreadPool
-
-inline ThreadPool::ThreadPool(
-    size_t threads,
-    const std::function<void(size_t)>& initFn /* = nullptr */)
-    : stop(false) {
-  for (size_t id = 0; id < threads; ++id)
-    workers.emplace_back([this, initFn, id] {
-      if (initFn) {
-        initFn(id);
-      }
-      for (;;) {
-        std::function<void()> task;
-
-        {
-          std::unique_lock<std::mutex> lock(this->queue_mutex);
-          this->condition.wait(
-              lock, [this] { return this->stop || !this->tasks.empty(); });
-          if (this->stop && this->tasks.empty())
-            return;
-          task = std::move(this->tasks.front());
-          this->tasks.pop();
-        }
-
-        task();
-      }
-    });
-}
+  std::vector<std::thread> workers_;
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::atomic<size_t> nextQueue_{0};
+  // tasks queued but not started, and tasks not finished
+  std::atomic<size_t> pending_{0};
+  std::atomic<size_t> unfinished_{0};
+
+  // synchronization of idle workers and waiters
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::condition_variable finished_;
+  bool stop_{false};
+};
 
 template <class F, class... Args>
 auto ThreadPool::enqueue(F&& f, Args&&... args)
     -> std::future<typename std::result_of_t<F(Args...)>> {
+  return enqueueWithPriority(
+      TaskPriority::Normal, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template <class F, class... Args>
+auto ThreadPool::enqueueWithPriority(
+    TaskPriority priority,
+    F&& f,
+    Args&&... args) -> std::future<typename std::result_of_t<F(Args...)>> {
   using return_type = typename std::result_of_t<F(Args...)>;
 
   auto task = std::make_shared<std::packaged_task<return_type()>>(
       std::bind(std::forward<F>(f), std::forward<Args>(args)...));
 
   std::future<return_type> res = task->get_future();
-  {
-    std::unique_lock<std::mutex> lock(queue_mutex);
-
-    // don't allow enqueueing after stopping the pool
-    if (stop)
-      throw std::runtime_error("enqueue on stopped ThreadPool");
-
-    tasks.emplace([task]() { (*task)(); });
-  }
-  condition.notify_one();
+  push([task]() { (*task)(); }, priority);
   return res;
 }
 
-inline ThreadPool::~ThreadPool() {
-  {
-    std::unique_lock<std::mutex> lock(queue_mutex);
-    stop = true;
+template <class Future>
+void ThreadPool::wait(const Future& future) {
+  while (future.wait_for(std::chrono::seconds(0)) !=
+         std::future_status::ready) {
+    if (!runPendingTask()) {
+      // the task is running on another thread
+      future.wait_for(std::chrono::microseconds(100));
+    }
   }
-  condition.notify_all();
-  for (std::thread& worker : workers)
-    worker.join();
 }
+
 } // namespace fl
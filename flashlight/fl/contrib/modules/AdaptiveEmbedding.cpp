@@ -19,15 +19,21 @@ namespace fl {
 AdaptiveEmbedding::AdaptiveEmbedding(
     int embeddingDim,
     std::vector<int> cutoff,
-    float divValue /*= 4 */)
-    : embeddingDim_(embeddingDim), cutoff_(cutoff), divValue_(divValue) {
+    float divValue /*= 4 */,
+    bool sparseGrad /* = false */)
+    : embeddingDim_(embeddingDim),
+      cutoff_(cutoff),
+      divValue_(divValue),
+      sparseGrad_(sparseGrad) {
   if (cutoff_.empty()) {
     throw std::invalid_argument("Invalid cutoff for AdaptiveEmbedding");
   }
   double stdv = std::sqrt(1.0 / (double)embeddingDim_);
   // to be in agreement with the adaptive softmax to simplify
   // tied version of adaptive input and softmax
-  auto headEmbedding = fl::normal(cutoff_[0], embeddingDim_, stdv, 0);
+  auto headEmbedding = sparseGrad_
+      ? fl::normal(embeddingDim_, cutoff_[0], stdv, 0)
+      : fl::normal(cutoff_[0], embeddingDim_, stdv, 0);
   params_.push_back(headEmbedding);
   auto head = fl::glorotUniform(
       {embeddingDim_, embeddingDim_}, embeddingDim_, embeddingDim_);
@@ -40,8 +46,10 @@ AdaptiveEmbedding::AdaptiveEmbedding(
     double stdvTail = std::sqrt(1.0 / (double)tailEmbeddingDim);
     // to be in agreement with the adaptive softmax to simplify
     // tied version of adaptive input and softmax
-    auto tailEmbedding = fl::normal(
-        cutoff_[tailIdx] - cutoff_[tailIdx - 1], tailEmbeddingDim, stdvTail, 0);
+    const int tailSize = cutoff_[tailIdx] - cutoff_[tailIdx - 1];
+    auto tailEmbedding = sparseGrad_
+        ? fl::normal(tailEmbeddingDim, tailSize, stdvTail, 0)
+        : fl::normal(tailSize, tailEmbeddingDim, stdvTail, 0);
     params_.push_back(tailEmbedding);
     auto tail = fl::glorotUniform(
         {embeddingDim_, tailEmbeddingDim}, tailEmbeddingDim, embeddingDim_);
@@ -49,6 +57,13 @@ AdaptiveEmbedding::AdaptiveEmbedding(
   }
 }
 
+Variable AdaptiveEmbedding::lookup(const Variable& input, int tableIdx) const {
+  if (sparseGrad_) {
+    return embedding(input, params_[tableIdx], /* sparseGrad = */ true);
+  }
+  return embedding(input, reorder(params_[tableIdx], {1, 0}));
+}
+
 Variable AdaptiveEmbedding::forward(const Variable& input) {
   if (input.ndim() != 2) {
     throw std::invalid_argument(
@@ -62,8 +77,7 @@ Variable AdaptiveEmbedding::forward(const Variable& input) {
 
   Tensor headMask = flatInput.tensor() < cutoff_[0];
   if (fl::sum(headMask).scalar<unsigned>() > 0) {
-    auto headEmbedding =
-        embedding(flatInput(headMask), reorder(params_[0], {1, 0}));
+    auto headEmbedding = lookup(flatInput(headMask), 0);
     headEmbedding = matmul(params_[1], headEmbedding);
     indices.push_back(Variable(fl::nonzero(headMask), false));
     embeddings.push_back(headEmbedding);
@@ -73,9 +87,8 @@ Variable AdaptiveEmbedding::forward(const Variable& input) {
     Tensor tailMask = flatInput.tensor() < cutoff_[tailIdx] &&
         flatInput.tensor() >= cutoff_[tailIdx - 1];
     if (fl::any(tailMask).asScalar<bool>()) {
-      auto tailEmbedding = embedding(
-          flatInput(tailMask) - cutoff_[tailIdx - 1],
-          reorder(params_[tailIdx * 2], {1, 0}));
+      auto tailEmbedding =
+          lookup(flatInput(tailMask) - cutoff_[tailIdx - 1], tailIdx * 2);
       tailEmbedding = matmul(params_[tailIdx * 2 + 1], tailEmbedding);
       indices.push_back(Variable(fl::nonzero(tailMask), false));
       embeddings.push_back(tailEmbedding);
@@ -101,6 +114,9 @@ std::string AdaptiveEmbedding::prettyString() const {
   }
   ss << cutoff_[cutoff_.size() - 1] << "), "
      << "(divValue: " << divValue_ << ")";
+  if (sparseGrad_) {
+    ss << " (sparse gradients)";
+  }
   return ss.str();
 }
 
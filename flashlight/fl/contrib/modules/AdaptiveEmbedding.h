@@ -25,8 +25,17 @@ class AdaptiveEmbedding : public UnaryModule {
   int embeddingDim_;
   std::vector<int> cutoff_;
   float divValue_;
+  bool sparseGrad_{false};
 
-  FL_SAVE_LOAD_WITH_BASE(UnaryModule, embeddingDim_, cutoff_, divValue_)
+  FL_SAVE_LOAD_WITH_BASE(
+      UnaryModule,
+      embeddingDim_,
+      cutoff_,
+      divValue_,
+      fl::versioned(sparseGrad_, 1))
+
+  // Looks up the embeddings of the table of the parameter at `tableIdx`
+  Variable lookup(const Variable& input, int tableIdx) const;
 
  public:
   /**
@@ -44,11 +53,16 @@ class AdaptiveEmbedding : public UnaryModule {
    * assigned to an 'overflow' bucket.
    * @param[in] divValue is the scaling factor for tail groups dimention
    * reduction (see paper https://arxiv.org/pdf/1809.10853.pdf for details).
+   * @param[in] sparseGrad whether the gradients of the embedding tables are
+   * row-sparse, see `Embedding`. The tables are then stored as [embedding dim,
+   * bucket size] rather than [bucket size, embedding dim], so they can't be
+   * tied with those of an `AdaptiveSoftMax`.
    */
   explicit AdaptiveEmbedding(
       int embeddingDim,
       std::vector<int> cutoff,
-      float divValue = 4);
+      float divValue = 4,
+      bool sparseGrad = false);
 
   Variable forward(const Variable& input) override;
 
@@ -58,3 +72,4 @@ class AdaptiveEmbedding : public UnaryModule {
 } // namespace fl
 
 CEREAL_REGISTER_TYPE(fl::AdaptiveEmbedding)
+CEREAL_CLASS_VERSION(fl::AdaptiveEmbedding, 1)
@@ -5,6 +5,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <cmath>
+#include <sstream>
 #include <stdexcept>
 
 #include "flashlight/fl/contrib/modules/AsymmetricConv1D.h"
@@ -13,6 +15,25 @@
 
 namespace fl {
 
+namespace {
+
+// The padding cut from one side of the input for the given part of the future
+int asymmetryPadding(int px, float futurePart) {
+  return std::abs(2 * (0.5 - futurePart)) * px;
+}
+
+// Removes the outputs of the padding cut from the input
+Variable cutAsymmetry(const Variable& output, int cutPx, float futurePart) {
+  if (futurePart < 0.5) {
+    return output(fl::range(0, output.dim(0) - 2 * cutPx));
+  } else if (futurePart > 0.5) {
+    return output(fl::range(2 * cutPx, output.dim(0)));
+  }
+  return output;
+}
+
+} // namespace
+
 void AsymmetricConv1D::checkParams() {
   if (xPad_ != static_cast<int>(PaddingMode::SAME) && xPad_ != 0) {
     throw std::invalid_argument(
@@ -69,7 +90,7 @@ Variable AsymmetricConv1D::forward(const Variable& input) {
     throw std::invalid_argument("invalid padding for AsymmetricConv1D");
   }
   Variable output;
-  int cutPx = std::abs(2 * (0.5 - futurePart_)) * px;
+  int cutPx = asymmetryPadding(px, futurePart_);
   int asymmetryPx = px + cutPx;
   if (bias_) {
     output = conv2d(
@@ -95,12 +116,7 @@ Variable AsymmetricConv1D::forward(const Variable& input) {
         yDilation_,
         groups_);
   }
-  if (futurePart_ < 0.5) {
-    output = output(fl::range(0, output.dim(0) - 2 * cutPx));
-  } else if (futurePart_ > 0.5) {
-    output = output(fl::range(2 * cutPx, output.dim(0)));
-  }
-  return output;
+  return cutAsymmetry(output, cutPx, futurePart_);
 }
 
 std::string AsymmetricConv1D::prettyString() const {
@@ -110,4 +126,33 @@ std::string AsymmetricConv1D::prettyString() const {
   return ss.str();
 }
 
+float AsymmetricConv1D::getFuturePart() const {
+  return futurePart_;
+}
+
+QuantizedAsymmetricConv1D::QuantizedAsymmetricConv1D(
+    const AsymmetricConv1D& conv,
+    float inputScale /* = 0 */)
+    : QuantizedConv2D(conv, inputScale),
+      futurePart_(conv.getFuturePart()) {}
+
+Variable QuantizedAsymmetricConv1D::forward(const Variable& input) {
+  observe(input.tensor(), "QuantizedAsymmetricConv1D::forward");
+  auto px =
+      fl::derivePadding(input.dim(0), xFilter_, xStride_, xPad_, xDilation_);
+  if (!(px >= 0)) {
+    throw std::invalid_argument(
+        "invalid padding for QuantizedAsymmetricConv1D");
+  }
+  int cutPx = asymmetryPadding(px, futurePart_);
+  return cutAsymmetry(convolve(input, px + cutPx, 0), cutPx, futurePart_);
+}
+
+std::string QuantizedAsymmetricConv1D::prettyString() const {
+  std::ostringstream ss;
+  ss << "QuantizedAsymmetricConv1D";
+  ss << " (" << QuantizedConv2D::prettyString() << ")";
+  return ss.str();
+}
+
 } // namespace fl
@@ -54,6 +54,8 @@ class AsymmetricConv1D : public fl::Conv2D {
 
   std::string prettyString() const override;
 
+  float getFuturePart() const;
+
  private:
   FL_SAVE_LOAD_WITH_BASE(fl::Conv2D, futurePart_)
   float futurePart_;
@@ -62,6 +64,36 @@ class AsymmetricConv1D : public fl::Conv2D {
   AsymmetricConv1D() = default;
 };
 
+/**
+ * An int8 version of `AsymmetricConv1D` for inference on the OneDNN autograd
+ * backend, e.g. for the convolutions of a ConvLM. See `fl::QuantizedConv2D`.
+ */
+class QuantizedAsymmetricConv1D : public fl::QuantizedConv2D {
+ public:
+  /**
+   * Constructs a QuantizedAsymmetricConv1D module from an `AsymmetricConv1D`
+   * one.
+   *
+   * @param conv the module to quantize
+   * @param inputScale the scale of the inputs, if known. Otherwise, the
+   *  module must be calibrated before use, see `fl::calibrateQuantization`
+   */
+  explicit QuantizedAsymmetricConv1D(
+      const AsymmetricConv1D& conv,
+      float inputScale = 0);
+
+  fl::Variable forward(const fl::Variable& input) override;
+
+  std::string prettyString() const override;
+
+ private:
+  FL_SAVE_LOAD_WITH_BASE(fl::QuantizedConv2D, futurePart_)
+  float futurePart_;
+
+  QuantizedAsymmetricConv1D() = default;
+};
+
 } // namespace fl
 
 CEREAL_REGISTER_TYPE(fl::AsymmetricConv1D)
+CEREAL_REGISTER_TYPE(fl::QuantizedAsymmetricConv1D)
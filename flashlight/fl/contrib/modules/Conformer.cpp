@@ -7,16 +7,76 @@
 
 #include "flashlight/fl/contrib/modules/Conformer.h"
 
+#include <algorithm>
 #include <cmath>
+#include <stdexcept>
 
 #include "flashlight/fl/autograd/Functions.h"
 #include "flashlight/fl/nn/Init.h"
 #include "flashlight/fl/nn/Utils.h"
+#include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Random.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
 namespace fl {
 
+namespace {
+
+// the tensors of a streaming state, each with its batch along the last of 3
+// dimensions
+template <typename State, typename Fn>
+void forEachStateTensor(State& state, Fn fn) {
+  fn(state.attentionInput);
+  fn(state.keys);
+  fn(state.values);
+  fn(state.convResidual);
+  fn(state.convInput);
+}
+
+} // namespace
+
+ConformerState ConformerState::select(int64_t batchIdx) const {
+  ConformerState state = *this;
+  const auto batch = fl::range(batchIdx, batchIdx + 1);
+  forEachStateTensor(state, [&batch](Tensor& t) {
+    if (!t.isEmpty()) {
+      t = t(fl::span, fl::span, batch);
+    }
+  });
+  return state;
+}
+
+ConformerState ConformerState::concatenate(
+    const std::vector<ConformerState>& states) {
+  if (states.empty()) {
+    throw std::invalid_argument(
+        "ConformerState::concatenate - no states to concatenate");
+  }
+  const auto& first = states.front();
+  for (const auto& s : states) {
+    if (s.length != first.length || s.attended != first.attended ||
+        s.emitted != first.emitted || s.keysStart != first.keysStart) {
+      throw std::invalid_argument(
+          "ConformerState::concatenate - "
+          "states must be at the same position of their streams");
+    }
+  }
+  ConformerState state = first;
+  std::vector<std::vector<Tensor>> tensors(5);
+  for (const auto& s : states) {
+    int i = 0;
+    forEachStateTensor(s, [&](const Tensor& t) { tensors[i++].push_back(t); });
+  }
+  int i = 0;
+  forEachStateTensor(state, [&](Tensor& t) {
+    if (!t.isEmpty()) {
+      t = fl::concatenate(tensors[i], 2);
+    }
+    ++i;
+  });
+  return state;
+}
+
 Conformer::Conformer(
     int32_t modelDim,
     int32_t headDim,
@@ -121,19 +181,55 @@ Variable Conformer::conformerInitLinear(int32_t inDim, int32_t outDim) {
   return fl::uniform(outDim, inDim, -std, std);
 }
 
-Variable Conformer::mhsa(const Variable& input, const Variable& inputPadMask) {
+Variable Conformer::feedForward(
+    const Variable& input,
+    const std::shared_ptr<Linear>& w1,
+    const std::shared_ptr<Linear>& w2,
+    const std::shared_ptr<LayerNorm>& norm) {
   float pDropout = train_ ? pDropout_ : 0.0;
-  int bsz = input.dim(2);
+  return dropout(
+      (*w2)(dropout(
+          fl::swish((*w1)(((*norm)(input)).astype(input.type())), 1.),
+          pDropout)),
+      pDropout);
+}
+
+Variable Conformer::getContextMask(
+    int64_t queryStart,
+    int64_t nQueries,
+    int64_t keyStart,
+    int64_t nKeys) const {
+  if (leftContext_ < 0 && rightContext_ < 0) {
+    return Variable();
+  }
+  // the distance of each key from each query, queries along the first axis
+  auto distance = (fl::arange({nQueries, nKeys}, 1) + keyStart) -
+      (fl::arange({nQueries, nKeys}, 0) + queryStart);
+  Tensor inContext;
+  if (leftContext_ >= 0) {
+    inContext = distance >= -leftContext_;
+  }
+  if (rightContext_ >= 0) {
+    auto inRightContext = distance <= rightContext_;
+    inContext =
+        inContext.isEmpty() ? inRightContext : inContext && inRightContext;
+  }
+  return Variable(fl::log(inContext.astype(fl::dtype::f32)), false);
+}
 
+Variable Conformer::mhsa(const Variable& input, const Variable& inputPadMask) {
+  float pDropout = train_ ? pDropout_ : 0.0;
   auto normedInput = (*normMhsa_)(input);
   auto q = transpose((*wq_)(normedInput), {1, 0, 2});
   auto k = transpose((*wk_)(normedInput), {1, 0, 2});
   auto v = transpose((*wv_)(normedInput), {1, 0, 2});
 
-  Variable mask, posEmb;
+  Variable posEmb;
   if (posEmbContextSize_ > 0) {
-    posEmb = tile(params_[0].astype(input.type()), {1, 1, nHeads_ * bsz});
+    // broadcast over heads and batch by matmul
+    posEmb = params_[0].astype(input.type());
   }
+  auto mask = getContextMask(0, input.dim(1), 0, input.dim(1));
 
   fl::Variable padMask;
   // TODO{fl::Tensor}{resize} - emulate the ArrayFire resize operation for
@@ -157,26 +253,34 @@ Variable Conformer::mhsa(const Variable& input, const Variable& inputPadMask) {
   return result;
 }
 
-Variable Conformer::conv(const Variable& _input) {
+Variable Conformer::convInput(const Variable& _input) {
   // Make sure the input has 4 dims for depthwise conv
   Shape s = _input.shape();
   Variable input = moddims(_input, {s[0], s[1], s[2], 1});
-
-  float pDropout = train_ ? pDropout_ : 0.0;
   // input C x T x B x 1
   // apply first pointwise conv
   auto result =
       gatedlinearunit((*conv1_)(((*normConv1_)(input)).astype(input.type())), 0);
-  result = reorder(result, {1, 3, 0, 2});
+  return moddims(result, {result.dim(0), s[1], s[2]});
+}
+
+Variable Conformer::convOutput(const Variable& gated, fl::dtype type) {
+  Shape s = gated.shape();
+  float pDropout = train_ ? pDropout_ : 0.0;
+  auto result = reorder(moddims(gated, {s[0], s[1], s[2], 1}), {1, 3, 0, 2});
   // T x 1 x C x B
   // apply depthwise separable convolutions
   result = (*convDepthWise_)(result);
   result = reorder(result, {2, 0, 3, 1});
   // C x T x B x 1
-  result = fl::swish(((*normConv2_)(result)).astype(input.type()), 1.);
+  result = fl::swish(((*normConv2_)(result)).astype(type), 1.);
   // apply second pointwise conv
   result = dropout((*conv2_)(result), pDropout);
-  return moddims(result, _input.shape());
+  return moddims(result, {result.dim(0), s[1], s[2]});
+}
+
+Variable Conformer::conv(const Variable& input) {
+  return moddims(convOutput(convInput(input), input.type()), input.shape());
 }
 
 std::vector<Variable> Conformer::forward(const std::vector<Variable>& input) {
@@ -194,31 +298,159 @@ std::vector<Variable> Conformer::forward(const std::vector<Variable>& input) {
         "expects an input of size C x T x B - see documentation.");
   }
 
-  float pDropout = train_ ? pDropout_ : 0.0;
   float f = 1.0;
   if (train_ && (fl::rand({1}).scalar<float>() < pLayerDropout_)) {
     f = 0.0;
   }
   // apply first feed-forward module
-  auto ffn1 = dropout(
-      (*w12_)(dropout(
-          fl::swish((*w11_)(((*norm1_)(x)).astype(x.type())), 1.), pDropout)),
-      pDropout);
-  x = x + f * 0.5 * ffn1;
+  x = x + f * 0.5 * feedForward(x, w11_, w12_, norm1_);
   // apply multihead attention module
   x = x + f * mhsa(x, input[1]);
   // apply conv module
   x = x + f * conv(x);
   // apply second feed-forward module
-  auto ffn2 = dropout(
-      (*w22_)(dropout(
-          fl::swish((*w21_)(((*norm2_)(x)).astype(x.type())), 1.), pDropout)),
-      pDropout);
-  x = x + f * 0.5 * ffn2;
+  x = x + f * 0.5 * feedForward(x, w21_, w22_, norm2_);
   x = ((*norm3_)(x)).astype(x.type());
   return {x};
 }
 
+void Conformer::setAttentionContext(int32_t left, int32_t right) {
+  leftContext_ = left;
+  rightContext_ = right;
+}
+
+std::pair<Variable, ConformerState> Conformer::forwardStreaming(
+    const Variable& input,
+    ConformerState state,
+    bool last) {
+  if (input.ndim() != 3) {
+    throw std::invalid_argument(
+        "Conformer::forwardStreaming - input should be of 3 dimensions "
+        "expects an input of size C x T x B - see documentation.");
+  }
+  if (rightContext_ < 0) {
+    throw std::invalid_argument(
+        "Conformer::forwardStreaming - the right context must be limited");
+  }
+  if (convKernelSize_ % 2 == 0) {
+    throw std::invalid_argument(
+        "Conformer::forwardStreaming - the kernel size must be odd");
+  }
+  if (posEmbContextSize_ > 0 &&
+      (leftContext_ < 0 || leftContext_ >= posEmbContextSize_ ||
+       rightContext_ >= posEmbContextSize_)) {
+    throw std::invalid_argument(
+        "Conformer::forwardStreaming - the attention context must be less "
+        "than the positional embedding context size");
+  }
+  // frames are along the given axis
+  auto append = [](const Tensor& frames, const Tensor& newFrames, int axis) {
+    return frames.isEmpty() ? newFrames
+                            : fl::concatenate(axis, frames, newFrames);
+  };
+  auto dropFrames = [](const Tensor& frames, int64_t n, int axis) {
+    if (n == 0) {
+      return frames;
+    } else if (n == frames.dim(axis)) {
+      return Tensor();
+    }
+    std::vector<fl::Index> indices(axis + 1, fl::span);
+    indices[axis] = fl::range(n, frames.dim(axis));
+    return frames(indices);
+  };
+  const auto type = input.type();
+  float pDropout = train_ ? pDropout_ : 0.0;
+
+  // apply first feed-forward module, and compute the keys and values of the
+  // new frames
+  auto x = input + 0.5 * feedForward(input, w11_, w12_, norm1_);
+  auto normed = (*normMhsa_)(x);
+  state.keys =
+      append(state.keys, transpose((*wk_)(normed), {1, 0, 2}).tensor(), 0);
+  state.values =
+      append(state.values, transpose((*wv_)(normed), {1, 0, 2}).tensor(), 0);
+  state.attentionInput = append(state.attentionInput, x.tensor(), 1);
+  state.length += input.dim(1);
+
+  // apply multihead attention module to the frames whose right context is
+  // available
+  const int64_t nQueries = last
+      ? state.length - state.attended
+      : std::max<int64_t>(0, state.length - rightContext_ - state.attended);
+  if (nQueries > 0) {
+    auto queryInput =
+        Variable(state.attentionInput(fl::span, fl::range(0, nQueries)), false);
+    auto q = transpose((*wq_)((*normMhsa_)(queryInput)), {1, 0, 2});
+    Variable posEmb;
+    if (posEmbContextSize_ > 0) {
+      posEmb = params_[0].astype(type);
+    }
+    auto mask = getContextMask(
+        state.attended, nQueries, state.keysStart, state.keys.dim(0));
+    auto attention = multiheadAttention(
+        q,
+        Variable(state.keys, false),
+        Variable(state.values, false),
+        posEmb,
+        mask,
+        Variable(),
+        nHeads_,
+        pDropout,
+        state.attended - state.keysStart);
+    auto h = queryInput +
+        dropout((*wf_)(transpose(attention, {1, 0, 2})), pDropout);
+
+    state.attentionInput = dropFrames(state.attentionInput, nQueries, 1);
+    state.attended += nQueries;
+    if (leftContext_ >= 0) {
+      // drop the keys which the next frames don't attend to
+      const int64_t keysStart =
+          std::max(state.keysStart, state.attended - leftContext_);
+      state.keys = dropFrames(state.keys, keysStart - state.keysStart, 0);
+      state.values = dropFrames(state.values, keysStart - state.keysStart, 0);
+      state.keysStart = keysStart;
+    }
+
+    auto gated = convInput(h).tensor();
+    if (state.emitted == 0 && state.convInput.isEmpty()) {
+      // the depthwise convolution is padded with zeros at the start
+      const int64_t padding = (convKernelSize_ - 1) / 2;
+      state.convInput =
+          fl::full({gated.dim(0), padding, gated.dim(2)}, 0, gated.type());
+    }
+    state.convResidual = append(state.convResidual, h.tensor(), 1);
+    state.convInput = append(state.convInput, gated, 1);
+  }
+
+  // apply conv module to the frames whose right context is available, which
+  // is padded with zeros at the end
+  const int64_t padding = (convKernelSize_ - 1) / 2;
+  if (last && padding > 0 && !state.convInput.isEmpty()) {
+    const auto& gated = state.convInput;
+    state.convInput = fl::concatenate(
+        1,
+        gated,
+        fl::full({gated.dim(0), padding, gated.dim(2)}, 0, gated.type()));
+  }
+  const int64_t nFrames =
+      state.convInput.isEmpty() ? 0 : state.convInput.dim(1) - 2 * padding;
+  if (nFrames <= 0) {
+    return {Variable(), std::move(state)};
+  }
+  auto conv = convOutput(Variable(state.convInput, false), type);
+  const auto frames = fl::range(0, nFrames);
+  auto out = Variable(state.convResidual(fl::span, frames), false) +
+      conv(fl::span, fl::range(padding, padding + nFrames));
+  state.convResidual = dropFrames(state.convResidual, nFrames, 1);
+  state.convInput = dropFrames(state.convInput, nFrames, 1);
+  state.emitted += nFrames;
+
+  // apply second feed-forward module
+  out = out + 0.5 * feedForward(out, w21_, w22_, norm2_);
+  out = ((*norm3_)(out)).astype(out.type());
+  return {out, std::move(state)};
+}
+
 std::string Conformer::prettyString() const {
   std::ostringstream ss;
   ss << "Conformer "
@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "flashlight/fl/nn/modules/Container.h"
 #include "flashlight/fl/nn/modules/Conv2D.h"
 #include "flashlight/fl/nn/modules/LayerNorm.h"
@@ -15,6 +18,43 @@
 
 namespace fl {
 
+/**
+ * The state of a `Conformer` between the chunks of a stream, see
+ * `Conformer::forwardStreaming`. Default-constructed at the start of a
+ * stream.
+ */
+struct ConformerState {
+  // the number of frames of the stream so far, whose attention outputs were
+  // computed, and which were output
+  int64_t length{0};
+  int64_t attended{0};
+  int64_t emitted{0};
+  // the inputs of the attention module whose outputs wait for their right
+  // context, of size C x T x B
+  Tensor attentionInput;
+  // the keys and values which can still be attended to, from frame
+  // `keysStart` on, of size T x (nHeads * headDim) x B
+  Tensor keys;
+  Tensor values;
+  int64_t keysStart{0};
+  // the outputs of the attention module whose convolution waits for its right
+  // context, and the gated inputs of the depthwise convolution, including its
+  // left context, of size C x T x B
+  Tensor convResidual;
+  Tensor convInput;
+
+  /**
+   * @return the state of a single batch element, with batch size 1.
+   */
+  ConformerState select(int64_t batchIdx) const;
+
+  /**
+   * Batches the states of streams at the same position, e.g. of the sessions
+   * of a streaming service, along the batch dimension.
+   */
+  static ConformerState concatenate(const std::vector<ConformerState>& states);
+};
+
 /**
  * A module which implements a Conformer block (we use LayerNorm everywhere).
  *
@@ -46,6 +86,36 @@ class Conformer : public Container {
       float pLayerDropout = 0.);
 
   std::vector<Variable> forward(const std::vector<Variable>& input) override;
+
+  /**
+   * Limits the frames each frame attends to, e.g. for streaming, to those at
+   * most `left` frames before and `right` frames after it. -1 doesn't limit
+   * the context on that side, which is the default.
+   */
+  void setAttentionContext(int32_t left, int32_t right);
+
+  /**
+   * Forwards the next chunk of a stream with the keys and values of the
+   * previous frames and the left context of the convolution cached in the
+   * state, such that the outputs of the chunks of a stream equal those of
+   * `forward` over the whole stream without a pad mask, in eval mode.
+   *
+   * The output of a frame is delayed until the right context of the
+   * attention and the convolution is available, so a chunk may yield fewer
+   * frames than it has. Requires a limited right context, see
+   * `setAttentionContext`, an odd convolution kernel size and, with a relative
+   * positional embedding, both contexts to be less than its context size.
+   *
+   * @param input the next frames of the stream, of size C x T x B
+   * @param state the state after the previous chunk
+   * @param last whether the chunk ends the stream, which yields the pending
+   * frames
+   * @return the output frames which are ready, if any, and the state for the
+   * next chunk
+   */
+  std::pair<Variable, ConformerState>
+  forwardStreaming(const Variable& input, ConformerState state, bool last);
+
   std::string prettyString() const override;
 
  private:
@@ -54,6 +124,8 @@ class Conformer : public Container {
   int32_t convKernelSize_;
   double pDropout_;
   float pLayerDropout_;
+  int32_t leftContext_{-1};
+  int32_t rightContext_{-1};
 
   std::shared_ptr<Linear> w11_, w12_, w21_, w22_, wq_, wk_, wv_, wf_, conv1_,
       conv2_;
@@ -62,7 +134,23 @@ class Conformer : public Container {
   std::shared_ptr<Conv2D> convDepthWise_;
 
   static Variable conformerInitLinear(int32_t inDim, int32_t outDim);
+  Variable feedForward(
+      const Variable& input,
+      const std::shared_ptr<Linear>& w1,
+      const std::shared_ptr<Linear>& w2,
+      const std::shared_ptr<LayerNorm>& norm);
   Variable mhsa(const Variable& input, const Variable& inputPadMask);
+  // The log mask of the attention context of queries and keys from the given
+  // frames on, empty if the context isn't limited
+  Variable getContextMask(
+      int64_t queryStart,
+      int64_t nQueries,
+      int64_t keyStart,
+      int64_t nKeys) const;
+  // The gated inputs of the depthwise convolution
+  Variable convInput(const Variable& input);
+  // The output of the conv module given its gated inputs, of size C x T x B
+  Variable convOutput(const Variable& gated, fl::dtype type);
   Variable conv(const Variable& input);
 
   Conformer() = default;
@@ -90,9 +178,12 @@ class Conformer : public Container {
       pDropout_,
       pLayerDropout_,
       posEmbContextSize_,
-      convKernelSize_)
+      convKernelSize_,
+      fl::versioned(leftContext_, 1),
+      fl::versioned(rightContext_, 1))
 };
 
 } // namespace fl
 
 CEREAL_REGISTER_TYPE(fl::Conformer);
+CEREAL_CLASS_VERSION(fl::Conformer, 1)
@@ -6,8 +6,10 @@
  */
 
 #include <math.h>
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 
 #include "flashlight/fl/common/Logging.h"
 #include "flashlight/fl/contrib/modules/RawWavSpecAugment.h"
@@ -61,7 +63,7 @@ RawWavSpecAugment::RawWavSpecAugment(
 }
 
 void RawWavSpecAugment::precomputeFilters() {
-  if (!lowPassFilters_.empty()) {
+  if (!filterWidths_.empty()) {
     return;
   }
   auto mel2hz = [](float mel) {
@@ -87,13 +89,16 @@ void RawWavSpecAugment::precomputeFilters() {
   transBandKhz[0] = transBandKhz[1];
   ignoredLowPassFilters_ = 0;
   // compute filters for each frequency point, nMel + 1 low pass filters
+  std::vector<Tensor> kernels;
+  int maxWidth = 0;
   for (int fidx = 0; fidx < cutoff_.size(); fidx++) {
     int width = 2. / (1e-6 + transBandKhz[fidx]);
     if (width * 2 + 1 > maxKernelSize_) {
       FL_LOG(fl::LogLevel::INFO)
           << "RawWavSpecAugment raw wave: frequency " << cutoff_[fidx]
           << " will be skipped for eval, too large kernel";
-      lowPassFilters_.push_back(nullptr);
+      kernels.emplace_back();
+      filterWidths_.push_back(-1);
       ignoredLowPassFilters_++;
       continue;
     }
@@ -108,20 +113,27 @@ void RawWavSpecAugment::precomputeFilters() {
     kernel = kernel * blackmanWindow;
     // normalize kernel
     kernel = kernel / fl::tile(fl::sum(kernel, {0}), {2 * width + 1});
-    // create low pass filter
-    auto filter = std::make_shared<Conv2D>(
-        Variable(fl::reshape(kernel, {kernel.dim(0), 1, 1, 1}), false),
-        1,
-        1,
-        PaddingMode::SAME,
-        0);
-    filter->eval();
-    lowPassFilters_.push_back(filter);
-  }
-  if (ignoredLowPassFilters_ >= lowPassFilters_.size()) {
+    kernels.push_back(kernel);
+    filterWidths_.push_back(width);
+    maxWidth = std::max(maxWidth, width);
+  }
+  if (ignoredLowPassFilters_ >= filterWidths_.size()) {
     throw std::invalid_argument(
         "All low pass filters are ignored, too huge kernel for all frequencies");
   }
+  // the centered kernels of the low pass filters, and of the identity, as the
+  // columns of a matrix, such that a band stop filter is one convolution
+  lowPassKernels_ =
+      fl::full({2 * maxWidth + 1, static_cast<Dim>(kernels.size()) + 1}, 0.0);
+  for (int fidx = 0; fidx < kernels.size(); fidx++) {
+    const int width = filterWidths_[fidx];
+    if (width >= 0) {
+      lowPassKernels_(
+          fl::range(maxWidth - width, maxWidth + width + 1), fidx) =
+          kernels[fidx];
+    }
+  }
+  lowPassKernels_(maxWidth, static_cast<Dim>(kernels.size())) = 1.0;
 }
 
 Variable RawWavSpecAugment::forward(const Variable& input) {
@@ -129,7 +141,7 @@ Variable RawWavSpecAugment::forward(const Variable& input) {
     throw std::invalid_argument(
         "input gradient calculation is not supported for RawWavSpecAugment.");
   }
-  if (lowPassFilters_.empty()) {
+  if (filterWidths_.empty()) {
     throw std::invalid_argument("invalid RawWavSpecAugment, filters are empty");
   }
 
@@ -147,17 +159,34 @@ Variable RawWavSpecAugment::forward(const Variable& input) {
 
   // input is expected T x C x B (mostly C=1)
   const Shape& inShape = inputCast.shape();
+  const Dim numTimeSteps = inShape[0]; // number of time steps
   // Conv2D input must be 4 dims (W x H x C x N) (N = batch size)
-  Shape timeView = {inShape[0], inShape[1] * inShape[2], 1, 1};
+  Shape timeView = {numTimeSteps, inShape[1] * inShape[2], 1, 1};
+  const Dim identityIdx = filterWidths_.size();
+  const int maxWidth = (lowPassKernels_.dim(0) - 1) / 2;
   for (int i = 0; i < numFreqMask_; ++i) {
     auto low = generateRandomInt(ignoredLowPassFilters_, rawWavNMels_);
     auto high =
         generateRandomInt(low, std::min(rawWavNMels_, low + freqMaskF_) + 1);
     if (high > low) {
-      auto inputForFilter = fl::moddims(output, timeView);
-      auto midLowWav = lowPassFilters_[high]->forward(inputForFilter);
-      auto lowWav = lowPassFilters_[low]->forward(inputForFilter);
-      output = output - fl::moddims(midLowWav - lowWav, inputCast.shape());
+      // a single band stop filter, identity - (lowpass[high] - lowpass[low])
+      const int width = std::max(filterWidths_[low], filterWidths_[high]);
+      auto rows = fl::range(maxWidth - width, maxWidth + width + 1);
+      auto kernel = lowPassKernels_(rows, identityIdx) +
+          lowPassKernels_(rows, low) - lowPassKernels_(rows, high);
+      auto weights = Variable(
+          fl::reshape(kernel, {2 * width + 1, 1, 1, 1})
+              .astype(inputCast.type()),
+          false);
+      output = fl::moddims(
+          fl::conv2d(
+              fl::moddims(output, timeView),
+              weights,
+              /* sx = */ 1,
+              /* sy = */ 1,
+              /* px = */ width,
+              /* py = */ 0),
+          inShape);
     }
   }
 
@@ -165,16 +194,23 @@ Variable RawWavSpecAugment::forward(const Variable& input) {
       ? fl::mean(inputCast.tensor()).asScalar<double>()
       : 0.0;
 
-  auto& opArr = output.tensor();
-  auto numTimeSteps = inputCast.dim(0); // number of time steps
   // an upper bound on the time mask
   int T = std::min(timeMaskT_, static_cast<int>(numTimeSteps * timeMaskP_));
-  if (T > 0) {
+  if (T > 0 && numTimeMask_ > 0) {
+    // the time masks are applied at once, and broadcast to the whole batch
+    std::vector<float> timeKeep(numTimeSteps, 1.0);
     for (int i = 0; i < numTimeMask_; ++i) {
       auto t = generateRandomInt(0, T);
       auto t0 = generateRandomInt(0, numTimeSteps - t);
-      opArr(fl::range(t0, t0 + t + 1)) = replaceVal;
+      std::fill(timeKeep.begin() + t0, timeKeep.begin() + t0 + t + 1, 0.0);
+    }
+    auto keep =
+        Tensor::fromVector({numTimeSteps}, timeKeep).astype(inputCast.type());
+    auto masked = output.tensor() * keep;
+    if (replaceVal != 0.0) {
+      masked = masked + replaceVal * (1 - keep);
     }
+    output = Variable(masked, false);
   }
   return output;
 }
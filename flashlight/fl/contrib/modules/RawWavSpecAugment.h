@@ -81,7 +81,11 @@ class RawWavSpecAugment : public UnaryModule {
   int maxKernelSize_;
   int ignoredLowPassFilters_;
   std::vector<float> cutoff_;
-  std::vector<std::shared_ptr<Conv2D>> lowPassFilters_;
+  // half width of the kernel of each low pass filter, or -1 if it is ignored
+  std::vector<int> filterWidths_;
+  // (2 * max width + 1) x (nMels + 2) centered kernels of the low pass
+  // filters, and of the identity in the last column
+  Tensor lowPassKernels_;
 
   int generateRandomInt(int low, int high);
 
@@ -37,6 +37,12 @@ SinusoidalPositionEmbedding::SinusoidalPositionEmbedding(
 
 std::vector<Variable> SinusoidalPositionEmbedding::forward(
     const std::vector<Variable>& input) {
+  return forward(input, 0);
+}
+
+std::vector<Variable> SinusoidalPositionEmbedding::forward(
+    const std::vector<Variable>& input,
+    int64_t firstPosition) {
   if (input[0].dim(0) != layerDim_) {
     throw std::invalid_argument(
         "Input dimenstion " + std::to_string(input[0].dim(0)) +
@@ -53,6 +59,9 @@ std::vector<Variable> SinusoidalPositionEmbedding::forward(
   //               [ 1,  1, ..],
   //               [.., .., ..]]
   Tensor positions = fl::iota({1, nPositions}, {layerDim_}, numType);
+  if (firstPosition != 0) {
+    positions = positions + static_cast<double>(firstPosition);
+  }
   // Generate the embedding transformation with the precomputed scale and shift
   // factors.
   positions = fl::sin(
@@ -65,6 +74,38 @@ std::vector<Variable> SinusoidalPositionEmbedding::forward(
   return {input[0] * inputScale_ + tileAs(embeddingsPos, input[0])};
 }
 
+std::vector<Variable> SinusoidalPositionEmbedding::forward(
+    const std::vector<Variable>& input,
+    const std::vector<int64_t>& firstPositions) {
+  if (input[0].dim(0) != layerDim_) {
+    throw std::invalid_argument(
+        "Input dimenstion " + std::to_string(input[0].dim(0)) +
+        " and Embedding dimension " + std::to_string(layerDim_) +
+        " are different.");
+  }
+  const int nPositions = input[0].dim(1);
+  const int batch = input[0].ndim() > 2 ? input[0].dim(2) : 1;
+  if (batch != firstPositions.size()) {
+    throw std::invalid_argument(
+        "SinusoidalPositionEmbedding::forward - a first position is "
+        "required for each batch element");
+  }
+  const auto numType = input[0].type();
+  // positions of size C x T x B, from the first position of each element
+  Tensor positions = fl::iota({1, nPositions}, {layerDim_, 1, batch}, numType) +
+      fl::tile(
+          fl::reshape(
+              Tensor::fromVector(firstPositions).astype(numType),
+              {1, 1, batch}),
+          {layerDim_, nPositions});
+  const Shape shape = {layerDim_, nPositions, batch};
+  positions = fl::sin(
+      positions * detail::tileAs(scale_.astype(numType), shape) +
+      detail::tileAs(cosShifts_.astype(numType), shape));
+  Variable embeddingsPos = Variable(positions, false);
+  return {input[0] * inputScale_ + tileAs(embeddingsPos, input[0])};
+}
+
 std::vector<Variable> SinusoidalPositionEmbedding::operator()(
     const std::vector<Variable>& input) {
   return forward(input);
@@ -44,6 +44,23 @@ class SinusoidalPositionEmbedding : public Container {
    */
   std::vector<Variable> forward(const std::vector<Variable>& input) override;
 
+  /**
+   * Same as `forward`, for positions starting at `firstPosition` rather than
+   * 0, e.g. for the next steps of a sequence whose previous steps are cached.
+   */
+  std::vector<Variable> forward(
+      const std::vector<Variable>& input,
+      int64_t firstPosition);
+
+  /**
+   * Same as `forward`, for the positions of each batch element starting at
+   * its own first position, e.g. for the next steps of sequences of different
+   * lengths batched together.
+   */
+  std::vector<Variable> forward(
+      const std::vector<Variable>& input,
+      const std::vector<int64_t>& firstPositions);
+
   std::vector<Variable> operator()(const std::vector<Variable>& input);
 
   std::string prettyString() const override;
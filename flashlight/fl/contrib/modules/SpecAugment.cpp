@@ -5,8 +5,10 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 
 #include "flashlight/fl/contrib/modules/SpecAugment.h"
 
@@ -51,8 +53,6 @@ Variable SpecAugment::forward(const Variable& input) {
     return output;
   }
 
-  auto& opArr = output.tensor();
-
   double replaceVal = (maskStrategy_ == MaskingStrategy::GLOBAL_MEAN)
       ? fl::mean(input.tensor()).asScalar<double>()
       : 0.0;
@@ -61,24 +61,34 @@ Variable SpecAugment::forward(const Variable& input) {
   if (numFreqChans < freqMaskF_) {
     throw std::runtime_error("Invalid input frequency channels");
   }
+  auto numTimeSteps = input.dim(0); // number of time steps
+  // an upper bound on the time mask
+  int T = std::min(timeMaskT_, static_cast<int>(numTimeSteps * timeMaskP_));
+  // the masks are drawn on the host, and applied at once as the product of
+  // the frequency and time masks, which broadcasts to the whole batch
+  std::vector<float> freqKeep(numFreqChans, 1.0);
   for (int i = 0; i < numFreqMask_; ++i) {
     auto f = generateRandomInt(0, freqMaskF_);
     auto f0 = generateRandomInt(0, numFreqChans - f);
-    opArr(fl::span, fl::range(f0, f0 + f + 1)) = replaceVal;
+    std::fill(freqKeep.begin() + f0, freqKeep.begin() + f0 + f + 1, 0.0);
   }
-
-  auto numTimeSteps = input.dim(0); // number of time steps
-  // an upper bound on the time mask
-  int T = std::min(timeMaskT_, static_cast<int>(numTimeSteps * timeMaskP_));
+  std::vector<float> timeKeep(numTimeSteps, 1.0);
   if (T > 0) {
     for (int i = 0; i < numTimeMask_; ++i) {
       auto t = generateRandomInt(0, T);
       auto t0 = generateRandomInt(0, numTimeSteps - t);
-      opArr(fl::range(t0, t0 + t + 1)) = replaceVal;
+      std::fill(timeKeep.begin() + t0, timeKeep.begin() + t0 + t + 1, 0.0);
     }
   }
 
-  return output;
+  auto keep = (Tensor::fromVector({1, numFreqChans}, freqKeep) *
+               Tensor::fromVector({numTimeSteps, 1}, timeKeep))
+                  .astype(input.type());
+  auto masked = input.tensor() * keep;
+  if (replaceVal != 0.0) {
+    masked = masked + replaceVal * (1 - keep);
+  }
+  return Variable(masked, false);
 }
 
 int SpecAugment::generateRandomInt(int low, int high) {
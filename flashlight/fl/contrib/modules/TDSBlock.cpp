@@ -7,8 +7,46 @@
 
 #include "flashlight/fl/contrib/modules/TDSBlock.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+#include "flashlight/fl/tensor/Index.h"
+
 namespace fl {
 
+TDSBlockState TDSBlockState::select(int64_t batchIdx) const {
+  TDSBlockState state;
+  if (!context.isEmpty()) {
+    state.context = context(
+        fl::span, fl::span, fl::span, fl::range(batchIdx, batchIdx + 1));
+  }
+  return state;
+}
+
+TDSBlockState TDSBlockState::concatenate(
+    const std::vector<TDSBlockState>& states) {
+  if (states.empty()) {
+    throw std::invalid_argument(
+        "TDSBlockState::concatenate - no states to concatenate");
+  }
+  TDSBlockState state;
+  if (states.front().context.isEmpty()) {
+    return state;
+  }
+  std::vector<Tensor> contexts;
+  for (const auto& s : states) {
+    if (s.context.isEmpty() ||
+        s.context.dim(0) != states.front().context.dim(0)) {
+      throw std::invalid_argument(
+          "TDSBlockState::concatenate - "
+          "states must be at the same position of their streams");
+    }
+    contexts.push_back(s.context);
+  }
+  state.context = fl::concatenate(contexts, 3);
+  return state;
+}
+
 TDSBlock::TDSBlock(
     int channels,
     int kernelSize,
@@ -75,6 +113,62 @@ std::vector<Variable> TDSBlock::forward(const std::vector<Variable>& inputs) {
   return module(3)->forward({out});
 }
 
+std::pair<Variable, TDSBlockState> TDSBlock::forwardStreaming(
+    const Variable& input,
+    TDSBlockState state,
+    bool last) {
+  auto norm = std::dynamic_pointer_cast<LayerNorm>(module(1));
+  const auto normAxis = norm->getAxis();
+  if (std::find(normAxis.begin(), normAxis.end(), 0) != normAxis.end()) {
+    throw std::invalid_argument(
+        "TDSBlock::forwardStreaming - normalization over time can't be "
+        "streamed");
+  }
+
+  // the left and right context of the convolution
+  auto conv = std::dynamic_pointer_cast<Sequential>(module(0));
+  int leftContext, rightContext;
+  if (auto pad = std::dynamic_pointer_cast<Padding>(conv->module(0))) {
+    leftContext = pad->getPadding().front().first;
+    rightContext = pad->getPadding().front().second;
+  } else {
+    const int kernelSize = conv->param(0).dim(0);
+    leftContext = (kernelSize - 1) / 2;
+    rightContext = kernelSize - 1 - leftContext;
+  }
+
+  // the buffer is padded with zeros at the ends of the stream, as the
+  // convolution of the whole stream
+  auto buffer = input.tensor();
+  auto padShape = buffer.shape();
+  if (state.context.isEmpty() && leftContext > 0) {
+    padShape[0] = leftContext;
+    buffer = fl::concatenate(0, fl::full(padShape, 0, buffer.type()), buffer);
+  } else if (!state.context.isEmpty()) {
+    buffer = fl::concatenate(0, state.context, buffer);
+  }
+  if (last && rightContext > 0) {
+    padShape[0] = rightContext;
+    buffer = fl::concatenate(0, buffer, fl::full(padShape, 0, buffer.type()));
+  }
+
+  // the frames whose convolution only covers the buffer
+  const int64_t nFrames = buffer.dim(0) - leftContext - rightContext;
+  if (nFrames <= 0) {
+    state.context = buffer;
+    return {Variable(), std::move(state)};
+  }
+  auto in = Variable(buffer, false);
+  const auto frames = fl::range(leftContext, leftContext + nFrames);
+  auto out = conv->forward(in)(frames).astype(in.type()) + in(frames);
+  out = module(1)->forward({out})[0];
+  out = module(2)->forward({out})[0].astype(out.type()) + out;
+  out = module(3)->forward({out})[0];
+
+  state.context = buffer(fl::range(nFrames, buffer.dim(0)));
+  return {out, std::move(state)};
+}
+
 std::string TDSBlock::prettyString() const {
   std::ostringstream ss;
   auto convW = param(0);
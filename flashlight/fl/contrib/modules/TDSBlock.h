@@ -7,10 +7,34 @@
 
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "flashlight/fl/nn/nn.h"
 
 namespace fl {
 
+/**
+ * The state of a `TDSBlock` between the chunks of a stream, see
+ * `TDSBlock::forwardStreaming`. Empty at the start of a stream.
+ */
+struct TDSBlockState {
+  // the inputs whose outputs are pending, preceded by the left context of the
+  // convolution, of size T x W x C x B
+  Tensor context;
+
+  /**
+   * @return the state of a single batch element, with batch size 1.
+   */
+  TDSBlockState select(int64_t batchIdx) const;
+
+  /**
+   * Batches the states of streams at the same position along the batch
+   * dimension.
+   */
+  static TDSBlockState concatenate(const std::vector<TDSBlockState>& states);
+};
+
 /**
  * Implements Time-Depth Separable Convolution Block as described in the paper
  * [Sequence-to-Sequence Speech Recognition with Time-Depth Separable
@@ -56,6 +80,25 @@ class TDSBlock : public Container {
       bool lNormIncludeTime = true);
 
   std::vector<Variable> forward(const std::vector<Variable>& inputs) override;
+
+  /**
+   * Forwards the next chunk of a stream, such that the outputs of the chunks
+   * of a stream equal those of `forward` over the whole stream in eval mode.
+   * The output of a frame is delayed until the right context of the
+   * convolution is available, so a chunk may yield fewer frames than it has.
+   * Requires the normalization to exclude the time dimension, i.e.
+   * `lNormIncludeTime` to be `false`.
+   *
+   * @param input the next frames of the stream, of size T x W x C x B
+   * @param state the state after the previous chunk, empty for the first one
+   * @param last whether the chunk ends the stream, which yields the pending
+   * frames
+   * @return the output frames which are ready, if any, and the state for the
+   * next chunk
+   */
+  std::pair<Variable, TDSBlockState>
+  forwardStreaming(const Variable& input, TDSBlockState state, bool last);
+
   std::string prettyString() const override;
 };
 
@@ -5,13 +5,16 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <stdexcept>
 
 #include "flashlight/fl/autograd/Functions.h"
 #include "flashlight/fl/contrib/modules/Transformer.h"
 #include "flashlight/fl/nn/Init.h"
 #include "flashlight/fl/nn/Utils.h"
+#include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Random.h"
 
 namespace {
@@ -23,6 +26,84 @@ fl::Variable transformerInitLinear(int32_t inDim, int32_t outDim) {
 
 namespace fl {
 
+int64_t TransformerCache::capacity() const {
+  return keys.isEmpty() ? 0 : keys.dim(0);
+}
+
+TransformerCache TransformerCache::select(int64_t batchIdx) const {
+  TransformerCache cache;
+  cache.length = length;
+  if (!keys.isEmpty()) {
+    const auto batch = fl::range(batchIdx, batchIdx + 1);
+    cache.keys = keys(fl::span, fl::span, batch);
+    cache.values = values(fl::span, fl::span, batch);
+  }
+  return cache;
+}
+
+TransformerCache TransformerCache::gather(const Tensor& batchIdx) const {
+  TransformerCache cache;
+  cache.length = length;
+  if (!keys.isEmpty()) {
+    cache.keys = keys(fl::span, fl::span, batchIdx);
+    cache.values = values(fl::span, fl::span, batchIdx);
+  }
+  return cache;
+}
+
+void TransformerCache::keepLast(int64_t steps) {
+  if (steps >= length) {
+    return;
+  }
+  if (steps > 0) {
+    const auto kept = fl::range(length - steps, length);
+    const auto front = fl::range(0, steps);
+    // copied first, as the ranges may overlap
+    keys(front) = keys(kept).copy();
+    values(front) = values(kept).copy();
+  }
+  length = std::max<int64_t>(steps, 0);
+}
+
+TransformerCache TransformerCache::concatenate(
+    const std::vector<TransformerCache>& caches) {
+  if (caches.empty()) {
+    throw std::invalid_argument(
+        "TransformerCache::concatenate - no caches to concatenate");
+  }
+  TransformerCache cache;
+  cache.length = caches.front().length;
+  bool sameCapacity = true;
+  for (const auto& c : caches) {
+    if (c.length != cache.length) {
+      throw std::invalid_argument(
+          "TransformerCache::concatenate - caches must have the same length");
+    }
+    sameCapacity = sameCapacity && c.capacity() == caches.front().capacity();
+  }
+  if (cache.length == 0) {
+    return cache;
+  }
+  // the used steps only, unless the buffers can be concatenated as they are
+  std::vector<Tensor> keys, values;
+  for (const auto& c : caches) {
+    if (sameCapacity) {
+      keys.push_back(c.keys);
+      values.push_back(c.values);
+    } else {
+      keys.push_back(c.keys(fl::range(0, cache.length)));
+      values.push_back(c.values(fl::range(0, cache.length)));
+    }
+  }
+  cache.keys = fl::concatenate(keys, 2);
+  cache.values = fl::concatenate(values, 2);
+  return cache;
+}
+
+int64_t TransformerBlockPool::numBlocks() const {
+  return keys.isEmpty() ? 0 : keys.dim(0) / blockSize;
+}
+
 Transformer::Transformer(
     int32_t modelDim,
     int32_t headDim,
@@ -84,7 +165,7 @@ Variable Transformer::selfAttention(const std::vector<Variable>& input) {
   // previous step[optionally], input, padMask
   auto encoderInput = input.at(input.size() - 2);
   // in case of previous state input[0] has size CxT_prevxB
-  int n = input[0].dim(1), bsz = input[0].dim(2);
+  int n = input[0].dim(1);
   double pDrop = train_ ? pDropout_ : 0.0;
 
   auto q = transpose((*wq_)(encoderInput), {1, 0, 2});
@@ -94,7 +175,8 @@ Variable Transformer::selfAttention(const std::vector<Variable>& input) {
 
   Variable mask, posEmb;
   if (bptt_ > 0) {
-    posEmb = tile(params_[0].astype(encoderInput.type()), {1, 1, nHeads_ * bsz});
+    // broadcast over heads and batch by matmul
+    posEmb = params_[0].astype(encoderInput.type());
   }
   if (useMask_ && encoderInput.dim(1) > 1) {
     // mask future if we use the previous state (then n is previous time)
@@ -125,6 +207,19 @@ Variable Transformer::selfAttention(const std::vector<Variable>& input) {
   return result;
 }
 
+Variable Transformer::addResiduals(
+    const Variable& x,
+    const Variable& attention,
+    float f) {
+  if (preLN_) {
+    auto h = (f * (*norm1_)(attention)).astype(x.type()) + x;
+    return f * (*norm2_)(mlp(h)).astype(h.type()) + h;
+  } else {
+    auto h = (*norm1_)((f * attention).astype(x.type()) + x);
+    return (*norm2_)((f * mlp(h)).astype(h.type()) + h);
+  }
+}
+
 std::vector<Variable> Transformer::forward(const std::vector<Variable>& input) {
   // previous step[optionally], input, padMask
   // padMask should be empty if previous step is provided
@@ -158,13 +253,234 @@ std::vector<Variable> Transformer::forward(const std::vector<Variable>& input) {
   if (train_ && (fl::rand({1}).scalar<float>() < pLayerdrop_)) {
     f = 0.0;
   }
-  if (preLN_) {
-    auto h = (f * (*norm1_)(selfAttention(input))).astype(x.type()) + x;
-    return {f * (*norm2_)(mlp(h)).astype(h.type()) + h};
-  } else {
-    auto h = (*norm1_)((f * selfAttention(input)).astype(x.type()) + x);
-    return {(*norm2_)((f * mlp(h)).astype(h.type()) + h)};
+  return {addResiduals(x, selfAttention(input), f)};
+}
+
+std::pair<Variable, TransformerCache> Transformer::forwardIncremental(
+    const Variable& input,
+    TransformerCache cache,
+    int64_t reserve /* = 0 */) {
+  if (input.ndim() != 3) {
+    throw std::invalid_argument(
+        "Transformer::forwardIncremental - input should be of 3 dimensions "
+        "expects an input of size C x T x B - see documentation.");
+  }
+  const int64_t prevLength = cache.length;
+  if (prevLength > 0 && cache.keys.dim(2) != input.dim(2)) {
+    throw std::invalid_argument(
+        "Transformer::forwardIncremental - input and cache batch sizes are "
+        "different");
+  }
+  const int64_t nSteps = input.dim(1);
+  const int64_t length = prevLength + nSteps;
+  if (bptt_ > 0 && prevLength >= bptt_) {
+    throw std::invalid_argument(
+        "Transformer::forwardIncremental - the sequence exceeds the size of "
+        "the relative positional embedding");
+  }
+
+  // only the inputs of the new steps are projected
+  auto q = transpose((*wq_)(input), {1, 0, 2});
+  auto k = transpose((*wk_)(input), {1, 0, 2}).tensor();
+  auto v = transpose((*wv_)(input), {1, 0, 2}).tensor();
+
+  if (cache.capacity() == 0 || cache.capacity() < length ||
+      cache.keys.type() != k.type() || cache.keys.dim(2) != k.dim(2)) {
+    const int64_t capacity =
+        std::max({length, 2 * cache.capacity(), reserve});
+    auto keys = fl::full({capacity, k.dim(1), k.dim(2)}, 0, k.type());
+    auto values = fl::full({capacity, v.dim(1), v.dim(2)}, 0, v.type());
+    if (prevLength > 0) {
+      const auto used = fl::range(0, prevLength);
+      keys(used) = cache.keys(used).astype(k.type());
+      values(used) = cache.values(used).astype(v.type());
+    }
+    cache.keys = std::move(keys);
+    cache.values = std::move(values);
+  }
+  const auto steps = fl::range(prevLength, length);
+  cache.keys(steps) = k;
+  cache.values(steps) = v;
+  cache.length = length;
+
+  const auto used = fl::range(0, length);
+  Variable keys(cache.keys(used), false);
+  Variable values(cache.values(used), false);
+
+  Variable mask, posEmb;
+  if (bptt_ > 0) {
+    posEmb = params_[0].astype(input.type());
   }
+  if (useMask_ && nSteps > 1) {
+    // the new steps attend to all previous ones, and not to the future
+    auto stepMask = fl::tril(fl::full({nSteps, nSteps}, 1.0));
+    if (prevLength > 0) {
+      stepMask =
+          fl::concatenate(1, fl::full({nSteps, prevLength}, 1.0), stepMask);
+    }
+    mask = Variable(fl::log(stepMask), false);
+  }
+
+  double pDrop = train_ ? pDropout_ : 0.0;
+  auto result = multiheadAttention(
+      q, keys, values, posEmb, mask, Variable(), nHeads_, pDrop, prevLength);
+  result = (*wf_)(transpose(result, {1, 0, 2}));
+
+  return {addResiduals(input, result, 1.0), std::move(cache)};
+}
+
+Variable Transformer::forwardPacked(
+    const Variable& input,
+    const std::vector<int64_t>& offsets) {
+  if (input.ndim() != 3 || input.dim(2) != 1) {
+    throw std::invalid_argument(
+        "Transformer::forwardPacked - input should be of size C x T x 1");
+  }
+  if (offsets.empty() || offsets.back() != input.dim(1)) {
+    throw std::invalid_argument(
+        "Transformer::forwardPacked - offsets should end at the length of the "
+        "input");
+  }
+  if (bptt_ > 0) {
+    throw std::invalid_argument(
+        "Transformer::forwardPacked - relative positional embedding isn't "
+        "supported for packed sequences");
+  }
+  // the heads are the batch of the packed attention, which doesn't
+  // materialize its block-diagonal, and causal, mask
+  const int64_t nSteps = input.dim(1);
+  const int64_t headDim = wq_->param(0).dim(0) / nHeads_;
+  auto q = moddims(
+      transpose((*wq_)(input), {1, 0, 2}), {nSteps, headDim, nHeads_});
+  auto k = moddims(
+      transpose((*wk_)(input), {1, 0, 2}), {nSteps, headDim, nHeads_});
+  auto v = moddims(
+      transpose((*wv_)(input), {1, 0, 2}), {nSteps, headDim, nHeads_});
+
+  double pDrop = train_ ? pDropout_ : 0.0;
+  auto result = scaledDotProductAttention(
+      q, k, v, Variable(), pDrop, std::nullopt, offsets, useMask_);
+  result = moddims(result, {nSteps, headDim * nHeads_, 1});
+  result = (*wf_)(transpose(result, {1, 0, 2}));
+
+  float f = 1.0;
+  if (train_ && (fl::rand({1}).scalar<float>() < pLayerdrop_)) {
+    f = 0.0;
+  }
+  return addResiduals(input, result, f);
+}
+
+TransformerBlockPool Transformer::createBlockPool(
+    int64_t numBlocks,
+    int64_t blockSize,
+    fl::dtype type /* = fl::dtype::f32 */) const {
+  if (numBlocks < 1 || blockSize < 1) {
+    throw std::invalid_argument(
+        "Transformer::createBlockPool - invalid number or size of blocks");
+  }
+  const int64_t dim = wk_->param(0).dim(0);
+  TransformerBlockPool pool;
+  pool.keys = fl::full({numBlocks * blockSize, dim}, 0, type);
+  pool.values = fl::full({numBlocks * blockSize, dim}, 0, type);
+  pool.blockSize = blockSize;
+  return pool;
+}
+
+Variable Transformer::forwardPaged(
+    const Variable& input,
+    TransformerBlockPool& pool,
+    const std::vector<TransformerPagedSequence>& sequences) {
+  if (input.ndim() != 3 || input.dim(2) != sequences.size()) {
+    throw std::invalid_argument(
+        "Transformer::forwardPaged - input should be of size C x T x B, "
+        "for B sequences");
+  }
+  if (bptt_ > 0) {
+    throw std::invalid_argument(
+        "Transformer::forwardPaged - relative positional embedding isn't "
+        "supported for paged sequences");
+  }
+  const int64_t nSteps = input.dim(1);
+  const int64_t batch = input.dim(2);
+  const int64_t blockSize = pool.blockSize;
+  int64_t nKeys = 0;
+  for (const auto& seq : sequences) {
+    if (seq.steps < 1 || seq.steps > nSteps || seq.length < 0 ||
+        seq.length + seq.steps > blockSize * int64_t(seq.blocks.size())) {
+      throw std::invalid_argument(
+          "Transformer::forwardPaged - the blocks of a sequence don't hold "
+          "its steps");
+    }
+    nKeys = std::max(nKeys, seq.length + seq.steps);
+  }
+
+  // the rows of the pool of the new steps, and of all the steps of each
+  // sequence, whose padding is masked along with the future if `useMask`
+  std::vector<int64_t> newRows, inputRows;
+  std::vector<int64_t> keyRows(nKeys * batch, 0);
+  std::vector<float> mask(
+      nSteps * nKeys * batch, -std::numeric_limits<float>::infinity());
+  for (int64_t b = 0; b < batch; ++b) {
+    const auto& seq = sequences[b];
+    const int64_t total = seq.length + seq.steps;
+    auto row = [&seq, blockSize](int64_t step) {
+      return seq.blocks[step / blockSize] * blockSize + step % blockSize;
+    };
+    for (int64_t t = 0; t < seq.steps; ++t) {
+      newRows.push_back(row(seq.length + t));
+      inputRows.push_back(t + nSteps * b);
+    }
+    for (int64_t j = 0; j < total; ++j) {
+      keyRows[j + nKeys * b] = row(j);
+    }
+    for (int64_t t = 0; t < nSteps; ++t) {
+      const int64_t end =
+          useMask_ ? std::min(seq.length + t + 1, total) : total;
+      for (int64_t j = 0; j < end; ++j) {
+        mask[t + nSteps * (j + nKeys * b)] = 0;
+      }
+    }
+  }
+
+  auto q = transpose((*wq_)(input), {1, 0, 2});
+  const int64_t dim = q.dim(1);
+  const int64_t headDim = dim / nHeads_;
+  // the projections of the steps of the input by row, t + T * b
+  auto inputSteps = [nSteps, batch, dim](const Variable& x) {
+    return fl::reshape(
+        fl::transpose(x.tensor(), {1, 2, 0}), {nSteps * batch, dim});
+  };
+  auto newIdx = Tensor::fromVector(newRows);
+  auto inputIdx = Tensor::fromVector(inputRows);
+  pool.keys(newIdx) =
+      inputSteps((*wk_)(input))(inputIdx).astype(pool.keys.type());
+  pool.values(newIdx) =
+      inputSteps((*wv_)(input))(inputIdx).astype(pool.values.type());
+
+  auto keyIdx = Tensor::fromVector(keyRows);
+  auto gather = [&](const Tensor& buffer) {
+    auto steps = fl::reshape(buffer(keyIdx), {nKeys, batch, dim});
+    return Variable(
+        fl::reshape(
+            fl::transpose(steps, {0, 2, 1}).astype(q.type()),
+            {nKeys, headDim, nHeads_ * batch}),
+        false);
+  };
+  // the mask of each sequence is shared by its heads
+  auto headMask = fl::reshape(
+      fl::tile(
+          Tensor::fromVector({nSteps, nKeys, 1, batch}, mask), {1, 1, nHeads_}),
+      {nSteps, nKeys, nHeads_ * batch});
+
+  auto result = scaledDotProductAttention(
+      moddims(q, {nSteps, headDim, nHeads_ * batch}),
+      gather(pool.keys),
+      gather(pool.values),
+      Variable(headMask, false));
+  result = moddims(result, {nSteps, dim, batch});
+  result = (*wf_)(transpose(result, {1, 0, 2}));
+
+  return addResiduals(input, result, 1.0);
 }
 
 void Transformer::setDropout(float value) {
@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "flashlight/fl/nn/modules/Container.h"
 #include "flashlight/fl/nn/modules/LayerNorm.h"
 #include "flashlight/fl/nn/modules/Linear.h"
@@ -14,6 +17,85 @@
 
 namespace fl {
 
+/**
+ * The projected keys and values of the previous steps of a `Transformer`, for
+ * incremental decoding with `Transformer::forwardIncremental`.
+ *
+ * Keys and values are stored in buffers of size capacity x (nHeads * headDim)
+ * x B, whose first `length` steps are used. The buffers grow geometrically,
+ * so that a step only computes and writes the keys and values of its own
+ * inputs. Copies of a cache are independent, e.g. for the hypotheses of a beam
+ * search.
+ */
+struct TransformerCache {
+  Tensor keys;
+  Tensor values;
+  int64_t length{0};
+
+  /** @return the number of steps the buffers can hold */
+  int64_t capacity() const;
+
+  /**
+   * @return the cache of a single batch element, with batch size 1.
+   */
+  TransformerCache select(int64_t batchIdx) const;
+
+  /**
+   * @return the cache of batch elements gathered by index, e.g. of the
+   * surviving hypotheses of a beam search, in a single copy.
+   */
+  TransformerCache gather(const Tensor& batchIdx) const;
+
+  /**
+   * Keeps the last `steps` steps of the cache only, moved to the front of its
+   * buffers, e.g. for a sliding window of attention over a long sequence.
+   * Does nothing if the cache has as few steps.
+   */
+  void keepLast(int64_t steps);
+
+  /**
+   * Batches caches of the same length, e.g. of the hypotheses of a beam
+   * search, along the batch dimension.
+   */
+  static TransformerCache concatenate(
+      const std::vector<TransformerCache>& caches);
+};
+
+/**
+ * Fixed-size blocks of the keys and values of a `Transformer`, in which the
+ * caches of many sequences are paged for `Transformer::forwardPaged`, e.g. of
+ * the concurrent requests of an inference server. A sequence holds any blocks
+ * of the pool, which the caller allocates, so that the blocks of finished
+ * sequences are reused by others whatever their lengths, without
+ * fragmentation. The layers of a model share the block tables of the
+ * sequences, each with its own pool.
+ *
+ * Keys and values are stored in buffers of size (numBlocks * blockSize) x
+ * (nHeads * headDim), the i-th block spanning the rows [i * blockSize, (i +
+ * 1) * blockSize).
+ */
+struct TransformerBlockPool {
+  Tensor keys;
+  Tensor values;
+  int64_t blockSize{0};
+
+  /** @return the number of blocks of the pool */
+  int64_t numBlocks() const;
+};
+
+/**
+ * A sequence whose keys and values are paged in a `TransformerBlockPool`.
+ */
+struct TransformerPagedSequence {
+  // the blocks of the sequence, in order, which hold its step `i` in the row
+  // `i % blockSize` of the block `blocks[i / blockSize]`
+  std::vector<int64_t> blocks;
+  // the number of steps of the sequence in the pool
+  int64_t length{0};
+  // the number of new steps of the input, of which the others are padding
+  int64_t steps{0};
+};
+
 /**
  * A module which implements a Transformer.
  *
@@ -60,6 +142,80 @@ class Transformer : public Container {
       bool preLN = false);
 
   std::vector<Variable> forward(const std::vector<Variable>& input) override;
+
+  /**
+   * Forwards the next steps of a sequence given the keys and values of its
+   * previous steps, which costs linear rather than quadratic time in the
+   * length of the sequence per step, as in autoregressive decoding. With
+   * `useMask`, the result equals that of the corresponding steps of `forward`
+   * over the whole sequence without a pad mask, in eval mode.
+   *
+   * Layer drop isn't applied, and the cache isn't differentiable. With a
+   * relative positional embedding, the sequence is limited to `bptt` steps.
+   *
+   * @param input the next steps, of size C x T x B
+   * @param cache the cache of the previous steps, empty for the first ones.
+   * Its buffers are written in place if it's moved from and they're large
+   * enough, and copied otherwise.
+   * @param reserve the minimum number of steps to allocate the buffers of the
+   * cache for when they grow, e.g. the maximum length of the sequence
+   * @return the output for the steps, of size C x T x B, and the cache of the
+   * sequence including them
+   */
+  std::pair<Variable, TransformerCache> forwardIncremental(
+      const Variable& input,
+      TransformerCache cache,
+      int64_t reserve = 0);
+
+  /**
+   * Forwards packed sequences of variable length, e.g. from `fl::packBatch`,
+   * each of which only attends to itself, as with a block-diagonal mask which
+   * isn't materialized. With `useMask`, a sequence doesn't attend to its
+   * future either. The result for a sequence equals that of `forward` for it
+   * alone, without padding.
+   *
+   * A relative positional embedding isn't supported.
+   *
+   * @param input the sequences concatenated along time, of size C x T x 1
+   * @param offsets the cumulative lengths of the sequences, such that the i-th
+   * one spans the steps [offsets[i], offsets[i + 1]) of the input
+   * @return the output for the sequences, of size C x T x 1
+   */
+  Variable forwardPacked(
+      const Variable& input,
+      const std::vector<int64_t>& offsets);
+
+  /**
+   * Creates a pool of key/value blocks for `forwardPaged`.
+   */
+  TransformerBlockPool createBlockPool(
+      int64_t numBlocks,
+      int64_t blockSize,
+      fl::dtype type = fl::dtype::f32) const;
+
+  /**
+   * Forwards the next steps of a batch of sequences of different lengths,
+   * whose keys and values are paged in the blocks of a pool, e.g. of requests
+   * batched dynamically by an inference server. The keys and values of the
+   * new steps are written to the blocks of their sequences, which must hold
+   * them. With `useMask`, the result for a sequence equals that of
+   * `forwardIncremental` for its steps, in eval mode.
+   *
+   * Layer drop isn't applied, and the pool isn't differentiable. A relative
+   * positional embedding isn't supported.
+   *
+   * @param input the next steps, of size C x T x B, of which the first
+   * `sequences[b].steps` ones of the b-th sequence are used
+   * @param pool the pool of the keys and values of the sequences
+   * @param sequences the blocks and lengths of the B sequences
+   * @return the output for the steps, of size C x T x B, which is undefined
+   * for the padded steps
+   */
+  Variable forwardPaged(
+      const Variable& input,
+      TransformerBlockPool& pool,
+      const std::vector<TransformerPagedSequence>& sequences);
+
   void setDropout(float value);
   void setLayerDropout(float value);
   std::string prettyString() const override;
@@ -77,6 +233,9 @@ class Transformer : public Container {
   Variable mlp(const Variable& input);
   Variable getMask(int32_t n, bool cache = false);
   Variable selfAttention(const std::vector<Variable>& input);
+  // Adds the residual connections and the feed-forward block to the output of
+  // the attention, with a layer drop factor
+  Variable addResiduals(const Variable& x, const Variable& attention, float f);
 
   FL_SAVE_LOAD_WITH_BASE(
       Container,
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/dataset/BatchCollator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "flashlight/fl/dataset/Utils.h"
+#include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Profile.h"
+
+namespace fl {
+
+namespace {
+
+// Copies a sample to its slot of a batch buffer, padding it with zeros to the
+// shape of the slot
+void copyToSlot(
+    const Tensor& sample,
+    const Shape& slotShape,
+    char* slot,
+    std::vector<char>& scratch) {
+  const auto& shape = sample.shape();
+  const size_t typeSize = fl::getTypeSize(sample.type());
+  for (int d = 0; d < shape.ndim(); ++d) {
+    if (shape[d] > (d < slotShape.ndim() ? slotShape[d] : 1)) {
+      throw std::invalid_argument(
+          "BatchCollator::collate - sample of shape " + shape.toString() +
+          " exceeds the shape " + slotShape.toString());
+    }
+  }
+  if (shape.elements() == slotShape.elements()) {
+    // no padding, so the layout of the sample is that of the slot
+    sample.host<void>(slot);
+    return;
+  }
+  std::memset(slot, 0, slotShape.elements() * typeSize);
+  if (shape.elements() == 0) {
+    return;
+  }
+  scratch.resize(sample.bytes());
+  sample.host<void>(scratch.data());
+  // copy the columns, contiguous in column-major order, to their padded place
+  const Dim rows = shape.ndim() > 0 ? shape[0] : 1;
+  const Dim cols = shape.elements() / rows;
+  for (Dim c = 0; c < cols; ++c) {
+    Dim rem = c;
+    Dim offset = 0;
+    Dim stride = slotShape.ndim() > 0 ? slotShape[0] : 1;
+    for (int d = 1; d < slotShape.ndim(); ++d) {
+      const Dim dim = d < shape.ndim() ? shape[d] : 1;
+      offset += (rem % dim) * stride;
+      rem /= dim;
+      stride *= slotShape[d];
+    }
+    std::memcpy(
+        slot + offset * typeSize,
+        scratch.data() + c * rows * typeSize,
+        rows * typeSize);
+  }
+}
+
+Shape batchShape(const Shape& slotShape, Dim batchSize) {
+  // as with makeBatch, along the first dimension after those of the samples
+  if (slotShape.elements() <= 1) {
+    return Shape({batchSize});
+  }
+  auto dims = slotShape.get();
+  dims.push_back(batchSize);
+  return Shape(dims);
+}
+
+} // namespace
+
+BatchCollator::BatchCollator(
+    std::vector<Shape> sampleShapes,
+    bool pinned /* = false */)
+    : sampleShapes_(std::move(sampleShapes)), pinned_(pinned) {
+  if (sampleShapes_.empty()) {
+    throw std::invalid_argument(
+        "BatchCollator::BatchCollator - no sample shapes");
+  }
+}
+
+BatchCollator::~BatchCollator() {
+  for (auto& buffer : pool_) {
+    if (pinned_) {
+      fl::freePinnedHost(buffer.data);
+    } else {
+      delete[] buffer.data;
+    }
+  }
+}
+
+BatchCollator::Buffer BatchCollator::acquire(size_t bytes) const {
+  {
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    for (auto it = pool_.begin(); it != pool_.end(); ++it) {
+      if (it->bytes >= bytes) {
+        auto buffer = *it;
+        pool_.erase(it);
+        return buffer;
+      }
+    }
+  }
+  Buffer buffer;
+  buffer.bytes = bytes;
+  buffer.data = pinned_ ? static_cast<char*>(fl::allocPinnedHost(bytes))
+                        : new char[bytes];
+  return buffer;
+}
+
+void BatchCollator::release(Buffer buffer) const {
+  std::lock_guard<std::mutex> lock(poolMutex_);
+  pool_.push_back(buffer);
+}
+
+size_t BatchCollator::pooledBuffers() const {
+  std::lock_guard<std::mutex> lock(poolMutex_);
+  return pool_.size();
+}
+
+std::vector<Tensor> BatchCollator::collate(
+    const Dataset& dataset,
+    const std::vector<Dataset::BatchFunction>& batchFns,
+    int64_t start,
+    int64_t end) const {
+  FL_PROFILE_TRACE("BatchCollator::collate");
+  const int64_t batchSize = end - start;
+  std::vector<Buffer> buffers;
+  std::vector<dtype> types;
+  std::vector<size_t> slotBytes;
+  std::vector<std::vector<Tensor>> others;
+  std::vector<char> scratch;
+  const auto releaseAll = [this, &buffers]() {
+    for (auto& buffer : buffers) {
+      release(buffer);
+    }
+    buffers.clear();
+  };
+
+  std::vector<Tensor> result;
+  try {
+    // fetch the samples concurrently, if the dataset can
+    std::vector<int64_t> indices(std::max<int64_t>(batchSize, 0));
+    std::iota(indices.begin(), indices.end(), start);
+    auto samples = dataset.getBatchAsync(indices);
+    for (int64_t i = 0; i < batchSize; ++i) {
+      auto sample = samples[i].get();
+      if (sample.size() < sampleShapes_.size()) {
+        throw std::invalid_argument(
+            "BatchCollator::collate - sample has " +
+            std::to_string(sample.size()) + " fields, expected at least " +
+            std::to_string(sampleShapes_.size()));
+      }
+      for (size_t f = 0; f < sampleShapes_.size(); ++f) {
+        if (i == 0) {
+          types.push_back(sample[f].type());
+          slotBytes.push_back(
+              sampleShapes_[f].elements() * fl::getTypeSize(types[f]));
+          buffers.push_back(acquire(slotBytes[f] * batchSize));
+        } else if (sample[f].type() != types[f]) {
+          throw std::invalid_argument(
+              "BatchCollator::collate - type mismatch in field " +
+              std::to_string(f));
+        }
+        copyToSlot(
+            sample[f],
+            sampleShapes_[f],
+            buffers[f].data + i * slotBytes[f],
+            scratch);
+      }
+      if (others.size() < sample.size() - sampleShapes_.size()) {
+        others.resize(sample.size() - sampleShapes_.size());
+      }
+      for (size_t f = sampleShapes_.size(); f < sample.size(); ++f) {
+        others[f - sampleShapes_.size()].push_back(std::move(sample[f]));
+      }
+    }
+    for (size_t f = 0; f < buffers.size(); ++f) {
+      // copies the buffer, which can be reused afterwards
+      result.push_back(Tensor::fromBuffer(
+          batchShape(sampleShapes_[f], batchSize),
+          types[f],
+          reinterpret_cast<const uint8_t*>(buffers[f].data),
+          MemoryLocation::Host));
+    }
+  } catch (...) {
+    releaseAll();
+    throw;
+  }
+  releaseAll();
+  for (size_t f = 0; f < others.size(); ++f) {
+    const auto field = f + sampleShapes_.size();
+    result.push_back(makeBatch(
+        others[f], field < batchFns.size() ? batchFns[field] : nullptr));
+  }
+  return result;
+}
+
+} // namespace fl
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "flashlight/fl/dataset/Dataset.h"
+#include "flashlight/fl/tensor/Shape.h"
+
+namespace fl {
+
+/**
+ * Collates samples into batches whose shapes are known up front: the samples
+ * of each field are copied to the host directly into their slot of a single
+ * buffer, from which the batch is created with one copy, instead of
+ * allocating and assigning a batch tensor sample by sample as `makeBatch`
+ * does.
+ *
+ * Samples smaller than the shape of their field, e.g. sequences of variable
+ * length, are padded with zeros to it. Host buffers, optionally pinned (see
+ * `fl::allocPinnedHost`), are reused across batches from a pool.
+ *
+ * Batches have the same shape as with `makeBatch`: a field of shape
+ * `[d0, ..., dn]` is batched along a new dimension `[d0, ..., dn, batchsize]`.
+ *
+ * Example:
+  \code{.cpp}
+  // inputs of up to 1000 frames of 80 features, and targets of up to 100
+  auto collator = std::make_shared<BatchCollator>(
+      std::vector<Shape>{{80, 1000}, {100}}, true);
+  auto batchds = std::make_shared<BatchDataset>(ds, 32);
+  batchds->setCollator(collator);
+  \endcode
+ */
+class BatchCollator {
+ public:
+  /**
+   * Creates a `BatchCollator`.
+   * @param[in] sampleShapes The shape of a (padded) sample of each field.
+   * Fields after these are batched with `makeBatch`.
+   * @param[in] pinned Whether buffers are allocated in pinned host memory,
+   * which speeds up their copy to the device.
+   */
+  explicit BatchCollator(std::vector<Shape> sampleShapes, bool pinned = false);
+
+  ~BatchCollator();
+
+  // no copy/move
+  BatchCollator(const BatchCollator&) = delete;
+  BatchCollator& operator=(const BatchCollator&) = delete;
+
+  /**
+   * Collates the samples of a range `[start, end)` of a dataset into a batch.
+   * Thread-safe.
+   * @param[in] dataset The dataset from which the samples are taken.
+   * @param[in] batchFns The batch functions of the fields which aren't
+   * collated.
+   * @param[in] start The start index.
+   * @param[in] end The end index.
+   */
+  std::vector<Tensor> collate(
+      const Dataset& dataset,
+      const std::vector<Dataset::BatchFunction>& batchFns,
+      int64_t start,
+      int64_t end) const;
+
+  /**
+   * @return The number of host buffers in the pool.
+   */
+  size_t pooledBuffers() const;
+
+ private:
+  struct Buffer {
+    char* data{nullptr};
+    size_t bytes{0};
+  };
+
+  Buffer acquire(size_t bytes) const;
+  void release(Buffer buffer) const;
+
+  std::vector<Shape> sampleShapes_;
+  bool pinned_;
+  mutable std::mutex poolMutex_;
+  mutable std::vector<Buffer> pool_;
+};
+
+} // namespace fl
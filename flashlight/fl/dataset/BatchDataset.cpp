@@ -11,6 +11,9 @@
 #include <array>
 #include <numeric>
 #include <stdexcept>
+#include <utility>
+
+#include "flashlight/fl/dataset/DatasetProfiler.h"
 
 namespace fl {
 BatchDataset::BatchDataset(
@@ -69,6 +72,7 @@ BatchDataset::BatchDataset(
 
 std::vector<Tensor> BatchDataset::get(const int64_t idx) const {
   checkIndexBounds(idx);
+  DatasetProfileRange range("BatchDataset");
   int64_t start, end;
   if (cumSumBatchSize_.empty()) {
     // batchsize is given
@@ -79,9 +83,16 @@ std::vector<Tensor> BatchDataset::get(const int64_t idx) const {
     start = idx == 0 ? 0 : cumSumBatchSize_[idx - 1];
     end = std::min(cumSumBatchSize_[idx], preBatchSize_);
   }
+  if (collator_) {
+    return collator_->collate(*dataset_, batchFns_, start, end);
+  }
   return makeBatchFromRange(dataset_, batchFns_, start, end);
 }
 
+void BatchDataset::setCollator(std::shared_ptr<const BatchCollator> collator) {
+  collator_ = std::move(collator);
+}
+
 int64_t BatchDataset::size() const {
   return size_;
 }
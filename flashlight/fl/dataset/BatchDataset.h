@@ -6,6 +6,7 @@
  */
 
 #pragma once
+#include "flashlight/fl/dataset/BatchCollator.h"
 #include "flashlight/fl/dataset/Dataset.h"
 #include "flashlight/fl/dataset/Utils.h"
 
@@ -83,12 +84,20 @@ class BatchDataset : public Dataset {
 
   std::vector<Tensor> get(const int64_t idx) const override;
 
+  /**
+   * Collates the samples of each batch with a `BatchCollator`, into
+   * preallocated host buffers, instead of the batch functions.
+   * @param[in] collator The collator, or null to use the batch functions.
+   */
+  void setCollator(std::shared_ptr<const BatchCollator> collator);
+
  private:
   std::shared_ptr<const Dataset> dataset_;
   int64_t batchSize_;
   BatchDatasetPolicy batchPolicy_;
   std::vector<int64_t> cumSumBatchSize_;
   std::vector<BatchFunction> batchFns_;
+  std::shared_ptr<const BatchCollator> collator_;
 
   int64_t preBatchSize_; // Size of the dataset before batching
   int64_t size_;
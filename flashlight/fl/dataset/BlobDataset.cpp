@@ -10,6 +10,7 @@
 #include <thread>
 
 #include "flashlight/fl/dataset/BlobDataset.h"
+#include "flashlight/fl/dataset/DatasetProfiler.h"
 #include "flashlight/fl/tensor/Types.h"
 
 namespace fl {
@@ -71,6 +72,7 @@ int64_t BlobDataset::size() const {
 }
 
 std::vector<Tensor> BlobDataset::get(const int64_t idx) const {
+  DatasetProfileRange range("BlobDataset");
   std::vector<Tensor> sample;
   for (int64_t i = 0; i < sizes_.at(idx); i++) {
     auto entry = entries_.get(offsets_.at(idx) + i);
@@ -167,8 +169,20 @@ std::vector<uint8_t> BlobDataset::readRawArray(
 
 Tensor BlobDataset::readArray(const BlobDatasetEntry& e, int i) const {
   if (e.dims.elements() > 0) {
-    auto buffer = readRawArray(e);
     auto keyval = hostTransforms_.find(i);
+    // host transforms may modify their buffer, so are given a copy
+    if (keyval == hostTransforms_.end()) {
+      const auto* ptr =
+          dataPtr(e.offset, fl::getTypeSize(e.type) * e.dims.elements());
+      if (ptr) {
+        return Tensor::fromBuffer(
+            e.dims,
+            e.type,
+            reinterpret_cast<const uint8_t*>(ptr),
+            MemoryLocation::Host);
+      }
+    }
+    auto buffer = readRawArray(e);
     if (keyval == hostTransforms_.end()) {
       return Tensor::fromBuffer(
           e.dims, e.type, buffer.data(), MemoryLocation::Host);
@@ -180,6 +194,12 @@ Tensor BlobDataset::readArray(const BlobDatasetEntry& e, int i) const {
   }
 }
 
+const char* BlobDataset::dataPtr(
+    int64_t /* offset */,
+    int64_t /* size */) const {
+  return nullptr;
+}
+
 void BlobDataset::writeArray(const BlobDatasetEntry& e, const Tensor& array) {
   std::vector<uint8_t> buffer(array.bytes());
   array.host(buffer.data());
@@ -90,12 +90,27 @@ class BlobDataset : public Dataset {
   mutable std::mutex mutex_;
 
   std::vector<uint8_t> readRawArray(const BlobDatasetEntry& e) const;
-  Tensor readArray(const BlobDatasetEntry& e, int i) const;
   void writeArray(const BlobDatasetEntry& e, const Tensor& array);
 
  protected:
   void readIndex();
 
+  /**
+   * Read the array of an entry, which is the i-th of its sample, applying the
+   * host transform of its field if any.
+   */
+  Tensor readArray(const BlobDatasetEntry& e, int i) const;
+
+  /**
+   * Return a pointer to raw data of the blob if it is addressable in host
+   * memory, such that arrays are read without an intermediate copy, and
+   * nullptr otherwise.
+   * Implementation must be thread-safe.
+   * @param[in] offset Offset in the blob in bytes.
+   * @param[in] size Raw data size in bytes.
+   */
+  virtual const char* dataPtr(int64_t offset, int64_t size) const;
+
   /**
    * Write raw data in the blob.
    * Implementation must be thread-safe.
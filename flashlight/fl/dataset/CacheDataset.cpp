@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/dataset/CacheDataset.h"
+
+#include <stdexcept>
+
+#include "flashlight/fl/dataset/DatasetProfiler.h"
+
+namespace fl {
+
+CacheDataset::CacheDataset(
+    std::shared_ptr<const Dataset> dataset,
+    int64_t memoryCapacity,
+    const std::string& diskPath /* = "" */,
+    int64_t version /* = 0 */)
+    : dataset_(dataset),
+      version_(version),
+      memoryCapacity_(memoryCapacity),
+      memory_(memoryCapacity) {
+  if (!dataset_) {
+    throw std::invalid_argument("dataset to be cached is null");
+  }
+  if (memoryCapacity < 0) {
+    throw std::invalid_argument("invalid memory capacity");
+  }
+  if (!diskPath.empty()) {
+    disk_ = std::make_unique<FileBlobDataset>(
+        diskPath, /* rw = */ true, /* truncate = */ true);
+  }
+}
+
+std::vector<Tensor> CacheDataset::get(const int64_t idx) const {
+  checkIndexBounds(idx);
+  DatasetProfileRange range("CacheDataset");
+  const int64_t version = version_;
+
+  if (memoryCapacity_ > 0) {
+    std::lock_guard<std::mutex> lock(memoryMutex_);
+    auto* entry = memory_.get(idx);
+    if (entry && entry->version == version) {
+      ++memoryHits_;
+      return entry->sample;
+    }
+  }
+
+  std::vector<Tensor> sample;
+  bool cached = false;
+  if (disk_) {
+    std::shared_lock<std::shared_mutex> lock(diskMutex_);
+    auto entry = diskEntries_.find(idx);
+    if (entry != diskEntries_.end() && entry->second.version == version) {
+      sample = disk_->get(entry->second.blobIdx);
+      cached = true;
+    }
+  }
+  if (cached) {
+    ++diskHits_;
+  } else {
+    ++misses_;
+    sample = dataset_->get(idx);
+    if (disk_) {
+      std::unique_lock<std::shared_mutex> lock(diskMutex_);
+      auto& entry = diskEntries_[idx];
+      if (entry.blobIdx < 0 || entry.version != version) {
+        // a stale sample stays in the file, unreferenced
+        disk_->add(sample);
+        entry = {version, disk_->size() - 1};
+      }
+    }
+  }
+
+  if (memoryCapacity_ > 0) {
+    std::lock_guard<std::mutex> lock(memoryMutex_);
+    memory_.put(
+        idx, std::make_unique<MemoryEntry>(MemoryEntry{version, sample}));
+  }
+  return sample;
+}
+
+int64_t CacheDataset::size() const {
+  return dataset_->size();
+}
+
+void CacheDataset::setVersion(int64_t version) {
+  version_ = version;
+}
+
+int64_t CacheDataset::memoryHits() const {
+  return memoryHits_;
+}
+
+int64_t CacheDataset::diskHits() const {
+  return diskHits_;
+}
+
+int64_t CacheDataset::misses() const {
+  return misses_;
+}
+
+} // namespace fl
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flashlight/fl/dataset/Dataset.h"
+#include "flashlight/fl/dataset/FileBlobDataset.h"
+#include "flashlight/fl/distributed/LRUCache.h"
+
+namespace fl {
+
+/**
+ * A view into a dataset whose samples are cached after they are first read,
+ * for datasets whose samples are expensive but deterministic, e.g. the output
+ * of a `TransformDataset` extracting features. Samples are cached in a
+ * bounded in-memory LRU tier, and optionally in a disk tier, a blob file to
+ * which every sample is written once, from which samples evicted from memory
+ * are read back.
+ *
+ * Cached samples are keyed by their index and the version of the underlying
+ * dataset: after `setVersion`, e.g. when the transforms change, samples cached
+ * with a previous version are read again from the underlying dataset.
+ *
+ * The cache is thread-safe, and can be filled concurrently, e.g. by the
+ * workers of a `PrefetchDataset` over it. The disk tier is a scratch file,
+ * truncated when the dataset is created.
+ *
+ * Example:
+  \code{.cpp}
+  auto featurized = std::make_shared<TransformDataset>(audio, transforms);
+  // keep 10000 samples in memory, and all of them on disk
+  auto cached = std::make_shared<CacheDataset>(
+      featurized, 10000, "/tmp/features.blob");
+  PrefetchDataset prefetched(cached, 8, 8);
+  \endcode
+ */
+class CacheDataset : public Dataset {
+ public:
+  /**
+   * Creates a `CacheDataset`.
+   * @param[in] dataset The underlying dataset.
+   * @param[in] memoryCapacity The number of samples cached in memory.
+   * @param[in] diskPath If not empty, the path of the blob file of the disk
+   * tier.
+   * @param[in] version The version of the underlying dataset.
+   */
+  CacheDataset(
+      std::shared_ptr<const Dataset> dataset,
+      int64_t memoryCapacity,
+      const std::string& diskPath = "",
+      int64_t version = 0);
+
+  int64_t size() const override;
+
+  std::vector<Tensor> get(const int64_t idx) const override;
+
+  /**
+   * Sets the version of the underlying dataset, invalidating the samples
+   * cached with other versions.
+   */
+  void setVersion(int64_t version);
+
+  /**
+   * @return The number of reads served from memory, from disk, and from the
+   * underlying dataset.
+   */
+  int64_t memoryHits() const;
+  int64_t diskHits() const;
+  int64_t misses() const;
+
+ private:
+  struct MemoryEntry {
+    int64_t version;
+    std::vector<Tensor> sample;
+  };
+  struct DiskEntry {
+    int64_t version{0};
+    int64_t blobIdx{-1};
+  };
+
+  std::shared_ptr<const Dataset> dataset_;
+  std::atomic<int64_t> version_;
+  int64_t memoryCapacity_;
+
+  mutable std::mutex memoryMutex_;
+  mutable detail::LRUCache<int64_t, MemoryEntry> memory_;
+
+  std::unique_ptr<FileBlobDataset> disk_;
+  // blob reads are concurrent, adds are exclusive
+  mutable std::shared_mutex diskMutex_;
+  mutable std::unordered_map<int64_t, DiskEntry> diskEntries_;
+
+  mutable std::atomic<int64_t> memoryHits_{0};
+  mutable std::atomic<int64_t> diskHits_{0};
+  mutable std::atomic<int64_t> misses_{0};
+};
+
+} // namespace fl
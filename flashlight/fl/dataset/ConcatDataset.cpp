@@ -28,13 +28,26 @@ std::vector<Tensor> ConcatDataset::get(const int64_t idx) const {
   checkIndexBounds(idx);
 
   // get sample from correct dataset
-  int64_t datasetidx =
-      std::upper_bound(
-          cumulativedatasetsizes_.begin(), cumulativedatasetsizes_.end(), idx) -
-      cumulativedatasetsizes_.begin() - 1;
+  const auto datasetidx = getDatasetIndex(idx);
   return datasets_[datasetidx]->get(idx - cumulativedatasetsizes_[datasetidx]);
 }
 
+std::future<std::vector<Tensor>> ConcatDataset::getAsync(
+    const int64_t idx) const {
+  checkIndexBounds(idx);
+  const auto datasetidx = getDatasetIndex(idx);
+  return datasets_[datasetidx]->getAsync(
+      idx - cumulativedatasetsizes_[datasetidx]);
+}
+
+int64_t ConcatDataset::getDatasetIndex(const int64_t idx) const {
+  return std::upper_bound(
+             cumulativedatasetsizes_.begin(),
+             cumulativedatasetsizes_.end(),
+             idx) -
+      cumulativedatasetsizes_.begin() - 1;
+}
+
 int64_t ConcatDataset::size() const {
   return size_;
 }
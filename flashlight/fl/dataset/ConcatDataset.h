@@ -47,7 +47,12 @@ class ConcatDataset : public Dataset {
 
   std::vector<Tensor> get(const int64_t idx) const override;
 
+  std::future<std::vector<Tensor>> getAsync(const int64_t idx) const override;
+
  private:
+  // the index of the dataset holding a sample
+  int64_t getDatasetIndex(const int64_t idx) const;
+
   std::vector<std::shared_ptr<const Dataset>> datasets_;
   std::vector<int64_t> cumulativedatasetsizes_;
   int64_t size_;
@@ -8,7 +8,9 @@
 #pragma once
 
 #include <cstring>
+#include <exception>
 #include <functional>
+#include <future>
 #include <memory>
 #include <vector>
 
@@ -65,6 +67,43 @@ class Dataset {
    */
   virtual std::vector<Tensor> get(const int64_t idx) const = 0;
 
+  /**
+   * Fetches a sample asynchronously, such that several fetches, e.g. those of
+   * the samples of a batch, can be in flight at once. The default fetches the
+   * sample with `get` on the calling thread; datasets which can overlap
+   * fetches, e.g. I/O bound ones, override it, and wrappers forward it to the
+   * datasets they wrap, deferring their own work to the `get()` of the future.
+   *
+   * @param[in] idx Index of the sample in the dataset. Must be in [0, size()).
+   * @return A future of `get(idx)`, which holds its exception if it throws.
+   */
+  virtual std::future<std::vector<Tensor>> getAsync(const int64_t idx) const {
+    std::promise<std::vector<Tensor>> sample;
+    try {
+      sample.set_value(get(idx));
+    } catch (...) {
+      sample.set_exception(std::current_exception());
+    }
+    return sample.get_future();
+  }
+
+  /**
+   * Fetches several samples asynchronously: all fetches are started before
+   * any is waited for. The default calls `getAsync` for each index.
+   *
+   * @param[in] indices Indices of samples in the dataset.
+   * @return The futures of the samples, in the order of `indices`.
+   */
+  virtual std::vector<std::future<std::vector<Tensor>>> getBatchAsync(
+      const std::vector<int64_t>& indices) const {
+    std::vector<std::future<std::vector<Tensor>>> samples;
+    samples.reserve(indices.size());
+    for (const auto idx : indices) {
+      samples.push_back(getAsync(idx));
+    }
+    return samples;
+  }
+
   virtual ~Dataset() = default;
 
   // Setup iterators
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/dataset/DatasetProfiler.h"
+
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+#include "flashlight/fl/common/Histogram.h"
+
+namespace fl {
+
+namespace {
+
+// the innermost range of the thread
+thread_local DatasetProfileRange* currentRange = nullptr;
+
+double secondsSince(DatasetProfiler::Clock::time_point start) {
+  return std::chrono::duration<double>(DatasetProfiler::Clock::now() - start)
+      .count();
+}
+
+} // namespace
+
+DatasetProfiler& DatasetProfiler::getInstance() {
+  static DatasetProfiler instance;
+  return instance;
+}
+
+void DatasetProfiler::enable() {
+  clear();
+  enabled_ = true;
+}
+
+void DatasetProfiler::disable() {
+  enabled_ = false;
+}
+
+bool DatasetProfiler::isEnabled() const {
+  return enabled_;
+}
+
+void DatasetProfiler::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stages_.clear();
+  lastReport_ = Clock::now();
+}
+
+void DatasetProfiler::setPeriodicReport(
+    double intervalSeconds,
+    ReportFunction reporter) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  reportInterval_ = reporter ? intervalSeconds : 0;
+  reporter_ = std::move(reporter);
+  lastReport_ = Clock::now();
+}
+
+void DatasetProfiler::recordCall(
+    const std::string& stage,
+    double seconds,
+    double selfSeconds) {
+  if (!enabled_) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto& stats = stages_[stage];
+  ++stats.calls;
+  stats.totalSeconds += seconds;
+  stats.selfSeconds += selfSeconds;
+  stats.latenciesUs.push_back(static_cast<size_t>(seconds * 1e6));
+  getStageMetrics(stage).calls->observe(seconds);
+  maybeReport(lock);
+}
+
+void DatasetProfiler::recordWait(const std::string& stage, double seconds) {
+  if (!enabled_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& stats = stages_[stage];
+  ++stats.waits;
+  stats.waitSeconds += seconds;
+  getStageMetrics(stage).waitSeconds->inc(seconds);
+}
+
+void DatasetProfiler::recordQueueOccupancy(
+    const std::string& stage,
+    size_t occupancy) {
+  if (!enabled_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  stages_[stage].queueOccupancy.push_back(occupancy);
+}
+
+DatasetProfiler::StageMetrics& DatasetProfiler::getStageMetrics(
+    const std::string& stage) {
+  auto it = stageMetrics_.find(stage);
+  if (it == stageMetrics_.end()) {
+    auto& registry = MetricsRegistry::getInstance();
+    const MetricLabels labels = {{"stage", stage}};
+    StageMetrics metrics{
+        &registry.histogram(
+            "fl_dataset_stage_seconds",
+            "Latency of the get calls of a data pipeline stage",
+            HistogramMetric::exponentialBounds(1e-5, 4, 10),
+            labels),
+        &registry.counter(
+            "fl_dataset_wait_seconds_total",
+            "Time the consumer of a data pipeline stage waited for samples",
+            labels)};
+    it = stageMetrics_.emplace(stage, metrics).first;
+  }
+  return it->second;
+}
+
+void DatasetProfiler::maybeReport(std::unique_lock<std::mutex>& lock) {
+  if (reportInterval_ <= 0 || secondsSince(lastReport_) < reportInterval_) {
+    lock.unlock();
+    return;
+  }
+  auto report = summaryLocked(10);
+  auto reporter = reporter_;
+  stages_.clear();
+  lastReport_ = Clock::now();
+  // the reporter may use the profiler
+  lock.unlock();
+  reporter(report);
+}
+
+std::map<std::string, DatasetStageStats> DatasetProfiler::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stages_;
+}
+
+std::string DatasetProfiler::summary(size_t numBuckets /* = 10 */) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return summaryLocked(numBuckets);
+}
+
+std::string DatasetProfiler::summaryLocked(size_t numBuckets) const {
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(3);
+  for (const auto& [stage, stats] : stages_) {
+    ss << stage << ": " << stats.calls << " calls, total "
+       << stats.totalSeconds * 1e3 << " ms, self " << stats.selfSeconds * 1e3
+       << " ms";
+    if (stats.waits > 0) {
+      ss << ", consumer waited " << stats.waits << " times for "
+         << stats.waitSeconds * 1e3 << " ms";
+    }
+    if (!stats.queueOccupancy.empty()) {
+      double occupancy = 0;
+      for (auto size : stats.queueOccupancy) {
+        occupancy += size;
+      }
+      ss << ", mean queue occupancy "
+         << occupancy / stats.queueOccupancy.size();
+    }
+    ss << "\n";
+    if (!stats.latenciesUs.empty()) {
+      ss << "latency (us) "
+         << FixedBucketSizeHistogram<size_t>(
+                stats.latenciesUs.begin(),
+                stats.latenciesUs.end(),
+                numBuckets)
+                .prettyString(50, shortFormatCount, shortFormatCount);
+    }
+  }
+  return ss.str();
+}
+
+DatasetProfileRange::DatasetProfileRange(const char* stage)
+    : stage_(stage), enabled_(DatasetProfiler::getInstance().isEnabled()) {
+  if (!enabled_) {
+    return;
+  }
+  parent_ = currentRange;
+  currentRange = this;
+  start_ = DatasetProfiler::Clock::now();
+}
+
+DatasetProfileRange::~DatasetProfileRange() {
+  if (!enabled_) {
+    return;
+  }
+  const double seconds = secondsSince(start_);
+  currentRange = parent_;
+  if (parent_) {
+    parent_->childSeconds_ += seconds;
+  }
+  DatasetProfiler::getInstance().recordCall(
+      stage_, seconds, seconds - childSeconds_);
+}
+
+} // namespace fl
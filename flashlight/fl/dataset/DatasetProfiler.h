@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "flashlight/fl/common/Metrics.h"
+
+namespace fl {
+
+/**
+ * The statistics of a stage of a data pipeline, e.g. all the
+ * `TransformDataset`s, as recorded by the `DatasetProfiler`.
+ */
+struct DatasetStageStats {
+  /// The number of `get` calls.
+  size_t calls = 0;
+  /// The time spent in `get`, including the stages it calls.
+  double totalSeconds = 0;
+  /// The time spent in `get`, excluding the stages it calls on the same
+  /// thread.
+  double selfSeconds = 0;
+  /// The latency of each call, in microseconds.
+  std::vector<size_t> latenciesUs;
+  /// The number of times the consumer waited for a sample, and for how long.
+  size_t waits = 0;
+  double waitSeconds = 0;
+  /// The number of samples ready in a prefetch queue at each call.
+  std::vector<size_t> queueOccupancy;
+};
+
+/**
+ * A process-wide profiler of data pipelines, to find the stage which makes
+ * training input-bound. Datasets record their `get` calls with a
+ * `DatasetProfileRange` when it is enabled, and prefetching datasets also
+ * record the time the consumer spent blocked waiting for samples and the
+ * occupancy of their queues. Stages are named after their dataset class.
+ * Calls and waits are also exported to the `MetricsRegistry`, as
+ * `fl_dataset_stage_seconds` and `fl_dataset_wait_seconds_total`, labelled by
+ * stage.
+ *
+ * Example:
+  \code{.cpp}
+  auto& profiler = DatasetProfiler::getInstance();
+  profiler.enable();
+  // log the statistics of the last minute, every minute
+  profiler.setPeriodicReport(
+      60, [](const std::string& report) { FL_LOG(fl::INFO) << report; });
+  for (auto& batch : *trainset) {
+    // train
+  }
+  std::cout << profiler.summary();
+  \endcode
+ */
+class DatasetProfiler {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using ReportFunction = std::function<void(const std::string&)>;
+
+  static DatasetProfiler& getInstance();
+
+  /**
+   * Starts recording, discarding the previous statistics.
+   */
+  void enable();
+  void disable();
+  bool isEnabled() const;
+
+  /**
+   * Discards the statistics recorded so far.
+   */
+  void clear();
+
+  /**
+   * Calls `reporter` with the summary of the statistics every
+   * `intervalSeconds`, then clears them. The report is made by the thread
+   * recording a call once the interval elapsed. A non-positive interval stops
+   * the reports.
+   */
+  void setPeriodicReport(double intervalSeconds, ReportFunction reporter);
+
+  void recordCall(const std::string& stage, double seconds, double selfSeconds);
+  void recordWait(const std::string& stage, double seconds);
+  void recordQueueOccupancy(const std::string& stage, size_t occupancy);
+
+  /**
+   * @return The statistics of each stage.
+   */
+  std::map<std::string, DatasetStageStats> stats() const;
+
+  /**
+   * @return A report of the statistics of each stage, with a histogram of
+   * latencies of `numBuckets` buckets.
+   */
+  std::string summary(size_t numBuckets = 10) const;
+
+ private:
+  DatasetProfiler() = default;
+
+  std::string summaryLocked(size_t numBuckets) const;
+  // reports if the interval elapsed, assumes `mutex_` is held, and returns it
+  // unlocked
+  void maybeReport(std::unique_lock<std::mutex>& lock);
+
+  // the exported metrics of a stage, which outlive the reports
+  struct StageMetrics {
+    HistogramMetric* calls;
+    CounterMetric* waitSeconds;
+  };
+  // assumes `mutex_` is held
+  StageMetrics& getStageMetrics(const std::string& stage);
+
+  std::atomic<bool> enabled_{false};
+  mutable std::mutex mutex_;
+  std::map<std::string, DatasetStageStats> stages_;
+  std::map<std::string, StageMetrics> stageMetrics_;
+  double reportInterval_{0};
+  ReportFunction reporter_;
+  Clock::time_point lastReport_;
+};
+
+/**
+ * Records a `get` call of a pipeline stage in the `DatasetProfiler` for the
+ * duration of its scope, if the profiler is enabled. Nested ranges on the
+ * same thread are excluded from the self time of the enclosing one.
+ *
+ * Example:
+ * \code
+   std::vector<Tensor> MyDataset::get(const int64_t idx) const {
+     DatasetProfileRange range("MyDataset");
+     // ...
+   }
+ * \endcode
+ */
+class DatasetProfileRange {
+  const char* stage_;
+  const bool enabled_;
+  DatasetProfiler::Clock::time_point start_;
+  DatasetProfileRange* parent_{nullptr};
+  double childSeconds_{0};
+
+ public:
+  explicit DatasetProfileRange(const char* stage);
+  ~DatasetProfileRange();
+
+  // no copy/move
+  DatasetProfileRange(const DatasetProfileRange&) = delete;
+  DatasetProfileRange(DatasetProfileRange&&) = delete;
+  DatasetProfileRange& operator=(const DatasetProfileRange&) = delete;
+  DatasetProfileRange& operator=(DatasetProfileRange&&) = delete;
+};
+
+} // namespace fl
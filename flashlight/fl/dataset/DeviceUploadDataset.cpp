@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/dataset/DeviceUploadDataset.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "flashlight/fl/dataset/DatasetProfiler.h"
+#include "flashlight/fl/runtime/DeviceManager.h"
+#include "flashlight/fl/runtime/Tracer.h"
+#include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Profile.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+namespace {
+
+// the number of returned samples whose host buffers are kept, to free them
+// without waiting on uploads still in flight
+constexpr size_t kMaxRetired = 8;
+
+} // namespace
+
+DeviceUploadDataset::HostSample::~HostSample() {
+  if (uploaded_) {
+    uploaded_->sync();
+  }
+  for (auto& buffer : buffers_) {
+    fl::freePinnedHost(buffer.data);
+  }
+}
+
+void* DeviceUploadDataset::HostSample::add(const Shape& shape, dtype type) {
+  const size_t bytes = shape.elements() * fl::getTypeSize(type);
+  buffers_.push_back({shape, type, bytes, fl::allocPinnedHost(bytes)});
+  return buffers_.back().data;
+}
+
+size_t DeviceUploadDataset::HostSample::size() const {
+  return buffers_.size();
+}
+
+DeviceUploadDataset::DeviceUploadDataset(
+    LoadFunction load,
+    int64_t size,
+    int64_t numThreads,
+    int64_t prefetchSize /* = 2 */,
+    ThreadAffinityPolicy affinity /* = ThreadAffinityPolicy::None */)
+    : load_(std::move(load)),
+      size_(size),
+      prefetchSize_(prefetchSize),
+      curIdx_(-1) {
+  if (!load_) {
+    throw std::invalid_argument(
+        "DeviceUploadDataset::DeviceUploadDataset - null load function");
+  }
+  if (size_ < 0) {
+    throw std::invalid_argument(
+        "DeviceUploadDataset::DeviceUploadDataset - negative size");
+  }
+  if (!(numThreads > 0 && prefetchSize_ > 0) &&
+      !(numThreads == 0 && prefetchSize_ == 0)) {
+    throw std::invalid_argument(
+        "DeviceUploadDataset::DeviceUploadDataset - invalid numThreads or "
+        "prefetchSize");
+  }
+  if (numThreads > 0) {
+    auto deviceId = fl::getDevice();
+    threadPool_ = std::make_unique<ThreadPool>(
+        numThreads, [deviceId, affinity](int threadId) {
+          fl::setDevice(deviceId);
+          // buffers are allocated on the workers, so follow their memory
+          // policy
+          setCallingThreadAffinity(affinity);
+          Tracer::getInstance().setThreadName(
+              "DeviceUploadDataset worker " + std::to_string(threadId));
+        });
+  }
+}
+
+DeviceUploadDataset::~DeviceUploadDataset() {
+  // the workers may still be loading samples
+  threadPool_.reset();
+}
+
+const Stream& DeviceUploadDataset::getUploadStream(
+    const Stream& computeStream) const {
+  if (computeStream.type() != StreamType::CUDA) {
+    return computeStream;
+  }
+  std::call_once(uploadStreamOnce_, [this]() {
+    uploadStream_ = DeviceManager::getInstance().getStreamFromPool(
+        DeviceType::CUDA, StreamPriority::Low);
+  });
+  return *uploadStream_;
+}
+
+DeviceUploadDataset::Upload DeviceUploadDataset::load(int64_t idx) const {
+  FL_PROFILE_TRACE("DeviceUploadDataset::load");
+  Upload upload;
+  upload.sample = std::make_unique<HostSample>();
+  load_(idx, *upload.sample);
+
+  const Stream* uploadStream = nullptr;
+  for (const auto& buffer : upload.sample->buffers_) {
+    auto tensor = Tensor(buffer.shape, buffer.type);
+    const auto& computeStream = tensor.stream();
+    if (!uploadStream) {
+      uploadStream = &getUploadStream(computeStream);
+    }
+    if (uploadStream != &computeStream) {
+      // the new memory may still be used by earlier computations
+      uploadStream->relativeSync(computeStream);
+    }
+    if (buffer.bytes > 0) {
+      uploadStream->copyAsync(tensor.device<void>(), buffer.data, buffer.bytes);
+      tensor.unlock();
+    }
+    upload.tensors.push_back(std::move(tensor));
+  }
+  if (uploadStream) {
+    upload.sample->uploaded_ = uploadStream->recordEvent();
+  }
+  return upload;
+}
+
+void DeviceUploadDataset::retire(std::unique_ptr<HostSample> sample) const {
+  retired_.push_back(std::move(sample));
+  while (!retired_.empty() &&
+         (retired_.size() > kMaxRetired || !retired_.front()->uploaded_ ||
+          retired_.front()->uploaded_->isReady())) {
+    retired_.pop_front();
+  }
+}
+
+std::vector<Tensor> DeviceUploadDataset::get(const int64_t idx) const {
+  checkIndexBounds(idx);
+  DatasetProfileRange range("DeviceUploadDataset");
+
+  Upload upload;
+  if (!threadPool_) {
+    upload = load(idx);
+  } else {
+    // remove from cache (if necessary)
+    while (!prefetchCache_.empty() && idx != curIdx_) {
+      prefetchCache_.pop();
+      ++curIdx_;
+    }
+
+    // add to cache (if necessary)
+    while (static_cast<int64_t>(prefetchCache_.size()) < prefetchSize_) {
+      const auto fetchIdx = idx + static_cast<int64_t>(prefetchCache_.size());
+      if (fetchIdx >= size()) {
+        break;
+      }
+      prefetchCache_.emplace(
+          threadPool_->enqueue([this, fetchIdx]() { return load(fetchIdx); }));
+    }
+
+    auto& profiler = DatasetProfiler::getInstance();
+    if (profiler.isEnabled() &&
+        prefetchCache_.front().wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready) {
+      const auto start = DatasetProfiler::Clock::now();
+      prefetchCache_.front().wait();
+      profiler.recordWait(
+          "DeviceUploadDataset",
+          std::chrono::duration<double>(DatasetProfiler::Clock::now() - start)
+              .count());
+    }
+    upload = prefetchCache_.front().get();
+    prefetchCache_.pop();
+    curIdx_ = idx + 1;
+  }
+
+  // computations on the tensors wait for the upload, without blocking
+  if (upload.sample->uploaded_) {
+    for (const auto& tensor : upload.tensors) {
+      tensor.stream().relativeSync(*upload.sample->uploaded_);
+    }
+  }
+  retire(std::move(upload.sample));
+  return std::move(upload.tensors);
+}
+
+int64_t DeviceUploadDataset::size() const {
+  return size_;
+}
+
+} // namespace fl
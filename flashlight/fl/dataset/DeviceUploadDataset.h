@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+#include "flashlight/fl/common/threadpool/ThreadPool.h"
+#include "flashlight/fl/dataset/Dataset.h"
+#include "flashlight/fl/runtime/Event.h"
+#include "flashlight/fl/runtime/Stream.h"
+#include "flashlight/fl/runtime/ThreadAffinity.h"
+#include "flashlight/fl/tensor/Shape.h"
+#include "flashlight/fl/tensor/Types.h"
+
+namespace fl {
+
+/**
+ * A dataset whose samples, e.g. batches, are built in pinned host memory by a
+ * user-provided function on worker threads, uploaded to the device
+ * asynchronously on a dedicated stream, and returned as device tensors whose
+ * streams wait for the upload without blocking the host. Samples are
+ * prefetched in advance for sequential access as with `PrefetchDataset`, such
+ * that, with the default of two samples, the upload of the next batch overlaps
+ * the computations on the current one.
+ *
+ * Unlike a `PrefetchDataset` of a dataset creating tensors from host data,
+ * the uploads neither wait for nor delay the computations on the compute
+ * stream.
+ *
+ * Example:
+  \code{.cpp}
+  auto load = [](int64_t idx, DeviceUploadDataset::HostSample& sample) {
+    float* input = sample.add<float>({80, 1000});
+    int* target = sample.add<int>({100});
+    // ... decode batch idx into input and target
+  };
+  DeviceUploadDataset ds(load, numBatches, 4);
+  for (auto& batch : ds) {
+    // batch[0] and batch[1] are device tensors
+  }
+  \endcode
+ */
+class DeviceUploadDataset : public Dataset {
+ public:
+  /**
+   * The tensors of a sample in pinned host memory, see `fl::allocPinnedHost`,
+   * which a `LoadFunction` adds and fills.
+   */
+  class HostSample {
+   public:
+    HostSample() = default;
+    ~HostSample();
+
+    // no copy/move
+    HostSample(const HostSample&) = delete;
+    HostSample(HostSample&&) = delete;
+    HostSample& operator=(const HostSample&) = delete;
+    HostSample& operator=(HostSample&&) = delete;
+
+    /**
+     * Adds a tensor to the sample.
+     *
+     * @param[in] shape the shape of the tensor
+     * @param[in] type the type of the tensor
+     * @return a buffer of the elements of the tensor in column-major order, to
+     * be filled by the caller
+     */
+    void* add(const Shape& shape, dtype type);
+
+    /**
+     * Adds a tensor of elements of type `T` to the sample.
+     */
+    template <typename T>
+    T* add(const Shape& shape) {
+      return static_cast<T*>(add(shape, dtype_traits<T>::fl_type));
+    }
+
+    /**
+     * @return the number of tensors of the sample
+     */
+    size_t size() const;
+
+   private:
+    friend class DeviceUploadDataset;
+
+    struct Buffer {
+      Shape shape;
+      dtype type;
+      size_t bytes;
+      void* data;
+    };
+
+    std::vector<Buffer> buffers_;
+    // marks the end of the upload of the buffers, which can be freed after it
+    std::unique_ptr<Event> uploaded_;
+  };
+
+  /**
+   * Fills the sample of the given index.
+   */
+  using LoadFunction = std::function<void(int64_t, HostSample&)>;
+
+  /**
+   * Creates a `DeviceUploadDataset`.
+   * @param[in] load The function filling the host sample of an index, which is
+   * called on worker threads, so must be thread-safe
+   * @param[in] size The number of samples
+   * @param[in] numThreads Number of threads used by the threadpool
+   * @param[in] prefetchSize Number of samples to be prefetched and uploaded in
+   * advance
+   * @param[in] affinity How the threads are bound to cores and memory; with
+   * `ThreadAffinityPolicy::DeviceNumaNode`, the pinned buffers of samples are
+   * also allocated on the NUMA node of the device
+   */
+  DeviceUploadDataset(
+      LoadFunction load,
+      int64_t size,
+      int64_t numThreads,
+      int64_t prefetchSize = 2,
+      ThreadAffinityPolicy affinity = ThreadAffinityPolicy::None);
+
+  ~DeviceUploadDataset() override;
+
+  int64_t size() const override;
+
+  std::vector<Tensor> get(const int64_t idx) const override;
+
+ private:
+  struct Upload {
+    std::vector<Tensor> tensors;
+    std::unique_ptr<HostSample> sample;
+  };
+
+  // Loads a sample and enqueues its upload, on a worker thread
+  Upload load(int64_t idx) const;
+
+  // The stream uploads run on, given the stream of a device tensor
+  const Stream& getUploadStream(const Stream& computeStream) const;
+
+  // Frees the host samples whose uploads completed
+  void retire(std::unique_ptr<HostSample> sample) const;
+
+  LoadFunction load_;
+  int64_t size_, prefetchSize_;
+  mutable std::once_flag uploadStreamOnce_;
+  mutable std::shared_ptr<Stream> uploadStream_;
+  // state variables
+  mutable std::queue<std::future<Upload>> prefetchCache_;
+  mutable int64_t curIdx_;
+  mutable std::deque<std::unique_ptr<HostSample>> retired_;
+  std::unique_ptr<ThreadPool> threadPool_;
+};
+
+} // namespace fl
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/dataset/DynamicBatchSampler.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "flashlight/fl/dataset/ResampleDataset.h"
+
+namespace fl {
+
+DynamicBatchSampler::DynamicBatchSampler(
+    std::vector<float> sizes,
+    float maxSizePerBatch,
+    int64_t partition /* = 0 */,
+    int64_t numPartitions /* = 1 */,
+    bool shuffle /* = true */,
+    int64_t bucketSize /* = 0 */,
+    uint64_t seed /* = 0 */)
+    : sizes_(std::move(sizes)),
+      maxSizePerBatch_(maxSizePerBatch),
+      partition_(partition),
+      numPartitions_(numPartitions),
+      shuffle_(shuffle),
+      bucketSize_(bucketSize),
+      seed_(seed) {
+  if (numPartitions_ <= 0 || partition_ < 0 || partition_ >= numPartitions_) {
+    throw std::invalid_argument(
+        "[DynamicBatchSampler] invalid partition, numPartitions");
+  }
+  for (auto size : sizes_) {
+    if (size > maxSizePerBatch_) {
+      throw std::invalid_argument(
+          "[DynamicBatchSampler] sample of size " + std::to_string(size) +
+          " exceeds maxSizePerBatch " + std::to_string(maxSizePerBatch_));
+    }
+  }
+  setEpoch(0);
+}
+
+void DynamicBatchSampler::setEpoch(int64_t epoch) {
+  std::mt19937_64 rng(seed_ + epoch);
+  std::vector<int64_t> order(sizes_.size());
+  std::iota(order.begin(), order.end(), 0);
+  if (shuffle_) {
+    std::shuffle(order.begin(), order.end(), rng);
+  }
+
+  // sort the samples by decreasing size within buckets
+  const auto cmp = [this](int64_t lhs, int64_t rhs) {
+    return sizes_[lhs] > sizes_[rhs];
+  };
+  const size_t bucketSize = bucketSize_ > 0 ? bucketSize_ : order.size();
+  for (size_t start = 0; start < order.size(); start += bucketSize) {
+    const auto end = order.begin() + std::min(start + bucketSize, order.size());
+    std::stable_sort(order.begin() + start, end, cmp);
+  }
+
+  // pack consecutive samples while the padded size fits the budget
+  std::vector<std::pair<float, std::vector<int64_t>>> batches;
+  std::vector<int64_t> batch;
+  float maxSize = 0;
+  for (auto idx : order) {
+    const float newMax = std::max(maxSize, sizes_[idx]);
+    if (!batch.empty() && (batch.size() + 1) * newMax > maxSizePerBatch_) {
+      batches.emplace_back(batch.size() * maxSize, std::move(batch));
+      batch.clear();
+      maxSize = sizes_[idx];
+    } else {
+      maxSize = newMax;
+    }
+    batch.push_back(idx);
+  }
+  if (!batch.empty()) {
+    batches.emplace_back(batch.size() * maxSize, std::move(batch));
+  }
+
+  // steps of one batch per partition, of similar padded sizes
+  std::stable_sort(
+      batches.begin(), batches.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first > rhs.first;
+      });
+  std::vector<int64_t> steps(batches.size() / numPartitions_);
+  std::iota(steps.begin(), steps.end(), 0);
+  if (shuffle_) {
+    std::shuffle(steps.begin(), steps.end(), rng);
+  }
+  batches_.clear();
+  for (auto step : steps) {
+    batches_.push_back(
+        std::move(batches[step * numPartitions_ + partition_].second));
+  }
+}
+
+const std::vector<std::vector<int64_t>>& DynamicBatchSampler::batches() const {
+  return batches_;
+}
+
+double DynamicBatchSampler::paddingFraction() const {
+  double total = 0, padded = 0;
+  for (const auto& batch : batches_) {
+    float maxSize = 0;
+    for (auto idx : batch) {
+      total += sizes_[idx];
+      maxSize = std::max(maxSize, sizes_[idx]);
+    }
+    padded += static_cast<double>(batch.size()) * maxSize;
+  }
+  return padded > 0 ? 1 - total / padded : 0;
+}
+
+std::shared_ptr<BatchDataset> DynamicBatchSampler::makeBatchDataset(
+    std::shared_ptr<const Dataset> dataset,
+    const std::vector<Dataset::BatchFunction>& batchfns /* = {} */) const {
+  if (!dataset || dataset->size() != static_cast<int64_t>(sizes_.size())) {
+    throw std::invalid_argument(
+        "[DynamicBatchSampler::makeBatchDataset] null dataset or size "
+        "mismatch with the sample sizes");
+  }
+  if (batches_.empty()) {
+    throw std::invalid_argument(
+        "[DynamicBatchSampler::makeBatchDataset] no batches for the "
+        "partition");
+  }
+  std::vector<int64_t> indices, batchSizes;
+  for (const auto& batch : batches_) {
+    indices.insert(indices.end(), batch.begin(), batch.end());
+    batchSizes.push_back(batch.size());
+  }
+  return std::make_shared<BatchDataset>(
+      std::make_shared<ResampleDataset>(dataset, indices),
+      batchSizes,
+      batchfns);
+}
+
+} // namespace fl
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "flashlight/fl/dataset/BatchDataset.h"
+#include "flashlight/fl/dataset/Dataset.h"
+
+namespace fl {
+
+/**
+ * Forms batches of samples of variable size, e.g. frames or tokens, under a
+ * budget of padded size per batch: a batch of `n` samples of max size `m` has
+ * a padded size of `n * m <= maxSizePerBatch`.
+ *
+ * To limit padding, samples are sorted by size within buckets of
+ * `bucketSize` samples, taken from a random permutation of the dataset when
+ * shuffling, and batches are formed from consecutive sorted samples. For
+ * distributed training, batches are then sorted by padded size and dealt
+ * round-robin to partitions, such that every partition has the same number
+ * of batches, and the batches of a step are of similar size. The batches
+ * which don't fill a step on all partitions are dropped. With shuffling, the
+ * order of the steps is random.
+ *
+ * Example:
+  \code{.cpp}
+  std::vector<float> sizes;
+  for (int64_t i = 0; i < listDs->size(); ++i) {
+    sizes.push_back(listDs->getInputSize(i));
+  }
+  DynamicBatchSampler sampler(sizes, 40000, rank, worldSize);
+  for (int epoch = 0; epoch < nEpochs; ++epoch) {
+    sampler.setEpoch(epoch);
+    for (auto& batch : *sampler.makeBatchDataset(listDs, batchFns)) {
+      // do something
+    }
+  }
+  \endcode
+ */
+class DynamicBatchSampler {
+ public:
+  /**
+   * Creates a `DynamicBatchSampler`, with the batches of epoch 0.
+   * @param[in] sizes The size of each sample of the dataset.
+   * @param[in] maxSizePerBatch The maximum padded size of a batch.
+   * @param[in] partition The partition whose batches are sampled.
+   * @param[in] numPartitions The number of partitions, e.g. of ranks.
+   * @param[in] shuffle Whether the dataset and the batches are shuffled.
+   * @param[in] bucketSize The number of samples sorted by size together. If
+   * not positive, all samples are sorted together.
+   * @param[in] seed The seed of the shuffling, the same on all partitions.
+   */
+  DynamicBatchSampler(
+      std::vector<float> sizes,
+      float maxSizePerBatch,
+      int64_t partition = 0,
+      int64_t numPartitions = 1,
+      bool shuffle = true,
+      int64_t bucketSize = 0,
+      uint64_t seed = 0);
+
+  /**
+   * Samples the batches of an epoch, which differ between epochs when
+   * shuffling.
+   * @param[in] epoch The epoch.
+   */
+  void setEpoch(int64_t epoch);
+
+  /**
+   * @return The sample indices of the batches of the partition.
+   */
+  const std::vector<std::vector<int64_t>>& batches() const;
+
+  /**
+   * @return The fraction of the padded size of the batches of the partition
+   * which is padding.
+   */
+  double paddingFraction() const;
+
+  /**
+   * Batches a dataset, whose samples have the given sizes, with the batches
+   * of the current epoch.
+   * @param[in] dataset The dataset.
+   * @param[in] batchfns The batch functions, as for a `BatchDataset`.
+   */
+  std::shared_ptr<BatchDataset> makeBatchDataset(
+      std::shared_ptr<const Dataset> dataset,
+      const std::vector<Dataset::BatchFunction>& batchfns = {}) const;
+
+ private:
+  std::vector<float> sizes_;
+  float maxSizePerBatch_;
+  int64_t partition_, numPartitions_;
+  bool shuffle_;
+  int64_t bucketSize_;
+  uint64_t seed_;
+  std::vector<std::vector<int64_t>> batches_;
+};
+
+} // namespace fl
@@ -7,6 +7,14 @@
 
 #include "flashlight/fl/dataset/FileBlobDataset.h"
 
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace fl {
 
 FileBlobDataset::FileBlobDataset(
@@ -14,54 +22,20 @@ FileBlobDataset::FileBlobDataset(
     bool rw,
     bool truncate)
     : name_(name) {
-  mode_ = (rw ? std::ios_base::in | std::ios_base::out : std::ios_base::in);
-  {
-    std::ofstream fs(name_, (truncate ? mode_ | std::ios_base::trunc : mode_));
-    if (!fs.is_open()) {
-      throw std::runtime_error("could not open file " + name);
-    }
+  int flags = rw ? O_RDWR | O_CREAT : O_RDONLY;
+  if (rw && truncate) {
+    flags |= O_TRUNC;
   }
-  readIndex();
-}
-
-std::shared_ptr<std::fstream> FileBlobDataset::getStream() const {
-  static thread_local std::shared_ptr<
-      std::unordered_map<uintptr_t, std::shared_ptr<std::fstream>>>
-      threadFileHandles = std::make_shared<
-          std::unordered_map<uintptr_t, std::shared_ptr<std::fstream>>>();
-
-  // Get a per-thread file handle.
-  auto keyval = threadFileHandles->find(reinterpret_cast<uintptr_t>(this));
-  if (keyval == threadFileHandles->end()) {
-    auto fs = std::make_shared<std::fstream>();
-    fs->exceptions(
-        std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
-    fs->open(name_, mode_);
-    threadFileHandles->insert({reinterpret_cast<uintptr_t>(this), fs});
-    // Link threadFileHandles to the object
-    // so the file handle can be cleaned at destruction.
-    {
-      std::lock_guard<std::mutex> lock(afhmutex_);
-      auto i = allFileHandles_.begin();
-      bool match = false;
-      while (i != std::end(allFileHandles_)) {
-        auto ptr = i->lock();
-        if (ptr) {
-          if (threadFileHandles == ptr) {
-            match = true;
-          }
-          ++i;
-        } else {
-          i = allFileHandles_.erase(i);
-        }
-      }
-      if (!match) {
-        allFileHandles_.push_back(threadFileHandles);
-      }
-    }
-    return fs;
-  } else {
-    return keyval->second;
+  fd_ = ::open(name_.c_str(), flags | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    throw std::runtime_error(
+        "could not open file " + name + ": " + std::strerror(errno));
+  }
+  try {
+    readIndex();
+  } catch (...) {
+    ::close(fd_);
+    throw;
   }
 }
 
@@ -69,38 +43,61 @@ int64_t FileBlobDataset::writeData(
     int64_t offset,
     const char* data,
     int64_t size) const {
-  auto fs = getStream();
-  fs->seekp(offset, std::ios_base::beg);
-  fs->write(data, size);
-  return fs->tellp() - offset;
+  int64_t written = 0;
+  while (written < size) {
+    const auto n =
+        ::pwrite(fd_, data + written, size - written, offset + written);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(
+          "FileBlobDataset::writeData - could not write to " + name_ + ": " +
+          std::strerror(errno));
+    }
+    written += n;
+  }
+  return written;
 }
 
 int64_t FileBlobDataset::readData(int64_t offset, char* data, int64_t size)
     const {
-  auto fs = getStream();
-  fs->seekg(offset, std::ios_base::beg);
-  fs->read(data, size);
-  return fs->tellg() - offset;
+  int64_t read = 0;
+  while (read < size) {
+    const auto n = ::pread(fd_, data + read, size - read, offset + read);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(
+          "FileBlobDataset::readData - could not read from " + name_ + ": " +
+          std::strerror(errno));
+    }
+    if (n == 0) {
+      throw std::runtime_error(
+          "FileBlobDataset::readData - unexpected end of file " + name_);
+    }
+    read += n;
+  }
+  return read;
 }
 
 void FileBlobDataset::flushData() {
-  auto fs = getStream();
-  fs->flush();
+  // writes are unbuffered, and visible to readers once pwrite returns
 }
 
 bool FileBlobDataset::isEmptyData() const {
-  auto fs = getStream();
-  fs->seekg(0, std::ios_base::end);
-  return (fs->tellg() == 0);
+  struct stat st;
+  if (::fstat(fd_, &st) != 0) {
+    throw std::runtime_error(
+        "FileBlobDataset::isEmptyData - could not stat file " + name_);
+  }
+  return st.st_size == 0;
 }
 
 FileBlobDataset::~FileBlobDataset() {
-  std::lock_guard<std::mutex> lock(afhmutex_);
-  for (auto& weakFileHandles : allFileHandles_) {
-    auto fileHandles = weakFileHandles.lock();
-    if (fileHandles) {
-      fileHandles->erase(reinterpret_cast<uintptr_t>(this));
-    }
+  if (fd_ >= 0) {
+    ::close(fd_);
   }
 }
 
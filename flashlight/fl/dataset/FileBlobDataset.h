@@ -9,8 +9,7 @@
 
 #include "flashlight/fl/dataset/BlobDataset.h"
 
-#include <fstream>
-#include <mutex>
+#include <string>
 
 namespace fl {
 
@@ -20,6 +19,8 @@ namespace fl {
  * As the arrays are stored on disk, sequential access will be the most
  * efficient.
  *
+ * Reads and writes are positional (`pread`/`pwrite`) on a single file
+ * descriptor shared by all threads, so concurrent reads take no lock.
  */
 class FileBlobDataset : public BlobDataset {
  public:
@@ -48,13 +49,7 @@ class FileBlobDataset : public BlobDataset {
 
  private:
   std::string name_;
-  std::ios_base::openmode mode_;
-  std::shared_ptr<std::fstream> getStream() const;
-
-  mutable std::vector<std::weak_ptr<
-      std::unordered_map<uintptr_t, std::shared_ptr<std::fstream>>>>
-      allFileHandles_;
-  mutable std::mutex afhmutex_;
+  int fd_{-1};
 };
 
 } // namespace fl
@@ -6,6 +6,7 @@
  */
 
 #include <cstring>
+#include <utility>
 
 #include "flashlight/fl/dataset/MemoryBlobDataset.h"
 
@@ -15,6 +16,11 @@ MemoryBlobDataset::MemoryBlobDataset() {
   readIndex();
 }
 
+MemoryBlobDataset::MemoryBlobDataset(std::vector<char> data)
+    : data_(std::move(data)) {
+  readIndex();
+}
+
 int64_t MemoryBlobDataset::writeData(
     int64_t offset,
     const char* data,
@@ -28,6 +28,13 @@ class MemoryBlobDataset : public BlobDataset {
    */
   MemoryBlobDataset();
 
+  /**
+   * Creates a `MemoryBlobDataset` from the content of a blob, e.g. a blob file
+   * read in memory.
+   * @param[in] data The bytes of a blob.
+   */
+  explicit MemoryBlobDataset(std::vector<char> data);
+
   virtual ~MemoryBlobDataset() override = default;
 
  protected:
@@ -5,7 +5,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <future>
 #include <stdexcept>
+#include <utility>
 
 #include "flashlight/fl/dataset/MergeDataset.h"
 
@@ -35,6 +37,31 @@ std::vector<Tensor> MergeDataset::get(const int64_t idx) const {
   return result;
 }
 
+std::future<std::vector<Tensor>> MergeDataset::getAsync(
+    const int64_t idx) const {
+  checkIndexBounds(idx);
+
+  // the fetches of the merged datasets overlap
+  std::vector<std::future<std::vector<Tensor>>> parts;
+  for (auto dataset : datasets_) {
+    if (idx < dataset->size()) {
+      parts.push_back(dataset->getAsync(idx));
+    }
+  }
+  return std::async(
+      std::launch::deferred, [parts = std::move(parts)]() mutable {
+        std::vector<Tensor> result;
+        for (auto& part : parts) {
+          auto f = part.get();
+          result.insert(
+              result.end(),
+              std::make_move_iterator(f.begin()),
+              std::make_move_iterator(f.end()));
+        }
+        return result;
+      });
+}
+
 int64_t MergeDataset::size() const {
   return size_;
 }
@@ -53,6 +53,8 @@ class MergeDataset : public Dataset {
 
   std::vector<Tensor> get(const int64_t idx) const override;
 
+  std::future<std::vector<Tensor>> getAsync(const int64_t idx) const override;
+
  private:
   std::vector<std::shared_ptr<const Dataset>> datasets_;
   int64_t size_;
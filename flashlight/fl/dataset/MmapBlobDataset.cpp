@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/dataset/MmapBlobDataset.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fl {
+
+namespace {
+
+int toMadvise(MmapAdvice advice) {
+  switch (advice) {
+    case MmapAdvice::Sequential:
+      return MADV_SEQUENTIAL;
+    case MmapAdvice::Random:
+      return MADV_RANDOM;
+    default:
+      return MADV_NORMAL;
+  }
+}
+
+} // namespace
+
+MmapBlobDataset::MmapBlobDataset(
+    const std::string& name,
+    MmapAdvice advice /* = MmapAdvice::Normal */)
+    : name_(name) {
+  const int fd = ::open(name_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(
+        "MmapBlobDataset::MmapBlobDataset - could not open file " + name +
+        ": " + std::strerror(errno));
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error(
+        "MmapBlobDataset::MmapBlobDataset - could not stat file " + name);
+  }
+  size_ = st.st_size;
+  if (size_ > 0) {
+    void* data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error(
+          "MmapBlobDataset::MmapBlobDataset - could not map file " + name +
+          ": " + std::strerror(errno));
+    }
+    data_ = static_cast<char*>(data);
+  }
+  // the mapping stays valid after closing its file
+  ::close(fd);
+  advise(advice);
+  readIndex();
+}
+
+MmapBlobDataset::~MmapBlobDataset() {
+  if (data_) {
+    ::munmap(data_, size_);
+  }
+}
+
+std::vector<Tensor> MmapBlobDataset::get(const int64_t idx) const {
+  if (mappedHostTransforms_.empty()) {
+    return BlobDataset::get(idx);
+  }
+  std::vector<Tensor> sample;
+  const auto views = view(idx);
+  for (int i = 0; i < static_cast<int>(views.size()); ++i) {
+    const auto& v = views[i];
+    auto keyval = mappedHostTransforms_.find(i);
+    if (keyval != mappedHostTransforms_.end() && v.bytes > 0) {
+      sample.push_back(keyval->second(v.data, v.entry.dims, v.entry.type));
+    } else {
+      sample.push_back(readArray(v.entry, i));
+    }
+  }
+  return sample;
+}
+
+std::vector<BlobDatasetView> MmapBlobDataset::view(const int64_t idx) const {
+  std::vector<BlobDatasetView> views;
+  for (const auto& entry : getEntries(idx)) {
+    const int64_t bytes = fl::getTypeSize(entry.type) * entry.dims.elements();
+    views.push_back({entry, dataPtr(entry.offset, bytes), bytes});
+  }
+  return views;
+}
+
+void MmapBlobDataset::advise(MmapAdvice advice) const {
+  if (data_ && ::madvise(data_, size_, toMadvise(advice)) != 0) {
+    throw std::runtime_error(
+        "MmapBlobDataset::advise - madvise failed: " +
+        std::string(std::strerror(errno)));
+  }
+}
+
+void MmapBlobDataset::willNeed(const int64_t idx) const {
+  const auto views = view(idx);
+  if (views.empty()) {
+    return;
+  }
+  // the range of the sample, whose arrays are written contiguously
+  int64_t start = size_, end = 0;
+  for (const auto& v : views) {
+    if (v.bytes > 0) {
+      start = std::min(start, v.entry.offset);
+      end = std::max(end, v.entry.offset + v.bytes);
+    }
+  }
+  if (start >= end) {
+    return;
+  }
+  // madvise takes page-aligned addresses
+  const int64_t pageSize = ::sysconf(_SC_PAGESIZE);
+  start -= start % pageSize;
+  // the hint is advisory, so failures are ignored
+  ::madvise(data_ + start, end - start, MADV_WILLNEED);
+}
+
+void MmapBlobDataset::setMappedHostTransform(
+    int field,
+    MappedHostTransform func) {
+  mappedHostTransforms_[field] = std::move(func);
+}
+
+int64_t MmapBlobDataset::writeData(
+    int64_t /* offset */,
+    const char* /* data */,
+    int64_t /* size */) const {
+  throw std::logic_error(
+      "MmapBlobDataset::writeData - the dataset is read-only");
+}
+
+int64_t MmapBlobDataset::readData(int64_t offset, char* data, int64_t size)
+    const {
+  const auto* ptr = dataPtr(offset, size);
+  if (size > 0) {
+    std::memcpy(data, ptr, size);
+  }
+  return size;
+}
+
+const char* MmapBlobDataset::dataPtr(int64_t offset, int64_t size) const {
+  if (offset < 0 || size < 0 || offset + size > size_) {
+    throw std::out_of_range(
+        "MmapBlobDataset - read past the end of file " + name_);
+  }
+  return data_ + offset;
+}
+
+void MmapBlobDataset::flushData() {}
+
+bool MmapBlobDataset::isEmptyData() const {
+  return size_ == 0;
+}
+
+} // namespace fl
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "flashlight/fl/dataset/BlobDataset.h"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fl {
+
+/**
+ * The access pattern of a memory-mapped blob, given to the kernel as an
+ * `madvise` hint for its read-ahead.
+ */
+enum class MmapAdvice {
+  Normal,
+  Sequential,
+  Random,
+};
+
+/**
+ * A view of the raw data of an entry of a memory-mapped blob, valid as long as
+ * the dataset.
+ */
+struct BlobDatasetView {
+  BlobDatasetEntry entry;
+  const void* data;
+  int64_t bytes;
+};
+
+/**
+ * A read-only BlobDataset on a memory-mapped file, e.g. one written by a
+ * `FileBlobDataset`. Arrays are read from the page cache without read
+ * syscalls or intermediate buffers: they are copied to tensors directly from
+ * the mapping, and are accessible as zero-copy views with `view`.
+ *
+ * Mapped host transforms, see `setMappedHostTransform`, read the mapped bytes
+ * of a field in place. Host transforms set with `setHostTransform` may modify
+ * their buffer so are given a copy of it.
+ *
+ * Example:
+  \code{.cpp}
+  MmapBlobDataset blob("features.blob", MmapAdvice::Random);
+  blob.setMappedHostTransform(
+      0, [](const void* ptr, fl::Shape shape, fl::dtype type) {
+        // e.g. decode or normalize the data of field 0
+        return Tensor::fromBuffer(
+            shape, static_cast<const float*>(ptr), MemoryLocation::Host);
+      });
+  auto sample = blob.get(42);
+  \endcode
+ */
+class MmapBlobDataset : public BlobDataset {
+ public:
+  using MappedHostTransform =
+      std::function<Tensor(const void*, Shape, fl::dtype)>;
+
+  /**
+   * Creates a `MmapBlobDataset`, mapping a blob file.
+   * @param[in] name A blob file name.
+   * @param[in] advice The expected access pattern.
+   */
+  explicit MmapBlobDataset(
+      const std::string& name,
+      MmapAdvice advice = MmapAdvice::Normal);
+
+  virtual ~MmapBlobDataset() override;
+
+  std::vector<Tensor> get(const int64_t idx) const override;
+
+  /**
+   * Return views of the raw data of a sample in the mapping, without copies.
+   * @param[in] idx An index in the dataset.
+   */
+  std::vector<BlobDatasetView> view(const int64_t idx) const;
+
+  /**
+   * Change the expected access pattern of the blob.
+   * @param[in] advice The expected access pattern.
+   */
+  void advise(MmapAdvice advice) const;
+
+  /**
+   * Hint that a sample will be read soon, such that the kernel reads it ahead
+   * in the background, e.g. for the upcoming indices of a sampler.
+   * @param[in] idx An index in the dataset.
+   */
+  void willNeed(const int64_t idx) const;
+
+  /**
+   * Set a host transform on specified field, given the mapped bytes of its
+   * array, which it must not modify. Takes precedence over a transform set
+   * with `setHostTransform`.
+   * @param[in] field The field on which to apply the transform.
+   * @param[in] func The corresponding transform.
+   */
+  void setMappedHostTransform(int field, MappedHostTransform func);
+
+ protected:
+  int64_t writeData(int64_t offset, const char* data, int64_t size)
+      const override;
+  int64_t readData(int64_t offset, char* data, int64_t size) const override;
+  const char* dataPtr(int64_t offset, int64_t size) const override;
+  void flushData() override;
+  bool isEmptyData() const override;
+
+ private:
+  std::string name_;
+  char* data_{nullptr};
+  int64_t size_{0};
+  std::unordered_map<int, MappedHostTransform> mappedHostTransforms_;
+};
+
+} // namespace fl
@@ -5,19 +5,68 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <chrono>
+#include <condition_variable>
+#include <exception>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
 
+#include "flashlight/fl/common/BoundedQueue.h"
 #include "flashlight/fl/common/Serialization.h"
+#include "flashlight/fl/dataset/DatasetProfiler.h"
 #include "flashlight/fl/dataset/PrefetchDataset.h"
+#include "flashlight/fl/runtime/Tracer.h"
 #include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Profile.h"
 
 namespace fl {
 
+struct PrefetchDataset::Lookahead {
+  struct Sample {
+    std::vector<Tensor> tensors;
+    std::exception_ptr error;
+  };
+
+  struct Completed {
+    uint64_t generation = 0;
+    Sample sample;
+  };
+
+  std::vector<int64_t> indices;
+  bool completionOrder;
+  std::mutex mutex;
+  std::condition_variable completed;
+  // bumped when the prefetched samples are discarded, such that the tasks of
+  // discarded samples drop them
+  uint64_t generation = 0;
+  // the next index to read, and the next one to prefetch
+  int64_t next = 0;
+  int64_t nextFetch = 0;
+  // the completed samples by index
+  std::unordered_map<int64_t, Sample> samples;
+  // in completion order, the completed samples are handed off through a queue
+  // rather than `samples`, without taking `mutex`; the reader skips those of
+  // discarded generations
+  std::unique_ptr<BoundedQueue<Completed>> completionQueue;
+
+  // assumes `mutex` is held
+  void discard(int64_t idx) {
+    ++generation;
+    samples.clear();
+    next = idx;
+    nextFetch = idx;
+  }
+};
+
 PrefetchDataset::PrefetchDataset(
     std::shared_ptr<const Dataset> dataset,
     int64_t numThreads,
-    int64_t prefetchSize)
+    int64_t prefetchSize,
+    ThreadAffinityPolicy affinity /* = ThreadAffinityPolicy::None */)
     : dataset_(dataset),
       numThreads_(numThreads),
       prefetchSize_(prefetchSize),
@@ -33,12 +82,70 @@ PrefetchDataset::PrefetchDataset(
     auto deviceId = fl::getDevice();
     threadPool_ = std::make_unique<ThreadPool>(
         numThreads_,
-        [deviceId](int /* threadId */) { fl::setDevice(deviceId); });
+        [deviceId, affinity](int threadId) {
+          fl::setDevice(deviceId);
+          // the affinity is that of the device, once set
+          setCallingThreadAffinity(affinity);
+          Tracer::getInstance().setThreadName(
+              "PrefetchDataset worker " + std::to_string(threadId));
+        });
+  }
+}
+
+PrefetchDataset::PrefetchDataset(
+    std::shared_ptr<const Dataset> dataset,
+    int64_t numThreads,
+    int64_t prefetchSize,
+    std::vector<int64_t> indices,
+    bool completionOrder /* = false */,
+    ThreadAffinityPolicy affinity /* = ThreadAffinityPolicy::None */)
+    : PrefetchDataset(
+          std::move(dataset),
+          numThreads,
+          prefetchSize,
+          affinity) {
+  lookahead_ = std::make_shared<Lookahead>();
+  lookahead_->completionOrder = completionOrder;
+  if (completionOrder && numThreads_ > 0) {
+    // the samples in flight, and as many of discarded generations
+    lookahead_->completionQueue =
+        std::make_unique<BoundedQueue<Lookahead::Completed>>(
+            2 * prefetchSize_ + 1);
+  }
+  resample(std::move(indices));
+}
+
+PrefetchDataset::~PrefetchDataset() {
+  // tasks blocked on a full queue fail, such that the pool can be joined
+  if (lookahead_ && lookahead_->completionQueue) {
+    lookahead_->completionQueue->close();
+  }
+}
+
+void PrefetchDataset::resample(std::vector<int64_t> indices) {
+  if (!lookahead_) {
+    throw std::logic_error(
+        "PrefetchDataset::resample - the dataset wasn't created with indices");
   }
+  for (const auto index : indices) {
+    if (index < 0 || index >= dataset_->size()) {
+      throw std::out_of_range(
+          "PrefetchDataset::resample - index " + std::to_string(index) +
+          " out of range");
+    }
+  }
+  std::lock_guard<std::mutex> lock(lookahead_->mutex);
+  lookahead_->indices = std::move(indices);
+  lookahead_->discard(0);
 }
 
 std::vector<Tensor> PrefetchDataset::get(int64_t idx) const {
   checkIndexBounds(idx);
+  DatasetProfileRange range("PrefetchDataset");
+
+  if (lookahead_) {
+    return getLookahead(idx);
+  }
 
   if (numThreads_ == 0) {
     return dataset_->get(idx);
@@ -56,10 +163,39 @@ std::vector<Tensor> PrefetchDataset::get(int64_t idx) const {
     if (fetchIdx >= size()) {
       break;
     }
-    prefetchCache_.emplace(threadPool_->enqueue(
-        [this, fetchIdx]() { return this->dataset_->get(fetchIdx); }));
+    // the requested sample is fetched before the ones ahead of it
+    const auto priority =
+        fetchIdx == idx ? TaskPriority::High : TaskPriority::Normal;
+    prefetchCache_.emplace(threadPool_->enqueueWithPriority(
+        priority, [this, fetchIdx]() {
+          FL_PROFILE_TRACE("PrefetchDataset::get");
+          return this->dataset_->get(fetchIdx);
+        }));
   }
 
+  auto& profiler = DatasetProfiler::getInstance();
+  if (profiler.isEnabled()) {
+    const auto isReady = [](const std::future<std::vector<Tensor>>& sample) {
+      return sample.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready;
+    };
+    // the queue can't be iterated, so is rotated
+    size_t ready = 0;
+    for (size_t i = 0; i < prefetchCache_.size(); ++i) {
+      ready += isReady(prefetchCache_.front());
+      prefetchCache_.push(std::move(prefetchCache_.front()));
+      prefetchCache_.pop();
+    }
+    profiler.recordQueueOccupancy("PrefetchDataset", ready);
+    if (!isReady(prefetchCache_.front())) {
+      const auto start = DatasetProfiler::Clock::now();
+      prefetchCache_.front().wait();
+      profiler.recordWait(
+          "PrefetchDataset",
+          std::chrono::duration<double>(DatasetProfiler::Clock::now() - start)
+              .count());
+    }
+  }
   auto curSample = prefetchCache_.front().get();
 
   prefetchCache_.pop();
@@ -67,7 +203,117 @@ std::vector<Tensor> PrefetchDataset::get(int64_t idx) const {
   return curSample;
 }
 
+std::vector<Tensor> PrefetchDataset::getLookahead(int64_t idx) const {
+  auto& state = *lookahead_;
+  if (numThreads_ == 0) {
+    return dataset_->get(state.indices[idx]);
+  }
+
+  std::unique_lock<std::mutex> lock(state.mutex);
+  if (idx != state.next) {
+    state.discard(idx);
+  }
+  // keeps `prefetchSize_` samples which are being fetched or waiting to be
+  // read after the `end`-th one
+  const auto prefetch = [&](int64_t end) {
+    const int64_t numIndices = state.indices.size();
+    while (state.nextFetch < numIndices &&
+           state.nextFetch < end + prefetchSize_) {
+      const auto position = state.nextFetch++;
+      // the sample read next is fetched before the ones ahead of it
+      const auto priority =
+          position == end ? TaskPriority::High : TaskPriority::Normal;
+      threadPool_->enqueueWithPriority(
+          priority,
+          [lookahead = lookahead_,
+           dataset = dataset_,
+           generation = state.generation,
+           position,
+           index = state.indices[position]]() {
+            FL_PROFILE_TRACE("PrefetchDataset::get");
+            Lookahead::Sample sample;
+            try {
+              sample.tensors = dataset->get(index);
+            } catch (...) {
+              sample.error = std::current_exception();
+            }
+            if (lookahead->completionQueue) {
+              lookahead->completionQueue->push(
+                  Lookahead::Completed{generation, std::move(sample)});
+              return;
+            }
+            std::lock_guard<std::mutex> lock(lookahead->mutex);
+            if (lookahead->generation != generation) {
+              return;
+            }
+            lookahead->samples.emplace(position, std::move(sample));
+            lookahead->completed.notify_all();
+          });
+    }
+  };
+  prefetch(idx);
+
+  auto& profiler = DatasetProfiler::getInstance();
+  const auto recordWait = [&profiler](
+                              DatasetProfiler::Clock::time_point start) {
+    profiler.recordWait(
+        "PrefetchDataset",
+        std::chrono::duration<double>(DatasetProfiler::Clock::now() - start)
+            .count());
+  };
+  Lookahead::Sample sample;
+  if (state.completionQueue) {
+    const auto generation = state.generation;
+    lock.unlock();
+    auto& queue = *state.completionQueue;
+    if (profiler.isEnabled()) {
+      profiler.recordQueueOccupancy("PrefetchDataset", queue.size());
+    }
+    Lookahead::Completed completed;
+    bool wait = false;
+    const auto waitStart = DatasetProfiler::Clock::now();
+    // samples of discarded generations are dropped
+    do {
+      if (!queue.tryPop(completed)) {
+        wait = true;
+        if (!queue.pop(completed)) {
+          throw std::runtime_error(
+              "PrefetchDataset::get - the dataset is being destroyed");
+        }
+      }
+    } while (completed.generation != generation);
+    if (wait && profiler.isEnabled()) {
+      recordWait(waitStart);
+    }
+    sample = std::move(completed.sample);
+    lock.lock();
+  } else {
+    const auto isReady = [&]() { return state.samples.count(idx) > 0; };
+    const bool wait = !isReady();
+    if (profiler.isEnabled()) {
+      profiler.recordQueueOccupancy("PrefetchDataset", state.samples.size());
+    }
+    const auto waitStart = DatasetProfiler::Clock::now();
+    state.completed.wait(lock, isReady);
+    if (wait && profiler.isEnabled()) {
+      recordWait(waitStart);
+    }
+    sample = std::move(state.samples.extract(idx).mapped());
+  }
+  state.next = idx + 1;
+  prefetch(idx + 1);
+  lock.unlock();
+
+  if (sample.error) {
+    std::rethrow_exception(sample.error);
+  }
+  return std::move(sample.tensors);
+}
+
 int64_t PrefetchDataset::size() const {
+  if (lookahead_) {
+    return lookahead_->indices.size();
+  }
   return dataset_->size();
 }
 } // namespace fl
@@ -8,11 +8,14 @@
 #pragma once
 
 #include <future>
+#include <memory>
 #include <queue>
+#include <vector>
 
 #include "flashlight/fl/dataset/Dataset.h"
 
 #include "flashlight/fl/common/threadpool/ThreadPool.h"
+#include "flashlight/fl/runtime/ThreadAffinity.h"
 
 namespace fl {
 
@@ -22,6 +25,14 @@ namespace fl {
  * sequential access to the underlying dataset. Otherwise, there will a lot of
  * cache misses leading to a degraded performance.
  *
+ * Given the sequence of indices it will be read in, e.g. those of a sampler,
+ * a PrefetchDataset instead prefetches the samples of the upcoming indices,
+ * which complete out of order in a reorder buffer of `prefetchSize` samples,
+ * such that a slow sample doesn't keep the threads from fetching the following
+ * ones. For training, where the order of samples doesn't matter, samples can
+ * also be returned in the order they complete, such that a slow sample doesn't
+ * block those which completed after it either.
+ *
  * Example:
   \code{.cpp}
   // Make a dataset with 100 samples
@@ -34,6 +45,15 @@ namespace fl {
   for (auto& sample : PrefetchDataset(ds, 4, 2)) {
       // do something
   }
+
+  // Iterate over a permutation of the dataset, in the order samples complete
+  std::vector<int64_t> perm(ds->size());
+  std::iota(perm.begin(), perm.end(), 0);
+  std::shuffle(perm.begin(), perm.end(), std::mt19937());
+  PrefetchDataset unordered(ds, 4, 8, perm, true);
+  for (auto& sample : unordered) {
+      // do something
+  }
   \endcode
  */
 class PrefetchDataset : public Dataset {
@@ -43,25 +63,72 @@ class PrefetchDataset : public Dataset {
    * @param[in] dataset The underlying dataset.
    * @param[in] numThreads Number of threads used by the threadpool
    * @param[in] prefetchSize Number of samples to be prefetched
+   * @param[in] affinity How the threads are bound to cores and memory, e.g.
+   * to the NUMA node of the active device
    */
   explicit PrefetchDataset(
       std::shared_ptr<const Dataset> dataset,
       int64_t numThreads,
-      int64_t prefetchSize);
+      int64_t prefetchSize,
+      ThreadAffinityPolicy affinity = ThreadAffinityPolicy::None);
+
+  /**
+   * Creates a `PrefetchDataset` which prefetches the samples of the
+   * underlying dataset in the order of given indices:
+   * `PrefetchDataset(ds, t, p, v)->get(i) == ds->get(v[i])`,
+   * or, in completion order, `get(i)` returns the first sample to complete of
+   * the `prefetchSize` following ones, such that reading indices `0` to
+   * `size() - 1` in order returns each sample of `v` once.
+   *
+   * Reading out of order restarts prefetching at the index which is read.
+   *
+   * @param[in] dataset The underlying dataset.
+   * @param[in] numThreads Number of threads used by the threadpool
+   * @param[in] prefetchSize Number of samples to be prefetched, which bounds
+   * the number of samples waiting to be read
+   * @param[in] indices The indices of the underlying dataset to read, in order
+   * @param[in] completionOrder Whether to return samples in the order they
+   * complete rather than in the order of `indices`
+   * @param[in] affinity How the threads are bound to cores and memory, e.g.
+   * to the NUMA node of the active device
+   */
+  PrefetchDataset(
+      std::shared_ptr<const Dataset> dataset,
+      int64_t numThreads,
+      int64_t prefetchSize,
+      std::vector<int64_t> indices,
+      bool completionOrder = false,
+      ThreadAffinityPolicy affinity = ThreadAffinityPolicy::None);
+
+  ~PrefetchDataset() override;
 
   int64_t size() const override;
 
   std::vector<Tensor> get(const int64_t idx) const override;
 
+  /**
+   * Changes the indices to prefetch, e.g. for a new epoch, and discards the
+   * prefetched samples; only valid for a `PrefetchDataset` created with
+   * indices.
+   * @param[in] indices The indices of the underlying dataset to read, in order
+   */
+  void resample(std::vector<int64_t> indices);
+
  protected:
   std::shared_ptr<const Dataset> dataset_;
   int64_t numThreads_, prefetchSize_;
 
  private:
+  // The samples prefetched with indices, shared with the tasks fetching them
+  struct Lookahead;
+
+  std::vector<Tensor> getLookahead(int64_t idx) const;
+
   std::unique_ptr<ThreadPool> threadPool_;
   // state variables
   mutable std::queue<std::future<std::vector<Tensor>>> prefetchCache_;
   mutable int64_t curIdx_;
+  std::shared_ptr<Lookahead> lookahead_;
 };
 
 } // namespace fl
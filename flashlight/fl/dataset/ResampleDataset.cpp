@@ -64,6 +64,12 @@ std::vector<Tensor> ResampleDataset::get(const int64_t idx) const {
   return dataset_->get(resampleVec_[idx]);
 }
 
+std::future<std::vector<Tensor>> ResampleDataset::getAsync(
+    const int64_t idx) const {
+  checkIndexBounds(idx);
+  return dataset_->getAsync(resampleVec_[idx]);
+}
+
 int64_t ResampleDataset::size() const {
   return resampleVec_.size();
 }
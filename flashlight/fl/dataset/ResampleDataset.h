@@ -66,6 +66,8 @@ class ResampleDataset : public Dataset {
 
   std::vector<Tensor> get(const int64_t idx) const override;
 
+  std::future<std::vector<Tensor>> getAsync(const int64_t idx) const override;
+
   /**
    * Changes the mapping used to resample the dataset.
    * @param[in] resamplevec The vector specifying the new mapping.
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/dataset/ShardedStreamingDataset.h"
+
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+#include "flashlight/fl/dataset/FileBlobDataset.h"
+#include "flashlight/fl/dataset/MemoryBlobDataset.h"
+#include "flashlight/fl/runtime/Tracer.h"
+#include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Profile.h"
+
+namespace fl {
+
+ShardedStreamingDataset::ShardedStreamingDataset(
+    std::vector<std::string> shards,
+    int64_t partition /* = 0 */,
+    int64_t numPartitions /* = 1 */,
+    int64_t shuffleBufferSize /* = 0 */,
+    int64_t prefetchShards /* = 1 */,
+    uint64_t seed /* = 0 */)
+    : size_(0),
+      shuffleBufferSize_(shuffleBufferSize),
+      prefetchShards_(prefetchShards),
+      seed_(seed),
+      epoch_(-1),
+      nextIdx_(0),
+      nextShard_(0),
+      currentPos_(0) {
+  if (numPartitions <= 0 || partition < 0 || partition >= numPartitions) {
+    throw std::invalid_argument(
+        "ShardedStreamingDataset::ShardedStreamingDataset - invalid partition");
+  }
+  if (shuffleBufferSize_ < 0 || prefetchShards_ < 0) {
+    throw std::invalid_argument(
+        "ShardedStreamingDataset::ShardedStreamingDataset - invalid "
+        "shuffleBufferSize or prefetchShards");
+  }
+  for (size_t i = partition; i < shards.size(); i += numPartitions) {
+    shards_.push_back(std::move(shards[i]));
+    // only reads the header and the index of the shard
+    shardSizes_.push_back(FileBlobDataset(shards_.back()).size());
+    size_ += shardSizes_.back();
+  }
+  if (prefetchShards_ > 0) {
+    auto deviceId = fl::getDevice();
+    threadPool_ = std::make_unique<ThreadPool>(1, [deviceId](int /* id */) {
+      fl::setDevice(deviceId);
+      Tracer::getInstance().setThreadName("ShardedStreamingDataset reader");
+    });
+  }
+}
+
+ShardedStreamingDataset::~ShardedStreamingDataset() {
+  // the reader may still be reading shards
+  threadPool_.reset();
+}
+
+ShardedStreamingDataset::Shard ShardedStreamingDataset::load(
+    int64_t shardIdx) const {
+  FL_PROFILE_TRACE("ShardedStreamingDataset::load");
+  const auto& name = shards_[shardIdx];
+  std::ifstream fs(name, std::ios_base::binary | std::ios_base::ate);
+  if (!fs.is_open()) {
+    throw std::runtime_error(
+        "ShardedStreamingDataset::load - could not open file " + name);
+  }
+  std::vector<char> data(fs.tellg());
+  fs.seekg(0, std::ios_base::beg);
+  if (!fs.read(data.data(), data.size())) {
+    throw std::runtime_error(
+        "ShardedStreamingDataset::load - could not read file " + name);
+  }
+  return std::make_shared<MemoryBlobDataset>(std::move(data));
+}
+
+void ShardedStreamingDataset::startEpoch() const {
+  // reads in flight are dropped, a worker still completes them
+  std::queue<std::future<Shard>>().swap(pending_);
+  current_.reset();
+  currentPos_ = 0;
+  buffer_.clear();
+  ++epoch_;
+  rng_.seed(seed_ + epoch_);
+  order_.resize(shards_.size());
+  std::iota(order_.begin(), order_.end(), 0);
+  if (shuffleBufferSize_ > 0) {
+    std::shuffle(order_.begin(), order_.end(), rng_);
+  }
+  nextShard_ = 0;
+  enqueueShards();
+}
+
+void ShardedStreamingDataset::enqueueShards() const {
+  const size_t maxPending = std::max<int64_t>(prefetchShards_, 1);
+  while (pending_.size() < maxPending && nextShard_ < order_.size()) {
+    const auto shardIdx = order_[nextShard_++];
+    if (threadPool_) {
+      pending_.emplace(
+          threadPool_->enqueue([this, shardIdx]() { return load(shardIdx); }));
+    } else {
+      pending_.emplace(std::async(std::launch::deferred, [this, shardIdx]() {
+        return load(shardIdx);
+      }));
+    }
+  }
+}
+
+std::pair<ShardedStreamingDataset::Shard, int64_t>
+ShardedStreamingDataset::nextSample() const {
+  while (!current_ || currentPos_ >= current_->size()) {
+    if (pending_.empty()) {
+      return {nullptr, 0};
+    }
+    current_ = pending_.front().get();
+    pending_.pop();
+    currentPos_ = 0;
+    enqueueShards();
+  }
+  return {current_, currentPos_++};
+}
+
+std::vector<Tensor> ShardedStreamingDataset::get(const int64_t idx) const {
+  checkIndexBounds(idx);
+
+  std::pair<Shard, int64_t> sample;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idx == 0) {
+      startEpoch();
+    } else if (idx != nextIdx_) {
+      throw std::invalid_argument(
+          "ShardedStreamingDataset::get - samples must be read in order, "
+          "expected index " +
+          std::to_string(nextIdx_) + " but got " + std::to_string(idx));
+    }
+    const size_t bufferSize = std::max<int64_t>(shuffleBufferSize_, 1);
+    while (buffer_.size() < bufferSize) {
+      auto next = nextSample();
+      if (!next.first) {
+        break;
+      }
+      buffer_.push_back(std::move(next));
+    }
+    if (buffer_.empty()) {
+      throw std::runtime_error(
+          "ShardedStreamingDataset::get - the shards ended before index " +
+          std::to_string(idx));
+    }
+    if (shuffleBufferSize_ > 0) {
+      std::uniform_int_distribution<size_t> dist(0, buffer_.size() - 1);
+      std::swap(buffer_[dist(rng_)], buffer_.back());
+    }
+    sample = std::move(buffer_.back());
+    buffer_.pop_back();
+    nextIdx_ = idx + 1;
+  }
+  return sample.first->get(sample.second);
+}
+
+int64_t ShardedStreamingDataset::size() const {
+  return size_;
+}
+
+const std::vector<std::string>& ShardedStreamingDataset::shards() const {
+  return shards_;
+}
+
+} // namespace fl
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/common/threadpool/ThreadPool.h"
+#include "flashlight/fl/dataset/BlobDataset.h"
+#include "flashlight/fl/dataset/Dataset.h"
+
+namespace fl {
+
+/**
+ * A dataset streaming samples from shards, blob files as written by a
+ * `FileBlobDataset`, for storage where random access per sample is expensive,
+ * e.g. object storage. Each shard is read whole, with one large sequential
+ * read, in a background thread which prefetches the next shards while the
+ * current one is consumed.
+ *
+ * Shards are assigned to partitions, e.g. ranks or data-loading workers, in a
+ * round-robin: shard `i` belongs to partition `i % numPartitions`. With
+ * shuffling, the order of the shards of the partition is shuffled every epoch,
+ * and samples are drawn at random from a buffer filled from the stream.
+ *
+ * Samples are streamed, so must be read in order: reading index 0 starts a new
+ * epoch, and any other index must follow the previously read one, e.g. when
+ * iterating over the dataset or over a `BatchDataset` of it. The index of a
+ * sample holds no relation to its position in the shards.
+ *
+ * Example:
+  \code{.cpp}
+  // The shards of rank r, of which 2 are prefetched, and a shuffle buffer of
+  // 10000 samples
+  ShardedStreamingDataset ds(shards, r, worldSize, 10000, 2);
+  for (int epoch = 0; epoch < nEpochs; ++epoch) {
+    for (auto& sample : ds) {
+      // do something
+    }
+  }
+  \endcode
+ */
+class ShardedStreamingDataset : public Dataset {
+ public:
+  /**
+   * Creates a `ShardedStreamingDataset`. Reads the index of every shard of
+   * the partition, to know its size.
+   * @param[in] shards The paths of the blob files, for all partitions.
+   * @param[in] partition The partition whose shards are read, in
+   * `[0, numPartitions)`.
+   * @param[in] numPartitions The number of partitions.
+   * @param[in] shuffleBufferSize If positive, shuffles the shards and the
+   * samples, drawn from a buffer of this many samples.
+   * @param[in] prefetchShards The number of shards read in advance in the
+   * background. If 0, shards are read when needed.
+   * @param[in] seed The seed of the shuffling, the same on all partitions.
+   */
+  ShardedStreamingDataset(
+      std::vector<std::string> shards,
+      int64_t partition = 0,
+      int64_t numPartitions = 1,
+      int64_t shuffleBufferSize = 0,
+      int64_t prefetchShards = 1,
+      uint64_t seed = 0);
+
+  ~ShardedStreamingDataset() override;
+
+  int64_t size() const override;
+
+  std::vector<Tensor> get(const int64_t idx) const override;
+
+  /**
+   * @return The shards of the partition.
+   */
+  const std::vector<std::string>& shards() const;
+
+ private:
+  using Shard = std::shared_ptr<const BlobDataset>;
+
+  // Reads a whole shard in memory
+  Shard load(int64_t shardIdx) const;
+
+  // Restarts the stream on a new epoch
+  void startEpoch() const;
+
+  // Enqueues reads until prefetchShards_ shards are in flight
+  void enqueueShards() const;
+
+  // The next sample of the stream, or a null shard at its end
+  std::pair<Shard, int64_t> nextSample() const;
+
+  std::vector<std::string> shards_;
+  std::vector<int64_t> shardSizes_;
+  int64_t size_, shuffleBufferSize_, prefetchShards_;
+  uint64_t seed_;
+  std::unique_ptr<ThreadPool> threadPool_;
+
+  // state variables
+  mutable std::mutex mutex_;
+  mutable int64_t epoch_;
+  mutable int64_t nextIdx_;
+  mutable std::vector<int64_t> order_;
+  mutable size_t nextShard_;
+  mutable std::queue<std::future<Shard>> pending_;
+  mutable Shard current_;
+  mutable int64_t currentPos_;
+  mutable std::vector<std::pair<Shard, int64_t>> buffer_;
+  mutable std::mt19937_64 rng_;
+};
+
+} // namespace fl
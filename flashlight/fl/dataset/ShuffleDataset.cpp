@@ -8,26 +8,63 @@
 #include "flashlight/fl/dataset/ShuffleDataset.h"
 
 #include <algorithm>
+#include <numeric>
+#include <vector>
 
 namespace fl {
 
+namespace {
+
+// custom implementation of shuffle -
+// en.cppreference.com/w/cpp/algorithm/random_shuffle#Possible_implementation
+template <typename Iterator>
+void shuffle(Iterator first, Iterator last, std::mt19937_64& rng) {
+  using distr_t = std::uniform_int_distribution<unsigned int>;
+  distr_t D;
+  for (int i = (last - first) - 1; i > 0; --i) {
+    std::swap(first[i], first[D(rng, distr_t::param_type(0, i))]);
+  }
+}
+
+} // namespace
+
 ShuffleDataset::ShuffleDataset(
     std::shared_ptr<const Dataset> dataset,
-    int seed /* = 0 */)
-    : ResampleDataset(dataset), rng_(seed) {
+    int seed /* = 0 */,
+    int64_t blockSize /* = 0 */,
+    int64_t windowSize /* = 0 */)
+    : ResampleDataset(dataset),
+      rng_(seed),
+      blockSize_(blockSize),
+      windowSize_(windowSize > 0 ? windowSize : blockSize) {
   resample();
 }
 
 void ShuffleDataset::resample() {
   std::iota(resampleVec_.begin(), resampleVec_.end(), 0);
-  auto n = resampleVec_.size();
-  // custom implementation of shuffle -
-  // en.cppreference.com/w/cpp/algorithm/random_shuffle#Possible_implementation
-  using distr_t = std::uniform_int_distribution<unsigned int>;
-  distr_t D;
-  for (int i = n - 1; i > 0; --i) {
-    std::swap(
-        resampleVec_[i], resampleVec_[D(rng_, distr_t::param_type(0, i))]);
+  const int64_t n = resampleVec_.size();
+  if (blockSize_ <= 1) {
+    shuffle(resampleVec_.begin(), resampleVec_.end(), rng_);
+    return;
+  }
+
+  std::vector<int64_t> blocks((n + blockSize_ - 1) / blockSize_);
+  std::iota(blocks.begin(), blocks.end(), 0);
+  shuffle(blocks.begin(), blocks.end(), rng_);
+  int64_t i = 0;
+  for (auto block : blocks) {
+    const int64_t end = std::min((block + 1) * blockSize_, n);
+    for (int64_t idx = block * blockSize_; idx < end; ++idx) {
+      resampleVec_[i++] = idx;
+    }
+  }
+  if (windowSize_ > 1) {
+    for (int64_t start = 0; start < n; start += windowSize_) {
+      shuffle(
+          resampleVec_.begin() + start,
+          resampleVec_.begin() + std::min(start + windowSize_, n),
+          rng_);
+    }
   }
 }
 
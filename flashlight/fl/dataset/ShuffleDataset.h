@@ -16,6 +16,13 @@ namespace fl {
 /**
  * A view into a dataset, with indices permuted randomly.
  *
+ * In block-shuffle mode, the order of contiguous blocks of `blockSize`
+ * indices is permuted, and indices are then shuffled within consecutive
+ * windows of `windowSize` indices. Reads stay local to a few blocks at a
+ * time, which keeps the page cache and readahead of file-backed datasets
+ * (e.g. `FileBlobDataset`, `MmapBlobDataset`) effective, while the order is
+ * still random enough for SGD.
+ *
  * Example:
   \code{.cpp}
   // Make a dataset with 100 samples
@@ -31,6 +38,9 @@ namespace fl {
   // Reshuffle it
   shuffleds.resample();
   std::cout << "second try" << shuffleds.get(0)["x"] << std::endl;
+
+  // Shuffle blocks of 10 samples, then samples within windows of 20
+  ShuffleDataset blockds(ds, 0, 10, 20);
   \endcode
  */
 class ShuffleDataset : public ResampleDataset {
@@ -39,8 +49,16 @@ class ShuffleDataset : public ResampleDataset {
    * Creates a `ShuffleDataset`.
    * @param[in] dataset The underlying dataset.
    * @param[seed] seed initial seed to be used.
+   * @param[in] blockSize If greater than 1, the size of the contiguous blocks
+   * of indices whose order is permuted.
+   * @param[in] windowSize In block-shuffle mode, the size of the windows
+   * within which indices are shuffled, `blockSize` if not positive.
    */
-  explicit ShuffleDataset(std::shared_ptr<const Dataset> dataset, int seed = 0);
+  explicit ShuffleDataset(
+      std::shared_ptr<const Dataset> dataset,
+      int seed = 0,
+      int64_t blockSize = 0,
+      int64_t windowSize = 0);
 
   /**
    * Generates a new random permutation for the dataset.
@@ -55,6 +73,8 @@ class ShuffleDataset : public ResampleDataset {
 
  protected:
   std::mt19937_64 rng_;
+  int64_t blockSize_;
+  int64_t windowSize_;
 };
 
 } // namespace fl
@@ -5,10 +5,14 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <future>
 #include <stdexcept>
+#include <utility>
 
 #include "flashlight/fl/dataset/TransformDataset.h"
 
+#include "flashlight/fl/dataset/DatasetProfiler.h"
+
 namespace fl {
 
 TransformDataset::TransformDataset(
@@ -22,16 +26,32 @@ TransformDataset::TransformDataset(
 
 std::vector<Tensor> TransformDataset::get(const int64_t idx) const {
   checkIndexBounds(idx);
+  DatasetProfileRange range("TransformDataset");
+
+  return transform(dataset_->get(idx));
+}
 
-  auto result = dataset_->get(idx);
+std::future<std::vector<Tensor>> TransformDataset::getAsync(
+    const int64_t idx) const {
+  checkIndexBounds(idx);
+  // the transforms run on the consumer, once the sample is fetched
+  return std::async(
+      std::launch::deferred,
+      [this, sample = dataset_->getAsync(idx)]() mutable {
+        DatasetProfileRange range("TransformDataset");
+        return transform(sample.get());
+      });
+}
 
-  for (int64_t i = 0; i < result.size(); ++i) {
+std::vector<Tensor> TransformDataset::transform(
+    std::vector<Tensor> sample) const {
+  for (int64_t i = 0; i < sample.size(); ++i) {
     if (i >= transformFns_.size() || !transformFns_[i]) {
       continue;
     }
-    result[i] = transformFns_[i](result[i]);
+    sample[i] = transformFns_[i](sample[i]);
   }
-  return result;
+  return sample;
 }
 
 int64_t TransformDataset::size() const {
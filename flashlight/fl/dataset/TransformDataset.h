@@ -49,7 +49,11 @@ class TransformDataset : public Dataset {
 
   std::vector<Tensor> get(const int64_t idx) const override;
 
+  std::future<std::vector<Tensor>> getAsync(const int64_t idx) const override;
+
  private:
+  std::vector<Tensor> transform(std::vector<Tensor> sample) const;
+
   std::shared_ptr<const Dataset> dataset_;
   const std::vector<TransformFunction> transformFns_;
 };
@@ -8,6 +8,7 @@
 #include "flashlight/fl/dataset/Utils.h"
 
 #include <algorithm>
+#include <numeric>
 #include <stdexcept>
 
 #include "flashlight/fl/tensor/Index.h"
@@ -128,9 +129,13 @@ std::vector<Tensor> makeBatchFromRange(
     std::vector<Dataset::BatchFunction> batchFns,
     int64_t start,
     int64_t end) {
+  // fetch the samples concurrently, if the dataset can
+  std::vector<int64_t> indices(std::max<int64_t>(end - start, 0));
+  std::iota(indices.begin(), indices.end(), start);
+  auto samples = dataset->getBatchAsync(indices);
   std::vector<std::vector<Tensor>> buffer;
-  for (int64_t batchidx = start; batchidx < end; ++batchidx) {
-    auto fds = dataset->get(batchidx);
+  for (auto& sample : samples) {
+    auto fds = sample.get();
     if (buffer.size() < fds.size()) {
       buffer.resize(fds.size());
     }
@@ -186,4 +191,18 @@ Tensor makeBatch(
   }
   return batcharr;
 }
+
+PackedBatch packBatch(const std::vector<Tensor>& data, int dim /* = 0 */) {
+  if (data.empty()) {
+    throw std::invalid_argument("packBatch - no sequences to pack");
+  }
+  PackedBatch batch;
+  batch.offsets.reserve(data.size() + 1);
+  batch.offsets.push_back(0);
+  for (const auto& d : data) {
+    batch.offsets.push_back(batch.offsets.back() + d.dim(dim));
+  }
+  batch.data = fl::concatenate(data, dim);
+  return batch;
+}
 } // namespace fl
@@ -73,6 +73,25 @@ std::vector<Tensor> makeBatchFromRange(
     int64_t start,
     int64_t end);
 
+/**
+ * A batch of sequences of variable length without padding: the sequences are
+ * concatenated along their time dimension, and the i-th one spans the steps
+ * [offsets[i], offsets[i + 1]) of `data`, e.g. for attention with a
+ * block-diagonal mask (see `fl::scaledDotProductAttention`).
+ */
+struct PackedBatch {
+  Tensor data;
+  std::vector<int64_t> offsets;
+};
+
+/**
+ * Packs sequences into a batch without padding.
+ * @param data sequences whose dimensions other than `dim` are equal
+ * @param dim the time dimension of the sequences, along which they're
+ * concatenated
+ */
+PackedBatch packBatch(const std::vector<Tensor>& data, int dim = 0);
+
 /** @} */
 
 } // namespace fl
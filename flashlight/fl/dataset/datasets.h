@@ -7,16 +7,23 @@
 
 #pragma once
 
+#include "flashlight/fl/dataset/BatchCollator.h"
 #include "flashlight/fl/dataset/BatchDataset.h"
 #include "flashlight/fl/dataset/BlobDataset.h"
+#include "flashlight/fl/dataset/CacheDataset.h"
 #include "flashlight/fl/dataset/ConcatDataset.h"
 #include "flashlight/fl/dataset/Dataset.h"
 #include "flashlight/fl/dataset/DatasetIterator.h"
+#include "flashlight/fl/dataset/DatasetProfiler.h"
+#include "flashlight/fl/dataset/DeviceUploadDataset.h"
+#include "flashlight/fl/dataset/DynamicBatchSampler.h"
 #include "flashlight/fl/dataset/FileBlobDataset.h"
 #include "flashlight/fl/dataset/MemoryBlobDataset.h"
 #include "flashlight/fl/dataset/MergeDataset.h"
+#include "flashlight/fl/dataset/MmapBlobDataset.h"
 #include "flashlight/fl/dataset/PrefetchDataset.h"
 #include "flashlight/fl/dataset/ResampleDataset.h"
+#include "flashlight/fl/dataset/ShardedStreamingDataset.h"
 #include "flashlight/fl/dataset/ShuffleDataset.h"
 #include "flashlight/fl/dataset/TensorDataset.h"
 #include "flashlight/fl/dataset/TransformDataset.h"
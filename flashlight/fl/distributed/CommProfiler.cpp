@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/distributed/CommProfiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "flashlight/fl/distributed/DistributedApi.h"
+
+namespace fl {
+
+namespace {
+
+// the tracks of the Chrome trace of a process
+constexpr unsigned kCollectiveTid = 0;
+constexpr unsigned kSyncWaitTid = 1;
+
+template <typename T>
+void sortByStart(std::vector<T>& records) {
+  std::stable_sort(
+      records.begin(), records.end(), [](const T& lhs, const T& rhs) {
+        return lhs.startSeconds < rhs.startSeconds;
+      });
+}
+
+} // namespace
+
+std::string collectiveTypeToString(CollectiveType type) {
+  switch (type) {
+    case CollectiveType::AllReduce:
+      return "allReduce";
+    case CollectiveType::ReduceScatter:
+      return "reduceScatter";
+    case CollectiveType::AllGather:
+      return "allGather";
+    case CollectiveType::Broadcast:
+      return "broadcast";
+    case CollectiveType::Send:
+      return "send";
+    case CollectiveType::Recv:
+      return "recv";
+    case CollectiveType::SendRecv:
+      return "sendRecv";
+  }
+  throw std::invalid_argument(
+      "collectiveTypeToString: unknown collective type");
+}
+
+double CollectiveRecord::seconds() const {
+  return endSeconds - startSeconds;
+}
+
+double CollectiveRecord::algorithmBandwidth() const {
+  const double time = seconds();
+  return time > 0 ? bytes / time : 0;
+}
+
+double CollectiveRecord::busBandwidth() const {
+  const double n = worldSize;
+  switch (type) {
+    case CollectiveType::AllReduce:
+      return algorithmBandwidth() * 2 * (n - 1) / n;
+    case CollectiveType::ReduceScatter:
+    case CollectiveType::AllGather:
+      return algorithmBandwidth() * (n - 1) / n;
+    default:
+      return algorithmBandwidth();
+  }
+}
+
+double SyncWaitRecord::seconds() const {
+  return endSeconds - startSeconds;
+}
+
+CommProfiler& CommProfiler::getInstance() {
+  static CommProfiler instance;
+  return instance;
+}
+
+void CommProfiler::enable() {
+  clear();
+  enabled_ = true;
+}
+
+void CommProfiler::disable() {
+  enabled_ = false;
+}
+
+bool CommProfiler::isEnabled() const {
+  return enabled_;
+}
+
+void CommProfiler::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  origin_ = Clock::now();
+  // references may predate the new origin; they're re-recorded on demand
+  streamReferences_.clear();
+  collectives_.clear();
+  syncWaits_.clear();
+  pendingCollectives_.clear();
+  pendingSyncWaits_.clear();
+}
+
+double CommProfiler::toSeconds(Clock::time_point time) const {
+  return std::chrono::duration<double>(time - origin_).count();
+}
+
+const CommProfiler::StreamReference& CommProfiler::getStreamReference(
+    const Stream& stream) {
+  auto iter = streamReferences_.find(&stream);
+  if (iter == streamReferences_.end()) {
+    auto event = stream.recordEvent(/* enableTiming = */ true);
+    event->sync();
+    StreamReference reference{std::move(event), Clock::now()};
+    iter = streamReferences_.emplace(&stream, std::move(reference)).first;
+  }
+  return iter->second;
+}
+
+void CommProfiler::recordHostCollective(
+    CollectiveType type,
+    const std::string& algorithm,
+    size_t bytes,
+    Clock::time_point start,
+    Clock::time_point end) {
+  if (!enabled_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  collectives_.push_back(
+      {type,
+       algorithm,
+       bytes,
+       getWorldSize(),
+       toSeconds(start),
+       toSeconds(end)});
+}
+
+std::unique_ptr<Event> CommProfiler::recordDeviceMark(const Stream& stream) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    getStreamReference(stream);
+  }
+  return stream.recordEvent(/* enableTiming = */ true);
+}
+
+void CommProfiler::recordDeviceCollective(
+    CollectiveType type,
+    const std::string& algorithm,
+    size_t bytes,
+    const Stream& stream,
+    std::unique_ptr<Event> start,
+    std::unique_ptr<Event> end) {
+  if (!enabled_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  getStreamReference(stream);
+  pendingCollectives_.emplace_back(
+      CollectiveRecord{type, algorithm, bytes, getWorldSize(), 0, 0},
+      DeviceRange{&stream, std::move(start), std::move(end)});
+}
+
+void CommProfiler::recordHostSyncWait(
+    Clock::time_point start,
+    Clock::time_point end) {
+  if (!enabled_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  syncWaits_.push_back({toSeconds(start), toSeconds(end)});
+}
+
+void CommProfiler::recordDeviceSyncWait(
+    const Stream& stream,
+    std::unique_ptr<Event> start,
+    std::unique_ptr<Event> end) {
+  if (!enabled_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  getStreamReference(stream);
+  pendingSyncWaits_.push_back({&stream, std::move(start), std::move(end)});
+}
+
+void CommProfiler::resolveDeviceRanges() {
+  const auto resolve = [this](const DeviceRange& range) {
+    const auto& reference = streamReferences_.at(range.stream_);
+    const double referenceSeconds = toSeconds(reference.time_);
+    return std::make_pair(
+        referenceSeconds + range.start_->elapsedSeconds(*reference.event_),
+        referenceSeconds + range.end_->elapsedSeconds(*reference.event_));
+  };
+  for (auto& [record, range] : pendingCollectives_) {
+    std::tie(record.startSeconds, record.endSeconds) = resolve(range);
+    collectives_.push_back(std::move(record));
+  }
+  pendingCollectives_.clear();
+  for (const auto& range : pendingSyncWaits_) {
+    const auto [start, end] = resolve(range);
+    syncWaits_.push_back({start, end});
+  }
+  pendingSyncWaits_.clear();
+  sortByStart(collectives_);
+  sortByStart(syncWaits_);
+}
+
+std::vector<CollectiveRecord> CommProfiler::collectives() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  resolveDeviceRanges();
+  return collectives_;
+}
+
+std::vector<SyncWaitRecord> CommProfiler::syncWaits() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  resolveDeviceRanges();
+  return syncWaits_;
+}
+
+std::string CommProfiler::summary() {
+  struct Totals {
+    size_t count = 0;
+    size_t bytes = 0;
+    double seconds = 0;
+    double busBandwidth = 0;
+  };
+  std::map<std::pair<std::string, std::string>, Totals> totals;
+  for (const auto& record : collectives()) {
+    auto& entry =
+        totals[{collectiveTypeToString(record.type), record.algorithm}];
+    ++entry.count;
+    entry.bytes += record.bytes;
+    entry.seconds += record.seconds();
+    entry.busBandwidth += record.busBandwidth();
+  }
+  double waitSeconds = 0;
+  const auto waits = syncWaits();
+  for (const auto& wait : waits) {
+    waitSeconds += wait.seconds();
+  }
+
+  std::ostringstream ss;
+  ss << std::left << std::setw(16) << "collective" << std::setw(16)
+     << "algorithm" << std::right << std::setw(8) << "count" << std::setw(14)
+     << "MB" << std::setw(12) << "time (ms)" << std::setw(12) << "busBW (GB/s)"
+     << "\n";
+  ss << std::fixed << std::setprecision(3);
+  for (const auto& [key, entry] : totals) {
+    ss << std::left << std::setw(16) << key.first << std::setw(16)
+       << key.second << std::right << std::setw(8) << entry.count
+       << std::setw(14) << entry.bytes / 1e6 << std::setw(12)
+       << entry.seconds * 1e3 << std::setw(12)
+       << entry.busBandwidth / entry.count / 1e9 << "\n";
+  }
+  ss << "syncDistributed: " << waits.size() << " waits, "
+     << waitSeconds * 1e3 << " ms\n";
+  return ss.str();
+}
+
+void CommProfiler::writeChromeTrace(std::ostream& ostream) {
+  const auto records = collectives();
+  const auto waits = syncWaits();
+  const int pid = getWorldRank();
+  ostream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  ostream << "\n  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid
+          << ", \"args\": {\"name\": \"Rank " << pid << "\"}},";
+  ostream << "\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+          << ", \"tid\": " << kCollectiveTid
+          << ", \"args\": {\"name\": \"Collectives\"}},";
+  ostream << "\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+          << ", \"tid\": " << kSyncWaitTid
+          << ", \"args\": {\"name\": \"syncDistributed\"}}";
+  for (const auto& record : records) {
+    ostream << ",\n  {\"name\": \"" << collectiveTypeToString(record.type)
+            << "\", \"ph\": \"X\", \"pid\": " << pid
+            << ", \"tid\": " << kCollectiveTid
+            << ", \"ts\": " << record.startSeconds * 1e6
+            << ", \"dur\": " << record.seconds() * 1e6
+            << ", \"args\": {\"algorithm\": \"" << record.algorithm
+            << "\", \"bytes\": " << record.bytes
+            << ", \"algBW (GB/s)\": " << record.algorithmBandwidth() / 1e9
+            << ", \"busBW (GB/s)\": " << record.busBandwidth() / 1e9 << "}}";
+  }
+  for (const auto& wait : waits) {
+    ostream << ",\n  {\"name\": \"wait\", \"ph\": \"X\", \"pid\": " << pid
+            << ", \"tid\": " << kSyncWaitTid
+            << ", \"ts\": " << wait.startSeconds * 1e6
+            << ", \"dur\": " << wait.seconds() * 1e6 << "}";
+  }
+  ostream << "\n]}" << std::endl;
+}
+
+CommProfileRange::CommProfileRange(
+    CollectiveType type,
+    std::string algorithm,
+    size_t bytes,
+    const Stream* stream)
+    : type_(type),
+      algorithm_(std::move(algorithm)),
+      bytes_(bytes),
+      stream_(stream),
+      enabled_(CommProfiler::getInstance().isEnabled()) {
+  if (!enabled_) {
+    return;
+  }
+  if (stream_) {
+    startMark_ = CommProfiler::getInstance().recordDeviceMark(*stream_);
+  }
+  start_ = CommProfiler::Clock::now();
+}
+
+CommProfileRange::~CommProfileRange() {
+  if (!enabled_) {
+    return;
+  }
+  auto& profiler = CommProfiler::getInstance();
+  if (stream_) {
+    profiler.recordDeviceCollective(
+        type_,
+        algorithm_,
+        bytes_,
+        *stream_,
+        std::move(startMark_),
+        profiler.recordDeviceMark(*stream_));
+  } else {
+    profiler.recordHostCollective(
+        type_, algorithm_, bytes_, start_, CommProfiler::Clock::now());
+  }
+}
+
+} // namespace fl
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flashlight/fl/runtime/Event.h"
+#include "flashlight/fl/runtime/Stream.h"
+
+namespace fl {
+
+/**
+ * The kinds of operations recorded by the `CommProfiler`.
+ */
+enum class CollectiveType {
+  AllReduce,
+  ReduceScatter,
+  AllGather,
+  Broadcast,
+  Send,
+  Recv,
+  SendRecv
+};
+
+/**
+ * @return the name of a collective, e.g. "allReduce".
+ */
+std::string collectiveTypeToString(CollectiveType type);
+
+/**
+ * A collective operation recorded by the `CommProfiler`. Times are in seconds
+ * since the profiler was enabled, on the host clock of this process; those of
+ * the NCCL backend are when the distributed stream executed the operation
+ * rather than when it was enqueued.
+ */
+struct CollectiveRecord {
+  CollectiveType type;
+  /// the algorithm of the backend, e.g. "ring" or "hierarchical"
+  std::string algorithm;
+  /// the size of the reduced or gathered array of each process, or of the
+  /// sent array
+  size_t bytes;
+  int worldSize;
+  double startSeconds;
+  double endSeconds;
+
+  double seconds() const;
+
+  /**
+   * @return the bytes per second of the array.
+   */
+  double algorithmBandwidth() const;
+
+  /**
+   * @return the bytes per second each process sent, whatever the algorithm,
+   * which is comparable to the bandwidth of the links between processes: the
+   * algorithm bandwidth times 2 (n - 1) / n for an allreduce, and times
+   * (n - 1) / n for a reduce-scatter or an all-gather, as in nccl-tests.
+   */
+  double busBandwidth() const;
+};
+
+/**
+ * A time at which the compute streams waited in `syncDistributed` for the
+ * asynchronous collectives, in seconds since the profiler was enabled. With
+ * the NCCL backend, this is the time a compute stream stalled after its prior
+ * work rather than the time the host spent enqueueing the wait.
+ */
+struct SyncWaitRecord {
+  double startSeconds;
+  double endSeconds;
+
+  double seconds() const;
+};
+
+/**
+ * A singleton which records the collectives of the distributed backends, and
+ * the waits of the compute streams for them, such that the time of a training
+ * step can be split between compute, communication and waiting for other
+ * processes. Nothing is recorded unless the profiler is enabled.
+ *
+ * Example:
+ * \code
+   auto& profiler = fl::CommProfiler::getInstance();
+   profiler.enable();
+   // ... train
+   profiler.disable();
+   std::cout << profiler.summary();
+   std::ofstream trace("comms" + std::to_string(fl::getWorldRank()) + ".json");
+   profiler.writeChromeTrace(trace);
+ * \endcode
+ */
+class CommProfiler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Gets the singleton CommProfiler.
+   *
+   * @return a reference to the singleton CommProfiler.
+   */
+  static CommProfiler& getInstance();
+
+  /**
+   * Clear the records and start recording.
+   */
+  void enable();
+
+  /**
+   * Stop recording; the records are kept until the next `enable` or `clear`.
+   */
+  void disable();
+
+  /**
+   * @return whether the profiler is recording.
+   */
+  bool isEnabled() const;
+
+  /**
+   * Clear the records.
+   */
+  void clear();
+
+  /**
+   * Record a collective which ran on the host between given times.
+   */
+  void recordHostCollective(
+      CollectiveType type,
+      const std::string& algorithm,
+      size_t bytes,
+      Clock::time_point start,
+      Clock::time_point end);
+
+  /**
+   * Record a timed event on given stream, to be used as the bound of
+   * collectives or waits recorded on it.
+   *
+   * @param[in] stream the stream to record the event on.
+   * @return the recorded event.
+   */
+  std::unique_ptr<Event> recordDeviceMark(const Stream& stream);
+
+  /**
+   * Record a collective which ran on given stream between two marks, see
+   * `recordDeviceMark`.
+   */
+  void recordDeviceCollective(
+      CollectiveType type,
+      const std::string& algorithm,
+      size_t bytes,
+      const Stream& stream,
+      std::unique_ptr<Event> start,
+      std::unique_ptr<Event> end);
+
+  /**
+   * Record a wait of the host in `syncDistributed` between given times.
+   */
+  void recordHostSyncWait(Clock::time_point start, Clock::time_point end);
+
+  /**
+   * Record a wait of given stream in `syncDistributed` between two marks, the
+   * first recorded before the wait and the second after it.
+   */
+  void recordDeviceSyncWait(
+      const Stream& stream,
+      std::unique_ptr<Event> start,
+      std::unique_ptr<Event> end);
+
+  /**
+   * @return the recorded collectives, in order of start; blocks until those on
+   * device streams completed.
+   */
+  std::vector<CollectiveRecord> collectives();
+
+  /**
+   * @return the recorded waits in `syncDistributed`, in order of start; blocks
+   * until those on device streams completed.
+   */
+  std::vector<SyncWaitRecord> syncWaits();
+
+  /**
+   * @return a table of the count, bytes, time and mean bus bandwidth of the
+   * collectives per type and algorithm, and the total time of waits.
+   */
+  std::string summary();
+
+  /**
+   * Write the records in the Chrome trace event format, as a process per rank
+   * such that the traces of all processes can be merged to find stragglers.
+   * Each collective has its size and bandwidths as arguments.
+   *
+   * @param[in] ostream the stream to write to.
+   */
+  void writeChromeTrace(std::ostream& ostream);
+
+ private:
+  struct DeviceRange {
+    const Stream* stream_;
+    std::unique_ptr<Event> start_;
+    std::unique_ptr<Event> end_;
+  };
+
+  // Relates the events of a stream to the host clock
+  struct StreamReference {
+    std::unique_ptr<Event> event_;
+    Clock::time_point time_;
+  };
+
+  CommProfiler() = default;
+
+  double toSeconds(Clock::time_point time) const;
+
+  // the reference of given stream, assumes `mutex_` is held
+  const StreamReference& getStreamReference(const Stream& stream);
+
+  // resolves the device ranges into records, assumes `mutex_` is held
+  void resolveDeviceRanges();
+
+  std::mutex mutex_;
+  std::atomic<bool> enabled_{false};
+  Clock::time_point origin_{Clock::now()};
+  std::unordered_map<const Stream*, StreamReference> streamReferences_;
+  std::vector<CollectiveRecord> collectives_;
+  std::vector<SyncWaitRecord> syncWaits_;
+  // device ranges which haven't been resolved, and the records they complete
+  std::vector<std::pair<CollectiveRecord, DeviceRange>> pendingCollectives_;
+  std::vector<DeviceRange> pendingSyncWaits_;
+};
+
+/**
+ * An RAII abstraction to record a collective over the lifetime of an object,
+ * on the host or, if a stream is given, on the stream. For example:
+ * \code
+   {
+     CommProfileRange range(CollectiveType::AllReduce, "ring", bytes, &stream);
+     // enqueue the collective on stream
+   }
+ * \endcode
+ */
+class CommProfileRange {
+  const CollectiveType type_;
+  const std::string algorithm_;
+  const size_t bytes_;
+  const Stream* stream_;
+  const bool enabled_;
+  CommProfiler::Clock::time_point start_;
+  std::unique_ptr<Event> startMark_;
+
+ public:
+  /**
+   * @param[in] type the type of the collective.
+   * @param[in] algorithm the algorithm of the backend.
+   * @param[in] bytes the size of the collective, see `CollectiveRecord`.
+   * @param[in] stream the stream the collective runs on, if any.
+   */
+  CommProfileRange(
+      CollectiveType type,
+      std::string algorithm,
+      size_t bytes,
+      const Stream* stream = nullptr);
+  ~CommProfileRange();
+
+  // no copy/move
+  CommProfileRange(const CommProfileRange&) = delete;
+  CommProfileRange(CommProfileRange&&) = delete;
+  CommProfileRange& operator=(const CommProfileRange&) = delete;
+  CommProfileRange& operator=(CommProfileRange&&) = delete;
+};
+
+} // namespace fl
@@ -7,10 +7,45 @@
 
 #include "flashlight/fl/distributed/DistributedApi.h"
 
+#include <utility>
+
+#include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
 namespace fl {
 
+namespace {
+
+// Reduces the rows of a row-sparse Variable in two steps, first a mask of the
+// rows any process has, then the values of these rows. This only communicates
+// one value per row of the dense matrix, plus the values of the rows in use.
+void allReduceRowSparse(Variable& var, double scale) {
+  auto& indices = var.sparseIndices();
+  auto& values = var.sparseValues();
+  if (getWorldSize() > 1) {
+    auto mask = fl::full({var.dim(1)}, 0, fl::dtype::s32);
+    if (!indices.isEmpty()) {
+      mask(indices) = 1;
+    }
+    allReduce(mask, /* async = */ false);
+    auto isUsed = (mask > 0).astype(fl::dtype::s32);
+    auto rows = fl::nonzero(isUsed).astype(fl::dtype::s32);
+    // the position of each row among the rows in use
+    auto positions = fl::cumsum(isUsed, 0) - 1;
+
+    auto reduced = fl::full({values.dim(0), rows.elements()}, 0, values.type());
+    if (!indices.isEmpty()) {
+      reduced(fl::span, positions(indices)) = values;
+    }
+    allReduce(reduced, /* async = */ false);
+    indices = std::move(rows);
+    values = std::move(reduced);
+  }
+  values *= scale;
+}
+
+} // namespace
+
 bool isDistributedInit() {
   return detail::DistributedInfo::getInstance().isInitialized_;
 }
@@ -23,12 +58,31 @@ void allReduce(
     Variable& var,
     double scale /* = 1.0 */,
     bool async /* = false */) {
+  if (var.isRowSparse()) {
+    allReduceRowSparse(var, scale);
+    return;
+  }
   if (getWorldSize() > 1) {
     allReduce(var.tensor(), async);
   }
   var.tensor() *= scale;
 }
 
+void allReduce(
+    GradientArena& arena,
+    double scale /* = 1.0 */,
+    bool async /* = false */) {
+  for (const auto type : arena.types()) {
+    auto& buffer = arena.buffer(type);
+    if (getWorldSize() > 1) {
+      allReduce(buffer, async);
+    }
+    if (scale != 1.0) {
+      buffer *= scale;
+    }
+  }
+}
+
 void allReduceMultiple(
     std::vector<Variable> vars,
     double scale /* = 1.0 */,
@@ -36,17 +90,51 @@ void allReduceMultiple(
     bool contiguous /* = false */) {
   // return a vector of pointers to avoid copying
   std::vector<Tensor*> arrs;
+  std::vector<Variable> denseVars;
   for (auto& var : vars) {
-    arrs.push_back(&var.tensor());
+    if (var.isRowSparse()) {
+      allReduceRowSparse(var, scale);
+    } else {
+      arrs.push_back(&var.tensor());
+      denseVars.push_back(var);
+    }
   }
   if (getWorldSize() > 1) {
     allReduceMultiple(arrs, async, contiguous);
   }
-  for (auto& var : vars) {
+  for (auto& var : denseVars) {
     var.tensor() *= scale;
   }
 }
 
+DistributedWork::DistributedWork(std::function<void()> wait)
+    : wait_(std::move(wait)) {}
+
+void DistributedWork::wait() {
+  if (wait_) {
+    // reset before waiting, such that an error isn't raised again
+    auto wait = std::move(wait_);
+    wait_ = nullptr;
+    wait();
+  }
+}
+
+void broadcast(Tensor& arr, int root) {
+  broadcastAsync(arr, root).wait();
+}
+
+void send(const Tensor& arr, int dst) {
+  sendAsync(arr, dst).wait();
+}
+
+void recv(Tensor& arr, int src) {
+  recvAsync(arr, src).wait();
+}
+
+void sendRecv(const Tensor& sendArr, int dst, Tensor& recvArr, int src) {
+  sendRecvAsync(sendArr, dst, recvArr, src).wait();
+}
+
 void barrier() {
   auto tensor = Tensor::fromVector<int>({0});
   allReduce(tensor, false);
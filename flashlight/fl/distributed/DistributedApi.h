@@ -7,10 +7,12 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "flashlight/fl/autograd/GradientArena.h"
 #include "flashlight/fl/autograd/Variable.h"
 #include "flashlight/fl/common/Defines.h"
 #include "flashlight/fl/tensor/TensorBase.h"
@@ -21,14 +23,59 @@ namespace fl {
  * @{
  */
 
+/**
+ * A handle of an asynchronous distributed operation. The tensors the operation
+ * writes are only valid, and those it reads may only be modified, after
+ * `wait`. Asynchronous operations are also complete after `syncDistributed`.
+ */
+class DistributedWork {
+ public:
+  /** A handle of a complete operation. */
+  DistributedWork() = default;
+
+  /**
+   * @param[in] wait waits for the operation, called at most once
+   */
+  explicit DistributedWork(std::function<void()> wait);
+
+  /**
+   * Waits for the operation: on the CUDA backend, future operations on the
+   * streams of its tensors run after it without blocking the host; on the
+   * Gloo backend, blocks until it's complete. Does nothing after the first
+   * call.
+   */
+  void wait();
+
+ private:
+  std::function<void()> wait_;
+};
+
 /**
  * Initialize the distributed environment. Note that `worldSize`, `worldRank`
  * are ignored if `DistributedInit::MPI` is used.
  *
+ * `DistributedInit::FILE_SYSTEM` rendezvouses through files in the directory
+ * `DistributedConstants::kFilePath` of a shared filesystem, and
+ * `DistributedInit::TCP` through a store served by the process of rank 0 at
+ * `DistributedConstants::kStoreHost` and `DistributedConstants::kStorePort`,
+ * which is faster for many processes.
+ *
+ * `DistributedInit::LOCAL` makes each of the first `worldSize` devices of the
+ * process a rank, or each device if `worldSize` isn't positive, with NCCL
+ * communicators within the process. Collectives then run on the driver
+ * threads of `runOnDevices`, rather than in one process per device, such that
+ * the dataset, dictionaries and caches are loaded once per node.
+ *
  * @param initMethod Initialization method used for setting up the rendezvous
  * @param worldSize Total number of processes in the communication group
  *`@param worldRank 0-indexed rank of the current process
- * @param params Additional parameters (if any) needed for initialization
+ * @param params Additional parameters (if any) needed for initialization,
+ * e.g. `DistributedConstants::kAllReduceMode` to select the allreduce
+ * algorithm of the NCCL backend. A hierarchical allreduce groups processes
+ * into nodes of `DistributedConstants::kMaxDevicePerNode` consecutive ranks.
+ * The Gloo backend takes `DistributedConstants::kGlooAlgorithm` and the number
+ * of threads of its asynchronous operations,
+ * `DistributedConstants::kCommThreads`.
  */
 void distributedInit(
     DistributedInit initMethod,
@@ -36,6 +83,28 @@ void distributedInit(
     int worldSize,
     const std::unordered_map<std::string, std::string>& params = {});
 
+/**
+ * Runs a function on each rank of this process, with its rank, e.g. a training
+ * loop on a replica of a model (see `replicateModule`).
+ *
+ * After `distributedInit(DistributedInit::LOCAL, ...)`, starts a driver thread
+ * per rank whose active device is the device of the rank, and on which the
+ * distributed functions, e.g. `getWorldRank` and `allReduce`, use the
+ * communicator of the rank. Returns once all threads are done, rethrowing the
+ * exception of the lowest rank which threw, if any. As collectives wait for
+ * all ranks, a rank which throws should only do so when the others fail too,
+ * or are done communicating.
+ *
+ * Otherwise, runs the function on the calling thread with the rank of the
+ * process, such that the same code runs in either mode.
+ *
+ * Outside of the driver threads, a `DistributedInit::LOCAL` environment has
+ * rank 0 and can't run collectives.
+ *
+ * @param[in] fn the function to run, which is given its rank
+ */
+void runOnDevices(const std::function<void(int worldRank)>& fn);
+
 /**
  * Returns whether the distributed environment has been initialized
  */
@@ -61,6 +130,10 @@ int getWorldSize();
 /**
  * Synchronizes a the array wrapped by the Variable with allreduce.
  *
+ * Row-sparse Variables (see `Variable::rowSparse`) stay so: their rows are
+ * reduced synchronously, with an allreduce of the rows in use followed by one
+ * of their values.
+ *
  * @param[in] var a variable whose array will be synchronized
  * @param[in] scale scale the Variable after allreduce by this factor
  * @param[in] async perform the allReduce operation asynchronously in a separate
@@ -70,9 +143,26 @@ int getWorldSize();
  */
 void allReduce(Variable& var, double scale = 1.0, bool async = false);
 
+/**
+ * Synchronizes the gradients stored in a `GradientArena` with one allreduce
+ * per buffer of the arena. Parameters without a gradient contribute zeros.
+ *
+ * @param[in] arena the arena whose gradients will be synchronized
+ * @param[in] scale scale the gradients after allreduce by this factor
+ * @param[in] async perform the allReduce operation asynchronously in a separate
+ * compute stream to the Flashlight compute stream. NB: if true,
+ * ``syncDistributed`` *must* be called in order to ensure the Flashlight CUDA
+ * stream waits until ``allReduce`` is complete and uses updated values.
+ */
+void allReduce(GradientArena& arena, double scale = 1.0, bool async = false);
+
 /**
  * Synchronizes a single Flashlight array with allreduce.
  *
+ * With the Gloo backend, asynchronous operations run in order on a pool of
+ * communication threads, which processes give the same operations to, so that
+ * consecutive operations run in parallel.
+ *
  * @param arr an array which will be synchronized
  * @param[in] async perform the allReduce operation asynchronously in a separate
  * compute stream to the Flashlight compute stream. NB: if used,
@@ -118,6 +208,117 @@ void allReduceMultiple(
     bool async = false,
     bool contiguous = false);
 
+/**
+ * Sums an array over all processes, and returns the part of the sum of the
+ * current process: the `getWorldRank()`-th of `getWorldSize()` equal parts of
+ * the flat array. This communicates half the data of an allreduce.
+ *
+ * @param[in] arr an array whose number of elements is a multiple of the world
+ * size
+ * @return the flat part of the sum of the current process
+ */
+Tensor reduceScatter(const Tensor& arr);
+
+/**
+ * An asynchronous `reduceScatter`, which runs on the distributed stream.
+ *
+ * @param[in] arr an array whose number of elements is a multiple of the world
+ * size
+ * @param[out] output set to the flat part of the sum of the current process,
+ * which is valid after waiting for the returned handle
+ * @return the handle of the operation
+ */
+DistributedWork reduceScatterAsync(const Tensor& arr, Tensor& output);
+
+/**
+ * Gathers an array of the same type and number of elements from each process.
+ *
+ * @param[in] arr the array of the current process
+ * @return the flat arrays of all processes, concatenated by rank
+ */
+Tensor allGather(const Tensor& arr);
+
+/**
+ * An asynchronous `allGather`, which runs on the distributed stream.
+ *
+ * @param[in] arr the array of the current process
+ * @param[out] output set to the flat arrays of all processes, concatenated by
+ * rank, which are valid after waiting for the returned handle
+ * @return the handle of the operation
+ */
+DistributedWork allGatherAsync(const Tensor& arr, Tensor& output);
+
+/**
+ * Replaces an array on all processes by that of the process of rank `root`.
+ * The array must have the same type and number of elements on all processes.
+ *
+ * @param[in,out] arr the array to send from the root, and to receive into on
+ * other processes
+ * @param[in] root the rank of the process whose array to broadcast
+ */
+void broadcast(Tensor& arr, int root);
+
+/**
+ * An asynchronous `broadcast`, which runs on the distributed stream.
+ *
+ * @return the handle of the operation
+ */
+DistributedWork broadcastAsync(Tensor& arr, int root);
+
+/**
+ * Sends an array to another process, which receives it with `recv`. The
+ * sends and receives between two processes are matched in order.
+ *
+ * @param[in] arr the array to send
+ * @param[in] dst the rank of the receiving process
+ */
+void send(const Tensor& arr, int dst);
+
+/**
+ * An asynchronous `send`, which runs on the distributed stream.
+ *
+ * @return the handle of the operation
+ */
+DistributedWork sendAsync(const Tensor& arr, int dst);
+
+/**
+ * Receives an array sent by another process with `send`.
+ *
+ * @param[in,out] arr the array to receive into, of the type and number of
+ * elements of the sent array
+ * @param[in] src the rank of the sending process
+ */
+void recv(Tensor& arr, int src);
+
+/**
+ * An asynchronous `recv`, which runs on the distributed stream.
+ *
+ * @return the handle of the operation
+ */
+DistributedWork recvAsync(Tensor& arr, int src);
+
+/**
+ * Sends an array to a process while receiving one from a process, both of
+ * which may be the same. Unlike a `send` followed by a `recv`, the two run
+ * concurrently, such that processes which exchange arrays in opposite orders
+ * don't wait on each other, e.g. a process which sends then receives and one
+ * which receives then sends.
+ *
+ * @param[in] sendArr the array to send
+ * @param[in] dst the rank of the process receiving `sendArr`
+ * @param[in,out] recvArr the array to receive into, see `recv`
+ * @param[in] src the rank of the process sending `recvArr`
+ */
+void sendRecv(const Tensor& sendArr, int dst, Tensor& recvArr, int src);
+
+/**
+ * An asynchronous `sendRecv`, which runs on the distributed stream.
+ *
+ * @return the handle of the operation
+ */
+DistributedWork
+sendRecvAsync(const Tensor& sendArr, int dst, Tensor& recvArr, int src);
+
 /**
  * Synchronizes operations in the Flashlight compute stream with operations in
  * the distributed compute stream, if applicable. That is, all operations in the
@@ -87,6 +87,12 @@ void FileStore::clear(const std::string& key) {
   fs::remove(path);
 }
 
+void FileStore::wait(const std::vector<std::string>& keys) {
+  for (const auto& key : keys) {
+    wait(key);
+  }
+}
+
 bool FileStore::check(const std::string& key) {
   fs::path path = objectPath(key);
 
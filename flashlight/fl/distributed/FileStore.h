@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/distributed/Store.h"
 
 namespace fl {
 
@@ -19,14 +20,16 @@ namespace detail {
 
 // Inspired from
 // https://github.com/facebookincubator/gloo/blob/master/gloo/rendezvous/file_store.h
-class FileStore {
+class FileStore : public Store {
  public:
   static constexpr std::chrono::milliseconds kDefaultTimeout =
       std::chrono::seconds(60 * 2);
   explicit FileStore(const fs::path& path) : basePath_(path) {}
-  std::vector<char> get(const std::string& key);
-  void set(const std::string& key, const std::vector<char>& data);
-  void clear(const std::string& key);
+  using Store::get;
+  std::vector<char> get(const std::string& key) override;
+  void set(const std::string& key, const std::vector<char>& data) override;
+  void clear(const std::string& key) override;
+  void wait(const std::vector<std::string>& keys) override;
 
  private:
   fs::path basePath_;
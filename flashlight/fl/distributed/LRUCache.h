@@ -7,8 +7,14 @@
 
 #pragma once
 
+#include <cstdint>
 #include <list>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <typeinfo>
 #include <unordered_map>
+#include <utility>
 
 namespace fl {
 
@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/distributed/ShardedCheckpoint.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#if FL_CHECKPOINT_USE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "flashlight/fl/common/Logging.h"
+#include "flashlight/fl/common/threadpool/ThreadPool.h"
+#include "flashlight/fl/distributed/DistributedApi.h"
+
+namespace fl {
+
+namespace {
+
+// Version 1 shards hold raw tensors without checksums; version 2 adds the
+// codec and the checksum of each tensor
+constexpr uint32_t kFormatVersion = 2;
+
+enum class Codec : uint8_t { Raw, Zstd };
+
+// The data of a tensor of a shard, compressed if its codec isn't raw
+struct HostTensor {
+  uint64_t index;
+  Shape shape;
+  dtype type;
+  std::vector<uint8_t> data;
+  Codec codec{Codec::Raw};
+  uint64_t rawBytes{0};
+  uint32_t checksum{0};
+};
+
+// CRC-32 (of zlib), 8 bytes at a time with the slicing-by-8 tables
+using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+const CrcTables& crcTables() {
+  static const CrcTables tables = []() {
+    CrcTables t;
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; ++j) {
+        crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+      }
+      t[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+      for (int k = 1; k < 8; ++k) {
+        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+      }
+    }
+    return t;
+  }();
+  return tables;
+}
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+  const auto& t = crcTables();
+  uint32_t crc = 0xFFFFFFFFu;
+  for (; size >= 8; data += 8, size -= 8) {
+    uint32_t lo, hi;
+    std::memcpy(&lo, data, 4);
+    std::memcpy(&hi, data + 4, 4);
+    lo ^= crc;
+    crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^
+        t[4][lo >> 24] ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^
+        t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+  }
+  for (; size > 0; ++data, --size) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xFF];
+  }
+  return ~crc;
+}
+
+// Compresses the data of a tensor, unless it doesn't get smaller
+void compress(HostTensor& tensor, ShardedCheckpoint::Compression compression) {
+  if (compression == ShardedCheckpoint::Compression::None ||
+      tensor.data.empty()) {
+    return;
+  }
+#if FL_CHECKPOINT_USE_ZSTD
+  std::vector<uint8_t> compressed(ZSTD_compressBound(tensor.data.size()));
+  const size_t size = ZSTD_compress(
+      compressed.data(),
+      compressed.size(),
+      tensor.data.data(),
+      tensor.data.size(),
+      1 /* the fastest level */);
+  if (ZSTD_isError(size)) {
+    throw std::runtime_error(
+        std::string("[ShardedCheckpoint::save] compression failed: ") +
+        ZSTD_getErrorName(size));
+  }
+  if (size < tensor.data.size()) {
+    compressed.resize(size);
+    tensor.data = std::move(compressed);
+    tensor.codec = Codec::Zstd;
+  }
+#endif
+}
+
+void decompress(HostTensor& tensor, const fs::path& path) {
+  if (tensor.codec == Codec::Raw) {
+    return;
+  }
+#if FL_CHECKPOINT_USE_ZSTD
+  if (tensor.codec == Codec::Zstd) {
+    std::vector<uint8_t> raw(tensor.rawBytes);
+    const size_t size = ZSTD_decompress(
+        raw.data(), raw.size(), tensor.data.data(), tensor.data.size());
+    if (ZSTD_isError(size) || size != raw.size()) {
+      throw std::runtime_error(
+          "[ShardedCheckpoint::load] corrupted tensor in shard " +
+          path.string());
+    }
+    tensor.data = std::move(raw);
+    return;
+  }
+#endif
+  throw std::runtime_error(
+      "[ShardedCheckpoint::load] shard " + path.string() +
+      " is compressed with a codec this build doesn't support");
+}
+
+std::string shardFile(int rank, int worldSize) {
+  return "shard" + std::to_string(rank) + "-of-" + std::to_string(worldSize) +
+      ".bin";
+}
+
+// Writes a file of a unique name in the same directory, then moves it over
+// the destination, such that readers never see a partial file
+void writeAtomically(
+    const fs::path& path,
+    const std::function<void(cereal::BinaryOutputArchive&)>& write) {
+  auto tmpPath = path;
+  tmpPath += ".tmp" + std::to_string(std::random_device()());
+  {
+    std::ofstream file(tmpPath, std::ios::binary);
+    if (!file) {
+      throw std::runtime_error(
+          "[ShardedCheckpoint::save] can't write file " + tmpPath.string());
+    }
+    {
+      cereal::BinaryOutputArchive ar(file);
+      write(ar);
+    }
+    if (!file) {
+      throw std::runtime_error(
+          "[ShardedCheckpoint::save] can't write file " + tmpPath.string());
+    }
+  }
+  fs::rename(tmpPath, path);
+}
+
+std::vector<HostTensor> readShard(
+    const fs::path& path,
+    uint64_t id,
+    uint64_t numTensors,
+    uint32_t version) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error(
+        "[ShardedCheckpoint::load] can't read shard " + path.string() +
+        ", the checkpoint may be incomplete");
+  }
+  cereal::BinaryInputArchive ar(file);
+  uint64_t shardId, count;
+  ar(shardId, count);
+  if (shardId != id) {
+    throw std::runtime_error(
+        "[ShardedCheckpoint::load] shard " + path.string() +
+        " is from another checkpoint, which may be incomplete");
+  }
+  std::vector<HostTensor> shard(count);
+  for (auto& tensor : shard) {
+    ar(tensor.index, tensor.shape, tensor.type);
+    if (version >= 2) {
+      ar(tensor.codec, tensor.rawBytes, tensor.checksum);
+    }
+    ar(tensor.data);
+    if (tensor.index >= numTensors) {
+      throw std::runtime_error(
+          "[ShardedCheckpoint::load] invalid tensor index in shard " +
+          path.string());
+    }
+    if (version >= 2) {
+      decompress(tensor, path);
+      if (tensor.data.size() != tensor.rawBytes ||
+          crc32(tensor.data.data(), tensor.data.size()) != tensor.checksum) {
+        throw std::runtime_error(
+            "[ShardedCheckpoint::load] checksum mismatch in shard " +
+            path.string() + ", which is corrupted");
+      }
+    }
+  }
+  return shard;
+}
+
+} // namespace
+
+ShardedCheckpoint::ShardedCheckpoint() : ShardedCheckpoint(Options()) {}
+
+ShardedCheckpoint::ShardedCheckpoint(Options options) : options_(options) {
+  if (options_.filesPerProcess < 1) {
+    throw std::invalid_argument(
+        "ShardedCheckpoint::ShardedCheckpoint - filesPerProcess must be "
+        "positive");
+  }
+  if (!isSupported(options_.compression)) {
+    throw std::invalid_argument(
+        "ShardedCheckpoint::ShardedCheckpoint - zstd compression requires a "
+        "build with zstd");
+  }
+}
+
+ShardedCheckpoint::~ShardedCheckpoint() {
+  try {
+    wait();
+  } catch (const std::exception& ex) {
+    FL_LOG(fl::LogLevel::ERROR)
+        << "ShardedCheckpoint: saving failed: " << ex.what();
+  }
+}
+
+void ShardedCheckpoint::wait() {
+  if (pending_.valid()) {
+    pending_.get();
+  }
+}
+
+bool ShardedCheckpoint::exists(const fs::path& path) {
+  return fs::exists(path / kMetadataFile);
+}
+
+bool ShardedCheckpoint::isSupported(Compression compression) {
+#if FL_CHECKPOINT_USE_ZSTD
+  return true;
+#else
+  return compression == Compression::None;
+#endif
+}
+
+void ShardedCheckpoint::saveShards(
+    const fs::path& path,
+    std::string structure,
+    std::vector<Tensor> tensors) {
+  const int rank = getWorldRank();
+  const int worldSize = getWorldSize();
+
+  // the files of a checkpoint share an id, such that the shards of another
+  // checkpoint in the same directory aren't loaded with it
+  std::random_device rd;
+  auto idTensor = Tensor::fromVector<long long>(
+      {static_cast<long long>(rd()) << 32 | rd()});
+  if (worldSize > 1) {
+    broadcast(idTensor, 0);
+  }
+  const auto id = static_cast<uint64_t>(idTensor.scalar<long long>());
+
+  // contiguous ranges of tensors of about the same size per file, the files
+  // of a process being consecutive
+  const int filesPerProcess = options_.filesPerProcess;
+  const int numFiles = worldSize * filesPerProcess;
+  size_t totalBytes = 0;
+  for (const auto& tensor : tensors) {
+    totalBytes += tensor.bytes();
+  }
+  std::vector<std::vector<HostTensor>> files(filesPerProcess);
+  size_t offset = 0;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const auto& tensor = tensors[i];
+    const size_t middle = offset + tensor.bytes() / 2;
+    offset += tensor.bytes();
+    const int file = totalBytes == 0
+        ? 0
+        : std::min<int>(numFiles - 1, middle * numFiles / totalBytes);
+    if (file / filesPerProcess != rank) {
+      continue;
+    }
+    HostTensor hostTensor{i, tensor.shape(), tensor.type(), {}};
+    hostTensor.data.resize(tensor.bytes());
+    if (!hostTensor.data.empty()) {
+      tensor.host(hostTensor.data.data());
+    }
+    files[file % filesPerProcess].push_back(std::move(hostTensor));
+  }
+  const uint64_t numTensors = tensors.size();
+  tensors.clear();
+
+  fs::create_directories(path);
+  pending_ = std::async(
+      std::launch::async,
+      [path,
+       rank,
+       numFiles,
+       filesPerProcess,
+       compression = options_.compression,
+       id,
+       numTensors,
+       files = std::move(files),
+       structure = std::move(structure)]() mutable {
+        // the files are checksummed, compressed and written concurrently
+        std::vector<std::future<void>> writes;
+        {
+          ThreadPool pool(filesPerProcess);
+          for (int i = 0; i < filesPerProcess; ++i) {
+            writes.push_back(pool.enqueue([&, i]() {
+              auto& shard = files[i];
+              for (auto& tensor : shard) {
+                tensor.rawBytes = tensor.data.size();
+                tensor.checksum = crc32(tensor.data.data(), tensor.data.size());
+                compress(tensor, compression);
+              }
+              writeAtomically(
+                  path / shardFile(rank * filesPerProcess + i, numFiles),
+                  [&](cereal::BinaryOutputArchive& ar) {
+                    ar(id, static_cast<uint64_t>(shard.size()));
+                    for (const auto& tensor : shard) {
+                      ar(tensor.index,
+                         tensor.shape,
+                         tensor.type,
+                         tensor.codec,
+                         tensor.rawBytes,
+                         tensor.checksum,
+                         tensor.data);
+                    }
+                  });
+              shard.clear();
+            }));
+          }
+        }
+        for (auto& write : writes) {
+          write.get();
+        }
+        if (rank == 0) {
+          writeAtomically(
+              path / kMetadataFile, [&](cereal::BinaryOutputArchive& ar) {
+                ar(id,
+                   static_cast<uint64_t>(numFiles),
+                   numTensors,
+                   structure,
+                   kFormatVersion);
+              });
+        }
+      });
+}
+
+std::string ShardedCheckpoint::loadShards(
+    const fs::path& path,
+    std::vector<Tensor>& tensors) {
+  const auto metadataPath = path / kMetadataFile;
+  std::ifstream file(metadataPath, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error(
+        "[ShardedCheckpoint::load] can't read file " + metadataPath.string());
+  }
+  uint64_t id, numShards, numTensors;
+  std::string structure;
+  uint32_t version = 1;
+  {
+    cereal::BinaryInputArchive ar(file);
+    ar(id, numShards, numTensors, structure);
+    // the version follows from version 2
+    if (file.peek() != std::ifstream::traits_type::eof()) {
+      ar(version);
+    }
+  }
+  if (version > kFormatVersion) {
+    throw std::runtime_error(
+        "[ShardedCheckpoint::load] " + path.string() +
+        " has an unsupported version " + std::to_string(version));
+  }
+
+  // the shards are read, decompressed and verified concurrently, and copied to
+  // the device on this thread
+  std::vector<std::future<std::vector<HostTensor>>> shards;
+  for (uint64_t i = 0; i < numShards; ++i) {
+    shards.push_back(std::async(
+        std::launch::async,
+        readShard,
+        path / shardFile(static_cast<int>(i), static_cast<int>(numShards)),
+        id,
+        numTensors,
+        version));
+  }
+  tensors.assign(numTensors, Tensor());
+  std::vector<bool> loaded(numTensors, false);
+  for (auto& shard : shards) {
+    for (auto& tensor : shard.get()) {
+      tensors[tensor.index] =
+          Tensor::fromVector(tensor.shape, tensor.data, tensor.type);
+      loaded[tensor.index] = true;
+    }
+  }
+  for (bool isLoaded : loaded) {
+    if (!isLoaded) {
+      throw std::runtime_error(
+          "[ShardedCheckpoint::load] the shards of " + path.string() +
+          " are missing tensors");
+    }
+  }
+  return structure;
+}
+
+} // namespace fl
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <future>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/common/Serialization.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+/**
+ * Checkpoints of the state replicated by the processes of data-parallel
+ * training, e.g. a model and its optimizer, whose tensors are split into one
+ * shard per process, balanced by size, and written in parallel. The tensors
+ * of a process are copied to the host while saving, and written to files in
+ * the background, such that training continues during the writes.
+ *
+ * A checkpoint is a directory, which holds the structure of the objects,
+ * written with cereal by the process of rank 0, and a file per shard. Each
+ * process of a job of any world size loads all shards, so a job can restart
+ * from a checkpoint written with another number of processes, e.g. after the
+ * loss of a node.
+ *
+ * The shard of a process may be split into several files, written
+ * concurrently, e.g. for the bandwidth of NVMe RAID or network storage to
+ * scale with threads, and its tensors compressed with zstd. Each tensor is
+ * stored with a checksum of its data, verified when loading.
+ *
+ * Example:
+ * \code
+   fl::ShardedCheckpoint checkpoint;
+   // on all processes, with the same objects
+   checkpoint.save("/checkpoints/model", network, optimizer, epoch);
+   // ... continue training while the shards are written
+   checkpoint.wait();
+
+   // later, with any number of processes
+   fl::ShardedCheckpoint::load("/checkpoints/model", network, optimizer, epoch);
+ * \endcode
+ */
+class ShardedCheckpoint {
+ public:
+  /** The name of the file with the structure of a checkpoint. */
+  static constexpr const char* kMetadataFile = "checkpoint.bin";
+
+  /** The compression of the tensors of the shards. */
+  enum class Compression { None, Zstd };
+
+  /** How the shards of the processes are written. */
+  struct Options {
+    /// The number of files the shard of each process is split into, balanced
+    /// by size and written concurrently
+    int filesPerProcess = 1;
+    /// The compression of the tensors, e.g. for optimizer moments. The
+    /// tensors which don't compress are stored raw.
+    Compression compression = Compression::None;
+  };
+
+  ShardedCheckpoint();
+  explicit ShardedCheckpoint(Options options);
+
+  /** Waits for the pending save, logging its error, if any. */
+  ~ShardedCheckpoint();
+
+  ShardedCheckpoint(const ShardedCheckpoint&) = delete;
+  ShardedCheckpoint& operator=(const ShardedCheckpoint&) = delete;
+
+  /**
+   * Saves objects to a checkpoint directory, created if needed, in the
+   * background after waiting for the previous save. A collective operation:
+   * all processes must save the same objects, in the same order.
+   *
+   * @param[in] path the directory of the checkpoint, on a filesystem shared
+   * by the processes
+   * @param[in] args the objects to save, as with `fl::save`
+   */
+  template <typename... Args>
+  void save(const fs::path& path, const Args&... args) {
+    wait();
+    detail::ExternalTensors external;
+    std::ostringstream structure;
+    {
+      detail::ExternalTensorsScope scope(&external);
+      cereal::BinaryOutputArchive ar(structure);
+      ar(args...);
+    }
+    saveShards(path, structure.str(), std::move(external.tensors));
+  }
+
+  /**
+   * Waits for the pending save to be written, and rethrows its error, if any.
+   */
+  void wait();
+
+  /**
+   * Loads objects saved with `save`, whose shards must all be written.
+   *
+   * @param[in] path the directory of the checkpoint
+   * @param[out] args the objects to load, in the order they were saved
+   */
+  template <typename... Args>
+  static void load(const fs::path& path, Args&... args) {
+    detail::ExternalTensors external;
+    std::istringstream structure(loadShards(path, external.tensors));
+    detail::ExternalTensorsScope scope(&external);
+    cereal::BinaryInputArchive ar(structure);
+    ar(args...);
+  }
+
+  /**
+   * @return whether a checkpoint was saved in the directory
+   */
+  static bool exists(const fs::path& path);
+
+  /**
+   * @return whether checkpoints can be written with a compression, e.g. zstd
+   * if the build found it
+   */
+  static bool isSupported(Compression compression);
+
+ private:
+  // Copies the tensors of the shard of this process to the host, and writes
+  // them in the background
+  void saveShards(
+      const fs::path& path,
+      std::string structure,
+      std::vector<Tensor> tensors);
+
+  // Reads the tensors of all shards, and returns the structure
+  static std::string loadShards(
+      const fs::path& path,
+      std::vector<Tensor>& tensors);
+
+  Options options_;
+  std::future<void> pending_;
+};
+
+} // namespace fl
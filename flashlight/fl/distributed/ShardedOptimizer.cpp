@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/distributed/ShardedOptimizer.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include "flashlight/fl/distributed/DistributedApi.h"
+#include "flashlight/fl/tensor/Index.h"
+
+namespace fl {
+
+// The parameters of one type, each at an offset of the flat tensor of the
+// bucket, in the part of the flat tensor of their owner
+struct ShardedOptimizer::Bucket {
+  fl::dtype type;
+  // the number of elements of the part of each process
+  Dim partSize{0};
+  std::vector<std::pair<size_t, Dim>> offsets;
+};
+
+ShardedOptimizer::ShardedOptimizer(
+    const std::vector<Variable>& parameters,
+    const OptimizerFactory& makeOptimizer,
+    double scale /* = 1.0 */)
+    : worldSize_(getWorldSize()), scale_(scale) {
+  parameters_ = parameters;
+  // greedily assign the largest parameters first to the process owning the
+  // fewest elements, which is deterministic across processes
+  std::vector<size_t> order(parameters_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    return parameters_[a].elements() > parameters_[b].elements();
+  });
+  std::vector<Dim> loads(worldSize_, 0);
+  owners_.resize(parameters_.size());
+  for (const auto i : order) {
+    const auto owner = static_cast<int>(
+        std::min_element(loads.begin(), loads.end()) - loads.begin());
+    owners_[i] = owner;
+    loads[owner] += parameters_[i].elements();
+  }
+
+  std::vector<Variable> owned;
+  for (size_t i = 0; i < parameters_.size(); ++i) {
+    if (owners_[i] == getWorldRank()) {
+      owned.push_back(parameters_[i]);
+    }
+  }
+  optimizer_ = makeOptimizer(owned);
+  if (!optimizer_) {
+    throw std::invalid_argument(
+        "[ShardedOptimizer::ShardedOptimizer] makeOptimizer returned null");
+  }
+  lr_ = optimizer_->getLr();
+}
+
+std::vector<ShardedOptimizer::Bucket> ShardedOptimizer::getBuckets() const {
+  std::map<fl::dtype, std::vector<size_t>> indices;
+  for (size_t i = 0; i < parameters_.size(); ++i) {
+    indices[parameters_[i].type()].push_back(i);
+  }
+  std::vector<Bucket> buckets;
+  for (const auto& [type, typeIndices] : indices) {
+    Bucket bucket;
+    bucket.type = type;
+    std::vector<Dim> sizes(worldSize_, 0);
+    for (const auto i : typeIndices) {
+      sizes[owners_[i]] += parameters_[i].elements();
+    }
+    bucket.partSize = *std::max_element(sizes.begin(), sizes.end());
+    if (bucket.partSize == 0) {
+      continue;
+    }
+    // the next offset in the part of each process
+    std::vector<Dim> ends(worldSize_);
+    for (int rank = 0; rank < worldSize_; ++rank) {
+      ends[rank] = rank * bucket.partSize;
+    }
+    for (const auto i : typeIndices) {
+      bucket.offsets.emplace_back(i, ends[owners_[i]]);
+      ends[owners_[i]] += parameters_[i].elements();
+    }
+    buckets.push_back(std::move(bucket));
+  }
+  return buckets;
+}
+
+void ShardedOptimizer::step() {
+  if (getWorldSize() != worldSize_) {
+    throw std::runtime_error(
+        "[ShardedOptimizer::step] the optimizer is sharded across " +
+        std::to_string(worldSize_) + " processes, but the world size is " +
+        std::to_string(getWorldSize()));
+  }
+  const int rank = getWorldRank();
+  const auto buckets = getBuckets();
+
+  if (worldSize_ > 1) {
+    for (const auto& bucket : buckets) {
+      auto flat = fl::full({bucket.partSize * worldSize_}, 0, bucket.type);
+      for (const auto& [i, offset] : bucket.offsets) {
+        auto& param = parameters_[i];
+        if (!param.isGradAvailable() || param.elements() == 0) {
+          continue;
+        }
+        if (param.grad().isRowSparse()) {
+          throw std::invalid_argument(
+              "[ShardedOptimizer::step] row-sparse gradients aren't "
+              "supported over multiple processes");
+        }
+        flat(fl::range(offset, offset + param.elements())) =
+            param.grad().tensor().flatten();
+      }
+      auto part = reduceScatter(flat);
+      if (scale_ != 1.0) {
+        part *= scale_;
+      }
+      const Dim start = rank * bucket.partSize;
+      for (const auto& [i, offset] : bucket.offsets) {
+        auto& param = parameters_[i];
+        if (owners_[i] != rank || param.elements() == 0) {
+          continue;
+        }
+        auto grad = fl::reshape(
+            part(fl::range(offset - start, offset - start + param.elements())),
+            param.shape());
+        param.zeroGrad();
+        param.addGrad(Variable(grad, false));
+      }
+    }
+  } else if (scale_ != 1.0) {
+    for (auto& param : parameters_) {
+      if (param.isGradAvailable()) {
+        allReduce(param.grad(), scale_);
+      }
+    }
+  }
+
+  optimizer_->setLr(lr_);
+  optimizer_->setMultiTensor(multiTensor_);
+  optimizer_->setLazySparse(lazySparse_);
+  optimizer_->step();
+
+  if (worldSize_ > 1) {
+    for (const auto& bucket : buckets) {
+      auto part = fl::full({bucket.partSize}, 0, bucket.type);
+      const Dim start = rank * bucket.partSize;
+      for (const auto& [i, offset] : bucket.offsets) {
+        const auto& param = parameters_[i];
+        if (owners_[i] != rank || param.elements() == 0) {
+          continue;
+        }
+        part(fl::range(offset - start, offset - start + param.elements())) =
+            param.tensor().flatten();
+      }
+      auto flat = allGather(part);
+      for (const auto& [i, offset] : bucket.offsets) {
+        auto& param = parameters_[i];
+        if (owners_[i] == rank || param.elements() == 0) {
+          continue;
+        }
+        param.tensor() = fl::reshape(
+            flat(fl::range(offset, offset + param.elements())), param.shape());
+      }
+    }
+  }
+}
+
+const std::vector<int>& ShardedOptimizer::owners() const {
+  return owners_;
+}
+
+FirstOrderOptimizer& ShardedOptimizer::optimizer() {
+  return *optimizer_;
+}
+
+std::string ShardedOptimizer::prettyString() const {
+  std::ostringstream ss;
+  ss << "Sharded (" << worldSize_ << " processes) "
+     << optimizer_->prettyString();
+  return ss.str();
+}
+
+} // namespace fl
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flashlight/fl/common/Serialization.h"
+#include "flashlight/fl/optim/Optimizers.h"
+
+namespace fl {
+
+/**
+ * An optimizer whose state is sharded across the processes of data-parallel
+ * training, as in stage 1 of ZeRO (https://arxiv.org/abs/1910.02054). Each
+ * parameter is owned by one process, with the parameters balanced by size,
+ * and each process holds the state of an optimizer of its own parameters.
+ *
+ * A step reduce-scatters the gradients, such that each process gets the sum of
+ * those of its parameters, steps the optimizer of these, and all-gathers the
+ * updated parameters. Gradients shouldn't be synchronized beforehand, e.g. by
+ * a `Reducer`. Parameters without a gradient contribute zeros, and row-sparse
+ * gradients aren't supported over multiple processes.
+ *
+ * The learning rate and multi-tensor setting of the optimizer are those of
+ * this one. Each process serializes the state of its own parameters, so each
+ * process saves and loads its own checkpoint of the optimizer, and a
+ * checkpoint can only be loaded by a process of the same rank and world size.
+ *
+ * Example:
+ * \code
+   fl::ShardedOptimizer optimizer(
+       model.parameters(),
+       [](const std::vector<fl::Variable>& params) {
+         return std::make_shared<fl::AdamOptimizer>(params, 1e-3);
+       },
+       1.0 / fl::getWorldSize());
+   auto loss = criterion(model(input), target);
+   loss.backward();
+   optimizer.step();
+   optimizer.zeroGrad();
+ * \endcode
+ */
+class ShardedOptimizer : public FirstOrderOptimizer {
+ public:
+  /**
+   * @param[in] parameters the parameters from e.g. `model.parameters()`, in
+   * the same order on all processes.
+   * @param[in] makeOptimizer creates the optimizer of the parameters of this
+   * process, whose learning rate is that of this optimizer.
+   * @param[in] scale scale the summed gradients by this factor, e.g. by the
+   * inverse of the world size to average them.
+   */
+  ShardedOptimizer(
+      const std::vector<Variable>& parameters,
+      const OptimizerFactory& makeOptimizer,
+      double scale = 1.0);
+
+  void step() override;
+
+  /**
+   * @return the rank of the process owning each parameter
+   */
+  const std::vector<int>& owners() const;
+
+  /**
+   * @return the optimizer of the parameters of this process
+   */
+  FirstOrderOptimizer& optimizer();
+
+  std::string prettyString() const override;
+
+ private:
+  FL_SAVE_LOAD_WITH_BASE(
+      FirstOrderOptimizer,
+      optimizer_,
+      owners_,
+      worldSize_,
+      fl::serializeAs<double>(scale_))
+
+  ShardedOptimizer() = default; // Intentionally private
+
+  struct Bucket;
+
+  // Lays out the parameters of each type by owner, in equal parts per process
+  std::vector<Bucket> getBuckets() const;
+
+  std::shared_ptr<FirstOrderOptimizer> optimizer_;
+  std::vector<int> owners_;
+  int worldSize_;
+  double scale_;
+};
+
+} // namespace fl
+
+CEREAL_REGISTER_TYPE(fl::ShardedOptimizer)
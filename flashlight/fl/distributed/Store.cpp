@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/distributed/Store.h"
+
+namespace fl {
+
+namespace detail {
+
+std::vector<std::vector<char>> Store::get(
+    const std::vector<std::string>& keys) {
+  std::vector<std::vector<char>> result;
+  result.reserve(keys.size());
+  for (const auto& key : keys) {
+    result.push_back(get(key));
+  }
+  return result;
+}
+
+void Store::wait(const std::vector<std::string>& keys) {
+  get(keys);
+}
+
+} // namespace detail
+
+} // namespace fl
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace fl {
+
+namespace detail {
+
+/**
+ * A key-value store shared by the processes of a job, through which they
+ * exchange the data needed to initialize communication. Keys are set once,
+ * and reads block until their keys are set.
+ */
+class Store {
+ public:
+  virtual ~Store() = default;
+
+  /**
+   * Sets a key, which must not be set already.
+   */
+  virtual void set(const std::string& key, const std::vector<char>& data) = 0;
+
+  /**
+   * Returns the data of a key, once it's set.
+   */
+  virtual std::vector<char> get(const std::string& key) = 0;
+
+  /**
+   * Returns the data of several keys, once they're all set.
+   */
+  virtual std::vector<std::vector<char>> get(
+      const std::vector<std::string>& keys);
+
+  /**
+   * Blocks until all given keys are set.
+   */
+  virtual void wait(const std::vector<std::string>& keys);
+
+  /**
+   * Removes a key.
+   */
+  virtual void clear(const std::string& key) = 0;
+};
+
+} // namespace detail
+
+} // namespace fl
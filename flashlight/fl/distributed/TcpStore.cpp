@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/distributed/TcpStore.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+// A request is a command, a number of keys and the keys, each prefixed by its
+// size, followed by the value for a set. A response is a status, and for a get
+// the number of values and the values, each prefixed by its size.
+constexpr char kSet = 0;
+constexpr char kGet = 1;
+constexpr char kWait = 2;
+constexpr char kClear = 3;
+
+constexpr char kOk = 0;
+constexpr char kKeyExists = 1;
+
+using Clock = std::chrono::steady_clock;
+
+std::runtime_error socketError(const std::string& what) {
+  return std::runtime_error(
+      "TcpStore: " + what + " failed: " + std::strerror(errno));
+}
+
+void sendAll(int fd, const std::vector<char>& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    auto n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw socketError("send");
+    }
+    sent += n;
+  }
+}
+
+// Receives exactly `size` bytes, or returns false if the peer disconnected.
+// Throws if the deadline passes, if given.
+bool recvAll(
+    int fd,
+    void* data,
+    size_t size,
+    const Clock::time_point* deadline = nullptr) {
+  auto* cur = static_cast<char*>(data);
+  while (size > 0) {
+    if (deadline) {
+      const auto remaining =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              *deadline - Clock::now());
+      pollfd pfd{fd, POLLIN, 0};
+      int ready = remaining.count() > 0
+          ? ::poll(&pfd, 1, static_cast<int>(remaining.count()))
+          : 0;
+      if (ready < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ready < 0) {
+        throw socketError("poll");
+      }
+      if (ready == 0) {
+        throw std::runtime_error("TcpStore: timed out");
+      }
+    }
+    auto n = ::recv(fd, cur, size, 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      throw socketError("recv");
+    }
+    if (n == 0) {
+      return false;
+    }
+    cur += n;
+    size -= n;
+  }
+  return true;
+}
+
+void appendSize(std::vector<char>& buffer, uint32_t size) {
+  const auto* sizeBytes = reinterpret_cast<const char*>(&size);
+  buffer.insert(buffer.end(), sizeBytes, sizeBytes + sizeof(size));
+}
+
+void appendBytes(std::vector<char>& buffer, const char* data, uint32_t size) {
+  appendSize(buffer, size);
+  buffer.insert(buffer.end(), data, data + size);
+}
+
+// Receives a size-prefixed string of bytes
+bool recvBytes(
+    int fd,
+    std::vector<char>& data,
+    const Clock::time_point* deadline = nullptr) {
+  uint32_t size;
+  if (!recvAll(fd, &size, sizeof(size), deadline)) {
+    return false;
+  }
+  data.resize(size);
+  return recvAll(fd, data.data(), size, deadline);
+}
+
+void setNoDelay(int fd) {
+  int one = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+} // namespace
+
+namespace fl {
+
+namespace detail {
+
+constexpr std::chrono::milliseconds TcpStore::kDefaultTimeout;
+
+// Serves the store on a thread, which polls the connections of all clients.
+// Gets and waits for keys which aren't set are answered once they're set.
+class TcpStore::Server {
+ public:
+  explicit Server(int port) {
+    listenFd_ = ::socket(AF_INET6, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+      throw socketError("socket");
+    }
+    int one = 1;
+    int zero = 0;
+    ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    // accept IPv4 connections too
+    ::setsockopt(listenFd_, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+    sockaddr_in6 addr{};
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(port);
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) <
+            0 ||
+        ::listen(listenFd_, SOMAXCONN) < 0) {
+      auto error = socketError("bind on port " + std::to_string(port));
+      ::close(listenFd_);
+      throw error;
+    }
+    if (::pipe(wakeFds_) < 0) {
+      auto error = socketError("pipe");
+      ::close(listenFd_);
+      throw error;
+    }
+    thread_ = std::thread([this]() { run(); });
+  }
+
+  ~Server() {
+    char stop = 0;
+    while (::write(wakeFds_[1], &stop, 1) < 0 && errno == EINTR) {
+    }
+    thread_.join();
+    for (int fd : clients_) {
+      ::close(fd);
+    }
+    ::close(listenFd_);
+    ::close(wakeFds_[0]);
+    ::close(wakeFds_[1]);
+  }
+
+ private:
+  struct Waiter {
+    int fd;
+    char command;
+    std::vector<std::string> keys;
+  };
+
+  void run() {
+    while (true) {
+      std::vector<pollfd> fds = {
+          {wakeFds_[0], POLLIN, 0}, {listenFd_, POLLIN, 0}};
+      for (int fd : clients_) {
+        fds.push_back({fd, POLLIN, 0});
+      }
+      if (::poll(fds.data(), fds.size(), -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      if (fds[0].revents) {
+        return;
+      }
+      if (fds[1].revents & POLLIN) {
+        int fd = ::accept(listenFd_, nullptr, nullptr);
+        if (fd >= 0) {
+          setNoDelay(fd);
+          clients_.push_back(fd);
+        }
+      }
+      std::unordered_set<int> closed;
+      for (size_t i = 2; i < fds.size(); ++i) {
+        if (fds[i].revents && !handle(fds[i].fd)) {
+          closed.insert(fds[i].fd);
+        }
+      }
+      if (!closed.empty()) {
+        for (int fd : closed) {
+          ::close(fd);
+        }
+        auto isClosed = [&closed](int fd) { return closed.count(fd) > 0; };
+        clients_.erase(
+            std::remove_if(clients_.begin(), clients_.end(), isClosed),
+            clients_.end());
+        waiters_.erase(
+            std::remove_if(
+                waiters_.begin(),
+                waiters_.end(),
+                [&isClosed](const Waiter& w) { return isClosed(w.fd); }),
+            waiters_.end());
+      }
+    }
+  }
+
+  // Handles a request, and returns false if the client disconnected
+  bool handle(int fd) {
+    try {
+      char command;
+      uint32_t numKeys;
+      if (!recvAll(fd, &command, 1) ||
+          !recvAll(fd, &numKeys, sizeof(numKeys))) {
+        return false;
+      }
+      Waiter request{fd, command, std::vector<std::string>(numKeys)};
+      std::vector<char> bytes;
+      for (auto& key : request.keys) {
+        if (!recvBytes(fd, bytes)) {
+          return false;
+        }
+        key.assign(bytes.begin(), bytes.end());
+      }
+
+      if (command == kSet) {
+        std::vector<char> value;
+        if (request.keys.size() != 1 || !recvBytes(fd, value)) {
+          return false;
+        }
+        const auto& key = request.keys.front();
+        if (data_.count(key)) {
+          sendAll(fd, {kKeyExists});
+          return true;
+        }
+        data_.emplace(key, std::move(value));
+        sendAll(fd, {kOk});
+        respondToWaiters();
+      } else if (command == kGet || command == kWait) {
+        if (isSet(request.keys)) {
+          respond(request);
+        } else {
+          waiters_.push_back(std::move(request));
+        }
+      } else if (command == kClear) {
+        for (const auto& key : request.keys) {
+          data_.erase(key);
+        }
+        sendAll(fd, {kOk});
+      } else {
+        return false;
+      }
+      return true;
+    } catch (const std::exception&) {
+      return false;
+    }
+  }
+
+  bool isSet(const std::vector<std::string>& keys) const {
+    return std::all_of(keys.begin(), keys.end(), [this](const auto& key) {
+      return data_.count(key) > 0;
+    });
+  }
+
+  void respond(const Waiter& waiter) {
+    std::vector<char> response = {kOk};
+    if (waiter.command == kGet) {
+      appendSize(response, waiter.keys.size());
+      for (const auto& key : waiter.keys) {
+        const auto& value = data_.at(key);
+        appendBytes(response, value.data(), value.size());
+      }
+    }
+    sendAll(waiter.fd, response);
+  }
+
+  void respondToWaiters() {
+    for (auto it = waiters_.begin(); it != waiters_.end();) {
+      if (isSet(it->keys)) {
+        try {
+          respond(*it);
+        } catch (const std::exception&) {
+          // the client is closed when polled next
+        }
+        it = waiters_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  int listenFd_{-1};
+  int wakeFds_[2] = {-1, -1};
+  std::thread thread_;
+  std::vector<int> clients_;
+  std::vector<Waiter> waiters_;
+  std::unordered_map<std::string, std::vector<char>> data_;
+};
+
+TcpStore::TcpStore(
+    const std::string& host,
+    int port,
+    bool isServer,
+    std::chrono::milliseconds timeout /* = kDefaultTimeout */)
+    : timeout_(timeout) {
+  if (isServer) {
+    server_ = std::make_unique<Server>(port);
+  }
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  const auto deadline = Clock::now() + timeout_;
+  while (socket_ < 0) {
+    addrinfo* addrs = nullptr;
+    if (::getaddrinfo(
+            host.c_str(), std::to_string(port).c_str(), &hints, &addrs) == 0) {
+      for (auto* addr = addrs; addr && socket_ < 0; addr = addr->ai_next) {
+        int fd =
+            ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (fd < 0) {
+          continue;
+        }
+        if (::connect(fd, addr->ai_addr, addr->ai_addrlen) == 0) {
+          socket_ = fd;
+        } else {
+          ::close(fd);
+        }
+      }
+      ::freeaddrinfo(addrs);
+    }
+    if (socket_ < 0) {
+      if (Clock::now() > deadline) {
+        throw std::runtime_error(
+            "TcpStore: timed out connecting to " + host + ":" +
+            std::to_string(port));
+      }
+      // the server may not be up yet
+      /* sleep override */
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+  }
+  setNoDelay(socket_);
+}
+
+TcpStore::~TcpStore() {
+  if (socket_ >= 0) {
+    ::close(socket_);
+  }
+}
+
+std::vector<std::vector<char>> TcpStore::request(
+    char command,
+    const std::vector<std::string>& keys,
+    const std::vector<char>* data /* = nullptr */) {
+  std::vector<char> message = {command};
+  appendSize(message, keys.size());
+  for (const auto& key : keys) {
+    appendBytes(message, key.data(), key.size());
+  }
+  if (data) {
+    appendBytes(message, data->data(), data->size());
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  sendAll(socket_, message);
+  const auto deadline = Clock::now() + timeout_;
+  char status;
+  std::vector<std::vector<char>> values;
+  try {
+    if (!recvAll(socket_, &status, 1, &deadline)) {
+      throw std::runtime_error("TcpStore: the server disconnected");
+    }
+    if (status == kOk && command == kGet) {
+      uint32_t numValues;
+      if (!recvAll(socket_, &numValues, sizeof(numValues), &deadline)) {
+        throw std::runtime_error("TcpStore: the server disconnected");
+      }
+      values.resize(numValues);
+      for (auto& value : values) {
+        if (!recvBytes(socket_, value, &deadline)) {
+          throw std::runtime_error("TcpStore: the server disconnected");
+        }
+      }
+    }
+  } catch (const std::runtime_error& e) {
+    std::string keyList;
+    for (const auto& key : keys) {
+      keyList += (keyList.empty() ? "" : ", ") + key;
+    }
+    throw std::runtime_error(std::string(e.what()) + " for keys: " + keyList);
+  }
+  if (status == kKeyExists) {
+    throw std::runtime_error("TcpStore set: key already exists: " + keys[0]);
+  }
+  return values;
+}
+
+void TcpStore::set(const std::string& key, const std::vector<char>& data) {
+  request(kSet, {key}, &data);
+}
+
+std::vector<char> TcpStore::get(const std::string& key) {
+  return std::move(request(kGet, {key}).front());
+}
+
+std::vector<std::vector<char>> TcpStore::get(
+    const std::vector<std::string>& keys) {
+  return request(kGet, keys);
+}
+
+void TcpStore::wait(const std::vector<std::string>& keys) {
+  request(kWait, keys);
+}
+
+void TcpStore::clear(const std::string& key) {
+  request(kClear, {key});
+}
+
+} // namespace detail
+
+} // namespace fl
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "flashlight/fl/distributed/Store.h"
+
+namespace fl {
+
+namespace detail {
+
+/**
+ * A `Store` served over TCP by one process, typically of rank 0, to which all
+ * processes connect, as a faster alternative to a `FileStore` on a shared
+ * filesystem for jobs of many processes. The store only lasts as long as the
+ * serving process's instance, so the serving process should wait for the
+ * others to be done with it, e.g. for a key set by each of them.
+ *
+ * Reads of keys which aren't set yet are answered by the server once they're
+ * set, rather than polled.
+ */
+class TcpStore : public Store {
+ public:
+  static constexpr std::chrono::milliseconds kDefaultTimeout =
+      std::chrono::seconds(60 * 2);
+
+  /**
+   * Connects to the store, retrying until the timeout while the server isn't
+   * up.
+   *
+   * @param[in] host the host name or address of the serving process
+   * @param[in] port the port of the store
+   * @param[in] isServer whether this process serves the store, on `port` of
+   * all its interfaces
+   * @param[in] timeout the time after which connecting, or waiting for a key,
+   * fails
+   */
+  TcpStore(
+      const std::string& host,
+      int port,
+      bool isServer,
+      std::chrono::milliseconds timeout = kDefaultTimeout);
+  ~TcpStore() override;
+
+  TcpStore(const TcpStore&) = delete;
+  TcpStore& operator=(const TcpStore&) = delete;
+
+  void set(const std::string& key, const std::vector<char>& data) override;
+  std::vector<char> get(const std::string& key) override;
+  std::vector<std::vector<char>> get(
+      const std::vector<std::string>& keys) override;
+  void wait(const std::vector<std::string>& keys) override;
+  void clear(const std::string& key) override;
+
+ private:
+  class Server;
+
+  // Sends a request, and returns the values of the response, or throws after
+  // the timeout
+  std::vector<std::vector<char>> request(
+      char command,
+      const std::vector<std::string>& keys,
+      const std::vector<char>* data = nullptr);
+
+  std::unique_ptr<Server> server_;
+  int socket_{-1};
+  std::chrono::milliseconds timeout_;
+  // requests are answered in order, so are sent one at a time
+  std::mutex mutex_;
+};
+
+} // namespace detail
+
+} // namespace fl
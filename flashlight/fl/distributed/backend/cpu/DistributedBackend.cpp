@@ -7,20 +7,37 @@
 
 #include "flashlight/fl/distributed/DistributedApi.h"
 
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include <gloo/allgather_ring.h>
+#include <gloo/allreduce_bcube.h>
 #include <gloo/allreduce_halving_doubling.h>
+#include <gloo/allreduce_ring_chunked.h>
+#include <gloo/broadcast_one_to_all.h>
 #include <gloo/config.h>
 #include <gloo/mpi/context.h>
+#include <gloo/reduce_scatter.h>
 #include <gloo/transport/tcp/device.h>
 #include <mpi.h>
 
+#include "flashlight/fl/common/Defines.h"
 #include "flashlight/fl/common/DevicePtr.h"
+#include "flashlight/fl/common/threadpool/ThreadPool.h"
+#include "flashlight/fl/distributed/CommProfiler.h"
 #include "flashlight/fl/distributed/LRUCache.h"
+#include "flashlight/fl/tensor/Profile.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
 namespace {
@@ -39,6 +56,52 @@ const int kGlooCacheSize_ = 10;
 using CacheType = fl::detail::LRUCache<std::string, gloo::Algorithm>;
 CacheType glooCache_(kGlooCacheSize_);
 fl::Tensor cacheTensor_;
+// the output of allGather, the input of which is in cacheTensor_
+fl::Tensor gatherCacheTensor_;
+
+// Grows a cache tensor to at least the given number of bytes
+void reserveCache(fl::Tensor& cache, size_t bytes) {
+  if (bytes > cache.elements()) {
+    cache = fl::Tensor({static_cast<long long>(bytes)}, fl::dtype::b8);
+  }
+}
+
+// Allreduces of fewer bytes use bcube, which takes the fewest steps, and
+// allreduces of more bytes use a chunked ring, which uses the bandwidth best;
+// halving-doubling is in between
+constexpr size_t kGlooSmallMessageBytes = 64 << 10;
+constexpr size_t kGlooLargeMessageBytes = 4 << 20;
+std::string glooAlgorithm_ = fl::DistributedConstants::kGlooAlgorithmAuto;
+
+// A thread running the asynchronous operations given to it in order, with its
+// own Gloo context such that operations of different threads run in parallel.
+// Processes give the same operations to the same thread.
+struct CommWorker {
+  std::shared_ptr<gloo::mpi::Context> context;
+  CacheType cache{kGlooCacheSize_};
+  // the buffers reduced in place, with the same roles as cacheTensor_ and
+  // gatherCacheTensor_
+  std::vector<char> buffer;
+  std::vector<char> gatherBuffer;
+  fl::ThreadPool thread{1};
+};
+constexpr int kDefaultCommThreads = 2;
+std::vector<std::unique_ptr<CommWorker>> commWorkers_;
+size_t nextCommWorker_ = 0;
+// the worker of point-to-point operations, which only involve some processes
+// so can't be spread over workers in turn
+std::unique_ptr<CommWorker> p2pWorker_;
+constexpr int kGlooP2PSlot = 0;
+// the names of the algorithms of other collectives than allreduce, as
+// recorded by the CommProfiler
+constexpr const char* kGlooReduceScatterAlgorithm = "halving_doubling";
+constexpr const char* kGlooAllGatherAlgorithm = "ring";
+constexpr const char* kGlooBroadcastAlgorithm = "one_to_all";
+constexpr const char* kGlooP2PAlgorithm = "p2p";
+// the asynchronous operations which haven't been synchronized, and the tensors
+// they access, which are locked until then
+std::vector<std::shared_future<void>> pendingOps_;
+std::vector<std::shared_ptr<fl::DevicePtr>> pendingPtrs_;
 } // namespace
 
 namespace fl {
@@ -49,29 +112,234 @@ std::shared_ptr<gloo::mpi::Context> globalContext() {
   return glooContext_;
 }
 
+// The allreduce algorithm for a message of the given size
+std::string getAllreduceAlgorithm(size_t bytes, size_t count, int worldSize) {
+  if (glooAlgorithm_ != DistributedConstants::kGlooAlgorithmAuto) {
+    return glooAlgorithm_;
+  }
+  // bcube splits messages across processes
+  if (bytes < kGlooSmallMessageBytes &&
+      count >= static_cast<size_t>(worldSize)) {
+    return DistributedConstants::kGlooAlgorithmBcube;
+  }
+  if (bytes >= kGlooLargeMessageBytes) {
+    return DistributedConstants::kGlooAlgorithmRing;
+  }
+  return DistributedConstants::kGlooAlgorithmHalvingDoubling;
+}
+
 template <typename T>
-inline void allreduceGloo(T* ptr, size_t s) {
-  auto key = detail::makeHashKey(ptr, s, "allreduceCpu");
-  auto algorithm = glooCache_.get(key);
+inline void allreduceGloo(
+    const std::shared_ptr<gloo::mpi::Context>& context,
+    CacheType& cache,
+    T* ptr,
+    size_t s) {
+  const auto algorithmName =
+      getAllreduceAlgorithm(s * sizeof(T), s, context->size);
+  auto key = detail::makeHashKey(ptr, s, "allreduceCpu", algorithmName);
+  auto algorithm = cache.get(key);
   if (algorithm == nullptr) {
-    using Allreduce = gloo::AllreduceHalvingDoubling<T>;
-    algorithm = glooCache_.put(
+    std::unique_ptr<gloo::Algorithm> allreduce;
+    const std::vector<T*> ptrs({ptr});
+    if (algorithmName == DistributedConstants::kGlooAlgorithmRing) {
+      allreduce = std::make_unique<gloo::AllreduceRingChunked<T>>(
+          context, ptrs, s, gloo::ReductionFunction<T>::sum);
+    } else if (algorithmName == DistributedConstants::kGlooAlgorithmBcube) {
+      allreduce = std::make_unique<gloo::AllreduceBcube<T>>(
+          context, ptrs, s, gloo::ReductionFunction<T>::sum);
+    } else {
+      allreduce = std::make_unique<gloo::AllreduceHalvingDoubling<T>>(
+          context, ptrs, s, gloo::ReductionFunction<T>::sum);
+    }
+    algorithm = cache.put(key, std::move(allreduce));
+  }
+  algorithm->run();
+}
+
+// Calls `f` with a null pointer to the type of the elements of a tensor
+template <typename F>
+void dispatchGlooType(fl::dtype type, const std::string& op, F&& f) {
+  switch (type) {
+    case fl::dtype::f32:
+      f(static_cast<float*>(nullptr));
+      break;
+    case fl::dtype::f64:
+      f(static_cast<double*>(nullptr));
+      break;
+    case fl::dtype::s32:
+      f(static_cast<int*>(nullptr));
+      break;
+    case fl::dtype::s64:
+      f(static_cast<int64_t*>(nullptr));
+      break;
+    default:
+      throw std::runtime_error(
+          "unsupported data type for " + op + " with gloo");
+  }
+}
+
+// Allreduces `count` elements of the given type in place
+void allreduceGloo(
+    const std::shared_ptr<gloo::mpi::Context>& context,
+    CacheType& cache,
+    void* ptr,
+    fl::dtype type,
+    size_t count) {
+  dispatchGlooType(type, "allreduce", [&](auto* typed) {
+    using T = std::remove_pointer_t<decltype(typed)>;
+    allreduceGloo(context, cache, static_cast<T*>(ptr), count);
+  });
+}
+
+// Sums `ptr` over all processes, leaving the part of the current process at
+// its offset in `ptr`
+template <typename T>
+inline void reduceScatterGloo(
+    const std::shared_ptr<gloo::mpi::Context>& context,
+    CacheType& cache,
+    T* ptr,
+    size_t s) {
+  auto key = detail::makeHashKey(ptr, s, "reduceScatterCpu");
+  auto algorithm = cache.get(key);
+  if (algorithm == nullptr) {
+    const int size = context->size;
+    using ReduceScatter = gloo::ReduceScatterHalvingDoubling<T>;
+    algorithm = cache.put(
         key,
-        std::make_unique<Allreduce>(
-            globalContext(),
+        std::make_unique<ReduceScatter>(
+            context,
             std::vector<T*>({ptr}),
             s,
+            std::vector<int>(size, s / size),
             gloo::ReductionFunction<T>::sum));
   }
   algorithm->run();
 }
+
+template <typename T>
+inline void allGatherGloo(
+    const std::shared_ptr<gloo::mpi::Context>& context,
+    CacheType& cache,
+    const T* in,
+    T* out,
+    size_t s) {
+  auto key = detail::makeHashKey(out, in, s, "allGatherCpu");
+  auto algorithm = cache.get(key);
+  if (algorithm == nullptr) {
+    using Allgather = gloo::AllgatherRing<T>;
+    algorithm = cache.put(
+        key,
+        std::make_unique<Allgather>(
+            context, std::vector<const T*>({in}), out, s));
+  }
+  algorithm->run();
+}
+
+template <typename T>
+inline void broadcastGloo(
+    const std::shared_ptr<gloo::mpi::Context>& context,
+    CacheType& cache,
+    T* ptr,
+    size_t s,
+    int root) {
+  auto key = detail::makeHashKey(ptr, s, "broadcastCpu", root);
+  auto algorithm = cache.get(key);
+  if (algorithm == nullptr) {
+    using Broadcast = gloo::BroadcastOneToAll<T>;
+    algorithm = cache.put(
+        key,
+        std::make_unique<Broadcast>(context, std::vector<T*>({ptr}), s, root));
+  }
+  algorithm->run();
+}
+
+// Grows the buffer of a worker to at least the given number of bytes
+char* reserveBuffer(std::vector<char>& buffer, size_t bytes) {
+  if (buffer.size() < bytes) {
+    buffer.resize(bytes);
+  }
+  return buffer.data();
+}
+
+CommWorker& nextCommWorker() {
+  auto& worker = *commWorkers_[nextCommWorker_];
+  nextCommWorker_ = (nextCommWorker_ + 1) % commWorkers_.size();
+  return worker;
+}
+
+// Runs an operation on the thread of a worker, with the data of the tensors it
+// accesses, which are locked until it's done. The operation is profiled as a
+// collective of the given type, algorithm and size.
+DistributedWork runAsync(
+    CommWorker& worker,
+    const std::vector<const fl::Tensor*>& tensors,
+    CollectiveType type,
+    std::string algorithm,
+    size_t bytes,
+    std::function<void(CommWorker&, const std::vector<void*>&)> op) {
+  std::vector<std::shared_ptr<DevicePtr>> ptrs;
+  std::vector<void*> data;
+  for (const auto* tensor : tensors) {
+    ptrs.push_back(std::make_shared<DevicePtr>(*tensor));
+    data.push_back(ptrs.back()->get());
+  }
+  auto done = worker.thread
+                  .enqueue([&worker,
+                            data,
+                            type,
+                            algorithm = std::move(algorithm),
+                            bytes,
+                            op = std::move(op)]() {
+                    CommProfileRange range(type, algorithm, bytes);
+                    op(worker, data);
+                  })
+                  .share();
+  pendingOps_.push_back(done);
+  pendingPtrs_.insert(pendingPtrs_.end(), ptrs.begin(), ptrs.end());
+  return DistributedWork([done, ptrs]() { done.get(); });
+}
+
+// Allreduces tensors of the same type in the buffer of a worker, coalesced
+void allreduceAsync(const std::vector<fl::Tensor*>& tensors) {
+  const auto type = tensors.front()->type();
+  std::vector<size_t> bytes;
+  size_t count = 0;
+  size_t totalBytes = 0;
+  for (auto* tensor : tensors) {
+    bytes.push_back(tensor->bytes());
+    count += tensor->elements();
+    totalBytes += tensor->bytes();
+  }
+  auto& commWorker = nextCommWorker();
+  runAsync(
+      commWorker,
+      std::vector<const fl::Tensor*>(tensors.begin(), tensors.end()),
+      CollectiveType::AllReduce,
+      getAllreduceAlgorithm(totalBytes, count, commWorker.context->size),
+      totalBytes,
+      [bytes, type, count, totalBytes](
+          CommWorker& worker, const std::vector<void*>& data) {
+        auto* buffer = reserveBuffer(worker.buffer, totalBytes);
+        auto* cur = buffer;
+        for (size_t i = 0; i < data.size(); ++i) {
+          std::memcpy(cur, data[i], bytes[i]);
+          cur += bytes[i];
+        }
+        allreduceGloo(worker.context, worker.cache, buffer, type, count);
+        cur = buffer;
+        for (size_t i = 0; i < data.size(); ++i) {
+          std::memcpy(data[i], cur, bytes[i]);
+          cur += bytes[i];
+        }
+      });
+}
 } // namespace detail
 
 void distributedInit(
     DistributedInit initMethod,
     int /* worldRank */,
     int /* worldSize */,
-    const std::unordered_map<std::string, std::string>& /* params = {} */) {
+    const std::unordered_map<std::string, std::string>& params /* = {} */) {
   if (isDistributedInit()) {
     std::cerr << "warning: fl::distributedInit() called more than once\n";
     return;
@@ -94,6 +362,42 @@ void distributedInit(
   glooContext_->setTimeout(gloo::kNoTimeout);
   glooContext_->connectFullMesh(glooDev);
 
+  auto algorithm = params.find(DistributedConstants::kGlooAlgorithm);
+  if (algorithm != params.end()) {
+    glooAlgorithm_ = algorithm->second;
+    if (glooAlgorithm_ != DistributedConstants::kGlooAlgorithmAuto &&
+        glooAlgorithm_ != DistributedConstants::kGlooAlgorithmRing &&
+        glooAlgorithm_ != DistributedConstants::kGlooAlgorithmBcube &&
+        glooAlgorithm_ != DistributedConstants::kGlooAlgorithmHalvingDoubling) {
+      throw std::invalid_argument(
+          "distributedInit: unknown Gloo allreduce algorithm " +
+          glooAlgorithm_);
+    }
+  }
+
+  // a context per communication thread, connected in the same order by all
+  // processes
+  auto commThreads = params.find(DistributedConstants::kCommThreads);
+  const int numCommThreads = commThreads == params.end()
+      ? kDefaultCommThreads
+      : std::stoi(commThreads->second);
+  if (numCommThreads < 1) {
+    throw std::invalid_argument(
+        "distributedInit: the Gloo backend needs at least one communication "
+        "thread");
+  }
+  auto makeWorker = [&glooDev]() {
+    auto worker = std::make_unique<CommWorker>();
+    worker->context = gloo::mpi::Context::createManaged();
+    worker->context->setTimeout(gloo::kNoTimeout);
+    worker->context->connectFullMesh(glooDev);
+    return worker;
+  };
+  for (int i = 0; i < numCommThreads; ++i) {
+    commWorkers_.push_back(makeWorker());
+  }
+  p2pWorker_ = makeWorker();
+
   detail::DistributedInfo::getInstance().backend_ = DistributedBackend::GLOO;
   detail::DistributedInfo::getInstance().isInitialized_ = true;
   if (glooContext_->rank == 0) {
@@ -105,60 +409,354 @@ void allReduce(fl::Tensor& tensor, bool async /* = false */) {
   if (!isDistributedInit()) {
     throw std::runtime_error("distributed environment not initialized");
   }
+  FL_PROFILE_TRACE("allReduce");
   if (async) {
-    throw std::runtime_error(
-        "Asynchronous allReduce not yet supported for Gloo backend");
+    detail::allreduceAsync({&tensor});
+    return;
   }
   size_t tensorSize = tensor.elements() * fl::getTypeSize(tensor.type());
-  if (tensorSize > cacheTensor_.elements()) {
-    cacheTensor_ =
-        fl::Tensor({static_cast<long long>(tensorSize)}, fl::dtype::b8);
-  }
+  reserveCache(cacheTensor_, tensorSize);
   DevicePtr tensorPtr(tensor);
   DevicePtr cacheTensorPtr(cacheTensor_);
   memcpy(cacheTensorPtr.get(), tensorPtr.get(), tensorSize);
-  switch (tensor.type()) {
-    case fl::dtype::f32:
-      detail::allreduceGloo(
-          static_cast<float*>(cacheTensorPtr.get()), tensor.elements());
-      break;
-    case fl::dtype::f64:
-      detail::allreduceGloo(
-          static_cast<double*>(cacheTensorPtr.get()), tensor.elements());
-      break;
-    case fl::dtype::s32:
-      detail::allreduceGloo(
-          static_cast<int*>(cacheTensorPtr.get()), tensor.elements());
-      break;
-    case fl::dtype::s64:
-      detail::allreduceGloo(
-          static_cast<int64_t*>(cacheTensorPtr.get()), tensor.elements());
-      break;
-    default:
-      throw std::runtime_error("unsupported data type for allreduce with gloo");
-  }
+  CommProfileRange range(
+      CollectiveType::AllReduce,
+      detail::getAllreduceAlgorithm(
+          tensorSize, tensor.elements(), glooContext_->size),
+      tensorSize);
+  detail::allreduceGloo(
+      glooContext_,
+      glooCache_,
+      cacheTensorPtr.get(),
+      tensor.type(),
+      tensor.elements());
   memcpy(tensorPtr.get(), cacheTensorPtr.get(), tensorSize);
 }
 
-// Not yet supported
 void allReduceMultiple(
     std::vector<fl::Tensor*> tensors,
     bool async /* = false */,
     bool contiguous /* = false */) {
-  if (contiguous) {
+  if (!contiguous || tensors.empty()) {
+    for (auto& tensor : tensors) {
+      allReduce(*tensor, async);
+    }
+    return;
+  }
+
+  // We can only do a contiguous set reduction if all arrays in the set are of
+  // the same type, else fail
+  const auto type = tensors.front()->type();
+  size_t totalBytes = 0;
+  for (auto* tensor : tensors) {
+    if (tensor->type() != type) {
+      throw std::runtime_error(
+          "Cannot perform contiguous set allReduce on a set of tensors "
+          "of different types");
+    }
+    totalBytes += tensor->bytes();
+  }
+  // as with NCCL, contiguous reductions are at most the size of the coalescing
+  // cache of reducers
+  if (totalBytes > DistributedConstants::kCoalesceCacheSize) {
     throw std::runtime_error(
-        "contiguous allReduceMultiple is not yet supported for Gloo backend");
+        "Total coalesce buffer size is larger than existing buffer size");
+  }
+  FL_PROFILE_TRACE("allReduceMultiple");
+  if (async) {
+    detail::allreduceAsync(tensors);
+    return;
+  }
+
+  reserveCache(cacheTensor_, totalBytes);
+  DevicePtr cacheTensorPtr(cacheTensor_);
+  std::vector<DevicePtr> tensorPtrs;
+  auto* cur = static_cast<char*>(cacheTensorPtr.get());
+  size_t count = 0;
+  for (auto* tensor : tensors) {
+    tensorPtrs.emplace_back(*tensor);
+    memcpy(cur, tensorPtrs.back().get(), tensor->bytes());
+    cur += tensor->bytes();
+    count += tensor->elements();
+  }
+  {
+    CommProfileRange range(
+        CollectiveType::AllReduce,
+        detail::getAllreduceAlgorithm(totalBytes, count, glooContext_->size),
+        totalBytes);
+    detail::allreduceGloo(
+        glooContext_, glooCache_, cacheTensorPtr.get(), type, count);
+  }
+  cur = static_cast<char*>(cacheTensorPtr.get());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    memcpy(tensorPtrs[i].get(), cur, tensors[i]->bytes());
+    cur += tensors[i]->bytes();
+  }
+}
+
+namespace {
+
+void checkReduceScatterInput(const Tensor& arr) {
+  if (!isDistributedInit()) {
+    throw std::runtime_error("distributed environment not initialized");
+  }
+  if (arr.elements() % getWorldSize() != 0) {
+    throw std::invalid_argument(
+        "reduceScatter: the number of elements must be a multiple of the "
+        "world size");
+  }
+}
+
+void checkPeer(int peer, const std::string& op) {
+  if (!isDistributedInit()) {
+    throw std::runtime_error("distributed environment not initialized");
+  }
+  if (peer < 0 || peer >= getWorldSize() || peer == getWorldRank()) {
+    throw std::invalid_argument(
+        op + ": invalid peer rank " + std::to_string(peer));
   }
+}
+
+} // namespace
 
-  for (auto& tensor : tensors) {
-    allReduce(*tensor, async);
+Tensor reduceScatter(const Tensor& arr) {
+  checkReduceScatterInput(arr);
+  FL_PROFILE_TRACE("reduceScatter");
+  const size_t count = arr.elements() / getWorldSize();
+  const size_t typeSize = fl::getTypeSize(arr.type());
+  reserveCache(cacheTensor_, arr.elements() * typeSize);
+  auto output = Tensor({static_cast<Dim>(count)}, arr.type());
+  DevicePtr arrPtr(arr);
+  DevicePtr outputPtr(output);
+  DevicePtr cacheTensorPtr(cacheTensor_);
+  memcpy(cacheTensorPtr.get(), arrPtr.get(), arr.elements() * typeSize);
+  CommProfileRange range(
+      CollectiveType::ReduceScatter,
+      kGlooReduceScatterAlgorithm,
+      arr.elements() * typeSize);
+  detail::dispatchGlooType(arr.type(), "reduceScatter", [&](auto* typed) {
+    using T = std::remove_pointer_t<decltype(typed)>;
+    detail::reduceScatterGloo(
+        glooContext_,
+        glooCache_,
+        static_cast<T*>(cacheTensorPtr.get()),
+        arr.elements());
+  });
+  memcpy(
+      outputPtr.get(),
+      static_cast<char*>(cacheTensorPtr.get()) +
+          getWorldRank() * count * typeSize,
+      count * typeSize);
+  return output;
+}
+
+DistributedWork reduceScatterAsync(const Tensor& arr, Tensor& output) {
+  checkReduceScatterInput(arr);
+  const size_t elements = arr.elements();
+  const size_t count = elements / getWorldSize();
+  const auto type = arr.type();
+  const int rank = getWorldRank();
+  output = Tensor({static_cast<Dim>(count)}, type);
+  return detail::runAsync(
+      detail::nextCommWorker(),
+      {&arr, &output},
+      CollectiveType::ReduceScatter,
+      kGlooReduceScatterAlgorithm,
+      arr.bytes(),
+      [=](CommWorker& worker, const std::vector<void*>& data) {
+        const size_t typeSize = fl::getTypeSize(type);
+        auto* buffer =
+            detail::reserveBuffer(worker.buffer, elements * typeSize);
+        std::memcpy(buffer, data[0], elements * typeSize);
+        detail::dispatchGlooType(type, "reduceScatter", [&](auto* typed) {
+          using T = std::remove_pointer_t<decltype(typed)>;
+          detail::reduceScatterGloo(
+              worker.context,
+              worker.cache,
+              reinterpret_cast<T*>(buffer),
+              elements);
+        });
+        std::memcpy(
+            data[1], buffer + rank * count * typeSize, count * typeSize);
+      });
+}
+
+Tensor allGather(const Tensor& arr) {
+  if (!isDistributedInit()) {
+    throw std::runtime_error("distributed environment not initialized");
+  }
+  FL_PROFILE_TRACE("allGather");
+  const size_t count = arr.elements();
+  const size_t bytes = count * fl::getTypeSize(arr.type());
+  reserveCache(cacheTensor_, bytes);
+  reserveCache(gatherCacheTensor_, bytes * getWorldSize());
+  auto output = Tensor({static_cast<Dim>(count * getWorldSize())}, arr.type());
+  DevicePtr arrPtr(arr);
+  DevicePtr outputPtr(output);
+  DevicePtr cacheTensorPtr(cacheTensor_);
+  DevicePtr gatherCacheTensorPtr(gatherCacheTensor_);
+  memcpy(cacheTensorPtr.get(), arrPtr.get(), bytes);
+  CommProfileRange range(
+      CollectiveType::AllGather, kGlooAllGatherAlgorithm, output.bytes());
+  detail::dispatchGlooType(arr.type(), "allGather", [&](auto* typed) {
+    using T = std::remove_pointer_t<decltype(typed)>;
+    detail::allGatherGloo(
+        glooContext_,
+        glooCache_,
+        static_cast<const T*>(cacheTensorPtr.get()),
+        static_cast<T*>(gatherCacheTensorPtr.get()),
+        count);
+  });
+  memcpy(outputPtr.get(), gatherCacheTensorPtr.get(), bytes * getWorldSize());
+  return output;
+}
+
+DistributedWork allGatherAsync(const Tensor& arr, Tensor& output) {
+  if (!isDistributedInit()) {
+    throw std::runtime_error("distributed environment not initialized");
   }
+  const size_t count = arr.elements();
+  const auto type = arr.type();
+  const int worldSize = getWorldSize();
+  output = Tensor({static_cast<Dim>(count * worldSize)}, type);
+  return detail::runAsync(
+      detail::nextCommWorker(),
+      {&arr, &output},
+      CollectiveType::AllGather,
+      kGlooAllGatherAlgorithm,
+      output.bytes(),
+      [=](CommWorker& worker, const std::vector<void*>& data) {
+        const size_t bytes = count * fl::getTypeSize(type);
+        auto* in = detail::reserveBuffer(worker.buffer, bytes);
+        auto* out =
+            detail::reserveBuffer(worker.gatherBuffer, bytes * worldSize);
+        std::memcpy(in, data[0], bytes);
+        detail::dispatchGlooType(type, "allGather", [&](auto* typed) {
+          using T = std::remove_pointer_t<decltype(typed)>;
+          detail::allGatherGloo(
+              worker.context,
+              worker.cache,
+              reinterpret_cast<const T*>(in),
+              reinterpret_cast<T*>(out),
+              count);
+        });
+        std::memcpy(data[1], out, bytes * worldSize);
+      });
+}
+
+DistributedWork broadcastAsync(Tensor& arr, int root) {
+  if (!isDistributedInit()) {
+    throw std::runtime_error("distributed environment not initialized");
+  }
+  if (root < 0 || root >= getWorldSize()) {
+    throw std::invalid_argument(
+        "broadcast: invalid root rank " + std::to_string(root));
+  }
+  const size_t count = arr.elements();
+  const auto type = arr.type();
+  return detail::runAsync(
+      detail::nextCommWorker(),
+      {&arr},
+      CollectiveType::Broadcast,
+      kGlooBroadcastAlgorithm,
+      arr.bytes(),
+      [=](CommWorker& worker, const std::vector<void*>& data) {
+        const size_t bytes = count * fl::getTypeSize(type);
+        auto* buffer = detail::reserveBuffer(worker.buffer, bytes);
+        std::memcpy(buffer, data[0], bytes);
+        detail::dispatchGlooType(type, "broadcast", [&](auto* typed) {
+          using T = std::remove_pointer_t<decltype(typed)>;
+          detail::broadcastGloo(
+              worker.context,
+              worker.cache,
+              reinterpret_cast<T*>(buffer),
+              count,
+              root);
+        });
+        std::memcpy(data[0], buffer, bytes);
+      });
+}
+
+DistributedWork sendAsync(const Tensor& arr, int dst) {
+  checkPeer(dst, "send");
+  const size_t bytes = arr.bytes();
+  return detail::runAsync(
+      *p2pWorker_,
+      {&arr},
+      CollectiveType::Send,
+      kGlooP2PAlgorithm,
+      bytes,
+      [=](CommWorker& worker, const std::vector<void*>& data) {
+        auto buffer = worker.context->createUnboundBuffer(data[0], bytes);
+        buffer->send(dst, kGlooP2PSlot);
+        buffer->waitSend();
+      });
+}
+
+DistributedWork recvAsync(Tensor& arr, int src) {
+  checkPeer(src, "recv");
+  const size_t bytes = arr.bytes();
+  return detail::runAsync(
+      *p2pWorker_,
+      {&arr},
+      CollectiveType::Recv,
+      kGlooP2PAlgorithm,
+      bytes,
+      [=](CommWorker& worker, const std::vector<void*>& data) {
+        auto buffer = worker.context->createUnboundBuffer(data[0], bytes);
+        buffer->recv(src, kGlooP2PSlot);
+        buffer->waitRecv();
+      });
+}
+
+DistributedWork
+sendRecvAsync(const Tensor& sendArr, int dst, Tensor& recvArr, int src) {
+  checkPeer(dst, "sendRecv");
+  checkPeer(src, "sendRecv");
+  const size_t sendBytes = sendArr.bytes();
+  const size_t recvBytes = recvArr.bytes();
+  return detail::runAsync(
+      *p2pWorker_,
+      {&sendArr, &recvArr},
+      CollectiveType::SendRecv,
+      kGlooP2PAlgorithm,
+      sendBytes + recvBytes,
+      [=](CommWorker& worker, const std::vector<void*>& data) {
+        auto sendBuffer =
+            worker.context->createUnboundBuffer(data[0], sendBytes);
+        auto recvBuffer =
+            worker.context->createUnboundBuffer(data[1], recvBytes);
+        // both are posted before waiting, such that neither waits for the
+        // other
+        sendBuffer->send(dst, kGlooP2PSlot);
+        recvBuffer->recv(src, kGlooP2PSlot);
+        sendBuffer->waitSend();
+        recvBuffer->waitRecv();
+      });
 }
 
 void syncDistributed() {
-  // NOOP since async distributed operations aren't yet supported with the Gloo
-  // backend
-  return;
+  const auto start = CommProfiler::Clock::now();
+  // wait for all operations before rethrowing the first error, if any
+  std::exception_ptr error;
+  for (auto& op : pendingOps_) {
+    try {
+      op.get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (!pendingOps_.empty()) {
+    CommProfiler::getInstance().recordHostSyncWait(
+        start, CommProfiler::Clock::now());
+  }
+  pendingOps_.clear();
+  pendingPtrs_.clear();
+  if (error) {
+    std::rethrow_exception(error);
+  }
 }
 
 int getWorldRank() {
@@ -174,4 +772,9 @@ int getWorldSize() {
   }
   return detail::globalContext()->size;
 }
+
+void runOnDevices(const std::function<void(int worldRank)>& fn) {
+  // DistributedInit::LOCAL isn't supported, so a process is a single rank
+  fn(getWorldRank());
+}
 } // namespace fl
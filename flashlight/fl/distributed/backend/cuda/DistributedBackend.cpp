@@ -6,22 +6,32 @@
  */
 
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <mpi.h>
 #include <nccl.h>
 
 #include "flashlight/fl/common/Defines.h"
 #include "flashlight/fl/common/DevicePtr.h"
+#include "flashlight/fl/distributed/CommProfiler.h"
 #include "flashlight/fl/distributed/DistributedApi.h"
 #include "flashlight/fl/distributed/FileStore.h"
+#include "flashlight/fl/distributed/TcpStore.h"
 #include "flashlight/fl/runtime/CUDAStream.h"
 #include "flashlight/fl/runtime/CUDAUtils.h"
 #include "flashlight/fl/runtime/DeviceManager.h"
 #include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Profile.h"
 #include "flashlight/fl/tensor/Types.h"
 
 #define NCCLCHECK(expr) ::fl::detail::ncclCheck((expr))
@@ -33,10 +43,6 @@ namespace detail {
 
 namespace {
 
-// We need to pass this flag to our dedicated NCCL CUDA stream, else activity in
-// the stream will be precluded from running in parallel with the default stream
-constexpr unsigned int kDefaultStreamFlags = cudaStreamNonBlocking;
-
 constexpr const char* kNcclKey = "ncclUniqueId";
 
 class NcclContext {
@@ -49,18 +55,53 @@ class NcclContext {
       int worldRank,
       int worldSize,
       const std::unordered_map<std::string, std::string>& params);
+  void initWithTcp(
+      int worldRank,
+      int worldSize,
+      const std::unordered_map<std::string, std::string>& params);
+  // Initializes the context of a rank of a DistributedInit::LOCAL
+  // environment, from its communicator, on the active device
+  void initLocal(int worldRank, int worldSize, ncclComm_t comm);
   ncclComm_t& getComm();
   int getWorldSize() const;
   int getWorldRank() const;
   const CUDAStream& getReductionStream() const;
   const CUDAStream& getWorkerStream() const;
   void* getCoalesceBuffer();
+  bool isHierarchical() const;
+  // Allreduces within the node, across nodes and within the node again
+  void hierarchicalAllReduce(
+      void* ptr,
+      size_t count,
+      ncclDataType_t ncclType,
+      cudaStream_t stream);
 
  private:
   // create CUDA resources
   void createCudaResources();
+  // Initializes NCCL, sharing the unique ids of communicators through a store
+  void initWithStore(
+      int worldRank,
+      int worldSize,
+      const std::unordered_map<std::string, std::string>& params,
+      Store& store,
+      const std::string& method);
+  // Creates the communicators within and across nodes if a hierarchical
+  // allreduce is selected, given a function which shares the unique id of a
+  // communicator from a root rank with the others. Returns the keys of the
+  // ids this rank is the root of.
+  std::vector<std::string> initHierarchicalComms(
+      const std::unordered_map<std::string, std::string>& params,
+      int maxDevicePerNode,
+      const std::function<
+          void(const std::string& key, int root, ncclUniqueId& id)>& shareId);
   ncclComm_t comm_;
   int worldSize_, worldRank_;
+  // communicators of the ranks of the node, and of the ranks with the same
+  // local rank across nodes
+  bool hierarchical_{false};
+  ncclComm_t localComm_, crossComm_;
+  int localSize_{1}, localRank_{0};
   // CUDA stream in which NCCL calls run if in async mode
   std::shared_ptr<CUDAStream> reductionStream_;
   // CUDA stream in which cudaMemcpyAsync calls run if in contiguous mode
@@ -70,6 +111,17 @@ class NcclContext {
   std::once_flag allocBuffer_;
 };
 
+// The contexts of the ranks of a DistributedInit::LOCAL environment, one per
+// device, and that of the rank of the calling driver thread, if any
+std::vector<std::unique_ptr<NcclContext>> localContexts;
+thread_local NcclContext* threadContext = nullptr;
+
+// Creates the communicators of a DistributedInit::LOCAL environment over the
+// first worldSize devices, or all of them if worldSize isn't positive
+void initLocalContexts(
+    int worldSize,
+    const std::unordered_map<std::string, std::string>& params);
+
 bool isNonNegativeInteger(const std::string& s) {
   return !s.empty() && std::find_if(s.begin(), s.end(), [](char c) {
                          return !std::isdigit(c);
@@ -80,6 +132,10 @@ ncclDataType_t getNcclTypeForArray(const Tensor& arr) {
   switch (arr.type()) {
     case fl::dtype::f16:
       return ncclHalf;
+#if NCCL_VERSION_CODE >= NCCL_VERSION(2, 10, 0)
+    case fl::dtype::bf16:
+      return ncclBfloat16;
+#endif
     case fl::dtype::f32:
       return ncclFloat32;
     case fl::dtype::f64:
@@ -94,6 +150,36 @@ ncclDataType_t getNcclTypeForArray(const Tensor& arr) {
   }
 }
 
+// The algorithm of collectives as recorded by the CommProfiler. NCCL picks its
+// own unless NCCL_ALGO forces one.
+std::string getNcclAlgorithm() {
+  static const std::string algorithm = []() -> std::string {
+    const char* env = std::getenv("NCCL_ALGO");
+    return env ? env : "nccl";
+  }();
+  return algorithm;
+}
+
+constexpr const char* kNcclP2PAlgorithm = "p2p";
+
+size_t getNcclTypeSize(ncclDataType_t ncclType) {
+  switch (ncclType) {
+    case ncclHalf:
+#if NCCL_VERSION_CODE >= NCCL_VERSION(2, 10, 0)
+    case ncclBfloat16:
+#endif
+      return 2;
+    case ncclFloat32:
+    case ncclInt32:
+      return 4;
+    case ncclFloat64:
+    case ncclInt64:
+      return 8;
+    default:
+      throw std::runtime_error("unsupported data type for allreduce with NCCL");
+  }
+}
+
 } // namespace
 
 void ncclCheck(ncclResult_t r);
@@ -106,7 +192,8 @@ void allReduceCuda(
     const size_t count,
     const ncclDataType_t ncclType,
     const bool async,
-    const bool contiguous);
+    const bool contiguous,
+    const bool profile = true);
 } // namespace detail
 
 void allReduce(Tensor& arr, bool async /* = false */) {
@@ -134,10 +221,43 @@ void allReduceMultiple(
   }
 
   if (!contiguous) {
-    // Use nccl groups to do everything in a single kernel launch
+    if (detail::NcclContext::getInstance().isHierarchical()) {
+      // the steps of a hierarchical allreduce depend on each other, so can't
+      // be grouped
+      for (auto& arr : arrs) {
+        allReduce(*arr, async);
+      }
+      return;
+    }
+    if (!isDistributedInit()) {
+      throw std::runtime_error("distributed environment not initialized");
+    }
+    // Use nccl groups to do everything in a single kernel launch, which is
+    // profiled as a whole since the group only runs at its end, including the
+    // wait for the streams of the arrays
+    size_t totalBytes = 0;
+    for (auto& arr : arrs) {
+      totalBytes += arr->bytes();
+    }
+    const auto* profileStream = async
+        ? &detail::NcclContext::getInstance().getReductionStream()
+        : &arrs.front()->stream().impl<CUDAStream>();
+    CommProfileRange range(
+        CollectiveType::AllReduce,
+        detail::getNcclAlgorithm(),
+        totalBytes,
+        profileStream);
     NCCLCHECK(ncclGroupStart());
     for (auto& arr : arrs) {
-      allReduce(*arr, async);
+      DevicePtr tensorPtr(*arr);
+      detail::allReduceCuda(
+          &arr->stream().impl<CUDAStream>(),
+          tensorPtr.get(),
+          arr->elements(),
+          detail::getNcclTypeForArray(*arr),
+          async,
+          /* contiguous = */ false,
+          /* profile = */ false);
     }
     NCCLCHECK(ncclGroupEnd());
     return;
@@ -226,6 +346,259 @@ void allReduceMultiple(
   }
 }
 
+namespace {
+
+void checkReduceScatterInput(const Tensor& arr) {
+  if (!isDistributedInit()) {
+    throw std::runtime_error("distributed environment not initialized");
+  }
+  if (arr.elements() % getWorldSize() != 0) {
+    throw std::invalid_argument(
+        "reduceScatter: the number of elements must be a multiple of the "
+        "world size");
+  }
+}
+
+void checkPeer(int peer, const std::string& op) {
+  if (!isDistributedInit()) {
+    throw std::runtime_error("distributed environment not initialized");
+  }
+  if (peer < 0 || peer >= getWorldSize() || peer == getWorldRank()) {
+    throw std::invalid_argument(
+        op + ": invalid peer rank " + std::to_string(peer));
+  }
+}
+
+// Enqueues an NCCL operation on the reduction stream after the pending
+// operations on the given tensors, whose streams wait for it in the returned
+// handle. The operation is profiled as a collective of the given type,
+// algorithm and size.
+DistributedWork runOnReductionStream(
+    const std::vector<Tensor>& tensors,
+    CollectiveType type,
+    const std::string& algorithm,
+    size_t bytes,
+    const std::function<void(cudaStream_t)>& op) {
+  const auto& stream = detail::NcclContext::getInstance().getReductionStream();
+  relativeSync(stream, tensors);
+  {
+    CommProfileRange range(type, algorithm, bytes, &stream);
+    op(stream.handle());
+  }
+  std::shared_ptr<Event> event = stream.recordEvent();
+  return DistributedWork([tensors, event]() {
+    for (const auto& tensor : tensors) {
+      tensor.stream().relativeSync(*event);
+    }
+  });
+}
+
+} // namespace
+
+Tensor reduceScatter(const Tensor& arr) {
+  checkReduceScatterInput(arr);
+  const auto worldSize = getWorldSize();
+  auto input = arr.asContiguousTensor();
+  auto output = Tensor({input.elements() / worldSize}, input.type());
+  const auto& stream = input.stream().impl<CUDAStream>();
+  // the output may come from another stream
+  relativeSync(stream, {output});
+  {
+    DevicePtr inputPtr(input);
+    DevicePtr outputPtr(output);
+    FL_PROFILE_TRACE_STREAM("ncclReduceScatter", &stream);
+    CommProfileRange range(
+        CollectiveType::ReduceScatter,
+        detail::getNcclAlgorithm(),
+        input.bytes(),
+        &stream);
+    NCCLCHECK(ncclReduceScatter(
+        inputPtr.get(),
+        outputPtr.get(),
+        output.elements(),
+        detail::getNcclTypeForArray(input),
+        ncclSum,
+        detail::NcclContext::getInstance().getComm(),
+        stream.handle()));
+  }
+  relativeSync({output}, stream);
+  return output;
+}
+
+Tensor allGather(const Tensor& arr) {
+  if (!isDistributedInit()) {
+    throw std::runtime_error("distributed environment not initialized");
+  }
+  auto input = arr.asContiguousTensor();
+  auto output = Tensor({input.elements() * getWorldSize()}, input.type());
+  const auto& stream = input.stream().impl<CUDAStream>();
+  // the output may come from another stream
+  relativeSync(stream, {output});
+  {
+    DevicePtr inputPtr(input);
+    DevicePtr outputPtr(output);
+    FL_PROFILE_TRACE_STREAM("ncclAllGather", &stream);
+    CommProfileRange range(
+        CollectiveType::AllGather,
+        detail::getNcclAlgorithm(),
+        output.bytes(),
+        &stream);
+    NCCLCHECK(ncclAllGather(
+        inputPtr.get(),
+        outputPtr.get(),
+        input.elements(),
+        detail::getNcclTypeForArray(input),
+        detail::NcclContext::getInstance().getComm(),
+        stream.handle()));
+  }
+  relativeSync({output}, stream);
+  return output;
+}
+
+DistributedWork reduceScatterAsync(const Tensor& arr, Tensor& output) {
+  checkReduceScatterInput(arr);
+  auto input = arr.asContiguousTensor();
+  output = Tensor({input.elements() / getWorldSize()}, input.type());
+  return runOnReductionStream(
+      {input, output},
+      CollectiveType::ReduceScatter,
+      detail::getNcclAlgorithm(),
+      input.bytes(),
+      [&input, &output](cudaStream_t stream) {
+        DevicePtr inputPtr(input);
+        DevicePtr outputPtr(output);
+        NCCLCHECK(ncclReduceScatter(
+            inputPtr.get(),
+            outputPtr.get(),
+            output.elements(),
+            detail::getNcclTypeForArray(input),
+            ncclSum,
+            detail::NcclContext::getInstance().getComm(),
+            stream));
+      });
+}
+
+DistributedWork allGatherAsync(const Tensor& arr, Tensor& output) {
+  if (!isDistributedInit()) {
+    throw std::runtime_error("distributed environment not initialized");
+  }
+  auto input = arr.asContiguousTensor();
+  output = Tensor({input.elements() * getWorldSize()}, input.type());
+  return runOnReductionStream(
+      {input, output},
+      CollectiveType::AllGather,
+      detail::getNcclAlgorithm(),
+      output.bytes(),
+      [&input, &output](cudaStream_t stream) {
+        DevicePtr inputPtr(input);
+        DevicePtr outputPtr(output);
+        NCCLCHECK(ncclAllGather(
+            inputPtr.get(),
+            outputPtr.get(),
+            input.elements(),
+            detail::getNcclTypeForArray(input),
+            detail::NcclContext::getInstance().getComm(),
+            stream));
+      });
+}
+
+DistributedWork broadcastAsync(Tensor& arr, int root) {
+  if (!isDistributedInit()) {
+    throw std::runtime_error("distributed environment not initialized");
+  }
+  if (root < 0 || root >= getWorldSize()) {
+    throw std::invalid_argument(
+        "broadcast: invalid root rank " + std::to_string(root));
+  }
+  return runOnReductionStream(
+      {arr},
+      CollectiveType::Broadcast,
+      detail::getNcclAlgorithm(),
+      arr.bytes(),
+      [&arr, root](cudaStream_t stream) {
+        DevicePtr arrPtr(arr);
+        NCCLCHECK(ncclBroadcast(
+            arrPtr.get(),
+            arrPtr.get(),
+            arr.elements(),
+            detail::getNcclTypeForArray(arr),
+            root,
+            detail::NcclContext::getInstance().getComm(),
+            stream));
+      });
+}
+
+DistributedWork sendAsync(const Tensor& arr, int dst) {
+  checkPeer(dst, "send");
+  return runOnReductionStream(
+      {arr},
+      CollectiveType::Send,
+      detail::kNcclP2PAlgorithm,
+      arr.bytes(),
+      [&arr, dst](cudaStream_t stream) {
+        DevicePtr arrPtr(arr);
+        NCCLCHECK(ncclSend(
+            arrPtr.get(),
+            arr.elements(),
+            detail::getNcclTypeForArray(arr),
+            dst,
+            detail::NcclContext::getInstance().getComm(),
+            stream));
+      });
+}
+
+DistributedWork recvAsync(Tensor& arr, int src) {
+  checkPeer(src, "recv");
+  return runOnReductionStream(
+      {arr},
+      CollectiveType::Recv,
+      detail::kNcclP2PAlgorithm,
+      arr.bytes(),
+      [&arr, src](cudaStream_t stream) {
+        DevicePtr arrPtr(arr);
+        NCCLCHECK(ncclRecv(
+            arrPtr.get(),
+            arr.elements(),
+            detail::getNcclTypeForArray(arr),
+            src,
+            detail::NcclContext::getInstance().getComm(),
+            stream));
+      });
+}
+
+DistributedWork
+sendRecvAsync(const Tensor& sendArr, int dst, Tensor& recvArr, int src) {
+  checkPeer(dst, "sendRecv");
+  checkPeer(src, "sendRecv");
+  return runOnReductionStream(
+      {sendArr, recvArr},
+      CollectiveType::SendRecv,
+      detail::kNcclP2PAlgorithm,
+      sendArr.bytes() + recvArr.bytes(),
+      [&sendArr, dst, &recvArr, src](cudaStream_t stream) {
+        DevicePtr sendPtr(sendArr);
+        DevicePtr recvPtr(recvArr);
+        const auto& comm = detail::NcclContext::getInstance().getComm();
+        // grouped such that neither waits for the other
+        NCCLCHECK(ncclGroupStart());
+        NCCLCHECK(ncclSend(
+            sendPtr.get(),
+            sendArr.elements(),
+            detail::getNcclTypeForArray(sendArr),
+            dst,
+            comm,
+            stream));
+        NCCLCHECK(ncclRecv(
+            recvPtr.get(),
+            recvArr.elements(),
+            detail::getNcclTypeForArray(recvArr),
+            src,
+            comm,
+            stream));
+        NCCLCHECK(ncclGroupEnd());
+      });
+}
+
 /**
  * Block future operations in all other CUDA streams on this device on
  * operations currently running in the NCCL [and worker] CUDA stream.
@@ -236,10 +609,21 @@ void syncDistributed() {
   const auto& activeCudaDevice = manager.getActiveDevice(DeviceType::CUDA);
   const auto& workerStream = ncclContext.getWorkerStream();
   const auto& reductionStream = ncclContext.getReductionStream();
+  auto& profiler = CommProfiler::getInstance();
   for (const auto& stream : activeCudaDevice.getStreams()) {
     if (stream.get() != &workerStream && stream.get() != &reductionStream) {
+      // the marks complete when the prior work of the stream, and then the
+      // distributed streams, are done, so bound the time the stream stalls
+      std::unique_ptr<Event> start;
+      if (profiler.isEnabled()) {
+        start = profiler.recordDeviceMark(*stream);
+      }
       stream->relativeSync(workerStream);
       stream->relativeSync(reductionStream);
+      if (start) {
+        profiler.recordDeviceSyncWait(
+            *stream, std::move(start), profiler.recordDeviceMark(*stream));
+      }
     }
   }
 }
@@ -248,6 +632,9 @@ int getWorldRank() {
   if (!isDistributedInit()) {
     return 0;
   }
+  if (!detail::localContexts.empty() && detail::threadContext == nullptr) {
+    return 0;
+  }
   return detail::NcclContext::getInstance().getWorldRank();
 }
 
@@ -255,6 +642,9 @@ int getWorldSize() {
   if (!isDistributedInit()) {
     return 1;
   }
+  if (!detail::localContexts.empty()) {
+    return detail::localContexts.size();
+  }
   return detail::NcclContext::getInstance().getWorldSize();
 }
 
@@ -275,6 +665,14 @@ void distributedInit(
         worldRank, worldSize, params);
     detail::DistributedInfo::getInstance().initMethod_ =
         DistributedInit::FILE_SYSTEM;
+  } else if (initMethod == DistributedInit::TCP) {
+    detail::NcclContext::getInstance().initWithTcp(
+        worldRank, worldSize, params);
+    detail::DistributedInfo::getInstance().initMethod_ = DistributedInit::TCP;
+  } else if (initMethod == DistributedInit::LOCAL) {
+    detail::initLocalContexts(worldSize, params);
+    detail::DistributedInfo::getInstance().initMethod_ =
+        DistributedInit::LOCAL;
   } else {
     throw std::runtime_error(
         "unsupported distributed init method for NCCL backend");
@@ -287,6 +685,38 @@ void distributedInit(
   }
 }
 
+void runOnDevices(const std::function<void(int worldRank)>& fn) {
+  if (detail::localContexts.empty()) {
+    fn(getWorldRank());
+    return;
+  }
+  if (detail::threadContext != nullptr) {
+    throw std::logic_error("runOnDevices can't be called from a driver thread");
+  }
+  const int worldSize = detail::localContexts.size();
+  std::vector<std::exception_ptr> errors(worldSize);
+  std::vector<std::thread> threads;
+  for (int rank = 0; rank < worldSize; ++rank) {
+    threads.emplace_back([&fn, &errors, rank]() {
+      try {
+        fl::setDevice(rank);
+        detail::threadContext = detail::localContexts[rank].get();
+        fn(rank);
+      } catch (...) {
+        errors[rank] = std::current_exception();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
 namespace detail {
 
 void ncclCheck(ncclResult_t r) {
@@ -320,7 +750,8 @@ void allReduceCuda(
     const size_t count,
     const ncclDataType_t ncclType,
     const bool async,
-    const bool contiguous) {
+    const bool contiguous,
+    const bool profile /* = true */) {
   const CUDAStream* syncStream;
   auto& ncclContext = detail::NcclContext::getInstance();
   if (async) {
@@ -342,6 +773,21 @@ void allReduceCuda(
   // don't synchronize streams if not async and not contiguous - the AF CUDA
   // stream does everything
 
+  std::unique_ptr<CommProfileRange> range;
+  if (profile) {
+    range = std::make_unique<CommProfileRange>(
+        CollectiveType::AllReduce,
+        ncclContext.isHierarchical() ? "hierarchical" : getNcclAlgorithm(),
+        count * getNcclTypeSize(ncclType),
+        syncStream);
+  }
+  if (ncclContext.isHierarchical()) {
+    FL_PROFILE_TRACE_STREAM("ncclHierarchicalAllReduce", syncStream);
+    ncclContext.hierarchicalAllReduce(
+        ptr, count, ncclType, syncStream->handle());
+    return;
+  }
+  FL_PROFILE_TRACE_STREAM("ncclAllReduce", syncStream);
   NCCLCHECK(ncclAllReduce(
       ptr,
       ptr,
@@ -381,31 +827,115 @@ void* NcclContext::getCoalesceBuffer() {
   return coalesceBuffer_;
 }
 
+bool NcclContext::isHierarchical() const {
+  return hierarchical_;
+}
+
+void NcclContext::hierarchicalAllReduce(
+    void* ptr,
+    size_t count,
+    ncclDataType_t ncclType,
+    cudaStream_t stream) {
+  auto* data = static_cast<char*>(ptr);
+  const size_t typeSize = getNcclTypeSize(ncclType);
+  const size_t shardCount = count / localSize_;
+  if (shardCount > 0) {
+    // each rank of the node reduces a shard in place, which is reduced across
+    // nodes and gathered back
+    auto* shard = data + localRank_ * shardCount * typeSize;
+    NCCLCHECK(ncclReduceScatter(
+        data, shard, shardCount, ncclType, ncclSum, localComm_, stream));
+    NCCLCHECK(ncclAllReduce(
+        shard, shard, shardCount, ncclType, ncclSum, crossComm_, stream));
+    NCCLCHECK(
+        ncclAllGather(shard, data, shardCount, ncclType, localComm_, stream));
+  }
+  // the elements which don't divide into shards
+  const size_t restCount = count - shardCount * localSize_;
+  if (restCount > 0) {
+    auto* rest = data + shardCount * localSize_ * typeSize;
+    NCCLCHECK(
+        ncclAllReduce(rest, rest, restCount, ncclType, ncclSum, comm_, stream));
+  }
+}
+
 /* static */ NcclContext& NcclContext::getInstance() {
+  if (threadContext != nullptr) {
+    return *threadContext;
+  }
+  if (!localContexts.empty()) {
+    throw std::logic_error(
+        "the collectives of a local NCCL environment run on the driver "
+        "threads of runOnDevices");
+  }
   static NcclContext ncclCtx;
   return ncclCtx;
 }
 
 void NcclContext::createCudaResources() {
   // initialize
-  // - dedicated NCCL CUDA stream to support async allReduce
-  // - a third dedicated stream to asynchronously copy gradients
-  //   into a coalesced form if using a contiguous allReduce
-
-// Destroying the dedicated NCCL CUDA stream is a bit odd since the stream
-// lives in a global NcclContext singleton. The CUDA driver shuts down when
-// exit(0) is called, but the context may not be destroyed until
-// afterwards, and destroying streams when the driver has already shut down is
-// ungraceful. Manually destroying streams races against the driver, but in
-// all cases, streams are destroyed when the driver shuts down, so don't
-// destroy the stream by default.
-#ifdef CUDA_STREAM_POOL_DESTROY_ON_SHUTDOWN
-  reductionStream_ = CUDAStream::createManaged(detail::kDefaultStreamFlags);
-  workerStream_ = CUDAStream::createManaged(detail::kDefaultStreamFlags);
-#else
-  reductionStream_ = CUDAStream::createUnmanaged(detail::kDefaultStreamFlags);
-  workerStream_ = CUDAStream::createUnmanaged(detail::kDefaultStreamFlags);
-#endif
+  // - NCCL CUDA stream to support async allReduce
+  // - a third stream to asynchronously copy gradients into a coalesced form if
+  //   using a contiguous allReduce
+  // Both come from the device's high priority pool, whose streams are
+  // non-blocking so that their activity can run in parallel with the default
+  // stream, and whose lifetime is tied to the device rather than this context.
+  auto& device = DeviceManager::getInstance()
+                     .getActiveDevice(DeviceType::CUDA)
+                     .impl<CUDADevice>();
+  reductionStream_ = device.getCUDAStreamFromPool(StreamPriority::High);
+  workerStream_ = device.getCUDAStreamFromPool(StreamPriority::High);
+}
+
+std::vector<std::string> NcclContext::initHierarchicalComms(
+    const std::unordered_map<std::string, std::string>& params,
+    int maxDevicePerNode,
+    const std::function<
+        void(const std::string& key, int root, ncclUniqueId& id)>& shareId) {
+  auto mode = params.find(DistributedConstants::kAllReduceMode);
+  if (mode == params.end() ||
+      mode->second == DistributedConstants::kAllReduceModeFlat) {
+    return {};
+  }
+  if (mode->second != DistributedConstants::kAllReduceModeHierarchical) {
+    throw std::invalid_argument(
+        "invalid AllReduceMode for NCCL: " + mode->second);
+  }
+  // a single node or a device per node reduce as a flat allreduce
+  if (worldSize_ <= maxDevicePerNode || maxDevicePerNode == 1) {
+    return {};
+  }
+  if (worldSize_ % maxDevicePerNode != 0) {
+    throw std::invalid_argument(
+        "hierarchical allreduce with NCCL requires the world size to be a "
+        "multiple of MaxDevicePerNode");
+  }
+  localSize_ = maxDevicePerNode;
+  localRank_ = worldRank_ % localSize_;
+  const int node = worldRank_ / localSize_;
+  const int nNodes = worldSize_ / localSize_;
+
+  std::vector<std::string> rootKeys;
+  auto getId = [&](const std::string& key, int root) {
+    ncclUniqueId id;
+    if (worldRank_ == root) {
+      NCCLCHECK(ncclGetUniqueId(&id));
+      rootKeys.push_back(key);
+    }
+    shareId(key, root, id);
+    return id;
+  };
+  // the node is rooted at its first rank, and the ranks of a local rank
+  // across nodes at that of the first node
+  auto localId = getId(
+      std::string(kNcclKey) + "Node" + std::to_string(node),
+      node * localSize_);
+  auto crossId = getId(
+      std::string(kNcclKey) + "Local" + std::to_string(localRank_), localRank_);
+  NCCLCHECK(ncclCommInitRank(&localComm_, localSize_, localId, localRank_));
+  NCCLCHECK(ncclCommInitRank(&crossComm_, nNodes, crossId, node));
+  hierarchical_ = true;
+  return rootKeys;
 }
 
 void NcclContext::initWithMPI(
@@ -437,6 +967,23 @@ void NcclContext::initWithMPI(
   // initializing NCCL
   NCCLCHECK(ncclCommInitRank(&comm_, worldSize_, id, worldRank_));
 
+  // each rank contributes an id, of which those of the roots are used
+  initHierarchicalComms(
+      params,
+      std::stoi(maxDevicePerNode->second),
+      [this](const std::string& /* key */, int root, ncclUniqueId& id) {
+        std::vector<ncclUniqueId> ids(worldSize_);
+        MPICHECK(MPI_Allgather(
+            (void*)&id,
+            sizeof(id),
+            MPI_BYTE,
+            (void*)ids.data(),
+            sizeof(id),
+            MPI_BYTE,
+            MPI_COMM_WORLD));
+        id = ids[root];
+      });
+
   createCudaResources();
 }
 
@@ -445,14 +992,51 @@ void NcclContext::initWithFileSystem(
     int worldSize,
     const std::unordered_map<std::string, std::string>& params) {
   auto filePath = params.find(DistributedConstants::kFilePath);
-  auto maxDevicePerNode = params.find(DistributedConstants::kMaxDevicePerNode);
-
   if (filePath == params.end() || filePath->second.empty()) {
     throw std::invalid_argument("invalid FilePath for NCCL initWithFileSystem");
   }
+  auto fs = FileStore(filePath->second);
+  initWithStore(worldRank, worldSize, params, fs, "initWithFileSystem");
+}
+
+void NcclContext::initWithTcp(
+    int worldRank,
+    int worldSize,
+    const std::unordered_map<std::string, std::string>& params) {
+  auto host = params.find(DistributedConstants::kStoreHost);
+  auto port = params.find(DistributedConstants::kStorePort);
+  if (host == params.end() || host->second.empty()) {
+    throw std::invalid_argument("invalid StoreHost for NCCL initWithTcp");
+  }
+  if (port == params.end() || !isNonNegativeInteger(port->second)) {
+    throw std::invalid_argument("invalid StorePort for NCCL initWithTcp");
+  }
+  TcpStore store(
+      host->second, std::stoi(port->second), /* isServer = */ worldRank == 0);
+  initWithStore(worldRank, worldSize, params, store, "initWithTcp");
+
+  // the store lasts as long as rank 0's, so rank 0 waits for all ranks to be
+  // done with it
+  auto doneKey = [](int rank) { return "initDone" + std::to_string(rank); };
+  store.set(doneKey(worldRank), {1});
+  if (worldRank == 0) {
+    std::vector<std::string> keys;
+    for (int rank = 0; rank < worldSize; ++rank) {
+      keys.push_back(doneKey(rank));
+    }
+    store.wait(keys);
+  }
+}
+
+void NcclContext::initWithStore(
+    int worldRank,
+    int worldSize,
+    const std::unordered_map<std::string, std::string>& params,
+    Store& store,
+    const std::string& method) {
+  auto maxDevicePerNode = params.find(DistributedConstants::kMaxDevicePerNode);
   if (maxDevicePerNode == params.end()) {
-    throw std::invalid_argument(
-        "invalid MaxDevicePerNode for NCCL initWithFileSystem");
+    throw std::invalid_argument("invalid MaxDevicePerNode for NCCL " + method);
   }
 
   worldRank_ = worldRank;
@@ -465,15 +1049,11 @@ void NcclContext::initWithFileSystem(
   // get NCCL unique ID at rank 0 and broadcast it to all others
   if (worldRank_ == 0) {
     ncclGetUniqueId(&id);
-  }
-
-  auto fs = FileStore(filePath->second);
-  if (worldRank_ == 0) {
     std::vector<char> data(sizeof(id));
     std::memcpy(data.data(), &id, sizeof(id));
-    fs.set(kNcclKey, data);
+    store.set(kNcclKey, data);
   } else {
-    auto data = fs.get(kNcclKey);
+    auto data = store.get(kNcclKey);
     std::memcpy(&id, data.data(), sizeof(id));
   }
   // No need for barrier here as ncclCommInitRank inherently synchronizes
@@ -481,20 +1061,85 @@ void NcclContext::initWithFileSystem(
   // initializing NCCL
   NCCLCHECK(ncclCommInitRank(&comm_, worldSize_, id, worldRank_));
 
-  // Remove the temporary file created for initialization
+  // Remove the key created for initialization
   if (worldRank_ == 0) {
-    fs.clear(kNcclKey);
+    store.clear(kNcclKey);
   }
 
+  auto rootKeys = initHierarchicalComms(
+      params,
+      std::stoi(maxDevicePerNode->second),
+      [this, &store](const std::string& key, int root, ncclUniqueId& id) {
+        if (worldRank_ == root) {
+          std::vector<char> data(sizeof(id));
+          std::memcpy(data.data(), &id, sizeof(id));
+          store.set(key, data);
+        } else {
+          auto data = store.get(key);
+          std::memcpy(&id, data.data(), sizeof(id));
+        }
+      });
+  for (const auto& key : rootKeys) {
+    store.clear(key);
+  }
+
+  createCudaResources();
+}
+
+void NcclContext::initLocal(int worldRank, int worldSize, ncclComm_t comm) {
+  worldRank_ = worldRank;
+  worldSize_ = worldSize;
+  comm_ = comm;
   createCudaResources();
 }
 
+void initLocalContexts(
+    int worldSize,
+    const std::unordered_map<std::string, std::string>& params) {
+  // the ranks are on a single node, for which NCCL picks the links itself
+  auto mode = params.find(DistributedConstants::kAllReduceMode);
+  if (mode != params.end() &&
+      mode->second != DistributedConstants::kAllReduceModeFlat) {
+    throw std::invalid_argument(
+        "invalid AllReduceMode for a local NCCL environment: " + mode->second);
+  }
+  const int deviceCount = fl::getDeviceCount();
+  if (worldSize <= 0) {
+    worldSize = deviceCount;
+  }
+  if (worldSize > deviceCount) {
+    throw std::invalid_argument(
+        "a local NCCL environment of " + std::to_string(worldSize) +
+        " ranks needs as many devices, but there are " +
+        std::to_string(deviceCount));
+  }
+
+  std::vector<ncclComm_t> comms(worldSize);
+  std::vector<int> devices(worldSize);
+  std::iota(devices.begin(), devices.end(), 0);
+  NCCLCHECK(ncclCommInitAll(comms.data(), worldSize, devices.data()));
+
+  // the streams of each rank are on its device
+  const int activeDevice = fl::getDevice();
+  for (int rank = 0; rank < worldSize; ++rank) {
+    fl::setDevice(rank);
+    auto context = std::make_unique<NcclContext>();
+    context->initLocal(rank, worldSize, comms[rank]);
+    localContexts.push_back(std::move(context));
+  }
+  fl::setDevice(activeDevice);
+}
+
 NcclContext::~NcclContext() {
 #ifdef NO_NCCL_COMM_DESTROY_HANDLE
 // DEBUG : ncclCommDestroy disabled as it leads to segfault.
 #else
   // finalizing NCCL
   NCCLCHECK(ncclCommDestroy(comm_));
+  if (hierarchical_) {
+    NCCLCHECK(ncclCommDestroy(localComm_));
+    NCCLCHECK(ncclCommDestroy(crossComm_));
+  }
 #endif
 
 // The CUDA driver has already shut down before we can free, so don't free by
@@ -7,6 +7,7 @@
 
 #include "flashlight/fl/distributed/DistributedApi.h"
 
+#include <functional>
 #include <iostream>
 #include <list>
 #include <memory>
@@ -46,6 +47,50 @@ void allReduceMultiple(
   throw std::runtime_error("allReduceMultiple not supported for stub backend");
 }
 
+Tensor reduceScatter(const Tensor& /* arr */) {
+  if (!isDistributedInit()) {
+    throw std::runtime_error("distributed environment not initialized");
+  }
+  throw std::runtime_error("reduceScatter not supported for stub backend");
+}
+
+Tensor allGather(const Tensor& /* arr */) {
+  if (!isDistributedInit()) {
+    throw std::runtime_error("distributed environment not initialized");
+  }
+  throw std::runtime_error("allGather not supported for stub backend");
+}
+
+DistributedWork reduceScatterAsync(
+    const Tensor& /* arr */,
+    Tensor& /* output */) {
+  throw std::runtime_error("reduceScatter not supported for stub backend");
+}
+
+DistributedWork allGatherAsync(const Tensor& /* arr */, Tensor& /* output */) {
+  throw std::runtime_error("allGather not supported for stub backend");
+}
+
+DistributedWork broadcastAsync(Tensor& /* arr */, int /* root */) {
+  throw std::runtime_error("broadcast not supported for stub backend");
+}
+
+DistributedWork sendAsync(const Tensor& /* arr */, int /* dst */) {
+  throw std::runtime_error("send not supported for stub backend");
+}
+
+DistributedWork recvAsync(Tensor& /* arr */, int /* src */) {
+  throw std::runtime_error("recv not supported for stub backend");
+}
+
+DistributedWork sendRecvAsync(
+    const Tensor& /* sendArr */,
+    int /* dst */,
+    Tensor& /* recvArr */,
+    int /* src */) {
+  throw std::runtime_error("sendRecv not supported for stub backend");
+}
+
 void syncDistributed() {
   throw std::runtime_error(
       "Asynchronous allReduce not supported for stub backend");
@@ -58,4 +103,8 @@ int getWorldRank() {
 int getWorldSize() {
   return 1;
 }
+
+void runOnDevices(const std::function<void(int worldRank)>& fn) {
+  fn(getWorldRank());
+}
 } // namespace fl
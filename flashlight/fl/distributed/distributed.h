@@ -7,5 +7,8 @@
 
 #pragma once
 
+#include "flashlight/fl/distributed/CommProfiler.h"
 #include "flashlight/fl/distributed/DistributedApi.h"
+#include "flashlight/fl/distributed/ShardedCheckpoint.h"
+#include "flashlight/fl/distributed/ShardedOptimizer.h"
 #include "flashlight/fl/distributed/reducers/reducers.h"
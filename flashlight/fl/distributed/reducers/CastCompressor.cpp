@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/distributed/reducers/CastCompressor.h"
+
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/distributed/DistributedApi.h"
+#include "flashlight/fl/tensor/Compute.h"
+
+namespace fl {
+
+CastCompressor::CastCompressor(
+    fl::dtype type /* = fl::dtype::f16 */,
+    bool errorFeedback /* = true */)
+    : type_(type), errorFeedback_(errorFeedback) {}
+
+void CastCompressor::allReduce(
+    std::vector<Variable>& grads,
+    double scale,
+    bool contiguous) {
+  std::vector<Tensor> compressed;
+  std::vector<size_t> compressedIdx;
+  for (size_t i = 0; i < grads.size(); ++i) {
+    auto& grad = grads[i];
+    if (grad.isRowSparse()) {
+      fl::allReduce(grad, scale);
+      continue;
+    }
+    auto value = grad.tensor();
+    const size_t idx = index_++;
+    if (errorFeedback_) {
+      if (errors_.size() <= idx) {
+        errors_.resize(idx + 1);
+      }
+      const auto& error = errors_[idx];
+      if (!error.isEmpty() && error.shape() == value.shape()) {
+        value = value + error.astype(value.type());
+      }
+    }
+    auto cast = (value * scale).astype(type_);
+    if (errorFeedback_ && scale != 0) {
+      auto error = value - cast.astype(value.type()) / scale;
+      // the cast is reduced in place, so the error is computed beforehand
+      fl::eval(error);
+      errors_[idx] = std::move(error);
+    }
+    compressed.push_back(std::move(cast));
+    compressedIdx.push_back(i);
+  }
+
+  std::vector<Tensor*> tensors;
+  for (auto& tensor : compressed) {
+    tensors.push_back(&tensor);
+  }
+  allReduceTensors(tensors, contiguous);
+  for (size_t k = 0; k < compressed.size(); ++k) {
+    auto& grad = grads[compressedIdx[k]];
+    grad.tensor() = compressed[k].astype(grad.type());
+  }
+}
+
+void CastCompressor::endStep() {
+  index_ = 0;
+}
+
+} // namespace fl
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "flashlight/fl/distributed/reducers/GradientCompressor.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+/**
+ * A `GradientCompressor` which reduces gradients cast to a smaller type, e.g.
+ * f16 or bf16, halving the bytes of fp32 gradients. Gradients are scaled
+ * before the cast, to keep their sum in range.
+ *
+ * With error feedback, the rounding error of each gradient is added to the
+ * gradient of the next step, such that it isn't lost over steps.
+ */
+class CastCompressor : public GradientCompressor {
+ public:
+  /**
+   * @param[in] type the type in which gradients are reduced
+   * @param[in] errorFeedback whether to add the rounding error of each
+   * gradient to that of the next step
+   */
+  explicit CastCompressor(
+      fl::dtype type = fl::dtype::f16,
+      bool errorFeedback = true);
+
+  void allReduce(std::vector<Variable>& grads, double scale, bool contiguous)
+      override;
+
+  void endStep() override;
+
+ private:
+  fl::dtype type_;
+  bool errorFeedback_;
+  // the rounding error of each gradient of the previous step
+  std::vector<Tensor> errors_;
+  // the index of the next gradient in the step
+  size_t index_{0};
+};
+
+} // namespace fl
@@ -6,22 +6,115 @@
  */
 
 #include "flashlight/fl/distributed/reducers/CoalescingReducer.h"
+
+#include <chrono>
+#include <limits>
+#include <map>
+#include <utility>
+
 #include "flashlight/fl/distributed/DistributedApi.h"
 #include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/TensorBase.h"
 
 namespace fl {
 
-CoalescingReducer::CoalescingReducer(double scale, bool async, bool contiguous)
+namespace {
+
+constexpr std::size_t kNotBucketed = std::numeric_limits<std::size_t>::max();
+
+ReducerMetrics& metrics() {
+  static ReducerMetrics metrics("coalescing");
+  return metrics;
+}
+
+} // namespace
+
+struct CoalescingReducer::GradInfo {
+  Shape shape;
+  fl::dtype type;
+  /// Whether the gradient can be bucketed, i.e. is dense and fits the cache
+  bool bucketable;
+
+  bool operator==(const GradInfo& other) const {
+    return shape == other.shape && type == other.type &&
+        bucketable == other.bucketable;
+  }
+};
+
+struct CoalescingReducer::Bucket {
+  /// The flat buffer of the gradients of the bucket
+  Tensor buffer;
+  /// The number of gradients in the bucket
+  std::size_t size{0};
+  /// The gradients added to the bucket in this step, and their offset
+  std::vector<std::pair<Variable, Dim>> vars;
+  bool launched{false};
+};
+
+CoalescingReducer::CoalescingReducer(
+    double scale,
+    bool async,
+    bool contiguous,
+    std::shared_ptr<GradientCompressor> compressor /* = nullptr */,
+    bool bucketed /* = false */)
     : scale_(scale),
       async_(async),
       contiguous_(contiguous),
-      cacheThresholdBytes_(DistributedConstants::kCoalesceCacheSize) {}
+      cacheThresholdBytes_(DistributedConstants::kCoalesceCacheSize),
+      compressor_(std::move(compressor)),
+      bucketed_(bucketed && !compressor_) {}
 
 CoalescingReducer::~CoalescingReducer() {
   finalize();
 }
 
 void CoalescingReducer::add(Variable& var) {
+  metrics().gradients.inc();
+  metrics().gradientBytes.inc(var.bytes());
+  if (!bucketed_) {
+    addToCache(var);
+    return;
+  }
+
+  const std::size_t idx = stepGrads_.size();
+  stepGrads_.push_back(
+      {var.shape(),
+       var.type(),
+       !var.isRowSparse() && var.bytes() <= cacheThresholdBytes_});
+  if (followingPlan_ &&
+      (idx >= plan_.size() || !(plan_[idx] == stepGrads_.back()))) {
+    // the rest of the step is coalesced in the cache, so start synchronizing
+    // the gradients which are already in buckets
+    followingPlan_ = false;
+    for (auto& bucket : buckets_) {
+      if (!bucket.launched && !bucket.vars.empty()) {
+        launch(bucket);
+      }
+    }
+  }
+  if (!followingPlan_ || !stepGrads_.back().bucketable) {
+    addToCache(var);
+    return;
+  }
+
+  const auto [bucketIdx, offset] = slots_[idx];
+  auto& bucket = buckets_[bucketIdx];
+  bucket.buffer(fl::range(offset, offset + var.elements())) =
+      var.tensor().flatten();
+  bucket.vars.emplace_back(var, offset);
+  if (bucket.vars.size() == bucket.size) {
+    launch(bucket);
+  }
+}
+
+void CoalescingReducer::addToCache(Variable& var) {
+  // row-sparse gradients are reduced separately
+  if (var.isRowSparse()) {
+    allReduce(var, scale_, async_);
+    return;
+  }
+
   // if this tensor would push the cache oversize, flush
   if (currCacheSize_ + var.bytes() > cacheThresholdBytes_) {
     flush();
@@ -30,7 +123,7 @@ void CoalescingReducer::add(Variable& var) {
   // check if the tensor is larger than the cache. If so, reduce immediately
   // and don't copy-coalesce
   if (var.bytes() > cacheThresholdBytes_) {
-    allReduce(var, scale_, async_);
+    reduceOversize(var);
   } else {
     // if async, evaluating the JIT on the value upfront is more efficient than
     // evaluating the JIT for each Variable in the cache after we flush it,
@@ -46,16 +139,104 @@ void CoalescingReducer::add(Variable& var) {
 }
 
 void CoalescingReducer::finalize() {
+  const auto start = std::chrono::steady_clock::now();
   flush();
+  for (auto& bucket : buckets_) {
+    // gradients which weren't added leave stale data in their slot, which is
+    // synchronized but not copied back
+    if (!bucket.launched && !bucket.vars.empty()) {
+      launch(bucket);
+    }
+  }
   synchronize();
+
+  for (auto& bucket : buckets_) {
+    for (auto& [var, offset] : bucket.vars) {
+      auto reduced = bucket.buffer(fl::range(offset, offset + var.elements()));
+      var.tensor() = fl::reshape(reduced, var.shape()) * scale_;
+      // the buffer is overwritten in place by the next step
+      fl::eval(var.tensor());
+    }
+    bucket.vars.clear();
+    bucket.launched = false;
+  }
+  if (bucketed_ && !stepGrads_.empty()) {
+    if (!(stepGrads_ == plan_)) {
+      planBuckets();
+    }
+    stepGrads_.clear();
+    followingPlan_ = true;
+  }
+
+  if (compressor_) {
+    compressor_->endStep();
+  }
+  metrics().finalizeSeconds.observe(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count());
 }
 
 void CoalescingReducer::flush() {
-  allReduceMultiple(cache_, scale_, async_, contiguous_);
+  if (compressor_) {
+    if (!cache_.empty()) {
+      compressor_->allReduce(cache_, scale_, contiguous_);
+    }
+  } else {
+    allReduceMultiple(cache_, scale_, async_, contiguous_);
+  }
   currCacheSize_ = 0;
   cache_.clear();
 }
 
+void CoalescingReducer::reduceOversize(Variable& var) {
+  if (!compressor_) {
+    allReduce(var, scale_, async_);
+    return;
+  }
+  std::vector<Variable> grads = {var};
+  compressor_->allReduce(grads, scale_, /* contiguous = */ false);
+}
+
+void CoalescingReducer::launch(Bucket& bucket) {
+  allReduce(bucket.buffer, async_);
+  bucket.launched = true;
+}
+
+void CoalescingReducer::planBuckets() {
+  plan_ = stepGrads_;
+  slots_.assign(plan_.size(), {kNotBucketed, 0});
+  buckets_.clear();
+  // the bucket being filled, and the number of elements in it, by type
+  std::map<fl::dtype, std::pair<std::size_t, Dim>> open;
+  std::vector<Dim> elements;
+  std::vector<fl::dtype> types;
+  for (std::size_t i = 0; i < plan_.size(); ++i) {
+    const auto& grad = plan_[i];
+    if (!grad.bucketable) {
+      continue;
+    }
+    const Dim gradElements = grad.shape.elements();
+    const auto typeSize = fl::getTypeSize(grad.type);
+    auto it = open.find(grad.type);
+    if (it == open.end() ||
+        (it->second.second + gradElements) * typeSize > cacheThresholdBytes_) {
+      buckets_.emplace_back();
+      elements.push_back(0);
+      types.push_back(grad.type);
+      const auto bucket = std::make_pair(buckets_.size() - 1, Dim(0));
+      it = open.insert_or_assign(grad.type, bucket).first;
+    }
+    auto& [bucketIdx, bucketElements] = it->second;
+    slots_[i] = {bucketIdx, bucketElements};
+    bucketElements += gradElements;
+    elements[bucketIdx] = bucketElements;
+    buckets_[bucketIdx].size++;
+  }
+  for (std::size_t i = 0; i < buckets_.size(); ++i) {
+    buckets_[i].buffer = Tensor({elements[i]}, types[i]);
+  }
+}
+
 void CoalescingReducer::synchronize() {
   if (async_ || contiguous_) {
     syncDistributed();
@@ -7,9 +7,13 @@
 
 #pragma once
 
+#include <memory>
+#include <utility>
 #include <vector>
 
+#include "flashlight/fl/distributed/reducers/GradientCompressor.h"
 #include "flashlight/fl/distributed/reducers/Reducer.h"
+#include "flashlight/fl/tensor/Shape.h"
 
 namespace fl {
 
@@ -23,6 +27,19 @@ class Variable;
  * Since the Reducer executes ``allReduceMultiple`` operations asynchronously,
  * to guarantee that synchronized values are available after reduction,
  * ``finalize`` must be called before using a given value.
+ *
+ * If a `GradientCompressor` is given, each flushed cache is reduced in a
+ * compressed form, synchronously.
+ *
+ * With bucketing, the cache is replaced by buckets planned from the order in
+ * which the gradients were added in the previous step, which is e.g. the order
+ * in which the backward pass computes them. Gradients are copied into the
+ * preallocated contiguous buffer of their bucket, which is reduced as soon as
+ * all of its gradients are added, such that reductions overlap with the
+ * backward pass rather than mostly happening in ``finalize``. Buckets are
+ * planned again after a step whose gradients differ from the plan, whose
+ * remaining gradients are coalesced as without bucketing. Bucketing doesn't
+ * apply with a compressor.
  */
 class CoalescingReducer : public Reducer {
   /// A scale by which to scale reduced gradients
@@ -40,6 +57,22 @@ class CoalescingReducer : public Reducer {
   std::vector<Variable> cache_;
   /// The current cache size, in bytes
   std::size_t currCacheSize_{0};
+  /// Compresses the gradients to reduce, if any
+  std::shared_ptr<GradientCompressor> compressor_;
+
+  struct GradInfo;
+  struct Bucket;
+  /// Whether gradients are reduced in planned buckets
+  bool bucketed_{false};
+  /// The gradients of the step the buckets were planned from, in order
+  std::vector<GradInfo> plan_;
+  /// The bucket and offset in its buffer of each gradient of the plan
+  std::vector<std::pair<std::size_t, Dim>> slots_;
+  std::vector<Bucket> buckets_;
+  /// The gradients added in this step
+  std::vector<GradInfo> stepGrads_;
+  /// Whether the gradients added in this step match the plan so far
+  bool followingPlan_{false};
 
  public:
   /**
@@ -51,8 +84,17 @@ class CoalescingReducer : public Reducer {
    * runs asynchronously to the AF stream.
    * @param[in] contiguous forces synchronization of the set of Variables
    * to occur in a contiguous buffer, which may improve performance.
+   * @param[in] compressor if non-null, reduces the gradients in a compressed
+   * form
+   * @param[in] bucketed reduces gradients in buckets planned from the previous
+   * step, in which case the cache is always contiguous
    */
-  CoalescingReducer(double scale, bool async, bool contiguous);
+  CoalescingReducer(
+      double scale,
+      bool async,
+      bool contiguous,
+      std::shared_ptr<GradientCompressor> compressor = nullptr,
+      bool bucketed = false);
 
   /**
    * Destroy the Reducer. Calls `finalize()` before returning.
@@ -71,7 +113,8 @@ class CoalescingReducer : public Reducer {
   void add(Variable& var) override;
 
   /**
-   * Flush any remaining ``Variable``s in the cache and synchronize.
+   * Flush any remaining ``Variable``s in the cache and synchronize, and end
+   * the step of the compressor, if any.
    */
   void finalize() override;
 
@@ -82,6 +125,27 @@ class CoalescingReducer : public Reducer {
    */
   void flush();
 
+  /**
+   * Synchronize a ``Variable`` which is too large for the cache.
+   */
+  void reduceOversize(Variable& var);
+
+  /**
+   * Add a ``Variable`` to the cache, or synchronize it if it's row-sparse or
+   * too large for the cache.
+   */
+  void addToCache(Variable& var);
+
+  /**
+   * Start synchronizing the buffer of a bucket.
+   */
+  void launch(Bucket& bucket);
+
+  /**
+   * Plan buckets for the gradients added in this step.
+   */
+  void planBuckets();
+
   /**
    * Synchronize the distributed computation stream with the existing AF
    * computation stream in a way that doesn't block the main host thread.
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/distributed/reducers/GradientCompressor.h"
+
+#include "flashlight/fl/distributed/DistributedApi.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+void GradientCompressor::allReduceTensors(
+    const std::vector<Tensor*>& tensors,
+    bool contiguous) {
+  if (tensors.empty()) {
+    return;
+  }
+  for (const auto* tensor : tensors) {
+    contiguous = contiguous && tensor->type() == tensors.front()->type();
+  }
+  allReduceMultiple(tensors, /* async = */ false, contiguous);
+  if (contiguous) {
+    // the reduced values are copied back in the worker stream
+    syncDistributed();
+  }
+}
+
+} // namespace fl
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <vector>
+
+namespace fl {
+
+class Tensor;
+class Variable;
+
+/**
+ * An interface for allreducing gradients in a compressed form, which reduces
+ * the bytes sent between processes, for use by a `Reducer`.
+ *
+ * A compressor may keep state for each gradient across steps, such as the
+ * compression error to feed back into the gradient of the next step. The
+ * gradients of a step are identified by the order in which they're reduced,
+ * which must be the same in each step, and `endStep` marks the end of a step.
+ * Compressed reductions are synchronous, since the decompression depends on
+ * them.
+ */
+class GradientCompressor {
+ public:
+  virtual ~GradientCompressor() = default;
+
+  /**
+   * Replaces each gradient by the sum across processes of its compressed
+   * form, scaled by `scale`.
+   *
+   * @param[in] grads the gradients to reduce, which may be row-sparse
+   * @param[in] scale the factor by which to scale the reduced gradients
+   * @param[in] contiguous whether to reduce the compressed gradients in a
+   * contiguous buffer, see `allReduceMultiple`
+   */
+  virtual void allReduce(
+      std::vector<Variable>& grads,
+      double scale,
+      bool contiguous) = 0;
+
+  /**
+   * Marks the end of the reductions of a step.
+   */
+  virtual void endStep() = 0;
+
+ protected:
+  /**
+   * Synchronously allreduces tensors, contiguously if they're of the same
+   * type and `contiguous` is true.
+   */
+  static void allReduceTensors(
+      const std::vector<Tensor*>& tensors,
+      bool contiguous);
+};
+
+} // namespace fl
@@ -6,17 +6,50 @@
  */
 
 #include "flashlight/fl/distributed/reducers/InlineReducer.h"
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/autograd/Variable.h"
 #include "flashlight/fl/distributed/DistributedApi.h"
 
 namespace fl {
 
-InlineReducer::InlineReducer(double scale) : scale_(scale) {}
+namespace {
+
+ReducerMetrics& metrics() {
+  static ReducerMetrics metrics("inline");
+  return metrics;
+}
+
+} // namespace
+
+InlineReducer::InlineReducer(
+    double scale,
+    std::shared_ptr<GradientCompressor> compressor /* = nullptr */)
+    : scale_(scale), compressor_(std::move(compressor)) {}
 
 void InlineReducer::add(Variable& var) {
-  if (getWorldSize() > 1) {
-    allReduce(var.tensor());
+  metrics().gradients.inc();
+  metrics().gradientBytes.inc(var.bytes());
+  if (!compressor_) {
+    allReduce(var, scale_);
+    return;
+  }
+  // the copy shares its data with var, which thus gets the reduced value
+  std::vector<Variable> grads = {var};
+  compressor_->allReduce(grads, scale_, /* contiguous = */ false);
+}
+
+void InlineReducer::finalize() {
+  const auto start = std::chrono::steady_clock::now();
+  if (compressor_) {
+    compressor_->endStep();
   }
-  var.tensor() *= scale_;
+  metrics().finalizeSeconds.observe(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count());
 }
 
 } // namespace fl
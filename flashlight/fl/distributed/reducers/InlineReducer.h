@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <memory>
+
+#include "flashlight/fl/distributed/reducers/GradientCompressor.h"
 #include "flashlight/fl/distributed/reducers/Reducer.h"
 
 namespace fl {
@@ -15,11 +18,14 @@ class Variable;
 
 /**
  * A Reducer which calls allReduce directly on gradients to process. All
- * synchronized gradients are scaled by a pre-specified factor.
+ * synchronized gradients are scaled by a pre-specified factor. Gradients are
+ * reduced in a compressed form if a `GradientCompressor` is given.
  */
 class InlineReducer : public Reducer {
   /// A scale by which to scale reduced gradients
   double scale_;
+  /// Compresses the gradients to reduce, if any
+  std::shared_ptr<GradientCompressor> compressor_;
 
  public:
   /**
@@ -27,8 +33,12 @@ class InlineReducer : public Reducer {
    *
    * @param[in] scale the factor by which to scale gradients after
    * synchronization
+   * @param[in] compressor if non-null, reduces the gradients in a compressed
+   * form
    */
-  explicit InlineReducer(double scale);
+  explicit InlineReducer(
+      double scale,
+      std::shared_ptr<GradientCompressor> compressor = nullptr);
 
   /**
    * Ingest a Variable and immediately call allReduce on it.
@@ -37,8 +47,10 @@ class InlineReducer : public Reducer {
    */
   void add(Variable& var) override;
 
-  // no-op; no state
-  void finalize() override {}
+  /**
+   * Ends the step of the compressor, if any.
+   */
+  void finalize() override;
 };
 
 } // namespace fl
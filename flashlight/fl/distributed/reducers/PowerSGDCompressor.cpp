@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/distributed/reducers/PowerSGDCompressor.h"
+
+#include <random>
+#include <stdexcept>
+
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/distributed/DistributedApi.h"
+#include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Index.h"
+
+namespace fl {
+
+namespace {
+
+// Orthonormalizes the columns of a matrix with Gram-Schmidt
+Tensor orthogonalize(const Tensor& matrix) {
+  std::vector<Tensor> columns;
+  for (Dim i = 0; i < matrix.dim(1); ++i) {
+    auto column = matrix(fl::span, fl::range(i, i + 1));
+    for (const auto& prev : columns) {
+      column = column - fl::sum(column * prev, {0}, true) * prev;
+    }
+    column = column / (fl::sqrt(fl::sum(column * column, {0}, true)) + 1e-8);
+    columns.push_back(column);
+  }
+  return fl::concatenate(columns, 1);
+}
+
+// The same random start of the power iteration on all processes
+Tensor initialQ(Dim m, int rank, size_t seed) {
+  std::mt19937 generator(seed);
+  std::normal_distribution<float> normal;
+  std::vector<float> values(m * rank);
+  for (auto& value : values) {
+    value = normal(generator);
+  }
+  return Tensor::fromVector({m, rank}, values);
+}
+
+} // namespace
+
+PowerSGDCompressor::PowerSGDCompressor(
+    int rank /* = 1 */,
+    bool warmStart /* = true */)
+    : rank_(rank), warmStart_(warmStart) {
+  if (rank_ < 1) {
+    throw std::invalid_argument(
+        "PowerSGDCompressor: the rank must be positive");
+  }
+}
+
+void PowerSGDCompressor::allReduce(
+    std::vector<Variable>& grads,
+    double scale,
+    bool contiguous) {
+  // the matrices of compressed gradients, their P and Q, and the states
+  std::vector<size_t> compressedIdx;
+  std::vector<Tensor> matrices, ps, qs;
+  std::vector<State*> states;
+  // the other gradients, which are reduced with the P
+  std::vector<size_t> uncompressedIdx;
+  std::vector<Tensor> uncompressed;
+  for (size_t i = 0; i < grads.size(); ++i) {
+    auto& grad = grads[i];
+    if (grad.isRowSparse()) {
+      fl::allReduce(grad, scale);
+      continue;
+    }
+    const Dim n = grad.dim(0);
+    const Dim m = n == 0 ? 0 : grad.elements() / n;
+    if (grad.ndim() < 2 || (n + m) * rank_ >= n * m) {
+      uncompressedIdx.push_back(i);
+      uncompressed.push_back(grad.tensor());
+      continue;
+    }
+
+    const size_t idx = index_++;
+    if (states_.size() <= idx) {
+      states_.resize(idx + 1);
+    }
+    auto& state = states_[idx];
+    auto matrix = fl::reshape(grad.tensor().astype(fl::dtype::f32), {n, m});
+    if (!state.error.isEmpty() && state.error.shape() == matrix.shape()) {
+      matrix = matrix + state.error;
+    }
+    if (!warmStart_ || state.q.isEmpty() || state.q.dim(0) != m) {
+      state.q = initialQ(m, rank_, idx);
+    }
+    ps.push_back(fl::matmul(matrix, state.q));
+    matrices.push_back(matrix);
+    compressedIdx.push_back(i);
+    states.push_back(&state);
+  }
+
+  // reduce P and the uncompressed gradients
+  std::vector<Tensor*> tensors;
+  for (auto& p : ps) {
+    tensors.push_back(&p);
+  }
+  for (auto& tensor : uncompressed) {
+    tensors.push_back(&tensor);
+  }
+  allReduceTensors(tensors, contiguous);
+  for (size_t k = 0; k < uncompressed.size(); ++k) {
+    auto& grad = grads[uncompressedIdx[k]];
+    grad.tensor() = uncompressed[k] * scale;
+  }
+
+  // reduce Q
+  for (size_t k = 0; k < ps.size(); ++k) {
+    ps[k] = orthogonalize(ps[k]);
+    auto q = fl::matmul(
+        matrices[k], ps[k], MatrixProperty::Transpose, MatrixProperty::None);
+    // Q is reduced in place, so the error is computed beforehand
+    auto error = matrices[k] -
+        fl::matmul(ps[k], q, MatrixProperty::None, MatrixProperty::Transpose);
+    fl::eval(error);
+    states[k]->error = std::move(error);
+    qs.push_back(std::move(q));
+  }
+  tensors.clear();
+  for (auto& q : qs) {
+    tensors.push_back(&q);
+  }
+  allReduceTensors(tensors, contiguous);
+
+  for (size_t k = 0; k < qs.size(); ++k) {
+    auto& grad = grads[compressedIdx[k]];
+    auto approx = fl::matmul(
+        ps[k], qs[k], MatrixProperty::None, MatrixProperty::Transpose);
+    grad.tensor() =
+        fl::reshape(approx * scale, grad.shape()).astype(grad.type());
+    states[k]->q = std::move(qs[k]);
+  }
+}
+
+void PowerSGDCompressor::endStep() {
+  index_ = 0;
+}
+
+} // namespace fl
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "flashlight/fl/distributed/reducers/GradientCompressor.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+/**
+ * A `GradientCompressor` which reduces low-rank approximations of gradients,
+ * as in PowerSGD (https://arxiv.org/abs/1905.13727). A gradient, viewed as an
+ * n x m matrix M of its first dimension by the others, is approximated by
+ * P Q^T, with one step of power iteration: P = M Q is reduced and
+ * orthogonalized, and Q = M^T P is reduced, which sends (n + m) * rank rather
+ * than n * m values.
+ *
+ * Q starts from its reduced value of the previous step with warm start, and
+ * the approximation error of each gradient is added to the gradient of the
+ * next step. Gradients which a low-rank approximation doesn't compress, e.g.
+ * biases, are reduced as they are. The power iteration is computed in fp32.
+ */
+class PowerSGDCompressor : public GradientCompressor {
+ public:
+  /**
+   * @param[in] rank the rank of the approximation of each gradient
+   * @param[in] warmStart whether to start the power iteration of each
+   * gradient from its result in the previous step
+   */
+  explicit PowerSGDCompressor(int rank = 1, bool warmStart = true);
+
+  void allReduce(std::vector<Variable>& grads, double scale, bool contiguous)
+      override;
+
+  void endStep() override;
+
+ private:
+  struct State {
+    // the approximation error of the previous step
+    Tensor error;
+    // the reduced Q of the previous step, of size m x rank
+    Tensor q;
+  };
+
+  int rank_;
+  bool warmStart_;
+  std::vector<State> states_;
+  // the index of the next compressed gradient in the step
+  size_t index_{0};
+};
+
+} // namespace fl
@@ -7,10 +7,40 @@
 
 #pragma once
 
+#include <string>
+
+#include "flashlight/fl/common/Metrics.h"
+
 namespace fl {
 
 class Variable;
 
+/**
+ * The metrics of a kind of Reducer in the `MetricsRegistry`, labelled by
+ * reducer: the gradients added and their bytes, and the latency of
+ * `finalize`, which is where training blocks on synchronization.
+ */
+struct ReducerMetrics {
+  CounterMetric& gradients;
+  CounterMetric& gradientBytes;
+  HistogramMetric& finalizeSeconds;
+
+  explicit ReducerMetrics(const std::string& reducer)
+      : gradients(MetricsRegistry::getInstance().counter(
+            "fl_reducer_gradients_total",
+            "Gradients added to the reducers",
+            {{"reducer", reducer}})),
+        gradientBytes(MetricsRegistry::getInstance().counter(
+            "fl_reducer_gradient_bytes_total",
+            "Bytes of the gradients added to the reducers",
+            {{"reducer", reducer}})),
+        finalizeSeconds(MetricsRegistry::getInstance().histogram(
+            "fl_reducer_finalize_seconds",
+            "Latency of the finalize calls of the reducers",
+            HistogramMetric::exponentialBounds(1e-4, 4, 10),
+            {{"reducer", reducer}})) {}
+};
+
 /**
  * An interface for creating tensor reduction algorithms/rules.
  *
@@ -37,6 +67,26 @@ class Reducer {
    * processes or synchronizes all gradients that are added.
    */
   virtual void finalize() = 0;
+
+  /**
+   * Defers the reduction of the gradients given to the Reducer by gradient
+   * hooks (see `distributeModuleGrads`), which are then left as they are,
+   * e.g. while gradients are accumulated over the micro-batches of a step,
+   * such that only the accumulated gradients of the last micro-batch are
+   * reduced.
+   *
+   * @param[in] deferred whether to defer reductions
+   */
+  void setDeferred(bool deferred) {
+    deferred_ = deferred;
+  }
+
+  bool isDeferred() const {
+    return deferred_;
+  }
+
+ private:
+  bool deferred_{false};
 };
 
 } // namespace fl
@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include "flashlight/fl/distributed/reducers/CastCompressor.h"
 #include "flashlight/fl/distributed/reducers/CoalescingReducer.h"
+#include "flashlight/fl/distributed/reducers/GradientCompressor.h"
 #include "flashlight/fl/distributed/reducers/InlineReducer.h"
+#include "flashlight/fl/distributed/reducers/PowerSGDCompressor.h"
 #include "flashlight/fl/distributed/reducers/Reducer.h"
@@ -0,0 +1,520 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Benchmarks individual tensor ops on each available tensor backend, over a
+ * grid of shapes and types. Flags follow Google Benchmark's:
+ *
+ *   TensorBenchmark [--benchmark_filter=<regex>]
+ *     [--benchmark_min_time=<seconds>] [--benchmark_out=<file.json>]
+ *     [--backends=<comma-separated, e.g. ArrayFire,OneDnn,Jit(ArrayFire)>]
+ *
+ * Benchmarks are named `<backend>/<op>/<type>/<shape>`. If an output file is
+ * given, results are also written to it in Google Benchmark's JSON format,
+ * so that they can be compared across runs with its tooling.
+ *
+ * The `dispatch*` benchmarks run ops on single elements, to measure the host
+ * overhead of dispatching an op rather than its compute; on the `Stub`
+ * backend, which has no data, they measure the dispatch alone.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flashlight/fl/autograd/tensor/AutogradExtension.h"
+#include "flashlight/fl/autograd/tensor/AutogradOps.h"
+#include "flashlight/fl/common/Timer.h"
+#include "flashlight/fl/common/Utils.h"
+#include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/DefaultTensorType.h"
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/TensorBackend.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/TensorExtension.h"
+#if FL_USE_JIT
+#include "flashlight/fl/tensor/backend/jit/JitTensor.h"
+#endif
+
+using namespace fl;
+
+namespace {
+
+struct Options {
+  std::regex filter{".*"};
+  double minTime{0.5};
+  std::string out;
+  std::vector<std::string> backends;
+};
+
+struct Result {
+  std::string name;
+  int64_t iterations;
+  double realTime; // microseconds per iteration
+  double cpuTime; // microseconds per iteration
+  int64_t bytes; // bytes of the inputs and output, per iteration
+};
+
+struct NamedBackend {
+  std::string name;
+  TensorBackend* backend;
+};
+
+using Op = std::function<Tensor()>;
+
+std::vector<NamedBackend> availableBackends() {
+  std::vector<NamedBackend> backends;
+#if FL_USE_ARRAYFIRE
+  backends.push_back({"ArrayFire", &ArrayFireBackend::getInstance()});
+#endif
+#if FL_USE_ONEDNN
+  backends.push_back({"OneDnn", &OneDnnBackend::getInstance()});
+#endif
+#if FL_USE_JIT && FL_USE_ARRAYFIRE
+  backends.push_back(
+      {"Jit(ArrayFire)", &JitTensor<ArrayFireTensor>().backend()});
+#endif
+#if FL_USE_JIT && FL_USE_ONEDNN
+  backends.push_back({"Jit(OneDnn)", &JitTensor<OneDnnTensor>().backend()});
+#endif
+#if FL_USE_TENSOR_STUB
+  backends.push_back({"Stub", &StubBackend::getInstance()});
+#endif
+  return backends;
+}
+
+std::string shapeName(const Shape& shape) {
+  std::stringstream ss;
+  for (unsigned i = 0; i < shape.ndim(); ++i) {
+    ss << (i == 0 ? "" : "x") << shape[i];
+  }
+  return ss.str();
+}
+
+Options parseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const auto eq = arg.find('=');
+    const auto flag = arg.substr(0, eq);
+    const auto value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+    if (flag == "--benchmark_filter") {
+      options.filter = std::regex(value);
+    } else if (flag == "--benchmark_min_time") {
+      options.minTime = std::stod(value);
+    } else if (flag == "--benchmark_out") {
+      options.out = value;
+    } else if (flag == "--backends") {
+      std::stringstream ss(value);
+      std::string name;
+      while (std::getline(ss, name, ',')) {
+        options.backends.push_back(name);
+      }
+    } else {
+      throw std::invalid_argument("[TensorBenchmark] unknown flag " + arg);
+    }
+  }
+  return options;
+}
+
+class Benchmarker {
+ public:
+  explicit Benchmarker(const Options& options) : options_(options) {}
+
+  // Times `op`, which reads `inputs`, if its name matches the filter.
+  void run(
+      const std::string& name,
+      const std::vector<const Tensor*>& inputs,
+      const Op& op) {
+    if (!std::regex_search(name, options_.filter)) {
+      return;
+    }
+    // warm up, which also compiles kernels for JIT backends
+    Tensor output;
+    try {
+      output = op();
+      fl::eval(output);
+      output.stream().sync();
+    } catch (const std::exception& ex) {
+      // not every backend implements every op
+      std::cerr << name << " skipped: " << ex.what() << std::endl;
+      return;
+    }
+
+    int64_t iterations = 1;
+    double realTime = 0;
+    double cpuTime = 0;
+    while (true) {
+      const auto cpuStart = std::clock();
+      const auto start = fl::Timer::start();
+      for (int64_t i = 0; i < iterations; ++i) {
+        output = op();
+        fl::eval(output);
+      }
+      output.stream().sync();
+      realTime = fl::Timer::stop(start);
+      cpuTime = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+      if (realTime >= options_.minTime || iterations >= kMaxIterations) {
+        break;
+      }
+      // grow as Google Benchmark does, aiming past the min time
+      const double multiplier = realTime > 0
+          ? std::min(10., 1.4 * options_.minTime / realTime)
+          : 10.;
+      iterations = std::min(
+          kMaxIterations,
+          std::max(
+              iterations + 1,
+              static_cast<int64_t>(std::ceil(iterations * multiplier))));
+    }
+
+    int64_t bytes = output.bytes();
+    for (const auto* input : inputs) {
+      bytes += input->bytes();
+    }
+    Result result{
+        name,
+        iterations,
+        realTime * 1e6 / iterations,
+        cpuTime * 1e6 / iterations,
+        bytes};
+    std::cout << std::left << std::setw(56) << name << std::right
+              << std::setw(14) << std::fixed << std::setprecision(2)
+              << result.realTime << " us" << std::setw(14) << result.cpuTime
+              << " us" << std::setw(12) << iterations << std::endl;
+    results_.push_back(std::move(result));
+  }
+
+  void writeJson(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+      throw std::runtime_error(
+          "[TensorBenchmark] can't open output file " + path);
+    }
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << dateTimeWithMicroSeconds() << "\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency()
+        << ",\n    \"library_build_type\": \"flashlight\"\n  },\n"
+        << "  \"benchmarks\": [";
+    out << std::setprecision(6) << std::fixed;
+    for (size_t i = 0; i < results_.size(); ++i) {
+      const auto& result = results_[i];
+      const double bytesPerSecond =
+          result.realTime > 0 ? result.bytes * 1e6 / result.realTime : 0;
+      out << (i == 0 ? "\n" : ",\n") << "    {\n"
+          << "      \"name\": \"" << result.name << "\",\n"
+          << "      \"run_name\": \"" << result.name << "\",\n"
+          << "      \"run_type\": \"iteration\",\n"
+          << "      \"iterations\": " << result.iterations << ",\n"
+          << "      \"real_time\": " << result.realTime << ",\n"
+          << "      \"cpu_time\": " << result.cpuTime << ",\n"
+          << "      \"time_unit\": \"us\",\n"
+          << "      \"bytes_per_second\": " << bytesPerSecond << "\n"
+          << "    }";
+    }
+    out << "\n  ]\n}\n";
+  }
+
+ private:
+  static constexpr int64_t kMaxIterations = 1000000000;
+
+  const Options& options_;
+  std::vector<Result> results_;
+};
+
+// ]----- Benchmarks: each runs an op family over types and shapes
+
+const std::vector<Shape> kElementwiseShapes = {
+    {4096},
+    {256, 256},
+    {1024, 1024},
+    {64, 64, 64, 16}};
+
+const std::vector<dtype> kFloatTypes = {dtype::f16, dtype::f32, dtype::f64};
+
+std::vector<dtype> supportedTypes(
+    const NamedBackend& b,
+    const std::vector<dtype>& types) {
+  std::vector<dtype> supported;
+  for (const auto type : types) {
+    if (b.backend->isDataTypeSupported(type)) {
+      supported.push_back(type);
+    }
+  }
+  return supported;
+}
+
+std::string
+opName(const NamedBackend& b, const char* op, dtype type, const Shape& shape) {
+  return b.name + "/" + op + "/" + dtypeToString(type) + "/" +
+      shapeName(shape);
+}
+
+void benchmarkUnary(Benchmarker& bench, const NamedBackend& b) {
+  const std::vector<std::pair<const char*, Tensor (*)(const Tensor&)>> ops = {
+      {"exp", fl::exp},
+      {"log", fl::log},
+      {"sqrt", fl::sqrt},
+      {"tanh", fl::tanh},
+      {"sigmoid", fl::sigmoid},
+      {"erf", fl::erf},
+      {"abs", fl::abs},
+      {"negative", fl::negative},
+      {"floor", fl::floor}};
+  for (const auto type : supportedTypes(b, kFloatTypes)) {
+    for (const auto& shape : kElementwiseShapes) {
+      const auto x = b.backend->rand(shape, type);
+      for (const auto& [name, fn] : ops) {
+        bench.run(opName(b, name, type, shape), {&x}, [&x, fn = fn]() {
+          return fn(x);
+        });
+      }
+    }
+  }
+}
+
+void benchmarkBinary(Benchmarker& bench, const NamedBackend& b) {
+  for (const auto type : supportedTypes(
+           b, {dtype::f16, dtype::f32, dtype::f64, dtype::s32})) {
+    for (const auto& shape : kElementwiseShapes) {
+      const auto x = (b.backend->rand(shape, dtype::f32) * 100).astype(type);
+      const auto y =
+          (b.backend->rand(shape, dtype::f32) * 100 + 1).astype(type);
+      bench.run(opName(b, "add", type, shape), {&x, &y}, [&]() {
+        return x + y;
+      });
+      bench.run(opName(b, "mul", type, shape), {&x, &y}, [&]() {
+        return x * y;
+      });
+      bench.run(opName(b, "div", type, shape), {&x, &y}, [&]() {
+        return x / y;
+      });
+      bench.run(opName(b, "maximum", type, shape), {&x, &y}, [&]() {
+        return fl::maximum(x, y);
+      });
+      bench.run(opName(b, "greater", type, shape), {&x, &y}, [&]() {
+        return x > y;
+      });
+      bench.run(opName(b, "addScalar", type, shape), {&x}, [&]() {
+        return x + 2;
+      });
+      // broadcasting along the first axis
+      const auto row = y(fl::range(0, 1));
+      bench.run(opName(b, "addBroadcast", type, shape), {&x, &row}, [&]() {
+        return x + row;
+      });
+    }
+  }
+}
+
+void benchmarkReductions(Benchmarker& bench, const NamedBackend& b) {
+  for (const auto type : supportedTypes(b, kFloatTypes)) {
+    for (const auto& shape : kElementwiseShapes) {
+      const auto x = b.backend->rand(shape, type);
+      bench.run(opName(b, "sum", type, shape), {&x}, [&]() {
+        return fl::sum(x);
+      });
+      bench.run(opName(b, "sum0", type, shape), {&x}, [&]() {
+        return fl::sum(x, {0});
+      });
+      bench.run(opName(b, "amax0", type, shape), {&x}, [&]() {
+        return fl::amax(x, {0});
+      });
+      bench.run(opName(b, "mean0", type, shape), {&x}, [&]() {
+        return fl::mean(x, {0});
+      });
+      bench.run(opName(b, "var0", type, shape), {&x}, [&]() {
+        return fl::var(x, {0});
+      });
+      bench.run(opName(b, "argmax0", type, shape), {&x}, [&]() {
+        return fl::argmax(x, 0);
+      });
+      bench.run(opName(b, "cumsum0", type, shape), {&x}, [&]() {
+        return fl::cumsum(x, 0);
+      });
+      bench.run(opName(b, "sort0", type, shape), {&x}, [&]() {
+        return fl::sort(x, 0);
+      });
+    }
+  }
+}
+
+void benchmarkMatmul(Benchmarker& bench, const NamedBackend& b) {
+  for (const auto type : supportedTypes(b, kFloatTypes)) {
+    for (const Dim n : {64, 256, 1024, 2048}) {
+      const Shape shape({n, n});
+      const auto x = b.backend->rand(shape, type);
+      const auto y = b.backend->rand(shape, type);
+      bench.run(opName(b, "matmul", type, shape), {&x, &y}, [&]() {
+        return fl::matmul(x, y);
+      });
+      bench.run(opName(b, "matmulTransposed", type, shape), {&x, &y}, [&]() {
+        return fl::matmul(
+            x, y, MatrixProperty::Transpose, MatrixProperty::Transpose);
+      });
+    }
+    // batched
+    const Shape shape({128, 128, 64});
+    const auto x = b.backend->rand(shape, type);
+    const auto y = b.backend->rand(shape, type);
+    bench.run(opName(b, "matmulBatched", type, shape), {&x, &y}, [&]() {
+      return fl::matmul(x, y);
+    });
+  }
+}
+
+void benchmarkConv(Benchmarker& bench, const NamedBackend& b) {
+  // convolutions are implemented by autograd extensions
+  if (!detail::TensorExtensionRegistrar::getInstance()
+           .isTensorExtensionRegistered(
+               b.backend->backendType(), TensorExtensionType::Autograd)) {
+    return;
+  }
+  struct Conv {
+    Shape input; // [W, H, C, N]
+    Dim filter;
+    Dim outChannels;
+    int stride;
+  };
+  const std::vector<Conv> convs = {
+      {{56, 56, 64, 16}, 3, 64, 1},
+      {{28, 28, 128, 16}, 3, 128, 1},
+      {{14, 14, 256, 16}, 1, 1024, 1},
+      {{224, 224, 3, 16}, 7, 64, 2}};
+  for (const auto type : supportedTypes(b, {dtype::f16, dtype::f32})) {
+    for (const auto& conv : convs) {
+      const auto x = b.backend->rand(conv.input, type);
+      const auto w = b.backend->rand(
+          {conv.filter, conv.filter, conv.input[2], conv.outChannels}, type);
+      const int pad = conv.filter / 2;
+      bench.run(opName(b, "conv2d", type, conv.input), {&x, &w}, [&]() {
+        return fl::conv2d(x, w, conv.stride, conv.stride, pad, pad);
+      });
+    }
+  }
+}
+
+void benchmarkIndexing(Benchmarker& bench, const NamedBackend& b) {
+  for (const auto type :
+       supportedTypes(b, {dtype::f32, dtype::f64, dtype::s32})) {
+    for (const Shape& shape : {Shape({256, 256}), Shape({4096, 1024})}) {
+      const auto x = b.backend->rand(shape, dtype::f32).astype(type);
+      const Dim rows = shape[0];
+      const Dim cols = shape[1];
+      const auto indices =
+          (b.backend->rand({cols / 2}, dtype::f32) * (cols - 1))
+              .astype(dtype::s32);
+      bench.run(opName(b, "slice", type, shape), {&x}, [&]() {
+        return x(fl::range(rows / 4, 3 * rows / 4), fl::range(0, cols / 2))
+            .copy();
+      });
+      bench.run(opName(b, "gather", type, shape), {&x, &indices}, [&]() {
+        return x(fl::span, indices).copy();
+      });
+      bench.run(opName(b, "assign", type, shape), {&x}, [&]() {
+        auto y = x.copy();
+        y(fl::range(0, rows / 2)) = 0;
+        return y;
+      });
+      bench.run(opName(b, "transpose", type, shape), {&x}, [&]() {
+        return fl::transpose(x);
+      });
+      bench.run(opName(b, "concatenate", type, shape), {&x}, [&]() {
+        return fl::concatenate(0, x, x);
+      });
+    }
+  }
+}
+
+void benchmarkDispatch(Benchmarker& bench, const NamedBackend& b) {
+  const Shape shape({1});
+  const auto type = dtype::f32;
+  const auto x = b.backend->rand(shape, type);
+  const auto y = b.backend->rand(shape, type);
+  bench.run(opName(b, "dispatchAdd", type, shape), {&x, &y}, [&]() {
+    return x + y;
+  });
+  bench.run(opName(b, "dispatchAddScalar", type, shape), {&x}, [&]() {
+    return x + 2;
+  });
+  bench.run(opName(b, "dispatchExp", type, shape), {&x}, [&]() {
+    return fl::exp(x);
+  });
+  bench.run(opName(b, "dispatchSum", type, shape), {&x}, [&]() {
+    return fl::sum(x);
+  });
+  bench.run(opName(b, "dispatchReshape", type, shape), {&x}, [&]() {
+    return fl::reshape(x, {1, 1});
+  });
+  bench.run(opName(b, "dispatchIndex", type, shape), {&x}, [&]() {
+    return x(0);
+  });
+  // creation, which dispatches to the default backend
+  if (&defaultTensorBackend() == b.backend) {
+    bench.run(opName(b, "dispatchFull", type, shape), {}, [&]() {
+      return fl::full(shape, 1., type);
+    });
+  }
+  // a chain of ops as in a step of a recurrent decoder
+  bench.run(opName(b, "dispatchChain", type, shape), {&x, &y}, [&]() {
+    return fl::tanh(x * y + x) - y;
+  });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  fl::init();
+  const auto options = parseOptions(argc, argv);
+
+  std::vector<NamedBackend> backends;
+  for (const auto& backend : availableBackends()) {
+    if (options.backends.empty() ||
+        std::find(
+            options.backends.begin(), options.backends.end(), backend.name) !=
+            options.backends.end()) {
+      backends.push_back(backend);
+    }
+  }
+  if (backends.empty()) {
+    std::cerr << "No matching tensor backend is available" << std::endl;
+    return 1;
+  }
+
+  Benchmarker bench(options);
+  std::cout << std::left << std::setw(56) << "Benchmark" << std::right
+            << std::setw(17) << "Time" << std::setw(17) << "CPU"
+            << std::setw(12) << "Iterations" << std::endl;
+  for (const auto& backend : backends) {
+    const std::vector<void (*)(Benchmarker&, const NamedBackend&)> suites = {
+        benchmarkDispatch,
+        benchmarkUnary,
+        benchmarkBinary,
+        benchmarkReductions,
+        benchmarkMatmul,
+        benchmarkConv,
+        benchmarkIndexing};
+    for (const auto& suite : suites) {
+      suite(bench, backend);
+    }
+  }
+  if (!options.out.empty()) {
+    bench.writeJson(options.out);
+  }
+  return 0;
+}
@@ -20,6 +20,10 @@ void AverageValueMeter::reset() {
   curMeanSquaredSum_ = 0;
   curWeightSum_ = 0;
   curWeightSquaredSum_ = 0;
+  pendingSum_ = Tensor();
+  pendingSquaredSum_ = Tensor();
+  pendingWeight_ = 0;
+  updateMetric();
 }
 
 void AverageValueMeter::add(const double val, const double w /* = 1.0 */) {
@@ -33,28 +37,64 @@ void AverageValueMeter::add(const double val, const double w /* = 1.0 */) {
   curMean_ = curMean_ + w * (val - curMean_) / curWeightSum_;
   curMeanSquaredSum_ =
       curMeanSquaredSum_ + w * (val * val - curMeanSquaredSum_) / curWeightSum_;
+  updateMetric();
 }
 
 void AverageValueMeter::add(const Tensor& vals) {
-  double w = vals.elements();
-  curWeightSum_ += w;
+  const double w = vals.elements();
+  if (w == 0) {
+    return;
+  }
   curWeightSquaredSum_ += w;
+  const Tensor sum = fl::sum(vals);
+  const Tensor squaredSum = fl::sum(vals * vals);
+  if (pendingSum_.isEmpty()) {
+    pendingSum_ = sum;
+    pendingSquaredSum_ = squaredSum;
+  } else {
+    pendingSum_ = pendingSum_ + sum;
+    pendingSquaredSum_ = pendingSquaredSum_ + squaredSum;
+  }
+  pendingWeight_ += w;
+}
 
-  if (curWeightSum_ == 0) {
+void AverageValueMeter::flush() const {
+  if (pendingSum_.isEmpty()) {
     return;
   }
-
+  const double weightSum = curWeightSum_ + pendingWeight_;
   curMean_ = curMean_ +
-      (fl::sum(vals).asScalar<double>() - w * curMean_) / curWeightSum_;
+      (pendingSum_.asScalar<double>() - pendingWeight_ * curMean_) / weightSum;
   curMeanSquaredSum_ = curMeanSquaredSum_ +
-      (fl::sum(vals * vals).asScalar<double>() - w * curMeanSquaredSum_) /
-          curWeightSum_;
+      (pendingSquaredSum_.asScalar<double>() -
+       pendingWeight_ * curMeanSquaredSum_) /
+          weightSum;
+  curWeightSum_ = weightSum;
+  pendingSum_ = Tensor();
+  pendingSquaredSum_ = Tensor();
+  pendingWeight_ = 0;
+  updateMetric();
 }
 
 std::vector<double> AverageValueMeter::value() const {
+  flush();
   double mean = curMean_;
   double var = (curMeanSquaredSum_ - curMean_ * curMean_) /
       (1 - curWeightSquaredSum_ / (curWeightSum_ * curWeightSum_));
   return {mean, var, curWeightSum_};
 }
+
+void AverageValueMeter::exportMetric(
+    const std::string& name,
+    const std::string& help,
+    const MetricLabels& labels /* = {} */) {
+  metric_ = &MetricsRegistry::getInstance().gauge(name, help, labels);
+  updateMetric();
+}
+
+void AverageValueMeter::updateMetric() const {
+  if (metric_) {
+    metric_->set(curMean_);
+  }
+}
 } // namespace fl
@@ -7,11 +7,13 @@
 
 #pragma once
 
+#include <string>
 #include <vector>
 
-namespace fl {
+#include "flashlight/fl/common/Metrics.h"
+#include "flashlight/fl/tensor/TensorBase.h"
 
-class Tensor;
+namespace fl {
 
 /** An implementation of average value meter, which measures the mean and
  * variance of a sequence of values.
@@ -45,7 +47,11 @@ class AverageValueMeter {
   /** Updates counters with the given value `val` with weight `w`. */
   void add(const double val, const double w = 1.0);
 
-  /** Updates counters with all values in `vals` with equal weights. */
+  /** Updates counters with all values in `vals` with equal weights. The sums
+   * of the values are accumulated on the device, without waiting for their
+   * computation, and only read by `value`: adding every step doesn't
+   * synchronize with the device.
+   */
   void add(const Tensor& vals);
 
   /** Returns a vector of four values:
@@ -60,10 +66,28 @@ class AverageValueMeter {
   /** Sets all the counters to 0. */
   void reset();
 
+  /** Exports the mean of the meter as a gauge of the `MetricsRegistry`,
+   * updated on `add` and `reset`, and by `value` for values added as tensors.
+   */
+  void exportMetric(
+      const std::string& name,
+      const std::string& help,
+      const MetricLabels& labels = {});
+
  private:
-  double curMean_;
-  double curMeanSquaredSum_;
-  double curWeightSum_;
+  void updateMetric() const;
+  // merges the pending sums into the counters
+  void flush() const;
+
+  GaugeMetric* metric_{nullptr};
+  mutable double curMean_;
+  mutable double curMeanSquaredSum_;
+  mutable double curWeightSum_;
   double curWeightSquaredSum_;
+  // the sums of the values and squared values added as tensors since the
+  // last flush, and their weight
+  mutable Tensor pendingSum_;
+  mutable Tensor pendingSquaredSum_;
+  mutable double pendingWeight_{0};
 };
 } // namespace fl
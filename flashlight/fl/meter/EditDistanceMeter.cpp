@@ -7,6 +7,8 @@
 
 #include "flashlight/fl/meter/EditDistanceMeter.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdlib> // TODO: whatever is actually needed for free?
 #include <stdexcept>
 
@@ -38,7 +40,7 @@ void EditDistanceMeter::add(const Tensor& output, const Tensor& target) {
 
   int* in1raw = output.host<int>();
   int* in2raw = target.host<int>();
-  auto err_state = levensteinDistance(in1raw, in2raw, len1, len2);
+  auto err_state = editDistance(in1raw, len1, in2raw, len2);
   free(in1raw);
   in1raw = nullptr;
   free(in2raw);
@@ -57,6 +59,79 @@ void EditDistanceMeter::add(
   nsub_ += nsub;
 }
 
+EditDistanceMeter::ErrorState EditDistanceMeter::editDistance(
+    const int* output,
+    size_t olen,
+    const int* target,
+    size_t tlen) {
+  // Cell (x, y) is the distance between the first x elements of the target
+  // and the first y of the output, on anti-diagonal x + y. The cells of an
+  // anti-diagonal depend on the two previous ones, which are indexed by y
+  // too. The number of substitutions is the distance minus the others.
+  struct Diagonal {
+    std::vector<int> cost, ndel, nins;
+    explicit Diagonal(size_t size) : cost(size), ndel(size), nins(size) {}
+  };
+  Diagonal prev2(olen + 1), prev(olen + 1), cur(olen + 1);
+  // the target reversed, such that the target element of cell (x, y) of
+  // anti-diagonal d, x = d - y, is at tlen - d + y
+  std::vector<int> reversed(target, target + tlen);
+  std::reverse(reversed.begin(), reversed.end());
+  const int* rev = reversed.data();
+
+  for (size_t d = 1; d <= olen + tlen; ++d) {
+    const size_t ylo = d > tlen ? d - tlen : 0;
+    const size_t yhi = std::min(olen, d);
+    if (ylo == 0) { // the empty output: deletions
+      cur.cost[0] = d;
+      cur.ndel[0] = d;
+      cur.nins[0] = 0;
+    }
+    if (yhi == d) { // the empty target: insertions
+      cur.cost[d] = d;
+      cur.ndel[d] = 0;
+      cur.nins[d] = d;
+    }
+    const size_t begin = std::max<size_t>(ylo, 1);
+    const size_t end = std::min(yhi, d - 1) + 1;
+    const std::ptrdiff_t shift = static_cast<std::ptrdiff_t>(tlen) - d;
+    const int* pc1 = prev.cost.data();
+    const int* pd1 = prev.ndel.data();
+    const int* pi1 = prev.nins.data();
+    const int* pc2 = prev2.cost.data();
+    const int* pd2 = prev2.ndel.data();
+    const int* pi2 = prev2.nins.data();
+    int* cc = cur.cost.data();
+    int* cd = cur.ndel.data();
+    int* ci = cur.nins.data();
+    // branchless, with unconditional loads, so that it vectorizes
+    for (size_t y = begin; y < end; ++y) {
+      const int del = pc1[y] + 1;
+      const int ins = pc1[y - 1] + 1;
+      const int sub = pc2[y - 1] + (output[y - 1] != rev[shift + y]);
+      const int delDel = pd1[y] + 1, insDel = pd1[y - 1], subDel = pd2[y - 1];
+      const int delIns = pi1[y], insIns = pi1[y - 1] + 1, subIns = pi2[y - 1];
+      const int cost = std::min(std::min(del, ins), sub);
+      // all ones if the cell is a deletion, an insertion or else
+      const int isDel = -static_cast<int>(del == cost);
+      const int isIns = ~isDel & -static_cast<int>(ins == cost);
+      const int isSub = ~(isDel | isIns);
+      cc[y] = cost;
+      cd[y] = (delDel & isDel) | (insDel & isIns) | (subDel & isSub);
+      ci[y] = (delIns & isDel) | (insIns & isIns) | (subIns & isSub);
+    }
+    std::swap(prev2, prev);
+    std::swap(prev, cur);
+  }
+
+  ErrorState errors;
+  const auto& last = olen + tlen == 0 ? cur : prev;
+  errors.ndel = last.ndel[olen];
+  errors.nins = last.nins[olen];
+  errors.nsub = last.cost[olen] - errors.ndel - errors.nins;
+  return errors;
+}
+
 std::vector<int64_t> EditDistanceMeter::value() const {
   return {sumErr(), n_, ndel_, nins_, nsub_};
 }
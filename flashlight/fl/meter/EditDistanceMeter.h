@@ -8,13 +8,80 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace fl {
 
 class Tensor;
 
+namespace detail {
+
+template <typename V, typename = void>
+struct IsHashable : std::false_type {};
+
+template <typename V>
+struct IsHashable<
+    V,
+    std::void_t<decltype(std::hash<V>()(std::declval<const V&>()))>>
+    : std::true_type {};
+
+/**
+ * Maps the elements of two sequences to integer ids, equal iff the elements
+ * are equal.
+ */
+template <typename T, typename S>
+void toIds(
+    const T& in1begin,
+    const S& in2begin,
+    size_t len1,
+    size_t len2,
+    std::vector<int>& ids1,
+    std::vector<int>& ids2) {
+  using V = std::decay_t<decltype(*in1begin)>;
+  ids1.resize(len1);
+  ids2.resize(len2);
+  if constexpr (IsHashable<V>::value) {
+    std::unordered_map<V, int> ids;
+    auto in1 = in1begin;
+    for (size_t i = 0; i < len1; ++i, ++in1) {
+      ids1[i] = ids.emplace(*in1, ids.size()).first->second;
+    }
+    auto in2 = in2begin;
+    for (size_t i = 0; i < len2; ++i, ++in2) {
+      ids2[i] = ids.emplace(*in2, ids.size()).first->second;
+    }
+  } else {
+    // only equality comparable
+    std::vector<V> values;
+    auto getId = [&values](const V& value) {
+      auto it = std::find(values.begin(), values.end(), value);
+      if (it == values.end()) {
+        values.push_back(value);
+        return static_cast<int>(values.size() - 1);
+      }
+      return static_cast<int>(it - values.begin());
+    };
+    auto in1 = in1begin;
+    for (size_t i = 0; i < len1; ++i, ++in1) {
+      ids1[i] = getId(*in1);
+    }
+    auto in2 = in2begin;
+    for (size_t i = 0; i < len2; ++i, ++in2) {
+      ids2[i] = getId(*in2);
+    }
+  }
+}
+
+} // namespace detail
+
 /** An implementation of edit distance meter, which measures the edit distance
  * between targets and predictions made by the model.
  * Example usage:
@@ -106,9 +173,66 @@ class EditDistanceMeter {
     add(output.data(), target.data(), output.size(), target.size());
   }
 
+  /** Computes the edit distances between the pairs of sequences of `outputs`
+   * and `targets`, e.g. of a whole evaluation set, on `numThreads` threads (0
+   * for the number of cores), and updates the counters.
+   */
+  template <typename T>
+  void addBatch(
+      const std::vector<std::vector<T>>& outputs,
+      const std::vector<std::vector<T>>& targets,
+      size_t numThreads = 0) {
+    if (outputs.size() != targets.size()) {
+      throw std::invalid_argument(
+          "EditDistanceMeter::addBatch - outputs and targets sizes differ");
+    }
+    if (numThreads == 0) {
+      numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    numThreads = std::min(numThreads, outputs.size());
+    // the errors and target lengths of each thread
+    std::vector<std::pair<ErrorState, int64_t>> results(numThreads);
+    auto work = [&](size_t thread) {
+      for (size_t i = thread; i < outputs.size(); i += numThreads) {
+        auto errors = levensteinDistance(
+            outputs[i].data(),
+            targets[i].data(),
+            outputs[i].size(),
+            targets[i].size());
+        auto& [sum, n] = results[thread];
+        sum.ndel += errors.ndel;
+        sum.nins += errors.nins;
+        sum.nsub += errors.nsub;
+        n += targets[i].size();
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_t thread = 1; thread < numThreads; ++thread) {
+      threads.emplace_back(work, thread);
+    }
+    if (numThreads > 0) {
+      work(0);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (const auto& [errors, n] : results) {
+      add(errors, n);
+    }
+  }
+
   /** Sets all the counters to 0. */
   void reset();
 
+  /** Computes the edit distance between sequences of ids. Cells of the
+   * dynamic programming are computed by anti-diagonals, which are
+   * independent, so that they vectorize. Among the alignments of minimal
+   * distance, errors are attributed preferring deletions, then insertions,
+   * then substitutions.
+   */
+  static ErrorState
+  editDistance(const int* output, size_t olen, const int* target, size_t tlen);
+
  private:
   int64_t n_;
   int64_t ndel_;
@@ -119,52 +243,19 @@ class EditDistanceMeter {
     return ndel_ + nins_ + nsub_;
   }
 
-  template <typename T>
+  template <typename T, typename S>
   ErrorState levensteinDistance(
       const T& in1begin,
-      const T& in2begin,
+      const S& in2begin,
       size_t len1,
       size_t len2) const {
-    std::vector<ErrorState> column(len1 + 1);
-    for (int i = 0; i <= len1; ++i) {
-      column[i].nins = i;
+    if constexpr (std::is_same_v<T, const int*> && std::is_same_v<S, T>) {
+      return editDistance(in1begin, len1, in2begin, len2);
+    } else {
+      std::vector<int> ids1, ids2;
+      detail::toIds(in1begin, in2begin, len1, len2, ids1, ids2);
+      return editDistance(ids1.data(), len1, ids2.data(), len2);
     }
-
-    auto curin2 = in2begin;
-    for (int x = 1; x <= len2; x++) {
-      ErrorState lastdiagonal = column[0];
-      column[0].ndel = x;
-      auto curin1 = in1begin;
-      for (int y = 1; y <= len1; y++) {
-        auto olddiagonal = column[y];
-        auto possibilities = {
-            column[y].sum() + 1,
-            column[y - 1].sum() + 1,
-            lastdiagonal.sum() + ((*curin1 == *curin2) ? 0 : 1)};
-        auto min_it =
-            std::min_element(possibilities.begin(), possibilities.end());
-        if (std::distance(possibilities.begin(), min_it) ==
-            0) { // deletion error
-          ++column[y].ndel;
-        } else if (
-            std::distance(possibilities.begin(), min_it) == 1) { // insertion
-          // error
-          column[y] = column[y - 1];
-          ++column[y].nins;
-        } else {
-          column[y] = lastdiagonal;
-          if (*curin1 != *curin2) { // substitution error
-            ++column[y].nsub;
-          }
-        }
-
-        lastdiagonal = olddiagonal;
-        ++curin1;
-      }
-      ++curin2;
-    }
-
-    return column[len1];
   }
 };
 } // namespace fl
@@ -19,6 +19,8 @@ MSEMeter::MSEMeter() {
 void MSEMeter::reset() {
   curN_ = 0;
   curValue_ = .0;
+  pendingSum_ = Tensor();
+  pendingN_ = 0;
 }
 
 void MSEMeter::add(const Tensor& output, const Tensor& target) {
@@ -26,13 +28,19 @@ void MSEMeter::add(const Tensor& output, const Tensor& target) {
     throw std::invalid_argument("dimension mismatch in MSEMeter");
   }
   ++curN_;
-  curValue_ =
-      (curValue_ * (curN_ - 1) +
-       fl::sum((output - target) * (output - target)).asScalar<double>()) /
-      curN_;
+  const Tensor error = fl::sum((output - target) * (output - target));
+  pendingSum_ = pendingSum_.isEmpty() ? error : pendingSum_ + error;
+  ++pendingN_;
 }
 
 double MSEMeter::value() const {
+  if (!pendingSum_.isEmpty()) {
+    curValue_ = (curValue_ * (curN_ - pendingN_) +
+                 pendingSum_.asScalar<double>()) /
+        curN_;
+    pendingSum_ = Tensor();
+    pendingN_ = 0;
+  }
   return curValue_;
 }
 } // namespace fl
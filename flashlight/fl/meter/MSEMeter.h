@@ -9,9 +9,9 @@
 
 #include <cstdint>
 
-namespace fl {
+#include "flashlight/fl/tensor/TensorBase.h"
 
-class Tensor;
+namespace fl {
 
 /** An implementation of mean square error meter, which measures the mean square
  * error between targets and predictions made by the model.
@@ -37,7 +37,8 @@ class MSEMeter {
 
   /** Computes mean square error between two arrayfire arrays `output` and
    * `target` and updates the counters. Note that the shape of the two input
-   * arrays should be identical.
+   * arrays should be identical. The error is accumulated on the device,
+   * without waiting for its computation, and only read by `value`.
    */
   void add(const Tensor& output, const Tensor& target);
 
@@ -48,7 +49,11 @@ class MSEMeter {
   void reset();
 
  private:
-  double curValue_;
+  mutable double curValue_;
   int64_t curN_;
+  // the sum of the errors added since curValue_ was last updated, and their
+  // number
+  mutable Tensor pendingSum_;
+  mutable int64_t pendingN_{0};
 };
 } // namespace fl
@@ -7,6 +7,8 @@
 
 #include "flashlight/fl/meter/TimeMeter.h"
 
+#include "flashlight/fl/runtime/StreamTimer.h"
+
 namespace fl {
 
 TimeMeter::TimeMeter(bool unit /* = false */) : useUnit_(unit) {
@@ -17,17 +19,30 @@ void TimeMeter::reset() {
   curN_ = 0;
   curValue_ = 0.;
   isStopped_ = true;
+  if (streamTimer_) {
+    streamTimer_->reset();
+  }
+  updateMetric();
 }
 
 void TimeMeter::set(double val, int64_t num /* = 1 */) {
   curValue_ = val;
   curN_ = num;
   start_ = std::chrono::system_clock::now();
+  if (streamTimer_) {
+    streamTimer_->reset();
+    if (!isStopped_) {
+      streamTimer_->start();
+    }
+  }
+  updateMetric();
 }
 
 double TimeMeter::value() const {
   double val = curValue_;
-  if (!isStopped_) {
+  if (streamTimer_) {
+    val += streamTimer_->elapsedSeconds();
+  } else if (!isStopped_) {
     std::chrono::duration<double> duration =
         std::chrono::system_clock::now() - start_;
     val += duration.count();
@@ -35,6 +50,9 @@ double TimeMeter::value() const {
   if (useUnit_) {
     val = (curN_ > 0) ? (val / curN_) : 0.0;
   }
+  if (streamTimer_ && metric_) {
+    metric_->set(val);
+  }
   return val;
 }
 
@@ -42,17 +60,26 @@ void TimeMeter::stop() {
   if (isStopped_) {
     return;
   }
-  std::chrono::duration<double> duration =
-      std::chrono::system_clock::now() - start_;
-  curValue_ += duration.count();
+  if (streamTimer_) {
+    streamTimer_->stop();
+  } else {
+    std::chrono::duration<double> duration =
+        std::chrono::system_clock::now() - start_;
+    curValue_ += duration.count();
+  }
   isStopped_ = true;
+  updateMetric();
 }
 
 void TimeMeter::resume() {
   if (!isStopped_) {
     return;
   }
-  start_ = std::chrono::system_clock::now();
+  if (streamTimer_) {
+    streamTimer_->start();
+  } else {
+    start_ = std::chrono::system_clock::now();
+  }
   isStopped_ = false;
 }
 
@@ -63,5 +90,26 @@ void TimeMeter::incUnit(int64_t num) {
 void TimeMeter::stopAndIncUnit(int64_t num) {
   stop();
   incUnit(num);
+  updateMetric();
+}
+
+void TimeMeter::setStream(const Stream* stream) {
+  streamTimer_ = stream ? std::make_shared<StreamTimer>(*stream) : nullptr;
+  reset();
+}
+
+void TimeMeter::exportMetric(
+    const std::string& name,
+    const std::string& help,
+    const MetricLabels& labels /* = {} */) {
+  metric_ = &MetricsRegistry::getInstance().gauge(name, help, labels);
+  updateMetric();
+}
+
+void TimeMeter::updateMetric() {
+  // stream times are only resolved on reads, by value
+  if (metric_ && !streamTimer_) {
+    metric_->set(value());
+  }
 }
 } // namespace fl
@@ -8,9 +8,16 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
+#include <string>
+
+#include "flashlight/fl/common/Metrics.h"
 
 namespace fl {
 
+class Stream;
+class StreamTimer;
+
 /** An implementation of timer, which measures the wall clock time.
  * Example usage:
  *
@@ -21,6 +28,9 @@ namespace fl {
  * meter.stop();
  * double time = meter.value();
  * \endcode
+ *
+ * To time the work of a device stream rather than the host, without
+ * synchronizing with the device, see `setStream`.
  */
 class TimeMeter {
  public:
@@ -54,7 +64,27 @@ class TimeMeter {
   /** Stops the timer and increase the number of units by `num`. */
   void stopAndIncUnit(int64_t num = 1);
 
+  /** Times the work of given stream, with events recorded on it by `resume`
+   * and `stop` (see `StreamTimer`), rather than the host clock; nullptr
+   * restores the host clock. Resets the meter. The time is only resolved by
+   * `value`, which waits for the work of the timed intervals.
+   */
+  void setStream(const Stream* stream);
+
+  /** Exports the value of the meter as a gauge of the `MetricsRegistry`,
+   * updated when the timer stops, and on `set` and `reset`; or by `value` when
+   * timing a stream.
+   */
+  void exportMetric(
+      const std::string& name,
+      const std::string& help,
+      const MetricLabels& labels = {});
+
  private:
+  void updateMetric();
+
+  GaugeMetric* metric_{nullptr};
+  std::shared_ptr<StreamTimer> streamTimer_;
   std::chrono::time_point<std::chrono::system_clock> start_;
   double curValue_;
   int64_t curN_;
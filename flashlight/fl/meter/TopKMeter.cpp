@@ -28,7 +28,9 @@ void TopKMeter::add(const Tensor& output, const Tensor& target) {
   match = maxIds == fl::reshape(target, {1, target.dim(0), 1, 1});
   const Tensor correct = fl::any(match, {0});
 
-  correct_ += fl::countNonzero(correct).asScalar<int32_t>();
+  const Tensor count = fl::countNonzero(correct).astype(fl::dtype::s32);
+  pendingCorrect_ =
+      pendingCorrect_.isEmpty() ? count : pendingCorrect_ + count;
   const int batchsize = target.dim(0);
   n_ += batchsize;
 }
@@ -36,19 +38,29 @@ void TopKMeter::add(const Tensor& output, const Tensor& target) {
 void TopKMeter::reset() {
   correct_ = 0;
   n_ = 0;
+  pendingCorrect_ = Tensor();
+}
+
+int32_t TopKMeter::correct() const {
+  if (!pendingCorrect_.isEmpty()) {
+    correct_ += pendingCorrect_.asScalar<int32_t>();
+    pendingCorrect_ = Tensor();
+  }
+  return correct_;
 }
 
 double TopKMeter::value() const {
-  return (static_cast<double>(correct_) / n_) * 100.0f;
+  return (static_cast<double>(correct()) / n_) * 100.0f;
 }
 
 std::pair<int32_t, int32_t> TopKMeter::getStats() {
-  return std::make_pair(correct_, n_);
+  return std::make_pair(correct(), n_);
 }
 
 void TopKMeter::set(int32_t correct, int32_t n) {
   n_ = n;
   correct_ = correct;
+  pendingCorrect_ = Tensor();
 }
 
 } // namespace fl
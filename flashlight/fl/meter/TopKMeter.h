@@ -9,9 +9,9 @@
 #include <cstdint>
 #include <utility>
 
-namespace fl {
+#include "flashlight/fl/tensor/TensorBase.h"
 
-class Tensor;
+namespace fl {
 
 /** TopKMeter computes the accuracy of the model outputs predicting the target
  * label in the top k predictions.
@@ -38,6 +38,10 @@ class TopKMeter {
    */
   explicit TopKMeter(const int k);
 
+  /** Adds the predictions of a batch. The number of correct predictions is
+   * accumulated on the device, without waiting for the computation of the
+   * batch, and only read by `value` and `getStats`.
+   */
   void add(const Tensor& output, const Tensor& target);
 
   void reset();
@@ -51,8 +55,12 @@ class TopKMeter {
 
  private:
   int k_;
-  int32_t correct_;
+  mutable int32_t correct_;
   int32_t n_;
+  // the correct predictions added since correct_ was last read
+  mutable Tensor pendingCorrect_;
+
+  int32_t correct() const;
 };
 
 } // namespace fl
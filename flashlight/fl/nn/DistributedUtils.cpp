@@ -7,15 +7,22 @@
 
 #include "flashlight/fl/nn/DistributedUtils.h"
 
+#include <sstream>
 #include <stdexcept>
 
+#include "flashlight/fl/common/Serialization.h"
+
 namespace fl {
 
 void distributeModuleGrads(
     std::shared_ptr<const Module> module,
     std::shared_ptr<Reducer> reducer) {
   for (auto& param : module->params()) {
-    param.registerGradHook([reducer](Variable& grad) { reducer->add(grad); });
+    param.registerGradHook([reducer](Variable& grad) {
+      if (!reducer->isDeferred()) {
+        reducer->add(grad);
+      }
+    });
   }
 }
 
@@ -40,4 +47,16 @@ void allReduceGradients(
   };
 }
 
+std::shared_ptr<Module> replicateModule(std::shared_ptr<Module> module) {
+  if (!module) {
+    throw std::invalid_argument("null module passed to replicateModule");
+  }
+  // the parameters are loaded into tensors of the active device
+  std::stringstream ss;
+  save(ss, module);
+  std::shared_ptr<Module> replica;
+  load(ss, replica);
+  return replica;
+}
+
 } // namespace fl
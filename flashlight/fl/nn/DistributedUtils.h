@@ -25,7 +25,7 @@ namespace fl {
  *
  * @param[in] module a module whose parameter gradients will be synchronized
  * @param[in] a ``Reducer`` instance to which gradients will be immediately
- * added when available
+ * added when available, unless it's deferred (see `Reducer::setDeferred`)
  */
 void distributeModuleGrads(
     std::shared_ptr<const Module> module,
@@ -50,6 +50,17 @@ void allReduceGradients(
     std::shared_ptr<const Module> module,
     double scale = 1.0);
 
+/**
+ * Copies a module, with copies of its parameters on the active device, e.g. to
+ * make a replica of a model loaded once per process on the driver thread of
+ * each device of `runOnDevices`. The module is copied through its
+ * serialization, so its type must be serializable.
+ *
+ * @param module a module to replicate
+ * @return the replica
+ */
+std::shared_ptr<Module> replicateModule(std::shared_ptr<Module> module);
+
 /** @} */
 
 } // namespace fl
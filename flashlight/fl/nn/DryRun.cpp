@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/nn/DryRun.h"
+
+#include <algorithm>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+
+#include "flashlight/fl/common/Utils.h"
+#include "flashlight/fl/optim/Optimizers.h"
+#include "flashlight/fl/tensor/TensorAdapter.h"
+
+#if FL_USE_TENSOR_STUB
+  #include "flashlight/fl/tensor/backend/stub/StubBackend.h"
+  #include "flashlight/fl/tensor/backend/stub/StubTensor.h"
+#endif // FL_USE_TENSOR_STUB
+
+namespace fl {
+
+namespace {
+
+struct ModuleFrame {
+  // the path of the module, with its parents
+  std::string name;
+  // the FLOPs when the module started
+  uint64_t startFlops;
+  // the FLOPs of the modules it ran
+  uint64_t childFlops{0};
+};
+
+// the modules running on this thread
+thread_local std::vector<ModuleFrame> moduleStack;
+
+#if FL_USE_TENSOR_STUB
+uint64_t getFlops() {
+  return StubBackend::getInstance().flops();
+}
+
+size_t getLiveBytes() {
+  return StubBackend::getInstance().liveBytes();
+}
+
+size_t getPeakBytes() {
+  return StubBackend::getInstance().getMemMgrPeakBytes(0);
+}
+
+void resetPeakBytes() {
+  StubBackend::getInstance().resetMemMgrPeakBytes(0);
+}
+
+// the difference of a count which should grow, clamped at 0
+size_t getGrowth(const size_t before, const size_t after) {
+  return after > before ? after - before : 0;
+}
+#else
+uint64_t getFlops() {
+  return 0;
+}
+#endif // FL_USE_TENSOR_STUB
+
+} // namespace
+
+std::string DryRunReport::prettyString() const {
+  std::ostringstream ss;
+  ss << "Parameters: " << prettyStringMemorySize(parameterBytes) << " B\n"
+     << "Gradients: " << prettyStringMemorySize(gradientBytes) << " B\n"
+     << "Optimizer state: " << prettyStringMemorySize(optimizerStateBytes)
+     << " B\n"
+     << "Activations (peak): " << prettyStringMemorySize(activationBytes)
+     << " B\n"
+     << "Peak: " << prettyStringMemorySize(peakBytes) << " B\n"
+     << "Forward: " << prettyStringCount(forwardFlops) << " FLOPs\n"
+     << "Backward: " << prettyStringCount(backwardFlops) << " FLOPs\n"
+     << "Optimizer step: " << prettyStringCount(stepFlops) << " FLOPs\n";
+  if (!moduleFlops.empty()) {
+    ss << "Forward FLOPs per module:\n";
+    for (const auto& [module, flops] : moduleFlops) {
+      ss << "\t" << module << ": " << prettyStringCount(flops) << "\n";
+    }
+  }
+  if (savedMemory) {
+    ss << savedMemory->prettyString();
+  }
+  return ss.str();
+}
+
+DryRunReport dryRun(
+    const std::function<std::shared_ptr<Module>()>& createModel,
+    const std::function<Variable(Module&)>& computeLoss,
+    const std::function<std::shared_ptr<FirstOrderOptimizer>(
+        const std::vector<Variable>&)>& createOptimizer /* = nullptr */) {
+#if FL_USE_TENSOR_STUB
+  if (!createModel || !computeLoss) {
+    throw std::invalid_argument(
+        "dryRun - a model and a loss function are required");
+  }
+  auto& profiler = detail::DryRunProfiler::getInstance();
+  if (profiler.isEnabled()) {
+    throw std::logic_error("dryRun - dry runs can't be nested");
+  }
+
+  DryRunReport report;
+  report.savedMemory = std::make_shared<SavedMemoryProfile>();
+  std::exception_ptr error;
+  withTensorType<StubTensor>([&]() {
+    try {
+      const auto liveAtStart = getLiveBytes();
+      resetPeakBytes();
+      auto model = createModel();
+      const auto params = model->params();
+      report.parameterBytes = getGrowth(liveAtStart, getLiveBytes());
+
+      std::shared_ptr<FirstOrderOptimizer> optimizer;
+      const auto liveBeforeOptimizer = getLiveBytes();
+      if (createOptimizer) {
+        optimizer = createOptimizer(params);
+      }
+      report.optimizerStateBytes =
+          getGrowth(liveBeforeOptimizer, getLiveBytes());
+
+      // forward and backward
+      const auto liveBeforeForward = getLiveBytes();
+      auto flops = getFlops();
+      profiler.start();
+      Variable loss;
+      try {
+        SavedMemoryProfileScope savedMemoryScope(*report.savedMemory);
+        loss = computeLoss(*model);
+      } catch (...) {
+        profiler.stop();
+        throw;
+      }
+      report.moduleFlops = profiler.stop();
+      report.forwardFlops = getFlops() - flops;
+
+      flops = getFlops();
+      loss.backward();
+      report.backwardFlops = getFlops() - flops;
+      for (const auto& param : params) {
+        if (param.isGradAvailable()) {
+          report.gradientBytes += param.grad().bytes();
+        }
+      }
+      // the gradients of the parameters outlive the passes
+      report.activationBytes = getGrowth(
+          liveBeforeForward + report.gradientBytes, getPeakBytes());
+      loss = Variable();
+
+      // the state lazily created by the first step, e.g. of sparse gradients
+      if (optimizer) {
+        const auto liveBeforeStep = getLiveBytes();
+        flops = getFlops();
+        optimizer->step();
+        report.stepFlops = getFlops() - flops;
+        report.optimizerStateBytes +=
+            getGrowth(liveBeforeStep, getLiveBytes());
+      }
+      report.peakBytes = getGrowth(liveAtStart, getPeakBytes());
+    } catch (...) {
+      error = std::current_exception();
+    }
+  });
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return report;
+#else
+  throw std::runtime_error(
+      "dryRun - Flashlight was built without the stub tensor backend");
+#endif // FL_USE_TENSOR_STUB
+}
+
+namespace detail {
+
+DryRunProfiler& DryRunProfiler::getInstance() {
+  static DryRunProfiler instance;
+  return instance;
+}
+
+bool DryRunProfiler::isEnabled() const {
+  return enabled_.load();
+}
+
+void DryRunProfiler::start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  moduleFlops_.clear();
+  enabled_.store(true);
+}
+
+std::vector<std::pair<std::string, uint64_t>> DryRunProfiler::stop() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  enabled_.store(false);
+  std::vector<std::pair<std::string, uint64_t>> moduleFlops(
+      moduleFlops_.begin(), moduleFlops_.end());
+  std::stable_sort(
+      moduleFlops.begin(), moduleFlops.end(), [](const auto& a, const auto& b) {
+        return a.second > b.second;
+      });
+  moduleFlops_.clear();
+  return moduleFlops;
+}
+
+void DryRunProfiler::pushModule(const std::string& name) {
+  moduleStack.push_back(
+      {moduleStack.empty() ? name : moduleStack.back().name + " / " + name,
+       getFlops()});
+}
+
+void DryRunProfiler::popModule() {
+  if (moduleStack.empty()) {
+    return;
+  }
+  const auto frame = std::move(moduleStack.back());
+  moduleStack.pop_back();
+  const auto flops = getFlops() - frame.startFlops;
+  if (!moduleStack.empty()) {
+    moduleStack.back().childFlops += flops;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (enabled_.load()) {
+    moduleFlops_[frame.name] += flops - frame.childFlops;
+  }
+}
+
+} // namespace detail
+
+} // namespace fl
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/autograd/SavedMemoryProfile.h"
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/nn/modules/Module.h"
+
+namespace fl {
+
+class FirstOrderOptimizer;
+
+/**
+ * The memory and compute of a training step, as estimated by `dryRun`.
+ */
+struct DryRunReport {
+  /// The bytes of the parameters of the model
+  size_t parameterBytes{0};
+  /// The bytes of the gradients of the parameters after the backward pass
+  size_t gradientBytes{0};
+  /// The bytes of the state of the optimizer, e.g. the moments of Adam,
+  /// including the state created by its first step
+  size_t optimizerStateBytes{0};
+  /// The peak bytes of the tensors created by the forward and backward
+  /// passes, i.e. the activations, their gradients and the temporaries,
+  /// besides the gradients of the parameters
+  size_t activationBytes{0};
+  /// The peak bytes of all tensors during the step
+  size_t peakBytes{0};
+  /// The floating point operations of each pass and of the optimizer step
+  uint64_t forwardFlops{0};
+  uint64_t backwardFlops{0};
+  uint64_t stepFlops{0};
+  /// The forward FLOPs of each module, excluding those of the modules it
+  /// runs, as nested module names (see `SavedMemoryProfile::Entry::module`),
+  /// sorted by decreasing FLOPs
+  std::vector<std::pair<std::string, uint64_t>> moduleFlops;
+  /// The activations saved by the forward pass for the backward pass
+  std::shared_ptr<SavedMemoryProfile> savedMemory;
+
+  /**
+   * @return a summary of the report, then its module FLOPs and saved memory
+   */
+  std::string prettyString() const;
+};
+
+/**
+ * Runs a training step without data or compute, on `StubTensor`s which only
+ * have shapes and types, to estimate its memory and FLOPs before running it,
+ * e.g. to choose a batch size, where to apply `Checkpoint`, or how to shard a
+ * model. The memory estimates count the bytes of live tensors, without the
+ * overhead or fragmentation of memory managers or the workspaces of kernels.
+ *
+ * The model, its input and its optimizer are created on stub tensors by the
+ * given functions:
+  \code{.cpp}
+  auto report = fl::dryRun(
+      []() {
+        auto model = std::make_shared<fl::Sequential>();
+        model->add(fl::Linear(1024, 4096));
+        // ...
+        return model;
+      },
+      [](fl::Module& model) {
+        auto input = fl::Variable(fl::rand({1024, 64}), false);
+        return fl::mean(model.forward({input}).front(), {0, 1});
+      },
+      [](const std::vector<fl::Variable>& params) {
+        return std::make_shared<fl::AdamOptimizer>(params, 1e-3);
+      });
+  std::cout << report.prettyString();
+  \endcode
+ *
+ * Ops whose output shapes depend on data, e.g. masking, give upper bounds.
+ *
+ * @param[in] createModel creates the model
+ * @param[in] computeLoss runs the forward pass of the model on an input it
+ * creates, and returns the loss to run the backward pass from
+ * @param[in] createOptimizer [optional] creates the optimizer of the
+ * parameters of the model, whose step then ends the dry run
+ */
+DryRunReport dryRun(
+    const std::function<std::shared_ptr<Module>()>& createModel,
+    const std::function<Variable(Module&)>& computeLoss,
+    const std::function<std::shared_ptr<FirstOrderOptimizer>(
+        const std::vector<Variable>&)>& createOptimizer = nullptr);
+
+namespace detail {
+
+/**
+ * Attributes the FLOPs of the stub backend to the modules running during a
+ * dry run, see `ModuleProfileScope`.
+ */
+class DryRunProfiler {
+ public:
+  static DryRunProfiler& getInstance();
+
+  /**
+   * @return whether module FLOPs are currently recorded.
+   */
+  bool isEnabled() const;
+
+  /**
+   * Starts recording module FLOPs, from none.
+   */
+  void start();
+
+  /**
+   * Stops recording module FLOPs.
+   * @return the FLOPs of each module, sorted by decreasing FLOPs
+   */
+  std::vector<std::pair<std::string, uint64_t>> stop();
+
+  /**
+   * Attribute the FLOPs of the calling thread to the given module, nested in
+   * the current one, until `popModule`.
+   */
+  void pushModule(const std::string& name);
+  void popModule();
+
+ private:
+  DryRunProfiler() = default;
+
+  std::atomic<bool> enabled_{false};
+  std::map<std::string, uint64_t> moduleFlops_;
+  std::mutex mutex_;
+};
+
+} // namespace detail
+
+} // namespace fl
@@ -0,0 +1,393 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/nn/FrozenModel.h"
+
+#include <stdexcept>
+#include <typeinfo>
+
+#include "flashlight/fl/autograd/tensor/AutogradOps.h"
+#include "flashlight/fl/nn/Utils.h"
+#include "flashlight/fl/nn/modules/Activations.h"
+#include "flashlight/fl/nn/modules/BatchNorm.h"
+#include "flashlight/fl/nn/modules/Container.h"
+#include "flashlight/fl/nn/modules/Conv2D.h"
+#include "flashlight/fl/nn/modules/Embedding.h"
+#include "flashlight/fl/nn/modules/LayerNorm.h"
+#include "flashlight/fl/nn/modules/Linear.h"
+#include "flashlight/fl/nn/modules/Pool2D.h"
+#include "flashlight/fl/nn/modules/View.h"
+#include "flashlight/fl/tensor/Index.h"
+
+namespace fl {
+
+namespace {
+
+// The indices of the attributes of convolutions and pools, which start alike
+constexpr int kXFilter = 0;
+constexpr int kYFilter = 1;
+constexpr int kXStride = 2;
+constexpr int kYStride = 3;
+constexpr int kXPad = 4;
+constexpr int kYPad = 5;
+constexpr int kConvXDilation = 6;
+constexpr int kConvYDilation = 7;
+constexpr int kConvGroups = 8;
+constexpr int kConvFormat = 9;
+constexpr int kPoolMode = 6;
+constexpr int kPoolFormat = 7;
+
+bool isFloatingType(fl::dtype type) {
+  return type == fl::dtype::f16 || type == fl::dtype::bf16 ||
+      type == fl::dtype::f32 || type == fl::dtype::f64;
+}
+
+// Resolves the 0 and -1 axes of a `View`, as `moddims` does
+Shape viewShape(const Shape& input, const std::vector<int>& dims) {
+  Shape shape(std::vector<Dim>(dims.begin(), dims.end()));
+  int inferAxis = -1;
+  for (int i = 0; i < shape.ndim(); ++i) {
+    if (shape[i] == 0) {
+      if (i >= input.ndim()) {
+        throw std::invalid_argument(
+            "FrozenModel::forward - tried to infer dimension " +
+            std::to_string(i) + " of a view beyond the input's dimensions");
+      }
+      shape[i] = input[i];
+    } else if (shape[i] == -1) {
+      if (inferAxis >= 0) {
+        throw std::invalid_argument(
+            "FrozenModel::forward - too many dimensions to infer in a view");
+      }
+      inferAxis = i;
+    }
+  }
+  if (inferAxis >= 0) {
+    shape[inferAxis] = 1;
+    shape[inferAxis] = input.elements() / shape.elements();
+  }
+  if (shape.elements() != input.elements()) {
+    throw std::invalid_argument(
+        "FrozenModel::forward - mismatched number of elements in a view");
+  }
+  return shape;
+}
+
+// Broadcasts a tensor of one value per feature along `axis` of `input`
+Tensor tileFeatures(const Tensor& features, const Tensor& input, int axis) {
+  auto tileDims = input.shape();
+  tileDims[axis] = 1;
+  return fl::tile(features, tileDims);
+}
+
+Tensor runLinear(const FrozenModel::Op& op, const Tensor& input) {
+  const auto& weight = op.tensors[0];
+  auto outShape = input.shape();
+  outShape[0] = weight.dim(0);
+  auto output = fl::reshape(
+      fl::matmul(
+          weight,
+          fl::reshape(input, {input.dim(0), input.elements() / input.dim(0)})),
+      outShape);
+  if (op.tensors.size() > 1) {
+    auto tileDims = output.shape();
+    tileDims[0] = 1;
+    output = output + fl::tile(op.tensors[1], tileDims);
+  }
+  return output;
+}
+
+Tensor runConv2D(const FrozenModel::Op& op, const Tensor& input) {
+  const auto& a = op.attributes;
+  const auto format = static_cast<MemoryFormat>(a[kConvFormat]);
+  const int xAxis = format == MemoryFormat::CWHN ? 1 : 0;
+  const int px = derivePadding(
+      input.dim(xAxis), a[kXFilter], a[kXStride], a[kXPad], a[kConvXDilation]);
+  const int py = derivePadding(
+      input.dim(xAxis + 1),
+      a[kYFilter],
+      a[kYStride],
+      a[kYPad],
+      a[kConvYDilation]);
+  if (!(px >= 0 && py >= 0)) {
+    throw std::invalid_argument("FrozenModel::forward - invalid conv padding");
+  }
+  const auto bias =
+      op.tensors.size() > 1 ? op.tensors[1] : Tensor(input.type());
+  return fl::conv2d(
+      input,
+      op.tensors[0],
+      bias,
+      a[kXStride],
+      a[kYStride],
+      px,
+      py,
+      a[kConvXDilation],
+      a[kConvYDilation],
+      a[kConvGroups],
+      format);
+}
+
+Tensor runPool2D(const FrozenModel::Op& op, const Tensor& input) {
+  const auto& a = op.attributes;
+  const auto format = static_cast<MemoryFormat>(a[kPoolFormat]);
+  const int xAxis = format == MemoryFormat::CWHN ? 1 : 0;
+  const int px = derivePadding(
+      input.dim(xAxis), a[kXFilter], a[kXStride], a[kXPad], /* dilation= */ 1);
+  const int py = derivePadding(
+      input.dim(xAxis + 1),
+      a[kYFilter],
+      a[kYStride],
+      a[kYPad],
+      /* dilation= */ 1);
+  if (!(px >= 0 && py >= 0)) {
+    throw std::invalid_argument("FrozenModel::forward - invalid pool padding");
+  }
+  return fl::pool2d(
+      input,
+      a[kXFilter],
+      a[kYFilter],
+      a[kXStride],
+      a[kYStride],
+      px,
+      py,
+      static_cast<PoolingMode>(a[kPoolMode]),
+      format);
+}
+
+Tensor runLayerNorm(const FrozenModel::Op& op, const Tensor& input) {
+  if (input.ndim() > kLnExpectedNumDims) {
+    throw std::invalid_argument(
+        "FrozenModel::forward - layer norm input must have " +
+        std::to_string(kLnExpectedNumDims) + " or fewer dimensions");
+  }
+  std::vector<Dim> dims = input.shape().get();
+  dims.resize(kLnExpectedNumDims, 1);
+  const Shape shape(dims);
+  const int numAxes = op.attributes[0];
+  const int axisSize = op.attributes[1];
+  Tensor weight, bias;
+  if (!op.tensors.empty()) {
+    Dim sliceSize = 1;
+    for (int d = 0; d < numAxes; ++d) {
+      sliceSize *= shape[d];
+    }
+    if (axisSize == kLnVariableAxisSize) {
+      weight = fl::tile(op.tensors[0], {sliceSize});
+      bias = fl::tile(op.tensors[1], {sliceSize});
+    } else if (sliceSize != axisSize) {
+      throw std::invalid_argument(
+          "FrozenModel::forward - input size along the layer norm axes "
+          "doesn't match its axis size");
+    } else {
+      weight = op.tensors[0];
+      bias = op.tensors[1];
+    }
+  }
+  return fl::reshape(
+      fl::layerNorm(
+          fl::reshape(input, shape), weight, bias, numAxes, op.value),
+      input.shape());
+}
+
+Tensor runEmbedding(const FrozenModel::Op& op, const Tensor& input) {
+  if (input.ndim() >= 4) {
+    throw std::invalid_argument(
+        "FrozenModel::forward - embedding input must have 3 or fewer dims");
+  }
+  const auto& embeddings = op.tensors[0];
+  std::vector<Dim> dims{embeddings.dim(0)};
+  for (int i = 0; i < input.ndim(); ++i) {
+    dims.push_back(input.dim(i));
+  }
+  return fl::reshape(embeddings(fl::span, input.flatten()), Shape(dims));
+}
+
+Tensor run(const FrozenModel::Op& op, const Tensor& input) {
+  using Type = FrozenModel::OpType;
+  switch (op.type) {
+    case Type::Linear:
+      return runLinear(op, input);
+    case Type::Conv2D:
+      return runConv2D(op, input);
+    case Type::Pool2D:
+      return runPool2D(op, input);
+    case Type::Affine: {
+      const int axis = op.attributes[0];
+      return input * tileFeatures(op.tensors[0], input, axis) +
+          tileFeatures(op.tensors[1], input, axis);
+    }
+    case Type::LayerNorm:
+      return runLayerNorm(op, input);
+    case Type::View:
+      return fl::reshape(input, viewShape(input.shape(), op.attributes));
+    case Type::Embedding:
+      return runEmbedding(op, input);
+    case Type::LogSoftmax:
+      return fl::logSoftmax(input, op.attributes[0]);
+    case Type::ReLU:
+      return fl::maximum(input, 0.0).astype(input.type());
+    case Type::ReLU6:
+      return fl::clip(input, 0.0, 6.0);
+    case Type::LeakyReLU:
+      return fl::maximum(input, input * op.value);
+    case Type::HardTanh:
+      return fl::clip(input, -1.0, 1.0);
+    case Type::Sigmoid:
+      return fl::sigmoid(input);
+    case Type::Tanh:
+      return fl::tanh(input);
+  }
+  throw std::invalid_argument("FrozenModel::forward - unknown op type");
+}
+
+} // namespace
+
+FrozenModel::FrozenModel(Module& module, fl::dtype type /* = f32 */)
+    : type_(type) {
+  if (!isFloatingType(type)) {
+    throw std::invalid_argument(
+        "FrozenModel::FrozenModel - the run type must be a floating point "
+        "type");
+  }
+  optimizeForInference(module);
+  lower(module);
+}
+
+void FrozenModel::lower(Module& module) {
+  auto weight = [&module, this](int i) {
+    return module.param(i).tensor().astype(type_);
+  };
+  // the exact type: derived modules, e.g. quantized ones, compute differently
+  const auto& id = typeid(module);
+  Op op;
+  if (id == typeid(Sequential)) {
+    for (const auto& child : static_cast<Sequential&>(module).modules()) {
+      lower(*child);
+    }
+    return;
+  } else if (id == typeid(Linear)) {
+    op.type = OpType::Linear;
+    for (int i = 0; i < static_cast<int>(module.params().size()); ++i) {
+      op.tensors.push_back(weight(i));
+    }
+  } else if (id == typeid(Conv2D)) {
+    const auto& conv = static_cast<const Conv2D&>(module);
+    op.type = OpType::Conv2D;
+    for (int i = 0; i < static_cast<int>(module.params().size()); ++i) {
+      op.tensors.push_back(weight(i));
+    }
+    op.attributes = {
+        conv.xFilter_,
+        conv.yFilter_,
+        conv.xStride_,
+        conv.yStride_,
+        conv.xPad_,
+        conv.yPad_,
+        conv.xDilation_,
+        conv.yDilation_,
+        conv.groups_,
+        static_cast<int>(conv.format_)};
+  } else if (id == typeid(Pool2D)) {
+    const auto& pool = static_cast<const Pool2D&>(module);
+    op.type = OpType::Pool2D;
+    op.attributes = {
+        pool.xFilter_,
+        pool.yFilter_,
+        pool.xStride_,
+        pool.yStride_,
+        pool.xPad_,
+        pool.yPad_,
+        static_cast<int>(pool.mode_),
+        static_cast<int>(pool.format_)};
+  } else if (id == typeid(BatchNorm)) {
+    const auto& batchNorm = static_cast<const BatchNorm&>(module);
+    const auto featAxis = batchNorm.getFeatAxis();
+    if (featAxis.size() != 1) {
+      throw std::invalid_argument(
+          "FrozenModel::FrozenModel - only batch norms over one axis can be "
+          "frozen");
+    }
+    Tensor scale, shift;
+    // throws if the module uses batch statistics
+    batchNorm.getInferenceAffine(scale, shift);
+    // shaped to be broadcast along the feature axis
+    std::vector<Dim> dims(featAxis[0] + 1, 1);
+    dims.back() = scale.elements();
+    op.type = OpType::Affine;
+    op.tensors = {
+        fl::reshape(scale, Shape(dims)).astype(type_),
+        fl::reshape(shift, Shape(dims)).astype(type_)};
+    op.attributes = {featAxis[0]};
+  } else if (id == typeid(LayerNorm)) {
+    const auto& layerNorm = static_cast<const LayerNorm&>(module);
+    const auto& complement = layerNorm.axisComplement_;
+    const int numAxes = kLnExpectedNumDims - complement.size();
+    if (numAxes <= 0 ||
+        (!complement.empty() && complement.front() != numAxes)) {
+      throw std::invalid_argument(
+          "FrozenModel::FrozenModel - only layer norms over leading axes can "
+          "be frozen");
+    }
+    op.type = OpType::LayerNorm;
+    if (layerNorm.affine_) {
+      op.tensors = {weight(0), weight(1)};
+    }
+    op.attributes = {numAxes, layerNorm.axisSize_};
+    op.value = layerNorm.epsilon_;
+  } else if (id == typeid(View)) {
+    const auto& dims = static_cast<const View&>(module).dims_.get();
+    op.type = OpType::View;
+    op.attributes.assign(dims.begin(), dims.end());
+  } else if (id == typeid(Embedding)) {
+    op.type = OpType::Embedding;
+    op.tensors = {weight(0)};
+  } else if (id == typeid(LogSoftmax)) {
+    op.type = OpType::LogSoftmax;
+    op.attributes = {static_cast<const LogSoftmax&>(module).dim_};
+  } else if (id == typeid(LeakyReLU)) {
+    op.type = OpType::LeakyReLU;
+    op.value = static_cast<const LeakyReLU&>(module).mSlope_;
+  } else if (id == typeid(ReLU)) {
+    op.type = OpType::ReLU;
+  } else if (id == typeid(ReLU6)) {
+    op.type = OpType::ReLU6;
+  } else if (id == typeid(HardTanh)) {
+    op.type = OpType::HardTanh;
+  } else if (id == typeid(Sigmoid)) {
+    op.type = OpType::Sigmoid;
+  } else if (id == typeid(Tanh)) {
+    op.type = OpType::Tanh;
+  } else {
+    throw std::invalid_argument(
+        "FrozenModel::FrozenModel - unsupported module: " +
+        module.prettyString());
+  }
+  ops_.push_back(std::move(op));
+}
+
+Tensor FrozenModel::forward(const Tensor& input) const {
+  auto output = isFloatingType(input.type()) ? input.astype(type_) : input;
+  for (const auto& op : ops_) {
+    output = run(op, output);
+  }
+  return output;
+}
+
+Tensor FrozenModel::operator()(const Tensor& input) const {
+  return forward(input);
+}
+
+const std::vector<FrozenModel::Op>& FrozenModel::ops() const {
+  return ops_;
+}
+
+fl::dtype FrozenModel::type() const {
+  return type_;
+}
+
+} // namespace fl
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "flashlight/fl/common/Serialization.h"
+#include "flashlight/fl/nn/modules/Module.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+/**
+ * An inference-only export of a model: a flat list of ops on plain tensors,
+ * run directly on the tensor backend, without the `Variable`s, gradient state
+ * and training-only modules of the model.
+ *
+ * Freezing a model simplifies it with `optimizeForInference`, which folds
+ * batch norms into the preceding layers and removes dropouts, then lowers the
+ * modules of (possibly nested) `Sequential`s to ops, whose weights are
+ * converted once to the run type and to the shapes their ops consume, e.g.
+ * the affine transform of a batch norm which couldn't be folded. The memory
+ * format of the convolutions and pools is kept, so models converted with
+ * `setMemoryFormat` beforehand run channels-last.
+ *
+ * Supported modules are `Linear`, `Conv2D`, `Pool2D`, `BatchNorm` with running
+ * statistics over one axis, `LayerNorm` over leading axes, `View`,
+ * `Embedding`, `LogSoftmax` and the `ReLU`, `ReLU6`, `LeakyReLU`, `HardTanh`,
+ * `Sigmoid` and `Tanh` activations. Other modules, e.g. recurrent or quantized
+ * ones, throw when freezing.
+ *
+ * A frozen model is serializable with `fl::save`, or `MappedCheckpoint`, and
+ * doesn't need the model to be loaded. Example:
+ * \code
+   fl::FrozenModel frozen(model);
+   fl::save("model.frozen", frozen);
+
+   fl::FrozenModel loaded;
+   fl::load("model.frozen", loaded);
+   auto output = loaded(input); // a Tensor
+ * \endcode
+ */
+class FrozenModel {
+ public:
+  /** The kinds of ops of a frozen model. */
+  enum class OpType {
+    Linear,
+    Conv2D,
+    Pool2D,
+    Affine, // a per-feature scale and shift, i.e. a batch norm
+    LayerNorm,
+    View,
+    Embedding,
+    LogSoftmax,
+    ReLU,
+    ReLU6,
+    LeakyReLU,
+    HardTanh,
+    Sigmoid,
+    Tanh
+  };
+
+  /**
+   * An op of a frozen model, with its prepacked tensors, integer attributes,
+   * e.g. strides and padding, and a scalar attribute, e.g. a slope.
+   */
+  struct Op {
+    OpType type;
+    std::vector<Tensor> tensors;
+    std::vector<int> attributes;
+    double value{0};
+
+    template <class Archive>
+    void serialize(Archive& ar) {
+      ar(type, tensors, attributes, value);
+    }
+  };
+
+  /** Constructs an empty frozen model, e.g. to be loaded into. */
+  FrozenModel() = default;
+
+  /**
+   * Freezes a model. The model is simplified in place with
+   * `optimizeForInference`, and the frozen model shares its weights if they
+   * already are of the run type, but is independent from it otherwise.
+   *
+   * @param module the model to freeze, a supported module or a `Sequential`
+   * of them
+   * @param type the type to run in: floating point inputs and weights are
+   * converted to it
+   */
+  explicit FrozenModel(Module& module, fl::dtype type = fl::dtype::f32);
+
+  /** Runs the model on a batch of inputs. */
+  Tensor forward(const Tensor& input) const;
+
+  Tensor operator()(const Tensor& input) const;
+
+  const std::vector<Op>& ops() const;
+
+  fl::dtype type() const;
+
+ private:
+  std::vector<Op> ops_;
+  fl::dtype type_{fl::dtype::f32};
+
+  FL_SAVE_LOAD(ops_, type_)
+
+  void lower(Module& module);
+};
+
+} // namespace fl
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/nn/PipelineParallel.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "flashlight/fl/autograd/Functions.h"
+#include "flashlight/fl/distributed/DistributedApi.h"
+#include "flashlight/fl/tensor/Index.h"
+
+namespace fl {
+
+namespace {
+
+// The header of the activations of the first micro-batch of a step, sent
+// ahead of them: their type, number of dimensions and dimensions
+constexpr int kMaxActivationDims = 8;
+constexpr int kHeaderSize = kMaxActivationDims + 2;
+
+// The index-th of n equal parts of a tensor along its last dimension
+Tensor microBatch(const Tensor& tensor, int index, int n) {
+  if (tensor.ndim() == 0) {
+    throw std::invalid_argument(
+        "PipelineParallel - can't split a scalar into micro-batches");
+  }
+  const auto batchDim = tensor.ndim() - 1;
+  const auto batchSize = tensor.dim(batchDim);
+  if (batchSize % n != 0) {
+    throw std::invalid_argument(
+        "PipelineParallel - the batch size " + std::to_string(batchSize) +
+        " isn't a multiple of the number of micro-batches " +
+        std::to_string(n));
+  }
+  const auto size = batchSize / n;
+  std::vector<Index> indices(batchDim, fl::span);
+  indices.emplace_back(fl::range(index * size, (index + 1) * size));
+  return tensor(indices);
+}
+
+// Balances the parameters of consecutive stages, each of at least one module
+std::vector<int> balanceStages(const Sequential& model, int numStages) {
+  const auto modules = model.modules();
+  std::vector<Dim> cumulative;
+  Dim total = 0;
+  for (const auto& module : modules) {
+    for (const auto& param : module->params()) {
+      total += param.elements();
+    }
+    cumulative.push_back(total);
+  }
+  std::vector<int> starts = {0};
+  for (int stage = 1; stage < numStages; ++stage) {
+    const double target = static_cast<double>(total) * stage / numStages;
+    int start = starts.back() + 1;
+    while (start < static_cast<int>(modules.size()) - (numStages - stage) &&
+           cumulative[start - 1] < target) {
+      ++start;
+    }
+    starts.push_back(start);
+  }
+  return starts;
+}
+
+} // namespace
+
+PipelineParallel::PipelineParallel(
+    std::shared_ptr<Sequential> model,
+    int numMicroBatches,
+    std::vector<int> stageStarts /* = {} */)
+    : numMicroBatches_(numMicroBatches),
+      stageIndex_(getWorldRank()),
+      numStages_(getWorldSize()) {
+  if (!model) {
+    throw std::invalid_argument(
+        "PipelineParallel::PipelineParallel - null model");
+  }
+  if (numMicroBatches_ < 1) {
+    throw std::invalid_argument(
+        "PipelineParallel::PipelineParallel - there must be at least one "
+        "micro-batch");
+  }
+  const auto modules = model->modules();
+  const int numModules = modules.size();
+  if (numModules < numStages_) {
+    throw std::invalid_argument(
+        "PipelineParallel::PipelineParallel - the model has fewer modules "
+        "than there are stages");
+  }
+  if (stageStarts.empty()) {
+    stageStarts = balanceStages(*model, numStages_);
+  }
+  if (stageStarts.size() != static_cast<size_t>(numStages_) ||
+      stageStarts.front() != 0) {
+    throw std::invalid_argument(
+        "PipelineParallel::PipelineParallel - there must be a stage per "
+        "process, starting with module 0");
+  }
+  for (int i = 1; i < numStages_; ++i) {
+    if (stageStarts[i] <= stageStarts[i - 1] ||
+        stageStarts[i] >= numModules) {
+      throw std::invalid_argument(
+          "PipelineParallel::PipelineParallel - stages must be non-empty and "
+          "in order");
+    }
+  }
+  stageStarts_ = std::move(stageStarts);
+
+  const int end = stageIndex_ + 1 < numStages_ ? stageStarts_[stageIndex_ + 1]
+                                               : numModules;
+  stage_ = std::make_shared<Sequential>();
+  for (int i = stageStarts_[stageIndex_]; i < end; ++i) {
+    stage_->add(modules[i]);
+  }
+}
+
+Tensor PipelineParallel::trainStep(
+    const Tensor& input,
+    const Tensor& target,
+    const LossFunction& loss) {
+  if (!loss) {
+    throw std::invalid_argument(
+        "PipelineParallel::trainStep - null loss function");
+  }
+  inFlight_.clear();
+  lossSum_ = Tensor();
+
+  // the forward passes of the micro-batches still in flight in the following
+  // stages when the first one returns to this stage
+  const int warmup =
+      std::min(numStages_ - stageIndex_ - 1, numMicroBatches_);
+  for (int i = 0; i < warmup; ++i) {
+    forwardMicroBatch(i, input, target, loss, /* exchange = */ false);
+  }
+  // in the steady state, a stage sends the activations of a micro-batch while
+  // receiving the gradients of the oldest one, which the next stage sends
+  // before receiving the activations
+  for (int i = warmup; i < numMicroBatches_; ++i) {
+    forwardMicroBatch(i, input, target, loss, /* exchange = */ true);
+    backwardMicroBatch(/* received = */ stageIndex_ + 1 < numStages_);
+  }
+  for (int i = 0; i < warmup; ++i) {
+    backwardMicroBatch(/* received = */ false);
+  }
+
+  if (stageIndex_ + 1 < numStages_) {
+    return Tensor();
+  }
+  return lossSum_ / numMicroBatches_;
+}
+
+Tensor PipelineParallel::forward(const Tensor& input) {
+  std::vector<Tensor> outputs;
+  for (int i = 0; i < numMicroBatches_; ++i) {
+    auto x = stageIndex_ == 0
+        ? Variable(microBatch(input, i, numMicroBatches_), false)
+        : receiveActivation(i, /* calcGrad = */ false);
+    auto y = stage_->forward(x);
+    if (stageIndex_ + 1 < numStages_) {
+      sendActivation(y.tensor(), i);
+    } else {
+      outputs.push_back(y.tensor());
+    }
+  }
+  if (outputs.empty()) {
+    return Tensor();
+  }
+  return fl::concatenate(outputs, outputs.front().ndim() - 1);
+}
+
+void PipelineParallel::sendActivation(const Tensor& activation, int index) {
+  if (index == 0) {
+    if (activation.ndim() > kMaxActivationDims) {
+      throw std::invalid_argument(
+          "PipelineParallel - activations can have at most " +
+          std::to_string(kMaxActivationDims) + " dimensions");
+    }
+    std::vector<long long> header(kHeaderSize, 0);
+    header[0] = static_cast<long long>(activation.type());
+    header[1] = activation.ndim();
+    for (int i = 0; i < activation.ndim(); ++i) {
+      header[i + 2] = activation.dim(i);
+    }
+    send(Tensor::fromVector(header), stageIndex_ + 1);
+  }
+  send(activation, stageIndex_ + 1);
+}
+
+Variable PipelineParallel::receiveActivation(int index, bool calcGrad) {
+  if (index == 0) {
+    auto header = Tensor({kHeaderSize}, fl::dtype::s64);
+    recv(header, stageIndex_ - 1);
+    const auto values = header.toHostVector<long long>();
+    activationType_ = static_cast<dtype>(values[0]);
+    activationShape_ = Shape(
+        std::vector<Dim>(values.begin() + 2, values.begin() + 2 + values[1]));
+  }
+  auto activation = Tensor(activationShape_, activationType_);
+  recv(activation, stageIndex_ - 1);
+  return Variable(activation, calcGrad);
+}
+
+void PipelineParallel::forwardMicroBatch(
+    int index,
+    const Tensor& input,
+    const Tensor& target,
+    const LossFunction& loss,
+    bool exchange) {
+  MicroBatch state;
+  state.input = stageIndex_ == 0
+      ? Variable(microBatch(input, index, numMicroBatches_), false)
+      : receiveActivation(index, /* calcGrad = */ true);
+  auto output = stage_->forward(state.input);
+
+  if (stageIndex_ + 1 == numStages_) {
+    auto microBatchLoss = loss(
+        output, Variable(microBatch(target, index, numMicroBatches_), false));
+    lossSum_ = lossSum_.isEmpty() ? microBatchLoss.tensor()
+                                  : lossSum_ + microBatchLoss.tensor();
+    // the gradients are those of the mean over the micro-batches
+    state.output =
+        microBatchLoss / static_cast<double>(numMicroBatches_);
+  } else if (exchange) {
+    // the first micro-batch is never exchanged, so its header precedes this
+    auto& oldest = inFlight_.front();
+    oldest.outputGrad =
+        Tensor(oldest.output.shape(), oldest.output.type());
+    sendRecv(
+        output.tensor(),
+        stageIndex_ + 1,
+        oldest.outputGrad,
+        stageIndex_ + 1);
+    state.output = output;
+  } else {
+    sendActivation(output.tensor(), index);
+    state.output = output;
+  }
+  inFlight_.push_back(std::move(state));
+}
+
+void PipelineParallel::backwardMicroBatch(bool received) {
+  auto state = std::move(inFlight_.front());
+  inFlight_.pop_front();
+
+  if (stageIndex_ + 1 == numStages_) {
+    state.output.backward();
+  } else {
+    if (!received) {
+      state.outputGrad = Tensor(state.output.shape(), state.output.type());
+      recv(state.outputGrad, stageIndex_ + 1);
+    }
+    state.output.backward(Variable(state.outputGrad, false));
+  }
+
+  if (stageIndex_ > 0) {
+    // the stage may not depend on its input, whose gradient is then zero
+    send(
+        state.input.isGradAvailable()
+            ? state.input.grad().tensor()
+            : fl::full(state.input.shape(), 0, state.input.type()),
+        stageIndex_ - 1);
+  }
+}
+
+std::shared_ptr<Sequential> PipelineParallel::stage() const {
+  return stage_;
+}
+
+const std::vector<int>& PipelineParallel::stageStarts() const {
+  return stageStarts_;
+}
+
+int PipelineParallel::stageIndex() const {
+  return stageIndex_;
+}
+
+int PipelineParallel::numStages() const {
+  return numStages_;
+}
+
+} // namespace fl
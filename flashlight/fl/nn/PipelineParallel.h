@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/nn/modules/Container.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+/**
+ * Pipeline-parallel execution of a `Sequential` model, e.g. one built by
+ * `fl::pkg::runtime::buildSequentialModule` from an arch file, which may not
+ * fit on a single device. The modules are partitioned into consecutive
+ * stages, one per process, and each process only runs the modules of its
+ * stage. Activations are sent to the process of the next stage and their
+ * gradients back with point-to-point operations.
+ *
+ * A training step splits the batch along its last dimension into equal
+ * micro-batches, and streams them through the stages with the one forward,
+ * one backward (1F1B) schedule of PipeDream-Flush
+ * (https://arxiv.org/abs/2006.09503): each stage runs the forward passes of
+ * as many micro-batches as there are following stages, then alternates the
+ * forward pass of a micro-batch with the backward pass of the oldest one, which
+ * bounds the activations a stage holds by the number of stages. The
+ * gradients of the parameters of the stage are those of the mean loss of the
+ * micro-batches, as if the batch ran at once, such that a step is followed by
+ * that of an optimizer of `stage()->params()`, on each process.
+ *
+ * The activations of all micro-batches of a step must have the same shapes
+ * and types. Each stage holds different parameters, so gradients aren't
+ * synchronized across processes, e.g. with a `Reducer`.
+ *
+ * Example:
+ * \code
+   auto model = fl::pkg::runtime::buildSequentialModule(archFile, 80, 10);
+   fl::PipelineParallel pipeline(model, 4);
+   model.reset(); // only the modules of this stage are kept
+   fl::SGDOptimizer optimizer(pipeline.stage()->params(), 0.1);
+   auto criterion = fl::CategoricalCrossEntropy();
+   auto loss = pipeline.trainStep(
+       input, target, [&](const fl::Variable& out, const fl::Variable& tgt) {
+         return criterion(fl::logSoftmax(out, 0), tgt);
+       });
+   optimizer.step();
+   optimizer.zeroGrad();
+ * \endcode
+ */
+class PipelineParallel {
+ public:
+  /**
+   * Computes the loss of a micro-batch from the output of the model and the
+   * corresponding target.
+   */
+  using LossFunction =
+      std::function<Variable(const Variable& output, const Variable& target)>;
+
+  /**
+   * @param[in] model the model to partition, the same on all processes
+   * @param[in] numMicroBatches the number of micro-batches of a batch
+   * @param[in] stageStarts the index of the first module of each stage, one
+   * per process and starting with 0. Defaults to stages of consecutive modules
+   * with about as many parameters each.
+   */
+  PipelineParallel(
+      std::shared_ptr<Sequential> model,
+      int numMicroBatches,
+      std::vector<int> stageStarts = {});
+
+  /**
+   * Runs the forward and backward passes of a batch, accumulating the
+   * gradients of the parameters of the stage of this process.
+   *
+   * @param[in] input the input of the model, only used by the first stage
+   * @param[in] target the target of the model, only used by the last stage
+   * @param[in] loss the loss of a micro-batch
+   * @return on the last stage, the mean loss of the micro-batches, and an
+   * empty tensor on other stages
+   */
+  Tensor trainStep(
+      const Tensor& input,
+      const Tensor& target,
+      const LossFunction& loss);
+
+  /**
+   * Runs the forward pass of a batch, without gradients, streaming its
+   * micro-batches through the stages.
+   *
+   * @param[in] input the input of the model, only used by the first stage
+   * @return on the last stage, the output of the model for the batch, and an
+   * empty tensor on other stages
+   */
+  Tensor forward(const Tensor& input);
+
+  /**
+   * @return the modules of the stage of this process
+   */
+  std::shared_ptr<Sequential> stage() const;
+
+  /**
+   * @return the index of the first module of each stage
+   */
+  const std::vector<int>& stageStarts() const;
+
+  /**
+   * @return the index of the stage of this process, i.e. its rank
+   */
+  int stageIndex() const;
+
+  /**
+   * @return the number of stages, i.e. the world size
+   */
+  int numStages() const;
+
+ private:
+  // the state of a micro-batch between its forward and backward passes
+  struct MicroBatch {
+    Variable input;
+    // the loss on the last stage
+    Variable output;
+    Tensor outputGrad;
+  };
+
+  void sendActivation(const Tensor& activation, int index);
+  Variable receiveActivation(int index, bool calcGrad);
+  void forwardMicroBatch(
+      int index,
+      const Tensor& input,
+      const Tensor& target,
+      const LossFunction& loss,
+      bool exchange);
+  void backwardMicroBatch(bool received);
+
+  std::shared_ptr<Sequential> stage_;
+  std::vector<int> stageStarts_;
+  int numMicroBatches_;
+  int stageIndex_;
+  int numStages_;
+
+  // the state of the micro-batches between their forward and backward passes,
+  // oldest first
+  std::deque<MicroBatch> inFlight_;
+  // the shape and type of the activations sent to this stage in a step
+  Shape activationShape_;
+  dtype activationType_{dtype::f32};
+  Tensor lossSum_;
+};
+
+} // namespace fl
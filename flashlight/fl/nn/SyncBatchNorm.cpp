@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/nn/SyncBatchNorm.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "flashlight/fl/distributed/DistributedApi.h"
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+namespace {
+
+// Splits a buffer of per-feature values into its parts of `numFeatures`
+// values, in the broadcastable shape of the features
+std::vector<Tensor> splitFeatures(
+    const Tensor& buffer,
+    const Dim numFeatures,
+    const Shape& featShape) {
+  std::vector<Tensor> parts;
+  for (Dim begin = 0; begin + numFeatures <= buffer.elements();
+       begin += numFeatures) {
+    parts.push_back(fl::reshape(
+        buffer(fl::range(begin, begin + numFeatures)), featShape));
+  }
+  return parts;
+}
+
+} // namespace
+
+Variable syncBatchnorm(
+    const Variable& input,
+    const Variable& weight,
+    const Variable& bias,
+    Variable& runningMean,
+    Variable& runningVar,
+    const std::vector<int>& featAxes,
+    double momentum,
+    double epsilon) {
+  std::vector<int> reduceAxes;
+  for (int axis = 0; axis < input.ndim(); ++axis) {
+    if (std::find(featAxes.begin(), featAxes.end(), axis) == featAxes.end()) {
+      reduceAxes.push_back(axis);
+    }
+  }
+  if (reduceAxes.size() + featAxes.size() != input.ndim()) {
+    throw std::invalid_argument(
+        "syncBatchnorm - invalid feature axes for an input of shape " +
+        input.shape().toString());
+  }
+
+  // statistics of half-precision inputs are computed in single precision
+  const auto statsType =
+      isHalfPrecisionType(input.type()) ? fl::dtype::f32 : input.type();
+  const auto x = input.tensor().astype(statsType);
+  const auto localSum = fl::sum(x, reduceAxes, /* keepDims = */ true);
+  const auto featShape = localSum.shape();
+  const Dim numFeatures = featShape.elements();
+  const Dim localCount = x.elements() / numFeatures;
+  if (!weight.isEmpty() && weight.elements() != numFeatures) {
+    throw std::invalid_argument(
+        "syncBatchnorm - expected " + std::to_string(numFeatures) +
+        " features, got a weight of " + std::to_string(weight.elements()));
+  }
+
+  // the sums and the number of samples of all processes, in one allreduce
+  auto stats = fl::concatenate(
+      {localSum.flatten(),
+       fl::sum(x * x, reduceAxes, /* keepDims = */ true).flatten(),
+       fl::full({1}, localCount, statsType)},
+      0);
+  allReduce(stats);
+  const auto count = fl::reshape(
+      stats(fl::range(2 * numFeatures, 2 * numFeatures + 1)),
+      Shape(std::vector<Dim>(featShape.ndim(), 1)));
+  const auto sums = splitFeatures(stats, numFeatures, featShape);
+  const auto mean = sums[0] / count;
+  // clamped, as rounding may make it negative for constant features
+  const auto var = fl::maximum(sums[1] / count - mean * mean, 0);
+  const auto invStd = 1 / fl::sqrt(var + epsilon);
+  const auto normalized = (x - mean) * invStd;
+
+  if (!runningMean.isEmpty() && !runningVar.isEmpty() && momentum > 0) {
+    // the running variance is unbiased, as in BatchNorm
+    const auto unbiasedVar = var * count / fl::maximum(count - 1, 1);
+    runningMean.tensor() = runningMean.tensor() * (1 - momentum) +
+        mean.flatten().astype(runningMean.type()) * momentum;
+    runningVar.tensor() = runningVar.tensor() * (1 - momentum) +
+        unbiasedVar.flatten().astype(runningVar.type()) * momentum;
+  }
+
+  const bool affine = !weight.isEmpty();
+  auto output = normalized;
+  if (affine) {
+    output = normalized *
+            fl::reshape(weight.tensor().astype(statsType), featShape) +
+        fl::reshape(bias.tensor().astype(statsType), featShape);
+  }
+
+  auto gradFunc = [reduceAxes,
+                   numFeatures,
+                   featShape,
+                   normalized,
+                   invStd,
+                   count,
+                   affine](
+                      std::vector<Variable>& inputs,
+                      const Variable& gradOutput) {
+    auto& in = inputs[0];
+    auto& wt = inputs[1];
+    auto& bs = inputs[2];
+    const auto grad = gradOutput.tensor().astype(normalized.type());
+    const auto localSumGrad = fl::sum(grad, reduceAxes, /* keepDims = */ true);
+    const auto localSumGradNormalized =
+        fl::sum(grad * normalized, reduceAxes, /* keepDims = */ true);
+
+    // the gradients of the parameters are those of the batch of this process
+    if (wt.isCalcGrad()) {
+      wt.addGrad(Variable(
+          fl::reshape(localSumGradNormalized, wt.shape()).astype(wt.type()),
+          false));
+    }
+    if (bs.isCalcGrad()) {
+      bs.addGrad(Variable(
+          fl::reshape(localSumGrad, bs.shape()).astype(bs.type()), false));
+    }
+    if (!in.isCalcGrad()) {
+      return;
+    }
+
+    // the sums of all processes, in one allreduce
+    auto gradStats = fl::concatenate(
+        {localSumGrad.flatten(), localSumGradNormalized.flatten()}, 0);
+    allReduce(gradStats);
+    const auto sums = splitFeatures(gradStats, numFeatures, featShape);
+    auto scale = invStd;
+    if (affine) {
+      scale = scale *
+          fl::reshape(wt.tensor().astype(normalized.type()), featShape);
+    }
+    const auto gradInput =
+        scale * (grad - (sums[0] + normalized * sums[1]) / count);
+    in.addGrad(Variable(gradInput.astype(in.type()), false));
+  };
+  return Variable(
+      output.astype(input.type()),
+      {input.withoutData(), weight, bias},
+      gradFunc);
+}
+
+SyncBatchNorm::SyncBatchNorm(
+    int featAxis,
+    int featSize,
+    double momentum /* = 0.1 */,
+    double eps /* = 1e-5 */,
+    bool affine /* = true */,
+    bool trackStats /* = true */)
+    : BatchNorm(featAxis, featSize, momentum, eps, affine, trackStats) {}
+
+SyncBatchNorm::SyncBatchNorm(
+    const std::vector<int>& featAxis,
+    int featSize,
+    double momentum /* = 0.1 */,
+    double eps /* = 1e-5 */,
+    bool affine /* = true */,
+    bool trackStats /* = true */)
+    : BatchNorm(featAxis, featSize, momentum, eps, affine, trackStats) {}
+
+Variable SyncBatchNorm::forward(const Variable& input) {
+  // with running statistics, or a single process, there's nothing to sync
+  const bool batchStats = train_ || !trackStats_;
+  if (!batchStats || !isDistributedInit() || getWorldSize() == 1) {
+    return BatchNorm::forward(input);
+  }
+  const double avgFactor = updateAverageFactor();
+  Variable noParam;
+  return syncBatchnorm(
+      input,
+      params_.empty() ? noParam : params_[0],
+      params_.empty() ? noParam : params_[1],
+      runningMean_,
+      runningVar_,
+      featAxis_,
+      avgFactor,
+      epsilon_);
+}
+
+std::string SyncBatchNorm::prettyString() const {
+  std::ostringstream ss;
+  ss << "Sync" << BatchNorm::prettyString();
+  return ss.str();
+}
+
+} // namespace fl
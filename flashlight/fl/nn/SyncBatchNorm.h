@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/nn/modules/BatchNorm.h"
+
+namespace fl {
+
+/**
+ * Batch normalization with the statistics of the batches of all processes of
+ * the distributed environment, as if they were one batch, e.g. for data
+ * parallel training with small batches per device.
+ *
+ * The per-feature sums and sums of squares of the process, with its number of
+ * samples, are summed over processes with one allreduce in the forward pass,
+ * and the per-feature sums of the gradient and of its product with the
+ * normalized input with one in the backward pass. The gradients of
+ * \f$\gamma\f$ and \f$\beta\f$ are those of the batch of the process, which
+ * are summed by the gradient synchronization of data parallel training.
+ *
+ * All processes must run the same calls, with the same feature shape.
+ *
+ * @param input the input of the process
+ * @param weight \f$\gamma\f$ of size [`featSize`], or empty
+ * @param bias \f$\beta\f$ of size [`featSize`], or empty
+ * @param runningMean the running mean to update, or empty
+ * @param runningVar the running variance to update, or empty
+ * @param featAxes the axes over which normalization is performed
+ * @param momentum the factor by which the statistics of the batch are
+ * averaged into the running statistics
+ * @param epsilon \f$\epsilon\f$
+ * @return the normalized input of the process
+ */
+Variable syncBatchnorm(
+    const Variable& input,
+    const Variable& weight,
+    const Variable& bias,
+    Variable& runningMean,
+    Variable& runningVar,
+    const std::vector<int>& featAxes,
+    double momentum,
+    double epsilon);
+
+/**
+ * A `BatchNorm` which normalizes with the statistics of all processes when
+ * it uses batch statistics, see `syncBatchnorm`. It runs as a `BatchNorm`
+ * with running statistics, e.g. in eval mode, or without a distributed
+ * environment of several processes.
+ */
+class SyncBatchNorm : public BatchNorm {
+ public:
+  /**
+   * Constructs a SyncBatchNorm module, see the `BatchNorm` constructor.
+   */
+  SyncBatchNorm(
+      int featAxis,
+      int featSize,
+      double momentum = 0.1,
+      double eps = 1e-5,
+      bool affine = true,
+      bool trackStats = true);
+
+  SyncBatchNorm(
+      const std::vector<int>& featAxis,
+      int featSize,
+      double momentum = 0.1,
+      double eps = 1e-5,
+      bool affine = true,
+      bool trackStats = true);
+
+  Variable forward(const Variable& input) override;
+
+  std::string prettyString() const override;
+
+ private:
+  SyncBatchNorm() = default; // Intentionally private
+
+  FL_SAVE_LOAD_WITH_BASE(BatchNorm)
+};
+
+} // namespace fl
+
+CEREAL_REGISTER_TYPE(fl::SyncBatchNorm)
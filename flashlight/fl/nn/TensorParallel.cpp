@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/nn/TensorParallel.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#include "flashlight/fl/autograd/Functions.h"
+#include "flashlight/fl/distributed/DistributedApi.h"
+#include "flashlight/fl/nn/Init.h"
+#include "flashlight/fl/nn/Utils.h"
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/Random.h"
+
+namespace fl {
+
+namespace {
+
+void checkDivisible(Dim size, const std::string& name) {
+  if (size % getWorldSize() != 0) {
+    throw std::invalid_argument(
+        name + " - size " + std::to_string(size) +
+        " isn't a multiple of the world size");
+  }
+}
+
+// The slice of the rows of this process
+Tensor rowShard(const Tensor& tensor) {
+  const auto rows = tensor.dim(0) / getWorldSize();
+  const auto rank = getWorldRank();
+  return tensor(fl::range(rank * rows, (rank + 1) * rows));
+}
+
+// The slice of the columns of this process
+Tensor columnShard(const Tensor& tensor) {
+  const auto columns = tensor.dim(1) / getWorldSize();
+  const auto rank = getWorldRank();
+  return tensor(fl::span, fl::range(rank * columns, (rank + 1) * columns));
+}
+
+Variable transformerInitLinear(int32_t inDim, int32_t inShard, int32_t outDim) {
+  float std = std::sqrt(1.0 / float(inDim));
+  return fl::uniform(outDim, inShard, -std, std, fl::dtype::f32, true);
+}
+
+// Concatenates the slices of the processes along the first dimension
+Tensor gatherRows(const Tensor& tensor) {
+  const int worldSize = getWorldSize();
+  const auto rows = tensor.dim(0);
+  const Dim rest = tensor.elements() / rows;
+  // the slices are gathered one after the other, as the last dimension
+  auto gathered = fl::transpose(
+      fl::reshape(allGather(tensor), {rows, rest, worldSize}), {0, 2, 1});
+  auto shape = tensor.shape();
+  shape[0] = rows * worldSize;
+  return fl::reshape(gathered, shape);
+}
+
+} // namespace
+
+Variable copyToTensorParallel(const Variable& input) {
+  if (getWorldSize() == 1) {
+    return input;
+  }
+  auto gradFunc = [](std::vector<Variable>& inputs,
+                     const Variable& gradOutput) {
+    // reduced in place, so not in a buffer the gradient may share
+    auto grad = gradOutput.tensor().copy();
+    allReduce(grad);
+    inputs[0].addGrad(Variable(grad, false));
+  };
+  return Variable(input.tensor(), {input.withoutData()}, gradFunc);
+}
+
+Variable reduceFromTensorParallel(const Variable& input) {
+  if (getWorldSize() == 1) {
+    return input;
+  }
+  auto result = input.tensor().copy();
+  allReduce(result);
+  auto gradFunc = [](std::vector<Variable>& inputs,
+                     const Variable& gradOutput) {
+    inputs[0].addGrad(Variable(gradOutput.tensor(), false));
+  };
+  return Variable(result, {input.withoutData()}, gradFunc);
+}
+
+Variable gatherFromTensorParallel(const Variable& input) {
+  if (getWorldSize() == 1) {
+    return input;
+  }
+  auto gradFunc = [](std::vector<Variable>& inputs,
+                     const Variable& gradOutput) {
+    inputs[0].addGrad(Variable(rowShard(gradOutput.tensor()), false));
+  };
+  return Variable(
+      gatherRows(input.tensor()), {input.withoutData()}, gradFunc);
+}
+
+Variable scatterToTensorParallel(const Variable& input) {
+  if (getWorldSize() == 1) {
+    return input;
+  }
+  checkDivisible(input.dim(0), "scatterToTensorParallel");
+  auto gradFunc = [](std::vector<Variable>& inputs,
+                     const Variable& gradOutput) {
+    inputs[0].addGrad(Variable(gatherRows(gradOutput.tensor()), false));
+  };
+  return Variable(rowShard(input.tensor()), {input.withoutData()}, gradFunc);
+}
+
+ColumnParallelLinear::ColumnParallelLinear(
+    int inputSize,
+    int outputSize,
+    bool bias /* = true */,
+    bool gatherOutput /* = true */)
+    : nIn_(inputSize),
+      nOut_(outputSize),
+      bias_(bias),
+      gatherOutput_(gatherOutput) {
+  checkDivisible(nOut_, "ColumnParallelLinear");
+  const int localOut = nOut_ / getWorldSize();
+  auto w = Variable(
+      detail::kaimingUniform(Shape({localOut, nIn_}), nIn_, fl::dtype::f32),
+      true);
+  if (bias_) {
+    double bound = std::sqrt(1.0 / nIn_);
+    auto b = uniform(Shape({localOut}), -bound, bound, fl::dtype::f32, true);
+    params_ = {w, b};
+  } else {
+    params_ = {w};
+  }
+}
+
+ColumnParallelLinear::ColumnParallelLinear(
+    const Variable& w,
+    const Variable& b,
+    bool gatherOutput /* = true */)
+    : nIn_(w.dim(1)),
+      nOut_(w.dim(0)),
+      bias_(!b.isEmpty()),
+      gatherOutput_(gatherOutput) {
+  checkDivisible(nOut_, "ColumnParallelLinear");
+  params_ = {Variable(rowShard(w.tensor()), w.isCalcGrad())};
+  if (bias_) {
+    if (b.dim(0) != nOut_) {
+      throw std::invalid_argument(
+          "ColumnParallelLinear - dimension mismatch between weight and bias");
+    }
+    params_.emplace_back(rowShard(b.tensor()), b.isCalcGrad());
+  }
+}
+
+Variable ColumnParallelLinear::forward(const Variable& input) {
+  auto x = copyToTensorParallel(input);
+  auto output = bias_
+      ? linear(
+            x,
+            params_[0].astype(input.type()),
+            params_[1].astype(input.type()))
+      : linear(x, params_[0].astype(input.type()));
+  return gatherOutput_ ? gatherFromTensorParallel(output) : output;
+}
+
+std::string ColumnParallelLinear::prettyString() const {
+  std::ostringstream ss;
+  ss << "ColumnParallelLinear";
+  ss << " (" << nIn_ << "->" << nOut_ << ")";
+  if (bias_) {
+    ss << " (with bias)";
+  }
+  if (!gatherOutput_) {
+    ss << " (parallel output)";
+  }
+  return ss.str();
+}
+
+RowParallelLinear::RowParallelLinear(
+    int inputSize,
+    int outputSize,
+    bool bias /* = true */,
+    bool inputIsParallel /* = false */)
+    : nIn_(inputSize),
+      nOut_(outputSize),
+      bias_(bias),
+      inputIsParallel_(inputIsParallel) {
+  checkDivisible(nIn_, "RowParallelLinear");
+  auto w = Variable(
+      detail::kaimingUniform(
+          Shape({nOut_, nIn_ / getWorldSize()}), nIn_, fl::dtype::f32),
+      true);
+  if (bias_) {
+    double bound = std::sqrt(1.0 / nIn_);
+    auto b = uniform(Shape({nOut_}), -bound, bound, fl::dtype::f32, true);
+    // the bias is replicated, so the same on all processes
+    if (getWorldSize() > 1) {
+      broadcast(b.tensor(), 0);
+    }
+    params_ = {w, b};
+  } else {
+    params_ = {w};
+  }
+}
+
+RowParallelLinear::RowParallelLinear(
+    const Variable& w,
+    const Variable& b,
+    bool inputIsParallel /* = false */)
+    : nIn_(w.dim(1)),
+      nOut_(w.dim(0)),
+      bias_(!b.isEmpty()),
+      inputIsParallel_(inputIsParallel) {
+  checkDivisible(nIn_, "RowParallelLinear");
+  params_ = {Variable(columnShard(w.tensor()), w.isCalcGrad())};
+  if (bias_) {
+    if (b.dim(0) != nOut_) {
+      throw std::invalid_argument(
+          "RowParallelLinear - dimension mismatch between weight and bias");
+    }
+    params_.push_back(b);
+  }
+}
+
+Variable RowParallelLinear::forward(const Variable& input) {
+  auto x = inputIsParallel_ ? input : scatterToTensorParallel(input);
+  auto output =
+      reduceFromTensorParallel(linear(x, params_[0].astype(input.type())));
+  if (bias_) {
+    // added once, after the partial outputs are summed
+    output = output + tileAs(params_[1].astype(output.type()), output);
+  }
+  return output;
+}
+
+std::string RowParallelLinear::prettyString() const {
+  std::ostringstream ss;
+  ss << "RowParallelLinear";
+  ss << " (" << nIn_ << "->" << nOut_ << ")";
+  if (bias_) {
+    ss << " (with bias)";
+  }
+  if (inputIsParallel_) {
+    ss << " (parallel input)";
+  }
+  return ss.str();
+}
+
+TensorParallelTransformer::TensorParallelTransformer(
+    int32_t modelDim,
+    int32_t headDim,
+    int32_t mlpDim,
+    int32_t nHeads,
+    int32_t bptt,
+    float pDropout,
+    float pLayerdrop,
+    bool useMask,
+    bool preLN)
+    : nHeads_(nHeads),
+      bptt_(bptt),
+      pDropout_(pDropout),
+      pLayerdrop_(pLayerdrop),
+      useMask_(useMask),
+      preLN_(preLN),
+      norm1_(std::make_shared<LayerNorm>(std::vector<int>({0, 3}))),
+      norm2_(std::make_shared<LayerNorm>(std::vector<int>({0, 3}))) {
+  checkDivisible(nHeads, "TensorParallelTransformer");
+  checkDivisible(mlpDim, "TensorParallelTransformer");
+  const int32_t worldSize = getWorldSize();
+  const int32_t attentionDim = headDim * nHeads;
+  const int32_t attentionShard = attentionDim / worldSize;
+  const int32_t mlpShard = mlpDim / worldSize;
+  w1_ = std::make_shared<Linear>(
+      transformerInitLinear(modelDim, modelDim, mlpShard));
+  w2_ = std::make_shared<Linear>(
+      transformerInitLinear(mlpDim, mlpShard, modelDim));
+  wq_ = std::make_shared<Linear>(
+      transformerInitLinear(modelDim, modelDim, attentionShard));
+  wk_ = std::make_shared<Linear>(
+      transformerInitLinear(modelDim, modelDim, attentionShard));
+  wv_ = std::make_shared<Linear>(
+      transformerInitLinear(modelDim, modelDim, attentionShard));
+  wf_ = std::make_shared<Linear>(
+      transformerInitLinear(attentionDim, attentionShard, modelDim));
+  if (bptt > 0) {
+    params_.push_back(
+        uniform(2 * bptt - 1, headDim, -0.1, 0.1, fl::dtype::f32, true));
+    // replicated, so the same on all processes
+    if (worldSize > 1) {
+      broadcast(params_.back().tensor(), 0);
+    }
+  }
+
+  add(w1_);
+  add(w2_);
+  add(wq_);
+  add(wk_);
+  add(wv_);
+  add(wf_);
+  add(norm1_);
+  add(norm2_);
+}
+
+Variable TensorParallelTransformer::mlp(const Variable& input) {
+  float pDropout = train_ ? pDropout_ : 0.0;
+  auto hidden = relu((*w1_)(copyToTensorParallel(input)));
+  return reduceFromTensorParallel((*w2_)(dropout(hidden, pDropout)));
+}
+
+Variable TensorParallelTransformer::selfAttention(
+    const Variable& input,
+    const Variable& padMaskInput) {
+  int n = input.dim(1);
+  double pDrop = train_ ? pDropout_ : 0.0;
+
+  auto x = copyToTensorParallel(input);
+  auto q = transpose((*wq_)(x), {1, 0, 2});
+  auto k = transpose((*wk_)(x), {1, 0, 2});
+  auto v = transpose((*wv_)(x), {1, 0, 2});
+
+  Variable mask, posEmb;
+  if (bptt_ > 0) {
+    // each process computes the part of the gradient of its heads
+    posEmb = copyToTensorParallel(params_[0]).astype(input.type());
+  }
+  if (useMask_ && n > 1) {
+    mask = Variable(fl::log(fl::tril(fl::full({n, n}, 1.0))), false);
+  }
+
+  // time x batch
+  Variable padMask;
+  if (!padMaskInput.isEmpty()) {
+    auto padMaskArr = padMaskInput.tensor();
+    Shape newMaskShape = {input.dim(1), input.dim(2)};
+    if (padMaskArr.elements() != newMaskShape.elements()) {
+      throw std::runtime_error(
+          "TensorParallelTransformer::selfAttention - pad mask requires "
+          "resize");
+    }
+    padMaskArr = fl::reshape(padMaskArr, newMaskShape);
+    padMask = Variable(fl::log(padMaskArr), false);
+  }
+  auto result = multiheadAttention(
+      q, k, v, posEmb, mask, padMask, nHeads_ / getWorldSize(), pDrop, 0);
+  return reduceFromTensorParallel((*wf_)(transpose(result, {1, 0, 2})));
+}
+
+std::vector<Variable> TensorParallelTransformer::forward(
+    const std::vector<Variable>& input) {
+  if (input.size() != 2) {
+    throw std::invalid_argument(
+        "TensorParallelTransformer::forward - expects an input and a pad "
+        "mask");
+  }
+  const auto& x = input[0];
+  if (x.ndim() != 3) {
+    throw std::invalid_argument(
+        "TensorParallelTransformer::forward - input should be of 3 dimensions "
+        "expects an input of size C x T x B - see documentation.");
+  }
+  if (!input[1].isEmpty() &&
+      (input[1].ndim() < 2 || x.dim(2) != input[1].dim(1))) {
+    throw std::invalid_argument(
+        "TensorParallelTransformer::forward - invalid size for pad mask");
+  }
+
+  float f = 1.0;
+  if (train_ && pLayerdrop_ > 0) {
+    // all processes must drop the layer, or none
+    auto draw = fl::rand({1});
+    if (getWorldSize() > 1) {
+      broadcast(draw, 0);
+    }
+    if (draw.scalar<float>() < pLayerdrop_) {
+      f = 0.0;
+    }
+  }
+
+  auto attention = selfAttention(x, input[1]);
+  if (preLN_) {
+    auto h = (f * (*norm1_)(attention)).astype(x.type()) + x;
+    return {f * (*norm2_)(mlp(h)).astype(h.type()) + h};
+  }
+  auto h = (*norm1_)((f * attention).astype(x.type()) + x);
+  return {(*norm2_)((f * mlp(h)).astype(h.type()) + h)};
+}
+
+void TensorParallelTransformer::setDropout(float value) {
+  pDropout_ = value;
+}
+
+void TensorParallelTransformer::setLayerDropout(float value) {
+  pLayerdrop_ = value;
+}
+
+std::string TensorParallelTransformer::prettyString() const {
+  std::ostringstream ss;
+  ss << "TensorParallelTransformer (nHeads: " << nHeads_ << "), "
+     << "(pDropout: " << pDropout_ << "), "
+     << "(pLayerdrop: " << pLayerdrop_ << "), "
+     << "(bptt: " << bptt_ << "), "
+     << "(useMask: " << useMask_ << "), "
+     << "(preLayerNorm: " << preLN_ << ")";
+  return ss.str();
+}
+
+} // namespace fl
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/nn/modules/Container.h"
+#include "flashlight/fl/nn/modules/LayerNorm.h"
+#include "flashlight/fl/nn/modules/Linear.h"
+#include "flashlight/fl/nn/modules/Module.h"
+
+namespace fl {
+
+/**
+ * \defgroup nn_tensor_parallel NN Tensor Parallelism
+ *
+ * Layers whose weights are sharded across processes, as in Megatron-LM
+ * (https://arxiv.org/abs/1909.08053), such that a model can be wider than the
+ * memory of a device. All processes run the same layers on the same inputs,
+ * and each computes the part of the output of its shard of the weights; the
+ * functions below move between replicated activations, which are the same
+ * on all processes, and parallel activations, of which each process holds a
+ * slice along the first (feature) dimension.
+ *
+ * The processes are those of the distributed environment, so tensor
+ * parallelism isn't combined with data parallelism.
+ * @{
+ */
+
+/**
+ * Enters a parallel region: the identity in the forward pass, and sums the
+ * gradient over processes in the backward pass, since each process only
+ * computes the part of the gradient of its shard.
+ */
+Variable copyToTensorParallel(const Variable& input);
+
+/**
+ * Leaves a parallel region by summing partial outputs over processes in the
+ * forward pass, and the identity in the backward pass.
+ */
+Variable reduceFromTensorParallel(const Variable& input);
+
+/**
+ * Leaves a parallel region by concatenating the slices of the processes along
+ * the first dimension, in order of rank, in the forward pass. The backward
+ * pass keeps the slice of the gradient of this process.
+ */
+Variable gatherFromTensorParallel(const Variable& input);
+
+/**
+ * Enters a parallel region by keeping the slice of this process along the
+ * first dimension, whose size must be a multiple of the world size, in the
+ * forward pass. The backward pass gathers the slices of the gradient.
+ */
+Variable scatterToTensorParallel(const Variable& input);
+
+/**
+ * A `Linear` layer whose outputs are sharded across processes: each process
+ * holds the rows of the weight and bias of a slice of the outputs, whose
+ * number must be a multiple of the world size. The input is replicated, and
+ * the output is either gathered or kept parallel, e.g. as the input of a
+ * `RowParallelLinear`.
+ */
+class ColumnParallelLinear : public UnaryModule {
+ public:
+  /**
+   * @param inputSize the size of each input sample
+   * @param outputSize the size of each output sample, over all processes
+   * @param bias whether the layer has a bias
+   * @param gatherOutput whether to gather the output, or to only return the
+   * slice of this process
+   */
+  ColumnParallelLinear(
+      int inputSize,
+      int outputSize,
+      bool bias = true,
+      bool gatherOutput = true);
+
+  /**
+   * Shards the weights of a `Linear` layer, of which it keeps the rows of
+   * this process, e.g. those of a trained model.
+   *
+   * @param w the weight of size `outputSize` x `inputSize`
+   * @param b the bias of size `outputSize`, or empty for no bias
+   * @param gatherOutput see above
+   */
+  ColumnParallelLinear(
+      const Variable& w,
+      const Variable& b,
+      bool gatherOutput = true);
+
+  Variable forward(const Variable& input) override;
+
+  std::string prettyString() const override;
+
+ private:
+  ColumnParallelLinear() = default; // Intentionally private
+
+  int nIn_, nOut_;
+  bool bias_;
+  bool gatherOutput_;
+
+  FL_SAVE_LOAD_WITH_BASE(UnaryModule, nIn_, nOut_, bias_, gatherOutput_)
+};
+
+/**
+ * A `Linear` layer whose inputs are sharded across processes: each process
+ * holds the columns of the weight of a slice of the inputs, whose number must
+ * be a multiple of the world size, and the output is the sum of the partial
+ * outputs of the processes, plus a bias, replicated. The input is either
+ * replicated, of which each process takes its slice, or already parallel,
+ * e.g. the output of a `ColumnParallelLinear`.
+ */
+class RowParallelLinear : public UnaryModule {
+ public:
+  /**
+   * @param inputSize the size of each input sample, over all processes
+   * @param outputSize the size of each output sample
+   * @param bias whether the layer has a bias
+   * @param inputIsParallel whether the input is the slice of this process,
+   * rather than replicated
+   */
+  RowParallelLinear(
+      int inputSize,
+      int outputSize,
+      bool bias = true,
+      bool inputIsParallel = false);
+
+  /**
+   * Shards the weights of a `Linear` layer, of which it keeps the columns of
+   * this process, e.g. those of a trained model.
+   *
+   * @param w the weight of size `outputSize` x `inputSize`
+   * @param b the bias of size `outputSize`, or empty for no bias
+   * @param inputIsParallel see above
+   */
+  RowParallelLinear(
+      const Variable& w,
+      const Variable& b,
+      bool inputIsParallel = false);
+
+  Variable forward(const Variable& input) override;
+
+  std::string prettyString() const override;
+
+ private:
+  RowParallelLinear() = default; // Intentionally private
+
+  int nIn_, nOut_;
+  bool bias_;
+  bool inputIsParallel_;
+
+  FL_SAVE_LOAD_WITH_BASE(UnaryModule, nIn_, nOut_, bias_, inputIsParallel_)
+};
+
+/**
+ * A block of `fl::Transformer` whose attention heads and feed-forward hidden
+ * units are sharded across processes: each process holds the query, key and
+ * value projections of `nHeads / worldSize` heads and the columns of the
+ * output projection for them, and a slice of the feed-forward layers, such
+ * that a block needs two sums over processes in the forward pass, and two in
+ * the backward pass. The layer norms and the relative positional embedding
+ * are replicated, and the input and output are replicated, of size C x T x B.
+ *
+ * Its `forward` takes the input and a pad mask as `fl::Transformer`, and
+ * layer drop draws the same decision on all processes.
+ */
+class TensorParallelTransformer : public Container {
+ public:
+  /**
+   * Takes the arguments of `fl::Transformer`, where the number of heads and
+   * `mlpDim` must be multiples of the world size.
+   */
+  TensorParallelTransformer(
+      int32_t modelDim,
+      int32_t headDim,
+      int32_t mlpDim,
+      int32_t nHeads,
+      int32_t bptt,
+      float pDropout,
+      float pLayerdrop,
+      bool useMask = false,
+      bool preLN = false);
+
+  std::vector<Variable> forward(const std::vector<Variable>& input) override;
+
+  void setDropout(float value);
+  void setLayerDropout(float value);
+  std::string prettyString() const override;
+
+ private:
+  int32_t nHeads_;
+  int32_t bptt_;
+  double pDropout_;
+  double pLayerdrop_;
+  bool useMask_;
+  bool preLN_;
+  // the shards of this process
+  std::shared_ptr<Linear> w1_, w2_, wq_, wk_, wv_, wf_;
+  std::shared_ptr<LayerNorm> norm1_, norm2_;
+
+  Variable mlp(const Variable& input);
+  Variable selfAttention(const Variable& input, const Variable& padMask);
+
+  FL_SAVE_LOAD_WITH_BASE(
+      Container,
+      w1_,
+      w2_,
+      wq_,
+      wk_,
+      wv_,
+      wf_,
+      norm1_,
+      norm2_,
+      nHeads_,
+      pDropout_,
+      pLayerdrop_,
+      bptt_,
+      useMask_,
+      preLN_)
+
+  TensorParallelTransformer() = default;
+};
+
+/** @} */
+
+} // namespace fl
+
+CEREAL_REGISTER_TYPE(fl::ColumnParallelLinear)
+CEREAL_REGISTER_TYPE(fl::RowParallelLinear)
+CEREAL_REGISTER_TYPE(fl::TensorParallelTransformer)
@@ -7,15 +7,110 @@
 
 #include <algorithm>
 #include <array>
+#include <stdexcept>
+#include <typeinfo>
 
 #include "flashlight/fl/nn/Utils.h"
 
 #include "flashlight/fl/autograd/Utils.h"
 #include "flashlight/fl/common/Utils.h"
+#include "flashlight/fl/nn/modules/BatchNorm.h"
+#include "flashlight/fl/nn/modules/Container.h"
+#include "flashlight/fl/nn/modules/Conv2D.h"
+#include "flashlight/fl/nn/modules/Dropout.h"
+#include "flashlight/fl/nn/modules/Identity.h"
+#include "flashlight/fl/nn/modules/Linear.h"
+#include "flashlight/fl/nn/modules/Pool2D.h"
+#include "flashlight/fl/nn/modules/WeightNorm.h"
 #include "flashlight/fl/tensor/Index.h"
 
 namespace fl {
 
+namespace {
+
+// Folds a BatchNorm into the preceding module if possible. Modules derived from
+// Conv2D and Linear, e.g. quantized ones, aren't folded into.
+bool foldBatchNorm(const ModulePtr& prev, const BatchNorm& batchNorm) {
+  const auto featAxis = batchNorm.getFeatAxis();
+  if (!prev || featAxis.size() != 1) {
+    return false;
+  }
+  int channelAxis;
+  const bool isConv = typeid(*prev) == typeid(Conv2D);
+  if (isConv) {
+    const auto format = static_cast<Conv2D&>(*prev).getMemoryFormat();
+    channelAxis = format == MemoryFormat::CWHN ? 0 : 2;
+  } else if (typeid(*prev) == typeid(Linear)) {
+    channelAxis = 0;
+  } else {
+    return false;
+  }
+  if (featAxis[0] != channelAxis) {
+    return false;
+  }
+  Tensor scale, shift;
+  try {
+    batchNorm.getInferenceAffine(scale, shift);
+  } catch (const std::invalid_argument&) {
+    // batch statistics
+    return false;
+  }
+  if (isConv) {
+    auto& conv = static_cast<Conv2D&>(*prev);
+    if (scale.elements() != conv.param(0).dim(3)) {
+      return false;
+    }
+    conv.foldAffine(scale, shift);
+  } else {
+    auto& linear = static_cast<Linear&>(*prev);
+    if (scale.elements() != linear.param(0).dim(0)) {
+      return false;
+    }
+    linear.foldAffine(scale, shift);
+  }
+  return true;
+}
+
+void optimizeContainer(Container& container);
+
+// Returns the module which replaces a module for inference
+ModulePtr optimizeModule(const ModulePtr& module) {
+  if (auto* weightNorm = dynamic_cast<WeightNorm*>(module.get())) {
+    // the weight was computed in eval mode
+    auto inner = weightNorm->module();
+    inner->setParams(Variable(inner->param(0).tensor(), false), 0);
+    return optimizeModule(inner);
+  }
+  if (auto* container = dynamic_cast<Container*>(module.get())) {
+    optimizeContainer(*container);
+  }
+  return module;
+}
+
+void optimizeContainer(Container& container) {
+  std::vector<ModulePtr> modules;
+  const bool isSequential = dynamic_cast<Sequential*>(&container) != nullptr;
+  for (const auto& child : container.modules()) {
+    auto module = optimizeModule(child);
+    if (isSequential) {
+      if (dynamic_cast<Dropout*>(module.get()) ||
+          dynamic_cast<Identity*>(module.get())) {
+        continue;
+      }
+      auto* batchNorm = dynamic_cast<BatchNorm*>(module.get());
+      if (batchNorm && !modules.empty() &&
+          foldBatchNorm(modules.back(), *batchNorm)) {
+        continue;
+      }
+    }
+    modules.push_back(module);
+  }
+  // also refreshes the parameters of the container from its modules
+  container.setModules(modules);
+}
+
+} // namespace
+
 int64_t numTotalParams(std::shared_ptr<fl::Module> module) {
   int64_t params = 0;
   for (auto& p : module->params()) {
@@ -84,6 +179,29 @@ int64_t getNumRnnParams(
 }
 } // namespace detail
 
+void optimizeForInference(Module& module) {
+  module.eval();
+  if (auto* container = dynamic_cast<Container*>(&module)) {
+    optimizeContainer(*container);
+  }
+}
+
+void setMemoryFormat(Module& module, MemoryFormat format) {
+  if (auto* conv = dynamic_cast<Conv2D*>(&module)) {
+    conv->setMemoryFormat(format);
+  } else if (auto* pool = dynamic_cast<Pool2D*>(&module)) {
+    pool->setMemoryFormat(format);
+  } else if (auto* batchNorm = dynamic_cast<BatchNorm*>(&module)) {
+    batchNorm->setMemoryFormat(format);
+  } else if (auto* container = dynamic_cast<Container*>(&module)) {
+    for (const auto& child : container->modules()) {
+      setMemoryFormat(*child, format);
+    }
+    // refreshes the parameters of the container from its modules
+    container->setModules(container->modules());
+  }
+}
+
 int derivePadding(int inSz, int filterSz, int stride, int pad, int dilation) {
   if (pad == static_cast<int>(PaddingMode::SAME)) {
     int newPad;
@@ -117,7 +235,7 @@ Tensor join(
   // If the batch dim > the max number of dims, make those dims singleton
   int outNdims = std::max(batchDim + 1, static_cast<int>(maxNumDims));
 
-  Shape maxDims(std::vector<Dim>(outNdims, 1));
+  Shape maxDims(Shape::Dims(outNdims, 1));
 
   fl::dtype type = inputs[0].type();
   bool isEmpty = true;
@@ -42,6 +42,42 @@ bool allParamsClose(
     const Module& b,
     double absTolerance = 1e-5);
 
+/**
+ * Simplifies a module for inference, in place: puts it in eval mode, replaces
+ * each `WeightNorm` by its module with the normalized weights, folds each
+ * `BatchNorm` (including derived ones, e.g. `FrozenBatchNorm`) which
+ * immediately follows a `Conv2D` or `Linear` in a `Sequential` into its
+ * weights and bias, and removes `Dropout` and `Identity` modules from
+ * `Sequential`s. Nested containers are simplified as well.
+ *
+ * The module computes the same function in eval mode, but can't be trained as
+ * before, and its modules may be replaced, so pointers to them should be
+ * fetched again. Only `BatchNorm`s with running statistics over the channel
+ * axis of the preceding layer are folded, i.e. axis 2 for `Conv2D` and 0 for
+ * `Linear`.
+ *
+ * @param module the module to simplify
+ */
+void optimizeForInference(Module& module);
+
+/**
+ * Sets the memory layout of the images of a convolutional model, in place: of
+ * its `Conv2D` and `Pool2D` modules, whose weights are permuted, and of its
+ * `BatchNorm` modules (including derived ones), whose feature axis is moved to
+ * the channel axis. Nested containers are converted as well, and other
+ * modules are left as is.
+ *
+ * Channels-last `MemoryFormat::CWHN` models take inputs of shape [C, W, H, N]
+ * and compute the same function as before, e.g. on `fl::transpose(input, {2,
+ * 0, 1, 3})`, without transposing between layers. Layers which are not
+ * layout-agnostic, e.g. a `View` of images which are not 1 x 1, must be
+ * adapted separately.
+ *
+ * @param module the module to convert
+ * @param format the layout of the images
+ */
+void setMemoryFormat(Module& module, MemoryFormat format);
+
 namespace detail {
 
 int64_t getNumRnnParams(
@@ -11,6 +11,8 @@
 
 namespace fl {
 
+class FrozenModel;
+
 /**
  * Applies the [sigmoid
  * function](https://en.wikipedia.org/wiki/Sigmoid_function) element-wise to a
@@ -143,6 +145,8 @@ class LeakyReLU : public UnaryModule {
 
   FL_SAVE_LOAD_WITH_BASE(UnaryModule, mSlope_)
 
+  friend class FrozenModel;
+
  public:
   /**
    * Creates a `LeakyReLU` with the specified slope
@@ -309,6 +313,8 @@ class LogSoftmax : public UnaryModule {
 
   FL_SAVE_LOAD_WITH_BASE(UnaryModule, dim_)
 
+  friend class FrozenModel;
+
  public:
   /**
    * Creates a `LogSoftmax`.
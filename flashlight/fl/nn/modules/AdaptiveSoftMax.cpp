@@ -5,7 +5,10 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <limits>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 #include "flashlight/fl/autograd/Functions.h"
@@ -15,6 +18,29 @@
 
 namespace fl {
 
+namespace {
+
+// Keeps, for each column, the best of the candidates in `values` and `indices`
+// and of the given ones, as many as there are rows in `values`
+void mergeTopK(
+    Tensor& values,
+    Tensor& indices,
+    const Tensor& candidateValues,
+    const Tensor& candidateIndices) {
+  const auto k = values.dim(0);
+  auto allValues = fl::concatenate(0, values, candidateValues);
+  auto allIndices = fl::concatenate(0, indices, candidateIndices);
+  Tensor positions;
+  fl::topk(values, positions, allValues, k, 0);
+  // the positions in the flattened columns of the candidates
+  auto flatPositions = positions.astype(fl::dtype::s32) +
+      fl::arange({1, allValues.dim(1)}, 1, fl::dtype::s32) * allValues.dim(0);
+  indices = fl::reshape(
+      allIndices.flatten()(flatPositions.flatten()), values.shape());
+}
+
+} // namespace
+
 AdaptiveSoftMax::AdaptiveSoftMax(
     int inputSize,
     const std::vector<int>& cutoff,
@@ -123,6 +149,82 @@ Variable AdaptiveSoftMax::predict(const Variable& inputs) const {
   return moddims(ret, outDims);
 }
 
+void AdaptiveSoftMax::topK(
+    Tensor& values,
+    Tensor& indices,
+    const Variable& inputs,
+    unsigned k) const {
+  // input -- [C_in, .. , N]
+  // return -- [k, .. , N]
+  auto inputSize = inputs.dim(0);
+  if (inputSize != params_[0].dim(1)) {
+    throw std::invalid_argument(
+        "AdaptiveSoftMax::topK: invalid input dimension");
+  }
+  if (k == 0 || k > static_cast<unsigned>(cutoff_.back())) {
+    throw std::invalid_argument(
+        "AdaptiveSoftMax::topK: k must be in [1, " +
+        std::to_string(cutoff_.back()) + "], got " + std::to_string(k));
+  }
+
+  auto inputsFlattened =
+      Variable(fl::reshape(inputs.tensor(), {inputSize, -1}), false);
+  auto batchSize = inputsFlattened.dim(1);
+  auto headOutput =
+      logSoftmax(matmul(params_.front(), inputsFlattened), 0).tensor();
+
+  // start from the classes of the head
+  values = fl::full(
+      {k, batchSize}, -std::numeric_limits<float>::infinity(), inputs.type());
+  indices = fl::full({k, batchSize}, 0, fl::dtype::s32);
+  {
+    Tensor headValues, headIndices;
+    fl::topk(
+        headValues,
+        headIndices,
+        headOutput(fl::range(0, cutoff_[0])),
+        std::min<unsigned>(k, cutoff_[0]),
+        0);
+    mergeTopK(values, indices, headValues, headIndices.astype(fl::dtype::s32));
+  }
+
+  for (int i = 0; i < cutoff_.size() - 1; i++) {
+    auto idx = i + cutoff_[0];
+    auto bucketLogProb = headOutput(fl::range(idx, idx + 1));
+    // examples for which a class of the bucket can be among the best
+    auto expand = (bucketLogProb > values(fl::range(k - 1, k))).flatten();
+    if (!fl::any(expand).asScalar<bool>()) {
+      continue;
+    }
+    auto tailOutput = matmul(
+        params_[2 + i * 2],
+        matmul(params_[1 + i * 2], inputsFlattened(fl::span, expand)));
+    auto tailLogProb = logSoftmax(tailOutput, 0).tensor() +
+        fl::tile(bucketLogProb(fl::span, expand), {tailOutput.dim(0)});
+    Tensor tailValues, tailIndices;
+    fl::topk(
+        tailValues,
+        tailIndices,
+        tailLogProb,
+        std::min<unsigned>(k, cutoff_[i + 1] - cutoff_[i]),
+        0);
+    Tensor expandValues = values(fl::span, expand);
+    Tensor expandIndices = indices(fl::span, expand);
+    mergeTopK(
+        expandValues,
+        expandIndices,
+        tailValues,
+        tailIndices.astype(fl::dtype::s32) + cutoff_[i]);
+    values(fl::span, expand) = expandValues;
+    indices(fl::span, expand) = expandIndices;
+  }
+
+  Shape outDims = inputs.shape();
+  outDims[0] = k;
+  values = fl::reshape(values, outDims);
+  indices = fl::reshape(indices, outDims);
+}
+
 std::vector<int> AdaptiveSoftMax::getCutoff() const {
   return cutoff_;
 }
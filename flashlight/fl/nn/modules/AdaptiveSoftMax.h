@@ -92,6 +92,31 @@ class AdaptiveSoftMax : public UnaryModule {
    * containing the classes with the highest probabilities, over each sample.
    */
   Variable predict(const Variable& inputs) const;
+
+  /**
+   * Computes the `k` classes with the highest log-probabilities for each
+   * example in a given input, e.g. for beam search, without computing the full
+   * distribution: the log-probability of a class of a tail bucket is at most
+   * that of its bucket in the head, so a tail bucket is only evaluated for the
+   * examples for which its head log-probability is above the `k`-th best
+   * log-probability found so far.
+   *
+   * @param[out] values a Tensor with shape [\f$k\f$, \f$B_1\f$, \f$B_2\f$,
+   * \f$B_3\f$] containing the `k` highest log-probabilities of each sample,
+   * in descending order.
+   * @param[out] indices a Tensor of type s32 with the same shape, containing
+   * the classes of `values`.
+   * @param inputs a Variable with size [\f$C_{in}\f$, \f$B_1\f$, \f$B_2\f$,
+   * \f$B_3\f$].
+   * @param k the number of classes to return, which is at most the number of
+   * classes.
+   */
+  void topK(
+      Tensor& values,
+      Tensor& indices,
+      const Variable& inputs,
+      unsigned k) const;
+
   std::vector<int> getCutoff() const;
 
   std::string prettyString() const override;
@@ -7,6 +7,8 @@
 
 #include "flashlight/fl/nn/modules/BatchNorm.h"
 
+#include <stdexcept>
+
 #include "flashlight/fl/autograd/Functions.h"
 #include "flashlight/fl/nn/Init.h"
 
@@ -44,7 +46,7 @@ BatchNorm::BatchNorm(
   initialize();
 }
 
-Variable BatchNorm::forward(const Variable& input) {
+double BatchNorm::updateAverageFactor() {
   double avgFactor = 0.0;
 
   if (train_ && trackStats_) {
@@ -55,9 +57,14 @@ Variable BatchNorm::forward(const Variable& input) {
       avgFactor = momentum_;
     }
   }
+  return avgFactor;
+}
+
+Variable BatchNorm::forward(const Variable& input) {
+  const double avgFactor = updateAverageFactor();
 
   auto paramsType =
-      (input.type() == fl::dtype::f16) ? fl::dtype::f32 : input.type();
+      isHalfPrecisionType(input.type()) ? fl::dtype::f32 : input.type();
   return batchnorm(
       input,
       params_.empty() ? Variable(Tensor(paramsType), false) : params_[0],
@@ -83,6 +90,36 @@ void BatchNorm::initialize() {
   }
 }
 
+void BatchNorm::getInferenceAffine(Tensor& scale, Tensor& shift) const {
+  if (!trackStats_) {
+    throw std::invalid_argument(
+        "BatchNorm::getInferenceAffine: the module uses batch statistics");
+  }
+  scale = 1 / fl::sqrt(runningVar_.tensor() + epsilon_);
+  shift = -runningMean_.tensor() * scale;
+  if (affine_) {
+    scale = scale * params_[0].tensor();
+    shift = shift * params_[0].tensor() + params_[1].tensor();
+  }
+}
+
+std::vector<int> BatchNorm::getFeatAxis() const {
+  return featAxis_;
+}
+
+void BatchNorm::setMemoryFormat(MemoryFormat format) {
+  const bool channelsLast = format == MemoryFormat::CWHN;
+  const int channelAxis = channelsLast ? 0 : 2;
+  const int otherChannelAxis = channelsLast ? 2 : 0;
+  if (featAxis_.size() != 1 ||
+      (featAxis_[0] != channelAxis && featAxis_[0] != otherChannelAxis)) {
+    throw std::invalid_argument(
+        "BatchNorm::setMemoryFormat - expects a batch norm over the channel "
+        "axis of images");
+  }
+  featAxis_ = {channelAxis};
+}
+
 std::string BatchNorm::prettyString() const {
   std::ostringstream ss;
   ss << "BatchNorm";
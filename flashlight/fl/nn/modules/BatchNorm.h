@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "flashlight/fl/common/Defines.h"
 #include "flashlight/fl/nn/modules/Module.h"
 
 namespace fl {
@@ -54,6 +55,13 @@ protected:
    */
   void initialize();
 
+  /**
+   * Counts a batch if the module tracks running statistics in train mode, and
+   * returns the factor by which the statistics of the batch are averaged into
+   * the running statistics, or 0 if they aren't.
+   */
+  double updateAverageFactor();
+
  public:
   /**
    * Constructs a BatchNorm module.
@@ -116,6 +124,26 @@ protected:
 
   Variable forward(const Variable& input) override;
 
+  /**
+   * Computes the per-feature affine transform, `input * scale + shift`, which
+   * the module applies in eval mode, e.g. to fold it into a preceding layer.
+   * Throws if the module doesn't track running statistics.
+   *
+   * @param[out] scale a Tensor of size [`featSize`]
+   * @param[out] shift a Tensor of size [`featSize`]
+   */
+  void getInferenceAffine(Tensor& scale, Tensor& shift) const;
+
+  /** Returns the axes over which normalization is performed. */
+  std::vector<int> getFeatAxis() const;
+
+  /**
+   * Moves the feature axis of a batch norm of images to the channel axis of a
+   * memory format, i.e. axis 2 for `MemoryFormat::WHCN` and 0 for
+   * `MemoryFormat::CWHN`. Throws if the feature axis is neither.
+   */
+  void setMemoryFormat(MemoryFormat format);
+
   std::string prettyString() const override;
 };
 
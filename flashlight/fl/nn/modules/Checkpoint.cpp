@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/nn/modules/Checkpoint.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/tensor/Random.h"
+
+namespace fl {
+
+namespace {
+
+constexpr int kSeedDrawBits = 24;
+
+// A seed drawn from the random numbers in use, which are those of the
+// enclosing checkpoint when nested, so that its recomputation is replayed
+uint64_t drawSeed() {
+  auto draws = (fl::rand({2}) * (1 << kSeedDrawBits))
+                   .astype(fl::dtype::s64)
+                   .toHostVector<int64_t>();
+  return (static_cast<uint64_t>(draws[0]) << kSeedDrawBits) |
+      static_cast<uint64_t>(draws[1]);
+}
+
+bool anyCalcGrad(const std::vector<Variable>& vars) {
+  return std::any_of(vars.begin(), vars.end(), [](const Variable& var) {
+    return var.isCalcGrad();
+  });
+}
+
+// Runs `module` on new leaves holding the data of `inputs` and `params`, the
+// latter being the parameters of `module`, which are restored afterwards. The
+// leaves require gradients if `calcGrad` and if the Variables they replace do.
+std::vector<Variable> forwardDetached(
+    Module& module,
+    const std::vector<Variable>& inputs,
+    const std::vector<Variable>& params,
+    uint64_t seed,
+    bool calcGrad,
+    std::vector<Variable>& leaves) {
+  leaves.clear();
+  for (const auto& input : inputs) {
+    leaves.emplace_back(input.tensor(), calcGrad && input.isCalcGrad());
+  }
+  for (int i = 0; i < params.size(); ++i) {
+    leaves.emplace_back(params[i].tensor(), calcGrad && params[i].isCalcGrad());
+    module.setParams(leaves.back(), i);
+  }
+
+  std::vector<Variable> outputs;
+  try {
+    RandomState state(seed);
+    RandomStateScope scope(state);
+    outputs = module.forward(
+        std::vector<Variable>(leaves.begin(), leaves.begin() + inputs.size()));
+  } catch (...) {
+    for (int i = 0; i < params.size(); ++i) {
+      module.setParams(params[i], i);
+    }
+    throw;
+  }
+  for (int i = 0; i < params.size(); ++i) {
+    module.setParams(params[i], i);
+  }
+  return outputs;
+}
+
+} // namespace
+
+Checkpoint::Checkpoint(std::shared_ptr<Module> module) {
+  add(std::move(module));
+}
+
+std::vector<Variable> Checkpoint::forward(const std::vector<Variable>& inputs) {
+  auto module = modules_[0];
+  if (!anyCalcGrad(inputs) && !anyCalcGrad(params_)) {
+    return module->forward(inputs);
+  }
+
+  const auto seed = drawSeed();
+  std::vector<Variable> leaves;
+  auto outputs = forwardDetached(
+      *module, inputs, params_, seed, /* calcGrad = */ false, leaves);
+
+  // Each output recomputes the graph to propagate its own gradient
+  std::vector<Variable> gradInputs(inputs);
+  gradInputs.insert(gradInputs.end(), params_.begin(), params_.end());
+  const size_t numInputs = inputs.size();
+  std::vector<Variable> results;
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    auto gradFunc = [module, numInputs, seed, i](
+                        std::vector<Variable>& gradInputs,
+                        const Variable& gradOutput) {
+      std::vector<Variable> inputs(
+          gradInputs.begin(), gradInputs.begin() + numInputs);
+      std::vector<Variable> params(
+          gradInputs.begin() + numInputs, gradInputs.end());
+      std::vector<Variable> leaves;
+      auto outputs = forwardDetached(
+          *module, inputs, params, seed, /* calcGrad = */ true, leaves);
+      if (!outputs[i].isCalcGrad()) {
+        return;
+      }
+      outputs[i].backward(gradOutput);
+      for (size_t j = 0; j < leaves.size(); ++j) {
+        if (leaves[j].isCalcGrad() && leaves[j].isGradAvailable()) {
+          gradInputs[j].addGrad(leaves[j].grad());
+        }
+      }
+    };
+    results.emplace_back(outputs[i].tensor(), gradInputs, gradFunc);
+  }
+  return results;
+}
+
+Variable Checkpoint::forward(const Variable& input) {
+  auto output = forward(std::vector<Variable>{input});
+  if (output.size() != 1) {
+    throw std::invalid_argument(
+        "[Checkpoint::forward] module output size is not 1");
+  }
+  return output.front();
+}
+
+Variable Checkpoint::operator()(const Variable& input) {
+  return forward(input);
+}
+
+std::string Checkpoint::prettyString() const {
+  std::ostringstream ss;
+  ss << "Checkpoint (" << modules_[0]->prettyString() << ")";
+  return ss.str();
+}
+
+} // namespace fl
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/nn/modules/Container.h"
+
+namespace fl {
+
+/**
+ * A `Container` which checkpoints the activations of a module: its forward
+ * pass doesn't retain the module's autograd graph, only its inputs, and the
+ * graph is recomputed when gradients are propagated through it by
+ * `Variable::backward`. This trades compute, about one more forward pass of
+ * the module, for the memory of its intermediate activations, e.g. to train
+ * on longer sequences.
+ *
+ * Random numbers the module draws with `fl::rand` and `fl::randn`, e.g.
+ * dropout masks, are drawn from a `RandomStateScope` seeded on each forward
+ * pass, so that the recomputation draws the same ones. Other side effects of
+ * the module's forward pass, e.g. the running statistics of `BatchNorm`, are
+ * applied again by the recomputation.
+ *
+ * Example:
+ * \code
+   Sequential model;
+   // ...
+   // don't keep the activations of a block between forward and backward
+   model.add(Checkpoint(block));
+ * \endcode
+ */
+class Checkpoint : public Container {
+ private:
+  Checkpoint() = default;
+
+  FL_SAVE_LOAD_WITH_BASE(Container)
+
+ public:
+  /**
+   * Constructs a Checkpoint around a copy of a module. Note that parameters
+   * are still shared, due to Variable's copy semantics.
+   *
+   * @param module the module to checkpoint
+   */
+  template <typename T>
+  explicit Checkpoint(const T& module)
+      : Checkpoint(std::make_shared<T>(module)) {}
+
+  /**
+   * Constructs a Checkpoint around a module.
+   *
+   * @param module the module to checkpoint
+   */
+  explicit Checkpoint(std::shared_ptr<Module> module);
+
+  template <typename T>
+  explicit Checkpoint(std::shared_ptr<T> module)
+      : Checkpoint(std::shared_ptr<Module>(std::move(module))) {}
+
+  std::vector<Variable> forward(const std::vector<Variable>& inputs) override;
+
+  Variable forward(const Variable& input);
+
+  Variable operator()(const Variable& input);
+
+  std::string prettyString() const override;
+};
+
+} // namespace fl
+
+CEREAL_REGISTER_TYPE(fl::Checkpoint)
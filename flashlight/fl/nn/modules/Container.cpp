@@ -21,6 +21,17 @@ std::vector<ModulePtr> Container::modules() const {
   return modules_;
 }
 
+void Container::setModules(const std::vector<ModulePtr>& modules) {
+  // modules may be modules_ itself
+  const auto newModules = modules;
+  modules_.clear();
+  params_.clear();
+  childParamIdx_.clear();
+  for (const auto& module : newModules) {
+    add(module);
+  }
+}
+
 void Container::train() {
   train_ = true;
 
@@ -77,6 +88,7 @@ Sequential::Sequential() = default;
 std::vector<Variable> Sequential::forward(const std::vector<Variable>& input) {
   auto output = input;
   for (auto& module : modules_) {
+    detail::ModuleProfileScope profileScope(*module);
     output = module->forward(output);
   }
   return output;
@@ -85,6 +97,7 @@ std::vector<Variable> Sequential::forward(const std::vector<Variable>& input) {
 Variable Sequential::forward(const Variable& input) {
   std::vector<Variable> output = {input};
   for (auto& module : modules_) {
+    detail::ModuleProfileScope profileScope(*module);
     output = module->forward(output);
   }
   if (output.size() != 1) {
@@ -94,6 +107,7 @@ Variable Sequential::forward(const Variable& input) {
 }
 
 Variable Sequential::operator()(const Variable& input) {
+  detail::ModuleProfileScope profileScope(*this);
   return this->forward(input);
 }
 
@@ -86,6 +86,14 @@ class Container : public Module {
    */
   std::vector<ModulePtr> modules() const;
 
+  /**
+   * Replaces the modules of the `Container`, and its parameters with theirs,
+   * e.g. after modifying or replacing modules.
+   *
+   * @param modules the new modules
+   */
+  void setModules(const std::vector<ModulePtr>& modules);
+
   /**
    * Switches all modules in the `Container` into train mode. See `Module`.
    */
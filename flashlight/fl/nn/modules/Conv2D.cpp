@@ -20,6 +20,16 @@ namespace fl {
 
 using detail::IntOrPadMode;
 
+namespace {
+
+// The shape of the bias of a convolution in a memory format
+Shape biasShape(const int nOut, const MemoryFormat format) {
+  return format == MemoryFormat::CWHN ? Shape({nOut, 1, 1, 1})
+                                      : Shape({1, 1, nOut, 1});
+}
+
+} // namespace
+
 Conv2D::Conv2D(
     int nin,
     int nout,
@@ -105,8 +115,11 @@ Conv2D::Conv2D(
 }
 
 Variable Conv2D::forward(const Variable& input) {
-  auto px = derivePadding(input.dim(0), xFilter_, xStride_, xPad_, xDilation_);
-  auto py = derivePadding(input.dim(1), yFilter_, yStride_, yPad_, yDilation_);
+  const int xAxis = format_ == MemoryFormat::CWHN ? 1 : 0;
+  auto px =
+      derivePadding(input.dim(xAxis), xFilter_, xStride_, xPad_, xDilation_);
+  auto py = derivePadding(
+      input.dim(xAxis + 1), yFilter_, yStride_, yPad_, yDilation_);
   if (!(px >= 0 && py >= 0)) {
     throw std::invalid_argument("invalid padding for Conv2D");
   }
@@ -123,7 +136,8 @@ Variable Conv2D::forward(const Variable& input) {
         xDilation_,
         yDilation_,
         groups_,
-        benchmarks_);
+        benchmarks_,
+        format_);
   } else {
     return conv2d(
         input,
@@ -135,7 +149,8 @@ Variable Conv2D::forward(const Variable& input) {
         xDilation_,
         yDilation_,
         groups_,
-        benchmarks_);
+        benchmarks_,
+        format_);
   }
 }
 
@@ -158,6 +173,72 @@ void Conv2D::initialize() {
   benchmarks_ = std::make_shared<detail::ConvBenchmarks>();
 }
 
+void Conv2D::foldAffine(const Tensor& scale, const Tensor& shift) {
+  if (scale.elements() != nOut_ || shift.elements() != nOut_) {
+    throw std::invalid_argument(
+        "Conv2D::foldAffine: scale and shift must have one value per output "
+        "channel");
+  }
+  const auto& weight = params_[0];
+  auto channelScale =
+      fl::reshape(scale.astype(weight.type()), {1, 1, 1, nOut_});
+  auto foldedWeight = weight.tensor() *
+      fl::tile(channelScale, {weight.dim(0), weight.dim(1), weight.dim(2)});
+  const auto bShape = biasShape(nOut_, format_);
+  auto foldedBias = fl::reshape(shift.astype(weight.type()), bShape);
+  if (bias_) {
+    foldedBias =
+        foldedBias + params_[1].tensor() * fl::reshape(channelScale, bShape);
+  }
+  params_ = {
+      Variable(foldedWeight, weight.isCalcGrad()),
+      Variable(foldedBias, weight.isCalcGrad())};
+  bias_ = true;
+}
+
+void Conv2D::setMemoryFormat(MemoryFormat format) {
+  if (format == format_) {
+    return;
+  }
+  // [W, H, C_in, C_out] <-> [C_in, W, H, C_out]
+  const Shape order =
+      format == MemoryFormat::CWHN ? Shape({2, 0, 1, 3}) : Shape({1, 2, 0, 3});
+  const auto& weight = params_[0];
+  std::vector<Variable> params = {
+      Variable(fl::transpose(weight.tensor(), order), weight.isCalcGrad())};
+  if (bias_) {
+    const auto& bias = params_[1];
+    params.emplace_back(
+        fl::reshape(bias.tensor(), biasShape(nOut_, format)),
+        bias.isCalcGrad());
+  }
+  params_ = std::move(params);
+  format_ = format;
+}
+
+MemoryFormat Conv2D::getMemoryFormat() const {
+  return format_;
+}
+
+Shape Conv2D::outputShape(const Shape& inputShape) const {
+  const bool channelsLast = format_ == MemoryFormat::CWHN;
+  const int xAxis = channelsLast ? 1 : 0;
+  if (inputShape.ndim() < 3) {
+    throw std::invalid_argument(
+        "Conv2D::outputShape - expects an input with at least 3 dimensions");
+  }
+  auto outputSize = [&](int axis, int filter, int stride, int pad, int dil) {
+    const int p = derivePadding(inputShape[axis], filter, stride, pad, dil);
+    return (inputShape[axis] + 2 * p - dil * (filter - 1) - 1) / stride + 1;
+  };
+  Shape output = inputShape;
+  output[xAxis] = outputSize(xAxis, xFilter_, xStride_, xPad_, xDilation_);
+  output[xAxis + 1] =
+      outputSize(xAxis + 1, yFilter_, yStride_, yPad_, yDilation_);
+  output[channelsLast ? 0 : 2] = nOut_;
+  return output;
+}
+
 std::string Conv2D::prettyString() const {
   std::ostringstream ss;
   ss << "Conv2D";
@@ -182,6 +263,9 @@ std::string Conv2D::prettyString() const {
   } else {
     ss << " (without bias)";
   }
+  if (format_ == MemoryFormat::CWHN) {
+    ss << " (channels last)";
+  }
   return ss.str();
 }
 
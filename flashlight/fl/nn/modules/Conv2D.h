@@ -13,6 +13,8 @@
 
 namespace fl {
 
+class FrozenModel;
+
 namespace detail {
 class ConvBenchmarks;
 }
@@ -52,7 +54,10 @@ class Conv2D : public UnaryModule {
       fl::versioned(xDilation_, 1),
       fl::versioned(yDilation_, 1),
       bias_,
-      groups_)
+      groups_,
+      fl::versioned(format_, 2))
+
+  friend class FrozenModel;
 
   void initialize();
 
@@ -65,6 +70,7 @@ class Conv2D : public UnaryModule {
   int xDilation_{1}, yDilation_{1}; // dilation
   bool bias_;
   int groups_;
+  MemoryFormat format_{MemoryFormat::WHCN};
 
  public:
   /**
@@ -176,6 +182,36 @@ class Conv2D : public UnaryModule {
       int dy = 1,
       int groups = 1);
 
+  /**
+   * Folds a per-channel affine transform of the output, `output * scale +
+   * shift`, into the weight and bias, adding a bias if there is none, e.g. to
+   * fold a following `BatchNorm` for inference.
+   *
+   * @param scale a Tensor of size [`nOut`]
+   * @param shift a Tensor of size [`nOut`]
+   */
+  void foldAffine(const Tensor& scale, const Tensor& shift);
+
+  /**
+   * Sets the memory layout of the input and output, permuting the weight and
+   * bias in place. Modules are constructed in the default
+   * `MemoryFormat::WHCN`, whose weight has shape [\f$kerneldim_0\f$,
+   * \f$kerneldim_1\f$, \f$C_{in}\f$, \f$C_{out}\f$]. In the channels-last
+   * `MemoryFormat::CWHN`, the weight has shape [\f$C_{in}\f$,
+   * \f$kerneldim_0\f$, \f$kerneldim_1\f$, \f$C_{out}\f$] and the bias
+   * [\f$C_{out}\f$, \f$1\f$, \f$1\f$, \f$1\f$]. See `fl::setMemoryFormat` to
+   * set the format of all the layers of a model.
+   */
+  void setMemoryFormat(MemoryFormat format);
+
+  MemoryFormat getMemoryFormat() const;
+
+  /**
+   * Computes the shape of the output for an input of a given shape, without
+   * running the module, e.g. to plan the memory of a model.
+   */
+  Shape outputShape(const Shape& inputShape) const;
+
   Variable forward(const Variable& input) override;
 
   std::string prettyString() const override;
@@ -187,4 +223,4 @@ class Conv2D : public UnaryModule {
 } // namespace fl
 
 CEREAL_REGISTER_TYPE(fl::Conv2D)
-CEREAL_CLASS_VERSION(fl::Conv2D, 1)
+CEREAL_CLASS_VERSION(fl::Conv2D, 2)
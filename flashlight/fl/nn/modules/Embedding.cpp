@@ -14,13 +14,21 @@
 
 namespace fl {
 
-Embedding::Embedding(int embeddingDim, int numEmbeddings)
-    : embeddingDim_(embeddingDim), numEmbeddings_(numEmbeddings) {
+Embedding::Embedding(
+    int embeddingDim,
+    int numEmbeddings,
+    bool sparseGrad /* = false */)
+    : embeddingDim_(embeddingDim),
+      numEmbeddings_(numEmbeddings),
+      sparseGrad_(sparseGrad) {
   initialize();
 }
 
-Embedding::Embedding(const Variable& w)
-    : UnaryModule({w}), embeddingDim_(w.dim(0)), numEmbeddings_(w.dim(1)) {}
+Embedding::Embedding(const Variable& w, bool sparseGrad /* = false */)
+    : UnaryModule({w}),
+      embeddingDim_(w.dim(0)),
+      numEmbeddings_(w.dim(1)),
+      sparseGrad_(sparseGrad) {}
 
 void Embedding::initialize() {
   double stdv = std::sqrt(1.0 / (double)embeddingDim_);
@@ -30,13 +38,16 @@ void Embedding::initialize() {
 }
 
 Variable Embedding::forward(const Variable& input) {
-  return embedding(input, params_[0]);
+  return embedding(input, params_[0], sparseGrad_);
 }
 
 std::string Embedding::prettyString() const {
   std::ostringstream ss;
   ss << "Embedding (embeddings: " << numEmbeddings_
      << ") (dim: " << embeddingDim_ << ")";
+  if (sparseGrad_) {
+    ss << " (sparse gradients)";
+  }
   return ss.str();
 }
 
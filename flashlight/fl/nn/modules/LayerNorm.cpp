@@ -56,12 +56,37 @@ Variable LayerNorm::forward(const Variable& _input) {
         std::to_string(kLnExpectedNumDims) + " or fewer dimensions.");
   }
 
+  // normalizing along leading axes is a single op, without reordering
+  const int numAxes = kLnExpectedNumDims - axisComplement_.size();
+  if (numAxes > 0 &&
+      (axisComplement_.empty() || axisComplement_.front() == numAxes)) {
+    Variable weight, bias;
+    if (affine_) {
+      Dim sliceSize = 1;
+      for (int d = 0; d < numAxes; ++d) {
+        sliceSize *= input.dim(d);
+      }
+      if (axisSize_ == kLnVariableAxisSize) {
+        weight = tileAs(params_[0], {sliceSize});
+        bias = tileAs(params_[1], {sliceSize});
+      } else if (sliceSize != axisSize_) {
+        throw std::invalid_argument(
+            "[LayerNorm] Input size along the norm axis doesn't with axisSize.");
+      } else {
+        weight = params_[0];
+        bias = params_[1];
+      }
+    }
+    return moddims(
+        layerNorm(input, weight, bias, numAxes, epsilon_), _input.shape());
+  }
+
   Variable dummyInMean, dummyInVar;
 
   Variable inputToBn = input;
   std::vector<int> inNormAxes;
   // reorder is only required if axisComplement_ is not continuous
-  Shape reorderDims(std::vector<Dim>(input.ndim()));
+  Shape reorderDims(Shape::Dims(input.ndim()));
   auto maxAxis =
       *std::max_element(axisComplement_.begin(), axisComplement_.end());
   auto minAxis =
@@ -84,7 +109,7 @@ Variable LayerNorm::forward(const Variable& _input) {
     inputToBn = reorder(input, reorderDims);
   }
   auto paramsType =
-      (input.type() == fl::dtype::f16) ? fl::dtype::f32 : input.type();
+      isHalfPrecisionType(input.type()) ? fl::dtype::f32 : input.type();
   auto output = batchnorm(
       inputToBn,
       Variable(Tensor(paramsType), false),
@@ -102,7 +127,7 @@ Variable LayerNorm::forward(const Variable& _input) {
       restoreDims.push_back(std::make_pair(reorderDims[i], i));
     }
     std::sort(restoreDims.begin(), restoreDims.end());
-    Shape restoreDimsShape(std::vector<Dim>(restoreDims.size()));
+    Shape restoreDimsShape(Shape::Dims(restoreDims.size()));
     for (size_t i = 0; i < restoreDims.size(); ++i) {
       restoreDimsShape[i] = restoreDims[i].second;
     }
@@ -139,6 +164,17 @@ void LayerNorm::initialize() {
   }
 }
 
+std::vector<int> LayerNorm::getAxis() const {
+  std::vector<int> axis;
+  for (int d = 0; d < kLnExpectedNumDims; ++d) {
+    if (std::find(axisComplement_.begin(), axisComplement_.end(), d) ==
+        axisComplement_.end()) {
+      axis.push_back(d);
+    }
+  }
+  return axis;
+}
+
 std::string LayerNorm::prettyString() const {
   std::ostringstream ss;
   ss << "LayerNorm";
@@ -11,6 +11,8 @@
 
 namespace fl {
 
+class FrozenModel;
+
 constexpr const int kLnExpectedNumDims = 4;
 constexpr const int kLnVariableAxisSize = -1;
 
@@ -71,6 +73,11 @@ class LayerNorm : public UnaryModule {
 
   Variable forward(const Variable& input) override;
 
+  /**
+   * @return the axes along which normalization is computed
+   */
+  std::vector<int> getAxis() const;
+
   std::string prettyString() const override;
 
  private:
@@ -90,6 +97,8 @@ class LayerNorm : public UnaryModule {
       affine_,
       fl::versioned(axisSize_, 1))
 
+  friend class FrozenModel;
+
   void initialize();
 };
 
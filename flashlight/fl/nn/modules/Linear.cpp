@@ -54,6 +54,24 @@ void Linear::initialize() {
   }
 }
 
+void Linear::foldAffine(const Tensor& scale, const Tensor& shift) {
+  if (scale.elements() != nOut_ || shift.elements() != nOut_) {
+    throw std::invalid_argument(
+        "Linear::foldAffine: scale and shift must have one value per output");
+  }
+  const auto& weight = params_[0];
+  auto outputScale = fl::reshape(scale.astype(weight.type()), {nOut_, 1});
+  auto foldedWeight = weight.tensor() * fl::tile(outputScale, {1, nIn_});
+  auto foldedBias = fl::reshape(shift.astype(weight.type()), {nOut_});
+  if (bias_) {
+    foldedBias = foldedBias + params_[1].tensor() * outputScale.flatten();
+  }
+  params_ = {
+      Variable(foldedWeight, weight.isCalcGrad()),
+      Variable(foldedBias, weight.isCalcGrad())};
+  bias_ = true;
+}
+
 std::string Linear::prettyString() const {
   std::ostringstream ss;
   ss << "Linear";
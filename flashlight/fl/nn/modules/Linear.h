@@ -58,6 +58,16 @@ class Linear : public UnaryModule {
    */
   Linear(const Variable& w, const Variable& b);
 
+  /**
+   * Folds a per-channel affine transform of the output, `output * scale +
+   * shift`, into the weight and bias, adding a bias if there is none, e.g. to
+   * fold a following `BatchNorm` for inference.
+   *
+   * @param scale a Tensor of size [`output_size`]
+   * @param shift a Tensor of size [`output_size`]
+   */
+  void foldAffine(const Tensor& scale, const Tensor& shift);
+
   Variable forward(const Variable& input) override;
 
   std::string prettyString() const override;
@@ -7,6 +7,7 @@
 
 #include "flashlight/fl/nn/modules/Loss.h"
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include "flashlight/fl/autograd/Functions.h"
@@ -91,27 +92,193 @@ AdaptiveSoftMaxLoss::AdaptiveSoftMaxLoss(
   params_ = activation_->params();
 }
 
-Variable AdaptiveSoftMaxLoss::cast(
+namespace {
+
+// log(sum(exp(x))) along the first axis of a [C, M] tensor
+Tensor logSumExp(const Tensor& x) {
+  auto maxValues = fl::amax(x, {0}, /* keepDims = */ true);
+  return fl::log(fl::sum(fl::exp(x - fl::tile(maxValues, {x.dim(0)})), {0})) +
+      maxValues.flatten();
+}
+
+// The flat indices of logits(targets[j], j) in a [C, M] tensor
+Tensor targetIndices(const Tensor& targets, Dim C) {
+  const Dim M = targets.elements();
+  return fl::arange({M}, 0, fl::dtype::s64) * C +
+      targets.astype(fl::dtype::s64);
+}
+
+// The gradient of the NLL of softmax(logits) wrt the [C, M] logits, scaled by
+// the gradient of the loss of each column
+Tensor softmaxNllGrad(
+    const Tensor& logits,
+    const Tensor& logSumExps,
+    const Tensor& targets,
+    const Tensor& grad) {
+  const Dim C = logits.dim(0);
+  auto gradRows = fl::tile(fl::reshape(grad, {1, grad.elements()}), {C});
+  auto result =
+      fl::exp(logits - fl::tile(fl::reshape(logSumExps, gradRows.shape()), {C}))
+          .flatten() *
+      gradRows.flatten();
+  auto indices = targetIndices(targets, C);
+  result(indices) = result(indices) - grad;
+  return fl::reshape(result, logits.shape());
+}
+
+/**
+ * The per-token NLL of an adaptive softmax, as a single autograd op over the
+ * input [N, M] and the projections of the clusters: {head, tail0 (2
+ * projections), tail1, ...}. The targets are sorted by cluster once, such that
+ * each tail runs its projections on the contiguous range of its tokens, and
+ * the softmax and NLL are computed from the logits directly. The tail logits
+ * are not kept for backward, where they are recomputed from their hidden
+ * projection.
+ */
+Variable adaptiveSoftMaxNll(
     const Variable& input,
-    const Shape& outDims,
-    const Tensor& indices) {
-  if (input.elements() != indices.elements()) {
-    throw std::invalid_argument("AdaptiveSoftMaxLoss: input, indices mismatch");
+    const Tensor& target,
+    const std::vector<Variable>& params,
+    const std::vector<int>& cutoff,
+    int ignoreIndex) {
+  const Dim M = target.elements();
+  const int numClusters = cutoff.size();
+  const auto computeType = params[0].type();
+  auto x = input.tensor().astype(computeType);
+  auto valid = (target != ignoreIndex).astype(fl::dtype::f32);
+
+  // The cluster of each target, 0 for the head and i + 1 for the tail i.
+  // Ignored targets are in the head, with a null loss.
+  auto cluster = fl::full({M}, 0, fl::dtype::s32);
+  for (int i = 0; i < numClusters - 1; ++i) {
+    cluster = cluster + (target >= cutoff[i]).astype(fl::dtype::s32);
+  }
+  auto validIndex = (target != ignoreIndex).astype(fl::dtype::s32);
+  cluster = cluster * validIndex;
+  auto inHead = (cluster == 0).astype(fl::dtype::s32);
+  auto headTarget =
+      (target * inHead + (cluster + (cutoff[0] - 1)) * (1 - inHead)) *
+      validIndex;
+
+  // A single sort and transfer to find the range of tokens of each cluster
+  auto order = fl::argsort(cluster, 0);
+  auto clusterIds = fl::arange({numClusters, M}, 0, fl::dtype::s32);
+  auto clusterCounts = fl::sum(
+      (clusterIds == fl::tile(fl::reshape(cluster, {1, M}), {numClusters}))
+          .astype(fl::dtype::s32),
+      {1});
+  auto counts = clusterCounts.toHostVector<int>();
+
+  auto headLogits = fl::matmul(params[0].tensor(), x).astype(fl::dtype::f32);
+  auto headLse = logSumExp(headLogits);
+  auto loss = headLse -
+      headLogits.flatten()(targetIndices(headTarget, headLogits.dim(0)));
+
+  std::vector<int> tails;
+  std::vector<Tensor> positions, hiddens, tailTargets, tailLses;
+  int64_t offset = counts[0];
+  for (int i = 0; i < numClusters - 1; ++i) {
+    const int count = counts[i + 1];
+    if (count == 0) {
+      continue;
+    }
+    auto pos = order(fl::range(offset, offset + count));
+    offset += count;
+    auto hidden = fl::matmul(params[1 + i * 2].tensor(), x(fl::span, pos));
+    auto logits = fl::matmul(params[2 + i * 2].tensor(), hidden)
+                      .astype(fl::dtype::f32);
+    auto tailTarget = target(pos) - cutoff[i];
+    auto lse = logSumExp(logits);
+    loss(pos) = loss(pos) + lse -
+        logits.flatten()(targetIndices(tailTarget, logits.dim(0)));
+    tails.push_back(i);
+    positions.push_back(std::move(pos));
+    hiddens.push_back(std::move(hidden));
+    tailTargets.push_back(std::move(tailTarget));
+    tailLses.push_back(std::move(lse));
   }
-  Tensor output = fl::full(outDims, 0, input.type());
-  output(indices) = input.tensor().flatten();
-  auto inputDims = input.shape();
+  loss = loss * valid;
 
-  auto gradFunc = [indices, inputDims](
+  std::vector<Variable> inputs = {input};
+  inputs.insert(inputs.end(), params.begin(), params.end());
+  auto gradFunc = [valid,
+                   headTarget,
+                   headLse,
+                   tails,
+                   positions,
+                   hiddens,
+                   tailTargets,
+                   tailLses](
                       std::vector<Variable>& inputs,
-                      const Variable& grad_output) {
-    Tensor gradTensor = grad_output.tensor()(indices);
-    auto grad = Variable(fl::reshape(gradTensor, inputDims), false);
-    inputs[0].addGrad(grad);
+                      const Variable& gradOutput) {
+    auto grad = gradOutput.tensor().astype(fl::dtype::f32) * valid;
+    const auto& head = inputs[1].tensor();
+    const auto computeType = head.type();
+    auto x = inputs[0].tensor().astype(computeType);
+
+    auto headLogits = fl::matmul(head, x).astype(fl::dtype::f32);
+    auto headGrad = softmaxNllGrad(headLogits, headLse, headTarget, grad)
+                        .astype(computeType);
+    if (inputs[1].isCalcGrad()) {
+      inputs[1].addGrad(Variable(
+          fl::matmul(
+              headGrad, x, MatrixProperty::None, MatrixProperty::Transpose)
+              .astype(inputs[1].type()),
+          false));
+    }
+    auto inputGrad = fl::matmul(
+        head, headGrad, MatrixProperty::Transpose, MatrixProperty::None);
+
+    for (int t = 0; t < tails.size(); ++t) {
+      auto& proj1 = inputs[2 + tails[t] * 2];
+      auto& proj2 = inputs[3 + tails[t] * 2];
+      const auto& pos = positions[t];
+      const auto& hidden = hiddens[t];
+      auto logits = fl::matmul(proj2.tensor(), hidden).astype(fl::dtype::f32);
+      auto logitsGrad =
+          softmaxNllGrad(logits, tailLses[t], tailTargets[t], grad(pos))
+              .astype(computeType);
+      if (proj2.isCalcGrad()) {
+        proj2.addGrad(Variable(
+            fl::matmul(
+                logitsGrad,
+                hidden,
+                MatrixProperty::None,
+                MatrixProperty::Transpose)
+                .astype(proj2.type()),
+            false));
+      }
+      auto hiddenGrad = fl::matmul(
+          proj2.tensor(),
+          logitsGrad,
+          MatrixProperty::Transpose,
+          MatrixProperty::None);
+      if (proj1.isCalcGrad()) {
+        proj1.addGrad(Variable(
+            fl::matmul(
+                hiddenGrad,
+                x(fl::span, pos),
+                MatrixProperty::None,
+                MatrixProperty::Transpose)
+                .astype(proj1.type()),
+            false));
+      }
+      inputGrad(fl::span, pos) = inputGrad(fl::span, pos) +
+          fl::matmul(
+              proj1.tensor(),
+              hiddenGrad,
+              MatrixProperty::Transpose,
+              MatrixProperty::None);
+    }
+    if (inputs[0].isCalcGrad()) {
+      inputs[0].addGrad(Variable(inputGrad.astype(inputs[0].type()), false));
+    }
   };
-  return Variable(output, {input.withoutData()}, gradFunc);
+  return Variable(loss, inputs, gradFunc);
 }
 
+} // namespace
+
 Variable AdaptiveSoftMaxLoss::forward(
     const Variable& inputs,
     const Variable& targets) {
@@ -139,39 +306,17 @@ Variable AdaptiveSoftMaxLoss::forward(
   auto cutoff = activation_->getCutoff();
 
   auto input = moddims(inputs, {N, T * B});
-  auto target = moddims(targets, {T * B});
-
-  auto headOutput = matmul(params_[0], input);
-  auto headTarget = Variable(target.tensor(), false) * (target < cutoff[0]);
-  // TODO: check the type of res
-  auto res = Variable(fl::full({T * B}, 0, fl::dtype::f32), true);
-
-  // Tail forwawrd
-  for (int i = 0; i < cutoff.size() - 1; i++) {
-    auto mask = (target >= cutoff[i]) && (target < cutoff[i + 1]);
-    if (!fl::any(mask.tensor()).scalar<char>()) {
-      continue;
-    }
-
-    auto indicesArray = fl::nonzero(mask.tensor());
-    headTarget =
-        headTarget + (mask * (cutoff[0] + i)).astype(headTarget.type());
-    auto tailTarget = target(indicesArray) - cutoff[i];
-    auto selectedInput = embedding(Variable(indicesArray, false), input);
-    auto tailOutput = matmul(params_[1 + i * 2], selectedInput);
-    tailOutput = matmul(params_[2 + i * 2], tailOutput);
-    auto localLoss = categoricalCrossEntropy(
-        logSoftmax(tailOutput, 0), tailTarget, ReduceMode::NONE, ignoreIndex_);
-    res = res + cast(localLoss, res.shape(), indicesArray);
+  auto target = fl::reshape(targets.tensor(), {T * B}).astype(fl::dtype::s32);
+  if (fl::any(
+          ((target < 0) || (target >= cutoff.back())) &&
+          (target != ignoreIndex_))
+          .scalar<char>()) {
+    throw std::invalid_argument(
+        "AdaptiveSoftMaxLoss::forward - target contains elements out of "
+        "valid range [0, num_classes)");
   }
 
-  // Head forward
-  res = res +
-      categoricalCrossEntropy(
-            logSoftmax(headOutput, 0),
-            headTarget,
-            ReduceMode::NONE,
-            ignoreIndex_);
+  auto res = adaptiveSoftMaxNll(input, target, params_, cutoff, ignoreIndex_);
 
   // Reduce
   if (reduction_ == ReduceMode::NONE) {
@@ -180,7 +325,7 @@ Variable AdaptiveSoftMaxLoss::forward(
   res = sum(res, {0});
   if (reduction_ == ReduceMode::MEAN) {
     auto denominator =
-        fl::countNonzero(target.tensor() != ignoreIndex_).scalar<unsigned>();
+        fl::countNonzero(target != ignoreIndex_).scalar<unsigned>();
     res = res / denominator;
   }
   return res;
@@ -180,9 +180,6 @@ class AdaptiveSoftMaxLoss : public BinaryModule {
   ReduceMode reduction_;
   int ignoreIndex_{-1};
 
-  Variable
-  cast(const Variable& input, const Shape& outDims, const Tensor& indices);
-
  public:
   AdaptiveSoftMaxLoss() = default;
 
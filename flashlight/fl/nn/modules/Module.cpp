@@ -9,7 +9,9 @@
 
 #include "flashlight/fl/nn/modules/Module.h"
 
+#include "flashlight/fl/autograd/SavedMemoryProfile.h"
 #include "flashlight/fl/common/Utils.h"
+#include "flashlight/fl/nn/DryRun.h"
 #include "flashlight/fl/nn/Init.h"
 
 namespace fl {
@@ -58,6 +60,7 @@ std::vector<Variable> Module::params() const {
 }
 
 std::vector<Variable> Module::operator()(const std::vector<Variable>& input) {
+  detail::ModuleProfileScope profileScope(*this);
   return this->forward(input);
 }
 
@@ -75,6 +78,7 @@ std::vector<Variable> UnaryModule::forward(
 }
 
 Variable UnaryModule::operator()(const Variable& input) {
+  detail::ModuleProfileScope profileScope(*this);
   return this->forward(input);
 }
 
@@ -94,7 +98,37 @@ std::vector<Variable> BinaryModule::forward(
 Variable BinaryModule::operator()(
     const Variable& input1,
     const Variable& input2) {
+  detail::ModuleProfileScope profileScope(*this);
   return this->forward(input1, input2);
 }
 
+namespace detail {
+
+ModuleProfileScope::ModuleProfileScope(const Module& module)
+    : savedMemory_(SavedMemoryProfiler::getInstance().isEnabled()),
+      dryRun_(DryRunProfiler::getInstance().isEnabled()) {
+  if (!savedMemory_ && !dryRun_) {
+    return;
+  }
+  auto name = module.prettyString();
+  name = name.substr(0, name.find('\n'));
+  if (savedMemory_) {
+    SavedMemoryProfiler::getInstance().pushModule(name);
+  }
+  if (dryRun_) {
+    DryRunProfiler::getInstance().pushModule(name);
+  }
+}
+
+ModuleProfileScope::~ModuleProfileScope() {
+  if (savedMemory_) {
+    SavedMemoryProfiler::getInstance().popModule();
+  }
+  if (dryRun_) {
+    DryRunProfiler::getInstance().popModule();
+  }
+}
+
+} // namespace detail
+
 } // namespace fl
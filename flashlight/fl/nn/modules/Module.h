@@ -177,6 +177,30 @@ class BinaryModule : public Module {
  private:
   FL_SAVE_LOAD_WITH_BASE(Module)
 };
+
+namespace detail {
+
+/**
+ * An RAII scope which attributes the autograd nodes created during its
+ * lifetime to a module, named by the first line of its `prettyString`, while
+ * a `SavedMemoryProfileScope` is active, and its FLOPs during a `dryRun`.
+ */
+class ModuleProfileScope {
+  const bool savedMemory_;
+  const bool dryRun_;
+
+ public:
+  explicit ModuleProfileScope(const Module& module);
+  ~ModuleProfileScope();
+
+  // no copy/move
+  ModuleProfileScope(const ModuleProfileScope&) = delete;
+  ModuleProfileScope(ModuleProfileScope&&) = delete;
+  ModuleProfileScope& operator=(const ModuleProfileScope&) = delete;
+  ModuleProfileScope& operator=(ModuleProfileScope&&) = delete;
+};
+
+} // namespace detail
 } // namespace fl
 
 CEREAL_REGISTER_TYPE(fl::UnaryModule)
@@ -33,15 +33,41 @@ Pool2D::Pool2D(
       yPad_(py.padVal),
       mode_(mode) {}
 
+void Pool2D::setMemoryFormat(MemoryFormat format) {
+  format_ = format;
+}
+
+MemoryFormat Pool2D::getMemoryFormat() const {
+  return format_;
+}
+
+Shape Pool2D::outputShape(const Shape& inputShape) const {
+  const int xAxis = format_ == MemoryFormat::CWHN ? 1 : 0;
+  if (inputShape.ndim() < xAxis + 2) {
+    throw std::invalid_argument(
+        "Pool2D::outputShape - the input has too few dimensions");
+  }
+  auto outputSize = [&](int axis, int filter, int stride, int pad) {
+    const int p =
+        derivePadding(inputShape[axis], filter, stride, pad, /* dilation= */ 1);
+    return (inputShape[axis] + 2 * p - filter) / stride + 1;
+  };
+  Shape output = inputShape;
+  output[xAxis] = outputSize(xAxis, xFilter_, xStride_, xPad_);
+  output[xAxis + 1] = outputSize(xAxis + 1, yFilter_, yStride_, yPad_);
+  return output;
+}
+
 Variable Pool2D::forward(const Variable& input) {
+  const int xAxis = format_ == MemoryFormat::CWHN ? 1 : 0;
   auto px = derivePadding(
-      input.dim(0),
+      input.dim(xAxis),
       xFilter_,
       xStride_,
       xPad_,
       /* dilation= */ 1);
   auto py = derivePadding(
-      input.dim(1),
+      input.dim(xAxis + 1),
       yFilter_,
       yStride_,
       yPad_,
@@ -51,7 +77,8 @@ Variable Pool2D::forward(const Variable& input) {
     throw std::invalid_argument("invalid padding for Pool2D");
   }
 
-  return pool2d(input, xFilter_, yFilter_, xStride_, yStride_, px, py, mode_);
+  return pool2d(
+      input, xFilter_, yFilter_, xStride_, yStride_, px, py, mode_, format_);
 }
 
 std::string Pool2D::prettyString() const {
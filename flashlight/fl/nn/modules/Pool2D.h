@@ -13,6 +13,8 @@
 
 namespace fl {
 
+class FrozenModel;
+
 /**
  * A 2D pooling layer. This layer expects an input of shape [\f$X_{in}\f$,
  * \f$Y_{in}\f$, \f$C\f$, \f$N\f$]. Pooling (max or average) is performed
@@ -27,6 +29,7 @@ class Pool2D : public UnaryModule {
   int xStride_, yStride_; // stride
   int xPad_, yPad_; // padding - used iff padding mode is none
   PoolingMode mode_; // pooling type
+  MemoryFormat format_{MemoryFormat::WHCN};
 
   FL_SAVE_LOAD_WITH_BASE(
       UnaryModule,
@@ -36,7 +39,10 @@ class Pool2D : public UnaryModule {
       yStride_,
       xPad_,
       yPad_,
-      mode_)
+      mode_,
+      fl::versioned(format_, 1))
+
+  friend class FrozenModel;
 
  public:
   /** Construct a Pool2D layer.
@@ -62,6 +68,21 @@ class Pool2D : public UnaryModule {
       detail::IntOrPadMode py = 0,
       PoolingMode mode = PoolingMode::MAX);
 
+  /**
+   * Sets the memory layout of the input and output, e.g. channels-last
+   * `MemoryFormat::CWHN` images of shape [\f$C\f$, \f$W\f$, \f$H\f$,
+   * \f$N\f$].
+   */
+  void setMemoryFormat(MemoryFormat format);
+
+  MemoryFormat getMemoryFormat() const;
+
+  /**
+   * Computes the shape of the output for an input of a given shape, without
+   * running the module, e.g. to plan the memory of a model.
+   */
+  Shape outputShape(const Shape& inputShape) const;
+
   Variable forward(const Variable& input) override;
 
   std::string prettyString() const override;
@@ -70,3 +91,4 @@ class Pool2D : public UnaryModule {
 } // namespace fl
 
 CEREAL_REGISTER_TYPE(fl::Pool2D)
+CEREAL_CLASS_VERSION(fl::Pool2D, 1)
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/nn/modules/Quantized.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "flashlight/fl/autograd/Functions.h"
+#include "flashlight/fl/autograd/tensor/AutogradExtension.h"
+#include "flashlight/fl/autograd/tensor/AutogradOps.h"
+#include "flashlight/fl/dataset/Dataset.h"
+#include "flashlight/fl/nn/Init.h"
+#include "flashlight/fl/nn/Utils.h"
+#include "flashlight/fl/nn/modules/Container.h"
+#include "flashlight/fl/tensor/Index.h"
+
+namespace fl {
+
+namespace {
+
+constexpr float kInt8Max = 127;
+
+void collectQuantizedModules(
+    Module& module,
+    std::vector<QuantizedModule*>& quantized) {
+  if (auto* quantizedModule = dynamic_cast<QuantizedModule*>(&module)) {
+    quantized.push_back(quantizedModule);
+  }
+  if (auto* container = dynamic_cast<Container*>(&module)) {
+    for (const auto& child : container->modules()) {
+      collectQuantizedModules(*child, quantized);
+    }
+  }
+}
+
+} // namespace
+
+Tensor computeQuantizationScales(const Tensor& weights, int channelAxis) {
+  if (channelAxis < 0 || channelAxis >= weights.ndim()) {
+    throw std::invalid_argument(
+        "[computeQuantizationScales] invalid channel axis");
+  }
+  std::vector<int> axes;
+  for (int i = 0; i < weights.ndim(); ++i) {
+    if (i != channelAxis) {
+      axes.push_back(i);
+    }
+  }
+  auto maxAbs = fl::amax(fl::abs(weights), axes).astype(fl::dtype::f32);
+  return fl::where(maxAbs > 0, maxAbs / kInt8Max, 1.);
+}
+
+QuantizedModule::QuantizedModule(float inputScale) {
+  setInputScale(inputScale);
+}
+
+void QuantizedModule::setCalibrating(bool calibrating) {
+  if (calibrating && !calibrating_) {
+    calibrationMax_ = 0;
+  } else if (!calibrating && calibrating_) {
+    inputScale_ = calibrationMax_ > 0 ? calibrationMax_ / kInt8Max : 1;
+  }
+  calibrating_ = calibrating;
+}
+
+bool QuantizedModule::isCalibrating() const {
+  return calibrating_;
+}
+
+float QuantizedModule::inputScale() const {
+  return inputScale_;
+}
+
+void QuantizedModule::setInputScale(float inputScale) {
+  if (inputScale < 0) {
+    throw std::invalid_argument(
+        "[QuantizedModule::setInputScale] the input scale can't be negative");
+  }
+  inputScale_ = inputScale;
+}
+
+void QuantizedModule::observe(const Tensor& input, const std::string& caller) {
+  if (calibrating_) {
+    calibrationMax_ = std::max(
+        calibrationMax_, fl::amax(fl::abs(input)).asScalar<float>());
+  } else if (inputScale_ == 0) {
+    throw std::runtime_error(
+        "[" + caller +
+        "] the input scale must be set or calibrated before use, see "
+        "fl::calibrateQuantization");
+  }
+}
+
+QuantizedLinear::QuantizedLinear(const Linear& linear, float inputScale)
+    : UnaryModule(linear.params()),
+      QuantizedModule(inputScale),
+      bias_(linear.params().size() > 1) {}
+
+void QuantizedLinear::setParams(const Variable& var, int position) {
+  UnaryModule::setParams(var, position);
+  weightScales_ = Tensor();
+  payload_.reset();
+}
+
+Variable QuantizedLinear::forward(const Variable& input) {
+  observe(input.tensor(), "QuantizedLinear::forward");
+  if (calibrating_) {
+    if (bias_) {
+      return linear(
+          input,
+          params_[0].astype(input.type()),
+          params_[1].astype(input.type()));
+    }
+    return linear(input, params_[0].astype(input.type()));
+  }
+
+  if (weightScales_.isEmpty()) {
+    weightScales_ = computeQuantizationScales(params_[0].tensor(), 0);
+    payload_ = std::make_shared<detail::AutogradPayload>();
+  }
+  auto bias = bias_ ? params_[1].tensor() : Tensor(fl::dtype::f32);
+  return Variable(
+      detail::quantizedLinear(
+          input.tensor().astype(fl::dtype::f32),
+          params_[0].tensor(),
+          weightScales_,
+          bias,
+          inputScale_,
+          payload_),
+      /* calcGrad = */ false);
+}
+
+std::string QuantizedLinear::prettyString() const {
+  std::ostringstream ss;
+  ss << "QuantizedLinear";
+  ss << " (" << params_[0].dim(1) << "->" << params_[0].dim(0) << ")";
+  if (bias_) {
+    ss << " (with bias)";
+  } else {
+    ss << " (without bias)";
+  }
+  ss << " (input scale " << inputScale_ << ")";
+  return ss.str();
+}
+
+QuantizedConv2D::QuantizedConv2D(const Conv2D& conv, float inputScale)
+    : Conv2D(conv), QuantizedModule(inputScale) {}
+
+void QuantizedConv2D::setParams(const Variable& var, int position) {
+  Conv2D::setParams(var, position);
+  weightScales_ = Tensor();
+  payload_.reset();
+}
+
+Variable QuantizedConv2D::forward(const Variable& input) {
+  observe(input.tensor(), "QuantizedConv2D::forward");
+  auto px = derivePadding(input.dim(0), xFilter_, xStride_, xPad_, xDilation_);
+  auto py = derivePadding(input.dim(1), yFilter_, yStride_, yPad_, yDilation_);
+  if (!(px >= 0 && py >= 0)) {
+    throw std::invalid_argument("invalid padding for QuantizedConv2D");
+  }
+  return convolve(input, px, py);
+}
+
+Variable QuantizedConv2D::convolve(const Variable& input, int px, int py) {
+  if (calibrating_) {
+    if (bias_) {
+      return conv2d(
+          input,
+          params_[0].astype(input.type()),
+          params_[1].astype(input.type()),
+          xStride_,
+          yStride_,
+          px,
+          py,
+          xDilation_,
+          yDilation_,
+          groups_,
+          benchmarks_,
+          format_);
+    }
+    return conv2d(
+        input,
+        params_[0].astype(input.type()),
+        xStride_,
+        yStride_,
+        px,
+        py,
+        xDilation_,
+        yDilation_,
+        groups_,
+        benchmarks_,
+        format_);
+  }
+
+  if (weightScales_.isEmpty()) {
+    weightScales_ = computeQuantizationScales(params_[0].tensor(), 3);
+    payload_ = std::make_shared<detail::AutogradPayload>();
+  }
+  auto bias = bias_ ? params_[1].tensor() : Tensor(fl::dtype::f32);
+  return Variable(
+      detail::quantizedConv2d(
+          input.tensor().astype(fl::dtype::f32),
+          params_[0].tensor(),
+          weightScales_,
+          bias,
+          inputScale_,
+          xStride_,
+          yStride_,
+          px,
+          py,
+          xDilation_,
+          yDilation_,
+          groups_,
+          payload_),
+      /* calcGrad = */ false);
+}
+
+std::string QuantizedConv2D::prettyString() const {
+  std::ostringstream ss;
+  ss << "Quantized" << Conv2D::prettyString();
+  ss << " (input scale " << inputScale_ << ")";
+  return ss.str();
+}
+
+QuantizedAdaptiveSoftMax::QuantizedAdaptiveSoftMax(
+    const AdaptiveSoftMax& adaptiveSoftMax)
+    : cutoff_(adaptiveSoftMax.getCutoff()) {
+  // the head, then the two projections of each tail bucket
+  for (const auto& weight : adaptiveSoftMax.params()) {
+    add(QuantizedLinear(Linear(Variable(weight.tensor(), false))));
+  }
+}
+
+Variable QuantizedAdaptiveSoftMax::forward(const Variable& input) {
+  // input -- [C_in, .. , N]
+  // return -- [C_out, .. , N]
+  const auto inputSize = input.dim(0);
+  auto inputs = moddims(input, {inputSize, -1});
+  auto headOutput = logSoftmax(modules_[0]->forward({inputs})[0], 0);
+
+  std::vector<Variable> outputs = {headOutput(fl::range(0, cutoff_[0]))};
+  for (int i = 0; i < cutoff_.size() - 1; ++i) {
+    auto tailOutput = modules_[1 + i * 2]->forward({inputs})[0];
+    tailOutput = modules_[2 + i * 2]->forward({tailOutput})[0];
+    auto idx = i + cutoff_[0];
+    outputs.push_back(
+        logSoftmax(tailOutput, 0) +
+        tileAs(headOutput(fl::range(idx, idx + 1)), tailOutput));
+  }
+  auto output = concatenate(outputs, 0);
+
+  Shape outDims = input.shape();
+  outDims[0] = output.dim(0);
+  return moddims(output, outDims);
+}
+
+std::vector<Variable> QuantizedAdaptiveSoftMax::forward(
+    const std::vector<Variable>& inputs) {
+  if (inputs.size() != 1) {
+    throw std::invalid_argument(
+        "[QuantizedAdaptiveSoftMax::forward] expects a single input");
+  }
+  return {forward(inputs[0])};
+}
+
+std::string QuantizedAdaptiveSoftMax::prettyString() const {
+  std::ostringstream ss;
+  ss << "QuantizedAdaptiveSoftMax (cutoff";
+  for (const auto c : cutoff_) {
+    ss << " " << c;
+  }
+  ss << ")";
+  return ss.str();
+}
+
+void calibrateQuantization(
+    Module& model,
+    const Dataset& dataset,
+    int64_t numSamples,
+    int inputIdx) {
+  std::vector<QuantizedModule*> quantized;
+  collectQuantizedModules(model, quantized);
+  if (quantized.empty()) {
+    throw std::invalid_argument(
+        "[calibrateQuantization] the model has no quantized modules");
+  }
+  if (numSamples < 0 || numSamples > dataset.size()) {
+    numSamples = dataset.size();
+  }
+
+  model.eval();
+  for (auto* module : quantized) {
+    module->setCalibrating(true);
+  }
+  for (int64_t i = 0; i < numSamples; ++i) {
+    auto sample = dataset.get(i);
+    if (inputIdx < 0 || inputIdx >= static_cast<int>(sample.size())) {
+      throw std::out_of_range(
+          "[calibrateQuantization] invalid input index for sample " +
+          std::to_string(i));
+    }
+    model.forward({noGrad(sample[inputIdx])});
+  }
+  for (auto* module : quantized) {
+    module->setCalibrating(false);
+  }
+}
+
+} // namespace fl
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flashlight/fl/nn/modules/AdaptiveSoftMax.h"
+#include "flashlight/fl/nn/modules/Container.h"
+#include "flashlight/fl/nn/modules/Conv2D.h"
+#include "flashlight/fl/nn/modules/Linear.h"
+#include "flashlight/fl/nn/modules/Module.h"
+
+namespace fl {
+
+class Dataset;
+
+namespace detail {
+struct AutogradPayload;
+}
+
+/**
+ * Computes the scales that quantize weights symmetrically to int8 with a scale
+ * per output channel, i.e. the largest absolute value of each channel divided
+ * by 127. Channels which are all zero have a scale of 1.
+ *
+ * @param weights the weights to quantize
+ * @param channelAxis the axis of `weights` indexing output channels
+ * @return a float32 Tensor with shape [`weights.dim(channelAxis)`]
+ */
+Tensor computeQuantizationScales(const Tensor& weights, int channelAxis);
+
+/**
+ * The state shared by modules computing in int8 for inference: the scale of
+ * their inputs, which is calibrated on representative inputs, see
+ * `calibrateQuantization`.
+ */
+class QuantizedModule {
+ public:
+  virtual ~QuantizedModule() = default;
+
+  /**
+   * Starts or stops calibrating the input scale. While calibrating,
+   * `forward` computes in float32 and records the largest absolute value of
+   * the inputs, from which the input scale is set once calibration stops.
+   */
+  void setCalibrating(bool calibrating);
+
+  bool isCalibrating() const;
+
+  /**
+   * @return the scale of the inputs, or 0 if not calibrated yet.
+   */
+  float inputScale() const;
+
+  void setInputScale(float inputScale);
+
+ protected:
+  QuantizedModule() = default;
+  explicit QuantizedModule(float inputScale);
+
+  // Checks the input scale is set if not calibrating, and records the range
+  // of `input` if calibrating.
+  void observe(const Tensor& input, const std::string& caller);
+
+  float inputScale_{0};
+  bool calibrating_{false};
+  float calibrationMax_{0};
+  // the quantized weights and their scales, computed on first use
+  Tensor weightScales_;
+  std::shared_ptr<detail::AutogradPayload> payload_;
+};
+
+/**
+ * An int8 version of `Linear` for inference on the OneDNN autograd backend.
+ * The weights are quantized with a scale per output channel, and inputs with
+ * the calibrated `inputScale()`. The output is dequantized to float32,
+ * including the bias, so that quantized layers compose with other ones.
+ *
+ * Example:
+ * \code
+   Sequential model;
+   // ... train a model with a Linear layer, then replace it
+   model.add(QuantizedLinear(linear));
+   calibrateQuantization(model, calibrationData);
+   auto output = model(input); // in int8
+ * \endcode
+ */
+class QuantizedLinear : public UnaryModule, public QuantizedModule {
+ private:
+  QuantizedLinear() = default; // Intentionally private
+
+  bool bias_;
+
+  FL_SAVE_LOAD_WITH_BASE(UnaryModule, bias_, inputScale_)
+
+ public:
+  /**
+   * Constructs a QuantizedLinear module from the parameters of a `Linear`
+   * one.
+   *
+   * @param linear the module to quantize
+   * @param inputScale the scale of the inputs, if known. Otherwise, the
+   *  module must be calibrated before use, see `calibrateQuantization`
+   */
+  explicit QuantizedLinear(const Linear& linear, float inputScale = 0);
+
+  void setParams(const Variable& var, int position) override;
+
+  Variable forward(const Variable& input) override;
+
+  std::string prettyString() const override;
+};
+
+/**
+ * An int8 version of `Conv2D` for inference on the OneDNN autograd backend.
+ * The weights are quantized with a scale per output channel, and inputs with
+ * the calibrated `inputScale()`. The output is dequantized to float32. See
+ * `QuantizedLinear`.
+ */
+class QuantizedConv2D : public Conv2D, public QuantizedModule {
+ private:
+  FL_SAVE_LOAD_WITH_BASE(Conv2D, inputScale_)
+
+ protected:
+  QuantizedConv2D() = default;
+
+  // Convolves `input` with the given padding, in float32 while calibrating
+  Variable convolve(const Variable& input, int px, int py);
+
+ public:
+  /**
+   * Constructs a QuantizedConv2D module from a `Conv2D` one.
+   *
+   * @param conv the module to quantize
+   * @param inputScale the scale of the inputs, if known. Otherwise, the
+   *  module must be calibrated before use, see `calibrateQuantization`
+   */
+  explicit QuantizedConv2D(const Conv2D& conv, float inputScale = 0);
+
+  void setParams(const Variable& var, int position) override;
+
+  Variable forward(const Variable& input) override;
+
+  std::string prettyString() const override;
+};
+
+/**
+ * An int8 version of `AdaptiveSoftMax` for inference on the OneDNN autograd
+ * backend, whose head and tail projections are `QuantizedLinear` modules,
+ * calibrated along with the other quantized modules of a model. The
+ * log-softmaxes are computed in float32.
+ */
+class QuantizedAdaptiveSoftMax : public Container {
+ private:
+  QuantizedAdaptiveSoftMax() = default; // Intentionally private
+
+  std::vector<int> cutoff_;
+
+  FL_SAVE_LOAD_WITH_BASE(Container, cutoff_)
+
+ public:
+  /**
+   * Constructs a QuantizedAdaptiveSoftMax module from an `AdaptiveSoftMax`
+   * one, which must be calibrated before use, see `calibrateQuantization`.
+   *
+   * @param adaptiveSoftMax the module to quantize
+   */
+  explicit QuantizedAdaptiveSoftMax(const AdaptiveSoftMax& adaptiveSoftMax);
+
+  /**
+   * Computes log-probabilities across all classes, as
+   * `AdaptiveSoftMax::forward`.
+   */
+  Variable forward(const Variable& input);
+
+  std::vector<Variable> forward(const std::vector<Variable>& inputs) override;
+
+  std::string prettyString() const override;
+};
+
+/**
+ * Calibrates the input scales of the quantized modules in `model`, including
+ * those nested in containers, by running it in eval mode on samples of
+ * `dataset`, which is left in eval mode. The scale of each module's input is
+ * set from the largest absolute value it received.
+ *
+ * @param model the model to calibrate
+ * @param dataset samples (or batches) representative of the model's inputs
+ * @param numSamples the number of samples to use, or -1 for all of them
+ * @param inputIdx the index of the model's input in each sample
+ */
+void calibrateQuantization(
+    Module& model,
+    const Dataset& dataset,
+    int64_t numSamples = -1,
+    int inputIdx = 0);
+
+} // namespace fl
+
+CEREAL_REGISTER_TYPE(fl::QuantizedLinear)
+CEREAL_REGISTER_TYPE(fl::QuantizedConv2D)
+CEREAL_REGISTER_TYPE(fl::QuantizedAdaptiveSoftMax)
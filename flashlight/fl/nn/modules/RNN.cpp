@@ -41,6 +41,42 @@ void RNN::initialize() {
   params_ = {w};
 }
 
+std::tuple<Variable, Variable, Variable> RNN::forwardImpl(
+    const Variable& input,
+    const Variable& hiddenState,
+    const Variable& cellState,
+    const std::vector<int>& sequenceLengths) {
+  float dropProb = train_ ? dropProb_ : 0.0;
+  // the weights are only cast if needed, such that backends can identify them
+  // across calls, e.g. to reuse their prepacked layout
+  const auto& weights = params_[0].type() == input.type()
+      ? params_[0]
+      : params_[0].astype(input.type());
+  if (sequenceLengths.empty()) {
+    return rnn(
+        input,
+        hiddenState.astype(input.type()),
+        cellState.astype(input.type()),
+        weights,
+        hiddenSize_,
+        numLayers_,
+        mode_,
+        bidirectional_,
+        dropProb);
+  }
+  return rnn(
+      input,
+      hiddenState.astype(input.type()),
+      cellState.astype(input.type()),
+      weights,
+      sequenceLengths,
+      hiddenSize_,
+      numLayers_,
+      mode_,
+      bidirectional_,
+      dropProb);
+}
+
 std::vector<Variable> RNN::forward(const std::vector<Variable>& inputs) {
   if (inputs.size() < 1 || inputs.size() > 3) {
     throw std::invalid_argument("Invalid inputs size");
@@ -50,17 +86,7 @@ std::vector<Variable> RNN::forward(const std::vector<Variable>& inputs) {
   const auto& hiddenState = inputs.size() >= 2 ? inputs[1] : Variable();
   const auto& cellState = inputs.size() == 3 ? inputs[2] : Variable();
 
-  float dropProb = train_ ? dropProb_ : 0.0;
-  auto rnnRes =
-      rnn(input,
-          hiddenState.astype(input.type()),
-          cellState.astype(input.type()),
-          params_[0].astype(input.type()),
-          hiddenSize_,
-          numLayers_,
-          mode_,
-          bidirectional_,
-          dropProb);
+  auto rnnRes = forwardImpl(input, hiddenState, cellState, {});
 
   std::vector<Variable> output(1, std::get<0>(rnnRes));
   if (inputs.size() >= 2) {
@@ -108,6 +134,14 @@ std::tuple<Variable, Variable, Variable> RNN::operator()(
   return forward(input, hidden_state, cell_state);
 }
 
+std::tuple<Variable, Variable, Variable> RNN::forward(
+    const Variable& input,
+    const Variable& hidden_state,
+    const Variable& cell_state,
+    const std::vector<int>& sequence_lengths) {
+  return forwardImpl(input, hidden_state, cell_state, sequence_lengths);
+}
+
 std::string RNN::prettyString() const {
   std::ostringstream ss;
   switch (mode_) {
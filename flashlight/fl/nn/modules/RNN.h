@@ -62,6 +62,12 @@ class RNN : public Module {
 
   void initialize();
 
+  std::tuple<Variable, Variable, Variable> forwardImpl(
+      const Variable& input,
+      const Variable& hiddenState,
+      const Variable& cellState,
+      const std::vector<int>& sequenceLengths);
+
  public:
   /** Construct an RNN layer.
    * @param input_size The dimension of the input (e.g. \f$X_{in}\f$)
@@ -139,6 +145,25 @@ class RNN : public Module {
       const Variable& hidden_state,
       const Variable& cell_state);
 
+  /** Forward the RNN Layer over sequences of different lengths, see the
+   * `fl::rnn` overload with sequence lengths.
+   * @param input Should be of shape [\f$X_{in}\f$, \f$N\f$, \f$T\f$], with
+   * the samples padded to \f$T\f$ steps
+   * @param hidden_state Should be of shape [\f$X_{out}\f$, \f$N\f$], or
+   * empty
+   * @param cell_state Should be of shape [\f$X_{out}\f$, \f$N\f$], or empty
+   * @param sequence_lengths The number of steps of each of the \f$N\f$
+   * samples, in [1, \f$T\f$]
+   * @returns An tuple of output Variables, as with the overload without
+   * lengths. The output past the length of each sample is zero, and the
+   * states are those after its last step.
+   */
+  std::tuple<Variable, Variable, Variable> forward(
+      const Variable& input,
+      const Variable& hidden_state,
+      const Variable& cell_state,
+      const std::vector<int>& sequence_lengths);
+
   std::string prettyString() const override;
 };
 
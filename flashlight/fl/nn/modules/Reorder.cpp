@@ -17,6 +17,19 @@ namespace fl {
 
 Reorder::Reorder(Shape shape) : shape_(std::move(shape)) {}
 
+Shape Reorder::outputShape(const Shape& inputShape) const {
+  if (inputShape.ndim() != shape_.ndim()) {
+    throw std::invalid_argument(
+        "Reorder::outputShape - input shape has different "
+        "number of dimensions than reorder shape.");
+  }
+  Shape output = inputShape;
+  for (int i = 0; i < shape_.ndim(); ++i) {
+    output[i] = inputShape[shape_[i]];
+  }
+  return output;
+}
+
 Variable Reorder::forward(const Variable& input) {
   if (input.ndim() != shape_.ndim()) {
     throw std::invalid_argument(
@@ -42,6 +42,12 @@ class Reorder : public UnaryModule {
    */
   explicit Reorder(Shape shape);
 
+  /**
+   * Computes the shape of the output for an input of a given shape, without
+   * running the module.
+   */
+  Shape outputShape(const Shape& inputShape) const;
+
   Variable forward(const Variable& input) override;
 
   std::string prettyString() const override;
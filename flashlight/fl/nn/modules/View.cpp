@@ -7,6 +7,8 @@
 
 #include "flashlight/fl/nn/modules/View.h"
 
+#include <stdexcept>
+#include <string>
 #include <utility>
 
 #include "flashlight/fl/autograd/Functions.h"
@@ -17,6 +19,37 @@ namespace fl {
 
 View::View(Shape dims) : dims_(std::move(dims)) {}
 
+Shape View::outputShape(const Shape& inputShape) const {
+  // as moddims: 0 keeps the input's dimension, and -1 is inferred
+  Shape output = dims_;
+  int inferAxis = -1;
+  for (int i = 0; i < output.ndim(); ++i) {
+    if (output[i] == 0) {
+      if (i >= inputShape.ndim()) {
+        throw std::invalid_argument(
+            "View::outputShape - tried to infer dimension " +
+            std::to_string(i) + " which exceeds the input's dimensions");
+      }
+      output[i] = inputShape[i];
+    } else if (output[i] == -1) {
+      if (inferAxis >= 0) {
+        throw std::invalid_argument(
+            "View::outputShape - too many dimensions to infer");
+      }
+      inferAxis = i;
+    }
+  }
+  if (inferAxis >= 0) {
+    output[inferAxis] = 1;
+    output[inferAxis] = inputShape.elements() / output.elements();
+  }
+  if (output.elements() != inputShape.elements()) {
+    throw std::invalid_argument(
+        "View::outputShape - mismatched number of elements");
+  }
+  return output;
+}
+
 Variable View::forward(const Variable& input) {
   Shape dims = dims_;
   return moddims(input, dims);
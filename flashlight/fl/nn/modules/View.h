@@ -12,6 +12,8 @@
 
 namespace fl {
 
+class FrozenModel;
+
 /**
  * Modifies the dimensions of a `Variable` and rearranges its elements without
  * modifying the order of elements in the underlying `Tensor`. When
@@ -32,6 +34,8 @@ class View : public UnaryModule {
 
   FL_SAVE_LOAD_WITH_BASE(UnaryModule, dims_)
 
+  friend class FrozenModel;
+
  public:
   /**
    * Creates a `View` with the given dimensions.
@@ -40,6 +44,12 @@ class View : public UnaryModule {
    */
   explicit View(Shape dims);
 
+  /**
+   * Computes the shape of the output for an input of a given shape, without
+   * running the module.
+   */
+  Shape outputShape(const Shape& inputShape) const;
+
   Variable forward(const Variable& input) override;
 
   std::string prettyString() const override;
@@ -11,6 +11,7 @@
 #include "flashlight/fl/nn/modules/Activations.h"
 #include "flashlight/fl/nn/modules/AdaptiveSoftMax.h"
 #include "flashlight/fl/nn/modules/BatchNorm.h"
+#include "flashlight/fl/nn/modules/Checkpoint.h"
 #include "flashlight/fl/nn/modules/Container.h"
 #include "flashlight/fl/nn/modules/Conv2D.h"
 #include "flashlight/fl/nn/modules/Dropout.h"
@@ -24,6 +25,7 @@
 #include "flashlight/fl/nn/modules/Padding.h"
 #include "flashlight/fl/nn/modules/Pool2D.h"
 #include "flashlight/fl/nn/modules/PrecisionCast.h"
+#include "flashlight/fl/nn/modules/Quantized.h"
 #include "flashlight/fl/nn/modules/RNN.h"
 #include "flashlight/fl/nn/modules/Reorder.h"
 #include "flashlight/fl/nn/modules/Transform.h"
@@ -8,6 +8,9 @@
 #pragma once
 
 #include "flashlight/fl/nn/DistributedUtils.h"
+#include "flashlight/fl/nn/DryRun.h"
+#include "flashlight/fl/nn/FrozenModel.h"
 #include "flashlight/fl/nn/Init.h"
+#include "flashlight/fl/nn/PipelineParallel.h"
 #include "flashlight/fl/nn/Utils.h"
 #include "flashlight/fl/nn/modules/modules.h"
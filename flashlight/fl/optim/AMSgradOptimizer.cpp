@@ -9,6 +9,7 @@
 
 #include <cmath>
 
+#include "flashlight/fl/optim/Utils.h"
 #include "flashlight/fl/tensor/Compute.h"
 
 using std::vector;
@@ -35,9 +36,10 @@ AMSgradOptimizer::AMSgradOptimizer(
   maxExpAvgSq_.reserve(parameters.size());
 
   for (const auto& parameter : parameters_) {
-    biasedFirst_.emplace_back(fl::full(parameter.shape(), 0, parameter.type()));
-    biasedSecond_.emplace_back(fl::full(parameter.shape(), 0, parameter.type()));
-    maxExpAvgSq_.emplace_back(fl::full(parameter.shape(), 0, parameter.type()));
+    const auto stateType = detail::getOptimizerStateType(parameter.type());
+    biasedFirst_.emplace_back(fl::full(parameter.shape(), 0, stateType));
+    biasedSecond_.emplace_back(fl::full(parameter.shape(), 0, stateType));
+    maxExpAvgSq_.emplace_back(fl::full(parameter.shape(), 0, stateType));
 
     fl::eval(biasedFirst_.back());
     fl::eval(biasedSecond_.back());
@@ -46,8 +48,16 @@ AMSgradOptimizer::AMSgradOptimizer(
 }
 
 void AMSgradOptimizer::step() {
+  std::vector<bool> grouped(parameters_.size(), false);
+  if (multiTensor_) {
+    for (const auto& group :
+         detail::getMultiTensorGroups(parameters_, grouped)) {
+      multiTensorStep(group);
+    }
+  }
+
   for (size_t i = 0; i < parameters_.size(); i++) {
-    if (!parameters_[i].isGradAvailable()) {
+    if (!parameters_[i].isGradAvailable() || grouped[i]) {
       continue;
     }
 
@@ -69,8 +79,40 @@ void AMSgradOptimizer::step() {
     fl::eval(biasedSecond);
     fl::eval(maxExpAvgSq);
 
-    data = data - (lr_ * biasedFirst) / (fl::sqrt(maxExpAvgSq) + eps_);
+    data = data -
+        detail::toParamType(
+            (lr_ * biasedFirst) / (fl::sqrt(maxExpAvgSq) + eps_),
+            data.type());
+
+    fl::eval(data);
+  }
+}
 
+void AMSgradOptimizer::multiTensorStep(const detail::MultiTensorGroup& group) {
+  const auto grad = group.grads(parameters_);
+  Tensor& biasedFirst = flatFirst_.get(group, biasedFirst_);
+  Tensor& biasedSecond = flatSecond_.get(group, biasedSecond_);
+  Tensor& maxExpAvgSq = flatMaxExpAvgSq_.get(group, maxExpAvgSq_);
+
+  biasedFirst = beta1_ * biasedFirst + (1 - beta1_) * grad;
+  biasedSecond = beta2_ * biasedSecond + (1 - beta2_) * grad * grad;
+  maxExpAvgSq = fl::maximum(maxExpAvgSq, biasedSecond);
+  fl::eval(biasedFirst);
+  fl::eval(biasedSecond);
+  fl::eval(maxExpAvgSq);
+  flatFirst_.scatter(group, biasedFirst_);
+  flatSecond_.scatter(group, biasedSecond_);
+  flatMaxExpAvgSq_.scatter(group, maxExpAvgSq_);
+
+  auto update = (lr_ * biasedFirst) / (fl::sqrt(maxExpAvgSq) + eps_);
+  fl::eval(update);
+
+  for (size_t j = 0; j < group.indices().size(); ++j) {
+    Tensor& data = parameters_[group.indices()[j]].tensor();
+    if (wd_ != 0) {
+      data = data - wd_ * data;
+    }
+    data = data - detail::toParamType(group.slice(update, j), data.type());
     fl::eval(data);
   }
 }
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/optim/MultiTensor.h"
 #include "flashlight/fl/optim/Optimizers.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
@@ -41,6 +42,11 @@ class AMSgradOptimizer : public FirstOrderOptimizer {
   std::vector<Tensor> biasedFirst_;
   std::vector<Tensor> biasedSecond_;
   std::vector<Tensor> maxExpAvgSq_;
+  detail::MultiTensorState flatFirst_;
+  detail::MultiTensorState flatSecond_;
+  detail::MultiTensorState flatMaxExpAvgSq_;
+
+  void multiTensorStep(const detail::MultiTensorGroup& group);
 
  public:
   /** Construct an AMSgrad optimizer
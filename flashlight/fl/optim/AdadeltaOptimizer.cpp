@@ -9,6 +9,7 @@
 
 #include <cmath>
 
+#include "flashlight/fl/optim/Utils.h"
 #include "flashlight/fl/tensor/Compute.h"
 
 namespace fl {
@@ -29,8 +30,9 @@ AdadeltaOptimizer::AdadeltaOptimizer(
   accDelta_.reserve(parameters.size());
 
   for (const auto& parameter : parameters_) {
-    accGrad_.emplace_back(fl::full(parameter.shape(), 0, parameter.type()));
-    accDelta_.emplace_back(fl::full(parameter.shape(), 0, parameter.type()));
+    const auto stateType = detail::getOptimizerStateType(parameter.type());
+    accGrad_.emplace_back(fl::full(parameter.shape(), 0, stateType));
+    accDelta_.emplace_back(fl::full(parameter.shape(), 0, stateType));
 
     fl::eval(accGrad_.back());
     fl::eval(accDelta_.back());
@@ -38,8 +40,16 @@ AdadeltaOptimizer::AdadeltaOptimizer(
 }
 
 void AdadeltaOptimizer::step() {
+  std::vector<bool> grouped(parameters_.size(), false);
+  if (multiTensor_) {
+    for (const auto& group :
+         detail::getMultiTensorGroups(parameters_, grouped)) {
+      multiTensorStep(group);
+    }
+  }
+
   for (size_t i = 0; i < parameters_.size(); i++) {
-    if (!parameters_[i].isGradAvailable()) {
+    if (!parameters_[i].isGradAvailable() || grouped[i]) {
       continue;
     }
 
@@ -59,7 +69,7 @@ void AdadeltaOptimizer::step() {
 
     auto delta = fl::sqrt(accDelta + eps_) / fl::sqrt(accGrad + eps_) * grad;
 
-    data = data - lr_ * delta;
+    data = data - detail::toParamType(lr_ * delta, data.type());
     fl::eval(data);
 
     accDelta = rho_ * accDelta + (1 - rho_) * delta * delta;
@@ -67,6 +77,35 @@ void AdadeltaOptimizer::step() {
   }
 }
 
+void AdadeltaOptimizer::multiTensorStep(
+    const detail::MultiTensorGroup& group) {
+  const auto grad = group.grads(parameters_);
+  Tensor& accGrad = flatAccGrad_.get(group, accGrad_);
+  Tensor& accDelta = flatAccDelta_.get(group, accDelta_);
+
+  accGrad = rho_ * accGrad + (1 - rho_) * grad * grad;
+  fl::eval(accGrad);
+
+  auto delta = fl::sqrt(accDelta + eps_) / fl::sqrt(accGrad + eps_) * grad;
+  fl::eval(delta);
+
+  for (size_t j = 0; j < group.indices().size(); ++j) {
+    Tensor& data = parameters_[group.indices()[j]].tensor();
+    if (wd_ != 0) {
+      // Weight decay term
+      data = data - wd_ * data;
+    }
+    data = data -
+        detail::toParamType(lr_ * group.slice(delta, j), data.type());
+    fl::eval(data);
+  }
+
+  accDelta = rho_ * accDelta + (1 - rho_) * delta * delta;
+  fl::eval(accDelta);
+  flatAccGrad_.scatter(group, accGrad_);
+  flatAccDelta_.scatter(group, accDelta_);
+}
+
 std::string AdadeltaOptimizer::prettyString() const {
   std::ostringstream ss;
   ss << "Adadelta";
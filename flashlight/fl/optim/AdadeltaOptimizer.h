@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/optim/MultiTensor.h"
 #include "flashlight/fl/optim/Optimizers.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
@@ -37,6 +38,10 @@ class AdadeltaOptimizer : public FirstOrderOptimizer {
   float wd_;
   std::vector<Tensor> accGrad_;
   std::vector<Tensor> accDelta_;
+  detail::MultiTensorState flatAccGrad_;
+  detail::MultiTensorState flatAccDelta_;
+
+  void multiTensorStep(const detail::MultiTensorGroup& group);
 
  public:
   /** Construct an Adadelta optimizer.
@@ -9,7 +9,9 @@
 
 #include <cmath>
 
+#include "flashlight/fl/optim/Utils.h"
 #include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Index.h"
 
 namespace fl {
 
@@ -23,29 +25,80 @@ AdagradOptimizer::AdagradOptimizer(
       wd_(weightDecay) {
   variance_.reserve(parameters.size());
   for (const auto& param : parameters_) {
-    variance_.push_back(fl::full(param.shape(), 0, param.type()));
+    const auto stateType = detail::getOptimizerStateType(param.type());
+    variance_.push_back(fl::full(param.shape(), 0, stateType));
     fl::eval(variance_.back());
   }
 }
 
 void AdagradOptimizer::step() {
+  std::vector<bool> grouped(parameters_.size(), false);
+  if (multiTensor_) {
+    for (const auto& group :
+         detail::getMultiTensorGroups(parameters_, grouped)) {
+      multiTensorStep(group);
+    }
+  }
+
   for (size_t i = 0; i < parameters_.size(); i++) {
-    if (!parameters_[i].isGradAvailable()) {
+    if (!parameters_[i].isGradAvailable() || grouped[i]) {
       continue;
     }
 
-    const Tensor& grad = parameters_[i].grad().tensor();
     Tensor& data = parameters_[i].tensor();
     Tensor& variance = variance_[i];
+    const bool isSparse = parameters_[i].grad().isRowSparse();
 
-    if (wd_ != 0) {
+    if (wd_ != 0 && !(isSparse && lazySparse_)) {
       // Weight decay term
       data = data - wd_ * data;
     }
 
+    if (isSparse) {
+      // Only the rows with gradients change, besides weight decay unless lazy
+      const auto& gradVar = parameters_[i].grad();
+      const Tensor& indices = gradVar.sparseIndices();
+      const auto grad = gradVar.sparseValues().astype(variance.type());
+      auto rows = data(fl::span, indices);
+      if (wd_ != 0 && lazySparse_) {
+        rows = rows - wd_ * rows;
+      }
+      variance(fl::span, indices) += grad * grad;
+      fl::eval(variance);
+      data(fl::span, indices) = rows -
+          detail::toParamType(
+              lr_ * grad / (fl::sqrt(variance(fl::span, indices)) + eps_),
+              data.type());
+      fl::eval(data);
+      continue;
+    }
+
+    const Tensor& grad = parameters_[i].grad().tensor();
     variance = variance + grad * grad;
     fl::eval(variance);
-    data = data - lr_ * grad / (fl::sqrt(variance) + eps_);
+    data = data -
+        detail::toParamType(
+            lr_ * grad / (fl::sqrt(variance) + eps_), data.type());
+    fl::eval(data);
+  }
+}
+
+void AdagradOptimizer::multiTensorStep(const detail::MultiTensorGroup& group) {
+  const auto grad = group.grads(parameters_);
+  Tensor& variance = flatVariance_.get(group, variance_);
+  variance = variance + grad * grad;
+  fl::eval(variance);
+  flatVariance_.scatter(group, variance_);
+  auto update = lr_ * grad / (fl::sqrt(variance) + eps_);
+  fl::eval(update);
+
+  for (size_t j = 0; j < group.indices().size(); ++j) {
+    Tensor& data = parameters_[group.indices()[j]].tensor();
+    if (wd_ != 0) {
+      // Weight decay term
+      data = data - wd_ * data;
+    }
+    data = data - detail::toParamType(group.slice(update, j), data.type());
     fl::eval(data);
   }
 }
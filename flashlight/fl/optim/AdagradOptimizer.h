@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/optim/MultiTensor.h"
 #include "flashlight/fl/optim/Optimizers.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
@@ -30,6 +31,9 @@ class AdagradOptimizer : public FirstOrderOptimizer {
   float eps_;
   float wd_;
   std::vector<Tensor> variance_; // store sum_{tau=0}^{tau=t} grad_tau*grad_tau
+  detail::MultiTensorState flatVariance_;
+
+  void multiTensorStep(const detail::MultiTensorGroup& group);
 
  public:
   /** Construct an Adagrad optimizer
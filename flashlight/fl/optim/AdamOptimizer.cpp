@@ -9,7 +9,9 @@
 
 #include <cmath>
 
+#include "flashlight/fl/optim/Utils.h"
 #include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Index.h"
 
 using std::vector;
 
@@ -34,8 +36,9 @@ AdamOptimizer::AdamOptimizer(
   biasedSecond_.reserve(parameters.size());
 
   for (const auto& parameter : parameters_) {
-    biasedFirst_.emplace_back(fl::full(parameter.shape(), 0, parameter.type()));
-    biasedSecond_.emplace_back(fl::full(parameter.shape(), 0, parameter.type()));
+    const auto stateType = detail::getOptimizerStateType(parameter.type());
+    biasedFirst_.emplace_back(fl::full(parameter.shape(), 0, stateType));
+    biasedSecond_.emplace_back(fl::full(parameter.shape(), 0, stateType));
 
     fl::eval(biasedFirst_.back());
     fl::eval(biasedSecond_.back());
@@ -48,30 +51,105 @@ void AdamOptimizer::step() {
   float correctedBias2 = 1 - std::pow(beta2_, count_);
   float correctedLr = lr_ * std::sqrt(correctedBias2) / correctedBias1;
 
+  std::vector<bool> grouped(parameters_.size(), false);
+  if (multiTensor_) {
+    for (const auto& group :
+         detail::getMultiTensorGroups(parameters_, grouped)) {
+      multiTensorStep(group, correctedLr);
+    }
+  }
+
   for (size_t i = 0; i < parameters_.size(); i++) {
-    if (!parameters_[i].isGradAvailable()) {
+    if (!parameters_[i].isGradAvailable() || grouped[i]) {
       continue;
     }
 
-    const Tensor& grad = parameters_[i].grad().tensor();
     Tensor& data = parameters_[i].tensor();
+    Tensor& biasedFirst = biasedFirst_[i];
+    Tensor& biasedSecond = biasedSecond_[i];
+
+    if (parameters_[i].grad().isRowSparse() && lazySparse_) {
+      // Lazy Adam: only the rows with gradients, and their moments, change
+      const auto& gradVar = parameters_[i].grad();
+      const Tensor& indices = gradVar.sparseIndices();
+      const auto grad = gradVar.sparseValues().astype(biasedFirst.type());
+      auto rows = data(fl::span, indices);
+      if (wd_ != 0) {
+        rows = rows - wd_ * lr_ * rows;
+      }
+      auto rowsFirst =
+          beta1_ * biasedFirst(fl::span, indices) + (1 - beta1_) * grad;
+      auto rowsSecond = beta2_ * biasedSecond(fl::span, indices) +
+          (1 - beta2_) * grad * grad;
+      biasedFirst(fl::span, indices) = rowsFirst;
+      biasedSecond(fl::span, indices) = rowsSecond;
+      fl::eval(biasedFirst);
+      fl::eval(biasedSecond);
+      data(fl::span, indices) = rows -
+          detail::toParamType(
+              (correctedLr * rowsFirst) / (fl::sqrt(rowsSecond) + eps_),
+              data.type());
+      fl::eval(data);
+      continue;
+    }
 
     if (wd_ != 0) {
       // Weight decay term
       data = data - wd_ * lr_ * data;
     }
 
-    Tensor& biasedFirst = biasedFirst_[i];
-    Tensor& biasedSecond = biasedSecond_[i];
-
-    biasedFirst = beta1_ * biasedFirst + (1 - beta1_) * grad;
-    biasedSecond = beta2_ * biasedSecond + (1 - beta2_) * grad * grad;
+    if (parameters_[i].grad().isRowSparse()) {
+      // The moments of all rows decay, and only the rows with gradients get
+      // them added
+      const auto& gradVar = parameters_[i].grad();
+      const Tensor& indices = gradVar.sparseIndices();
+      const auto grad = gradVar.sparseValues().astype(biasedFirst.type());
+      biasedFirst = beta1_ * biasedFirst;
+      biasedFirst(fl::span, indices) += (1 - beta1_) * grad;
+      biasedSecond = beta2_ * biasedSecond;
+      biasedSecond(fl::span, indices) += (1 - beta2_) * grad * grad;
+    } else {
+      const Tensor& grad = parameters_[i].grad().tensor();
+      biasedFirst = beta1_ * biasedFirst + (1 - beta1_) * grad;
+      biasedSecond = beta2_ * biasedSecond + (1 - beta2_) * grad * grad;
+    }
 
     fl::eval(biasedFirst);
     fl::eval(biasedSecond);
 
-    data = data - (correctedLr * biasedFirst) / (fl::sqrt(biasedSecond) + eps_);
+    data = data -
+        detail::toParamType(
+            (correctedLr * biasedFirst) / (fl::sqrt(biasedSecond) + eps_),
+            data.type());
+
+    fl::eval(data);
+  }
+}
 
+void AdamOptimizer::multiTensorStep(
+    const detail::MultiTensorGroup& group,
+    float correctedLr) {
+  const auto grad = group.grads(parameters_);
+  Tensor& biasedFirst = flatFirst_.get(group, biasedFirst_);
+  Tensor& biasedSecond = flatSecond_.get(group, biasedSecond_);
+
+  biasedFirst = beta1_ * biasedFirst + (1 - beta1_) * grad;
+  biasedSecond = beta2_ * biasedSecond + (1 - beta2_) * grad * grad;
+  fl::eval(biasedFirst);
+  fl::eval(biasedSecond);
+  flatFirst_.scatter(group, biasedFirst_);
+  flatSecond_.scatter(group, biasedSecond_);
+
+  auto update = (correctedLr * biasedFirst) / (fl::sqrt(biasedSecond) + eps_);
+  fl::eval(update);
+
+  for (size_t j = 0; j < group.indices().size(); ++j) {
+    Tensor& data = parameters_[group.indices()[j]].tensor();
+    if (wd_ != 0) {
+      // Weight decay term
+      data = data - wd_ * lr_ * data;
+    }
+    data = data - detail::toParamType(group.slice(update, j), data.type());
     fl::eval(data);
   }
 }
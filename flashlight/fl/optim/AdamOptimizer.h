@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/optim/MultiTensor.h"
 #include "flashlight/fl/optim/Optimizers.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
@@ -41,6 +42,12 @@ class AdamOptimizer : public FirstOrderOptimizer {
   int count_;
   std::vector<Tensor> biasedFirst_;
   std::vector<Tensor> biasedSecond_;
+  detail::MultiTensorState flatFirst_;
+  detail::MultiTensorState flatSecond_;
+
+  void multiTensorStep(
+      const detail::MultiTensorGroup& group,
+      float correctedLr);
 
  public:
   /** Construct an Adam optimizer.
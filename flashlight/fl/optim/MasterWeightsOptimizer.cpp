@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/optim/MasterWeightsOptimizer.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+MasterWeightsOptimizer::MasterWeightsOptimizer(
+    const std::vector<Variable>& parameters,
+    const OptimizerFactory& makeOptimizer)
+    : FirstOrderOptimizer(parameters, 0.0) {
+  masters_.reserve(parameters_.size());
+  for (const auto& param : parameters_) {
+    if (fl::isHalfPrecisionType(param.type())) {
+      masters_.emplace_back(param.tensor().astype(fl::dtype::f32), true);
+    } else {
+      masters_.push_back(param);
+    }
+  }
+  optimizer_ = makeOptimizer(masters_);
+  if (!optimizer_) {
+    throw std::invalid_argument(
+        "[MasterWeightsOptimizer::MasterWeightsOptimizer] makeOptimizer "
+        "returned null");
+  }
+  lr_ = optimizer_->getLr();
+}
+
+void MasterWeightsOptimizer::step() {
+  // the unscaled fp32 gradients, and whether any of them isn't finite, which
+  // is only copied to the host once
+  std::vector<Tensor> grads(parameters_.size());
+  Tensor invalid;
+  for (size_t i = 0; i < parameters_.size(); ++i) {
+    const auto& param = parameters_[i];
+    if (!param.isGradAvailable()) {
+      continue;
+    }
+    if (param.grad().isRowSparse()) {
+      throw std::invalid_argument(
+          "[MasterWeightsOptimizer::step] row-sparse gradients aren't "
+          "supported");
+    }
+    auto grad = param.grad().tensor();
+    if (fl::isHalfPrecisionType(grad.type())) {
+      grad = grad.astype(fl::dtype::f32);
+    }
+    if (lossScale_ != 1.0) {
+      grad = grad / lossScale_;
+    }
+    auto gradInvalid = fl::any(fl::isnan(grad) || fl::isinf(grad));
+    invalid = invalid.isEmpty() ? gradInvalid : invalid || gradInvalid;
+    grads[i] = std::move(grad);
+  }
+  lastStepFinite_ = invalid.isEmpty() || !invalid.asScalar<bool>();
+  if (!lastStepFinite_) {
+    return;
+  }
+
+  for (size_t i = 0; i < parameters_.size(); ++i) {
+    auto& master = masters_[i];
+    if (!fl::isHalfPrecisionType(parameters_[i].type())) {
+      // the master is the parameter, whose gradient is only replaced if it
+      // was unscaled
+      if (parameters_[i].isGradAvailable() && lossScale_ != 1.0) {
+        master.grad().tensor() = grads[i];
+      }
+      continue;
+    }
+    master.zeroGrad();
+    if (parameters_[i].isGradAvailable()) {
+      master.addGrad(Variable(grads[i], false));
+    }
+  }
+
+  optimizer_->setLr(lr_);
+  optimizer_->setMultiTensor(multiTensor_);
+  optimizer_->step();
+
+  for (size_t i = 0; i < parameters_.size(); ++i) {
+    auto& param = parameters_[i];
+    if (fl::isHalfPrecisionType(param.type())) {
+      param.tensor() = masters_[i].tensor().astype(param.type());
+    }
+  }
+}
+
+void MasterWeightsOptimizer::setLossScale(double lossScale) {
+  lossScale_ = lossScale;
+}
+
+double MasterWeightsOptimizer::getLossScale() const {
+  return lossScale_;
+}
+
+bool MasterWeightsOptimizer::isLastStepFinite() const {
+  return lastStepFinite_;
+}
+
+const std::vector<Variable>& MasterWeightsOptimizer::masterParameters() const {
+  return masters_;
+}
+
+FirstOrderOptimizer& MasterWeightsOptimizer::optimizer() {
+  return *optimizer_;
+}
+
+std::string MasterWeightsOptimizer::prettyString() const {
+  std::ostringstream ss;
+  ss << "Master weights " << optimizer_->prettyString();
+  return ss.str();
+}
+
+} // namespace fl
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flashlight/fl/optim/Optimizers.h"
+
+namespace fl {
+
+/**
+ * An optimizer of half-precision parameters (f16 or bf16) with fp32 master
+ * weights, as in mixed precision training
+ * (https://arxiv.org/abs/1710.03740): the model only holds half-precision
+ * parameters for the forward and backward passes, and the optimizer updates
+ * an fp32 copy of each, with fp32 state, which is rounded back to the
+ * parameter after each step. Parameters of other types are updated directly.
+ *
+ * A step unscales the gradients by the loss scale while casting them to fp32,
+ * and skips the update if any of them isn't finite, with a single host
+ * synchronization for all gradients; see `isLastStepFinite` and
+ * `fl::pkg::runtime::DynamicScaler::step`. Row-sparse gradients aren't
+ * supported.
+ *
+ * Example:
+ * \code
+   auto model = ...; // with f16 parameters
+   fl::MasterWeightsOptimizer optimizer(
+       model.parameters(), [](const std::vector<fl::Variable>& params) {
+         return std::make_shared<fl::AdamOptimizer>(params, 1e-3);
+       });
+   auto loss = criterion(model(input), target);
+   (loss * lossScale).backward();
+   optimizer.setLossScale(lossScale);
+   optimizer.step();
+   optimizer.zeroGrad();
+ * \endcode
+ */
+class MasterWeightsOptimizer : public FirstOrderOptimizer {
+ public:
+  /**
+   * @param[in] parameters the parameters from e.g. `model.parameters()`.
+   * @param[in] makeOptimizer creates the optimizer of the master weights,
+   * whose learning rate is that of this optimizer.
+   */
+  MasterWeightsOptimizer(
+      const std::vector<Variable>& parameters,
+      const OptimizerFactory& makeOptimizer);
+
+  void step() override;
+
+  /**
+   * Sets the factor by which the loss was scaled, by which the gradients are
+   * divided in the following steps.
+   */
+  void setLossScale(double lossScale);
+
+  /** Get the loss scale, see `setLossScale`. */
+  double getLossScale() const;
+
+  /**
+   * Whether all gradients of the last step were finite, i.e. whether it
+   * updated the parameters.
+   */
+  bool isLastStepFinite() const;
+
+  /**
+   * @return the weights the optimizer updates: an fp32 copy of each
+   * half-precision parameter, and the other parameters themselves.
+   */
+  const std::vector<Variable>& masterParameters() const;
+
+  /**
+   * @return the optimizer of the master weights
+   */
+  FirstOrderOptimizer& optimizer();
+
+  std::string prettyString() const override;
+
+ private:
+  FL_SAVE_LOAD_WITH_BASE(
+      FirstOrderOptimizer,
+      optimizer_,
+      masters_,
+      fl::serializeAs<double>(lossScale_))
+
+  MasterWeightsOptimizer() = default; // Intentionally private
+
+  std::shared_ptr<FirstOrderOptimizer> optimizer_;
+  std::vector<Variable> masters_;
+  double lossScale_{1.0};
+  bool lastStepFinite_{true};
+};
+
+} // namespace fl
+
+CEREAL_REGISTER_TYPE(fl::MasterWeightsOptimizer)
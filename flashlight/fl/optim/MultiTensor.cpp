@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/optim/MultiTensor.h"
+
+#include <stdexcept>
+#include <utility>
+
+#include "flashlight/fl/autograd/GradientArena.h"
+#include "flashlight/fl/tensor/Index.h"
+
+namespace fl {
+namespace detail {
+
+MultiTensorGroup::MultiTensorGroup(
+    const std::vector<Variable>& params,
+    std::vector<size_t> indices)
+    : indices_(std::move(indices)) {
+  if (indices_.empty()) {
+    throw std::invalid_argument(
+        "[MultiTensorGroup::MultiTensorGroup] a group can't be empty");
+  }
+  type_ = params[indices_.front()].type();
+  offsets_.push_back(0);
+  for (const auto i : indices_) {
+    if (params[i].type() != type_) {
+      throw std::invalid_argument(
+          "[MultiTensorGroup::MultiTensorGroup] parameters of a group must "
+          "have the same type");
+    }
+    shapes_.push_back(params[i].shape());
+    offsets_.push_back(offsets_.back() + params[i].elements());
+  }
+}
+
+fl::dtype MultiTensorGroup::type() const {
+  return type_;
+}
+
+const std::vector<size_t>& MultiTensorGroup::indices() const {
+  return indices_;
+}
+
+Dim MultiTensorGroup::elements() const {
+  return offsets_.back();
+}
+
+Tensor MultiTensorGroup::grads(const std::vector<Variable>& params) const {
+  std::vector<Variable> groupParams;
+  groupParams.reserve(indices_.size());
+  for (const auto i : indices_) {
+    groupParams.push_back(params[i]);
+  }
+  if (auto buffer = GradientArena::findBuffer(groupParams)) {
+    return *buffer;
+  }
+  auto flat = Tensor({elements()}, type_);
+  for (size_t j = 0; j < groupParams.size(); ++j) {
+    flat(fl::range(offsets_[j], offsets_[j + 1])) =
+        groupParams[j].grad().tensor().flatten();
+  }
+  return flat;
+}
+
+Tensor MultiTensorGroup::data(const std::vector<Variable>& params) const {
+  auto flat = Tensor({elements()}, type_);
+  for (size_t j = 0; j < indices_.size(); ++j) {
+    flat(fl::range(offsets_[j], offsets_[j + 1])) =
+        params[indices_[j]].tensor().flatten();
+  }
+  return flat;
+}
+
+Tensor MultiTensorGroup::gather(
+    const std::vector<Tensor>& tensors,
+    fl::dtype type) const {
+  auto flat = Tensor({elements()}, type);
+  for (size_t j = 0; j < indices_.size(); ++j) {
+    flat(fl::range(offsets_[j], offsets_[j + 1])) =
+        tensors[indices_[j]].flatten().astype(type);
+  }
+  return flat;
+}
+
+Tensor MultiTensorGroup::slice(const Tensor& flat, size_t j) const {
+  return fl::reshape(flat(fl::range(offsets_[j], offsets_[j + 1])), shapes_[j]);
+}
+
+void MultiTensorGroup::scatter(const Tensor& flat, std::vector<Tensor>& tensors)
+    const {
+  for (size_t j = 0; j < indices_.size(); ++j) {
+    tensors[indices_[j]] = slice(flat, j);
+  }
+}
+
+Tensor MultiTensorGroup::segmentIds() const {
+  // the sum of markers of the first element of each parameter but the first,
+  // such that only the offsets are copied to the device
+  auto starts = fl::full({elements()}, 0, fl::dtype::s32);
+  if (offsets_.size() > 2) {
+    std::vector<int> offsets(offsets_.begin() + 1, offsets_.end() - 1);
+    starts(Tensor::fromVector(offsets)) = 1;
+  }
+  return fl::cumsum(starts, 0);
+}
+
+std::vector<MultiTensorGroup> getMultiTensorGroups(
+    const std::vector<Variable>& params,
+    std::vector<bool>& grouped) {
+  grouped.assign(params.size(), false);
+  std::map<fl::dtype, std::vector<size_t>> indices;
+  for (size_t i = 0; i < params.size(); ++i) {
+    if (params[i].elements() == 0 || !params[i].isGradAvailable() ||
+        params[i].grad().isRowSparse()) {
+      continue;
+    }
+    indices[params[i].type()].push_back(i);
+    grouped[i] = true;
+  }
+  std::vector<MultiTensorGroup> groups;
+  for (auto& [type, typeIndices] : indices) {
+    groups.emplace_back(params, std::move(typeIndices));
+  }
+  return groups;
+}
+
+Tensor& MultiTensorState::get(
+    const MultiTensorGroup& group,
+    const std::vector<Tensor>& state) {
+  auto& [indices, flat] = flat_[group.type()];
+  if (indices != group.indices()) {
+    indices = group.indices();
+    flat = group.gather(state, state[indices.front()].type());
+  }
+  return flat;
+}
+
+void MultiTensorState::scatter(
+    const MultiTensorGroup& group,
+    std::vector<Tensor>& state) {
+  group.scatter(flat_.at(group.type()).second, state);
+}
+
+} // namespace detail
+} // namespace fl
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+namespace detail {
+
+/**
+ * The parameters of an optimizer of one type with dense gradients, which a
+ * multi-tensor step updates together: the gradients and optimizer state of
+ * the group are flat tensors, such that the update of all of its parameters
+ * takes the ops of the update of one parameter, and only the final update of
+ * the data of each parameter is a separate op.
+ */
+class MultiTensorGroup {
+ public:
+  /**
+   * @param[in] params the parameters of the optimizer
+   * @param[in] indices the indices of the parameters of the group in `params`,
+   * which must have the same type.
+   */
+  MultiTensorGroup(
+      const std::vector<Variable>& params,
+      std::vector<size_t> indices);
+
+  fl::dtype type() const;
+
+  /**
+   * @return the indices of the parameters of the group in the optimizer
+   */
+  const std::vector<size_t>& indices() const;
+
+  /**
+   * @return the number of elements of all parameters of the group
+   */
+  Dim elements() const;
+
+  /**
+   * Returns the gradients of the parameters of the group as a flat tensor.
+   * It's the buffer of a `GradientArena` if it holds exactly these gradients,
+   * otherwise the gradients are copied to a new tensor.
+   */
+  Tensor grads(const std::vector<Variable>& params) const;
+
+  /**
+   * Copies the data of the parameters of the group to a new flat tensor, for
+   * updates which depend on it, e.g. weight decay added to momentum.
+   */
+  Tensor data(const std::vector<Variable>& params) const;
+
+  /**
+   * Copies the tensors of the parameters of the group, e.g. their optimizer
+   * state, to a new flat tensor of the given type.
+   */
+  Tensor gather(const std::vector<Tensor>& tensors, fl::dtype type) const;
+
+  /**
+   * @return the part of a flat tensor of the `j`-th parameter of the group,
+   * with its shape
+   */
+  Tensor slice(const Tensor& flat, size_t j) const;
+
+  /**
+   * Sets the tensors of the parameters of the group to their slice of a flat
+   * tensor.
+   */
+  void scatter(const Tensor& flat, std::vector<Tensor>& tensors) const;
+
+  /**
+   * @return a flat tensor holding the index within the group of the parameter
+   * of each element, e.g. to broadcast per-parameter values with
+   * `values(segmentIds())`
+   */
+  Tensor segmentIds() const;
+
+ private:
+  std::vector<size_t> indices_;
+  fl::dtype type_;
+  std::vector<Shape> shapes_;
+  // the offset of each parameter, and the number of elements last
+  std::vector<Dim> offsets_;
+};
+
+/**
+ * Groups the non-empty parameters with dense gradients by type, for a
+ * multi-tensor step.
+ *
+ * @param[in] params the parameters of an optimizer
+ * @param[out] grouped whether each parameter is in a group; the others are
+ * to be updated separately.
+ */
+std::vector<MultiTensorGroup> getMultiTensorGroups(
+    const std::vector<Variable>& params,
+    std::vector<bool>& grouped);
+
+/**
+ * A kind of state of an optimizer, e.g. the first moments of Adam, as flat
+ * tensors of the groups of a multi-tensor step. The per-parameter state of the
+ * optimizer, which is serialized, remains the reference: after each update the
+ * per-parameter state is set to views of the flat state, and the flat state is
+ * gathered again from the per-parameter state when the parameters of a group
+ * change, e.g. after deserialization.
+ */
+class MultiTensorState {
+ public:
+  /**
+   * Returns the flat state of the group, gathered from the per-parameter
+   * state unless it's already held for the parameters of the group.
+   */
+  Tensor& get(const MultiTensorGroup& group, const std::vector<Tensor>& state);
+
+  /**
+   * Sets the per-parameter state of the group to views of its flat state.
+   */
+  void scatter(const MultiTensorGroup& group, std::vector<Tensor>& state);
+
+ private:
+  // by type, the indices of the parameters of the flat state and the state
+  std::map<fl::dtype, std::pair<std::vector<size_t>, Tensor>> flat_;
+};
+
+} // namespace detail
+} // namespace fl
@@ -39,8 +39,16 @@ NAGOptimizer::NAGOptimizer(
 void NAGOptimizer::step() {
   float correctedLr = lr_ / oldLr_;
 
+  std::vector<bool> grouped(parameters_.size(), false);
+  if (multiTensor_) {
+    for (const auto& group :
+         detail::getMultiTensorGroups(parameters_, grouped)) {
+      multiTensorStep(group, correctedLr);
+    }
+  }
+
   for (size_t i = 0; i < parameters_.size(); i++) {
-    if (!parameters_[i].isGradAvailable()) {
+    if (!parameters_[i].isGradAvailable() || grouped[i]) {
       continue;
     }
 
@@ -62,6 +70,29 @@ void NAGOptimizer::step() {
   oldLr_ = lr_;
 }
 
+void NAGOptimizer::multiTensorStep(
+    const detail::MultiTensorGroup& group,
+    float correctedLr) {
+  auto grad = group.grads(parameters_);
+  Tensor& velocity = flatVelocities_.get(group, velocities_);
+  // this velocity corresponds to fairseq velocity * -1
+  velocity = mu_ * velocity * correctedLr + lr_ * grad;
+  fl::eval(velocity);
+  flatVelocities_.scatter(group, velocities_);
+  auto update = grad * lr_ + velocity * mu_;
+  fl::eval(update);
+
+  for (size_t j = 0; j < group.indices().size(); ++j) {
+    Tensor& data = parameters_[group.indices()[j]].tensor();
+    if (wd_ != 0) {
+      // Weight decay term
+      data = data * (1 - lr_ * wd_);
+    }
+    data = data - group.slice(update, j);
+    fl::eval(data);
+  }
+}
+
 std::string NAGOptimizer::prettyString() const {
   std::ostringstream ss;
   ss << "NAG (lr=" << lr_ << " ); (previous lr=" << oldLr_ << ");";
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "flashlight/fl/optim/MultiTensor.h"
 #include "flashlight/fl/optim/Optimizers.h"
 
 #include "flashlight/fl/tensor/TensorBase.h"
@@ -27,6 +28,11 @@ class NAGOptimizer : public FirstOrderOptimizer {
   float wd_;
   std::vector<Tensor> velocities_;
   float oldLr_;
+  detail::MultiTensorState flatVelocities_;
+
+  void multiTensorStep(
+      const detail::MultiTensorGroup& group,
+      float correctedLr);
 
  public:
   /** NAGOptimizer constructor.
@@ -9,7 +9,9 @@
 
 #include <cmath>
 
+#include "flashlight/fl/optim/Utils.h"
 #include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Index.h"
 
 using std::vector;
 
@@ -33,16 +35,25 @@ NovogradOptimizer::NovogradOptimizer(
   accGrad_.reserve(parameters.size());
 
   for (const auto& parameter : parameters_) {
+    const auto stateType = detail::getOptimizerStateType(parameter.type());
     accGradNorm_.emplace_back(0.0);
-    accGrad_.emplace_back(fl::full(parameter.shape(), 0, parameter.type()));
+    accGrad_.emplace_back(fl::full(parameter.shape(), 0, stateType));
 
     fl::eval(accGrad_.back());
   }
 }
 
 void NovogradOptimizer::step() {
+  std::vector<bool> grouped(parameters_.size(), false);
+  if (multiTensor_) {
+    for (const auto& group :
+         detail::getMultiTensorGroups(parameters_, grouped)) {
+      multiTensorStep(group);
+    }
+  }
+
   for (size_t i = 0; i < parameters_.size(); i++) {
-    if (!parameters_[i].isGradAvailable()) {
+    if (!parameters_[i].isGradAvailable() || grouped[i]) {
       continue;
     }
 
@@ -59,8 +70,49 @@ void NovogradOptimizer::step() {
              wd_ * data);
     fl::eval(accGrad);
 
-    data = data - (lr_ * accGrad);
+    data = data - detail::toParamType(lr_ * accGrad, data.type());
+
+    fl::eval(data);
+  }
+}
+
+void NovogradOptimizer::multiTensorStep(
+    const detail::MultiTensorGroup& group) {
+  const auto& indices = group.indices();
+  const auto grad = group.grads(parameters_);
+
+  // The norms of the gradients of all parameters are copied to the host at
+  // once
+  auto gradNorms = Tensor({static_cast<Dim>(indices.size())}, grad.type());
+  for (size_t j = 0; j < indices.size(); ++j) {
+    const auto paramGrad = group.slice(grad, j);
+    gradNorms(static_cast<Dim>(j)) = fl::sum(paramGrad * paramGrad);
+  }
+  const auto hostGradNorms =
+      gradNorms.astype(fl::dtype::f32).toHostVector<float>();
+
+  std::vector<float> denominators(indices.size());
+  for (size_t j = 0; j < indices.size(); ++j) {
+    const auto i = indices[j];
+    accGradNorm_[i] =
+        beta2_ * accGradNorm_[i] + (1 - beta2_) * hostGradNorms[j];
+    denominators[j] = static_cast<float>(std::sqrt(accGradNorm_[i]) + eps_);
+  }
 
+  // each gradient is divided by the denominator of its parameter
+  auto update = grad / Tensor::fromVector(denominators)(group.segmentIds());
+  if (wd_ != 0) {
+    update = update + wd_ * group.data(parameters_);
+  }
+  Tensor& accGrad = flatAccGrad_.get(group, accGrad_);
+  accGrad = beta1_ * accGrad + (1 - beta1_) * update;
+  fl::eval(accGrad);
+  flatAccGrad_.scatter(group, accGrad_);
+
+  for (size_t j = 0; j < indices.size(); ++j) {
+    Tensor& data = parameters_[indices[j]].tensor();
+    data = data -
+        detail::toParamType(lr_ * group.slice(accGrad, j), data.type());
     fl::eval(data);
   }
 }
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/optim/MultiTensor.h"
 #include "flashlight/fl/optim/Optimizers.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
@@ -39,6 +40,9 @@ class NovogradOptimizer : public FirstOrderOptimizer {
   float wd_;
   std::vector<double> accGradNorm_;
   std::vector<Tensor> accGrad_;
+  detail::MultiTensorState flatAccGrad_;
+
+  void multiTensorStep(const detail::MultiTensorGroup& group);
 
  public:
   /** Construct a Novograd optimizer
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <vector>
 
 #include "flashlight/fl/autograd/Variable.h"
@@ -35,6 +37,8 @@ class FirstOrderOptimizer {
  protected:
   std::vector<Variable> parameters_;
   double lr_;
+  bool multiTensor_{false};
+  bool lazySparse_{false};
 
   FirstOrderOptimizer() = default;
 
@@ -59,6 +63,40 @@ class FirstOrderOptimizer {
     lr_ = lr;
   }
 
+  /**
+   * Sets whether step() updates the parameters of each type with dense
+   * gradients together, in a few ops per type, rather than a few ops per
+   * parameter, see `detail::MultiTensorGroup`. This bounds the number of ops
+   * of steps over many small parameters, at the cost of temporaries for all
+   * parameters of a type. Gradients are gathered into a flat tensor per type
+   * unless they are stored in a `GradientArena`. The setting isn't serialized.
+   */
+  void setMultiTensor(bool multiTensor) {
+    multiTensor_ = multiTensor;
+  }
+
+  /** Whether steps are multi-tensor, see `setMultiTensor`. */
+  bool isMultiTensor() const {
+    return multiTensor_;
+  }
+
+  /**
+   * Sets whether steps with row-sparse gradients, e.g. of an `Embedding` with
+   * sparse gradients, only update the rows with gradients: the optimizer state
+   * and weight decay of the other rows are left as is, rather than decayed as
+   * for a dense gradient of zeros, as in lazy Adam. This bounds the cost of
+   * steps to the rows used by a batch, but changes the result of optimizers
+   * with momentum, state decay or weight decay. The setting isn't serialized.
+   */
+  void setLazySparse(bool lazySparse) {
+    lazySparse_ = lazySparse;
+  }
+
+  /** Whether sparse steps are lazy, see `setLazySparse`. */
+  bool isLazySparse() const {
+    return lazySparse_;
+  }
+
   /** Zero the gradients for all the parameters being optimized. Typically
    * this will be called after every call to step().
    */
@@ -74,4 +112,11 @@ class FirstOrderOptimizer {
   virtual ~FirstOrderOptimizer() = default;
 };
 
+/**
+ * Creates an optimizer of the given parameters, for optimizers wrapping
+ * another one, e.g. over a subset or a copy of their parameters.
+ */
+using OptimizerFactory = std::function<std::shared_ptr<FirstOrderOptimizer>(
+    const std::vector<Variable>&)>;
+
 } // namespace fl
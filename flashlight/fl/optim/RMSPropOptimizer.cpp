@@ -9,6 +9,7 @@
 
 #include <cmath>
 
+#include "flashlight/fl/optim/Utils.h"
 #include "flashlight/fl/tensor/Compute.h"
 
 using std::vector;
@@ -35,19 +36,28 @@ RMSPropOptimizer::RMSPropOptimizer(
   second_.reserve(parameters.size());
 
   for (const auto& parameter : parameters_) {
+    const auto stateType = detail::getOptimizerStateType(parameter.type());
     if (useFirst_) {
-      first_.emplace_back(fl::full(parameter.shape(), 0, parameter.type()));
+      first_.emplace_back(fl::full(parameter.shape(), 0, stateType));
       fl::eval(first_.back());
     }
 
-    second_.emplace_back(fl::full(parameter.shape(), 0, parameter.type()));
+    second_.emplace_back(fl::full(parameter.shape(), 0, stateType));
     fl::eval(second_.back());
   }
 }
 
 void RMSPropOptimizer::step() {
+  std::vector<bool> grouped(parameters_.size(), false);
+  if (multiTensor_) {
+    for (const auto& group :
+         detail::getMultiTensorGroups(parameters_, grouped)) {
+      multiTensorStep(group);
+    }
+  }
+
   for (size_t i = 0; i < parameters_.size(); i++) {
-    if (!parameters_[i].isGradAvailable()) {
+    if (!parameters_[i].isGradAvailable() || grouped[i]) {
       continue;
     }
 
@@ -73,8 +83,41 @@ void RMSPropOptimizer::step() {
       fl::eval(first);
     }
 
-    data = data - (lr_ * grad) / (fl::sqrt(moments) + eps_);
+    data = data -
+        detail::toParamType(
+            (lr_ * grad) / (fl::sqrt(moments) + eps_), data.type());
+
+    fl::eval(data);
+  }
+}
+
+void RMSPropOptimizer::multiTensorStep(const detail::MultiTensorGroup& group) {
+  const auto grad = group.grads(parameters_);
+  Tensor& second = flatSecond_.get(group, second_);
+  second = rho_ * second + (1 - rho_) * grad * grad;
+  fl::eval(second);
+  flatSecond_.scatter(group, second_);
 
+  // Create shallow copy of second so that we don't update
+  // "second" below
+  Tensor moments = second;
+  if (useFirst_) {
+    Tensor& first = flatFirst_.get(group, first_);
+    first = rho_ * first + (1 - rho_) * grad;
+    moments = moments - first * first;
+    fl::eval(first);
+    flatFirst_.scatter(group, first_);
+  }
+  auto update = (lr_ * grad) / (fl::sqrt(moments) + eps_);
+  fl::eval(update);
+
+  for (size_t j = 0; j < group.indices().size(); ++j) {
+    Tensor& data = parameters_[group.indices()[j]].tensor();
+    if (wd_ != 0) {
+      // Weight decay term
+      data = data - wd_ * data;
+    }
+    data = data - detail::toParamType(group.slice(update, j), data.type());
     fl::eval(data);
   }
 }
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/optim/MultiTensor.h"
 #include "flashlight/fl/optim/Optimizers.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
@@ -39,6 +40,10 @@ class RMSPropOptimizer : public FirstOrderOptimizer {
   float wd_;
   std::vector<Tensor> first_;
   std::vector<Tensor> second_;
+  detail::MultiTensorState flatFirst_;
+  detail::MultiTensorState flatSecond_;
+
+  void multiTensorStep(const detail::MultiTensorGroup& group);
 
  public:
   /** Construct an RMSProp optimizer.
@@ -10,6 +10,7 @@
 #include <cmath>
 
 #include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Index.h"
 
 using std::vector;
 
@@ -36,8 +37,21 @@ SGDOptimizer::SGDOptimizer(
 }
 
 void SGDOptimizer::step() {
+  std::vector<bool> grouped(parameters_.size(), false);
+  if (multiTensor_) {
+    for (const auto& group :
+         detail::getMultiTensorGroups(parameters_, grouped)) {
+      multiTensorStep(group);
+    }
+  }
+
   for (size_t i = 0; i < parameters_.size(); i++) {
-    if (!parameters_[i].isGradAvailable()) {
+    if (!parameters_[i].isGradAvailable() || grouped[i]) {
+      continue;
+    }
+
+    if (parameters_[i].grad().isRowSparse()) {
+      sparseStep(i);
       continue;
     }
 
@@ -67,6 +81,99 @@ void SGDOptimizer::step() {
   }
 }
 
+void SGDOptimizer::sparseStep(size_t i) {
+  const auto& grad = parameters_[i].grad();
+  const Tensor& indices = grad.sparseIndices();
+  const Tensor& values = grad.sparseValues();
+  Tensor& data = parameters_[i].tensor();
+
+  if (lazySparse_) {
+    // Only the rows with gradients, and their velocities, change
+    auto rows = data(fl::span, indices);
+    auto grad = values;
+    if (wd_ != 0) {
+      grad = grad + wd_ * rows;
+    }
+    if (mu_ != 0) {
+      Tensor& velocity = velocities_[i];
+      auto rowsVelocity = mu_ * velocity(fl::span, indices) + grad;
+      velocity(fl::span, indices) = rowsVelocity;
+      fl::eval(velocity);
+      if (useNesterov_) {
+        grad = grad + rowsVelocity * mu_;
+      } else {
+        grad = rowsVelocity;
+      }
+    }
+    data(fl::span, indices) = rows - lr_ * grad;
+    fl::eval(data);
+    return;
+  }
+
+  // The update is the same as for dense gradients, with the gradient only
+  // added to its rows
+  if (mu_ != 0) {
+    Tensor& velocity = velocities_[i];
+    velocity = mu_ * velocity;
+    if (wd_ != 0) {
+      velocity = velocity + wd_ * data;
+    }
+    velocity(fl::span, indices) += values;
+    fl::eval(velocity);
+    if (useNesterov_) {
+      auto update = velocity * mu_;
+      if (wd_ != 0) {
+        update = update + wd_ * data;
+      }
+      data = data - lr_ * update;
+      data(fl::span, indices) -= lr_ * values;
+    } else {
+      data = data - lr_ * velocity;
+    }
+  } else {
+    if (wd_ != 0) {
+      data = data - lr_ * wd_ * data;
+    }
+    data(fl::span, indices) -= lr_ * values;
+  }
+  fl::eval(data);
+}
+
+void SGDOptimizer::multiTensorStep(const detail::MultiTensorGroup& group) {
+  auto grad = group.grads(parameters_);
+
+  if (mu_ != 0) {
+    if (wd_ != 0) {
+      // Weight decay term
+      grad = grad + wd_ * group.data(parameters_);
+    }
+    Tensor& velocity = flatVelocities_.get(group, velocities_);
+
+    // Regular momentum
+    velocity = mu_ * velocity + grad;
+    fl::eval(velocity);
+    flatVelocities_.scatter(group, velocities_);
+    if (useNesterov_) {
+      // Update for nesterov momentum
+      grad = grad + velocity * mu_;
+    } else {
+      grad = velocity;
+    }
+  }
+  fl::eval(grad);
+
+  for (size_t j = 0; j < group.indices().size(); ++j) {
+    Tensor& data = parameters_[group.indices()[j]].tensor();
+    if (mu_ == 0 && wd_ != 0) {
+      // Weight decay term, which doesn't require gathering the data
+      data = data - lr_ * (group.slice(grad, j) + wd_ * data);
+    } else {
+      data = data - lr_ * group.slice(grad, j);
+    }
+    fl::eval(data);
+  }
+}
+
 std::string SGDOptimizer::prettyString() const {
   std::ostringstream ss;
   ss << "SGD";
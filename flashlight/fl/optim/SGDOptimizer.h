@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "flashlight/fl/optim/MultiTensor.h"
 #include "flashlight/fl/optim/Optimizers.h"
 
 #include "flashlight/fl/tensor/TensorBase.h"
@@ -43,6 +44,12 @@ class SGDOptimizer : public FirstOrderOptimizer {
   float mu_;
   float wd_;
   std::vector<Tensor> velocities_;
+  detail::MultiTensorState flatVelocities_;
+
+  void multiTensorStep(const detail::MultiTensorGroup& group);
+
+  // Updates the parameter at index `i` given its row-sparse gradient
+  void sparseStep(size_t i);
 
  public:
   /** SGDOptimizer constructor.
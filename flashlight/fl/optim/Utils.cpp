@@ -8,32 +8,102 @@
 #include "flashlight/fl/optim/Utils.h"
 
 #include <cmath>
+#include <utility>
 
 #include "flashlight/fl/tensor/TensorBase.h"
 
 namespace fl {
 
+namespace {
+
+// Adds the squared 2-norm of a gradient to a running sum, in which half
+// precision gradients are squared in float32 to avoid overflow
+void addSquaredNorm(Tensor& sum, const Tensor& grad) {
+  const auto type = detail::getOptimizerStateType(grad.type());
+  const auto g = type == grad.type() ? grad : grad.astype(type);
+  auto squared = fl::sum(g * g);
+  sum = sum.isEmpty() ? std::move(squared) : sum + squared;
+}
+
+// The factor by which gradients of the given norm are scaled, which is 1 if
+// they aren't clipped
+Tensor getClipScale(const Tensor& sumSquared, double maxNorm) {
+  return fl::minimum(maxNorm / (fl::sqrt(sumSquared) + 1e-6), 1.0);
+}
+
+// Scales a tensor in place by a scalar tensor, tiled since in-place ops don't
+// broadcast
+void scaleInPlace(Tensor& tensor, const Tensor& scale) {
+  tensor *= fl::tile(scale.astype(tensor.type()), tensor.shape());
+}
+
+} // namespace
+
 double clipGradNorm(const std::vector<Variable>& parameters, double maxNorm) {
-  double gradNorm = 0.0;
+  return clipGradNormLazy(parameters, maxNorm).asScalar<double>();
+}
+
+Tensor clipGradNormLazy(
+    const std::vector<Variable>& parameters,
+    double maxNorm) {
+  Tensor sumSquared;
   for (const auto& p : parameters) {
     if (!p.isGradAvailable()) {
       continue;
     }
-    const auto& grad = p.grad().tensor();
-    gradNorm += fl::sum(grad * grad).asScalar<double>();
+    // the norm of row-sparse gradients is the norm of their rows
+    addSquaredNorm(
+        sumSquared,
+        p.grad().isRowSparse() ? p.grad().sparseValues() : p.grad().tensor());
   }
-  gradNorm = std::sqrt(gradNorm);
-  double scale = maxNorm / (gradNorm + 1e-6);
-  if (scale >= 1.0) {
-    return gradNorm;
+  if (sumSquared.isEmpty()) {
+    return fl::fromScalar(0.0);
   }
+  auto scale = getClipScale(sumSquared, maxNorm);
   for (auto& p : parameters) {
     if (!p.isGradAvailable()) {
       continue;
     }
-    p.grad().tensor() *= scale;
+    if (p.grad().isRowSparse()) {
+      scaleInPlace(p.grad().sparseValues(), scale);
+    } else {
+      scaleInPlace(p.grad().tensor(), scale);
+    }
+  }
+  return fl::sqrt(sumSquared);
+}
+
+double clipGradNorm(GradientArena& arena, double maxNorm) {
+  return clipGradNormLazy(arena, maxNorm).asScalar<double>();
+}
+
+Tensor clipGradNormLazy(GradientArena& arena, double maxNorm) {
+  Tensor sumSquared;
+  for (const auto type : arena.types()) {
+    addSquaredNorm(sumSquared, arena.buffer(type));
+  }
+  if (sumSquared.isEmpty()) {
+    return fl::fromScalar(0.0);
+  }
+  auto scale = getClipScale(sumSquared, maxNorm);
+  for (const auto type : arena.types()) {
+    scaleInPlace(arena.buffer(type), scale);
+  }
+  return fl::sqrt(sumSquared);
+}
+
+namespace detail {
+
+fl::dtype getOptimizerStateType(fl::dtype paramType) {
+  return fl::isHalfPrecisionType(paramType) ? fl::dtype::f32 : paramType;
+}
+
+Tensor toParamType(Tensor&& update, fl::dtype paramType) {
+  if (update.type() == paramType) {
+    return std::move(update);
   }
-  return gradNorm;
+  return update.astype(paramType);
 }
 
+} // namespace detail
 } // namespace fl
@@ -9,9 +9,65 @@
 
 #include <vector>
 
+#include "flashlight/fl/autograd/GradientArena.h"
 #include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/Types.h"
 
 namespace fl {
 
+/**
+ * Clips the gradients of the parameters such that their 2-norm is at most
+ * `maxNorm`, see `clipGradNormLazy`, and copies the norm to the host.
+ *
+ * @return the 2-norm of the gradients before clipping
+ */
 double clipGradNorm(const std::vector<Variable>& parameters, double max_norm);
-}
+
+/**
+ * Clips the gradients of the parameters such that their 2-norm is at most
+ * `maxNorm`, without synchronizing with the host: the norm and the factor by
+ * which gradients are scaled are computed on the device, and all gradients
+ * are scaled, by one if they aren't clipped.
+ *
+ * @return a scalar tensor of the 2-norm of the gradients before clipping,
+ * which is only copied to the host if read.
+ */
+Tensor clipGradNormLazy(
+    const std::vector<Variable>& parameters,
+    double maxNorm);
+
+/**
+ * Clips the gradients of the parameters of a `GradientArena` such that their
+ * 2-norm is at most `maxNorm`, with one reduction and one scaling per buffer
+ * of the arena.
+ *
+ * @return the 2-norm of the gradients before clipping
+ */
+double clipGradNorm(GradientArena& arena, double maxNorm);
+
+/**
+ * Clips the gradients of the parameters of a `GradientArena` like
+ * `clipGradNorm`, without synchronizing with the host, see above.
+ *
+ * @return a scalar tensor of the 2-norm of the gradients before clipping
+ */
+Tensor clipGradNormLazy(GradientArena& arena, double maxNorm);
+
+namespace detail {
+
+/**
+ * The type in which optimizers keep their state, e.g. moments, for parameters
+ * of given type. Half-precision parameters have float32 state, since their
+ * updates are often too small to be represented in half precision.
+ */
+fl::dtype getOptimizerStateType(fl::dtype paramType);
+
+/**
+ * Casts an update computed from optimizer state to the type of the parameters
+ * it applies to. It's a no-op if the types are the same.
+ */
+Tensor toParamType(Tensor&& update, fl::dtype paramType);
+
+} // namespace detail
+} // namespace fl
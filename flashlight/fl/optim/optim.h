@@ -11,6 +11,8 @@
 #include "flashlight/fl/optim/AdadeltaOptimizer.h"
 #include "flashlight/fl/optim/AdagradOptimizer.h"
 #include "flashlight/fl/optim/AdamOptimizer.h"
+#include "flashlight/fl/optim/MasterWeightsOptimizer.h"
+#include "flashlight/fl/optim/MultiTensor.h"
 #include "flashlight/fl/optim/NAGOptimizer.h"
 #include "flashlight/fl/optim/NovogradOptimizer.h"
 #include "flashlight/fl/optim/Optimizers.h"
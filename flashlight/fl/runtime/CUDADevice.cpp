@@ -6,10 +6,18 @@
  */
 
 #include "flashlight/fl/runtime/CUDADevice.h"
+#include "flashlight/fl/runtime/CUDAStream.h"
 #include "flashlight/fl/runtime/CUDAUtils.h"
 
 namespace fl {
 
+namespace {
+
+// number of streams in each priority class of a device's stream pool
+constexpr unsigned kStreamsPerPool = 4;
+
+} // namespace
+
 CUDADevice::CUDADevice(const int nativeId) : nativeId_(nativeId) {}
 
 int CUDADevice::nativeId() const {
@@ -20,4 +28,36 @@ void CUDADevice::setActiveImpl() const {
   FL_CUDA_CHECK(cudaSetDevice(nativeId_));
 }
 
+std::shared_ptr<Stream> CUDADevice::getStreamFromPool(StreamPriority priority) {
+  return getCUDAStreamFromPool(priority);
+}
+
+std::shared_ptr<CUDAStream> CUDADevice::getCUDAStreamFromPool(
+    StreamPriority priority) {
+  const auto index = static_cast<size_t>(priority);
+  auto& pool = streamPools_.at(index);
+  std::call_once(streamPoolInitFlags_[index], [this, priority, &pool]() {
+    // streams are created on, and their priorities queried from, the active
+    // device
+    cuda::detail::ScopedDeviceSwitch deviceSwitch(*this);
+    int leastPriority, greatestPriority;
+    FL_CUDA_CHECK(
+        cudaDeviceGetStreamPriorityRange(&leastPriority, &greatestPriority));
+    const int nativePriority =
+        priority == StreamPriority::High ? greatestPriority : leastPriority;
+    for (unsigned i = 0; i < kStreamsPerPool; i++) {
+// Pools live as long as the DeviceManager singleton, which may outlive the
+// CUDA driver at exit, so don't destroy their streams by default.
+#ifdef CUDA_STREAM_POOL_DESTROY_ON_SHUTDOWN
+      pool.push_back(
+          CUDAStream::createManaged(cudaStreamNonBlocking, nativePriority));
+#else
+      pool.push_back(
+          CUDAStream::createUnmanaged(cudaStreamNonBlocking, nativePriority));
+#endif
+    }
+  });
+  return pool[streamPoolCounters_[index]++ % pool.size()];
+}
+
 } // namespace fl
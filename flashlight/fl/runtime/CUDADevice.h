@@ -8,10 +8,18 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "flashlight/fl/runtime/Device.h"
 
 namespace fl {
 
+class CUDAStream;
+
 /**
  * Represents a CUDA device.
  */
@@ -20,6 +28,14 @@ class CUDADevice : public DeviceTrait<CUDADevice> {
   const int nativeId_;
   // TODO metadata, e.g., memory/compute capacity
 
+  // lazily created stream pools and their round-robin counters, indexed by
+  // StreamPriority
+  static constexpr size_t kNumStreamPriorities = 2;
+  std::array<std::once_flag, kNumStreamPriorities> streamPoolInitFlags_;
+  std::array<std::vector<std::shared_ptr<CUDAStream>>, kNumStreamPriorities>
+      streamPools_;
+  std::array<std::atomic<unsigned>, kNumStreamPriorities> streamPoolCounters_{};
+
  public:
   static constexpr DeviceType type = DeviceType::CUDA;
 
@@ -41,6 +57,20 @@ class CUDADevice : public DeviceTrait<CUDADevice> {
    * Set the underlying CUDA device as active.
    */
   void setActiveImpl() const override;
+
+  std::shared_ptr<Stream> getStreamFromPool(
+      StreamPriority priority = StreamPriority::Low) override;
+
+  /**
+   * Get a non-blocking CUDA stream of given priority from this device's stream
+   * pool. Low priority streams use the device's least priority, and high
+   * priority streams its greatest one.
+   *
+   * @param[in] priority the priority class of the requested stream.
+   * @return a shared pointer to a CUDAStream created on this device.
+   */
+  std::shared_ptr<CUDAStream> getCUDAStreamFromPool(
+      StreamPriority priority = StreamPriority::Low);
 };
 
 } // namespace fl
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/runtime/CUDAGraph.h"
+
+#include <atomic>
+#include <stdexcept>
+
+#include "flashlight/fl/runtime/CUDAUtils.h"
+
+namespace fl {
+
+namespace {
+
+CUDAGraph::MemoryPoolHooks& getMemoryPoolHooks() {
+  static CUDAGraph::MemoryPoolHooks hooks;
+  return hooks;
+}
+
+CUDAGraph::MemoryPoolId getNextMemoryPoolId() {
+  static std::atomic<CUDAGraph::MemoryPoolId> nextId{1};
+  return nextId++;
+}
+
+} // namespace
+
+using cuda::detail::ScopedDeviceSwitch;
+
+void CUDAGraph::setMemoryPoolHooks(MemoryPoolHooks hooks) {
+  getMemoryPoolHooks() = std::move(hooks);
+}
+
+CUDAGraph::CUDAGraph() : poolId_(getNextMemoryPoolId()) {}
+
+CUDAGraph::~CUDAGraph() {
+  if (graphExec_) {
+    FL_CUDA_CHECK(cudaGraphExecDestroy(graphExec_));
+  }
+  if (graph_) {
+    FL_CUDA_CHECK(cudaGraphDestroy(graph_));
+  }
+  const auto& hooks = getMemoryPoolHooks();
+  if (usesPool_ && hooks.releasePool) {
+    hooks.releasePool(poolId_);
+  }
+}
+
+void CUDAGraph::beginCapture(
+    const CUDAStream& stream,
+    cudaStreamCaptureMode mode) {
+  if (capturing_ || graphExec_) {
+    throw std::runtime_error(
+        "[CUDAGraph::beginCapture] Graph is already captured");
+  }
+  // allocations go to the device of the stream
+  ScopedDeviceSwitch deviceSwitch(stream.device());
+  const auto& hooks = getMemoryPoolHooks();
+  if (hooks.beginAllocateToPool) {
+    hooks.beginAllocateToPool(poolId_);
+    usesPool_ = true;
+  }
+  const auto status = cudaStreamBeginCapture(stream.handle(), mode);
+  if (status != cudaSuccess && hooks.endAllocateToPool) {
+    hooks.endAllocateToPool();
+  }
+  FL_CUDA_CHECK(status);
+  stream_ = &stream;
+  capturing_ = true;
+}
+
+void CUDAGraph::endCapture() {
+  if (!capturing_) {
+    throw std::runtime_error("[CUDAGraph::endCapture] No capture in progress");
+  }
+  ScopedDeviceSwitch deviceSwitch(stream_->device());
+  capturing_ = false;
+  // fails if the capture was invalidated, e.g. by a synchronization
+  const auto status = cudaStreamEndCapture(stream_->handle(), &graph_);
+  const auto& hooks = getMemoryPoolHooks();
+  if (hooks.endAllocateToPool) {
+    hooks.endAllocateToPool();
+  }
+  FL_CUDA_CHECK(status);
+  FL_CUDA_CHECK(
+      cudaGraphInstantiateWithFlags(&graphExec_, graph_, /* flags = */ 0));
+}
+
+void CUDAGraph::capture(
+    const CUDAStream& stream,
+    const std::function<void()>& fn) {
+  beginCapture(stream);
+  try {
+    fn();
+  } catch (...) {
+    // still end the capture so that the stream can be used again
+    try {
+      endCapture();
+    } catch (const std::exception&) {
+      // the exception thrown by `fn` takes precedence
+    }
+    throw;
+  }
+  endCapture();
+}
+
+void CUDAGraph::replay() const {
+  if (!graphExec_) {
+    throw std::runtime_error("[CUDAGraph::replay] Graph wasn't captured");
+  }
+  ScopedDeviceSwitch deviceSwitch(stream_->device());
+  FL_CUDA_CHECK(cudaGraphLaunch(graphExec_, stream_->handle()));
+}
+
+bool CUDAGraph::isCaptured() const {
+  return graphExec_ != nullptr;
+}
+
+CUDAGraph::MemoryPoolId CUDAGraph::memoryPoolId() const {
+  return poolId_;
+}
+
+CUDAGraphCache::CUDAGraphCache(unsigned numWarmupRuns)
+    : numWarmupRuns_(numWarmupRuns) {}
+
+void CUDAGraphCache::run(
+    const std::string& key,
+    const CUDAStream& stream,
+    const std::function<void()>& fn) {
+  const auto iter = keyToGraph_.find(key);
+  if (iter != keyToGraph_.end()) {
+    iter->second->replay();
+    return;
+  }
+  if (keyToNumRuns_[key]++ < numWarmupRuns_) {
+    fn();
+    return;
+  }
+  auto graph = std::make_unique<CUDAGraph>();
+  graph->capture(stream, fn);
+  // capturing doesn't execute the work
+  graph->replay();
+  keyToGraph_.emplace(key, std::move(graph));
+  keyToNumRuns_.erase(key);
+}
+
+size_t CUDAGraphCache::size() const {
+  return keyToGraph_.size();
+}
+
+void CUDAGraphCache::clear() {
+  keyToGraph_.clear();
+  keyToNumRuns_.clear();
+}
+
+} // namespace fl
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "flashlight/fl/runtime/CUDAStream.h"
+
+#include <cuda_runtime.h>
+
+namespace fl {
+
+/**
+ * Captures the work enqueued on a CUDAStream into a CUDA graph, which can then
+ * be replayed with a single launch. This removes most of the launch overhead
+ * of workloads made of many small kernels, e.g. a training step of a small
+ * model.
+ *
+ * A replay repeats the captured kernels with the very same arguments, i.e., it
+ * reads from and writes to the same buffers as during capture. New inputs must
+ * thus be copied into the tensors used during capture, and all tensors used by
+ * the graph must outlive it. Memory allocated during capture comes from a
+ * private pool of the memory manager (see `setMemoryPoolHooks`) so that it
+ * isn't handed out to other tensors while the graph may still replay.
+ *
+ * Work that synchronizes with the host (e.g. copies to host memory or
+ * Tensor::scalar) can't be captured.
+ */
+class CUDAGraph {
+ public:
+  using MemoryPoolId = uint64_t;
+
+  /**
+   * Functions through which a memory manager serves the allocations made
+   * during capture from a private pool, see CachingMemoryManager.
+   */
+  struct MemoryPoolHooks {
+    // serve allocations on the active device from the given pool
+    std::function<void(MemoryPoolId)> beginAllocateToPool;
+    // stop directing allocations on the active device to a private pool
+    std::function<void()> endAllocateToPool;
+    // the given pool is no longer used by a graph
+    std::function<void(MemoryPoolId)> releasePool;
+  };
+
+  /**
+   * Set the hooks used by all graphs, typically by the installed memory
+   * manager. Without hooks, memory allocated during capture may be reused
+   * by other tensors after being freed, corrupting them during replays.
+   *
+   * @param[in] hooks the new hooks, possibly empty.
+   */
+  static void setMemoryPoolHooks(MemoryPoolHooks hooks);
+
+  CUDAGraph();
+  ~CUDAGraph();
+
+  // no copy/move
+  CUDAGraph(const CUDAGraph&) = delete;
+  CUDAGraph(CUDAGraph&&) = delete;
+  CUDAGraph& operator=(const CUDAGraph&) = delete;
+  CUDAGraph& operator=(CUDAGraph&&) = delete;
+
+  /**
+   * Start capturing the work enqueued on given stream; the work is recorded
+   * rather than executed.
+   *
+   * Throws runtime_error if this graph was already captured.
+   *
+   * @param[in] stream the stream whose work to capture. It must outlive this
+   * graph.
+   * @param[in] mode how strictly CUDA rejects unsafe calls made meanwhile.
+   */
+  void beginCapture(
+      const CUDAStream& stream,
+      cudaStreamCaptureMode mode = cudaStreamCaptureModeThreadLocal);
+
+  /**
+   * End the capture started by `beginCapture` and prepare the graph for
+   * replays.
+   *
+   * Throws runtime_error if no capture is in progress.
+   */
+  void endCapture();
+
+  /**
+   * Capture the work enqueued by `fn` on given stream.
+   *
+   * @param[in] stream the stream whose work to capture.
+   * @param[in] fn the function enqueuing the work.
+   */
+  void capture(const CUDAStream& stream, const std::function<void()>& fn);
+
+  /**
+   * Enqueue the captured work on the stream it was captured on.
+   *
+   * Throws runtime_error if this graph wasn't captured.
+   */
+  void replay() const;
+
+  /**
+   * @return whether this graph was captured and can be replayed.
+   */
+  bool isCaptured() const;
+
+  /**
+   * @return the id of the private memory pool holding the memory allocated
+   * during capture.
+   */
+  MemoryPoolId memoryPoolId() const;
+
+ private:
+  const MemoryPoolId poolId_;
+  const CUDAStream* stream_{nullptr};
+  bool capturing_{false};
+  bool usesPool_{false}; // whether the pool must be released
+  cudaGraph_t graph_{nullptr};
+  cudaGraphExec_t graphExec_{nullptr};
+};
+
+/**
+ * Graphs captured by key, e.g. a description of the input shapes, so that a
+ * workload is replayed whenever it runs with the same key again.
+ */
+class CUDAGraphCache {
+  // the first runs per key are executed eagerly, e.g. to let kernels be
+  // compiled or benchmarked, which can't be captured
+  const unsigned numWarmupRuns_;
+  std::unordered_map<std::string, unsigned> keyToNumRuns_;
+  std::unordered_map<std::string, std::unique_ptr<CUDAGraph>> keyToGraph_;
+
+ public:
+  /**
+   * @param[in] numWarmupRuns the number of eager runs per key before the
+   * workload is captured.
+   */
+  explicit CUDAGraphCache(unsigned numWarmupRuns = 1);
+
+  /**
+   * Run `fn`, or replay the graph captured from it, for given key. See
+   * CUDAGraph for the constraints on `fn`.
+   *
+   * @param[in] key identifies the workload of `fn`, e.g. its input shapes.
+   * @param[in] stream the stream on which `fn` enqueues its work.
+   * @param[in] fn the function enqueuing the work.
+   */
+  void run(
+      const std::string& key,
+      const CUDAStream& stream,
+      const std::function<void()>& fn);
+
+  /**
+   * @return the number of captured graphs.
+   */
+  size_t size() const;
+
+  /**
+   * Destroy all captured graphs.
+   */
+  void clear();
+};
+
+} // namespace fl
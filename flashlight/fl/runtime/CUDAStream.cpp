@@ -14,6 +14,39 @@
 
 namespace fl {
 
+using cuda::detail::ScopedDeviceSwitch;
+
+CUDAEvent::CUDAEvent(cudaEvent_t event) : nativeEvent_(event) {}
+
+CUDAEvent::~CUDAEvent() {
+  FL_CUDA_CHECK(cudaEventDestroy(nativeEvent_));
+}
+
+void CUDAEvent::sync() const {
+  FL_CUDA_CHECK(cudaEventSynchronize(nativeEvent_));
+}
+
+bool CUDAEvent::isReady() const {
+  const auto status = cudaEventQuery(nativeEvent_);
+  if (status == cudaErrorNotReady) {
+    return false;
+  }
+  FL_CUDA_CHECK(status);
+  return true;
+}
+
+double CUDAEvent::elapsedSeconds(const Event& start) const {
+  sync();
+  const auto startEvent = start.impl<CUDAEvent>().nativeEvent_;
+  float ms = 0;
+  FL_CUDA_CHECK(cudaEventElapsedTime(&ms, startEvent, nativeEvent_));
+  return ms / 1000.0;
+}
+
+cudaEvent_t CUDAEvent::handle() const {
+  return nativeEvent_;
+}
+
 CUDAStream::CUDAStream(CUDADevice& device, cudaStream_t stream, bool managed)
     : device_(device), nativeStream_(stream), managed_(managed) {
   // Ensure `event_` and `nativeStream_` are associated with the same device
@@ -35,20 +68,25 @@ std::shared_ptr<CUDAStream> CUDAStream::makeSharedAndRegister(
   return streamPtr;
 }
 
-std::shared_ptr<CUDAStream> CUDAStream::create(int flag, bool managed) {
+std::shared_ptr<CUDAStream>
+CUDAStream::create(int flag, bool managed, int priority) {
   cudaStream_t nativeStream;
-  FL_CUDA_CHECK(cudaStreamCreateWithFlags(&nativeStream, flag));
+  FL_CUDA_CHECK(cudaStreamCreateWithPriority(&nativeStream, flag, priority));
   auto& manager = DeviceManager::getInstance();
   auto& device = manager.getActiveDevice(DeviceType::CUDA).impl<CUDADevice>();
   return makeSharedAndRegister(device, nativeStream, managed);
 }
 
-std::shared_ptr<CUDAStream> CUDAStream::createManaged(int flag) {
-  return CUDAStream::create(flag, /* managed */ true);
+std::shared_ptr<CUDAStream> CUDAStream::createManaged(
+    int flag,
+    int priority) {
+  return CUDAStream::create(flag, /* managed */ true, priority);
 }
 
-std::shared_ptr<CUDAStream> CUDAStream::createUnmanaged(int flag) {
-  return CUDAStream::create(flag, /* managed */ false);
+std::shared_ptr<CUDAStream> CUDAStream::createUnmanaged(
+    int flag,
+    int priority) {
+  return CUDAStream::create(flag, /* managed */ false, priority);
 }
 
 std::shared_ptr<CUDAStream> CUDAStream::wrapUnmanaged(
@@ -103,20 +141,43 @@ void CUDAStream::sync() const {
 }
 
 void CUDAStream::relativeSync(const CUDAStream& waitOn) const {
-  auto& manager = DeviceManager::getInstance();
-  auto* oldActiveCUDADevice = &manager.getActiveDevice(DeviceType::CUDA);
-  bool needDeviceSwitch = oldActiveCUDADevice != &device_;
-  if (needDeviceSwitch) {
-    device_.setActive();
-  }
+  ScopedDeviceSwitch deviceSwitch(device_);
   // event and stream from same instance are guaranteed to have been created
   // from the same device
   FL_CUDA_CHECK(cudaEventRecord(waitOn.event_, waitOn.nativeStream_));
   FL_CUDA_CHECK(cudaStreamWaitEvent(
       this->nativeStream_, waitOn.event_, /* cudaEventWaitDefault = */ 0));
-  if (needDeviceSwitch) {
-    oldActiveCUDADevice->setActive();
+}
+
+void CUDAStream::relativeSync(const Event& waitOn) const {
+  if (waitOn.type() != CUDAEvent::type) {
+    // other events don't mark tasks on the GPU
+    waitOn.sync();
+    return;
   }
+  ScopedDeviceSwitch deviceSwitch(device_);
+  FL_CUDA_CHECK(cudaStreamWaitEvent(
+      this->nativeStream_,
+      waitOn.impl<CUDAEvent>().handle(),
+      /* cudaEventWaitDefault = */ 0));
+}
+
+std::unique_ptr<Event> CUDAStream::recordEvent(bool enableTiming) const {
+  // the event must be created on the same device as the stream
+  ScopedDeviceSwitch deviceSwitch(device_);
+  cudaEvent_t event;
+  FL_CUDA_CHECK(cudaEventCreateWithFlags(
+      &event, enableTiming ? cudaEventDefault : cudaEventDisableTiming));
+  auto eventPtr = std::make_unique<CUDAEvent>(event);
+  FL_CUDA_CHECK(cudaEventRecord(event, nativeStream_));
+  return eventPtr;
+}
+
+void CUDAStream::copyAsync(void* dst, const void* src, size_t bytes) const {
+  ScopedDeviceSwitch deviceSwitch(device_);
+  // unified addressing lets CUDA infer the direction of the copy
+  FL_CUDA_CHECK(
+      cudaMemcpyAsync(dst, src, bytes, cudaMemcpyDefault, nativeStream_));
 }
 
 cudaStream_t CUDAStream::handle() const {
@@ -8,12 +8,47 @@
 #pragma once
 
 #include "flashlight/fl/runtime/CUDADevice.h"
+#include "flashlight/fl/runtime/Event.h"
 #include "flashlight/fl/runtime/Stream.h"
 
 #include <cuda_runtime.h>
 
 namespace fl {
 
+/**
+ * An event recorded on a CUDAStream, i.e., a wrapper around a native CUDA
+ * event.
+ */
+class CUDAEvent : public EventTrait<CUDAEvent> {
+  cudaEvent_t nativeEvent_;
+
+ public:
+  static constexpr StreamType type = StreamType::CUDA;
+
+  /**
+   * Creates a wrapper which takes ownership of given native CUDA event.
+   *
+   * @param[in] event the underlying native CUDA event.
+   */
+  explicit CUDAEvent(cudaEvent_t event);
+
+  /**
+   * Destroy the underlying native CUDA event.
+   */
+  ~CUDAEvent() override;
+
+  void sync() const override;
+  bool isReady() const override;
+  double elapsedSeconds(const Event& start) const override;
+
+  /**
+   * Get the native CUDA event handle.
+   *
+   * @return the native CUDA event handle.
+   */
+  cudaEvent_t handle() const;
+};
+
 /**
  * An abstraction for CUDA stream with controlled creation methods.
  */
@@ -56,7 +91,8 @@ class CUDAStream : public StreamTrait<CUDAStream> {
       CUDADevice& device, cudaStream_t nativeStream, bool managed);
 
   // A fully configurable create, hidden for internal use.
-  static std::shared_ptr<CUDAStream> create(int flag, bool managed);
+  static std::shared_ptr<CUDAStream>
+  create(int flag, bool managed, int priority);
 
  public:
   // prevent name hiding
@@ -85,11 +121,13 @@ class CUDAStream : public StreamTrait<CUDAStream> {
      * DeviceManager.
      *
      * @param[in] flag the flag used for creating native CUDA stream.
+     * @param[in] priority the priority of the native CUDA stream; lower
+     * numbers mean higher priority, see cudaDeviceGetStreamPriorityRange.
      *
      * @return a shared pointer to the CUDAStream created.
      */
   static std::shared_ptr<CUDAStream> createManaged(
-      int flag = cudaStreamDefault);
+      int flag = cudaStreamDefault, int priority = 0);
 
     /**
      * Create an unmanaged CUDAStream around an internally created native CUDA
@@ -97,11 +135,13 @@ class CUDAStream : public StreamTrait<CUDAStream> {
      * DeviceManager.
      *
      * @param[in] flag the flag used for creating native CUDA stream.
+     * @param[in] priority the priority of the native CUDA stream; lower
+     * numbers mean higher priority, see cudaDeviceGetStreamPriorityRange.
      *
      * @return a shared pointer to the CUDAStream created.
      */
   static std::shared_ptr<CUDAStream> createUnmanaged(
-      int flag = cudaStreamDefault);
+      int flag = cudaStreamDefault, int priority = 0);
 
   /**
    * Destroy any stream managed by this object.
@@ -112,6 +152,9 @@ class CUDAStream : public StreamTrait<CUDAStream> {
   const CUDADevice& device() const override;
   void sync() const override;
   void relativeSync(const CUDAStream& waitOn) const override;
+  void relativeSync(const Event& waitOn) const override;
+  std::unique_ptr<Event> recordEvent(bool enableTiming = false) const override;
+  void copyAsync(void* dst, const void* src, size_t bytes) const override;
 
   /**
    * Get the native CUDA stream handle.
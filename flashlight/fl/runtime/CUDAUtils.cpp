@@ -5,10 +5,12 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <mutex>
 #include <stdexcept>
 
 #include "flashlight/fl/runtime/CUDADevice.h"
 #include "flashlight/fl/runtime/CUDAUtils.h"
+#include "flashlight/fl/runtime/DeviceManager.h"
 
 #include <cuda_runtime.h>
 
@@ -21,6 +23,25 @@ int getActiveDeviceId() {
   return cudaActiveDeviceId;
 }
 
+std::string getActiveDeviceModel() {
+  static std::mutex mutex;
+  static std::unordered_map<int, std::string> models;
+  const int id = getActiveDeviceId();
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = models.find(id);
+  if (it == models.end()) {
+    cudaDeviceProp prop;
+    FL_CUDA_CHECK(cudaGetDeviceProperties(&prop, id));
+    it = models
+             .emplace(
+                 id,
+                 std::string(prop.name) + " sm_" +
+                     std::to_string(prop.major) + std::to_string(prop.minor))
+             .first;
+  }
+  return it->second;
+}
+
 std::unordered_map<int, const std::unique_ptr<Device>> createCUDADevices() {
   std::unordered_map<int, const std::unique_ptr<Device>> idToDevice;
   int numCudaDevices = 0;
@@ -33,6 +54,21 @@ std::unordered_map<int, const std::unique_ptr<Device>> createCUDADevices() {
 
 namespace detail {
 
+ScopedDeviceSwitch::ScopedDeviceSwitch(const Device& device) {
+  auto& manager = DeviceManager::getInstance();
+  const auto* activeDevice = &manager.getActiveDevice(DeviceType::CUDA);
+  if (activeDevice != &device) {
+    oldActiveDevice_ = activeDevice;
+    device.setActive();
+  }
+}
+
+ScopedDeviceSwitch::~ScopedDeviceSwitch() {
+  if (oldActiveDevice_) {
+    oldActiveDevice_->setActive();
+  }
+}
+
 void check(cudaError_t err, const char* file, int line) {
   check(err, "", file, line);
 }
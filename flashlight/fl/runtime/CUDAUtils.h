@@ -8,6 +8,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 
 #include "flashlight/fl/runtime/Device.h"
@@ -27,6 +28,14 @@ namespace cuda {
  */
 int getActiveDeviceId();
 
+/**
+ * Gets the model of the active CUDA device, e.g. to key what is tuned for it.
+ *
+ * @return the name and compute capability of the active CUDA device, e.g.
+ * "Tesla V100-SXM2-16GB sm_70".
+ */
+std::string getActiveDeviceModel();
+
 /**
  * Return a mapping from native CUDA device id to available CUDA devices.
  *
@@ -36,6 +45,15 @@ std::unordered_map<int, const std::unique_ptr<Device>> createCUDADevices();
 
 namespace detail {
 
+// Makes given device active for the lifetime of this object, if it isn't.
+class ScopedDeviceSwitch {
+  const Device* oldActiveDevice_{nullptr};
+
+ public:
+  explicit ScopedDeviceSwitch(const Device& device);
+  ~ScopedDeviceSwitch();
+};
+
 void check(cudaError_t err, const char* file, int line);
 
 void check(cudaError_t err, const char* prefix, const char* file, int line);
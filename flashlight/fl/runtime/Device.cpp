@@ -6,12 +6,21 @@
  */
 
 #include <algorithm>
+#include <unordered_map>
 
 #include "flashlight/fl/runtime/Device.h"
 #include "flashlight/fl/runtime/DeviceManager.h"
 
 namespace fl {
 
+namespace {
+
+// each thread's current stream selection, per device
+thread_local std::unordered_map<const Device*, std::shared_ptr<Stream>>
+    deviceToCurrentStream;
+
+} // namespace
+
 void deviceImplTypeCheck(DeviceType expect, DeviceType actual) {
   if (expect != actual) {
     std::ostringstream oss;
@@ -34,6 +43,30 @@ void Device::addStream(std::shared_ptr<Stream> stream) {
   streams_.insert(stream);
 }
 
+std::shared_ptr<Stream> Device::getStreamFromPool(
+    StreamPriority /* priority */) {
+  throw std::runtime_error(
+      "[Device::getStreamFromPool] Stream pools unsupported on this device");
+}
+
+std::shared_ptr<Stream> Device::getCurrentStream() const {
+  const auto iter = deviceToCurrentStream.find(this);
+  return iter == deviceToCurrentStream.end() ? nullptr : iter->second;
+}
+
+void Device::setCurrentStream(std::shared_ptr<Stream> stream) {
+  if (!stream) {
+    deviceToCurrentStream.erase(this);
+    return;
+  }
+  if (&stream->device() != this) {
+    throw std::runtime_error(
+        "[Device::setCurrentStream] Must select stream on owner device");
+  }
+  addStream(stream);
+  deviceToCurrentStream[this] = std::move(stream);
+}
+
 void Device::sync() const {
   for (auto stream : streams_) {
     stream->sync();
@@ -59,4 +92,13 @@ void X64Device::setActiveImpl() const {
   // no op, CPU device is always active
 }
 
+StreamGuard::StreamGuard(std::shared_ptr<Stream> stream)
+    : device_(stream->device()), prevStream_(device_.getCurrentStream()) {
+  device_.setCurrentStream(std::move(stream));
+}
+
+StreamGuard::~StreamGuard() {
+  device_.setCurrentStream(std::move(prevStream_));
+}
+
 } // namespace fl
@@ -22,6 +22,11 @@ namespace fl {
 // throw invalid_argument with descriptive message if given types don't match
 void deviceImplTypeCheck(DeviceType expect, DeviceType actual);
 
+/**
+ * Priority classes of the streams handed out by a device's stream pool.
+ */
+enum class StreamPriority { Low, High };
+
 /**
  * An abstraction that represents framework-level (as opposed to hardware-level)
  * computing device.
@@ -64,6 +69,38 @@ class Device {
    */
   virtual void addStream(std::shared_ptr<Stream> stream);
 
+  /**
+   * Get a stream of given priority from this device's stream pool. Pools are
+   * created lazily and their streams are handed out in a round-robin fashion,
+   * so callers should not assume exclusive use of the returned stream.
+   *
+   * Throws runtime_error if this device doesn't support stream pools.
+   *
+   * @param[in] priority the priority class of the requested stream.
+   * @return a shared pointer to a stream owned by this device.
+   */
+  virtual std::shared_ptr<Stream> getStreamFromPool(
+      StreamPriority priority = StreamPriority::Low);
+
+  /**
+   * Get the stream the calling thread has currently selected on this device.
+   *
+   * @return a shared pointer to the current stream, or nullptr if the calling
+   * thread hasn't selected any.
+   */
+  std::shared_ptr<Stream> getCurrentStream() const;
+
+  /**
+   * Select given stream as the calling thread's current stream on this device
+   * and let this device manage it. A nullptr clears the selection.
+   *
+   * Throws runtime_error if stream is owned by a different device than this
+   * one.
+   *
+   * @param[in] stream the stream to select.
+   */
+  void setCurrentStream(std::shared_ptr<Stream> stream);
+
   /**
    * Block calling thread and synchronize w.r.t. all streams on this device.
    */
@@ -154,4 +191,26 @@ class X64Device : public DeviceTrait<X64Device> {
   void setActiveImpl() const override;
 };
 
+/**
+ * Makes a stream the calling thread's current stream on its owner device for
+ * the lifetime of this object, then restores the previous selection.
+ */
+class StreamGuard {
+  Device& device_;
+  std::shared_ptr<Stream> prevStream_;
+
+ public:
+  /**
+   * @param[in] stream the stream to select as current on its owner device.
+   */
+  explicit StreamGuard(std::shared_ptr<Stream> stream);
+  ~StreamGuard();
+
+  // no copy/move
+  StreamGuard(const StreamGuard&) = delete;
+  StreamGuard(StreamGuard&&) = delete;
+  StreamGuard& operator=(const StreamGuard&) = delete;
+  StreamGuard& operator=(StreamGuard&&) = delete;
+};
+
 } // namespace fl
@@ -5,7 +5,10 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <atomic>
+#include <cstdlib>
 #include <stdexcept>
+#include <string>
 
 #include "flashlight/fl/runtime/Device.h"
 #include "flashlight/fl/runtime/DeviceManager.h"
@@ -16,6 +19,16 @@
 
 namespace {
 
+std::atomic<bool> cudaInitialized{false};
+
+std::atomic<bool>& cpuOnlyFlag() {
+  static std::atomic<bool> cpuOnly{[]() {
+    const char* env = std::getenv("FL_CPU_ONLY");
+    return env != nullptr && std::string(env) == "1";
+  }()};
+  return cpuOnly;
+}
+
 int getActiveDeviceId(const fl::DeviceType type) {
   switch (type) {
     case fl::DeviceType::x64: return fl::kX64DeviceId;
@@ -38,9 +51,9 @@ DeviceManager::DeviceManager() {
   x64Info.emplace(kX64DeviceId, std::make_unique<X64Device>());
   deviceTypeToInfo_.emplace(DeviceType::x64, std::move(x64Info));
 
-  // initialize for CUDA
+  // CUDA devices are enumerated on first use, see `getDeviceTypeInfo`
 #if FL_BACKEND_CUDA
-  deviceTypeToInfo_.insert({DeviceType::CUDA, fl::cuda::createCUDADevices()});
+  deviceTypeToInfo_.emplace(DeviceType::CUDA, DeviceTypeInfo{});
 #endif
 }
 
@@ -52,25 +65,56 @@ void DeviceManager::enforceDeviceTypeAvailable(
   }
 }
 
+DeviceManager::DeviceTypeInfo& DeviceManager::getDeviceTypeInfo(
+  std::string_view errorPrefix, const DeviceType type) const {
+  enforceDeviceTypeAvailable(errorPrefix, type);
+  auto& info = deviceTypeToInfo_.at(type);
+#if FL_BACKEND_CUDA
+  if (type == DeviceType::CUDA) {
+    // retried on the next use if it throws, e.g. without a CUDA driver
+    std::call_once(cudaInitFlag_, [&info]() {
+      cudaInitialized = true;
+      auto devices = fl::cuda::createCUDADevices();
+      info.swap(devices);
+    });
+  }
+#endif
+  return info;
+}
+
 DeviceManager& DeviceManager::getInstance() {
   static DeviceManager instance;
   return instance;
 }
 
+void DeviceManager::setCPUOnly() {
+  if (cudaInitialized) {
+    throw std::runtime_error(
+      "[DeviceManager::setCPUOnly] CUDA devices were already initialized");
+  }
+  cpuOnlyFlag() = true;
+}
+
+bool DeviceManager::isCPUOnly() {
+  return cpuOnlyFlag();
+}
+
 bool DeviceManager::isDeviceTypeAvailable(const DeviceType type) const {
+  if (type == DeviceType::CUDA && isCPUOnly()) {
+    return false;
+  }
   return deviceTypeToInfo_.count(type) != 0;
 }
 
 unsigned DeviceManager::getDeviceCount(const DeviceType type) const {
-  enforceDeviceTypeAvailable("[DeviceManager::getDeviceCount]", type);
-  return deviceTypeToInfo_.at(type).size();
+  return getDeviceTypeInfo("[DeviceManager::getDeviceCount]", type).size();
 }
 
 std::vector<Device*> DeviceManager::getDevicesOfType(
   DeviceType type) {
-  enforceDeviceTypeAvailable("[DeviceManager::getDevicesOfType]", type);
   std::vector<Device*> devices;
-  for (auto &[_, device] : deviceTypeToInfo_.at(type)) {
+  for (auto &[_, device] :
+       getDeviceTypeInfo("[DeviceManager::getDevicesOfType]", type)) {
     devices.push_back(device.get());
   }
   return devices;
@@ -78,17 +122,17 @@ std::vector<Device*> DeviceManager::getDevicesOfType(
 
 std::vector<const Device*> DeviceManager::getDevicesOfType(
   DeviceType type) const {
-  enforceDeviceTypeAvailable("[DeviceManager::getDevicesOfType]", type);
   std::vector<const Device*> devices;
-  for (auto &[_, device] : deviceTypeToInfo_.at(type)) {
+  for (auto &[_, device] :
+       getDeviceTypeInfo("[DeviceManager::getDevicesOfType]", type)) {
     devices.push_back(device.get());
   }
   return devices;
 }
 
 Device& DeviceManager::getDevice(const DeviceType type, int id) const {
-  enforceDeviceTypeAvailable("[DeviceManager::getActiveDevice]", type);
-  auto& idToDevice = deviceTypeToInfo_.at(type);
+  auto& idToDevice =
+    getDeviceTypeInfo("[DeviceManager::getActiveDevice]", type);
   if (idToDevice.count(id) == 0) {
     throw std::runtime_error(
       "[DeviceManager::getDevice] unknown device id");
@@ -97,9 +141,17 @@ Device& DeviceManager::getDevice(const DeviceType type, int id) const {
 }
 
 Device& DeviceManager::getActiveDevice(const DeviceType type) const {
-  enforceDeviceTypeAvailable("[DeviceManager::getActiveDevice]", type);
+  auto& idToDevice =
+    getDeviceTypeInfo("[DeviceManager::getActiveDevice]", type);
   int activeDeviceId = getActiveDeviceId(type);
-  return *deviceTypeToInfo_.at(type).at(activeDeviceId);
+  return *idToDevice.at(activeDeviceId);
+}
+
+std::shared_ptr<Stream> DeviceManager::getStreamFromPool(
+    const DeviceType type,
+    StreamPriority priority) const {
+  enforceDeviceTypeAvailable("[DeviceManager::getStreamFromPool]", type);
+  return getActiveDevice(type).getStreamFromPool(priority);
 }
 
 } // namespace fl
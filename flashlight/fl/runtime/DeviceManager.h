@@ -8,6 +8,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <string_view>
 #include <vector>
 #include <unordered_map>
@@ -23,12 +24,19 @@ constexpr int kX64DeviceId = 0;
 
 /**
  * A singleton to manage all supported types of devices.
+ *
+ * The devices of a type are enumerated on the first use of the type, e.g.
+ * CUDA devices aren't queried until a CUDA device is needed. If restricted to
+ * the CPU, with `setCPUOnly` or the FL_CPU_ONLY environment variable, CUDA is
+ * never touched and reported unavailable.
  */
 class DeviceManager {
 
   using DeviceTypeInfo = std::unordered_map<int, const std::unique_ptr<Device>>;
 
-  std::unordered_map<DeviceType, DeviceTypeInfo> deviceTypeToInfo_;
+  // the available device types; devices other than x64 are added lazily
+  mutable std::unordered_map<DeviceType, DeviceTypeInfo> deviceTypeToInfo_;
+  mutable std::once_flag cudaInitFlag_;
 
   // Help enforce singleton
   DeviceManager();
@@ -41,6 +49,10 @@ class DeviceManager {
   void enforceDeviceTypeAvailable(
     std::string_view errorPrefix, const DeviceType type) const;
 
+  // returns the devices of `type`, enumerating them on first use
+  DeviceTypeInfo& getDeviceTypeInfo(
+    std::string_view errorPrefix, const DeviceType type) const;
+
  public:
 
   /**
@@ -50,6 +62,23 @@ class DeviceManager {
    */
   static DeviceManager& getInstance();
 
+  /**
+   * Restricts Flashlight to the CPU: CUDA devices are never enumerated nor
+   * initialized, and tensor backends requiring CUDA fail on first use. Must be
+   * called before the first use of a CUDA device.
+   *
+   * Throws a runtime_error if CUDA devices were already initialized.
+   */
+  static void setCPUOnly();
+
+  /**
+   * Returns if Flashlight is restricted to the CPU, with `setCPUOnly` or by
+   * setting the FL_CPU_ONLY environment variable to 1.
+   *
+   * @return a boolean denoting if only the CPU may be used.
+   */
+  static bool isCPUOnly();
+
   /**
    * Returns if the given device type is available.
    *
@@ -102,6 +131,19 @@ class DeviceManager {
    * @return a reference to the active device of given type.
    */
   Device& getActiveDevice(const DeviceType type) const;
+
+  /**
+   * Gets a stream of given priority from the pool of the active device of
+   * given type.
+   *
+   * Throws a runtime_error if given device `type` is unavailable or doesn't
+   * support stream pools.
+   *
+   * @return a shared pointer to a stream owned by the active device.
+   */
+  std::shared_ptr<Stream> getStreamFromPool(
+      const DeviceType type,
+      StreamPriority priority = StreamPriority::Low) const;
 };
 
 } // namespace fl
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <stdexcept>
+
+#include "flashlight/fl/runtime/Stream.h"
+
+namespace fl {
+
+/**
+ * An abstraction that marks a point in a stream, i.e., the completion of all
+ * tasks enqueued on the stream before the event was recorded. See
+ * `Stream::recordEvent`.
+ */
+class Event {
+ public:
+  Event() = default;
+  virtual ~Event() = default;
+
+  // no copy/move
+  Event(const Event&) = delete;
+  Event(Event&&) = delete;
+  Event& operator=(const Event&) = delete;
+  Event& operator=(const Event&&) = delete;
+
+  /**
+   * Get the underlying implementation of this event.
+   *
+   * Throws invalid_argument if the specified type does not match the actual
+   * derived event type.
+   *
+   * @return an immutable reference to the specified event type.
+   */
+  template <typename T>
+  const T& impl() const {
+    if (T::type != type()) {
+      throw std::invalid_argument(
+          "[fl::Event::impl] "
+          "specified event type doesn't match actual event type.");
+    }
+    return *(static_cast<const T*>(this));
+  }
+
+  /**
+   * Returns the type of the stream this event was recorded on.
+   *
+   * @return a enum denoting stream type.
+   */
+  virtual StreamType type() const = 0;
+
+  /**
+   * Block calling thread until the event completes.
+   */
+  virtual void sync() const = 0;
+
+  /**
+   * Returns whether the event has completed, without blocking.
+   *
+   * @return true iff all tasks the event marks have completed.
+   */
+  virtual bool isReady() const = 0;
+
+  /**
+   * Block calling thread until the event completes, and return the time
+   * elapsed between the completion of given event and this one.
+   *
+   * Throws invalid_argument if the events are of different types, and
+   * runtime_error if either wasn't recorded with timing enabled.
+   *
+   * @param[in] start an earlier event recorded on a stream of the same device.
+   * @return the elapsed time in seconds.
+   */
+  virtual double elapsedSeconds(const Event& start) const = 0;
+};
+
+/**
+ * A trait for some generic event functionalities.
+ *
+ * REQUIRED definition in derived class:
+ *   static StreamType type;
+ */
+template <typename Derived>
+class EventTrait : public Event {
+ public:
+  StreamType type() const override {
+    return Derived::type;
+  }
+};
+
+} // namespace fl
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/runtime/OpProfiler.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace fl {
+
+namespace {
+
+constexpr size_t kHistogramBuckets = 10;
+
+// the ids of the open ranges of the calling thread, innermost last
+thread_local std::vector<int64_t> openRanges;
+
+} // namespace
+
+OpProfiler& OpProfiler::getInstance() {
+  static OpProfiler instance;
+  return instance;
+}
+
+void OpProfiler::enable() {
+  clear();
+  enabled_ = true;
+}
+
+void OpProfiler::disable() {
+  enabled_ = false;
+}
+
+int64_t OpProfiler::begin(
+    std::string name,
+    std::string shape,
+    const Stream* stream) {
+  if (!enabled_) {
+    return -1;
+  }
+  if (stream && stream->type() != StreamType::CUDA) {
+    stream = nullptr;
+  }
+  const int64_t parent = openRanges.empty() ? -1 : openRanges.back();
+  auto key = name + '\0' + shape;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto [iter, inserted] = keyIndices_.emplace(key, keys_.size());
+  if (inserted) {
+    keys_.emplace_back(std::move(name), std::move(shape));
+  }
+  const int64_t id = firstId_ + ranges_.size();
+  ranges_.push_back(
+      {iter->second, parent < firstId_ ? -1 : parent, false, {}, 0, stream});
+  auto& range = ranges_.back();
+  if (stream) {
+    range.startMark_ = stream->recordEvent(/* enableTiming = */ true);
+  }
+  range.start_ = Clock::now();
+  openRanges.push_back(id);
+  return id;
+}
+
+void OpProfiler::end(int64_t id) {
+  if (id < 0) {
+    return;
+  }
+  const auto end = Clock::now();
+  if (!openRanges.empty() && openRanges.back() == id) {
+    openRanges.pop_back();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (id < firstId_) {
+    return;
+  }
+  auto& range = ranges_[id - firstId_];
+  if (range.stream_) {
+    range.endMark_ = range.stream_->recordEvent(/* enableTiming = */ true);
+  } else {
+    range.seconds_ = std::chrono::duration<double>(end - range.start_).count();
+  }
+  range.ended_ = true;
+}
+
+std::optional<std::pair<std::string, std::string>> OpProfiler::currentRange()
+    const {
+  if (openRanges.empty()) {
+    return std::nullopt;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  const int64_t id = openRanges.back();
+  if (id < firstId_) {
+    return std::nullopt;
+  }
+  return keys_[ranges_[id - firstId_].key_];
+}
+
+std::vector<OpProfiler::OpStats> OpProfiler::getStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<double> seconds(ranges_.size(), 0);
+  std::vector<double> childSeconds(ranges_.size(), 0);
+  for (size_t i = 0; i < ranges_.size(); ++i) {
+    const auto& range = ranges_[i];
+    if (!range.ended_) {
+      continue;
+    }
+    seconds[i] = range.stream_
+        ? range.endMark_->elapsedSeconds(*range.startMark_)
+        : range.seconds_;
+    if (range.parent_ >= 0) {
+      childSeconds[range.parent_ - firstId_] += seconds[i];
+    }
+  }
+
+  std::vector<OpStats> stats(keys_.size());
+  std::vector<std::vector<int64_t>> durations(keys_.size());
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    stats[i].name = keys_[i].first;
+    stats[i].shape = keys_[i].second;
+  }
+  for (size_t i = 0; i < ranges_.size(); ++i) {
+    if (!ranges_[i].ended_) {
+      continue;
+    }
+    auto& opStats = stats[ranges_[i].key_];
+    ++opStats.calls;
+    opStats.totalSeconds += seconds[i];
+    // children timed on another clock may exceed their parent
+    opStats.selfSeconds += std::max(0., seconds[i] - childSeconds[i]);
+    durations[ranges_[i].key_].push_back(seconds[i] * 1e9);
+  }
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    stats[i].durations = FixedBucketSizeHistogram<int64_t>(
+        durations[i].begin(), durations[i].end(), kHistogramBuckets);
+  }
+  stats.erase(
+      std::remove_if(
+          stats.begin(),
+          stats.end(),
+          [](const OpStats& opStats) { return opStats.calls == 0; }),
+      stats.end());
+  std::sort(stats.begin(), stats.end(), [](const auto& a, const auto& b) {
+    return a.selfSeconds > b.selfSeconds;
+  });
+  return stats;
+}
+
+void OpProfiler::writeFlatProfile(std::ostream& ostream, size_t maxRows) {
+  const auto stats = getStats();
+  double selfSeconds = 0;
+  for (const auto& opStats : stats) {
+    selfSeconds += opStats.selfSeconds;
+  }
+  const auto flags = ostream.flags();
+  const auto precision = ostream.precision();
+  ostream << std::fixed << std::setprecision(2) << std::setw(7) << "%self"
+          << std::setw(12) << "self(ms)" << std::setw(12) << "total(ms)"
+          << std::setw(10) << "calls" << std::setw(12) << "mean(us)"
+          << "  name [shape]\n";
+  const size_t rows =
+      maxRows > 0 ? std::min(maxRows, stats.size()) : stats.size();
+  for (size_t i = 0; i < rows; ++i) {
+    const auto& opStats = stats[i];
+    ostream << std::setw(7)
+            << (selfSeconds > 0 ? 100 * opStats.selfSeconds / selfSeconds : 0)
+            << std::setw(12) << opStats.selfSeconds * 1e3 << std::setw(12)
+            << opStats.totalSeconds * 1e3 << std::setw(10) << opStats.calls
+            << std::setw(12) << opStats.totalSeconds * 1e6 / opStats.calls
+            << "  " << opStats.name;
+    if (!opStats.shape.empty()) {
+      ostream << " " << opStats.shape;
+    }
+    ostream << "\n";
+  }
+  ostream.flags(flags);
+  ostream.precision(precision);
+  ostream << std::flush;
+}
+
+void OpProfiler::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  firstId_ += ranges_.size();
+  keyIndices_.clear();
+  keys_.clear();
+  ranges_.clear();
+}
+
+OpProfileRange::OpProfileRange(
+    std::string name,
+    std::string shape /* = "" */,
+    const Stream* stream /* = nullptr */)
+    : id_(OpProfiler::getInstance().begin(
+          std::move(name),
+          std::move(shape),
+          stream)) {}
+
+OpProfileRange::~OpProfileRange() {
+  OpProfiler::getInstance().end(id_);
+}
+
+ScopedOpProfile::ScopedOpProfile(
+    std::ostream& ostream /* = std::cout */,
+    size_t maxRows /* = 50 */)
+    : ostream_(ostream), maxRows_(maxRows) {
+  OpProfiler::getInstance().enable();
+}
+
+ScopedOpProfile::~ScopedOpProfile() {
+  auto& profiler = OpProfiler::getInstance();
+  profiler.disable();
+  profiler.writeFlatProfile(ostream_, maxRows_);
+}
+
+} // namespace fl
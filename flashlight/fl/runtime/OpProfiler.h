@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/common/Histogram.h"
+#include "flashlight/fl/runtime/Event.h"
+#include "flashlight/fl/runtime/Stream.h"
+
+namespace fl {
+
+/**
+ * A singleton which aggregates the time spent in named ranges, e.g. of tensor
+ * ops, autograd functions and their gradients (see `FL_PROFILE_OP`), by name
+ * and shape, into a flat profile.
+ *
+ * Ranges may nest, e.g. the tensor ops of an autograd function: the total
+ * time of a range includes that of the ranges it encloses on the same thread,
+ * and its self time excludes it. Ranges on CUDA streams are timed by events
+ * recorded on their stream, so they measure the execution of the enclosed
+ * work rather than its enqueueing; other ranges are timed on the host.
+ * Nothing is recorded unless the profiler is enabled.
+ */
+class OpProfiler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * The aggregated ranges of a name and shape.
+   */
+  struct OpStats {
+    std::string name;
+    std::string shape;
+    size_t calls{0};
+    double totalSeconds{0};
+    double selfSeconds{0};
+    // of the total durations of the calls, in nanoseconds
+    HistogramStats<int64_t> durations;
+  };
+
+  /**
+   * Gets the singleton OpProfiler.
+   *
+   * @return a reference to the singleton OpProfiler.
+   */
+  static OpProfiler& getInstance();
+
+  /**
+   * Clear the recorded ranges and start recording.
+   */
+  void enable();
+
+  /**
+   * Stop recording; the ranges are kept until the next `enable` or `clear`.
+   */
+  void disable();
+
+  /**
+   * @return whether the profiler is recording.
+   */
+  bool isEnabled() const {
+    return enabled_;
+  }
+
+  /**
+   * Start a range on the calling thread, nested in its innermost open range.
+   *
+   * @param[in] name the name of the range, e.g. of an op.
+   * @param[in] shape the shape of the data of the range, if any.
+   * @param[in] stream the stream whose work the range times, if any.
+   * @return the id of the range, to be passed to `end`, or -1 if the profiler
+   * is disabled.
+   */
+  int64_t begin(std::string name, std::string shape, const Stream* stream);
+
+  /**
+   * End the innermost open range of the calling thread, started by `begin`.
+   *
+   * @param[in] id the id of the range, ignored if -1 or cleared.
+   */
+  void end(int64_t id);
+
+  /**
+   * @return the name and shape of the innermost open range of the calling
+   * thread, if any, e.g. to name the gradient of an autograd function.
+   */
+  std::optional<std::pair<std::string, std::string>> currentRange() const;
+
+  /**
+   * Aggregate the recorded ranges; blocks until all recorded device ranges
+   * completed.
+   *
+   * @return the ranges of each name and shape, by decreasing self time.
+   */
+  std::vector<OpStats> getStats();
+
+  /**
+   * Write the aggregated ranges as a table, by decreasing self time, e.g. at
+   * the end of a profiled window.
+   *
+   * @param[in] ostream the stream to write to.
+   * @param[in] maxRows the largest number of rows, 0 for all of them.
+   */
+  void writeFlatProfile(std::ostream& ostream, size_t maxRows = 0);
+
+  /**
+   * Clear the recorded ranges. Ranges which are still open are dropped.
+   */
+  void clear();
+
+ private:
+  struct Range {
+    size_t key_;
+    int64_t parent_; // id of the enclosing range, or -1
+    bool ended_{false};
+    Clock::time_point start_;
+    double seconds_{0}; // of host ranges
+    const Stream* stream_; // of device ranges
+    std::unique_ptr<Event> startMark_;
+    std::unique_ptr<Event> endMark_;
+  };
+
+  OpProfiler() = default;
+
+  mutable std::mutex mutex_;
+  std::atomic<bool> enabled_{false};
+  // the id of `ranges_[0]`, ranges of lower ids were cleared
+  int64_t firstId_{0};
+  std::unordered_map<std::string, size_t> keyIndices_;
+  std::vector<std::pair<std::string, std::string>> keys_; // (name, shape)
+  std::vector<Range> ranges_;
+};
+
+/**
+ * An RAII abstraction to record a range of the `OpProfiler` over the lifetime
+ * of an object. For example:
+ * \code
+   {
+     OpProfileRange range("matmul", "(64, 128)", &stream);
+     // enqueue work on stream
+   }
+ * \endcode
+ */
+class OpProfileRange {
+  const int64_t id_;
+
+ public:
+  /**
+   * @param[in] name the name of the range.
+   * @param[in] shape the shape of the data of the range, if any.
+   * @param[in] stream the stream whose work the range times, if any.
+   */
+  explicit OpProfileRange(
+      std::string name,
+      std::string shape = "",
+      const Stream* stream = nullptr);
+  ~OpProfileRange();
+
+  // no copy/move
+  OpProfileRange(const OpProfileRange&) = delete;
+  OpProfileRange(OpProfileRange&&) = delete;
+  OpProfileRange& operator=(const OpProfileRange&) = delete;
+  OpProfileRange& operator=(OpProfileRange&&) = delete;
+};
+
+/**
+ * An RAII abstraction to profile a window, e.g. some training iterations:
+ * enables the `OpProfiler` over the lifetime of an object, then writes its
+ * flat profile.
+ */
+class ScopedOpProfile {
+  std::ostream& ostream_;
+  const size_t maxRows_;
+
+ public:
+  /**
+   * @param[in] ostream the stream to write the flat profile to.
+   * @param[in] maxRows the largest number of rows, 0 for all of them.
+   */
+  explicit ScopedOpProfile(
+      std::ostream& ostream = std::cout,
+      size_t maxRows = 50);
+  ~ScopedOpProfile();
+};
+
+} // namespace fl
@@ -7,12 +7,15 @@
 
 #pragma once
 
+#include <cstddef>
+#include <memory>
 #include <stdexcept>
 #include <unordered_set>
 
 namespace fl {
 
 class Device;
+class Event;
 
 enum class StreamType {
   CUDA, Synchronous,
@@ -96,6 +99,41 @@ class Stream {
    */
   virtual void relativeSync(
     const std::unordered_set<const Stream*>& waitOns) const;
+
+  /**
+   * Synchronize future tasks on this stream w.r.t. the tasks marked by given
+   * event, i.e., the former can only start after the completion of the latter.
+   * NOTE this function may or may not block the calling thread.
+   *
+   * @param[in] waitOn the event to perform relative synchronization against.
+   */
+  virtual void relativeSync(const Event& waitOn) const = 0;
+
+  /**
+   * Record an event which marks the completion of all current tasks on this
+   * stream.
+   * NOTE this function may or may not block the calling thread.
+   *
+   * @param[in] enableTiming whether the event can be used with
+   * `Event::elapsedSeconds`, which may add overhead.
+   * @return the recorded event.
+   */
+  virtual std::unique_ptr<Event> recordEvent(
+      bool enableTiming = false) const = 0;
+
+  /**
+   * Enqueue a copy of `bytes` bytes from `src` to `dst` on this stream, after
+   * all current tasks on it. Each buffer may be in host memory or in memory of
+   * this stream's device. Both must remain valid until the copy completes,
+   * e.g., as observed via an event recorded afterwards.
+   * NOTE this function may or may not block the calling thread; copies which
+   * involve pageable host memory generally do. See `fl::allocPinnedHost`.
+   *
+   * @param[in] dst the buffer to copy to.
+   * @param[in] src the buffer to copy from.
+   * @param[in] bytes the number of bytes to copy.
+   */
+  virtual void copyAsync(void* dst, const void* src, size_t bytes) const = 0;
 };
 
 /**
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/runtime/StreamTimer.h"
+
+namespace fl {
+
+StreamTimer::StreamTimer(const Stream& stream) : stream_(&stream) {}
+
+void StreamTimer::start() {
+  if (startEvent_) {
+    return;
+  }
+  startEvent_ = stream_->recordEvent(/* enableTiming = */ true);
+}
+
+void StreamTimer::stop() {
+  if (!startEvent_) {
+    return;
+  }
+  pending_.emplace_back(
+      std::move(startEvent_), stream_->recordEvent(/* enableTiming = */ true));
+  // bounds the events held by timers which are rarely read
+  resolve(/* wait = */ false);
+}
+
+bool StreamTimer::isRunning() const {
+  return startEvent_ != nullptr;
+}
+
+double StreamTimer::elapsedSeconds() const {
+  resolve(/* wait = */ true);
+  if (!startEvent_) {
+    return seconds_;
+  }
+  const auto now = stream_->recordEvent(/* enableTiming = */ true);
+  return seconds_ + now->elapsedSeconds(*startEvent_);
+}
+
+void StreamTimer::reset() {
+  startEvent_.reset();
+  pending_.clear();
+  seconds_ = 0;
+}
+
+const Stream& StreamTimer::stream() const {
+  return *stream_;
+}
+
+void StreamTimer::resolve(bool wait) const {
+  // intervals complete in order on the stream
+  size_t resolved = 0;
+  for (; resolved < pending_.size(); ++resolved) {
+    auto& [start, stop] = pending_[resolved];
+    if (!wait && !stop->isReady()) {
+      break;
+    }
+    seconds_ += stop->elapsedSeconds(*start);
+  }
+  pending_.erase(pending_.begin(), pending_.begin() + resolved);
+}
+
+} // namespace fl
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/runtime/Event.h"
+#include "flashlight/fl/runtime/Stream.h"
+
+namespace fl {
+
+/**
+ * Times the work of a stream between `start` and `stop`, with events recorded
+ * on the stream rather than the host clock: on CUDA streams, it measures the
+ * execution of the work enqueued meanwhile without synchronizing with the
+ * device; on other streams, events are recorded on the host. The intervals are
+ * resolved lazily, only blocking on their device work when their total is
+ * read: timing every step costs two events.
+ *
+ * Example:
+ * \code
+   StreamTimer timer(input.stream());
+   for (...) {
+     timer.start();
+     auto output = model(input);
+     timer.stop();
+   }
+   double seconds = timer.elapsedSeconds(); // waits for the last forward
+ * \endcode
+ */
+class StreamTimer {
+ public:
+  /**
+   * @param[in] stream the stream to time, which must outlive the timer.
+   */
+  explicit StreamTimer(const Stream& stream);
+
+  /**
+   * Starts an interval, after the work currently enqueued on the stream. Does
+   * nothing if the timer is running.
+   */
+  void start();
+
+  /**
+   * Ends the interval, after the work currently enqueued on the stream. Does
+   * nothing if the timer isn't running.
+   */
+  void stop();
+
+  bool isRunning() const;
+
+  /**
+   * Blocks until the work of the intervals completed, and returns their total
+   * time, including that of the running interval so far.
+   *
+   * @return the time in seconds.
+   */
+  double elapsedSeconds() const;
+
+  /**
+   * Discards the intervals and stops the timer.
+   */
+  void reset();
+
+  const Stream& stream() const;
+
+ private:
+  // adds the intervals whose work completed to `seconds_`
+  void resolve(bool wait) const;
+
+  const Stream* stream_;
+  std::unique_ptr<Event> startEvent_;
+  // the ended intervals not yet resolved, as (start, stop)
+  mutable std::vector<std::pair<std::unique_ptr<Event>, std::unique_ptr<Event>>>
+      pending_;
+  mutable double seconds_{0};
+};
+
+} // namespace fl
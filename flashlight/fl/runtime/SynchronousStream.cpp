@@ -7,8 +7,22 @@
 
 #include "flashlight/fl/runtime/SynchronousStream.h"
 
+#include <cstring>
+
 namespace fl {
 
+void SynchronousEvent::sync() const {}
+
+bool SynchronousEvent::isReady() const {
+  return true;
+}
+
+double SynchronousEvent::elapsedSeconds(const Event& start) const {
+  return std::chrono::duration<double>(
+             time_ - start.impl<SynchronousEvent>().time_)
+      .count();
+}
+
 X64Device& SynchronousStream::device() {
   return device_;
 }
@@ -21,4 +35,23 @@ void SynchronousStream::relativeSync(const SynchronousStream& waitOn) const {
   waitOn.sync();
 }
 
+void SynchronousStream::relativeSync(const Event& waitOn) const {
+  waitOn.sync();
+}
+
+std::unique_ptr<Event> SynchronousStream::recordEvent(
+    bool /* enableTiming */) const {
+  sync();
+  return std::make_unique<SynchronousEvent>();
+}
+
+void SynchronousStream::copyAsync(
+    void* dst,
+    const void* src,
+    size_t bytes) const {
+  // buffers are on the host; wait for the tasks which may use them
+  sync();
+  std::memcpy(dst, src, bytes);
+}
+
 } // namespace fl
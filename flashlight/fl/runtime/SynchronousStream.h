@@ -7,11 +7,31 @@
 
 #pragma once
 
+#include <chrono>
+
 #include "flashlight/fl/runtime/DeviceManager.h"
+#include "flashlight/fl/runtime/Event.h"
 #include "flashlight/fl/runtime/Stream.h"
 
 namespace fl {
 
+/**
+ * An event recorded on a synchronous stream. Recording synchronizes the stream,
+ * so the event has always completed.
+ */
+class SynchronousEvent : public EventTrait<SynchronousEvent> {
+  // when the event was recorded, i.e., completed
+  const std::chrono::steady_clock::time_point time_{
+      std::chrono::steady_clock::now()};
+
+ public:
+  static constexpr StreamType type = StreamType::Synchronous;
+
+  void sync() const override;
+  bool isReady() const override;
+  double elapsedSeconds(const Event& start) const override;
+};
+
 /**
  * An abstraction for a synchronous stream. The word "synchronous" describes the
  * relative synchronization strategy, i.e., it merely delegates to `sync`.
@@ -31,6 +51,9 @@ class SynchronousStream : public StreamTrait<SynchronousStream> {
   X64Device& device() override;
   const X64Device& device() const override;
   void relativeSync(const SynchronousStream& waitOn) const override;
+  void relativeSync(const Event& waitOn) const override;
+  std::unique_ptr<Event> recordEvent(bool enableTiming = false) const override;
+  void copyAsync(void* dst, const void* src, size_t bytes) const override;
 };
 
 } // namespace fl
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/runtime/ThreadAffinity.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "flashlight/fl/common/Logging.h"
+
+#if FL_BACKEND_CUDA
+  #include "flashlight/fl/runtime/CUDAUtils.h"
+#endif
+
+#ifdef __linux__
+  #include <linux/mempolicy.h>
+  #include <sched.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+namespace fl {
+
+namespace {
+
+#ifdef __linux__
+// parses a sysfs CPU list, e.g. "0-3,8-11"
+std::vector<unsigned> parseCpuList(const std::string& cpuList) {
+  std::vector<unsigned> cpus;
+  std::istringstream ss(cpuList);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || range == "\n") {
+      continue;
+    }
+    const auto dash = range.find('-');
+    const unsigned first = std::stoul(range.substr(0, dash));
+    const unsigned last =
+        dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+    for (unsigned cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+void pinCallingThread(const std::vector<unsigned>& cpus) {
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  for (const auto cpu : cpus) {
+    if (cpu >= CPU_SETSIZE) {
+      throw std::runtime_error(
+          "[setCallingThreadAffinity] invalid core " + std::to_string(cpu));
+    }
+    CPU_SET(cpu, &cpuSet);
+  }
+  if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+    throw std::runtime_error(
+        "[setCallingThreadAffinity] failed to pin the thread to the requested "
+        "cores");
+  }
+}
+
+void preferNumaNode(int numaNode) {
+  constexpr unsigned kBitsPerWord = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> nodeMask(numaNode / kBitsPerWord + 1, 0);
+  nodeMask[numaNode / kBitsPerWord] |= 1UL << (numaNode % kBitsPerWord);
+  // the mask size given to the kernel is in bits, plus one
+  const unsigned long maxNode = nodeMask.size() * kBitsPerWord + 1;
+  if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodeMask.data(), maxNode) !=
+      0) {
+    throw std::runtime_error(
+        "[setCallingThreadAffinity] failed to prefer memory from NUMA node " +
+        std::to_string(numaNode));
+  }
+}
+#endif // __linux__
+
+#if FL_BACKEND_CUDA && defined(__linux__)
+// the NUMA node of the PCI bus of a CUDA device, -1 if unknown
+int getCudaDeviceNumaNode(int nativeId) {
+  char busId[64];
+  FL_CUDA_CHECK(cudaDeviceGetPCIBusId(busId, sizeof(busId), nativeId));
+  std::string path = busId;
+  // sysfs names buses in lower case
+  std::transform(path.begin(), path.end(), path.begin(), [](char c) {
+    return std::tolower(static_cast<unsigned char>(c));
+  });
+  std::ifstream file("/sys/bus/pci/devices/" + path + "/numa_node");
+  int numaNode = -1;
+  if (!(file >> numaNode)) {
+    return -1;
+  }
+  return numaNode;
+}
+#endif
+
+} // namespace
+
+std::vector<unsigned> getNumaNodeCpus(int numaNode) {
+#ifdef __linux__
+  const auto path = "/sys/devices/system/node/node" +
+      std::to_string(numaNode) + "/cpulist";
+  std::ifstream file(path);
+  std::string cpuList;
+  if (numaNode < 0 || !file || !std::getline(file, cpuList)) {
+    throw std::runtime_error(
+        "[getNumaNodeCpus] can't read the cores of NUMA node " +
+        std::to_string(numaNode) + " from " + path);
+  }
+  return parseCpuList(cpuList);
+#else
+  throw std::runtime_error(
+      "[getNumaNodeCpus] NUMA nodes are only supported on Linux");
+#endif
+}
+
+int getDeviceNumaNode() {
+#if FL_BACKEND_CUDA && defined(__linux__)
+  return getCudaDeviceNumaNode(cuda::getActiveDeviceId());
+#else
+  return -1;
+#endif
+}
+
+ThreadAffinity getDeviceThreadAffinity() {
+  ThreadAffinity affinity;
+#if FL_BACKEND_CUDA && defined(__linux__)
+  const int activeId = cuda::getActiveDeviceId();
+  affinity.numaNode = getCudaDeviceNumaNode(activeId);
+  if (affinity.numaNode < 0) {
+    return affinity;
+  }
+  const auto cpus = getNumaNodeCpus(affinity.numaNode);
+  // the position of the device among those of its node
+  int numDevices = 0;
+  FL_CUDA_CHECK(cudaGetDeviceCount(&numDevices));
+  size_t numLocal = 0;
+  size_t position = 0;
+  for (int id = 0; id < numDevices; ++id) {
+    if (getCudaDeviceNumaNode(id) == affinity.numaNode) {
+      if (id == activeId) {
+        position = numLocal;
+      }
+      ++numLocal;
+    }
+  }
+  // contiguous shares, the first ones taking the remainder
+  numLocal = std::min(numLocal, cpus.size());
+  position = std::min(position, numLocal - 1);
+  const size_t share = cpus.size() / numLocal;
+  const size_t remainder = cpus.size() % numLocal;
+  const size_t begin = position * share + std::min(position, remainder);
+  const size_t end = begin + share + (position < remainder ? 1 : 0);
+  affinity.cpus.assign(cpus.begin() + begin, cpus.begin() + end);
+#endif
+  return affinity;
+}
+
+void setCallingThreadAffinity(const ThreadAffinity& affinity) {
+  if (affinity.numaNode < -1) {
+    throw std::invalid_argument(
+        "[setCallingThreadAffinity] invalid NUMA node " +
+        std::to_string(affinity.numaNode));
+  }
+#ifdef __linux__
+  if (affinity.numaNode >= 0) {
+    preferNumaNode(affinity.numaNode);
+  }
+  if (!affinity.cpus.empty()) {
+    pinCallingThread(affinity.cpus);
+  } else if (affinity.numaNode >= 0) {
+    pinCallingThread(getNumaNodeCpus(affinity.numaNode));
+  }
+#else
+  if (!affinity.cpus.empty() || affinity.numaNode >= 0) {
+    throw std::runtime_error(
+        "[setCallingThreadAffinity] core pinning and NUMA nodes are only "
+        "supported on Linux");
+  }
+#endif // __linux__
+}
+
+bool setCallingThreadAffinity(ThreadAffinityPolicy policy) {
+  if (policy == ThreadAffinityPolicy::None) {
+    return true;
+  }
+  try {
+    const auto affinity = getDeviceThreadAffinity();
+    if (affinity.numaNode < 0) {
+      FL_LOG(fl::LogLevel::WARNING)
+          << "setCallingThreadAffinity - the NUMA node of the device is "
+             "unknown, the thread isn't bound";
+      return false;
+    }
+    setCallingThreadAffinity(affinity);
+    return true;
+  } catch (const std::exception& ex) {
+    FL_LOG(fl::LogLevel::WARNING)
+        << "setCallingThreadAffinity - the thread isn't bound: " << ex.what();
+    return false;
+  }
+}
+
+} // namespace fl
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <vector>
+
+namespace fl {
+
+/**
+ * The cores and memory a thread uses, e.g. to keep the threads feeding a
+ * device on the socket it is attached to. Default values leave the thread
+ * as is.
+ */
+struct ThreadAffinity {
+  // cores to which the thread is pinned; if empty and `numaNode` is set, the
+  // cores of `numaNode`
+  std::vector<unsigned> cpus;
+  // NUMA node from which memory is preferably allocated; -1 for none
+  int numaNode{-1};
+};
+
+/**
+ * How the worker threads of a pool, e.g. those of a `PrefetchDataset`, are
+ * bound to cores and memory.
+ */
+enum class ThreadAffinityPolicy {
+  // threads may run anywhere, which the OS decides
+  None,
+  // threads run on a share of the cores of the NUMA node closest to the active
+  // device, and allocate memory, including pinned host buffers, from it; see
+  // `getDeviceThreadAffinity`
+  DeviceNumaNode,
+};
+
+/**
+ * Gets the cores of a NUMA node, from sysfs. Throws on failure, e.g. on
+ * platforms other than Linux.
+ */
+std::vector<unsigned> getNumaNodeCpus(int numaNode);
+
+/**
+ * Gets the NUMA node closest to the active device, i.e. the one of its PCI
+ * bus.
+ *
+ * @return the NUMA node, or -1 if unknown, e.g. for devices other than CUDA
+ * devices or single-node machines
+ */
+int getDeviceNumaNode();
+
+/**
+ * Gets the affinity of the threads feeding the active device: its NUMA node
+ * and an even share of the node's cores among the visible devices closest to
+ * the node, such that the threads of processes driving one device each, e.g.
+ * 4 ranks per socket, neither cross sockets nor compete for cores. Processes
+ * which see one device each share all the cores of its node.
+ *
+ * @return the affinity, empty if the NUMA node of the device is unknown
+ */
+ThreadAffinity getDeviceThreadAffinity();
+
+/**
+ * Binds the calling thread to an affinity: pins it to the cores and prefers
+ * memory from the NUMA node, either of which may be left unset. Throws if
+ * the affinity can't be applied, e.g. on platforms other than Linux.
+ */
+void setCallingThreadAffinity(const ThreadAffinity& affinity);
+
+/**
+ * Binds the calling thread to the affinity of a policy, for its active device.
+ * As affinities only affect performance, and thread pool initialization
+ * functions must not throw, failures are logged rather than thrown.
+ *
+ * @return whether the affinity was applied
+ */
+bool setCallingThreadAffinity(ThreadAffinityPolicy policy);
+
+} // namespace fl
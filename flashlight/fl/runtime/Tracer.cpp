@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/runtime/Tracer.h"
+
+#include <sstream>
+
+#include "flashlight/fl/runtime/Device.h"
+
+namespace fl {
+
+namespace {
+
+// host threads and device streams are shown as two processes
+constexpr int kHostPid = 0;
+constexpr int kDevicePid = 1;
+
+std::string toJsonString(const std::string& str) {
+  std::ostringstream ss;
+  ss << '"';
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        ss << "\\\"";
+        break;
+      case '\\':
+        ss << "\\\\";
+        break;
+      case '\n':
+        ss << "\\n";
+        break;
+      default:
+        ss << c;
+    }
+  }
+  ss << '"';
+  return ss.str();
+}
+
+double toMicroseconds(Tracer::Clock::duration duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+void writeMetadata(
+    std::ostream& ostream,
+    const char* kind,
+    int pid,
+    unsigned tid,
+    const std::string& name) {
+  ostream << "\n  {\"name\": \"" << kind << "\", \"ph\": \"M\", \"pid\": "
+          << pid << ", \"tid\": " << tid
+          << ", \"args\": {\"name\": " << toJsonString(name) << "}}";
+}
+
+void writeRange(
+    std::ostream& ostream,
+    const std::string& name,
+    int pid,
+    unsigned tid,
+    double startUs,
+    double durationUs) {
+  ostream << "\n  {\"name\": " << toJsonString(name)
+          << ", \"ph\": \"X\", \"pid\": " << pid << ", \"tid\": " << tid
+          << ", \"ts\": " << startUs << ", \"dur\": " << durationUs << "}";
+}
+
+} // namespace
+
+Tracer& Tracer::getInstance() {
+  static Tracer instance;
+  return instance;
+}
+
+void Tracer::enable() {
+  clear();
+  enabled_ = true;
+}
+
+void Tracer::disable() {
+  enabled_ = false;
+}
+
+bool Tracer::isEnabled() const {
+  return enabled_;
+}
+
+void Tracer::setThreadName(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  threadNames_[getThreadTrack()] = name;
+}
+
+unsigned Tracer::getThreadTrack() {
+  const auto [iter, inserted] = threadToTrack_.emplace(
+      std::this_thread::get_id(), threadNames_.size());
+  if (inserted) {
+    threadNames_.push_back("Thread " + std::to_string(iter->second));
+  }
+  return iter->second;
+}
+
+unsigned Tracer::getStreamTrack(const Stream& stream) {
+  const auto [iter, inserted] =
+      streamToTrack_.emplace(&stream, streamTracks_.size());
+  if (inserted) {
+    std::ostringstream name;
+    name << stream.device().type() << " " << stream.device().nativeId()
+         << " stream " << iter->second;
+    auto reference = stream.recordEvent(/* enableTiming = */ true);
+    reference->sync();
+    streamTracks_.push_back({name.str(), std::move(reference), Clock::now()});
+  }
+  return iter->second;
+}
+
+void Tracer::recordHostRange(
+    const std::string& name,
+    Clock::time_point start,
+    Clock::time_point end) {
+  if (!enabled_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  hostRanges_.push_back({name, getThreadTrack(), start, end});
+}
+
+std::unique_ptr<Event> Tracer::recordDeviceMark(const Stream& stream) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    getStreamTrack(stream);
+  }
+  return stream.recordEvent(/* enableTiming = */ true);
+}
+
+void Tracer::recordDeviceRange(
+    const std::string& name,
+    const Stream& stream,
+    std::unique_ptr<Event> start,
+    std::unique_ptr<Event> end) {
+  if (!enabled_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  deviceRanges_.push_back(
+      {name, getStreamTrack(stream), std::move(start), std::move(end)});
+}
+
+void Tracer::writeChromeTrace(std::ostream& ostream) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ostream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  writeMetadata(ostream, "process_name", kHostPid, 0, "Host");
+  ostream << ",";
+  writeMetadata(ostream, "process_name", kDevicePid, 0, "Devices");
+  for (unsigned track = 0; track < threadNames_.size(); ++track) {
+    ostream << ",";
+    writeMetadata(ostream, "thread_name", kHostPid, track, threadNames_[track]);
+  }
+  for (unsigned track = 0; track < streamTracks_.size(); ++track) {
+    ostream << ",";
+    writeMetadata(
+        ostream, "thread_name", kDevicePid, track, streamTracks_[track].name_);
+  }
+
+  for (const auto& range : hostRanges_) {
+    ostream << ",";
+    writeRange(
+        ostream,
+        range.name_,
+        kHostPid,
+        range.threadTrack_,
+        toMicroseconds(range.start_ - origin_),
+        toMicroseconds(range.end_ - range.start_));
+  }
+  for (const auto& range : deviceRanges_) {
+    const auto& track = streamTracks_[range.streamTrack_];
+    const double startSeconds = range.start_->elapsedSeconds(*track.reference_);
+    const double endSeconds = range.end_->elapsedSeconds(*track.reference_);
+    ostream << ",";
+    writeRange(
+        ostream,
+        range.name_,
+        kDevicePid,
+        range.streamTrack_,
+        toMicroseconds(track.referenceTime_ - origin_) + startSeconds * 1e6,
+        (endSeconds - startSeconds) * 1e6);
+  }
+  ostream << "\n]}" << std::endl;
+}
+
+void Tracer::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  origin_ = Clock::now();
+  // references may predate the new origin; they're re-recorded on demand
+  streamToTrack_.clear();
+  streamTracks_.clear();
+  hostRanges_.clear();
+  deviceRanges_.clear();
+}
+
+TraceRange::TraceRange(std::string name, const Stream* stream)
+    : name_(std::move(name)),
+      stream_(stream),
+      enabled_(Tracer::getInstance().isEnabled()) {
+  if (!enabled_) {
+    return;
+  }
+  if (stream_) {
+    startMark_ = Tracer::getInstance().recordDeviceMark(*stream_);
+  }
+  start_ = Tracer::Clock::now();
+}
+
+TraceRange::~TraceRange() {
+  if (!enabled_) {
+    return;
+  }
+  auto& tracer = Tracer::getInstance();
+  const auto end = Tracer::Clock::now();
+  tracer.recordHostRange(name_, start_, end);
+  if (stream_) {
+    auto endMark = tracer.recordDeviceMark(*stream_);
+    tracer.recordDeviceRange(
+        name_, *stream_, std::move(startMark_), std::move(endMark));
+  }
+}
+
+} // namespace fl
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "flashlight/fl/runtime/Event.h"
+#include "flashlight/fl/runtime/Stream.h"
+
+namespace fl {
+
+/**
+ * A singleton which records a timeline of host ranges, per thread, and device
+ * ranges, per stream, regardless of the backend. The timeline is exported in
+ * the Chrome trace event format, which chrome://tracing and Perfetto can
+ * display.
+ *
+ * Device ranges are delimited by timed events recorded on their stream, so
+ * they show when the stream executed the enclosed work rather than when it was
+ * enqueued. Nothing is recorded unless the tracer is enabled.
+ */
+class Tracer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Gets the singleton Tracer.
+   *
+   * @return a reference to the singleton Tracer.
+   */
+  static Tracer& getInstance();
+
+  /**
+   * Clear the timeline and start recording.
+   */
+  void enable();
+
+  /**
+   * Stop recording; the timeline is kept until the next `enable` or `clear`.
+   */
+  void disable();
+
+  /**
+   * @return whether the tracer is recording.
+   */
+  bool isEnabled() const;
+
+  /**
+   * Name the calling thread's track in the timeline, e.g. "PrefetchDataset
+   * worker 0". Names persist across `enable` and `clear`.
+   *
+   * @param[in] name the name of the calling thread.
+   */
+  void setThreadName(const std::string& name);
+
+  /**
+   * Record a range on the calling thread's track.
+   *
+   * @param[in] name the name of the range.
+   * @param[in] start when the range started.
+   * @param[in] end when the range ended.
+   */
+  void recordHostRange(
+      const std::string& name,
+      Clock::time_point start,
+      Clock::time_point end);
+
+  /**
+   * Record a timed event on given stream, to be used as the bound of a device
+   * range. The first event recorded on a stream synchronizes it once, to relate
+   * its timeline to the host's.
+   *
+   * @param[in] stream the stream to record the event on.
+   * @return the recorded event.
+   */
+  std::unique_ptr<Event> recordDeviceMark(const Stream& stream);
+
+  /**
+   * Record a range on given stream's track.
+   *
+   * @param[in] name the name of the range.
+   * @param[in] stream the stream on which `start` and `end` were recorded.
+   * @param[in] start marks the start of the range, see `recordDeviceMark`.
+   * @param[in] end marks the end of the range, see `recordDeviceMark`.
+   */
+  void recordDeviceRange(
+      const std::string& name,
+      const Stream& stream,
+      std::unique_ptr<Event> start,
+      std::unique_ptr<Event> end);
+
+  /**
+   * Write the timeline as Chrome trace JSON; blocks until all recorded device
+   * ranges completed.
+   *
+   * @param[in] ostream the stream to write to.
+   */
+  void writeChromeTrace(std::ostream& ostream);
+
+  /**
+   * Clear the timeline.
+   */
+  void clear();
+
+ private:
+  struct HostRange {
+    std::string name_;
+    unsigned threadTrack_;
+    Clock::time_point start_;
+    Clock::time_point end_;
+  };
+
+  struct DeviceRange {
+    std::string name_;
+    unsigned streamTrack_;
+    std::unique_ptr<Event> start_;
+    std::unique_ptr<Event> end_;
+  };
+
+  // Relates a stream's events to the host clock. Streams are only identified
+  // by address, since they may be destroyed before the timeline is written.
+  struct StreamTrack {
+    std::string name_;
+    std::unique_ptr<Event> reference_;
+    Clock::time_point referenceTime_; // host time at which `reference_` was
+                                      // known to have completed
+  };
+
+  Tracer() = default;
+
+  // the track of the calling thread, assumes `mutex_` is held
+  unsigned getThreadTrack();
+
+  // the track of given stream, assumes `mutex_` is held
+  unsigned getStreamTrack(const Stream& stream);
+
+  std::mutex mutex_;
+  std::atomic<bool> enabled_{false};
+  Clock::time_point origin_{Clock::now()};
+  std::unordered_map<std::thread::id, unsigned> threadToTrack_;
+  std::vector<std::string> threadNames_; // by track
+  std::unordered_map<const Stream*, unsigned> streamToTrack_;
+  std::vector<StreamTrack> streamTracks_; // by track
+  std::vector<HostRange> hostRanges_;
+  std::vector<DeviceRange> deviceRanges_;
+};
+
+/**
+ * An RAII abstraction to record a range over the lifetime of an object on the
+ * calling thread's track and, if a stream is given, on the stream's track.
+ * For example:
+ * \code
+   {
+     TraceRange range("allReduce", &stream);
+     // enqueue work on stream
+   }
+ * \endcode
+ */
+class TraceRange {
+  const std::string name_;
+  const Stream* stream_;
+  const bool enabled_;
+  Tracer::Clock::time_point start_;
+  std::unique_ptr<Event> startMark_;
+
+ public:
+  /**
+   * @param[in] name the name of the range.
+   * @param[in] stream the stream on which to also record the range, if any.
+   */
+  explicit TraceRange(std::string name, const Stream* stream = nullptr);
+  ~TraceRange();
+
+  // no copy/move
+  TraceRange(const TraceRange&) = delete;
+  TraceRange(TraceRange&&) = delete;
+  TraceRange& operator=(const TraceRange&) = delete;
+  TraceRange& operator=(TraceRange&&) = delete;
+};
+
+} // namespace fl
@@ -10,3 +10,4 @@
 #include "flashlight/fl/runtime/Device.h"
 #include "flashlight/fl/runtime/DeviceManager.h"
 #include "flashlight/fl/runtime/Stream.h"
+#include "flashlight/fl/runtime/StreamTimer.h"
@@ -108,6 +108,14 @@ int getDeviceCount() {
   return DeviceManager::getInstance().getDeviceCount(fl::kDefaultDeviceType);
 }
 
+void* allocPinnedHost(const size_t bytes) {
+  return defaultTensorBackend().allocPinnedHost(bytes);
+}
+
+void freePinnedHost(void* ptr) {
+  defaultTensorBackend().freePinnedHost(ptr);
+}
+
 namespace detail {
 
 void getMemMgrInfo(
@@ -129,6 +137,14 @@ void setMemMgrFlushInterval(const size_t interval) {
   defaultTensorBackend().setMemMgrFlushInterval(interval);
 }
 
+size_t getMemMgrPeakBytes(const int deviceId) {
+  return defaultTensorBackend().getMemMgrPeakBytes(deviceId);
+}
+
+void resetMemMgrPeakBytes(const int deviceId) {
+  defaultTensorBackend().resetMemMgrPeakBytes(deviceId);
+}
+
 } // namespace detail
 
 } // namespace fl
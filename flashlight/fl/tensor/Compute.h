@@ -152,6 +152,25 @@ void setDevice(const int deviceId);
  */
 int getDeviceCount();
 
+/**
+ * Allocates page-locked (pinned) host memory if the default tensor backend
+ * supports it, and pageable host memory otherwise. Copies between pinned
+ * memory and devices are faster; pass the buffer to `Tensor::fromBuffer` with
+ * `Location::Host` or to `Tensor::host` to opt into them. The ArrayFire CUDA
+ * backend caches pinned allocations, so allocating per batch is cheap.
+ *
+ * @param[in] bytes the size of the buffer in bytes.
+ * @return a pointer to the buffer, which must be freed with `freePinnedHost`.
+ */
+void* allocPinnedHost(const size_t bytes);
+
+/**
+ * Frees a buffer allocated with `allocPinnedHost`.
+ *
+ * @param[in] ptr the buffer to free.
+ */
+void freePinnedHost(void* ptr);
+
 namespace detail {
 
 /**
@@ -198,5 +217,23 @@ void setMemMgrLoggingEnabled(const bool enabled);
  */
 void setMemMgrFlushInterval(const size_t interval);
 
+/**
+ * Returns the largest number of bytes the memory manager held on a device, in
+ * use or cached, since the last call to `resetMemMgrPeakBytes` for it, e.g.
+ * to measure the memory a model needs. Returns 0 for backends that do not
+ * implement memory managers which track it.
+ *
+ * @param[in] deviceId the native id of the device
+ */
+size_t getMemMgrPeakBytes(const int deviceId);
+
+/**
+ * Resets the peak bytes of the memory manager on a device to the bytes it
+ * currently holds. See `getMemMgrPeakBytes`.
+ *
+ * @param[in] deviceId the native id of the device
+ */
+void resetMemMgrPeakBytes(const int deviceId);
+
 } // namespace detail
 } // namespace fl
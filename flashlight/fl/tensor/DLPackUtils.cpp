@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/DLPackUtils.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/runtime/Device.h"
+#include "flashlight/fl/runtime/Stream.h"
+
+namespace fl {
+namespace detail {
+
+namespace {
+
+// Keeps the exported tensor and the arrays DLPack points to alive
+struct DLPackExport {
+  Tensor tensor;
+  std::vector<int64_t> shape;
+  std::vector<int64_t> strides;
+  DLManagedTensor dlTensor{};
+
+  explicit DLPackExport(Tensor&& tensor) : tensor(std::move(tensor)) {}
+};
+
+// Whether the tensor is dense in the given order of its axes, i.e. with unit
+// strides along the first axis of `axes`. Axes of size 1 have any stride.
+bool isDense(const DLTensor& tensor, const std::vector<int>& axes) {
+  int64_t expectedStride = 1;
+  for (const auto axis : axes) {
+    if (tensor.shape[axis] != 1 && tensor.strides[axis] != expectedStride) {
+      return false;
+    }
+    expectedStride *= tensor.shape[axis];
+  }
+  return true;
+}
+
+} // namespace
+
+DLDataType toDLDataType(const fl::dtype type) {
+  const uint8_t bits = fl::getTypeSize(type) * 8;
+  switch (type) {
+    case fl::dtype::f16:
+    case fl::dtype::f32:
+    case fl::dtype::f64:
+      return {kDLFloat, bits, 1};
+    case fl::dtype::bf16:
+      return {kDLBfloat, bits, 1};
+    case fl::dtype::b8:
+      return {kDLBool, bits, 1};
+    case fl::dtype::s16:
+    case fl::dtype::s32:
+    case fl::dtype::s64:
+      return {kDLInt, bits, 1};
+    case fl::dtype::u8:
+    case fl::dtype::u16:
+    case fl::dtype::u32:
+    case fl::dtype::u64:
+      return {kDLUInt, bits, 1};
+  }
+  throw std::invalid_argument("[toDLDataType] unsupported data type");
+}
+
+fl::dtype fromDLDataType(const DLDataType& type) {
+  if (type.lanes == 1) {
+    switch (type.code) {
+      case kDLFloat:
+        switch (type.bits) {
+          case 16:
+            return fl::dtype::f16;
+          case 32:
+            return fl::dtype::f32;
+          case 64:
+            return fl::dtype::f64;
+        }
+        break;
+      case kDLBfloat:
+        if (type.bits == 16) {
+          return fl::dtype::bf16;
+        }
+        break;
+      case kDLBool:
+        if (type.bits == 8) {
+          return fl::dtype::b8;
+        }
+        break;
+      case kDLInt:
+        switch (type.bits) {
+          case 16:
+            return fl::dtype::s16;
+          case 32:
+            return fl::dtype::s32;
+          case 64:
+            return fl::dtype::s64;
+        }
+        break;
+      case kDLUInt:
+        switch (type.bits) {
+          case 8:
+            return fl::dtype::u8;
+          case 16:
+            return fl::dtype::u16;
+          case 32:
+            return fl::dtype::u32;
+          case 64:
+            return fl::dtype::u64;
+        }
+        break;
+    }
+  }
+  throw std::invalid_argument(
+      "[fromDLDataType] unsupported DLPack data type with code " +
+      std::to_string(type.code) + ", " + std::to_string(type.bits) +
+      " bits and " + std::to_string(type.lanes) + " lanes");
+}
+
+DLDevice toDLDevice(const Device& device) {
+  switch (device.type()) {
+    case DeviceType::x64:
+      return {kDLCPU, 0};
+    case DeviceType::CUDA:
+      return {kDLCUDA, device.nativeId()};
+  }
+  throw std::invalid_argument("[toDLDevice] unsupported device type");
+}
+
+bool isSameDevice(const DLDevice& dlDevice, const Device& device) {
+  const auto expected = toDLDevice(device);
+  return dlDevice.device_type == expected.device_type &&
+      dlDevice.device_id == expected.device_id;
+}
+
+DLManagedTensor* exportToDLPack(Tensor tensor) {
+  if (tensor.isSparse()) {
+    throw std::invalid_argument(
+        "[Tensor::toDLPack] sparse tensors can't be exported to DLPack");
+  }
+  auto exported = std::make_unique<DLPackExport>(std::move(tensor));
+  const auto& shape = exported->tensor.shape();
+  int64_t stride = 1;
+  for (const auto dim : shape.get()) {
+    exported->shape.push_back(dim);
+    exported->strides.push_back(stride);
+    stride *= dim;
+  }
+
+  auto& dlTensor = exported->dlTensor.dl_tensor;
+  dlTensor.data = exported->tensor.device<void>();
+  dlTensor.device = toDLDevice(exported->tensor.stream().device());
+  dlTensor.ndim = shape.ndim();
+  dlTensor.dtype = toDLDataType(exported->tensor.type());
+  dlTensor.shape = exported->shape.data();
+  dlTensor.strides = exported->strides.data();
+  dlTensor.byte_offset = 0;
+  // DLPack has no notion of streams, so the data must be ready when shared
+  exported->tensor.stream().sync();
+
+  exported->dlTensor.manager_ctx = exported.get();
+  exported->dlTensor.deleter = [](DLManagedTensor* self) {
+    auto* exported = static_cast<DLPackExport*>(self->manager_ctx);
+    exported->tensor.unlock();
+    delete exported;
+  };
+  return &exported.release()->dlTensor;
+}
+
+DLPackImport importFromDLPack(
+    DLManagedTensor* dlTensor,
+    const std::string& caller) {
+  if (!dlTensor) {
+    throw std::invalid_argument("[" + caller + "] null DLPack tensor");
+  }
+  DLPackImport imported;
+  // owned from now on, so that it's released if it can't be imported
+  imported.owner = std::shared_ptr<DLManagedTensor>(
+      dlTensor, [](DLManagedTensor* self) {
+        if (self->deleter) {
+          self->deleter(self);
+        }
+      });
+
+  const auto& tensor = dlTensor->dl_tensor;
+  imported.type = fromDLDataType(tensor.dtype);
+  imported.device = tensor.device;
+  imported.data = static_cast<char*>(tensor.data) + tensor.byte_offset;
+
+  std::vector<Dim> dims(tensor.shape, tensor.shape + tensor.ndim);
+  // no strides means dense row-major
+  bool isRowMajor = tensor.strides == nullptr;
+  if (!isRowMajor) {
+    std::vector<int> axes(tensor.ndim);
+    for (int i = 0; i < tensor.ndim; ++i) {
+      axes[i] = i;
+    }
+    if (isDense(tensor, axes)) {
+      imported.shape = Shape(std::move(dims));
+      return imported;
+    }
+    std::reverse(axes.begin(), axes.end());
+    isRowMajor = isDense(tensor, axes);
+  }
+  if (!isRowMajor) {
+    throw std::invalid_argument(
+        "[" + caller +
+        "] only dense row-major or column-major DLPack tensors can be "
+        "imported without copies");
+  }
+  imported.shape = Shape(std::vector<Dim>(dims.rbegin(), dims.rend()));
+  return imported;
+}
+
+} // namespace detail
+} // namespace fl
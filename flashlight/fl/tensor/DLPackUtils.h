@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <dlpack/dlpack.h>
+
+#include "flashlight/fl/tensor/Shape.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/Types.h"
+
+namespace fl {
+
+class Device;
+
+namespace detail {
+
+// Utilities shared by tensor backends to implement Tensor::toDLPack() and
+// fl::fromDLPack().
+
+/**
+ * Converts between Flashlight and DLPack data types. Throws if the DLPack
+ * type has no Flashlight equivalent, e.g. vector types.
+ */
+DLDataType toDLDataType(const fl::dtype type);
+fl::dtype fromDLDataType(const DLDataType& type);
+
+/**
+ * @return the DLPack device corresponding to given Flashlight device.
+ */
+DLDevice toDLDevice(const Device& device);
+
+/**
+ * @return whether given DLPack and Flashlight devices are the same.
+ */
+bool isSameDevice(const DLDevice& dlDevice, const Device& device);
+
+/**
+ * Exports a contiguous tensor to DLPack. The returned DLManagedTensor holds
+ * a shallow copy of `tensor`, whose memory is locked via Tensor::device()
+ * until the DLManagedTensor's deleter is called. Waits for the tensor's
+ * pending computations.
+ *
+ * @param[in] tensor a contiguous tensor
+ * @return a DLManagedTensor owned by the caller
+ */
+DLManagedTensor* exportToDLPack(Tensor tensor);
+
+/**
+ * A DLPack tensor being imported, in Flashlight's terms.
+ */
+struct DLPackImport {
+  // with axes reversed if the DLPack tensor is row-major
+  Shape shape;
+  fl::dtype type;
+  // the first element, i.e. including the DLPack tensor's byte offset
+  void* data{nullptr};
+  DLDevice device;
+  // calls the DLManagedTensor's deleter once destroyed
+  std::shared_ptr<DLManagedTensor> owner;
+};
+
+/**
+ * Takes ownership of given DLPack tensor and describes it, or throws if it
+ * can't be imported without copies.
+ *
+ * @param[in] dlTensor the DLPack tensor to import
+ * @param[in] caller the function importing the tensor, for error messages
+ */
+DLPackImport importFromDLPack(
+    DLManagedTensor* dlTensor,
+    const std::string& caller);
+
+} // namespace detail
+} // namespace fl
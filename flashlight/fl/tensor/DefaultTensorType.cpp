@@ -7,11 +7,13 @@
 
 #include "flashlight/fl/tensor/DefaultTensorType.h"
 
+#include "flashlight/fl/tensor/TensorAdapter.h"
+
 namespace fl {
 
 TensorBackend& defaultTensorBackend() {
-  // TODO: improve this implementation! Hacky/requires creating a tensor
-  return Tensor().backend();
+  // the creator caches the backend, rather than creating a tensor per call
+  return detail::DefaultTensorType::getInstance().getTensorCreator().backend();
 }
 
 } // namespace fl
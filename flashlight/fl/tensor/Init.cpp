@@ -10,7 +10,9 @@
 #include <iostream>
 #include <string>
 
+#include "flashlight/fl/runtime/DeviceManager.h"
 #include "flashlight/fl/tensor/DefaultTensorType.h"
+#include "flashlight/fl/tensor/Init.h"
 #include "flashlight/fl/tensor/TensorBackend.h"
 
 namespace fl {
@@ -18,15 +20,17 @@ namespace {
 std::once_flag flInitFlag;
 }
 
-/**
- * Initialize Flashlight. Performs setup, including:
- * - Ensures ArrayFire globals are initialized
- * - Sets the default memory manager (CachingMemoryManager)
- *
- * Can only be called once per process. Subsequent calls will be noops.
- */
-void init() {
-  std::call_once(flInitFlag, []() { defaultTensorBackend(); });
+void init(const InitOptions& options /* = {} */) {
+  std::call_once(flInitFlag, [&options]() {
+    if (options.cpuOnly) {
+      DeviceManager::setCPUOnly();
+    }
+    if (options.eager) {
+      // initializes ArrayFire globals and the default memory manager
+      // (CachingMemoryManager)
+      defaultTensorBackend();
+    }
+  });
 }
 
 } // namespace fl
@@ -9,9 +9,32 @@
 
 namespace fl {
 
+/**
+ * Options of `fl::init`.
+ */
+struct InitOptions {
+  /**
+   * Restricts Flashlight to the CPU: CUDA is never initialized, and tensor
+   * backends requiring it fail on first use. Also enabled by setting the
+   * FL_CPU_ONLY environment variable to 1. See `DeviceManager::setCPUOnly`.
+   */
+  bool cpuOnly{false};
+  /**
+   * Initializes the default tensor backend, its devices and memory manager
+   * now rather than on the first use of a tensor.
+   */
+  bool eager{false};
+};
+
 /**
  * Initialize Flashlight.
+ *
+ * The default tensor backend, e.g. ArrayFire, and its memory manager are
+ * initialized on the first use of a tensor, and devices on their first use,
+ * such that programs which don't compute on tensors start fast.
+ *
+ * Can only be called once per process. Subsequent calls will be noops.
  */
-void init();
+void init(const InitOptions& options = {});
 
 } // namespace fl
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/Profile.h"
+
+#if FL_BACKEND_CUDA
+  #include <cuda_profiler_api.h>
+  #include <nvToolsExt.h>
+
+  #include "flashlight/fl/runtime/CUDAUtils.h"
+#endif
+
+namespace fl {
+namespace detail {
+
+ScopedProfiler::ScopedProfiler() {
+  Tracer::getInstance().enable();
+#if FL_BACKEND_CUDA
+  FL_CUDA_CHECK(cudaProfilerStart());
+#endif
+}
+
+ScopedProfiler::~ScopedProfiler() {
+#if FL_BACKEND_CUDA
+  FL_CUDA_CHECK(cudaProfilerStop());
+#endif
+  Tracer::getInstance().disable();
+}
+
+ProfileTracer::ProfileTracer(const std::string& name, const Stream* stream)
+    : range_(name, stream), opRange_(name, "", stream) {
+#if FL_BACKEND_CUDA
+  nvtxRangePush(name.c_str());
+#endif
+}
+
+ProfileTracer::~ProfileTracer() {
+#if FL_BACKEND_CUDA
+  nvtxRangePop();
+#endif
+}
+
+OpProfileTracer::OpProfileTracer(const char* name, const Tensor& tensor) {
+  if (OpProfiler::getInstance().isEnabled()) {
+    range_ = std::make_unique<OpProfileRange>(
+        name, tensor.shape().toString(), &tensor.stream());
+  }
+}
+
+} // namespace detail
+} // namespace fl
@@ -7,13 +7,19 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
+#include "flashlight/fl/runtime/OpProfiler.h"
+#include "flashlight/fl/runtime/Tracer.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
 namespace fl {
 namespace detail {
 
 /**
- * An RAII abstraction to start and stop profiling recording.
+ * An RAII abstraction to start and stop profiling recording, i.e., the
+ * Tracer's timeline and, under CUDA, the CUDA profiler.
  */
 class ScopedProfiler {
  public:
@@ -23,7 +29,8 @@ class ScopedProfiler {
 
 /**
  * An RAII abstractiont to label a profile interval over the lifetime for an
- object given a specific scope. For example:
+ object given a specific scope, as a Tracer range, an OpProfiler range and,
+ under CUDA, an NVTX range. For example:
  * \code
    {
      ProfileTracer tr("myOperation");
@@ -33,11 +40,32 @@ class ScopedProfiler {
  * \endcode
  */
 class ProfileTracer {
+  TraceRange range_;
+  OpProfileRange opRange_;
+
  public:
-  explicit ProfileTracer(const std::string& name);
+  /**
+   * @param[in] name the name of the interval.
+   * @param[in] stream a stream on which to also trace the interval, if any.
+   */
+  explicit ProfileTracer(
+      const std::string& name,
+      const Stream* stream = nullptr);
   ~ProfileTracer();
 };
 
+/**
+ * An RAII abstraction to time an op in the OpProfiler, aggregated by its name
+ * and the shape of a tensor, e.g. its first input, on the stream of the
+ * tensor. Nothing is computed unless the OpProfiler is enabled.
+ */
+class OpProfileTracer {
+  std::unique_ptr<OpProfileRange> range_;
+
+ public:
+  OpProfileTracer(const char* name, const Tensor& tensor);
+};
+
 } // namespace detail
 } // namespace fl
 
@@ -48,10 +76,22 @@ class ProfileTracer {
 #define FL_PROFILE_TRACE(name) \
   fl::detail::ProfileTracer _FL_PROFILE_CAT(profileTracer, __LINE__)(name);
 
+// Also traces the interval on given stream (a `const fl::Stream*`)
+#define FL_PROFILE_TRACE_STREAM(name, stream) \
+  fl::detail::ProfileTracer _FL_PROFILE_CAT(profileTracer, __LINE__)( \
+      name, stream);
+
 #define FL_SCOPED_PROFILE() \
   fl::detail::ScopedProfiler _FL_PROFILE_CAT(scopedProfile, __LINE__);
 
+// Times an op in the OpProfiler, given a tensor of the op (a `fl::Tensor`)
+#define FL_PROFILE_OP(name, tensor) \
+  fl::detail::OpProfileTracer _FL_PROFILE_CAT(opProfileTracer, __LINE__)( \
+      name, tensor);
+
 #else
 #define FL_PROFILE_TRACE(_)
+#define FL_PROFILE_TRACE_STREAM(name, stream)
 #define FL_SCOPED_PROFILE()
+#define FL_PROFILE_OP(name, tensor)
 #endif
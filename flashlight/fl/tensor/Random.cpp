@@ -7,22 +7,154 @@
 
 #include "flashlight/fl/tensor/Random.h"
 
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
 #include "flashlight/fl/tensor/DefaultTensorType.h"
 #include "flashlight/fl/tensor/TensorBackend.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
 namespace fl {
 
+namespace {
+
+// Philox4x32-10 constants, see Salmon et al.
+constexpr uint64_t kPhiloxM0 = 0xD2511F53;
+constexpr uint64_t kPhiloxM1 = 0xCD9E8D57;
+constexpr uint32_t kPhiloxW0 = 0x9E3779B9;
+constexpr uint32_t kPhiloxW1 = 0xBB67AE85;
+constexpr int kPhiloxRounds = 10;
+
+constexpr uint64_t kWordBits = 32;
+constexpr uint64_t kWordMask = 0xFFFFFFFF;
+
+// The state of the innermost RandomStateScope of the thread, if any
+thread_local RandomState* scopedState = nullptr;
+
+bool isFloatingPoint(const dtype type) {
+  return type == dtype::bf16 || type == dtype::f16 || type == dtype::f32 ||
+      type == dtype::f64;
+}
+
+// The random words of the next `count` counters of `state`, which is advanced
+std::array<Tensor, 4> nextRandomWords(RandomState& state, const Dim count) {
+  auto counters = fl::arange({count}, 0, fl::dtype::u64) + state.offset;
+  state.offset += count;
+  auto zeros = fl::full({count}, 0, fl::dtype::u64);
+  return detail::philox4x32(
+      {counters & kWordMask, counters >> kWordBits, zeros, zeros},
+      static_cast<uint32_t>(state.seed),
+      static_cast<uint32_t>(state.seed >> kWordBits));
+}
+
+// The number of significant bits of floating point types
+uint64_t getPrecision(const dtype type, const char* caller) {
+  switch (type) {
+    case dtype::bf16:
+      return 8;
+    case dtype::f16:
+      return 11;
+    case dtype::f32:
+      return 24;
+    case dtype::f64:
+      return 53;
+    default:
+      throw std::invalid_argument(
+          std::string("[") + caller +
+          "] random numbers must have a floating point type");
+  }
+}
+
+// Uniform numbers in [0, 1) with the precision of `type`, from the random
+// words `high` and `low`
+Tensor toUniform(
+    const Tensor& high,
+    const Tensor& low,
+    const dtype type,
+    const char* caller) {
+  const uint64_t precision = getPrecision(type, caller);
+  const double scale = std::ldexp(1., -static_cast<int>(precision));
+  if (precision > kWordBits) {
+    auto bits = (high << (precision - kWordBits)) |
+        (low >> (2 * kWordBits - precision));
+    return bits.astype(dtype::f64) * scale;
+  }
+  // exact in float32, and thus in narrower types
+  auto bits = high >> (kWordBits - precision);
+  return (bits.astype(dtype::f32) * scale).astype(type);
+}
+
+} // namespace
+
 void setSeed(const int seed) {
   defaultTensorBackend().setSeed(seed);
 }
 
 Tensor randn(const Shape& shape, dtype type) {
+  if (scopedState && isFloatingPoint(type)) {
+    return randn(shape, *scopedState, type);
+  }
   return defaultTensorBackend().randn(shape, type);
 }
 
 Tensor rand(const Shape& shape, dtype type) {
+  if (scopedState && isFloatingPoint(type)) {
+    return rand(shape, *scopedState, type);
+  }
   return defaultTensorBackend().rand(shape, type);
 }
 
+Tensor randn(const Shape& shape, RandomState& state, dtype type) {
+  constexpr const char* caller = "fl::randn";
+  getPrecision(type, caller); // checks the type is floating point
+  const auto computeType = type == dtype::f64 ? dtype::f64 : dtype::f32;
+  auto words = nextRandomWords(state, shape.elements());
+  // Box-Muller transform, with the first uniform number in (0, 1]
+  auto radius = fl::sqrt(
+      -2 * fl::log(1 - toUniform(words[0], words[1], computeType, caller)));
+  auto angle = 2 * M_PI * toUniform(words[2], words[3], computeType, caller);
+  return fl::reshape(radius * fl::cos(angle), shape).astype(type);
+}
+
+Tensor rand(const Shape& shape, RandomState& state, dtype type) {
+  auto words = nextRandomWords(state, shape.elements());
+  return fl::reshape(toUniform(words[0], words[1], type, "fl::rand"), shape);
+}
+
+RandomStateScope::RandomStateScope(RandomState& state)
+    : prevState_(scopedState) {
+  scopedState = &state;
+}
+
+RandomStateScope::~RandomStateScope() {
+  scopedState = prevState_;
+}
+
+namespace detail {
+
+std::array<Tensor, 4> philox4x32(
+    const std::array<Tensor, 4>& counter,
+    uint32_t key0,
+    uint32_t key1) {
+  auto result = counter;
+  for (int round = 0; round < kPhiloxRounds; ++round) {
+    if (round > 0) {
+      key0 += kPhiloxW0;
+      key1 += kPhiloxW1;
+    }
+    // the products of 32-bit words are exact in 64 bits
+    auto product0 = result[0] * kPhiloxM0;
+    auto product1 = result[2] * kPhiloxM1;
+    result = {
+        (product1 >> kWordBits) ^ result[1] ^ static_cast<uint64_t>(key0),
+        product1 & kWordMask,
+        (product0 >> kWordBits) ^ result[3] ^ static_cast<uint64_t>(key1),
+        product0 & kWordMask};
+  }
+  return result;
+}
+
+} // namespace detail
+
 } // namespace fl
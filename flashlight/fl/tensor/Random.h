@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
+
 #include "flashlight/fl/tensor/Shape.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 #include "flashlight/fl/tensor/Types.h"
@@ -41,4 +44,94 @@ Tensor randn(const Shape& shape, dtype type = dtype::f32);
  */
 Tensor rand(const Shape& shape, dtype type = dtype::f32);
 
+/**
+ * The state of a counter-based random number generator, which random numbers
+ * are a function of a seed and of their position in the sequence, unlike the
+ * generator of the backend behind `setSeed`.
+ *
+ * Random numbers are thus reproducible bitwise given the state, regardless of
+ * the order in which tensors are evaluated, and independent streams are
+ * obtained from distinct seeds, or from disjoint ranges of offsets, e.g. one
+ * per device or thread.
+ *
+ * The generator is Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As
+ * Easy as 1, 2, 3", SC 2011), computed elementwise with tensor operations
+ * such that it's fused with the operations using its numbers by backends with
+ * a JIT.
+ */
+struct RandomState {
+  /// The seed, i.e. the key of the generator
+  uint64_t seed{0};
+  /// The position of the next random numbers in the sequence of the seed
+  uint64_t offset{0};
+
+  RandomState() = default;
+  explicit RandomState(uint64_t seed, uint64_t offset = 0)
+      : seed(seed), offset(offset) {}
+};
+
+/**
+ * Initialize a tensor with elements sampled from the standard normal
+ * distribution with a counter-based generator, which state is advanced by the
+ * number of elements.
+ *
+ * @param[in] shape the shape of the tensor to create
+ * @param[in,out] state the state of the generator
+ * @param[in] type the floating point type of the tensor. Defaults to float
+ * @return a tensor with the given dimensions with elements sampled accordingly
+ */
+Tensor randn(const Shape& shape, RandomState& state, dtype type = dtype::f32);
+
+/**
+ * Initialize a tensor with elements sampled uniformly from the interval [0, 1)
+ * with a counter-based generator, which state is advanced by the number of
+ * elements.
+ *
+ * @param[in] shape the shape of the tensor to create
+ * @param[in,out] state the state of the generator
+ * @param[in] type the floating point type of the tensor. Defaults to float
+ * @return a tensor with the given dimensions with elements sampled accordingly
+ */
+Tensor rand(const Shape& shape, RandomState& state, dtype type = dtype::f32);
+
+/**
+ * An RAII scope in which, on the current thread, `fl::rand` and `fl::randn`
+ * draw floating point numbers from the counter-based generator with `state`
+ * rather than from the backend's generator. Random numbers drawn in the scope,
+ * e.g. dropout masks, can thus be drawn again by a scope with the same state,
+ * see `Checkpoint`. Scopes can be nested.
+ */
+class RandomStateScope {
+  RandomState* prevState_;
+
+ public:
+  /**
+   * @param[in,out] state the state of the generator, which must outlive the
+   * scope, and which is advanced by the numbers drawn in it
+   */
+  explicit RandomStateScope(RandomState& state);
+  ~RandomStateScope();
+
+  // no copy/move
+  RandomStateScope(const RandomStateScope&) = delete;
+  RandomStateScope(RandomStateScope&&) = delete;
+  RandomStateScope& operator=(const RandomStateScope&) = delete;
+  RandomStateScope& operator=(RandomStateScope&&) = delete;
+};
+
+namespace detail {
+
+/**
+ * Applies the Philox4x32-10 bijection to counters of 4 32-bit words, given as
+ * u64 tensors holding values smaller than 2^32, with the key of 2 words.
+ *
+ * @return the 4 random 32-bit words of each counter, as u64 tensors
+ */
+std::array<Tensor, 4> philox4x32(
+    const std::array<Tensor, 4>& counter,
+    uint32_t key0,
+    uint32_t key1);
+
+} // namespace detail
+
 } // namespace fl
@@ -9,19 +9,19 @@
 
 #include <algorithm>
 #include <limits>
-#include <numeric>
 #include <sstream>
 #include <stdexcept>
 
 namespace fl {
 
-Shape::Shape(std::vector<Dim> d) : dims_(std::move(d)) {}
-Shape::Shape(std::initializer_list<Dim> d) : Shape(std::vector<Dim>(d)) {}
+Shape::Shape(const std::vector<Dim>& d) : dims_(d) {}
+Shape::Shape(Dims d) : dims_(std::move(d)) {}
+Shape::Shape(std::initializer_list<Dim> d) : dims_(d) {}
 
 const Dim kEmptyShapeNumberOfElements = 1;
 
 void Shape::checkDimsOrThrow(const size_t dim) const {
-  if (dim > ndim() - 1) {
+  if (dim >= dims_.size()) {
     std::stringstream ss;
     ss << "Shape index " << std::to_string(dim)
        << " out of bounds for shape with " << std::to_string(dims_.size())
@@ -31,10 +31,11 @@ void Shape::checkDimsOrThrow(const size_t dim) const {
 }
 
 Dim Shape::elements() const {
-  if (dims_.size() == 0) {
-    return kEmptyShapeNumberOfElements;
+  Dim elements = kEmptyShapeNumberOfElements;
+  for (const auto dim : dims_) {
+    elements *= dim;
   }
-  return std::accumulate(dims_.begin(), dims_.end(), 1, std::multiplies<Dim>());
+  return elements;
 }
 
 int Shape::ndim() const {
@@ -73,13 +74,13 @@ bool Shape::operator!=(const std::initializer_list<Dim>& other) const {
   return !(this->operator==(other));
 }
 
-const std::vector<Dim>& Shape::get() const {
+const Shape::Dims& Shape::get() const {
   return dims_;
 }
 
-std::vector<Dim>& Shape::get() {
+Shape::Dims& Shape::get() {
   return dims_;
-};
+}
 
 std::string Shape::toString() const {
   std::stringstream ss;
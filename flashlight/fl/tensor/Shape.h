@@ -13,6 +13,8 @@
 #include <utility>
 #include <vector>
 
+#include "flashlight/fl/common/SmallVector.h"
+
 namespace fl {
 
 // The type of a dimension.
@@ -38,11 +40,26 @@ using Dim = long long;
  *
  * Shape is an interface and can be derived from or implemented given specific
  * backing storage or handles.
+ *
+ * Dimensions are stored inline up to `kInlineDims`, such that creating or
+ * copying the shapes of most tensors doesn't allocate.
  */
 class Shape {
+ public:
+  /**
+   * The number of dimensions stored without a heap allocation.
+   */
+  static constexpr size_t kInlineDims = 6;
+
+  /**
+   * The storage of the dimensions, which converts to a `std::vector<Dim>`.
+   */
+  using Dims = SmallVector<Dim, kInlineDims>;
+
+ private:
   // Storage for the dimension values. Defaults to an empty Shape {0}, whereas
   // {} is a scalar shape.
-  std::vector<Dim> dims_;
+  Dims dims_;
 
   /**
    * Check if a dimension is valid (i.e. in bounds) given the current size of
@@ -65,7 +82,12 @@ class Shape {
   /**
    * Initialize a Shape via a vector.
    */
-  explicit Shape(std::vector<Dim> d);
+  explicit Shape(const std::vector<Dim>& d);
+
+  /**
+   * Initialize a Shape via its dimension storage, without allocating.
+   */
+  explicit Shape(Dims d);
 
   /**
    * Initialize a Shape via an initializer list.
@@ -109,10 +131,11 @@ class Shape {
   bool operator!=(const std::initializer_list<Dim>& other) const;
 
   /**
-   * Gets a reference to the underying dims vector.
+   * Gets a reference to the underying dims, which convert to a
+   * `std::vector<Dim>`.
    */
-  const std::vector<Dim>& get() const;
-  std::vector<Dim>& get();
+  const Dims& get() const;
+  Dims& get();
 
   /**
    * Returns a string representation of the Shape
@@ -10,13 +10,21 @@
 #include <memory>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 #include "flashlight/fl/tensor/DefaultTensorType.h"
+#include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/TensorBackend.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
-
 namespace fl {
+
+Tensor TensorAdapterBase::indexArray(
+    const Index* indices,
+    size_t numIndices) {
+  return index(std::vector<Index>(indices, indices + numIndices));
+}
+
 namespace detail {
 
 DefaultTensorType& DefaultTensorType::getInstance() {
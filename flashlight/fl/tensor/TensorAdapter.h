@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <utility>
@@ -158,6 +159,11 @@ class TensorAdapterBase {
    */
   virtual bool isContiguous() = 0;
 
+  /**
+   * Exports the tensor to DLPack without copying, see Tensor::toDLPack().
+   */
+  virtual DLManagedTensor* toDLPack() = 0;
+
   /**
    * Get the dimension-wise strides for this tensor - the number of bytes to
    * step in each direction when traversing.
@@ -191,6 +197,17 @@ class TensorAdapterBase {
    */
   virtual Tensor index(const std::vector<Index>& indices) = 0;
 
+  /**
+   * Index into a tensor with a fixed number of indices stored by the caller,
+   * e.g. on the stack by `Tensor::operator()`. Defaults to `index` with a copy
+   * of the indices; backends override it to index without allocating.
+   *
+   * @param[in] indices the first of the indices
+   * @param[in] numIndices the number of indices
+   * @return an indexed tensor
+   */
+  virtual Tensor indexArray(const Index* indices, size_t numIndices);
+
   /**
    * Returns a representation of the tensor in 1 dimension.
    *
@@ -285,6 +302,9 @@ struct TensorCreator {
       const Tensor& rowIdx,
       const Tensor& colIdx,
       StorageType storageType) const = 0;
+
+  // The backend of the created tensors
+  virtual TensorBackend& backend() const = 0;
 };
 
 template <typename T>
@@ -310,6 +330,19 @@ struct TensorCreatorImpl : public TensorCreator {
     return std::make_unique<T>(
         nRows, nCols, values, rowIdx, colIdx, storageType);
   }
+
+  TensorBackend& backend() const override {
+    // created once, rather than with a tensor on every lookup
+    auto* backend = backend_.load(std::memory_order_relaxed);
+    if (!backend) {
+      backend = &get()->backend();
+      backend_.store(backend, std::memory_order_relaxed);
+    }
+    return *backend;
+  }
+
+ private:
+  mutable std::atomic<TensorBackend*> backend_{nullptr};
 };
 
 /*
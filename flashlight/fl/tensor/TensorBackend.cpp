@@ -11,7 +11,8 @@ namespace fl {
 namespace detail {
 
 bool areBackendsEqual(const Tensor& a, const Tensor& b) {
-  return a.backendType() == b.backendType();
+  // the backends are cached on tensors, and usually the same instance
+  return &a.backend() == &b.backend() || a.backendType() == b.backendType();
 }
 
 } // namespace detail
@@ -24,6 +25,20 @@ bool TensorBackend::isDataTypeSupported(const fl::dtype& dtype) const {
   return supported;
 }
 
+size_t TensorBackend::getMemMgrPeakBytes(const int /* deviceId */) {
+  return 0;
+}
+
+void TensorBackend::resetMemMgrPeakBytes(const int /* deviceId */) {}
+
+void* TensorBackend::allocPinnedHost(const size_t bytes) {
+  return new char[bytes];
+}
+
+void TensorBackend::freePinnedHost(void* ptr) {
+  delete[] static_cast<char*>(ptr);
+}
+
 Tensor TensorBackend::clip(
     const Tensor& tensor,
     const Tensor& low,
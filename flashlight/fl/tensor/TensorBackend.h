@@ -48,6 +48,12 @@ class TensorBackend {
   virtual void setMemMgrLogStream(std::ostream* stream) = 0;
   virtual void setMemMgrLoggingEnabled(const bool enabled) = 0;
   virtual void setMemMgrFlushInterval(const size_t interval) = 0;
+  // Defaults to 0, for backends whose memory isn't managed
+  virtual size_t getMemMgrPeakBytes(const int deviceId);
+  virtual void resetMemMgrPeakBytes(const int deviceId);
+  // Page-locked host memory; defaults to pageable memory
+  virtual void* allocPinnedHost(const size_t bytes);
+  virtual void freePinnedHost(void* ptr);
 
   /* -------------------------- Rand Functions -------------------------- */
   virtual void setSeed(const int seed) = 0;
@@ -77,6 +83,7 @@ class TensorBackend {
 #undef FL_CREATE_FUN_LITERAL_BACKEND_DECL
 
   virtual Tensor identity(const Dim dim, const dtype type) = 0;
+  virtual Tensor fromDLPack(DLManagedTensor* dlTensor) = 0;
   virtual Tensor
   arange(const Shape& shape, const Dim seqDim, const dtype type) = 0;
   virtual Tensor
@@ -11,6 +11,7 @@
 #include <utility>
 
 #include "flashlight/fl/tensor/DefaultTensorType.h"
+#include "flashlight/fl/tensor/Profile.h"
 #include "flashlight/fl/tensor/TensorAdapter.h"
 #include "flashlight/fl/tensor/TensorBackend.h"
 
@@ -27,14 +28,20 @@ Tensor::Tensor(std::unique_ptr<TensorAdapterBase> adapter)
     : impl_(std::move(adapter)) {}
 
 std::unique_ptr<TensorAdapterBase> Tensor::releaseAdapter() {
+  backend_.store(nullptr, std::memory_order_relaxed);
   return std::move(impl_);
 }
 
 Tensor::~Tensor() {}
 
-Tensor::Tensor(const Tensor& tensor) : impl_(tensor.impl_->clone()) {}
+// clones have the backend of the original
+Tensor::Tensor(const Tensor& tensor)
+    : impl_(tensor.impl_->clone()),
+      backend_(tensor.backend_.load(std::memory_order_relaxed)) {}
 
-Tensor::Tensor(Tensor&& other) noexcept : impl_(std::move(other.impl_)) {}
+Tensor::Tensor(Tensor&& other) noexcept
+    : impl_(std::move(other.impl_)),
+      backend_(other.backend_.exchange(nullptr, std::memory_order_relaxed)) {}
 
 Tensor::Tensor() : impl_(detail::getDefaultAdapter()) {}
 
@@ -67,6 +74,7 @@ Tensor::Tensor(fl::dtype type)
     : impl_(detail::getDefaultAdapter(Shape({0}), type)) {}
 
 Tensor Tensor::copy() const {
+  FL_PROFILE_OP("tensor::copy", *this);
   return impl_->copy();
 }
 
@@ -115,22 +123,32 @@ bool Tensor::isSparse() const {
 }
 
 Tensor Tensor::astype(const dtype type) const {
+  FL_PROFILE_OP("tensor::astype", *this);
   return impl_->astype(type);
 }
 
 Tensor Tensor::operator()(const std::vector<Index>& indices) const {
+  FL_PROFILE_OP("tensor::index", *this);
   return impl_->index(indices);
 }
 
+Tensor Tensor::indexArray(const Index* indices, size_t numIndices) const {
+  FL_PROFILE_OP("tensor::index", *this);
+  return impl_->indexArray(indices, numIndices);
+}
+
 Tensor Tensor::flatten() const {
+  FL_PROFILE_OP("tensor::flatten", *this);
   return impl_->flatten();
 }
 
 Tensor Tensor::flat(const Index& idx) const {
+  FL_PROFILE_OP("tensor::flat", *this);
   return impl_->flat(idx);
 }
 
 Tensor Tensor::asContiguousTensor() const {
+  FL_PROFILE_OP("tensor::asContiguousTensor", *this);
   return impl_->asContiguousTensor();
 }
 
@@ -139,7 +157,13 @@ TensorBackendType Tensor::backendType() const {
 }
 
 TensorBackend& Tensor::backend() const {
-  return impl_->backend();
+  auto* backend = backend_.load(std::memory_order_relaxed);
+  if (!backend) {
+    // adapters always return the same backend, thus racing stores are equal
+    backend = &impl_->backend();
+    backend_.store(backend, std::memory_order_relaxed);
+  }
+  return *backend;
 }
 
 #define FL_CREATE_MEMORY_OPS(TYPE)                                          \
@@ -253,6 +277,10 @@ bool Tensor::isContiguous() const {
   return impl_->isContiguous();
 }
 
+DLManagedTensor* Tensor::toDLPack() const {
+  return impl_->toDLPack();
+}
+
 Shape Tensor::strides() const {
   return impl_->strides();
 }
@@ -278,10 +306,11 @@ std::ostream& Tensor::operator<<(std::ostream& ostr) const {
 }
 
 /******************** Assignment Operators ********************/
-#define FL_ASSIGN_OP_TYPE(OP, FUN, TYPE) \
-  Tensor& Tensor::OP(TYPE val) {         \
-    impl_->FUN(val);                     \
-    return *this;                        \
+#define FL_ASSIGN_OP_TYPE(OP, FUN, TYPE)     \
+  Tensor& Tensor::OP(TYPE val) {             \
+    FL_PROFILE_OP("tensor::" #FUN, *this);   \
+    impl_->FUN(val);                         \
+    return *this;                            \
   }
 #define FL_ASSIGN_TENSOR_OP(OP, FUN) FL_ASSIGN_OP_TYPE(OP, FUN, const Tensor&);
 #define FL_ASSIGN_SCALAR_OP(OP, FUN)                 \
@@ -318,6 +347,9 @@ FL_ASSIGN_OP(operator/=, inPlaceDivide);
 // In such cases, we let `this` take over the tensor data of `other`.
 Tensor& Tensor::operator=(Tensor&& other) & {
   this->impl_ = std::move(other.impl_);
+  backend_.store(
+      other.backend_.exchange(nullptr, std::memory_order_relaxed),
+      std::memory_order_relaxed);
   return *this;
 }
 
@@ -332,6 +364,9 @@ Tensor& Tensor::operator=(Tensor&& other) && {
 // In such cases, we let `this` take over the _cloned_ data from `other`.
 Tensor& Tensor::operator=(const Tensor& other) & {
   this->impl_ = other.impl_->clone();
+  backend_.store(
+      other.backend_.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
   return *this;
 }
 
@@ -373,6 +408,10 @@ Tensor identity(const Dim dim, const dtype type) {
   return defaultTensorBackend().identity(dim, type);
 }
 
+Tensor fromDLPack(DLManagedTensor* dlTensor) {
+  return defaultTensorBackend().fromDLPack(dlTensor);
+}
+
 #define FL_ARANGE_FUN_DEF(TYPE)                                             \
   template <>                                                               \
   Tensor arange(TYPE start, TYPE end, TYPE step, const dtype type) {        \
@@ -400,14 +439,17 @@ Tensor iota(const Shape& dims, const Shape& tileDims, const dtype type) {
 /************************ Shaping and Indexing *************************/
 
 Tensor reshape(const Tensor& tensor, const Shape& shape) {
+  FL_PROFILE_OP("tensor::reshape", tensor);
   return tensor.backend().reshape(tensor, shape);
 }
 
 Tensor transpose(const Tensor& tensor, const Shape& axes /* = {} */) {
+  FL_PROFILE_OP("tensor::transpose", tensor);
   return tensor.backend().transpose(tensor, axes);
 }
 
 Tensor tile(const Tensor& tensor, const Shape& shape) {
+  FL_PROFILE_OP("tensor::tile", tensor);
   return tensor.backend().tile(tensor, shape);
 }
 
@@ -427,10 +469,12 @@ Tensor concatenate(const std::vector<Tensor>& tensors, const unsigned axis) {
         "concatenate: tried to concatenate tensors of different backends");
   }
 
+  FL_PROFILE_OP("tensor::concatenate", tensors.front());
   return tensors.front().backend().concatenate(tensors, axis);
 }
 
 Tensor nonzero(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::nonzero", tensor);
   return tensor.backend().nonzero(tensor);
 }
 
@@ -438,129 +482,159 @@ Tensor pad(
     const Tensor& input,
     const std::vector<std::pair<int, int>>& padWidths,
     const PadType type) {
+  FL_PROFILE_OP("tensor::pad", input);
   return input.backend().pad(input, padWidths, type);
 }
 
 /************************** Unary Operators ***************************/
 Tensor exp(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::exp", tensor);
   return tensor.backend().exp(tensor);
 }
 
 Tensor log(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::log", tensor);
   return tensor.backend().log(tensor);
 }
 
 Tensor negative(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::negative", tensor);
   return tensor.backend().negative(tensor);
 }
 
 Tensor logicalNot(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::logicalNot", tensor);
   return tensor.backend().logicalNot(tensor);
 }
 
 Tensor log1p(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::log1p", tensor);
   return tensor.backend().log1p(tensor);
 }
 
 Tensor sin(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::sin", tensor);
   return tensor.backend().sin(tensor);
 }
 
 Tensor cos(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::cos", tensor);
   return tensor.backend().cos(tensor);
 }
 
 Tensor sqrt(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::sqrt", tensor);
   return tensor.backend().sqrt(tensor);
 }
 
 Tensor tanh(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::tanh", tensor);
   return tensor.backend().tanh(tensor);
 }
 
 Tensor floor(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::floor", tensor);
   return tensor.backend().floor(tensor);
 }
 
 Tensor ceil(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::ceil", tensor);
   return tensor.backend().ceil(tensor);
 }
 
 Tensor rint(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::rint", tensor);
   return tensor.backend().rint(tensor);
 }
 
 Tensor absolute(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::absolute", tensor);
   return tensor.backend().absolute(tensor);
 }
 
 Tensor sigmoid(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::sigmoid", tensor);
   return tensor.backend().sigmoid(tensor);
 }
 
 Tensor erf(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::erf", tensor);
   return tensor.backend().erf(tensor);
 }
 
 Tensor flip(const Tensor& tensor, const unsigned dim) {
+  FL_PROFILE_OP("tensor::flip", tensor);
   return tensor.backend().flip(tensor, dim);
 }
 
 Tensor clip(const Tensor& tensor, const Tensor& low, const Tensor& high) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(tensor, low, high);
+  FL_PROFILE_OP("tensor::clip", tensor);
   return tensor.backend().clip(tensor, low, high);
 }
 
 Tensor clip(const Tensor& tensor, const Tensor& low, const double& high) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(tensor, low);
+  FL_PROFILE_OP("tensor::clip", tensor);
   return tensor.backend().clip(tensor, low, high);
 }
 
 Tensor clip(const Tensor& tensor, const double& low, const Tensor& high) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(tensor, high);
+  FL_PROFILE_OP("tensor::clip", tensor);
   return tensor.backend().clip(tensor, low, high);
 }
 
 Tensor clip(const Tensor& tensor, const double& low, const double& high) {
+  FL_PROFILE_OP("tensor::clip", tensor);
   return tensor.backend().clip(tensor, low, high);
 }
 
 Tensor roll(const Tensor& tensor, const int shift, const unsigned axis) {
+  FL_PROFILE_OP("tensor::roll", tensor);
   return tensor.backend().roll(tensor, shift, axis);
 }
 
 Tensor isnan(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::isnan", tensor);
   return tensor.backend().isnan(tensor);
 }
 
 Tensor isinf(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::isinf", tensor);
   return tensor.backend().isinf(tensor);
 }
 
 Tensor sign(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::sign", tensor);
   return tensor.backend().sign(tensor);
 }
 
 Tensor tril(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::tril", tensor);
   return tensor.backend().tril(tensor);
 }
 
 Tensor triu(const Tensor& tensor) {
+  FL_PROFILE_OP("tensor::triu", tensor);
   return tensor.backend().triu(tensor);
 }
 
 Tensor where(const Tensor& condition, const Tensor& x, const Tensor& y) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(condition, x, y);
+  FL_PROFILE_OP("tensor::where", condition);
   return condition.backend().where(condition, x, y);
 }
 
 Tensor where(const Tensor& condition, const Tensor& x, const double& y) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(condition, x);
+  FL_PROFILE_OP("tensor::where", condition);
   return condition.backend().where(condition, x, y);
 }
 
 Tensor where(const Tensor& condition, const double& x, const Tensor& y) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(condition, y);
+  FL_PROFILE_OP("tensor::where", condition);
   return condition.backend().where(condition, x, y);
 }
 
@@ -572,10 +646,12 @@ void topk(
     const Dim axis,
     const SortMode sortMode /* = SortMode::Descending */) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(values, indices, input);
+  FL_PROFILE_OP("tensor::topk", input);
   input.backend().topk(values, indices, input, k, axis, sortMode);
 }
 
 Tensor sort(const Tensor& input, const Dim axis, const SortMode sortMode) {
+  FL_PROFILE_OP("tensor::sort", input);
   return input.backend().sort(input, axis, sortMode);
 }
 
@@ -585,19 +661,23 @@ void sort(
     const Tensor& input,
     const Dim axis,
     const SortMode sortMode /* = SortMode::Descending */) {
+  FL_PROFILE_OP("tensor::sort", values);
   return values.backend().sort(values, indices, input, axis, sortMode);
 }
 
 Tensor argsort(const Tensor& input, const Dim axis, const SortMode sortMode) {
+  FL_PROFILE_OP("tensor::argsort", input);
   return input.backend().argsort(input, axis, sortMode);
 }
 
 /************************** Binary Operators ***************************/
 #define FL_BINARY_OP_LITERAL_TYPE_DEF(OP, FUNC, TYPE) \
   Tensor FUNC(TYPE lhs, const Tensor& rhs) {          \
+    FL_PROFILE_OP("tensor::" #FUNC, rhs);             \
     return rhs.backend().FUNC(lhs, rhs);              \
   }                                                   \
   Tensor FUNC(const Tensor& lhs, TYPE rhs) {          \
+    FL_PROFILE_OP("tensor::" #FUNC, lhs);             \
     return lhs.backend().FUNC(lhs, rhs);              \
   }                                                   \
   Tensor operator OP(TYPE lhs, const Tensor& rhs) {   \
@@ -625,6 +705,7 @@ Tensor argsort(const Tensor& input, const Dim axis, const SortMode sortMode) {
 #define FL_BINARY_OP_DEF(OP, FUNC)                           \
   Tensor FUNC(const Tensor& lhs, const Tensor& rhs) {        \
     FL_TENSOR_BACKENDS_MATCH_CHECK(lhs, rhs);                \
+    FL_PROFILE_OP("tensor::" #FUNC, lhs);                    \
     return lhs.backend().FUNC(lhs, rhs);                     \
   }                                                          \
   Tensor operator OP(const Tensor& lhs, const Tensor& rhs) { \
@@ -657,40 +738,49 @@ FL_BINARY_OP_DEF(>>, rShift);
 
 Tensor minimum(const Tensor& lhs, const Tensor& rhs) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(lhs, rhs);
+  FL_PROFILE_OP("tensor::minimum", lhs);
   return lhs.backend().minimum(lhs, rhs);
 }
 
 Tensor maximum(const Tensor& lhs, const Tensor& rhs) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(lhs, rhs);
+  FL_PROFILE_OP("tensor::maximum", lhs);
   return lhs.backend().maximum(lhs, rhs);
 }
 
 Tensor minimum(const Tensor& lhs, const double& rhs) {
+  FL_PROFILE_OP("tensor::minimum", lhs);
   return lhs.backend().minimum(lhs, rhs);
 }
 
 Tensor minimum(const double& lhs, const Tensor& rhs) {
+  FL_PROFILE_OP("tensor::minimum", rhs);
   return rhs.backend().minimum(lhs, rhs);
 }
 
 Tensor maximum(const Tensor& lhs, const double& rhs) {
+  FL_PROFILE_OP("tensor::maximum", lhs);
   return lhs.backend().maximum(lhs, rhs);
 }
 
 Tensor maximum(const double& lhs, const Tensor& rhs) {
+  FL_PROFILE_OP("tensor::maximum", rhs);
   return rhs.backend().maximum(lhs, rhs);
 }
 
 Tensor power(const Tensor& lhs, const Tensor& rhs) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(lhs, rhs);
+  FL_PROFILE_OP("tensor::power", lhs);
   return lhs.backend().power(lhs, rhs);
 }
 
 Tensor power(const Tensor& lhs, const double& rhs) {
+  FL_PROFILE_OP("tensor::power", lhs);
   return lhs.backend().power(lhs, rhs);
 }
 
 Tensor power(const double& lhs, const Tensor& rhs) {
+  FL_PROFILE_OP("tensor::power", rhs);
   return rhs.backend().power(lhs, rhs);
 }
 
@@ -701,6 +791,7 @@ Tensor matmul(
     MatrixProperty lhsProp,
     MatrixProperty rhsProp) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(lhs, rhs);
+  FL_PROFILE_OP("tensor::matmul", lhs);
   return lhs.backend().matmul(lhs, rhs, lhsProp, rhsProp);
 }
 
@@ -710,6 +801,7 @@ Tensor amin(
     const Tensor& input,
     const std::vector<int>& axes /* = {} */,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::amin", input);
   return input.backend().amin(input, axes, keepDims);
 }
 
@@ -717,6 +809,7 @@ Tensor amax(
     const Tensor& input,
     const std::vector<int>& axes /* = {} */,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::amax", input);
   return input.backend().amax(input, axes, keepDims);
 }
 
@@ -727,6 +820,7 @@ void min(
     const unsigned axis,
     const bool keepDims) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(values, indices, input);
+  FL_PROFILE_OP("tensor::min", input);
   return input.backend().min(values, indices, input, axis, keepDims);
 }
 
@@ -737,6 +831,7 @@ void max(
     const unsigned axis,
     const bool keepDims /* = false */) {
   FL_TENSOR_BACKENDS_MATCH_CHECK(values, indices, input);
+  FL_PROFILE_OP("tensor::max", input);
   return input.backend().max(values, indices, input, axis, keepDims);
 }
 
@@ -744,10 +839,12 @@ Tensor sum(
     const Tensor& input,
     const std::vector<int>& axes /* = {} */,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::sum", input);
   return input.backend().sum(input, axes, keepDims);
 }
 
 Tensor cumsum(const Tensor& input, const unsigned axis) {
+  FL_PROFILE_OP("tensor::cumsum", input);
   return input.backend().cumsum(input, axis);
 }
 
@@ -755,6 +852,7 @@ Tensor argmax(
     const Tensor& input,
     const unsigned axis,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::argmax", input);
   return input.backend().argmax(input, axis, keepDims);
 }
 
@@ -762,6 +860,7 @@ Tensor argmin(
     const Tensor& input,
     const unsigned axis,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::argmin", input);
   return input.backend().argmin(input, axis, keepDims);
 }
 
@@ -769,6 +868,7 @@ Tensor mean(
     const Tensor& input,
     const std::vector<int>& axes /* = {} */,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::mean", input);
   return input.backend().mean(input, axes, keepDims);
 }
 
@@ -776,6 +876,7 @@ Tensor median(
     const Tensor& input,
     const std::vector<int>& axes /* = {} */,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::median", input);
   return input.backend().median(input, axes, keepDims);
 }
 
@@ -784,6 +885,7 @@ Tensor var(
     const std::vector<int>& axes /* = {} */,
     const bool bias,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::var", input);
   return input.backend().var(input, axes, bias, keepDims);
 }
 
@@ -791,6 +893,7 @@ Tensor std(
     const Tensor& input,
     const std::vector<int>& axes /* = {} */,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::std", input);
   return input.backend().std(input, axes, keepDims);
 }
 
@@ -799,6 +902,7 @@ Tensor norm(
     const std::vector<int>& axes /* = {} */,
     double p /* = 2 */,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::norm", input);
   return input.backend().norm(input, axes, p, keepDims);
 }
 
@@ -806,6 +910,7 @@ Tensor countNonzero(
     const Tensor& input,
     const std::vector<int>& axes /* = {} */,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::countNonzero", input);
   return input.backend().countNonzero(input, axes, keepDims);
 }
 
@@ -813,6 +918,7 @@ Tensor any(
     const Tensor& input,
     const std::vector<int>& axes /* = {} */,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::any", input);
   return input.backend().any(input, axes, keepDims);
 }
 
@@ -820,6 +926,7 @@ Tensor all(
     const Tensor& input,
     const std::vector<int>& axes /* = {} */,
     const bool keepDims /* = false */) {
+  FL_PROFILE_OP("tensor::all", input);
   return input.backend().all(input, axes, keepDims);
 }
 
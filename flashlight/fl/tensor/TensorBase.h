@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -43,6 +46,13 @@ class Index;
 // See runtime/Stream.h
 class Stream;
 
+} // namespace fl
+
+// See dlpack/dlpack.h
+struct DLManagedTensor;
+
+namespace fl {
+
 /// Location of memory or tensors.
 enum class Location { Host, Device };
 /// Alias to make it semantically clearer when referring to buffer location
@@ -76,6 +86,9 @@ std::unique_ptr<TensorAdapterBase> releaseAdapterUnsafe(Tensor& t);
 class Tensor {
   // The tensor adapter for the tensor
   std::unique_ptr<TensorAdapterBase> impl_;
+  // The backend of the adapter, which every op dispatches to, cached on first
+  // use; reset whenever the adapter is replaced
+  mutable std::atomic<TensorBackend*> backend_{nullptr};
 
   /*
    * Construct a tensor with a given shape and using an existing buffer.
@@ -105,6 +118,8 @@ class Tensor {
   friend class DevicePtr;
   // also used in tensor abstractions that wrap and call tensor ops:
   friend class TracerTensorBase;
+  // and to materialize results of lazily built trees without a deep copy:
+  friend class JitTensorBase;
 
   /**
    * Release and transfer ownership of the tensor's underlying
@@ -120,6 +135,12 @@ class Tensor {
   friend std::unique_ptr<TensorAdapterBase> detail::releaseAdapterUnsafe(
       Tensor& t);
 
+  /**
+   * Index into the tensor with indices stored by the caller, e.g. on the stack
+   * by the variadic `operator()`, see `TensorAdapterBase::indexArray`.
+   */
+  Tensor indexArray(const Index* indices, size_t numIndices) const;
+
  public:
   explicit Tensor(std::unique_ptr<TensorAdapterBase> adapter);
   virtual ~Tensor();
@@ -379,8 +400,9 @@ class Tensor {
     //     std::conjunction<std::is_constructible<Index, Ts>...>::value,
     //     "Tensor index operator can only take Index-compatible types - "
     //     "fl::range, fl::Tensor, fl::span, and integer types.");
-    std::vector<Index> indices{{args...}};
-    return this->operator()(indices);
+    // A fixed number of indices on the stack, which indexing doesn't allocate
+    const std::array<Index, sizeof...(Ts)> indices{{Index(args)...}};
+    return indexArray(indices.data(), indices.size());
   }
 
   /**
@@ -456,6 +478,7 @@ class Tensor {
     // Implicitly cast to the requested return type
     switch (type()) {
       case dtype::f16:
+      case dtype::bf16:
         return astype(dtype::f32).scalar<float>();
       case dtype::f32:
         return scalar<float>();
@@ -568,6 +591,19 @@ class Tensor {
    */
   bool isContiguous() const;
 
+  /**
+   * Exports the tensor to DLPack without copying its data, to share it with
+   * another runtime. The exported tensor has the same shape as this one, and
+   * column-major strides. Its memory stays locked, as with Tensor::device(),
+   * until the consumer calls the `deleter` of the returned DLManagedTensor.
+   * The tensor's pending computations complete before this returns.
+   *
+   * Non-contiguous tensors are made contiguous first, hence copied.
+   *
+   * @return a DLManagedTensor owned by the caller
+   */
+  DLManagedTensor* toDLPack() const;
+
   /**
    * Stores arbitrary data on a tensor. For internal use/benchmarking only. This
    * may be a no-op for some backends.
@@ -682,6 +718,21 @@ Tensor full(
  */
 Tensor identity(const Dim dim, const dtype type = dtype::f32);
 
+/**
+ * Imports a DLPack tensor from another runtime without copying its data. The
+ * returned tensor takes ownership of `dlTensor`, and calls its `deleter` once
+ * the memory is no longer referenced by any tensor.
+ *
+ * The tensor must be dense. Column-major tensors keep their shape, while
+ * row-major tensors, e.g. from Numpy or PyTorch, are imported with their axes
+ * reversed, i.e. transposed, since Flashlight tensors are column-major. The
+ * data must be ready to be read when this is called.
+ *
+ * @param[in] dlTensor the DLPack tensor to import
+ * @return a tensor sharing the memory of `dlTensor`
+ */
+Tensor fromDLPack(DLManagedTensor* dlTensor);
+
 /**
  * Return evenly-spaced values in a given interval. Generate values in the
  * interval `[start, stop)` steppping each element by the passed step.
@@ -1233,6 +1284,10 @@ enum class MatrixProperty { None = 0, Transpose = 1 };
 /**
  * Perform matrix multiplication between two tensors.
  *
+ * Dimensions beyond the first two are batch dimensions. Batch dimensions of
+ * size 1, or missing, on one side are broadcast to the other without copies,
+ * e.g. a [M, K, 1] tensor times a [K, N, B] tensor gives a [M, N, B] tensor.
+ *
  * @param[in] lhs the Tensor on the left hand side
  * @param[in] rhs the Tensor on the right hand side
  * @param[in] lhsProp the `MatrixProperty` to apply to the tensor on the
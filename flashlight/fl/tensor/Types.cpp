@@ -24,6 +24,7 @@ const std::unordered_map<dtype, std::string> kTypeToString = {
     {dtype::u16, "u16"},
     {dtype::u32, "u32"},
     {dtype::u64, "u64"},
+    {dtype::bf16, "bf16"},
 };
 
 const std::unordered_map<std::string, dtype> kStringToType = {
@@ -38,11 +39,13 @@ const std::unordered_map<std::string, dtype> kStringToType = {
     {"u16", dtype::u16},
     {"u32", dtype::u32},
     {"u64", dtype::u64},
+    {"bf16", dtype::bf16},
 };
 
 size_t getTypeSize(dtype type) {
   switch (type) {
     case dtype::f16:
+    case dtype::bf16:
       return sizeof(float) / 2;
     case dtype::f32:
       return sizeof(float);
@@ -69,6 +72,10 @@ size_t getTypeSize(dtype type) {
   }
 }
 
+bool isHalfPrecisionType(dtype type) {
+  return type == dtype::f16 || type == dtype::bf16;
+}
+
 const std::string& dtypeToString(dtype type) {
   return kTypeToString.at(type);
 }
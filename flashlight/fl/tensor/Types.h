@@ -23,7 +23,8 @@ enum class dtype {
   u8 = 7, // 8-bit unsigned integer
   u16 = 8, // 16-bit unsigned integer
   u32 = 9, // 32-bit unsigned integer
-  u64 = 10 // 64-bit unsigned integer
+  u64 = 10, // 64-bit unsigned integer
+  bf16 = 11 // 16-bit brain float, with the exponent range of f32
   // TODO: add support for complex-valued tensors? (AF)
 };
 
@@ -34,6 +35,13 @@ enum class dtype {
  */
 size_t getTypeSize(dtype type);
 
+/**
+ * Returns whether the type is a 16-bit floating point type, i.e. f16 or bf16.
+ *
+ * @param[in] type the input type to query.
+ */
+bool isHalfPrecisionType(dtype type);
+
 /**
  * Convert a dtype to its string representation.
  */
@@ -14,6 +14,7 @@
 #include <af/random.h>
 
 #include "flashlight/fl/runtime/DeviceManager.h"
+#include "flashlight/fl/tensor/DLPackUtils.h"
 #include "flashlight/fl/tensor/backend/af/ArrayFireTensor.h"
 #include "flashlight/fl/tensor/backend/af/Utils.h"
 #include "flashlight/fl/tensor/backend/af/mem/MemoryManagerInstaller.h"
@@ -64,6 +65,13 @@ const Stream& getOrWrapAfDeviceStream(
 } // namespace
 
 ArrayFireBackend::ArrayFireBackend() {
+#if FL_ARRAYFIRE_USE_CUDA
+  if (DeviceManager::isCPUOnly()) {
+    throw std::runtime_error(
+        "ArrayFireBackend - ArrayFire was built for CUDA, which Flashlight "
+        "is restricted from using (fl::InitOptions::cpuOnly or FL_CPU_ONLY)");
+  }
+#endif
   AF_CHECK(af_init());
 
   std::call_once(memoryInitFlag, []() {
@@ -74,6 +82,7 @@ ArrayFireBackend::ArrayFireBackend() {
     // opencl kernels.
     if (FL_BACKEND_CUDA) {
       MemoryManagerInstaller::installDefaultMemoryManager();
+      MemoryManagerInstaller::installDefaultPinnedMemoryManager();
     }
   });
 
@@ -148,6 +157,9 @@ bool ArrayFireBackend::supportsDataType(const fl::dtype& dtype) const {
           // f16 isn't [yet] supported with the CPU backend per onednn
           // limitations
           !FL_BACKEND_CPU;
+    case fl::dtype::bf16:
+      // ArrayFire has no bf16 arrays
+      return false;
     default:
       return true;
   }
@@ -169,6 +181,23 @@ void ArrayFireBackend::getMemMgrInfo(
   }
 }
 
+size_t ArrayFireBackend::getMemMgrPeakBytes(const int nativeDeviceId) {
+  auto* curMemMgr =
+      fl::MemoryManagerInstaller::currentlyInstalledMemoryManager();
+  if (!curMemMgr) {
+    return 0;
+  }
+  return curMemMgr->getPeakAllocatedBytes(nativeIdToId_.at(nativeDeviceId));
+}
+
+void ArrayFireBackend::resetMemMgrPeakBytes(const int nativeDeviceId) {
+  auto* curMemMgr =
+      fl::MemoryManagerInstaller::currentlyInstalledMemoryManager();
+  if (curMemMgr) {
+    curMemMgr->resetPeakAllocatedBytes(nativeIdToId_.at(nativeDeviceId));
+  }
+}
+
 void ArrayFireBackend::setMemMgrLogStream(std::ostream* stream) {
   if (stream == nullptr) {
     throw std::invalid_argument(
@@ -197,6 +226,16 @@ void ArrayFireBackend::setMemMgrFlushInterval(const size_t interval) {
   }
 }
 
+void* ArrayFireBackend::allocPinnedHost(const size_t bytes) {
+  void* ptr;
+  AF_CHECK(af_alloc_pinned(&ptr, bytes));
+  return ptr;
+}
+
+void ArrayFireBackend::freePinnedHost(void* ptr) {
+  AF_CHECK(af_free_pinned(ptr));
+}
+
 /* -------------------------- Rand Functions -------------------------- */
 
 void ArrayFireBackend::setSeed(const int seed) {
@@ -250,6 +289,42 @@ Tensor ArrayFireBackend::identity(const Dim dim, const dtype type) {
       af::identity({dim, dim}, detail::flToAfType(type)), /* numDims = */ 2);
 }
 
+Tensor ArrayFireBackend::fromDLPack(DLManagedTensor* dlTensor) {
+  auto imported =
+      detail::importFromDLPack(dlTensor, "ArrayFireBackend::fromDLPack");
+  const auto& device =
+      DeviceManager::getInstance().getActiveDevice(kDefaultDeviceType);
+  if (!detail::isSameDevice(imported.device, device)) {
+    throw std::invalid_argument(
+        "[ArrayFireBackend::fromDLPack] the DLPack tensor must be on the "
+        "active " +
+        deviceTypeToString(kDefaultDeviceType) + " device");
+  }
+  const auto numDims = imported.shape.ndim();
+  const auto afDims = detail::flToAfDims(imported.shape);
+  const auto afType = detail::flToAfType(imported.type);
+
+  // ArrayFire frees the memory of arrays created from device pointers, which
+  // only Flashlight's memory managers can hand back to the owner instead
+  if (imported.shape.elements() == 0 ||
+      !MemoryManagerInstaller::currentlyInstalledMemoryManager()) {
+    af::array array(afDims, afType);
+    if (imported.shape.elements() > 0) {
+      array.write(
+          static_cast<const unsigned char*>(imported.data),
+          imported.shape.elements() * fl::getTypeSize(imported.type),
+          afDevice);
+    }
+    return toTensor<ArrayFireTensor>(std::move(array), numDims);
+  }
+  MemoryManagerInstaller::registerExternalBuffer(
+      imported.data, std::move(imported.owner));
+  af_array handle = nullptr;
+  AF_CHECK(af_device_array(
+      &handle, imported.data, AF_MAX_DIMS, afDims.get(), afType));
+  return toTensor<ArrayFireTensor>(af::array(handle), numDims);
+}
+
 Tensor ArrayFireBackend::arange(
     const Shape& shape,
     const Dim seqDim,
@@ -71,6 +71,10 @@ class ArrayFireBackend : public TensorBackend {
   void setMemMgrLogStream(std::ostream* stream) override;
   void setMemMgrLoggingEnabled(const bool enabled) override;
   void setMemMgrFlushInterval(const size_t interval) override;
+  size_t getMemMgrPeakBytes(const int nativeDeviceId) override;
+  void resetMemMgrPeakBytes(const int nativeDeviceId) override;
+  void* allocPinnedHost(const size_t bytes) override;
+  void freePinnedHost(void* ptr) override;
 
   /* -------------------------- Rand Functions -------------------------- */
   void setSeed(const int seed) override;
@@ -98,6 +102,7 @@ class ArrayFireBackend : public TensorBackend {
 #undef AF_BACKEND_CREATE_FUN_LITERAL_DECL
 
   Tensor identity(const Dim dim, const dtype type) override;
+  Tensor fromDLPack(DLManagedTensor* dlTensor) override;
   Tensor arange(const Shape& shape, const Dim seqDim, const dtype type)
       override;
   Tensor iota(const Shape& dims, const Shape& tileDims, const dtype type)
@@ -39,22 +39,26 @@ Tensor doBinaryOpOrBroadcast(
     const Tensor& lhs,
     const Tensor& rhs,
     binaryOpFunc_t func) {
+  // ArrayFireTensor::shape() rebuilds the shape from the array's dims, so get
+  // it once
+  const Shape& lhsShape = lhs.shape();
+  const Shape& rhsShape = rhs.shape();
   // Dims are the same or scalar <> 1-el tensor - no broadcasting
-  if (lhs.shape() == rhs.shape() ||
-      (lhs.elements() <= 1 && rhs.elements() <= 1)) {
+  if (lhsShape == rhsShape ||
+      (lhsShape.elements() <= 1 && rhsShape.elements() <= 1)) {
     return toTensor<ArrayFireTensor>(
-        func(toArray(lhs), toArray(rhs)), lhs.ndim());
+        func(toArray(lhs), toArray(rhs)), lhsShape.ndim());
   }
 
-  if (canBroadcast(lhs.shape(), rhs.shape())) {
+  if (canBroadcast(lhsShape, rhsShape)) {
     return toTensor<ArrayFireTensor>(
         af::batchFunc(toArray(lhs), toArray(rhs), func),
-        std::max(lhs.ndim(), rhs.ndim()));
+        std::max(lhsShape.ndim(), rhsShape.ndim()));
   } else {
     std::stringstream ss;
     ss << "doBinaryOpOrBroadcast: cannot perform operation "
           "or broadcasting with tensors of shapes "
-       << lhs.shape() << " and " << rhs.shape() << " - dimension mismatch.";
+       << lhsShape << " and " << rhsShape << " - dimension mismatch.";
     throw std::invalid_argument(ss.str());
   }
 }
@@ -7,11 +7,13 @@
 
 #include "flashlight/fl/tensor/backend/af/ArrayFireTensor.h"
 
-#include <cassert>
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <utility>
 
+#include "flashlight/fl/tensor/DLPackUtils.h"
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 #include "flashlight/fl/tensor/backend/af/AdvancedIndex.h"
@@ -26,6 +28,21 @@
 
 namespace fl {
 
+namespace {
+
+af::array createArray(
+    const Shape& shape,
+    const void* ptr,
+    fl::dtype type,
+    Location memoryLocation) {
+  // The backend is initialized on first use, and installs the memory manager,
+  // which must be before ArrayFire first allocates.
+  ArrayFireBackend::getInstance();
+  return detail::fromFlData(shape, ptr, type, memoryLocation);
+}
+
+} // namespace
+
 const af::array& toArray(const Tensor& tensor) {
   if (tensor.backendType() != TensorBackendType::ArrayFire) {
     throw std::invalid_argument("toArray: tensor is not ArrayFire-backed");
@@ -50,7 +67,7 @@ ArrayFireTensor::ArrayFireTensor(
     std::vector<detail::IndexType>&& indexTypes,
     const unsigned numDims,
     const bool isFlat)
-    : arrayHandle_(arr),
+    : arrayHandle_(std::move(arr)),
       indices_(std::move(afIndices)),
       indexTypes_(std::move(indexTypes)),
       handle_(IndexedArrayComponent(isFlat)),
@@ -59,7 +76,7 @@ ArrayFireTensor::ArrayFireTensor(
 ArrayFireTensor::ArrayFireTensor(
     std::shared_ptr<af::array> arr,
     unsigned numDims)
-    : arrayHandle_(arr), numDims_(numDims) {}
+    : arrayHandle_(std::move(arr)), numDims_(numDims) {}
 
 ArrayFireTensor::ArrayFireTensor()
     : arrayHandle_(std::make_shared<af::array>()), handle_(ArrayComponent()) {}
@@ -70,7 +87,7 @@ ArrayFireTensor::ArrayFireTensor(
     const void* ptr,
     Location memoryLocation)
     : arrayHandle_(std::make_shared<af::array>(
-          detail::fromFlData(shape, ptr, type, memoryLocation))),
+          createArray(shape, ptr, type, memoryLocation))),
       handle_(ArrayComponent()),
       numDims_(shape.ndim()) {}
 
@@ -124,6 +141,129 @@ af::array& ArrayFireTensor::ArrayComponent::get(const ArrayFireTensor& inst) {
   return *(inst.arrayHandle_);
 }
 
+ArrayFireTensor::StridedView ArrayFireTensor::StridedView::of(
+    std::shared_ptr<af::array> root) {
+  StridedView view{std::move(root), {}};
+  const af::dim4& dims = view.root->dims();
+  for (unsigned i = 0; i < AF_MAX_DIMS; ++i) {
+    view.axes.push_back({dims[i], 0, 1, dims[i]});
+  }
+  return view;
+}
+
+std::optional<ArrayFireTensor::StridedView>
+ArrayFireTensor::StridedView::index(
+    const Index* indices,
+    size_t numIndices) const {
+  // As with ArrayFire arrays, missing trailing axes have a size of 1
+  auto inAxes = axes;
+  while (inAxes.size() < AF_MAX_DIMS) {
+    inAxes.push_back({1, 0, 1, 1});
+  }
+
+  StridedView out{root, {}};
+  // literals preceding the first axis that isn't indexed by a literal
+  std::optional<Axis> leading;
+  for (unsigned i = 0; i < inAxes.size(); ++i) {
+    Axis axis = inAxes[i];
+    bool isLiteral = false;
+    if (i < numIndices) {
+      switch (indices[i].type()) {
+        case detail::IndexType::Span:
+          break;
+        case detail::IndexType::Literal: {
+          dim_t idx = indices[i].get<Dim>();
+          idx = idx < 0 ? idx + axis.size : idx;
+          if (idx < 0 || idx >= axis.size) {
+            return std::nullopt;
+          }
+          axis.begin += idx * axis.stride;
+          axis.size = 1;
+          isLiteral = true;
+          break;
+        }
+        case detail::IndexType::Range: {
+          const auto& r = indices[i].get<range>();
+          dim_t start = r.start() < 0 ? r.start() + axis.size : r.start();
+          dim_t end = r.end().value_or(axis.size);
+          end = end < 0 ? end + axis.size : end;
+          if (r.stride() <= 0 || start < 0 || start >= end ||
+              end > axis.size) {
+            return std::nullopt;
+          }
+          axis.begin += start * axis.stride;
+          axis.size = (end - start + r.stride() - 1) / r.stride();
+          axis.stride *= r.stride();
+          break;
+        }
+        default:
+          return std::nullopt;
+      }
+    }
+
+    // Condense axes indexed by literals by merging them with a neighbor
+    if (!isLiteral) {
+      if (leading) {
+        axis.begin = leading->begin + axis.begin * leading->extent;
+        axis.stride *= leading->extent;
+        axis.extent *= leading->extent;
+        leading.reset();
+      }
+      out.axes.push_back(axis);
+    } else if (!out.axes.empty()) {
+      auto& prev = out.axes.back();
+      prev.begin += axis.begin * prev.extent;
+      prev.extent *= axis.extent;
+    } else if (leading) {
+      leading->begin += axis.begin * leading->extent;
+      leading->extent *= axis.extent;
+    } else {
+      leading = axis;
+    }
+  }
+  if (leading) {
+    // all axes were indexed by literals
+    out.axes.push_back({leading->extent, leading->begin, 1, 1});
+  }
+  return out;
+}
+
+af::array ArrayFireTensor::StridedView::get() const {
+  if (axes.size() > AF_MAX_DIMS) {
+    throw std::logic_error(
+        "ArrayFireTensor::StridedView::get - view has too many axes");
+  }
+  af::dim4 rootDims(1, 1, 1, 1);
+  std::vector<af::index> seqs(AF_MAX_DIMS, af::span);
+  for (unsigned i = 0; i < axes.size(); ++i) {
+    const auto& axis = axes[i];
+    rootDims[i] = axis.extent;
+    seqs[i] = af::seq(
+        axis.begin, axis.begin + (axis.size - 1) * axis.stride, axis.stride);
+  }
+  // Reshaping an evaluated linear array doesn't copy it, and neither does
+  // indexing it with unit strides along the first dimension.
+  root->eval();
+  auto merged = rootDims == root->dims() ? *root : af::moddims(*root, rootDims);
+  return merged(seqs[0], seqs[1], seqs[2], seqs[3]);
+}
+
+std::optional<ArrayFireTensor::StridedView> ArrayFireTensor::asStridedView() {
+  const af::array& arr = getHandle();
+  if (view_) {
+    // Writing to either the view or the viewed array makes ArrayFire copy
+    // it, after which the view is stale
+    if (af::getRawPtr(arr) == af::getRawPtr(*view_->root)) {
+      return view_;
+    }
+    view_.reset();
+  }
+  if (arr.issparse() || arr.elements() == 0 || !af::isLinear(arr)) {
+    return std::nullopt;
+  }
+  return StridedView::of(arrayHandle_);
+}
+
 const af::array& ArrayFireTensor::getHandle() const {
   return const_cast<ArrayFireTensor*>(this)->getHandle();
 }
@@ -137,11 +277,16 @@ af::array& ArrayFireTensor::getHandle() {
   // the conversion.
   if (!std::holds_alternative<ArrayComponent>(handle_)) {
     auto& idxComp = std::get<IndexedArrayComponent>(handle_);
-    arrayHandle_ = std::make_shared<af::array>(detail::condenseIndices(
-        idxComp.get(*this),
-        /* keepDims = */ false,
-        indexTypes_,
-        /* isFlat = */ idxComp.isFlat));
+    if (view_) {
+      // Already condensed, and without the copy moddims makes of sub-arrays
+      arrayHandle_ = std::make_shared<af::array>(view_->get());
+    } else {
+      arrayHandle_ = std::make_shared<af::array>(detail::condenseIndices(
+          idxComp.get(*this),
+          /* keepDims = */ false,
+          indexTypes_,
+          /* isFlat = */ idxComp.isFlat));
+    }
     // Clear state
     handle_ = ArrayComponent(); // set to passthrough
     indices_ = {}; // remove indices
@@ -152,8 +297,10 @@ af::array& ArrayFireTensor::getHandle() {
 
 std::unique_ptr<TensorAdapterBase> ArrayFireTensor::clone() const {
   af::array arr = getHandle(); // increment internal AF refcount
-  return std::unique_ptr<ArrayFireTensor>(
+  auto tensor = std::unique_ptr<ArrayFireTensor>(
       new ArrayFireTensor(std::move(arr), numDims()));
+  tensor->view_ = view_;
+  return tensor;
 }
 
 Tensor ArrayFireTensor::copy() {
@@ -163,8 +310,10 @@ Tensor ArrayFireTensor::copy() {
 
 Tensor ArrayFireTensor::shallowCopy() {
   getHandle(); // if this tensor was a view, run indexing and promote
-  return Tensor(std::unique_ptr<ArrayFireTensor>(
-      new ArrayFireTensor(arrayHandle_, numDims())));
+  auto tensor = std::unique_ptr<ArrayFireTensor>(
+      new ArrayFireTensor(arrayHandle_, numDims()));
+  tensor->view_ = view_;
+  return Tensor(std::move(tensor));
 }
 
 TensorBackendType ArrayFireTensor::backendType() const {
@@ -239,6 +388,11 @@ bool ArrayFireTensor::isContiguous() {
   return af::isLinear(getHandle());
 }
 
+DLManagedTensor* ArrayFireTensor::toDLPack() {
+  return detail::exportToDLPack(
+      isContiguous() ? shallowCopy() : asContiguousTensor());
+}
+
 Shape ArrayFireTensor::strides() {
   return detail::afToFlDims(af::getStrides(getHandle()), numDims());
 }
@@ -255,20 +409,30 @@ Tensor ArrayFireTensor::astype(const dtype type) {
 }
 
 Tensor ArrayFireTensor::index(const std::vector<Index>& indices) {
-  if (indices.size() > AF_MAX_DIMS) {
+  return indexArray(indices.data(), indices.size());
+}
+
+Tensor ArrayFireTensor::indexArray(const Index* indices, size_t numIndices) {
+  if (numIndices > AF_MAX_DIMS) {
     throw std::invalid_argument(
         "ArrayFire-backed tensor was indexed with > 4 elements:"
         "ArrayFire tensors support up to 4 dimensions.");
   }
 
+  // Fast path: spans, ranges and literals select a strided view of linear
+  // arrays, with neither tensor indices to inspect nor advanced indexing
+  const bool isBasic =
+      std::none_of(indices, indices + numIndices, [](const Index& idx) {
+        return idx.type() == detail::IndexType::Tensor;
+      });
+
   // TODO: vet and stress test this a lot more/add proper support for
   // multi-tensor
   // If indexing by a single element and it's a tensor with the same number of
   // indices as the array being indexed, do a flat index as this is probably a
   // filter-based index (for example: a(a < 5)).
-  bool completeTensorIndex = indices.size() == 1 &&
-      indices.front().type() == detail::IndexType::Tensor &&
-      indices.front().get<Tensor>().elements() == getHandle().elements();
+  bool completeTensorIndex = !isBasic && numIndices == 1 &&
+      indices[0].get<Tensor>().elements() == getHandle().elements();
   std::vector<af::index> afIndices;
   if (completeTensorIndex) {
     afIndices = {af::index(0)};
@@ -276,49 +440,53 @@ Tensor ArrayFireTensor::index(const std::vector<Index>& indices) {
     afIndices = {af::span, af::span, af::span, af::span}; // implicit spans
   }
 
-  if (indices.size() > afIndices.size()) {
+  if (numIndices > afIndices.size()) {
     throw std::logic_error(
         "ArrayFireTensor::index internal error - passed indiecs is larger "
         "than the number of af indices");
   }
 
-  // Fill in corresponding index types for each af index
-  std::vector<detail::IndexType> indexTypes(afIndices.size());
-  size_t i = 0;
-  for (; i < indices.size(); ++i) {
+  // Fill in corresponding index types for each af index; implicit spans are
+  // spans
+  std::vector<detail::IndexType> indexTypes(
+      afIndices.size(), detail::IndexType::Span);
+  unsigned numLiterals = 0;
+  for (size_t i = 0; i < numIndices; ++i) {
     indexTypes[i] = indices[i].type();
     afIndices[i] = detail::flToAfIndex(indices[i]);
-  }
-  // If we're adding implicit spans, fill those indexTypes in
-  for (; i < afIndices.size(); ++i) {
-    indexTypes[i] = detail::IndexType::Span;
+    numLiterals += indexTypes[i] == detail::IndexType::Literal;
   }
 
-  getHandle(); // if this tensor was a view, run indexing and promote
+  // Basic indexing of a linear array or of a view of one yields a view of it,
+  // and promotes this tensor if it was a view
+  std::optional<StridedView> view;
+  if (isBasic) {
+    if (auto parent = asStridedView()) {
+      view = parent->index(indices, numIndices);
+    }
+  } else {
+    getHandle(); // if this tensor was a view, run indexing and promote
+  }
 
-  assert(afIndices.size() == indexTypes.size());
   // Compute numDums for the new Tensor
   unsigned newNumDims = numDims();
-
   if (completeTensorIndex) {
     // TODO/FIXME: compute this based on the number of els in the indexing
     // tensor(s)
     newNumDims = 1;
   } else {
-    for (const auto& type : indexTypes) {
-      if (type == detail::IndexType::Literal) {
-        newNumDims--;
-      }
-    }
+    newNumDims -= std::min(numLiterals, newNumDims);
   }
   newNumDims = std::max(newNumDims, 1u); // can never index to a 0 dim tensor
 
-  return fl::Tensor(std::unique_ptr<ArrayFireTensor>(new ArrayFireTensor(
+  auto tensor = std::unique_ptr<ArrayFireTensor>(new ArrayFireTensor(
       arrayHandle_,
       std::move(afIndices),
       std::move(indexTypes),
       newNumDims,
-      /* isFlat = */ false)));
+      /* isFlat = */ false));
+  tensor->view_ = std::move(view);
+  return fl::Tensor(std::move(tensor));
 }
 
 Tensor ArrayFireTensor::flatten() const {
@@ -372,6 +540,7 @@ std::ostream& ArrayFireTensor::operator<<(std::ostream& ostr) {
 /******************** Assignment Operators ********************/
 #define ASSIGN_OP_TYPE(FUN, AF_OP, TYPE)                                 \
   void ArrayFireTensor::FUN(const TYPE& val) {                           \
+    view_.reset();                                                       \
     std::visit(                                                          \
         [val, this](auto&& arr) { arr.get(*this) AF_OP val; }, handle_); \
   }
@@ -483,6 +652,7 @@ af::array ArrayFireTensor::adjustInPlaceOperandDims(const Tensor& operand) {
 
 #define ASSIGN_OP_TENSOR(FUN, AF_OP)                                   \
   void ArrayFireTensor::FUN(const Tensor& tensor) {                    \
+    view_.reset();                                                     \
     std::visit(                                                        \
         [&tensor, this](auto&& arr) {                                  \
           arr.get(*this) AF_OP this->adjustInPlaceOperandDims(tensor); \
@@ -502,6 +672,7 @@ ASSIGN_OP(inPlaceDivide, /=);
 // Instantiate definitions for type literals - those remain unchanged:
 ASSIGN_OP_LITERALS(assign, =);
 void ArrayFireTensor::assign(const Tensor& tensor) {
+  view_.reset();
   std::visit(
       [&tensor, this](auto&& arr) {
         if (indices_) {
@@ -528,6 +699,7 @@ void ArrayFireTensor::assign(const Tensor& tensor) {
 ASSIGN_OP_LITERALS(inPlaceAdd, +=);
 // Special tensor op:
 void ArrayFireTensor::inPlaceAdd(const Tensor& tensor) {
+  view_.reset();
   // First, check if this a tensor that's going to be lazily indexed. Don't
   // implicitly cast to an array, else that will trigger indexing.
   // Carefully get the handle types without calling type(), which will lazily
@@ -11,7 +11,9 @@
 #include <af/array.h>
 #include <af/statistics.h>
 
+#include <optional>
 #include <variant>
+#include <vector>
 
 #include "flashlight/fl/runtime/Stream.h"
 #include "flashlight/fl/tensor/Index.h"
@@ -54,6 +56,36 @@ class ArrayFireTensor : public TensorAdapterBase {
   // because we can't store an af::array::proxy as an lvalue. See getHandle().
   std::variant<ArrayComponent, IndexedArrayComponent> handle_{ArrayComponent()};
 
+  // A strided view of a linear array, selected with spans, ranges and
+  // literals only. Consecutive dimensions of the array are merged so that
+  // literals become offsets, which lets views be condensed and indexed again
+  // without copying the array. See index().
+  struct StridedView {
+    struct Axis {
+      // the number of elements of the merged dimensions of `root`
+      dim_t extent;
+      // which of those elements the view selects
+      dim_t begin;
+      dim_t stride;
+      dim_t size;
+    };
+    std::shared_ptr<af::array> root;
+    std::vector<Axis> axes;
+
+    static StridedView of(std::shared_ptr<af::array> root);
+    // nullopt if the indices aren't all spans, ranges or literals in bounds
+    std::optional<StridedView> index(
+        const Index* indices,
+        size_t numIndices) const;
+    // a sub-array sharing the memory of `root`
+    af::array get() const;
+  };
+  // Set if this tensor is, or is about to be, a strided view of a linear array
+  std::optional<StridedView> view_;
+
+  // The strided view this tensor is, if it can be indexed as one
+  std::optional<StridedView> asStridedView();
+
   /**
    * Constructs an ArrayFireTensor that will be lazily indexed.
    *
@@ -188,10 +220,12 @@ class ArrayFireTensor : public TensorAdapterBase {
   void unlock() override;
   bool isLocked() override;
   bool isContiguous() override;
+  DLManagedTensor* toDLPack() override;
   Shape strides() override;
   const Stream& stream() const override;
   Tensor astype(const dtype type) override;
   Tensor index(const std::vector<Index>& indices) override;
+  Tensor indexArray(const Index* indices, size_t numIndices) override;
   Tensor flatten() const override;
   Tensor flat(const Index& idx) const override;
   Tensor asContiguousTensor() override;
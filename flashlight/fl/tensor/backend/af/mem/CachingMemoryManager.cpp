@@ -14,8 +14,11 @@
 #include <memory>
 #include <mutex>
 #include <numeric>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace fl {
@@ -36,6 +39,8 @@ constexpr size_t kRoundLarge = 2097152; // round up large allocs to 2 MiB
 // Environment variables names, specifying number of mega bytes as floats.
 constexpr const char* kMemRecyclingSize = "FL_MEM_RECYCLING_SIZE_MB";
 constexpr const char* kMemSplitSize = "FL_MEM_SPLIT_SIZE_MB";
+// Enables expandable segments unless set to "0".
+constexpr const char* kMemExpandableSegments = "FL_MEM_EXPANDABLE_SEGMENTS";
 constexpr double kMB = static_cast<double>(1UL << 20);
 
 size_t roundSize(size_t size) {
@@ -46,6 +51,10 @@ size_t roundSize(size_t size) {
   }
 }
 
+size_t roundUp(size_t size, size_t multiple) {
+  return multiple * ((size + multiple - 1) / multiple);
+}
+
 size_t getAllocationSize(size_t size) {
   if (size <= kSmallSize) {
     return kSmallBuffer;
@@ -56,9 +65,14 @@ size_t getAllocationSize(size_t size) {
   }
 }
 
+// Orders blocks by stream first so each stream's blocks form a contiguous,
+// size-ordered range of a pool.
 static bool BlockComparator(
     const CachingMemoryManager::Block* a,
     const CachingMemoryManager::Block* b) {
+  if (a->stream_ != b->stream_) {
+    return (uintptr_t)a->stream_ < (uintptr_t)b->stream_;
+  }
   if (a->size_ != b->size_) {
     return a->size_ < b->size_;
   }
@@ -95,24 +109,76 @@ size_t getEnvAsBytesFromFloatMb(const char* name, size_t defaultVal) {
   return defaultVal;
 }
 
+std::string toJsonPointer(const void* ptr) {
+  std::ostringstream ss;
+  ss << "\"0x" << std::hex << reinterpret_cast<uintptr_t>(ptr) << "\"";
+  return ss.str();
+}
+
+std::string toJsonString(const std::string& str) {
+  std::ostringstream ss;
+  ss << '"';
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        ss << "\\\"";
+        break;
+      case '\\':
+        ss << "\\\\";
+        break;
+      case '\n':
+        ss << "\\n";
+        break;
+      default:
+        ss << c;
+    }
+  }
+  ss << '"';
+  return ss.str();
+}
+
 } // namespace
 
 CachingMemoryManager::DeviceMemoryInfo::DeviceMemoryInfo(int id)
     : deviceId_(id),
       largeBlocks_(BlockComparator),
-      smallBlocks_(BlockComparator) {}
+      smallBlocks_(BlockComparator),
+      allocatedBytesMetric_(MetricsRegistry::getInstance().gauge(
+          "fl_memory_allocated_bytes",
+          "Device memory allocated by the caching memory manager",
+          {{"device", std::to_string(id)}})),
+      cachedBytesMetric_(MetricsRegistry::getInstance().gauge(
+          "fl_memory_cached_bytes",
+          "Device memory cached by the caching memory manager, not in use",
+          {{"device", std::to_string(id)}})),
+      peakAllocatedBytesMetric_(MetricsRegistry::getInstance().gauge(
+          "fl_memory_peak_allocated_bytes",
+          "Most device memory allocated since the last reset of the peak",
+          {{"device", std::to_string(id)}})),
+      nativeMallocsMetric_(MetricsRegistry::getInstance().counter(
+          "fl_memory_native_mallocs_total",
+          "Native allocations of the caching memory manager",
+          {{"device", std::to_string(id)}})),
+      nativeFreesMetric_(MetricsRegistry::getInstance().counter(
+          "fl_memory_native_frees_total",
+          "Native frees of the caching memory manager",
+          {{"device", std::to_string(id)}})) {}
+
+CachingMemoryManager::PrivatePool::PrivatePool()
+    : largeBlocks_(BlockComparator),
+      smallBlocks_(BlockComparator),
+      useCount_(0) {}
 
 CachingMemoryManager::CachingMemoryManager(
     int numDevices,
     std::shared_ptr<MemoryManagerDeviceInterface> deviceInterface)
-    : MemoryManagerAdapter(deviceInterface) {
+    : MemoryManagerAdapter(deviceInterface), numDevices_(numDevices) {
   recyclingSizeLimit_ =
       getEnvAsBytesFromFloatMb(kMemRecyclingSize, recyclingSizeLimit_);
   splitSizeLimit_ = getEnvAsBytesFromFloatMb(kMemSplitSize, splitSizeLimit_);
-
-  for (int i = 0; i < numDevices; ++i) {
-    deviceMemInfos_.emplace(
-        i, std::make_unique<CachingMemoryManager::DeviceMemoryInfo>(i));
+  const char* expandableSegments = std::getenv(kMemExpandableSegments);
+  if (expandableSegments) {
+    expandableSegments_ = std::string(expandableSegments) != "0";
   }
 }
 
@@ -126,11 +192,24 @@ void CachingMemoryManager::setSplitSizeLimit(size_t limit) {
   splitSizeLimit_ = limit;
 }
 
+void CachingMemoryManager::setExpandableSegments(bool enabled) {
+  expandableSegments_ = enabled;
+}
+
 void CachingMemoryManager::shutdown() {
   signalMemoryCleanup();
+  auto& memoryInfo = getDeviceMemoryInfo();
+  std::lock_guard<std::recursive_mutex> lock(memoryInfo.mutexAll_);
+  auto& segment = memoryInfo.segment_;
+  if (segment && segment->mappedSize_ == 0) {
+    this->deviceInterface->freeAddressRange(
+        segment->base_, segment->reservedSize_);
+    segment.reset();
+  }
 }
 
 void CachingMemoryManager::addMemoryManagement(int device) {
+  std::lock_guard<std::mutex> lock(deviceMemInfosMutex_);
   if (deviceMemInfos_.find(device) != deviceMemInfos_.end()) {
     return;
   }
@@ -139,10 +218,13 @@ void CachingMemoryManager::addMemoryManagement(int device) {
 }
 
 void CachingMemoryManager::removeMemoryManagement(int device) {
-  if (deviceMemInfos_.find(device) == deviceMemInfos_.end()) {
+  std::lock_guard<std::mutex> lock(deviceMemInfosMutex_);
+  auto it = deviceMemInfos_.find(device);
+  if (it == deviceMemInfos_.end()) {
     return;
   }
-  deviceMemInfos_.erase(device);
+  releaseEvents(*it->second);
+  deviceMemInfos_.erase(it);
 }
 
 void* CachingMemoryManager::alloc(
@@ -161,12 +243,24 @@ void* CachingMemoryManager::alloc(
   }
   size = roundSize(size);
   const bool isSmallAlloc = (size <= kSmallSize);
-  CachingMemoryManager::Block searchKey(size);
+  // allocations to a private pool must not synchronize with the device
+  PrivatePool* privatePool = memoryInfo.allocatingPool_;
   CachingMemoryManager::BlockSet& pool =
-      isSmallAlloc ? memoryInfo.smallBlocks_ : memoryInfo.largeBlocks_;
+      getBlockSet(memoryInfo, privatePool, isSmallAlloc);
+  void* stream = getActiveStream();
+  if (!privatePool && !memoryInfo.pendingBlocks_.empty()) {
+    processPendingBlocks(memoryInfo, /* wait = */ false);
+  }
 
   CachingMemoryManager::Block* block = nullptr;
-  auto it = pool.lower_bound(&searchKey);
+  auto it = findReusableBlock(pool, stream, size);
+  // Blocks cached by other streams can only be reused once their pending work
+  // is done; if that is already the case, this avoids a native allocation.
+  if (it == pool.end() && stream && !privatePool &&
+      startStreamHandoffs(memoryInfo, pool, stream, size)) {
+    processPendingBlocks(memoryInfo, /* wait = */ false);
+    it = findReusableBlock(pool, stream, size);
+  }
   // Recycle blocks if any found, and if small alloc or the block size is not
   // too large:
   if (it != pool.end() &&
@@ -174,12 +268,16 @@ void* CachingMemoryManager::alloc(
     block = *it;
     pool.erase(it);
     memoryInfo.stats_.cachedBytes_ -= block->size_;
-  } else {
+  } else if (!isSmallAlloc && !privatePool && useExpandableSegments()) {
+    block = growSegment(memoryInfo, size, stream);
+  }
+  if (!block) {
     void* ptr = nullptr;
     size_t allocSize = getAllocationSize(size);
-    mallocWithRetry(allocSize, &ptr); // could throw
+    mallocWithRetry(allocSize, &ptr, /* retry = */ !privatePool); // could throw
     block = new Block(allocSize, ptr);
-    memoryInfo.stats_.allocatedBytes_ += allocSize;
+    block->privatePool_ = privatePool;
+    memoryInfo.stats_.addAllocatedBytes(allocSize);
   }
 
   // If the block is larger than the requested size to handle another
@@ -189,11 +287,14 @@ void* CachingMemoryManager::alloc(
   CachingMemoryManager::Block* remaining = nullptr;
   size_t diff = block->size_ - size;
   if ((diff >= (isSmallAlloc ? kMinBlockSize : kSmallSize)) &&
-      (block->size_ < splitSizeLimit_) // possibly dont split large buffers to
+      (block->segment_ || // segments don't fragment like native buffers
+       block->size_ < splitSizeLimit_) // possibly dont split large buffers to
                                        // minimize risk of fragmentation
   ) {
     remaining = block;
     block = new Block(size, block->ptr_);
+    block->segment_ = remaining->segment_;
+    block->privatePool_ = remaining->privatePool_;
     block->prev_ = remaining->prev_;
     if (block->prev_) {
       block->prev_->next_ = block;
@@ -210,6 +311,8 @@ void* CachingMemoryManager::alloc(
   block->managerLock_ = !userLock;
   block->userLock_ = userLock;
   memoryInfo.allocatedBlocks_[block->ptr_] = block;
+  recordEvent(TraceEvent::Action::Alloc, block->ptr_, block->size_, memoryInfo);
+  exportMetrics(memoryInfo);
   return static_cast<void*>(block->ptr_);
 }
 
@@ -237,6 +340,8 @@ void CachingMemoryManager::unlock(void* ptr, bool userUnlock) {
     // Probably came from user, just free it
     this->deviceInterface->nativeFree(ptr);
     ++memoryInfo.stats_.totalNativeFrees_;
+    recordEvent(TraceEvent::Action::NativeFree, ptr, 0, memoryInfo);
+    exportMetrics(memoryInfo);
     return;
   }
 
@@ -253,6 +358,7 @@ void CachingMemoryManager::unlock(void* ptr, bool userUnlock) {
   }
   memoryInfo.allocatedBlocks_.erase(it);
   freeBlock(block);
+  exportMetrics(memoryInfo);
 }
 
 void CachingMemoryManager::freeBlock(CachingMemoryManager::Block* block) {
@@ -262,9 +368,14 @@ void CachingMemoryManager::freeBlock(CachingMemoryManager::Block* block) {
   auto& memoryInfo = getDeviceMemoryInfo();
   std::lock_guard<std::recursive_mutex> lock(memoryInfo.mutexAll_);
 
-  const bool isSmallAlloc = (block->size_ <= kSmallSize);
+  // The block may still be used by pending work on the active stream, so it
+  // is only freely reusable on that stream.
+  block->stream_ = getActiveStream();
+  recordEvent(TraceEvent::Action::Free, block->ptr_, block->size_, memoryInfo);
+  // segment blocks are large regardless of their size
+  const bool isSmallAlloc = (block->size_ <= kSmallSize) && !block->segment_;
   CachingMemoryManager::BlockSet& pool =
-      isSmallAlloc ? memoryInfo.smallBlocks_ : memoryInfo.largeBlocks_;
+      getBlockSet(memoryInfo, block->privatePool_, isSmallAlloc);
   tryMergeBlocks(block, block->prev_, pool);
   tryMergeBlocks(block, block->next_, pool);
 
@@ -272,12 +383,16 @@ void CachingMemoryManager::freeBlock(CachingMemoryManager::Block* block) {
   memoryInfo.stats_.cachedBytes_ += block->size_;
 }
 
-/** combine previously split blocks */
+/**
+ * combine previously split blocks; `dst` takes over `src` only if `src` can be
+ * reused on the stream of `dst` without synchronization
+ */
 void CachingMemoryManager::tryMergeBlocks(
     CachingMemoryManager::Block* dst,
     CachingMemoryManager::Block* src,
     BlockSet& pool) {
-  if (!src || src->inUse()) {
+  if (!src || src->inUse() || src->pending_ ||
+      (src->stream_ != nullptr && src->stream_ != dst->stream_)) {
     return;
   }
   if (dst->prev_ == src) {
@@ -293,12 +408,18 @@ void CachingMemoryManager::tryMergeBlocks(
     }
   }
   dst->size_ += src->size_;
+  if (src->segment_ && src->segment_->tail_ == src) {
+    src->segment_->tail_ = dst;
+  }
   pool.erase(src);
   getDeviceMemoryInfo().stats_.cachedBytes_ -= src->size_;
   delete src;
 }
 
-void CachingMemoryManager::mallocWithRetry(size_t size, void** ptr) {
+void CachingMemoryManager::mallocWithRetry(
+    size_t size,
+    void** ptr,
+    bool retry) {
   // Try nativeMalloc. If nativeMalloc fails, frees all non-split cached blocks
   // and retries.
   auto& memInfo = getDeviceMemoryInfo();
@@ -307,6 +428,9 @@ void CachingMemoryManager::mallocWithRetry(size_t size, void** ptr) {
     *ptr = this->deviceInterface->nativeAlloc(size);
   } catch (std::exception& exUnused) {
     try {
+      if (!retry) {
+        throw;
+      }
       signalMemoryCleanup();
       ++memInfo.stats_.totalNativeMallocs_;
       *ptr = this->deviceInterface->nativeAlloc(size);
@@ -325,6 +449,17 @@ void CachingMemoryManager::mallocWithRetry(size_t size, void** ptr) {
       throw;
     }
   }
+  recordEvent(TraceEvent::Action::NativeAlloc, *ptr, size, memInfo);
+}
+
+CachingMemoryManager::BlockSet& CachingMemoryManager::getBlockSet(
+    DeviceMemoryInfo& memoryInfo,
+    PrivatePool* pool,
+    bool isSmall) {
+  if (pool) {
+    return isSmall ? pool->smallBlocks_ : pool->largeBlocks_;
+  }
+  return isSmall ? memoryInfo.smallBlocks_ : memoryInfo.largeBlocks_;
 }
 
 void CachingMemoryManager::freeBlocks(
@@ -335,9 +470,14 @@ void CachingMemoryManager::freeBlocks(
   auto& memoryInfo = getDeviceMemoryInfo();
   while (it != end) {
     Block* block = *it;
-    if (!block->isSplit()) {
+    if (!block->isSplit() && !block->segment_) {
       this->deviceInterface->nativeFree(static_cast<void*>(block->ptr_));
       ++memoryInfo.stats_.totalNativeFrees_;
+      recordEvent(
+          TraceEvent::Action::NativeFree,
+          block->ptr_,
+          block->size_,
+          memoryInfo);
       memoryInfo.stats_.allocatedBytes_ -= block->size_;
       memoryInfo.stats_.cachedBytes_ -= block->size_;
       auto cur = it;
@@ -354,6 +494,15 @@ void CachingMemoryManager::signalMemoryCleanup() {
   // Free all non-split cached blocks on device
   auto& memoryInfo = getDeviceMemoryInfo();
   std::lock_guard<std::recursive_mutex> lock(memoryInfo.mutexAll_);
+  // Blocks split across streams can only be merged back, and thus freed, once
+  // they are safe on any stream
+  if (getActiveStream()) {
+    startStreamHandoffs(memoryInfo, memoryInfo.largeBlocks_, nullptr, 0);
+    startStreamHandoffs(memoryInfo, memoryInfo.smallBlocks_, nullptr, 0);
+  }
+  processPendingBlocks(memoryInfo, /* wait = */ true);
+  releaseEvents(memoryInfo);
+  shrinkSegment(memoryInfo);
 
   freeBlocks(
       memoryInfo.largeBlocks_,
@@ -364,6 +513,7 @@ void CachingMemoryManager::signalMemoryCleanup() {
       memoryInfo.smallBlocks_,
       memoryInfo.smallBlocks_.begin(),
       memoryInfo.smallBlocks_.end());
+  exportMetrics(memoryInfo);
 }
 
 float CachingMemoryManager::getMemoryPressure() {
@@ -374,6 +524,19 @@ bool CachingMemoryManager::jitTreeExceedsMemoryPressure(size_t /* unused */) {
   return false; // TODO: check if this is optimal
 }
 
+size_t CachingMemoryManager::getPeakAllocatedBytes(int device) {
+  auto& memInfo = getDeviceMemoryInfo(device);
+  std::lock_guard<std::recursive_mutex> lock(memInfo.mutexAll_);
+  return memInfo.stats_.peakAllocatedBytes_;
+}
+
+void CachingMemoryManager::resetPeakAllocatedBytes(int device) {
+  auto& memInfo = getDeviceMemoryInfo(device);
+  std::lock_guard<std::recursive_mutex> lock(memInfo.mutexAll_);
+  memInfo.stats_.peakAllocatedBytes_ = memInfo.stats_.allocatedBytes_;
+  exportMetrics(memInfo);
+}
+
 void CachingMemoryManager::printInfo(
     const char* msg,
     const int /* unused */,
@@ -388,10 +551,23 @@ void CachingMemoryManager::printInfo(
                  this->deviceInterface->getMaxMemorySize(memInfo.deviceId_))
           << ", Allocated: " << formatMemory(memInfo.stats_.allocatedBytes_)
           << ", Cached: " << formatMemory(memInfo.stats_.cachedBytes_)
-          << std::endl
+          << ", Peak allocated: "
+          << formatMemory(memInfo.stats_.peakAllocatedBytes_) << std::endl
           << "\nTotal native calls: " << memInfo.stats_.totalNativeMallocs_
           << "(mallocs), " << memInfo.stats_.totalNativeFrees_ << "(frees)"
-          << std::endl;
+          << std::endl
+          << "\nTotal cross-stream handoffs: "
+          << memInfo.stats_.totalStreamHandoffs_ << "(blocks)" << std::endl;
+  if (!memInfo.privatePools_.empty()) {
+    ostream << "\nPrivate pools: " << memInfo.privatePools_.size()
+            << std::endl;
+  }
+  if (memInfo.segment_) {
+    ostream << "\nExpandable segment: "
+            << formatMemory(memInfo.segment_->mappedSize_) << " mapped of "
+            << formatMemory(memInfo.segment_->reservedSize_) << " reserved"
+            << std::endl;
+  }
 }
 
 void CachingMemoryManager::userLock(const void* ptr) {
@@ -430,15 +606,467 @@ bool CachingMemoryManager::isUserLocked(const void* ptr) {
   return it->second->userLock_;
 }
 
+void* CachingMemoryManager::getActiveStream() {
+  if (!this->deviceInterface->getActiveStream) {
+    return nullptr;
+  }
+  return this->deviceInterface->getActiveStream();
+}
+
+CachingMemoryManager::BlockSet::iterator
+CachingMemoryManager::findReusableBlock(
+    BlockSet& pool,
+    void* stream,
+    size_t size) {
+  // Prefer blocks of the stream itself, then blocks which are safe on any
+  // stream (stream_ == nullptr)
+  CachingMemoryManager::Block searchKey(size);
+  searchKey.stream_ = stream;
+  auto it = pool.lower_bound(&searchKey);
+  if (it != pool.end() && (*it)->stream_ == stream) {
+    return it;
+  }
+  if (stream) {
+    searchKey.stream_ = nullptr;
+    it = pool.lower_bound(&searchKey);
+    if (it != pool.end() && (*it)->stream_ == nullptr) {
+      return it;
+    }
+  }
+  return pool.end();
+}
+
+bool CachingMemoryManager::startStreamHandoffs(
+    DeviceMemoryInfo& memoryInfo,
+    BlockSet& pool,
+    void* stream,
+    size_t size) {
+  auto& itf = *this->deviceInterface;
+  if (!itf.createEvent || !itf.destroyEvent || !itf.recordEvent ||
+      !itf.queryEvent || !itf.syncEvent) {
+    throw std::runtime_error(
+        "[CachingMemoryManager::startStreamHandoffs] "
+        "getActiveStream requires all native event functions to be set");
+  }
+  std::unordered_map<void*, std::vector<Block*>> streamToBlocks;
+  for (auto it = pool.begin(); it != pool.end();) {
+    Block* block = *it;
+    if (block->stream_ && block->stream_ != stream && block->size_ >= size) {
+      // stays accounted for in cachedBytes_ while pending
+      block->pending_ = true;
+      streamToBlocks[block->stream_].push_back(block);
+      it = pool.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto& [blockStream, blocks] : streamToBlocks) {
+    void* event = nullptr;
+    if (memoryInfo.freeEvents_.empty()) {
+      event = itf.createEvent();
+    } else {
+      event = memoryInfo.freeEvents_.back();
+      memoryInfo.freeEvents_.pop_back();
+    }
+    itf.recordEvent(event, blockStream);
+    memoryInfo.stats_.totalStreamHandoffs_ += blocks.size();
+    memoryInfo.pendingBlocks_.push_back({event, &pool, std::move(blocks)});
+  }
+  return !streamToBlocks.empty();
+}
+
+void CachingMemoryManager::processPendingBlocks(
+    DeviceMemoryInfo& memoryInfo,
+    bool wait) {
+  auto& itf = *this->deviceInterface;
+  auto& pending = memoryInfo.pendingBlocks_;
+  for (auto it = pending.begin(); it != pending.end();) {
+    // events on different streams may complete in any order
+    if (wait) {
+      itf.syncEvent(it->event_);
+    } else if (!itf.queryEvent(it->event_)) {
+      ++it;
+      continue;
+    }
+    auto& pool = *it->pool_;
+    for (Block* block : it->blocks_) {
+      block->pending_ = false;
+      block->stream_ = nullptr;
+      // merging re-accounts for the merged block below
+      memoryInfo.stats_.cachedBytes_ -= block->size_;
+      tryMergeBlocks(block, block->prev_, pool);
+      tryMergeBlocks(block, block->next_, pool);
+      pool.insert(block);
+      memoryInfo.stats_.cachedBytes_ += block->size_;
+    }
+    memoryInfo.freeEvents_.push_back(it->event_);
+    it = pending.erase(it);
+  }
+}
+
+void CachingMemoryManager::releaseEvents(DeviceMemoryInfo& memoryInfo) {
+  auto& itf = *this->deviceInterface;
+  for (const auto& pendingBlocks : memoryInfo.pendingBlocks_) {
+    itf.syncEvent(pendingBlocks.event_);
+    itf.destroyEvent(pendingBlocks.event_);
+  }
+  memoryInfo.pendingBlocks_.clear();
+  for (void* event : memoryInfo.freeEvents_) {
+    itf.destroyEvent(event);
+  }
+  memoryInfo.freeEvents_.clear();
+}
+
+bool CachingMemoryManager::useExpandableSegments() const {
+  auto& itf = *this->deviceInterface;
+  if (!expandableSegments_ || !itf.reserveAddressRange) {
+    return false;
+  }
+  if (!itf.getMemoryGranularity || !itf.freeAddressRange || !itf.mapMemory ||
+      !itf.unmapMemory) {
+    throw std::runtime_error(
+        "[CachingMemoryManager::useExpandableSegments] "
+        "reserveAddressRange requires all native virtual memory functions "
+        "to be set");
+  }
+  return true;
+}
+
+CachingMemoryManager::Block* CachingMemoryManager::growSegment(
+    DeviceMemoryInfo& memoryInfo,
+    size_t size,
+    void* stream) {
+  auto& itf = *this->deviceInterface;
+  const size_t granularity = itf.getMemoryGranularity();
+  auto& segment = memoryInfo.segment_;
+  if (!segment) {
+    // reserve enough addresses to map all of the device's memory
+    const size_t reservedSize =
+        roundUp(itf.getMaxMemorySize(memoryInfo.deviceId_), granularity);
+    segment = std::make_unique<ExpandableSegment>(ExpandableSegment{
+        .base_ = itf.reserveAddressRange(reservedSize),
+        .reservedSize_ = reservedSize,
+        .mappedSize_ = 0,
+        .tail_ = nullptr});
+  }
+  // retry once after releasing cached memory, like mallocWithRetry
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    Block* tail = segment->tail_;
+    // a free tail usable on `stream` is extended rather than left behind
+    const bool growTail = tail && !tail->inUse() && !tail->pending_ &&
+        (tail->stream_ == nullptr || tail->stream_ == stream) &&
+        tail->size_ < size;
+    const size_t mapSize =
+        roundUp(growTail ? size - tail->size_ : size, granularity);
+    if (segment->mappedSize_ + mapSize > segment->reservedSize_) {
+      return nullptr;
+    }
+    void* end = static_cast<char*>(segment->base_) + segment->mappedSize_;
+    try {
+      itf.mapMemory(end, mapSize);
+    } catch (std::exception& exUnused) {
+      if (attempt == 0) {
+        signalMemoryCleanup(); // may shrink the segment
+        continue;
+      }
+      return nullptr;
+    }
+    segment->mappedSize_ += mapSize;
+    memoryInfo.stats_.addAllocatedBytes(mapSize);
+    recordEvent(TraceEvent::Action::SegmentMap, end, mapSize, memoryInfo);
+    if (growTail) {
+      memoryInfo.largeBlocks_.erase(tail);
+      memoryInfo.stats_.cachedBytes_ -= tail->size_;
+      tail->size_ += mapSize;
+      return tail;
+    }
+    Block* block = new Block(mapSize, end);
+    block->segment_ = segment.get();
+    block->prev_ = tail;
+    if (tail) {
+      tail->next_ = block;
+    }
+    segment->tail_ = block;
+    return block;
+  }
+  return nullptr;
+}
+
+void CachingMemoryManager::shrinkSegment(DeviceMemoryInfo& memoryInfo) {
+  auto& segment = memoryInfo.segment_;
+  Block* tail = segment ? segment->tail_ : nullptr;
+  if (!tail || tail->inUse() || tail->pending_) {
+    return;
+  }
+  auto& itf = *this->deviceInterface;
+  char* base = static_cast<char*>(segment->base_);
+  // only whole granules past the start of the tail can be unmapped
+  const size_t start = roundUp(
+      static_cast<char*>(tail->ptr_) - base, itf.getMemoryGranularity());
+  const size_t unmapSize = segment->mappedSize_ - start;
+  if (unmapSize == 0) {
+    return;
+  }
+  memoryInfo.largeBlocks_.erase(tail);
+  memoryInfo.stats_.cachedBytes_ -= tail->size_;
+  itf.unmapMemory(base + start, unmapSize);
+  segment->mappedSize_ = start;
+  memoryInfo.stats_.allocatedBytes_ -= unmapSize;
+  recordEvent(
+      TraceEvent::Action::SegmentUnmap, base + start, unmapSize, memoryInfo);
+  tail->size_ -= unmapSize;
+  if (tail->size_ > 0) {
+    memoryInfo.largeBlocks_.insert(tail);
+    memoryInfo.stats_.cachedBytes_ += tail->size_;
+  } else {
+    segment->tail_ = tail->prev_;
+    if (tail->prev_) {
+      tail->prev_->next_ = nullptr;
+    }
+    delete tail;
+  }
+}
+
+void CachingMemoryManager::beginAllocateToPool(PrivatePoolId id) {
+  auto& memoryInfo = getDeviceMemoryInfo();
+  std::lock_guard<std::recursive_mutex> lock(memoryInfo.mutexAll_);
+  if (memoryInfo.allocatingPool_) {
+    throw std::runtime_error(
+        "[CachingMemoryManager::beginAllocateToPool] "
+        "Already allocating to a private pool");
+  }
+  auto& pool = memoryInfo.privatePools_[id];
+  if (!pool) {
+    pool = std::make_unique<PrivatePool>();
+  }
+  ++pool->useCount_;
+  memoryInfo.allocatingPool_ = pool.get();
+}
+
+void CachingMemoryManager::endAllocateToPool() {
+  auto& memoryInfo = getDeviceMemoryInfo();
+  std::lock_guard<std::recursive_mutex> lock(memoryInfo.mutexAll_);
+  memoryInfo.allocatingPool_ = nullptr;
+}
+
+void CachingMemoryManager::releasePool(PrivatePoolId id) {
+  for (auto* memInfoPtr : getDeviceMemoryInfos()) {
+    auto& memoryInfo = *memInfoPtr;
+    std::lock_guard<std::recursive_mutex> lock(memoryInfo.mutexAll_);
+    auto it = memoryInfo.privatePools_.find(id);
+    if (it == memoryInfo.privatePools_.end() || --it->second->useCount_ > 0) {
+      continue;
+    }
+    PrivatePool* pool = it->second.get();
+    if (memoryInfo.allocatingPool_ == pool) {
+      memoryInfo.allocatingPool_ = nullptr;
+    }
+    for (auto& [ptr, block] : memoryInfo.allocatedBlocks_) {
+      if (block->privatePool_ == pool) {
+        block->privatePool_ = nullptr;
+      }
+    }
+    // blocks of a pool only merge with each other, so its chains stay intact
+    for (Block* block : pool->largeBlocks_) {
+      block->privatePool_ = nullptr;
+      memoryInfo.largeBlocks_.insert(block);
+    }
+    for (Block* block : pool->smallBlocks_) {
+      block->privatePool_ = nullptr;
+      memoryInfo.smallBlocks_.insert(block);
+    }
+    memoryInfo.privatePools_.erase(it);
+  }
+}
+
+void CachingMemoryManager::recordHistory(size_t maxEvents, TagFn tagFn) {
+  std::lock_guard<std::mutex> lock(historyMutex_);
+  history_.clear();
+  historyCapacity_ = maxEvents;
+  historyStart_ = 0;
+  tagFn_ = std::move(tagFn);
+  recordingHistory_ = maxEvents > 0;
+}
+
+std::vector<CachingMemoryManager::TraceEvent>
+CachingMemoryManager::getHistory() {
+  std::lock_guard<std::mutex> lock(historyMutex_);
+  std::vector<TraceEvent> events(
+      history_.begin() + historyStart_, history_.end());
+  events.insert(
+      events.end(), history_.begin(), history_.begin() + historyStart_);
+  return events;
+}
+
+const char* CachingMemoryManager::actionToString(TraceEvent::Action action) {
+  switch (action) {
+    case TraceEvent::Action::Alloc:
+      return "alloc";
+    case TraceEvent::Action::Free:
+      return "free";
+    case TraceEvent::Action::NativeAlloc:
+      return "nativeAlloc";
+    case TraceEvent::Action::NativeFree:
+      return "nativeFree";
+    case TraceEvent::Action::SegmentMap:
+      return "segmentMap";
+    case TraceEvent::Action::SegmentUnmap:
+      return "segmentUnmap";
+  }
+  throw std::runtime_error(
+      "[CachingMemoryManager::actionToString] Unknown action");
+}
+
+void CachingMemoryManager::recordEvent(
+    TraceEvent::Action action,
+    void* ptr,
+    size_t size,
+    const DeviceMemoryInfo& memoryInfo) {
+  if (!recordingHistory_) {
+    return;
+  }
+  TraceEvent event{
+      .action_ = action,
+      .ptr_ = ptr,
+      .size_ = size,
+      .stream_ = getActiveStream(),
+      .deviceId_ = memoryInfo.deviceId_,
+      .time_ = std::chrono::steady_clock::now(),
+      .tag_ = ""};
+  std::lock_guard<std::mutex> lock(historyMutex_);
+  if (historyCapacity_ == 0) {
+    return;
+  }
+  if (tagFn_) {
+    event.tag_ = tagFn_();
+  }
+  if (history_.size() < historyCapacity_) {
+    history_.push_back(std::move(event));
+  } else {
+    history_[historyStart_] = std::move(event);
+    historyStart_ = (historyStart_ + 1) % historyCapacity_;
+  }
+}
+
+void CachingMemoryManager::exportMetrics(DeviceMemoryInfo& memoryInfo) {
+  const auto& stats = memoryInfo.stats_;
+  memoryInfo.allocatedBytesMetric_.set(stats.allocatedBytes_);
+  memoryInfo.cachedBytesMetric_.set(stats.cachedBytes_);
+  memoryInfo.peakAllocatedBytesMetric_.set(stats.peakAllocatedBytes_);
+  memoryInfo.nativeMallocsMetric_.inc(
+      stats.totalNativeMallocs_ - memoryInfo.exportedNativeMallocs_);
+  memoryInfo.nativeFreesMetric_.inc(
+      stats.totalNativeFrees_ - memoryInfo.exportedNativeFrees_);
+  memoryInfo.exportedNativeMallocs_ = stats.totalNativeMallocs_;
+  memoryInfo.exportedNativeFrees_ = stats.totalNativeFrees_;
+}
+
+void CachingMemoryManager::printSnapshot(std::ostream* _ostream) {
+  std::ostream& ostream = *_ostream;
+  ostream << "{\"devices\": [";
+  bool firstDevice = true;
+  for (auto* memInfoPtr : getDeviceMemoryInfos()) {
+    auto& memInfo = *memInfoPtr;
+    std::lock_guard<std::recursive_mutex> lock(memInfo.mutexAll_);
+    // gather every block once; each chain of split blocks is one segment
+    std::unordered_set<Block*> blocks;
+    for (const auto& [ptr, block] : memInfo.allocatedBlocks_) {
+      blocks.insert(block);
+    }
+    blocks.insert(memInfo.largeBlocks_.begin(), memInfo.largeBlocks_.end());
+    blocks.insert(memInfo.smallBlocks_.begin(), memInfo.smallBlocks_.end());
+    for (const auto& [id, pool] : memInfo.privatePools_) {
+      blocks.insert(pool->largeBlocks_.begin(), pool->largeBlocks_.end());
+      blocks.insert(pool->smallBlocks_.begin(), pool->smallBlocks_.end());
+    }
+    for (const auto& pendingBlocks : memInfo.pendingBlocks_) {
+      blocks.insert(pendingBlocks.blocks_.begin(), pendingBlocks.blocks_.end());
+    }
+    std::vector<Block*> heads;
+    for (Block* block : blocks) {
+      if (!block->prev_) {
+        heads.push_back(block);
+      }
+    }
+    std::sort(heads.begin(), heads.end(), [](Block* a, Block* b) {
+      return (uintptr_t)a->ptr_ < (uintptr_t)b->ptr_;
+    });
+
+    ostream << (firstDevice ? "" : ",") << "\n  {\"device\": " << deviceId
+            << ", \"allocatedBytes\": " << memInfo.stats_.allocatedBytes_
+            << ", \"cachedBytes\": " << memInfo.stats_.cachedBytes_
+            << ", \"segments\": [";
+    firstDevice = false;
+    for (size_t i = 0; i < heads.size(); ++i) {
+      size_t segmentSize = 0;
+      for (Block* block = heads[i]; block; block = block->next_) {
+        segmentSize += block->size_;
+      }
+      ostream << (i == 0 ? "" : ",") << "\n    {\"address\": "
+              << toJsonPointer(heads[i]->ptr_) << ", \"size\": " << segmentSize
+              << ", \"expandable\": "
+              << (heads[i]->segment_ ? "true" : "false") << ", \"blocks\": [";
+      for (Block* block = heads[i]; block; block = block->next_) {
+        const char* state = block->pending_
+            ? "pending"
+            : (block->inUse() ? "allocated" : "free");
+        ostream << (block == heads[i] ? "" : ", ")
+                << "{\"address\": " << toJsonPointer(block->ptr_)
+                << ", \"size\": " << block->size_ << ", \"state\": \""
+                << state << "\", \"stream\": "
+                << toJsonPointer(block->stream_) << "}";
+      }
+      ostream << "]}";
+    }
+    ostream << "]}";
+  }
+  ostream << "],\n\"history\": [";
+  const auto history = getHistory();
+  for (size_t i = 0; i < history.size(); ++i) {
+    const auto& event = history[i];
+    ostream << (i == 0 ? "" : ",") << "\n  {\"action\": \""
+            << actionToString(event.action_)
+            << "\", \"address\": " << toJsonPointer(event.ptr_)
+            << ", \"size\": " << event.size_
+            << ", \"stream\": " << toJsonPointer(event.stream_)
+            << ", \"device\": " << event.deviceId_ << ", \"timeUs\": "
+            << std::chrono::duration_cast<std::chrono::microseconds>(
+                   event.time_.time_since_epoch())
+                   .count()
+            << ", \"tag\": " << toJsonString(event.tag_) << "}";
+  }
+  ostream << "]}" << std::endl;
+}
+
 CachingMemoryManager::DeviceMemoryInfo&
 CachingMemoryManager::getDeviceMemoryInfo(int device /* = -1*/) {
   if (device == -1) {
     device = this->deviceInterface->getActiveDeviceId();
   }
+  std::lock_guard<std::mutex> lock(deviceMemInfosMutex_);
   auto it = deviceMemInfos_.find(device);
+  if (it == deviceMemInfos_.end() && device >= 0 && device < numDevices_) {
+    it = deviceMemInfos_
+             .emplace(
+                 device,
+                 std::make_unique<CachingMemoryManager::DeviceMemoryInfo>(
+                     device))
+             .first;
+  }
   if (it == deviceMemInfos_.end() || !it->second) {
     throw std::runtime_error("meminfo for the device doesn't exist");
   }
   return *(it->second);
 }
+
+std::vector<CachingMemoryManager::DeviceMemoryInfo*>
+CachingMemoryManager::getDeviceMemoryInfos() {
+  // copied, as their mutexes may not be taken while holding this one
+  std::lock_guard<std::mutex> lock(deviceMemInfosMutex_);
+  std::vector<DeviceMemoryInfo*> infos;
+  for (auto& [deviceId, memInfoPtr] : deviceMemInfos_) {
+    infos.push_back(memInfoPtr.get());
+  }
+  return infos;
+}
 } // namespace fl
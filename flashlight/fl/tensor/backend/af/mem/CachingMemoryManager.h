@@ -7,16 +7,23 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <limits>
 #include <memory>
 #include <mutex>
 #include <numeric>
 #include <ostream>
 #include <set>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "flashlight/fl/common/Metrics.h"
 #include "flashlight/fl/tensor/backend/af/mem/MemoryManagerAdapter.h"
 #include "flashlight/fl/tensor/backend/af/mem/MemoryManagerDeviceInterface.h"
 
@@ -24,6 +31,30 @@ namespace fl {
 
 /**
  * Reimplementation of CudaCachingAllocator from Torch adapted for flashlight
+ *
+ * Cached blocks are kept per stream: a block is tagged with the stream it was
+ * freed on and is reused freely by later allocations on that stream. Before a
+ * block can be handed off to another stream, an event is recorded on the
+ * stream it was freed on and the block is held back until the event completes;
+ * it then becomes safe to reuse on any stream. Without the stream functions of
+ * `MemoryManagerDeviceInterface`, all blocks share a single pool.
+ *
+ * With expandable segments enabled (`setExpandableSegments` or the
+ * FL_MEM_EXPANDABLE_SEGMENTS environment variable) and the virtual memory
+ * functions of `MemoryManagerDeviceInterface` available, large blocks are
+ * carved out of a single reserved address range per device which is backed by
+ * physical memory on demand. A free block at the end of the range grows in
+ * place instead of requiring a new contiguous native allocation, which avoids
+ * most fragmentation.
+ *
+ * Allocations can also be directed to a private pool (`beginAllocateToPool`),
+ * e.g. while capturing a CUDA graph: blocks of a private pool are only reused
+ * by allocations to the same pool, so that memory used by a captured graph
+ * stays valid for its replays even once the graph freed it.
+ *
+ * The state of a device is created on its first allocation, so that devices
+ * which are never used aren't touched.
+ *
  * Sources :
  * https://github.com/torch/cutorch/blob/master/lib/THC/THCCachingAllocator.h
  * https://github.com/pytorch/pytorch/blob/master/c10/cuda/CUDACachingAllocator.cpp
@@ -55,10 +86,78 @@ class CachingMemoryManager : public MemoryManagerAdapter {
   bool jitTreeExceedsMemoryPressure(size_t bytes) override;
   void addMemoryManagement(int device) override;
   void removeMemoryManagement(int device) override;
+  size_t getPeakAllocatedBytes(int device) override;
+  void resetPeakAllocatedBytes(int device) override;
   // Set runtime options: RecyclingSizeLimit, SplitSizeLimit, ... Warning: not
   // thread safe
   void setRecyclingSizeLimit(size_t);
   void setSplitSizeLimit(size_t);
+  void setExpandableSegments(bool);
+
+  // An allocator event captured by the history recorder.
+  struct TraceEvent {
+    enum class Action {
+      Alloc, // block handed out
+      Free, // block returned to the cache
+      NativeAlloc, // native buffer allocated
+      NativeFree, // native buffer freed
+      SegmentMap, // expandable segment grown
+      SegmentUnmap, // expandable segment shrunk
+    };
+    Action action_;
+    void* ptr_;
+    size_t size_;
+    void* stream_; // active stream, see MemoryManagerDeviceInterface
+    int deviceId_;
+    std::chrono::steady_clock::time_point time_;
+    std::string tag_; // from the user-provided TagFn, if any
+  };
+
+  // Returns a tag for recorded events, e.g. the name of the active profile
+  // trace. Called with the manager locked; must not allocate through it.
+  using TagFn = std::function<std::string()>;
+
+  /**
+   * Records the `maxEvents` most recent allocator events in a ring buffer.
+   * Recording again clears the history; `maxEvents == 0` stops recording.
+   */
+  void recordHistory(size_t maxEvents, TagFn tagFn = nullptr);
+
+  // The recorded events, oldest first.
+  std::vector<TraceEvent> getHistory();
+
+  /**
+   * Prints a JSON snapshot of all blocks on all devices, grouped into the
+   * native buffers or expandable segments they were split from, followed by
+   * the recorded history.
+   */
+  void printSnapshot(std::ostream* ostream = &std::cout);
+
+  static const char* actionToString(TraceEvent::Action action);
+
+  // Identifies a private pool; ids are shared across devices.
+  using PrivatePoolId = uint64_t;
+
+  /**
+   * Serves all allocations on the active device from the private pool `id`,
+   * creating it if needed, until `endAllocateToPool`. Meanwhile, cross-stream
+   * handoffs, cleanup retries and expandable segments are skipped since they
+   * would synchronize with the device, which e.g. graph capture forbids.
+   *
+   * Each call must be matched by a `releasePool`.
+   */
+  void beginAllocateToPool(PrivatePoolId id);
+  void endAllocateToPool();
+
+  /**
+   * Drops a reference to private pool `id`. Once unreferenced, its blocks
+   * return to the regular pools of their device, and blocks still allocated
+   * do so when freed.
+   */
+  void releasePool(PrivatePoolId id);
+
+  struct ExpandableSegment;
+  struct PrivatePool;
 
   // Block denotes a single allocated unit of memory.
   struct Block {
@@ -68,6 +167,10 @@ class CachingMemoryManager : public MemoryManagerAdapter {
     bool userLock_; // whether the memory is locked by the user
     Block* prev_; // prev block if split from a larger allocation
     Block* next_; // next block if split from a larger allocation
+    void* stream_; // stream the block was freed on, nullptr if safe on any
+    bool pending_; // whether the block awaits a cross-stream handoff
+    ExpandableSegment* segment_; // segment containing the block, if any
+    PrivatePool* privatePool_; // pool the block returns to, if private
 
     bool isSplit() const {
       return (prev_ != nullptr) || (next_ != nullptr);
@@ -83,24 +186,64 @@ class CachingMemoryManager : public MemoryManagerAdapter {
           managerLock_(false),
           userLock_(false),
           prev_(nullptr),
-          next_(nullptr) {}
+          next_(nullptr),
+          stream_(nullptr),
+          pending_(false),
+          segment_(nullptr),
+          privatePool_(nullptr) {}
+  };
+
+  // A reserved address range of which [base_, base_ + mappedSize_) is backed
+  // by physical memory. Its blocks form a single chain of split blocks.
+  struct ExpandableSegment {
+    void* base_;
+    size_t reservedSize_;
+    size_t mappedSize_;
+    Block* tail_; // the block ending at base_ + mappedSize_, if any
   };
 
   typedef bool (*Comparison)(const Block*, const Block*);
   typedef std::set<Block*, Comparison> BlockSet;
 
+  // Cached blocks only reused by allocations to this pool, split into large
+  // and small blocks like the regular pools.
+  struct PrivatePool {
+    BlockSet largeBlocks_;
+    BlockSet smallBlocks_;
+    size_t useCount_; // beginAllocateToPool calls not released yet
+
+    PrivatePool();
+  };
+
   // A structure to store allocation stats per device.
   struct MemoryAllocationStats {
     size_t totalNativeMallocs_;
     size_t totalNativeFrees_;
     size_t allocatedBytes_; // memory allocated by mem manager for the program
     size_t cachedBytes_; // memory held by mem manager & not used by the program
+    size_t totalStreamHandoffs_; // blocks handed off to another stream
+    size_t peakAllocatedBytes_; // most allocated bytes since the last reset
 
     MemoryAllocationStats()
         : totalNativeMallocs_(0),
           totalNativeFrees_(0),
           allocatedBytes_(0),
-          cachedBytes_(0) {}
+          cachedBytes_(0),
+          totalStreamHandoffs_(0),
+          peakAllocatedBytes_(0) {}
+
+    void addAllocatedBytes(size_t bytes) {
+      allocatedBytes_ += bytes;
+      peakAllocatedBytes_ = std::max(peakAllocatedBytes_, allocatedBytes_);
+    }
+  };
+
+  // Cached blocks freed on the same stream, waiting for `event_` (recorded on
+  // that stream) to complete before they may be reused on any stream.
+  struct PendingBlocks {
+    void* event_;
+    BlockSet* pool_; // the pool the blocks are returned to
+    std::vector<Block*> blocks_;
   };
 
   // Stores the mutex and misc variables per device so that we operate in a
@@ -120,13 +263,39 @@ class CachingMemoryManager : public MemoryManagerAdapter {
     // allocated blocks by device pointer
     std::unordered_map<void*, Block*> allocatedBlocks_;
 
+    // cached blocks awaiting a cross-stream handoff, oldest first
+    std::deque<PendingBlocks> pendingBlocks_;
+
+    // native events not currently recorded, kept for reuse
+    std::vector<void*> freeEvents_;
+
+    // holds large blocks if expandable segments are enabled
+    std::unique_ptr<ExpandableSegment> segment_;
+
+    // private pools by id, and the one allocations are directed to, if any
+    std::unordered_map<PrivatePoolId, std::unique_ptr<PrivatePool>>
+        privatePools_;
+    PrivatePool* allocatingPool_{nullptr};
+
     MemoryAllocationStats stats_;
 
+    // the stats exported to the `MetricsRegistry`, and those already counted
+    GaugeMetric& allocatedBytesMetric_;
+    GaugeMetric& cachedBytesMetric_;
+    GaugeMetric& peakAllocatedBytesMetric_;
+    CounterMetric& nativeMallocsMetric_;
+    CounterMetric& nativeFreesMetric_;
+    size_t exportedNativeMallocs_{0};
+    size_t exportedNativeFrees_{0};
+
     explicit DeviceMemoryInfo(int id);
   };
 
  protected:
+  // created lazily for the devices below numDevices_, or added by ArrayFire
   std::unordered_map<int, std::unique_ptr<DeviceMemoryInfo>> deviceMemInfos_;
+  int numDevices_;
+  std::mutex deviceMemInfosMutex_;
 
   CachingMemoryManager(const CachingMemoryManager& other) = delete;
   CachingMemoryManager(CachingMemoryManager&& other) = delete;
@@ -137,14 +306,65 @@ class CachingMemoryManager : public MemoryManagerAdapter {
   // Using "-1" will return info for the current active device.
   DeviceMemoryInfo& getDeviceMemoryInfo(int device = -1);
 
+  // The memory info of the devices which were used.
+  std::vector<DeviceMemoryInfo*> getDeviceMemoryInfos();
+
   void
   freeBlocks(BlockSet& blocks, BlockSet::iterator it, BlockSet::iterator end);
 
-  void mallocWithRetry(size_t size, void** ptr);
+  // Retries after freeing cached memory if `retry` is set.
+  void mallocWithRetry(size_t size, void** ptr, bool retry = true);
+
+  // Returns the blocks set a block of given pool and kind is cached in.
+  BlockSet&
+  getBlockSet(DeviceMemoryInfo& memoryInfo, PrivatePool* pool, bool isSmall);
 
   void tryMergeBlocks(Block* dst, Block* src, BlockSet& freeBlocks);
   void freeBlock(Block* block);
 
+  // Returns the active native stream, or nullptr if streams aren't tracked.
+  void* getActiveStream();
+
+  // Returns the smallest cached block of at least `size` bytes in `pool` that
+  // can be reused on `stream` without synchronization, or pool.end().
+  BlockSet::iterator
+  findReusableBlock(BlockSet& pool, void* stream, size_t size);
+
+  // Starts handing off the blocks of at least `size` bytes in `pool` cached by
+  // streams other than `stream` (any stream if nullptr). Returns whether any
+  // handoff was started.
+  bool startStreamHandoffs(
+      DeviceMemoryInfo& memoryInfo,
+      BlockSet& pool,
+      void* stream,
+      size_t size);
+
+  // Makes the pending blocks whose event completed reusable on any stream. If
+  // `wait` is set, waits for all pending events.
+  void processPendingBlocks(DeviceMemoryInfo& memoryInfo, bool wait);
+
+  // Destroys the native events owned by `memoryInfo`.
+  void releaseEvents(DeviceMemoryInfo& memoryInfo);
+
+  bool useExpandableSegments() const;
+
+  // Maps memory at the end of the device's segment to return an unused block
+  // of at least `size` bytes, or nullptr if the segment can't grow.
+  Block*
+  growSegment(DeviceMemoryInfo& memoryInfo, size_t size, void* stream);
+
+  // Unmaps the free memory at the end of the device's segment.
+  void shrinkSegment(DeviceMemoryInfo& memoryInfo);
+
+  void recordEvent(
+      TraceEvent::Action action,
+      void* ptr,
+      size_t size,
+      const DeviceMemoryInfo& memoryInfo);
+
+  // Updates the metrics of `memoryInfo` from its stats.
+  void exportMetrics(DeviceMemoryInfo& memoryInfo);
+
  private:
   // Non-const runtime options in order to fine tune the behavior of this
   // manager. Prevents to recycle some buffers, to be set by the user if
@@ -153,6 +373,16 @@ class CachingMemoryManager : public MemoryManagerAdapter {
   // size_t recyclingSizeLimit;
   // Prevents to split big buffers, to be set by the user if desired:
   size_t splitSizeLimit_{std::numeric_limits<size_t>::max()};
+  // Grows large blocks in place using virtual memory, when supported:
+  bool expandableSegments_{false};
+
+  // History recorder: a ring buffer of the most recent events
+  std::mutex historyMutex_;
+  std::atomic<bool> recordingHistory_{false};
+  size_t historyCapacity_{0};
+  size_t historyStart_{0}; // index of the oldest event
+  std::vector<TraceEvent> history_;
+  TagFn tagFn_;
 };
 
 } // namespace fl
@@ -75,4 +75,10 @@ size_t MemoryManagerAdapter::getMemStepSize() {
 
 void MemoryManagerAdapter::setMemStepSize(size_t size) {}
 
+size_t MemoryManagerAdapter::getPeakAllocatedBytes(int /* device */) {
+  return 0;
+}
+
+void MemoryManagerAdapter::resetPeakAllocatedBytes(int /* device */) {}
+
 } // namespace fl
@@ -94,6 +94,11 @@ class MemoryManagerAdapter {
   virtual size_t getMemStepSize();
   virtual void setMemStepSize(size_t size);
 
+  // The largest number of bytes allocated on a device since the last reset,
+  // or 0 if the memory manager doesn't track it
+  virtual size_t getPeakAllocatedBytes(int device);
+  virtual void resetPeakAllocatedBytes(int device);
+
   /**
    * Logs information to the `MemoryManagerAdapters`'s log stream. If logging
    * mode is enabled, function calls to virtual base class methods are logged.
@@ -17,6 +17,17 @@ using NativeAllocFn = std::function<void*(size_t)>;
 using NativeFreeFn = std::function<void(void*)>;
 using GetMemoryPressureThresholdFn = std::function<float()>;
 using SetMemoryPressureThresholdFn = std::function<void(float)>;
+using GetActiveStreamFn = std::function<void*()>;
+using CreateEventFn = std::function<void*()>;
+using DestroyEventFn = std::function<void(void*)>;
+using RecordEventFn = std::function<void(void* event, void* stream)>;
+using QueryEventFn = std::function<bool(void*)>;
+using SyncEventFn = std::function<void(void*)>;
+using GetMemoryGranularityFn = std::function<size_t()>;
+using ReserveAddressRangeFn = std::function<void*(size_t)>;
+using FreeAddressRangeFn = std::function<void(void* ptr, size_t size)>;
+using MapMemoryFn = std::function<void(void* ptr, size_t size)>;
+using UnmapMemoryFn = std::function<void(void* ptr, size_t size)>;
 
 /**
  * An interface for using native device memory management and JIT-related memory
@@ -33,6 +44,15 @@ using SetMemoryPressureThresholdFn = std::function<void(float)>;
  * `MemoryManagerInstaller`'s `setMemoryManager` or `setMemoryManagerPinned`
  * method. Until one of these are called, the functions therein remain unset.
  *
+ * Stream and event functions are optional and operate on opaque native
+ * handles. A memory manager may use them to keep cached memory ordered with
+ * respect to the stream it was last used on. If `getActiveStream` is unset,
+ * all work is assumed to be ordered on a single stream.
+ *
+ * Virtual memory functions are optional as well. They let a memory manager
+ * reserve a range of device addresses up front and back parts of it with
+ * physical memory on demand, so that allocations can grow in place.
+ *
  * For documentation of virtual methods, see [ArrayFire's memory
  * header](https://git.io/Jv7do) for full specifications.
  */
@@ -45,6 +65,20 @@ struct MemoryManagerDeviceInterface {
   // Memory pressure functions
   GetMemoryPressureThresholdFn getMemoryPressureThreshold;
   SetMemoryPressureThresholdFn setMemoryPressureThreshold;
+  // Native stream and event functions
+  GetActiveStreamFn getActiveStream;
+  CreateEventFn createEvent;
+  DestroyEventFn destroyEvent;
+  RecordEventFn recordEvent; // record event on stream
+  QueryEventFn queryEvent; // true iff all work before the event completed
+  SyncEventFn syncEvent; // block the host until the event completes
+  // Native virtual memory functions. Sizes and addresses passed to
+  // map/unmapMemory are multiples of getMemoryGranularity()
+  GetMemoryGranularityFn getMemoryGranularity;
+  ReserveAddressRangeFn reserveAddressRange;
+  FreeAddressRangeFn freeAddressRange;
+  MapMemoryFn mapMemory; // back an address range with physical memory
+  UnmapMemoryFn unmapMemory; // release physical memory after pending work
 };
 
 } // namespace fl
@@ -10,17 +10,126 @@
 #include <cstdint>
 #include <cstdlib>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
 
 #include <af/device.h>
 
 #include "flashlight/fl/tensor/backend/af/Utils.h"
 #include "flashlight/fl/tensor/backend/af/mem/CachingMemoryManager.h"
 
+#if FL_ARRAYFIRE_USE_CUDA
+  #include <cuda.h>
+  #include <cuda_runtime.h>
+
+  #include <af/cuda.h>
+
+  #include "flashlight/fl/runtime/CUDAGraph.h"
+  #include "flashlight/fl/runtime/CUDAUtils.h"
+#endif
+
 namespace fl {
 
+namespace {
+
+// Memory allocated outside of ArrayFire, see registerExternalBuffer
+struct ExternalBuffer {
+  std::shared_ptr<void> owner;
+  bool userLocked{false};
+  bool released{false}; // by ArrayFire
+};
+
+std::mutex externalBuffersMutex;
+std::unordered_map<const void*, ExternalBuffer> externalBuffers;
+
+// The following return false if the memory isn't external. Owners are
+// released outside of the lock.
+
+bool userLockExternalBuffer(const void* ptr) {
+  std::lock_guard<std::mutex> lock(externalBuffersMutex);
+  auto it = externalBuffers.find(ptr);
+  if (it == externalBuffers.end()) {
+    return false;
+  }
+  it->second.userLocked = true;
+  return true;
+}
+
+bool unlockExternalBuffer(const void* ptr, bool userUnlock) {
+  std::shared_ptr<void> owner;
+  std::lock_guard<std::mutex> lock(externalBuffersMutex);
+  auto it = externalBuffers.find(ptr);
+  if (it == externalBuffers.end()) {
+    return false;
+  }
+  auto& buffer = it->second;
+  if (userUnlock) {
+    buffer.userLocked = false;
+  } else {
+    buffer.released = true;
+  }
+  if (buffer.released && !buffer.userLocked) {
+    owner = std::move(buffer.owner);
+    externalBuffers.erase(it);
+  }
+  return true;
+}
+
+bool isExternalBufferUserLocked(const void* ptr, int* out) {
+  std::lock_guard<std::mutex> lock(externalBuffersMutex);
+  auto it = externalBuffers.find(ptr);
+  if (it == externalBuffers.end()) {
+    return false;
+  }
+  *out = (int)it->second.userLocked;
+  return true;
+}
+
+} // namespace
+
+#if FL_ARRAYFIRE_USE_CUDA
+namespace {
+
+void checkCudaDriver(CUresult result, const char* what) {
+  if (result != CUDA_SUCCESS) {
+    const char* message = nullptr;
+    cuGetErrorString(result, &message);
+    throw std::runtime_error(
+        std::string("[MemoryManagerInstaller] ") + what +
+        " failed: " + (message ? message : "unknown error"));
+  }
+}
+
+// Physical memory allocation properties for the given AF device
+CUmemAllocationProp getAllocationProp(int afDeviceId) {
+  CUmemAllocationProp prop = {};
+  prop.type = CU_MEM_ALLOCATION_TYPE_PINNED;
+  prop.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+  prop.location.id = afcu::getNativeId(afDeviceId);
+  return prop;
+}
+
+bool supportsVirtualMemory(int afDeviceId) {
+  CUdevice device;
+  int supported = 0;
+  return cuDeviceGet(&device, afcu::getNativeId(afDeviceId)) ==
+      CUDA_SUCCESS &&
+      cuDeviceGetAttribute(
+          &supported,
+          CU_DEVICE_ATTRIBUTE_VIRTUAL_MEMORY_MANAGEMENT_SUPPORTED,
+          device) == CUDA_SUCCESS &&
+      supported;
+}
+
+} // namespace
+#endif
+
 // Statics from MemoryManagerInstaller
 std::shared_ptr<MemoryManagerAdapter>
     MemoryManagerInstaller::currentlyInstalledMemoryManager_;
+std::shared_ptr<MemoryManagerAdapter>
+    MemoryManagerInstaller::currentlyInstalledPinnedMemoryManager_;
 
 MemoryManagerAdapter* MemoryManagerInstaller::getImpl(
     af_memory_manager manager) {
@@ -99,7 +208,9 @@ MemoryManagerInstaller::MemoryManagerInstaller(
   auto unlockFn = [](af_memory_manager manager, void* ptr, int userLock) {
     MemoryManagerAdapter* m = MemoryManagerInstaller::getImpl(manager);
     m->log("unlock", (std::uintptr_t)ptr, userLock);
-    m->unlock(ptr, (bool)userLock);
+    if (!unlockExternalBuffer(ptr, (bool)userLock)) {
+      m->unlock(ptr, (bool)userLock);
+    }
     return AF_SUCCESS;
   };
   AF_CHECK(af_memory_manager_set_unlock_fn(itf, unlockFn));
@@ -121,21 +232,27 @@ MemoryManagerInstaller::MemoryManagerInstaller(
   auto userLockFn = [](af_memory_manager manager, void* ptr) {
     MemoryManagerAdapter* m = MemoryManagerInstaller::getImpl(manager);
     m->log("userLock", (std::uintptr_t)ptr);
-    m->userLock(ptr);
+    if (!userLockExternalBuffer(ptr)) {
+      m->userLock(ptr);
+    }
     return AF_SUCCESS;
   };
   AF_CHECK(af_memory_manager_set_user_lock_fn(itf, userLockFn));
   auto userUnlockFn = [](af_memory_manager manager, void* ptr) {
     MemoryManagerAdapter* m = MemoryManagerInstaller::getImpl(manager);
     m->log("userUnlock", (std::uintptr_t)ptr);
-    MemoryManagerInstaller::getImpl(manager)->userUnlock(ptr);
+    if (!unlockExternalBuffer(ptr, /* userUnlock = */ true)) {
+      MemoryManagerInstaller::getImpl(manager)->userUnlock(ptr);
+    }
     return AF_SUCCESS;
   };
   AF_CHECK(af_memory_manager_set_user_unlock_fn(itf, userUnlockFn));
   auto isUserLockedFn = [](af_memory_manager manager, int* out, void* ptr) {
     MemoryManagerAdapter* m = MemoryManagerInstaller::getImpl(manager);
     m->log("isUserLocked", (std::uintptr_t)ptr);
-    *out = (int)m->isUserLocked(ptr);
+    if (!isExternalBufferUserLocked(ptr, out)) {
+      *out = (int)m->isUserLocked(ptr);
+    }
     return AF_SUCCESS;
   };
   AF_CHECK(af_memory_manager_set_is_user_locked_fn(itf, isUserLockedFn));
@@ -204,6 +321,96 @@ MemoryManagerInstaller::MemoryManagerInstaller(
   };
   impl_->deviceInterface->setMemoryPressureThreshold =
       std::move(setMemoryPressureThresholdFn);
+
+#if FL_ARRAYFIRE_USE_CUDA
+  // Native stream and event functions
+  auto getActiveStreamFn = [itf]() {
+    int id;
+    AF_CHECK(af_memory_manager_get_active_device_id(itf, &id));
+    return static_cast<void*>(afcu::getStream(id));
+  };
+  impl_->deviceInterface->getActiveStream = std::move(getActiveStreamFn);
+  impl_->deviceInterface->createEvent = []() {
+    cudaEvent_t event;
+    FL_CUDA_CHECK(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+    return static_cast<void*>(event);
+  };
+  impl_->deviceInterface->destroyEvent = [](void* event) {
+    FL_CUDA_CHECK(cudaEventDestroy(static_cast<cudaEvent_t>(event)));
+  };
+  impl_->deviceInterface->recordEvent = [](void* event, void* stream) {
+    FL_CUDA_CHECK(cudaEventRecord(
+        static_cast<cudaEvent_t>(event), static_cast<cudaStream_t>(stream)));
+  };
+  impl_->deviceInterface->queryEvent = [](void* event) {
+    const auto status = cudaEventQuery(static_cast<cudaEvent_t>(event));
+    if (status == cudaErrorNotReady) {
+      return false;
+    }
+    FL_CUDA_CHECK(status);
+    return true;
+  };
+  impl_->deviceInterface->syncEvent = [](void* event) {
+    FL_CUDA_CHECK(cudaEventSynchronize(static_cast<cudaEvent_t>(event)));
+  };
+
+  // Native virtual memory functions, if supported by the active device
+  int activeDeviceId;
+  AF_CHECK(af_memory_manager_get_active_device_id(itf, &activeDeviceId));
+  if (supportsVirtualMemory(activeDeviceId)) {
+    auto getMemoryGranularityFn = [itf]() {
+      int id;
+      AF_CHECK(af_memory_manager_get_active_device_id(itf, &id));
+      const auto prop = getAllocationProp(id);
+      size_t granularity;
+      checkCudaDriver(
+          cuMemGetAllocationGranularity(
+              &granularity, &prop, CU_MEM_ALLOC_GRANULARITY_MINIMUM),
+          "cuMemGetAllocationGranularity");
+      return granularity;
+    };
+    impl_->deviceInterface->getMemoryGranularity =
+        std::move(getMemoryGranularityFn);
+    impl_->deviceInterface->reserveAddressRange = [](size_t size) {
+      CUdeviceptr ptr;
+      checkCudaDriver(
+          cuMemAddressReserve(&ptr, size, 0, 0, 0), "cuMemAddressReserve");
+      return reinterpret_cast<void*>(ptr);
+    };
+    impl_->deviceInterface->freeAddressRange = [](void* ptr, size_t size) {
+      checkCudaDriver(
+          cuMemAddressFree(reinterpret_cast<CUdeviceptr>(ptr), size),
+          "cuMemAddressFree");
+    };
+    auto mapMemoryFn = [itf](void* ptr, size_t size) {
+      int id;
+      AF_CHECK(af_memory_manager_get_active_device_id(itf, &id));
+      const auto prop = getAllocationProp(id);
+      CUmemGenericAllocationHandle handle;
+      checkCudaDriver(cuMemCreate(&handle, size, &prop, 0), "cuMemCreate");
+      const auto dptr = reinterpret_cast<CUdeviceptr>(ptr);
+      const auto mapResult = cuMemMap(dptr, size, 0, handle, 0);
+      // the mapping keeps the physical memory alive until it is unmapped
+      cuMemRelease(handle);
+      checkCudaDriver(mapResult, "cuMemMap");
+      CUmemAccessDesc access = {};
+      access.location = prop.location;
+      access.flags = CU_MEM_ACCESS_FLAGS_PROT_READWRITE;
+      const auto accessResult = cuMemSetAccess(dptr, size, &access, 1);
+      if (accessResult != CUDA_SUCCESS) {
+        cuMemUnmap(dptr, size);
+      }
+      checkCudaDriver(accessResult, "cuMemSetAccess");
+    };
+    impl_->deviceInterface->mapMemory = std::move(mapMemoryFn);
+    impl_->deviceInterface->unmapMemory = [](void* ptr, size_t size) {
+      // unlike cudaFree, unmapping doesn't wait for pending work
+      FL_CUDA_CHECK(cudaDeviceSynchronize());
+      checkCudaDriver(
+          cuMemUnmap(reinterpret_cast<CUdeviceptr>(ptr), size), "cuMemUnmap");
+    };
+  }
+#endif
 }
 
 void MemoryManagerInstaller::setAsMemoryManager() {
@@ -212,8 +419,14 @@ void MemoryManagerInstaller::setAsMemoryManager() {
 }
 
 void MemoryManagerInstaller::setAsMemoryManagerPinned() {
+  auto& itf = *impl_->deviceInterface;
+  itf.getMemoryGranularity = nullptr;
+  itf.reserveAddressRange = nullptr;
+  itf.freeAddressRange = nullptr;
+  itf.mapMemory = nullptr;
+  itf.unmapMemory = nullptr;
   AF_CHECK(af_set_memory_manager_pinned(impl_->getHandle()));
-  currentlyInstalledMemoryManager_ = impl_;
+  currentlyInstalledPinnedMemoryManager_ = impl_;
 }
 
 MemoryManagerAdapter*
@@ -221,12 +434,37 @@ MemoryManagerInstaller::currentlyInstalledMemoryManager() {
   return currentlyInstalledMemoryManager_.get();
 }
 
+MemoryManagerAdapter*
+MemoryManagerInstaller::currentlyInstalledPinnedMemoryManager() {
+  return currentlyInstalledPinnedMemoryManager_.get();
+}
+
 void MemoryManagerInstaller::installDefaultMemoryManager() {
   auto deviceInterface = std::make_shared<MemoryManagerDeviceInterface>();
   auto adapter = std::make_shared<CachingMemoryManager>(
       af::getDeviceCount(), deviceInterface);
   auto installer = MemoryManagerInstaller(adapter);
   installer.setAsMemoryManager();
+#if FL_ARRAYFIRE_USE_CUDA
+  // memory allocated while capturing a graph must stay reserved for the graph
+  CUDAGraph::MemoryPoolHooks hooks;
+  hooks.beginAllocateToPool = [adapter](CUDAGraph::MemoryPoolId id) {
+    adapter->beginAllocateToPool(id);
+  };
+  hooks.endAllocateToPool = [adapter]() { adapter->endAllocateToPool(); };
+  hooks.releasePool = [adapter](CUDAGraph::MemoryPoolId id) {
+    adapter->releasePool(id);
+  };
+  CUDAGraph::setMemoryPoolHooks(std::move(hooks));
+#endif
+}
+
+void MemoryManagerInstaller::installDefaultPinnedMemoryManager() {
+  auto deviceInterface = std::make_shared<MemoryManagerDeviceInterface>();
+  auto adapter = std::make_shared<CachingMemoryManager>(
+      af::getDeviceCount(), deviceInterface);
+  auto installer = MemoryManagerInstaller(adapter);
+  installer.setAsMemoryManagerPinned();
 }
 
 void MemoryManagerInstaller::unsetMemoryManager() {
@@ -234,6 +472,27 @@ void MemoryManagerInstaller::unsetMemoryManager() {
   if (currentlyInstalledMemoryManager_) {
     AF_CHECK(af_unset_memory_manager());
     currentlyInstalledMemoryManager_ = nullptr;
+#if FL_ARRAYFIRE_USE_CUDA
+    CUDAGraph::setMemoryPoolHooks({});
+#endif
+  }
+}
+
+void MemoryManagerInstaller::unsetPinnedMemoryManager() {
+  if (currentlyInstalledPinnedMemoryManager_) {
+    AF_CHECK(af_unset_memory_manager_pinned());
+    currentlyInstalledPinnedMemoryManager_ = nullptr;
+  }
+}
+
+void MemoryManagerInstaller::registerExternalBuffer(
+    void* ptr,
+    std::shared_ptr<void> owner) {
+  std::lock_guard<std::mutex> lock(externalBuffersMutex);
+  if (!externalBuffers.emplace(ptr, ExternalBuffer{std::move(owner)}).second) {
+    throw std::invalid_argument(
+        "[MemoryManagerInstaller::registerExternalBuffer] memory is already "
+        "registered");
   }
 }
 
@@ -64,7 +64,9 @@ class MemoryManagerInstaller {
 
   /**
    * Sets this `MemoryManagerInstaller`'s `MemoryManagerAdapter` to be the
-   * active memory manager for pinned memory operations in ArrayFire.
+   * active memory manager for pinned memory operations in ArrayFire. Virtual
+   * memory functions of the adapter's `MemoryManagerDeviceInterface` are
+   * unset since they only apply to device memory.
    */
   void setAsMemoryManagerPinned();
 
@@ -80,6 +82,12 @@ class MemoryManagerInstaller {
    */
   static MemoryManagerAdapter* currentlyInstalledMemoryManager();
 
+  /**
+   * Returns the currently installed custom pinned memory manager, or null if
+   * none is installed.
+   */
+  static MemoryManagerAdapter* currentlyInstalledPinnedMemoryManager();
+
   /**
    * Initializes and installs the memory manager defaulted to on startup.
    *
@@ -88,6 +96,13 @@ class MemoryManagerInstaller {
    */
   static void installDefaultMemoryManager();
 
+  /**
+   * Initializes and installs a `CachingMemoryManager` as the AF pinned memory
+   * manager, so that pinned host buffers (e.g. for transfers) are cached with
+   * the same block and size class scheme as device memory.
+   */
+  static void installDefaultPinnedMemoryManager();
+
   /**
    * Unsets the currently-set custom ArrayFire memory manager. If no custom
    * memory manager is set, results in a noop, since the default memory manager
@@ -95,11 +110,34 @@ class MemoryManagerInstaller {
    */
   static void unsetMemoryManager();
 
+  /**
+   * Unsets the currently-set custom ArrayFire pinned memory manager, if any.
+   */
+  static void unsetPinnedMemoryManager();
+
+  /**
+   * Registers device memory allocated outside of ArrayFire, e.g. imported via
+   * DLPack, before creating an ArrayFire array from it. ArrayFire frees the
+   * memory of such arrays once released; instead, the installed memory
+   * manager is bypassed for this memory, and `owner` is released once
+   * ArrayFire releases the memory and it's no longer user-locked.
+   *
+   * Requires a custom memory manager to stay installed while the memory is
+   * in use. Throws if the memory is already registered.
+   *
+   * @param[in] ptr the external memory
+   * @param[in] owner keeps the memory alive until released
+   */
+  static void registerExternalBuffer(void* ptr, std::shared_ptr<void> owner);
+
  private:
   // The given memory manager implementation
   std::shared_ptr<MemoryManagerAdapter> impl_;
   // Points to the impl_ of the most recently installed manager.
   static std::shared_ptr<MemoryManagerAdapter> currentlyInstalledMemoryManager_;
+  // Points to the impl_ of the most recently installed pinned manager.
+  static std::shared_ptr<MemoryManagerAdapter>
+      currentlyInstalledPinnedMemoryManager_;
 };
 
 } // namespace fl
@@ -13,7 +13,11 @@
 #include "flashlight/fl/tensor/TensorBase.h"
 #include "flashlight/fl/tensor/backend/jit/JitTensorBase.h"
 #include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/MatmulNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ReductionNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ValueNode.h"
 
 #define FL_JIT_BACKEND_UNIMPLEMENTED \
   throw std::invalid_argument(       \
@@ -26,6 +30,22 @@ JitBackend::JitBackend(
     std::function<Tensor(Node*)> jitTensorCreator)
     : wrappedBackend_(wrappedBackend), jitTensorCreator_(jitTensorCreator) {}
 
+Tensor JitBackend::createJitTensor(Node* node) {
+  auto tensor = jitTensorCreator_(node);
+  if (materializationPolicy_.shouldMaterialize(node)) {
+    toJitTensorBase(tensor).materialize();
+  }
+  return tensor;
+}
+
+void JitBackend::setMaterializationPolicy(const MaterializationPolicy& policy) {
+  materializationPolicy_ = policy;
+}
+
+const MaterializationPolicy& JitBackend::materializationPolicy() const {
+  return materializationPolicy_;
+}
+
 TensorBackendType JitBackend::backendType() const {
   return TensorBackendType::Jit;
 }
@@ -66,6 +86,14 @@ void JitBackend::setMemMgrFlushInterval(const size_t /* interval */) {
   FL_JIT_BACKEND_UNIMPLEMENTED;
 }
 
+void* JitBackend::allocPinnedHost(const size_t bytes) {
+  return wrappedBackend_.allocPinnedHost(bytes);
+}
+
+void JitBackend::freePinnedHost(void* ptr) {
+  wrappedBackend_.freePinnedHost(ptr);
+}
+
 /* -------------------------- Rand Functions -------------------------- */
 
 void JitBackend::setSeed(const int /* seed */) {
@@ -108,13 +136,18 @@ FL_JIT_BACKEND_CREATE_FUN_LITERAL_DEF_STUB(const unsigned short&);
 
 template <typename T>
 Tensor JitBackend::fullWithType(const Shape& shape, T value, dtype type) {
-  return jitTensorCreator_(ScalarNode::create(shape, type, value));
+  return createJitTensor(ScalarNode::create(shape, type, value));
 }
 
 Tensor JitBackend::identity(const Dim /* dim */, const dtype /* type */) {
   FL_JIT_BACKEND_UNIMPLEMENTED;
 }
 
+Tensor JitBackend::fromDLPack(DLManagedTensor* dlTensor) {
+  return createJitTensor(
+      ValueNode::create(wrappedBackend_.fromDLPack(dlTensor)));
+}
+
 Tensor JitBackend::arange(
     const Shape& /* shape */,
     const Dim /* seqDim */,
@@ -165,65 +198,31 @@ Tensor JitBackend::pad(
 
 /************************** Unary Operators ***************************/
 
-Tensor JitBackend::exp(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::log(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::negative(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::logicalNot(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::log1p(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::sin(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::cos(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::sqrt(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::tanh(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::floor(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::ceil(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::rint(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::absolute(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::sigmoid(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
+#define FL_JIT_UNARY_OP_DEF(FUNC, UNARYOP)                      \
+  Tensor JitBackend::FUNC(const Tensor& tensor) {               \
+    const auto node = toJitTensorBase(tensor).node();           \
+    return createJitTensor(UnaryNode::create(node, UNARYOP));   \
+  }
 
-Tensor JitBackend::erf(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
+FL_JIT_UNARY_OP_DEF(exp, UnaryOp::Exp);
+FL_JIT_UNARY_OP_DEF(log, UnaryOp::Log);
+FL_JIT_UNARY_OP_DEF(negative, UnaryOp::Negative);
+FL_JIT_UNARY_OP_DEF(logicalNot, UnaryOp::LogicalNot);
+FL_JIT_UNARY_OP_DEF(log1p, UnaryOp::Log1p);
+FL_JIT_UNARY_OP_DEF(sin, UnaryOp::Sin);
+FL_JIT_UNARY_OP_DEF(cos, UnaryOp::Cos);
+FL_JIT_UNARY_OP_DEF(sqrt, UnaryOp::Sqrt);
+FL_JIT_UNARY_OP_DEF(tanh, UnaryOp::Tanh);
+FL_JIT_UNARY_OP_DEF(floor, UnaryOp::Floor);
+FL_JIT_UNARY_OP_DEF(ceil, UnaryOp::Ceil);
+FL_JIT_UNARY_OP_DEF(rint, UnaryOp::Rint);
+FL_JIT_UNARY_OP_DEF(absolute, UnaryOp::Absolute);
+FL_JIT_UNARY_OP_DEF(sigmoid, UnaryOp::Sigmoid);
+FL_JIT_UNARY_OP_DEF(erf, UnaryOp::Erf);
+FL_JIT_UNARY_OP_DEF(isnan, UnaryOp::IsNan);
+FL_JIT_UNARY_OP_DEF(isinf, UnaryOp::IsInf);
+FL_JIT_UNARY_OP_DEF(sign, UnaryOp::Sign);
+#undef FL_JIT_UNARY_OP_DEF
 
 Tensor JitBackend::flip(const Tensor& /* tensor */, const unsigned /* dim */) {
   FL_JIT_BACKEND_UNIMPLEMENTED;
@@ -243,18 +242,6 @@ Tensor JitBackend::roll(
   FL_JIT_BACKEND_UNIMPLEMENTED;
 }
 
-Tensor JitBackend::isnan(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::isinf(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor JitBackend::sign(const Tensor& /* tensor */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
-}
-
 Tensor JitBackend::tril(const Tensor& /* tensor */) {
   FL_JIT_BACKEND_UNIMPLEMENTED;
 }
@@ -388,7 +375,7 @@ FL_JIT_BINARY_OP_DEF_STUB(>>, rShift);
   Tensor JitBackend::FUNC(const Tensor& lhs, const Tensor& rhs) {          \
     const auto lhsNode = toJitTensorBase(lhs).node();                      \
     const auto rhsNode = toJitTensorBase(rhs).node();                      \
-    return jitTensorCreator_(BinaryNode::create(lhsNode, rhsNode, BINOP)); \
+    return createJitTensor(BinaryNode::create(lhsNode, rhsNode, BINOP));   \
   }                                                                        \
   FL_JIT_BINARY_OP_LITERALS_DEF(FUNC);
 
@@ -415,27 +402,34 @@ Tensor JitBackend::power(const Tensor& /* lhs */, const Tensor& /* rhs */) {
 /************************** BLAS ***************************/
 
 Tensor JitBackend::matmul(
-    const Tensor& /* lhs */,
-    const Tensor& /* rhs */,
-    MatrixProperty /* lhsProp */,
-    MatrixProperty /* rhsProp */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
+    const Tensor& lhs,
+    const Tensor& rhs,
+    MatrixProperty lhsProp,
+    MatrixProperty rhsProp) {
+  const auto lhsNode = toJitTensorBase(lhs).node();
+  const auto rhsNode = toJitTensorBase(rhs).node();
+  return createJitTensor(
+      MatmulNode::create(lhsNode, rhsNode, lhsProp, rhsProp));
 }
 
 /************************** Reductions ***************************/
 
 Tensor JitBackend::amin(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  const auto node = toJitTensorBase(input).node();
+  return createJitTensor(
+      ReductionNode::create(node, ReductionOp::Min, axes, keepDims));
 }
 
 Tensor JitBackend::amax(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  const auto node = toJitTensorBase(input).node();
+  return createJitTensor(
+      ReductionNode::create(node, ReductionOp::Max, axes, keepDims));
 }
 
 void JitBackend::min(
@@ -457,10 +451,12 @@ void JitBackend::max(
 }
 
 Tensor JitBackend::sum(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  const auto node = toJitTensorBase(input).node();
+  return createJitTensor(
+      ReductionNode::create(node, ReductionOp::Sum, axes, keepDims));
 }
 
 Tensor JitBackend::cumsum(
@@ -484,10 +480,12 @@ Tensor JitBackend::argmin(
 }
 
 Tensor JitBackend::mean(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_JIT_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  const auto node = toJitTensorBase(input).node();
+  return createJitTensor(
+      ReductionNode::create(node, ReductionOp::Mean, axes, keepDims));
 }
 
 Tensor JitBackend::median(
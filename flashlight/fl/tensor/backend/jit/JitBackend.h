@@ -9,6 +9,7 @@
 
 #include "flashlight/fl/tensor/TensorAdapter.h"
 #include "flashlight/fl/tensor/TensorBackend.h"
+#include "flashlight/fl/tensor/backend/jit/MaterializationPolicy.h"
 #include "flashlight/fl/tensor/backend/jit/ir/Node.h"
 
 namespace fl {
@@ -20,6 +21,11 @@ namespace fl {
 class JitBackend : public TensorBackend {
   TensorBackend& wrappedBackend_;
   std::function<Tensor(Node*)> jitTensorCreator_;
+  // when to eagerly evaluate lazily built trees
+  MaterializationPolicy materializationPolicy_{};
+
+  // create a JIT tensor for `node`, materialized if the policy says so
+  Tensor createJitTensor(Node* node);
 
   template<typename T>
   Tensor fullWithType(const Shape& shape, T value, dtype type);
@@ -31,6 +37,14 @@ class JitBackend : public TensorBackend {
   ~JitBackend() override = default;
   TensorBackendType backendType() const override;
 
+  /**
+   * Set the policy which decides when tensors created by this backend get
+   * materialized automatically, e.g., to bound memory kept alive by leaves
+   * of long lazy chains. Defaults to never.
+   */
+  void setMaterializationPolicy(const MaterializationPolicy& policy);
+  const MaterializationPolicy& materializationPolicy() const;
+
   // No copy or move construction or assignment
   JitBackend(JitBackend&&) = delete;
   JitBackend(const JitBackend&) = delete;
@@ -46,6 +60,8 @@ class JitBackend : public TensorBackend {
   void setMemMgrLogStream(std::ostream* stream) override;
   void setMemMgrLoggingEnabled(const bool enabled) override;
   void setMemMgrFlushInterval(const size_t interval) override;
+  void* allocPinnedHost(const size_t bytes) override;
+  void freePinnedHost(void* ptr) override;
 
   /* -------------------------- Rand Functions -------------------------- */
   void setSeed(const int seed) override;
@@ -73,6 +89,7 @@ class JitBackend : public TensorBackend {
 #undef FL_JIT_BACKEND_CREATE_FUN_LITERAL_DECL_STUB
 
   Tensor identity(const Dim dim, const dtype type) override;
+  Tensor fromDLPack(DLManagedTensor* dlTensor) override;
   Tensor arange(const Shape& shape, const Dim seqDim, const dtype type)
       override;
   Tensor iota(const Shape& dims, const Shape& tileDims, const dtype type)
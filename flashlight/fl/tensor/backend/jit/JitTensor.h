@@ -29,6 +29,7 @@ class JitTensor : public JitTensorBase {
     return wrappedBackend;
   }
 
+ public:
   Optimizer& optimizer() const override {
     static Optimizer optimizer(wrappedBackend());
     return optimizer;
@@ -39,7 +40,6 @@ class JitTensor : public JitTensorBase {
     return evaluator;
   }
 
- public:
   // 1 static instance per jitted T.
   // NOTE that it's safe even for multiple translation units:
   // https://stackoverflow.com/questions/19366615/static-member-variable-in-class-template
@@ -11,6 +11,8 @@
 #include <sstream>
 #include <stdexcept>
 
+#include "flashlight/fl/tensor/backend/jit/ir/ValueNode.h"
+
 #define FL_JIT_TENSOR_UNIMPLEMENTED \
   throw std::invalid_argument(      \
       "JitTensorBase::" + std::string(__func__) + " - unimplemented.");
@@ -200,6 +202,11 @@ bool JitTensorBase::isContiguous() {
   FL_JIT_TENSOR_UNIMPLEMENTED;
 }
 
+DLManagedTensor* JitTensorBase::toDLPack() {
+  // export the materialized result, which owns the memory
+  return getTensorOrEvalNode().toDLPack();
+}
+
 Shape JitTensorBase::strides() {
   FL_JIT_TENSOR_UNIMPLEMENTED;
 }
@@ -326,6 +333,15 @@ void JitTensorBase::eval() const {
   }
 }
 
+void JitTensorBase::materialize() const {
+  eval();
+  if (!node()->isValue()) {
+    // the result is immutable, no need for a deep copy
+    sharedData_->replaceNode(
+        ValueNode::create(node()->getResult().value().shallowCopy()));
+  }
+}
+
 const JitTensorBase& toJitTensorBase(const Tensor& tensor) {
   return toJitTensorBase(const_cast<Tensor&>(tensor));
 }
@@ -41,10 +41,6 @@ class JitTensorBase : public TensorAdapterBase {
   // let derived class manage the wrapped backend
   virtual TensorBackend& wrappedBackend() const = 0;
 
-  // allow JitTensor<T> to potentially inject things into Optimizer/Evaluator
-  virtual Optimizer& optimizer() const = 0;
-  virtual Evaluator& evaluator() const = 0;
-
   // JitTensorBase manages the backend-agnostic JIT node.
   JitTensorBase(Node* node);
   JitTensorBase(std::shared_ptr<SharedData> sharedData);
@@ -65,6 +61,7 @@ class JitTensorBase : public TensorAdapterBase {
   void unlock() override;
   bool isLocked() override;
   bool isContiguous() override;
+  DLManagedTensor* toDLPack() override;
   Shape strides() override;
   const Stream& stream() const override;
   Tensor astype(const dtype type) override;
@@ -77,6 +74,13 @@ class JitTensorBase : public TensorAdapterBase {
   std::string toString() override;
   std::ostream& operator<<(std::ostream& ostr) override;
 
+  /**
+   * The optimizer & evaluator used for this tensor, e.g., to inspect their
+   * stats. JitTensor<T> may inject things into them.
+   */
+  virtual Optimizer& optimizer() const = 0;
+  virtual Evaluator& evaluator() const = 0;
+
   /**
    * Return the node this JIT tensor represents.
    * NOTE `const` w.r.t. the underlying Tensor this represents.
@@ -89,6 +93,13 @@ class JitTensorBase : public TensorAdapterBase {
    */
   void eval() const;
 
+  /**
+   * Evaluate this tensor's JIT node and replace it with a node that only
+   * holds the result, so the tree it used to reference can be released.
+   * NOTE `const` w.r.t. the underlying Tensor this represents.
+   */
+  void materialize() const;
+
   /******************** Assignment Operators ********************/
 #define ASSIGN_OP_TYPE_STUB(OP, TYPE) void OP(const TYPE& val) override;
 
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/backend/jit/MaterializationPolicy.h"
+
+#include <unordered_set>
+#include <vector>
+
+#include "flashlight/fl/tensor/backend/jit/eval/EvalScheduler.h"
+
+namespace fl {
+
+bool MaterializationPolicy::shouldMaterialize(const Node* root) const {
+  if ((maxLeafBytes == 0 && maxNumNodes == 0) ||
+      root->getResult().has_value()) {
+    return false;
+  }
+  size_t leafBytes = 0;
+  unsigned numNodes = 0;
+  std::unordered_set<const Node*> visited{root};
+  std::vector<const Node*> worklist{root}; // lazy nodes to be visited
+  while (!worklist.empty()) {
+    const auto node = worklist.back();
+    worklist.pop_back();
+    numNodes++;
+    if (maxNumNodes != 0 && numNodes > maxNumNodes) {
+      return true;
+    }
+    for (const auto& input : node->inputs()) {
+      if (!visited.insert(input).second) {
+        continue;
+      }
+      if (input->getResult().has_value()) {
+        leafBytes += EvalScheduler::estimateResultBytes(input);
+        if (maxLeafBytes != 0 && leafBytes > maxLeafBytes) {
+          return true;
+        }
+      } else {
+        worklist.push_back(input);
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace fl
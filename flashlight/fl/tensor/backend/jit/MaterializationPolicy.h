@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "flashlight/fl/tensor/backend/jit/ir/Node.h"
+
+namespace fl {
+
+/**
+ * Decides when a lazily built JIT tree should be materialized (i.e., evaluated
+ * and replaced by its result) without an explicit request for its value.
+ *
+ * Without materialization, a long lazy chain keeps every leaf result alive
+ * until it's evaluated, and the optimizer cost grows with the chain as well.
+ *
+ * Only the lazy part of a tree (nodes without result) is inspected. Since
+ * every materialization cuts the tree, the inspection cost is bounded by the
+ * thresholds.
+ */
+struct MaterializationPolicy {
+  // bytes of leaf results kept alive by the lazy part of a tree; 0 is no limit
+  size_t maxLeafBytes{0};
+  // number of nodes in the lazy part of a tree; 0 is no limit
+  unsigned maxNumNodes{0};
+
+  /**
+   * @return true if the tree rooted at `root` crosses any threshold.
+   */
+  bool shouldMaterialize(const Node* root) const;
+};
+
+} // namespace fl
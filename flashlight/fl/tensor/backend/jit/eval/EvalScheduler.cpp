@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/backend/jit/eval/EvalScheduler.h"
+
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/IndexNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/MatmulNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ReductionNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
+
+namespace fl {
+
+namespace {
+
+dtype widerType(const dtype lhs, const dtype rhs) {
+  return getTypeSize(lhs) >= getTypeSize(rhs) ? lhs : rhs;
+}
+
+// Infers (an approximation of) the result type of nodes, since nodes don't
+// carry types until they are evaluated.
+class TypeEstimator {
+  std::unordered_map<const Node*, dtype> nodeToType_{};
+
+  dtype estimateUncached(const Node* node) {
+    const auto& result = node->getResult();
+    if (result.has_value()) {
+      return result->type();
+    }
+    switch (node->type()) {
+      case NodeType::Binary: {
+        const auto& binaryNode = node->impl<BinaryNode>();
+        return widerType(
+            estimate(binaryNode.lhs()), estimate(binaryNode.rhs()));
+      }
+      case NodeType::Custom: {
+        // opaque, assume the widest input type
+        dtype type = dtype::f32;
+        for (const auto& input : node->inputs()) {
+          type = widerType(type, estimate(input));
+        }
+        return type;
+      }
+      case NodeType::Index:
+        return estimate(node->impl<IndexNode>().indexedNode());
+      case NodeType::Matmul: {
+        const auto& matmulNode = node->impl<MatmulNode>();
+        return widerType(
+            estimate(matmulNode.lhs()), estimate(matmulNode.rhs()));
+      }
+      case NodeType::Reduction:
+        return estimate(node->impl<ReductionNode>().input());
+      case NodeType::Scalar:
+        return node->impl<ScalarNode>().dataType();
+      case NodeType::Unary: {
+        const auto& unaryNode = node->impl<UnaryNode>();
+        switch (unaryNode.op()) {
+          case UnaryOp::LogicalNot:
+          case UnaryOp::IsNan:
+          case UnaryOp::IsInf:
+            return dtype::b8;
+          default:
+            return estimate(unaryNode.input());
+        }
+      }
+      case NodeType::Value:
+        break; // always has a result
+    }
+    throw std::runtime_error("[TypeEstimator::estimate] Unknown node type");
+  }
+
+ public:
+  dtype estimate(const Node* node) {
+    const auto iter = nodeToType_.find(node);
+    if (iter != nodeToType_.end()) {
+      return iter->second;
+    }
+    const auto type = estimateUncached(node);
+    nodeToType_.emplace(node, type);
+    return type;
+  }
+
+  size_t estimateBytes(const Node* node) {
+    return node->shape().elements() * getTypeSize(estimate(node));
+  }
+};
+
+class Planner {
+  const EvalScheduler::Order order_;
+  TypeEstimator typeEstimator_{};
+  // peak bytes needed to evaluate the subtree rooted at a node, treating the
+  // subtree as a tree (i.e., shared nodes are double counted)
+  std::unordered_map<const Node*, size_t> nodeToNeededBytes_{};
+  std::unordered_set<const Node*> scheduled_{};
+  std::vector<Node*> nodes_{};
+
+  // distinct inputs that must be evaluated, in the order we evaluate them
+  std::vector<Node*> getOrderedInputs(const Node* node) {
+    std::vector<Node*> inputs;
+    for (const auto& input : node->inputs()) {
+      if (!input->getResult().has_value() &&
+          std::find(inputs.begin(), inputs.end(), input) == inputs.end()) {
+        inputs.push_back(input);
+      }
+    }
+    if (order_ == EvalScheduler::Order::MinPeakMemory) {
+      // Sethi-Ullman: evaluating `a` first costs max(need(a), bytes(a) +
+      // need(b)), so we go first with the input whose need exceeds the bytes
+      // it retains by the most.
+      std::stable_sort(inputs.begin(), inputs.end(), [this](Node* a, Node* b) {
+        return getNeededBytes(a) + typeEstimator_.estimateBytes(b) >
+            getNeededBytes(b) + typeEstimator_.estimateBytes(a);
+      });
+    }
+    return inputs;
+  }
+
+  size_t getNeededBytes(const Node* node) {
+    if (node->getResult().has_value()) {
+      return 0;
+    }
+    const auto iter = nodeToNeededBytes_.find(node);
+    if (iter != nodeToNeededBytes_.end()) {
+      return iter->second;
+    }
+    size_t neededBytes = 0;
+    size_t retainedBytes = 0; // results of inputs evaluated so far
+    for (const auto& input : getOrderedInputs(node)) {
+      neededBytes =
+          std::max(neededBytes, retainedBytes + getNeededBytes(input));
+      retainedBytes += typeEstimator_.estimateBytes(input);
+    }
+    neededBytes = std::max(
+        neededBytes, retainedBytes + typeEstimator_.estimateBytes(node));
+    nodeToNeededBytes_.emplace(node, neededBytes);
+    return neededBytes;
+  }
+
+  void schedule(Node* node) {
+    if (node->getResult().has_value() || !scheduled_.insert(node).second) {
+      return;
+    }
+    for (const auto& input : getOrderedInputs(node)) {
+      schedule(input);
+    }
+    nodes_.push_back(node);
+  }
+
+  // mirror how Evaluator frees intermediate results after their last use
+  size_t simulatePeakBytes(Node* root) {
+    auto nodeToResultUseCount = EvalScheduler::getNodeToRefCountInTree(root);
+    size_t liveBytes = 0;
+    size_t peakBytes = 0;
+    for (const auto& node : nodes_) {
+      liveBytes += typeEstimator_.estimateBytes(node);
+      peakBytes = std::max(peakBytes, liveBytes);
+      for (const auto& input : node->inputs()) {
+        auto& count = nodeToResultUseCount.at(input);
+        count--;
+        if (count == 0 && scheduled_.count(input)) {
+          liveBytes -= typeEstimator_.estimateBytes(input);
+        }
+      }
+    }
+    return peakBytes;
+  }
+
+ public:
+  explicit Planner(EvalScheduler::Order order) : order_(order) {}
+
+  EvalScheduler::Schedule plan(Node* root) {
+    schedule(root);
+    const auto peakBytes = simulatePeakBytes(root);
+    return {std::move(nodes_), peakBytes};
+  }
+};
+
+} // namespace
+
+std::unordered_map<Node*, unsigned> EvalScheduler::getNodeToRefCountInTree(
+    Node* root) {
+  std::unordered_map<Node*, unsigned> nodeToRefCount;
+  std::queue<Node*> worklist({root}); // nodes to be visited
+  while (!worklist.empty()) {
+    Node* node = worklist.front();
+    worklist.pop();
+    if (nodeToRefCount.find(node) == nodeToRefCount.end()) {
+      nodeToRefCount.emplace(node, node->getRefCount());
+      for (const auto& input : node->inputs()) {
+        worklist.push(input);
+      }
+    }
+  }
+  return nodeToRefCount;
+}
+
+size_t EvalScheduler::estimateResultBytes(const Node* node) {
+  return TypeEstimator().estimateBytes(node);
+}
+
+EvalScheduler::Schedule EvalScheduler::plan(Node* root, Order order) {
+  return Planner(order).plan(root);
+}
+
+} // namespace fl
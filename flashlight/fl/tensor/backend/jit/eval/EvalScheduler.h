@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "flashlight/fl/tensor/backend/jit/ir/Node.h"
+
+namespace fl {
+
+/**
+ * Plans the order in which nodes of a JIT tree get evaluated.
+ *
+ * Since intermediate results are freed after their last use, the order in
+ * which independent subtrees are evaluated determines how many intermediate
+ * results are alive at once, i.e., the peak memory usage of evaluation.
+ */
+class EvalScheduler {
+ public:
+  enum class Order {
+    // evaluate inputs of each node from first to last
+    InputOrder,
+    // evaluate inputs of each node in the order (Sethi-Ullman style) that
+    // minimizes peak bytes of live intermediate results
+    MinPeakMemory,
+  };
+
+  struct Schedule {
+    // nodes to be evaluated, each one is after all of its inputs
+    std::vector<Node*> nodes;
+    // peak bytes of intermediate results alive at once, while evaluating
+    // `nodes` in order (excluding results that existed before evaluation)
+    size_t peakBytes{0};
+  };
+
+  /**
+   * Map each node in the tree rooted at `root` to its current refcount, i.e.,
+   * (conservatively) how many times its result will be used.
+   */
+  static std::unordered_map<Node*, unsigned> getNodeToRefCountInTree(
+      Node* root);
+
+  /**
+   * Estimate the number of bytes taken by result of `node`.
+   */
+  static size_t estimateResultBytes(const Node* node);
+
+  /**
+   * Plan the evaluation of all nodes without result in the tree rooted at
+   * `root`.
+   *
+   * @param[in] root the root node of the JIT tree to be evaluated.
+   * @param[in] order the policy for ordering inputs of each node.
+   * @return the planned schedule; empty if `root` already has a result.
+   */
+  static Schedule plan(Node* root, Order order);
+};
+
+} // namespace fl
@@ -7,35 +7,22 @@
 
 #include "flashlight/fl/tensor/backend/jit/eval/Evaluator.h"
 
-#include <queue>
+#include <condition_variable>
+#include <exception>
+#include <set>
+#include <unordered_set>
+
+#include "flashlight/fl/common/Timer.h"
+#include "flashlight/fl/runtime/Stream.h"
+#include "flashlight/fl/tensor/Profile.h"
 
 #include "flashlight/fl/tensor/backend/jit/JitTensorBase.h"
 #include "flashlight/fl/tensor/backend/jit/ir/ValueNode.h"
 
 namespace fl {
 
-namespace {
-
-// Build a map from each node in the tree to its current refcount.
-std::unordered_map<Node*, unsigned> getNodeToRefCountInTree(Node* root) {
-  std::unordered_map<Node*, unsigned> nodeToRefCount;
-  std::queue<Node*> worklist({root}); // nodes to be visited
-  while (!worklist.empty()) {
-    Node* node = worklist.front();
-    worklist.pop();
-    if (nodeToRefCount.find(node) == nodeToRefCount.end()) {
-      nodeToRefCount.emplace(node, node->getRefCount());
-      for (const auto& input : node->inputs()) {
-        worklist.push(input);
-      }
-    }
-  }
-  return nodeToRefCount;
-}
-
-} // namespace
-
-Evaluator::Evaluator(TensorBackend& backend) : backend_(backend) {}
+Evaluator::Evaluator(TensorBackend& backend, EvalScheduler::Order order)
+    : backend_(backend), order_(order) {}
 
 void Evaluator::evalBinaryNode(BinaryNode& node) {
   const auto& lhs = node.lhs()->getResult().value();
@@ -44,6 +31,7 @@ void Evaluator::evalBinaryNode(BinaryNode& node) {
 }
 
 void Evaluator::evalCustomNode(CustomNode& node) {
+  FL_PROFILE_TRACE(node.name());
   std::vector<const Tensor*> inputTensors;
   for (auto& inputNode : node.inputs()) {
     inputTensors.push_back(&inputNode->getResult().value());
@@ -64,10 +52,27 @@ void Evaluator::evalIndexNode(IndexNode& node) {
   node.setResult(node.indexedNode()->getResult().value()(indices));
 }
 
+void Evaluator::evalMatmulNode(MatmulNode& node) {
+  const auto& lhs = node.lhs()->getResult().value();
+  const auto& rhs = node.rhs()->getResult().value();
+  node.setResult(backend_.matmul(lhs, rhs, node.lhsProp(), node.rhsProp()));
+}
+
+void Evaluator::evalReductionNode(ReductionNode& node) {
+  const auto& input = node.input()->getResult().value();
+  node.setResult(
+      evalReductionOp(node.op(), input, node.axes(), node.keepDims()));
+}
+
 void Evaluator::evalScalarNode(ScalarNode& node) {
   node.setResult(evalScalar(node));
 }
 
+void Evaluator::evalUnaryNode(UnaryNode& node) {
+  const auto& input = node.input()->getResult().value();
+  node.setResult(evalUnaryOp(node.op(), input));
+}
+
 Tensor
 Evaluator::evalBinaryOp(BinaryOp op, const Tensor& lhs, const Tensor& rhs) {
   switch (op) {
@@ -84,11 +89,31 @@ Evaluator::evalBinaryOp(BinaryOp op, const Tensor& lhs, const Tensor& rhs) {
       "[Evaluator::evalBinaryOp] Unknown binary operation type");
 }
 
+Tensor Evaluator::evalReductionOp(
+    ReductionOp op,
+    const Tensor& input,
+    const std::vector<int>& axes,
+    bool keepDims) {
+  switch (op) {
+    case ReductionOp::Min:
+      return backend_.amin(input, axes, keepDims);
+    case ReductionOp::Max:
+      return backend_.amax(input, axes, keepDims);
+    case ReductionOp::Sum:
+      return backend_.sum(input, axes, keepDims);
+    case ReductionOp::Mean:
+      return backend_.mean(input, axes, keepDims);
+  }
+  throw std::runtime_error(
+      "[Evaluator::evalReductionOp] Unknown reduction operation type");
+}
+
 Tensor Evaluator::evalScalar(ScalarNode& node) {
   const Shape& shape = node.shape();
   const auto dtype = node.dataType();
   switch (dtype) {
     case dtype::f16:
+    case dtype::bf16:
     case dtype::f32:
     case dtype::f64:
       return backend_.full(shape, node.scalar<double>(), dtype);
@@ -106,6 +131,49 @@ Tensor Evaluator::evalScalar(ScalarNode& node) {
   throw std::runtime_error("Unknown dtype");
 }
 
+Tensor Evaluator::evalUnaryOp(UnaryOp op, const Tensor& input) {
+  switch (op) {
+    case UnaryOp::Exp:
+      return backend_.exp(input);
+    case UnaryOp::Log:
+      return backend_.log(input);
+    case UnaryOp::Negative:
+      return backend_.negative(input);
+    case UnaryOp::LogicalNot:
+      return backend_.logicalNot(input);
+    case UnaryOp::Log1p:
+      return backend_.log1p(input);
+    case UnaryOp::Sin:
+      return backend_.sin(input);
+    case UnaryOp::Cos:
+      return backend_.cos(input);
+    case UnaryOp::Sqrt:
+      return backend_.sqrt(input);
+    case UnaryOp::Tanh:
+      return backend_.tanh(input);
+    case UnaryOp::Floor:
+      return backend_.floor(input);
+    case UnaryOp::Ceil:
+      return backend_.ceil(input);
+    case UnaryOp::Rint:
+      return backend_.rint(input);
+    case UnaryOp::Absolute:
+      return backend_.absolute(input);
+    case UnaryOp::Sigmoid:
+      return backend_.sigmoid(input);
+    case UnaryOp::Erf:
+      return backend_.erf(input);
+    case UnaryOp::IsNan:
+      return backend_.isnan(input);
+    case UnaryOp::IsInf:
+      return backend_.isinf(input);
+    case UnaryOp::Sign:
+      return backend_.sign(input);
+  }
+  throw std::runtime_error(
+      "[Evaluator::evalUnaryOp] Unknown unary operation type");
+}
+
 void Evaluator::evalNodeDispatch(Node* node) {
   switch (node->type()) {
     case NodeType::Binary:
@@ -114,37 +182,203 @@ void Evaluator::evalNodeDispatch(Node* node) {
       return evalCustomNode(node->impl<CustomNode>());
     case NodeType::Index:
       return evalIndexNode(node->impl<IndexNode>());
+    case NodeType::Matmul:
+      return evalMatmulNode(node->impl<MatmulNode>());
+    case NodeType::Reduction:
+      return evalReductionNode(node->impl<ReductionNode>());
     case NodeType::Scalar:
       return evalScalarNode(node->impl<ScalarNode>());
+    case NodeType::Unary:
+      return evalUnaryNode(node->impl<UnaryNode>());
     case NodeType::Value:
       return; // already has a result
   }
   throw std::runtime_error("[Evaluator::evalNodeDispatch] Unknown node type");
 }
 
+void Evaluator::evalNodeAndRecordStats(Node* node) {
+  if (!collectStats_) {
+    return evalNodeDispatch(node);
+  }
+  const auto timer = Timer::start();
+  evalNodeDispatch(node);
+  const auto& result = node->getResult().value();
+  if (node->isCustom()) {
+    result.stream().sync();
+  }
+  const auto seconds = Timer::stop(timer);
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  stats_.numEvaluatedNodes++;
+  stats_.numMaterializedBytes += result.bytes();
+  if (node->isCustom()) {
+    auto& customNodeStats =
+        stats_.customNodeStats[node->impl<CustomNode>().name()];
+    customNodeStats.numEvals++;
+    customNodeStats.seconds += seconds;
+  }
+}
+
 void Evaluator::evalNode(Node* node) {
-  if (!node->getResult().has_value()) {
-    for (const auto& input : node->inputs()) {
-      evalNode(input);
-    }
-    evalNodeDispatch(node);
-    for (const auto& input : node->inputs()) {
-      auto& count = nodeToResultUseCount_.at(input);
-      count--;
-      if (count == 0 && !input->isValue()) {
-        // This helps reduce memory footprint during evaluation, allowing the
-        // result tensor memory to be reused. This has a non-trivial performance
-        // impact on graph with high intermediate tensor memory usage.
-        input->unsetResult();
-      }
+  evalNodeAndRecordStats(node);
+  releaseInputResults(node);
+}
+
+void Evaluator::releaseInputResults(Node* node) {
+  for (const auto& input : node->inputs()) {
+    auto& count = nodeToResultUseCount_.at(input);
+    count--;
+    if (count == 0 && !input->isValue()) {
+      // This helps reduce memory footprint during evaluation, allowing the
+      // result tensor memory to be reused. This has a non-trivial performance
+      // impact on graph with high intermediate tensor memory usage.
+      input->unsetResult();
     }
   }
 }
 
 void Evaluator::eval(Node* node) {
-  nodeToResultUseCount_ = getNodeToRefCountInTree(node);
-  evalNode(node);
+  FL_PROFILE_TRACE("JitEvaluator::eval");
+  const auto schedule = EvalScheduler::plan(node, order_);
+  nodeToResultUseCount_ = EvalScheduler::getNodeToRefCountInTree(node);
+  if (numThreads_ > 1 && schedule.nodes.size() > 1) {
+    evalNodesInParallel(schedule.nodes);
+  } else {
+    for (const auto& scheduledNode : schedule.nodes) {
+      evalNode(scheduledNode);
+    }
+  }
   nodeToResultUseCount_.clear();
 }
 
+void Evaluator::evalNodesInParallel(const std::vector<Node*>& nodes) {
+  // node -> its order in `nodes`, which is also used as scheduling priority
+  std::unordered_map<const Node*, unsigned> nodeToIdx;
+  for (unsigned i = 0; i < nodes.size(); i++) {
+    nodeToIdx.emplace(nodes[i], i);
+  }
+  // dependencies among `nodes`, other inputs already have results
+  std::vector<unsigned> numPendingInputs(nodes.size(), 0);
+  std::vector<std::vector<unsigned>> idxToUserIdxs(nodes.size());
+  for (unsigned i = 0; i < nodes.size(); i++) {
+    std::unordered_set<const Node*> distinctInputs;
+    for (const auto& input : nodes[i]->inputs()) {
+      const auto iter = nodeToIdx.find(input);
+      if (iter != nodeToIdx.end() && distinctInputs.insert(input).second) {
+        numPendingInputs[i]++;
+        idxToUserIdxs[iter->second].push_back(i);
+      }
+    }
+  }
+
+  if (!threadPool_) {
+    threadPool_ = std::make_unique<ThreadPool>(numThreads_);
+  }
+  std::condition_variable cv;
+  std::set<unsigned> readyIdxs; // ordered by priority
+  for (unsigned i = 0; i < nodes.size(); i++) {
+    if (numPendingInputs[i] == 0) {
+      readyIdxs.insert(i);
+    }
+  }
+  unsigned numDone = 0;
+  unsigned numInFlight = 0;
+  std::exception_ptr error = nullptr;
+
+  const auto evalTask = [&](const unsigned idx) {
+    Node* node = nodes[idx];
+    std::exception_ptr taskError = nullptr;
+    try {
+      evalNodeAndRecordStats(node);
+      // inputs may come from other streams, let users of `node` wait on them
+      const auto& stream = node->getResult().value().stream();
+      std::unordered_set<const Stream*> inputStreams;
+      for (const auto& input : node->inputs()) {
+        const auto& inputStream = input->getResult().value().stream();
+        // NOTE streams of different types can't be synchronized relatively
+        if (&inputStream != &stream && inputStream.type() == stream.type()) {
+          inputStreams.insert(&inputStream);
+        }
+      }
+      if (!inputStreams.empty()) {
+        stream.relativeSync(inputStreams);
+      }
+    } catch (...) {
+      taskError = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(resultUseCountMutex_);
+    numInFlight--;
+    if (taskError) {
+      error = error ? error : taskError;
+    } else {
+      releaseInputResults(node);
+      for (const auto userIdx : idxToUserIdxs[idx]) {
+        if (--numPendingInputs[userIdx] == 0) {
+          readyIdxs.insert(userIdx);
+        }
+      }
+      numDone++;
+    }
+    cv.notify_one();
+  };
+
+  std::unique_lock<std::mutex> lock(resultUseCountMutex_);
+  while (error ? numInFlight > 0 : numDone < nodes.size()) {
+    if (!error) {
+      for (const auto idx : readyIdxs) {
+        numInFlight++;
+        threadPool_->enqueue(evalTask, idx);
+      }
+      readyIdxs.clear();
+    }
+    cv.wait(lock);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void Evaluator::setEvalOrder(EvalScheduler::Order order) {
+  order_ = order;
+}
+
+EvalScheduler::Order Evaluator::evalOrder() const {
+  return order_;
+}
+
+size_t Evaluator::getPlannedPeakBytes(Node* node) const {
+  return EvalScheduler::plan(node, order_).peakBytes;
+}
+
+void Evaluator::setNumThreads(unsigned numThreads) {
+  if (numThreads == 0) {
+    throw std::invalid_argument(
+        "[Evaluator::setNumThreads] Number of threads must be positive");
+  }
+  if (numThreads != numThreads_) {
+    threadPool_.reset();
+  }
+  numThreads_ = numThreads;
+}
+
+unsigned Evaluator::numThreads() const {
+  return numThreads_;
+}
+
+void Evaluator::setCollectStats(bool collectStats) {
+  collectStats_ = collectStats;
+}
+
+bool Evaluator::collectStats() const {
+  return collectStats_;
+}
+
+const Evaluator::Stats& Evaluator::stats() const {
+  return stats_;
+}
+
+void Evaluator::resetStats() {
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  stats_ = Stats();
+}
+
 } // namespace fl
@@ -7,14 +7,22 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 
+#include "flashlight/fl/common/threadpool/ThreadPool.h"
 #include "flashlight/fl/tensor/TensorBackend.h"
 #include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/backend/jit/eval/EvalScheduler.h"
 #include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/CustomNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/IndexNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/MatmulNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ReductionNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
 
 namespace fl {
 
@@ -23,12 +31,49 @@ namespace fl {
  * out the computation represented by the JIT tree.
  */
 class Evaluator {
+ public:
+  struct CustomNodeStats {
+    unsigned numEvals{0};
+    double seconds{0};
+  };
+
+  /**
+   * What the evaluator did since stats collection was enabled (or reset).
+   */
+  struct Stats {
+    unsigned numEvaluatedNodes{0};
+    // bytes of the results produced by evaluated nodes
+    size_t numMaterializedBytes{0};
+    // keyed by `CustomNode::name()`, e.g., fused kernels
+    std::unordered_map<std::string, CustomNodeStats> customNodeStats;
+  };
+
+ private:
   // backend used for dispatching Tensor ops.
   TensorBackend& backend_;
+  // policy for picking the evaluation order of nodes
+  EvalScheduler::Order order_;
   // track (conservatively) how many more times the a node's result will be used
   std::unordered_map<Node*, unsigned> nodeToResultUseCount_{};
+  // guards `nodeToResultUseCount_` and input results during parallel eval
+  std::mutex resultUseCountMutex_;
+  // number of threads for evaluating independent nodes concurrently
+  unsigned numThreads_{1};
+  // lazily created for parallel evaluation
+  std::unique_ptr<ThreadPool> threadPool_{nullptr};
+  bool collectStats_{false};
+  Stats stats_{};
+  std::mutex statsMutex_;
 
+  // evaluate, set result and release results of inputs after their last use
+  // ASSUME inputs have been evaluated
   void evalNode(Node* node);
+  // evaluate independent nodes of `nodes` concurrently, starting with the
+  // earliest ready node in `nodes`
+  void evalNodesInParallel(const std::vector<Node*>& nodes);
+  void releaseInputResults(Node* node);
+  // dispatch, and record stats if enabled
+  void evalNodeAndRecordStats(Node* node);
   void evalNodeDispatch(Node* node);
 
   // evaluate and set result without checking for existing result
@@ -36,17 +81,28 @@ class Evaluator {
   void evalBinaryNode(BinaryNode& node);
   void evalCustomNode(CustomNode& node);
   void evalIndexNode(IndexNode& node);
+  void evalMatmulNode(MatmulNode& node);
+  void evalReductionNode(ReductionNode& node);
   void evalScalarNode(ScalarNode& node);
+  void evalUnaryNode(UnaryNode& node);
 
   // helpers that evaluates without setting results
   Tensor evalBinaryOp(BinaryOp op, const Tensor& lhs, const Tensor& rhs);
+  Tensor evalReductionOp(
+      ReductionOp op,
+      const Tensor& input,
+      const std::vector<int>& axes,
+      bool keepDims);
   Tensor evalScalar(ScalarNode& node);
+  Tensor evalUnaryOp(UnaryOp op, const Tensor& input);
 
  public:
   /**
    * Creates a JIT graph Evaluator that dispatches to the given backend.
    */
-  explicit Evaluator(TensorBackend& backend);
+  explicit Evaluator(
+      TensorBackend& backend,
+      EvalScheduler::Order order = EvalScheduler::Order::InputOrder);
 
   // no copy/move
   Evaluator(const Evaluator&) = delete;
@@ -60,6 +116,40 @@ class Evaluator {
    * 2. set result for all intermediate/final tensors evaluated
    */
   void eval(Node* node);
+
+  /**
+   * Set the policy for ordering evaluation of nodes, e.g., `MinPeakMemory`
+   * trades some planning time for lower peak memory usage on wide trees.
+   */
+  void setEvalOrder(EvalScheduler::Order order);
+  EvalScheduler::Order evalOrder() const;
+
+  /**
+   * @return the peak bytes of intermediate results that would be alive at
+   * once, if the tree rooted at `node` were evaluated under the current order.
+   */
+  size_t getPlannedPeakBytes(Node* node) const;
+
+  /**
+   * Set the number of threads used to evaluate independent nodes (e.g., wide
+   * branches of a tree) concurrently; 1 (default) evaluates sequentially.
+   * Results of inputs from other streams are joined via `relativeSync`.
+   *
+   * NOTE the wrapped backend must support concurrent op dispatch.
+   */
+  void setNumThreads(unsigned numThreads);
+  unsigned numThreads() const;
+
+  /**
+   * Enable/disable collecting `stats()`; disabled by default.
+   *
+   * NOTE to time custom nodes, their results' streams are synchronized while
+   * collecting stats.
+   */
+  void setCollectStats(bool collectStats);
+  bool collectStats() const;
+  const Stats& stats() const;
+  void resetStats();
 };
 
 } // namespace fl
@@ -27,7 +27,7 @@ std::optional<Shape> getBinopOutputShape(const Shape& lhs, const Shape& rhs) {
   }
   // check and accumulate output dimensions
   auto ndim = lhs.ndim();
-  std::vector<Dim> dstDims;
+  Shape::Dims dstDims;
   for (auto i = 0; i < ndim; ++i) {
     auto lhsDim = lhs.dim(i);
     auto rhsDim = rhs.dim(i);
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/backend/jit/ir/GraphPrinter.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/CustomNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/MatmulNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ReductionNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
+
+namespace fl {
+
+namespace {
+
+std::string binopToString(const BinaryOp op) {
+  switch (op) {
+    case BinaryOp::Add:
+      return "Add";
+    case BinaryOp::Sub:
+      return "Sub";
+    case BinaryOp::Mul:
+      return "Mul";
+    case BinaryOp::Div:
+      return "Div";
+  }
+  throw std::runtime_error("[binopToString] Unknown binary operation type");
+}
+
+std::string unaryOpToString(const UnaryOp op) {
+  switch (op) {
+    case UnaryOp::Exp:
+      return "Exp";
+    case UnaryOp::Log:
+      return "Log";
+    case UnaryOp::Negative:
+      return "Negative";
+    case UnaryOp::LogicalNot:
+      return "LogicalNot";
+    case UnaryOp::Log1p:
+      return "Log1p";
+    case UnaryOp::Sin:
+      return "Sin";
+    case UnaryOp::Cos:
+      return "Cos";
+    case UnaryOp::Sqrt:
+      return "Sqrt";
+    case UnaryOp::Tanh:
+      return "Tanh";
+    case UnaryOp::Floor:
+      return "Floor";
+    case UnaryOp::Ceil:
+      return "Ceil";
+    case UnaryOp::Rint:
+      return "Rint";
+    case UnaryOp::Absolute:
+      return "Absolute";
+    case UnaryOp::Sigmoid:
+      return "Sigmoid";
+    case UnaryOp::Erf:
+      return "Erf";
+    case UnaryOp::IsNan:
+      return "IsNan";
+    case UnaryOp::IsInf:
+      return "IsInf";
+    case UnaryOp::Sign:
+      return "Sign";
+  }
+  throw std::runtime_error("[unaryOpToString] Unknown unary operation type");
+}
+
+std::string reductionOpToString(const ReductionOp op) {
+  switch (op) {
+    case ReductionOp::Min:
+      return "Min";
+    case ReductionOp::Max:
+      return "Max";
+    case ReductionOp::Sum:
+      return "Sum";
+    case ReductionOp::Mean:
+      return "Mean";
+  }
+  throw std::runtime_error(
+      "[reductionOpToString] Unknown reduction operation type");
+}
+
+std::string matrixPropertyToString(const MatrixProperty prop) {
+  return prop == MatrixProperty::Transpose ? "T" : "N";
+}
+
+std::string escape(const std::string& str) {
+  std::string escaped;
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      escaped.push_back('\\');
+    }
+    escaped.push_back(c);
+  }
+  return escaped;
+}
+
+// distinct nodes of the tree in post order, i.e., inputs before users
+class NodeNumbering {
+  std::vector<const Node*> nodes_{};
+  std::unordered_map<const Node*, unsigned> nodeToId_{};
+
+  void visit(const Node* node) {
+    if (nodeToId_.count(node)) {
+      return;
+    }
+    nodeToId_.emplace(node, 0); // placeholder to avoid re-visit
+    for (const auto& input : node->inputs()) {
+      visit(input);
+    }
+    nodeToId_[node] = nodes_.size();
+    nodes_.push_back(node);
+  }
+
+ public:
+  explicit NodeNumbering(const Node* root) {
+    visit(root);
+  }
+
+  const std::vector<const Node*>& nodes() const {
+    return nodes_;
+  }
+
+  unsigned id(const Node* node) const {
+    return nodeToId_.at(node);
+  }
+};
+
+} // namespace
+
+std::string getNodeLabel(const Node* node) {
+  std::ostringstream oss;
+  oss << node->type();
+  switch (node->type()) {
+    case NodeType::Binary:
+      oss << " " << binopToString(node->impl<BinaryNode>().op());
+      break;
+    case NodeType::Custom:
+      oss << " " << node->impl<CustomNode>().name();
+      break;
+    case NodeType::Matmul: {
+      const auto& matmulNode = node->impl<MatmulNode>();
+      oss << " " << matrixPropertyToString(matmulNode.lhsProp())
+          << matrixPropertyToString(matmulNode.rhsProp());
+      break;
+    }
+    case NodeType::Reduction:
+      oss << " " << reductionOpToString(node->impl<ReductionNode>().op());
+      break;
+    case NodeType::Scalar: {
+      const auto& scalarNode = node->impl<ScalarNode>();
+      oss << " " << scalarNode.scalar<double>() << " "
+          << scalarNode.dataType();
+      break;
+    }
+    case NodeType::Unary:
+      oss << " " << unaryOpToString(node->impl<UnaryNode>().op());
+      break;
+    case NodeType::Index:
+    case NodeType::Value:
+      break;
+  }
+  oss << " " << node->shape();
+  return oss.str();
+}
+
+void printGraphviz(const Node* root, std::ostream& os) {
+  const NodeNumbering numbering(root);
+  os << "digraph JitTree {\n";
+  for (const auto& node : numbering.nodes()) {
+    const auto id = numbering.id(node);
+    os << "  n" << id << " [label=\"" << escape(getNodeLabel(node)) << "\"";
+    if (node->getResult().has_value()) {
+      os << ", style=filled";
+    }
+    os << "];\n";
+    for (const auto& input : node->inputs()) {
+      os << "  n" << numbering.id(input) << " -> n" << id << ";\n";
+    }
+  }
+  os << "}\n";
+}
+
+void printJson(const Node* root, std::ostream& os) {
+  const NodeNumbering numbering(root);
+  os << "{\"root\": " << numbering.id(root) << ", \"nodes\": [";
+  const auto& nodes = numbering.nodes();
+  for (unsigned i = 0; i < nodes.size(); i++) {
+    const auto& node = nodes[i];
+    os << (i == 0 ? "" : ", ") << "{\"id\": " << numbering.id(node)
+       << ", \"type\": \"" << node->type() << "\", \"label\": \""
+       << escape(getNodeLabel(node)) << "\", \"shape\": [";
+    const auto& dims = node->shape().get();
+    for (unsigned j = 0; j < dims.size(); j++) {
+      os << (j == 0 ? "" : ", ") << dims[j];
+    }
+    os << "], \"evaluated\": "
+       << (node->getResult().has_value() ? "true" : "false")
+       << ", \"inputs\": [";
+    const auto& inputs = node->inputs();
+    for (unsigned j = 0; j < inputs.size(); j++) {
+      os << (j == 0 ? "" : ", ") << numbering.id(inputs[j]);
+    }
+    os << "]}";
+  }
+  os << "]}\n";
+}
+
+} // namespace fl
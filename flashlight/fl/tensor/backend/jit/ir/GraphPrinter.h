@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include "flashlight/fl/tensor/backend/jit/ir/Node.h"
+
+namespace fl {
+
+/**
+ * @return a short description of `node`, e.g., `Binary Add (2, 3)`.
+ */
+std::string getNodeLabel(const Node* node);
+
+/**
+ * Write the JIT tree rooted at `root` in Graphviz DOT format, e.g., to be
+ * rendered via `dot -Tsvg`. Shared nodes are written once, and edges go from
+ * inputs to users. Nodes that already have a result are drawn shaded.
+ */
+void printGraphviz(const Node* root, std::ostream& os);
+
+/**
+ * Write the JIT tree rooted at `root` as JSON:
+ *
+ *   {"root": 0, "nodes": [{"id": 0, "type": "Binary", "label": "...",
+ *    "shape": [2, 3], "evaluated": false, "inputs": [1, 2]}, ...]}
+ *
+ * Node ids are only meaningful within a single dump.
+ */
+void printJson(const Node* root, std::ostream& os);
+
+} // namespace fl
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/backend/jit/ir/MatmulNode.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace fl {
+
+namespace {
+
+// Same shape semantics as `fl::matmul`:
+// 1. vectors are treated as (1 x K) for lhs and (K x 1) for rhs, and the
+//    output is flattened.
+// 2. dimensions beyond the first 2 are batch dimensions and must match, or
+//    be 1 (or missing) on one side, to be broadcast to the other.
+Shape getOutputShape(
+    const Shape& lhsShape,
+    const Shape& rhsShape,
+    MatrixProperty lhsProp,
+    MatrixProperty rhsProp) {
+  std::vector<Dim> lhsDims = lhsShape.get();
+  std::vector<Dim> rhsDims = rhsShape.get();
+  const bool isLhsScalarOrVector = lhsDims.size() <= 1;
+  const bool isRhsScalarOrVector = rhsDims.size() <= 1;
+  if (isLhsScalarOrVector) {
+    lhsDims.insert(lhsDims.end(), 2 - lhsDims.size(), 1);
+    std::reverse(lhsDims.begin(), lhsDims.end());
+  } else if (lhsProp == MatrixProperty::Transpose) {
+    std::swap(lhsDims[0], lhsDims[1]);
+  }
+  if (isRhsScalarOrVector) {
+    rhsDims.insert(rhsDims.end(), 2 - rhsDims.size(), 1);
+  } else if (rhsProp == MatrixProperty::Transpose) {
+    std::swap(rhsDims[0], rhsDims[1]);
+  }
+  const auto ndim = std::max(lhsDims.size(), rhsDims.size());
+  lhsDims.resize(ndim, 1);
+  rhsDims.resize(ndim, 1);
+  std::vector<Dim> dstDims = lhsDims;
+  dstDims[1] = rhsDims[1];
+  bool isValid = lhsDims[1] == rhsDims[0];
+  for (unsigned i = 2; i < ndim; ++i) {
+    isValid &= lhsDims[i] == rhsDims[i] || lhsDims[i] == 1 || rhsDims[i] == 1;
+    dstDims[i] = std::max(lhsDims[i], rhsDims[i]);
+  }
+  if (!isValid) {
+    std::ostringstream oss;
+    oss << "[MatmulNode::create] Invalid shapes: " << lhsShape << " and "
+        << rhsShape;
+    throw std::invalid_argument(oss.str());
+  }
+  Shape dstShape(dstDims);
+  if (isLhsScalarOrVector || isRhsScalarOrVector) {
+    return Shape({dstShape.elements()});
+  }
+  return dstShape;
+}
+
+} // namespace
+
+MatmulNode::MatmulNode(
+    Node* lhs,
+    Node* rhs,
+    MatrixProperty lhsProp,
+    MatrixProperty rhsProp,
+    const Shape& shape)
+    : NodeTrait({lhs, rhs}, shape), lhsProp_(lhsProp), rhsProp_(rhsProp) {}
+
+MatmulNode* MatmulNode::create(
+    Node* lhs,
+    Node* rhs,
+    MatrixProperty lhsProp,
+    MatrixProperty rhsProp) {
+  const auto shape =
+      getOutputShape(lhs->shape(), rhs->shape(), lhsProp, rhsProp);
+  return new MatmulNode(lhs, rhs, lhsProp, rhsProp, shape);
+}
+
+Node* MatmulNode::lhs() const {
+  return getInput(kLhsIdx);
+}
+
+Node* MatmulNode::rhs() const {
+  return getInput(kRhsIdx);
+}
+
+MatrixProperty MatmulNode::lhsProp() const {
+  return lhsProp_;
+}
+
+MatrixProperty MatmulNode::rhsProp() const {
+  return rhsProp_;
+}
+
+} // namespace fl
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/backend/jit/ir/Node.h"
+
+namespace fl {
+
+/**
+ * A node that represents matrix multiplication, i.e., `fl::matmul`.
+ */
+class MatmulNode : public NodeTrait<MatmulNode> {
+  const MatrixProperty lhsProp_;
+  const MatrixProperty rhsProp_;
+
+  // helps indexing into inputs
+  static constexpr unsigned kLhsIdx = 0;
+  static constexpr unsigned kRhsIdx = 1;
+
+  // intentionally kept private to control allocation
+  MatmulNode(
+      Node* lhs,
+      Node* rhs,
+      MatrixProperty lhsProp,
+      MatrixProperty rhsProp,
+      const Shape& shape);
+
+ public:
+  static constexpr NodeType nodeType = NodeType::Matmul;
+
+  /**
+   * Create a node for `matmul(lhs, rhs, lhsProp, rhsProp)`.
+   *
+   * @throws std::invalid_argument if the input shapes are incompatible.
+   */
+  static MatmulNode* create(
+      Node* lhs,
+      Node* rhs,
+      MatrixProperty lhsProp,
+      MatrixProperty rhsProp);
+
+  Node* lhs() const;
+  Node* rhs() const;
+  MatrixProperty lhsProp() const;
+  MatrixProperty rhsProp() const;
+};
+
+} // namespace fl
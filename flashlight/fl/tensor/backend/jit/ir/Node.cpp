@@ -82,12 +82,15 @@ const UseList& Node::uses() const {
 }
 
 void Node::replaceAllUsesWith(Node* newInput) {
-  if (newInput != this) {
+  if (newInput != this && !uses_.empty()) {
+    // the last user switching to `newInput` may release `this` mid-loop
+    incRefCount();
     // each iteration updates links an existing user to newInput
     while (!uses_.empty()) {
       const auto* nextUse = *uses_.begin();
       nextUse->user()->setInput(nextUse->inputIdx(), newInput);
     }
+    decRefCount(); // NOTE this might delete `this`
   }
 }
 
@@ -141,10 +144,22 @@ bool Node::isIndex() const {
   return type() == NodeType::Index;
 }
 
+bool Node::isMatmul() const {
+  return type() == NodeType::Matmul;
+}
+
+bool Node::isReduction() const {
+  return type() == NodeType::Reduction;
+}
+
 bool Node::isScalar() const {
   return type() == NodeType::Scalar;
 }
 
+bool Node::isUnary() const {
+  return type() == NodeType::Unary;
+}
+
 bool Node::isValue() const {
   return type() == NodeType::Value;
 }
@@ -75,6 +75,7 @@ class Node {
 
   // Uses
   const UseList& uses() const;
+  // NOTE `this` gets deleted if it was only referenced by its users
   void replaceAllUsesWith(Node* newInput);
 
   // Mainly for debugging/testing
@@ -92,7 +93,10 @@ class Node {
   bool isBinary() const;
   bool isCustom() const;
   bool isIndex() const;
+  bool isMatmul() const;
+  bool isReduction() const;
   bool isScalar() const;
+  bool isUnary() const;
   bool isValue() const;
 
   // Fast & safe casts
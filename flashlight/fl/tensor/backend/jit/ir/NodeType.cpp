@@ -23,6 +23,12 @@ std::string nodeTypeToString(const NodeType type) {
       return "Value";
     case NodeType::Index:
       return "Index";
+    case NodeType::Unary:
+      return "Unary";
+    case NodeType::Reduction:
+      return "Reduction";
+    case NodeType::Matmul:
+      return "Matmul";
   }
   throw std::runtime_error("Unknown node type");
 }
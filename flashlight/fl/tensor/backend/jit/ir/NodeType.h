@@ -21,6 +21,9 @@ enum class NodeType {
   Scalar,
   Value,
   Index,
+  Unary,
+  Reduction,
+  Matmul,
 };
 
 /**
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/backend/jit/ir/ReductionNode.h"
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace fl {
+
+namespace {
+
+std::vector<int> getAxesToReduce(
+    const Shape& inputShape,
+    const std::vector<int>& axes) {
+  std::vector<int> axesToReduce;
+  if (axes.empty()) {
+    axesToReduce.resize(inputShape.ndim());
+    std::iota(axesToReduce.begin(), axesToReduce.end(), 0);
+    return axesToReduce;
+  }
+  for (const int axis : axes) {
+    if (axis < 0 || axis >= inputShape.ndim()) {
+      std::ostringstream oss;
+      oss << "[ReductionNode::create] Invalid axis for reduction: " << axis
+          << " for input of shape: " << inputShape;
+      throw std::invalid_argument(oss.str());
+    }
+    axesToReduce.push_back(axis);
+  }
+  std::sort(axesToReduce.begin(), axesToReduce.end());
+  axesToReduce.erase(
+      std::unique(axesToReduce.begin(), axesToReduce.end()),
+      axesToReduce.end());
+  return axesToReduce;
+}
+
+// ASSUME `axesToReduce` is sorted & deduplicated
+Shape inferReducedShape(
+    const Shape& inputShape,
+    const std::vector<int>& axesToReduce,
+    const bool keepDims) {
+  Shape::Dims dstDims;
+  auto axisIter = axesToReduce.begin();
+  for (int i = 0; i < inputShape.ndim(); i++) {
+    if (axisIter != axesToReduce.end() && *axisIter == i) {
+      axisIter++;
+      if (keepDims) {
+        dstDims.push_back(1);
+      }
+    } else {
+      dstDims.push_back(inputShape.dim(i));
+    }
+  }
+  return Shape(dstDims);
+}
+
+} // namespace
+
+ReductionNode::ReductionNode(
+    Node* input,
+    ReductionOp op,
+    std::vector<int>&& axes,
+    bool keepDims,
+    const Shape& shape)
+    : NodeTrait({input}, shape),
+      op_(op),
+      axes_(std::move(axes)),
+      keepDims_(keepDims) {}
+
+ReductionNode* ReductionNode::create(
+    Node* input,
+    ReductionOp op,
+    const std::vector<int>& axes,
+    bool keepDims) {
+  auto axesToReduce = getAxesToReduce(input->shape(), axes);
+  const auto shape = inferReducedShape(input->shape(), axesToReduce, keepDims);
+  return new ReductionNode(
+      input, op, std::move(axesToReduce), keepDims, shape);
+}
+
+ReductionOp ReductionNode::op() const {
+  return op_;
+}
+
+Node* ReductionNode::input() const {
+  return getInput(kInputIdx);
+}
+
+const std::vector<int>& ReductionNode::axes() const {
+  return axes_;
+}
+
+bool ReductionNode::keepDims() const {
+  return keepDims_;
+}
+
+} // namespace fl
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "flashlight/fl/tensor/backend/jit/ir/Node.h"
+
+namespace fl {
+
+/**
+ * Types of reduction operations.
+ */
+enum class ReductionOp { Min, Max, Sum, Mean };
+
+/**
+ * A node that represents reductions along some axes, e.g., `sum(x, {0})`.
+ */
+class ReductionNode : public NodeTrait<ReductionNode> {
+  const ReductionOp op_;
+  // axes to reduce along, sorted & deduplicated (empty `axes` is expanded)
+  const std::vector<int> axes_;
+  const bool keepDims_;
+
+  // helps indexing into inputs
+  static constexpr unsigned kInputIdx = 0;
+
+  // intentionally kept private to control allocation
+  ReductionNode(
+      Node* input,
+      ReductionOp op,
+      std::vector<int>&& axes,
+      bool keepDims,
+      const Shape& shape);
+
+ public:
+  static constexpr NodeType nodeType = NodeType::Reduction;
+
+  /**
+   * Create a node that reduces `input` along `axes`. Same as the
+   * `TensorBackend` reductions, an empty `axes` means reducing along all axes.
+   */
+  static ReductionNode* create(
+      Node* input,
+      ReductionOp op,
+      const std::vector<int>& axes,
+      bool keepDims);
+
+  ReductionOp op() const;
+  Node* input() const;
+  const std::vector<int>& axes() const;
+  bool keepDims() const;
+};
+
+} // namespace fl
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
+
+namespace fl {
+
+UnaryNode::UnaryNode(Node* input, UnaryOp op)
+    : NodeTrait({input}, input->shape()), op_(op) {}
+
+UnaryNode* UnaryNode::create(Node* input, UnaryOp op) {
+  return new UnaryNode(input, op);
+}
+
+UnaryOp UnaryNode::op() const {
+  return op_;
+}
+
+Node* UnaryNode::input() const {
+  return getInput(kInputIdx);
+}
+
+} // namespace fl
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "flashlight/fl/tensor/backend/jit/ir/Node.h"
+
+namespace fl {
+
+/**
+ * Types of unary (elementwise) operations.
+ */
+enum class UnaryOp {
+  Exp,
+  Log,
+  Negative,
+  LogicalNot,
+  Log1p,
+  Sin,
+  Cos,
+  Sqrt,
+  Tanh,
+  Floor,
+  Ceil,
+  Rint,
+  Absolute,
+  Sigmoid,
+  Erf,
+  IsNan,
+  IsInf,
+  Sign,
+};
+
+/**
+ * A node that represents unary elementwise operations.
+ */
+class UnaryNode : public NodeTrait<UnaryNode> {
+  const UnaryOp op_;
+
+  // helps indexing into inputs
+  static constexpr unsigned kInputIdx = 0;
+
+  // intentionally kept private to control allocation
+  UnaryNode(Node* input, UnaryOp op);
+
+ public:
+  static constexpr NodeType nodeType = NodeType::Unary;
+
+  static UnaryNode* create(Node* input, UnaryOp op);
+
+  UnaryOp op() const;
+  Node* input() const;
+};
+
+} // namespace fl
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/backend/jit/opt/OptimizedGraphCache.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/CustomNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/MatmulNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ReductionNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
+
+namespace fl {
+
+namespace {
+
+void writeScalar(std::ostream& os, const ScalarNode& node) {
+  os << node.dataType() << ":";
+  switch (node.dataType()) {
+    case dtype::f16:
+    case dtype::bf16:
+    case dtype::f32:
+    case dtype::f64:
+      // hexfloat is exact, i.e., distinct values yield distinct signatures
+      os << std::hexfloat << node.scalar<double>() << std::defaultfloat;
+      return;
+    case dtype::b8:
+    case dtype::s16:
+    case dtype::s32:
+    case dtype::s64:
+    case dtype::u8:
+    case dtype::u16:
+    case dtype::u32:
+      os << node.scalar<long long>();
+      return;
+    case dtype::u64:
+      os << node.scalar<unsigned long long>();
+      return;
+  }
+  throw std::runtime_error("[writeScalar] Unknown data type");
+}
+
+ScalarNode* cloneScalarNode(const ScalarNode& node) {
+  const auto& shape = node.shape();
+  const auto type = node.dataType();
+  switch (type) {
+    case dtype::f16:
+    case dtype::bf16:
+    case dtype::f32:
+    case dtype::f64:
+      return ScalarNode::create(shape, type, node.scalar<double>());
+    case dtype::b8:
+    case dtype::s16:
+    case dtype::s32:
+    case dtype::s64:
+    case dtype::u8:
+    case dtype::u16:
+    case dtype::u32:
+      return ScalarNode::create(shape, type, node.scalar<long long>());
+    case dtype::u64:
+      return ScalarNode::create(shape, type, node.scalar<unsigned long long>());
+  }
+  throw std::runtime_error("[cloneScalarNode] Unknown data type");
+}
+
+CustomNode* createPlaceholder(const Shape& shape) {
+  return CustomNode::create(
+      "OptimizedGraphCachePlaceholder",
+      {},
+      shape,
+      [](const std::vector<const Tensor*>& /* inputs */) -> Tensor {
+        throw std::runtime_error(
+            "[OptimizedGraphCache] Placeholders must not be evaluated");
+      });
+}
+
+// Builds the signature of a tree in post-order, nodes refer to their inputs
+// via the order in which those inputs were first visited.
+class SignatureBuilder {
+  std::ostringstream oss_{};
+  std::vector<Node*> leaves_{};
+  std::unordered_map<const Node*, unsigned> nodeToId_{};
+
+  void writeInputIds(const Node* node) {
+    oss_ << "(";
+    for (const auto& input : node->inputs()) {
+      oss_ << nodeToId_.at(input) << ",";
+    }
+    oss_ << ")";
+  }
+
+ public:
+  // return false if the tree can't be cached
+  bool visit(Node* node) {
+    if (nodeToId_.find(node) != nodeToId_.end()) {
+      return true;
+    }
+    const auto& result = node->getResult();
+    if (result.has_value()) {
+      oss_ << "L" << leaves_.size() << node->shape() << result->type();
+      leaves_.push_back(node);
+    } else {
+      for (const auto& input : node->inputs()) {
+        if (!visit(input)) {
+          return false;
+        }
+      }
+      switch (node->type()) {
+        case NodeType::Binary:
+          oss_ << "B" << static_cast<int>(node->impl<BinaryNode>().op());
+          break;
+        case NodeType::Matmul: {
+          const auto& matmulNode = node->impl<MatmulNode>();
+          oss_ << "M" << static_cast<int>(matmulNode.lhsProp())
+               << static_cast<int>(matmulNode.rhsProp());
+          break;
+        }
+        case NodeType::Reduction: {
+          const auto& reductionNode = node->impl<ReductionNode>();
+          oss_ << "R" << static_cast<int>(reductionNode.op()) << "[";
+          for (const auto axis : reductionNode.axes()) {
+            oss_ << axis << ",";
+          }
+          oss_ << "]" << reductionNode.keepDims();
+          break;
+        }
+        case NodeType::Scalar:
+          oss_ << "S" << node->shape();
+          writeScalar(oss_, node->impl<ScalarNode>());
+          break;
+        case NodeType::Unary:
+          oss_ << "U" << static_cast<int>(node->impl<UnaryNode>().op());
+          break;
+        case NodeType::Custom:
+        case NodeType::Index:
+        case NodeType::Value:
+          return false;
+      }
+      writeInputIds(node);
+    }
+    oss_ << ";";
+    nodeToId_.emplace(node, nodeToId_.size());
+    return true;
+  }
+
+  OptimizedGraphCache::Signature build() {
+    return {oss_.str(), std::move(leaves_)};
+  }
+};
+
+// Clone a tree, with the given existing mapping as base (e.g., for leaves).
+// ASSUME every node without a mapping is a clonable type without result.
+class TreeCloner {
+  std::unordered_map<const Node*, Node*> oldToNew_;
+
+  Node* cloneNode(const Node* node, std::vector<Node*>&& inputs) {
+    switch (node->type()) {
+      case NodeType::Binary:
+        return BinaryNode::create(
+            inputs.at(0), inputs.at(1), node->impl<BinaryNode>().op());
+      case NodeType::Custom: {
+        const auto& customNode = node->impl<CustomNode>();
+        auto evalFunc = customNode.evalFunc();
+        return CustomNode::create(
+            std::string(customNode.name()),
+            std::move(inputs),
+            node->shape(),
+            std::move(evalFunc));
+      }
+      case NodeType::Matmul: {
+        const auto& matmulNode = node->impl<MatmulNode>();
+        return MatmulNode::create(
+            inputs.at(0),
+            inputs.at(1),
+            matmulNode.lhsProp(),
+            matmulNode.rhsProp());
+      }
+      case NodeType::Reduction: {
+        const auto& reductionNode = node->impl<ReductionNode>();
+        return ReductionNode::create(
+            inputs.at(0),
+            reductionNode.op(),
+            reductionNode.axes(),
+            reductionNode.keepDims());
+      }
+      case NodeType::Scalar:
+        return cloneScalarNode(node->impl<ScalarNode>());
+      case NodeType::Unary:
+        return UnaryNode::create(inputs.at(0), node->impl<UnaryNode>().op());
+      case NodeType::Index:
+      case NodeType::Value:
+        break;
+    }
+    throw std::runtime_error("[TreeCloner::cloneNode] Unclonable node type");
+  }
+
+ public:
+  explicit TreeCloner(std::unordered_map<const Node*, Node*>&& oldToNew)
+      : oldToNew_(std::move(oldToNew)) {}
+
+  Node* clone(const Node* node) {
+    const auto iter = oldToNew_.find(node);
+    if (iter != oldToNew_.end()) {
+      return iter->second;
+    }
+    std::vector<Node*> newInputs;
+    for (const auto& input : node->inputs()) {
+      newInputs.push_back(clone(input));
+    }
+    const auto newNode = cloneNode(node, std::move(newInputs));
+    oldToNew_.emplace(node, newNode);
+    return newNode;
+  }
+};
+
+// whether the tree only depends on `leaves`, i.e., it can be cloned with
+// `leaves` mapped to placeholders.
+bool isRecordable(
+    const Node* node,
+    const std::unordered_set<const Node*>& leaves,
+    std::unordered_set<const Node*>& visited) {
+  if (!visited.insert(node).second || leaves.count(node)) {
+    return true;
+  }
+  if (node->getResult().has_value() || node->isIndex() || node->isValue()) {
+    return false;
+  }
+  for (const auto& input : node->inputs()) {
+    if (!isRecordable(input, leaves, visited)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+OptimizedGraphCache::~OptimizedGraphCache() {
+  clear();
+}
+
+std::optional<OptimizedGraphCache::Signature>
+OptimizedGraphCache::getSignature(Node* root) {
+  if (root->getResult().has_value()) {
+    return std::nullopt; // nothing to optimize
+  }
+  SignatureBuilder builder;
+  if (!builder.visit(root)) {
+    return std::nullopt;
+  }
+  return builder.build();
+}
+
+Node* OptimizedGraphCache::replay(const Signature& signature) const {
+  const auto iter = keyToPlan_.find(signature.key);
+  if (iter == keyToPlan_.end()) {
+    return nullptr;
+  }
+  const auto& plan = iter->second;
+  std::unordered_map<const Node*, Node*> placeholderToLeaf;
+  for (const auto& [placeholder, leafIdx] : plan.placeholderToLeafIdx) {
+    placeholderToLeaf.emplace(placeholder, signature.leaves.at(leafIdx));
+  }
+  return TreeCloner(std::move(placeholderToLeaf)).clone(plan.root);
+}
+
+void OptimizedGraphCache::record(
+    const Signature& signature,
+    Node* optimizedRoot) {
+  const std::unordered_set<const Node*> leaves(
+      signature.leaves.begin(), signature.leaves.end());
+  std::unordered_set<const Node*> visited;
+  if (!isRecordable(optimizedRoot, leaves, visited)) {
+    return;
+  }
+  if (keyToPlan_.size() >= kMaxNumPlans) {
+    clear();
+  }
+  // only leaves that are actually used get a placeholder
+  Plan plan;
+  std::unordered_map<const Node*, Node*> leafToPlaceholder;
+  for (unsigned i = 0; i < signature.leaves.size(); i++) {
+    const auto leaf = signature.leaves[i];
+    if (visited.count(leaf)) {
+      const auto placeholder = createPlaceholder(leaf->shape());
+      leafToPlaceholder.emplace(leaf, placeholder);
+      plan.placeholderToLeafIdx.emplace(placeholder, i);
+    }
+  }
+  plan.root = TreeCloner(std::move(leafToPlaceholder)).clone(optimizedRoot);
+  plan.root->incRefCount();
+  keyToPlan_.emplace(signature.key, std::move(plan));
+}
+
+size_t OptimizedGraphCache::size() const {
+  return keyToPlan_.size();
+}
+
+void OptimizedGraphCache::clear() {
+  for (auto& [key, plan] : keyToPlan_) {
+    plan.root->decRefCount();
+  }
+  keyToPlan_.clear();
+}
+
+} // namespace fl
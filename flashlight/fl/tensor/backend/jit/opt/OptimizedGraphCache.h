@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flashlight/fl/tensor/backend/jit/ir/Node.h"
+
+namespace fl {
+
+/**
+ * A cache that maps the structure of a JIT tree to its optimized form, so that
+ * structurally identical trees (e.g., from each iteration of a training loop)
+ * only go through the optimization passes once.
+ *
+ * The structure of a tree covers node types, ops, shapes, scalar types and
+ * values, and how nodes are shared. Leaves (nodes that already have a result)
+ * are treated as placeholders, identified only by their shape and type -- on
+ * a cache hit, the optimized tree is re-instantiated on top of the new leaves.
+ *
+ * NOTE
+ * 1. trees with CustomNode (opaque semantics) or IndexNode aren't cached.
+ * 2. optimization passes must be purely structural, i.e., they can't depend on
+ *    the data of leaves.
+ */
+class OptimizedGraphCache {
+ public:
+  /**
+   * The structural signature of a JIT tree, along with its leaves in the
+   * order they appear in the signature.
+   */
+  struct Signature {
+    std::string key;
+    std::vector<Node*> leaves;
+  };
+
+ private:
+  // an optimized tree whose leaves are placeholder nodes (owned by the tree)
+  struct Plan {
+    Node* root;
+    std::unordered_map<const Node*, unsigned> placeholderToLeafIdx;
+  };
+
+  // beyond this, we flush the cache to bound memory used by plans
+  static constexpr unsigned kMaxNumPlans = 1024;
+
+  std::unordered_map<std::string, Plan> keyToPlan_{};
+
+ public:
+  OptimizedGraphCache() = default;
+  ~OptimizedGraphCache();
+
+  // no copy/move
+  OptimizedGraphCache(const OptimizedGraphCache&) = delete;
+  OptimizedGraphCache(OptimizedGraphCache&&) = delete;
+  OptimizedGraphCache& operator=(const OptimizedGraphCache&) = delete;
+  OptimizedGraphCache& operator=(OptimizedGraphCache&&) = delete;
+
+  /**
+   * Compute the structural signature for the tree rooted at `root`.
+   *
+   * @return the signature, or nullopt if the tree can't be cached.
+   */
+  static std::optional<Signature> getSignature(Node* root);
+
+  /**
+   * Instantiate the cached plan for `signature` against its leaves.
+   *
+   * @return root of the re-instantiated optimized tree (caller must take
+   * ownership), or nullptr upon cache miss.
+   */
+  Node* replay(const Signature& signature) const;
+
+  /**
+   * Record `optimizedRoot` as the optimized form of trees with `signature`.
+   * The tree rooted at `optimizedRoot` is copied, not retained, and must only
+   * depend on leaves in `signature.leaves`; otherwise nothing gets recorded.
+   */
+  void record(const Signature& signature, Node* optimizedRoot);
+
+  /**
+   * Number of plans currently in the cache.
+   */
+  size_t size() const;
+
+  /**
+   * Remove all plans from the cache.
+   */
+  void clear();
+};
+
+} // namespace fl
@@ -8,10 +8,15 @@
 #include "flashlight/fl/tensor/backend/jit/opt/Optimizer.h"
 
 #include <iterator>
+#include <unordered_set>
+
+#include "flashlight/fl/common/Timer.h"
+#include "flashlight/fl/tensor/Profile.h"
 
 #include "flashlight/fl/tensor/TensorBackend.h"
 #include "flashlight/fl/tensor/backend/jit/opt/JitOptimizerExtension.h"
 #include "flashlight/fl/tensor/backend/jit/opt/JitOptimizerExtensionBackends.h"
+#include "flashlight/fl/tensor/backend/jit/opt/passes/CommonSubexpressionElimination.h"
 #include "flashlight/fl/tensor/backend/jit/opt/passes/ScalarFolding.h"
 
 namespace fl {
@@ -26,6 +31,29 @@ void extend(std::vector<T>& extendee, std::vector<T>&& elems) {
       std::make_move_iterator(std::end(elems)));
 }
 
+struct TreeSummary {
+  size_t numNodes{0};
+  unsigned numCustomNodes{0};
+};
+
+TreeSummary summarizeTree(const Node* root) {
+  TreeSummary summary;
+  std::unordered_set<const Node*> visited{root};
+  std::vector<const Node*> worklist{root};
+  while (!worklist.empty()) {
+    const auto node = worklist.back();
+    worklist.pop_back();
+    summary.numNodes++;
+    summary.numCustomNodes += node->isCustom();
+    for (const auto& input : node->inputs()) {
+      if (visited.insert(input).second) {
+        worklist.push_back(input);
+      }
+    }
+  }
+  return summary;
+}
+
 } // namespace
 
 Optimizer::Optimizer(TensorBackend& backend) : backend_(backend) {
@@ -33,14 +61,17 @@ Optimizer::Optimizer(TensorBackend& backend) : backend_(backend) {
   // 1. figure out a configuration API (e.g., LLVM pass style macro)
   // 2. think about ordering
   passes_.emplace_back(std::make_unique<ScalarFolding>());
+  // runs after folding so that newly folded scalars can be merged as well
+  passes_.emplace_back(std::make_unique<CommonSubexpressionElimination>());
   auto& registrar = detail::TensorExtensionRegistrar::getInstance();
   if (registrar.isTensorExtensionRegistered(
           backend_.backendType(), TensorExtensionType::JitOptimizer)) {
     extend(passes_, backend_.getExtension<JitOptimizerExtension>().passes());
   }
+  resetStats();
 }
 
-Node* Optimizer::optimize(Node* node) {
+Node* Optimizer::runPasses(Node* node) {
   // TODO use an `ExternalUse` interface to enable `Node::replaceAllUsesWith()`
   // to update JitTensorBase::node() as well. We don't want to store these
   // "external" uses together with node uses in `Node::uses()` because the
@@ -50,8 +81,21 @@ Node* Optimizer::optimize(Node* node) {
   // return a Node* anymore, and relevant refcount management gets cleaner too.
   Node* currNode = node;
   bool currNodeMustBeDeleted = false;
-  for (const auto& pass : passes_) {
-    Node* nextNode = pass->apply(currNode);
+  for (unsigned i = 0; i < passes_.size(); i++) {
+    const auto& pass = passes_[i];
+    FL_PROFILE_TRACE("JitOptimizer::" + pass->name());
+    Node* nextNode = nullptr;
+    if (collectStats_) {
+      auto& passStats = stats_.passStats[i];
+      passStats.numRuns++;
+      passStats.numNodesBefore += summarizeTree(currNode).numNodes;
+      const auto timer = Timer::start();
+      nextNode = pass->apply(currNode);
+      passStats.seconds += Timer::stop(timer);
+      passStats.numNodesAfter += summarizeTree(nextNode).numNodes;
+    } else {
+      nextNode = pass->apply(currNode);
+    }
     // intermediate nodes must be deleted -- caller only gets final output node
     if (currNode != node && currNode != nextNode && currNodeMustBeDeleted) {
       delete currNode;
@@ -62,4 +106,67 @@ Node* Optimizer::optimize(Node* node) {
   return currNode;
 }
 
+void Optimizer::recordOptimizedTree(const Node* node) {
+  if (collectStats_) {
+    stats_.numOptimizedTrees++;
+    stats_.numCustomNodes += summarizeTree(node).numCustomNodes;
+  }
+}
+
+Node* Optimizer::optimize(Node* node) {
+  const auto signature = OptimizedGraphCache::getSignature(node);
+  if (!signature.has_value()) {
+    const auto optimizedNode = runPasses(node);
+    recordOptimizedTree(optimizedNode);
+    return optimizedNode;
+  }
+  if (const auto replayedNode = cache_.replay(signature.value())) {
+    if (collectStats_) {
+      stats_.numReplayedTrees++;
+    }
+    recordOptimizedTree(replayedNode);
+    return replayedNode;
+  }
+  // passes might drop leaves from the tree, keep them alive for recording
+  for (const auto leaf : signature->leaves) {
+    leaf->incRefCount();
+  }
+  const auto optimizedNode = runPasses(node);
+  cache_.record(signature.value(), optimizedNode);
+  for (const auto leaf : signature->leaves) {
+    leaf->decRefCount();
+  }
+  recordOptimizedTree(optimizedNode);
+  return optimizedNode;
+}
+
+void Optimizer::addPass(std::unique_ptr<Pass> pass) {
+  stats_.passStats.push_back({.name = pass->name()});
+  passes_.push_back(std::move(pass));
+  cache_.clear();
+}
+
+OptimizedGraphCache& Optimizer::cache() {
+  return cache_;
+}
+
+void Optimizer::setCollectStats(bool collectStats) {
+  collectStats_ = collectStats;
+}
+
+bool Optimizer::collectStats() const {
+  return collectStats_;
+}
+
+const Optimizer::Stats& Optimizer::stats() const {
+  return stats_;
+}
+
+void Optimizer::resetStats() {
+  stats_ = Stats();
+  for (const auto& pass : passes_) {
+    stats_.passStats.push_back({.name = pass->name()});
+  }
+}
+
 } // namespace fl
@@ -8,8 +8,11 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "flashlight/fl/tensor/backend/jit/ir/Node.h"
+#include "flashlight/fl/tensor/backend/jit/opt/OptimizedGraphCache.h"
 #include "flashlight/fl/tensor/backend/jit/opt/Pass.h"
 
 namespace fl {
@@ -18,9 +21,40 @@ namespace fl {
  * A JIT tree optimizer.
  */
 class Optimizer {
+ public:
+  struct PassStats {
+    std::string name;
+    unsigned numRuns{0};
+    // summed over all runs
+    size_t numNodesBefore{0};
+    size_t numNodesAfter{0};
+    double seconds{0};
+  };
+
+  /**
+   * What the optimizer did since stats collection was enabled (or reset).
+   */
+  struct Stats {
+    unsigned numOptimizedTrees{0};
+    // trees whose optimized form was replayed from `cache()`
+    unsigned numReplayedTrees{0};
+    // custom nodes (e.g., fused kernels) in the optimized trees
+    unsigned numCustomNodes{0};
+    // in the order passes run
+    std::vector<PassStats> passStats;
+  };
+
+ private:
   std::vector<std::unique_ptr<Pass>> passes_;
   // backend used for optional JIT optimizer extension
   TensorBackend& backend_;
+  // skip the passes for trees we've optimized before
+  OptimizedGraphCache cache_{};
+  bool collectStats_{false};
+  Stats stats_{};
+
+  Node* runPasses(Node* node);
+  void recordOptimizedTree(const Node* node);
 
  public:
   explicit Optimizer(TensorBackend& backend);
@@ -33,6 +67,27 @@ class Optimizer {
    * node if `return != node`)
    */
   Node* optimize(Node* node);
+
+  /**
+   * Append a pass to run after the existing ones, e.g., a fusion pass from a
+   * package that the core doesn't depend on. Clears `cache()`, whose plans
+   * were optimized without the pass.
+   */
+  void addPass(std::unique_ptr<Pass> pass);
+
+  /**
+   * @return the cache of optimized trees used by this optimizer.
+   */
+  OptimizedGraphCache& cache();
+
+  /**
+   * Enable/disable collecting `stats()`; disabled by default since counting
+   * nodes adds a pass over the tree before and after each optimization pass.
+   */
+  void setCollectStats(bool collectStats);
+  bool collectStats() const;
+  const Stats& stats() const;
+  void resetStats();
 };
 
 } // namespace fl
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "flashlight/fl/tensor/backend/jit/ir/Node.h"
 
 namespace fl {
@@ -27,6 +29,12 @@ class Pass {
    * node if `return != node`)
    */
   virtual Node* apply(Node* node) = 0;
+
+  /**
+   * @return a human-readable name of the pass, e.g., for statistics and
+   * profiling.
+   */
+  virtual std::string name() const = 0;
 };
 
 } // namespace fl
@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/backend/jit/opt/backends/cpu/CpuElementwiseFusion.h"
+
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/CustomNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/IndexNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/opt/backends/cpu/ElementwiseKernel.h"
+
+namespace fl {
+
+namespace {
+
+using Instruction = ElementwiseKernel::Instruction;
+using InputView = ElementwiseKernel::InputView;
+using OpCode = ElementwiseKernel::OpCode;
+using ScalarValue = ElementwiseKernel::ScalarValue;
+
+OpCode binopToOpCode(const BinaryOp op) {
+  switch (op) {
+    case BinaryOp::Add:
+      return OpCode::Add;
+    case BinaryOp::Sub:
+      return OpCode::Sub;
+    case BinaryOp::Mul:
+      return OpCode::Mul;
+    case BinaryOp::Div:
+      return OpCode::Div;
+  }
+  throw std::runtime_error("[binopToOpCode] Unknown binary operation type");
+}
+
+ScalarValue getScalarValue(const ScalarNode& node) {
+  switch (node.dataType()) {
+    case dtype::b8:
+    case dtype::s16:
+    case dtype::s32:
+    case dtype::s64:
+    case dtype::u8:
+    case dtype::u16:
+    case dtype::u32:
+      return node.scalar<long long>();
+    case dtype::u64:
+      return node.scalar<unsigned long long>();
+    case dtype::f16:
+    case dtype::bf16:
+    case dtype::f32:
+    case dtype::f64:
+      return node.scalar<double>();
+  }
+  throw std::runtime_error("[getScalarValue] Unknown data type");
+}
+
+bool isNodeFusable(const Node* node) {
+  if (!node->isBinary()) {
+    return false;
+  }
+  // leave these to ScalarFolding
+  const auto& binaryNode = node->impl<BinaryNode>();
+  return !(binaryNode.lhs()->isScalar() && binaryNode.rhs()->isScalar());
+}
+
+struct StridedView {
+  Dim offset;
+  std::vector<Dim> strides;
+};
+
+// If `node` only selects a strided window (spans, positive-stride ranges and
+// literals) of the indexed node, return how to read it in place from the
+// (contiguous) buffer of the indexed node.
+std::optional<StridedView> getStridedView(const IndexNode& node) {
+  const auto& indexedShape = node.indexedNode()->shape();
+  const auto& indices = node.indices();
+  if (indices.size() > static_cast<size_t>(indexedShape.ndim())) {
+    return std::nullopt;
+  }
+  StridedView view{0, {}};
+  Dim bufferStride = 1; // column-major
+  for (int i = 0; i < indexedShape.ndim(); i++) {
+    const auto dim = indexedShape.dim(i);
+    if (i >= static_cast<int>(indices.size())) {
+      view.strides.push_back(bufferStride);
+      bufferStride *= dim;
+      continue;
+    }
+    const auto& idx = indices[i];
+    switch (idx.type()) {
+      case detail::IndexType::Span:
+        view.strides.push_back(bufferStride);
+        break;
+      case detail::IndexType::Range: {
+        const auto& rangeIdx = idx.get<range>();
+        const auto start = rangeIdx.start();
+        const auto end = rangeIdx.end().value_or(dim);
+        const auto stride = rangeIdx.stride();
+        if (start < 0 || end > dim || start >= end || stride <= 0) {
+          return std::nullopt;
+        }
+        view.offset += start * bufferStride;
+        view.strides.push_back(stride * bufferStride);
+        break;
+      }
+      case detail::IndexType::Literal: {
+        const auto literal = idx.get<Dim>();
+        if (literal < 0 || literal >= dim) {
+          return std::nullopt;
+        }
+        view.offset += literal * bufferStride; // dimension is reduced
+        break;
+      }
+      default:
+        return std::nullopt;
+    }
+    bufferStride *= dim;
+  }
+  if (view.strides.size() != static_cast<size_t>(node.shape().ndim())) {
+    return std::nullopt;
+  }
+  return view;
+}
+
+bool isFusionProfitable(const Node* node) {
+  // TODO Even if we have > 1 use, it might be possible & profitable to fuse,
+  // i.e., recomputation might be okay, think Halide.
+  return node->uses().size() <= 1;
+}
+
+} // namespace
+
+// Linearizes a fusable region into ElementwiseKernel instructions.
+class CpuElementwiseFusion::RegionBuilder {
+  CpuElementwiseFusion& fuser_;
+  std::vector<Instruction> instructions_{};
+  std::vector<Node*> inputNodes_{};
+  std::vector<ScalarValue> scalars_{};
+  std::vector<InputView> views_{};
+  // input (or view) node -> register holding its value
+  std::unordered_map<Node*, unsigned> inputNodeToRegister_{};
+  // input node -> index into `inputNodes_`
+  std::unordered_map<Node*, unsigned> inputNodeToOperandIdx_{};
+  unsigned numBinops_{0};
+
+  unsigned addInstruction(Instruction&& instruction) {
+    instructions_.push_back(std::move(instruction));
+    return instructions_.size() - 1;
+  }
+
+  unsigned getOperandIdx(Node* node) {
+    const auto iter = inputNodeToOperandIdx_.find(node);
+    if (iter != inputNodeToOperandIdx_.end()) {
+      return iter->second;
+    }
+    inputNodes_.push_back(node);
+    inputNodeToOperandIdx_.emplace(node, inputNodes_.size() - 1);
+    return inputNodes_.size() - 1;
+  }
+
+  unsigned addInput(Node* node) {
+    // optimize the input first, since it might get replaced
+    node = fuser_.rewriteFrom(node);
+    const auto iter = inputNodeToRegister_.find(node);
+    if (iter != inputNodeToRegister_.end()) {
+      return iter->second;
+    }
+    Instruction instruction{.opCode = OpCode::Input};
+    instruction.operandIdx = getOperandIdx(node);
+    instruction.shape = node->shape();
+    const auto reg = addInstruction(std::move(instruction));
+    inputNodeToRegister_.emplace(node, reg);
+    return reg;
+  }
+
+  // read the indexed node in place, rather than materializing the slice
+  unsigned addView(Node* node, StridedView&& view) {
+    const auto iter = inputNodeToRegister_.find(node);
+    if (iter != inputNodeToRegister_.end()) {
+      return iter->second;
+    }
+    const auto& indexNode = node->impl<IndexNode>();
+    const auto indexedNode = fuser_.rewriteFrom(indexNode.indexedNode());
+    Instruction instruction{.opCode = OpCode::Input};
+    instruction.operandIdx = getOperandIdx(indexedNode);
+    instruction.shape = node->shape();
+    instruction.viewStrides = std::move(view.strides);
+    views_.push_back({view.offset, indexNode.indices()});
+    const auto reg = addInstruction(std::move(instruction));
+    inputNodeToRegister_.emplace(node, reg);
+    return reg;
+  }
+
+  unsigned addScalar(const ScalarNode& node) {
+    Instruction instruction{.opCode = OpCode::Scalar};
+    instruction.operandIdx = scalars_.size();
+    instruction.shape = node.shape();
+    instruction.scalarType = node.dataType();
+    scalars_.push_back(getScalarValue(node));
+    return addInstruction(std::move(instruction));
+  }
+
+  unsigned addBinop(const BinaryNode& node) {
+    const auto lhs = add(node.lhs(), /* isRegionRoot = */ false);
+    const auto rhs = add(node.rhs(), /* isRegionRoot = */ false);
+    Instruction instruction{.opCode = binopToOpCode(node.op())};
+    instruction.lhs = lhs;
+    instruction.rhs = rhs;
+    instruction.shape = node.shape();
+    numBinops_++;
+    return addInstruction(std::move(instruction));
+  }
+
+ public:
+  explicit RegionBuilder(CpuElementwiseFusion& fuser) : fuser_(fuser) {}
+
+  unsigned add(Node* node, bool isRegionRoot) {
+    if (node->isScalar()) {
+      return addScalar(node->impl<ScalarNode>());
+    }
+    const bool isVisited = fuser_.visited_.find(node) != fuser_.visited_.end();
+    const bool isInterior =
+        !isVisited && isNodeFusable(node) && isFusionProfitable(node);
+    if (!isRegionRoot && !isInterior) {
+      // a view costs nothing to read multiple times, so its uses don't matter
+      if (node->isIndex() && !node->getResult().has_value()) {
+        auto view = getStridedView(node->impl<IndexNode>());
+        if (view.has_value()) {
+          return addView(node, std::move(view.value()));
+        }
+      }
+      return addInput(node);
+    }
+    fuser_.visited_.insert(node);
+    return addBinop(node->impl<BinaryNode>());
+  }
+
+  // Fusing a single binop only pays off if it saves us a scalar broadcast or
+  // a slice copy.
+  bool isFusionWorthwhile() const {
+    return numBinops_ >= 2 || !scalars_.empty() || !views_.empty();
+  }
+
+  Node* build(const Shape& outputShape, TensorBackend& backend) {
+    auto kernel =
+        ElementwiseKernel::getOrCompile(std::move(instructions_), outputShape);
+    auto evalFunc = [kernel = std::move(kernel),
+                     scalars = std::move(scalars_),
+                     views = std::move(views_),
+                     &backend](const std::vector<const Tensor*>& inputs) {
+      return kernel->run(backend, inputs, scalars, views);
+    };
+    return CustomNode::create(
+        "CpuFusedElementwise",
+        std::move(inputNodes_),
+        outputShape,
+        std::move(evalFunc));
+  }
+};
+
+CpuElementwiseFusion::CpuElementwiseFusion(TensorBackend& backend)
+    : backend_(backend) {}
+
+Node* CpuElementwiseFusion::rewriteFrom(Node* node) {
+  if (visited_.find(node) != visited_.end()) {
+    return node;
+  }
+  if (!isNodeFusable(node)) {
+    visited_.insert(node);
+    for (const auto& input : node->inputs()) {
+      rewriteFrom(input);
+    }
+    return node;
+  }
+  RegionBuilder builder(*this);
+  builder.add(node, /* isRegionRoot = */ true);
+  if (!builder.isFusionWorthwhile()) {
+    return node;
+  }
+  auto fusedNode = builder.build(node->shape(), backend_);
+  node->replaceAllUsesWith(fusedNode);
+  return fusedNode;
+}
+
+Node* CpuElementwiseFusion::apply(Node* root) {
+  auto optimizedRoot = rewriteFrom(root);
+  visited_.clear();
+  return optimizedRoot;
+}
+
+std::string CpuElementwiseFusion::name() const {
+  return "CpuElementwiseFusion";
+}
+
+} // namespace fl
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <unordered_set>
+
+#include "flashlight/fl/tensor/TensorBackend.h"
+#include "flashlight/fl/tensor/backend/jit/ir/Node.h"
+#include "flashlight/fl/tensor/backend/jit/opt/Pass.h"
+
+namespace fl {
+
+/**
+ * Fuse connected elementwise subgraphs into a single `ElementwiseKernel`,
+ * which evaluates the whole subgraph in one pass over memory, i.e., without
+ * materializing any intermediate tensor (including broadcasted scalars).
+ *
+ * n1   c1
+ *  \  /
+ *   b2   n2
+ *    \  /
+ *     b1
+ *
+ * -->
+ *
+ *      n1 n2
+ *       \ /
+ * ---------------------- CustomNode that runs a (cached) ElementwiseKernel
+ * | r0 = in0           |
+ * | r1 = scalar0       |
+ * | r2 = r0 `b2` r1    |
+ * | r3 = in1           |
+ * | r4 = r2 `b1` r3    |
+ * ----------------------
+ *
+ * NOTE
+ * 1. like OneDnnOpFusion, we avoid recomputation -- intermediate nodes with
+ *    more than 1 use become inputs of the fused node.
+ * 2. binary nodes with 2 scalar inputs are left to ScalarFolding.
+ * 3. tensor inputs that don't qualify for the fused host loop (e.g., integral
+ *    types, or non-host memory) are evaluated op by op via `backend`.
+ * 4. index nodes that select a strided window of their input (e.g.,
+ *    `x(span, range(a, b))`) are read in place by the kernel, rather than
+ *    materialized as a copy.
+ */
+class CpuElementwiseFusion : public Pass {
+  TensorBackend& backend_;
+
+  // Avoid re-visit, since fuser only need to apply once to each node.
+  std::unordered_set<Node*> visited_{};
+
+  class RegionBuilder;
+
+  // fuse the largest elementwise region rooted at `node`, and recursively
+  // optimize the inputs of that region.
+  Node* rewriteFrom(Node* node);
+
+ public:
+  explicit CpuElementwiseFusion(TensorBackend& backend);
+  ~CpuElementwiseFusion() = default;
+
+  Node* apply(Node* root) override;
+  std::string name() const override;
+};
+
+} // namespace fl
@@ -0,0 +1,464 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/backend/jit/opt/backends/cpu/ElementwiseKernel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "flashlight/fl/runtime/Stream.h"
+
+namespace fl {
+
+namespace {
+
+// Number of elements each instruction processes at a time. Small enough for
+// all registers of a typical kernel to stay in L1/L2 cache.
+constexpr Dim kTileSize = 512;
+
+struct KernelCache {
+  std::mutex mutex;
+  std::unordered_map<std::string, std::shared_ptr<const ElementwiseKernel>>
+      signatureToKernel;
+
+  static KernelCache& getInstance() {
+    static KernelCache cache;
+    return cache;
+  }
+};
+
+bool isFpType(const dtype type) {
+  return type == dtype::f16 || type == dtype::bf16 || type == dtype::f32 ||
+      type == dtype::f64;
+}
+
+// Mimics the typing rule of binary ops in backends, i.e., floating point
+// types win over integral types, and otherwise the larger type wins.
+dtype getTypeWithLargerRange(const dtype t1, const dtype t2) {
+  if (isFpType(t1) == isFpType(t2)) {
+    return getTypeSize(t1) >= getTypeSize(t2) ? t1 : t2;
+  }
+  return isFpType(t1) ? t1 : t2;
+}
+
+bool isBinaryOpCode(const ElementwiseKernel::OpCode opCode) {
+  switch (opCode) {
+    case ElementwiseKernel::OpCode::Add:
+    case ElementwiseKernel::OpCode::Sub:
+    case ElementwiseKernel::OpCode::Mul:
+    case ElementwiseKernel::OpCode::Div:
+      return true;
+    case ElementwiseKernel::OpCode::Input:
+    case ElementwiseKernel::OpCode::Scalar:
+      return false;
+  }
+  throw std::runtime_error("[isBinaryOpCode] Unknown op code");
+}
+
+std::string opCodeToString(const ElementwiseKernel::OpCode opCode) {
+  switch (opCode) {
+    case ElementwiseKernel::OpCode::Input:
+      return "in";
+    case ElementwiseKernel::OpCode::Scalar:
+      return "scalar";
+    case ElementwiseKernel::OpCode::Add:
+      return "add";
+    case ElementwiseKernel::OpCode::Sub:
+      return "sub";
+    case ElementwiseKernel::OpCode::Mul:
+      return "mul";
+    case ElementwiseKernel::OpCode::Div:
+      return "div";
+  }
+  throw std::runtime_error("[opCodeToString] Unknown op code");
+}
+
+template <typename T>
+T castScalar(const ElementwiseKernel::ScalarValue& value) {
+  return std::visit([](auto&& val) { return static_cast<T>(val); }, value);
+}
+
+// Strides of `shape` w.r.t. `outputShape`'s index space, i.e., broadcasted
+// dimensions get a stride of 0. `viewStrides` are used if non-empty, and
+// column-major strides otherwise.
+std::vector<Dim> getBroadcastStrides(
+    const Shape& shape,
+    const std::vector<Dim>& viewStrides,
+    const Shape& outputShape) {
+  std::vector<Dim> strides(outputShape.ndim(), 0);
+  Dim stride = 1;
+  for (int i = 0; i < outputShape.ndim(); i++) {
+    const auto dim = shape.dim(i);
+    const auto dimStride = viewStrides.empty() ? stride : viewStrides.at(i);
+    strides[i] = (dim == 1 && outputShape.dim(i) != 1) ? 0 : dimStride;
+    stride *= dim;
+  }
+  return strides;
+}
+
+bool isDense(const std::vector<Dim>& strides, const Shape& outputShape) {
+  Dim stride = 1;
+  for (int i = 0; i < outputShape.ndim(); i++) {
+    if (outputShape.dim(i) != 1 && strides[i] != stride) {
+      return false;
+    }
+    stride *= outputShape.dim(i);
+  }
+  return true;
+}
+
+bool isUniform(const std::vector<Dim>& strides) {
+  return std::all_of(
+      strides.begin(), strides.end(), [](Dim stride) { return stride == 0; });
+}
+
+// load `size` elements of `src` starting at output linear index `begin`
+template <typename T>
+void loadInput(
+    T* dst,
+    const T* src,
+    const ElementwiseKernel::InputLayout& layout,
+    const Shape& outputShape,
+    const Dim begin,
+    const Dim size,
+    std::vector<Dim>& coords) {
+  if (layout.isDense) {
+    std::memcpy(dst, src + begin, size * sizeof(T));
+    return;
+  }
+  if (layout.isUniform) {
+    std::fill(dst, dst + size, src[0]);
+    return;
+  }
+  const auto& strides = layout.strides;
+  // general broadcast -- decompose `begin` once, then increment coordinates
+  const auto ndim = outputShape.ndim();
+  Dim offset = 0;
+  Dim remainder = begin;
+  for (int i = 0; i < ndim; i++) {
+    coords[i] = remainder % outputShape.dim(i);
+    remainder /= outputShape.dim(i);
+    offset += coords[i] * strides[i];
+  }
+  for (Dim j = 0; j < size; j++) {
+    dst[j] = src[offset];
+    for (int i = 0; i < ndim; i++) {
+      coords[i]++;
+      offset += strides[i];
+      if (coords[i] < outputShape.dim(i)) {
+        break;
+      }
+      offset -= coords[i] * strides[i];
+      coords[i] = 0;
+    }
+  }
+}
+
+} // namespace
+
+ElementwiseKernel::ElementwiseKernel(
+    std::vector<Instruction>&& instructions,
+    const Shape& outputShape,
+    std::string&& signature)
+    : instructions_(std::move(instructions)),
+      outputShape_(outputShape),
+      signature_(std::move(signature)) {
+  if (instructions_.empty() || !isBinaryOpCode(instructions_.back().opCode)) {
+    throw std::invalid_argument(
+        "[ElementwiseKernel] Last instruction must be a binary operation");
+  }
+  inputLayouts_.resize(instructions_.size());
+  for (unsigned i = 0; i < instructions_.size(); i++) {
+    const auto& instruction = instructions_[i];
+    if (isBinaryOpCode(instruction.opCode) &&
+        (instruction.lhs >= i || instruction.rhs >= i)) {
+      throw std::invalid_argument(
+          "[ElementwiseKernel] Instructions must be in topological order");
+    }
+    if (instruction.opCode == OpCode::Input) {
+      numInputs_ = std::max(numInputs_, instruction.operandIdx + 1);
+      auto& layout = inputLayouts_[i];
+      layout.strides = getBroadcastStrides(
+          instruction.shape, instruction.viewStrides, outputShape_);
+      layout.isDense = isDense(layout.strides, outputShape_);
+      layout.isUniform = isUniform(layout.strides);
+      if (!instruction.viewStrides.empty()) {
+        layout.viewIdx = numViews_++;
+      }
+    }
+  }
+}
+
+std::shared_ptr<const ElementwiseKernel> ElementwiseKernel::getOrCompile(
+    std::vector<Instruction>&& instructions,
+    const Shape& outputShape) {
+  auto signature = getSignature(instructions, outputShape);
+  auto& cache = KernelCache::getInstance();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  auto iter = cache.signatureToKernel.find(signature);
+  if (iter == cache.signatureToKernel.end()) {
+    // constructor is private, so no `std::make_shared`
+    std::shared_ptr<const ElementwiseKernel> kernel(new ElementwiseKernel(
+        std::move(instructions), outputShape, std::string(signature)));
+    iter = cache.signatureToKernel.emplace(std::move(signature), kernel).first;
+  }
+  return iter->second;
+}
+
+std::string ElementwiseKernel::getSignature(
+    const std::vector<Instruction>& instructions,
+    const Shape& outputShape) {
+  std::ostringstream oss;
+  oss << outputShape << ":";
+  for (const auto& instruction : instructions) {
+    oss << opCodeToString(instruction.opCode);
+    switch (instruction.opCode) {
+      case OpCode::Input:
+        oss << instruction.operandIdx << instruction.shape;
+        for (const auto stride : instruction.viewStrides) {
+          oss << "," << stride;
+        }
+        break;
+      case OpCode::Scalar:
+        oss << instruction.operandIdx << instruction.shape
+            << instruction.scalarType;
+        break;
+      case OpCode::Add:
+      case OpCode::Sub:
+      case OpCode::Mul:
+      case OpCode::Div:
+        oss << "(" << instruction.lhs << "," << instruction.rhs << ")";
+        break;
+    }
+    oss << ";";
+  }
+  return oss.str();
+}
+
+size_t ElementwiseKernel::numCachedKernels() {
+  auto& cache = KernelCache::getInstance();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  return cache.signatureToKernel.size();
+}
+
+void ElementwiseKernel::clearCache() {
+  auto& cache = KernelCache::getInstance();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.signatureToKernel.clear();
+}
+
+const std::string& ElementwiseKernel::signature() const {
+  return signature_;
+}
+
+const std::vector<ElementwiseKernel::Instruction>&
+ElementwiseKernel::instructions() const {
+  return instructions_;
+}
+
+std::optional<dtype> ElementwiseKernel::getHostComputeType(
+    const std::vector<const Tensor*>& inputs) const {
+  if (inputs.empty()) {
+    return std::nullopt;
+  }
+  auto type = inputs.front()->type();
+  for (const auto& instruction : instructions_) {
+    if (instruction.opCode == OpCode::Scalar) {
+      type = getTypeWithLargerRange(type, instruction.scalarType);
+    }
+  }
+  if (type != dtype::f32 && type != dtype::f64) {
+    return std::nullopt;
+  }
+  for (const auto* input : inputs) {
+    if (input->type() != type || input->location() != Location::Host ||
+        !input->isContiguous()) {
+      return std::nullopt;
+    }
+  }
+  return type;
+}
+
+template <typename T>
+void ElementwiseKernel::runOnHost(
+    T* out,
+    const std::vector<const T*>& inputs,
+    const std::vector<ScalarValue>& scalars,
+    const std::vector<InputView>& views) const {
+  const Dim numElements = outputShape_.elements();
+  const Dim numTiles = (numElements + kTileSize - 1) / kTileSize;
+  const unsigned numRegisters = instructions_.size();
+#pragma omp parallel
+  {
+    std::vector<T> registers(numRegisters * kTileSize);
+    std::vector<Dim> coords(outputShape_.ndim());
+    // scalars are the same for every tile
+    for (unsigned i = 0; i < numRegisters; i++) {
+      const auto& instruction = instructions_[i];
+      if (instruction.opCode == OpCode::Scalar) {
+        T* reg = registers.data() + i * kTileSize;
+        const auto val = castScalar<T>(scalars[instruction.operandIdx]);
+        std::fill(reg, reg + kTileSize, val);
+      }
+    }
+#pragma omp for
+    for (Dim tile = 0; tile < numTiles; tile++) {
+      const Dim begin = tile * kTileSize;
+      const Dim size = std::min(kTileSize, numElements - begin);
+      for (unsigned i = 0; i < numRegisters; i++) {
+        const auto& instruction = instructions_[i];
+        // the last instruction writes to the output directly
+        T* dst = i + 1 == numRegisters ? out + begin
+                                       : registers.data() + i * kTileSize;
+        const T* lhs = registers.data() + instruction.lhs * kTileSize;
+        const T* rhs = registers.data() + instruction.rhs * kTileSize;
+        switch (instruction.opCode) {
+          case OpCode::Input: {
+            const auto& layout = inputLayouts_[i];
+            const Dim offset =
+                layout.viewIdx < 0 ? 0 : views[layout.viewIdx].offset;
+            loadInput(
+                dst,
+                inputs[instruction.operandIdx] + offset,
+                layout,
+                outputShape_,
+                begin,
+                size,
+                coords);
+            break;
+          }
+          case OpCode::Scalar:
+            break; // already filled
+          case OpCode::Add:
+            for (Dim j = 0; j < size; j++) {
+              dst[j] = lhs[j] + rhs[j];
+            }
+            break;
+          case OpCode::Sub:
+            for (Dim j = 0; j < size; j++) {
+              dst[j] = lhs[j] - rhs[j];
+            }
+            break;
+          case OpCode::Mul:
+            for (Dim j = 0; j < size; j++) {
+              dst[j] = lhs[j] * rhs[j];
+            }
+            break;
+          case OpCode::Div:
+            for (Dim j = 0; j < size; j++) {
+              dst[j] = lhs[j] / rhs[j];
+            }
+            break;
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+Tensor ElementwiseKernel::runOnHost(
+    TensorBackend& backend,
+    const std::vector<const Tensor*>& inputs,
+    const std::vector<ScalarValue>& scalars,
+    const std::vector<InputView>& views,
+    const dtype type) const {
+  auto result = backend.full(outputShape_, 0, type);
+  result.stream().sync();
+  std::vector<const T*> inputPtrs;
+  for (const auto* input : inputs) {
+    input->stream().sync(); // make sure data is ready
+    inputPtrs.push_back(input->device<T>());
+  }
+  runOnHost(result.device<T>(), inputPtrs, scalars, views);
+  for (const auto* input : inputs) {
+    input->unlock();
+  }
+  result.unlock();
+  return result;
+}
+
+Tensor ElementwiseKernel::runWithBackend(
+    TensorBackend& backend,
+    const std::vector<const Tensor*>& inputs,
+    const std::vector<ScalarValue>& scalars,
+    const std::vector<InputView>& views) const {
+  // inputs are referenced as-is, everything else is owned by `results`
+  std::vector<const Tensor*> registers(instructions_.size(), nullptr);
+  std::vector<std::optional<Tensor>> results(instructions_.size());
+  for (unsigned i = 0; i < instructions_.size(); i++) {
+    const auto& instruction = instructions_[i];
+    const auto& shape = instruction.shape;
+    const auto type = instruction.scalarType;
+    const Tensor* lhs = registers[instruction.lhs];
+    const Tensor* rhs = registers[instruction.rhs];
+    switch (instruction.opCode) {
+      case OpCode::Input: {
+        const auto viewIdx = inputLayouts_[i].viewIdx;
+        if (viewIdx < 0) {
+          registers[i] = inputs.at(instruction.operandIdx);
+          continue;
+        }
+        results[i] = (*inputs.at(instruction.operandIdx))(
+            views.at(viewIdx).indices);
+        break;
+      }
+      case OpCode::Scalar:
+        results[i] = std::visit(
+            [&](auto&& val) { return backend.full(shape, val, type); },
+            scalars.at(instruction.operandIdx));
+        break;
+      case OpCode::Add:
+        results[i] = backend.add(*lhs, *rhs);
+        break;
+      case OpCode::Sub:
+        results[i] = backend.sub(*lhs, *rhs);
+        break;
+      case OpCode::Mul:
+        results[i] = backend.mul(*lhs, *rhs);
+        break;
+      case OpCode::Div:
+        results[i] = backend.div(*lhs, *rhs);
+        break;
+    }
+    registers[i] = &results[i].value();
+  }
+  // constructor ensures the last instruction is a binop, i.e., owned
+  return std::move(results.back().value());
+}
+
+Tensor ElementwiseKernel::run(
+    TensorBackend& backend,
+    const std::vector<const Tensor*>& inputs,
+    const std::vector<ScalarValue>& scalars,
+    const std::vector<InputView>& views) const {
+  if (inputs.size() != numInputs_) {
+    throw std::invalid_argument(
+        "[ElementwiseKernel::run] Unexpected number of inputs");
+  }
+  if (views.size() != numViews_) {
+    throw std::invalid_argument(
+        "[ElementwiseKernel::run] Unexpected number of views");
+  }
+  const auto hostComputeType = getHostComputeType(inputs);
+  if (!hostComputeType.has_value()) {
+    return runWithBackend(backend, inputs, scalars, views);
+  }
+  switch (hostComputeType.value()) {
+    case dtype::f32:
+      return runOnHost<float>(backend, inputs, scalars, views, dtype::f32);
+    case dtype::f64:
+      return runOnHost<double>(backend, inputs, scalars, views, dtype::f64);
+    default:
+      return runWithBackend(backend, inputs, scalars, views);
+  }
+}
+
+} // namespace fl
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/Shape.h"
+#include "flashlight/fl/tensor/TensorBackend.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/Types.h"
+
+namespace fl {
+
+/**
+ * A fused kernel for a connected elementwise subgraph.
+ *
+ * The subgraph is linearized into SSA instructions over virtual registers,
+ * i.e., the result of `instructions[i]` lives in register `i`. Executing the
+ * kernel makes a single pass over the output, computing every instruction
+ * tile by tile (tiles are small enough to stay in cache, and the per-tile
+ * loops are trivially vectorizable).
+ *
+ * Kernels only depend on the structure of the subgraph (ops, shapes), not on
+ * the value of its scalars or leaf tensors, so they are compiled once per
+ * signature and cached; scalar values are passed in at execution time.
+ *
+ * An `Input` can also read a strided view (e.g., a slice) of its tensor in
+ * place, rather than a materialized copy. Only the strides of the view are
+ * part of the signature; where the view starts is passed in at execution
+ * time, so sliding a window over a tensor reuses the same kernel.
+ */
+class ElementwiseKernel {
+ public:
+  enum class OpCode { Input, Scalar, Add, Sub, Mul, Div };
+
+  // these types can hold all types scalars FL support, w/o loss of precision
+  using ScalarValue = std::variant<long long, double, unsigned long long>;
+
+  struct Instruction {
+    OpCode opCode;
+    // register indices, only used by binary operations
+    unsigned lhs{0};
+    unsigned rhs{0};
+    // index into the tensor inputs for `Input`, or into the scalar values for
+    // `Scalar`
+    unsigned operandIdx{0};
+    // shape of the result of this instruction (before broadcasting)
+    Shape shape;
+    // type of the scalar, only used by `Scalar`
+    dtype scalarType{dtype::f32};
+    // only used by `Input` that reads a view of its (contiguous) tensor --
+    // stride (in elements) of the tensor's buffer along each dimension of
+    // `shape`. Empty if the input is read as a whole.
+    std::vector<Dim> viewStrides{};
+  };
+
+  // where a view read by an `Input` starts, and how to materialize it (for
+  // when we can't read it in place)
+  struct InputView {
+    // offset (in elements) of the view's first element in the tensor's buffer
+    Dim offset{0};
+    std::vector<Index> indices;
+  };
+
+  // how an `Input` instruction maps the output index space to its tensor
+  struct InputLayout {
+    // strides w.r.t. the output index space (0 along broadcasted dimensions)
+    std::vector<Dim> strides;
+    // no broadcasting, i.e., output index == input index
+    bool isDense{false};
+    // broadcasted along all dimensions, i.e., a single element
+    bool isUniform{false};
+    // index into the `InputView`s passed at execution time, -1 if the input
+    // isn't a view
+    int viewIdx{-1};
+  };
+
+ private:
+  const std::vector<Instruction> instructions_;
+  const Shape outputShape_;
+  const std::string signature_;
+  unsigned numInputs_{0};
+  unsigned numViews_{0};
+  // layout of each `Input` instruction (unused for other instructions)
+  std::vector<InputLayout> inputLayouts_;
+
+  ElementwiseKernel(
+      std::vector<Instruction>&& instructions,
+      const Shape& outputShape,
+      std::string&& signature);
+
+  // returns the result type, or nullopt if the host loop can't handle inputs
+  std::optional<dtype> getHostComputeType(
+      const std::vector<const Tensor*>& inputs) const;
+
+  template <typename T>
+  void runOnHost(
+      T* out,
+      const std::vector<const T*>& inputs,
+      const std::vector<ScalarValue>& scalars,
+      const std::vector<InputView>& views) const;
+
+  template <typename T>
+  Tensor runOnHost(
+      TensorBackend& backend,
+      const std::vector<const Tensor*>& inputs,
+      const std::vector<ScalarValue>& scalars,
+      const std::vector<InputView>& views,
+      const dtype type) const;
+
+  // evaluate instruction by instruction via the given backend
+  Tensor runWithBackend(
+      TensorBackend& backend,
+      const std::vector<const Tensor*>& inputs,
+      const std::vector<ScalarValue>& scalars,
+      const std::vector<InputView>& views) const;
+
+ public:
+  /**
+   * Get the kernel for the given instructions from the kernel cache, compile
+   * and cache one if none exists yet.
+   *
+   * @param[in] instructions the SSA instructions, with the last instruction
+   * producing the kernel output.
+   * @param[in] outputShape the shape of the kernel output.
+   * @return the compiled kernel.
+   */
+  static std::shared_ptr<const ElementwiseKernel> getOrCompile(
+      std::vector<Instruction>&& instructions,
+      const Shape& outputShape);
+
+  /**
+   * Build a signature that uniquely identifies the kernel structure.
+   */
+  static std::string getSignature(
+      const std::vector<Instruction>& instructions,
+      const Shape& outputShape);
+
+  /**
+   * Number of kernels currently in the kernel cache.
+   */
+  static size_t numCachedKernels();
+
+  /**
+   * Remove all kernels from the kernel cache.
+   */
+  static void clearCache();
+
+  const std::string& signature() const;
+  const std::vector<Instruction>& instructions() const;
+
+  /**
+   * Execute the kernel.
+   *
+   * Uses the fused host loop if all inputs live on host, are contiguous, and
+   * share a floating point type; otherwise falls back to dispatching each
+   * instruction to `backend`, which yields identical results.
+   *
+   * @param[in] backend the backend used to allocate output/fallback compute.
+   * @param[in] inputs the input tensors, indexed by `Instruction::operandIdx`.
+   * @param[in] scalars the scalar values, indexed by `Instruction::operandIdx`.
+   * @param[in] views the views read by `Input` instructions with
+   * `viewStrides`, in instruction order.
+   * @return the output tensor.
+   */
+  Tensor run(
+      TensorBackend& backend,
+      const std::vector<const Tensor*>& inputs,
+      const std::vector<ScalarValue>& scalars,
+      const std::vector<InputView>& views = {}) const;
+};
+
+} // namespace fl
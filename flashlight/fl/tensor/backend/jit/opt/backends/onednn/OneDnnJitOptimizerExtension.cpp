@@ -7,6 +7,7 @@
 
 #include "flashlight/fl/tensor/backend/jit/opt/backends/onednn/OneDnnJitOptimizerExtension.h"
 
+#include "flashlight/fl/tensor/backend/jit/opt/backends/cpu/CpuElementwiseFusion.h"
 #include "flashlight/fl/tensor/backend/jit/opt/backends/onednn/OneDnnOpFusion.h"
 #include "flashlight/fl/tensor/backend/onednn/OneDnnBackend.h"
 
@@ -14,6 +15,10 @@ namespace fl {
 
 std::vector<std::unique_ptr<Pass>> OneDnnJitOptimizerExtension::passes() {
   std::vector<std::unique_ptr<Pass>> passes;
+  // fuses f32/f64 elementwise chains into a single host loop, whatever it
+  // leaves behind can still benefit from OneDNN post-ops
+  passes.emplace_back(
+      std::make_unique<CpuElementwiseFusion>(OneDnnBackend::getInstance()));
   passes.emplace_back(std::make_unique<OneDnnOpFusion>());
   return passes;
 }
@@ -7,8 +7,12 @@
 
 #include "flashlight/fl/tensor/backend/jit/opt/backends/onednn/OneDnnOpFusion.h"
 
+#include <optional>
+
 #include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/CustomNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/MatmulNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
 #include "flashlight/fl/tensor/backend/onednn/OneDnnBackend.h"
 #include "flashlight/fl/tensor/backend/onednn/OneDnnTensor.h"
 #include "flashlight/fl/tensor/backend/onednn/Utils.h"
@@ -17,9 +21,17 @@
 
 namespace fl {
 
-struct BinopInfo {
-  Node* rhsNode;
-  BinaryOp op;
+struct PostOpInfo {
+  // the node this op comes from
+  Node* node;
+  dnnl::algorithm alg;
+  // index of the input of `node` the chain continues from
+  unsigned chainInputIdx;
+  // the other input of a binary op, nullptr for eltwise op
+  Node* rhsNode{nullptr};
+  // parameters of eltwise op
+  float alpha{0};
+  float beta{0};
 };
 
 struct OneDnnOpFusion::SearchState {
@@ -32,8 +44,8 @@ struct OneDnnOpFusion::SearchState {
   //     \  /
   //    binop2
   //
-  // accumulatedBinopInfos: { { binop2->op(), x2 }, { binop1->op(), x1 } }
-  std::vector<BinopInfo> accumulatedBinopInfos;
+  // accumulatedPostOpInfos: { { binop2, x2 }, { binop1, x1 } }
+  std::vector<PostOpInfo> accumulatedPostOpInfos;
 };
 
 namespace {
@@ -41,6 +53,20 @@ namespace {
 // https://github.com/oneapi-src/oneDNN/blob/adeda9fcc20149effb1bffc051262810e9f3138c/include/oneapi/dnnl/dnnl_types.h#L2914
 static constexpr unsigned kOneDnnMaxNumPostOps = 32;
 
+// What gets captured by the evaluation logic of a fused node
+struct OneDnnPostOp {
+  dnnl::algorithm alg;
+  bool isBinary;
+  float alpha;
+  float beta;
+};
+
+struct EltwiseInfo {
+  dnnl::algorithm alg;
+  float alpha;
+  float beta;
+};
+
 dnnl::memory::data_type getOneDnnTypeWithLargestRange(
     const std::vector<const Tensor*>& tensors) {
   dnnl::memory::data_type largestType =
@@ -66,6 +92,30 @@ dnnl::algorithm binopToOneDnnAlg(const BinaryOp op) {
   throw std::runtime_error("Unsupported binary operation type");
 }
 
+// dst = alpha * alg(src) + beta, for the algorithms used here
+std::optional<EltwiseInfo> unaryOpToOneDnnEltwise(const UnaryOp op) {
+  switch (op) {
+    case UnaryOp::Exp:
+      return EltwiseInfo{dnnl::algorithm::eltwise_exp, 0, 0};
+    case UnaryOp::Log:
+      return EltwiseInfo{dnnl::algorithm::eltwise_log, 0, 0};
+    case UnaryOp::Negative:
+      return EltwiseInfo{dnnl::algorithm::eltwise_linear, -1, 0};
+    case UnaryOp::Sqrt:
+      return EltwiseInfo{dnnl::algorithm::eltwise_sqrt, 0, 0};
+    case UnaryOp::Tanh:
+      return EltwiseInfo{dnnl::algorithm::eltwise_tanh, 0, 0};
+    case UnaryOp::Rint:
+      return EltwiseInfo{dnnl::algorithm::eltwise_round, 0, 0};
+    case UnaryOp::Absolute:
+      return EltwiseInfo{dnnl::algorithm::eltwise_abs, 0, 0};
+    case UnaryOp::Sigmoid:
+      return EltwiseInfo{dnnl::algorithm::eltwise_logistic, 0, 0};
+    default:
+      return std::nullopt;
+  }
+}
+
 bool isOpFusable(const BinaryOp op) {
   switch (op) {
     case BinaryOp::Add:
@@ -77,8 +127,18 @@ bool isOpFusable(const BinaryOp op) {
   throw std::runtime_error("Unsupported binary operation type");
 }
 
+bool isOpCommutative(const BinaryOp op) {
+  return op == BinaryOp::Add || op == BinaryOp::Mul;
+}
+
 bool isNodeFusable(const Node* node) {
-  return node->isBinary() && isOpFusable(node->impl<BinaryNode>().op());
+  if (node->isBinary()) {
+    return isOpFusable(node->impl<BinaryNode>().op());
+  }
+  if (node->isUnary()) {
+    return unaryOpToOneDnnEltwise(node->impl<UnaryNode>().op()).has_value();
+  }
+  return false;
 }
 
 bool isFusionProfitable(const Node* node) {
@@ -91,52 +151,244 @@ bool shouldNodeBeFused(const Node* node) {
   return isNodeFusable(node) && isFusionProfitable(node);
 }
 
+// matmul that can serve as the primitive of an op-chain
+bool canAnchorChain(const Node* node) {
+  if (!node->isMatmul() || !isFusionProfitable(node)) {
+    return false;
+  }
+  // vectors are padded & flattened by OneDnnBackend::matmul, leave them be
+  const auto& matmulNode = node->impl<MatmulNode>();
+  return matmulNode.lhs()->shape().ndim() >= 2 &&
+      matmulNode.rhs()->shape().ndim() >= 2;
+}
+
+// Append `postOps` to a primitive; the binary ones consume `inputs` from
+// `inputIdx` onwards.
+dnnl::post_ops createOneDnnPostOps(
+    const std::vector<OneDnnPostOp>& postOps,
+    const std::vector<const Tensor*>& inputs,
+    unsigned inputIdx,
+    std::unordered_map<int, dnnl::memory>& args) {
+  dnnl::post_ops oneDnnPostOps;
+  for (unsigned i = 0; i < postOps.size(); i++) {
+    const auto& postOp = postOps[i];
+    if (!postOp.isBinary) {
+      oneDnnPostOps.append_eltwise(
+          /* scale = */ 1, postOp.alg, postOp.alpha, postOp.beta);
+      continue;
+    }
+    // set up the other input for post-op
+    auto& otherMem = toOneDnnTensor(*inputs[inputIdx++]).memory();
+    oneDnnPostOps.append_binary(postOp.alg, otherMem.get_desc());
+    args.insert( // DNNL_ARG_SRC_1 feels totally arbitrary...
+        {DNNL_ARG_ATTR_MULTIPLE_POST_OP(i) | DNNL_ARG_SRC_1, otherMem});
+  }
+  return oneDnnPostOps;
+}
+
+Tensor evalFusedBinaryOp(
+    dnnl::algorithm alg,
+    const std::vector<OneDnnPostOp>& postOps,
+    const Shape& dstShape,
+    const std::vector<const Tensor*>& inputs) {
+  const Tensor* lhs = inputs[0];
+  const Tensor* rhs = inputs[1];
+  // NOTE this simulates OneDNNBackend's "typing rule". Once we support type
+  // inference in JIT we can get rid of this.
+  const auto dstType = getOneDnnTypeWithLargestRange(inputs);
+
+  auto& backend = OneDnnBackend::getInstance();
+  auto& engine = backend.engine();
+
+  // prepare memories
+  auto& lhsMem = toOneDnnTensor(*lhs).memory();
+  auto& rhsMem = toOneDnnTensor(*rhs).memory();
+  const auto lhsMemDesc = lhsMem.get_desc();
+  const auto rhsMemDesc = rhsMem.get_desc();
+  const auto dstMemDesc =
+      detail::oneDnnContiguousMemDescFromShape(dstShape, dstType);
+  auto dstMem = dnnl::memory(dstMemDesc, engine);
+
+  // prepare part of primitive
+  const dnnl::binary::desc binaryDesc(alg, lhsMemDesc, rhsMemDesc, dstMemDesc);
+
+  // prepare arguments
+  std::unordered_map<int, dnnl::memory> args = {
+      {DNNL_ARG_SRC_0, lhsMem},
+      {DNNL_ARG_SRC_1, rhsMem},
+      {DNNL_ARG_DST, dstMem},
+  };
+
+  // finish building primitive
+  dnnl::primitive_attr binaryAttr;
+  binaryAttr.set_post_ops(
+      createOneDnnPostOps(postOps, inputs, /* inputIdx = */ 2, args));
+  const auto binaryPrimtiveDesc =
+      dnnl::binary::primitive_desc(binaryDesc, binaryAttr, engine);
+  const auto binaryPrimitive = dnnl::binary(binaryPrimtiveDesc);
+
+  // execute primitive
+  binaryPrimitive.execute(backend.nativeStream(), args);
+  return toTensor<OneDnnTensor>(dstShape, std::move(dstMem));
+}
+
+Tensor evalFusedMatmul(
+    MatrixProperty lhsProp,
+    MatrixProperty rhsProp,
+    const std::vector<OneDnnPostOp>& postOps,
+    const Shape& dstShape,
+    const std::vector<const Tensor*>& inputs) {
+  auto& lhsTensor = toOneDnnTensor(*inputs[0]);
+  auto& rhsTensor = toOneDnnTensor(*inputs[1]);
+  // NOTE this simulates OneDNNBackend's "typing rule" too.
+  const auto dstType = getOneDnnTypeWithLargestRange(inputs);
+
+  auto& backend = OneDnnBackend::getInstance();
+  auto& engine = backend.engine();
+
+  // prepare memories
+  auto lhsMem = lhsTensor.memory();
+  auto rhsMem = rhsTensor.memory();
+  auto lhsMemDesc = lhsTensor.memoryDesc();
+  auto rhsMemDesc = rhsTensor.memoryDesc();
+  if (lhsProp == MatrixProperty::Transpose) {
+    lhsMemDesc = detail::transposeInnerMatrix(lhsMemDesc);
+  }
+  if (rhsProp == MatrixProperty::Transpose) {
+    rhsMemDesc = detail::transposeInnerMatrix(rhsMemDesc);
+  }
+  const auto dstMemDesc =
+      detail::oneDnnContiguousMemDescFromShape(dstShape, dstType);
+  auto dstMem = dnnl::memory(dstMemDesc, engine);
+
+  // NOTE lhs/rhs are switched, see OneDnnBackend::matmul
+  std::unordered_map<int, dnnl::memory> args = {
+      {DNNL_ARG_SRC, rhsMem},
+      {DNNL_ARG_WEIGHTS, lhsMem},
+      {DNNL_ARG_DST, dstMem},
+  };
+
+  // build primitive
+  dnnl::primitive_attr matmulAttr;
+  matmulAttr.set_post_ops(
+      createOneDnnPostOps(postOps, inputs, /* inputIdx = */ 2, args));
+  const auto matmulDesc =
+      dnnl::matmul::desc(rhsMemDesc, lhsMemDesc, dstMemDesc);
+  const auto matmulPrimitiveDesc =
+      dnnl::matmul::primitive_desc(matmulDesc, matmulAttr, engine);
+  const auto matmulPrimitive = dnnl::matmul(matmulPrimitiveDesc);
+
+  // execute primitive
+  matmulPrimitive.execute(backend.nativeStream(), args);
+  return toTensor<OneDnnTensor>(dstShape, std::move(dstMem));
+}
+
 } // namespace
 
 Node* OneDnnOpFusion::rewriteFrom(Node* node) {
-  SearchState state{.searchRoot = node, .accumulatedBinopInfos = {}};
+  SearchState state{.searchRoot = node, .accumulatedPostOpInfos = {}};
   auto fusedNode = searchAndFuse(node, state);
   node->replaceAllUsesWith(fusedNode);
   return fusedNode;
 }
 
+bool OneDnnOpFusion::canExtendChain(const Node* node, const Node* input)
+    const {
+  if (visited_.find(const_cast<Node*>(input)) != visited_.end() ||
+      input->shape() != node->shape()) {
+    return false;
+  }
+  return shouldNodeBeFused(input) || canAnchorChain(input);
+}
+
 Node* OneDnnOpFusion::searchAndFuse(Node* node, SearchState& state) {
+  // The search root itself may be shared, since the fused node replaces all
+  // of its uses.
   // TODO for now we just skip shared input, need to think more.
-  if (visited_.find(node) != visited_.end() || !shouldNodeBeFused(node) ||
-      state.accumulatedBinopInfos.size() > kOneDnnMaxNumPostOps) {
+  const bool isSearchRoot = node == state.searchRoot;
+  if (visited_.find(node) != visited_.end() || !isNodeFusable(node) ||
+      (!isSearchRoot && !isFusionProfitable(node)) ||
+      node->shape() != state.searchRoot->shape() ||
+      state.accumulatedPostOpInfos.size() >= kOneDnnMaxNumPostOps) {
     return fuseNodes(node, state);
   }
   visited_.insert(node);
 
   if (node->isBinary()) {
     const auto& binaryNode = node->impl<BinaryNode>();
-    const auto lhs = binaryNode.lhs();
-    const auto rhs = binaryNode.rhs();
     const auto op = binaryNode.op();
-    state.accumulatedBinopInfos.push_back({rewriteFrom(rhs), op});
-    return searchAndFuse(lhs, state);
+    // binary post-op only takes rhs argument, so we go down lhs unless we can
+    // commute and only rhs continues the chain.
+    unsigned chainInputIdx = 0;
+    if (isOpCommutative(op) &&
+        !canExtendChain(node, binaryNode.lhs()) &&
+        canExtendChain(node, binaryNode.rhs())) {
+      chainInputIdx = 1;
+    }
+    const auto otherInput = node->inputs().at(1 - chainInputIdx);
+    state.accumulatedPostOpInfos.push_back(
+        {node, binopToOneDnnAlg(op), chainInputIdx, rewriteFrom(otherInput)});
+    // `node`'s inputs might've been replaced during the rewrite
+    return searchAndFuse(node->inputs().at(chainInputIdx), state);
+  } else if (node->isUnary()) {
+    const auto& unaryNode = node->impl<UnaryNode>();
+    const auto eltwise = unaryOpToOneDnnEltwise(unaryNode.op()).value();
+    state.accumulatedPostOpInfos.push_back(
+        {node, eltwise.alg, 0, nullptr, eltwise.alpha, eltwise.beta});
+    return searchAndFuse(unaryNode.input(), state);
   } else {
     // TODO support more fusion for more kinds of op (e.g., reduction)
     throw std::runtime_error(
-        "[OneDnnOpFusion::rewriteFrom] If node should be fused, it must be binary node");
+        "[OneDnnOpFusion::searchAndFuse] Fused node must be binary or unary");
   }
 }
 
 Node* OneDnnOpFusion::fuseNodes(Node* node, SearchState& state) {
-  for (const auto& input : node->inputs()) {
-    rewriteFrom(input);
+  auto& infos = state.accumulatedPostOpInfos;
+  const auto& dstShape = state.searchRoot->shape();
+  // Nothing to fuse, `node` is the search root
+  if (infos.empty()) {
+    for (const auto& input : node->inputs()) {
+      rewriteFrom(input);
+    }
+    return node;
+  }
+
+  Node* base = nullptr;
+  const bool isMatmulAnchored = visited_.find(node) == visited_.end() &&
+      canAnchorChain(node) && node->shape() == dstShape;
+  if (isMatmulAnchored) {
+    visited_.insert(node);
+    for (const auto& input : node->inputs()) {
+      rewriteFrom(input);
+    }
+    base = node;
+  } else {
+    rewriteFrom(node);
+    // `node` might've been replaced
+    base = infos.back().node->inputs().at(infos.back().chainInputIdx);
+    // The binary primitive must start with a binary op whose inputs have the
+    // output shape; other ops stay outside the fused node.
+    // e.g., for `add(tanh(x), y)`, `tanh` stays outside (and so nothing is
+    // fused)
+    while (!infos.empty() &&
+           (infos.back().rhsNode == nullptr || base->shape() != dstShape)) {
+      base = infos.back().node;
+      infos.pop_back();
+    }
   }
+
   // Nothing to fuse, it's one of the following:
-  // 1. node
+  // 1. base
   //
-  // 2. node  ...
+  // 2. base  ...
   //      \  /
   //    searchRoot
-  if (state.accumulatedBinopInfos.size() < 2) {
+  if (infos.size() < (isMatmulAnchored ? 1 : 2)) {
     return state.searchRoot;
   }
 
-  // In the following case `node` is `x1`
+  // In the following case `base` is `x1`
   //
   // x1  x2
   //  \  /
@@ -145,75 +397,49 @@ Node* OneDnnOpFusion::fuseNodes(Node* node, SearchState& state) {
   //     op2
   // becomes
   // inputNodes: { x1, x2, x3 }
-  // algs:       { op1, op2 }
-  std::vector<Node*> inputNodes{node};
-  std::vector<dnnl::algorithm> algs;
-  for (int i = state.accumulatedBinopInfos.size() - 1; i >= 0; i--) {
-    const auto& info = state.accumulatedBinopInfos[i];
-    algs.push_back(binopToOneDnnAlg(info.op));
-    inputNodes.push_back(info.rhsNode);
+  // postOps:    { op1, op2 }
+  std::vector<Node*> inputNodes;
+  std::vector<OneDnnPostOp> postOps;
+  if (isMatmulAnchored) {
+    const auto& matmulNode = base->impl<MatmulNode>();
+    inputNodes = {matmulNode.lhs(), matmulNode.rhs()};
+  } else {
+    inputNodes = {base};
+  }
+  for (int i = infos.size() - 1; i >= 0; i--) {
+    const auto& info = infos[i];
+    const bool isBinary = info.rhsNode != nullptr;
+    postOps.push_back({info.alg, isBinary, info.alpha, info.beta});
+    if (isBinary) {
+      inputNodes.push_back(info.rhsNode);
+    }
   }
 
   // TODO refactor with common logic in OneDnnBackend
-  auto evalFunc = [algs = std::move(algs),
-                   dstShape = state.searchRoot->shape()](
-                      const std::vector<const Tensor*>& inputs) {
-    const Tensor* lhs = inputs[0];
-    const Tensor* rhs = inputs[1];
-    // NOTE this simulates OneDNNBackend's "typing rule". Once we support type
-    // inference in JIT we can get rid of this.
-    const auto dstType = getOneDnnTypeWithLargestRange(inputs);
-
-    auto& backend = OneDnnBackend::getInstance();
-    auto& engine = backend.engine();
-
-    // prepare memories
-    dnnl::algorithm alg = algs.front();
-    auto& lhsMem = toOneDnnTensor(*lhs).memory();
-    auto& rhsMem = toOneDnnTensor(*rhs).memory();
-    const auto lhsMemDesc = lhsMem.get_desc();
-    const auto rhsMemDesc = rhsMem.get_desc();
-    const auto dstMemDesc =
-        detail::oneDnnContiguousMemDescFromShape(dstShape, dstType);
-    auto dstMem = dnnl::memory(dstMemDesc, engine);
-
-    // prepare part of primitive
-    const dnnl::binary::desc binaryDesc(
-        alg, lhsMemDesc, rhsMemDesc, dstMemDesc);
-
-    // prepare part of arguments
-    std::unordered_map<int, dnnl::memory> args = {
-        {DNNL_ARG_SRC_0, lhsMem},
-        {DNNL_ARG_SRC_1, rhsMem},
-        {DNNL_ARG_DST, dstMem},
+  if (isMatmulAnchored) {
+    const auto& matmulNode = base->impl<MatmulNode>();
+    auto evalFunc = [lhsProp = matmulNode.lhsProp(),
+                     rhsProp = matmulNode.rhsProp(),
+                     postOps = std::move(postOps),
+                     dstShape](const std::vector<const Tensor*>& inputs) {
+      return evalFusedMatmul(lhsProp, rhsProp, postOps, dstShape, inputs);
     };
-
-    // prepare post ops
-    dnnl::post_ops binops;
-    for (unsigned i = 1; i < algs.size(); i++) {
-      // set up the other input for post-op
-      auto& otherMem = toOneDnnTensor(*inputs[i + 1]).memory();
-      binops.append_binary(algs[i], otherMem.get_desc());
-      args.insert( // DNNL_ARG_SRC_1 feels totally arbitrary...
-          {DNNL_ARG_ATTR_MULTIPLE_POST_OP(i - 1) | DNNL_ARG_SRC_1, otherMem});
-    }
-
-    // finish building primitive
-    dnnl::primitive_attr binaryAttr;
-    binaryAttr.set_post_ops(binops);
-    const auto binaryPrimtiveDesc =
-        dnnl::binary::primitive_desc(binaryDesc, binaryAttr, engine);
-    const auto binaryPrimitive = dnnl::binary(binaryPrimtiveDesc);
-
-    // execute primitive
-    binaryPrimitive.execute(backend.nativeStream(), args);
-    return toTensor<OneDnnTensor>(dstShape, std::move(dstMem));
+    return CustomNode::create(
+        "OneDnnFusedMatmul",
+        std::move(inputNodes),
+        dstShape,
+        std::move(evalFunc));
+  }
+  const auto alg = postOps.front().alg;
+  postOps.erase(postOps.begin());
+  auto evalFunc = [alg, postOps = std::move(postOps), dstShape](
+                      const std::vector<const Tensor*>& inputs) {
+    return evalFusedBinaryOp(alg, postOps, dstShape, inputs);
   };
-
   return CustomNode::create(
       "OneDnnFusedBinaryOp",
       std::move(inputNodes),
-      node->shape(),
+      dstShape,
       std::move(evalFunc));
 }
 
@@ -223,4 +449,8 @@ Node* OneDnnOpFusion::apply(Node* root) {
   return optimizedRoot;
 }
 
+std::string OneDnnOpFusion::name() const {
+  return "OneDnnOpFusion";
+}
+
 } // namespace fl
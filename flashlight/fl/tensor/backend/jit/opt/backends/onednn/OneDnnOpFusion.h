@@ -20,11 +20,14 @@ namespace fl {
  * Levearge OneDNN's post-ops to fuse operations.
  *
  * NOTE
- * 1. due to OneDNN limitation, binary post-op only supports rhs argument.
+ * 1. due to OneDNN limitation, binary post-op only supports rhs argument, so
+ *    we follow the lhs of each binop, or the rhs if the binop is commutative
+ *    and only rhs continues the chain.
  * 2. currently we avoid recomputation -- fuse iff intermediate nodes are _only_
  *    used as input nodes in the chain. There might be places where benefit of
  *    aggressive fusion outweighs cost of recomputation, need to investigate
  *    more (think Halide).
+ * 3. unary ops with a OneDNN eltwise counterpart become eltwise post-ops.
  *
  * n1   n2
  *  \  /
@@ -41,10 +44,11 @@ namespace fl {
  * | n1 = n2 + n3 |
  * ----------------
  *
+ * A chain can also be anchored on a matmul, e.g., `tanh(matmul(x, w) + b) + r`
+ * becomes a single OneDNN matmul primitive with post-ops.
+ *
  * TODO
- * - leverage commutativity of certain binops to bypass the rhs-only limitation
- *   of OneDNN binary post-ops.
- * - support more than just binop fusion
+ * - anchor on convolution once the JIT IR has a node for it.
  */
 class OneDnnOpFusion : public Pass {
   struct SearchState;
@@ -62,11 +66,15 @@ class OneDnnOpFusion : public Pass {
   // Actual fusion of an op-chain, `node` is a leaf input.
   Node* fuseNodes(Node* node, SearchState& state);
 
+  // whether the op-chain can extend from `node` to its input `input`
+  bool canExtendChain(const Node* node, const Node* input) const;
+
  public:
   OneDnnOpFusion() = default;
   ~OneDnnOpFusion() = default;
 
   Node* apply(Node* root) override;
+  std::string name() const override;
 };
 
 } // namespace fl
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/backend/jit/opt/passes/CommonSubexpressionElimination.h"
+
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/MatmulNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ReductionNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
+
+namespace fl {
+
+namespace {
+
+void hashCombine(std::size_t& seed, std::size_t value) {
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+bool isScalarEqual(const ScalarNode& lhs, const ScalarNode& rhs) {
+  if (lhs.dataType() != rhs.dataType()) {
+    return false;
+  }
+  switch (lhs.dataType()) {
+    case dtype::f16:
+    case dtype::bf16:
+    case dtype::f32:
+    case dtype::f64:
+      return lhs.scalar<double>() == rhs.scalar<double>();
+    case dtype::b8:
+    case dtype::s16:
+    case dtype::s32:
+    case dtype::s64:
+    case dtype::u8:
+    case dtype::u16:
+    case dtype::u32:
+      return lhs.scalar<long long>() == rhs.scalar<long long>();
+    case dtype::u64:
+      return lhs.scalar<unsigned long long>() ==
+          rhs.scalar<unsigned long long>();
+  }
+  throw std::runtime_error("[isScalarEqual] Unknown data type");
+}
+
+bool isReductionEqual(const ReductionNode& lhs, const ReductionNode& rhs) {
+  return lhs.op() == rhs.op() && lhs.axes() == rhs.axes() &&
+      lhs.keepDims() == rhs.keepDims();
+}
+
+bool isMatmulEqual(const MatmulNode& lhs, const MatmulNode& rhs) {
+  return lhs.lhsProp() == rhs.lhsProp() && lhs.rhsProp() == rhs.rhsProp();
+}
+
+bool isNodeMergeable(const Node* node) {
+  switch (node->type()) {
+    case NodeType::Binary:
+    case NodeType::Matmul:
+    case NodeType::Reduction:
+    case NodeType::Scalar:
+    case NodeType::Unary:
+      return true;
+    // TODO support IndexNode once `Index` supports equality checks
+    case NodeType::Custom:
+    case NodeType::Index:
+    case NodeType::Value:
+      return false;
+  }
+  throw std::runtime_error("[isNodeMergeable] Unknown node type");
+}
+
+// ASSUME both nodes are mergeable
+bool isNodeEqual(const Node* lhs, const Node* rhs) {
+  if (lhs->type() != rhs->type() || lhs->shape() != rhs->shape() ||
+      lhs->inputs() != rhs->inputs()) {
+    return false;
+  }
+  switch (lhs->type()) {
+    case NodeType::Binary:
+      return lhs->impl<BinaryNode>().op() == rhs->impl<BinaryNode>().op();
+    case NodeType::Matmul:
+      return isMatmulEqual(lhs->impl<MatmulNode>(), rhs->impl<MatmulNode>());
+    case NodeType::Reduction:
+      return isReductionEqual(
+          lhs->impl<ReductionNode>(), rhs->impl<ReductionNode>());
+    case NodeType::Scalar:
+      return isScalarEqual(lhs->impl<ScalarNode>(), rhs->impl<ScalarNode>());
+    case NodeType::Unary:
+      return lhs->impl<UnaryNode>().op() == rhs->impl<UnaryNode>().op();
+    case NodeType::Custom:
+    case NodeType::Index:
+    case NodeType::Value:
+      return false;
+  }
+  throw std::runtime_error("[isNodeEqual] Unknown node type");
+}
+
+// ASSUME node is mergeable
+std::size_t hashNode(const Node* node) {
+  std::size_t seed = std::hash<int>()(static_cast<int>(node->type()));
+  for (const auto dim : node->shape().get()) {
+    hashCombine(seed, std::hash<Dim>()(dim));
+  }
+  for (const auto input : node->inputs()) {
+    hashCombine(seed, std::hash<const Node*>()(input));
+  }
+  switch (node->type()) {
+    case NodeType::Binary: {
+      const auto op = node->impl<BinaryNode>().op();
+      hashCombine(seed, std::hash<int>()(static_cast<int>(op)));
+      break;
+    }
+    case NodeType::Scalar: {
+      const auto& scalarNode = node->impl<ScalarNode>();
+      hashCombine(
+          seed, std::hash<int>()(static_cast<int>(scalarNode.dataType())));
+      hashCombine(seed, std::hash<double>()(scalarNode.scalar<double>()));
+      break;
+    }
+    case NodeType::Matmul: {
+      const auto& matmulNode = node->impl<MatmulNode>();
+      const auto lhsProp = static_cast<int>(matmulNode.lhsProp());
+      const auto rhsProp = static_cast<int>(matmulNode.rhsProp());
+      hashCombine(seed, std::hash<int>()(lhsProp));
+      hashCombine(seed, std::hash<int>()(rhsProp));
+      break;
+    }
+    case NodeType::Reduction: {
+      // axes & keepDims are implied by input & output shapes in most cases
+      const auto op = node->impl<ReductionNode>().op();
+      hashCombine(seed, std::hash<int>()(static_cast<int>(op)));
+      break;
+    }
+    case NodeType::Unary: {
+      const auto op = node->impl<UnaryNode>().op();
+      hashCombine(seed, std::hash<int>()(static_cast<int>(op)));
+      break;
+    }
+    case NodeType::Custom:
+    case NodeType::Index:
+    case NodeType::Value:
+      break;
+  }
+  return seed;
+}
+
+class Deduplicator {
+  // nodes that have been visited and kept in the tree
+  std::unordered_set<Node*> visited_{};
+  // hash -> canonical nodes with that hash
+  std::unordered_multimap<std::size_t, Node*> hashToCanonicalNodes_{};
+
+  Node* findCanonicalNode(Node* node, std::size_t hash) const {
+    const auto [begin, end] = hashToCanonicalNodes_.equal_range(hash);
+    for (auto iter = begin; iter != end; iter++) {
+      if (isNodeEqual(iter->second, node)) {
+        return iter->second;
+      }
+    }
+    return nullptr;
+  }
+
+ public:
+  void dedup(Node* node) {
+    if (visited_.find(node) != visited_.end()) {
+      return;
+    }
+    // inputs are deduplicated first so that duplicate nodes end up sharing the
+    // exact same inputs
+    for (const auto& input : node->inputs()) {
+      dedup(input);
+    }
+    visited_.insert(node);
+    if (!isNodeMergeable(node)) {
+      return;
+    }
+    const auto hash = hashNode(node);
+    const auto canonicalNode = findCanonicalNode(node, hash);
+    if (canonicalNode == nullptr) {
+      hashToCanonicalNodes_.emplace(hash, node);
+      return;
+    }
+    // `node` may get deleted when its last user switches to `canonicalNode`,
+    // so we forget about it.
+    visited_.erase(node);
+    node->replaceAllUsesWith(canonicalNode);
+  }
+};
+
+} // namespace
+
+Node* CommonSubexpressionElimination::apply(Node* node) {
+  // The root can't be a duplicate of any node in its own tree, since that
+  // would require them to share inputs (i.e., a cycle).
+  Deduplicator().dedup(node);
+  return node;
+}
+
+std::string CommonSubexpressionElimination::name() const {
+  return "CommonSubexpressionElimination";
+}
+
+} // namespace fl
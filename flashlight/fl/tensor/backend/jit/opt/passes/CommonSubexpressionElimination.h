@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "flashlight/fl/tensor/backend/jit/opt/Pass.h"
+
+namespace fl {
+
+/**
+ * An optimization pass that merges structurally identical nodes inside a JIT
+ * tree, e.g., in `(x * 2) + (x * 2)` the two `x * 2` nodes become one.
+ *
+ * Two nodes are considered identical if they have the same node type, op,
+ * shape and (already merged) inputs. Nodes with opaque semantics (e.g.,
+ * CustomNode) are never merged.
+ */
+class CommonSubexpressionElimination : public Pass {
+ public:
+  Node* apply(Node* node) override;
+  std::string name() const override;
+};
+
+} // namespace fl
@@ -48,7 +48,8 @@ ScalarNode* foldScalarNodes(
     const dtype type) {
   switch (type) {
     case dtype::f16:
-      throw std::runtime_error("[foldScalarNodes] unexpected f16");
+    case dtype::bf16:
+      throw std::runtime_error("[foldScalarNodes] unexpected half precision");
     case dtype::f32:
       return foldScalarNodes<float>(lhs, rhs, op, type);
     case dtype::f64:
@@ -83,7 +84,7 @@ Node* foldScalarsInBinaryNode(BinaryNode* node) {
     const auto& shape = lhsScalar.shape();
     const auto dtype = lhsScalar.dataType();
     if (shape == rhsScalar.shape() && dtype == rhsScalar.dataType() &&
-        dtype != dtype::f16) {
+        dtype != dtype::f16 && dtype != dtype::bf16) {
       auto foldedScalar = foldScalarNodes(lhsScalar, rhsScalar, binop, dtype);
       node->replaceAllUsesWith(foldedScalar);
       return foldedScalar;
@@ -101,7 +102,10 @@ Node* foldScalars(Node* node) {
       return foldScalarsInBinaryNode(&node->impl<BinaryNode>());
     case NodeType::Custom:
     case NodeType::Index:
+    case NodeType::Matmul:
+    case NodeType::Reduction:
     case NodeType::Scalar:
+    case NodeType::Unary:
     case NodeType::Value:
       return node;
   }
@@ -114,4 +118,8 @@ Node* ScalarFolding::apply(Node* node) {
   return foldScalars(node);
 }
 
+std::string ScalarFolding::name() const {
+  return "ScalarFolding";
+}
+
 } // namespace fl
@@ -18,6 +18,7 @@ namespace fl {
 class ScalarFolding : public Pass {
  public:
   Node* apply(Node* node) override;
+  std::string name() const override;
 };
 
 } // namespace fl
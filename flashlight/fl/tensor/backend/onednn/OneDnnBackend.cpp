@@ -20,8 +20,10 @@
 #include <unordered_set>
 #include <vector>
 
+#include "flashlight/fl/tensor/DLPackUtils.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 #include "flashlight/fl/tensor/backend/onednn/OneDnnTensor.h"
+#include "flashlight/fl/tensor/backend/onednn/PrimitiveCache.h"
 #include "flashlight/fl/tensor/backend/onednn/Utils.h"
 
 #define FL_ONEDNN_BACKEND_UNIMPLEMENTED \
@@ -124,7 +126,8 @@ Tensor iotaSingleAxisCpu(
   const Shape shape(dims);
   switch (type) {
     case dtype::f16:
-      return iotaWithTypeCpu<float>(shape, dtype::f32).astype(dtype::f16);
+    case dtype::bf16:
+      return iotaWithTypeCpu<float>(shape, dtype::f32).astype(type);
     case dtype::f32:
       return iotaWithTypeCpu<float>(shape, type);
     case dtype::f64:
@@ -236,8 +239,9 @@ void applyBinopCpu(
     OP op) {
   switch (rhsType) {
     case fl::dtype::f16:
+    case fl::dtype::bf16:
       throw std::runtime_error(
-          "Fallback implementation currently doesn't support f16");
+          "Fallback implementation currently doesn't support f16 and bf16");
     case fl::dtype::f32:
       applyBinopCpu<L, float>(lhs, rhs, dst, count, op);
       break;
@@ -282,8 +286,9 @@ void applyBinopCpu(
     OP op) {
   switch (lhsType) {
     case fl::dtype::f16:
+    case fl::dtype::bf16:
       throw std::runtime_error(
-          "Fallback implementation currently doesn't support f16");
+          "Fallback implementation currently doesn't support f16 and bf16");
     case fl::dtype::f32:
       applyBinopCpu<float>(lhs, rhs, rhsType, dst, count, op);
       break;
@@ -377,23 +382,6 @@ Tensor createScalarTensorForBinop(const Tensor& tensor, INPUT_TYPE val) {
       literalShape, type, &castedVal, tensor.location());
 }
 
-dnnl::memory::desc transposeInnerMatrix(const dnnl::memory::desc& memDesc) {
-  const auto ndims = memDesc.data.ndims;
-  if (ndims < 2) {
-    std::ostringstream oss;
-    oss << "[transposeInnerMatrix] expected ndims to be >= 2, got: " << ndims;
-    throw std::runtime_error(oss.str());
-  }
-  // recall that internal dims are reversed from the logical col-major dims
-  std::vector<int> transposeAxesPermutation;
-  for (int i = 0; i < ndims; i++) {
-    transposeAxesPermutation.push_back(i);
-  }
-  std::swap(
-      transposeAxesPermutation[ndims - 2], transposeAxesPermutation[ndims - 1]);
-  return memDesc.permute_axes(transposeAxesPermutation);
-}
-
 std::tuple<Shape, Shape> padShorterDimsWithOnesOnTheRight(
     const Shape& tensorShape,
     const Shape& tileDims) {
@@ -448,6 +436,14 @@ const dnnl::engine& OneDnnBackend::cpuEngine() const {
   return engine_;
 }
 
+void OneDnnBackend::setThreadingOptions(
+    const OneDnnCPUThreadingOptions& options) {
+  auto stream = OneDnnCPUStream::create(engine_, options);
+  stream->bindCallingThread();
+  stream_->sync();
+  stream_ = std::move(stream);
+}
+
 /* -------------------------- Compute Functions -------------------------- */
 
 void OneDnnBackend::eval(const Tensor& /* tensor */) {
@@ -555,8 +551,8 @@ Tensor OneDnnBackend::rand(const Shape& shape, dtype type) {
       const Shape& shape, TYPE value, const dtype type) {                      \
     switch (type) {                                                            \
       case dtype::f16:                                                         \
-        return fullWithType<float>(shape, value, dtype::f32)                   \
-            .astype(dtype::f16);                                               \
+      case dtype::bf16:                                                        \
+        return fullWithType<float>(shape, value, dtype::f32).astype(type);     \
       case dtype::f32:                                                         \
         return fullWithType<float>(shape, value, type);                        \
       case dtype::f64:                                                         \
@@ -608,6 +604,22 @@ Tensor OneDnnBackend::identity(const Dim /* dim */, const dtype /* type */) {
   FL_ONEDNN_BACKEND_UNIMPLEMENTED;
 }
 
+Tensor OneDnnBackend::fromDLPack(DLManagedTensor* dlTensor) {
+  auto imported =
+      detail::importFromDLPack(dlTensor, "OneDnnBackend::fromDLPack");
+  const auto& device = stream_->device();
+  if (!detail::isSameDevice(imported.device, device)) {
+    throw std::invalid_argument(
+        "[OneDnnBackend::fromDLPack] the DLPack tensor must be in CPU memory");
+  }
+  // the memory is only referenced, i.e. neither copied nor freed by OneDNN
+  const auto memDesc = detail::oneDnnContiguousMemDescFromShape(
+      imported.shape, detail::flToOneDnnType(imported.type));
+  dnnl::memory memory(memDesc, engine_, imported.data);
+  return toTensor<OneDnnTensor>(
+      imported.shape, std::move(memory), std::move(imported.owner));
+}
+
 Tensor OneDnnBackend::arange(
     const Shape& shape,
     const Dim seqDim,
@@ -658,9 +670,8 @@ Tensor OneDnnBackend::reshape(
   auto reshapedMem = dnnl::memory(reshapedMemDesc, engine_);
 
   // prepare primitive (use reorder to do a copy)
-  const auto reorderPrimitiveDesc = dnnl::reorder::primitive_desc(
-      engine_, memDesc, engine_, memDesc);
-  const auto reorderPrimitive = dnnl::reorder(reorderPrimitiveDesc);
+  const auto reorderPrimitive =
+      detail::getCachedReorder(engine_, memDesc, memDesc);
 
   // execute primitive
   reorderPrimitive.execute(stream_->handle(), mem, reshapedMem);
@@ -732,9 +743,8 @@ Tensor OneDnnBackend::transpose(
       getStridesAfterPermuteAxes(srcMemDims, oldToNewAxes);
   const auto reorderDstMemDesc =
       dnnl::memory::desc(srcMemDims, type, reorderDstStrides);
-  const auto reorderPrimitiveDesc = dnnl::reorder::primitive_desc(
-      engine_, srcMemDesc, engine_, reorderDstMemDesc);
-  const auto reorderPrimitive = dnnl::reorder(reorderPrimitiveDesc);
+  const auto reorderPrimitive =
+      detail::getCachedReorder(engine_, srcMemDesc, reorderDstMemDesc);
 
   // execute primitive
   reorderPrimitive.execute(stream_->handle(), srcMem, dstMem);
@@ -762,9 +772,14 @@ Tensor OneDnnBackend::tile(
       std::vector<dnnl::memory::desc> tileMemDescs(numTiles, currTiledMemDesc);
 
       // prepare concat primitive
-      const dnnl::concat::primitive_desc concatPrimitiveDesc(
-          dimsAxis, tileMemDescs, engine_);
-      const dnnl::concat concatPrimitive(concatPrimitiveDesc);
+      const auto [concatPrimitiveDesc, concatPrimitive] =
+          detail::OneDnnPrimitiveCache::getInstance().get<dnnl::concat>(
+              detail::OneDnnPrimitiveKey("tile")
+                  << static_cast<int64_t>(dimsAxis) << tileMemDescs << engine_,
+              [&]() {
+                return dnnl::concat::primitive_desc(
+                    dimsAxis, tileMemDescs, engine_);
+              });
       const auto newTileMemDesc = concatPrimitiveDesc.dst_desc();
       auto newTiledMem = dnnl::memory(newTileMemDesc, engine_);
 
@@ -962,19 +977,34 @@ Tensor OneDnnBackend::applyEltwiseOp(
     float alpha /* 0 */,
     float beta /* 0 */) {
   // prepare memories
+  // element-wise ops run on any layout, so blocked memory (e.g. from a
+  // convolution) stays blocked for the next primitive
   auto& srcTensor = toOneDnnTensor(tensor);
-  const auto mem = srcTensor.memory();
-  const auto& memDesc = srcTensor.memoryDesc();
-  const auto dstMemDesc = detail::oneDnnContiguousMemDescFromShape(
-      tensor.shape(), memDesc.data_type());
+  const auto mem = srcTensor.memoryInAnyLayout();
+  const auto& memDesc = srcTensor.memoryDescInAnyLayout();
+  const auto dstMemDesc = srcTensor.hasBlockedLayout()
+      ? memDesc
+      : detail::oneDnnContiguousMemDescFromShape(
+            tensor.shape(), memDesc.data_type());
   auto dstMem = dnnl::memory(dstMemDesc, engine_);
 
   // prepare unary primitive
-  const auto unaryDesc = dnnl::eltwise_forward::desc(
-      dnnl::prop_kind::forward_inference, alg, memDesc, alpha, beta);
-  const auto unaryPrimtiveDesc =
-      dnnl::eltwise_forward::primitive_desc(unaryDesc, engine_);
-  const auto unaryPrimitive = dnnl::eltwise_forward(unaryPrimtiveDesc);
+  const auto unaryPrimitive =
+      detail::OneDnnPrimitiveCache::getInstance()
+          .get<dnnl::eltwise_forward>(
+              detail::OneDnnPrimitiveKey("eltwise")
+                  << alg << memDesc << alpha << beta << engine_,
+              [&]() {
+                const auto unaryDesc = dnnl::eltwise_forward::desc(
+                    dnnl::prop_kind::forward_inference,
+                    alg,
+                    memDesc,
+                    alpha,
+                    beta);
+                return dnnl::eltwise_forward::primitive_desc(
+                    unaryDesc, engine_);
+              })
+          .second;
 
   // prepare arguments.
   const std::unordered_map<int, dnnl::memory> args = {
@@ -1136,11 +1166,18 @@ Tensor OneDnnBackend::applyBinop(
   auto dstMem = dnnl::memory(outputDesc.dstMemDesc, engine_);
 
   // prepare primitive
-  const auto binaryDesc = dnnl::binary::desc(
-    alg, lhsMemDesc, rhsMemDesc, outputDesc.dstMemDesc);
-  const auto binaryPrimtiveDesc =
-      dnnl::binary::primitive_desc(binaryDesc, engine_);
-  const auto binaryPrimitive = dnnl::binary(binaryPrimtiveDesc);
+  const auto binaryPrimitive =
+      detail::OneDnnPrimitiveCache::getInstance()
+          .get<dnnl::binary>(
+              detail::OneDnnPrimitiveKey("binary")
+                  << alg << lhsMemDesc << rhsMemDesc << outputDesc.dstMemDesc
+                  << engine_,
+              [&]() {
+                const auto binaryDesc = dnnl::binary::desc(
+                    alg, lhsMemDesc, rhsMemDesc, outputDesc.dstMemDesc);
+                return dnnl::binary::primitive_desc(binaryDesc, engine_);
+              })
+          .second;
 
   // prepare arguments
   const std::unordered_map<int, dnnl::memory> args = {
@@ -1186,30 +1223,39 @@ Tensor OneDnnBackend::matmul(
     lhsMemDesc = lhsMemDesc.reshape(detail::flDimsToOneDnnDims(lhsDims));
   } else if (lhsProp == MatrixProperty::Transpose) {
     std::swap(lhsDims[0], lhsDims[1]);
-    lhsMemDesc = transposeInnerMatrix(lhsMemDesc);
+    lhsMemDesc = detail::transposeInnerMatrix(lhsMemDesc);
   }
   if (isRhsScalarOrVector) { // pad to (1/K x 1)
     rhsDims.insert(rhsDims.end(), 2 - rhsDims.size(), 1);
     rhsMemDesc = rhsMemDesc.reshape(detail::flDimsToOneDnnDims(rhsDims));
   } else if (rhsProp == MatrixProperty::Transpose) {
     std::swap(rhsDims[0], rhsDims[1]);
-    rhsMemDesc = transposeInnerMatrix(rhsMemDesc);
+    rhsMemDesc = detail::transposeInnerMatrix(rhsMemDesc);
   }
 
-  // shape check (TODO support broadcasting)
-  if (!(lhsDims.at(1) == rhsDims.at(0) &&
-        std::equal(
-          lhsDims.begin() + 2,
-          lhsDims.end(),
-          rhsDims.begin() + 2,
-          rhsDims.end()))) {
+  // Batch dimensions of size 1, or missing, are broadcast by the primitive
+  const auto ndim = std::max(lhsDims.size(), rhsDims.size());
+  if (lhsDims.size() < ndim) {
+    lhsDims.resize(ndim, 1);
+    lhsMemDesc = lhsMemDesc.reshape(detail::flDimsToOneDnnDims(lhsDims));
+  }
+  if (rhsDims.size() < ndim) {
+    rhsDims.resize(ndim, 1);
+    rhsMemDesc = rhsMemDesc.reshape(detail::flDimsToOneDnnDims(rhsDims));
+  }
+  std::vector<Dim> dstDims = lhsDims;
+  dstDims[1] = rhsDims[1];
+  bool isValid = lhsDims[1] == rhsDims[0];
+  for (unsigned i = 2; i < ndim; ++i) {
+    isValid &= lhsDims[i] == rhsDims[i] || lhsDims[i] == 1 || rhsDims[i] == 1;
+    dstDims[i] = std::max(lhsDims[i], rhsDims[i]);
+  }
+  if (!isValid) {
     std::ostringstream oss;
     oss << "Cannot perform matmul for tensors of shapes: " << lhs.shape()
       << " and " << rhs.shape();
     throw std::invalid_argument(oss.str());
   }
-  std::vector<Dim> dstDims = lhsDims;
-  dstDims[1] = rhsDims[1];
   Shape dstShape(dstDims);
 
   // prepare memories
@@ -1240,11 +1286,17 @@ Tensor OneDnnBackend::matmul(
   auto& weightsMem = lhsMem;
 
   // prepare primitive
-  const auto matmulDesc =
-    dnnl::matmul::desc(srcMemDesc, weightsMemDesc, dstMemArgDesc);
-  const auto matmulPrimitiveDesc =
-    dnnl::matmul::primitive_desc(matmulDesc, engine_);
-  const auto matmulPrimitive = dnnl::matmul(matmulPrimitiveDesc);
+  const auto matmulPrimitive =
+      detail::OneDnnPrimitiveCache::getInstance()
+          .get<dnnl::matmul>(
+              detail::OneDnnPrimitiveKey("matmul")
+                  << srcMemDesc << weightsMemDesc << dstMemArgDesc << engine_,
+              [&]() {
+                const auto matmulDesc = dnnl::matmul::desc(
+                    srcMemDesc, weightsMemDesc, dstMemArgDesc);
+                return dnnl::matmul::primitive_desc(matmulDesc, engine_);
+              })
+          .second;
 
   // prepare arguments.
   const std::unordered_map<int, dnnl::memory> args = {
@@ -1350,7 +1402,9 @@ void maxWithIndexCpu(
   const Shape& inputShape = input.shape();
   switch (input.type()) {
     case dtype::f16:
-      throw std::runtime_error("[OneDnnTensor::min] doesn't support f16");
+    case dtype::bf16:
+      throw std::runtime_error(
+          "[OneDnnTensor::min] doesn't support f16 and bf16");
     case dtype::f32: {
       auto dataVec = input.toHostVector<float>();
       maxWithIndexCpu(values, indices, inputShape, dataVec, axis, keepDims, lt);
@@ -1564,16 +1618,24 @@ Tensor OneDnnBackend::applyReductionOp(
       dstShape, srcMemDesc.data_type());
 
   // prepare reduction primitive
-  const auto reductionDesc =
-      dnnl::reduction::desc(alg, srcMemDesc, dstArgMemDesc, 0, 0);
-  const auto reductionPrimtiveDesc =
-      dnnl::reduction::primitive_desc(reductionDesc, engine_);
-  const auto reductionPrimitive = dnnl::reduction(reductionPrimtiveDesc);
+  const auto reductionPrimitive =
+      detail::OneDnnPrimitiveCache::getInstance()
+          .get<dnnl::reduction>(
+              detail::OneDnnPrimitiveKey("reduction")
+                  << alg << srcMemDesc << dstArgMemDesc << engine_,
+              [&]() {
+                const auto reductionDesc = dnnl::reduction::desc(
+                    alg, srcMemDesc, dstArgMemDesc, 0, 0);
+                return dnnl::reduction::primitive_desc(
+                    reductionDesc, engine_);
+              })
+          .second;
 
   // prepare dst memories
   auto dstMemDesc = dstArgMemDesc;
   if (!keepDims) {
-    dstShape = Shape(detail::removeIndices(dstShape.get(), axesToReduce));
+    dstShape =
+        Shape(detail::removeIndices<Dim>(dstShape.get(), axesToReduce));
     dstMemDesc = detail::oneDnnContiguousMemDescFromShape(
         dstShape, srcMemDesc.data_type());
   }
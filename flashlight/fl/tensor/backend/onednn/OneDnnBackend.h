@@ -103,6 +103,15 @@ class OneDnnBackend : public TensorBackend {
    */
   const dnnl::engine& cpuEngine() const;
 
+  /**
+   * Replace the active OneDNN stream by one with given threading options and
+   * bind the calling thread to them, see OneDnnCPUStream::bindCallingThread.
+   * Computations submitted from other threads keep their own binding.
+   *
+   * @param[in] options how computations use the host's cores and memory.
+   */
+  void setThreadingOptions(const OneDnnCPUThreadingOptions& options);
+
   /* -------------------------- Compute Functions -------------------------- */
   void eval(const Tensor& tensor) override;
   bool supportsDataType(const fl::dtype& dtype) const override;
@@ -139,6 +148,7 @@ class OneDnnBackend : public TensorBackend {
 #undef FL_ONEDNN_BACKEND_CREATE_FUN_LITERAL_DECL
 
   Tensor identity(const Dim dim, const dtype type) override;
+  Tensor fromDLPack(DLManagedTensor* dlTensor) override;
   Tensor arange(const Shape& shape, const Dim seqDim, const dtype type)
       override;
   Tensor iota(const Shape& dims, const Shape& tileDims, const dtype type)
@@ -8,24 +8,83 @@
 #include "flashlight/fl/tensor/backend/onednn/OneDnnCPUStream.h"
 
 #include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "flashlight/fl/runtime/ThreadAffinity.h"
+
+#if DNNL_CPU_RUNTIME == DNNL_RUNTIME_OMP
+  #include <omp.h>
+#endif
 
 namespace fl {
 
-OneDnnCPUStream::OneDnnCPUStream(const dnnl::engine& engine) {
+namespace {
+
+void checkThreadingOptions(const OneDnnCPUThreadingOptions& options) {
+#if DNNL_CPU_RUNTIME != DNNL_RUNTIME_OMP && DNNL_CPU_RUNTIME != DNNL_RUNTIME_SEQ
+  if (options.numThreads != 0) {
+    throw std::invalid_argument(
+        "[OneDnnCPUStream::create] numThreads requires OneDNN's OpenMP or "
+        "sequential CPU runtime");
+  }
+#elif DNNL_CPU_RUNTIME == DNNL_RUNTIME_SEQ
+  if (options.numThreads > 1) {
+    throw std::invalid_argument(
+        "[OneDnnCPUStream::create] OneDNN's sequential CPU runtime only "
+        "supports one thread");
+  }
+#endif
+#ifndef __linux__
+  if (!options.cpus.empty() || options.numaNode >= 0) {
+    throw std::invalid_argument(
+        "[OneDnnCPUStream::create] core pinning and NUMA nodes are only "
+        "supported on Linux");
+  }
+#else
+  if (options.numaNode < -1) {
+    throw std::invalid_argument(
+        "[OneDnnCPUStream::create] invalid NUMA node " +
+        std::to_string(options.numaNode));
+  }
+#endif
+}
+
+} // namespace
+
+OneDnnCPUStream::OneDnnCPUStream(
+    const dnnl::engine& engine,
+    OneDnnCPUThreadingOptions options)
+    : options_(std::move(options)) {
   stream_ = std::make_unique<dnnl::stream>(engine);
 }
 
 std::shared_ptr<OneDnnCPUStream> OneDnnCPUStream::create(
-    const dnnl::engine& engine) {
+    const dnnl::engine& engine,
+    OneDnnCPUThreadingOptions options) {
   if (engine.get_kind() != dnnl::engine::kind::cpu) {
     throw std::invalid_argument("OneDnnCPUStream expects a CPU engine");
   }
-  const auto rawStreamPtr = new OneDnnCPUStream(engine);
+  checkThreadingOptions(options);
+  const auto rawStreamPtr = new OneDnnCPUStream(engine, std::move(options));
   const auto stream = std::shared_ptr<OneDnnCPUStream>(rawStreamPtr);
   rawStreamPtr->device_.addStream(stream);
   return stream;
 }
 
+const OneDnnCPUThreadingOptions& OneDnnCPUStream::threadingOptions() const {
+  return options_;
+}
+
+void OneDnnCPUStream::bindCallingThread() const {
+  setCallingThreadAffinity({options_.cpus, options_.numaNode});
+#if DNNL_CPU_RUNTIME == DNNL_RUNTIME_OMP
+  if (options_.numThreads != 0) {
+    omp_set_num_threads(options_.numThreads);
+  }
+#endif
+}
+
 void OneDnnCPUStream::sync() const {
   stream_->wait();
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "flashlight/fl/runtime/SynchronousStream.h"
 
@@ -15,14 +16,35 @@
 
 namespace fl {
 
+/**
+ * How the computations run on a OneDnnCPUStream use the host's cores and
+ * memory, e.g. to run several isolated replicas on a multi-socket machine.
+ * Default values keep OneDNN's defaults.
+ */
+struct OneDnnCPUThreadingOptions {
+  // number of threads used by each primitive; 0 keeps OneDNN's default
+  unsigned numThreads{0};
+  // cores to which the computing threads are pinned; if empty and `numaNode`
+  // is set, the cores of `numaNode`
+  std::vector<unsigned> cpus;
+  // NUMA node from which memory is preferably allocated; -1 for none
+  int numaNode{-1};
+};
+
 /**
  * An abstraction for OneDNN's CPU Stream with controlled creation methods.
+ *
+ * OneDNN executes CPU primitives on the thread submitting them, so threading
+ * options take effect on the threads bound with `bindCallingThread`.
  */
 class OneDnnCPUStream : public SynchronousStream {
   std::unique_ptr<dnnl::stream> stream_; // stored as a pointer to satisfy `sync() const`
+  const OneDnnCPUThreadingOptions options_;
 
   // internal constructor used to create the native OneDNN stream.
-  explicit OneDnnCPUStream(const dnnl::engine& engine);
+  OneDnnCPUStream(
+      const dnnl::engine& engine,
+      OneDnnCPUThreadingOptions options);
 
  public:
   /**
@@ -30,10 +52,32 @@ class OneDnnCPUStream : public SynchronousStream {
    * with the active x64 device from DeviceManager.
    *
    * @param[in] engine is the cpu engine on which the stream will be created.
+   * @param[in] options how computations on the stream use cores and memory.
    * @return a shared pointer to the created OneDnnCPUStream.
-   * @throws invalid_argument if given engine is not a CPU engine.
+   * @throws invalid_argument if given engine is not a CPU engine, or if the
+   * options aren't supported by OneDNN's CPU runtime or the platform.
+   */
+  static std::shared_ptr<OneDnnCPUStream> create(
+      const dnnl::engine& engine,
+      OneDnnCPUThreadingOptions options = {});
+
+  /**
+   * Gets the threading options of this stream.
+   *
+   * @return the threading options of this stream.
+   */
+  const OneDnnCPUThreadingOptions& threadingOptions() const;
+
+  /**
+   * Apply the threading options of this stream to the calling thread, i.e.
+   * pin it, set its memory policy and the number of threads of the parallel
+   * regions it starts. Threads it creates afterwards, e.g. OpenMP workers,
+   * inherit its pinning and memory policy, so this should be called before
+   * the thread runs its first computation.
+   *
+   * @throws runtime_error if the options can't be applied.
    */
-  static std::shared_ptr<OneDnnCPUStream> create(const dnnl::engine& engine);
+  void bindCallingThread() const;
 
   void sync() const override;
 
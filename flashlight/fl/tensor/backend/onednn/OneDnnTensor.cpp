@@ -15,6 +15,7 @@
 #include <stdexcept>
 #include <sstream>
 
+#include "flashlight/fl/tensor/DLPackUtils.h"
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Shape.h"
 #include "flashlight/fl/tensor/backend/onednn/OneDnnBackend.h"
@@ -123,9 +124,45 @@ OneDnnTensor::OneDnnTensor(
     std::shared_ptr<SharedData> sharedData,
     const Shape& shape,
     const dnnl::memory::desc& memDesc)
-    : sharedData_(std::move(sharedData)), shape_(shape), memDesc_(memDesc) {}
+    : sharedData_(std::move(sharedData)),
+      shape_(shape),
+      memDesc_(memDesc),
+      hasBlockedLayout_(sharedData_->hasBlockedLayout) {}
+
+void OneDnnTensor::refreshLayout() const {
+  if (hasBlockedLayout_ && !sharedData_->hasBlockedLayout) {
+    memDesc_ = sharedData_->memory.get_desc();
+    hasBlockedLayout_ = false;
+  }
+}
+
+void OneDnnTensor::toPlainLayout() const {
+  if (sharedData_->hasBlockedLayout) {
+    // prepare memories
+    auto& srcMem = sharedData_->memory;
+    const auto engine = srcMem.get_engine();
+    const auto srcMemDesc = srcMem.get_desc();
+    const auto dstMemDesc = detail::oneDnnContiguousMemDescFromShape(
+        shape_, srcMemDesc.data_type());
+    auto dstMem = dnnl::memory(dstMemDesc, engine);
+
+    // prepare primitive
+    const auto reorderPrimitiveDesc =
+        dnnl::reorder::primitive_desc(engine, srcMemDesc, engine, dstMemDesc);
+    const auto reorderPrimitive = dnnl::reorder(reorderPrimitiveDesc);
+
+    // execute primitive
+    reorderPrimitive.execute(backend().nativeStream(), srcMem, dstMem);
+    // shallow copies see the reordered memory too
+    sharedData_->memory = std::move(dstMem);
+    sharedData_->hasBlockedLayout = false;
+    sharedData_->isDataReady = false;
+  }
+  refreshLayout();
+}
 
 void* OneDnnTensor::getOrEvalDataHandle() {
+  toPlainLayout();
   if (!sharedData_->isDataReady) {
     stream().sync();
     sharedData_->isDataReady = true;
@@ -137,16 +174,22 @@ unsigned OneDnnTensor::getSizeInBytes() const {
   // NOTE ideally we should use `dnnl::memory::desc::get_size()`, but for some
   // reason it returns 0 for submemory with non-zero offset, e.g., `tensor(1:4)`.
   // See https://github.com/oneapi-src/oneDNN/issues/1429
-  auto type = memoryDesc().data_type();
+  auto type = memDesc_.data_type(); // the same in any layout
   auto typeSize = dnnl::memory::data_type_size(type);
   auto numElems = shape_.elements();
   return numElems * typeSize;
 }
 
-OneDnnTensor::OneDnnTensor(const Shape& shape, dnnl::memory&& memory) {
+OneDnnTensor::OneDnnTensor(
+    const Shape& shape,
+    dnnl::memory&& memory,
+    std::shared_ptr<void> externalOwner) {
   sharedData_ = std::make_shared<SharedData>();
+  sharedData_->externalOwner = std::move(externalOwner);
   shape_ = shape;
   memDesc_ = memory.get_desc();
+  hasBlockedLayout_ = !detail::isPlainLayout(memDesc_);
+  sharedData_->hasBlockedLayout = hasBlockedLayout_;
   sharedData_->memory = std::move(memory);
 }
 
@@ -187,8 +230,9 @@ OneDnnTensor::OneDnnTensor(
 
 std::unique_ptr<TensorAdapterBase> OneDnnTensor::clone() const {
   // TODO copy on write if this is not a view
-  auto& srcMem = sharedData_->memory;
-  const auto& srcMemDesc = memoryDesc();
+  // reorder from any layout, into the plain one
+  auto& srcMem = memoryInAnyLayout();
+  const auto& srcMemDesc = memoryDescInAnyLayout();
   const auto type = srcMemDesc.data_type();
   const auto dstMemDesc =
       detail::oneDnnContiguousMemDescFromShape(shape_, type);
@@ -228,7 +272,7 @@ const Shape& OneDnnTensor::shape() {
 }
 
 fl::dtype OneDnnTensor::type() {
-  return detail::oneDnnToFlType(memoryDesc().data_type());
+  return detail::oneDnnToFlType(memDesc_.data_type());
 }
 
 bool OneDnnTensor::isSparse() {
@@ -271,7 +315,7 @@ void OneDnnTensor::scalar(void* out) {
 }
 
 void OneDnnTensor::device(void** out) {
-  *out = sharedData_->memory.get_data_handle();
+  *out = memory().get_data_handle();
   sharedData_->isDevicePtrLocked = true;
 }
 
@@ -298,6 +342,11 @@ bool OneDnnTensor::isLocked() {
   return sharedData_->isDevicePtrLocked;
 }
 
+DLManagedTensor* OneDnnTensor::toDLPack() {
+  return detail::exportToDLPack(
+      isContiguous() ? shallowCopy() : asContiguousTensor());
+}
+
 bool OneDnnTensor::isContiguous() {
   const auto& shape = this->shape();
   if (shape.ndim() == 0) { // scalar
@@ -329,10 +378,10 @@ const Stream& OneDnnTensor::stream() const {
 }
 
 Tensor OneDnnTensor::astype(const dtype type) {
-  // prepare memories
-  auto& srcMem = sharedData_->memory;
+  // prepare memories (reorder from any layout, into the plain one)
+  auto& srcMem = memoryInAnyLayout();
   const auto engine = srcMem.get_engine();
-  const auto& srcMemDesc = memoryDesc();
+  const auto& srcMemDesc = memoryDescInAnyLayout();
   const auto dstMemDesc = detail::oneDnnContiguousMemDescFromShape(
       shape(), detail::flToOneDnnType(type));
   auto dstMem = dnnl::memory(dstMemDesc, engine);
@@ -560,7 +609,8 @@ std::string OneDnnTensor::toString() {
   const auto& shape = this->shape();
   switch (type()) {
     case fl::dtype::f16:
-      throw std::runtime_error("OneDnnTensor::toString doesn't support f16");
+    case fl::dtype::bf16:
+      return astype(fl::dtype::f32).toString();
     case fl::dtype::f32:
       return dataToString<float>(data, shape);
     case fl::dtype::f64:
@@ -634,14 +684,14 @@ void OneDnnTensor::assign(const Tensor& tensor) {
         "Cannot update OneDNN tensor to different shape");
   }
 
-  // prepare primitive
-  auto thisMem = this->memory();
-  auto otherMem = other.memory();
+  // prepare primitive (reorders between any layouts)
+  auto thisMem = this->memoryInAnyLayout();
+  auto otherMem = other.memoryInAnyLayout();
   const auto reorderPrimitiveDesc = dnnl::reorder::primitive_desc(
       otherMem.get_engine(),
-      other.memoryDesc(),
+      other.memoryDescInAnyLayout(),
       thisMem.get_engine(),
-      this->memoryDesc());
+      this->memoryDescInAnyLayout());
   const auto reorderPrimitive = dnnl::reorder(reorderPrimitiveDesc);
 
   // execute primitive
@@ -676,10 +726,26 @@ bool OneDnnTensor::equals(OneDnnTensor&& other) {
 }
 
 dnnl::memory& OneDnnTensor::memory() {
+  toPlainLayout();
   return sharedData_->memory;
 }
 
 const dnnl::memory::desc& OneDnnTensor::memoryDesc() const {
+  toPlainLayout();
+  return memDesc_;
+}
+
+bool OneDnnTensor::hasBlockedLayout() const {
+  return sharedData_->hasBlockedLayout;
+}
+
+dnnl::memory& OneDnnTensor::memoryInAnyLayout() {
+  refreshLayout();
+  return sharedData_->memory;
+}
+
+const dnnl::memory::desc& OneDnnTensor::memoryDescInAnyLayout() const {
+  refreshLayout();
   return memDesc_;
 }
 
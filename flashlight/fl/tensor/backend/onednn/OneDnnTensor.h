@@ -48,11 +48,22 @@ class OneDnnTensor : public TensorAdapterBase {
      *   Visually, the dnnl::memory internally represents such a tensor:
      *       [[1, 2, 3],
      *        [4, 5, 6]]
+     *
+     * Primitives like convolutions may instead leave `memory` in the blocked
+     * layout they perform best on (e.g. nChw16c), so that consecutive
+     * primitives don't pay reorders in and out. Such memory is reordered into
+     * the plain layout above lazily, once some operation requires it. Tensors
+     * with blocked memory are never views.
      */
     dnnl::memory memory;
+    // Whether `memory` is in a blocked (non-plain) layout.
+    bool hasBlockedLayout{false};
     // Whether the data in `memory` is ready (its computation finished).
     bool isDataReady{false};
     bool isDevicePtrLocked{false};
+    // Keeps `memory` alive if it's owned outside of OneDNN, e.g. by a DLPack
+    // tensor from another runtime.
+    std::shared_ptr<void> externalOwner;
 
     ~SharedData();
   };
@@ -60,7 +71,16 @@ class OneDnnTensor : public TensorAdapterBase {
   // shared among tensors that are shallow copied
   std::shared_ptr<SharedData> sharedData_;
   Shape shape_;
-  dnnl::memory::desc memDesc_;
+  // may be updated by `toPlainLayout`, if `sharedData_` was reordered into
+  // the plain layout through a shallow copy
+  mutable dnnl::memory::desc memDesc_;
+  mutable bool hasBlockedLayout_{false};
+
+  // Reorder the memory into the plain layout if it's blocked.
+  void toPlainLayout() const;
+
+  // Catch up with a reorder into the plain layout through a shallow copy.
+  void refreshLayout() const;
 
   // Return the underlying data handle in `memory`.
   // If `isDataReady` is false, sync and set it to true.
@@ -96,8 +116,12 @@ class OneDnnTensor : public TensorAdapterBase {
    *
    * @param[in] shape the shape of the new tensor
    * @param[in] memory the memory handle containing underlying tensor data
+   * @param[in] externalOwner keeps the memory alive if OneDNN doesn't own it
    */
-  OneDnnTensor(const Shape& shape, dnnl::memory&& memory);
+  OneDnnTensor(
+      const Shape& shape,
+      dnnl::memory&& memory,
+      std::shared_ptr<void> externalOwner = nullptr);
 
   /**
    * Construct an empty OneDNNTensor.
@@ -143,6 +167,7 @@ class OneDnnTensor : public TensorAdapterBase {
   void unlock() override;
   bool isLocked() override;
   bool isContiguous() override;
+  DLManagedTensor* toDLPack() override;
   Shape strides() override;
   const Stream& stream() const override;
   Tensor astype(const dtype type) override;
@@ -190,7 +215,8 @@ class OneDnnTensor : public TensorAdapterBase {
   bool equals(OneDnnTensor&& other);
 
   /**
-   * Get the underlying OneDNN memory handle.
+   * Get the underlying OneDNN memory handle, in the plain layout. Blocked
+   * memory is reordered first.
    * NOTE not const-correct to conform with OneDNN primitive execution API.
    *
    * @return a reference to the underlying OneDNN memory handle.
@@ -199,11 +225,35 @@ class OneDnnTensor : public TensorAdapterBase {
 
   /**
    * Get the current OneDNN memory descriptor (which may be a view) for this
-   * tensor. Guaranteed to have same data type as original memory desc.
+   * tensor, in the plain layout. Blocked memory is reordered first.
+   * Guaranteed to have same data type as original memory desc.
    *
    * @return an immutable reference to the underlying OneDNN memory descriptro.
    */
   const dnnl::memory::desc& memoryDesc() const;
+
+  /**
+   * @return whether the underlying memory is in a blocked layout, see
+   * `memoryInAnyLayout`.
+   */
+  bool hasBlockedLayout() const;
+
+  /**
+   * Get the underlying OneDNN memory handle in its current layout, which may
+   * be blocked. For primitives that accept any layout, e.g. reorders or
+   * convolutions, to avoid reordering into the plain layout.
+   *
+   * @return a reference to the underlying OneDNN memory handle.
+   */
+  dnnl::memory& memoryInAnyLayout();
+
+  /**
+   * Get the current OneDNN memory descriptor for this tensor in its current
+   * layout, which may be blocked, see `memoryInAnyLayout`.
+   *
+   * @return an immutable reference to the underlying OneDNN memory descriptor.
+   */
+  const dnnl::memory::desc& memoryDescInAnyLayout() const;
 };
 
 // Safe to drop `const`, as these are just checked version of `Tensor::impl`
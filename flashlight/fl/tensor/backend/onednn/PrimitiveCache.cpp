@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/fl/tensor/backend/onednn/PrimitiveCache.h"
+
+#include <stdexcept>
+
+#include "flashlight/fl/common/Utils.h"
+
+namespace fl {
+namespace detail {
+
+namespace {
+
+constexpr const char* kCapacityEnv = "FL_ONEDNN_PRIMITIVE_CACHE_CAPACITY";
+
+size_t getCapacityFromEnv() {
+  const auto env = getEnvVar(kCapacityEnv);
+  if (env.empty()) {
+    return OneDnnPrimitiveCache::kDefaultCapacity;
+  }
+  try {
+    return std::stoul(env);
+  } catch (const std::exception&) {
+    throw std::invalid_argument(
+        std::string("OneDnnPrimitiveCache - invalid ") + kCapacityEnv + ": " +
+        env);
+  }
+}
+
+} // namespace
+
+OneDnnPrimitiveKey::OneDnnPrimitiveKey(const char* name) : key_(name) {
+  // separates the name from the values
+  key_.push_back('\0');
+}
+
+OneDnnPrimitiveKey& OneDnnPrimitiveKey::operator<<(
+    const dnnl::memory::desc& desc) {
+  const auto& md = desc.data;
+  appendBytes(md.ndims);
+  key_.append(
+      reinterpret_cast<const char*>(md.dims), md.ndims * sizeof(md.dims[0]));
+  key_.append(
+      reinterpret_cast<const char*>(md.padded_dims),
+      md.ndims * sizeof(md.padded_dims[0]));
+  appendBytes(md.data_type);
+  appendBytes(md.offset0);
+  appendBytes(md.format_kind);
+  if (md.format_kind == dnnl_blocked) {
+    const auto& blocking = md.format_desc.blocking;
+    key_.append(
+        reinterpret_cast<const char*>(blocking.strides),
+        md.ndims * sizeof(blocking.strides[0]));
+    appendBytes(blocking.inner_nblks);
+    key_.append(
+        reinterpret_cast<const char*>(blocking.inner_blks),
+        blocking.inner_nblks * sizeof(blocking.inner_blks[0]));
+    key_.append(
+        reinterpret_cast<const char*>(blocking.inner_idxs),
+        blocking.inner_nblks * sizeof(blocking.inner_idxs[0]));
+  }
+  appendBytes(md.extra.flags);
+  return *this;
+}
+
+OneDnnPrimitiveKey& OneDnnPrimitiveKey::operator<<(
+    const std::vector<dnnl::memory::desc>& descs) {
+  *this << static_cast<int64_t>(descs.size());
+  for (const auto& desc : descs) {
+    *this << desc;
+  }
+  return *this;
+}
+
+OneDnnPrimitiveKey& OneDnnPrimitiveKey::operator<<(
+    const dnnl::memory::dims& dims) {
+  *this << static_cast<int64_t>(dims.size());
+  key_.append(
+      reinterpret_cast<const char*>(dims.data()),
+      dims.size() * sizeof(dims[0]));
+  return *this;
+}
+
+OneDnnPrimitiveKey& OneDnnPrimitiveKey::operator<<(
+    const dnnl::engine& engine) {
+  appendBytes(engine.get());
+  return *this;
+}
+
+OneDnnPrimitiveKey& OneDnnPrimitiveKey::operator<<(const int64_t value) {
+  appendBytes(value);
+  return *this;
+}
+
+OneDnnPrimitiveKey& OneDnnPrimitiveKey::operator<<(const double value) {
+  appendBytes(value);
+  return *this;
+}
+
+const std::string& OneDnnPrimitiveKey::str() const {
+  return key_;
+}
+
+double OneDnnPrimitiveCache::Stats::hitRate() const {
+  const auto lookups = hits + misses;
+  return lookups == 0 ? 0. : static_cast<double>(hits) / lookups;
+}
+
+OneDnnPrimitiveCache& OneDnnPrimitiveCache::getInstance() {
+  static OneDnnPrimitiveCache instance;
+  return instance;
+}
+
+OneDnnPrimitiveCache::OneDnnPrimitiveCache()
+    : capacity_(getCapacityFromEnv()), cache_(capacity_) {}
+
+OneDnnPrimitiveCache::Stats OneDnnPrimitiveCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void OneDnnPrimitiveCache::resetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_ = Stats();
+}
+
+void OneDnnPrimitiveCache::reset(const size_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  capacity_ = capacity;
+  cache_ = LRUCache<std::string, Entry>(capacity);
+}
+
+size_t OneDnnPrimitiveCache::capacity() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return capacity_;
+}
+
+dnnl::reorder getCachedReorder(
+    const dnnl::engine& engine,
+    const dnnl::memory::desc& src,
+    const dnnl::memory::desc& dst) {
+  return OneDnnPrimitiveCache::getInstance()
+      .get<dnnl::reorder>(
+          OneDnnPrimitiveKey("reorder") << src << dst << engine,
+          [&]() {
+            return dnnl::reorder::primitive_desc(engine, src, engine, dst);
+          })
+      .second;
+}
+
+dnnl::reorder getCachedReorder(
+    const dnnl::memory& src,
+    const dnnl::memory& dst) {
+  const auto srcEngine = src.get_engine();
+  const auto dstEngine = dst.get_engine();
+  const auto srcDesc = src.get_desc();
+  const auto dstDesc = dst.get_desc();
+  return OneDnnPrimitiveCache::getInstance()
+      .get<dnnl::reorder>(
+          OneDnnPrimitiveKey("memoryReorder")
+              << srcDesc << srcEngine << dstDesc << dstEngine,
+          [&]() {
+            return dnnl::reorder::primitive_desc(
+                srcEngine, srcDesc, dstEngine, dstDesc);
+          })
+      .second;
+}
+
+} // namespace detail
+} // namespace fl
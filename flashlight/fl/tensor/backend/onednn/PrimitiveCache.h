@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <dnnl.hpp>
+
+#include "flashlight/fl/distributed/LRUCache.h"
+
+namespace fl {
+namespace detail {
+
+/**
+ * The key of a oneDNN primitive in `OneDnnPrimitiveCache`: the name of the
+ * primitive, then everything its primitive descriptor is created from, e.g.
+ * memory descriptors, algorithms, flags and the engine.
+ */
+class OneDnnPrimitiveKey {
+  // the appended values, as bytes
+  std::string key_;
+
+  template <typename T>
+  void appendBytes(const T& value) {
+    key_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+ public:
+  /**
+   * @param[in] name a name unique to the call site creating the primitive
+   */
+  explicit OneDnnPrimitiveKey(const char* name);
+
+  OneDnnPrimitiveKey& operator<<(const dnnl::memory::desc& desc);
+  OneDnnPrimitiveKey& operator<<(const std::vector<dnnl::memory::desc>& descs);
+  OneDnnPrimitiveKey& operator<<(const dnnl::memory::dims& dims);
+  OneDnnPrimitiveKey& operator<<(const dnnl::engine& engine);
+  OneDnnPrimitiveKey& operator<<(int64_t value);
+  OneDnnPrimitiveKey& operator<<(double value);
+
+  template <
+      typename Enum,
+      typename = std::enable_if_t<std::is_enum<Enum>::value>>
+  OneDnnPrimitiveKey& operator<<(Enum value) {
+    return *this << static_cast<int64_t>(value);
+  }
+
+  const std::string& str() const;
+};
+
+/**
+ * An LRU cache of oneDNN primitives and their primitive descriptors, shared
+ * by the oneDNN tensor backend and autograd extension.
+ *
+ * Creating a primitive descriptor looks up an implementation for the given
+ * memory descriptors, and creating the primitive may JIT its kernel, which
+ * often take longer than running the primitive on small tensors. Ops which
+ * run again on the same shapes, types and layouts get both from the cache:
+  \code{.cpp}
+  auto [desc, primitive] =
+      OneDnnPrimitiveCache::getInstance().get<dnnl::matmul>(
+          OneDnnPrimitiveKey("matmul") << lhsDesc << rhsDesc << dstDesc
+                                       << engine,
+          [&]() {
+            return dnnl::matmul::primitive_desc(
+                dnnl::matmul::desc(lhsDesc, rhsDesc, dstDesc), engine);
+          });
+  \endcode
+ *
+ * The cache holds `kDefaultCapacity` primitives, or as many as the
+ * `FL_ONEDNN_PRIMITIVE_CACHE_CAPACITY` environment variable gives; a capacity
+ * of 0 disables it.
+ */
+class OneDnnPrimitiveCache {
+ public:
+  static constexpr size_t kDefaultCapacity = 1024;
+
+  struct Stats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+
+    /**
+     * @return the fraction of lookups which hit, or 0 without lookups
+     */
+    double hitRate() const;
+  };
+
+  static OneDnnPrimitiveCache& getInstance();
+
+  /**
+   * Gets the primitive descriptor and primitive of a key, and creates and
+   * caches them if they aren't cached.
+   *
+   * @param[in] key the key of the primitive, see `OneDnnPrimitiveKey`
+   * @param[in] createDesc creates the primitive descriptor of the primitive,
+   * from which the primitive is created
+   * @return the primitive descriptor and the primitive
+   */
+  template <typename Primitive, typename CreateDesc>
+  std::pair<typename Primitive::primitive_desc, Primitive> get(
+      const OneDnnPrimitiveKey& key,
+      CreateDesc&& createDesc) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto* entry = capacity_ > 0
+          ? dynamic_cast<TypedEntry<Primitive>*>(cache_.get(key.str()))
+          : nullptr;
+      if (entry) {
+        ++stats_.hits;
+        return {entry->desc, entry->primitive};
+      }
+      ++stats_.misses;
+    }
+    // create outside of the lock, as primitives may take long to create
+    typename Primitive::primitive_desc desc = createDesc();
+    Primitive primitive(desc);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ > 0) {
+      cache_.put(
+          key.str(), std::make_unique<TypedEntry<Primitive>>(desc, primitive));
+    }
+    return {std::move(desc), std::move(primitive)};
+  }
+
+  /**
+   * @return the hits and misses of the cache since the last `resetStats`
+   */
+  Stats stats() const;
+  void resetStats();
+
+  /**
+   * Removes all primitives from the cache, and sets its capacity.
+   *
+   * @param[in] capacity the number of primitives to cache, 0 to disable it
+   */
+  void reset(size_t capacity);
+
+  size_t capacity() const;
+
+ private:
+  OneDnnPrimitiveCache();
+
+  struct Entry {
+    virtual ~Entry() = default;
+  };
+
+  template <typename Primitive>
+  struct TypedEntry : Entry {
+    typename Primitive::primitive_desc desc;
+    Primitive primitive;
+
+    TypedEntry(typename Primitive::primitive_desc desc, Primitive primitive)
+        : desc(std::move(desc)), primitive(std::move(primitive)) {}
+  };
+
+  mutable std::mutex mutex_;
+  size_t capacity_;
+  LRUCache<std::string, Entry> cache_;
+  Stats stats_;
+};
+
+/**
+ * A reorder of memory from one descriptor to another on an engine, from
+ * `OneDnnPrimitiveCache`.
+ */
+dnnl::reorder getCachedReorder(
+    const dnnl::engine& engine,
+    const dnnl::memory::desc& src,
+    const dnnl::memory::desc& dst);
+
+/**
+ * A reorder from one memory to another, from `OneDnnPrimitiveCache`.
+ */
+dnnl::reorder getCachedReorder(
+    const dnnl::memory& src,
+    const dnnl::memory& dst);
+
+} // namespace detail
+} // namespace fl
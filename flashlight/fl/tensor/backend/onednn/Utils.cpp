@@ -9,6 +9,7 @@
 #include "flashlight/fl/tensor/backend/onednn/Utils.h"
 
 #include <numeric>
+#include <sstream>
 #include <stdexcept>
 
 #include <dnnl_debug.h>
@@ -33,6 +34,7 @@ getFlashlightTypeToOnednnTypeMap() {
   static const std::unordered_map<fl::dtype, dnnl::memory::data_type>
       kFlashlightTypeToOneDnnType = {
           {fl::dtype::f16, dnnl::memory::data_type::f16},
+          {fl::dtype::bf16, dnnl::memory::data_type::bf16},
           {fl::dtype::f32, dnnl::memory::data_type::f32},
           {fl::dtype::b8, dnnl::memory::data_type::s8},
           {fl::dtype::u8, dnnl::memory::data_type::u8},
@@ -143,5 +145,39 @@ dnnl::memory::desc oneDnnContiguousMemDescFromShape(
       /* allowEmpty */ true);
 }
 
+bool isPlainLayout(const dnnl::memory::desc& memDesc) {
+  const auto& desc = memDesc.data;
+  if (desc.format_kind != dnnl_format_kind_t::dnnl_blocked ||
+      desc.format_desc.blocking.inner_nblks > 0) {
+    return false;
+  }
+  dnnl::memory::dim expectedStride = 1;
+  for (int i = desc.ndims - 1; i >= 0; i--) {
+    if (desc.dims[i] != 1 &&
+        desc.format_desc.blocking.strides[i] != expectedStride) {
+      return false;
+    }
+    expectedStride *= desc.dims[i];
+  }
+  return true;
+}
+
+dnnl::memory::desc transposeInnerMatrix(const dnnl::memory::desc& memDesc) {
+  const auto ndims = memDesc.data.ndims;
+  if (ndims < 2) {
+    std::ostringstream oss;
+    oss << "[transposeInnerMatrix] expected ndims to be >= 2, got: " << ndims;
+    throw std::runtime_error(oss.str());
+  }
+  // recall that internal dims are reversed from the logical col-major dims
+  std::vector<int> transposeAxesPermutation;
+  for (int i = 0; i < ndims; i++) {
+    transposeAxesPermutation.push_back(i);
+  }
+  std::swap(
+      transposeAxesPermutation[ndims - 2], transposeAxesPermutation[ndims - 1]);
+  return memDesc.permute_axes(transposeAxesPermutation);
+}
+
 } // namespace detail
 } // namespace fl
@@ -95,6 +95,24 @@ dnnl::memory::desc oneDnnContiguousMemDescFromShape(
     const Shape& shape,
     const dnnl::memory::data_type type);
 
+/**
+ * Return whether given memory descriptor describes a dense row-major buffer,
+ * i.e., a plain layout, as opposed to a blocked or permuted layout chosen by
+ * a OneDNN primitive (e.g. nChw16c). Strides of unit dimensions are ignored.
+ *
+ * @param[in] memDesc the memory descriptor of a full buffer (not a view).
+ * @return true if the memory descriptor has a plain layout.
+ */
+bool isPlainLayout(const dnnl::memory::desc& memDesc);
+
+/**
+ * Transpose the inner-most 2 dimensions of a OneDNN memory descriptor.
+ *
+ * @param[in] memDesc the memory descriptor, must have at least 2 dimensions.
+ * @return the transposed memory descriptor.
+ */
+dnnl::memory::desc transposeInnerMatrix(const dnnl::memory::desc& memDesc);
+
 /**
  * Return a copy of the given vector with items at given indices removed.
  *
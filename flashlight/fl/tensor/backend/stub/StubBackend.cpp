@@ -7,20 +7,187 @@
 
 #include "flashlight/fl/tensor/backend/stub/StubBackend.h"
 
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <sstream>
 #include <stdexcept>
 
+#include "flashlight/fl/runtime/SynchronousStream.h"
 #include "flashlight/fl/tensor/TensorBase.h"
-
-#define FL_STUB_BACKEND_UNIMPLEMENTED \
-  throw std::invalid_argument(        \
-      "StubBackend::" + std::string(__func__) + " - unimplemented.");
+#include "flashlight/fl/tensor/backend/stub/StubTensor.h"
 
 namespace fl {
 
-StubBackend::StubBackend() {
-  // Set up state
+namespace {
+
+// Stub tensors are only ever computed synchronously: there is nothing to wait
+// for.
+class StubStream : public SynchronousStream {
+ public:
+  static std::shared_ptr<StubStream> create() {
+    const auto rawStreamPtr = new StubStream();
+    const auto stream = std::shared_ptr<StubStream>(rawStreamPtr);
+    rawStreamPtr->device_.addStream(stream);
+    return stream;
+  }
+
+  void sync() const override {}
+};
+
+Tensor makeTensor(const Shape& shape, const dtype type) {
+  return Tensor(std::make_unique<StubTensor>(shape, type, nullptr, Location{}));
+}
+
+// An elementwise op, of an operation per output element
+Tensor makeElementwise(const Shape& shape, const dtype type) {
+  StubBackend::getInstance().addFlops(shape.elements());
+  return makeTensor(shape, type);
+}
+
+bool isFloatingPoint(const dtype type) {
+  return type == dtype::f16 || type == dtype::bf16 || type == dtype::f32 ||
+      type == dtype::f64;
+}
+
+// Floating point types win over integral ones, then wider types over
+// narrower ones
+dtype promoteTypes(const dtype lhs, const dtype rhs) {
+  if (isFloatingPoint(lhs) != isFloatingPoint(rhs)) {
+    return isFloatingPoint(lhs) ? lhs : rhs;
+  }
+  return getTypeSize(lhs) >= getTypeSize(rhs) ? lhs : rhs;
+}
+
+// Reductions like mean have floating point results
+dtype getFloatingPointType(const dtype type) {
+  return isFloatingPoint(type) ? type : dtype::f32;
 }
 
+Dim getDim(const Shape& shape, const int i) {
+  return i < shape.ndim() ? shape.dim(i) : 1;
+}
+
+Shape broadcastShapes(
+    const Shape& lhs,
+    const Shape& rhs,
+    const std::string& func) {
+  Shape::Dims dims;
+  for (int i = 0; i < std::max(lhs.ndim(), rhs.ndim()); ++i) {
+    const auto lhsDim = getDim(lhs, i);
+    const auto rhsDim = getDim(rhs, i);
+    if (lhsDim != rhsDim && lhsDim != 1 && rhsDim != 1) {
+      std::ostringstream ss;
+      ss << "StubBackend::" << func << " - cannot broadcast shapes " << lhs
+         << " and " << rhs;
+      throw std::invalid_argument(ss.str());
+    }
+    dims.push_back(lhsDim == 1 ? rhsDim : lhsDim);
+  }
+  return Shape(dims);
+}
+
+Tensor makeBinary(
+    const Tensor& lhs,
+    const Tensor& rhs,
+    const bool isBoolean,
+    const std::string& func) {
+  return makeElementwise(
+      broadcastShapes(lhs.shape(), rhs.shape(), func),
+      isBoolean ? dtype::b8 : promoteTypes(lhs.type(), rhs.type()));
+}
+
+Shape getReducedShape(
+    const Shape& shape,
+    const std::vector<int>& axes,
+    const bool keepDims,
+    const std::string& func) {
+  std::vector<int> axesToReduce = axes;
+  if (axesToReduce.empty()) {
+    axesToReduce.resize(shape.ndim());
+    std::iota(axesToReduce.begin(), axesToReduce.end(), 0);
+  }
+  for (const int axis : axesToReduce) {
+    if (axis < 0 || axis >= std::max(shape.ndim(), 1)) {
+      std::ostringstream ss;
+      ss << "StubBackend::" << func << " - invalid axis " << axis
+         << " for a tensor of shape " << shape;
+      throw std::invalid_argument(ss.str());
+    }
+  }
+  Shape::Dims dims;
+  for (int i = 0; i < shape.ndim(); ++i) {
+    if (std::find(axesToReduce.begin(), axesToReduce.end(), i) ==
+        axesToReduce.end()) {
+      dims.push_back(shape.dim(i));
+    } else if (keepDims) {
+      dims.push_back(1);
+    }
+  }
+  return Shape(dims);
+}
+
+// A reduction, of an operation per input element
+Tensor makeReduction(
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims,
+    const dtype type,
+    const std::string& func) {
+  StubBackend::getInstance().addFlops(input.elements());
+  return makeTensor(
+      getReducedShape(input.shape(), axes, keepDims, func), type);
+}
+
+Shape getMatmulShape(
+    const Shape& lhsShape,
+    const Shape& rhsShape,
+    MatrixProperty lhsProp,
+    MatrixProperty rhsProp,
+    Dim& innerDim) {
+  Shape::Dims lhsDims = lhsShape.get();
+  Shape::Dims rhsDims = rhsShape.get();
+  const bool isLhsScalarOrVector = lhsDims.size() <= 1;
+  const bool isRhsScalarOrVector = rhsDims.size() <= 1;
+  if (isLhsScalarOrVector) {
+    lhsDims.insert(lhsDims.end(), 2 - lhsDims.size(), 1);
+    std::reverse(lhsDims.begin(), lhsDims.end());
+  } else if (lhsProp == MatrixProperty::Transpose) {
+    std::swap(lhsDims[0], lhsDims[1]);
+  }
+  if (isRhsScalarOrVector) {
+    rhsDims.insert(rhsDims.end(), 2 - rhsDims.size(), 1);
+  } else if (rhsProp == MatrixProperty::Transpose) {
+    std::swap(rhsDims[0], rhsDims[1]);
+  }
+  const auto ndim = std::max(lhsDims.size(), rhsDims.size());
+  lhsDims.resize(ndim, 1);
+  rhsDims.resize(ndim, 1);
+  Shape::Dims dstDims = lhsDims;
+  dstDims[1] = rhsDims[1];
+  bool isValid = lhsDims[1] == rhsDims[0];
+  for (unsigned i = 2; i < ndim; ++i) {
+    isValid &= lhsDims[i] == rhsDims[i] || lhsDims[i] == 1 || rhsDims[i] == 1;
+    dstDims[i] = std::max(lhsDims[i], rhsDims[i]);
+  }
+  if (!isValid) {
+    std::ostringstream ss;
+    ss << "StubBackend::matmul - invalid shapes " << lhsShape << " and "
+       << rhsShape;
+    throw std::invalid_argument(ss.str());
+  }
+  innerDim = lhsDims[1];
+  Shape dstShape(dstDims);
+  if (isLhsScalarOrVector || isRhsScalarOrVector) {
+    return Shape({dstShape.elements()});
+  }
+  return dstShape;
+}
+
+} // namespace
+
+StubBackend::StubBackend() : stream_(StubStream::create()) {}
+
 StubBackend& StubBackend::getInstance() {
   static StubBackend instance;
   return instance;
@@ -32,68 +199,101 @@ TensorBackendType StubBackend::backendType() const {
   return TensorBackendType::Stub;
 }
 
+uint64_t StubBackend::flops() const {
+  return flops_.load(std::memory_order_relaxed);
+}
+
+size_t StubBackend::liveBytes() const {
+  return liveBytes_.load(std::memory_order_relaxed);
+}
+
+void StubBackend::addFlops(uint64_t flops) {
+  flops_.fetch_add(flops, std::memory_order_relaxed);
+}
+
+void StubBackend::allocate(size_t bytes) {
+  const auto live =
+      liveBytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  auto peak = peakBytes_.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !peakBytes_.compare_exchange_weak(
+             peak, live, std::memory_order_relaxed)) {
+  }
+}
+
+void StubBackend::release(size_t bytes) {
+  liveBytes_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+const Stream& StubBackend::stream() const {
+  return *stream_;
+}
+
 /* -------------------------- Compute Functions -------------------------- */
 
 void StubBackend::eval(const Tensor& /* tensor */) {
   // Launch computation for a given tensor. Can be a noop for non-async
   // runtimes.
-  FL_STUB_BACKEND_UNIMPLEMENTED;
 }
 
 bool StubBackend::supportsDataType(const fl::dtype& /* dtype */) const {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+  return true;
 }
 
 void StubBackend::getMemMgrInfo(
-    const char* /* msg */,
+    const char* msg,
     const int /* deviceId */,
-    std::ostream* /* ostream */) {
+    std::ostream* ostream) {
   // Can be a noop if no memory manager is implemented.
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+  if (ostream) {
+    *ostream << msg << " - stub tensors: " << liveBytes() << " bytes alive, "
+             << peakBytes_.load(std::memory_order_relaxed) << " at peak"
+             << std::endl;
+  }
 }
 
 void StubBackend::setMemMgrLogStream(std::ostream* /* stream */) {
   // Can be a noop if no memory manager is implemented.
-  FL_STUB_BACKEND_UNIMPLEMENTED;
 }
 
 void StubBackend::setMemMgrLoggingEnabled(const bool /* enabled */) {
   // Can be a noop if no memory manager is implemented.
-  FL_STUB_BACKEND_UNIMPLEMENTED;
 }
 
 void StubBackend::setMemMgrFlushInterval(const size_t /* interval */) {
   // Can be a noop if no memory manager is implemented.
-  FL_STUB_BACKEND_UNIMPLEMENTED;
 }
 
-/* -------------------------- Rand Functions -------------------------- */
+size_t StubBackend::getMemMgrPeakBytes(const int /* deviceId */) {
+  return peakBytes_.load(std::memory_order_relaxed);
+}
 
-void StubBackend::setSeed(const int /* seed */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+void StubBackend::resetMemMgrPeakBytes(const int /* deviceId */) {
+  peakBytes_.store(liveBytes(), std::memory_order_relaxed);
 }
 
-Tensor StubBackend::randn(const Shape& /* shape */, dtype /* type */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+/* -------------------------- Rand Functions -------------------------- */
+
+void StubBackend::setSeed(const int /* seed */) {}
+
+Tensor StubBackend::randn(const Shape& shape, dtype type) {
+  return makeTensor(shape, type);
 }
 
-Tensor StubBackend::rand(const Shape& /* shape */, dtype /* type */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+Tensor StubBackend::rand(const Shape& shape, dtype type) {
+  return makeTensor(shape, type);
 }
 
 /* --------------------------- Tensor Operators --------------------------- */
 
 /******************** Tensor Creation Functions ********************/
-#define FL_STUB_BACKEND_CREATE_FUN_LITERAL_DEF(TYPE)                           \
-  Tensor StubBackend::fromScalar(TYPE /* value */, const dtype /* type */) {   \
-    throw std::invalid_argument(                                               \
-        "StubBackend::fromScalar - not implemented for type " +                \
-        std::string(#TYPE));                                                   \
-  }                                                                            \
-  Tensor StubBackend::full(                                                    \
-      const Shape& /* shape */, TYPE /* value */, const dtype /* type */) {    \
-    throw std::invalid_argument(                                               \
-        "StubBackend::full - not implemented for type " + std::string(#TYPE)); \
+#define FL_STUB_BACKEND_CREATE_FUN_LITERAL_DEF(TYPE)                   \
+  Tensor StubBackend::fromScalar(TYPE /* value */, const dtype type) { \
+    return makeTensor(Shape(), type);                                  \
+  }                                                                    \
+  Tensor StubBackend::full(                                            \
+      const Shape& shape, TYPE /* value */, const dtype type) {        \
+    return makeTensor(shape, type);                                    \
   }
 FL_STUB_BACKEND_CREATE_FUN_LITERAL_DEF(const double&);
 FL_STUB_BACKEND_CREATE_FUN_LITERAL_DEF(const float&);
@@ -108,406 +308,433 @@ FL_STUB_BACKEND_CREATE_FUN_LITERAL_DEF(const unsigned long long&);
 FL_STUB_BACKEND_CREATE_FUN_LITERAL_DEF(const bool&);
 FL_STUB_BACKEND_CREATE_FUN_LITERAL_DEF(const short&);
 FL_STUB_BACKEND_CREATE_FUN_LITERAL_DEF(const unsigned short&);
+#undef FL_STUB_BACKEND_CREATE_FUN_LITERAL_DEF
+
+Tensor StubBackend::identity(const Dim dim, const dtype type) {
+  return makeTensor({dim, dim}, type);
+}
 
-Tensor StubBackend::identity(const Dim /* dim */, const dtype /* type */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+Tensor StubBackend::fromDLPack(DLManagedTensor* /* dlTensor */) {
+  throw std::invalid_argument(
+      "StubBackend::fromDLPack - stub tensors have no memory to share");
 }
 
 Tensor StubBackend::arange(
-    const Shape& /* shape */,
+    const Shape& shape,
     const Dim /* seqDim */,
-    const dtype /* type */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const dtype type) {
+  return makeTensor(shape, type);
 }
 
 Tensor StubBackend::iota(
-    const Shape& /* dims */,
-    const Shape& /* tileDims */,
-    const dtype /* type */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Shape& dims,
+    const Shape& tileDims,
+    const dtype type) {
+  Shape::Dims outDims;
+  for (int i = 0; i < std::max(dims.ndim(), tileDims.ndim()); ++i) {
+    outDims.push_back(getDim(dims, i) * getDim(tileDims, i));
+  }
+  return makeTensor(Shape(outDims), type);
 }
 
 /************************ Shaping and Indexing *************************/
-Tensor StubBackend::reshape(
-    const Tensor& /* tensor */,
-    const Shape& /* shape */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+Tensor StubBackend::reshape(const Tensor& tensor, const Shape& shape) {
+  if (tensor.elements() != shape.elements()) {
+    std::ostringstream ss;
+    ss << "StubBackend::reshape - cannot reshape a tensor of shape "
+       << tensor.shape() << " to " << shape;
+    throw std::invalid_argument(ss.str());
+  }
+  return makeTensor(shape, tensor.type());
 }
 
 Tensor StubBackend::transpose(
-    const Tensor& /* tensor */,
-    const Shape& /* axes */ /* = {} */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& tensor,
+    const Shape& axes /* = {} */) {
+  const auto& shape = tensor.shape();
+  Shape::Dims dims = shape.get();
+  if (axes.ndim() == 0) {
+    std::reverse(dims.begin(), dims.end());
+  } else if (axes.ndim() != shape.ndim()) {
+    std::ostringstream ss;
+    ss << "StubBackend::transpose - axes " << axes
+       << " don't match a tensor of shape " << shape;
+    throw std::invalid_argument(ss.str());
+  } else {
+    for (int i = 0; i < axes.ndim(); ++i) {
+      dims[i] = shape.dim(axes.dim(i));
+    }
+  }
+  return makeElementwise(Shape(dims), tensor.type());
 }
 
-Tensor StubBackend::tile(const Tensor& /* tensor */, const Shape& /* shape */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+Tensor StubBackend::tile(const Tensor& tensor, const Shape& shape) {
+  return iota(tensor.shape(), shape, tensor.type());
 }
 
 Tensor StubBackend::concatenate(
-    const std::vector<Tensor>& /* tensors */,
-    const unsigned /* axis */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const std::vector<Tensor>& tensors,
+    const unsigned axis) {
+  if (tensors.empty()) {
+    throw std::invalid_argument(
+        "StubBackend::concatenate - no tensors to concatenate");
+  }
+  const auto& first = tensors.front().shape();
+  const int ndim = std::max(first.ndim(), static_cast<int>(axis) + 1);
+  Shape::Dims dims;
+  for (int i = 0; i < ndim; ++i) {
+    dims.push_back(i == static_cast<int>(axis) ? 0 : getDim(first, i));
+  }
+  for (const auto& tensor : tensors) {
+    for (int i = 0; i < ndim; ++i) {
+      if (i == static_cast<int>(axis)) {
+        dims[i] += getDim(tensor.shape(), i);
+      } else if (getDim(tensor.shape(), i) != dims[i]) {
+        std::ostringstream ss;
+        ss << "StubBackend::concatenate - cannot concatenate shapes " << first
+           << " and " << tensor.shape() << " along axis " << axis;
+        throw std::invalid_argument(ss.str());
+      }
+    }
+  }
+  return makeTensor(Shape(dims), tensors.front().type());
 }
 
-Tensor StubBackend::nonzero(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+Tensor StubBackend::nonzero(const Tensor& tensor) {
+  // an upper bound
+  return makeElementwise({tensor.elements()}, dtype::u32);
 }
 
 Tensor StubBackend::pad(
-    const Tensor& /* input */,
-    const std::vector<std::pair<int, int>>& /* padWidths */,
+    const Tensor& input,
+    const std::vector<std::pair<int, int>>& padWidths,
     const PadType /* type */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+  Shape::Dims dims = input.shape().get();
+  dims.resize(std::max(dims.size(), padWidths.size()), 1);
+  for (size_t i = 0; i < padWidths.size(); ++i) {
+    dims[i] += padWidths[i].first + padWidths[i].second;
+  }
+  return makeTensor(Shape(dims), input.type());
 }
 
 /************************** Unary Operators ***************************/
 
-Tensor StubBackend::exp(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::log(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::negative(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::logicalNot(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::log1p(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::sin(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::cos(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::sqrt(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::tanh(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::floor(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::ceil(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::rint(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::absolute(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::sigmoid(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::erf(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::flip(const Tensor& /* tensor */, const unsigned /* dim */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+#define FL_STUB_BACKEND_UNARY_OP_DEF(FUNC)                 \
+  Tensor StubBackend::FUNC(const Tensor& tensor) {         \
+    return makeElementwise(tensor.shape(), tensor.type()); \
+  }
+FL_STUB_BACKEND_UNARY_OP_DEF(exp);
+FL_STUB_BACKEND_UNARY_OP_DEF(log);
+FL_STUB_BACKEND_UNARY_OP_DEF(negative);
+FL_STUB_BACKEND_UNARY_OP_DEF(log1p);
+FL_STUB_BACKEND_UNARY_OP_DEF(sin);
+FL_STUB_BACKEND_UNARY_OP_DEF(cos);
+FL_STUB_BACKEND_UNARY_OP_DEF(sqrt);
+FL_STUB_BACKEND_UNARY_OP_DEF(tanh);
+FL_STUB_BACKEND_UNARY_OP_DEF(floor);
+FL_STUB_BACKEND_UNARY_OP_DEF(ceil);
+FL_STUB_BACKEND_UNARY_OP_DEF(rint);
+FL_STUB_BACKEND_UNARY_OP_DEF(absolute);
+FL_STUB_BACKEND_UNARY_OP_DEF(sigmoid);
+FL_STUB_BACKEND_UNARY_OP_DEF(erf);
+FL_STUB_BACKEND_UNARY_OP_DEF(sign);
+FL_STUB_BACKEND_UNARY_OP_DEF(tril);
+FL_STUB_BACKEND_UNARY_OP_DEF(triu);
+#undef FL_STUB_BACKEND_UNARY_OP_DEF
+
+Tensor StubBackend::logicalNot(const Tensor& tensor) {
+  return makeElementwise(tensor.shape(), dtype::b8);
+}
+
+Tensor StubBackend::flip(const Tensor& tensor, const unsigned /* dim */) {
+  return makeElementwise(tensor.shape(), tensor.type());
 }
 
 Tensor StubBackend::clip(
-    const Tensor& /* tensor */,
+    const Tensor& tensor,
     const Tensor& /* low */,
     const Tensor& /* high */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+  return makeElementwise(tensor.shape(), tensor.type());
 }
 
 Tensor StubBackend::roll(
-    const Tensor& /* tensor */,
+    const Tensor& tensor,
     const int /* shift */,
     const unsigned /* axis */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::isnan(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::isinf(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::sign(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+  return makeElementwise(tensor.shape(), tensor.type());
 }
 
-Tensor StubBackend::tril(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+Tensor StubBackend::isnan(const Tensor& tensor) {
+  return makeElementwise(tensor.shape(), dtype::b8);
 }
 
-Tensor StubBackend::triu(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+Tensor StubBackend::isinf(const Tensor& tensor) {
+  return makeElementwise(tensor.shape(), dtype::b8);
 }
 
 Tensor StubBackend::where(
-    const Tensor& /* condition */,
-    const Tensor& /* x */,
-    const Tensor& /* y */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& condition,
+    const Tensor& x,
+    const Tensor& y) {
+  const auto shape = broadcastShapes(
+      condition.shape(), broadcastShapes(x.shape(), y.shape(), "where"),
+      "where");
+  return makeElementwise(shape, promoteTypes(x.type(), y.type()));
 }
 
 void StubBackend::topk(
-    Tensor& /* values */,
-    Tensor& /* indices */,
-    const Tensor& /* input */,
-    const unsigned /* k */,
-    const Dim /* axis */,
+    Tensor& values,
+    Tensor& indices,
+    const Tensor& input,
+    const unsigned k,
+    const Dim axis,
     const SortMode /* sortMode */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+  Shape::Dims dims = input.shape().get();
+  if (axis < 0 || axis >= static_cast<Dim>(dims.size())) {
+    throw std::invalid_argument("StubBackend::topk - invalid axis");
+  }
+  dims[axis] = std::min(static_cast<Dim>(k), dims[axis]);
+  addFlops(input.elements());
+  values = makeTensor(Shape(dims), input.type());
+  indices = makeTensor(Shape(dims), dtype::u32);
 }
 
 Tensor StubBackend::sort(
-    const Tensor& /* input */,
+    const Tensor& input,
     const Dim /* axis */,
     const SortMode /* sortMode */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+  return makeElementwise(input.shape(), input.type());
 }
 
 void StubBackend::sort(
-    Tensor& /* values */,
-    Tensor& /* indices */,
-    const Tensor& /* input */,
+    Tensor& values,
+    Tensor& indices,
+    const Tensor& input,
     const Dim /* axis */,
     const SortMode /* sortMode */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+  values = makeElementwise(input.shape(), input.type());
+  indices = makeTensor(input.shape(), dtype::u32);
 }
 
 Tensor StubBackend::argsort(
-    const Tensor& /* input */,
+    const Tensor& input,
     const Dim /* axis */,
     const SortMode /* sortMode */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+  return makeElementwise(input.shape(), dtype::u32);
 }
 
 /************************** Binary Operators ***************************/
-#define FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, TYPE)                            \
-  Tensor StubBackend::FUNC(const Tensor& /* a */, TYPE /* rhs */) {         \
-    throw std::runtime_error(                                               \
-        "StubBackend::" + std::string(#FUNC) + " unimplemented for type " + \
-        std::string(#TYPE));                                                \
-  }                                                                         \
-  Tensor StubBackend::FUNC(TYPE /* lhs */, const Tensor& /* a */) {         \
-    throw std::runtime_error(                                               \
-        "StubBackend::" + std::string(#FUNC) + " unimplemented for type " + \
-        std::string(#TYPE));                                                \
+// Ops with literals keep the shape and the type of their tensor
+#define FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, TYPE)        \
+  Tensor StubBackend::FUNC(const Tensor& a, TYPE /* rhs */) {       \
+    return makeElementwise(a.shape(), BOOL ? dtype::b8 : a.type()); \
+  }                                                                 \
+  Tensor StubBackend::FUNC(TYPE /* lhs */, const Tensor& a) {       \
+    return makeElementwise(a.shape(), BOOL ? dtype::b8 : a.type()); \
   }
 
-#define FL_AF_BINARY_OP_LITERALS_DEF(FUNC, OP)                   \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const bool&);               \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const int&);                \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const unsigned&);           \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const char&);               \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const unsigned char&);      \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const long&);               \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const unsigned long&);      \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const long long&);          \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const unsigned long long&); \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const double&);             \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const float&);              \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const short&);              \
-  FL_AF_BINARY_OP_TYPE_DEF(FUNC, OP, const unsigned short&);
-
-// Operations on fl::Tensor call the respective operator overloads that are
-// already defined on af::arrays
-#define FL_AF_BINARY_OP_DEF(OP, FUNC)                                          \
-  Tensor StubBackend::FUNC(const Tensor& /* lhs */, const Tensor& /* rhs */) { \
-    throw std::runtime_error(                                                  \
-        "StubBackend::" + std::string(#FUNC) +                                 \
-        " unimplemented for two-Tensor inputs.");                              \
-  }                                                                            \
-  FL_AF_BINARY_OP_LITERALS_DEF(FUNC, OP);
-
-// Definitions
-// Since ArrayFire implements operator overloads, map both fl::Tensor
-// functions and fl::Tensor operator overloads back to the af::array
-// overloads.
-FL_AF_BINARY_OP_DEF(+, add);
-FL_AF_BINARY_OP_DEF(-, sub);
-FL_AF_BINARY_OP_DEF(*, mul);
-FL_AF_BINARY_OP_DEF(/, div);
-FL_AF_BINARY_OP_DEF(==, eq);
-FL_AF_BINARY_OP_DEF(!=, neq);
-FL_AF_BINARY_OP_DEF(<, lessThan);
-FL_AF_BINARY_OP_DEF(<=, lessThanEqual);
-FL_AF_BINARY_OP_DEF(>, greaterThan);
-FL_AF_BINARY_OP_DEF(>=, greaterThanEqual);
-FL_AF_BINARY_OP_DEF(||, logicalOr);
-FL_AF_BINARY_OP_DEF(&&, logicalAnd);
-FL_AF_BINARY_OP_DEF(%, mod);
-FL_AF_BINARY_OP_DEF(&, bitwiseAnd);
-FL_AF_BINARY_OP_DEF(|, bitwiseOr);
-FL_AF_BINARY_OP_DEF(^, bitwiseXor);
-FL_AF_BINARY_OP_DEF(<<, lShift);
-FL_AF_BINARY_OP_DEF(>>, rShift);
-#undef FL_AF_BINARY_OP_DEF
-#undef FL_AF_BINARY_OP_TYPE_DEF
-#undef FL_AF_BINARY_OP_LITERALS_DEF
-
-Tensor StubBackend::minimum(const Tensor& /* lhs */, const Tensor& /* rhs */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::maximum(const Tensor& /* lhs */, const Tensor& /* rhs */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
-}
-
-Tensor StubBackend::power(const Tensor& /* lhs */, const Tensor& /* rhs */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+#define FL_STUB_BACKEND_BINARY_OP_LITERALS_DEF(FUNC, BOOL)                   \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const bool&);               \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const int&);                \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const unsigned&);           \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const char&);               \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const unsigned char&);      \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const long&);               \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const unsigned long&);      \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const long long&);          \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const unsigned long long&); \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const double&);             \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const float&);              \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const short&);              \
+  FL_STUB_BACKEND_BINARY_OP_TYPE_DEF(FUNC, BOOL, const unsigned short&);
+
+// Comparisons and logical ops give booleans, the others the promoted type of
+// their inputs, on their broadcast shape
+#define FL_STUB_BACKEND_BINARY_OP_DEF(FUNC, BOOL)                  \
+  Tensor StubBackend::FUNC(const Tensor& lhs, const Tensor& rhs) { \
+    return makeBinary(lhs, rhs, BOOL, #FUNC);                      \
+  }                                                                \
+  FL_STUB_BACKEND_BINARY_OP_LITERALS_DEF(FUNC, BOOL);
+
+FL_STUB_BACKEND_BINARY_OP_DEF(add, false);
+FL_STUB_BACKEND_BINARY_OP_DEF(sub, false);
+FL_STUB_BACKEND_BINARY_OP_DEF(mul, false);
+FL_STUB_BACKEND_BINARY_OP_DEF(div, false);
+FL_STUB_BACKEND_BINARY_OP_DEF(eq, true);
+FL_STUB_BACKEND_BINARY_OP_DEF(neq, true);
+FL_STUB_BACKEND_BINARY_OP_DEF(lessThan, true);
+FL_STUB_BACKEND_BINARY_OP_DEF(lessThanEqual, true);
+FL_STUB_BACKEND_BINARY_OP_DEF(greaterThan, true);
+FL_STUB_BACKEND_BINARY_OP_DEF(greaterThanEqual, true);
+FL_STUB_BACKEND_BINARY_OP_DEF(logicalOr, true);
+FL_STUB_BACKEND_BINARY_OP_DEF(logicalAnd, true);
+FL_STUB_BACKEND_BINARY_OP_DEF(mod, false);
+FL_STUB_BACKEND_BINARY_OP_DEF(bitwiseAnd, false);
+FL_STUB_BACKEND_BINARY_OP_DEF(bitwiseOr, false);
+FL_STUB_BACKEND_BINARY_OP_DEF(bitwiseXor, false);
+FL_STUB_BACKEND_BINARY_OP_DEF(lShift, false);
+FL_STUB_BACKEND_BINARY_OP_DEF(rShift, false);
+#undef FL_STUB_BACKEND_BINARY_OP_DEF
+#undef FL_STUB_BACKEND_BINARY_OP_TYPE_DEF
+#undef FL_STUB_BACKEND_BINARY_OP_LITERALS_DEF
+
+Tensor StubBackend::minimum(const Tensor& lhs, const Tensor& rhs) {
+  return makeBinary(lhs, rhs, false, "minimum");
+}
+
+Tensor StubBackend::maximum(const Tensor& lhs, const Tensor& rhs) {
+  return makeBinary(lhs, rhs, false, "maximum");
+}
+
+Tensor StubBackend::power(const Tensor& lhs, const Tensor& rhs) {
+  return makeBinary(lhs, rhs, false, "power");
 }
 
 /************************** BLAS ***************************/
 
 Tensor StubBackend::matmul(
-    const Tensor& /* lhs */,
-    const Tensor& /* rhs */,
-    MatrixProperty /* lhsProp */,
-    MatrixProperty /* rhsProp */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& lhs,
+    const Tensor& rhs,
+    MatrixProperty lhsProp,
+    MatrixProperty rhsProp) {
+  Dim innerDim = 0;
+  const auto shape =
+      getMatmulShape(lhs.shape(), rhs.shape(), lhsProp, rhsProp, innerDim);
+  // a multiply-add per output element and inner dimension
+  addFlops(2 * static_cast<uint64_t>(shape.elements()) * innerDim);
+  return makeTensor(shape, promoteTypes(lhs.type(), rhs.type()));
 }
 
 /************************** Reductions ***************************/
 
 Tensor StubBackend::amin(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  return makeReduction(input, axes, keepDims, input.type(), "amin");
 }
 
 Tensor StubBackend::amax(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  return makeReduction(input, axes, keepDims, input.type(), "amax");
 }
 
 void StubBackend::min(
-    Tensor& /* values */,
-    Tensor& /* indices */,
-    const Tensor& /* input */,
-    const unsigned /* axis */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    Tensor& values,
+    Tensor& indices,
+    const Tensor& input,
+    const unsigned axis,
+    const bool keepDims) {
+  const std::vector<int> axes = {static_cast<int>(axis)};
+  values = makeReduction(input, axes, keepDims, input.type(), "min");
+  indices = makeTensor(values.shape(), dtype::u32);
 }
 
 void StubBackend::max(
-    Tensor& /* values */,
-    Tensor& /* indices */,
-    const Tensor& /* input */,
-    const unsigned /* axis */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    Tensor& values,
+    Tensor& indices,
+    const Tensor& input,
+    const unsigned axis,
+    const bool keepDims) {
+  const std::vector<int> axes = {static_cast<int>(axis)};
+  values = makeReduction(input, axes, keepDims, input.type(), "max");
+  indices = makeTensor(values.shape(), dtype::u32);
 }
 
 Tensor StubBackend::sum(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  return makeReduction(input, axes, keepDims, input.type(), "sum");
 }
 
-Tensor StubBackend::cumsum(
-    const Tensor& /* input */,
-    const unsigned /* axis */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+Tensor StubBackend::cumsum(const Tensor& input, const unsigned /* axis */) {
+  return makeElementwise(input.shape(), input.type());
 }
 
 Tensor StubBackend::argmax(
-    const Tensor& /* input */,
-    const unsigned /* axis */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const unsigned axis,
+    const bool keepDims) {
+  return makeReduction(
+      input, {static_cast<int>(axis)}, keepDims, dtype::u32, "argmax");
 }
 
 Tensor StubBackend::argmin(
-    const Tensor& /* input */,
-    const unsigned /* axis */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const unsigned axis,
+    const bool keepDims) {
+  return makeReduction(
+      input, {static_cast<int>(axis)}, keepDims, dtype::u32, "argmin");
 }
 
 Tensor StubBackend::mean(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  return makeReduction(
+      input, axes, keepDims, getFloatingPointType(input.type()), "mean");
 }
 
 Tensor StubBackend::median(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  return makeReduction(
+      input, axes, keepDims, getFloatingPointType(input.type()), "median");
 }
 
 Tensor StubBackend::var(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
+    const Tensor& input,
+    const std::vector<int>& axes,
     const bool /* bias */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const bool keepDims) {
+  return makeReduction(
+      input, axes, keepDims, getFloatingPointType(input.type()), "var");
 }
 
 Tensor StubBackend::std(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  return makeReduction(
+      input, axes, keepDims, getFloatingPointType(input.type()), "std");
 }
 
 Tensor StubBackend::norm(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
+    const Tensor& input,
+    const std::vector<int>& axes,
     double /* p */ /* = 2 */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const bool keepDims) {
+  return makeReduction(
+      input, axes, keepDims, getFloatingPointType(input.type()), "norm");
 }
 
 Tensor StubBackend::countNonzero(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  return makeReduction(input, axes, keepDims, dtype::u32, "countNonzero");
 }
 
 Tensor StubBackend::any(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  return makeReduction(input, axes, keepDims, dtype::b8, "any");
 }
 
 Tensor StubBackend::all(
-    const Tensor& /* input */,
-    const std::vector<int>& /* axes */,
-    const bool /* keepDims */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+    const Tensor& input,
+    const std::vector<int>& axes,
+    const bool keepDims) {
+  return makeReduction(input, axes, keepDims, dtype::b8, "all");
 }
 
-void StubBackend::print(const Tensor& /* tensor */) {
-  FL_STUB_BACKEND_UNIMPLEMENTED;
+void StubBackend::print(const Tensor& tensor) {
+  std::cout << tensor.toString() << std::endl;
 }
 
 } // namespace fl
@@ -7,17 +7,45 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
 #include "flashlight/fl/tensor/TensorBackend.h"
 
 namespace fl {
 
 /**
- * A stub Tensor backend implementation to make it easy to get started with the
- * Flashlight Tensor API.
+ * A Tensor backend without compute, whose tensors only have a shape and a type
+ * (see `StubTensor`). Its ops propagate shapes and types, and count the bytes
+ * of the live tensors and the floating point operations the ops would take,
+ * such that a model can run its forward and backward passes symbolically, e.g.
+ * to choose a batch size, checkpointing or sharding for a job before running
+ * it (see `fl::dryRun`):
+  \code{.cpp}
+  fl::withTensorType<fl::StubTensor>([]() {
+    auto& backend = fl::StubBackend::getInstance();
+    auto model = ...;
+    backend.resetMemMgrPeakBytes(0);
+    model->forward(input).backward();
+    std::cout << backend.getMemMgrPeakBytes(0) << " bytes, "
+              << backend.flops() << " FLOPs";
+  });
+  \endcode
+ *
+ * Elementwise ops count an operation per output element, reductions one per
+ * input element and `matmul` a multiply-add per pair of inputs. Ops whose
+ * output shape depends on data, e.g. `nonzero`, give an upper bound.
  *
- * This stub can be copied, renamed, and implemented as needed.
+ * This backend is also a template to implement other backends from.
  */
 class StubBackend : public TensorBackend {
+  std::atomic<size_t> liveBytes_{0};
+  std::atomic<size_t> peakBytes_{0};
+  std::atomic<uint64_t> flops_{0};
+  std::shared_ptr<Stream> stream_;
+
  public:
   StubBackend();
 
@@ -31,6 +59,26 @@ class StubBackend : public TensorBackend {
   StubBackend& operator=(StubBackend&&) = delete;
   StubBackend& operator=(const StubBackend&) = delete;
 
+  /**
+   * @return the number of floating point operations of the ops run so far.
+   */
+  uint64_t flops() const;
+
+  /**
+   * @return the bytes of the stub tensors alive.
+   */
+  size_t liveBytes() const;
+
+  // Accounting of the tensors and ops, e.g. by the stub autograd extension
+  void addFlops(uint64_t flops);
+  void allocate(size_t bytes);
+  void release(size_t bytes);
+
+  /**
+   * @return the stream of the stub tensors, which is synchronous.
+   */
+  const Stream& stream() const;
+
   /* -------------------------- Compute Functions -------------------------- */
   void eval(const Tensor& tensor) override;
   bool supportsDataType(const fl::dtype& dtype) const override;
@@ -40,6 +88,9 @@ class StubBackend : public TensorBackend {
   void setMemMgrLogStream(std::ostream* stream) override;
   void setMemMgrLoggingEnabled(const bool enabled) override;
   void setMemMgrFlushInterval(const size_t interval) override;
+  // The peak of the bytes of the stub tensors alive, for any device
+  size_t getMemMgrPeakBytes(const int deviceId) override;
+  void resetMemMgrPeakBytes(const int deviceId) override;
 
   /* -------------------------- Rand Functions -------------------------- */
   void setSeed(const int seed) override;
@@ -67,6 +118,7 @@ class StubBackend : public TensorBackend {
 #undef FL_STUB_BACKEND_CREATE_FUN_LITERAL_DECL
 
   Tensor identity(const Dim dim, const dtype type) override;
+  Tensor fromDLPack(DLManagedTensor* dlTensor) override;
   Tensor arange(const Shape& shape, const Dim seqDim, const dtype type)
       override;
   Tensor iota(const Shape& dims, const Shape& tileDims, const dtype type)
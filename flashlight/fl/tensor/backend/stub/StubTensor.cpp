@@ -7,163 +7,293 @@
 
 #include "flashlight/fl/tensor/backend/stub/StubTensor.h"
 
-#define FL_STUB_TENSOR_UNIMPLEMENTED \
-  throw std::invalid_argument(       \
-      "StubTensor::" + std::string(__func__) + " - unimplemented.");
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/backend/stub/StubBackend.h"
 
 namespace fl {
 
-StubTensor::StubTensor() {}
+namespace {
+
+size_t getBytes(const Shape& shape, const dtype type) {
+  return shape.elements() * getTypeSize(type);
+}
+
+Tensor makeTensor(const Shape& shape, const dtype type) {
+  return Tensor(std::make_unique<StubTensor>(shape, type, nullptr, Location{}));
+}
+
+Dim getIndexedDim(const Index& idx, const Dim dim) {
+  switch (idx.type()) {
+    case detail::IndexType::Span:
+      return dim;
+    case detail::IndexType::Range: {
+      const auto& rangeIdx = idx.get<range>();
+      auto start = rangeIdx.start();
+      auto end = rangeIdx.end().value_or(dim);
+      start = start < 0 ? start + dim : start;
+      end = end < 0 ? end + dim : end;
+      const auto stride = rangeIdx.stride();
+      if (start < 0 || end > dim || stride <= 0) {
+        std::ostringstream ss;
+        ss << "StubTensor::index - invalid range [" << rangeIdx.start() << ", "
+           << end << ") of stride " << stride << " for a dimension of "
+           << dim;
+        throw std::invalid_argument(ss.str());
+      }
+      return end > start ? (end - start + stride - 1) / stride : 0;
+    }
+    case detail::IndexType::Tensor:
+      return idx.get<Tensor>().elements();
+    default:
+      throw std::invalid_argument("StubTensor::index - unknown index type");
+  }
+}
+
+// The same semantics as the ArrayFire backend: literals reduce their
+// dimension, and a tensor index gives as many elements along its dimension
+// as it has, or the elements of the flattened tensor if it indexes it whole.
+Shape getIndexedShape(
+    const Shape& shape,
+    const Index* indices,
+    const size_t numIndices) {
+  if (numIndices > static_cast<size_t>(shape.ndim())) {
+    std::ostringstream ss;
+    ss << "StubTensor::index - " << numIndices
+       << " indices for a tensor of shape " << shape;
+    throw std::invalid_argument(ss.str());
+  }
+  if (numIndices == 1 && indices[0].type() == detail::IndexType::Tensor &&
+      indices[0].get<Tensor>().shape() == shape) {
+    // a mask or the indices of all elements; masks give an upper bound
+    return Shape({shape.elements()});
+  }
+  Shape::Dims dims;
+  for (int i = 0; i < shape.ndim(); ++i) {
+    if (i >= static_cast<int>(numIndices)) {
+      dims.push_back(shape.dim(i));
+    } else if (indices[i].type() != detail::IndexType::Literal) {
+      dims.push_back(getIndexedDim(indices[i], shape.dim(i)));
+    } else {
+      const auto literal = indices[i].get<Dim>();
+      if (literal >= shape.dim(i) || literal < -shape.dim(i)) {
+        std::ostringstream ss;
+        ss << "StubTensor::index - index " << literal << " out of bounds "
+           << "for a dimension of " << shape.dim(i);
+        throw std::invalid_argument(ss.str());
+      }
+    }
+  }
+  if (dims.empty() && shape.ndim() > 0) {
+    // literals don't index a tensor to a scalar
+    dims.push_back(1);
+  }
+  return Shape(dims);
+}
+
+} // namespace
+
+StubTensor::Storage::Storage(size_t bytes) : bytes(bytes) {
+  StubBackend::getInstance().allocate(bytes);
+}
+
+StubTensor::Storage::~Storage() {
+  StubBackend::getInstance().release(bytes);
+}
+
+StubTensor::StubTensor(
+    const Shape& shape,
+    dtype type,
+    std::shared_ptr<Storage> storage)
+    : shape_(shape), type_(type), storage_(std::move(storage)) {}
+
+StubTensor::StubTensor() : StubTensor(Shape({0}), dtype::f32, nullptr, {}) {}
 
 StubTensor::StubTensor(
-    const Shape& /* shape */,
-    fl::dtype /* type */,
+    const Shape& shape,
+    fl::dtype type,
     const void* /* ptr */,
-    Location /* memoryLocation */) {}
+    Location /* memoryLocation */)
+    : shape_(shape),
+      type_(type),
+      storage_(std::make_shared<Storage>(getBytes(shape, type))) {}
 
 StubTensor::StubTensor(
-    const Dim /* nRows */,
-    const Dim /* nCols */,
-    const Tensor& /* values */,
-    const Tensor& /* rowIdx */,
-    const Tensor& /* colIdx */,
-    StorageType /* storageType */) {}
+    const Dim nRows,
+    const Dim nCols,
+    const Tensor& values,
+    const Tensor& rowIdx,
+    const Tensor& colIdx,
+    StorageType /* storageType */)
+    : shape_({nRows, nCols}),
+      type_(values.type()),
+      storage_(std::make_shared<Storage>(
+          values.bytes() + rowIdx.bytes() + colIdx.bytes())) {}
 
 std::unique_ptr<TensorAdapterBase> StubTensor::clone() const {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  // shares the data, as with copy-on-write
+  return std::unique_ptr<StubTensor>(new StubTensor(shape_, type_, storage_));
 }
 
 Tensor StubTensor::copy() {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return makeTensor(shape_, type_);
 }
 
 Tensor StubTensor::shallowCopy() {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return Tensor(std::unique_ptr<StubTensor>(
+      new StubTensor(shape_, type_, storage_)));
 }
 
 TensorBackendType StubTensor::backendType() const {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return tensorBackendType;
 }
 
 TensorBackend& StubTensor::backend() const {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return StubBackend::getInstance();
 }
 
 const Shape& StubTensor::shape() {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return shape_;
 }
 
 fl::dtype StubTensor::type() {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return type_;
 }
 
 bool StubTensor::isSparse() {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return false;
 }
 
 Location StubTensor::location() {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return Location::Host;
 }
 
-void StubTensor::scalar(void* /* out */) {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+void StubTensor::scalar(void* out) {
+  std::memset(out, 0, getTypeSize(type_));
 }
 
 void StubTensor::device(void** /* out */) {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  throw std::invalid_argument(
+      "StubTensor::device - stub tensors have no device memory");
 }
 
-void StubTensor::host(void* /* out */) {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+void StubTensor::host(void* out) {
+  std::memset(out, 0, getBytes(shape_, type_));
 }
 
-void StubTensor::unlock() {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
-}
+void StubTensor::unlock() {}
 
 bool StubTensor::isLocked() {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return false;
 }
 
 bool StubTensor::isContiguous() {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return true;
+}
+
+DLManagedTensor* StubTensor::toDLPack() {
+  throw std::invalid_argument(
+      "StubTensor::toDLPack - stub tensors have no memory to share");
 }
 
 Shape StubTensor::strides() {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  Shape::Dims strides;
+  Dim stride = 1;
+  for (const auto dim : shape_.get()) {
+    strides.push_back(stride);
+    stride *= dim;
+  }
+  return Shape(strides);
 }
 
 const Stream& StubTensor::stream() const {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return StubBackend::getInstance().stream();
+}
+
+Tensor StubTensor::astype(const dtype type) {
+  if (type == type_) {
+    return shallowCopy();
+  }
+  StubBackend::getInstance().addFlops(shape_.elements());
+  return makeTensor(shape_, type);
 }
 
-Tensor StubTensor::astype(const dtype /* type */) {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+Tensor StubTensor::index(const std::vector<Index>& indices) {
+  return indexArray(indices.data(), indices.size());
 }
 
-Tensor StubTensor::index(const std::vector<Index>& /* indices */) {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+Tensor StubTensor::indexArray(const Index* indices, size_t numIndices) {
+  return makeTensor(getIndexedShape(shape_, indices, numIndices), type_);
 }
 
 Tensor StubTensor::flatten() const {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return Tensor(std::unique_ptr<StubTensor>(
+      new StubTensor(Shape({shape_.elements()}), type_, storage_)));
 }
 
-Tensor StubTensor::flat(const Index& /* idx */) const {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+Tensor StubTensor::flat(const Index& idx) const {
+  const Shape flatShape({shape_.elements()});
+  return makeTensor(getIndexedShape(flatShape, &idx, 1), type_);
 }
 
 Tensor StubTensor::asContiguousTensor() {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return shallowCopy();
 }
 
-void StubTensor::setContext(void* /* context */) {
-  // Used to store arbitrary data on a Tensor - can be a noop.
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+void StubTensor::setContext(void* context) {
+  context_ = context;
 }
 
 void* StubTensor::getContext() {
-  // Used to store arbitrary data on a Tensor - can be a noop.
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  return context_;
 }
 
 std::string StubTensor::toString() {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+  std::ostringstream ss;
+  ss << "StubTensor of shape " << shape_ << " and type " << type_;
+  return ss.str();
 }
 
-std::ostream& StubTensor::operator<<(std::ostream& /* ostr */) {
-  FL_STUB_TENSOR_UNIMPLEMENTED;
+std::ostream& StubTensor::operator<<(std::ostream& ostr) {
+  ostr << toString();
+  return ostr;
 }
 
 /******************** Assignment Operators ********************/
-#define FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, TYPE)            \
-  void StubTensor::OP(const TYPE& /* val */) {             \
-    throw std::invalid_argument(                           \
-        "StubTensor::" + std::string(#OP) + " for type " + \
-        std::string(#TYPE));                               \
+// Writes don't change the shape or the type of a tensor, and arithmetic ones
+// take an operation per element
+#define FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, TYPE, FLOPS) \
+  void StubTensor::OP(const TYPE& /* val */) {         \
+    StubBackend::getInstance().addFlops(FLOPS);        \
   }
 
-#define FL_STUB_TENSOR_ASSIGN_OP(OP)                 \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, Tensor);         \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, double);         \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, float);          \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, int);            \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, unsigned);       \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, bool);           \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, char);           \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, unsigned char);  \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, short);          \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, unsigned short); \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, long);           \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, unsigned long);  \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, long long);      \
-  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, unsigned long long);
-
-FL_STUB_TENSOR_ASSIGN_OP(assign); // =
-FL_STUB_TENSOR_ASSIGN_OP(inPlaceAdd); // +=
-FL_STUB_TENSOR_ASSIGN_OP(inPlaceSubtract); // -=
-FL_STUB_TENSOR_ASSIGN_OP(inPlaceMultiply); // *=
-FL_STUB_TENSOR_ASSIGN_OP(inPlaceDivide); // /=
+#define FL_STUB_TENSOR_ASSIGN_OP(OP, FLOPS)                 \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, Tensor, FLOPS);         \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, double, FLOPS);         \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, float, FLOPS);          \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, int, FLOPS);            \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, unsigned, FLOPS);       \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, bool, FLOPS);           \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, char, FLOPS);           \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, unsigned char, FLOPS);  \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, short, FLOPS);          \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, unsigned short, FLOPS); \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, long, FLOPS);           \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, unsigned long, FLOPS);  \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, long long, FLOPS);      \
+  FL_STUB_TENSOR_ASSIGN_OP_TYPE(OP, unsigned long long, FLOPS);
+
+FL_STUB_TENSOR_ASSIGN_OP(assign, 0); // =
+FL_STUB_TENSOR_ASSIGN_OP(inPlaceAdd, shape_.elements()); // +=
+FL_STUB_TENSOR_ASSIGN_OP(inPlaceSubtract, shape_.elements()); // -=
+FL_STUB_TENSOR_ASSIGN_OP(inPlaceMultiply, shape_.elements()); // *=
+FL_STUB_TENSOR_ASSIGN_OP(inPlaceDivide, shape_.elements()); // /=
 #undef FL_STUB_TENSOR_ASSIGN_OP_TYPE
 #undef FL_STUB_TENSOR_ASSIGN_OP
 
@@ -7,17 +7,39 @@
 
 #pragma once
 
+#include <memory>
+
 #include "flashlight/fl/tensor/TensorAdapter.h"
 
 namespace fl {
 
 /**
- * A stub Tensor implementation to make it easy to get started with the
- * Flashlight Tensor API.
+ * A tensor of the `StubBackend`, which has a shape and a type but no data.
+ *
+ * Ops on stub tensors only propagate shapes and types, such that a model can
+ * run its forward and backward passes symbolically, e.g. to plan its memory
+ * and compute before running it on a real backend (see `StubBackend`). Reading
+ * a stub tensor on the host gives zeros; it has no device memory.
  *
- * This stub can be copied, renamed, and implemented as needed.
+ * Tensors sharing data, e.g. through `shallowCopy`, share the bytes accounted
+ * by the backend, which are released with the last of them.
  */
 class StubTensor : public TensorAdapterBase {
+  // the bytes the tensor would take, accounted by the backend while alive
+  struct Storage {
+    const size_t bytes;
+
+    explicit Storage(size_t bytes);
+    ~Storage();
+  };
+
+  Shape shape_;
+  dtype type_{dtype::f32};
+  std::shared_ptr<Storage> storage_;
+  void* context_{nullptr};
+
+  StubTensor(const Shape& shape, dtype type, std::shared_ptr<Storage> storage);
+
  public:
   constexpr static TensorBackendType tensorBackendType =
       TensorBackendType::Stub;
@@ -25,10 +47,10 @@ class StubTensor : public TensorAdapterBase {
   StubTensor();
 
   /**
-   * Construct a StubTensor using some data.
+   * Construct a StubTensor of a shape and type.
    *
    * @param[in] shape the shape of the new tensor
-   * @param[in] ptr the buffer containing underlying tensor data
+   * @param[in] ptr the buffer containing underlying tensor data, ignored
    * @param[in] type the type of the new tensor
    * @param[in] memoryLocation the location of the buffer
    */
@@ -38,7 +60,8 @@ class StubTensor : public TensorAdapterBase {
       const void* ptr,
       Location memoryLocation);
 
-  // Constructor for a sparse StubTensor. Can throw if unimplemented.
+  // Constructor for a sparse StubTensor, which takes the bytes of its values
+  // and indices.
   StubTensor(
       const Dim nRows,
       const Dim nCols,
@@ -63,10 +86,12 @@ class StubTensor : public TensorAdapterBase {
   void unlock() override;
   bool isLocked() override;
   bool isContiguous() override;
+  DLManagedTensor* toDLPack() override;
   Shape strides() override;
   const Stream& stream() const override;
   Tensor astype(const dtype type) override;
   Tensor index(const std::vector<Index>& indices) override;
+  Tensor indexArray(const Index* indices, size_t numIndices) override;
   Tensor flatten() const override;
   Tensor flat(const Index& idx) const override;
   Tensor asContiguousTensor() override;
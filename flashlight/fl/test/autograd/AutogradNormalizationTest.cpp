@@ -407,6 +407,45 @@ TEST_F(AutogradTestF16, LayerNormJacobianF16) {
   ASSERT_TRUE(fl::detail::jacobianTestImpl(funcLnIn, input, 1e-4, 1e-2));
 }
 
+TEST(AutogradNormalizationTest, LayerNormFused) {
+  const double eps = 1E-5;
+  auto input = Variable(fl::rand({4, 3, 5}), true);
+  auto weight = Variable(fl::rand({12}), true);
+  auto bias = Variable(fl::rand({12}), true);
+
+  // normalizes along the first two axes
+  auto slices = moddims(input, {12, 5});
+  auto mean = fl::mean(slices, {0}, /* keepDims = */ true);
+  auto var = fl::var(slices, {0}, /* isbiased = */ true, /* keepDims = */ true);
+  auto expected = (slices - tileAs(mean, slices)) /
+      tileAs(fl::sqrt(var + eps), slices);
+  expected = tileAs(weight, slices) * expected + tileAs(bias, slices);
+  auto output = layerNorm(input, weight, bias, /* numAxes = */ 2, eps);
+  ASSERT_EQ(output.shape(), input.shape());
+  ASSERT_TRUE(allClose(
+      output.tensor(), moddims(expected, input.shape()).tensor(), 1e-4));
+  auto normalized = (slices - tileAs(mean, slices)) /
+      tileAs(fl::sqrt(var + eps), slices);
+  ASSERT_TRUE(allClose(
+      layerNorm(input, Variable(), Variable(), /* numAxes = */ 2, eps)
+          .tensor(),
+      moddims(normalized, input.shape()).tensor(),
+      1e-4));
+
+  auto funcLnIn = [&](Variable& in) {
+    return layerNorm(in, weight, bias, /* numAxes = */ 2, eps);
+  };
+  ASSERT_TRUE(fl::detail::jacobianTestImpl(funcLnIn, input, 1e-2, 1e-4));
+  auto funcLnWt = [&](Variable& wt) {
+    return layerNorm(input, wt, bias, /* numAxes = */ 2, eps);
+  };
+  ASSERT_TRUE(fl::detail::jacobianTestImpl(funcLnWt, weight, 1e-2, 1e-4));
+  auto funcLnBs = [&](Variable& bs) {
+    return layerNorm(input, weight, bs, /* numAxes = */ 2, eps);
+  };
+  ASSERT_TRUE(fl::detail::jacobianTestImpl(funcLnBs, bias, 1e-2, 1e-4));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
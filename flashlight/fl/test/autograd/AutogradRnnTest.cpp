@@ -205,6 +205,121 @@ TEST_F(AutogradTestF16, GruF16) {
   testRnnImpl(RnnMode::GRU, fl::dtype::f16);
 }
 
+TEST(AutogradRnnTest, VariableLengthRnn) {
+  const int hiddenSize = 3;
+  const int inputSize = 2;
+  const std::vector<int> lengths = {2, 5, 1, 5, 3};
+  const int batchSize = lengths.size();
+  const int seqLength = 5;
+  auto in = Variable(fl::rand({inputSize, batchSize, seqLength}), true);
+
+  for (const bool bidirectional : {false, true}) {
+    const int numLayers = 2;
+    const int totalLayers = numLayers * (bidirectional ? 2 : 1);
+    auto w = Variable(
+        fl::rand({bidirectional ? 432 : 180}, fl::dtype::f32) * 0.2 - 0.1,
+        true);
+    auto hx = Variable(fl::rand({hiddenSize, batchSize, totalLayers}), true);
+    auto cx = Variable(fl::rand({hiddenSize, batchSize, totalLayers}), true);
+    auto [y, hy, cy] =
+        rnn(in,
+            hx,
+            cx,
+            w,
+            lengths,
+            hiddenSize,
+            numLayers,
+            RnnMode::LSTM,
+            bidirectional,
+            0.0);
+    ASSERT_EQ(
+        y.shape(),
+        Shape({hiddenSize * (bidirectional ? 2 : 1), batchSize, seqLength}));
+    ASSERT_EQ(hy.shape(), hx.shape());
+    ASSERT_EQ(cy.shape(), cx.shape());
+
+    // each sample matches an rnn over its steps only
+    for (int i = 0; i < batchSize; ++i) {
+      const auto sample = fl::range(i, i + 1);
+      auto [yi, hyi, cyi] =
+          rnn(in(fl::span, sample, fl::range(0, lengths[i])),
+              hx(fl::span, sample),
+              cx(fl::span, sample),
+              w,
+              hiddenSize,
+              numLayers,
+              RnnMode::LSTM,
+              bidirectional,
+              0.0);
+      ASSERT_TRUE(allClose(
+          y.tensor()(fl::span, sample, fl::range(0, lengths[i])),
+          yi.tensor(),
+          1e-5));
+      if (lengths[i] < seqLength) {
+        ASSERT_EQ(
+            fl::countNonzero(
+                y.tensor()(fl::span, sample, fl::range(lengths[i], seqLength)))
+                .scalar<unsigned>(),
+            0);
+      }
+      ASSERT_TRUE(allClose(hy.tensor()(fl::span, sample), hyi.tensor(), 1e-5));
+      ASSERT_TRUE(allClose(cy.tensor()(fl::span, sample), cyi.tensor(), 1e-5));
+    }
+  }
+
+  EXPECT_THROW(
+      rnn(in,
+          Variable(),
+          Variable(),
+          Variable(fl::rand({180}), true),
+          {1, 2},
+          hiddenSize,
+          2,
+          RnnMode::LSTM,
+          false,
+          0.0),
+      std::invalid_argument);
+  EXPECT_THROW(
+      rnn(in,
+          Variable(),
+          Variable(),
+          Variable(fl::rand({180}), true),
+          {1, 2, 0, 4, 5},
+          hiddenSize,
+          2,
+          RnnMode::LSTM,
+          false,
+          0.0),
+      std::invalid_argument);
+}
+
+TEST(AutogradRnnTest, VariableLengthRnnGrad) {
+  if (FL_BACKEND_CPU) {
+    GTEST_SKIP() << "RNN gradient computation not yet supported on CPU";
+  }
+  const std::vector<int> lengths = {2, 3, 1};
+  auto in = Variable(fl::rand({2, 3, 3}, fl::dtype::f64), true);
+  auto w = Variable(fl::rand({96}, fl::dtype::f64), true);
+  for (const bool bidirectional : {false, true}) {
+    auto wi = bidirectional ? w : w(fl::range(0, 48));
+    auto funcRnnIn = [&](Variable& input) -> Variable {
+      auto [y, hy, cy] =
+          rnn(input,
+              Variable().astype(fl::dtype::f64),
+              Variable().astype(fl::dtype::f64),
+              wi,
+              lengths,
+              2,
+              1,
+              RnnMode::LSTM,
+              bidirectional,
+              0.0);
+      return concatenate({flat(y), flat(hy)}, 0);
+    };
+    ASSERT_TRUE(fl::detail::jacobianTestImpl(funcRnnIn, in, 1e-5, 1e-4));
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
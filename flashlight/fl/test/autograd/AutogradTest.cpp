@@ -12,9 +12,11 @@
 
 #include <gtest/gtest.h>
 
+#include "flashlight/fl/autograd/ActivationOffload.h"
 #include "flashlight/fl/autograd/Functions.h"
 #include "flashlight/fl/autograd/autograd.h"
 #include "flashlight/fl/common/common.h"
+#include "flashlight/fl/optim/Utils.h"
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Init.h"
 #include "flashlight/fl/tensor/Random.h"
@@ -185,6 +187,36 @@ TEST(AutogradTest, NoCalcGrad) {
   ASSERT_THROW(x.grad(), std::logic_error);
 }
 
+TEST(AutogradTest, ActivationOffload) {
+  const auto& offloader = fl::detail::ActivationOffloader::getInstance();
+  auto x = Variable(fl::rand({5}), true);
+  {
+    // offload every saved activation
+    ActivationOffloadScope offload(/* budgetBytes = */ 1);
+    auto y = x * 2;
+    auto z = fl::sin(y * y);
+    ASSERT_EQ(offloader.numOffloaded(), 2);
+    ASSERT_EQ(offloader.residentBytes(), 0);
+    ASSERT_EQ(y.shape(), Shape({5}));
+    ASSERT_EQ(y.type(), fl::dtype::f32);
+    ASSERT_EQ(offloader.numOffloaded(), 2);
+
+    // using an offloaded activation restores it
+    ASSERT_TRUE(allClose(y.tensor(), 2 * x.tensor()));
+    ASSERT_EQ(offloader.numOffloaded(), 1);
+
+    z.backward();
+    ASSERT_EQ(offloader.numOffloaded(), 0);
+  }
+  auto x2 = x.tensor() * x.tensor();
+  ASSERT_TRUE(
+      allClose(x.grad().tensor(), 8 * x.tensor() * fl::cos(4 * x2), 1e-4));
+
+  // disabled outside of the scope
+  auto y = fl::sin(x * 2);
+  ASSERT_EQ(offloader.numOffloaded(), 0);
+}
+
 TEST(AutogradTest, Concatenate) {
   auto x1 = Variable(fl::rand({2, 3, 1, 2}, fl::dtype::f64), true);
   auto x2 = Variable(fl::rand({2, 3, 3, 2}, fl::dtype::f64), true);
@@ -364,6 +396,452 @@ TEST(AutogradTest, Embedding) {
   ASSERT_TRUE(fl::detail::jacobianTestImpl(funcEmbed, weights, 1E-5));
 }
 
+TEST(AutogradTest, EmbeddingSparseGrad) {
+  int nWords = 10;
+  auto input = Variable(Tensor::fromVector<float>({2, 2}, {3, 1, 3, 7}), false);
+  auto weights = Variable(fl::randn({4, nWords}), true);
+  auto sparseWeights = Variable(weights.tensor(), true);
+  embedding(input, weights).backward();
+  embedding(input, sparseWeights, /* sparseGrad = */ true).backward();
+
+  auto& grad = sparseWeights.grad();
+  ASSERT_TRUE(grad.isRowSparse());
+  ASSERT_EQ(grad.shape(), weights.shape());
+  ASSERT_TRUE(allClose(
+      grad.sparseIndices(), Tensor::fromVector<int>({1, 3, 7})));
+  ASSERT_EQ(grad.sparseValues().shape(), Shape({4, 3}));
+  ASSERT_TRUE(allClose(grad.tensor(), weights.grad().tensor()));
+  ASSERT_FALSE(grad.isRowSparse());
+}
+
+TEST(AutogradTest, RowSparseAddGrad) {
+  auto var = Variable(fl::rand({2, 4}), true);
+  auto indices = Tensor::fromVector<int>({2, 0, 2});
+  auto values = fl::rand({2, 3});
+  var.addGrad(Variable::rowSparse(indices, values, var.shape()));
+  var.addGrad(Variable::rowSparse(indices, values, var.shape()));
+  ASSERT_TRUE(var.grad().isRowSparse());
+
+  auto dense = fl::rand({2, 4});
+  var.addGrad(Variable(dense, false));
+  ASSERT_FALSE(var.grad().isRowSparse());
+  auto expected = dense;
+  expected(fl::span, 0) += 2 * values(fl::span, 1);
+  expected(fl::span, 2) += 2 * (values(fl::span, 0) + values(fl::span, 2));
+  ASSERT_TRUE(allClose(var.grad().tensor(), expected));
+
+  EXPECT_THROW(
+      Variable::rowSparse(indices, values, {3, 4}), std::invalid_argument);
+}
+
+TEST(AutogradTest, InPlaceOps) {
+  auto a = Variable(fl::rand({5, 4}) - 0.5, true);
+  auto b = Variable(fl::rand({5, 4}), true);
+  auto expected = fl::sum(fl::relu((a * 2 + b) * 3) * b, {0, 1});
+  expected.backward();
+  auto aGrad = a.grad().tensor();
+  auto bGrad = b.grad().tensor();
+  a.zeroGrad();
+  b.zeroGrad();
+
+  auto x = a * 2;
+  ASSERT_EQ(x.version(), 0);
+  fl::addInPlace(x, b);
+  fl::reluInPlace(fl::scaleInPlace(x, 3));
+  ASSERT_EQ(x.version(), 3);
+  auto loss = fl::sum(x * b, {0, 1});
+  ASSERT_TRUE(allClose(loss, expected, 1e-5));
+  loss.backward();
+  ASSERT_TRUE(allClose(a.grad().tensor(), aGrad, 1e-5));
+  ASSERT_TRUE(allClose(b.grad().tensor(), bGrad, 1e-5));
+
+  // leaves requiring gradients can't be modified in place
+  ASSERT_THROW(fl::addInPlace(a, b), std::invalid_argument);
+  ASSERT_THROW(
+      fl::addInPlace(x, Variable(fl::rand({2}), false)), std::invalid_argument);
+}
+
+TEST(AutogradTest, InPlaceOpsModifiedSavedInput) {
+  auto a = Variable(fl::rand({5}), true);
+  auto b = Variable(fl::rand({5}), true);
+  auto x = a * 2;
+  // the product saves x for its gradient
+  auto y = x * b;
+  fl::addInPlace(x, b);
+  ASSERT_THROW(fl::sum(y, {0}).backward(), std::logic_error);
+
+  // inputs saved without their data may be modified
+  auto z = Variable(a.tensor(), false) + a;
+  auto w = z + b;
+  fl::scaleInPlace(z, 2);
+  fl::sum(w + z, {0}).backward();
+  ASSERT_TRUE(allClose(b.grad().tensor(), fl::full({5}, 1.)));
+}
+
+TEST(AutogradTest, ScaledDotProductAttention) {
+  // spans several tiles of keys
+  const int queryLen = 7, keyLen = 300, dim = 4, valueDim = 5, batch = 2;
+  auto q = Variable(fl::rand({queryLen, dim, batch}, fl::dtype::f64), true);
+  auto k = Variable(fl::rand({keyLen, dim, batch}, fl::dtype::f64), true);
+  auto v = Variable(fl::rand({keyLen, valueDim, batch}, fl::dtype::f64), true);
+  auto mask = Variable(fl::rand({queryLen, keyLen}, fl::dtype::f64), false);
+  auto w =
+      Variable(fl::rand({queryLen, valueDim, batch}, fl::dtype::f64), false);
+
+  auto scores = matmulNT(q, k) / std::sqrt(dim);
+  auto expected = matmul(softmax(scores + tileAs(mask, scores), 1), v);
+  fl::sum(expected * w, {0, 1, 2}).backward();
+  std::vector<Tensor> expectedGrads;
+  for (auto* var : {&q, &k, &v}) {
+    expectedGrads.push_back(var->grad().tensor());
+    var->zeroGrad();
+  }
+
+  auto output = scaledDotProductAttention(q, k, v, mask);
+  ASSERT_EQ(output.shape(), expected.shape());
+  ASSERT_TRUE(allClose(output, expected, 1e-10));
+  fl::sum(output * w, {0, 1, 2}).backward();
+  ASSERT_TRUE(allClose(q.grad().tensor(), expectedGrads[0], 1e-10));
+  ASSERT_TRUE(allClose(k.grad().tensor(), expectedGrads[1], 1e-10));
+  ASSERT_TRUE(allClose(v.grad().tensor(), expectedGrads[2], 1e-10));
+
+  // masks broadcast, e.g. padding masks
+  auto padMask = Variable(fl::rand({1, keyLen, batch}, fl::dtype::f64), false);
+  ASSERT_TRUE(allClose(
+      scaledDotProductAttention(q, k, v, padMask),
+      matmul(softmax(scores + tileAs(padMask, scores), 1), v),
+      1e-10));
+
+  ASSERT_THROW(
+      scaledDotProductAttention(q, k, v.astype(fl::dtype::f32), Variable()),
+      std::invalid_argument);
+  ASSERT_THROW(
+      scaledDotProductAttention(q, k, v, Variable(fl::rand({2, 3}), false)),
+      std::invalid_argument);
+}
+
+TEST(AutogradTest, ScaledDotProductAttentionPacked) {
+  // packed sequences spanning several tiles of keys, one of them empty
+  const std::vector<int64_t> offsets = {0, 100, 100, 250, 320};
+  const int len = 320, dim = 4, valueDim = 5, heads = 2;
+  auto q = Variable(fl::rand({len, dim, heads}, fl::dtype::f64), true);
+  auto k = Variable(fl::rand({len, dim, heads}, fl::dtype::f64), true);
+  auto v = Variable(fl::rand({len, valueDim, heads}, fl::dtype::f64), true);
+  auto w = Variable(fl::rand({len, valueDim, heads}, fl::dtype::f64), false);
+
+  for (bool causal : {false, true}) {
+    // each sequence attends to itself only
+    std::vector<Variable> expectedSeqs;
+    for (int i = 0; i + 1 < offsets.size(); ++i) {
+      const int64_t n = offsets[i + 1] - offsets[i];
+      if (n == 0) {
+        continue;
+      }
+      const auto seq = fl::range(offsets[i], offsets[i + 1]);
+      auto scores = matmulNT(q(seq), k(seq)) / std::sqrt(dim);
+      if (causal) {
+        auto mask = Variable(
+            fl::log(fl::tril(fl::full({n, n}, 1.0, fl::dtype::f64))), false);
+        scores = scores + tileAs(mask, scores);
+      }
+      expectedSeqs.push_back(matmul(softmax(scores, 1), v(seq)));
+    }
+    auto expected = concatenate(expectedSeqs, 0);
+    fl::sum(expected * w, {0, 1, 2}).backward();
+    std::vector<Tensor> expectedGrads;
+    for (auto* var : {&q, &k, &v}) {
+      expectedGrads.push_back(var->grad().tensor());
+      var->zeroGrad();
+    }
+
+    auto output = scaledDotProductAttention(
+        q, k, v, Variable(), 0.0, std::nullopt, offsets, causal);
+    ASSERT_TRUE(allClose(output, expected, 1e-10));
+    fl::sum(output * w, {0, 1, 2}).backward();
+    ASSERT_TRUE(allClose(q.grad().tensor(), expectedGrads[0], 1e-10));
+    ASSERT_TRUE(allClose(k.grad().tensor(), expectedGrads[1], 1e-10));
+    ASSERT_TRUE(allClose(v.grad().tensor(), expectedGrads[2], 1e-10));
+    for (auto* var : {&q, &k, &v}) {
+      var->zeroGrad();
+    }
+  }
+
+  ASSERT_THROW(
+      scaledDotProductAttention(
+          q, k, v, Variable(), 0.0, std::nullopt, {0, 100, 300}),
+      std::invalid_argument);
+}
+
+TEST(AutogradTest, ScaledDotProductAttentionDropout) {
+  const int queryLen = 7, keyLen = 300, dim = 4;
+  auto q = Variable(fl::rand({queryLen, dim, 1}, fl::dtype::f64), true);
+  auto k = Variable(fl::rand({keyLen, dim, 1}, fl::dtype::f64), true);
+  // the output is the attention weights
+  auto v = Variable(fl::identity(keyLen, fl::dtype::f64), true);
+  auto w = Variable(fl::rand({queryLen, keyLen, 1}, fl::dtype::f64), false);
+
+  auto weights = scaledDotProductAttention(q, k, v, Variable(), 0.5);
+  const auto dropped = weights.elements() -
+      fl::countNonzero(weights.tensor()).scalar<unsigned>();
+  ASSERT_GT(dropped, 0);
+  ASSERT_LT(dropped, weights.elements());
+  // the backward pass drops the same weights
+  fl::sum(weights * w, {0, 1, 2}).backward();
+  ASSERT_TRUE(allClose(
+      v.grad().tensor(),
+      fl::matmul(
+          weights.tensor(),
+          w.tensor(),
+          /* lhsProp = */ MatrixProperty::Transpose),
+      1e-10));
+}
+
+TEST(AutogradTest, DropoutMask) {
+  // not a multiple of the 8 elements of a packed byte
+  auto x = Variable(fl::rand({7, 3, 5}, fl::dtype::f64) + 1, true);
+  RandomState state(3);
+  for (const bool counterBased : {false, true}) {
+    x.zeroGrad();
+    auto y = counterBased ? dropout(x, 0.5, state) : dropout(x, 0.5);
+    const auto dropped =
+        y.elements() - fl::countNonzero(y.tensor()).scalar<unsigned>();
+    ASSERT_GT(dropped, 0);
+    ASSERT_LT(dropped, y.elements());
+    // the gradient is the scaled mask of the forward pass
+    y.backward(Variable(fl::full(y.shape(), 1, fl::dtype::f64), false));
+    ASSERT_TRUE(allClose(x.grad().tensor(), y.tensor() / x.tensor(), 1e-10));
+  }
+}
+
+TEST(AutogradTest, BackwardCache) {
+  auto w = Variable(fl::rand({4, 3}), true);
+  auto b = Variable(fl::rand({4}), true);
+  auto step = [&](const Variable& x) {
+    auto y = fl::tanh(fl::matmul(w, x) + fl::tileAs(b, {4, 5}));
+    return fl::sum(y * y, {0, 1});
+  };
+  auto x = Variable(fl::rand({3, 5}), false);
+  step(x).backward();
+  auto wGrad = w.grad().tensor();
+  auto bGrad = b.grad().tensor();
+
+  fl::BackwardCache cache;
+  for (int i = 0; i < 3; ++i) {
+    w.zeroGrad();
+    b.zeroGrad();
+    step(x).backward(cache);
+    ASSERT_TRUE(allClose(w.grad().tensor(), wGrad));
+    ASSERT_TRUE(allClose(b.grad().tensor(), bGrad));
+  }
+  ASSERT_EQ(cache.misses(), 1);
+  ASSERT_EQ(cache.hits(), 2);
+
+  // a graph with a different structure is sorted again
+  w.zeroGrad();
+  fl::sum(w * w, {0, 1}).backward(cache);
+  ASSERT_TRUE(allClose(w.grad().tensor(), 2 * w.tensor()));
+  ASSERT_EQ(cache.misses(), 2);
+
+  // as is one in which distinct nodes of the cached graph are the same
+  auto v = Variable(fl::rand({4, 3}), true);
+  w.zeroGrad();
+  fl::sum(w * v, {0, 1}).backward(cache);
+  w.zeroGrad();
+  fl::sum(w * w, {0, 1}).backward(cache);
+  ASSERT_TRUE(allClose(w.grad().tensor(), 2 * w.tensor()));
+  ASSERT_EQ(cache.misses(), 4);
+}
+
+TEST(AutogradTest, BackwardExecutor) {
+  auto w1 = Variable(fl::rand({4, 3}), true);
+  auto w2 = Variable(fl::rand({4, 3}), true);
+  auto b = Variable(fl::rand({4}), true);
+  auto x = Variable(fl::rand({3, 5}), true);
+  auto loss = [&]() {
+    // two branches from x joining again, and a node with three consumers
+    auto left = fl::tanh(fl::matmul(w1, x));
+    auto right = fl::sigmoid(fl::matmul(w2, x)) + fl::tileAs(b, {4, 5});
+    auto y = left * right;
+    auto z = x(fl::range(0, 2)) * y(fl::range(0, 2));
+    return fl::sum(y * y, {0, 1}) + fl::sum(z, {0, 1});
+  };
+  loss().backward();
+  std::vector<Variable> params = {w1, w2, b, x};
+  std::vector<Tensor> grads;
+  for (auto& param : params) {
+    grads.push_back(param.grad().tensor());
+    param.zeroGrad();
+  }
+
+  BackwardExecutor executor(4);
+  ASSERT_EQ(executor.numThreads(), 4);
+  for (int i = 0; i < 3; ++i) {
+    executor.backward(loss());
+    for (size_t j = 0; j < params.size(); ++j) {
+      ASSERT_TRUE(allClose(params[j].grad().tensor(), grads[j], 1e-5));
+      params[j].zeroGrad();
+    }
+  }
+
+  // exceptions of gradient functions are rethrown
+  auto y = fl::tanh(x);
+  auto bad = Variable(
+      y.tensor(), {y}, [](std::vector<Variable>& inputs, const Variable&) {
+        inputs[0].addGrad(Variable(fl::full({1}, 1.0), false));
+      });
+  ASSERT_THROW(executor.backward(bad), std::invalid_argument);
+  ASSERT_THROW(BackwardExecutor(0), std::invalid_argument);
+}
+
+TEST(AutogradTest, InferenceMode) {
+  auto w = Variable(fl::rand({4, 3}), true);
+  auto x = Variable(fl::rand({3, 5}), true);
+  auto forward = [&]() { return fl::tanh(fl::matmul(w, x)) * 2; };
+  auto expected = forward();
+  ASSERT_TRUE(expected.isCalcGrad());
+  {
+    InferenceModeGuard guard;
+    ASSERT_TRUE(InferenceModeGuard::isEnabled());
+    auto output = forward();
+    ASSERT_FALSE(output.isCalcGrad());
+    ASSERT_TRUE(allClose(output.tensor(), expected.tensor()));
+    {
+      // the graph is built in a nested scope disabling inference mode
+      InferenceModeGuard nested(false);
+      ASSERT_TRUE(forward().isCalcGrad());
+    }
+    ASSERT_TRUE(InferenceModeGuard::isEnabled());
+
+    // leaves requiring gradients may be modified in place
+    auto copy = w;
+    auto version = w.version();
+    fl::addInPlace(copy, Variable(fl::full({4, 3}, 1.0), false));
+    ASSERT_GT(w.version(), version);
+  }
+  ASSERT_FALSE(InferenceModeGuard::isEnabled());
+  // the node saving w before it was modified detects the modification
+  ASSERT_THROW(expected.backward(), std::logic_error);
+}
+
+TEST(AutogradTest, Autocast) {
+  if (!fl::f16Supported()) {
+    GTEST_SKIP() << "Half-precision not supported on this device";
+  }
+  auto w = Variable(fl::rand({4, 3}), true);
+  auto x = Variable(fl::rand({3, 6}), false);
+  auto forward = [&]() {
+    // w is used twice, and cast once
+    auto y = fl::matmul(w, x) + fl::matmul(w, x);
+    return fl::sum(fl::softmax(y, 0) * y, {0, 1});
+  };
+  auto expected = forward();
+  expected.backward();
+  auto expectedGrad = w.grad().tensor();
+  w.zeroGrad();
+
+  Variable loss;
+  {
+    AutocastGuard autocast;
+    ASSERT_TRUE(AutocastGuard::isEnabled());
+    ASSERT_EQ(AutocastGuard::halfPrecisionType(), fl::dtype::f16);
+    ASSERT_EQ(fl::matmul(w, x).type(), fl::dtype::f16);
+    // softmax and reductions run in f32, and promote the product
+    loss = forward();
+    ASSERT_EQ(loss.type(), fl::dtype::f32);
+    ASSERT_EQ(
+        (x + Variable(x.tensor().astype(fl::dtype::f16), false)).type(),
+        fl::dtype::f32);
+    {
+      AutocastGuard nested(false);
+      ASSERT_EQ(fl::matmul(w, x).type(), fl::dtype::f32);
+    }
+    ASSERT_TRUE(AutocastGuard::isEnabled());
+  }
+  ASSERT_FALSE(AutocastGuard::isEnabled());
+  ASSERT_TRUE(allClose(loss.tensor(), expected.tensor(), 1e-1));
+
+  // gradients flow back to the parameter in its type
+  loss.backward();
+  ASSERT_EQ(w.grad().type(), fl::dtype::f32);
+  ASSERT_TRUE(allClose(w.grad().tensor(), expectedGrad, 1e-1));
+  ASSERT_THROW(AutocastGuard(true, fl::dtype::f32), std::invalid_argument);
+}
+
+TEST(AutogradTest, GradientArena) {
+  auto w = Variable(fl::rand({4, 3}), true);
+  auto b = Variable(fl::rand({4}), true);
+  auto v = Variable(fl::rand({5}, fl::dtype::f64), true);
+  auto unused = Variable(fl::rand({2}), true);
+  auto x = Variable(fl::rand({3, 6}), false);
+  auto loss = [&]() {
+    auto y = fl::matmul(w, x) + fl::tileAs(b, {4, 6});
+    return fl::sum(y * y, {0, 1}) +
+        fl::sum(v * v, {0}).astype(fl::dtype::f32) +
+        fl::sum(w, {0, 1}); // w gets two gradients
+  };
+  loss().backward();
+  auto wGrad = w.grad().tensor();
+  auto bGrad = b.grad().tensor();
+  auto vGrad = v.grad().tensor();
+  for (auto* p : {&w, &b, &v}) {
+    p->zeroGrad();
+  }
+
+  fl::GradientArena arena({w, b, v, unused, w});
+  ASSERT_EQ(arena.params().size(), 4);
+  ASSERT_EQ(arena.types().size(), 2);
+  ASSERT_EQ(arena.bytes(), (12 + 4 + 2) * sizeof(float) + 5 * sizeof(double));
+  // a parameter can't belong to two arenas
+  ASSERT_THROW(fl::GradientArena({b}), std::invalid_argument);
+
+  for (int step = 0; step < 2; ++step) {
+    arena.zeroGrad();
+    ASSERT_FALSE(w.isGradAvailable());
+    loss().backward();
+    ASSERT_TRUE(allClose(w.grad().tensor(), wGrad));
+    ASSERT_TRUE(allClose(b.grad().tensor(), bGrad));
+    ASSERT_TRUE(allClose(v.grad().tensor(), vGrad));
+    ASSERT_FALSE(unused.isGradAvailable());
+  }
+
+  // the buffers hold all gradients, in order, and zeros for unused ones
+  auto& buffer = arena.buffer(fl::dtype::f32);
+  ASSERT_TRUE(allClose(
+      buffer,
+      fl::concatenate(
+          0,
+          fl::reshape(wGrad, {12}),
+          bGrad,
+          fl::full({2}, 0, fl::dtype::f32))));
+  ASSERT_TRUE(unused.isGradAvailable());
+  buffer *= 2;
+  ASSERT_TRUE(allClose(w.grad().tensor(), wGrad * 2));
+  ASSERT_TRUE(allClose(arena.buffer(fl::dtype::f64), vGrad));
+
+  // clipping the arena is the same as clipping the parameters
+  auto norm = std::sqrt(
+      fl::sum(wGrad * wGrad * 4).asScalar<double>() +
+      fl::sum(bGrad * bGrad * 4).asScalar<double>() +
+      fl::sum(vGrad * vGrad).asScalar<double>());
+  ASSERT_NEAR(fl::clipGradNorm(arena, norm / 2), norm, norm * 1e-4);
+  ASSERT_TRUE(allClose(v.grad().tensor(), vGrad / 2, 1e-4));
+  ASSERT_TRUE(allClose(b.grad().tensor(), bGrad, 1e-4));
+}
+
+TEST(AutogradTest, GradientArenaLifetime) {
+  auto w = Variable(fl::rand({3, 3}), true);
+  w.addGrad(Variable(fl::full({3, 3}, 1.), false));
+  {
+    fl::GradientArena arena({w});
+    // existing gradients are moved into the arena
+    ASSERT_TRUE(allClose(arena.buffer(fl::dtype::f32), fl::full({9}, 1.)));
+    w.addGrad(Variable(fl::full({3, 3}, 2.), false));
+  }
+  // and out of it once it's gone
+  ASSERT_TRUE(allClose(w.grad().tensor(), fl::full({3, 3}, 3.)));
+  fl::GradientArena arena({w});
+}
+
 TEST(AutogradTest, GetAdvancedIndex) {
   // TODO: remove me
   if (!FL_BACKEND_CUDA) {
@@ -154,6 +154,20 @@ TEST_F(AutogradTestF16, LogSoftmaxF16) {
   ASSERT_TRUE(fl::detail::jacobianTestImpl(funcLsm, in, 1E-2, 1e-1));
 }
 
+TEST(AutogradUnaryOpsTest, SoftmaxInnerAxis) {
+  auto in = Variable(fl::rand({3, 4, 2}, fl::dtype::f64) * 10, true);
+  auto expInput = fl::exp(in.tensor());
+  auto expected = expInput /
+      fl::tile(fl::sum(expInput, {1}, /* keepDims = */ true), {1, 4});
+  ASSERT_TRUE(allClose(softmax(in, 1).tensor(), expected));
+  ASSERT_TRUE(allClose(logSoftmax(in, 1).tensor(), fl::log(expected)));
+
+  auto funcSm = [&](Variable& input) { return softmax(input, 1); };
+  ASSERT_TRUE(fl::detail::jacobianTestImpl(funcSm, in, 1E-5));
+  auto funcLsm = [&](Variable& input) { return logSoftmax(input, 1); };
+  ASSERT_TRUE(fl::detail::jacobianTestImpl(funcLsm, in, 1E-5));
+}
+
 TEST(AutogradUnaryOpsTest, Pow) {
   {
     auto x = Variable(fl::rand({5}), true);
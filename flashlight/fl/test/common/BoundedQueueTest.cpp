@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/common/BoundedQueue.h"
+#include "flashlight/fl/tensor/Init.h"
+
+using namespace fl;
+
+namespace {
+
+TEST(BoundedQueueTest, TryVariants) {
+  BoundedQueue<int> queue(3);
+  ASSERT_EQ(queue.capacity(), 3);
+  int item = 0;
+  ASSERT_FALSE(queue.tryPop(item));
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(queue.tryPush(i));
+  }
+  ASSERT_FALSE(queue.tryPush(3));
+  ASSERT_EQ(queue.size(), 3);
+
+  // FIFO, across the wrap around of the ring
+  for (int round = 0; round < 5; ++round) {
+    ASSERT_TRUE(queue.tryPop(item));
+    ASSERT_EQ(item, round);
+    ASSERT_TRUE(queue.tryPush(round + 3));
+  }
+
+  ASSERT_THROW(BoundedQueue<int>(0), std::invalid_argument);
+}
+
+TEST(BoundedQueueTest, MoveOnly) {
+  BoundedQueue<std::unique_ptr<int>> queue(2);
+  auto item = std::make_unique<int>(42);
+  ASSERT_TRUE(queue.push(std::move(item)));
+  std::unique_ptr<int> popped;
+  ASSERT_TRUE(queue.pop(popped));
+  ASSERT_EQ(*popped, 42);
+}
+
+TEST(BoundedQueueTest, Close) {
+  BoundedQueue<int> queue(4);
+  ASSERT_TRUE(queue.push(1));
+  ASSERT_TRUE(queue.push(2));
+  queue.close();
+  ASSERT_TRUE(queue.isClosed());
+  ASSERT_FALSE(queue.push(3));
+  ASSERT_FALSE(queue.tryPush(3));
+
+  // the remaining items are popped
+  int item = 0;
+  ASSERT_TRUE(queue.pop(item));
+  ASSERT_EQ(item, 1);
+  ASSERT_TRUE(queue.pop(item));
+  ASSERT_EQ(item, 2);
+  ASSERT_FALSE(queue.pop(item));
+
+  // close wakes up blocked threads
+  BoundedQueue<int> empty(1);
+  std::thread consumer([&empty]() {
+    int item = 0;
+    ASSERT_FALSE(empty.pop(item));
+  });
+  BoundedQueue<int> full(1);
+  ASSERT_TRUE(full.push(0));
+  std::thread producer([&full]() { ASSERT_FALSE(full.push(1)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  empty.close();
+  full.close();
+  consumer.join();
+  producer.join();
+}
+
+TEST(BoundedQueueTest, MultiThreads) {
+  const int nElements = 10000;
+  const int nProducers = 4;
+  const int nConsumers = 4;
+  // a small capacity, such that threads block on both ends
+  BoundedQueue<int> queue(8);
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < nProducers; ++p) {
+    producers.emplace_back([&queue, p]() {
+      for (int i = p; i < nElements; i += nProducers) {
+        ASSERT_TRUE(queue.push(i));
+      }
+    });
+  }
+  std::atomic<long> sum{0};
+  std::atomic<int> count{0};
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < nConsumers; ++c) {
+    consumers.emplace_back([&queue, &sum, &count]() {
+      int item = 0;
+      while (queue.pop(item)) {
+        sum += item;
+        ++count;
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  queue.close();
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+  ASSERT_EQ(count, nElements);
+  ASSERT_EQ(sum, static_cast<long>(nElements) * (nElements - 1) / 2);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
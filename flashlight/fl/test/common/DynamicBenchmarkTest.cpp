@@ -12,6 +12,7 @@
 
 #include <gtest/gtest.h>
 
+#include "flashlight/fl/common/BenchmarkCache.h"
 #include "flashlight/fl/common/DynamicBenchmark.h"
 #include "flashlight/fl/tensor/Init.h"
 #include "flashlight/fl/tensor/Compute.h"
@@ -147,6 +148,103 @@ TEST_F(DynamicBenchmark, DynamicBenchmarkMatmul) {
   ASSERT_EQ(ops->currentOption(), 4);
 }
 
+TEST_F(DynamicBenchmark, DynamicBenchmarkCache) {
+  fl::BenchmarkCache::clear();
+  size_t maxCount = 3;
+  std::vector<int> sleepTimes = {4, 2, 6};
+  const std::string key = "DynamicBenchmarkCache (2, 3)";
+
+  auto options =
+      std::make_shared<fl::DynamicBenchmarkOptions<int>>(sleepTimes, maxCount);
+  auto dynamicBench = std::make_shared<fl::DynamicBenchmark>(options);
+  dynamicBench->setCacheKey(key);
+  ASSERT_FALSE(options->timingsComplete());
+  for (size_t i = 0; i < maxCount * sleepTimes.size(); ++i) {
+    std::chrono::milliseconds sleepTime(options->currentOption());
+    dynamicBench->audit(
+        [sleepTime]() { std::this_thread::sleep_for(sleepTime); });
+  }
+  ASSERT_TRUE(options->timingsComplete());
+  ASSERT_EQ(fl::BenchmarkCache::get(key), 1);
+
+  // a benchmark of the same key uses the cached option without timings,
+  // including after reloading the cache
+  auto path = fs::temp_directory_path() / "DynamicBenchmarkCache.txt";
+  fl::BenchmarkCache::save(path);
+  fl::BenchmarkCache::clear();
+  ASSERT_FALSE(fl::BenchmarkCache::get(key).has_value());
+  ASSERT_EQ(fl::BenchmarkCache::load(path), 1);
+  fs::remove(path);
+
+  auto cachedOptions =
+      std::make_shared<fl::DynamicBenchmarkOptions<int>>(sleepTimes, maxCount);
+  fl::DynamicBenchmark cachedBench(cachedOptions);
+  cachedBench.setCacheKey(key);
+  ASSERT_TRUE(cachedOptions->timingsComplete());
+  ASSERT_EQ(cachedOptions->currentOption(), 2);
+
+  // out of range options are ignored
+  fl::BenchmarkCache::set(key, sleepTimes.size());
+  auto otherOptions =
+      std::make_shared<fl::DynamicBenchmarkOptions<int>>(sleepTimes, maxCount);
+  fl::DynamicBenchmark otherBench(otherOptions);
+  otherBench.setCacheKey(key);
+  ASSERT_FALSE(otherOptions->timingsComplete());
+}
+
+TEST_F(DynamicBenchmark, DynamicBenchmarkFrozen) {
+  fl::BenchmarkCache::clear();
+  fl::DynamicBenchmark::setFrozen(true);
+  size_t maxCount = 2;
+  std::vector<int> options = {1, 2, 3};
+  const std::string key = "DynamicBenchmarkFrozen (4)";
+
+  // without a cached option, nothing is timed and the default is used
+  auto uncached =
+      std::make_shared<fl::DynamicBenchmarkOptions<int>>(options, maxCount);
+  fl::DynamicBenchmark uncachedBench(uncached);
+  uncachedBench.setCacheKey(key);
+  ASSERT_FALSE(uncachedBench.useOptions());
+  int calls = 0;
+  for (size_t i = 0; i < maxCount * options.size(); ++i) {
+    uncachedBench.audit([&calls]() { ++calls; });
+  }
+  ASSERT_EQ(calls, maxCount * options.size());
+  ASSERT_FALSE(uncached->timingsComplete());
+  ASSERT_FALSE(fl::BenchmarkCache::get(key).has_value());
+
+  // a cached option is used right away
+  fl::BenchmarkCache::set(key, 2);
+  auto cached =
+      std::make_shared<fl::DynamicBenchmarkOptions<int>>(options, maxCount);
+  fl::DynamicBenchmark cachedBench(cached);
+  cachedBench.setCacheKey(key);
+  ASSERT_TRUE(cachedBench.useOptions());
+  ASSERT_EQ(cached->currentOption(), 3);
+
+  fl::DynamicBenchmark::setFrozen(false);
+  ASSERT_TRUE(uncachedBench.useOptions());
+  fl::BenchmarkCache::clear();
+}
+
+TEST_F(DynamicBenchmark, BenchmarkCacheMerge) {
+  fl::BenchmarkCache::clear();
+  fl::BenchmarkCache::set("a", 1);
+  fl::BenchmarkCache::set("b", 2);
+  ASSERT_THROW(fl::BenchmarkCache::set("c\td", 0), std::invalid_argument);
+  const auto data = fl::BenchmarkCache::serialize();
+
+  fl::BenchmarkCache::clear();
+  fl::BenchmarkCache::set("b", 0);
+  ASSERT_EQ(fl::BenchmarkCache::deserialize(data, /* overwrite = */ false), 1);
+  ASSERT_EQ(fl::BenchmarkCache::get("a"), 1);
+  ASSERT_EQ(fl::BenchmarkCache::get("b"), 0);
+  ASSERT_EQ(fl::BenchmarkCache::deserialize(data), 1);
+  ASSERT_EQ(fl::BenchmarkCache::get("b"), 2);
+  ASSERT_EQ(fl::BenchmarkCache::entries().size(), 2);
+  fl::BenchmarkCache::clear();
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
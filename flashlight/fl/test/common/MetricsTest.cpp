@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/common/Metrics.h"
+#include "flashlight/fl/tensor/Init.h"
+
+using namespace fl;
+
+namespace {
+
+bool contains(const std::string& text, const std::string& line) {
+  return text.find(line + "\n") != std::string::npos;
+}
+
+TEST(MetricsTest, Counter) {
+  auto& registry = MetricsRegistry::getInstance();
+  auto& counter = registry.counter("test_counter_total", "A counter");
+  counter.inc();
+  counter.inc(2.5);
+  ASSERT_DOUBLE_EQ(counter.value(), 3.5);
+  // registering again gets the same counter
+  ASSERT_EQ(&registry.counter("test_counter_total", "A counter"), &counter);
+  ASSERT_NE(
+      &registry.counter("test_counter_total", "A counter", {{"a", "b"}}),
+      &counter);
+}
+
+TEST(MetricsTest, ConcurrentCounter) {
+  auto& counter =
+      MetricsRegistry::getInstance().counter("test_concurrent_total", "");
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&counter]() {
+      for (int j = 0; j < 10000; ++j) {
+        counter.inc();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_DOUBLE_EQ(counter.value(), 40000);
+}
+
+TEST(MetricsTest, Gauge) {
+  auto& gauge = MetricsRegistry::getInstance().gauge("test_gauge", "A gauge");
+  gauge.set(5);
+  gauge.add(-2);
+  ASSERT_DOUBLE_EQ(gauge.value(), 3);
+}
+
+TEST(MetricsTest, Histogram) {
+  HistogramMetric histogram({1, 2, 4});
+  for (double value : {0.5, 1., 1.5, 3., 10.}) {
+    histogram.observe(value);
+  }
+  // bounds are inclusive, and the last bucket is +Inf
+  ASSERT_EQ(histogram.bucketCounts(), std::vector<uint64_t>({2, 1, 1, 1}));
+  ASSERT_DOUBLE_EQ(histogram.sum(), 16);
+  ASSERT_THROW(HistogramMetric({2, 1}), std::invalid_argument);
+  ASSERT_EQ(
+      HistogramMetric::exponentialBounds(1, 2, 4),
+      std::vector<double>({1, 2, 4, 8}));
+}
+
+TEST(MetricsTest, InvalidRegistrations) {
+  auto& registry = MetricsRegistry::getInstance();
+  ASSERT_THROW(registry.counter("0starts_with_digit", ""), std::exception);
+  ASSERT_THROW(registry.counter("has-dash", ""), std::exception);
+  ASSERT_THROW(
+      registry.counter("label", "", {{"bad-label", ""}}), std::exception);
+  ASSERT_THROW(registry.counter("label", "", {{"le", ""}}), std::exception);
+  registry.gauge("test_typed", "");
+  ASSERT_THROW(registry.counter("test_typed", ""), std::exception);
+}
+
+TEST(MetricsTest, Serialize) {
+  auto& registry = MetricsRegistry::getInstance();
+  registry.counter("test_ser_total", "Samples\nseen", {{"set", "a\"b"}})
+      .inc(3);
+  registry.gauge("test_ser_gauge", "A gauge").set(0.5);
+  auto& histogram = registry.histogram(
+      "test_ser_seconds", "Latency", {0.1, 1}, {{"stage", "load"}});
+  histogram.observe(0.05);
+  histogram.observe(2);
+
+  const auto text = registry.serialize();
+  ASSERT_TRUE(contains(text, "# HELP test_ser_total Samples\\nseen"));
+  ASSERT_TRUE(contains(text, "# TYPE test_ser_total counter"));
+  ASSERT_TRUE(contains(text, "test_ser_total{set=\"a\\\"b\"} 3"));
+  ASSERT_TRUE(contains(text, "# TYPE test_ser_gauge gauge"));
+  ASSERT_TRUE(contains(text, "test_ser_gauge 0.5"));
+  ASSERT_TRUE(contains(text, "# TYPE test_ser_seconds histogram"));
+  ASSERT_TRUE(
+      contains(text, "test_ser_seconds_bucket{stage=\"load\",le=\"0.1\"} 1"));
+  ASSERT_TRUE(
+      contains(text, "test_ser_seconds_bucket{stage=\"load\",le=\"1\"} 1"));
+  ASSERT_TRUE(
+      contains(text, "test_ser_seconds_bucket{stage=\"load\",le=\"+Inf\"} 2"));
+  ASSERT_TRUE(contains(text, "test_ser_seconds_sum{stage=\"load\"} 2.05"));
+  ASSERT_TRUE(contains(text, "test_ser_seconds_count{stage=\"load\"} 2"));
+}
+
+TEST(MetricsTest, FileDump) {
+  auto& registry = MetricsRegistry::getInstance();
+  registry.gauge("test_dump_gauge", "").set(7);
+  const auto path = fs::temp_directory_path() / "fl_metrics_test.prom";
+
+  registry.writeToFile(path);
+  std::ifstream file(path);
+  std::stringstream text;
+  text << file.rdbuf();
+  ASSERT_EQ(text.str(), registry.serialize());
+
+  fs::remove(path);
+  registry.startFileDump(path, 3600);
+  // stopping writes a last dump
+  registry.stopFileDump();
+  ASSERT_TRUE(fs::exists(path));
+  fs::remove(path);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/common/PoolAllocator.h"
+#include "flashlight/fl/tensor/Init.h"
+
+using namespace fl;
+using fl::detail::BlockPool;
+
+namespace {
+
+TEST(PoolAllocatorTest, ReusesFreedBlocks) {
+  const size_t bytes = 40;
+  const auto cached = BlockPool::cachedBlocks(bytes);
+  void* block = BlockPool::allocate(bytes);
+  BlockPool::deallocate(block, bytes);
+  ASSERT_EQ(BlockPool::cachedBlocks(bytes), cached + 1);
+  // sizes of the same granule share blocks
+  ASSERT_EQ(BlockPool::allocate(bytes + 1), block);
+  ASSERT_EQ(BlockPool::cachedBlocks(bytes), cached);
+  BlockPool::deallocate(block, bytes + 1);
+}
+
+TEST(PoolAllocatorTest, LargeBlocks) {
+  const size_t bytes = BlockPool::kMaxBlockSize + 1;
+  void* block = BlockPool::allocate(bytes);
+  ASSERT_NE(block, nullptr);
+  BlockPool::deallocate(block, bytes);
+  ASSERT_EQ(BlockPool::cachedBlocks(bytes), 0);
+}
+
+TEST(PoolAllocatorTest, BoundedCache) {
+  const size_t bytes = BlockPool::kGranularity;
+  std::vector<void*> blocks(BlockPool::kMaxCachedBlocks + 8);
+  for (auto& block : blocks) {
+    block = BlockPool::allocate(bytes);
+  }
+  for (auto* block : blocks) {
+    BlockPool::deallocate(block, bytes);
+  }
+  ASSERT_EQ(BlockPool::cachedBlocks(bytes), BlockPool::kMaxCachedBlocks);
+}
+
+TEST(PoolAllocatorTest, SharedPointers) {
+  struct Node {
+    int value;
+    std::shared_ptr<Node> next;
+  };
+  auto head = std::allocate_shared<Node>(PoolAllocator<Node>(), Node{0});
+  for (int i = 1; i < 100; ++i) {
+    head = std::allocate_shared<Node>(PoolAllocator<Node>(), Node{i, head});
+  }
+  int expected = 99;
+  for (auto* node = head.get(); node; node = node->next.get()) {
+    ASSERT_EQ(node->value, expected--);
+  }
+  ASSERT_EQ(expected, -1);
+
+  std::vector<int, PoolAllocator<int>> vec;
+  for (int i = 0; i < 100; ++i) {
+    vec.push_back(i);
+  }
+  ASSERT_EQ(vec[99], 99);
+}
+
+TEST(PoolAllocatorTest, CrossThreadFree) {
+  // blocks may be freed by other threads
+  std::shared_ptr<int> value;
+  std::thread([&value]() {
+    value = std::allocate_shared<int>(PoolAllocator<int>(), 42);
+  }).join();
+  ASSERT_EQ(*value, 42);
+  value.reset();
+
+  std::vector<void*> blocks(16);
+  for (auto& block : blocks) {
+    block = BlockPool::allocate(64);
+  }
+  std::thread([&blocks]() {
+    for (auto* block : blocks) {
+      BlockPool::deallocate(block, 64);
+    }
+    ASSERT_EQ(BlockPool::cachedBlocks(64), blocks.size());
+  }).join();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
@@ -6,6 +6,7 @@
  */
 
 #include <cmath>
+#include <fstream>
 #include <sstream>
 #include <string>
 #include <type_traits>
@@ -15,6 +16,9 @@
 #include <gtest/gtest.h>
 
 #include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/common/MappedCheckpoint.h"
 #include "flashlight/fl/common/Serialization.h"
 
 // ========== utility functions ==========
@@ -239,6 +243,121 @@ TEST(SerializationTest, TemporaryRvalues) {
   ASSERT_EQ(t.z, 73);
 }
 
+// ========== external tensors ==========
+
+TEST(SerializationTest, ExternalTensors) {
+  std::vector<fl::Tensor> tensors = {
+      fl::full({2, 3}, 1.5), fl::full({4}, 2, fl::dtype::s32)};
+  fl::detail::ExternalTensors external;
+  std::string data;
+  {
+    fl::detail::ExternalTensorsScope scope(&external);
+    data = saveToString(tensors);
+  }
+  // the archive only holds the indices of the tensors
+  ASSERT_EQ(external.tensors.size(), tensors.size());
+  ASSERT_LT(data.size(), saveToString(tensors).size());
+  ASSERT_EQ(fl::detail::ExternalTensors::current(), nullptr);
+
+  std::vector<fl::Tensor> loaded;
+  {
+    fl::detail::ExternalTensorsScope scope(&external);
+    loadFromString(data, loaded);
+  }
+  ASSERT_EQ(loaded.size(), tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    ASSERT_TRUE(fl::all(loaded[i] == tensors[i]).scalar<char>());
+  }
+
+  fl::detail::ExternalTensors empty;
+  fl::detail::ExternalTensorsScope scope(&empty);
+  ASSERT_THROW(loadFromString(data, loaded), cereal::Exception);
+}
+
+// ========== asynchronous saves ==========
+
+TEST(SerializationTest, SaveAsync) {
+  const auto path = fs::temp_directory_path() / "fl_save_async.bin";
+  auto tensor = fl::full({3, 4}, 2.5);
+  std::vector<fl::Tensor> tensors = {fl::arange({5}, 0, fl::dtype::s32)};
+  const auto expected = tensor.copy();
+  const auto expectedVector = tensors[0].copy();
+  auto saved = fl::saveAsync(path.string(), std::string("v1"), tensor, tensors);
+  // modified while saving: the snapshots are saved
+  tensor += 1;
+  tensors[0] = tensors[0] * 2;
+  saved.get();
+
+  std::string version;
+  fl::Tensor loaded;
+  std::vector<fl::Tensor> loadedVector;
+  fl::load(path.string(), version, loaded, loadedVector);
+  ASSERT_EQ(version, "v1");
+  ASSERT_TRUE(fl::all(loaded == expected).scalar<char>());
+  ASSERT_EQ(loadedVector.size(), 1);
+  ASSERT_TRUE(fl::all(loadedVector[0] == expectedVector).scalar<char>());
+  fs::remove(path);
+
+  auto failed = fl::saveAsync(
+      (fs::temp_directory_path() / "fl_no_such_dir" / "x.bin").string(),
+      tensor);
+  ASSERT_THROW(failed.get(), std::runtime_error);
+}
+
+// ========== mapped checkpoints ==========
+
+TEST(SerializationTest, MappedCheckpoint) {
+  const auto path = fs::temp_directory_path() / "fl_mapped_checkpoint.flc";
+  std::vector<fl::Tensor> tensors = {
+      fl::full({2, 3}, 1.5),
+      fl::full({4}, 2, fl::dtype::s32),
+      fl::Tensor({0}, fl::dtype::f32),
+      fl::arange({100, 7}, 0, fl::dtype::f64)};
+  const std::string name = "model";
+  fl::MappedCheckpoint::save(path, name, tensors);
+  ASSERT_TRUE(fl::MappedCheckpoint::isMappedCheckpoint(path));
+
+  fl::MappedCheckpoint checkpoint(path);
+  ASSERT_EQ(checkpoint.numTensors(), tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const auto& info = checkpoint.tensorInfo(i);
+    ASSERT_EQ(info.shape, tensors[i].shape());
+    ASSERT_EQ(info.type, tensors[i].type());
+    ASSERT_EQ(info.offset % fl::MappedCheckpoint::kTensorAlignment, 0);
+  }
+  // on demand
+  ASSERT_TRUE(fl::all(checkpoint.tensor(3) == tensors[3]).scalar<char>());
+  ASSERT_THROW(checkpoint.tensor(tensors.size()), std::out_of_range);
+
+  std::string loadedName;
+  std::vector<fl::Tensor> loaded;
+  checkpoint.loadWith(3, loadedName, loaded);
+  ASSERT_EQ(loadedName, name);
+  ASSERT_EQ(loaded.size(), tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    ASSERT_EQ(loaded[i].shape(), tensors[i].shape());
+    ASSERT_EQ(loaded[i].type(), tensors[i].type());
+    if (tensors[i].elements() > 0) {
+      ASSERT_TRUE(fl::all(loaded[i] == tensors[i]).scalar<char>());
+    }
+  }
+  fs::remove(path);
+}
+
+TEST(SerializationTest, MappedCheckpointInvalid) {
+  const auto path = fs::temp_directory_path() / "fl_mapped_invalid.flc";
+  fl::save(path.string(), std::string("not a mapped checkpoint"));
+  ASSERT_FALSE(fl::MappedCheckpoint::isMappedCheckpoint(path));
+  ASSERT_THROW(fl::MappedCheckpoint{path}, std::runtime_error);
+
+  fl::MappedCheckpoint::save(path, fl::full({1000}, 1.));
+  const auto size = fs::file_size(path);
+  fs::resize_file(path, size - 8);
+  ASSERT_THROW(fl::MappedCheckpoint{path}, std::runtime_error);
+  fs::remove(path);
+  ASSERT_THROW(fl::MappedCheckpoint{path}, std::runtime_error);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
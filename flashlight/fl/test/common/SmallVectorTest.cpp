@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/common/SmallVector.h"
+#include "flashlight/fl/tensor/Init.h"
+
+using namespace fl;
+
+namespace {
+
+using Vec = SmallVector<long long, 3>;
+
+TEST(SmallVectorTest, Construction) {
+  ASSERT_TRUE(Vec().empty());
+  ASSERT_EQ(Vec(2, 7), Vec({7, 7}));
+  ASSERT_EQ(Vec(2), Vec({0, 0}));
+
+  const std::vector<long long> vec = {1, 2, 3, 4, 5};
+  Vec fromVec(vec);
+  ASSERT_EQ(fromVec.size(), 5);
+  ASSERT_EQ(fromVec, vec);
+  std::vector<long long> toVec = fromVec;
+  ASSERT_EQ(toVec, vec);
+  ASSERT_EQ(Vec(vec.begin() + 1, vec.begin() + 3), Vec({2, 3}));
+}
+
+TEST(SmallVectorTest, InlineToHeap) {
+  Vec v = {1, 2};
+  for (long long i = 3; i <= 5; ++i) {
+    v.push_back(i);
+  }
+  ASSERT_EQ(v, Vec({1, 2, 3, 4, 5}));
+  ASSERT_EQ(v.back(), 5);
+
+  // copies are independent of their source, inline or not
+  Vec copy = v;
+  copy[0] = 10;
+  ASSERT_EQ(v.front(), 1);
+  v.resize(2);
+  ASSERT_EQ(v, Vec({1, 2}));
+  ASSERT_EQ(copy, Vec({10, 2, 3, 4, 5}));
+
+  copy.pop_back();
+  copy.pop_back();
+  copy.pop_back();
+  ASSERT_EQ(copy, Vec({10, 2}));
+  copy.resize(4, 9);
+  ASSERT_EQ(copy, Vec({10, 2, 9, 9}));
+  copy.clear();
+  ASSERT_TRUE(copy.empty());
+}
+
+TEST(SmallVectorTest, InsertErase) {
+  Vec v = {1, 4};
+  v.insert(v.begin() + 1, 2, 0);
+  ASSERT_EQ(v, Vec({1, 0, 0, 4}));
+  v.erase(v.begin() + 1, v.begin() + 3);
+  ASSERT_EQ(v, Vec({1, 4}));
+
+  // a range of the vector itself
+  v.insert(v.end(), v.begin(), v.end());
+  ASSERT_EQ(v, Vec({1, 4, 1, 4}));
+  v.erase(v.begin());
+  ASSERT_EQ(v, Vec({4, 1, 4}));
+  v.insert(v.begin(), 3);
+  ASSERT_EQ(v, Vec({3, 4, 1, 4}));
+}
+
+TEST(SmallVectorTest, Algorithms) {
+  Vec v = {3, 1, 4, 1, 5};
+  std::sort(v.begin(), v.end());
+  ASSERT_EQ(v, Vec({1, 1, 3, 4, 5}));
+  std::reverse(v.begin(), v.end());
+  ASSERT_EQ(v, Vec({5, 4, 3, 1, 1}));
+  ASSERT_EQ(std::vector<long long>(v.rbegin(), v.rend()).front(), 1);
+  ASSERT_THROW(v.at(5), std::out_of_range);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
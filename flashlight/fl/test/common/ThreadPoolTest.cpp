@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/common/threadpool/ThreadPool.h"
+#include "flashlight/fl/tensor/Init.h"
+
+using namespace fl;
+
+namespace {
+
+TEST(ThreadPoolTest, Enqueue) {
+  ThreadPool pool(4);
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 100; ++i) {
+    results.push_back(pool.enqueue([](int x) { return x * x; }, i));
+  }
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(results[i].get(), i * i);
+  }
+
+  auto error = pool.enqueue([]() -> int { throw std::runtime_error("task"); });
+  ASSERT_THROW(error.get(), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, InitFn) {
+  std::atomic<size_t> initialized{0};
+  {
+    ThreadPool pool(3, [&](size_t) { ++initialized; });
+  }
+  ASSERT_EQ(initialized, 3);
+}
+
+TEST(ThreadPoolTest, NestedTasks) {
+  // the only worker waits for the tasks it enqueues, which it runs itself
+  ThreadPool pool(1);
+  auto outer = pool.enqueue([&pool]() {
+    std::vector<std::future<int>> inner;
+    for (int i = 0; i < 10; ++i) {
+      inner.push_back(pool.enqueue([i]() { return i; }));
+    }
+    int sum = 0;
+    for (auto& result : inner) {
+      pool.wait(result);
+      sum += result.get();
+    }
+    return sum;
+  });
+  pool.wait(outer);
+  ASSERT_EQ(outer.get(), 45);
+}
+
+TEST(ThreadPoolTest, Priorities) {
+  ThreadPool pool(1);
+  // block the only worker while the tasks are enqueued
+  std::promise<void> unblock;
+  auto blocked = unblock.get_future().share();
+  auto blocker = pool.enqueue([blocked]() { blocked.wait(); });
+
+  std::mutex mutex;
+  std::vector<TaskPriority> order;
+  const auto record = [&](TaskPriority priority) {
+    std::lock_guard<std::mutex> lock(mutex);
+    order.push_back(priority);
+  };
+  for (const auto priority :
+       {TaskPriority::Low, TaskPriority::Normal, TaskPriority::High}) {
+    pool.enqueueWithPriority(priority, record, priority);
+  }
+  unblock.set_value();
+  pool.wait();
+  ASSERT_EQ(
+      order,
+      std::vector<TaskPriority>(
+          {TaskPriority::High, TaskPriority::Normal, TaskPriority::Low}));
+}
+
+TEST(ThreadPoolTest, WaitAll) {
+  std::atomic<int> count{0};
+  {
+    ThreadPool pool(2);
+    for (int i = 0; i < 1000; ++i) {
+      pool.enqueue([&count]() { ++count; });
+    }
+    pool.wait();
+    ASSERT_EQ(count, 1000);
+
+    auto waitInTask = pool.enqueue([&pool]() { pool.wait(); });
+    ASSERT_THROW(waitInTask.get(), std::logic_error);
+  }
+
+  // without workers, tasks run on the waiting thread
+  ThreadPool pool(0);
+  auto result = pool.enqueue([]() { return 42; });
+  pool.wait(result);
+  ASSERT_EQ(result.get(), 42);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
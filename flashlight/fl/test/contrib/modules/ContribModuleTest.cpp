@@ -10,6 +10,7 @@
 #include "flashlight/fl/autograd/autograd.h"
 #include "flashlight/fl/common/common.h"
 #include "flashlight/fl/contrib/modules/modules.h"
+#include "flashlight/fl/dataset/Utils.h"
 #include "flashlight/fl/nn/nn.h"
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Random.h"
@@ -236,6 +237,159 @@ TEST_F(ContribModuleTestF16, TransformerFwdF16) {
   transformerFwd(true);
 }
 
+TEST(ContribModuleTest, TransformerIncremental) {
+  int batchsize = 3;
+  int timesteps = 6;
+  int c = 16;
+  int nheads = 4;
+
+  for (int bptt : {0, 8}) {
+    auto tr = Transformer(c, c / nheads, c, nheads, bptt, 0.2, 0.1, true);
+    tr.eval();
+    auto input = Variable(fl::rand({c, timesteps, batchsize}), false);
+    auto expected = tr.forward({input, Variable()}).front();
+
+    // one step, then several at once, then one at a time
+    TransformerCache cache;
+    std::vector<Variable> outputs;
+    std::vector<std::pair<int, int>> chunks = {{0, 1}, {1, 4}, {4, 5}, {5, 6}};
+    for (const auto& [start, end] : chunks) {
+      Variable output;
+      std::tie(output, cache) = tr.forwardIncremental(
+          input(fl::span, fl::range(start, end)), std::move(cache));
+      ASSERT_EQ(cache.length, end);
+      ASSERT_GE(cache.capacity(), end);
+      outputs.push_back(output);
+    }
+    ASSERT_TRUE(allClose(concatenate(outputs, 1), expected, 1e-5));
+
+    // a batch element continues on its own
+    auto single = cache.select(1);
+    ASSERT_EQ(single.length, timesteps);
+    ASSERT_EQ(single.keys.dim(2), 1);
+    auto batched = TransformerCache::concatenate({single, single});
+    ASSERT_EQ(batched.keys.dim(2), 2);
+    ASSERT_EQ(batched.length, timesteps);
+
+    // batch elements are reordered with a gather
+    auto gathered = cache.gather(Tensor::fromVector<int>({2, 0, 0}));
+    ASSERT_EQ(gathered.length, timesteps);
+    ASSERT_EQ(gathered.keys.dim(2), 3);
+    ASSERT_TRUE(allClose(
+        gathered.keys(fl::span, fl::span, fl::range(1, 2)),
+        cache.select(0).keys));
+    ASSERT_TRUE(allClose(
+        gathered.values(fl::span, fl::span, fl::range(0, 1)),
+        cache.select(2).values));
+  }
+}
+
+TEST(ContribModuleTest, TransformerSlidingWindow) {
+  int batchsize = 3;
+  int c = 16;
+  int nheads = 4;
+
+  auto tr = Transformer(c, c / nheads, c, nheads, 0, 0.2, 0.1, true);
+  tr.eval();
+  auto input = Variable(fl::rand({c, 6, batchsize}), false);
+
+  // the last 2 steps of the cache are the context of the next ones
+  TransformerCache cache;
+  Variable output;
+  std::tie(output, cache) =
+      tr.forwardIncremental(input(fl::span, fl::range(0, 4)), std::move(cache));
+  cache.keepLast(2);
+  ASSERT_EQ(cache.length, 2);
+  std::tie(output, cache) =
+      tr.forwardIncremental(input(fl::span, fl::range(4, 6)), std::move(cache));
+  ASSERT_EQ(cache.length, 4);
+
+  auto expected =
+      tr.forward({input(fl::span, fl::range(2, 6)), Variable()}).front();
+  ASSERT_TRUE(allClose(output, expected(fl::span, fl::range(2, 4)), 1e-5));
+}
+
+TEST(ContribModuleTest, TransformerPacked) {
+  int c = 16;
+  int nheads = 4;
+
+  auto tr = Transformer(c, c / nheads, c, nheads, 0, 0.2, 0.1, true);
+  tr.eval();
+  std::vector<Tensor> sequences = {
+      fl::rand({c, 5}), fl::rand({c, 1}), fl::rand({c, 7})};
+  auto packed = fl::packBatch(sequences, 1);
+  ASSERT_EQ(packed.offsets, std::vector<int64_t>({0, 5, 6, 13}));
+
+  // each sequence is forwarded as if alone, without padding
+  auto output = tr.forwardPacked(
+      Variable(fl::reshape(packed.data, {c, 13, 1}), false), packed.offsets);
+  ASSERT_EQ(output.shape(), Shape({c, 13, 1}));
+  for (int i = 0; i < sequences.size(); ++i) {
+    auto expected =
+        tr.forward({Variable(sequences[i], false), Variable()}).front();
+    auto steps = fl::range(packed.offsets[i], packed.offsets[i + 1]);
+    ASSERT_TRUE(allClose(output(fl::span, steps), expected, 1e-5));
+  }
+}
+
+TEST(ContribModuleTest, TransformerPaged) {
+  int c = 16;
+  int nheads = 4;
+
+  auto tr = Transformer(c, c / nheads, c, nheads, 0, 0.2, 0.1, true);
+  tr.eval();
+  auto pool = tr.createBlockPool(8, 2);
+  ASSERT_EQ(pool.numBlocks(), 8);
+  // sequences of 5 and 3 steps, in blocks of any order
+  std::vector<TransformerPagedSequence> sequences(2);
+  sequences[0].blocks = {6, 1, 3};
+  sequences[1].blocks = {0, 7};
+  std::vector<Tensor> seqs = {fl::rand({c, 5, 1}), fl::rand({c, 3, 1})};
+
+  // 3 and 1 steps of each, and the remaining 2 of each, padded to 3
+  sequences[0].steps = 3;
+  sequences[1].steps = 1;
+  auto first = fl::full({c, 3, 2}, 0.0);
+  first(fl::span, fl::span, fl::range(0, 1)) =
+      seqs[0](fl::span, fl::range(0, 3));
+  first(fl::span, fl::range(0, 1), fl::range(1, 2)) =
+      seqs[1](fl::span, fl::range(0, 1));
+  auto firstOutput = tr.forwardPaged(Variable(first, false), pool, sequences);
+  sequences[0].length = 3;
+  sequences[0].steps = 2;
+  sequences[1].length = 1;
+  sequences[1].steps = 2;
+  auto second = fl::full({c, 2, 2}, 0.0);
+  second(fl::span, fl::span, fl::range(0, 1)) =
+      seqs[0](fl::span, fl::range(3, 5));
+  second(fl::span, fl::span, fl::range(1, 2)) =
+      seqs[1](fl::span, fl::range(1, 3));
+  auto secondOutput =
+      tr.forwardPaged(Variable(second, false), pool, sequences);
+
+  for (int b = 0; b < 2; ++b) {
+    auto expected = tr.forwardIncremental(
+                          Variable(seqs[b], false), TransformerCache())
+                        .first;
+    const int n = sequences[b].length;
+    const auto batch = fl::range(b, b + 1);
+    ASSERT_TRUE(allClose(
+        firstOutput(fl::span, fl::range(0, n), batch),
+        expected(fl::span, fl::range(0, n)),
+        1e-5));
+    ASSERT_TRUE(allClose(
+        secondOutput(fl::span, fl::span, batch),
+        expected(fl::span, fl::range(n, n + 2)),
+        1e-5));
+  }
+
+  // the blocks must hold the new steps
+  sequences[1].length = 3;
+  ASSERT_THROW(
+      tr.forwardPaged(Variable(second, false), pool, sequences),
+      std::invalid_argument);
+}
+
 void conformerFwd(bool isfp16) {
   int batchsize = 10;
   int timesteps = 120;
@@ -269,6 +423,47 @@ TEST_F(ContribModuleTestF16, ConformerFwdF16) {
   conformerFwd(true);
 }
 
+TEST(ContribModuleTest, ConformerStreaming) {
+  int batchsize = 2;
+  int timesteps = 12;
+  int c = 16;
+  int nheads = 4;
+  std::vector<int> chunkSizes = {3, 1, 5, 3};
+
+  // with and without a relative positional embedding
+  for (int posEmbContextSize : {0, 8}) {
+    auto conformer =
+        Conformer(c, c / nheads, c, nheads, posEmbContextSize, 5, 0);
+    conformer.setAttentionContext(posEmbContextSize > 0 ? 4 : -1, 2);
+    conformer.eval();
+    auto input = Variable(fl::rand({c, timesteps, batchsize}), false);
+    auto expected = conformer.forward({input, Variable()}).front();
+
+    ConformerState state;
+    std::vector<Variable> outputs;
+    int start = 0;
+    for (size_t i = 0; i < chunkSizes.size(); ++i) {
+      auto chunk = input(fl::span, fl::range(start, start + chunkSizes[i]));
+      start += chunkSizes[i];
+      Variable output;
+      std::tie(output, state) = conformer.forwardStreaming(
+          chunk, std::move(state), i + 1 == chunkSizes.size());
+      if (!output.isEmpty()) {
+        outputs.push_back(output);
+      }
+      // the streams of the batch are split and batched again
+      if (i == 1) {
+        state = ConformerState::concatenate({state.select(0), state.select(1)});
+      }
+    }
+    ASSERT_EQ(state.emitted, timesteps);
+    ASSERT_THROW(
+        ConformerState::concatenate({state, ConformerState()}),
+        std::invalid_argument);
+    ASSERT_TRUE(allClose(concatenate(outputs, 1), expected, 1e-5));
+  }
+}
+
 void positionEmbeddingFwd(bool isfp16) {
   int batchsize = 10;
   int timesteps = 120;
@@ -345,6 +540,35 @@ TEST(ContribModuleTest, AdaptiveEmbedding) {
   ASSERT_EQ(output.dim(2), B);
 }
 
+TEST(ContribModuleTest, AdaptiveEmbeddingSparseGrad) {
+  std::vector<float> values = {1, 4, 6, 2, 12, 7, 4, 21, 22, 18, 3, 23};
+  int T = 6, B = 2, dim = 16;
+  auto input = Variable(Tensor::fromVector({T, B}, values), false);
+  std::vector<int> cutoff = {5, 10, 25};
+  auto emb = AdaptiveEmbedding(dim, cutoff);
+  auto sparseEmb = AdaptiveEmbedding(dim, cutoff, 4, /* sparseGrad = */ true);
+  // the same parameters, with the tables transposed
+  for (int i = 0; i < emb.params().size(); ++i) {
+    auto param = emb.param(i).tensor();
+    sparseEmb.setParams(
+        Variable(i % 2 == 0 ? fl::transpose(param) : param, true), i);
+  }
+
+  auto output = emb.forward(input);
+  auto sparseOutput = sparseEmb.forward(input);
+  ASSERT_TRUE(allClose(output.tensor(), sparseOutput.tensor(), 1e-5));
+
+  output.backward();
+  sparseOutput.backward();
+  for (int i = 0; i < emb.params().size(); i += 2) {
+    ASSERT_TRUE(sparseEmb.param(i).grad().isRowSparse());
+    ASSERT_TRUE(allClose(
+        fl::transpose(emb.param(i).grad().tensor()),
+        sparseEmb.param(i).grad().tensor(),
+        1e-5));
+  }
+}
+
 void tdsFwd(bool isfp16) {
   int batchsize = 10;
   int timesteps = 120;
@@ -406,6 +630,50 @@ TEST_F(ContribModuleTestF16, StreamingTDSFwdF16) {
   streamingTDSFwd(true);
 }
 
+TEST(ContribModuleTest, TDSStreaming) {
+  int batchsize = 2;
+  int timesteps = 12;
+  int w = 3;
+  int c = 2;
+  std::vector<int> chunkSizes = {1, 4, 2, 5};
+
+  // symmetric and asymmetric padding
+  for (int rPad : {-1, 1}) {
+    auto tds = TDSBlock(c, 5, w, 0, 0, rPad, false);
+    tds.eval();
+    auto input = Variable(fl::rand({timesteps, w, c, batchsize}), false);
+    auto expected = tds.forward({input})[0];
+
+    TDSBlockState state;
+    std::vector<Variable> outputs;
+    int start = 0;
+    for (size_t i = 0; i < chunkSizes.size(); ++i) {
+      auto chunk = input(fl::range(start, start + chunkSizes[i]));
+      start += chunkSizes[i];
+      Variable output;
+      std::tie(output, state) = tds.forwardStreaming(
+          chunk, std::move(state), i + 1 == chunkSizes.size());
+      if (!output.isEmpty()) {
+        outputs.push_back(output);
+      }
+      // the streams of the batch are split and batched again
+      if (i == 1) {
+        state = TDSBlockState::concatenate({state.select(0), state.select(1)});
+      }
+    }
+    ASSERT_TRUE(allClose(concatenate(outputs, 0), expected, 1e-5));
+  }
+
+  // the normalization over time can't be streamed
+  auto tds = TDSBlock(c, 5, w);
+  ASSERT_THROW(
+      tds.forwardStreaming(
+          Variable(fl::rand({timesteps, w, c, batchsize}), false),
+          TDSBlockState(),
+          true),
+      std::invalid_argument);
+}
+
 TEST(ContribModuleTest, SpecAugmentFwd) {
   SpecAugment specAug(0, 27, 2, 100, 0.2, 2);
   int T = 512, F = 80;
@@ -5,7 +5,13 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstring>
+#include <future>
+#include <numeric>
+#include <random>
 #include <thread>
 
 #include <gtest/gtest.h>
@@ -74,6 +80,133 @@ TEST(DatasetTest, BatchDataset) {
       allClose(ff1[0], tensormap[0](fl::span, fl::span, fl::range(70, 77))));
 }
 
+TEST(DatasetTest, GetAsync) {
+  // fetches each sample on its own thread, and counts those in flight
+  class AsyncDataset : public Dataset {
+   public:
+    explicit AsyncDataset(Tensor data) : data_(std::move(data)) {}
+
+    int64_t size() const override {
+      return data_.dim(1);
+    }
+
+    std::vector<Tensor> get(const int64_t idx) const override {
+      checkIndexBounds(idx);
+      return {data_(fl::span, idx)};
+    }
+
+    std::future<std::vector<Tensor>> getAsync(
+        const int64_t idx) const override {
+      checkIndexBounds(idx);
+      return std::async(std::launch::async, [this, idx]() {
+        const int inFlight = ++inFlight_;
+        int prevMax = maxInFlight_;
+        while (prevMax < inFlight &&
+               !maxInFlight_.compare_exchange_weak(prevMax, inFlight)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        --inFlight_;
+        return get(idx);
+      });
+    }
+
+    mutable std::atomic<int> inFlight_{0};
+    mutable std::atomic<int> maxInFlight_{0};
+
+   private:
+    Tensor data_;
+  };
+
+  const auto data = fl::rand({5, 8});
+  auto asyncds = std::make_shared<AsyncDataset>(data);
+  auto negate = [](const Tensor& a) { return -a; };
+  auto transformds = std::make_shared<TransformDataset>(
+      asyncds, std::vector<Dataset::TransformFunction>{negate});
+  auto resampleds = std::make_shared<ResampleDataset>(
+      transformds, std::vector<int64_t>{7, 6, 5, 4, 3, 2, 1, 0});
+
+  // wrappers forward fetches, and keep their results
+  auto sample = resampleds->getAsync(2).get();
+  ASSERT_EQ(sample.size(), 1);
+  ASSERT_TRUE(allClose(sample[0], -data(fl::span, 5)));
+  auto samples = resampleds->getBatchAsync({0, 1});
+  ASSERT_TRUE(allClose(samples[0].get()[0], -data(fl::span, 7)));
+  ASSERT_TRUE(allClose(samples[1].get()[0], -data(fl::span, 6)));
+
+  // the samples of a batch are fetched concurrently
+  asyncds->maxInFlight_ = 0;
+  BatchDataset batchds(resampleds, 4);
+  auto batch = batchds.get(1);
+  ASSERT_EQ(asyncds->maxInFlight_, 4);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(allClose(batch[0](fl::span, i), -data(fl::span, 3 - i)));
+  }
+  ASSERT_THROW(transformds->getAsync(8), std::out_of_range);
+
+  // by default, samples are fetched synchronously
+  TensorDataset tensords({data});
+  ASSERT_TRUE(allClose(tensords.getAsync(3).get()[0], data(fl::span, 3)));
+}
+
+TEST(DatasetTest, BatchCollator) {
+  // fixed shapes match makeBatch
+  std::vector<Tensor> tensormap = {
+      fl::rand({10, 20, 30}), fl::rand({5, 30}), fl::rand({1, 30})};
+  auto tensords = std::make_shared<TensorDataset>(tensormap);
+  BatchDataset batchds(tensords, 7);
+  auto collator = std::make_shared<BatchCollator>(
+      std::vector<Shape>{{10, 20}, {5}}, /* pinned = */ true);
+  BatchDataset collatedds(tensords, 7);
+  collatedds.setCollator(collator);
+  ASSERT_EQ(collatedds.size(), batchds.size());
+  for (int64_t i = 0; i < batchds.size(); ++i) {
+    auto batch = batchds.get(i);
+    auto collated = collatedds.get(i);
+    ASSERT_EQ(batch.size(), collated.size());
+    for (int64_t f = 0; f < batch.size(); ++f) {
+      ASSERT_EQ(batch[f].shape(), collated[f].shape());
+      ASSERT_TRUE(allClose(batch[f], collated[f]));
+    }
+  }
+  // buffers are reused across batches
+  ASSERT_EQ(collator->pooledBuffers(), 2);
+
+  // variable-length samples are padded with zeros
+  class VariableLengthDataset : public Dataset {
+   public:
+    int64_t size() const override {
+      return 10;
+    }
+    std::vector<Tensor> get(const int64_t idx) const override {
+      return {fl::full({3, 1 + idx % 4}, idx + 1)};
+    }
+  };
+  BatchDataset paddedds(std::make_shared<VariableLengthDataset>(), 5);
+  paddedds.setCollator(
+      std::make_shared<BatchCollator>(std::vector<Shape>{{3, 4}}));
+  for (int64_t b = 0; b < paddedds.size(); ++b) {
+    auto batch = paddedds.get(b).front();
+    ASSERT_EQ(batch.shape(), Shape({3, 4, 5}));
+    for (int64_t j = 0; j < 5; ++j) {
+      const int64_t idx = b * 5 + j, length = 1 + idx % 4;
+      auto sample = batch(fl::span, fl::span, j);
+      ASSERT_TRUE(allClose(
+          sample(fl::span, fl::range(0, length)),
+          fl::full({3, length}, idx + 1)));
+      if (length < 4) {
+        ASSERT_TRUE(allClose(
+            sample(fl::span, fl::range(length, 4)),
+            fl::full({3, 4 - length}, 0)));
+      }
+    }
+  }
+
+  // samples larger than their shape are rejected
+  paddedds.setCollator(
+      std::make_shared<BatchCollator>(std::vector<Shape>{{3, 2}}));
+  ASSERT_THROW(paddedds.get(0), std::invalid_argument);
+}
+
 TEST(DatasetTest, DynamicBatchDataset) {
   // first create a tensor dataset
   std::vector<Tensor> tensormap = {fl::rand({100, 200, 300})};
@@ -123,6 +256,44 @@ TEST(DatasetTest, ShuffleDataset) {
   ASSERT_FALSE(allClose(ff2[0], ff4[0]));
 }
 
+TEST(DatasetTest, BlockShuffleDataset) {
+  auto tensords = std::make_shared<TensorDataset>(
+      std::vector<Tensor>{fl::arange({1000})});
+  const int64_t blockSize = 50, windowSize = 100;
+  ShuffleDataset shuffleds(tensords, 1, blockSize, windowSize);
+  ASSERT_EQ(shuffleds.size(), 1000);
+
+  auto read = [&shuffleds]() {
+    std::vector<int64_t> indices;
+    for (int64_t i = 0; i < shuffleds.size(); ++i) {
+      indices.push_back(shuffleds.get(i)[0].scalar<float>());
+    }
+    return indices;
+  };
+  auto indices = read();
+  // each window holds two whole blocks
+  for (int64_t start = 0; start < indices.size(); start += windowSize) {
+    std::vector<int64_t> window(
+        indices.begin() + start, indices.begin() + start + windowSize);
+    std::sort(window.begin(), window.end());
+    for (int64_t j = 0; j < blockSize; ++j) {
+      ASSERT_EQ(window[j], window[0] + j);
+      ASSERT_EQ(window[blockSize + j], window[blockSize] + j);
+    }
+    ASSERT_EQ(window[0] % blockSize, 0);
+    ASSERT_EQ(window[blockSize] % blockSize, 0);
+  }
+  auto sorted = indices;
+  std::sort(sorted.begin(), sorted.end());
+  std::vector<int64_t> expected(indices.size());
+  std::iota(expected.begin(), expected.end(), 0);
+  ASSERT_EQ(sorted, expected);
+  ASSERT_NE(indices, expected);
+
+  shuffleds.resample();
+  ASSERT_NE(read(), indices);
+}
+
 TEST(DatasetTest, ResampleDataset) {
   std::vector<Tensor> tensormap = {fl::rand({100, 200, 300})};
   auto tensords = std::make_shared<TensorDataset>(tensormap);
@@ -511,6 +682,282 @@ TEST(DatasetTest, MemoryBlobDataset) {
   }
 }
 
+TEST(DatasetTest, MmapBlobDataset) {
+  const auto path = fs::temp_directory_path() / "mmap.blob";
+  std::vector<std::vector<Tensor>> data;
+  {
+    FileBlobDataset blob(path, true, true);
+    for (int64_t i = 0; i < 20; i++) {
+      std::vector<Tensor> sample;
+      for (int64_t j = 0; j < i % 3; j++) {
+        sample.push_back(fl::rand({10, 3 + j, 7}));
+      }
+      data.push_back(sample);
+      blob.add(sample);
+    }
+    blob.writeIndex();
+  }
+
+  MmapBlobDataset blob(path, MmapAdvice::Sequential);
+  ASSERT_EQ(data.size(), blob.size());
+  for (int64_t i = 0; i < blob.size(); i++) {
+    auto blobSample = blob.get(i);
+    auto views = blob.view(i);
+    auto dataSample = data.at(i);
+    ASSERT_EQ(dataSample.size(), blobSample.size());
+    ASSERT_EQ(dataSample.size(), views.size());
+    for (int64_t j = 0; j < blobSample.size(); j++) {
+      ASSERT_EQ(dataSample.at(j).shape(), blobSample.at(j).shape());
+      ASSERT_TRUE(
+          fl::norm(dataSample.at(j).flatten() - blobSample.at(j).flatten())
+              .scalar<float>() <= 1e-05);
+      // views are the raw bytes of the arrays
+      auto host = dataSample.at(j).toHostVector<float>();
+      ASSERT_EQ(views[j].entry.dims, dataSample.at(j).shape());
+      ASSERT_EQ(views[j].bytes, host.size() * sizeof(float));
+      ASSERT_EQ(std::memcmp(views[j].data, host.data(), views[j].bytes), 0);
+    }
+    blob.willNeed(i);
+  }
+  blob.advise(MmapAdvice::Random);
+
+  // mapped transforms read the mapping in place
+  blob.setMappedHostTransform(
+      0, [](const void* ptr, fl::Shape shape, fl::dtype type) {
+        EXPECT_EQ(type, fl::dtype::f32);
+        auto tensor = Tensor::fromBuffer(
+            shape, static_cast<const float*>(ptr), MemoryLocation::Host);
+        return tensor * 2;
+      });
+  for (int64_t i = 0; i < blob.size(); i++) {
+    auto blobSample = blob.get(i);
+    auto dataSample = data.at(i);
+    ASSERT_EQ(dataSample.size(), blobSample.size());
+    for (int64_t j = 0; j < blobSample.size(); j++) {
+      auto expected = j == 0 ? dataSample.at(j) * 2 : dataSample.at(j);
+      ASSERT_TRUE(
+          fl::norm(expected.flatten() - blobSample.at(j).flatten())
+              .scalar<float>() <= 1e-05);
+    }
+  }
+
+  // read-only
+  ASSERT_THROW(blob.add(data.back()), std::logic_error);
+  ASSERT_THROW(blob.view(data.size()), std::out_of_range);
+}
+
+TEST(DatasetTest, ShardedStreamingDataset) {
+  // 5 shards of 7 samples, each holding its global index
+  const int64_t nShards = 5, shardSize = 7;
+  std::vector<std::string> shards;
+  for (int64_t s = 0; s < nShards; ++s) {
+    shards.push_back(
+        fs::temp_directory_path() / ("shard" + std::to_string(s) + ".blob"));
+    FileBlobDataset blob(shards.back(), true, true);
+    for (int64_t i = 0; i < shardSize; ++i) {
+      blob.add({fl::full({2}, s * shardSize + i, fl::dtype::f32)});
+    }
+    blob.writeIndex();
+  }
+  auto readEpoch = [](const Dataset& ds) {
+    std::vector<int64_t> indices;
+    for (int64_t i = 0; i < ds.size(); ++i) {
+      indices.push_back(ds.get(i).front().scalar<float>());
+    }
+    return indices;
+  };
+
+  // in order, with and without prefetching
+  std::vector<int64_t> expected(nShards * shardSize);
+  std::iota(expected.begin(), expected.end(), 0);
+  ASSERT_EQ(readEpoch(ShardedStreamingDataset(shards, 0, 1, 0, 0)), expected);
+  ShardedStreamingDataset ordered(shards, 0, 1, 0, 2);
+  ASSERT_EQ(ordered.size(), nShards * shardSize);
+  ASSERT_EQ(readEpoch(ordered), expected);
+  ASSERT_EQ(readEpoch(ordered), expected);
+  ASSERT_THROW(ordered.get(3), std::invalid_argument);
+
+  // partitions get disjoint shards
+  ShardedStreamingDataset partition(shards, 1, 2);
+  ASSERT_EQ(partition.shards().size(), 2);
+  ASSERT_EQ(partition.size(), 2 * shardSize);
+  auto indices = readEpoch(partition);
+  for (int64_t i = 0; i < indices.size(); ++i) {
+    ASSERT_EQ(indices[i] / shardSize, i < shardSize ? 1 : 3);
+  }
+
+  // shuffled epochs are permutations of the samples
+  ShardedStreamingDataset shuffled(shards, 0, 1, 10, 2, 1234);
+  auto epoch0 = readEpoch(shuffled);
+  auto epoch1 = readEpoch(shuffled);
+  ASSERT_NE(epoch0, epoch1);
+  ASSERT_EQ(
+      epoch0, readEpoch(ShardedStreamingDataset(shards, 0, 1, 10, 2, 1234)));
+  std::sort(epoch0.begin(), epoch0.end());
+  std::sort(epoch1.begin(), epoch1.end());
+  ASSERT_EQ(epoch0, expected);
+  ASSERT_EQ(epoch1, expected);
+
+  ASSERT_THROW(ShardedStreamingDataset(shards, 2, 2), std::invalid_argument);
+}
+
+TEST(DatasetTest, DynamicBatchSampler) {
+  std::vector<float> sizes(1000);
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dist(1, 100);
+  for (auto& size : sizes) {
+    size = dist(gen);
+  }
+  const float maxSize = 400;
+  const int64_t numPartitions = 3;
+
+  std::vector<std::vector<std::vector<int64_t>>> partitions;
+  for (int64_t p = 0; p < numPartitions; ++p) {
+    DynamicBatchSampler sampler(sizes, maxSize, p, numPartitions, true, 200);
+    partitions.push_back(sampler.batches());
+    // sorting within buckets keeps the padding low
+    ASSERT_LT(sampler.paddingFraction(), 0.1);
+  }
+  std::vector<int64_t> seen;
+  for (const auto& batches : partitions) {
+    ASSERT_EQ(batches.size(), partitions[0].size());
+    for (const auto& batch : batches) {
+      float max = 0;
+      for (auto idx : batch) {
+        max = std::max(max, sizes[idx]);
+        seen.push_back(idx);
+      }
+      ASSERT_LE(batch.size() * max, maxSize);
+    }
+  }
+  // samples are in at most one batch
+  std::sort(seen.begin(), seen.end());
+  ASSERT_EQ(std::unique(seen.begin(), seen.end()), seen.end());
+
+  // a single partition has all the samples
+  DynamicBatchSampler sampler(sizes, maxSize);
+  auto epoch0 = sampler.batches();
+  seen.clear();
+  for (const auto& batch : epoch0) {
+    seen.insert(seen.end(), batch.begin(), batch.end());
+  }
+  std::sort(seen.begin(), seen.end());
+  std::vector<int64_t> all(sizes.size());
+  std::iota(all.begin(), all.end(), 0);
+  ASSERT_EQ(seen, all);
+
+  // epochs are shuffled differently, deterministically
+  sampler.setEpoch(1);
+  ASSERT_NE(sampler.batches(), epoch0);
+  sampler.setEpoch(0);
+  ASSERT_EQ(sampler.batches(), epoch0);
+
+  // batches of a dataset
+  auto tensords = std::make_shared<TensorDataset>(
+      std::vector<Tensor>{fl::arange({static_cast<long>(sizes.size())})});
+  auto batchds = sampler.makeBatchDataset(tensords);
+  ASSERT_EQ(batchds->size(), epoch0.size());
+  for (int64_t b = 0; b < batchds->size(); ++b) {
+    auto batch = batchds->get(b)[0].toHostVector<float>();
+    ASSERT_EQ(batch.size(), epoch0[b].size());
+    for (int64_t i = 0; i < batch.size(); ++i) {
+      ASSERT_EQ(batch[i], epoch0[b][i]);
+    }
+  }
+
+  ASSERT_THROW(DynamicBatchSampler(sizes, 50), std::invalid_argument);
+}
+
+TEST(DatasetTest, DatasetProfiler) {
+  auto& profiler = DatasetProfiler::getInstance();
+  profiler.enable();
+  std::vector<Tensor> tensormap = {fl::rand({10, 100})};
+  auto tensords = std::make_shared<TensorDataset>(tensormap);
+  auto transformds = std::make_shared<TransformDataset>(
+      tensords,
+      std::vector<Dataset::TransformFunction>{[](const Tensor& a) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return a;
+      }});
+  auto batchds = std::make_shared<BatchDataset>(transformds, 10);
+  PrefetchDataset prefetchds(batchds, 2, 2);
+  for (auto& sample : prefetchds) {
+    ASSERT_EQ(sample.size(), 1);
+  }
+  profiler.disable();
+
+  auto stats = profiler.stats();
+  ASSERT_EQ(stats.at("TransformDataset").calls, 100);
+  ASSERT_EQ(stats.at("BatchDataset").calls, 10);
+  ASSERT_EQ(stats.at("PrefetchDataset").calls, 10);
+  ASSERT_EQ(stats.at("TransformDataset").latenciesUs.size(), 100);
+  ASSERT_GE(stats.at("TransformDataset").totalSeconds, 0.1);
+  // batches mostly wait for their transformed samples
+  const auto& batch = stats.at("BatchDataset");
+  ASSERT_LT(batch.selfSeconds, batch.totalSeconds);
+  ASSERT_GE(batch.totalSeconds, stats.at("TransformDataset").totalSeconds);
+  ASSERT_EQ(stats.at("PrefetchDataset").queueOccupancy.size(), 10);
+  // the first batch can't be prefetched
+  ASSERT_GE(stats.at("PrefetchDataset").waits, 1);
+  ASSERT_NE(profiler.summary().find("TransformDataset"), std::string::npos);
+
+  // periodic reports clear the statistics
+  std::vector<std::string> reports;
+  profiler.enable();
+  profiler.setPeriodicReport(1e-6, [&reports](const std::string& report) {
+    reports.push_back(report);
+  });
+  transformds->get(0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  transformds->get(1);
+  profiler.setPeriodicReport(0, nullptr);
+  profiler.disable();
+  ASSERT_FALSE(reports.empty());
+  ASSERT_NE(reports.back().find("TransformDataset"), std::string::npos);
+  ASSERT_TRUE(profiler.stats().empty());
+}
+
+TEST(DatasetTest, CacheDataset) {
+  std::atomic<int> calls{0};
+  std::vector<Tensor> tensormap = {fl::rand({10, 50})};
+  auto tensords = std::make_shared<TensorDataset>(tensormap);
+  auto transformds = std::make_shared<TransformDataset>(
+      tensords,
+      std::vector<Dataset::TransformFunction>{[&calls](const Tensor& a) {
+        ++calls;
+        return a * 2;
+      }});
+  auto check = [&tensormap](const Dataset& ds) {
+    for (int64_t i = 0; i < ds.size(); ++i) {
+      ASSERT_TRUE(allClose(ds.get(i)[0], tensormap[0](fl::span, i) * 2));
+    }
+  };
+
+  // memory only, over prefetch workers
+  auto cached = std::make_shared<CacheDataset>(transformds, 50);
+  check(PrefetchDataset(cached, 4, 4));
+  check(*cached);
+  ASSERT_EQ(calls.load(), 50);
+  ASSERT_EQ(cached->misses(), 50);
+  ASSERT_EQ(cached->memoryHits(), 50);
+
+  // evicted samples are read back from disk
+  calls = 0;
+  auto tiered = std::make_shared<CacheDataset>(
+      transformds, 10, fs::temp_directory_path() / "cache.blob");
+  check(*tiered);
+  check(*tiered);
+  ASSERT_EQ(calls.load(), 50);
+  ASSERT_EQ(tiered->diskHits(), 50);
+
+  // a new version invalidates the cache
+  tiered->setVersion(1);
+  check(*tiered);
+  ASSERT_EQ(calls.load(), 100);
+  check(*tiered);
+  ASSERT_EQ(calls.load(), 100);
+}
+
 TEST(DatasetTest, PrefetchDatasetCorrectness) {
   std::vector<Tensor> tensormap = {fl::rand({100, 200, 300})};
   auto tensords = std::make_shared<TensorDataset>(tensormap);
@@ -533,6 +980,83 @@ TEST(DatasetTest, PrefetchDatasetCorrectness) {
   }
 }
 
+TEST(DatasetTest, PrefetchDatasetLookahead) {
+  const int n = 20;
+  std::vector<float> values(n);
+  std::iota(values.begin(), values.end(), 0);
+  auto tensords = std::make_shared<TensorDataset>(
+      std::vector<Tensor>{Tensor::fromVector({1, n}, values)});
+  // the sample of value 0 is slow
+  Dataset::TransformFunction slowFirst = [](const Tensor& a) {
+    if (a.scalar<float>() == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+    return a;
+  };
+  auto transformDs = std::make_shared<TransformDataset>(
+      tensords, std::vector<Dataset::TransformFunction>{slowFirst});
+
+  std::vector<int64_t> indices(n);
+  std::iota(indices.rbegin(), indices.rend(), 0);
+  PrefetchDataset ordered(transformDs, 2, 4, indices);
+  ASSERT_EQ(ordered.size(), n);
+  for (int i = 0; i < n; ++i) {
+    ASSERT_EQ(ordered.get(i)[0].scalar<float>(), indices[i]);
+  }
+  // reading out of order restarts prefetching
+  ASSERT_EQ(ordered.get(3)[0].scalar<float>(), indices[3]);
+  ASSERT_EQ(ordered.get(1)[0].scalar<float>(), indices[1]);
+  ordered.resample({5, 0, 7});
+  ASSERT_EQ(ordered.size(), 3);
+  ASSERT_EQ(ordered.get(2)[0].scalar<float>(), 7);
+  ASSERT_THROW(ordered.resample({n}), std::out_of_range);
+
+  // the slow sample doesn't block those after it
+  std::iota(indices.begin(), indices.end(), 0);
+  PrefetchDataset unordered(transformDs, 2, 4, indices, true);
+  std::vector<float> read;
+  for (auto& sample : unordered) {
+    read.push_back(sample[0].scalar<float>());
+  }
+  ASSERT_NE(read.front(), 0);
+  std::sort(read.begin(), read.end());
+  ASSERT_EQ(read, values);
+}
+
+TEST(DatasetTest, DeviceUploadDataset) {
+  auto load = [](int64_t idx, DeviceUploadDataset::HostSample& sample) {
+    float* input = sample.add<float>({3, 4});
+    for (int i = 0; i < 12; ++i) {
+      input[i] = idx * 12 + i;
+    }
+    *sample.add<int>({1}) = idx;
+    sample.add<float>({0});
+  };
+  for (const int numThreads : {0, 2}) {
+    DeviceUploadDataset ds(load, 10, numThreads, numThreads);
+    ASSERT_EQ(ds.size(), 10);
+    int64_t idx = 0;
+    for (auto& sample : ds) {
+      ASSERT_EQ(sample.size(), 3);
+      ASSERT_EQ(sample[0].shape(), Shape({3, 4}));
+      ASSERT_EQ(sample[0].type(), fl::dtype::f32);
+      ASSERT_TRUE(allClose(
+          sample[0],
+          fl::reshape(fl::arange({12}) + idx * 12, {3, 4}).astype(
+              fl::dtype::f32)));
+      ASSERT_EQ(sample[1].type(), fl::dtype::s32);
+      ASSERT_EQ(sample[1].scalar<int>(), idx);
+      ASSERT_TRUE(sample[2].isEmpty());
+      ++idx;
+    }
+    ASSERT_EQ(idx, 10);
+    // out of order access
+    ASSERT_EQ(ds.get(7)[1].scalar<int>(), 7);
+  }
+  ASSERT_THROW(
+      DeviceUploadDataset(nullptr, 10, 2, 2), std::invalid_argument);
+}
+
 TEST(DatasetTest, DISABLED_PrefetchDatasetPerformance) {
   // Flaky test. Disabled for now.
   std::vector<Tensor> tensormap = {fl::rand({100, 200, 300})};
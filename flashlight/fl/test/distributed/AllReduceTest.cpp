@@ -8,14 +8,22 @@
 #include <chrono>
 #include <cstdio>
 #include <exception>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <thread>
 
 #include <gtest/gtest.h>
 
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/fl/distributed/distributed.h"
+#include "flashlight/fl/nn/SyncBatchNorm.h"
+#include "flashlight/fl/nn/TensorParallel.h"
+#include "flashlight/fl/nn/nn.h"
+#include "flashlight/fl/optim/optim.h"
+#include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Random.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 
 using namespace fl;
@@ -56,6 +64,33 @@ TEST(Distributed, InlineReducer) {
   ASSERT_TRUE(fl::all(arr == expected_val).scalar<char>());
 }
 
+TEST(Distributed, DeferredReducer) {
+  // counts the gradients it's given
+  struct CountingReducer : public Reducer {
+    int count{0};
+    void add(Variable&) override {
+      ++count;
+    }
+    void finalize() override {}
+  };
+  auto model = std::make_shared<Linear>(4, 3);
+  auto reducer = std::make_shared<CountingReducer>();
+  distributeModuleGrads(model, reducer);
+  auto input = Variable(fl::rand({4, 2}), false);
+
+  // the gradients of the first micro-batch are kept
+  reducer->setDeferred(true);
+  fl::sum(model->forward(input), {0, 1}).backward();
+  ASSERT_EQ(reducer->count, 0);
+  auto grad = model->param(0).grad().tensor().copy();
+
+  // and those accumulated with the last one are reduced
+  reducer->setDeferred(false);
+  fl::sum(model->forward(input), {0, 1}).backward();
+  ASSERT_EQ(reducer->count, model->params().size());
+  ASSERT_TRUE(allClose(model->param(0).grad().tensor(), 2 * grad));
+}
+
 TEST(Distributed, AllReduceAsync) {
   if (!isDistributedInit()) {
     GTEST_SKIP() << "Distributed initialization failed or not enabled.";
@@ -63,8 +98,7 @@ TEST(Distributed, AllReduceAsync) {
 
   auto rank = getWorldRank();
   auto size = getWorldSize();
-  // not supported for the CPU backend
-  bool async = true && !FL_BACKEND_CPU;
+  bool async = true;
 
   Variable var(fl::full({10}, rank, dtype::f32), false);
 
@@ -82,9 +116,8 @@ TEST(Distributed, AllReduceSetAsync) {
 
   auto rank = getWorldRank();
   auto size = getWorldSize();
-  // not supported for the CPU backend
-  bool async = true && !FL_BACKEND_CPU;
-  bool contiguous = true && !FL_BACKEND_CPU;
+  bool async = true;
+  bool contiguous = true;
 
   unsigned vSize = (1 << 20);
   std::vector<Variable> vars;
@@ -182,6 +215,605 @@ TEST(Distributed, CoalescingReducer) {
   }
 }
 
+TEST(Distributed, CoalescingReducerBucketed) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  auto rank = getWorldRank();
+  auto size = getWorldSize();
+
+  auto s = std::make_shared<fl::CoalescingReducer>(
+      /* scale = */ 1.0 / size,
+      /*async=*/true && !FL_BACKEND_CPU,
+      /*contiguous=*/true && !FL_BACKEND_CPU,
+      /* compressor = */ nullptr,
+      /* bucketed = */ true);
+
+  // the first step plans the buckets, which the second follows, and the third
+  // adds other gradients, which are planned again
+  for (int step = 0; step < 3; ++step) {
+    std::vector<Variable> vars;
+    for (unsigned i = 0; i < 20; ++i) {
+      unsigned vSize = (step < 2 ? i + 1 : 20 - i) << 16;
+      auto type = i % 4 == 0 ? dtype::f64 : dtype::f32;
+      vars.push_back(Variable(fl::full({vSize}, rank + step, type), false));
+    }
+    for (auto& var : vars) {
+      s->add(var);
+    }
+    s->finalize();
+
+    double expected_val = size * (size - 1.0 + 2 * step);
+    for (auto& var : vars) {
+      // The reducer scales down by a factor of 1 / size
+      auto arr = var.tensor() * (size * 2);
+      ASSERT_TRUE(fl::all(arr == expected_val).scalar<char>());
+    }
+  }
+}
+
+TEST(Distributed, CastCompressor) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  auto rank = getWorldRank();
+  auto size = getWorldSize();
+
+  auto reducer = std::make_shared<InlineReducer>(
+      1.0 / size, std::make_shared<CastCompressor>(dtype::f16));
+  for (int step = 0; step < 2; ++step) {
+    Variable var(fl::full({10}, rank, dtype::f32), false);
+    reducer->add(var);
+    reducer->finalize();
+
+    // the values are exact in fp16, so there's no error to feed back
+    ASSERT_EQ(var.type(), dtype::f32);
+    auto arr = var.tensor() * (size * 2);
+    float expected_val = size * (size - 1.0);
+    ASSERT_TRUE(allClose(arr, fl::full({10}, expected_val), 1e-3));
+  }
+}
+
+TEST(Distributed, PowerSGDCompressor) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  auto rank = getWorldRank();
+  auto size = getWorldSize();
+
+  auto reducer = std::make_shared<CoalescingReducer>(
+      /* scale = */ 1.0 / size,
+      /*async=*/false,
+      /*contiguous=*/true,
+      std::make_shared<PowerSGDCompressor>(/* rank = */ 1));
+
+  // a rank-1 gradient is recovered by a rank-1 approximation, and a bias is
+  // reduced uncompressed
+  auto u = fl::arange({6, 1}) + 1;
+  auto v = fl::arange({1, 5}, /* seqDim = */ 1) - 2;
+  auto matrix = fl::matmul(u, v);
+  for (int step = 0; step < 2; ++step) {
+    Variable weight(matrix * (rank + 1), false);
+    Variable bias(fl::full({6}, rank + 1, dtype::f32), false);
+    reducer->add(weight);
+    reducer->add(bias);
+    reducer->finalize();
+
+    float mean = (size + 1.0) / 2;
+    ASSERT_TRUE(allClose(weight.tensor(), matrix * mean, 1e-3));
+    ASSERT_TRUE(allClose(bias.tensor(), fl::full({6}, mean), 1e-5));
+  }
+}
+
+TEST(Distributed, ReduceScatterAllGather) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  auto rank = getWorldRank();
+  auto size = getWorldSize();
+
+  // the i-th element is rank + i on each process
+  auto arr = fl::arange({2 * size}, 0, dtype::f32) + rank;
+  auto part = reduceScatter(arr);
+  ASSERT_EQ(part.shape(), Shape({2}));
+  // the sum over processes of the elements 2 * rank and 2 * rank + 1
+  auto expected =
+      fl::arange({2}, 0, dtype::f32) * size + 2 * rank * size +
+      size * (size - 1) / 2;
+  ASSERT_TRUE(fl::all(part == expected).scalar<char>());
+
+  auto gathered = allGather(fl::full({3}, rank, dtype::s32));
+  ASSERT_EQ(gathered.shape(), Shape({3 * size}));
+  for (int i = 0; i < size; ++i) {
+    ASSERT_TRUE(
+        fl::all(gathered(fl::range(3 * i, 3 * (i + 1))) == i).scalar<char>());
+  }
+
+  if (size > 1) {
+    ASSERT_THROW(reduceScatter(fl::full({size + 1}, 0)), std::invalid_argument);
+  }
+}
+
+TEST(Distributed, AsyncCollectives) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  auto rank = getWorldRank();
+  auto size = getWorldSize();
+
+  auto arr = fl::arange({2 * size}, 0, dtype::f32) + rank;
+  Tensor part, gathered;
+  auto reduceScatterWork = reduceScatterAsync(arr, part);
+  auto allGatherWork =
+      allGatherAsync(fl::full({3}, rank, dtype::s32), gathered);
+  reduceScatterWork.wait();
+  allGatherWork.wait();
+  ASSERT_TRUE(allClose(part, reduceScatter(arr)));
+  ASSERT_EQ(gathered.shape(), Shape({3 * size}));
+  for (int i = 0; i < size; ++i) {
+    ASSERT_TRUE(
+        fl::all(gathered(fl::range(3 * i, 3 * (i + 1))) == i).scalar<char>());
+  }
+
+  auto broadcasted = fl::full({4}, rank + 1, dtype::f32);
+  broadcast(broadcasted, size - 1);
+  ASSERT_TRUE(fl::all(broadcasted == size).scalar<char>());
+  if (size > 1) {
+    ASSERT_THROW(broadcast(broadcasted, size), std::invalid_argument);
+  }
+}
+
+TEST(Distributed, SendRecv) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  auto rank = getWorldRank();
+  auto size = getWorldSize();
+  if (size < 2) {
+    GTEST_SKIP() << "Point-to-point operations need two processes.";
+  }
+
+  // pass a tensor along a ring, starting from rank 0
+  auto next = (rank + 1) % size;
+  auto prev = (rank + size - 1) % size;
+  auto arr = fl::full({5}, rank, dtype::f32);
+  if (rank == 0) {
+    send(arr, next);
+    recv(arr, prev);
+    ASSERT_TRUE(fl::all(arr == size - 1).scalar<char>());
+  } else {
+    auto received = Tensor({5}, dtype::f32);
+    recvAsync(received, prev).wait();
+    ASSERT_TRUE(fl::all(received == rank - 1).scalar<char>());
+    sendAsync(arr, next).wait();
+  }
+  ASSERT_THROW(send(arr, rank), std::invalid_argument);
+
+  // all processes send to the next while receiving from the previous one
+  auto sent = fl::full({3}, rank, dtype::f32);
+  auto received = Tensor({3}, dtype::f32);
+  sendRecv(sent, next, received, prev);
+  ASSERT_TRUE(fl::all(received == prev).scalar<char>());
+}
+
+TEST(Distributed, CommProfiler) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  auto& profiler = CommProfiler::getInstance();
+  profiler.enable();
+  auto arr = fl::full({1024}, getWorldRank(), dtype::f32);
+  allReduce(arr, /* async = */ true);
+  syncDistributed();
+  auto gathered = allGather(arr);
+  profiler.disable();
+  // not recorded once disabled
+  allReduce(arr, /* async = */ false);
+
+  const auto records = profiler.collectives();
+  ASSERT_EQ(records.size(), 2);
+  ASSERT_EQ(records[0].type, CollectiveType::AllReduce);
+  ASSERT_EQ(records[0].bytes, arr.bytes());
+  ASSERT_EQ(records[1].type, CollectiveType::AllGather);
+  ASSERT_EQ(records[1].bytes, gathered.bytes());
+  for (const auto& record : records) {
+    ASSERT_EQ(record.worldSize, getWorldSize());
+    ASSERT_FALSE(record.algorithm.empty());
+    ASSERT_LE(record.startSeconds, record.endSeconds);
+    ASSERT_GE(record.busBandwidth(), 0);
+  }
+  ASSERT_FALSE(profiler.syncWaits().empty());
+
+  std::ostringstream trace;
+  profiler.writeChromeTrace(trace);
+  ASSERT_NE(trace.str().find("\"allReduce\""), std::string::npos);
+  ASSERT_NE(trace.str().find("\"busBW (GB/s)\""), std::string::npos);
+  ASSERT_NE(profiler.summary().find("allGather"), std::string::npos);
+  profiler.clear();
+  ASSERT_TRUE(profiler.collectives().empty());
+}
+
+TEST(Distributed, PipelineParallel) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  auto rank = getWorldRank();
+  auto size = getWorldSize();
+  auto makeModel = [size]() {
+    auto model = std::make_shared<Sequential>();
+    for (int i = 0; i < 2 * size; ++i) {
+      model->add(Linear(
+          Variable(fl::sin(fl::arange({4, 4}, 1, dtype::f32) + i) / 2, true),
+          Variable(fl::full({4}, 0.1 * i, dtype::f32), true)));
+      model->add(Tanh());
+    }
+    return model;
+  };
+  auto input = fl::cos(fl::arange({4, 8}, 1, dtype::f32));
+  auto target = fl::sin(fl::arange({4, 8}, 0, dtype::f32));
+  auto mse = MeanSquaredError();
+  auto loss = [&mse](const Variable& output, const Variable& tgt) {
+    return mse(output, tgt);
+  };
+
+  // the gradients of the whole batch on the whole model
+  auto reference = makeModel();
+  auto referenceOutput = reference->forward(Variable(input, false));
+  auto referenceLoss = loss(referenceOutput, Variable(target, false));
+  referenceLoss.backward();
+
+  auto model = makeModel();
+  PipelineParallel pipeline(model, 4);
+  ASSERT_EQ(pipeline.numStages(), size);
+  ASSERT_EQ(pipeline.stageIndex(), rank);
+  ASSERT_EQ(pipeline.stageStarts().size(), static_cast<size_t>(size));
+  const int start = pipeline.stageStarts()[rank];
+  const auto stageModules = pipeline.stage()->modules();
+  ASSERT_FALSE(stageModules.empty());
+  for (size_t i = 0; i < stageModules.size(); ++i) {
+    ASSERT_EQ(stageModules[i], model->module(start + i));
+  }
+
+  for (int step = 0; step < 2; ++step) {
+    auto stepLoss = pipeline.trainStep(input, target, loss);
+    if (rank == size - 1) {
+      ASSERT_TRUE(allClose(stepLoss, referenceLoss.tensor(), 1e-5));
+    } else {
+      ASSERT_TRUE(stepLoss.isEmpty());
+    }
+    for (size_t i = 0; i < stageModules.size(); ++i) {
+      const auto params = stageModules[i]->params();
+      const auto referenceParams = reference->module(start + i)->params();
+      for (size_t j = 0; j < params.size(); ++j) {
+        ASSERT_TRUE(allClose(
+            params[j].grad().tensor(),
+            referenceParams[j].grad().tensor(),
+            1e-5));
+      }
+    }
+    pipeline.stage()->zeroGrad();
+  }
+
+  auto output = pipeline.forward(input);
+  if (rank == size - 1) {
+    ASSERT_TRUE(allClose(output, referenceOutput.tensor(), 1e-5));
+  } else {
+    ASSERT_TRUE(output.isEmpty());
+  }
+}
+
+TEST(Distributed, TensorParallelLinear) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  auto rank = getWorldRank();
+  auto size = getWorldSize();
+  const int hidden = 2 * size;
+  auto w1 = fl::sin(fl::arange({hidden, 3}, 1, dtype::f32));
+  auto b1 = fl::full({hidden}, 0.5, dtype::f32);
+  auto w2 = fl::cos(fl::arange({4, hidden}, 0, dtype::f32));
+  auto b2 = fl::full({4}, -0.25, dtype::f32);
+  auto input = fl::sin(fl::arange({3, 5, 2}, 1, dtype::f32));
+  const auto shard = fl::range(2 * rank, 2 * rank + 2);
+
+  // the two layers of a Megatron MLP, and the reference layers
+  ColumnParallelLinear column(
+      Variable(w1, true), Variable(b1, true), /* gatherOutput = */ false);
+  RowParallelLinear row(
+      Variable(w2, true), Variable(b2, true), /* inputIsParallel = */ true);
+  Linear linear1(Variable(w1, true), Variable(b1, true));
+  Linear linear2(Variable(w2, true), Variable(b2, true));
+
+  auto x = Variable(input, true);
+  auto output = row(tanh(column(x)));
+  auto xReference = Variable(input, true);
+  auto reference = linear2(tanh(linear1(xReference)));
+  ASSERT_TRUE(allClose(output.tensor(), reference.tensor(), 1e-5));
+
+  output.backward();
+  reference.backward();
+  ASSERT_TRUE(allClose(x.grad().tensor(), xReference.grad().tensor(), 1e-5));
+  ASSERT_TRUE(allClose(
+      column.param(0).grad().tensor(),
+      linear1.param(0).grad().tensor()(shard),
+      1e-5));
+  ASSERT_TRUE(allClose(
+      column.param(1).grad().tensor(),
+      linear1.param(1).grad().tensor()(shard),
+      1e-5));
+  ASSERT_TRUE(allClose(
+      row.param(0).grad().tensor(),
+      linear2.param(0).grad().tensor()(fl::span, shard),
+      1e-5));
+  ASSERT_TRUE(allClose(
+      row.param(1).grad().tensor(), linear2.param(1).grad().tensor(), 1e-5));
+
+  // gathered outputs and scattered inputs
+  ColumnParallelLinear gathered(Variable(w1, false), Variable(b1, false));
+  ASSERT_TRUE(allClose(
+      gathered(Variable(input, false)).tensor(),
+      linear1(Variable(input, false)).tensor(),
+      1e-5));
+  RowParallelLinear scattered(Variable(w2, false), Variable());
+  auto hiddenInput = Variable(fl::cos(fl::arange({hidden, 5}, 1)), false);
+  ASSERT_TRUE(allClose(
+      scattered(hiddenInput).tensor(),
+      linear(hiddenInput, Variable(w2, false)).tensor(),
+      1e-5));
+}
+
+TEST(Distributed, TensorParallelTransformer) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  auto size = getWorldSize();
+  TensorParallelTransformer transformer(
+      8, 4, 4 * size, 2 * size, 5, 0.0, 0.0, /* useMask = */ true);
+  ASSERT_THROW(
+      TensorParallelTransformer(8, 4, 4 * size + 1, 2 * size, 5, 0.0, 0.0),
+      std::invalid_argument);
+
+  auto input = Variable(fl::sin(fl::arange({8, 5, 2}, 1, dtype::f32)), true);
+  auto output = transformer({input, Variable()}).front();
+  ASSERT_EQ(output.shape(), input.shape());
+
+  // the output is replicated
+  auto sum = output.tensor().copy();
+  allReduce(sum);
+  ASSERT_TRUE(allClose(sum / size, output.tensor(), 1e-5));
+
+  output.backward();
+  ASSERT_TRUE(input.isGradAvailable());
+  auto inputGradSum = input.grad().tensor().copy();
+  allReduce(inputGradSum);
+  ASSERT_TRUE(allClose(inputGradSum / size, input.grad().tensor(), 1e-5));
+  for (const auto& param : transformer.params()) {
+    ASSERT_TRUE(param.isGradAvailable());
+  }
+}
+
+TEST(Distributed, SyncBatchNorm) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  auto rank = getWorldRank();
+  auto size = getWorldSize();
+  // the batches of all processes, of 2 samples each
+  const Shape fullShape = {3, 2, 4, 2 * size};
+  auto fullInput = fl::reshape(
+      fl::sin(fl::arange({fullShape.elements()}, 0, dtype::f32)), fullShape);
+  auto fullGrad = fl::reshape(
+      fl::cos(fl::arange({fullShape.elements()}, 0, dtype::f32)), fullShape);
+  const auto shard = fl::range(2 * rank, 2 * rank + 2);
+
+  auto setParams = [](Module& module) {
+    module.setParams(Variable(fl::arange({4}, 0, dtype::f32) + 0.5, true), 0);
+    module.setParams(Variable(fl::full({4}, -0.25, dtype::f32), true), 1);
+  };
+  // with batch statistics in both train and eval mode
+  SyncBatchNorm syncBn(2, 4, 0.1, 1e-5, true, /* trackStats = */ false);
+  BatchNorm reference(2, 4, 0.1, 1e-5, true, /* trackStats = */ false);
+  setParams(syncBn);
+  setParams(reference);
+
+  auto x = Variable(fullInput(fl::span, fl::span, fl::span, shard), true);
+  auto output = syncBn(x);
+  auto xReference = Variable(fullInput, true);
+  auto referenceOutput = reference(xReference);
+  ASSERT_TRUE(allClose(
+      output.tensor(),
+      referenceOutput.tensor()(fl::span, fl::span, fl::span, shard),
+      1e-5));
+
+  output.backward(
+      Variable(fullGrad(fl::span, fl::span, fl::span, shard), false));
+  referenceOutput.backward(Variable(fullGrad, false));
+  ASSERT_TRUE(allClose(
+      x.grad().tensor(),
+      xReference.grad().tensor()(fl::span, fl::span, fl::span, shard),
+      1e-4));
+  // the gradients of the parameters are summed by data parallel training
+  for (int i = 0; i < 2; ++i) {
+    auto grad = syncBn.param(i).grad().tensor().copy();
+    allReduce(grad);
+    ASSERT_TRUE(allClose(grad, reference.param(i).grad().tensor(), 1e-4));
+  }
+
+  if (FL_BACKEND_CPU) {
+    return; // the CPU batch norm doesn't track running statistics
+  }
+  // the running statistics are those of all processes
+  SyncBatchNorm trackedSyncBn(2, 4);
+  BatchNorm trackedReference(2, 4);
+  setParams(trackedSyncBn);
+  setParams(trackedReference);
+  trackedSyncBn(Variable(x.tensor(), false));
+  trackedReference(Variable(fullInput, false));
+  trackedSyncBn.eval();
+  trackedReference.eval();
+  ASSERT_TRUE(allClose(
+      trackedSyncBn(Variable(fullInput, false)).tensor(),
+      trackedReference(Variable(fullInput, false)).tensor(),
+      1e-5));
+}
+
+TEST(Distributed, ShardedCheckpoint) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  const auto path = fs::temp_directory_path() / "ShardedCheckpointTest";
+  auto model = std::make_shared<Sequential>();
+  model->add(Linear(8, 16));
+  model->add(ReLU());
+  model->add(Linear(16, 4));
+  allReduceParameters(model);
+  std::shared_ptr<FirstOrderOptimizer> optimizer =
+      std::make_shared<AdamOptimizer>(model->params(), 0.1);
+  model->forward(Variable(fl::rand({8, 3}), false)).backward();
+  allReduceGradients(model, 1.0 / getWorldSize());
+  optimizer->step();
+  int step = 5;
+
+  ShardedCheckpoint checkpoint;
+  checkpoint.save(path, model, optimizer, step);
+  checkpoint.wait();
+  barrier();
+  ASSERT_TRUE(ShardedCheckpoint::exists(path));
+
+  std::shared_ptr<Sequential> loadedModel;
+  std::shared_ptr<FirstOrderOptimizer> loadedOptimizer;
+  int loadedStep = 0;
+  ShardedCheckpoint::load(path, loadedModel, loadedOptimizer, loadedStep);
+  ASSERT_EQ(loadedStep, step);
+  ASSERT_EQ(loadedModel->params().size(), model->params().size());
+  for (size_t i = 0; i < model->params().size(); ++i) {
+    ASSERT_TRUE(allClose(
+        loadedModel->param(i).tensor(), model->param(i).tensor(), 1e-7));
+  }
+  ASSERT_EQ(loadedOptimizer->prettyString(), optimizer->prettyString());
+  barrier();
+}
+
+TEST(Distributed, ShardedCheckpointFiles) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+
+  const auto path = fs::temp_directory_path() / "ShardedCheckpointFilesTest";
+  std::vector<Tensor> tensors;
+  for (int i = 0; i < 7; ++i) {
+    tensors.push_back(fl::full({100 * (i + 1)}, i, dtype::f32));
+  }
+  ShardedCheckpoint::Options options;
+  options.filesPerProcess = 3;
+  if (ShardedCheckpoint::isSupported(ShardedCheckpoint::Compression::Zstd)) {
+    options.compression = ShardedCheckpoint::Compression::Zstd;
+  }
+  ShardedCheckpoint checkpoint(options);
+  checkpoint.save(path, tensors);
+  checkpoint.wait();
+  barrier();
+
+  std::vector<Tensor> loaded;
+  ShardedCheckpoint::load(path, loaded);
+  ASSERT_EQ(loaded.size(), tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    ASSERT_TRUE(allClose(loaded[i], tensors[i]));
+  }
+  barrier();
+
+  if (getWorldRank() == 0) {
+    // the checksums catch corrupted shards
+    const auto shard = path / ("shard0-of-" +
+                               std::to_string(3 * getWorldSize()) + ".bin");
+    std::fstream file(shard, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(-1, std::ios::end);
+    file.put('\x7f');
+    file.close();
+    ASSERT_THROW(ShardedCheckpoint::load(path, loaded), std::runtime_error);
+  }
+  ASSERT_THROW(
+      ShardedCheckpoint({0, ShardedCheckpoint::Compression::None}),
+      std::invalid_argument);
+  barrier();
+}
+
+TEST(Distributed, ShardedOptimizer) {
+  auto rank = getWorldRank();
+  auto size = getWorldSize();
+
+  auto makeParams = []() {
+    std::vector<Variable> params;
+    for (int i = 0; i < 5; ++i) {
+      params.emplace_back(
+          fl::arange({i + 3, 2}, 0, dtype::f32) / (i + 1), true);
+    }
+    return params;
+  };
+  auto params = makeParams();
+  auto reference = makeParams();
+  auto makeAdam = [](const std::vector<Variable>& p) {
+    return std::make_shared<AdamOptimizer>(p, 0.1, 0.9, 0.999, 1e-8, 0.01);
+  };
+  auto sharded =
+      std::make_shared<ShardedOptimizer>(params, makeAdam, 1.0 / size);
+  auto adam = makeAdam(reference);
+  ASSERT_EQ(sharded->owners().size(), params.size());
+  for (const auto owner : sharded->owners()) {
+    ASSERT_LT(owner, size);
+  }
+
+  auto setGrads = [rank](std::vector<Variable>& p, int step) {
+    for (size_t i = 0; i < p.size(); ++i) {
+      p[i].zeroGrad();
+      p[i].addGrad(Variable(
+          fl::sin(p[i].tensor() * (rank + step + 1)) + static_cast<float>(i),
+          false));
+    }
+  };
+  for (int step = 0; step < 3; ++step) {
+    setGrads(params, step);
+    sharded->step();
+
+    setGrads(reference, step);
+    std::vector<Variable> grads;
+    for (auto& param : reference) {
+      grads.push_back(param.grad());
+    }
+    allReduceMultiple(grads, 1.0 / size);
+    adam->step();
+    for (size_t i = 0; i < params.size(); ++i) {
+      ASSERT_TRUE(allClose(params[i].tensor(), reference[i].tensor(), 1e-5));
+    }
+  }
+
+  // each process restores the state of its own parameters
+  std::stringstream ss;
+  std::shared_ptr<FirstOrderOptimizer> saved = sharded;
+  save(ss, saved);
+  std::shared_ptr<FirstOrderOptimizer> loaded;
+  load(ss, loaded);
+  auto restored = std::dynamic_pointer_cast<ShardedOptimizer>(loaded);
+  ASSERT_NE(restored, nullptr);
+  ASSERT_EQ(restored->owners(), sharded->owners());
+  ASSERT_EQ(restored->getLr(), sharded->getLr());
+  ASSERT_EQ(
+      restored->optimizer().prettyString(),
+      sharded->optimizer().prettyString());
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
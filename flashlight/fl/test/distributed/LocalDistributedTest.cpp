@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/distributed/distributed.h"
+#include "flashlight/fl/nn/nn.h"
+#include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+using namespace fl;
+
+TEST(LocalDistributed, RunOnDevices) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+  const int size = getWorldSize();
+  // outside of the driver threads
+  ASSERT_EQ(getWorldRank(), 0);
+
+  std::vector<int> ranks(size, -1);
+  std::vector<int> devices(size, -1);
+  runOnDevices([&](int rank) {
+    ranks[rank] = getWorldRank();
+    devices[rank] = fl::getDevice();
+    ASSERT_EQ(getWorldSize(), size);
+
+    Variable var(fl::full({10}, rank, dtype::f32), false);
+    allReduce(var, 2.0);
+    const float expected = size * (size - 1.0);
+    ASSERT_TRUE(fl::all(var.tensor() == expected).scalar<char>());
+  });
+  for (int rank = 0; rank < size; ++rank) {
+    ASSERT_EQ(ranks[rank], rank);
+    ASSERT_EQ(devices[rank], rank);
+  }
+}
+
+TEST(LocalDistributed, Errors) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+  // the error of a rank is rethrown once all ranks are done
+  std::atomic<int> done{0};
+  ASSERT_THROW(
+      runOnDevices([&done](int rank) {
+        ++done;
+        if (rank == 0) {
+          throw std::runtime_error("rank 0 failed");
+        }
+      }),
+      std::runtime_error);
+  ASSERT_EQ(done, getWorldSize());
+
+  ASSERT_THROW(
+      runOnDevices([](int /* rank */) { runOnDevices([](int) {}); }),
+      std::logic_error);
+}
+
+TEST(LocalDistributed, ReplicateModule) {
+  if (!isDistributedInit()) {
+    GTEST_SKIP() << "Distributed initialization failed or not enabled.";
+  }
+  auto model = std::make_shared<Sequential>();
+  model->add(Linear(4, 3));
+  model->add(ReLU());
+  model->add(Linear(3, 2));
+
+  // the parameters, on the device of the main thread
+  std::vector<std::vector<float>> expected;
+  for (const auto& param : model->params()) {
+    expected.push_back(param.tensor().toHostVector<float>());
+  }
+
+  runOnDevices([&model, &expected](int /* rank */) {
+    auto replica = replicateModule(model);
+    // the replicas stay in sync
+    allReduceParameters(replica);
+    const auto params = replica->params();
+    ASSERT_EQ(params.size(), expected.size());
+    for (size_t i = 0; i < params.size(); ++i) {
+      const auto values = params[i].tensor().toHostVector<float>();
+      ASSERT_EQ(values.size(), expected[i].size());
+      for (size_t j = 0; j < values.size(); ++j) {
+        ASSERT_NEAR(values[j], expected[i][j], 1e-5);
+      }
+    }
+  });
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+
+  try {
+    distributedInit(DistributedInit::LOCAL, -1, -1);
+  } catch (const std::exception& ex) {
+    // Don't run the test if distributed initialization fails
+    std::cerr
+        << "Distributed initialization failed; tests will be skipped. Reason: "
+        << ex.what() << std::endl;
+  }
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/distributed/TcpStore.h"
+
+using namespace fl::detail;
+
+namespace {
+
+int getTestPort() {
+  // a port unlikely to be in use, different for each test
+  static std::mt19937 generator(std::random_device{}());
+  return std::uniform_int_distribution<int>(20000, 40000)(generator);
+}
+
+std::vector<char> toBytes(const std::string& s) {
+  return {s.begin(), s.end()};
+}
+
+} // namespace
+
+TEST(TcpStoreTest, SetGet) {
+  const int port = getTestPort();
+  TcpStore server("localhost", port, /* isServer = */ true);
+  TcpStore client("localhost", port, /* isServer = */ false);
+
+  server.set("a", toBytes("value"));
+  ASSERT_EQ(client.get("a"), toBytes("value"));
+  ASSERT_EQ(server.get("a"), toBytes("value"));
+  ASSERT_THROW(client.set("a", toBytes("other")), std::runtime_error);
+
+  // empty values and keys are allowed
+  client.set("", {});
+  ASSERT_TRUE(server.get("").empty());
+
+  client.clear("a");
+  client.set("a", toBytes("other"));
+  ASSERT_EQ(server.get("a"), toBytes("other"));
+}
+
+TEST(TcpStoreTest, BatchedGetAndWait) {
+  const int port = getTestPort();
+  TcpStore server("localhost", port, /* isServer = */ true);
+
+  // many clients, each setting a key and waiting for all of them
+  const int numClients = 32;
+  std::vector<std::string> keys;
+  for (int i = 0; i < numClients; ++i) {
+    keys.push_back("rank" + std::to_string(i));
+  }
+  std::vector<std::thread> clients;
+  for (int i = 0; i < numClients; ++i) {
+    clients.emplace_back([&keys, port, i]() {
+      TcpStore client("localhost", port, /* isServer = */ false);
+      // the wait is answered once the other clients set their keys
+      std::this_thread::sleep_for(std::chrono::milliseconds(i));
+      client.set(keys[i], toBytes(std::to_string(i)));
+      client.wait(keys);
+    });
+  }
+  auto values = server.get(keys);
+  for (auto& client : clients) {
+    client.join();
+  }
+  ASSERT_EQ(values.size(), keys.size());
+  for (int i = 0; i < numClients; ++i) {
+    ASSERT_EQ(values[i], toBytes(std::to_string(i)));
+  }
+}
+
+TEST(TcpStoreTest, Timeout) {
+  const int port = getTestPort();
+  TcpStore server(
+      "localhost",
+      port,
+      /* isServer = */ true,
+      std::chrono::milliseconds(100));
+  ASSERT_THROW(server.get("missing"), std::runtime_error);
+  ASSERT_THROW(
+      TcpStore("localhost", port + 1, false, std::chrono::milliseconds(100)),
+      std::runtime_error);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -6,6 +6,8 @@
  */
 
 #include <cmath>
+#include <numeric>
+#include <string>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -40,6 +42,45 @@ TEST(MeterTest, EditDistanceMeter) {
   ASSERT_EQ(meter.value()[0], 6);
 }
 
+TEST(MeterTest, EditDistanceMeterBatch) {
+  std::vector<std::vector<std::string>> outputs = {
+      {"the", "cat", "sat"}, {}, {"a", "b"}, {"x", "y", "z", "w"}};
+  std::vector<std::vector<std::string>> targets = {
+      {"the", "cat", "sat", "down"}, {"hello"}, {}, {"y", "x", "z"}};
+  EditDistanceMeter meter;
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    meter.add(outputs[i], targets[i]);
+  }
+  // ties are broken towards deletions, then insertions
+  ASSERT_EQ(meter.value(), std::vector<int64_t>({7, 8, 3, 4, 0}));
+  for (size_t numThreads : {1, 2, 8}) {
+    EditDistanceMeter batchMeter;
+    batchMeter.addBatch(outputs, targets, numThreads);
+    ASSERT_EQ(batchMeter.value(), meter.value());
+  }
+}
+
+TEST(MeterTest, EditDistanceMeterLong) {
+  // longer than the vector width: of the 24 edits made, the alignment
+  // merges an insertion and a deletion into a substitution twice
+  std::vector<int> target(100), output;
+  std::iota(target.begin(), target.end(), 0);
+  for (int i = 0; i < 100; ++i) {
+    if (i % 10 == 3) {
+      continue; // deleted
+    }
+    output.push_back(i % 10 == 5 ? -1 : i); // substituted
+    if (i % 25 == 7) {
+      output.push_back(-2); // inserted
+    }
+  }
+  auto errors = EditDistanceMeter::editDistance(
+      output.data(), output.size(), target.data(), target.size());
+  ASSERT_EQ(errors.ndel, 8);
+  ASSERT_EQ(errors.nins, 2);
+  ASSERT_EQ(errors.nsub, 12);
+}
+
 TEST(MeterTest, FrameErrorMeter) {
   FrameErrorMeter meter;
   std::vector<int> a = {1, 2, 3, 4, 5};
@@ -72,6 +113,24 @@ TEST(MeterTest, AverageValueMeter) {
   ASSERT_EQ(val[2], 6.0);
 }
 
+TEST(MeterTest, AverageValueMeterDeferred) {
+  // values added as tensors are only read by value, in any order with others
+  AverageValueMeter meter;
+  meter.add(Tensor::fromVector<float>({1.0, 2.0}));
+  meter.add(3.0);
+  meter.add(Tensor::fromVector<float>({4.0, 5.0, 6.0}));
+  meter.add(7.0, 2.0);
+  auto val = meter.value();
+  ASSERT_NEAR(val[0], 35.0 / 8, 1e-6);
+  ASSERT_EQ(val[2], 8.0);
+
+  meter.add(Tensor::fromVector<float>({8.0}));
+  ASSERT_NEAR(meter.value()[0], 43.0 / 9, 1e-6);
+  meter.add(Tensor::fromVector<float>({8.0}));
+  meter.reset();
+  ASSERT_EQ(meter.value()[2], 0.0);
+}
+
 TEST(MeterTest, MSEMeter) {
   MSEMeter meter;
   std::vector<int> b = {4, 5, 6, 7, 8};
@@ -80,6 +139,14 @@ TEST(MeterTest, MSEMeter) {
       Tensor::fromVector<int>({4, 5, 6, 7, 8}));
   auto val = meter.value();
   ASSERT_EQ(val, 45.0);
+
+  meter.add(
+      Tensor::fromVector<int>({1, 2, 3, 4, 5}),
+      Tensor::fromVector<int>({1, 2, 3, 4, 5}));
+  meter.add(
+      Tensor::fromVector<int>({1, 2, 3, 4, 5}),
+      Tensor::fromVector<int>({1, 2, 3, 4, 6}));
+  ASSERT_NEAR(meter.value(), 46.0 / 3, 1e-10);
 }
 
 TEST(MeterTest, CountMeter) {
@@ -93,6 +160,31 @@ TEST(MeterTest, CountMeter) {
   ASSERT_EQ(val[2], 0);
 }
 
+TEST(MeterTest, TopKMeter) {
+  TopKMeter top1(1);
+  TopKMeter top2(2);
+  // 3 classes x 4 samples
+  auto output = Tensor::fromVector<float>(
+      {3, 4}, {0.1, 0.7, 0.2, 0.5, 0.3, 0.2, 0.1, 0.3, 0.6, 0.6, 0.1, 0.3});
+  auto target = Tensor::fromVector<int>({1, 1, 0, 2});
+  for (int i = 0; i < 2; ++i) {
+    top1.add(output, target);
+    top2.add(output, target);
+  }
+  ASSERT_EQ(top1.getStats(), std::make_pair(2, 8));
+  ASSERT_EQ(top2.getStats(), std::make_pair(6, 8));
+  ASSERT_DOUBLE_EQ(top1.value(), 25.0);
+  ASSERT_DOUBLE_EQ(top2.value(), 75.0);
+
+  top1.add(output, target);
+  top1.set(10, 20);
+  ASSERT_DOUBLE_EQ(top1.value(), 50.0);
+  top1.add(output, target);
+  top1.reset();
+  top1.add(output, target);
+  ASSERT_EQ(top1.getStats(), std::make_pair(1, 4));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
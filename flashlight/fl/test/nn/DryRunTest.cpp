@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/autograd/autograd.h"
+#include "flashlight/fl/nn/nn.h"
+#include "flashlight/fl/optim/optim.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Random.h"
+
+using namespace fl;
+
+namespace {
+
+std::shared_ptr<Module> createModel() {
+  auto model = std::make_shared<Sequential>();
+  model->add(Linear(16, 32));
+  model->add(ReLU());
+  model->add(Linear(32, 4));
+  return model;
+}
+
+Variable computeLoss(Module& model) {
+  auto input = Variable(fl::rand({16, 8}), false);
+  return fl::mean(model.forward({input}).front(), {0, 1});
+}
+
+TEST(DryRunTest, Report) {
+  const auto report = dryRun(
+      createModel, computeLoss, [](const std::vector<Variable>& params) {
+        return std::make_shared<AdamOptimizer>(params, 1e-3);
+      });
+  const size_t paramBytes = (16 * 32 + 32 + 32 * 4 + 4) * sizeof(float);
+  ASSERT_EQ(report.parameterBytes, paramBytes);
+  ASSERT_EQ(report.gradientBytes, paramBytes);
+  // both moments of Adam
+  ASSERT_EQ(report.optimizerStateBytes, 2 * paramBytes);
+  ASSERT_GT(report.activationBytes, 0);
+  ASSERT_GE(report.peakBytes, 4 * paramBytes + report.activationBytes);
+
+  // the matmuls of the linear layers dominate the forward pass
+  const uint64_t matmulFlops = 2 * 32 * 8 * 16 + 2 * 4 * 8 * 32;
+  ASSERT_GE(report.forwardFlops, matmulFlops);
+  // the gradients of the weights, and of the input of the second layer only
+  ASSERT_GE(report.backwardFlops, matmulFlops + 2 * 4 * 8 * 32);
+  ASSERT_GT(report.stepFlops, 0);
+
+  ASSERT_EQ(report.moduleFlops.size(), 3);
+  ASSERT_EQ(report.moduleFlops.front().first, "Linear (16->32) (with bias)");
+  ASSERT_GE(report.moduleFlops.front().second, 2 * 32 * 8 * 16);
+  uint64_t moduleFlops = 0;
+  for (const auto& [module, flops] : report.moduleFlops) {
+    moduleFlops += flops;
+  }
+  ASSERT_LE(moduleFlops, report.forwardFlops);
+
+  ASSERT_GT(report.savedMemory->totalBytes(), 0);
+  ASSERT_FALSE(report.prettyString().empty());
+}
+
+TEST(DryRunTest, Errors) {
+  ASSERT_THROW(dryRun(createModel, nullptr), std::invalid_argument);
+  ASSERT_THROW(
+      dryRun(
+          createModel,
+          [](Module& /* model */) -> Variable {
+            throw std::runtime_error("bad loss");
+          }),
+      std::runtime_error);
+  // the dry run ended
+  ASSERT_FALSE(detail::DryRunProfiler::getInstance().isEnabled());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
@@ -11,6 +11,7 @@
 
 #include "flashlight/fl/autograd/autograd.h"
 #include "flashlight/fl/common/common.h"
+#include "flashlight/fl/dataset/datasets.h"
 #include "flashlight/fl/nn/nn.h"
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Init.h"
@@ -367,6 +368,64 @@ TEST(ModuleTest, ConvolutionWithGroupFwd) {
   }
 }
 
+TEST(ModuleTest, QuantizedLinearFwd) {
+  if (!FL_BACKEND_CPU) {
+    GTEST_SKIP() << "int8 inference is only supported on CPU";
+  }
+  auto linear = Linear(32, 16);
+  auto input = fl::rand({32, 8, 4}) * 2 - 1;
+  auto expected = linear(noGrad(input));
+
+  auto quantized = QuantizedLinear(linear);
+  ASSERT_THROW(quantized(noGrad(input)), std::runtime_error);
+  // batches along the last axis
+  calibrateQuantization(quantized, TensorDataset({input}));
+  ASSERT_GT(quantized.inputScale(), 0);
+  auto output = quantized(noGrad(input));
+  ASSERT_EQ(output.shape(), expected.shape());
+  ASSERT_EQ(output.type(), fl::dtype::f32);
+  ASSERT_FALSE(output.isCalcGrad());
+  ASSERT_TRUE(allClose(output, expected, 5E-2));
+  // reuses the quantized weights
+  ASSERT_TRUE(allClose(quantized(noGrad(input)), output, 1E-7));
+}
+
+TEST(ModuleTest, QuantizedConv2DFwd) {
+  if (!FL_BACKEND_CPU) {
+    GTEST_SKIP() << "int8 inference is only supported on CPU";
+  }
+  for (const int groups : {1, 2}) {
+    auto conv = Conv2D(8, 16, 3, 3, 1, 1, 1, 1, 1, 1, true, groups);
+    auto input = fl::rand({12, 10, 8, 2});
+    auto expected = conv(noGrad(input));
+
+    auto quantized = QuantizedConv2D(conv);
+    calibrateQuantization(
+        quantized,
+        BatchDataset(std::make_shared<TensorDataset>(
+            std::vector<Tensor>{input}), /* batchsize = */ 2));
+    auto output = quantized(noGrad(input));
+    ASSERT_EQ(output.shape(), expected.shape());
+    ASSERT_TRUE(allClose(output, expected, 5E-2));
+  }
+}
+
+TEST(ModuleTest, QuantizedAdaptiveSoftMaxFwd) {
+  if (!FL_BACKEND_CPU) {
+    GTEST_SKIP() << "int8 inference is only supported on CPU";
+  }
+  auto adaptiveSoftMax = AdaptiveSoftMax(32, {10, 30, 60}, 2);
+  auto input = fl::rand({32, 5, 3}) * 2 - 1;
+  auto expected = adaptiveSoftMax(noGrad(input));
+
+  auto quantized = QuantizedAdaptiveSoftMax(adaptiveSoftMax);
+  ASSERT_EQ(quantized.modules().size(), 5);
+  calibrateQuantization(quantized, TensorDataset({input}));
+  auto output = quantized.forward(noGrad(input));
+  ASSERT_EQ(output.shape(), expected.shape());
+  ASSERT_TRUE(allClose(output, expected, 5E-2));
+}
+
 TEST(ModuleTest, PoolingFwd) {
   // test batching
   auto pool = Pool2D(9, 7, 1, 1, PaddingMode::SAME, PaddingMode::SAME);
@@ -627,6 +686,101 @@ TEST_F(ModuleTestF16, DropoutFwdF16) {
   ASSERT_TRUE(allClose(out, in, 1E-5));
 }
 
+TEST(ModuleTest, CheckpointFwdBwd) {
+  auto block = std::make_shared<Sequential>();
+  block->add(Linear(6, 8));
+  block->add(Tanh());
+  block->add(Linear(8, 4));
+  Checkpoint checkpoint(block);
+  ASSERT_EQ(checkpoint.params().size(), block->params().size());
+
+  auto input = Variable(fl::rand({6, 5}), true);
+  auto expected = block->forward(input);
+  fl::sum(expected * expected, {0, 1}).backward();
+  auto expectedInputGrad = input.grad().tensor();
+  std::vector<Tensor> expectedGrads;
+  for (auto& param : block->params()) {
+    expectedGrads.push_back(param.grad().tensor());
+    param.zeroGrad();
+  }
+  input.zeroGrad();
+
+  auto output = checkpoint(input);
+  ASSERT_TRUE(allClose(output, expected, 1E-6));
+  fl::sum(output * output, {0, 1}).backward();
+  ASSERT_TRUE(allClose(input.grad().tensor(), expectedInputGrad, 1E-5));
+  for (int i = 0; i < block->params().size(); ++i) {
+    ASSERT_TRUE(
+        allClose(block->param(i).grad().tensor(), expectedGrads[i], 1E-5));
+  }
+}
+
+TEST(ModuleTest, CheckpointDropout) {
+  auto block = std::make_shared<Sequential>();
+  block->add(Dropout(0.5));
+  Checkpoint checkpoint(block);
+  checkpoint.train();
+
+  // the gradient of dropout is its scaled mask, which must be the same as
+  // the forward pass's when recomputed
+  auto input = Variable(fl::full({100, 100}, 1.), true);
+  auto output = checkpoint(input);
+  output.backward();
+  ASSERT_TRUE(allClose(input.grad(), output));
+  ASSERT_GT(fl::amax(output.tensor()).scalar<float>(), 1.5);
+
+  // masks differ across forward passes
+  ASSERT_FALSE(allClose(checkpoint(input), output));
+}
+
+TEST(ModuleTest, SavedMemoryProfile) {
+  Sequential model;
+  model.add(Linear(6, 8));
+  model.add(Tanh());
+  auto input = Variable(fl::rand({6, 5}), true);
+
+  SavedMemoryProfile profile;
+  {
+    SavedMemoryProfileScope scope(profile);
+    auto output = model(input);
+  }
+  ASSERT_GT(profile.totalBytes(), 0);
+  auto moduleBytes = profile.moduleBytes();
+  ASSERT_FALSE(moduleBytes.empty());
+  // the first module saves the most, its input and weight
+  ASSERT_EQ(moduleBytes.front().first.find("Sequential"), 0);
+  ASSERT_NE(
+      moduleBytes.front().first.find(" / Linear (6->8) (with bias)"),
+      std::string::npos);
+  ASSERT_GE(
+      moduleBytes.front().second,
+      input.bytes() + model.param(0).bytes());
+
+  bool hasTanh = false;
+  auto entries = profile.entries();
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (i > 0) {
+      ASSERT_LE(entries[i].bytes, entries[i - 1].bytes);
+    }
+    if (entries[i].op == "fl::tanh") {
+      hasTanh = true;
+      ASSERT_NE(entries[i].module.find(" / Tanh"), std::string::npos);
+      // tanh captures its output instead of saving its input
+      ASSERT_EQ(entries[i].bytes, 0);
+      ASSERT_EQ(entries[i].outputBytes, 8 * 5 * sizeof(float));
+    }
+  }
+  ASSERT_TRUE(hasTanh);
+  ASSERT_NE(profile.prettyString().find("fl::tanh"), std::string::npos);
+
+  // nodes created outside of the scope aren't recorded
+  const auto totalBytes = profile.totalBytes();
+  model(input);
+  ASSERT_EQ(profile.totalBytes(), totalBytes);
+  profile.clear();
+  ASSERT_TRUE(profile.entries().empty());
+}
+
 TEST(ModuleTest, PaddingFwd) {
   auto module = Padding({{1, 2}, {3, 4}}, -1);
   auto input = Variable(fl::rand({1, 2, 3, 4}, fl::dtype::f64), true);
@@ -816,6 +970,39 @@ TEST(ModuleTest, AdaptiveSoftMaxPredict) {
   ASSERT_TRUE(allClose(result1, result2));
 }
 
+TEST(ModuleTest, AdaptiveSoftMaxTopK) {
+  // test topK gives the same as topk along the full log probs
+  int N = 5;
+  int T = 10;
+  int B = 5;
+  unsigned k = 4;
+
+  auto x = input(fl::rand({N, T, B}, fl::dtype::f32));
+  std::vector<int> cutoff{{3, 8, 12}};
+  auto activation = std::make_shared<AdaptiveSoftMax>(N, cutoff);
+
+  auto logProbs = activation->forward(x).tensor();
+  Tensor expectedValues, expectedIndices;
+  fl::topk(expectedValues, expectedIndices, logProbs, k, 0);
+
+  Tensor values, indices;
+  activation->topK(values, indices, x, k);
+  ASSERT_EQ(values.shape(), Shape({k, T, B}));
+  ASSERT_EQ(indices.type(), fl::dtype::s32);
+  ASSERT_TRUE(allClose(values, expectedValues, 1e-5));
+  ASSERT_TRUE(allClose(indices, expectedIndices.astype(fl::dtype::s32)));
+
+  // k can exceed the size of the head
+  activation->topK(values, indices, x, cutoff.back());
+  fl::topk(expectedValues, expectedIndices, logProbs, cutoff.back(), 0);
+  ASSERT_TRUE(allClose(values, expectedValues, 1e-5));
+
+  ASSERT_THROW(activation->topK(values, indices, x, 0), std::invalid_argument);
+  ASSERT_THROW(
+      activation->topK(values, indices, x, cutoff.back() + 1),
+      std::invalid_argument);
+}
+
 TEST(ModuleTest, AdaptiveSoftMaxLossBatchFwd) {
   // test batching
   int N = 5;
@@ -871,6 +1058,43 @@ TEST(ModuleTest, AdaptiveSoftMaxLossIgnoreIndex) {
       1E-5);
 }
 
+TEST(ModuleTest, AdaptiveSoftMaxLossFwdBwd) {
+  // the loss and its gradients match the NLL of the full log probs
+  int N = 5;
+  int T = 10;
+  int B = 5;
+  std::vector<int> cutoff{{3, 8, 12}};
+
+  auto x = Variable(fl::rand({N, T, B}, fl::dtype::f32), true);
+  auto y = Variable(
+      (fl::rand({T, B}, fl::dtype::u32) % cutoff.back())
+          .astype(fl::dtype::s32),
+      false);
+  auto ignoreIdx = y(0, 0).scalar<int>();
+
+  auto activation = std::make_shared<AdaptiveSoftMax>(N, cutoff);
+  auto expected = categoricalCrossEntropy(
+      activation->forward(x), y, ReduceMode::MEAN, ignoreIdx);
+  expected.backward();
+  auto expectedInputGrad = x.grad().tensor();
+  std::vector<Tensor> expectedGrads;
+  for (auto& param : activation->params()) {
+    expectedGrads.push_back(param.grad().tensor());
+    param.zeroGrad();
+  }
+  x.zeroGrad();
+
+  auto asml = AdaptiveSoftMaxLoss(activation, ReduceMode::MEAN, ignoreIdx);
+  auto loss = asml.forward(x, y);
+  ASSERT_TRUE(allClose(loss, expected, 1E-5));
+  loss.backward();
+  ASSERT_TRUE(allClose(x.grad().tensor(), expectedInputGrad, 1E-5));
+  for (int i = 0; i < expectedGrads.size(); ++i) {
+    ASSERT_TRUE(
+        allClose(asml.param(i).grad().tensor(), expectedGrads[i], 1E-5));
+  }
+}
+
 TEST(ModuleTest, IdentityFwd) {
   auto module = Identity();
   std::vector<Variable> in = {
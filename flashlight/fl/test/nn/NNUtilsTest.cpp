@@ -5,9 +5,12 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <typeinfo>
+
 #include <gtest/gtest.h>
 
 #include "flashlight/fl/autograd/autograd.h"
+#include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/fl/nn/nn.h"
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Init.h"
@@ -111,6 +114,137 @@ TEST(UtilsTest, Join) {
                   .asScalar<bool>());
 }
 
+TEST(UtilsTest, OptimizeForInference) {
+  Sequential model;
+  model.add(Conv2D(3, 4, 3, 3, 1, 1, 1, 1, 1, 1, false));
+  model.add(BatchNorm(2, 4));
+  model.add(ReLU());
+  model.add(Dropout(0.5));
+  model.add(View({4 * 5 * 5, -1}));
+  model.add(WeightNorm(Linear(4 * 5 * 5, 6), 0));
+  model.add(BatchNorm(0, 6));
+  model.add(Identity());
+
+  // populate the running statistics
+  model.train();
+  for (int i = 0; i < 3; ++i) {
+    model(input(fl::rand({5, 5, 3, 8})));
+  }
+  model.eval();
+  auto in = input(fl::rand({5, 5, 3, 2}));
+  auto expected = model(in).tensor();
+
+  optimizeForInference(model);
+  ASSERT_EQ(model.modules().size(), 4);
+  ASSERT_EQ(typeid(*model.module(0)), typeid(Conv2D));
+  ASSERT_EQ(typeid(*model.module(3)), typeid(Linear));
+  ASSERT_EQ(model.params().size(), 4);
+  ASSERT_TRUE(allClose(model(in).tensor(), expected, 1e-4));
+}
+
+TEST(UtilsTest, OptimizeForInferenceUnfoldable) {
+  Sequential model;
+  model.add(Linear(4, 3));
+  // batch statistics, and a different axis than the features
+  model.add(BatchNorm(0, 3, 0.1, 1e-5, true, false));
+  model.add(BatchNorm(1, 2));
+  model.train();
+  model(input(fl::rand({4, 2})));
+  model.eval();
+  auto in = input(fl::rand({4, 2}));
+  auto expected = model(in).tensor();
+
+  optimizeForInference(model);
+  ASSERT_EQ(model.modules().size(), 3);
+  ASSERT_TRUE(allClose(model(in).tensor(), expected, 1e-5));
+}
+
+TEST(UtilsTest, SetMemoryFormat) {
+  Sequential model;
+  model.add(Conv2D(3, 4, 3, 3, 2, 1, PaddingMode::SAME, 1, 1, 1, true));
+  model.add(BatchNorm(2, 4));
+  model.add(ReLU());
+  model.add(Pool2D(2, 2, 2, 2, PaddingMode::SAME, 0, PoolingMode::MAX));
+  model.add(Conv2D(4, 6, 1, 1, 1, 1, 0, 0, 1, 1, false, 2));
+  model.eval();
+  auto in = input(fl::rand({7, 6, 3, 2}));
+  auto expected = model(in).tensor();
+
+  setMemoryFormat(model, MemoryFormat::CWHN);
+  auto conv = std::dynamic_pointer_cast<Conv2D>(model.module(0));
+  ASSERT_EQ(conv->getMemoryFormat(), MemoryFormat::CWHN);
+  ASSERT_EQ(conv->param(0).shape(), Shape({3, 3, 3, 4}));
+  ASSERT_EQ(model.param(0).shape(), Shape({3, 3, 3, 4}));
+  ASSERT_EQ(model.param(1).shape(), Shape({4, 1, 1, 1}));
+  auto channelsLastIn = input(fl::transpose(in.tensor(), {2, 0, 1, 3}));
+  auto output = model(channelsLastIn).tensor();
+  ASSERT_TRUE(
+      allClose(fl::transpose(output, {1, 2, 0, 3}), expected, 1e-5));
+
+  setMemoryFormat(model, MemoryFormat::WHCN);
+  ASSERT_TRUE(allClose(model(in).tensor(), expected, 1e-5));
+}
+
+TEST(UtilsTest, FrozenModel) {
+  Sequential model;
+  model.add(Conv2D(3, 4, 3, 3, 1, 1, PaddingMode::SAME, 1, 1, 1, true));
+  model.add(BatchNorm(2, 4));
+  model.add(ReLU());
+  model.add(Pool2D(2, 2, 2, 2, PaddingMode::SAME, 0, PoolingMode::MAX));
+  model.add(Dropout(0.5));
+  model.add(View({4 * 3 * 3, -1}));
+  model.add(Linear(4 * 3 * 3, 6));
+  // not folded: batch norms are only folded into preceding layers
+  model.add(LeakyReLU(0.1));
+  model.add(BatchNorm(0, 6));
+  model.add(LayerNorm(std::vector<int>{0}));
+  model.add(LogSoftmax());
+
+  model.train();
+  for (int i = 0; i < 3; ++i) {
+    model(input(fl::rand({5, 5, 3, 8})));
+  }
+  model.eval();
+  auto in = fl::rand({5, 5, 3, 2});
+  auto expected = model(input(in)).tensor();
+
+  FrozenModel frozen(model);
+  // the batch norm following the convolution is folded, the dropout removed
+  ASSERT_EQ(frozen.ops().size(), 9);
+  ASSERT_EQ(frozen.ops()[6].type, FrozenModel::OpType::Affine);
+  ASSERT_TRUE(allClose(frozen(in), expected, 1e-4));
+
+  const auto path = fs::temp_directory_path() / "FrozenModel.mdl";
+  save(path, frozen);
+  FrozenModel loaded;
+  load(path, loaded);
+  ASSERT_TRUE(allClose(loaded(in), expected, 1e-4));
+  fs::remove(path);
+}
+
+TEST(UtilsTest, FrozenModelEmbedding) {
+  Sequential model;
+  model.add(Embedding(4, 10));
+  model.add(Tanh());
+  auto in = (fl::rand({3, 2}) * 10).astype(fl::dtype::s32);
+  auto expected = model(input(in)).tensor();
+
+  FrozenModel frozen(model);
+  ASSERT_EQ(frozen.ops().size(), 2);
+  ASSERT_TRUE(allClose(frozen(in), expected, 1e-5));
+}
+
+TEST(UtilsTest, FrozenModelUnsupported) {
+  Sequential model;
+  model.add(Linear(4, 3));
+  model.add(RNN(3, 2, 1, RnnMode::LSTM));
+  ASSERT_THROW(FrozenModel{model}, std::invalid_argument);
+
+  Sequential batchStatistics;
+  batchStatistics.add(BatchNorm(1, 2, 0.1, 1e-5, true, false));
+  ASSERT_THROW(FrozenModel{batchStatistics}, std::invalid_argument);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
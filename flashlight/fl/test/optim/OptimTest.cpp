@@ -8,9 +8,12 @@
 #include <gtest/gtest.h>
 
 #include <cmath>
+#include <functional>
+#include <memory>
 
 #include "flashlight/fl/common/common.h"
 #include "flashlight/fl/optim/optim.h"
+#include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Random.h"
 
 using namespace fl;
@@ -59,6 +62,309 @@ TEST(OptimTest, GradNormF16) {
   ASSERT_TRUE(allClose(fl::full({1}, max_norm), fl::full({1}, clipped), 1e-2));
 }
 
+TEST(OptimTest, GradNormLazy) {
+  std::vector<Variable> parameters;
+  std::vector<Tensor> grads;
+  double norm = 0.0;
+  for (int i = 0; i < 5; i++) {
+    auto v = Variable(fl::randn({10, 10}), true);
+    grads.push_back(fl::randn({10, 10}));
+    v.addGrad(Variable(grads.back().copy(), false));
+    norm += fl::sum(grads.back() * grads.back()).asScalar<double>();
+    parameters.push_back(v);
+  }
+  parameters.push_back(Variable(fl::randn({3}), true)); // without a gradient
+  norm = std::sqrt(norm);
+
+  // gradients under the maximum norm are unchanged
+  auto gradNorm = clipGradNormLazy(parameters, norm * 2);
+  ASSERT_NEAR(gradNorm.asScalar<double>(), norm, norm * 1e-5);
+  for (size_t i = 0; i < grads.size(); ++i) {
+    ASSERT_TRUE(allClose(parameters[i].grad().tensor(), grads[i], 1e-5));
+  }
+
+  gradNorm = clipGradNormLazy(parameters, norm / 4);
+  ASSERT_NEAR(gradNorm.asScalar<double>(), norm, norm * 1e-5);
+  for (size_t i = 0; i < grads.size(); ++i) {
+    ASSERT_TRUE(allClose(parameters[i].grad().tensor(), grads[i] / 4, 1e-5));
+  }
+  ASSERT_EQ(clipGradNormLazy({}, 1.0).asScalar<double>(), 0.0);
+}
+
+TEST(OptimTest, AdamBF16) {
+  if (!fl::bf16Supported()) {
+    GTEST_SKIP() << "bfloat16 not supported on this device";
+  }
+
+  auto data = fl::randn({10, 10}).astype(fl::dtype::bf16);
+  auto grad = fl::randn({10, 10}).astype(fl::dtype::bf16);
+  auto param = Variable(data, true);
+  param.addGrad(Variable(grad, false));
+  auto paramF32 = Variable(data.astype(fl::dtype::f32), true);
+  paramF32.addGrad(Variable(grad.astype(fl::dtype::f32), false));
+
+  AdamOptimizer opt({param}, 0.01);
+  AdamOptimizer optF32({paramF32}, 0.01);
+  for (int i = 0; i < 5; ++i) {
+    opt.step();
+    optF32.step();
+  }
+  ASSERT_EQ(param.type(), fl::dtype::bf16);
+  ASSERT_TRUE(allClose(
+      param.tensor().astype(fl::dtype::f32), paramF32.tensor(), 5e-2));
+}
+
+TEST(OptimTest, MasterWeights) {
+  if (!fl::f16Supported()) {
+    GTEST_SKIP() << "Half-precision not supported on this device";
+  }
+
+  auto data = fl::randn({10, 10});
+  auto bias = fl::randn({10});
+  auto param = Variable(data.astype(fl::dtype::f16), true);
+  auto biasParam = Variable(bias, true);
+  auto paramF32 = Variable(param.tensor().astype(fl::dtype::f32), true);
+  auto biasF32 = Variable(bias.copy(), true);
+  auto makeAdam = [](const std::vector<Variable>& params) {
+    return std::make_shared<AdamOptimizer>(params, 0.01);
+  };
+  MasterWeightsOptimizer opt({param, biasParam}, makeAdam);
+  auto optF32 = makeAdam({paramF32, biasF32});
+  ASSERT_EQ(opt.getLr(), 0.01);
+  ASSERT_EQ(opt.masterParameters()[0].type(), fl::dtype::f32);
+
+  const double lossScale = 128;
+  opt.setLossScale(lossScale);
+  for (int i = 0; i < 5; ++i) {
+    auto grad = fl::randn({10, 10});
+    auto biasGrad = fl::randn({10});
+    opt.zeroGrad();
+    param.addGrad(
+        Variable((grad * lossScale).astype(fl::dtype::f16), false));
+    biasParam.addGrad(Variable(biasGrad * lossScale, false));
+    optF32->zeroGrad();
+    paramF32.addGrad(Variable(
+        (grad * lossScale).astype(fl::dtype::f16).astype(fl::dtype::f32) /
+            lossScale,
+        false));
+    biasF32.addGrad(Variable(biasGrad, false));
+    opt.step();
+    optF32->step();
+    ASSERT_TRUE(opt.isLastStepFinite());
+  }
+  ASSERT_EQ(param.type(), fl::dtype::f16);
+  ASSERT_TRUE(
+      allClose(opt.masterParameters()[0].tensor(), paramF32.tensor(), 1e-4));
+  ASSERT_TRUE(allClose(
+      param.tensor(),
+      opt.masterParameters()[0].tensor().astype(fl::dtype::f16)));
+  ASSERT_TRUE(allClose(biasParam.tensor(), biasF32.tensor(), 1e-4));
+
+  // overflowing gradients skip the step
+  auto before = opt.masterParameters()[0].tensor().copy();
+  opt.zeroGrad();
+  param.addGrad(
+      Variable(fl::full({10, 10}, 1e5).astype(fl::dtype::f16), false));
+  opt.step();
+  ASSERT_FALSE(opt.isLastStepFinite());
+  ASSERT_TRUE(allClose(opt.masterParameters()[0].tensor(), before));
+}
+
+TEST(OptimTest, RowSparseGrad) {
+  auto indices = Tensor::fromVector<int>({4, 1, 4});
+  auto values = fl::randn({5, 3});
+  auto grad = fl::full({5, 6}, 0.);
+  grad(fl::span, 1) = values(fl::span, 1);
+  grad(fl::span, 4) = values(fl::span, 0) + values(fl::span, 2);
+  auto data = fl::randn({5, 6});
+
+  using OptimizerFactory =
+      std::function<std::unique_ptr<FirstOrderOptimizer>(const Variable&)>;
+  std::vector<OptimizerFactory> factories = {
+      [](const Variable& p) {
+        return std::make_unique<SGDOptimizer>(std::vector<Variable>{p}, 0.1);
+      },
+      [](const Variable& p) {
+        return std::make_unique<SGDOptimizer>(
+            std::vector<Variable>{p}, 0.1, 0.9, 0.01);
+      },
+      [](const Variable& p) {
+        return std::make_unique<SGDOptimizer>(
+            std::vector<Variable>{p}, 0.1, 0.9, 0.01, true);
+      },
+      [](const Variable& p) {
+        return std::make_unique<AdagradOptimizer>(
+            std::vector<Variable>{p}, 0.1);
+      },
+      [](const Variable& p) {
+        return std::make_unique<AdamOptimizer>(
+            std::vector<Variable>{p}, 0.1, 0.9, 0.999, 1e-8, 0.01);
+      }};
+  for (const auto& makeOptimizer : factories) {
+    auto param = Variable(data, true);
+    auto sparseParam = Variable(data, true);
+    auto opt = makeOptimizer(param);
+    auto sparseOpt = makeOptimizer(sparseParam);
+    for (int i = 0; i < 3; ++i) {
+      param.zeroGrad();
+      param.addGrad(Variable(grad, false));
+      sparseParam.zeroGrad();
+      sparseParam.addGrad(Variable::rowSparse(indices, values, {5, 6}));
+      opt->step();
+      sparseOpt->step();
+      ASSERT_TRUE(sparseParam.grad().isRowSparse()) << opt->prettyString();
+    }
+    ASSERT_TRUE(allClose(sparseParam.tensor(), param.tensor(), 1e-5))
+        << opt->prettyString();
+  }
+}
+
+TEST(OptimTest, LazySparseStep) {
+  auto indices = Tensor::fromVector<int>({4, 1, 4});
+  auto rows = Tensor::fromVector<int>({1, 4});
+  auto values = fl::randn({5, 3});
+  // the coalesced gradient of the rows
+  auto grad = fl::concatenate(
+      1, values(fl::span, 1), values(fl::span, 0) + values(fl::span, 2));
+  auto data = fl::randn({5, 6});
+
+  using OptimizerFactory =
+      std::function<std::unique_ptr<FirstOrderOptimizer>(const Variable&)>;
+  std::vector<OptimizerFactory> factories = {
+      [](const Variable& p) {
+        return std::make_unique<SGDOptimizer>(
+            std::vector<Variable>{p}, 0.1, 0.9, 0.01);
+      },
+      [](const Variable& p) {
+        return std::make_unique<SGDOptimizer>(
+            std::vector<Variable>{p}, 0.1, 0.9, 0.01, true);
+      },
+      [](const Variable& p) {
+        return std::make_unique<AdagradOptimizer>(
+            std::vector<Variable>{p}, 0.1, 1e-8, 0.01);
+      },
+      [](const Variable& p) {
+        return std::make_unique<AdamOptimizer>(
+            std::vector<Variable>{p}, 0.1, 0.9, 0.999, 1e-8, 0.01);
+      }};
+  for (const auto& makeOptimizer : factories) {
+    // a lazy step is a dense step of the rows with gradients
+    auto rowsParam = Variable(data(fl::span, rows), true);
+    auto sparseParam = Variable(data, true);
+    auto opt = makeOptimizer(rowsParam);
+    auto sparseOpt = makeOptimizer(sparseParam);
+    sparseOpt->setLazySparse(true);
+    ASSERT_TRUE(sparseOpt->isLazySparse());
+    for (int i = 0; i < 3; ++i) {
+      rowsParam.zeroGrad();
+      rowsParam.addGrad(Variable(grad, false));
+      sparseParam.zeroGrad();
+      sparseParam.addGrad(Variable::rowSparse(indices, values, {5, 6}));
+      opt->step();
+      sparseOpt->step();
+    }
+    ASSERT_TRUE(allClose(
+        sparseParam.tensor()(fl::span, rows), rowsParam.tensor(), 1e-5))
+        << opt->prettyString();
+    for (const int row : {0, 2, 3, 5}) {
+      ASSERT_TRUE(allClose(
+          sparseParam.tensor()(fl::span, row), data(fl::span, row)))
+          << opt->prettyString();
+    }
+  }
+}
+
+TEST(OptimTest, MultiTensorStep) {
+  using Params = std::vector<Variable>;
+  using OptimizerFactory =
+      std::function<std::unique_ptr<FirstOrderOptimizer>(const Params&)>;
+  std::vector<OptimizerFactory> factories = {
+      [](const Params& p) {
+        return std::make_unique<SGDOptimizer>(p, 0.1, 0.9, 0.01);
+      },
+      [](const Params& p) {
+        return std::make_unique<SGDOptimizer>(p, 0.1, 0, 0.01);
+      },
+      [](const Params& p) {
+        return std::make_unique<SGDOptimizer>(p, 0.1, 0.9, 0.01, true);
+      },
+      [](const Params& p) {
+        return std::make_unique<AdamOptimizer>(p, 0.1, 0.9, 0.999, 1e-8, 0.01);
+      },
+      [](const Params& p) {
+        return std::make_unique<AMSgradOptimizer>(
+            p, 0.1, 0.9, 0.999, 1e-8, 0.01);
+      },
+      [](const Params& p) {
+        return std::make_unique<AdagradOptimizer>(p, 0.1, 1e-8, 0.01);
+      },
+      [](const Params& p) {
+        return std::make_unique<AdadeltaOptimizer>(p, 1.0, 0.9, 1e-8, 0.01);
+      },
+      [](const Params& p) {
+        return std::make_unique<NAGOptimizer>(p, 0.1, 0.9, 0.01);
+      },
+      [](const Params& p) {
+        return std::make_unique<NovogradOptimizer>(
+            p, 0.1, 0.95, 0.98, 1e-8, 0.01);
+      },
+      [](const Params& p) {
+        return std::make_unique<RMSPropOptimizer>(
+            p, 0.1, 0.99, 1e-8, 0.01, true);
+      }};
+  std::vector<Tensor> data = {
+      fl::randn({5, 6}),
+      fl::randn({7}),
+      fl::randn({2, 3, 4}),
+      fl::randn({3}, fl::dtype::f64)};
+  std::vector<Tensor> grads;
+  for (int i = 0; i < 3; ++i) {
+    for (const auto& d : data) {
+      grads.push_back(fl::randn(d.shape(), d.type()));
+    }
+  }
+
+  for (const auto& makeOptimizer : factories) {
+    Params params, multiParams, arenaParams;
+    for (const auto& d : data) {
+      params.emplace_back(d.copy(), true);
+      multiParams.emplace_back(d.copy(), true);
+      arenaParams.emplace_back(d.copy(), true);
+    }
+    auto opt = makeOptimizer(params);
+    auto multiOpt = makeOptimizer(multiParams);
+    multiOpt->setMultiTensor(true);
+    auto arenaOpt = makeOptimizer(arenaParams);
+    arenaOpt->setMultiTensor(true);
+    GradientArena arena(arenaParams);
+    for (int step = 0; step < 3; ++step) {
+      for (size_t i = 0; i < data.size(); ++i) {
+        // the last parameter has no gradient at the second step
+        if (step == 1 && i == data.size() - 1) {
+          continue;
+        }
+        const auto& grad = grads[step * data.size() + i];
+        params[i].addGrad(Variable(grad, false));
+        multiParams[i].addGrad(Variable(grad, false));
+        arenaParams[i].addGrad(Variable(grad, false));
+      }
+      opt->step();
+      multiOpt->step();
+      arenaOpt->step();
+      opt->zeroGrad();
+      multiOpt->zeroGrad();
+      arenaOpt->zeroGrad();
+    }
+    for (size_t i = 0; i < data.size(); ++i) {
+      ASSERT_EQ(multiParams[i].shape(), params[i].shape());
+      ASSERT_TRUE(allClose(multiParams[i].tensor(), params[i].tensor(), 1e-5))
+          << opt->prettyString();
+      ASSERT_TRUE(allClose(arenaParams[i].tensor(), params[i].tensor(), 1e-5))
+          << opt->prettyString();
+    }
+  }
+}
+
 TEST(SerializationTest, OptimizerSerialize) {
   const fs::path path = fs::temp_directory_path() / "optmizer.bin";
 
@@ -8,6 +8,7 @@
 #include <gtest/gtest.h>
 
 #include "flashlight/fl/runtime/CUDADevice.h"
+#include "flashlight/fl/runtime/CUDAStream.h"
 #include "flashlight/fl/runtime/DeviceManager.h"
 #include "flashlight/fl/tensor/Init.h"
 
@@ -16,6 +17,7 @@
 using fl::CUDADevice;
 using fl::DeviceManager;
 using fl::DeviceType;
+using fl::StreamPriority;
 
 TEST(CUDADeviceTest, impl) {
   auto& manager = DeviceManager::getInstance();
@@ -41,6 +43,31 @@ TEST(CUDADeviceTest, nativeId) {
   }
 }
 
+TEST(CUDADeviceTest, getStreamFromPool) {
+  auto& manager = DeviceManager::getInstance();
+  auto& cudaDevice =
+    manager.getActiveDevice(DeviceType::CUDA).impl<CUDADevice>();
+  auto lowStream = cudaDevice.getCUDAStreamFromPool(StreamPriority::Low);
+  auto highStream = cudaDevice.getCUDAStreamFromPool(StreamPriority::High);
+  ASSERT_NE(lowStream, highStream);
+  ASSERT_EQ(&lowStream->device(), &cudaDevice);
+  ASSERT_EQ(&highStream->device(), &cudaDevice);
+  ASSERT_EQ(cudaDevice.getStreams().count(lowStream), 1);
+
+  int lowPriority, highPriority;
+  cudaStreamGetPriority(lowStream->handle(), &lowPriority);
+  cudaStreamGetPriority(highStream->handle(), &highPriority);
+  ASSERT_LE(highPriority, lowPriority);
+
+  auto stream = manager.getStreamFromPool(DeviceType::CUDA);
+  ASSERT_EQ(stream->type(), fl::StreamType::CUDA);
+  {
+    fl::StreamGuard guard(stream);
+    ASSERT_EQ(cudaDevice.getCurrentStream(), stream);
+  }
+  ASSERT_EQ(cudaDevice.getCurrentStream(), nullptr);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
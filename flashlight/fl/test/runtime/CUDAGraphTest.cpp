@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/runtime/CUDAGraph.h"
+#include "flashlight/fl/runtime/CUDAUtils.h"
+#include "flashlight/fl/tensor/Init.h"
+
+#include <cuda_runtime.h>
+
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using fl::CUDAGraph;
+using fl::CUDAGraphCache;
+using fl::CUDAStream;
+
+namespace {
+
+constexpr size_t kNumElements = 1024;
+constexpr size_t kBytes = kNumElements * sizeof(int);
+
+} // namespace
+
+TEST(CUDAGraphTest, captureAndReplay) {
+  auto stream = CUDAStream::createManaged(cudaStreamNonBlocking);
+  std::vector<int> host(kNumElements);
+  std::iota(host.begin(), host.end(), 0);
+  void* src;
+  void* dst;
+  FL_CUDA_CHECK(cudaMalloc(&src, kBytes));
+  FL_CUDA_CHECK(cudaMalloc(&dst, kBytes));
+  FL_CUDA_CHECK(cudaMemset(dst, 0, kBytes));
+
+  CUDAGraph graph;
+  ASSERT_FALSE(graph.isCaptured());
+  ASSERT_THROW(graph.replay(), std::runtime_error);
+  ASSERT_THROW(graph.endCapture(), std::runtime_error);
+  graph.capture(*stream, [&]() { stream->copyAsync(dst, src, kBytes); });
+  ASSERT_TRUE(graph.isCaptured());
+  ASSERT_THROW(graph.beginCapture(*stream), std::runtime_error);
+
+  // capturing doesn't execute the work, replaying does
+  stream->copyAsync(src, host.data(), kBytes);
+  std::vector<int> result(kNumElements);
+  stream->copyAsync(result.data(), dst, kBytes);
+  stream->sync();
+  ASSERT_EQ(result, std::vector<int>(kNumElements, 0));
+  graph.replay();
+  stream->copyAsync(result.data(), dst, kBytes);
+  stream->sync();
+  ASSERT_EQ(result, host);
+
+  FL_CUDA_CHECK(cudaFree(src));
+  FL_CUDA_CHECK(cudaFree(dst));
+}
+
+TEST(CUDAGraphTest, cache) {
+  auto stream = CUDAStream::createManaged(cudaStreamNonBlocking);
+  void* src;
+  void* dst;
+  FL_CUDA_CHECK(cudaMalloc(&src, kBytes));
+  FL_CUDA_CHECK(cudaMalloc(&dst, kBytes));
+  unsigned numCalls = 0;
+  auto fn = [&]() {
+    numCalls++;
+    stream->copyAsync(dst, src, kBytes);
+  };
+
+  CUDAGraphCache cache(/* numWarmupRuns = */ 1);
+  // one eager run, one captured run, then replays
+  for (int i = 0; i < 4; i++) {
+    cache.run("a", *stream, fn);
+  }
+  ASSERT_EQ(numCalls, 2);
+  ASSERT_EQ(cache.size(), 1);
+  cache.run("b", *stream, fn);
+  ASSERT_EQ(numCalls, 3);
+  ASSERT_EQ(cache.size(), 1);
+  stream->sync();
+
+  cache.clear();
+  ASSERT_EQ(cache.size(), 0);
+  FL_CUDA_CHECK(cudaFree(src));
+  FL_CUDA_CHECK(cudaFree(dst));
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
@@ -14,8 +14,12 @@
 
 #include <cuda_runtime.h>
 
+#include <numeric>
+#include <vector>
+
 using fl::DeviceManager;
 using fl::DeviceType;
+using fl::CUDAEvent;
 using fl::CUDAStream;
 using fl::Stream;
 using fl::StreamType;
@@ -112,6 +116,30 @@ TEST(CUDAStreamTest, sync) {
   ASSERT_NO_THROW(cs1->sync());
 }
 
+TEST(CUDAStreamTest, copyAsync) {
+  auto cs1 = CUDAStream::createManaged();
+  auto cs2 = CUDAStream::createManaged();
+  std::vector<int> src(1024);
+  std::iota(src.begin(), src.end(), 0);
+  std::vector<int> dst(src.size());
+  const size_t bytes = src.size() * sizeof(int);
+  void* devicePtr;
+  FL_CUDA_CHECK(cudaMalloc(&devicePtr, bytes));
+
+  // upload on one stream, read back on another once the upload is done
+  cs1->copyAsync(devicePtr, src.data(), bytes);
+  auto uploaded = cs1->recordEvent();
+  ASSERT_EQ(uploaded->type(), StreamType::CUDA);
+  ASSERT_NO_THROW(uploaded->impl<CUDAEvent>());
+  cs2->relativeSync(*uploaded);
+  cs2->copyAsync(dst.data(), devicePtr, bytes);
+  auto downloaded = cs2->recordEvent();
+  downloaded->sync();
+  ASSERT_TRUE(downloaded->isReady());
+  ASSERT_EQ(src, dst);
+  FL_CUDA_CHECK(cudaFree(devicePtr));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
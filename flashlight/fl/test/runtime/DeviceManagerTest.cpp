@@ -77,6 +77,20 @@ TEST(DeviceManagerTest, getActiveDevice) {
   }
 }
 
+TEST(DeviceManagerTest, setCPUOnly) {
+  auto& manager = DeviceManager::getInstance();
+  if (manager.isDeviceTypeAvailable(DeviceType::CUDA)) {
+    // CUDA devices are initialized by now
+    manager.getDeviceCount(DeviceType::CUDA);
+    ASSERT_THROW(DeviceManager::setCPUOnly(), std::runtime_error);
+    return;
+  }
+  DeviceManager::setCPUOnly();
+  ASSERT_TRUE(DeviceManager::isCPUOnly());
+  ASSERT_FALSE(manager.isDeviceTypeAvailable(DeviceType::CUDA));
+  ASSERT_EQ(manager.getDeviceCount(DeviceType::x64), 1);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
@@ -7,6 +7,8 @@
 
 #include <gtest/gtest.h>
 
+#include <thread>
+
 #include "flashlight/fl/runtime/DeviceManager.h"
 #include "flashlight/fl/tensor/Init.h"
 
@@ -82,6 +84,34 @@ TEST(DeviceTest, getStream) {
   }
 }
 
+TEST(DeviceTest, currentStream) {
+  auto& manager = DeviceManager::getInstance();
+  for (const auto type : fl::getDeviceTypes()) {
+    if (manager.isDeviceTypeAvailable(type)) {
+      for (auto* device : manager.getDevicesOfType(type)) {
+        ASSERT_EQ(device->getCurrentStream(), nullptr);
+        for (const auto& stream : device->getStreams()) {
+          {
+            fl::StreamGuard guard(stream);
+            ASSERT_EQ(device->getCurrentStream(), stream);
+            // the selection is per thread
+            std::thread([device]() {
+              ASSERT_EQ(device->getCurrentStream(), nullptr);
+            }).join();
+          }
+          ASSERT_EQ(device->getCurrentStream(), nullptr);
+        }
+      }
+    }
+  }
+}
+
+TEST(DeviceTest, getStreamFromPool) {
+  auto& manager = DeviceManager::getInstance();
+  auto& x64Device = manager.getDevice(DeviceType::x64, fl::kX64DeviceId);
+  ASSERT_THROW(x64Device.getStreamFromPool(), std::runtime_error);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
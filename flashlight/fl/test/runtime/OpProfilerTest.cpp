@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "flashlight/fl/runtime/OpProfiler.h"
+#include "flashlight/fl/tensor/Init.h"
+
+using fl::OpProfileRange;
+using fl::OpProfiler;
+
+namespace {
+
+const OpProfiler::OpStats* findStats(
+    const std::vector<OpProfiler::OpStats>& stats,
+    const std::string& name,
+    const std::string& shape = "") {
+  for (const auto& opStats : stats) {
+    if (opStats.name == name && opStats.shape == shape) {
+      return &opStats;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace
+
+TEST(OpProfilerTest, disabled) {
+  auto& profiler = OpProfiler::getInstance();
+  profiler.disable();
+  profiler.clear();
+  {
+    OpProfileRange range("ignored");
+    ASSERT_FALSE(profiler.currentRange().has_value());
+  }
+  ASSERT_TRUE(profiler.getStats().empty());
+}
+
+TEST(OpProfilerTest, nestedRanges) {
+  auto& profiler = OpProfiler::getInstance();
+  profiler.enable();
+  for (int i = 0; i < 3; ++i) {
+    OpProfileRange outer("outer");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    for (int j = 0; j < 2; ++j) {
+      OpProfileRange inner("inner", "(2, 3)");
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
+  profiler.disable();
+
+  const auto stats = profiler.getStats();
+  ASSERT_EQ(stats.size(), 2);
+  const auto* outer = findStats(stats, "outer");
+  const auto* inner = findStats(stats, "inner", "(2, 3)");
+  ASSERT_NE(outer, nullptr);
+  ASSERT_NE(inner, nullptr);
+  ASSERT_EQ(outer->calls, 3);
+  ASSERT_EQ(inner->calls, 6);
+  ASSERT_EQ(inner->durations.numValues, 6);
+  ASSERT_DOUBLE_EQ(inner->selfSeconds, inner->totalSeconds);
+  ASSERT_GE(outer->totalSeconds, inner->totalSeconds);
+  ASSERT_NEAR(
+      outer->selfSeconds, outer->totalSeconds - inner->totalSeconds, 1e-9);
+  // the inner ranges sleep longer than the outer ones outside of them
+  ASSERT_EQ(&stats.front(), inner);
+}
+
+TEST(OpProfilerTest, shapes) {
+  auto& profiler = OpProfiler::getInstance();
+  profiler.enable();
+  {
+    OpProfileRange range("op", "(1)");
+  }
+  {
+    OpProfileRange range("op", "(2)");
+  }
+  {
+    OpProfileRange range("op", "(2)");
+  }
+  profiler.disable();
+
+  const auto stats = profiler.getStats();
+  ASSERT_EQ(stats.size(), 2);
+  ASSERT_EQ(findStats(stats, "op", "(1)")->calls, 1);
+  ASSERT_EQ(findStats(stats, "op", "(2)")->calls, 2);
+}
+
+TEST(OpProfilerTest, currentRange) {
+  auto& profiler = OpProfiler::getInstance();
+  profiler.enable();
+  ASSERT_FALSE(profiler.currentRange().has_value());
+  {
+    OpProfileRange outer("outer", "(4)");
+    {
+      OpProfileRange inner("inner");
+      ASSERT_EQ(profiler.currentRange()->first, "inner");
+    }
+    const auto current = profiler.currentRange();
+    ASSERT_TRUE(current.has_value());
+    ASSERT_EQ(current->first, "outer");
+    ASSERT_EQ(current->second, "(4)");
+  }
+  ASSERT_FALSE(profiler.currentRange().has_value());
+  profiler.disable();
+}
+
+TEST(OpProfilerTest, clearOpenRanges) {
+  auto& profiler = OpProfiler::getInstance();
+  profiler.enable();
+  {
+    OpProfileRange dropped("dropped");
+    profiler.clear();
+    ASSERT_FALSE(profiler.currentRange().has_value());
+    OpProfileRange kept("kept");
+  }
+  profiler.disable();
+
+  const auto stats = profiler.getStats();
+  ASSERT_EQ(stats.size(), 1);
+  ASSERT_EQ(stats.front().name, "kept");
+  ASSERT_EQ(stats.front().calls, 1);
+}
+
+TEST(OpProfilerTest, flatProfile) {
+  std::ostringstream profile;
+  {
+    fl::ScopedOpProfile scope(profile);
+    OpProfileRange outer("matmul", "(64, 128)");
+    OpProfileRange inner("add");
+  }
+  ASSERT_FALSE(OpProfiler::getInstance().isEnabled());
+  const auto text = profile.str();
+  ASSERT_NE(text.find("%self"), std::string::npos);
+  ASSERT_NE(text.find("matmul (64, 128)"), std::string::npos);
+  ASSERT_NE(text.find("add"), std::string::npos);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
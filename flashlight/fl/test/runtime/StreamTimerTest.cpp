@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "flashlight/fl/meter/TimeMeter.h"
+#include "flashlight/fl/runtime/StreamTimer.h"
+#include "flashlight/fl/runtime/SynchronousStream.h"
+#include "flashlight/fl/tensor/Init.h"
+
+using fl::StreamTimer;
+using fl::TimeMeter;
+
+namespace {
+
+class TestStream : public fl::SynchronousStream {
+ public:
+  void sync() const override {}
+};
+
+void sleepMs(int ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+} // namespace
+
+TEST(StreamTimerTest, intervals) {
+  TestStream stream;
+  StreamTimer timer(stream);
+  ASSERT_FALSE(timer.isRunning());
+  ASSERT_EQ(timer.elapsedSeconds(), 0);
+  ASSERT_EQ(&timer.stream(), &stream);
+
+  for (int i = 0; i < 3; ++i) {
+    timer.start();
+    ASSERT_TRUE(timer.isRunning());
+    sleepMs(5);
+    timer.stop();
+    ASSERT_FALSE(timer.isRunning());
+    // not timed
+    sleepMs(5);
+  }
+  const double seconds = timer.elapsedSeconds();
+  ASSERT_GE(seconds, 0.015);
+  ASSERT_LT(seconds, 0.03);
+  // stopped timers don't advance
+  sleepMs(5);
+  ASSERT_EQ(timer.elapsedSeconds(), seconds);
+
+  // the running interval is included
+  timer.start();
+  timer.start(); // ignored
+  sleepMs(5);
+  ASSERT_GE(timer.elapsedSeconds(), seconds + 0.005);
+  ASSERT_TRUE(timer.isRunning());
+
+  timer.reset();
+  ASSERT_FALSE(timer.isRunning());
+  ASSERT_EQ(timer.elapsedSeconds(), 0);
+  timer.stop(); // ignored
+  ASSERT_EQ(timer.elapsedSeconds(), 0);
+}
+
+TEST(StreamTimerTest, timeMeter) {
+  TestStream stream;
+  TimeMeter meter;
+  meter.setStream(&stream);
+  meter.resume();
+  sleepMs(5);
+  meter.stop();
+  sleepMs(5);
+  const double seconds = meter.value();
+  ASSERT_GE(seconds, 0.005);
+  ASSERT_LT(seconds, 0.01);
+
+  meter.reset();
+  ASSERT_EQ(meter.value(), 0);
+  meter.set(1.5);
+  ASSERT_EQ(meter.value(), 1.5);
+
+  // back to the host clock
+  meter.setStream(nullptr);
+  meter.resume();
+  sleepMs(5);
+  ASSERT_GE(meter.value(), 0.005);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
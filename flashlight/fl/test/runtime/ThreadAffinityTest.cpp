@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/runtime/ThreadAffinity.h"
+#include "flashlight/fl/tensor/Init.h"
+
+using namespace fl;
+
+TEST(ThreadAffinityTest, setCallingThreadAffinity) {
+  // bind another thread to leave the test runner's threading untouched
+  std::thread([]() {
+    ASSERT_NO_THROW(setCallingThreadAffinity(ThreadAffinity{}));
+    ASSERT_TRUE(setCallingThreadAffinity(ThreadAffinityPolicy::None));
+#ifdef __linux__
+    ASSERT_NO_THROW(setCallingThreadAffinity(ThreadAffinity{{0}, -1}));
+#endif
+    ASSERT_THROW(
+        setCallingThreadAffinity(ThreadAffinity{{}, -2}),
+        std::invalid_argument);
+  }).join();
+}
+
+TEST(ThreadAffinityTest, getDeviceThreadAffinity) {
+  const auto affinity = getDeviceThreadAffinity();
+  ASSERT_EQ(affinity.numaNode, getDeviceNumaNode());
+  if (affinity.numaNode < 0) {
+    ASSERT_TRUE(affinity.cpus.empty());
+    return;
+  }
+  // a share of the cores of the node
+  const auto nodeCpus = getNumaNodeCpus(affinity.numaNode);
+  ASSERT_FALSE(affinity.cpus.empty());
+  for (const auto cpu : affinity.cpus) {
+    ASSERT_NE(std::find(nodeCpus.begin(), nodeCpus.end(), cpu), nodeCpus.end());
+  }
+  std::thread([]() {
+    ASSERT_TRUE(setCallingThreadAffinity(ThreadAffinityPolicy::DeviceNumaNode));
+  }).join();
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
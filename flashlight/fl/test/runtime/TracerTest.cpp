@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "flashlight/fl/runtime/SynchronousStream.h"
+#include "flashlight/fl/runtime/Tracer.h"
+#include "flashlight/fl/tensor/Init.h"
+
+using fl::TraceRange;
+using fl::Tracer;
+
+namespace {
+
+class TestStream : public fl::SynchronousStream {
+ public:
+  void sync() const override {}
+};
+
+std::string writeTrace() {
+  std::ostringstream trace;
+  Tracer::getInstance().writeChromeTrace(trace);
+  return trace.str();
+}
+
+} // namespace
+
+TEST(TracerTest, disabled) {
+  auto& tracer = Tracer::getInstance();
+  tracer.disable();
+  tracer.clear();
+  {
+    TraceRange range("ignored");
+  }
+  ASSERT_EQ(writeTrace().find("ignored"), std::string::npos);
+}
+
+TEST(TracerTest, hostRanges) {
+  auto& tracer = Tracer::getInstance();
+  tracer.enable();
+  tracer.setThreadName("main \"thread\"");
+  {
+    TraceRange range("outer");
+    std::thread([]() {
+      Tracer::getInstance().setThreadName("worker");
+      TraceRange range("inner");
+    }).join();
+  }
+  tracer.disable();
+
+  const auto trace = writeTrace();
+  ASSERT_NE(trace.find("\"traceEvents\""), std::string::npos);
+  ASSERT_NE(trace.find("\"name\": \"outer\", \"ph\""), std::string::npos);
+  ASSERT_NE(trace.find("\"name\": \"inner\", \"ph\""), std::string::npos);
+  ASSERT_NE(trace.find("\"main \\\"thread\\\"\""), std::string::npos);
+  ASSERT_NE(trace.find("\"worker\""), std::string::npos);
+
+  tracer.clear();
+  ASSERT_EQ(writeTrace().find("outer"), std::string::npos);
+}
+
+TEST(TracerTest, deviceRanges) {
+  TestStream stream;
+  auto& tracer = Tracer::getInstance();
+  tracer.enable();
+  {
+    TraceRange range("copy", &stream);
+    char src = 'a';
+    char dst = 0;
+    stream.copyAsync(&dst, &src, sizeof(char));
+  }
+  tracer.disable();
+
+  const auto trace = writeTrace();
+  ASSERT_NE(trace.find("\"x64 0 stream 0\""), std::string::npos);
+  // recorded both on the host and the device
+  const std::string range = "\"name\": \"copy\", \"ph\": \"X\", \"pid\": ";
+  ASSERT_NE(trace.find(range + "0"), std::string::npos);
+  ASSERT_NE(trace.find(range + "1"), std::string::npos);
+  tracer.clear();
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
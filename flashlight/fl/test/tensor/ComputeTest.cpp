@@ -37,6 +37,26 @@ TEST(TensorComputeTest, eval) {
   fl::eval(t3);
 }
 
+TEST(TensorComputeTest, pinnedHost) {
+  // Pinned buffers should work as host buffers for transfers both ways
+  const fl::Shape shape({4, 5});
+  auto* in = static_cast<float*>(
+      fl::allocPinnedHost(shape.elements() * sizeof(float)));
+  for (unsigned i = 0; i < shape.elements(); ++i) {
+    in[i] = i;
+  }
+  auto t = fl::Tensor::fromBuffer(shape, in, fl::Location::Host);
+
+  auto* out = static_cast<float*>(
+      fl::allocPinnedHost(shape.elements() * sizeof(float)));
+  (t * 2).host(out);
+  for (unsigned i = 0; i < shape.elements(); ++i) {
+    ASSERT_EQ(out[i], 2 * in[i]);
+  }
+  fl::freePinnedHost(in);
+  fl::freePinnedHost(out);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
@@ -82,6 +82,35 @@ TEST(IndexTest, Shape) {
       Shape({5, 1, 7, 8}));
 }
 
+TEST(IndexTest, FixedArity) {
+  // indices on the stack index as a vector of them does
+  auto t = fl::rand({4, 5, 6});
+  auto idx = fl::arange({3}, 0, fl::dtype::s32);
+  const std::vector<std::vector<Index>> cases = {
+      {1},
+      {fl::span, 2},
+      {fl::range(1, 3), fl::span, -1},
+      {fl::range(0, fl::end, 2), 3, fl::range(1, 4)},
+      {idx, fl::span}};
+  for (const auto& indices : cases) {
+    Tensor fixed;
+    switch (indices.size()) {
+      case 1:
+        fixed = t(indices[0]);
+        break;
+      case 2:
+        fixed = t(indices[0], indices[1]);
+        break;
+      default:
+        fixed = t(indices[0], indices[1], indices[2]);
+        break;
+    }
+    auto expected = t(indices);
+    ASSERT_EQ(fixed.shape(), expected.shape());
+    ASSERT_TRUE(allClose(fixed, expected));
+  }
+}
+
 TEST(IndexTest, IndexAssignment) {
   auto t = fl::full({4, 4}, 0, fl::dtype::s32);
   t(fl::span, 0) = 1;
@@ -8,6 +8,7 @@
 #include <gtest/gtest.h>
 
 #include <stdexcept>
+#include <vector>
 
 #include "flashlight/fl/tensor/Init.h"
 #include "flashlight/fl/tensor/Shape.h"
@@ -32,6 +33,25 @@ TEST(ShapeTest, ManyDims) {
   ASSERT_EQ(many.dim(5), 6);
 }
 
+TEST(ShapeTest, InlineAndHeapDims) {
+  auto s = Shape({2, 3});
+  auto& dims = s.get();
+  for (Dim d = 4; d <= Shape::kInlineDims + 2; ++d) {
+    dims.push_back(d);
+  }
+  ASSERT_EQ(s.ndim(), Shape::kInlineDims + 1);
+  ASSERT_EQ(s.elements(), 40320);
+  auto copy = s;
+  ASSERT_EQ(copy, s);
+  dims.resize(2);
+  ASSERT_EQ(s, Shape({2, 3}));
+  ASSERT_EQ(copy.dim(Shape::kInlineDims), Shape::kInlineDims + 2);
+
+  std::vector<Dim> vec = copy.get();
+  ASSERT_EQ(Shape(vec), copy);
+  ASSERT_EQ(Shape(Shape::Dims(3, 2)), Shape({2, 2, 2}));
+}
+
 TEST(ShapeTest, ndim) {
   ASSERT_EQ(Shape().ndim(), 0);
   ASSERT_EQ(Shape({1, 0, 1}).ndim(), 3);
@@ -51,6 +71,7 @@ TEST(ShapeTest, elements) {
   ASSERT_EQ(Shape({1, 1, 1, 1}).elements(), 1);
   ASSERT_EQ(Shape({1, 2, 3, 4}).elements(), 24);
   ASSERT_EQ(Shape({1, 2, 3, 0}).elements(), 0);
+  ASSERT_EQ(Shape({1 << 20, 1 << 20}).elements(), 1LL << 40);
 }
 
 TEST(ShapeTest, Equality) {
@@ -70,6 +91,7 @@ TEST(ShapeTest, Indexing) {
   ASSERT_EQ(a[2], 5);
   ASSERT_EQ(a[3], 2);
   ASSERT_THROW(a[4], std::invalid_argument);
+  ASSERT_THROW(Shape({}).dim(0), std::invalid_argument);
 }
 
 TEST(ShapeTest, string) {
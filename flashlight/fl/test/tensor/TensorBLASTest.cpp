@@ -174,6 +174,35 @@ TEST(TensorBLASTest, matmulShapes) {
       Shape({256, 256, 2}));
 }
 
+TEST(TensorBLASTest, matmulBroadcast) {
+  using T = fl::MatrixProperty;
+  unsigned M = 5;
+  unsigned K = 6;
+  unsigned N = 7;
+  unsigned b2 = 2;
+  unsigned b3 = 3;
+  ASSERT_EQ(
+      fl::matmul(fl::rand({M, K, 1, b3}), fl::rand({K, N, b2, 1})).shape(),
+      Shape({M, N, b2, b3}));
+  ASSERT_EQ(
+      fl::matmul(
+          fl::rand({M, K, 1}), fl::rand({N, K, b2, b3}), T::None, T::Transpose)
+          .shape(),
+      Shape({M, N, b2, b3}));
+  ASSERT_THROW(
+      fl::matmul(fl::rand({M, K, b2}), fl::rand({K, N, b3})), std::exception);
+
+  // Broadcasting is equivalent to tiling
+  auto a = fl::rand({M, K, 1, b3});
+  auto b = fl::rand({K, N, b2, 1});
+  ASSERT_TRUE(allClose(
+      fl::matmul(a, b),
+      fl::matmul(fl::tile(a, {1, 1, b2}), fl::tile(b, {1, 1, 1, b3}))));
+  ASSERT_TRUE(allClose(
+      fl::matmul(fl::transpose(a, {1, 0, 2, 3}), b, T::Transpose),
+      fl::matmul(a, b)));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
@@ -25,6 +25,24 @@ TEST(TensorBaseTest, DefaultBackend) {
   ASSERT_EQ(t.backendType(), DefaultTensorType_t::tensorBackendType);
 }
 
+TEST(TensorBaseTest, CachedBackends) {
+  auto& backend = defaultTensorBackend();
+  ASSERT_EQ(&backend, &defaultTensorBackend());
+  ASSERT_EQ(backend.backendType(), DefaultTensorType_t::tensorBackendType);
+
+  auto x = fl::full({2, 2}, 1);
+  ASSERT_EQ(&x.backend(), &backend);
+  // the cached backend follows the adapter
+  auto y = std::move(x);
+  ASSERT_EQ(&y.backend(), &backend);
+  x = y;
+  ASSERT_EQ(&x.backend(), &backend);
+  Tensor z;
+  z = std::move(y);
+  ASSERT_EQ(&z.backend(), &backend);
+  ASSERT_EQ(&Tensor(z).backend(), &backend);
+}
+
 TEST(TensorBaseTest, DefaultConstruction) {
   Tensor t;
   ASSERT_EQ(t.shape(), Shape({0}));
@@ -401,6 +419,20 @@ TEST(TensorBaseTest, astype) {
   ASSERT_EQ(a.astype(dtype::f64).type(), dtype::f64);
 }
 
+TEST(TensorBaseTest, astypeBF16) {
+  ASSERT_EQ(fl::getTypeSize(dtype::bf16), 2);
+  ASSERT_EQ(fl::stringToDtype(fl::dtypeToString(dtype::bf16)), dtype::bf16);
+  ASSERT_TRUE(fl::isHalfPrecisionType(dtype::bf16));
+  ASSERT_FALSE(fl::isHalfPrecisionType(dtype::f32));
+  if (!defaultTensorBackend().isDataTypeSupported(dtype::bf16)) {
+    GTEST_SKIP() << "bfloat16 not supported by the default backend";
+  }
+  auto a = fl::full({3, 3}, 1.5);
+  auto b = a.astype(dtype::bf16);
+  ASSERT_EQ(b.type(), dtype::bf16);
+  ASSERT_TRUE(allClose(b.astype(dtype::f32), a));
+}
+
 TEST(TensorBaseTest, where) {
   auto a = Tensor::fromVector<int>({2, 5}, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
   auto out = fl::where(a < 5, a, a * 10);
@@ -570,6 +602,25 @@ TEST(TensorBaseTest, asContiguousTensor) {
   ASSERT_EQ(contiguous.strides(), Shape(strides));
 }
 
+TEST(TensorBaseTest, DLPack) {
+  auto t = fl::rand({3, 4, 5});
+  auto imported = fl::fromDLPack(t.toDLPack());
+  ASSERT_EQ(imported.shape(), t.shape());
+  ASSERT_EQ(imported.type(), t.type());
+  ASSERT_TRUE(allClose(imported, t));
+
+  // non-contiguous tensors are exported as contiguous copies
+  auto indexed = t(fl::range(0, 3, 2), fl::span, fl::range(1, 3));
+  auto importedIndexed = fl::fromDLPack(indexed.toDLPack());
+  ASSERT_EQ(importedIndexed.shape(), indexed.shape());
+  ASSERT_TRUE(allClose(importedIndexed, indexed));
+
+  auto integers = fl::full({2, 2}, 3, fl::dtype::s32);
+  ASSERT_TRUE(allClose(fl::fromDLPack(integers.toDLPack()), integers));
+
+  ASSERT_THROW(fl::fromDLPack(nullptr), std::invalid_argument);
+}
+
 TEST(TensorBaseTest, host) {
   auto a = fl::rand({10, 10});
 
@@ -632,6 +683,73 @@ TEST(TensorBaseTest, iota) {
   ASSERT_EQ(fl::iota({1, 10}, {5}).shape(), Shape({5, 10}));
 }
 
+TEST(TensorBaseTest, philox) {
+  // known-answer vectors of Philox4x32-10 from Random123
+  auto counter = [](std::array<uint64_t, 4> words) {
+    std::array<Tensor, 4> out;
+    for (int i = 0; i < 4; ++i) {
+      out[i] = fl::full({2}, words[i], fl::dtype::u64);
+    }
+    return out;
+  };
+  auto check = [](const std::array<Tensor, 4>& out,
+                  std::array<uint64_t, 4> expected) {
+    for (int i = 0; i < 4; ++i) {
+      ASSERT_TRUE(
+          fl::all(out[i] == fl::full({2}, expected[i], fl::dtype::u64))
+              .asScalar<bool>());
+    }
+  };
+  check(
+      fl::detail::philox4x32(counter({0, 0, 0, 0}), 0, 0),
+      {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+  check(
+      fl::detail::philox4x32(
+          counter({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}),
+          0xffffffff,
+          0xffffffff),
+      {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+  check(
+      fl::detail::philox4x32(
+          counter({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}),
+          0xa4093822,
+          0x299f31d0),
+      {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+}
+
+TEST(TensorBaseTest, randWithState) {
+  fl::RandomState a(1234);
+  fl::RandomState b(1234);
+  auto x = fl::rand({100, 10}, a);
+  ASSERT_TRUE(allClose(x, fl::rand({100, 10}, b)));
+  ASSERT_EQ(a.offset, b.offset);
+  ASSERT_GE(fl::amin(x).scalar<float>(), 0);
+  ASSERT_LT(fl::amax(x).scalar<float>(), 1);
+
+  // draws split across calls are the same as a single draw
+  fl::RandomState c(1234);
+  auto first = fl::rand({600}, c);
+  auto second = fl::rand({400}, c);
+  ASSERT_TRUE(allClose(
+      fl::reshape(x, {1000}),
+      fl::concatenate(0, first, second)));
+  ASSERT_EQ(c.offset, a.offset);
+
+  fl::RandomState d(4321);
+  ASSERT_FALSE(allClose(x, fl::rand({100, 10}, d)));
+  ASSERT_EQ(fl::rand({5}, d, fl::dtype::f64).type(), fl::dtype::f64);
+  ASSERT_THROW(fl::rand({5}, d, fl::dtype::s32), std::invalid_argument);
+}
+
+TEST(TensorBaseTest, randnWithState) {
+  fl::RandomState a(42);
+  fl::RandomState b(42);
+  auto x = fl::randn({10000}, a);
+  ASSERT_TRUE(allClose(x, fl::randn({10000}, b)));
+  ASSERT_NEAR(fl::mean(x).scalar<float>(), 0, 0.05);
+  ASSERT_NEAR(fl::std(x).scalar<float>(), 1, 0.05);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
@@ -7,6 +7,8 @@
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include "flashlight/fl/runtime/DeviceManager.h"
 #include "flashlight/fl/tensor/Init.h"
 #include "flashlight/fl/tensor/backend/af/ArrayFireCPUStream.h"
@@ -49,6 +51,20 @@ TEST(ArrayFireCPUStreamTest, sync) {
   ASSERT_NO_THROW(as1->sync());
 }
 
+TEST(ArrayFireCPUStreamTest, copyAsync) {
+  const auto as1 = ArrayFireCPUStream::create();
+  const auto as2 = ArrayFireCPUStream::create();
+  const std::vector<int> src = {1, 2, 3, 4};
+  std::vector<int> dst(src.size());
+  as1->copyAsync(dst.data(), src.data(), src.size() * sizeof(int));
+  const auto event = as1->recordEvent();
+  ASSERT_EQ(event->type(), StreamType::Synchronous);
+  ASSERT_TRUE(event->isReady());
+  ASSERT_NO_THROW(event->sync());
+  ASSERT_NO_THROW(as2->relativeSync(*event));
+  ASSERT_EQ(src, dst);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
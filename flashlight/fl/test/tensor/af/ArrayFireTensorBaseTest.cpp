@@ -443,6 +443,36 @@ TEST(ArrayFireTensorBaseTest, emptyRangeIndexing) {
   ASSERT_THROW(t(fl::range(0, -5)).shape(), std::exception);
 }
 
+TEST(ArrayFireTensorBaseTest, stridedViewIndexing) {
+  auto a = fl::rand({8, 6, 4});
+  const af::array& arr = toArray(a);
+  auto window = a(fl::range(2, 6), fl::span, 1); // windows of batch 1
+  auto frame = window(fl::span, 3);
+  auto strided = a(fl::range(0, 8, 2), 2, fl::range(1, 3));
+  ASSERT_EQ(window.shape(), Shape({4, 6}));
+  ASSERT_EQ(frame.shape(), Shape({4}));
+  ASSERT_EQ(strided.shape(), Shape({4, 2}));
+  // Views share the memory of the indexed tensor
+  ASSERT_EQ(af::getRawPtr(toArray(window)), af::getRawPtr(arr));
+  ASSERT_EQ(af::getRawPtr(toArray(frame)), af::getRawPtr(arr));
+  ASSERT_FALSE(window.isContiguous());
+  ASSERT_TRUE(window.asContiguousTensor().isContiguous());
+
+  ASSERT_TRUE(allClose(
+      toArray(window),
+      af::moddims(arr(af::seq(2, 5), af::span, 1), {4, 6})));
+  ASSERT_TRUE(allClose(toArray(frame), arr(af::seq(2, 5), 3, 1)));
+  ASSERT_TRUE(allClose(
+      toArray(strided),
+      af::moddims(arr(af::seq(0, 7, 2), 2, af::seq(1, 2)), {4, 2})));
+
+  // Views of tensors or views that were written to hold their own data
+  auto expected = toArray(frame).copy() + 1;
+  window += 1;
+  ASSERT_TRUE(allClose(toArray(window(fl::span, 3)), expected));
+  ASSERT_TRUE(allClose(toArray(frame), expected - 1));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
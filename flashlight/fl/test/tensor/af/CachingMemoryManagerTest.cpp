@@ -5,8 +5,10 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <cstdlib>
 #include <memory>
 #include <random>
+#include <sstream>
 #include <vector>
 
 #include <af/device.h>
@@ -194,6 +196,208 @@ TEST_F(CachingMemoryManagerTest, RecLimit) {
   testFragmentation(deviceInterface_, adapter_, false); // should not OOM
 }
 
+TEST_F(CachingMemoryManagerTest, StreamAwareReuse) {
+  // Checks that cached blocks are reused freely on the stream they were freed
+  // on, and only after an event completes on other streams. Uses a standalone
+  // manager with host memory and fake streams/events.
+  int streamA = 0;
+  int streamB = 0;
+  int event = 0;
+  void* activeStream = &streamA;
+  void* recordedStream = nullptr;
+  bool eventCompleted = false;
+  auto itf = std::make_shared<fl::MemoryManagerDeviceInterface>();
+  itf->getActiveDeviceId = []() { return 0; };
+  itf->getMaxMemorySize = [](int) { return size_t(1) << 30; };
+  itf->nativeAlloc = [](size_t bytes) { return std::malloc(bytes); };
+  itf->nativeFree = [](void* ptr) { std::free(ptr); };
+  itf->getActiveStream = [&]() { return activeStream; };
+  itf->createEvent = [&]() { return static_cast<void*>(&event); };
+  itf->destroyEvent = [](void*) {};
+  itf->recordEvent = [&](void*, void* stream) {
+    recordedStream = stream;
+    eventCompleted = false;
+  };
+  itf->queryEvent = [&](void*) { return eventCompleted; };
+  itf->syncEvent = [&](void*) { eventCompleted = true; };
+  fl::CachingMemoryManager manager(1, itf);
+
+  dim_t dims[] = {10 << 20}; // not split
+  void* a = manager.alloc(false, 1, dims, 1);
+  manager.unlock(a, false);
+  ASSERT_EQ(manager.alloc(false, 1, dims, 1), a); // same stream
+  manager.unlock(a, false);
+
+  // work on stream A may still use `a`
+  activeStream = &streamB;
+  void* b = manager.alloc(false, 1, dims, 1);
+  ASSERT_NE(b, a);
+  ASSERT_EQ(recordedStream, &streamA);
+
+  // once the work on stream A completes, `a` is safe to reuse anywhere
+  eventCompleted = true;
+  ASSERT_EQ(manager.alloc(false, 1, dims, 1), a);
+  manager.unlock(a, false);
+  manager.unlock(b, false);
+  manager.signalMemoryCleanup();
+}
+
+TEST_F(CachingMemoryManagerTest, ExpandableSegments) {
+  // Checks that large blocks are carved out of a single address range which
+  // grows in place. Uses a standalone manager with host memory standing in
+  // for the reserved range.
+  constexpr size_t kMB = 1 << 20;
+  constexpr size_t kGranularity = 2 * kMB;
+  std::vector<char> range;
+  size_t mappedBytes = 0;
+  auto itf = std::make_shared<fl::MemoryManagerDeviceInterface>();
+  itf->getActiveDeviceId = []() { return 0; };
+  itf->getMaxMemorySize = [](int) { return 64 * kMB; };
+  itf->nativeAlloc = [](size_t bytes) { return std::malloc(bytes); };
+  itf->nativeFree = [](void* ptr) { std::free(ptr); };
+  itf->getMemoryGranularity = [&]() { return kGranularity; };
+  itf->reserveAddressRange = [&](size_t size) {
+    range.resize(size);
+    return static_cast<void*>(range.data());
+  };
+  itf->freeAddressRange = [&](void*, size_t) { range.clear(); };
+  itf->mapMemory = [&](void* ptr, size_t size) {
+    ASSERT_EQ(static_cast<char*>(ptr), range.data() + mappedBytes);
+    ASSERT_EQ(size % kGranularity, 0);
+    mappedBytes += size;
+  };
+  itf->unmapMemory = [&](void* ptr, size_t size) {
+    ASSERT_EQ(static_cast<char*>(ptr) + size, range.data() + mappedBytes);
+    mappedBytes -= size;
+  };
+  fl::CachingMemoryManager manager(1, itf);
+  manager.setExpandableSegments(true);
+
+  dim_t dims[] = {12 * kMB};
+  void* a = manager.alloc(false, 1, dims, 1);
+  void* b = manager.alloc(false, 1, dims, 1);
+  ASSERT_EQ(static_cast<char*>(a), range.data());
+  ASSERT_EQ(static_cast<char*>(b), range.data() + 12 * kMB);
+  ASSERT_EQ(mappedBytes, 24 * kMB);
+
+  // the free end of the segment grows instead of needing a new 30 MiB buffer
+  manager.unlock(a, false);
+  manager.unlock(b, false);
+  dims[0] = 30 * kMB;
+  ASSERT_EQ(manager.alloc(false, 1, dims, 1), a);
+  ASSERT_EQ(mappedBytes, 30 * kMB);
+
+  manager.unlock(a, false);
+  manager.signalMemoryCleanup();
+  ASSERT_EQ(mappedBytes, 0);
+}
+
+TEST_F(CachingMemoryManagerTest, HistoryAndSnapshot) {
+  // Checks the event ring buffer and the JSON snapshot of a standalone
+  // manager using host memory.
+  auto itf = std::make_shared<fl::MemoryManagerDeviceInterface>();
+  itf->getActiveDeviceId = []() { return 0; };
+  itf->getMaxMemorySize = [](int) { return size_t(1) << 30; };
+  itf->nativeAlloc = [](size_t bytes) { return std::malloc(bytes); };
+  itf->nativeFree = [](void* ptr) { std::free(ptr); };
+  fl::CachingMemoryManager manager(1, itf);
+  manager.recordHistory(3, []() { return std::string("step\"1"); });
+
+  dim_t dims[] = {1024};
+  void* a = manager.alloc(false, 1, dims, 4);
+  void* b = manager.alloc(false, 1, dims, 4);
+  manager.unlock(a, false);
+
+  // only the 3 most recent events are kept
+  using Action = fl::CachingMemoryManager::TraceEvent::Action;
+  const auto history = manager.getHistory();
+  ASSERT_EQ(history.size(), 3);
+  ASSERT_EQ(history[0].action_, Action::Alloc);
+  ASSERT_EQ(history[0].ptr_, a);
+  ASSERT_EQ(history[1].action_, Action::Alloc);
+  ASSERT_EQ(history[1].ptr_, b);
+  ASSERT_EQ(history[2].action_, Action::Free);
+  ASSERT_EQ(history[2].size_, 4096);
+  ASSERT_EQ(history[2].tag_, "step\"1");
+
+  std::ostringstream snapshot;
+  manager.printSnapshot(&snapshot);
+  const auto json = snapshot.str();
+  // a single 2 MiB buffer split into a free, an allocated and a free block
+  ASSERT_NE(json.find("\"size\": 2097152"), std::string::npos);
+  ASSERT_NE(json.find("\"state\": \"allocated\""), std::string::npos);
+  ASSERT_NE(json.find("\"tag\": \"step\\\"1\""), std::string::npos);
+
+  manager.unlock(b, false);
+  manager.signalMemoryCleanup();
+}
+
+TEST_F(CachingMemoryManagerTest, PrivatePools) {
+  // Checks that blocks of a private pool are only reused by allocations to
+  // that pool until it's released. Uses a standalone manager with host memory.
+  size_t nativeFrees = 0;
+  auto itf = std::make_shared<fl::MemoryManagerDeviceInterface>();
+  itf->getActiveDeviceId = []() { return 0; };
+  itf->getMaxMemorySize = [](int) { return size_t(1) << 30; };
+  itf->nativeAlloc = [](size_t bytes) { return std::malloc(bytes); };
+  itf->nativeFree = [&](void* ptr) {
+    ++nativeFrees;
+    std::free(ptr);
+  };
+  fl::CachingMemoryManager manager(1, itf);
+
+  dim_t dims[] = {1024};
+  manager.beginAllocateToPool(1);
+  ASSERT_THROW(manager.beginAllocateToPool(2), std::runtime_error);
+  void* a = manager.alloc(false, 1, dims, 4);
+  void* b = manager.alloc(false, 1, dims, 4);
+  manager.unlock(a, false);
+  ASSERT_EQ(manager.alloc(false, 1, dims, 4), a);
+  manager.unlock(a, false);
+  manager.endAllocateToPool();
+
+  // freed blocks of the pool are neither reused outside of it nor released
+  void* c = manager.alloc(false, 1, dims, 4);
+  ASSERT_NE(c, a);
+  manager.unlock(c, false);
+  manager.signalMemoryCleanup();
+  ASSERT_EQ(nativeFrees, 1);
+
+  // once released, the pool's blocks are regular ones, even those in use
+  manager.releasePool(1);
+  ASSERT_EQ(manager.alloc(false, 1, dims, 4), a);
+  manager.unlock(a, false);
+  manager.unlock(b, false);
+  manager.signalMemoryCleanup();
+  ASSERT_EQ(nativeFrees, 2);
+}
+
+TEST_F(CachingMemoryManagerTest, PeakAllocatedBytes) {
+  // Checks that the peak of the bytes held by the manager outlives the frees
+  // of its blocks until it's reset. Uses a standalone manager with host memory.
+  auto itf = std::make_shared<fl::MemoryManagerDeviceInterface>();
+  itf->getActiveDeviceId = []() { return 0; };
+  itf->getMaxMemorySize = [](int) { return size_t(1) << 30; };
+  itf->nativeAlloc = [](size_t bytes) { return std::malloc(bytes); };
+  itf->nativeFree = [](void* ptr) { std::free(ptr); };
+  fl::CachingMemoryManager manager(1, itf);
+  ASSERT_EQ(manager.getPeakAllocatedBytes(0), 0);
+
+  dim_t dims[] = {1 << 20};
+  void* a = manager.alloc(false, 1, dims, 4);
+  const size_t peak = manager.getPeakAllocatedBytes(0);
+  ASSERT_GE(peak, size_t(4) << 20);
+  manager.unlock(a, false);
+  manager.signalMemoryCleanup();
+  ASSERT_EQ(manager.getPeakAllocatedBytes(0), peak);
+
+  manager.resetPeakAllocatedBytes(0);
+  ASSERT_EQ(manager.getPeakAllocatedBytes(0), 0);
+  void* b = manager.alloc(false, 1, dims, 4);
+  ASSERT_EQ(manager.getPeakAllocatedBytes(0), peak);
+  manager.unlock(b, false);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
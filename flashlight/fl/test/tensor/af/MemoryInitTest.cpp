@@ -29,6 +29,9 @@ TEST(MemoryInitTest, DefaultManagerInitializesCorrectType) {
 
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
-  fl::init();
+  // the memory manager is otherwise installed on the first use of a tensor
+  fl::InitOptions options;
+  options.eager = true;
+  fl::init(options);
   return RUN_ALL_TESTS();
 }
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/tensor/DefaultTensorType.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Shape.h"
+#include "flashlight/fl/tensor/Types.h"
+#include "flashlight/fl/tensor/backend/jit/Utils.h"
+#include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/CustomNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ValueNode.h"
+#include "flashlight/fl/tensor/backend/jit/opt/passes/CommonSubexpressionElimination.h"
+
+using namespace fl;
+
+class JitCommonSubexpressionEliminationTest : public ::testing::Test {
+ protected:
+  TensorBackend& defaultBackend_ = DefaultTensorBackend_t::getInstance();
+  CommonSubexpressionElimination cse_;
+};
+
+TEST_F(JitCommonSubexpressionEliminationTest, identity) {
+  // v1  c2
+  //  \  /
+  //   add
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::s32;
+  const auto v1 = ValueNode::create(defaultBackend_.full(shape, 1, dtype));
+  const auto c2 = ScalarNode::create(shape, dtype, 2);
+  const auto add = BinaryNode::create(v1, c2, BinaryOp::Add);
+  // nothing changed
+  ASSERT_EQ(add, cse_.apply(add));
+  ASSERT_EQ(add->inputs(), NodeList({v1, c2}));
+  ASSERT_EQ(add->uses(), UseValList({}));
+  ASSERT_EQ(v1->uses(), UseValList({{add, 0}}));
+  ASSERT_EQ(v1->getRefCount(), 1);
+  ASSERT_EQ(c2->uses(), UseValList({{add, 1}}));
+  ASSERT_EQ(c2->getRefCount(), 1);
+  // root node is owned locally (didn't transition to shared ownership)
+  delete add;
+}
+
+TEST_F(JitCommonSubexpressionEliminationTest, duplicateScalars) {
+  // c1  c1'
+  //  \  /
+  //   add
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::s32;
+  const auto c1 = ScalarNode::create(shape, dtype, 1);
+  const auto c1Dup = ScalarNode::create(shape, dtype, 1);
+  const auto add = BinaryNode::create(c1, c1Dup, BinaryOp::Add);
+  // c1' is deleted since its only user now uses c1
+  //   c1
+  //  /  \
+  //  \  /
+  //   add
+  ASSERT_EQ(add, cse_.apply(add));
+  ASSERT_EQ(add->inputs(), NodeList({c1, c1}));
+  ASSERT_EQ(c1->uses(), UseValList({{add, 0}, {add, 1}}));
+  ASSERT_EQ(c1->getRefCount(), 2);
+  // root node is owned locally (didn't transition to shared ownership)
+  delete add;
+}
+
+TEST_F(JitCommonSubexpressionEliminationTest, distinctScalars) {
+  // c1  c2  c1(f32)
+  //  \  /   /
+  //   add  /
+  //     \ /
+  //     sub
+  Shape shape(Shape({2, 2}));
+  const auto c1 = ScalarNode::create(shape, dtype::s32, 1);
+  const auto c2 = ScalarNode::create(shape, dtype::s32, 2);
+  const auto c1f = ScalarNode::create(shape, dtype::f32, 1);
+  const auto add = BinaryNode::create(c1, c2, BinaryOp::Add);
+  const auto sub = BinaryNode::create(add, c1f, BinaryOp::Sub);
+  // nothing changed -- values or types differ
+  ASSERT_EQ(sub, cse_.apply(sub));
+  ASSERT_EQ(add->inputs(), NodeList({c1, c2}));
+  ASSERT_EQ(sub->inputs(), NodeList({add, c1f}));
+  ASSERT_EQ(c1->uses(), UseValList({{add, 0}}));
+  ASSERT_EQ(c2->uses(), UseValList({{add, 1}}));
+  ASSERT_EQ(c1f->uses(), UseValList({{sub, 1}}));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete sub;
+}
+
+TEST_F(JitCommonSubexpressionEliminationTest, duplicateBinaryNodes) {
+  //  v1  c2    v1  c2'
+  //   \  /      \  /
+  //   mul       mul'
+  //     \       /
+  //        add
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::s32;
+  const auto v1 = ValueNode::create(defaultBackend_.full(shape, 1, dtype));
+  const auto c2 = ScalarNode::create(shape, dtype, 2);
+  const auto c2Dup = ScalarNode::create(shape, dtype, 2);
+  const auto mul = BinaryNode::create(v1, c2, BinaryOp::Mul);
+  const auto mulDup = BinaryNode::create(v1, c2Dup, BinaryOp::Mul);
+  const auto add = BinaryNode::create(mul, mulDup, BinaryOp::Add);
+  //   v1  c2
+  //    \  /
+  //    mul
+  //   /   \
+  //   \   /
+  //    add
+  ASSERT_EQ(add, cse_.apply(add));
+  ASSERT_EQ(add->inputs(), NodeList({mul, mul}));
+  ASSERT_EQ(mul->inputs(), NodeList({v1, c2}));
+  ASSERT_EQ(mul->uses(), UseValList({{add, 0}, {add, 1}}));
+  ASSERT_EQ(mul->getRefCount(), 2);
+  ASSERT_EQ(v1->uses(), UseValList({{mul, 0}}));
+  ASSERT_EQ(v1->getRefCount(), 1);
+  ASSERT_EQ(c2->uses(), UseValList({{mul, 1}}));
+  ASSERT_EQ(c2->getRefCount(), 1);
+  // root node is owned locally (didn't transition to shared ownership)
+  delete add;
+}
+
+TEST_F(JitCommonSubexpressionEliminationTest, differentOps) {
+  //  v1  c2
+  //  | \/ |
+  //  | /\ |
+  //  add  sub
+  //    \  /
+  //    mul
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::s32;
+  const auto v1 = ValueNode::create(defaultBackend_.full(shape, 1, dtype));
+  const auto c2 = ScalarNode::create(shape, dtype, 2);
+  const auto add = BinaryNode::create(v1, c2, BinaryOp::Add);
+  const auto sub = BinaryNode::create(v1, c2, BinaryOp::Sub);
+  const auto mul = BinaryNode::create(add, sub, BinaryOp::Mul);
+  // nothing changed
+  ASSERT_EQ(mul, cse_.apply(mul));
+  ASSERT_EQ(mul->inputs(), NodeList({add, sub}));
+  ASSERT_EQ(v1->uses(), UseValList({{add, 0}, {sub, 0}}));
+  ASSERT_EQ(c2->uses(), UseValList({{add, 1}, {sub, 1}}));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete mul;
+}
+
+TEST_F(JitCommonSubexpressionEliminationTest, externallyReferencedDuplicate) {
+  //  c1  c2  c1' c2'
+  //   \  /    \  /
+  //   add     add'  <-- also referenced externally (e.g., by a JitTensor)
+  //     \     /
+  //       mul
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::s32;
+  const auto c1 = ScalarNode::create(shape, dtype, 1);
+  const auto c2 = ScalarNode::create(shape, dtype, 2);
+  const auto c1Dup = ScalarNode::create(shape, dtype, 1);
+  const auto c2Dup = ScalarNode::create(shape, dtype, 2);
+  const auto add = BinaryNode::create(c1, c2, BinaryOp::Add);
+  const auto addDup = BinaryNode::create(c1Dup, c2Dup, BinaryOp::Add);
+  const auto mul = BinaryNode::create(add, addDup, BinaryOp::Mul);
+  addDup->incRefCount();
+  ASSERT_EQ(mul, cse_.apply(mul));
+  ASSERT_EQ(mul->inputs(), NodeList({add, add}));
+  ASSERT_EQ(add->uses(), UseValList({{mul, 0}, {mul, 1}}));
+  ASSERT_EQ(add->getRefCount(), 2);
+  // the duplicate is detached from the tree, but stays alive for other owners
+  ASSERT_EQ(addDup->uses(), UseValList({}));
+  ASSERT_EQ(addDup->getRefCount(), 1);
+  ASSERT_EQ(addDup->inputs(), NodeList({c1, c2}));
+  ASSERT_EQ(c1->uses(), UseValList({{add, 0}, {addDup, 0}}));
+  ASSERT_EQ(c2->uses(), UseValList({{add, 1}, {addDup, 1}}));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete mul;
+  addDup->decRefCount();
+}
+
+TEST_F(JitCommonSubexpressionEliminationTest, customNodesAreNotMerged) {
+  //   c1    c1
+  //   |     |
+  // custom custom'
+  //     \   /
+  //      add
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::s32;
+  const auto c1 = ScalarNode::create(shape, dtype, 1);
+  const auto identity = [](const std::vector<const Tensor*>& inputs) {
+    return *inputs[0];
+  };
+  const auto custom = CustomNode::create("identity", {c1}, shape, identity);
+  const auto customDup = CustomNode::create("identity", {c1}, shape, identity);
+  const auto add = BinaryNode::create(custom, customDup, BinaryOp::Add);
+  // nothing changed -- custom nodes have opaque semantics
+  ASSERT_EQ(add, cse_.apply(add));
+  ASSERT_EQ(add->inputs(), NodeList({custom, customDup}));
+  ASSERT_EQ(c1->uses(), UseValList({{custom, 0}, {customDup, 0}}));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete add;
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  init();
+  return RUN_ALL_TESTS();
+}
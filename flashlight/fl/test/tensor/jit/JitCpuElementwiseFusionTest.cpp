@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/tensor/DefaultTensorType.h"
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Random.h"
+#include "flashlight/fl/tensor/Shape.h"
+#include "flashlight/fl/tensor/Types.h"
+#include "flashlight/fl/tensor/backend/jit/Utils.h"
+#include "flashlight/fl/tensor/backend/jit/eval/Evaluator.h"
+#include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/CustomNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/IndexNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ValueNode.h"
+#include "flashlight/fl/tensor/backend/jit/opt/backends/cpu/CpuElementwiseFusion.h"
+#include "flashlight/fl/tensor/backend/jit/opt/backends/cpu/ElementwiseKernel.h"
+
+using namespace fl;
+
+class JitCpuElementwiseFusionTest : public ::testing::Test {
+ protected:
+  TensorBackend& defaultBackend_ = DefaultTensorBackend_t::getInstance();
+  CpuElementwiseFusion fuser_{defaultBackend_};
+  Evaluator evaluator_{defaultBackend_};
+};
+
+TEST_F(JitCpuElementwiseFusionTest, singleBinaryNodeOfValues) {
+  // v1  v2
+  //  \  /
+  //   add
+  Shape shape(Shape({2, 2}));
+  const auto v1 = ValueNode::create(fl::rand(shape, dtype::f32));
+  const auto v2 = ValueNode::create(fl::rand(shape, dtype::f32));
+  const auto add = BinaryNode::create(v1, v2, BinaryOp::Add);
+  // nothing changes -- fusion wouldn't save any memory traffic
+  ASSERT_EQ(add, fuser_.apply(add));
+  ASSERT_EQ(add->inputs(), NodeList({v1, v2}));
+  ASSERT_EQ(v1->uses(), UseValList({{add, 0}}));
+  ASSERT_EQ(v2->uses(), UseValList({{add, 1}}));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete add;
+}
+
+TEST_F(JitCpuElementwiseFusionTest, scalarOnlyBinaryNode) {
+  // c1  c2
+  //  \  /
+  //   add
+  Shape shape(Shape({2, 2}));
+  const auto c1 = ScalarNode::create(shape, dtype::f32, 1);
+  const auto c2 = ScalarNode::create(shape, dtype::f32, 2);
+  const auto add = BinaryNode::create(c1, c2, BinaryOp::Add);
+  // nothing changes -- left to ScalarFolding
+  ASSERT_EQ(add, fuser_.apply(add));
+  ASSERT_EQ(add->inputs(), NodeList({c1, c2}));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete add;
+}
+
+TEST_F(JitCpuElementwiseFusionTest, fuseChain) {
+  // v1  c2
+  //  \  /
+  //   mul  v3
+  //    \  /
+  //     add
+  Shape shape(Shape({3, 4}));
+  const auto t1 = fl::rand(shape, dtype::f32);
+  const auto t3 = fl::rand(shape, dtype::f32);
+  const auto v1 = ValueNode::create(t1.copy());
+  const auto c2 = ScalarNode::create(shape, dtype::f32, 2);
+  const auto v3 = ValueNode::create(t3.copy());
+  const auto mul = BinaryNode::create(v1, c2, BinaryOp::Mul);
+  const auto add = BinaryNode::create(mul, v3, BinaryOp::Add);
+  // v1  v3
+  //  \  /
+  // fused
+  const auto fused = fuser_.apply(add);
+  ASSERT_NE(fused, add);
+  ASSERT_TRUE(fused->isCustom());
+  ASSERT_EQ(fused->inputs(), NodeList({v1, v3}));
+  ASSERT_EQ(fused->shape(), shape);
+  ASSERT_EQ(v1->uses(), UseValList({{mul, 0}, {fused, 0}}));
+  ASSERT_EQ(v3->uses(), UseValList({{add, 1}, {fused, 1}}));
+  // root nodes are owned locally (didn't transition to shared ownership)
+  delete add;
+  ASSERT_EQ(v1->uses(), UseValList({{fused, 0}}));
+  ASSERT_EQ(v3->uses(), UseValList({{fused, 1}}));
+  evaluator_.eval(fused);
+  ASSERT_TRUE(allClose(fused->getResult().value(), t1 * 2 + t3));
+  delete fused;
+}
+
+TEST_F(JitCpuElementwiseFusionTest, sharedIntermediateNode) {
+  //   v1  c2
+  //    \  /
+  //    mul
+  //   /   \
+  //   \   /
+  //    add
+  Shape shape(Shape({3, 4}));
+  const auto t1 = fl::rand(shape, dtype::f32);
+  const auto v1 = ValueNode::create(t1.copy());
+  const auto c2 = ScalarNode::create(shape, dtype::f32, 2);
+  const auto mul = BinaryNode::create(v1, c2, BinaryOp::Mul);
+  const auto add = BinaryNode::create(mul, mul, BinaryOp::Add);
+  //    v1
+  //    |
+  //  fused
+  //   / \
+  //   \ /
+  //   add
+  ASSERT_EQ(add, fuser_.apply(add));
+  const auto fused = add->inputs().at(0);
+  ASSERT_TRUE(fused->isCustom());
+  ASSERT_EQ(add->inputs(), NodeList({fused, fused}));
+  ASSERT_EQ(fused->inputs(), NodeList({v1}));
+  ASSERT_EQ(fused->getRefCount(), 2);
+  ASSERT_EQ(v1->uses(), UseValList({{fused, 0}}));
+  evaluator_.eval(add);
+  ASSERT_TRUE(allClose(add->getResult().value(), t1 * 2 + t1 * 2));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete add;
+}
+
+TEST_F(JitCpuElementwiseFusionTest, nonFusableRoot) {
+  // v1  c2
+  //  \  /
+  //   sub  c3
+  //    \  /
+  //    div
+  //     |
+  //   custom
+  Shape shape(Shape({3, 4}));
+  const auto t1 = fl::rand(shape, dtype::f64);
+  const auto v1 = ValueNode::create(t1.copy());
+  const auto c2 = ScalarNode::create(shape, dtype::f64, 2);
+  const auto c3 = ScalarNode::create(shape, dtype::f64, 3);
+  const auto sub = BinaryNode::create(v1, c2, BinaryOp::Sub);
+  const auto div = BinaryNode::create(sub, c3, BinaryOp::Div);
+  const auto custom = CustomNode::create(
+      "identity", {div}, shape, [](const std::vector<const Tensor*>& inputs) {
+        return *inputs[0];
+      });
+  ASSERT_EQ(custom, fuser_.apply(custom));
+  const auto fused = custom->inputs().at(0);
+  ASSERT_TRUE(fused->isCustom());
+  ASSERT_EQ(fused->inputs(), NodeList({v1}));
+  ASSERT_EQ(fused->uses(), UseValList({{custom, 0}}));
+  ASSERT_EQ(v1->uses(), UseValList({{fused, 0}}));
+  evaluator_.eval(custom);
+  ASSERT_TRUE(allClose(custom->getResult().value(), (t1 - 2) / 3));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete custom;
+}
+
+TEST_F(JitCpuElementwiseFusionTest, integralTypes) {
+  // v1  c2
+  //  \  /
+  //   add  v1
+  //    \  /
+  //     mul
+  Shape shape(Shape({3, 4}));
+  const auto t1 = fl::full(shape, 3, dtype::s32);
+  const auto v1 = ValueNode::create(t1.copy());
+  const auto c2 = ScalarNode::create(shape, dtype::s32, 2);
+  const auto add = BinaryNode::create(v1, c2, BinaryOp::Add);
+  const auto mul = BinaryNode::create(add, v1, BinaryOp::Mul);
+  const auto fused = fuser_.apply(mul);
+  ASSERT_TRUE(fused->isCustom());
+  // shared input is only passed in once
+  ASSERT_EQ(fused->inputs(), NodeList({v1}));
+  // root nodes are owned locally (didn't transition to shared ownership)
+  delete mul;
+  // falls back to backend ops, but still yields correct result
+  evaluator_.eval(fused);
+  const auto& result = fused->getResult().value();
+  ASSERT_EQ(result.type(), dtype::s32);
+  ASSERT_TRUE(allClose(result, fl::full(shape, 15, dtype::s32)));
+  delete fused;
+}
+
+TEST_F(JitCpuElementwiseFusionTest, kernelIsCachedAcrossScalarValues) {
+  // v1  c
+  //  \  /
+  //   mul  v1
+  //    \  /
+  //     sub
+  Shape shape(Shape({3, 4}));
+  const auto t1 = fl::rand(shape, dtype::f32);
+  ElementwiseKernel::clearCache();
+  for (const float scalar : {2.f, 4.f}) {
+    const auto v1 = ValueNode::create(t1.copy());
+    const auto c = ScalarNode::create(shape, dtype::f32, scalar);
+    const auto mul = BinaryNode::create(v1, c, BinaryOp::Mul);
+    const auto sub = BinaryNode::create(mul, v1, BinaryOp::Sub);
+    const auto fused = fuser_.apply(sub);
+    ASSERT_TRUE(fused->isCustom());
+    // root nodes are owned locally (didn't transition to shared ownership)
+    delete sub;
+    ASSERT_EQ(ElementwiseKernel::numCachedKernels(), 1);
+    evaluator_.eval(fused);
+    ASSERT_TRUE(allClose(fused->getResult().value(), t1 * scalar - t1));
+    delete fused;
+  }
+}
+
+TEST_F(JitCpuElementwiseFusionTest, sliceIsReadInPlace) {
+  //    v1
+  //     |
+  //  index  v2
+  //     \  /
+  //      add
+  const auto t1 = fl::rand({4, 6}, dtype::f32);
+  const auto t2 = fl::rand({4, 4}, dtype::f32);
+  const auto v1 = ValueNode::create(t1.copy());
+  const auto v2 = ValueNode::create(t2.copy());
+  const auto index = IndexNode::create(v1, {fl::span, fl::range(1, 5)});
+  const auto add = BinaryNode::create(index, v2, BinaryOp::Add);
+  // v1  v2
+  //  \  /
+  // fused
+  const auto fused = fuser_.apply(add);
+  ASSERT_TRUE(fused->isCustom());
+  ASSERT_EQ(fused->inputs(), NodeList({v1, v2}));
+  ASSERT_EQ(fused->shape(), Shape({4, 4}));
+  // root nodes are owned locally (didn't transition to shared ownership)
+  delete add;
+  evaluator_.eval(fused);
+  ASSERT_TRUE(allClose(
+      fused->getResult().value(), t1(fl::span, fl::range(1, 5)) + t2));
+  delete fused;
+}
+
+TEST_F(JitCpuElementwiseFusionTest, stridedSlicesShareInput) {
+  //     v1
+  //    /  \
+  // index1 index2
+  //    \  /
+  //     mul
+  const auto t1 = fl::rand({4, 6}, dtype::f32);
+  const auto v1 = ValueNode::create(t1.copy());
+  const auto index1 = IndexNode::create(v1, {fl::range(0, 4, 2), 3});
+  const auto index2 = IndexNode::create(v1, {fl::range(1, 3), 5});
+  const auto mul = BinaryNode::create(index1, index2, BinaryOp::Mul);
+  const auto fused = fuser_.apply(mul);
+  ASSERT_TRUE(fused->isCustom());
+  // both views read the same input
+  ASSERT_EQ(fused->inputs(), NodeList({v1}));
+  // root nodes are owned locally (didn't transition to shared ownership)
+  delete mul;
+  evaluator_.eval(fused);
+  ASSERT_TRUE(allClose(
+      fused->getResult().value(),
+      t1(fl::range(0, 4, 2), 3) * t1(fl::range(1, 3), 5)));
+  delete fused;
+}
+
+TEST_F(JitCpuElementwiseFusionTest, kernelIsCachedAcrossSliceOffsets) {
+  const auto t1 = fl::rand({4, 8}, dtype::f32);
+  ElementwiseKernel::clearCache();
+  for (const Dim start : {0, 2, 4}) {
+    const auto v1 = ValueNode::create(t1.copy());
+    const auto c = ScalarNode::create({4, 4}, dtype::f32, 3);
+    const auto range = fl::range(start, start + 4);
+    const auto index = IndexNode::create(v1, {fl::span, range});
+    const auto mul = BinaryNode::create(index, c, BinaryOp::Mul);
+    const auto fused = fuser_.apply(mul);
+    ASSERT_TRUE(fused->isCustom());
+    // root nodes are owned locally (didn't transition to shared ownership)
+    delete mul;
+    ASSERT_EQ(ElementwiseKernel::numCachedKernels(), 1);
+    evaluator_.eval(fused);
+    ASSERT_TRUE(allClose(fused->getResult().value(), t1(fl::span, range) * 3));
+    delete fused;
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  init();
+  return RUN_ALL_TESTS();
+}
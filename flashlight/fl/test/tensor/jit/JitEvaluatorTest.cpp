@@ -14,6 +14,8 @@
 #include "flashlight/fl/tensor/Random.h"
 #include "flashlight/fl/tensor/Shape.h"
 #include "flashlight/fl/tensor/backend/jit/JitTensor.h"
+#include "flashlight/fl/tensor/backend/jit/Utils.h"
+#include "flashlight/fl/tensor/backend/jit/eval/EvalScheduler.h"
 #include "flashlight/fl/tensor/backend/jit/eval/Evaluator.h"
 #include "flashlight/fl/tensor/backend/jit/ir/ValueNode.h"
 
@@ -61,6 +63,34 @@ TEST_F(JitEvaluatorTest, evalBinaryNode) {
   delete add;
 }
 
+TEST_F(JitEvaluatorTest, evalUnaryNode) {
+  // c1
+  //  |
+  // exp
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::f32;
+  const auto c1 = ScalarNode::create(shape, dtype, 1);
+  const auto exp = UnaryNode::create(c1, UnaryOp::Exp);
+  evaluator_.eval(exp);
+  const auto expected = fl::exp(full(shape, 1, dtype));
+  ASSERT_TRUE(allClose(exp->getResult().value(), expected));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete exp;
+}
+
+TEST_F(JitEvaluatorTest, evalReductionNode) {
+  // v1
+  //  |
+  // sum
+  const auto tensor = fl::rand(Shape({2, 3}), dtype::f32);
+  const auto v1 = ValueNode::create(tensor.copy());
+  const auto sum = ReductionNode::create(v1, ReductionOp::Sum, {1}, false);
+  evaluator_.eval(sum);
+  ASSERT_TRUE(allClose(sum->getResult().value(), fl::sum(tensor, {1})));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete sum;
+}
+
 TEST_F(JitEvaluatorTest, evalCustomNode) {
   // c1  c2  c3
   //  \  |  /
@@ -85,6 +115,38 @@ TEST_F(JitEvaluatorTest, evalCustomNode) {
   delete custom;
 }
 
+TEST_F(JitEvaluatorTest, evalStats) {
+  // c1  c2
+  //  \  /
+  //   add  c3
+  //    \  /
+  //   custom
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::f32;
+  const auto c1 = ScalarNode::create(shape, dtype, 1);
+  const auto c2 = ScalarNode::create(shape, dtype, 2);
+  const auto c3 = ScalarNode::create(shape, dtype, 3);
+  const auto add = BinaryNode::create(c1, c2, BinaryOp::Add);
+  const auto custom = CustomNode::create(
+      "mul", {add, c3}, shape, [](const std::vector<const Tensor*> inputs) {
+        return *inputs[0] * *inputs[1];
+      });
+  evaluator_.setCollectStats(true);
+  evaluator_.eval(custom);
+  evaluator_.setCollectStats(false);
+  ASSERT_TRUE(allClose(custom->getResult().value(), full(shape, 9, dtype)));
+  const auto& stats = evaluator_.stats();
+  ASSERT_EQ(stats.numEvaluatedNodes, 5);
+  ASSERT_EQ(stats.numMaterializedBytes, 5 * shape.elements() * sizeof(float));
+  ASSERT_EQ(stats.customNodeStats.size(), 1);
+  ASSERT_EQ(stats.customNodeStats.at("mul").numEvals, 1);
+  evaluator_.resetStats();
+  ASSERT_EQ(evaluator_.stats().numEvaluatedNodes, 0);
+  ASSERT_TRUE(evaluator_.stats().customNodeStats.empty());
+  // root node is owned locally (didn't transition to shared ownership)
+  delete custom;
+}
+
 TEST_F(JitEvaluatorTest, evalIndexNodeWithoutTensorIdx) {
   const auto value = iota({4, 5, 6}, {1}, dtype::s32);
   const auto valueNode = ValueNode::create(value.copy());
@@ -157,6 +219,64 @@ TEST_F(JitEvaluatorTest, evalRetainResults) {
   c1->decRefCount();
 }
 
+TEST_F(JitEvaluatorTest, evalMinPeakMemoryOrder) {
+  //  c1  c2   big
+  //   \  /     |
+  //  small    sum
+  //     \     /
+  //       add
+  const auto dtype = dtype::f32;
+  const auto big = ScalarNode::create(Shape({100, 100}), dtype, 1);
+  const auto sum = ReductionNode::create(big, ReductionOp::Sum, {0}, true);
+  const auto c1 = ScalarNode::create(Shape({1, 100}), dtype, 1);
+  const auto c2 = ScalarNode::create(Shape({1, 100}), dtype, 2);
+  const auto small = BinaryNode::create(c1, c2, BinaryOp::Add);
+  const auto add = BinaryNode::create(small, sum, BinaryOp::Add);
+  // `small` stays alive while `big` is evaluated
+  ASSERT_EQ(evaluator_.getPlannedPeakBytes(add), (10000 + 100 + 100) * 4);
+  const auto schedule =
+      EvalScheduler::plan(add, EvalScheduler::Order::MinPeakMemory);
+  ASSERT_EQ(schedule.nodes, NodeList({big, sum, c1, c2, small, add}));
+  // `big` is released before `small` is evaluated
+  evaluator_.setEvalOrder(EvalScheduler::Order::MinPeakMemory);
+  ASSERT_EQ(evaluator_.getPlannedPeakBytes(add), (10000 + 100) * 4);
+  evaluator_.eval(add);
+  evaluator_.setEvalOrder(EvalScheduler::Order::InputOrder);
+  ASSERT_TRUE(allClose(
+      add->getResult().value(), full(Shape({1, 100}), 103, dtype)));
+  ASSERT_FALSE(big->getResult().has_value());
+  ASSERT_FALSE(small->getResult().has_value());
+  // root node is owned locally (didn't transition to shared ownership)
+  delete add;
+}
+
+TEST_F(JitEvaluatorTest, evalInParallel) {
+  //  c1  c2  c3  c4
+  //   \  /    \  /
+  //    add     mul
+  //      \    /
+  //        sub
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::s32;
+  const auto c1 = ScalarNode::create(shape, dtype, 1);
+  const auto c2 = ScalarNode::create(shape, dtype, 2);
+  const auto c3 = ScalarNode::create(shape, dtype, 3);
+  const auto c4 = ScalarNode::create(shape, dtype, 4);
+  const auto add = BinaryNode::create(c1, c2, BinaryOp::Add);
+  const auto mul = BinaryNode::create(c3, c4, BinaryOp::Mul);
+  const auto sub = BinaryNode::create(mul, add, BinaryOp::Sub);
+  ASSERT_THROW(evaluator_.setNumThreads(0), std::invalid_argument);
+  evaluator_.setNumThreads(4);
+  evaluator_.eval(sub);
+  evaluator_.setNumThreads(1);
+  ASSERT_TRUE(allClose(sub->getResult().value(), full(shape, 9, dtype)));
+  // intermediate results are still released after their last use
+  ASSERT_FALSE(add->getResult().has_value());
+  ASSERT_FALSE(mul->getResult().has_value());
+  // root node is owned locally (didn't transition to shared ownership)
+  delete sub;
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   init();
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Shape.h"
+#include "flashlight/fl/tensor/Types.h"
+#include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/CustomNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/GraphPrinter.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+
+using namespace fl;
+
+namespace {
+
+//   c1
+//  /  \
+//  \  /
+//   add
+//    |
+//  custom
+CustomNode* createSharedInputTree() {
+  const Shape shape({2, 3});
+  const auto c1 = ScalarNode::create(shape, dtype::f32, 1);
+  const auto add = BinaryNode::create(c1, c1, BinaryOp::Add);
+  return CustomNode::create(
+      "identity", {add}, shape, [](const std::vector<const Tensor*>& inputs) {
+        return *inputs[0];
+      });
+}
+
+} // namespace
+
+TEST(JitGraphPrinterTest, nodeLabel) {
+  const auto root = createSharedInputTree();
+  const auto add = root->inputs().at(0);
+  const auto c1 = add->inputs().at(0);
+  ASSERT_EQ(getNodeLabel(root), "Custom identity (2, 3)");
+  ASSERT_EQ(getNodeLabel(add), "Binary Add (2, 3)");
+  ASSERT_EQ(getNodeLabel(c1), "Scalar 1 f32 (2, 3)");
+  // root node is owned locally (didn't transition to shared ownership)
+  delete root;
+}
+
+TEST(JitGraphPrinterTest, graphviz) {
+  const auto root = createSharedInputTree();
+  std::ostringstream oss;
+  printGraphviz(root, oss);
+  // shared input is only printed once
+  ASSERT_EQ(
+      oss.str(),
+      "digraph JitTree {\n"
+      "  n0 [label=\"Scalar 1 f32 (2, 3)\"];\n"
+      "  n1 [label=\"Binary Add (2, 3)\"];\n"
+      "  n0 -> n1;\n"
+      "  n0 -> n1;\n"
+      "  n2 [label=\"Custom identity (2, 3)\"];\n"
+      "  n1 -> n2;\n"
+      "}\n");
+  // root node is owned locally (didn't transition to shared ownership)
+  delete root;
+}
+
+TEST(JitGraphPrinterTest, json) {
+  const auto root = createSharedInputTree();
+  std::ostringstream oss;
+  printJson(root, oss);
+  ASSERT_EQ(
+      oss.str(),
+      "{\"root\": 2, \"nodes\": ["
+      "{\"id\": 0, \"type\": \"Scalar\", \"label\": \"Scalar 1 f32 (2, 3)\", "
+      "\"shape\": [2, 3], \"evaluated\": false, \"inputs\": []}, "
+      "{\"id\": 1, \"type\": \"Binary\", \"label\": \"Binary Add (2, 3)\", "
+      "\"shape\": [2, 3], \"evaluated\": false, \"inputs\": [0, 0]}, "
+      "{\"id\": 2, \"type\": \"Custom\", "
+      "\"label\": \"Custom identity (2, 3)\", "
+      "\"shape\": [2, 3], \"evaluated\": false, \"inputs\": [1]}]}\n");
+  // root node is owned locally (didn't transition to shared ownership)
+  delete root;
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  init();
+  return RUN_ALL_TESTS();
+}
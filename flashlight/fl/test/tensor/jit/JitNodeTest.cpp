@@ -21,8 +21,11 @@
 #include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/CustomNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/IndexNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/MatmulNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/Node.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ReductionNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/ValueNode.h"
 
 using namespace fl;
@@ -76,6 +79,84 @@ TEST(JitNodeTest, BinaryNodeMetaData) {
   delete node;
 }
 
+TEST(JitNodeTest, UnaryNodeMetaData) {
+  const auto c1 = ScalarNode::create(Shape({2, 4}), dtype::f32, 42);
+  const auto op = UnaryOp::Exp;
+  const auto node = UnaryNode::create(c1, op);
+  ASSERT_EQ(node->inputs(), NodeList({c1}));
+  ASSERT_EQ(node->getRefCount(), 0);
+  ASSERT_EQ(node->uses(), UseList({}));
+  ASSERT_EQ(node->isUnary(), true);
+  ASSERT_EQ(node->getResult(), std::nullopt);
+  ASSERT_EQ(node->input(), c1);
+  ASSERT_EQ(node->op(), op);
+  ASSERT_EQ(node->shape(), Shape({2, 4}));
+  // node is owned locally (didn't transition to shared ownership)
+  delete node;
+}
+
+TEST(JitNodeTest, ReductionNodeMetaData) {
+  const auto c1 = ScalarNode::create(Shape({2, 3, 4}), dtype::f32, 42);
+  const auto op = ReductionOp::Sum;
+  const auto node = ReductionNode::create(c1, op, {2, 0, 2}, false);
+  ASSERT_EQ(node->inputs(), NodeList({c1}));
+  ASSERT_EQ(node->getRefCount(), 0);
+  ASSERT_EQ(node->uses(), UseList({}));
+  ASSERT_EQ(node->isReduction(), true);
+  ASSERT_EQ(node->getResult(), std::nullopt);
+  ASSERT_EQ(node->input(), c1);
+  ASSERT_EQ(node->op(), op);
+  ASSERT_EQ(node->axes(), std::vector<int>({0, 2})); // sorted & deduplicated
+  ASSERT_EQ(node->keepDims(), false);
+  ASSERT_EQ(node->shape(), Shape({3}));
+  // node is owned locally (didn't transition to shared ownership)
+  delete node;
+}
+
+TEST(JitNodeTest, ReductionNodeShapes) {
+  const auto c1 = ScalarNode::create(Shape({2, 3, 4}), dtype::f32, 42);
+  c1->incRefCount(); // keep it alive across the nodes below
+  const auto maxKeepDims =
+      ReductionNode::create(c1, ReductionOp::Max, {1}, true);
+  ASSERT_EQ(maxKeepDims->shape(), Shape({2, 1, 4}));
+  delete maxKeepDims;
+  // empty axes reduce along all axes
+  const auto sumAll = ReductionNode::create(c1, ReductionOp::Sum, {}, false);
+  ASSERT_EQ(sumAll->axes(), std::vector<int>({0, 1, 2}));
+  ASSERT_EQ(sumAll->shape(), Shape());
+  delete sumAll;
+  const auto meanAll = ReductionNode::create(c1, ReductionOp::Mean, {}, true);
+  ASSERT_EQ(meanAll->shape(), Shape({1, 1, 1}));
+  delete meanAll;
+  ASSERT_THROW(
+      ReductionNode::create(c1, ReductionOp::Min, {3}, false),
+      std::invalid_argument);
+  c1->decRefCount();
+}
+
+TEST(JitNodeTest, MatmulNodeMetaData) {
+  const auto c1 = ScalarNode::create(Shape({2, 3}), dtype::f32, 42);
+  const auto c2 = ScalarNode::create(Shape({4, 3}), dtype::f32, 23);
+  const auto lhsProp = MatrixProperty::None;
+  const auto rhsProp = MatrixProperty::Transpose;
+  const auto node = MatmulNode::create(c1, c2, lhsProp, rhsProp);
+  ASSERT_EQ(node->inputs(), NodeList({c1, c2}));
+  ASSERT_EQ(node->getRefCount(), 0);
+  ASSERT_EQ(node->uses(), UseList({}));
+  ASSERT_EQ(node->isMatmul(), true);
+  ASSERT_EQ(node->getResult(), std::nullopt);
+  ASSERT_EQ(node->lhs(), c1);
+  ASSERT_EQ(node->rhs(), c2);
+  ASSERT_EQ(node->lhsProp(), lhsProp);
+  ASSERT_EQ(node->rhsProp(), rhsProp);
+  ASSERT_EQ(node->shape(), Shape({2, 4}));
+  ASSERT_THROW(
+      MatmulNode::create(c1, c2, lhsProp, MatrixProperty::None),
+      std::invalid_argument);
+  // node is owned locally (didn't transition to shared ownership)
+  delete node;
+}
+
 TEST(JitNodeTest, CustomNodeMetaData) {
   Shape shape({2, 2});
   auto type = dtype::f32;
@@ -15,7 +15,9 @@
 #include "flashlight/fl/tensor/backend/jit/Utils.h"
 #include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/CustomNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/MatmulNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
 #include "flashlight/fl/tensor/backend/jit/opt/backends/onednn/OneDnnOpFusion.h"
 
 using namespace fl;
@@ -160,7 +162,7 @@ TEST_F(JitOneDnnOpFusionTest, nestedFusableChains) {
   //     \  /
   //  c1  div
   //   \  /
-  //    mul  c5
+  //    sub2  c5
   //     \  /
   //      add
   Shape shape(Shape({2, 2}));
@@ -172,15 +174,15 @@ TEST_F(JitOneDnnOpFusionTest, nestedFusableChains) {
   const auto c5 = ScalarNode::create(shape, dtype, 5);
   const auto sub = BinaryNode::create(c2, c3, BinaryOp::Sub);
   const auto div = BinaryNode::create(sub, c4, BinaryOp::Div);
-  const auto mul = BinaryNode::create(c1, div, BinaryOp::Mul);
-  const auto add = BinaryNode::create(mul, c5, BinaryOp::Add);
+  const auto sub2 = BinaryNode::create(c1, div, BinaryOp::Sub);
+  const auto add = BinaryNode::create(sub2, c5, BinaryOp::Add);
   // c2   c3              c2  c3 c4
   //  \  /                 \  |  /
   //   sub  c4          fusedCustomNode
   //     \  /                 |
   //  c1  div     ---->    c1 | c5
   //   \  /                 \ | /
-  //    mul  c5         fusedCustomRoot
+  //   sub2  c5         fusedCustomRoot
   //     \  /
   //      add
   const auto fusedCustomRoot = oneDnnFuser_.apply(add);
@@ -220,6 +222,120 @@ TEST_F(JitOneDnnOpFusionTest, nestedFusableChains) {
   delete fusedCustomRoot;
 }
 
+TEST_F(JitOneDnnOpFusionTest, commutativeFusableChain) {
+  //  c2  c3
+  //   \  /
+  //    sub
+  //     |
+  //  c1 |
+  //   \ |
+  //    mul  c4
+  //     \  /
+  //      add
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::s32;
+  const auto c1 = ScalarNode::create(shape, dtype, 1);
+  const auto c2 = ScalarNode::create(shape, dtype, 2);
+  const auto c3 = ScalarNode::create(shape, dtype, 3);
+  const auto c4 = ScalarNode::create(shape, dtype, 4);
+  const auto sub = BinaryNode::create(c2, c3, BinaryOp::Sub);
+  const auto mul = BinaryNode::create(c1, sub, BinaryOp::Mul);
+  const auto add = BinaryNode::create(mul, c4, BinaryOp::Add);
+  // `mul` commutes, so the chain continues into `sub`
+  //
+  //  c2 c3 c1 c4
+  //   \  | |  /
+  //  fusedCustomRoot
+  const auto fusedCustomRoot = oneDnnFuser_.apply(add);
+  delete add; // since it's not owned by a tensor, we manually get rid of it
+  ASSERT_TRUE(fusedCustomRoot->isCustom());
+  ASSERT_EQ(fusedCustomRoot->inputs(), NodeList({c2, c3, c1, c4}));
+  ASSERT_EQ(fusedCustomRoot->shape(), shape);
+  ASSERT_EQ(c1->uses(), UseValList({{fusedCustomRoot, 2}}));
+  ASSERT_EQ(c4->uses(), UseValList({{fusedCustomRoot, 3}}));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete fusedCustomRoot;
+}
+
+TEST_F(JitOneDnnOpFusionTest, eltwisePostOp) {
+  // c1  c2
+  //  \  /
+  //   sub
+  //    |
+  //   tanh  c3
+  //     \  /
+  //      add
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::f32;
+  const auto c1 = ScalarNode::create(shape, dtype, 1);
+  const auto c2 = ScalarNode::create(shape, dtype, 2);
+  const auto c3 = ScalarNode::create(shape, dtype, 3);
+  const auto sub = BinaryNode::create(c1, c2, BinaryOp::Sub);
+  const auto tanh = UnaryNode::create(sub, UnaryOp::Tanh);
+  const auto add = BinaryNode::create(tanh, c3, BinaryOp::Add);
+  const auto fusedCustomRoot = oneDnnFuser_.apply(add);
+  delete add; // since it's not owned by a tensor, we manually get rid of it
+  ASSERT_TRUE(fusedCustomRoot->isCustom());
+  ASSERT_EQ(
+      fusedCustomRoot->impl<CustomNode>().name(), "OneDnnFusedBinaryOp");
+  ASSERT_EQ(fusedCustomRoot->inputs(), NodeList({c1, c2, c3}));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete fusedCustomRoot;
+}
+
+TEST_F(JitOneDnnOpFusionTest, leadingEltwiseNotFused) {
+  //  c1
+  //   |
+  //  tanh  c2
+  //    \  /
+  //     add
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::f32;
+  const auto c1 = ScalarNode::create(shape, dtype, 1);
+  const auto c2 = ScalarNode::create(shape, dtype, 2);
+  const auto tanh = UnaryNode::create(c1, UnaryOp::Tanh);
+  const auto add = BinaryNode::create(tanh, c2, BinaryOp::Add);
+  // binary primitive can't start with an eltwise op, nothing changes
+  ASSERT_EQ(add, oneDnnFuser_.apply(add));
+  ASSERT_EQ(add->inputs(), NodeList({tanh, c2}));
+  ASSERT_EQ(tanh->inputs(), NodeList({c1}));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete add;
+}
+
+TEST_F(JitOneDnnOpFusionTest, matmulAnchoredChain) {
+  // c1  c2
+  //  \  /
+  // matmul
+  //    |
+  //   tanh  c3
+  //     \  /
+  //      add
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::f32;
+  const auto c1 = ScalarNode::create(shape, dtype, 1);
+  const auto c2 = ScalarNode::create(shape, dtype, 2);
+  const auto c3 = ScalarNode::create(shape, dtype, 3);
+  const auto matmul = MatmulNode::create(
+      c1, c2, MatrixProperty::None, MatrixProperty::Transpose);
+  const auto tanh = UnaryNode::create(matmul, UnaryOp::Tanh);
+  const auto add = BinaryNode::create(tanh, c3, BinaryOp::Add);
+  //   c1 c2 c3
+  //    \ |  /
+  // fusedCustomRoot (matmul primitive with tanh & add post-ops)
+  const auto fusedCustomRoot = oneDnnFuser_.apply(add);
+  delete add; // since it's not owned by a tensor, we manually get rid of it
+  ASSERT_TRUE(fusedCustomRoot->isCustom());
+  ASSERT_EQ(fusedCustomRoot->impl<CustomNode>().name(), "OneDnnFusedMatmul");
+  ASSERT_EQ(fusedCustomRoot->inputs(), NodeList({c1, c2, c3}));
+  ASSERT_EQ(fusedCustomRoot->shape(), shape);
+  ASSERT_EQ(c1->uses(), UseValList({{fusedCustomRoot, 0}}));
+  ASSERT_EQ(c2->uses(), UseValList({{fusedCustomRoot, 1}}));
+  ASSERT_EQ(c3->uses(), UseValList({{fusedCustomRoot, 2}}));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete fusedCustomRoot;
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   init();
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/tensor/DefaultTensorType.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Random.h"
+#include "flashlight/fl/tensor/Shape.h"
+#include "flashlight/fl/tensor/Types.h"
+#include "flashlight/fl/tensor/backend/jit/Utils.h"
+#include "flashlight/fl/tensor/backend/jit/eval/Evaluator.h"
+#include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/CustomNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ValueNode.h"
+#include "flashlight/fl/tensor/backend/jit/opt/OptimizedGraphCache.h"
+#include "flashlight/fl/tensor/backend/jit/opt/Optimizer.h"
+
+using namespace fl;
+
+class JitOptimizedGraphCacheTest : public ::testing::Test {
+ protected:
+  TensorBackend& defaultBackend_ = DefaultTensorBackend_t::getInstance();
+  Evaluator evaluator_{defaultBackend_};
+};
+
+namespace {
+
+// a leaf is any node that already has a result
+Node* createLeaf(const Shape& shape, const dtype type) {
+  return ValueNode::create(fl::rand(shape, type));
+}
+
+//   leaf  c
+//     \  /
+//     `op`
+Node* createTree(Node* leaf, const BinaryOp op, const float scalar) {
+  const auto c = ScalarNode::create(leaf->shape(), dtype::f32, scalar);
+  return BinaryNode::create(leaf, c, op);
+}
+
+} // namespace
+
+TEST_F(JitOptimizedGraphCacheTest, signatureIgnoresLeafIdentity) {
+  Shape shape(Shape({2, 3}));
+  const auto leaf1 = createLeaf(shape, dtype::f32);
+  const auto leaf2 = createLeaf(shape, dtype::f32);
+  const auto tree1 = createTree(leaf1, BinaryOp::Add, 1);
+  const auto tree2 = createTree(leaf2, BinaryOp::Add, 1);
+  const auto signature1 = OptimizedGraphCache::getSignature(tree1);
+  const auto signature2 = OptimizedGraphCache::getSignature(tree2);
+  ASSERT_TRUE(signature1.has_value());
+  ASSERT_TRUE(signature2.has_value());
+  ASSERT_EQ(signature1->key, signature2->key);
+  ASSERT_EQ(signature1->leaves, NodeList({leaf1}));
+  ASSERT_EQ(signature2->leaves, NodeList({leaf2}));
+  // root nodes are owned locally (didn't transition to shared ownership)
+  delete tree1;
+  delete tree2;
+}
+
+TEST_F(JitOptimizedGraphCacheTest, signatureCapturesStructure) {
+  Shape shape(Shape({2, 3}));
+  const auto leaf = createLeaf(shape, dtype::f32);
+  leaf->incRefCount(); // shared by all trees below
+  const auto getKey = [](Node* tree) {
+    const auto key = OptimizedGraphCache::getSignature(tree).value().key;
+    delete tree;
+    return key;
+  };
+  const auto key = getKey(createTree(leaf, BinaryOp::Add, 1));
+  // op
+  ASSERT_NE(key, getKey(createTree(leaf, BinaryOp::Mul, 1)));
+  // scalar value
+  ASSERT_NE(key, getKey(createTree(leaf, BinaryOp::Add, 2)));
+  // leaf shape & type
+  const auto otherShapeLeaf = createLeaf(Shape({3, 2}), dtype::f32);
+  ASSERT_NE(key, getKey(createTree(otherShapeLeaf, BinaryOp::Add, 1)));
+  const auto otherTypeLeaf = createLeaf(shape, dtype::f64);
+  ASSERT_NE(key, getKey(createTree(otherTypeLeaf, BinaryOp::Add, 1)));
+  // sharing
+  const auto leaf2 = createLeaf(shape, dtype::f32);
+  const auto sharedKey = getKey(BinaryNode::create(leaf, leaf, BinaryOp::Add));
+  ASSERT_NE(sharedKey, getKey(BinaryNode::create(leaf, leaf2, BinaryOp::Add)));
+  leaf->decRefCount();
+}
+
+TEST_F(JitOptimizedGraphCacheTest, uncacheableTrees) {
+  Shape shape(Shape({2, 3}));
+  // opaque semantics
+  const auto leaf = createLeaf(shape, dtype::f32);
+  const auto custom = CustomNode::create(
+      "identity", {leaf}, shape, [](const std::vector<const Tensor*>& inputs) {
+        return *inputs[0];
+      });
+  ASSERT_FALSE(OptimizedGraphCache::getSignature(custom).has_value());
+  // nothing to optimize
+  evaluator_.eval(custom);
+  ASSERT_FALSE(OptimizedGraphCache::getSignature(custom).has_value());
+  // root node is owned locally (didn't transition to shared ownership)
+  delete custom;
+}
+
+TEST_F(JitOptimizedGraphCacheTest, replayOnNewLeaves) {
+  OptimizedGraphCache cache;
+  Shape shape(Shape({2, 3}));
+  const auto t1 = fl::rand(shape, dtype::f32);
+  const auto t2 = fl::rand(shape, dtype::f32);
+  const auto leaf1 = ValueNode::create(t1.copy());
+  const auto leaf2 = ValueNode::create(t2.copy());
+  const auto tree1 = createTree(leaf1, BinaryOp::Mul, 3);
+  const auto tree2 = createTree(leaf2, BinaryOp::Mul, 3);
+  const auto signature1 = OptimizedGraphCache::getSignature(tree1).value();
+  const auto signature2 = OptimizedGraphCache::getSignature(tree2).value();
+  ASSERT_EQ(cache.replay(signature1), nullptr);
+  cache.record(signature1, tree1);
+  ASSERT_EQ(cache.size(), 1);
+  // recording doesn't retain the recorded tree
+  ASSERT_EQ(leaf1->uses(), UseValList({{tree1, 0}}));
+  const auto replayed = cache.replay(signature2);
+  ASSERT_NE(replayed, nullptr);
+  ASSERT_NE(replayed, tree2);
+  ASSERT_TRUE(replayed->isBinary());
+  ASSERT_EQ(replayed->inputs().at(0), leaf2);
+  evaluator_.eval(replayed);
+  ASSERT_TRUE(allClose(replayed->getResult().value(), t2 * 3));
+  // root nodes are owned locally (didn't transition to shared ownership)
+  delete tree1;
+  delete tree2;
+  delete replayed;
+  cache.clear();
+  ASSERT_EQ(cache.size(), 0);
+}
+
+TEST_F(JitOptimizedGraphCacheTest, optimizerReusesCachedTrees) {
+  Optimizer optimizer(defaultBackend_);
+  Shape shape(Shape({2, 3}));
+  const auto t = fl::rand(shape, dtype::f32);
+  for (int i = 0; i < 3; i++) {
+    //  c1  c2
+    //   \  /
+    //   add  leaf
+    //     \  /
+    //     mul
+    const auto leaf = ValueNode::create(t.copy());
+    const auto c1 = ScalarNode::create(shape, dtype::f32, 1);
+    const auto c2 = ScalarNode::create(shape, dtype::f32, 2);
+    const auto add = BinaryNode::create(c1, c2, BinaryOp::Add);
+    const auto mul = BinaryNode::create(add, leaf, BinaryOp::Mul);
+    // keep `mul` alive for comparison against the optimized tree
+    mul->incRefCount();
+    const auto optimized = optimizer.optimize(mul);
+    optimized->incRefCount();
+    ASSERT_EQ(optimizer.cache().size(), 1);
+    if (i > 0) {
+      // cache hit -- passes (which update in-place) didn't touch the tree
+      ASSERT_NE(optimized, mul);
+      ASSERT_EQ(mul->inputs(), NodeList({add, leaf}));
+    }
+    evaluator_.eval(optimized);
+    ASSERT_TRUE(allClose(optimized->getResult().value(), t * 3));
+    mul->decRefCount();
+    optimized->decRefCount();
+  }
+}
+
+TEST_F(JitOptimizedGraphCacheTest, optimizerStats) {
+  Optimizer optimizer(defaultBackend_);
+  optimizer.setCollectStats(true);
+  Shape shape(Shape({2, 3}));
+  const auto t = fl::rand(shape, dtype::f32);
+  for (int i = 0; i < 2; i++) {
+    //  c1  c2
+    //   \  /
+    //   add  leaf
+    //     \  /
+    //     mul
+    const auto leaf = ValueNode::create(t.copy());
+    const auto c1 = ScalarNode::create(shape, dtype::f32, 1);
+    const auto c2 = ScalarNode::create(shape, dtype::f32, 2);
+    const auto add = BinaryNode::create(c1, c2, BinaryOp::Add);
+    const auto mul = BinaryNode::create(add, leaf, BinaryOp::Mul);
+    mul->incRefCount();
+    const auto optimized = optimizer.optimize(mul);
+    optimized->incRefCount();
+    mul->decRefCount();
+    optimized->decRefCount();
+  }
+  const auto& stats = optimizer.stats();
+  ASSERT_EQ(stats.numOptimizedTrees, 2);
+  // second tree is replayed, so passes only ran once
+  ASSERT_EQ(stats.numReplayedTrees, 1);
+  ASSERT_FALSE(stats.passStats.empty());
+  const auto& foldingStats = stats.passStats.front();
+  ASSERT_EQ(foldingStats.name, "ScalarFolding");
+  ASSERT_EQ(foldingStats.numRuns, 1);
+  ASSERT_EQ(foldingStats.numNodesBefore, 5);
+  ASSERT_EQ(foldingStats.numNodesAfter, 3); // `c1 + c2` is folded
+  for (const auto& passStats : stats.passStats) {
+    ASSERT_EQ(passStats.numRuns, 1);
+  }
+  optimizer.resetStats();
+  ASSERT_EQ(optimizer.stats().numOptimizedTrees, 0);
+  ASSERT_EQ(optimizer.stats().passStats.front().numRuns, 0);
+}
+
+namespace {
+
+class CountingPass : public Pass {
+ public:
+  unsigned numRuns{0};
+
+  Node* apply(Node* node) override {
+    numRuns++;
+    return node;
+  }
+
+  std::string name() const override {
+    return "CountingPass";
+  }
+};
+
+} // namespace
+
+TEST_F(JitOptimizedGraphCacheTest, optimizerAddPass) {
+  Optimizer optimizer(defaultBackend_);
+  optimizer.setCollectStats(true);
+  Shape shape(Shape({2, 3}));
+  const auto t = fl::rand(shape, dtype::f32);
+  const auto optimizeTree = [&]() {
+    const auto tree = createTree(ValueNode::create(t.copy()), BinaryOp::Add, 1);
+    tree->incRefCount();
+    const auto optimized = optimizer.optimize(tree);
+    optimized->incRefCount();
+    tree->decRefCount();
+    optimized->decRefCount();
+  };
+  optimizeTree();
+  ASSERT_EQ(optimizer.cache().size(), 1);
+
+  auto pass = std::make_unique<CountingPass>();
+  const auto& counter = *pass;
+  optimizer.addPass(std::move(pass));
+  // plans from before the pass are dropped
+  ASSERT_EQ(optimizer.cache().size(), 0);
+  ASSERT_EQ(optimizer.stats().passStats.back().name, "CountingPass");
+  optimizeTree();
+  optimizeTree(); // replayed
+  ASSERT_EQ(counter.numRuns, 1);
+  ASSERT_EQ(optimizer.stats().passStats.back().numRuns, 1);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  init();
+  return RUN_ALL_TESTS();
+}
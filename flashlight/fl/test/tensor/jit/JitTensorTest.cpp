@@ -20,7 +20,9 @@
 #include "flashlight/fl/tensor/backend/jit/JitTensorBase.h"
 #include "flashlight/fl/tensor/backend/jit/Utils.h"
 #include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ReductionNode.h"
 #include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
 
 using namespace fl;
 
@@ -105,6 +107,42 @@ TEST_F(JitTensorTest, div) {
   testBinaryOp(std::divides<>(), BinaryOp::Div);
 }
 
+TEST_F(JitTensorTest, unaryOp) {
+  // c0
+  //  |
+  // node
+  Shape shape({2, 2});
+  auto dtype = dtype::f32;
+  const auto t0 = full(shape, 0, dtype);
+  const auto c0 = toJitTensorBase(t0).node();
+  const auto tensor = fl::tanh(t0);
+  const auto node = &toJitTensorBase(tensor).node()->impl<UnaryNode>();
+  ASSERT_EQ(node->inputs(), NodeList({c0}));
+  ASSERT_EQ(node->op(), UnaryOp::Tanh);
+  ASSERT_EQ(node->shape(), shape);
+  ASSERT_EQ(c0->uses(), UseValList({{node, 0}}));
+  ASSERT_TRUE(allClose(tensor, full(shape, 0, dtype)));
+}
+
+TEST_F(JitTensorTest, reductionOp) {
+  // c0
+  //  |
+  // node
+  Shape shape({2, 3});
+  auto dtype = dtype::f32;
+  const auto t0 = full(shape, 1, dtype);
+  const auto c0 = toJitTensorBase(t0).node();
+  const auto tensor = fl::amax(t0, {0}, /* keepDims = */ true);
+  const auto node = &toJitTensorBase(tensor).node()->impl<ReductionNode>();
+  ASSERT_EQ(node->inputs(), NodeList({c0}));
+  ASSERT_EQ(node->op(), ReductionOp::Max);
+  ASSERT_EQ(node->axes(), std::vector<int>({0}));
+  ASSERT_EQ(node->keepDims(), true);
+  ASSERT_EQ(node->shape(), Shape({1, 3}));
+  ASSERT_EQ(c0->uses(), UseValList({{node, 0}}));
+  ASSERT_TRUE(allClose(tensor, full(Shape({1, 3}), 1, dtype)));
+}
+
 TEST_F(JitTensorTest, explicitEval) {
   Shape shape(Shape({2, 2}));
   auto dtype = dtype::s32;
@@ -131,6 +169,36 @@ TEST_F(JitTensorTest, forcedEval) {
       defaultBackend_.full(shape, 33, dtype)));
 }
 
+TEST_F(JitTensorTest, autoMaterialization) {
+  Shape shape(Shape({2, 2}));
+  auto dtype = dtype::s32;
+  const auto t0 = full(shape, 1, dtype);
+  auto& backend = toJitTensorBase(t0).backend();
+  const auto isMaterialized = [](const Tensor& tensor) {
+    return toJitTensorBase(tensor).node()->isValue();
+  };
+  // lazy part of `t3` has 4 nodes: 3 adds + 1 scalar
+  backend.setMaterializationPolicy({.maxNumNodes = 4});
+  const auto t1 = t0 + t0;
+  const auto t2 = t1 + t1;
+  const auto t3 = t2 + t2;
+  ASSERT_FALSE(isMaterialized(t3));
+  const auto t4 = t3 + t3;
+  ASSERT_TRUE(isMaterialized(t4));
+  ASSERT_TRUE(allClose(t4, full(shape, 16, dtype)));
+
+  // `t4` is a leaf now, with 2 * 2 * 4 bytes
+  backend.setMaterializationPolicy({.maxLeafBytes = 16});
+  const auto t5 = t4 + t4;
+  ASSERT_FALSE(isMaterialized(t5));
+  toJitTensorBase(t5).materialize();
+  ASSERT_TRUE(isMaterialized(t5));
+  const auto t6 = t5 + t4;
+  ASSERT_TRUE(isMaterialized(t6));
+  ASSERT_TRUE(allClose(t6, full(shape, 48, dtype)));
+  backend.setMaterializationPolicy({});
+}
+
 TEST_F(JitTensorTest, assignment) {
   // we don't test the computation result (that's Evaluator's job) -- we only
   // test the graph we are building.
@@ -7,6 +7,8 @@
 
 #include <gtest/gtest.h>
 
+#include <thread>
+
 #include "flashlight/fl/runtime/DeviceManager.h"
 #include "flashlight/fl/tensor/Init.h"
 #include "flashlight/fl/tensor/backend/onednn/OneDnnCPUStream.h"
@@ -18,6 +20,7 @@ using fl::DeviceType;
 using fl::Stream;
 using fl::StreamType;
 using fl::OneDnnCPUStream;
+using fl::OneDnnCPUThreadingOptions;
 
 TEST(OneDnnCPUStreamTest, create) {
   const dnnl::engine cpuEngine(dnnl::engine::kind::cpu, 0);
@@ -52,6 +55,27 @@ TEST(OneDnnCPUStreamTest, sync) {
   ASSERT_NO_THROW(os1->sync());
 }
 
+TEST(OneDnnCPUStreamTest, threadingOptions) {
+  const dnnl::engine engine(dnnl::engine::kind::cpu, 0);
+  OneDnnCPUThreadingOptions options;
+  options.numThreads = 1;
+  options.cpus = {0};
+  const auto stream = OneDnnCPUStream::create(engine, options);
+  ASSERT_EQ(stream->threadingOptions().numThreads, 1);
+  ASSERT_EQ(stream->threadingOptions().cpus, std::vector<unsigned>{0});
+  ASSERT_EQ(stream->threadingOptions().numaNode, -1);
+
+  // bind another thread to leave the test runner's threading untouched
+  std::thread([&stream]() {
+    ASSERT_NO_THROW(stream->bindCallingThread());
+    ASSERT_NO_THROW(stream->sync());
+  }).join();
+
+  options.numaNode = -2;
+  ASSERT_THROW(
+      OneDnnCPUStream::create(engine, options), std::invalid_argument);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
@@ -283,6 +283,49 @@ TEST(OneDnnTensorTest, device) {
   t.unlock();
 }
 
+TEST(OneDnnTensorTest, blockedLayout) {
+  // OneDNN dims are reversed, so storing them as "ba" makes a 2x3 tensor
+  // row-major rather than column-major
+  const dnnl::memory::desc memDesc(
+      {3, 2}, dnnl::memory::data_type::f32, dnnl::memory::format_tag::ba);
+  dnnl::memory mem(memDesc, fl::OneDnnBackend::getInstance().engine());
+  auto* data = static_cast<float*>(mem.get_data_handle());
+  for (int i = 0; i < 6; i++) {
+    data[i] = i;
+  }
+  auto t = fl::toTensor<OneDnnTensor>(fl::Shape({2, 3}), std::move(mem));
+  auto& oneDnnTensor = t.getAdapter<OneDnnTensor>();
+  ASSERT_TRUE(oneDnnTensor.hasBlockedLayout());
+
+  // element-wise ops keep the layout
+  auto negated = -t;
+  ASSERT_TRUE(negated.getAdapter<OneDnnTensor>().hasBlockedLayout());
+  ASSERT_EQ(
+      negated.toHostVector<float>(),
+      std::vector<float>({0, -3, -1, -4, -2, -5}));
+
+  // the plain memory is requested, hence the layout is converted
+  ASSERT_EQ(t.toHostVector<float>(), std::vector<float>({0, 3, 1, 4, 2, 5}));
+  ASSERT_FALSE(oneDnnTensor.hasBlockedLayout());
+  oneDnnTensor.memory();
+  ASSERT_FALSE(oneDnnTensor.hasBlockedLayout());
+}
+
+TEST(OneDnnTensorTest, DLPack) {
+  auto t = fl::Tensor::fromVector<float>({2, 3}, {0, 1, 2, 3, 4, 5});
+  {
+    auto imported = fl::fromDLPack(t.toDLPack());
+    ASSERT_EQ(imported.backendType(), fl::TensorBackendType::OneDnn);
+    // the memory is shared, and locked until the importer releases it
+    ASSERT_TRUE(t.isLocked());
+    ASSERT_EQ(imported.device<void>(), t.device<void>());
+    imported.unlock();
+    ASSERT_TRUE(fl::allClose(imported, t));
+  }
+  t.unlock();
+  ASSERT_FALSE(t.isLocked());
+}
+
 TEST(OneDnnTensorTest, arithmetics) {
   auto t1 = fl::Tensor::fromVector<float>({2, 2}, {0, 1, 2, 3});
   auto t2 = fl::Tensor::fromVector<int>({2, 2}, {1, 2, 3, 4});
@@ -545,9 +588,11 @@ TEST(OneDnnTensorTest, matmulShapes) {
     // batch matrix
     {{2, 3, 42}, {2, 3, 42}, MP::None, MP::Transpose, {{2, 2, 42}}},
     {{2, 3, 41}, {2, 3, 42}, MP::None, MP::Transpose, std::nullopt},
-    // TODO support broadcast
-    {{2, 3, 1}, {2, 3, 42}, MP::None, MP::Transpose, std::nullopt},
-    {{2, 3}, {2, 3, 42}, MP::None, MP::Transpose, std::nullopt},
+    // broadcast batch matrix
+    {{2, 3, 1}, {2, 3, 42}, MP::None, MP::Transpose, {{2, 2, 42}}},
+    {{2, 3}, {2, 3, 42}, MP::None, MP::Transpose, {{2, 2, 42}}},
+    {{2, 3, 5, 1}, {3, 4, 1, 6}, MP::None, MP::None, {{2, 4, 5, 6}}},
+    {{2, 3, 5}, {3, 4, 6}, MP::None, MP::None, std::nullopt},
   };
   for (auto& input : inputs) {
     const auto lhs = backend.rand(input.lhsShape, fl::dtype::f32);
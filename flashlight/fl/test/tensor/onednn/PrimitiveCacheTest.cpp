@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/backend/onednn/OneDnnTensor.h"
+#include "flashlight/fl/tensor/backend/onednn/PrimitiveCache.h"
+
+using fl::OneDnnTensor;
+using fl::detail::OneDnnPrimitiveCache;
+using fl::detail::OneDnnPrimitiveKey;
+
+namespace {
+
+class PrimitiveCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    OneDnnPrimitiveCache::getInstance().reset(
+        OneDnnPrimitiveCache::kDefaultCapacity);
+    OneDnnPrimitiveCache::getInstance().resetStats();
+  }
+};
+
+} // namespace
+
+TEST(PrimitiveKeyTest, DistinguishesDescriptors) {
+  using dnnl::memory;
+  const memory::desc a({2, 3}, memory::data_type::f32, memory::format_tag::ab);
+  const memory::desc b({3, 2}, memory::data_type::f32, memory::format_tag::ab);
+  const memory::desc c({2, 3}, memory::data_type::s32, memory::format_tag::ab);
+  const memory::desc d({2, 3}, memory::data_type::f32, memory::format_tag::ba);
+  const auto key = [](const memory::desc& desc) {
+    return (OneDnnPrimitiveKey("test") << desc).str();
+  };
+  ASSERT_EQ(key(a), key(a));
+  ASSERT_NE(key(a), key(b));
+  ASSERT_NE(key(a), key(c));
+  ASSERT_NE(key(a), key(d));
+  ASSERT_NE(
+      (OneDnnPrimitiveKey("test") << a).str(),
+      (OneDnnPrimitiveKey("other") << a).str());
+}
+
+TEST_F(PrimitiveCacheTest, RepeatedOpsHit) {
+  auto& cache = OneDnnPrimitiveCache::getInstance();
+  const auto lhs = fl::full({4, 5}, 2.);
+  const auto rhs = fl::full({4, 5}, 3.);
+  auto res = lhs + rhs;
+  const auto missesAfterFirst = cache.stats().misses;
+  ASSERT_GT(missesAfterFirst, 0);
+  for (int i = 0; i < 3; ++i) {
+    res = lhs + rhs;
+  }
+  ASSERT_EQ(cache.stats().misses, missesAfterFirst);
+  ASSERT_GE(cache.stats().hits, 3);
+  ASSERT_GT(cache.stats().hitRate(), 0.);
+  ASSERT_TRUE(fl::allClose(res, fl::full({4, 5}, 5.)));
+
+  // a new shape misses
+  auto other = fl::full({6}, 2.) + fl::full({6}, 3.);
+  ASSERT_GT(cache.stats().misses, missesAfterFirst);
+  ASSERT_TRUE(fl::allClose(other, fl::full({6}, 5.)));
+}
+
+TEST_F(PrimitiveCacheTest, Disabled) {
+  auto& cache = OneDnnPrimitiveCache::getInstance();
+  cache.reset(0);
+  for (int i = 0; i < 3; ++i) {
+    auto res = fl::full({4, 5}, 2.) * fl::full({4, 5}, 3.);
+    ASSERT_TRUE(fl::allClose(res, fl::full({4, 5}, 6.)));
+  }
+  ASSERT_EQ(cache.stats().hits, 0);
+  ASSERT_EQ(cache.capacity(), 0);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  fl::setDefaultTensorType<OneDnnTensor>();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Random.h"
+#include "flashlight/fl/tensor/TensorAdapter.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/backend/stub/StubBackend.h"
+#include "flashlight/fl/tensor/backend/stub/StubTensor.h"
+
+using namespace fl;
+
+TEST(StubTensorTest, Shapes) {
+  withTensorType<StubTensor>([]() {
+    auto a = fl::rand({4, 8});
+    ASSERT_EQ(a.backendType(), TensorBackendType::Stub);
+    ASSERT_EQ(a.shape(), Shape({4, 8}));
+    ASSERT_EQ(a.strides(), Shape({1, 4}));
+
+    ASSERT_EQ(fl::matmul(a, fl::rand({8, 3})).shape(), Shape({4, 3}));
+    ASSERT_EQ(
+        fl::matmul(a, fl::rand({4, 3}), MatrixProperty::Transpose).shape(),
+        Shape({8, 3}));
+    ASSERT_THROW(fl::matmul(a, a), std::invalid_argument);
+
+    ASSERT_EQ((a + fl::rand({4, 1})).shape(), Shape({4, 8}));
+    ASSERT_THROW(a + fl::rand({3, 8}), std::invalid_argument);
+    ASSERT_EQ((a > 0).type(), dtype::b8);
+    ASSERT_EQ((a.astype(dtype::s32) + a).type(), dtype::f32);
+
+    ASSERT_EQ(fl::sum(a, {1}).shape(), Shape({4}));
+    ASSERT_EQ(fl::sum(a, {1}, /* keepDims = */ true).shape(), Shape({4, 1}));
+    ASSERT_EQ(fl::sum(a).shape(), Shape({}));
+    ASSERT_EQ(fl::argmax(a, 0).type(), dtype::u32);
+
+    ASSERT_EQ(a(fl::range(1, 3)).shape(), Shape({2, 8}));
+    ASSERT_EQ(a(2).shape(), Shape({8}));
+    ASSERT_EQ(fl::transpose(a).shape(), Shape({8, 4}));
+    ASSERT_EQ(fl::reshape(a, {32}).shape(), Shape({32}));
+    ASSERT_THROW(fl::reshape(a, {3}), std::invalid_argument);
+    ASSERT_EQ(fl::concatenate(1, a, a).shape(), Shape({4, 16}));
+
+    // host reads give zeros
+    const auto values = a.toHostVector<float>();
+    ASSERT_EQ(values.size(), 32);
+    ASSERT_EQ(values[0], 0);
+  });
+}
+
+TEST(StubTensorTest, Accounting) {
+  auto& backend = StubBackend::getInstance();
+  withTensorType<StubTensor>([&backend]() {
+    const auto liveBytes = backend.liveBytes();
+    const auto flops = backend.flops();
+    {
+      auto a = fl::rand({4, 8});
+      ASSERT_EQ(backend.liveBytes(), liveBytes + 4 * 8 * sizeof(float));
+      // copies share their data
+      auto b = a;
+      ASSERT_EQ(backend.liveBytes(), liveBytes + 4 * 8 * sizeof(float));
+      ASSERT_EQ(backend.flops(), flops);
+
+      backend.resetMemMgrPeakBytes(0);
+      auto c = fl::matmul(a, fl::rand({8, 3}));
+      ASSERT_EQ(backend.flops(), flops + 2 * 4 * 3 * 8);
+      ASSERT_EQ(
+          backend.getMemMgrPeakBytes(0),
+          liveBytes + (4 * 8 + 8 * 3 + 4 * 3) * sizeof(float));
+      c += 1;
+      ASSERT_EQ(backend.flops(), flops + 2 * 4 * 3 * 8 + 4 * 3);
+    }
+    ASSERT_EQ(backend.liveBytes(), liveBytes);
+  });
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
@@ -11,10 +11,11 @@
 
 #include "flashlight/fl/tensor/Compute.h"
 
-#include <cublas_v2.h> // this must proceed `af/cuda.h` for some reason
-#include <af/cuda.h>
-#include <af/device.h>
-#include <cuda.h> // Driver API needed for CUcontext
+#if FL_BACKEND_CUDA
+  #include <cublas_v2.h> // this must proceed `af/cuda.h` for some reason
+  #include <af/cuda.h>
+  #include <af/device.h>
+  #include <cuda.h> // Driver API needed for CUcontext
 
 std::unordered_map<void*, fl::Tensor> memory;
 
@@ -142,6 +143,8 @@ int halide_get_gpu_device(void* /* user_context */) {
 
 } // extern "C"
 
+#endif // FL_BACKEND_CUDA
+
 namespace fl {
 namespace pkg {
 namespace halide {
@@ -212,6 +215,62 @@ fl::dtype halideRuntimeTypeToFlType(halide_type_t type) {
           "halideRuntimeTypeToFlType: unsupported or unknown Halide type");
   }
 }
+
+halide_type_t flToHalideRuntimeType(fl::dtype type) {
+  switch (type) {
+    case fl::dtype::f16:
+      return halide_type_t(halide_type_float, 16);
+    case fl::dtype::f32:
+      return halide_type_t(halide_type_float, 32);
+    case fl::dtype::f64:
+      return halide_type_t(halide_type_float, 64);
+    case fl::dtype::bf16:
+      return halide_type_t(halide_type_bfloat, 16);
+    case fl::dtype::b8:
+      return halide_type_t(halide_type_uint, 1);
+    case fl::dtype::s16:
+      return halide_type_t(halide_type_int, 16);
+    case fl::dtype::s32:
+      return halide_type_t(halide_type_int, 32);
+    case fl::dtype::s64:
+      return halide_type_t(halide_type_int, 64);
+    case fl::dtype::u8:
+      return halide_type_t(halide_type_uint, 8);
+    case fl::dtype::u16:
+      return halide_type_t(halide_type_uint, 16);
+    case fl::dtype::u32:
+      return halide_type_t(halide_type_uint, 32);
+    case fl::dtype::u64:
+      return halide_type_t(halide_type_uint, 64);
+    default:
+      throw std::invalid_argument(
+          "flToHalideRuntimeType: unsupported or unknown Flashlight type");
+  }
+}
+
+HalideTensorBuffer::HalideTensorBuffer(const Tensor& tensor)
+    : HalideTensorBuffer(tensor, flToHalideDims(tensor.shape())) {}
+
+HalideTensorBuffer::HalideTensorBuffer(
+    const Tensor& tensor,
+    const std::vector<int>& dims)
+    : devicePtr_(tensor) {
+  const Halide::Type type(flToHalideRuntimeType(tensor.type()));
+  if (tensor.location() == Location::Host) {
+    halideBuffer_ = Halide::Buffer<void>(type, devicePtr_.get(), dims);
+    return;
+  }
+#if FL_BACKEND_CUDA
+  // Without host memory: the pipeline runs on the device
+  halideBuffer_ = Halide::Buffer<void>(type, nullptr, dims);
+  FL_HALIDE_CHECK(halideBuffer_.device_wrap_native(
+      halide_cuda_device_interface(), (uint64_t)devicePtr_.get()));
+  halideBuffer_.set_device_dirty();
+#else
+  throw std::invalid_argument(
+      "HalideTensorBuffer - device tensors require a CUDA build");
+#endif
+}
 } // namespace halide
 } // namespace pkg
 } // namespace fl
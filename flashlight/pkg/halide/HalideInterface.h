@@ -46,6 +46,41 @@ Shape halideToFlDims(const Halide::Buffer<void>& buffer);
 
 fl::dtype halideRuntimeTypeToFlType(halide_type_t type);
 
+/**
+ * Gets the Halide type of the elements of tensors of a Flashlight type.
+ */
+halide_type_t flToHalideRuntimeType(fl::dtype type);
+
+/**
+ * A Halide buffer of the memory of a tensor of any type and backend, which
+ * wraps the memory of the tensor rather than copying it, e.g. to pass tensors
+ * to Halide pipelines. Tensors on the host, e.g. of the oneDNN backend on the
+ * CPU or of the ArrayFire CPU backend, are wrapped as host buffers; device
+ * tensors, e.g. of the ArrayFire CUDA backend, as CUDA device buffers, which
+ * requires a CUDA build.
+ *
+ * The memory of the tensor is locked as long as the buffer lives, as in
+ * HalideBufferWrapper.
+ */
+class HalideTensorBuffer {
+ public:
+  explicit HalideTensorBuffer(const Tensor& tensor);
+
+  /**
+   * Wraps a tensor with given Halide dims rather than its reversed shape,
+   * e.g. its shape as is, such that Halide dim i is dim i of the tensor.
+   */
+  HalideTensorBuffer(const Tensor& tensor, const std::vector<int>& dims);
+
+  Halide::Buffer<void>& getBuffer() {
+    return halideBuffer_;
+  }
+
+ private:
+  DevicePtr devicePtr_;
+  Halide::Buffer<void> halideBuffer_;
+};
+
 /**
  * A thin wrapper around an ArrayFire array as converted to a Halide buffer.
  *
@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/halide/HalideKernel.h"
+
+#include <stdexcept>
+#include <unordered_map>
+
+#include "flashlight/fl/tensor/TensorBackend.h"
+#include "flashlight/pkg/halide/HalideInterface.h"
+
+namespace fl {
+namespace pkg {
+namespace halide {
+
+namespace {
+
+halide_scalar_value_t toScalarValue(double value, halide_type_t type) {
+  halide_scalar_value_t scalar{};
+  switch (type.code) {
+    case halide_type_float:
+      if (type.bits == 32) {
+        scalar.u.f32 = static_cast<float>(value);
+        return scalar;
+      } else if (type.bits == 64) {
+        scalar.u.f64 = value;
+        return scalar;
+      }
+      break;
+    case halide_type_int:
+      switch (type.bits) {
+        case 8:
+          scalar.u.i8 = static_cast<int8_t>(value);
+          return scalar;
+        case 16:
+          scalar.u.i16 = static_cast<int16_t>(value);
+          return scalar;
+        case 32:
+          scalar.u.i32 = static_cast<int32_t>(value);
+          return scalar;
+        case 64:
+          scalar.u.i64 = static_cast<int64_t>(value);
+          return scalar;
+      }
+      break;
+    case halide_type_uint:
+      switch (type.bits) {
+        case 1:
+          scalar.u.b = value != 0;
+          return scalar;
+        case 8:
+          scalar.u.u8 = static_cast<uint8_t>(value);
+          return scalar;
+        case 16:
+          scalar.u.u16 = static_cast<uint16_t>(value);
+          return scalar;
+        case 32:
+          scalar.u.u32 = static_cast<uint32_t>(value);
+          return scalar;
+        case 64:
+          scalar.u.u64 = static_cast<uint64_t>(value);
+          return scalar;
+      }
+      break;
+    default:
+      break;
+  }
+  throw std::invalid_argument(
+      "AOTHalidePipeline::run - unsupported scalar argument type");
+}
+
+void setScalar(Halide::Param<void>& param, double value) {
+  const auto type = param.type();
+  if (type == Halide::Float(32)) {
+    param.set(static_cast<float>(value));
+  } else if (type == Halide::Float(64)) {
+    param.set(value);
+  } else if (type == Halide::Bool()) {
+    param.set(value != 0);
+  } else if (type == Halide::Int(8)) {
+    param.set(static_cast<int8_t>(value));
+  } else if (type == Halide::Int(16)) {
+    param.set(static_cast<int16_t>(value));
+  } else if (type == Halide::Int(32)) {
+    param.set(static_cast<int32_t>(value));
+  } else if (type == Halide::Int(64)) {
+    param.set(static_cast<int64_t>(value));
+  } else if (type == Halide::UInt(8)) {
+    param.set(static_cast<uint8_t>(value));
+  } else if (type == Halide::UInt(16)) {
+    param.set(static_cast<uint16_t>(value));
+  } else if (type == Halide::UInt(32)) {
+    param.set(static_cast<uint32_t>(value));
+  } else if (type == Halide::UInt(64)) {
+    param.set(static_cast<uint64_t>(value));
+  } else {
+    throw std::invalid_argument(
+        "JITHalidePipeline::run - unsupported scalar parameter type");
+  }
+}
+
+void checkArgumentCount(
+    const std::string& func,
+    const std::string& kind,
+    size_t expected,
+    size_t actual) {
+  if (expected != actual) {
+    throw std::invalid_argument(
+        func + " - the pipeline expects " + std::to_string(expected) + " " +
+        kind + ", got " + std::to_string(actual));
+  }
+}
+
+struct KernelRegistry {
+  std::mutex mutex;
+  std::unordered_map<std::string, HalideKernel> kernels;
+};
+
+KernelRegistry& kernelRegistry() {
+  static KernelRegistry registry;
+  return registry;
+}
+
+HalideKernel getKernel(const std::string& name) {
+  auto& registry = kernelRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto it = registry.kernels.find(name);
+  if (it == registry.kernels.end()) {
+    throw std::invalid_argument(
+        "Halide kernel '" + name + "' is not registered");
+  }
+  return it->second;
+}
+
+std::vector<Tensor> runPipeline(
+    HalidePipeline& pipeline,
+    const std::vector<Tensor>& inputs,
+    const std::vector<double>& scalars,
+    const std::vector<std::pair<Shape, fl::dtype>>& outputs) {
+  if (inputs.empty()) {
+    throw std::invalid_argument(
+        "runHalideKernel - Halide kernels expect at least one input");
+  }
+  return inputs.front().backend().getExtension<HalideExtension>().run(
+      pipeline, inputs, scalars, outputs);
+}
+
+} // namespace
+
+AOTHalidePipeline::AOTHalidePipeline(
+    ArgvFunc func,
+    const halide_filter_metadata_t* metadata)
+    : func_(func), metadata_(metadata) {
+  if (!func_ || !metadata_) {
+    throw std::invalid_argument(
+        "AOTHalidePipeline::AOTHalidePipeline - "
+        "expects a pipeline and its metadata");
+  }
+}
+
+void AOTHalidePipeline::run(
+    std::vector<Halide::Buffer<void>>& inputs,
+    const std::vector<double>& scalars,
+    std::vector<Halide::Buffer<void>>& outputs) {
+  const int nArgs = metadata_->num_arguments;
+  std::vector<void*> args(nArgs);
+  // the arguments point to them, so they mustn't reallocate
+  std::vector<halide_scalar_value_t> scalarValues;
+  scalarValues.reserve(nArgs);
+  size_t nInputs = 0, nScalars = 0, nOutputs = 0;
+  for (int i = 0; i < nArgs; ++i) {
+    const auto& arg = metadata_->arguments[i];
+    switch (arg.kind) {
+      case halide_argument_kind_input_scalar:
+        if (arg.type.code == halide_type_handle) {
+          // e.g. the user context, which the runtime hooks don't use
+          scalarValues.emplace_back();
+          scalarValues.back().u.handle = nullptr;
+        } else {
+          if (nScalars >= scalars.size()) {
+            throw std::invalid_argument(
+                "AOTHalidePipeline::run - missing scalar argument " +
+                std::string(arg.name));
+          }
+          scalarValues.push_back(toScalarValue(scalars[nScalars++], arg.type));
+        }
+        args[i] = &scalarValues.back();
+        break;
+      case halide_argument_kind_input_buffer:
+        if (nInputs >= inputs.size()) {
+          throw std::invalid_argument(
+              "AOTHalidePipeline::run - missing input buffer " +
+              std::string(arg.name));
+        }
+        args[i] = inputs[nInputs++].raw_buffer();
+        break;
+      case halide_argument_kind_output_buffer:
+        if (nOutputs >= outputs.size()) {
+          throw std::invalid_argument(
+              "AOTHalidePipeline::run - missing output buffer " +
+              std::string(arg.name));
+        }
+        args[i] = outputs[nOutputs++].raw_buffer();
+        break;
+    }
+  }
+  checkArgumentCount(
+      "AOTHalidePipeline::run", "inputs", nInputs, inputs.size());
+  checkArgumentCount(
+      "AOTHalidePipeline::run", "scalars", nScalars, scalars.size());
+  checkArgumentCount(
+      "AOTHalidePipeline::run", "outputs", nOutputs, outputs.size());
+  const int err = func_(args.data());
+  FL_HALIDE_CHECK(err);
+}
+
+JITHalidePipeline::JITHalidePipeline(
+    Halide::Pipeline pipeline,
+    std::vector<Halide::ImageParam> inputs,
+    std::vector<Halide::Param<void>> scalars /* = {} */,
+    const Halide::Target& target /* = get_jit_target_from_environment() */,
+    const std::string& autoscheduler /* = "" */)
+    : pipeline_(std::move(pipeline)),
+      inputs_(std::move(inputs)),
+      scalars_(std::move(scalars)),
+      target_(target) {
+  if (!autoscheduler.empty()) {
+#if HALIDE_VERSION_MAJOR >= 15
+    pipeline_.apply_autoscheduler(
+        target_, Halide::AutoschedulerParams(autoscheduler));
+#else
+    pipeline_.auto_schedule(autoscheduler, target_);
+#endif
+  }
+  pipeline_.compile_jit(target_);
+}
+
+void JITHalidePipeline::run(
+    std::vector<Halide::Buffer<void>>& inputs,
+    const std::vector<double>& scalars,
+    std::vector<Halide::Buffer<void>>& outputs) {
+  checkArgumentCount(
+      "JITHalidePipeline::run", "inputs", inputs_.size(), inputs.size());
+  checkArgumentCount(
+      "JITHalidePipeline::run", "scalars", scalars_.size(), scalars.size());
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    inputs_[i].set(inputs[i]);
+  }
+  for (size_t i = 0; i < scalars.size(); ++i) {
+    setScalar(scalars_[i], scalars[i]);
+  }
+  Halide::Realization realization(outputs);
+  pipeline_.realize(realization, target_);
+  // unbinds the inputs, which don't outlive the run
+  for (auto& input : inputs_) {
+    input.reset();
+  }
+}
+
+bool HalideExtension::isDataTypeSupported(const fl::dtype& /* dtype */) const {
+  // types are checked against those of the pipeline when run
+  return true;
+}
+
+std::vector<Tensor> HalideExtension::run(
+    HalidePipeline& pipeline,
+    const std::vector<Tensor>& inputs,
+    const std::vector<double>& scalars,
+    const std::vector<std::pair<Shape, fl::dtype>>& outputs) {
+  std::vector<Tensor> results;
+  results.reserve(outputs.size());
+  for (const auto& [shape, type] : outputs) {
+    Tensor result(shape, type);
+    if (!inputs.empty() &&
+        result.backendType() != inputs.front().backendType()) {
+      // on the backend of the inputs, rather than the default one
+      result = inputs.front().backend().full(shape, 0, type);
+    }
+    results.push_back(std::move(result));
+  }
+
+  // the wrappers lock the memory of the tensors while the pipeline runs
+  std::vector<HalideTensorBuffer> inputWrappers;
+  std::vector<Halide::Buffer<void>> inputBuffers;
+  inputWrappers.reserve(inputs.size());
+  for (const auto& input : inputs) {
+    inputWrappers.emplace_back(input);
+    inputBuffers.push_back(inputWrappers.back().getBuffer());
+  }
+  std::vector<HalideTensorBuffer> outputWrappers;
+  std::vector<Halide::Buffer<void>> outputBuffers;
+  outputWrappers.reserve(results.size());
+  for (const auto& result : results) {
+    outputWrappers.emplace_back(result);
+    outputBuffers.push_back(outputWrappers.back().getBuffer());
+  }
+  pipeline.run(inputBuffers, scalars, outputBuffers);
+  return results;
+}
+
+void registerHalideKernel(const std::string& name, HalideKernel kernel) {
+  if (!kernel.forward) {
+    throw std::invalid_argument(
+        "registerHalideKernel - kernel '" + name + "' has no forward pipeline");
+  }
+  auto& registry = kernelRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (!registry.kernels.emplace(name, std::move(kernel)).second) {
+    throw std::invalid_argument(
+        "registerHalideKernel - kernel '" + name + "' is already registered");
+  }
+}
+
+bool isHalideKernelRegistered(const std::string& name) {
+  auto& registry = kernelRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  return registry.kernels.count(name) > 0;
+}
+
+std::vector<Tensor> runHalideKernel(
+    const std::string& name,
+    const std::vector<Tensor>& inputs,
+    const std::vector<double>& scalars /* = {} */) {
+  auto kernel = getKernel(name);
+  std::vector<std::pair<Shape, fl::dtype>> outputs;
+  if (kernel.outputs) {
+    outputs = kernel.outputs(inputs);
+  } else if (!inputs.empty()) {
+    outputs = {{inputs.front().shape(), inputs.front().type()}};
+  }
+  return runPipeline(*kernel.forward, inputs, scalars, outputs);
+}
+
+Variable halideKernel(
+    const std::string& name,
+    const std::vector<Variable>& inputs,
+    const std::vector<double>& scalars /* = {} */) {
+  std::vector<Tensor> tensors;
+  tensors.reserve(inputs.size());
+  for (const auto& input : inputs) {
+    tensors.push_back(input.tensor());
+  }
+  auto outputs = runHalideKernel(name, tensors, scalars);
+  if (outputs.size() != 1) {
+    throw std::invalid_argument(
+        "halideKernel - kernel '" + name + "' has " +
+        std::to_string(outputs.size()) +
+        " outputs, autograd ops have one: use runHalideKernel instead");
+  }
+  auto backward = getKernel(name).backward;
+  auto gradFunc = [name, backward, scalars](
+                      std::vector<Variable>& inputs,
+                      const Variable& gradOutput) {
+    if (!backward) {
+      throw std::runtime_error(
+          "halideKernel - kernel '" + name + "' has no backward pipeline");
+    }
+    std::vector<Tensor> args;
+    std::vector<std::pair<Shape, fl::dtype>> grads;
+    for (const auto& input : inputs) {
+      args.push_back(input.tensor());
+      grads.emplace_back(input.shape(), input.type());
+    }
+    args.push_back(gradOutput.tensor());
+    auto inputGrads = runPipeline(*backward, args, scalars, grads);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      inputs[i].addGrad(Variable(inputGrads[i], false));
+    }
+  };
+  return Variable(outputs.front(), inputs, gradFunc);
+}
+
+/****************** Halide Extension Registration ******************/
+
+#if FL_USE_ARRAYFIRE
+FL_REGISTER_TENSOR_EXTENSION(HalideExtension, ArrayFire);
+#endif // FL_USE_ARRAYFIRE
+
+#if FL_USE_ONEDNN
+FL_REGISTER_TENSOR_EXTENSION(HalideExtension, OneDnn);
+#endif // FL_USE_ONEDNN
+
+} // namespace halide
+} // namespace pkg
+} // namespace fl
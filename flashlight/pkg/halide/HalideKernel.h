@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Halide.h>
+#include <HalideRuntime.h>
+
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/TensorExtension.h"
+
+namespace fl {
+namespace pkg {
+namespace halide {
+
+/**
+ * A Halide pipeline run on tensors. Its buffer arguments are the inputs and
+ * the outputs, in the order the pipeline declares them, and its scalar
+ * arguments are passed as doubles, converted to the types it declares.
+ *
+ * Pipelines compiled for the host run on host tensors, e.g. of the oneDNN
+ * backend, and those compiled for CUDA on device tensors, e.g. of the
+ * ArrayFire CUDA backend.
+ */
+class HalidePipeline {
+ public:
+  virtual ~HalidePipeline() = default;
+
+  /**
+   * Runs the pipeline.
+   *
+   * @param[in] inputs the buffers of the inputs
+   * @param[in] scalars the values of the scalar arguments
+   * @param[in] outputs the buffers of the outputs, written by the pipeline
+   */
+  virtual void run(
+      std::vector<Halide::Buffer<void>>& inputs,
+      const std::vector<double>& scalars,
+      std::vector<Halide::Buffer<void>>& outputs) = 0;
+};
+
+/**
+ * A pipeline compiled ahead of time, e.g. with `fl_add_halide_lib`, called
+ * through the `argv` entry point and metadata that Halide generates with it.
+ *
+ * Example, for a pipeline generated as `myFunc`:
+ * \code
+   auto pipeline =
+       std::make_shared<AOTHalidePipeline>(myFunc_argv, myFunc_metadata());
+ * \endcode
+ */
+class AOTHalidePipeline : public HalidePipeline {
+ public:
+  using ArgvFunc = int (*)(void**);
+
+  AOTHalidePipeline(ArgvFunc func, const halide_filter_metadata_t* metadata);
+
+  void run(
+      std::vector<Halide::Buffer<void>>& inputs,
+      const std::vector<double>& scalars,
+      std::vector<Halide::Buffer<void>>& outputs) override;
+
+ private:
+  ArgvFunc func_;
+  const halide_filter_metadata_t* metadata_;
+};
+
+/**
+ * A pipeline compiled just in time, once, when constructed. It's scheduled
+ * with an autoscheduler if one is named, e.g. "Adams2019", which requires its
+ * plugin to be loaded with `Halide::load_plugin` and estimates to be set on
+ * the inputs and outputs of the pipeline.
+ *
+ * Runs are serialized, since they bind the parameters of the pipeline.
+ */
+class JITHalidePipeline : public HalidePipeline {
+ public:
+  /**
+   * @param[in] pipeline the pipeline, whose outputs are the outputs
+   * @param[in] inputs the parameters of the input buffers
+   * @param[in] scalars the parameters of the scalar arguments
+   * @param[in] target the target to compile the pipeline for
+   * @param[in] autoscheduler the name of the autoscheduler, if any
+   */
+  JITHalidePipeline(
+      Halide::Pipeline pipeline,
+      std::vector<Halide::ImageParam> inputs,
+      std::vector<Halide::Param<void>> scalars = {},
+      const Halide::Target& target = Halide::get_jit_target_from_environment(),
+      const std::string& autoscheduler = "");
+
+  void run(
+      std::vector<Halide::Buffer<void>>& inputs,
+      const std::vector<double>& scalars,
+      std::vector<Halide::Buffer<void>>& outputs) override;
+
+ private:
+  Halide::Pipeline pipeline_;
+  std::vector<Halide::ImageParam> inputs_;
+  std::vector<Halide::Param<void>> scalars_;
+  Halide::Target target_;
+  std::mutex mutex_;
+};
+
+/**
+ * A custom op computed by Halide pipelines.
+ */
+struct HalideKernel {
+  /** The shapes and types of the outputs of the op. */
+  using OutputsFunc = std::function<std::vector<std::pair<Shape, fl::dtype>>(
+      const std::vector<Tensor>& inputs)>;
+
+  /** Computes the outputs from the inputs. */
+  std::shared_ptr<HalidePipeline> forward;
+  /**
+   * The outputs of the op for given inputs. By default, a single output of
+   * the shape and type of the first input, e.g. for elementwise ops.
+   */
+  OutputsFunc outputs;
+  /**
+   * Computes the gradients of the inputs, from the inputs followed by the
+   * gradient of the output, if the op is differentiable. Gets the scalars of
+   * the forward.
+   */
+  std::shared_ptr<HalidePipeline> backward;
+};
+
+/**
+ * Runs Halide pipelines on the tensors of a backend.
+ */
+class HalideExtension : public TensorExtension<HalideExtension> {
+ public:
+  static constexpr TensorExtensionType extensionType =
+      TensorExtensionType::Halide;
+
+  HalideExtension() = default;
+  virtual ~HalideExtension() = default;
+
+  bool isDataTypeSupported(const fl::dtype& dtype) const override;
+
+  /**
+   * Runs a pipeline, allocating its outputs on the backend of the inputs.
+   *
+   * @param[in] pipeline the pipeline
+   * @param[in] inputs the inputs of the pipeline
+   * @param[in] scalars the scalar arguments of the pipeline
+   * @param[in] outputs the shapes and types of the outputs
+   * @return the outputs
+   */
+  virtual std::vector<Tensor> run(
+      HalidePipeline& pipeline,
+      const std::vector<Tensor>& inputs,
+      const std::vector<double>& scalars,
+      const std::vector<std::pair<Shape, fl::dtype>>& outputs);
+};
+
+/**
+ * Registers a kernel under a name, for runs with `runHalideKernel` and
+ * `halideKernel`. Throws if a kernel of the same name was registered.
+ *
+ * Example:
+ * \code
+   Halide::ImageParam input(Halide::Float(32), 1);
+   Halide::Func scaled;
+   Halide::Var x;
+   scaled(x) = input(x) * 2;
+   Halide::ImageParam gradOutput(Halide::Float(32), 1);
+   Halide::Func gradInput;
+   gradInput(x) = gradOutput(x) * 2;
+
+   HalideKernel kernel;
+   kernel.forward = std::make_shared<JITHalidePipeline>(
+       Halide::Pipeline(scaled), std::vector<Halide::ImageParam>{input});
+   kernel.backward = std::make_shared<JITHalidePipeline>(
+       Halide::Pipeline(gradInput),
+       std::vector<Halide::ImageParam>{input, gradOutput});
+   registerHalideKernel("scale", kernel);
+   auto output = halideKernel("scale", {x});
+ * \endcode
+ */
+void registerHalideKernel(const std::string& name, HalideKernel kernel);
+
+/** @return whether a kernel was registered under a name. */
+bool isHalideKernelRegistered(const std::string& name);
+
+/**
+ * Runs a registered kernel on tensors, with the `HalideExtension` of the
+ * backend of the tensors.
+ *
+ * @param[in] name the name of the kernel
+ * @param[in] inputs the inputs of the kernel
+ * @param[in] scalars the scalar arguments of the kernel
+ * @return the outputs of the kernel
+ */
+std::vector<Tensor> runHalideKernel(
+    const std::string& name,
+    const std::vector<Tensor>& inputs,
+    const std::vector<double>& scalars = {});
+
+/**
+ * Applies a registered kernel of a single output as an autograd op, whose
+ * gradients are computed by the backward pipeline of the kernel. Throws on
+ * backward if the kernel has none.
+ *
+ * @param[in] name the name of the kernel
+ * @param[in] inputs the inputs of the kernel
+ * @param[in] scalars the scalar arguments of the kernel
+ * @return the output of the kernel
+ */
+Variable halideKernel(
+    const std::string& name,
+    const std::vector<Variable>& inputs,
+    const std::vector<double>& scalars = {});
+
+} // namespace halide
+} // namespace pkg
+} // namespace fl
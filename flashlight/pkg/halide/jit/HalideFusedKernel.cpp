@@ -0,0 +1,835 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/halide/jit/HalideFusedKernel.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include <Halide.h>
+
+#include "flashlight/pkg/halide/HalideInterface.h"
+
+namespace fl {
+namespace pkg {
+namespace halide {
+
+namespace {
+
+// Number of elements each parallel task of the default host schedule
+// computes, and the vector width it computes them with.
+constexpr Dim kParallelTaskSize = 16384;
+constexpr int kVectorSize = 8;
+// Number of threads of each GPU block of the default CUDA schedule.
+constexpr int kGpuBlockSize = 256;
+
+using Instruction = HalideFusedKernel::Instruction;
+using OpCode = HalideFusedKernel::OpCode;
+using ScalarValue = HalideFusedKernel::ScalarValue;
+
+struct KernelCache {
+  std::mutex mutex;
+  std::unordered_map<std::string, std::shared_ptr<const HalideFusedKernel>>
+      signatureToKernel;
+
+  static KernelCache& getInstance() {
+    static KernelCache cache;
+    return cache;
+  }
+};
+
+bool isFpType(const dtype type) {
+  return type == dtype::f32 || type == dtype::f64;
+}
+
+// Halide emulates f16/bf16 on most targets, and rounds them differently
+// than backends do, so pipelines don't compute in them.
+bool isSupportedType(const dtype type) {
+  return type != dtype::f16 && type != dtype::bf16;
+}
+
+template <typename T>
+T castScalar(const ScalarValue& value) {
+  return std::visit([](auto&& val) { return static_cast<T>(val); }, value);
+}
+
+Halide::Type toHalideType(const dtype type) {
+  return Halide::Type(flToHalideRuntimeType(type));
+}
+
+std::vector<int> toHalideDims(const Shape& shape) {
+  std::vector<int> dims;
+  for (const auto dim : shape.get()) {
+    dims.push_back(static_cast<int>(dim));
+  }
+  return dims;
+}
+
+Halide::Region toHalideRegion(const Shape& shape) {
+  Halide::Region region;
+  for (const auto dim : shape.get()) {
+    region.emplace_back(0, static_cast<int>(dim));
+  }
+  return region;
+}
+
+std::optional<dtype> getUnaryType(const UnaryOp op, const dtype type) {
+  switch (op) {
+    case UnaryOp::Exp:
+    case UnaryOp::Log:
+    case UnaryOp::Sin:
+    case UnaryOp::Cos:
+    case UnaryOp::Sqrt:
+    case UnaryOp::Tanh:
+    case UnaryOp::Floor:
+    case UnaryOp::Ceil:
+    case UnaryOp::Rint:
+    case UnaryOp::Sigmoid:
+      return isFpType(type) ? std::optional<dtype>(type) : std::nullopt;
+    case UnaryOp::Negative:
+    case UnaryOp::Absolute:
+    case UnaryOp::Sign:
+      return type != dtype::b8 ? std::optional<dtype>(type) : std::nullopt;
+    case UnaryOp::LogicalNot:
+      return dtype::b8;
+    case UnaryOp::IsNan:
+    case UnaryOp::IsInf:
+      return isFpType(type) ? std::optional<dtype>(dtype::b8) : std::nullopt;
+    case UnaryOp::Log1p:
+    case UnaryOp::Erf:
+      return std::nullopt;
+  }
+  return std::nullopt;
+}
+
+std::optional<dtype> getReductionType(const ReductionOp op, const dtype type) {
+  switch (op) {
+    case ReductionOp::Min:
+    case ReductionOp::Max:
+      return type != dtype::b8 ? std::optional<dtype>(type) : std::nullopt;
+    case ReductionOp::Sum:
+      // backends accumulate narrow integers in wider types
+      return isFpType(type) || getTypeSize(type) >= 4 ? std::optional(type)
+                                                      : std::nullopt;
+    case ReductionOp::Mean:
+      return isFpType(type) ? std::optional<dtype>(type) : std::nullopt;
+  }
+  return std::nullopt;
+}
+
+Halide::Expr lowerUnaryOp(const UnaryOp op, const Halide::Expr& e) {
+  const auto zero = Halide::cast(e.type(), 0);
+  switch (op) {
+    case UnaryOp::Exp:
+      return Halide::exp(e);
+    case UnaryOp::Log:
+      return Halide::log(e);
+    case UnaryOp::Negative:
+      return -e;
+    case UnaryOp::LogicalNot:
+      return e == zero;
+    case UnaryOp::Sin:
+      return Halide::sin(e);
+    case UnaryOp::Cos:
+      return Halide::cos(e);
+    case UnaryOp::Sqrt:
+      return Halide::sqrt(e);
+    case UnaryOp::Tanh:
+      return Halide::tanh(e);
+    case UnaryOp::Floor:
+      return Halide::floor(e);
+    case UnaryOp::Ceil:
+      return Halide::ceil(e);
+    case UnaryOp::Rint:
+      // ties to even, like rint
+      return Halide::round(e);
+    case UnaryOp::Absolute:
+      // abs of signed integers is unsigned in Halide
+      return Halide::cast(e.type(), Halide::abs(e));
+    case UnaryOp::Sigmoid:
+      return 1 / (1 + Halide::exp(-e));
+    case UnaryOp::IsNan:
+      return Halide::is_nan(e);
+    case UnaryOp::IsInf:
+      return Halide::is_inf(e);
+    case UnaryOp::Sign:
+      return Halide::select(
+          e > zero,
+          Halide::cast(e.type(), 1),
+          e < zero,
+          Halide::cast(e.type(), -1),
+          zero);
+    case UnaryOp::Log1p:
+    case UnaryOp::Erf:
+      break;
+  }
+  throw std::runtime_error("[lowerUnaryOp] Unsupported unary operation type");
+}
+
+Halide::Expr lowerBinaryOp(
+    const BinaryOp op,
+    const Halide::Expr& lhs,
+    const Halide::Expr& rhs) {
+  switch (op) {
+    case BinaryOp::Add:
+      return lhs + rhs;
+    case BinaryOp::Sub:
+      return lhs - rhs;
+    case BinaryOp::Mul:
+      return lhs * rhs;
+    case BinaryOp::Div:
+      return lhs / rhs;
+  }
+  throw std::runtime_error("[lowerBinaryOp] Unknown binary operation type");
+}
+
+void setScalar(
+    Halide::Param<void>& param,
+    const dtype type,
+    const ScalarValue& value) {
+  switch (type) {
+    case dtype::f32:
+      return param.set(castScalar<float>(value));
+    case dtype::f64:
+      return param.set(castScalar<double>(value));
+    case dtype::b8:
+      return param.set(castScalar<bool>(value));
+    case dtype::s16:
+      return param.set(castScalar<int16_t>(value));
+    case dtype::s32:
+      return param.set(castScalar<int32_t>(value));
+    case dtype::s64:
+      return param.set(castScalar<int64_t>(value));
+    case dtype::u8:
+      return param.set(castScalar<uint8_t>(value));
+    case dtype::u16:
+      return param.set(castScalar<uint16_t>(value));
+    case dtype::u32:
+      return param.set(castScalar<uint32_t>(value));
+    case dtype::u64:
+      return param.set(castScalar<uint64_t>(value));
+    case dtype::f16:
+    case dtype::bf16:
+      break;
+  }
+  throw std::runtime_error("[setScalar] Unsupported scalar type");
+}
+
+// Computes all elements of `func` in a single loop, split into parallel
+// vectorized tasks on the host, or into blocks of threads on the GPU.
+void scheduleDefault(
+    Halide::Func& func,
+    const std::vector<Halide::Var>& vars,
+    const Shape& shape,
+    const bool gpu) {
+  const int ndim = shape.ndim();
+  if (ndim == 0) {
+    if (gpu) {
+      func.gpu_single_thread();
+    }
+    return;
+  }
+  Halide::Var fused = vars[0];
+  for (int i = 1; i < ndim; i++) {
+    Halide::Var next;
+    func.fuse(fused, vars[i], next);
+    fused = next;
+  }
+  const auto tail = Halide::TailStrategy::GuardWithIf;
+  if (gpu) {
+    Halide::Var block, thread;
+    func.gpu_tile(fused, block, thread, kGpuBlockSize, tail);
+    return;
+  }
+  const auto elements = shape.elements();
+  if (elements > kParallelTaskSize) {
+    Halide::Var task, element;
+    func.split(fused, task, element, kParallelTaskSize, tail)
+        .parallel(task)
+        .vectorize(element, kVectorSize, tail);
+  } else if (elements >= kVectorSize) {
+    func.vectorize(fused, kVectorSize, tail);
+  }
+}
+
+} // namespace
+
+// A pipeline compiled for some input types and target, and its parameters.
+struct HalideFusedKernel::Pipeline {
+  Halide::Pipeline pipeline;
+  Halide::Target target;
+  std::vector<Halide::ImageParam> inputs;
+  std::vector<Shape> inputShapes;
+  std::vector<Halide::Param<void>> scalars;
+  std::vector<dtype> scalarTypes;
+  // for each window, where it starts along each dim of its operand
+  std::vector<std::vector<Halide::Param<int>>> windowStarts;
+  // runs bind the parameters
+  std::mutex mutex;
+};
+
+HalideFusedKernel::HalideFusedKernel(
+    std::vector<Instruction>&& instructions,
+    const Options& options,
+    std::string&& signature)
+    : instructions_(std::move(instructions)),
+      options_(options),
+      signature_(std::move(signature)) {
+  if (instructions_.empty()) {
+    throw std::invalid_argument(
+        "[HalideFusedKernel::HalideFusedKernel] No instructions");
+  }
+  for (unsigned i = 0; i < instructions_.size(); i++) {
+    const auto& instruction = instructions_[i];
+    switch (instruction.opCode) {
+      case OpCode::Input:
+        numInputs_ = std::max(numInputs_, instruction.operandIdx + 1);
+        break;
+      case OpCode::Scalar:
+        // parameters are created in instruction order
+        if (instruction.operandIdx != numScalars_) {
+          throw std::invalid_argument(
+              "[HalideFusedKernel::HalideFusedKernel] "
+              "Scalars must be indexed in instruction order");
+        }
+        numScalars_++;
+        break;
+      case OpCode::Binary:
+        if (instruction.rhs >= i) {
+          throw std::invalid_argument(
+              "[HalideFusedKernel::HalideFusedKernel] Invalid operand");
+        }
+        [[fallthrough]];
+      case OpCode::Unary:
+      case OpCode::Reduction:
+      case OpCode::Window:
+        if (instruction.lhs >= i) {
+          throw std::invalid_argument(
+              "[HalideFusedKernel::HalideFusedKernel] Invalid operand");
+        }
+        numWindows_ += instruction.opCode == OpCode::Window;
+        break;
+    }
+  }
+}
+
+std::optional<std::vector<dtype>> HalideFusedKernel::getRegisterTypes(
+    const std::vector<const Tensor*>& inputs) const {
+  std::vector<dtype> types;
+  for (const auto& instruction : instructions_) {
+    std::optional<dtype> type;
+    switch (instruction.opCode) {
+      case OpCode::Input:
+        type = inputs.at(instruction.operandIdx)->type();
+        break;
+      case OpCode::Scalar:
+        type = instruction.scalarType;
+        break;
+      case OpCode::Unary:
+        type = getUnaryType(instruction.unaryOp, types[instruction.lhs]);
+        break;
+      case OpCode::Binary: {
+        const auto lhsType = types[instruction.lhs];
+        // backends promote mixed types, and round integer divisions towards
+        // zero rather than down
+        const bool isTyped = lhsType == types[instruction.rhs] &&
+            lhsType != dtype::b8 &&
+            (instruction.binaryOp != BinaryOp::Div || isFpType(lhsType));
+        if (isTyped) {
+          type = lhsType;
+        }
+        break;
+      }
+      case OpCode::Reduction:
+        type =
+            getReductionType(instruction.reductionOp, types[instruction.lhs]);
+        break;
+      case OpCode::Window:
+        type = types[instruction.lhs];
+        break;
+    }
+    if (!type.has_value() || !isSupportedType(type.value())) {
+      return std::nullopt;
+    }
+    types.push_back(type.value());
+  }
+  return types;
+}
+
+std::shared_ptr<HalideFusedKernel::Pipeline>
+HalideFusedKernel::getOrCompilePipeline(
+    const std::vector<dtype>& types,
+    const Location location) const {
+  std::ostringstream oss;
+  oss << (location == Location::Host ? "host" : "device");
+  for (const auto type : types) {
+    oss << "," << type;
+  }
+  const auto key = oss.str();
+  std::lock_guard<std::mutex> lock(pipelinesMutex_);
+  auto iter = pipelines_.find(key);
+  if (iter == pipelines_.end()) {
+    iter = pipelines_.emplace(key, compile(types, location)).first;
+  }
+  return iter->second;
+}
+
+std::shared_ptr<HalideFusedKernel::Pipeline> HalideFusedKernel::compile(
+    const std::vector<dtype>& types,
+    const Location location) const {
+  auto pipeline = std::make_shared<Pipeline>();
+  pipeline->target = Halide::get_jit_target_from_environment();
+  if (location == Location::Device) {
+#if FL_BACKEND_CUDA
+    pipeline->target = pipeline->target.with_feature(Halide::Target::CUDA);
+#else
+    return nullptr;
+#endif
+  }
+  const bool gpu = pipeline->target.has_gpu_feature();
+
+  int maxNdim = 0;
+  for (const auto& instruction : instructions_) {
+    maxNdim = std::max(maxNdim, instruction.shape.ndim());
+  }
+  std::vector<Halide::Var> vars;
+  for (int i = 0; i < maxNdim; i++) {
+    vars.emplace_back("d" + std::to_string(i));
+  }
+  // read register `reg` at the coordinates of a result of shape `shape`,
+  // i.e., broadcast it along its dims of size 1
+  std::vector<Halide::Func> funcs;
+  const auto read = [&](unsigned reg, const Shape& shape) {
+    const auto& regShape = instructions_[reg].shape;
+    std::vector<Halide::Expr> args;
+    for (int i = 0; i < regShape.ndim(); i++) {
+      const bool isBroadcast = regShape.dim(i) == 1 && shape.dim(i) != 1;
+      args.push_back(isBroadcast ? Halide::Expr(0) : Halide::Expr(vars[i]));
+    }
+    return funcs[reg](args);
+  };
+
+  pipeline->inputs.resize(numInputs_);
+  pipeline->inputShapes.resize(numInputs_);
+  for (unsigned i = 0; i < instructions_.size(); i++) {
+    const auto& instruction = instructions_[i];
+    const auto& shape = instruction.shape;
+    const std::vector<Halide::Var> funcVars(
+        vars.begin(), vars.begin() + shape.ndim());
+    Halide::Func func("r" + std::to_string(i));
+    switch (instruction.opCode) {
+      case OpCode::Input: {
+        auto& input = pipeline->inputs[instruction.operandIdx];
+        if (!input.defined()) {
+          input = Halide::ImageParam(
+              toHalideType(types[i]),
+              shape.ndim(),
+              "in" + std::to_string(instruction.operandIdx));
+          pipeline->inputShapes[instruction.operandIdx] = shape;
+        }
+        func(funcVars) =
+            input(std::vector<Halide::Expr>(funcVars.begin(), funcVars.end()));
+        break;
+      }
+      case OpCode::Scalar:
+        pipeline->scalars.emplace_back(toHalideType(instruction.scalarType));
+        pipeline->scalarTypes.push_back(instruction.scalarType);
+        func(funcVars) = Halide::Expr(pipeline->scalars.back());
+        break;
+      case OpCode::Unary:
+        func(funcVars) =
+            lowerUnaryOp(instruction.unaryOp, read(instruction.lhs, shape));
+        break;
+      case OpCode::Binary:
+        func(funcVars) = lowerBinaryOp(
+            instruction.binaryOp,
+            read(instruction.lhs, shape),
+            read(instruction.rhs, shape));
+        break;
+      case OpCode::Reduction: {
+        const auto& inputShape = instructions_[instruction.lhs].shape;
+        const auto& axes = instruction.axes;
+        Halide::Region region;
+        Dim count = 1;
+        for (const auto axis : axes) {
+          region.emplace_back(0, static_cast<int>(inputShape.dim(axis)));
+          count *= inputShape.dim(axis);
+        }
+        Halide::RDom r(region);
+        std::vector<Halide::Expr> args;
+        unsigned numReduced = 0;
+        int dim = 0;
+        for (int j = 0; j < inputShape.ndim(); j++) {
+          if (numReduced < axes.size() && axes[numReduced] == j) {
+            args.push_back(r[numReduced++]);
+            dim += instruction.keepDims;
+          } else {
+            args.push_back(vars[dim++]);
+          }
+        }
+        const auto value = funcs[instruction.lhs](args);
+        switch (instruction.reductionOp) {
+          case ReductionOp::Min:
+            func(funcVars) = Halide::minimum(value);
+            break;
+          case ReductionOp::Max:
+            func(funcVars) = Halide::maximum(value);
+            break;
+          case ReductionOp::Sum:
+            func(funcVars) = Halide::sum(value);
+            break;
+          case ReductionOp::Mean:
+            func(funcVars) = Halide::sum(value) /
+                Halide::cast(value.type(), static_cast<double>(count));
+            break;
+        }
+        if (options_.autoscheduler.empty() && i + 1 < instructions_.size()) {
+          // rather than recomputed for each element it's broadcast to
+          func.compute_root();
+          scheduleDefault(func, funcVars, shape, gpu);
+        }
+        break;
+      }
+      case OpCode::Window: {
+        const auto& inputShape = instructions_[instruction.lhs].shape;
+        auto& starts = pipeline->windowStarts.emplace_back(inputShape.ndim());
+        std::vector<Halide::Expr> args;
+        for (int j = 0; j < inputShape.ndim(); j++) {
+          const auto windowDim = instruction.windowDims[j];
+          const auto stride = static_cast<int>(instruction.windowStrides[j]);
+          args.push_back(
+              windowDim < 0 ? Halide::Expr(starts[j])
+                            : starts[j] + stride * vars[windowDim]);
+        }
+        func(funcVars) = funcs[instruction.lhs](args);
+        break;
+      }
+    }
+    funcs.push_back(func);
+  }
+
+  auto& output = funcs.back();
+  const auto& outputShape = instructions_.back().shape;
+  pipeline->pipeline = Halide::Pipeline(output);
+  if (options_.autoscheduler.empty()) {
+    scheduleDefault(
+        output,
+        std::vector<Halide::Var>(
+            vars.begin(), vars.begin() + outputShape.ndim()),
+        outputShape,
+        gpu);
+  } else {
+    // the shapes are static, so estimates are exact
+    for (unsigned i = 0; i < numInputs_; i++) {
+      pipeline->inputs[i].set_estimates(
+          toHalideRegion(pipeline->inputShapes[i]));
+    }
+    for (auto& starts : pipeline->windowStarts) {
+      for (auto& start : starts) {
+        start.set_estimate(0);
+      }
+    }
+    output.set_estimates(toHalideRegion(outputShape));
+#if HALIDE_VERSION_MAJOR >= 15
+    pipeline->pipeline.apply_autoscheduler(
+        pipeline->target, Halide::AutoschedulerParams(options_.autoscheduler));
+#else
+    pipeline->pipeline.auto_schedule(
+        options_.autoscheduler, pipeline->target);
+#endif
+  }
+  pipeline->pipeline.compile_jit(pipeline->target);
+  return pipeline;
+}
+
+std::shared_ptr<const HalideFusedKernel> HalideFusedKernel::getOrCreate(
+    std::vector<Instruction>&& instructions,
+    const Options& options /* = {} */) {
+  auto signature = getSignature(instructions, options);
+  auto& cache = KernelCache::getInstance();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  auto iter = cache.signatureToKernel.find(signature);
+  if (iter == cache.signatureToKernel.end()) {
+    // constructor is private, so no `std::make_shared`
+    std::shared_ptr<const HalideFusedKernel> kernel(new HalideFusedKernel(
+        std::move(instructions), options, std::string(signature)));
+    iter = cache.signatureToKernel.emplace(std::move(signature), kernel).first;
+  }
+  return iter->second;
+}
+
+bool HalideFusedKernel::canLower(const UnaryOp op) {
+  return op != UnaryOp::Log1p && op != UnaryOp::Erf;
+}
+
+std::string HalideFusedKernel::getSignature(
+    const std::vector<Instruction>& instructions,
+    const Options& options) {
+  std::ostringstream oss;
+  oss << options.autoscheduler << ":";
+  for (const auto& instruction : instructions) {
+    oss << static_cast<int>(instruction.opCode) << instruction.shape;
+    switch (instruction.opCode) {
+      case OpCode::Input:
+        oss << "#" << instruction.operandIdx;
+        break;
+      case OpCode::Scalar:
+        oss << "#" << instruction.operandIdx << instruction.scalarType;
+        break;
+      case OpCode::Unary:
+        oss << static_cast<int>(instruction.unaryOp) << "(" << instruction.lhs
+            << ")";
+        break;
+      case OpCode::Binary:
+        oss << static_cast<int>(instruction.binaryOp) << "(" << instruction.lhs
+            << "," << instruction.rhs << ")";
+        break;
+      case OpCode::Reduction:
+        oss << static_cast<int>(instruction.reductionOp) << "("
+            << instruction.lhs << ")" << instruction.keepDims;
+        for (const auto axis : instruction.axes) {
+          oss << "," << axis;
+        }
+        break;
+      case OpCode::Window:
+        oss << "(" << instruction.lhs << ")";
+        for (unsigned i = 0; i < instruction.windowDims.size(); i++) {
+          oss << "," << instruction.windowDims[i] << "/"
+              << instruction.windowStrides[i];
+        }
+        break;
+    }
+    oss << ";";
+  }
+  return oss.str();
+}
+
+size_t HalideFusedKernel::numCachedKernels() {
+  auto& cache = KernelCache::getInstance();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  return cache.signatureToKernel.size();
+}
+
+void HalideFusedKernel::clearCache() {
+  auto& cache = KernelCache::getInstance();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.signatureToKernel.clear();
+}
+
+size_t HalideFusedKernel::numCompiledPipelines() const {
+  std::lock_guard<std::mutex> lock(pipelinesMutex_);
+  return std::count_if(
+      pipelines_.begin(), pipelines_.end(), [](const auto& keyAndPipeline) {
+        return keyAndPipeline.second != nullptr;
+      });
+}
+
+const std::string& HalideFusedKernel::signature() const {
+  return signature_;
+}
+
+const std::vector<Instruction>& HalideFusedKernel::instructions() const {
+  return instructions_;
+}
+
+Tensor HalideFusedKernel::runWithBackend(
+    TensorBackend& backend,
+    const std::vector<const Tensor*>& inputs,
+    const std::vector<ScalarValue>& scalars,
+    const std::vector<WindowView>& windows) const {
+  // inputs are referenced as-is, everything else is owned by `results`
+  std::vector<const Tensor*> registers(instructions_.size(), nullptr);
+  std::vector<std::optional<Tensor>> results(instructions_.size());
+  unsigned windowIdx = 0;
+  for (unsigned i = 0; i < instructions_.size(); i++) {
+    const auto& instruction = instructions_[i];
+    const Tensor* lhs = registers[instruction.lhs];
+    const Tensor* rhs = registers[instruction.rhs];
+    switch (instruction.opCode) {
+      case OpCode::Input:
+        registers[i] = inputs.at(instruction.operandIdx);
+        continue;
+      case OpCode::Scalar:
+        results[i] = std::visit(
+            [&](auto&& val) {
+              return backend.full(
+                  instruction.shape, val, instruction.scalarType);
+            },
+            scalars.at(instruction.operandIdx));
+        break;
+      case OpCode::Unary:
+        switch (instruction.unaryOp) {
+          case UnaryOp::Exp:
+            results[i] = backend.exp(*lhs);
+            break;
+          case UnaryOp::Log:
+            results[i] = backend.log(*lhs);
+            break;
+          case UnaryOp::Negative:
+            results[i] = backend.negative(*lhs);
+            break;
+          case UnaryOp::LogicalNot:
+            results[i] = backend.logicalNot(*lhs);
+            break;
+          case UnaryOp::Log1p:
+            results[i] = backend.log1p(*lhs);
+            break;
+          case UnaryOp::Sin:
+            results[i] = backend.sin(*lhs);
+            break;
+          case UnaryOp::Cos:
+            results[i] = backend.cos(*lhs);
+            break;
+          case UnaryOp::Sqrt:
+            results[i] = backend.sqrt(*lhs);
+            break;
+          case UnaryOp::Tanh:
+            results[i] = backend.tanh(*lhs);
+            break;
+          case UnaryOp::Floor:
+            results[i] = backend.floor(*lhs);
+            break;
+          case UnaryOp::Ceil:
+            results[i] = backend.ceil(*lhs);
+            break;
+          case UnaryOp::Rint:
+            results[i] = backend.rint(*lhs);
+            break;
+          case UnaryOp::Absolute:
+            results[i] = backend.absolute(*lhs);
+            break;
+          case UnaryOp::Sigmoid:
+            results[i] = backend.sigmoid(*lhs);
+            break;
+          case UnaryOp::Erf:
+            results[i] = backend.erf(*lhs);
+            break;
+          case UnaryOp::IsNan:
+            results[i] = backend.isnan(*lhs);
+            break;
+          case UnaryOp::IsInf:
+            results[i] = backend.isinf(*lhs);
+            break;
+          case UnaryOp::Sign:
+            results[i] = backend.sign(*lhs);
+            break;
+        }
+        break;
+      case OpCode::Binary:
+        switch (instruction.binaryOp) {
+          case BinaryOp::Add:
+            results[i] = backend.add(*lhs, *rhs);
+            break;
+          case BinaryOp::Sub:
+            results[i] = backend.sub(*lhs, *rhs);
+            break;
+          case BinaryOp::Mul:
+            results[i] = backend.mul(*lhs, *rhs);
+            break;
+          case BinaryOp::Div:
+            results[i] = backend.div(*lhs, *rhs);
+            break;
+        }
+        break;
+      case OpCode::Reduction: {
+        const auto& axes = instruction.axes;
+        const auto keepDims = instruction.keepDims;
+        switch (instruction.reductionOp) {
+          case ReductionOp::Min:
+            results[i] = backend.amin(*lhs, axes, keepDims);
+            break;
+          case ReductionOp::Max:
+            results[i] = backend.amax(*lhs, axes, keepDims);
+            break;
+          case ReductionOp::Sum:
+            results[i] = backend.sum(*lhs, axes, keepDims);
+            break;
+          case ReductionOp::Mean:
+            results[i] = backend.mean(*lhs, axes, keepDims);
+            break;
+        }
+        break;
+      }
+      case OpCode::Window:
+        results[i] = (*lhs)(windows.at(windowIdx++).indices);
+        break;
+    }
+    registers[i] = &results[i].value();
+  }
+  if (!results.back().has_value()) {
+    return registers.back()->copy();
+  }
+  return std::move(results.back().value());
+}
+
+Tensor HalideFusedKernel::run(
+    TensorBackend& backend,
+    const std::vector<const Tensor*>& inputs,
+    const std::vector<ScalarValue>& scalars,
+    const std::vector<WindowView>& windows /* = {} */) const {
+  if (inputs.size() != numInputs_) {
+    throw std::invalid_argument(
+        "[HalideFusedKernel::run] Unexpected number of inputs");
+  }
+  if (scalars.size() != numScalars_) {
+    throw std::invalid_argument(
+        "[HalideFusedKernel::run] Unexpected number of scalars");
+  }
+  if (windows.size() != numWindows_) {
+    throw std::invalid_argument(
+        "[HalideFusedKernel::run] Unexpected number of windows");
+  }
+  const auto types = getRegisterTypes(inputs);
+  if (!types.has_value()) {
+    return runWithBackend(backend, inputs, scalars, windows);
+  }
+  const auto& outputShape = instructions_.back().shape;
+  auto output = backend.full(outputShape, 0, types->back());
+  // the pipeline runs where the output lives
+  const auto location = output.location();
+  for (const auto input : inputs) {
+    if (input->location() != location) {
+      return runWithBackend(backend, inputs, scalars, windows);
+    }
+  }
+  const auto pipeline = getOrCompilePipeline(types.value(), location);
+  if (!pipeline) {
+    return runWithBackend(backend, inputs, scalars, windows);
+  }
+
+  std::lock_guard<std::mutex> lock(pipeline->mutex);
+  // the wrappers lock the memory of the tensors while the pipeline runs
+  std::vector<HalideTensorBuffer> inputBuffers;
+  inputBuffers.reserve(inputs.size());
+  for (unsigned i = 0; i < inputs.size(); i++) {
+    inputBuffers.emplace_back(*inputs[i], toHalideDims(inputs[i]->shape()));
+    pipeline->inputs[i].set(inputBuffers.back().getBuffer());
+  }
+  for (unsigned i = 0; i < scalars.size(); i++) {
+    setScalar(pipeline->scalars[i], pipeline->scalarTypes[i], scalars[i]);
+  }
+  for (unsigned i = 0; i < windows.size(); i++) {
+    const auto& starts = windows[i].starts;
+    for (unsigned j = 0; j < starts.size(); j++) {
+      pipeline->windowStarts[i][j].set(static_cast<int>(starts[j]));
+    }
+  }
+  {
+    HalideTensorBuffer outputBuffer(output, toHalideDims(outputShape));
+    pipeline->pipeline.realize(outputBuffer.getBuffer(), pipeline->target);
+  }
+  // unbind the inputs, which don't outlive the run
+  for (auto& input : pipeline->inputs) {
+    input.reset();
+  }
+  return output;
+}
+
+} // namespace halide
+} // namespace pkg
+} // namespace fl
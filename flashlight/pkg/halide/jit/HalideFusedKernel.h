@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/Shape.h"
+#include "flashlight/fl/tensor/TensorBackend.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/Types.h"
+#include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ReductionNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
+
+namespace fl {
+namespace pkg {
+namespace halide {
+
+/**
+ * A fused kernel for a JIT subgraph of elementwise ops, reductions and
+ * strided windows (e.g., the taps of a stencil), lowered to a Halide
+ * pipeline.
+ *
+ * Like `ElementwiseKernel`, the subgraph is linearized into SSA instructions
+ * over virtual registers, i.e., the result of `instructions[i]` lives in
+ * register `i`, and each register becomes a Halide `Func`. Halide dim i is
+ * dim i of the tensors.
+ *
+ * Kernels only depend on the structure of the subgraph, so they are cached by
+ * signature; scalar values and where windows start are pipeline parameters,
+ * passed in at execution time. JIT nodes are untyped, so a kernel compiles a
+ * pipeline per combination of input types and target (host, or CUDA for
+ * device tensors) on first use, and caches it too. Pipelines are scheduled by
+ * the autoscheduler if one is named (its plugin must be loaded with
+ * `Halide::load_plugin`), and by a simple default schedule otherwise.
+ */
+class HalideFusedKernel {
+ public:
+  enum class OpCode { Input, Scalar, Unary, Binary, Reduction, Window };
+
+  // these types can hold all types scalars FL support, w/o loss of precision
+  using ScalarValue = std::variant<long long, double, unsigned long long>;
+
+  struct Instruction {
+    OpCode opCode;
+    // register indices of the operands -- `lhs` is the operand of unary,
+    // reduction and window instructions
+    unsigned lhs{0};
+    unsigned rhs{0};
+    // index into the tensor inputs for `Input`, or into the scalar values for
+    // `Scalar`
+    unsigned operandIdx{0};
+    // shape of the result of this instruction (before broadcasting)
+    Shape shape;
+    // type of the scalar, only used by `Scalar`
+    dtype scalarType{dtype::f32};
+    UnaryOp unaryOp{UnaryOp::Exp};
+    BinaryOp binaryOp{BinaryOp::Add};
+    // only used by `Reduction`
+    ReductionOp reductionOp{ReductionOp::Sum};
+    std::vector<int> axes{};
+    bool keepDims{false};
+    // only used by `Window` -- for each dim of the operand, the stride of the
+    // window and the dim of the result it spans, or -1 for a literal index
+    std::vector<Dim> windowStrides{};
+    std::vector<int> windowDims{};
+  };
+
+  // where a window read by a `Window` instruction starts, and how to
+  // materialize it (for when the kernel falls back to the backend)
+  struct WindowView {
+    // the first element of the window, for each dim of the operand
+    std::vector<Dim> starts;
+    std::vector<Index> indices;
+  };
+
+  struct Options {
+    // e.g., "Adams2019" or "Mullapudi2016", empty for the default schedule
+    std::string autoscheduler;
+  };
+
+ private:
+  struct Pipeline;
+
+  const std::vector<Instruction> instructions_;
+  const Options options_;
+  const std::string signature_;
+  unsigned numInputs_{0};
+  unsigned numScalars_{0};
+  unsigned numWindows_{0};
+
+  // compiled pipelines by input types and target, nullptr if the kernel
+  // can't run on them as a pipeline
+  mutable std::mutex pipelinesMutex_;
+  mutable std::unordered_map<std::string, std::shared_ptr<Pipeline>>
+      pipelines_;
+
+  HalideFusedKernel(
+      std::vector<Instruction>&& instructions,
+      const Options& options,
+      std::string&& signature);
+
+  // the type of each register, or nothing if the pipeline can't be typed
+  // (e.g., mixed types, which backends promote)
+  std::optional<std::vector<dtype>> getRegisterTypes(
+      const std::vector<const Tensor*>& inputs) const;
+
+  std::shared_ptr<Pipeline> getOrCompilePipeline(
+      const std::vector<dtype>& types,
+      Location location) const;
+
+  std::shared_ptr<Pipeline> compile(
+      const std::vector<dtype>& types,
+      Location location) const;
+
+  // evaluate instruction by instruction via the given backend
+  Tensor runWithBackend(
+      TensorBackend& backend,
+      const std::vector<const Tensor*>& inputs,
+      const std::vector<ScalarValue>& scalars,
+      const std::vector<WindowView>& windows) const;
+
+ public:
+  /**
+   * Get the kernel for the given instructions from the kernel cache, create
+   * and cache one if none exists yet. Pipelines are compiled lazily.
+   *
+   * @param[in] instructions the SSA instructions, with the last instruction
+   * producing the kernel output.
+   * @param[in] options how to schedule the pipelines of the kernel.
+   * @return the kernel.
+   */
+  static std::shared_ptr<const HalideFusedKernel> getOrCreate(
+      std::vector<Instruction>&& instructions,
+      const Options& options = {});
+
+  /**
+   * Whether unary instructions of the op can be lowered to Halide.
+   */
+  static bool canLower(UnaryOp op);
+
+  /**
+   * Build a signature that uniquely identifies the kernel structure.
+   */
+  static std::string getSignature(
+      const std::vector<Instruction>& instructions,
+      const Options& options);
+
+  /**
+   * Number of kernels currently in the kernel cache.
+   */
+  static size_t numCachedKernels();
+
+  /**
+   * Remove all kernels from the kernel cache.
+   */
+  static void clearCache();
+
+  /**
+   * Number of pipelines this kernel compiled so far.
+   */
+  size_t numCompiledPipelines() const;
+
+  const std::string& signature() const;
+  const std::vector<Instruction>& instructions() const;
+
+  /**
+   * Execute the kernel.
+   *
+   * Runs the compiled pipeline if the inputs can be typed as one and live
+   * where the output does (on the host, or on a CUDA device in CUDA builds);
+   * otherwise falls back to dispatching each instruction to `backend`.
+   *
+   * @param[in] backend the backend used to allocate output/fallback compute.
+   * @param[in] inputs the input tensors, indexed by `Instruction::operandIdx`.
+   * @param[in] scalars the scalar values, indexed by `Instruction::operandIdx`.
+   * @param[in] windows the windows read by `Window` instructions, in
+   * instruction order.
+   * @return the output tensor.
+   */
+  Tensor run(
+      TensorBackend& backend,
+      const std::vector<const Tensor*>& inputs,
+      const std::vector<ScalarValue>& scalars,
+      const std::vector<WindowView>& windows = {}) const;
+};
+
+} // namespace halide
+} // namespace pkg
+} // namespace fl
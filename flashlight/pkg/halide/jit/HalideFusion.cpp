@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/halide/jit/HalideFusion.h"
+
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/CustomNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/IndexNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ReductionNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
+
+namespace fl {
+namespace pkg {
+namespace halide {
+
+namespace {
+
+using Instruction = HalideFusedKernel::Instruction;
+using OpCode = HalideFusedKernel::OpCode;
+using ScalarValue = HalideFusedKernel::ScalarValue;
+using WindowView = HalideFusedKernel::WindowView;
+
+ScalarValue getScalarValue(const ScalarNode& node) {
+  switch (node.dataType()) {
+    case dtype::b8:
+    case dtype::s16:
+    case dtype::s32:
+    case dtype::s64:
+    case dtype::u8:
+    case dtype::u16:
+    case dtype::u32:
+      return node.scalar<long long>();
+    case dtype::u64:
+      return node.scalar<unsigned long long>();
+    case dtype::f16:
+    case dtype::bf16:
+    case dtype::f32:
+    case dtype::f64:
+      return node.scalar<double>();
+  }
+  throw std::runtime_error("[getScalarValue] Unknown data type");
+}
+
+bool isNodeFusable(const Node* node) {
+  if (node->getResult().has_value()) {
+    return false; // already computed, cheaper to read
+  }
+  if (node->isBinary()) {
+    // leave these to ScalarFolding
+    const auto& binaryNode = node->impl<BinaryNode>();
+    return !(binaryNode.lhs()->isScalar() && binaryNode.rhs()->isScalar());
+  }
+  if (node->isUnary()) {
+    return HalideFusedKernel::canLower(node->impl<UnaryNode>().op());
+  }
+  return node->isReduction();
+}
+
+struct Window {
+  std::vector<Dim> starts;
+  std::vector<Dim> strides;
+  std::vector<int> dims;
+};
+
+// If `node` only selects a strided window (spans, positive-stride ranges and
+// literals) of the indexed node, return where it starts, its strides and the
+// dims of the result it spans, for each dim of the indexed node.
+std::optional<Window> getWindow(const IndexNode& node) {
+  const auto& indexedShape = node.indexedNode()->shape();
+  const auto& indices = node.indices();
+  if (indices.size() > static_cast<size_t>(indexedShape.ndim())) {
+    return std::nullopt;
+  }
+  Window window;
+  int numDims = 0;
+  for (int i = 0; i < indexedShape.ndim(); i++) {
+    const auto dim = indexedShape.dim(i);
+    if (i >= static_cast<int>(indices.size())) {
+      window.starts.push_back(0);
+      window.strides.push_back(1);
+      window.dims.push_back(numDims++);
+      continue;
+    }
+    const auto& idx = indices[i];
+    switch (idx.type()) {
+      case detail::IndexType::Span:
+        window.starts.push_back(0);
+        window.strides.push_back(1);
+        window.dims.push_back(numDims++);
+        break;
+      case detail::IndexType::Range: {
+        const auto& rangeIdx = idx.get<range>();
+        const auto start = rangeIdx.start();
+        const auto end = rangeIdx.end().value_or(dim);
+        const auto stride = rangeIdx.stride();
+        if (start < 0 || end > dim || start >= end || stride <= 0) {
+          return std::nullopt;
+        }
+        window.starts.push_back(start);
+        window.strides.push_back(stride);
+        window.dims.push_back(numDims++);
+        break;
+      }
+      case detail::IndexType::Literal: {
+        const auto literal = idx.get<Dim>();
+        if (literal < 0 || literal >= dim) {
+          return std::nullopt;
+        }
+        window.starts.push_back(literal); // dimension is reduced
+        window.strides.push_back(0);
+        window.dims.push_back(-1);
+        break;
+      }
+      default:
+        return std::nullopt;
+    }
+  }
+  if (numDims != node.shape().ndim()) {
+    return std::nullopt;
+  }
+  return window;
+}
+
+bool isFusionProfitable(const Node* node) {
+  return node->uses().size() <= 1;
+}
+
+} // namespace
+
+// Linearizes a fusable region into HalideFusedKernel instructions.
+class HalideFusion::RegionBuilder {
+  HalideFusion& fuser_;
+  std::vector<Instruction> instructions_{};
+  std::vector<Node*> inputNodes_{};
+  std::vector<ScalarValue> scalars_{};
+  std::vector<WindowView> windows_{};
+  // input (or window) node -> register holding its value
+  std::unordered_map<Node*, unsigned> inputNodeToRegister_{};
+  unsigned numOps_{0};
+
+  unsigned addInstruction(Instruction&& instruction) {
+    instructions_.push_back(std::move(instruction));
+    return instructions_.size() - 1;
+  }
+
+  unsigned addInput(Node* node) {
+    // optimize the input first, since it might get replaced
+    node = fuser_.rewriteFrom(node);
+    const auto iter = inputNodeToRegister_.find(node);
+    if (iter != inputNodeToRegister_.end()) {
+      return iter->second;
+    }
+    Instruction instruction{.opCode = OpCode::Input};
+    instruction.operandIdx = inputNodes_.size();
+    instruction.shape = node->shape();
+    inputNodes_.push_back(node);
+    const auto reg = addInstruction(std::move(instruction));
+    inputNodeToRegister_.emplace(node, reg);
+    return reg;
+  }
+
+  // read the window of the indexed node in place, rather than materializing
+  // the slice
+  unsigned addWindow(Node* node, Window&& window) {
+    const auto iter = inputNodeToRegister_.find(node);
+    if (iter != inputNodeToRegister_.end()) {
+      return iter->second;
+    }
+    const auto& indexNode = node->impl<IndexNode>();
+    const auto lhs = addInput(indexNode.indexedNode());
+    Instruction instruction{.opCode = OpCode::Window};
+    instruction.lhs = lhs;
+    instruction.shape = node->shape();
+    instruction.windowStrides = std::move(window.strides);
+    instruction.windowDims = std::move(window.dims);
+    windows_.push_back({std::move(window.starts), indexNode.indices()});
+    const auto reg = addInstruction(std::move(instruction));
+    inputNodeToRegister_.emplace(node, reg);
+    return reg;
+  }
+
+  unsigned addScalar(const ScalarNode& node) {
+    Instruction instruction{.opCode = OpCode::Scalar};
+    instruction.operandIdx = scalars_.size();
+    instruction.shape = node.shape();
+    instruction.scalarType = node.dataType();
+    scalars_.push_back(getScalarValue(node));
+    return addInstruction(std::move(instruction));
+  }
+
+  unsigned addBinop(const BinaryNode& node) {
+    const auto lhs = add(node.lhs(), /* isRegionRoot = */ false);
+    const auto rhs = add(node.rhs(), /* isRegionRoot = */ false);
+    Instruction instruction{.opCode = OpCode::Binary};
+    instruction.lhs = lhs;
+    instruction.rhs = rhs;
+    instruction.shape = node.shape();
+    instruction.binaryOp = node.op();
+    return addInstruction(std::move(instruction));
+  }
+
+  unsigned addUnop(const UnaryNode& node) {
+    const auto lhs = add(node.input(), /* isRegionRoot = */ false);
+    Instruction instruction{.opCode = OpCode::Unary};
+    instruction.lhs = lhs;
+    instruction.shape = node.shape();
+    instruction.unaryOp = node.op();
+    return addInstruction(std::move(instruction));
+  }
+
+  unsigned addReduction(const ReductionNode& node) {
+    const auto lhs = add(node.input(), /* isRegionRoot = */ false);
+    Instruction instruction{.opCode = OpCode::Reduction};
+    instruction.lhs = lhs;
+    instruction.shape = node.shape();
+    instruction.reductionOp = node.op();
+    instruction.axes = node.axes();
+    instruction.keepDims = node.keepDims();
+    return addInstruction(std::move(instruction));
+  }
+
+ public:
+  explicit RegionBuilder(HalideFusion& fuser) : fuser_(fuser) {}
+
+  unsigned add(Node* node, bool isRegionRoot) {
+    if (node->isScalar()) {
+      return addScalar(node->impl<ScalarNode>());
+    }
+    const bool isVisited = fuser_.visited_.find(node) != fuser_.visited_.end();
+    const bool isInterior =
+        !isVisited && isNodeFusable(node) && isFusionProfitable(node);
+    if (!isRegionRoot && !isInterior) {
+      // a window costs nothing to read multiple times, so its uses don't
+      // matter
+      if (node->isIndex() && !node->getResult().has_value()) {
+        auto window = getWindow(node->impl<IndexNode>());
+        if (window.has_value()) {
+          return addWindow(node, std::move(window.value()));
+        }
+      }
+      return addInput(node);
+    }
+    fuser_.visited_.insert(node);
+    numOps_++;
+    if (node->isBinary()) {
+      return addBinop(node->impl<BinaryNode>());
+    }
+    if (node->isUnary()) {
+      return addUnop(node->impl<UnaryNode>());
+    }
+    return addReduction(node->impl<ReductionNode>());
+  }
+
+  // Fusing a single op only pays off if it saves us a scalar broadcast or a
+  // slice copy.
+  bool isFusionWorthwhile() const {
+    return numOps_ >= 2 || !scalars_.empty() || !windows_.empty();
+  }
+
+  Node* build(
+      const Shape& outputShape,
+      TensorBackend& backend,
+      const HalideFusedKernel::Options& options) {
+    auto kernel =
+        HalideFusedKernel::getOrCreate(std::move(instructions_), options);
+    auto evalFunc = [kernel = std::move(kernel),
+                     scalars = std::move(scalars_),
+                     windows = std::move(windows_),
+                     &backend](const std::vector<const Tensor*>& inputs) {
+      return kernel->run(backend, inputs, scalars, windows);
+    };
+    return CustomNode::create(
+        "HalideFused",
+        std::move(inputNodes_),
+        outputShape,
+        std::move(evalFunc));
+  }
+};
+
+HalideFusion::HalideFusion(
+    TensorBackend& backend,
+    HalideFusedKernel::Options options /* = {} */)
+    : backend_(backend), options_(std::move(options)) {}
+
+Node* HalideFusion::rewriteFrom(Node* node) {
+  if (visited_.find(node) != visited_.end()) {
+    return node;
+  }
+  if (!isNodeFusable(node)) {
+    visited_.insert(node);
+    for (const auto& input : node->inputs()) {
+      rewriteFrom(input);
+    }
+    return node;
+  }
+  RegionBuilder builder(*this);
+  builder.add(node, /* isRegionRoot = */ true);
+  if (!builder.isFusionWorthwhile()) {
+    return node;
+  }
+  auto fusedNode = builder.build(node->shape(), backend_, options_);
+  node->replaceAllUsesWith(fusedNode);
+  return fusedNode;
+}
+
+Node* HalideFusion::apply(Node* root) {
+  auto optimizedRoot = rewriteFrom(root);
+  visited_.clear();
+  return optimizedRoot;
+}
+
+std::string HalideFusion::name() const {
+  return "HalideFusion";
+}
+
+} // namespace halide
+} // namespace pkg
+} // namespace fl
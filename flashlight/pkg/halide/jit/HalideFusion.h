@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <unordered_set>
+
+#include "flashlight/fl/tensor/TensorBackend.h"
+#include "flashlight/fl/tensor/backend/jit/ir/Node.h"
+#include "flashlight/fl/tensor/backend/jit/opt/Pass.h"
+#include "flashlight/pkg/halide/jit/HalideFusedKernel.h"
+
+namespace fl {
+namespace pkg {
+namespace halide {
+
+/**
+ * Fuse connected subgraphs of elementwise ops, reductions and strided windows
+ * into a single `HalideFusedKernel`, i.e., a Halide pipeline that computes the
+ * whole subgraph without materializing any intermediate tensor.
+ *
+ * A stencil such as
+ *
+ *   x(range(0, n - 2)) + x(range(1, n - 1)) * 2 + x(range(2, n))
+ *
+ * becomes a single pipeline over `x`, which reads the 3 windows in place.
+ *
+ * NOTE
+ * 1. like CpuElementwiseFusion, we avoid recomputation -- intermediate nodes
+ *    with more than 1 use become inputs of the fused node (windows excepted,
+ *    since they cost nothing to read multiple times).
+ * 2. binary nodes with 2 scalar inputs are left to ScalarFolding.
+ * 3. inputs a pipeline can't be compiled for (e.g., f16, or device memory in
+ *    non-CUDA builds) are evaluated op by op via `backend`.
+ *
+ * It's a pass of the JIT optimizer of ArrayFire tensors, and can be added to
+ * those of other backends, e.g., on top of the oneDNN passes:
+ * \code
+   JitTensor<OneDnnTensor>().optimizer().addPass(
+       std::make_unique<HalideFusion>(OneDnnBackend::getInstance()));
+ * \endcode
+ */
+class HalideFusion : public Pass {
+  TensorBackend& backend_;
+  const HalideFusedKernel::Options options_;
+
+  // Avoid re-visit, since fuser only need to apply once to each node.
+  std::unordered_set<Node*> visited_{};
+
+  class RegionBuilder;
+
+  // fuse the largest region rooted at `node`, and recursively optimize the
+  // inputs of that region.
+  Node* rewriteFrom(Node* node);
+
+ public:
+  explicit HalideFusion(
+      TensorBackend& backend,
+      HalideFusedKernel::Options options = {});
+  ~HalideFusion() = default;
+
+  Node* apply(Node* root) override;
+  std::string name() const override;
+};
+
+} // namespace halide
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/halide/jit/HalideJitOptimizerExtension.h"
+
+#include "flashlight/fl/tensor/TensorExtension.h"
+#include "flashlight/pkg/halide/jit/HalideFusion.h"
+
+#if FL_USE_ARRAYFIRE
+  #include "flashlight/fl/tensor/backend/af/ArrayFireBackend.h"
+#endif // FL_USE_ARRAYFIRE
+
+namespace fl {
+namespace pkg {
+namespace halide {
+
+std::vector<std::unique_ptr<Pass>> HalideJitOptimizerExtension::passes() {
+  std::vector<std::unique_ptr<Pass>> passes;
+#if FL_USE_ARRAYFIRE
+  passes.emplace_back(
+      std::make_unique<HalideFusion>(ArrayFireBackend::getInstance()));
+#endif // FL_USE_ARRAYFIRE
+  return passes;
+}
+
+bool HalideJitOptimizerExtension::isDataTypeSupported(
+    const fl::dtype& dtype) const {
+  // pipelines fall back to the backend for the types they can't compile for
+  return true;
+}
+
+/****************** Jit Optimizer Extension Registration ******************/
+
+#if FL_USE_ARRAYFIRE
+FL_REGISTER_TENSOR_EXTENSION(HalideJitOptimizerExtension, ArrayFire);
+#endif // FL_USE_ARRAYFIRE
+
+} // namespace halide
+} // namespace pkg
+} // namespace fl
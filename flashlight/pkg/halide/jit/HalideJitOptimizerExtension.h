@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "flashlight/fl/tensor/backend/jit/opt/JitOptimizerExtension.h"
+
+namespace fl {
+namespace pkg {
+namespace halide {
+
+/**
+ * JIT graph optimization that lowers fused subgraphs to Halide pipelines, for
+ * backends that have no JIT optimizer extension of their own (ArrayFire).
+ */
+class HalideJitOptimizerExtension : public JitOptimizerExtension {
+ public:
+  std::vector<std::unique_ptr<Pass>> passes() override;
+  bool isDataTypeSupported(const fl::dtype& dtype) const override;
+};
+
+} // namespace halide
+} // namespace pkg
+} // namespace fl
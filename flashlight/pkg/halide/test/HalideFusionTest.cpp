@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/tensor/DefaultTensorType.h"
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Random.h"
+#include "flashlight/fl/tensor/Shape.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/Types.h"
+#include "flashlight/fl/tensor/backend/jit/Utils.h"
+#include "flashlight/fl/tensor/backend/jit/eval/Evaluator.h"
+#include "flashlight/fl/tensor/backend/jit/ir/BinaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/IndexNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ReductionNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ScalarNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/UnaryNode.h"
+#include "flashlight/fl/tensor/backend/jit/ir/ValueNode.h"
+#include "flashlight/pkg/halide/jit/HalideFusedKernel.h"
+#include "flashlight/pkg/halide/jit/HalideFusion.h"
+
+using namespace fl;
+using namespace fl::pkg::halide;
+
+class HalideFusionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    HalideFusedKernel::clearCache();
+  }
+
+  TensorBackend& backend_ = DefaultTensorBackend_t::getInstance();
+  HalideFusion fuser_{backend_};
+  Evaluator evaluator_{backend_};
+};
+
+TEST_F(HalideFusionTest, singleBinaryNodeOfValues) {
+  // v1  v2
+  //  \  /
+  //   add
+  Shape shape(Shape({2, 2}));
+  const auto v1 = ValueNode::create(fl::rand(shape, dtype::f32));
+  const auto v2 = ValueNode::create(fl::rand(shape, dtype::f32));
+  const auto add = BinaryNode::create(v1, v2, BinaryOp::Add);
+  // nothing changes -- fusion wouldn't save any memory traffic
+  ASSERT_EQ(add, fuser_.apply(add));
+  ASSERT_EQ(add->inputs(), NodeList({v1, v2}));
+  // root node is owned locally (didn't transition to shared ownership)
+  delete add;
+}
+
+TEST_F(HalideFusionTest, fuseChain) {
+  // v1  c2
+  //  \  /
+  //   mul
+  //    |
+  //   exp  v3
+  //    \  /
+  //     add
+  Shape shape(Shape({3, 4}));
+  const auto t1 = fl::rand(shape, dtype::f32);
+  const auto t3 = fl::rand(shape, dtype::f32);
+  const auto v1 = ValueNode::create(t1.copy());
+  const auto c2 = ScalarNode::create(shape, dtype::f32, 2);
+  const auto v3 = ValueNode::create(t3.copy());
+  const auto mul = BinaryNode::create(v1, c2, BinaryOp::Mul);
+  const auto exp = UnaryNode::create(mul, UnaryOp::Exp);
+  const auto add = BinaryNode::create(exp, v3, BinaryOp::Add);
+  const auto fused = fuser_.apply(add);
+  ASSERT_NE(fused, add);
+  ASSERT_TRUE(fused->isCustom());
+  ASSERT_EQ(fused->inputs(), NodeList({v1, v3}));
+  ASSERT_EQ(fused->shape(), shape);
+  // root nodes are owned locally (didn't transition to shared ownership)
+  delete add;
+  evaluator_.eval(fused);
+  ASSERT_TRUE(allClose(fused->getResult().value(), fl::exp(t1 * 2) + t3));
+  ASSERT_EQ(HalideFusedKernel::numCachedKernels(), 1);
+  delete fused;
+}
+
+TEST_F(HalideFusionTest, stencil) {
+  //     v1
+  //   /  |  \
+  // idx idx idx  c2
+  //   \  |   \  /
+  //    \ |   mul
+  //     \|   /
+  //     add /
+  //       \/
+  //       add
+  const Dim n = 10;
+  const auto t1 = fl::rand({n, 3}, dtype::f32);
+  const auto v1 = ValueNode::create(t1.copy());
+  const auto left = IndexNode::create(v1, {range(0, n - 2)});
+  const auto center = IndexNode::create(v1, {range(1, n - 1)});
+  const auto right = IndexNode::create(v1, {range(2, n)});
+  const auto c2 = ScalarNode::create(center->shape(), dtype::f32, 2);
+  const auto mul = BinaryNode::create(center, c2, BinaryOp::Mul);
+  const auto add1 = BinaryNode::create(left, mul, BinaryOp::Add);
+  const auto add2 = BinaryNode::create(add1, right, BinaryOp::Add);
+  const auto fused = fuser_.apply(add2);
+  ASSERT_TRUE(fused->isCustom());
+  // the windows are read in place
+  ASSERT_EQ(fused->inputs(), NodeList({v1}));
+  ASSERT_EQ(fused->shape(), Shape({n - 2, 3}));
+  delete add2;
+  evaluator_.eval(fused);
+  const auto expected = t1(range(0, n - 2)) + t1(range(1, n - 1)) * 2 +
+      t1(range(2, n));
+  ASSERT_TRUE(allClose(fused->getResult().value(), expected));
+  delete fused;
+}
+
+TEST_F(HalideFusionTest, reduction) {
+  //   v1
+  //    |
+  //   exp
+  //    |
+  //   sum
+  Shape shape(Shape({5, 4}));
+  const auto t1 = fl::rand(shape, dtype::f32);
+  const auto v1 = ValueNode::create(t1.copy());
+  const auto exp = UnaryNode::create(v1, UnaryOp::Exp);
+  const auto sum = ReductionNode::create(
+      exp, ReductionOp::Sum, {0}, /* keepDims = */ true);
+  const auto fused = fuser_.apply(sum);
+  ASSERT_TRUE(fused->isCustom());
+  ASSERT_EQ(fused->inputs(), NodeList({v1}));
+  ASSERT_EQ(fused->shape(), Shape({1, 4}));
+  delete sum;
+  evaluator_.eval(fused);
+  ASSERT_TRUE(allClose(
+      fused->getResult().value(),
+      fl::sum(fl::exp(t1), {0}, /* keepDims = */ true),
+      1e-5));
+  delete fused;
+}
+
+TEST_F(HalideFusionTest, fallback) {
+  // v1  c2
+  //  \  /
+  //   add  v1
+  //    \  /
+  //     mul
+  Shape shape(Shape({3, 4}));
+  const auto t1 = fl::full(shape, 3, dtype::f16);
+  const auto v1 = ValueNode::create(t1.copy());
+  const auto c2 = ScalarNode::create(shape, dtype::f16, 2);
+  const auto add = BinaryNode::create(v1, c2, BinaryOp::Add);
+  const auto mul = BinaryNode::create(add, v1, BinaryOp::Mul);
+  const auto fused = fuser_.apply(mul);
+  ASSERT_TRUE(fused->isCustom());
+  delete mul;
+  // no pipeline for f16, falls back to backend ops
+  evaluator_.eval(fused);
+  const auto& result = fused->getResult().value();
+  ASSERT_EQ(result.type(), dtype::f16);
+  ASSERT_TRUE(allClose(result, fl::full(shape, 15, dtype::f16)));
+  delete fused;
+}
+
+TEST_F(HalideFusionTest, kernelIsCachedAcrossScalarValues) {
+  // v1  c
+  //  \  /
+  //   mul  v1
+  //    \  /
+  //     sub
+  Shape shape(Shape({3, 4}));
+  const auto t1 = fl::rand(shape, dtype::f32);
+  for (const float scalar : {2.f, 4.f}) {
+    const auto v1 = ValueNode::create(t1.copy());
+    const auto c = ScalarNode::create(shape, dtype::f32, scalar);
+    const auto mul = BinaryNode::create(v1, c, BinaryOp::Mul);
+    const auto sub = BinaryNode::create(mul, v1, BinaryOp::Sub);
+    const auto fused = fuser_.apply(sub);
+    delete sub;
+    evaluator_.eval(fused);
+    ASSERT_TRUE(allClose(fused->getResult().value(), t1 * scalar - t1));
+    delete fused;
+  }
+  // same structure, so the same kernel (and pipeline) is reused
+  ASSERT_EQ(HalideFusedKernel::numCachedKernels(), 1);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
@@ -8,6 +8,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <cmath>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 
 #include "flashlight/fl/autograd/Functions.h"
@@ -15,12 +17,37 @@
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Random.h"
 #include "flashlight/pkg/halide/HalideInterface.h"
+#include "flashlight/pkg/halide/HalideKernel.h"
 
-// Generated at build time -- see the accompanying CMakeList
-#include "HalideTestPipeline.h"
+#if FL_BACKEND_CUDA
+  // Generated at build time -- see the accompanying CMakeList
+  #include "HalideTestPipeline.h"
+#endif
 
 using namespace fl;
 
+namespace {
+
+// Pipelines run on the host for host tensors, e.g. of oneDNN, and on the GPU
+// for device tensors, e.g. of ArrayFire CUDA
+bool onDevice() {
+  return fl::rand({1}).location() == Location::Device;
+}
+
+Halide::Target jitTarget() {
+  auto target = Halide::get_jit_target_from_environment();
+  return onDevice() ? target.with_feature(Halide::Target::CUDA) : target;
+}
+
+void schedule(Halide::Func& func, Halide::Var& x) {
+  if (onDevice()) {
+    Halide::Var xOuter, xInner;
+    func.gpu_tile(x, xOuter, xInner, 16);
+  }
+}
+
+} // namespace
+
 TEST(HalideTest, TypeMapping) {
   Halide::Buffer<Halide::float16_t> halfBuf({1});
   EXPECT_EQ(
@@ -83,6 +110,18 @@ TEST(HalideTest, ConvertDims) {
   EXPECT_EQ(pkg::halide::halideToFlDims(bufferWithEmptyDim), Shape());
 }
 
+TEST(HalideTest, ConvertTensor) {
+  auto tensor = fl::rand({5, 4, 3});
+  pkg::halide::HalideTensorBuffer buffer(tensor);
+  EXPECT_EQ(buffer.getBuffer().type(), Halide::Float(32));
+  EXPECT_EQ(pkg::halide::halideToFlDims(buffer.getBuffer()), tensor.shape());
+  EXPECT_EQ(
+      pkg::halide::halideRuntimeTypeToFlType(
+          pkg::halide::flToHalideRuntimeType(fl::dtype::s32)),
+      fl::dtype::s32);
+}
+
+#if FL_BACKEND_CUDA
 TEST(HalideTest, ConvertArray) {
   auto arr = fl::rand({5, 4, 3, 2});
   auto arrCopy = arr.copy();
@@ -148,6 +187,72 @@ TEST(HalideTest, SimpleAOTCompiledHalidePipeline) {
   EXPECT_TRUE(fl::allClose(expected, output));
 }
 
+TEST(HalideTest, AOTKernel) {
+  const int n = 64;
+  pkg::halide::HalideKernel kernel;
+  kernel.forward = std::make_shared<pkg::halide::AOTHalidePipeline>(
+      testFunc_argv, testFunc_metadata());
+  pkg::halide::registerHalideKernel("testFunc", kernel);
+
+  auto input = fl::rand({n, n}) * 100;
+  auto outputs = pkg::halide::runHalideKernel("testFunc", {input}, {5});
+  ASSERT_EQ(outputs.size(), 1);
+  auto expected =
+      input + fl::sin(fl::arange({n, n}, 0) * fl::arange({n, n}, 1)) + 5;
+  EXPECT_TRUE(fl::allClose(outputs.front(), expected, 1e-3));
+  // the scalar offset is missing
+  EXPECT_THROW(
+      pkg::halide::runHalideKernel("testFunc", {input}), std::invalid_argument);
+}
+#endif // FL_BACKEND_CUDA
+
+TEST(HalideTest, JITKernel) {
+  Halide::Var x("x");
+  Halide::ImageParam input(Halide::Float(32), 1, "input");
+  Halide::Param<float> scale("scale");
+  Halide::Func forward("forward");
+  forward(x) = input(x) * input(x) * scale;
+  schedule(forward, x);
+
+  Halide::ImageParam backwardInput(Halide::Float(32), 1, "backwardInput");
+  Halide::ImageParam gradOutput(Halide::Float(32), 1, "gradOutput");
+  Halide::Param<float> backwardScale("backwardScale");
+  Halide::Func backward("backward");
+  backward(x) = 2 * backwardInput(x) * backwardScale * gradOutput(x);
+  schedule(backward, x);
+
+  pkg::halide::HalideKernel kernel;
+  kernel.forward = std::make_shared<pkg::halide::JITHalidePipeline>(
+      Halide::Pipeline(forward),
+      std::vector<Halide::ImageParam>{input},
+      std::vector<Halide::Param<void>>{scale},
+      jitTarget());
+  kernel.backward = std::make_shared<pkg::halide::JITHalidePipeline>(
+      Halide::Pipeline(backward),
+      std::vector<Halide::ImageParam>{backwardInput, gradOutput},
+      std::vector<Halide::Param<void>>{backwardScale},
+      jitTarget());
+  pkg::halide::registerHalideKernel("scaledSquare", kernel);
+  EXPECT_TRUE(pkg::halide::isHalideKernelRegistered("scaledSquare"));
+  EXPECT_THROW(
+      pkg::halide::registerHalideKernel("scaledSquare", kernel),
+      std::invalid_argument);
+
+  auto in = Variable(fl::rand({100}), true);
+  auto out = pkg::halide::halideKernel("scaledSquare", {in}, {3});
+  EXPECT_TRUE(fl::allClose(out.tensor(), in.tensor() * in.tensor() * 3, 1e-5));
+  out.backward();
+  EXPECT_TRUE(fl::allClose(in.grad().tensor(), in.tensor() * 6, 1e-5));
+
+  EXPECT_THROW(
+      pkg::halide::runHalideKernel("missing", {in.tensor()}),
+      std::invalid_argument);
+  // the scalar is missing
+  EXPECT_THROW(
+      pkg::halide::runHalideKernel("scaledSquare", {in.tensor()}),
+      std::invalid_argument);
+}
+
 TEST(HalideTest, SimpleJITHalidePipeline) {
   // Make sure we can call the Halide JIT inline in flashlight
   int yDim = 10, xDim = 10;
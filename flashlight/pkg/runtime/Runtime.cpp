@@ -12,6 +12,8 @@
 
 #include "flashlight/pkg/runtime/Runtime.h"
 
+#include "flashlight/pkg/runtime/common/DistributedUtils.h"
+
 namespace fl {
 namespace pkg {
 namespace runtime {
@@ -63,6 +65,24 @@ bool backwardWithScaling(
   return true;
 }
 
+void warmUpBenchmarks(
+    const std::function<void()>& step,
+    int iterations,
+    const fs::path& cacheFile /* = "" */) {
+  if (!cacheFile.empty() && fs::exists(cacheFile)) {
+    fl::BenchmarkCache::load(cacheFile);
+  }
+  fl::DynamicBenchmark::setBenchmarkMode(true);
+  for (int i = 0; i < iterations; ++i) {
+    step();
+  }
+
+  syncBenchmarkCache();
+  if (!cacheFile.empty() && fl::getWorldRank() == 0) {
+    fl::BenchmarkCache::save(cacheFile);
+  }
+}
+
 std::string getCurrentDate() {
   time_t now = time(nullptr);
   struct tm tmbuf;
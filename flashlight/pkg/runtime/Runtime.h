@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/fl/flashlight.h"
 #include "flashlight/pkg/runtime/amp/DynamicScaler.h"
@@ -41,6 +43,27 @@ bool backwardWithScaling(
     std::shared_ptr<fl::pkg::runtime::DynamicScaler> dynamicScaler,
     std::shared_ptr<fl::Reducer> reducer);
 
+/**
+ * Warms up the `DynamicBenchmark`s of a model before training, such that
+ * training runs with the benchmarked options from the start: loads the
+ * options benchmarked by previous runs from `cacheFile` if it exists, runs
+ * `step` `iterations` times with benchmark mode on, merges the benchmarked
+ * options of all processes and, on the first process, saves them to
+ * `cacheFile` for the next runs. Benchmark mode is left on, which is needed
+ * for the benchmarked options to be used.
+ *
+ * @param[in] step runs e.g. a forward and backward pass of a batch; should
+ * cover the input shapes seen in training.
+ * @param[in] iterations the number of times to run `step`, e.g. the benchmark
+ * count `fl::kDynamicBenchmarkDefaultCount` times the number of options.
+ * @param[in] cacheFile the `BenchmarkCache` file, or empty to not persist the
+ * options.
+ */
+void warmUpBenchmarks(
+    const std::function<void()>& step,
+    int iterations,
+    const fs::path& cacheFile = "");
+
 /**
  * Returns the current date as a string
  */
@@ -8,6 +8,7 @@
 #include "flashlight/pkg/runtime/amp/DynamicScaler.h"
 
 #include "flashlight/fl/flashlight.h"
+#include "flashlight/fl/optim/MultiTensor.h"
 
 namespace fl {
 namespace pkg {
@@ -28,35 +29,84 @@ fl::Variable DynamicScaler::scale(const fl::Variable& loss) {
   return scaledLoss;
 }
 
-bool DynamicScaler::unscale(std::vector<fl::Variable>& params) {
+fl::Tensor DynamicScaler::unscaleAsync(std::vector<fl::Variable>& params) {
   for (auto& p : params) {
     if (!p.isGradAvailable()) {
       // Add a dummy grad for params not used in the backwards pass
       p.addGrad(Variable(fl::full(p.shape(), 0., p.type()), false));
     }
-    p.grad() = p.grad() / scaleFactor_;
-    if (fl::isInvalidArray(p.grad().tensor())) {
-      if (scaleFactor_ >= fl::kAmpMinimumScaleFactorValue) {
-        scaleFactor_ = scaleFactor_ / 2.0f;
-        FL_LOG(LogLevel::INFO)
-            << "AMP: Scale factor decreased. New value:\t" << scaleFactor_;
-      } else {
-        FL_LOG(LogLevel::FATAL)
-            << "Minimum loss scale reached: " << fl::kAmpMinimumScaleFactorValue
-            << " with over/underflowing gradients. Lowering the "
-            << "learning rate, using gradient clipping, or "
-            << "increasing the batch size can help resolve "
-            << "loss explosion.";
-      }
-      successCounter_ = 0;
-      return false;
+  }
+
+  // Unscale the gradients of each type as one flat tensor, and accumulate
+  // whether any of them isn't finite on the device
+  fl::Tensor invalid;
+  auto accumulate = [&invalid](const fl::Tensor& grad) {
+    auto gradInvalid = fl::any(fl::isnan(grad) || fl::isinf(grad));
+    invalid = invalid.isEmpty() ? gradInvalid : invalid || gradInvalid;
+  };
+  std::vector<bool> grouped;
+  for (const auto& group : fl::detail::getMultiTensorGroups(params, grouped)) {
+    auto grads = group.grads(params) / scaleFactor_;
+    accumulate(grads);
+    const auto& indices = group.indices();
+    for (size_t j = 0; j < indices.size(); ++j) {
+      params[indices[j]].grad().tensor() = group.slice(grads, j);
+    }
+  }
+  for (size_t i = 0; i < params.size(); ++i) {
+    if (grouped[i]) {
+      continue;
     }
+    auto& p = params[i];
+    p.grad() = p.grad() / scaleFactor_;
+    accumulate(p.grad().tensor());
+  }
+  return invalid.isEmpty() ? fl::fromScalar(false, fl::dtype::b8) : invalid;
+}
+
+bool DynamicScaler::unscale(std::vector<fl::Variable>& params) {
+  return updateFromFoundInf(unscaleAsync(params));
+}
+
+bool DynamicScaler::updateFromFoundInf(const fl::Tensor& foundInf) {
+  // The only host synchronization of the step
+  if (foundInf.asScalar<bool>()) {
+    decreaseScaleFactor();
+    return false;
   }
 
   ++successCounter_;
   return true;
 }
 
+bool DynamicScaler::step(fl::MasterWeightsOptimizer& optimizer) {
+  optimizer.setLossScale(scaleFactor_);
+  optimizer.step();
+  if (!optimizer.isLastStepFinite()) {
+    decreaseScaleFactor();
+    return false;
+  }
+
+  ++successCounter_;
+  return true;
+}
+
+void DynamicScaler::decreaseScaleFactor() {
+  if (scaleFactor_ >= fl::kAmpMinimumScaleFactorValue) {
+    scaleFactor_ = scaleFactor_ / 2.0f;
+    FL_LOG(LogLevel::INFO) << "AMP: Scale factor decreased. New value:\t"
+                           << scaleFactor_;
+  } else {
+    FL_LOG(LogLevel::FATAL)
+        << "Minimum loss scale reached: " << fl::kAmpMinimumScaleFactorValue
+        << " with over/underflowing gradients. Lowering the "
+        << "learning rate, using gradient clipping, or "
+        << "increasing the batch size can help resolve "
+        << "loss explosion.";
+  }
+  successCounter_ = 0;
+}
+
 void DynamicScaler::update() {
   if (scaleFactor_ >= maxScaleFactor_) {
     return;
@@ -9,6 +9,7 @@
 
 #include <vector>
 #include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/optim/MasterWeightsOptimizer.h"
 
 namespace fl {
 namespace pkg {
@@ -51,10 +52,33 @@ class DynamicScaler {
   /*
    * Unscale the gradients after back propagation.
    * Return false when NAN or INF occurs in gradients and halve the scale
-   * factor, true otherwise.
+   * factor, true otherwise. The gradients of each type are unscaled and
+   * checked together, with a single host synchronization for all of them.
    */
   bool unscale(std::vector<fl::Variable>& params);
 
+  /*
+   * Unscale the gradients like unscale(), without synchronizing with the host.
+   * Return an on-device boolean scalar of whether NAN or INF occurs in
+   * gradients, to pass to updateFromFoundInf() once it's needed, e.g. after
+   * queuing work which doesn't depend on it.
+   */
+  fl::Tensor unscaleAsync(std::vector<fl::Variable>& params);
+
+  /*
+   * Complete unscaleAsync() with the flag it returned, reading it back.
+   * Return false and halve the scale factor if it's set, true otherwise.
+   */
+  bool updateFromFoundInf(const fl::Tensor& foundInf);
+
+  /*
+   * Step an optimizer with master weights, which unscales the gradients and
+   * checks them for NAN or INF as part of its step, in place of unscale() and
+   * step(). Return false when the step was skipped and halve the scale
+   * factor, true otherwise.
+   */
+  bool step(fl::MasterWeightsOptimizer& optimizer);
+
   /*
    * Increase scale factor
    */
@@ -66,6 +90,9 @@ class DynamicScaler {
   double getScaleFactor() const;
 
  private:
+  // Halve the scale factor after NAN or INF occurred in gradients
+  void decreaseScaleFactor();
+
   double scaleFactor_;
   // The maximum value of scaleFactor_.
   double maxScaleFactor_;
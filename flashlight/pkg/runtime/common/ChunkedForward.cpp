@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/runtime/common/ChunkedForward.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "flashlight/fl/autograd/Functions.h"
+#include "flashlight/fl/nn/Init.h"
+#include "flashlight/fl/runtime/DeviceManager.h"
+#include "flashlight/fl/runtime/Event.h"
+#include "flashlight/fl/runtime/Stream.h"
+#include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Index.h"
+
+namespace fl {
+namespace pkg {
+namespace runtime {
+
+namespace {
+
+std::vector<fl::Index> sliceAlong(int ndim, int axis, Dim begin, Dim end) {
+  std::vector<fl::Index> indices(ndim, fl::span);
+  indices[axis] = fl::range(begin, end);
+  return indices;
+}
+
+void checkAxis(const Shape& shape, int axis, const std::string& what) {
+  if (axis < 0 || axis >= shape.ndim()) {
+    throw std::invalid_argument(
+        "ChunkedForward - invalid axis " + std::to_string(axis) + " for " +
+        what + " of shape " + shape.toString());
+  }
+}
+
+} // namespace
+
+/**
+ * The chunks of an input, the next of which is prepared while the model runs
+ * on the current one.
+ */
+class ChunkedForward::ChunkSource {
+ public:
+  virtual ~ChunkSource() = default;
+
+  /** @return the frames of the input along the chunked axis */
+  virtual Dim length() const = 0;
+
+  /** Starts preparing the chunk of the frames [begin, end). */
+  virtual void prepare(Dim begin, Dim end) = 0;
+
+  /** @return the prepared chunk, on the device */
+  virtual Tensor take() = 0;
+};
+
+class ChunkedForward::DeviceChunkSource : public ChunkedForward::ChunkSource {
+ public:
+  DeviceChunkSource(const Tensor& input, int axis)
+      : input_(input), axis_(axis) {
+    checkAxis(input.shape(), axis, "an input");
+  }
+
+  Dim length() const override {
+    return input_.dim(axis_);
+  }
+
+  void prepare(Dim begin, Dim end) override {
+    begin_ = begin;
+    end_ = end;
+  }
+
+  Tensor take() override {
+    if (begin_ == 0 && end_ == length()) {
+      return input_;
+    }
+    return input_(sliceAlong(input_.ndim(), axis_, begin_, end_));
+  }
+
+ private:
+  const Tensor& input_;
+  int axis_;
+  Dim begin_{0};
+  Dim end_{0};
+};
+
+class ChunkedForward::HostChunkSource : public ChunkedForward::ChunkSource {
+ public:
+  HostChunkSource(
+      const void* input,
+      const Shape& shape,
+      fl::dtype type,
+      int axis)
+      : input_(static_cast<const char*>(input)),
+        shape_(shape),
+        type_(type),
+        axis_(axis) {
+    checkAxis(shape, axis, "an input");
+    // a chunk is a run of frames for each index of the axes after the axis
+    frameBytes_ = fl::getTypeSize(type);
+    for (int i = 0; i < axis; ++i) {
+      frameBytes_ *= shape[i];
+    }
+    for (int i = axis + 1; i < shape.ndim(); ++i) {
+      runs_ *= shape[i];
+    }
+  }
+
+  ~HostChunkSource() override {
+    release(pending_);
+    release(taken_);
+  }
+
+  Dim length() const override {
+    return shape_[axis_];
+  }
+
+  void prepare(Dim begin, Dim end) override {
+    release(pending_);
+    Shape shape = shape_;
+    shape[axis_] = end - begin;
+    const size_t runBytes = frameBytes_ * (end - begin);
+    pending_.bytes = runBytes * runs_;
+    pending_.tensor = Tensor(shape, type_);
+    if (pending_.bytes == 0) {
+      return;
+    }
+    pending_.host = fl::allocPinnedHost(pending_.bytes);
+    auto* host = static_cast<char*>(pending_.host);
+    const size_t inputRunBytes = frameBytes_ * length();
+    for (size_t r = 0; r < runs_; ++r) {
+      std::memcpy(
+          host + r * runBytes,
+          input_ + r * inputRunBytes + begin * frameBytes_,
+          runBytes);
+    }
+
+    const auto& computeStream = pending_.tensor.stream();
+    const auto& uploadStream = getUploadStream(computeStream);
+    if (&uploadStream != &computeStream) {
+      // the new memory may still be used by earlier computations
+      uploadStream.relativeSync(computeStream);
+    }
+    uploadStream.copyAsync(
+        pending_.tensor.device<void>(), pending_.host, pending_.bytes);
+    pending_.tensor.unlock();
+    pending_.uploaded = uploadStream.recordEvent();
+  }
+
+  Tensor take() override {
+    // computations on the chunk wait for its upload, without blocking
+    if (pending_.uploaded) {
+      pending_.tensor.stream().relativeSync(*pending_.uploaded);
+    }
+    auto tensor = std::move(pending_.tensor);
+    // the pinned buffer is freed once the upload of the next chunk started
+    release(taken_);
+    taken_ = std::move(pending_);
+    pending_ = Upload();
+    return tensor;
+  }
+
+ private:
+  struct Upload {
+    Tensor tensor;
+    void* host{nullptr};
+    size_t bytes{0};
+    std::unique_ptr<Event> uploaded;
+  };
+
+  static void release(Upload& upload) {
+    if (upload.uploaded) {
+      upload.uploaded->sync();
+    }
+    if (upload.host) {
+      fl::freePinnedHost(upload.host);
+    }
+    upload = Upload();
+  }
+
+  const Stream& getUploadStream(const Stream& computeStream) {
+    if (computeStream.type() != StreamType::CUDA) {
+      return computeStream;
+    }
+    if (!uploadStream_) {
+      uploadStream_ = DeviceManager::getInstance().getStreamFromPool(
+          DeviceType::CUDA, StreamPriority::Low);
+    }
+    return *uploadStream_;
+  }
+
+  const char* input_;
+  Shape shape_;
+  fl::dtype type_;
+  int axis_;
+  size_t frameBytes_;
+  size_t runs_{1};
+  std::shared_ptr<Stream> uploadStream_;
+  Upload pending_;
+  Upload taken_;
+};
+
+ChunkedForward::ChunkedForward(ForwardFunction forward, const Options& options)
+    : forward_(std::move(forward)),
+      options_(options),
+      chunkSize_(options.chunkSize) {
+  if (!forward_) {
+    throw std::invalid_argument(
+        "ChunkedForward::ChunkedForward - null forward function");
+  }
+  if (options.chunkSize < 0 || options.leftContext < 0 ||
+      options.rightContext < 0) {
+    throw std::invalid_argument(
+        "ChunkedForward::ChunkedForward - negative chunk size or context");
+  }
+  if (options.memoryBudget > 0 && options.chunkSize == 0) {
+    throw std::invalid_argument(
+        "ChunkedForward::ChunkedForward - a memory budget requires the chunk "
+        "size of the first chunk");
+  }
+}
+
+Variable ChunkedForward::forward(const Tensor& input) {
+  DeviceChunkSource source(input, options_.inputAxis);
+  return stitch(source);
+}
+
+Variable ChunkedForward::forward(
+    const void* input,
+    const Shape& shape,
+    fl::dtype type) {
+  HostChunkSource source(input, shape, type, options_.inputAxis);
+  return stitch(source);
+}
+
+void ChunkedForward::forEachChunk(
+    const Tensor& input,
+    const ChunkCallback& callback) {
+  DeviceChunkSource source(input, options_.inputAxis);
+  run(source, callback);
+}
+
+void ChunkedForward::forEachChunk(
+    const void* input,
+    const Shape& shape,
+    fl::dtype type,
+    const ChunkCallback& callback) {
+  HostChunkSource source(input, shape, type, options_.inputAxis);
+  run(source, callback);
+}
+
+Dim ChunkedForward::chunkSize() const {
+  return chunkSize_;
+}
+
+void ChunkedForward::run(ChunkSource& source, const ChunkCallback& callback) {
+  const Dim length = source.length();
+  const int outputAxis = options_.outputAxis;
+  // the frames [first, last) of the input run for the chunk [begin, end)
+  auto window = [&](Dim begin, Dim end) {
+    return std::make_pair(
+        std::max<Dim>(begin - options_.leftContext, 0),
+        std::min(end + options_.rightContext, length));
+  };
+  auto chunkEnd = [&](Dim begin) {
+    return chunkSize_ > 0 ? std::min(begin + chunkSize_, length) : length;
+  };
+
+  Dim begin = 0;
+  Dim end = chunkEnd(begin);
+  Dim first;
+  Dim last;
+  std::tie(first, last) = window(begin, end);
+  source.prepare(first, last);
+  Dim offset = 0;
+  do {
+    auto input = fl::noGrad(source.take());
+    const bool measure = options_.memoryBudget > 0 && !measured_;
+    const int deviceId = fl::getDevice();
+    size_t heldBytes = 0;
+    if (measure) {
+      fl::detail::resetMemMgrPeakBytes(deviceId);
+      heldBytes = fl::detail::getMemMgrPeakBytes(deviceId);
+    }
+    auto output = forward_(input);
+    if (measure) {
+      const size_t peakBytes = fl::detail::getMemMgrPeakBytes(deviceId);
+      if (peakBytes > heldBytes) {
+        const double bytesPerFrame =
+            static_cast<double>(peakBytes - heldBytes) / (last - first);
+        const Dim frames =
+            static_cast<Dim>(options_.memoryBudget / bytesPerFrame) -
+            options_.leftContext - options_.rightContext;
+        chunkSize_ = std::max<Dim>(frames, 1);
+      }
+      measured_ = true;
+    }
+    checkAxis(output.shape(), outputAxis, "an output");
+
+    // the next chunk is prepared while the model runs on this one
+    const Dim nextBegin = end;
+    const Dim nextEnd = chunkEnd(nextBegin);
+    Dim nextFirst = 0;
+    Dim nextLast = 0;
+    if (nextBegin < length) {
+      std::tie(nextFirst, nextLast) = window(nextBegin, nextEnd);
+      source.prepare(nextFirst, nextLast);
+    }
+
+    // the outputs of the context, in proportion to its input frames
+    const Dim frames = output.dim(outputAxis);
+    const Dim inputFrames = std::max<Dim>(last - first, 1);
+    const Dim trimBegin =
+        ((begin - first) * frames + inputFrames / 2) / inputFrames;
+    const Dim trimEnd =
+        frames - ((last - end) * frames + inputFrames / 2) / inputFrames;
+    if (trimBegin > 0 || trimEnd < frames) {
+      output =
+          output(sliceAlong(output.ndim(), outputAxis, trimBegin, trimEnd));
+    }
+    callback(output, offset);
+    offset += trimEnd - trimBegin;
+
+    begin = nextBegin;
+    end = nextEnd;
+    first = nextFirst;
+    last = nextLast;
+  } while (begin < length);
+}
+
+Variable ChunkedForward::stitch(ChunkSource& source) {
+  std::vector<Variable> outputs;
+  run(source, [&outputs](const Variable& output, Dim /* offset */) {
+    outputs.push_back(output);
+  });
+  if (outputs.size() == 1) {
+    return outputs.front();
+  }
+  return fl::concatenate(outputs, options_.outputAxis);
+}
+
+} // namespace runtime
+} // namespace pkg
+} // namespace fl
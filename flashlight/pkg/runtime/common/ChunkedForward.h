@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/tensor/Shape.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/fl/tensor/Types.h"
+
+namespace fl {
+namespace pkg {
+namespace runtime {
+
+/**
+ * Runs a model on a long input in chunks along an axis, e.g. time, such that
+ * the memory of its activations is bounded by the size of a chunk rather than
+ * by the size of the input, and stitches the outputs of the chunks.
+ *
+ * Each chunk is run with frames of context of the input on each side, whose
+ * outputs are trimmed, such that a model whose receptive field is within the
+ * context, e.g. a convolutional acoustic model, gives the output it gives on
+ * the whole input. The output frames of a chunk are assumed to be spread
+ * evenly over its input frames, i.e. the model has a fixed stride along the
+ * axis: chunk sizes and contexts which are multiples of the stride stitch
+ * exactly.
+ *
+ * The chunk size is either fixed, or scaled to a memory budget: the peak
+ * memory of the memory manager during the forward of the first chunk, see
+ * `fl::detail::getMemMgrPeakBytes`, gives the memory per frame, assuming it
+ * is linear in the size of the chunk, from which the size of the next chunks,
+ * and of those of the next inputs, is derived. The budget thus bounds what a
+ * forward adds to the memory the memory manager holds, in use or cached.
+ * Backends which don't track memory keep the given size.
+ *
+ * The chunks of an input on the device are sliced on the device. Those of an
+ * input in host memory are uploaded one ahead: the next chunk is copied into
+ * a pinned buffer and uploaded on a dedicated stream while the model runs on
+ * the current one, as by `DeviceUploadDataset`, such that only a chunk of the
+ * input is on the device at a time.
+ *
+ * Example, for an acoustic model whose {T, C, 1, 1} input gives {N, T / 2, 1}
+ * emissions:
+ * \code
+   ChunkedForward::Options options;
+   options.inputAxis = 0;
+   options.outputAxis = 1;
+   options.chunkSize = 3000;
+   options.leftContext = options.rightContext = 200;
+   ChunkedForward chunked(
+       [&](const Variable& chunk) { return model->forward({chunk}).front(); },
+       options);
+   auto emissions = chunked.forward(features);
+ * \endcode
+ */
+class ChunkedForward {
+ public:
+  struct Options {
+    /// The axis of the input split into chunks
+    int inputAxis{0};
+    /// The axis of the output along which the outputs of chunks are stitched
+    int outputAxis{0};
+    /// The frames of input of a chunk, besides its context, or of the first
+    /// chunk with a budget; 0 to run whole inputs
+    Dim chunkSize{0};
+    /// The frames of context before and after each chunk
+    Dim leftContext{0};
+    Dim rightContext{0};
+    /// The bytes a forward of a chunk may add to the memory manager, to which
+    /// the chunk size is scaled; 0 for a fixed chunk size
+    size_t memoryBudget{0};
+  };
+
+  /** Runs the model on a chunk of input, with its context. */
+  using ForwardFunction = std::function<Variable(const Variable&)>;
+
+  /**
+   * Receives the output of a chunk, without the outputs of its context, and
+   * the offset of its first frame along the output axis.
+   */
+  using ChunkCallback = std::function<void(const Variable&, Dim)>;
+
+  ChunkedForward(ForwardFunction forward, const Options& options);
+
+  /**
+   * Runs the model on an input on the device.
+   * @return the output, stitched from the outputs of the chunks
+   */
+  Variable forward(const Tensor& input);
+
+  /**
+   * Runs the model on an input in host memory, whose chunks are uploaded to
+   * the current device.
+   * @param[in] input the elements of the input, in column-major order
+   * @param[in] shape the shape of the input
+   * @param[in] type the type of the input
+   * @return the output, stitched from the outputs of the chunks
+   */
+  Variable forward(const void* input, const Shape& shape, fl::dtype type);
+
+  /**
+   * Runs the model on an input on the device, passing the output of each
+   * chunk to a callback instead of keeping it, e.g. to copy it to the host.
+   */
+  void forEachChunk(const Tensor& input, const ChunkCallback& callback);
+
+  /**
+   * Runs the model on an input in host memory, passing the output of each
+   * chunk to a callback, see `forward`.
+   */
+  void forEachChunk(
+      const void* input,
+      const Shape& shape,
+      fl::dtype type,
+      const ChunkCallback& callback);
+
+  /**
+   * @return the frames of input of a chunk, besides its context, which is
+   * scaled to the budget after the first chunk with one
+   */
+  Dim chunkSize() const;
+
+ private:
+  ForwardFunction forward_;
+  Options options_;
+  Dim chunkSize_;
+  // whether the chunk size was scaled to the budget
+  bool measured_{false};
+
+  class ChunkSource;
+  class DeviceChunkSource;
+  class HostChunkSource;
+
+  void run(ChunkSource& source, const ChunkCallback& callback);
+  Variable stitch(ChunkSource& source);
+};
+
+} // namespace runtime
+} // namespace pkg
+} // namespace fl
@@ -7,6 +7,8 @@
 
 #include "flashlight/pkg/runtime/common/DistributedUtils.h"
 
+#include <algorithm>
+
 #include "flashlight/fl/flashlight.h"
 
 namespace fl {
@@ -102,6 +104,43 @@ void allreduceSet(fl::TopKMeter& mtr, Tensor& val) {
   auto valVec = val.toHostVector<int32_t>();
   mtr.set(valVec[0], valVec[1]);
 }
+
+void syncBenchmarkCache() {
+  if (!fl::isDistributedInit() || fl::getWorldSize() == 1) {
+    return;
+  }
+  const int worldSize = fl::getWorldSize();
+  const int worldRank = fl::getWorldRank();
+  const auto data = fl::BenchmarkCache::serialize();
+
+  // gather the size of the serialized cache of each process, then the caches,
+  // each at the offset of its process in a buffer which is zero elsewhere
+  std::vector<int> sizes(worldSize, 0);
+  sizes[worldRank] = static_cast<int>(data.size());
+  auto sizesArr = Tensor::fromVector(sizes);
+  fl::allReduce(sizesArr);
+  sizes = sizesArr.toHostVector<int>();
+  std::vector<size_t> offsets(worldSize + 1, 0);
+  for (int i = 0; i < worldSize; ++i) {
+    offsets[i + 1] = offsets[i] + sizes[i];
+  }
+  if (offsets[worldSize] == 0) {
+    return;
+  }
+  std::vector<int> chars(offsets[worldSize], 0);
+  std::copy(data.begin(), data.end(), chars.begin() + offsets[worldRank]);
+  auto charsArr = Tensor::fromVector(chars);
+  fl::allReduce(charsArr);
+  chars = charsArr.toHostVector<int>();
+
+  // merge in rank order, such that all processes get the same options
+  for (int i = 0; i < worldSize; ++i) {
+    fl::BenchmarkCache::deserialize(
+        std::string(chars.begin() + offsets[i], chars.begin() + offsets[i + 1]),
+        /* overwrite = */ true);
+  }
+}
+
 } // namespace runtime
 } // namespace pkg
 } // namespace fl
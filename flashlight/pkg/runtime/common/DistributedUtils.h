@@ -40,6 +40,13 @@ void allreduceSet(CountMeter& mtr, Tensor& val);
 void allreduceSet(TimeMeter& mtr, Tensor& val);
 void allreduceSet(TopKMeter& mtr, Tensor& val);
 
+/**
+ * Merges the `BenchmarkCache`s of all processes, such that each process has
+ * the options benchmarked by any of them. Options benchmarked for the same key
+ * by several processes are taken from the highest rank.
+ */
+void syncBenchmarkCache();
+
 /**
  * Synchronize meters across process.
  */
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/runtime/common/ExecutionPlan.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <typeinfo>
+
+#include "flashlight/fl/tensor/Compute.h"
+
+namespace fl {
+namespace pkg {
+namespace runtime {
+
+namespace {
+
+// Whether a module keeps the shape of its input
+bool keepsShape(const Module& module) {
+  return dynamic_cast<const Sigmoid*>(&module) ||
+      dynamic_cast<const Log*>(&module) || dynamic_cast<const Tanh*>(&module) ||
+      dynamic_cast<const HardTanh*>(&module) ||
+      dynamic_cast<const ReLU*>(&module) ||
+      dynamic_cast<const ReLU6*>(&module) ||
+      dynamic_cast<const LeakyReLU*>(&module) ||
+      dynamic_cast<const PReLU*>(&module) ||
+      dynamic_cast<const ELU*>(&module) ||
+      dynamic_cast<const ThresholdReLU*>(&module) ||
+      dynamic_cast<const LogSoftmax*>(&module) ||
+      dynamic_cast<const Swish*>(&module) ||
+      dynamic_cast<const Dropout*>(&module) ||
+      dynamic_cast<const Identity*>(&module) ||
+      dynamic_cast<const BatchNorm*>(&module) ||
+      dynamic_cast<const LayerNorm*>(&module) ||
+      dynamic_cast<const Normalize*>(&module);
+}
+
+size_t alignUp(size_t value) {
+  return (value + ExecutionPlan::kAlignment - 1) / ExecutionPlan::kAlignment *
+      ExecutionPlan::kAlignment;
+}
+
+} // namespace
+
+std::optional<Shape> inferOutputShape(
+    const Module& module,
+    const Shape& inputShape) {
+  // the exact type for layers: derived ones, e.g. quantized, may differ
+  const auto& id = typeid(module);
+  if (keepsShape(module)) {
+    return inputShape;
+  } else if (id == typeid(Linear)) {
+    if (inputShape.ndim() == 0) {
+      return std::nullopt;
+    }
+    Shape output = inputShape;
+    output[0] = module.param(0).dim(0);
+    return output;
+  } else if (id == typeid(Conv2D)) {
+    return static_cast<const Conv2D&>(module).outputShape(inputShape);
+  } else if (id == typeid(Pool2D)) {
+    return static_cast<const Pool2D&>(module).outputShape(inputShape);
+  } else if (id == typeid(View)) {
+    return static_cast<const View&>(module).outputShape(inputShape);
+  } else if (id == typeid(Reorder)) {
+    return static_cast<const Reorder&>(module).outputShape(inputShape);
+  } else if (id == typeid(Padding)) {
+    const auto pad = static_cast<const Padding&>(module).getPadding();
+    if (pad.size() > inputShape.ndim()) {
+      throw std::invalid_argument(
+          "inferOutputShape - number of padding dimensions exceeds number "
+          "of input dimensions");
+    }
+    Shape output = inputShape;
+    for (size_t i = 0; i < pad.size(); ++i) {
+      output[i] += pad[i].first + pad[i].second;
+    }
+    return output;
+  } else if (id == typeid(Embedding)) {
+    std::vector<Dim> dims{module.param(0).dim(0)};
+    const auto& inputDims = inputShape.get();
+    dims.insert(dims.end(), inputDims.begin(), inputDims.end());
+    return Shape(dims);
+  } else if (id == typeid(Sequential)) {
+    auto shape = inputShape;
+    for (const auto& child : static_cast<const Sequential&>(module).modules()) {
+      auto childShape = inferOutputShape(*child, shape);
+      if (!childShape) {
+        return std::nullopt;
+      }
+      shape = *childShape;
+    }
+    return shape;
+  }
+  return std::nullopt;
+}
+
+ExecutionPlan::ExecutionPlan(
+    std::shared_ptr<Sequential> model,
+    const Shape& inputShape,
+    fl::dtype inputType /* = fl::dtype::f32 */)
+    : model_(std::move(model)),
+      inputShape_(inputShape),
+      inputType_(inputType) {
+  model_->eval();
+  auto shape = inputShape;
+  auto type = inputType;
+  for (const auto& module : model_->modules()) {
+    Step step{module, shape, type, 0, 0, true};
+    auto inferred = inferOutputShape(*module, shape);
+    if (inferred) {
+      step.shape = *inferred;
+      if (typeid(*module) == typeid(Embedding)) {
+        step.type = module->param(0).type();
+      }
+    } else {
+      // runs the module once, on an input of the shape it gets
+      auto output =
+          module->forward({noGrad(fl::full(shape, 0, type))}).front();
+      step.shape = output.shape();
+      step.type = output.type();
+      step.inferred = false;
+    }
+    step.bytes = step.shape.elements() * fl::getTypeSize(step.type);
+    shape = step.shape;
+    type = step.type;
+    steps_.push_back(std::move(step));
+  }
+  assignOffsets();
+}
+
+void ExecutionPlan::assignOffsets() {
+  // The output of step i is written by step i and read by step i + 1, so
+  // outputs conflict if their steps are at most one apart. Outputs are placed
+  // at the lowest offset free of conflicts, the largest first.
+  std::vector<size_t> order(steps_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    return steps_[a].bytes > steps_[b].bytes;
+  });
+  std::vector<bool> placed(steps_.size(), false);
+  arenaBytes_ = 0;
+  for (size_t i : order) {
+    // the conflicting buffers already placed, by offset
+    std::vector<std::pair<size_t, size_t>> taken;
+    for (size_t j = i > 0 ? i - 1 : 0; j <= i + 1 && j < steps_.size(); ++j) {
+      if (j != i && placed[j]) {
+        taken.emplace_back(steps_[j].offset, alignUp(steps_[j].bytes));
+      }
+    }
+    std::sort(taken.begin(), taken.end());
+    size_t offset = 0;
+    for (const auto& [start, bytes] : taken) {
+      if (offset + alignUp(steps_[i].bytes) <= start) {
+        break;
+      }
+      offset = std::max(offset, start + bytes);
+    }
+    steps_[i].offset = offset;
+    placed[i] = true;
+    arenaBytes_ = std::max(arenaBytes_, offset + alignUp(steps_[i].bytes));
+  }
+}
+
+const std::vector<ExecutionPlan::Step>& ExecutionPlan::steps() const {
+  return steps_;
+}
+
+size_t ExecutionPlan::arenaBytes() const {
+  return arenaBytes_;
+}
+
+size_t ExecutionPlan::totalBytes() const {
+  size_t total = 0;
+  for (const auto& step : steps_) {
+    total += alignUp(step.bytes);
+  }
+  return total;
+}
+
+void ExecutionPlan::reserve() const {
+  if (arenaBytes_ > 0) {
+    // released to the memory manager, which keeps it cached
+    Tensor arena({static_cast<Dim>(arenaBytes_)}, fl::dtype::u8);
+    fl::eval(arena);
+  }
+}
+
+Variable ExecutionPlan::forward(const Variable& input) const {
+  if (input.shape() != inputShape_ || input.type() != inputType_) {
+    throw std::invalid_argument(
+        "ExecutionPlan::forward - expects an input of shape " +
+        inputShape_.toString() + " and type " + dtypeToString(inputType_) +
+        ", got " + input.shape().toString() + " and " +
+        dtypeToString(input.type()));
+  }
+  auto output = input;
+  for (const auto& step : steps_) {
+    output = step.module->forward({output}).front();
+    if (output.shape() != step.shape) {
+      throw std::runtime_error(
+          "ExecutionPlan::forward - " + step.module->prettyString() +
+          " output shape " + output.shape().toString() +
+          " differs from the planned " + step.shape.toString());
+    }
+  }
+  return output;
+}
+
+} // namespace runtime
+} // namespace pkg
+} // namespace fl
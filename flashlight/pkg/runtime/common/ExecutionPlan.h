@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "flashlight/fl/nn/nn.h"
+
+namespace fl {
+namespace pkg {
+namespace runtime {
+
+/**
+ * Infers the shape of the output of a module for an input of a given shape,
+ * without running it. Supported are the layers whose output shape follows
+ * from their hyperparameters, e.g. `Linear`, `Conv2D`, `Pool2D`, `View`,
+ * `Reorder`, `Padding` and `Embedding`, the modules which keep the shape of
+ * their input, e.g. activations and normalizations, and `Sequential`s of
+ * them.
+ *
+ * @return the shape of the output, or nothing if the module isn't supported,
+ * e.g. a recurrent or attention layer
+ */
+std::optional<Shape> inferOutputShape(
+    const Module& module,
+    const Shape& inputShape);
+
+/**
+ * A plan to run a sequential model, e.g. built with `buildSequentialModule`,
+ * on inputs of a fixed shape: the shape and type of the output of each of its
+ * modules, and the placement of these activations in an arena, in which those
+ * which are never live at the same time share memory.
+ *
+ * The shapes are inferred with `inferOutputShape`, and the modules it doesn't
+ * support are run once when planning, on zeros. The activations produced
+ * within modules, e.g. by the layers of a `Transformer`, aren't planned.
+ *
+ * Tensor ops allocate their outputs, so the arena is reserved from the
+ * memory manager rather than written to: `reserve` allocates it at once and
+ * releases it, such that a caching memory manager serves the activations of
+ * each forward from it, instead of discovering their sizes at runtime.
+ * Activations smaller than its small block threshold are still served from
+ * its pool of small blocks.
+ *
+ * Example:
+ * \code
+   auto model = buildSequentialModule("arch.txt", nFeatures, nClasses);
+   ExecutionPlan plan(model, {T, 1, nFeatures, B});
+   plan.reserve();
+   auto output = plan.forward(noGrad(input));
+ * \endcode
+ */
+class ExecutionPlan {
+ public:
+  /** The output of a module of the plan. */
+  struct Step {
+    std::shared_ptr<Module> module;
+    Shape shape;
+    fl::dtype type;
+    size_t bytes;
+    // in the arena
+    size_t offset;
+    // whether the shape was inferred without running the module
+    bool inferred;
+  };
+
+  /** The alignment of the activations in the arena, in bytes. */
+  static constexpr size_t kAlignment = 512;
+
+  /**
+   * Plans a model, which is put in eval mode.
+   *
+   * @param model the model to plan
+   * @param inputShape the shape of the inputs of the model
+   * @param inputType the type of the inputs of the model
+   */
+  ExecutionPlan(
+      std::shared_ptr<Sequential> model,
+      const Shape& inputShape,
+      fl::dtype inputType = fl::dtype::f32);
+
+  const std::vector<Step>& steps() const;
+
+  /** @return the size of the arena, the peak memory of the activations. */
+  size_t arenaBytes() const;
+
+  /** @return the memory of the activations, if none were reused. */
+  size_t totalBytes() const;
+
+  /**
+   * Allocates the arena on the current device in a single allocation, and
+   * releases it to the memory manager for the activations of the next
+   * forwards.
+   */
+  void reserve() const;
+
+  /**
+   * Runs the model on an input of the planned shape and type, checking the
+   * shape of each activation against the plan.
+   */
+  Variable forward(const Variable& input) const;
+
+ private:
+  std::shared_ptr<Sequential> model_;
+  Shape inputShape_;
+  fl::dtype inputType_;
+  std::vector<Step> steps_;
+  size_t arenaBytes_{0};
+
+  void assignOffsets();
+};
+
+} // namespace runtime
+} // namespace pkg
+} // namespace fl
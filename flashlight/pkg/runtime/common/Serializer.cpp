@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/runtime/common/Serializer.h"
+
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+namespace fl {
+namespace pkg {
+namespace runtime {
+
+namespace {
+
+// Writes a file of a unique name in the same directory, then moves it over
+// the destination
+void writeAtomically(const fs::path& filepath, const std::string& data) {
+  auto tmpPath = filepath;
+  tmpPath += ".tmp" + std::to_string(std::random_device()());
+  try {
+    {
+      std::ofstream file(tmpPath, std::ios::binary);
+      if (!file.is_open()) {
+        throw std::runtime_error(
+            "failed to open file for writing: " + tmpPath.string());
+      }
+      file.write(data.data(), data.size());
+      if (!file) {
+        throw std::runtime_error("failed to write file: " + tmpPath.string());
+      }
+    }
+    fs::rename(tmpPath, filepath);
+  } catch (const std::exception& ex) {
+    std::error_code ec;
+    fs::remove(tmpPath, ec);
+    FL_LOG(fl::LogLevel::ERROR)
+        << "Error while saving \"" << filepath << "\": " << ex.what() << "\n";
+    throw;
+  }
+}
+
+} // namespace
+
+AsyncSerializer::~AsyncSerializer() {
+  try {
+    wait();
+  } catch (const std::exception& ex) {
+    FL_LOG(fl::LogLevel::ERROR)
+        << "AsyncSerializer: saving failed: " << ex.what();
+  }
+}
+
+void AsyncSerializer::wait() {
+  if (pending_.valid()) {
+    pending_.get();
+  }
+}
+
+void AsyncSerializer::write(
+    std::vector<fs::path> filepaths,
+    std::string data) {
+  pending_ = std::async(
+      std::launch::async,
+      [filepaths = std::move(filepaths), data = std::move(data)]() {
+        for (const auto& filepath : filepaths) {
+          fl::retryWithBackoff(
+              std::chrono::seconds(1),
+              2.0,
+              6,
+              writeAtomically,
+              filepath,
+              data); // max wait 31s
+        }
+      });
+}
+
+} // namespace runtime
+} // namespace pkg
+} // namespace fl
@@ -9,8 +9,11 @@
 #pragma once
 
 #include <chrono>
+#include <future>
+#include <sstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/fl/flashlight.h"
@@ -86,6 +89,68 @@ struct Serializer {
     }
   }
 };
+
+/**
+ * Saves objects in the format of `Serializer`, from which they are loaded,
+ * with the files written in the background, e.g. such that training resumes
+ * while a checkpoint is written. The objects are serialized to host memory
+ * when saved, so they can be modified right after, and each file is written
+ * under a temporary name then renamed, such that readers never see a partial
+ * file.
+ *
+ * Example:
+ * \code
+   AsyncSerializer serializer;
+   serializer.save({"/checkpoints/model.bin"}, version, network, optimizer);
+   // ... continue training while the file is written
+   serializer.wait();
+ * \endcode
+ */
+class AsyncSerializer {
+ public:
+  AsyncSerializer() = default;
+
+  /** Waits for the pending save, logging its error, if any. */
+  ~AsyncSerializer();
+
+  AsyncSerializer(const AsyncSerializer&) = delete;
+  AsyncSerializer& operator=(const AsyncSerializer&) = delete;
+
+  /**
+   * Serializes objects, after waiting for the previous save, and writes them
+   * to files in the background.
+   *
+   * @param[in] filepaths the files to write the objects to, e.g. the last and
+   * the best checkpoints of a training
+   * @param[in] version the version of the objects, as with `Serializer::save`
+   * @param[in] args the objects to save
+   */
+  template <class... Args>
+  void save(
+      const std::vector<fs::path>& filepaths,
+      const std::string& version,
+      const Args&... args) {
+    wait();
+    std::ostringstream buffer;
+    {
+      cereal::BinaryOutputArchive ar(buffer);
+      ar(version);
+      ar(args...);
+    }
+    write(filepaths, buffer.str());
+  }
+
+  /**
+   * Waits for the pending save to be written, and rethrows its error, if any.
+   */
+  void wait();
+
+ private:
+  void write(std::vector<fs::path> filepaths, std::string data);
+
+  std::future<void> pending_;
+};
+
 } // namespace runtime
 } // namespace pkg
 } // namespace fl
@@ -8,11 +8,28 @@
 
 #include "flashlight/pkg/runtime/plugin/ModulePlugin.h"
 
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/pkg/runtime/plugin/PluginCache.h"
+
 namespace fl {
 namespace pkg {
 namespace runtime {
 
-ModulePlugin::ModulePlugin(const std::string& name) : fl::Plugin(name) {
+namespace {
+
+// Compiles plugin sources with the default cache
+std::string resolvePlugin(const std::string& name) {
+  const auto extension = fs::path(name).extension();
+  if (extension == ".cpp" || extension == ".cc" || extension == ".cxx") {
+    return PluginCache().get(name).string();
+  }
+  return name;
+}
+
+} // namespace
+
+ModulePlugin::ModulePlugin(const std::string& name)
+    : fl::Plugin(resolvePlugin(name)) {
   arch_ = getSymbol<w2l_module_plugin_t>("createModule");
 }
 
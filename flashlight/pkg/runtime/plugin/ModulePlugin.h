@@ -19,6 +19,11 @@ typedef Module* (*w2l_module_plugin_t)(int64_t nFeatures, int64_t nClasses);
 
 class ModulePlugin : public Plugin {
  public:
+  /**
+   * Loads a plugin defining `createModule`, from a shared library or from a
+   * source file (`.cpp`, `.cc` or `.cxx`), compiled with the default
+   * `PluginCache` if not in it.
+   */
   explicit ModulePlugin(const std::string& name);
   std::shared_ptr<fl::Module> arch(int64_t nFeatures, int64_t nClasses);
 
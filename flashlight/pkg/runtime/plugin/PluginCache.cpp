@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/runtime/plugin/PluginCache.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include <glog/logging.h>
+
+#include "flashlight/fl/common/Utils.h"
+// generated by CMake: FL_PLUGIN_BUILD_ID and FL_PLUGIN_COMPILE_COMMAND
+#include "flashlight/pkg/runtime/plugin/PluginCacheConfig.h"
+
+namespace fl {
+namespace pkg {
+namespace runtime {
+
+namespace {
+
+// FNV-1a, which is enough to address the few plugins of a cache
+uint64_t hash(const std::string& data, uint64_t seed = 14695981039346656037u) {
+  for (unsigned char c : data) {
+    seed = (seed ^ c) * 1099511628211u;
+  }
+  return seed;
+}
+
+std::string quote(const std::string& arg) {
+  std::string quoted = "'";
+  for (char c : arg) {
+    quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+  }
+  return quoted + "'";
+}
+
+std::string readFile(const fs::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error(
+        "PluginCache - can't read plugin source " + path.string());
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+} // namespace
+
+PluginCache::PluginCache(
+    fs::path directory /* = defaultDirectory() */,
+    std::string compileCommand /* = defaultCompileCommand() */)
+    : directory_(std::move(directory)),
+      compileCommand_(std::move(compileCommand)) {}
+
+fs::path PluginCache::path(const fs::path& source) const {
+  uint64_t key = hash(buildId());
+  key = hash(std::string(1, '\0') + compileCommand_, key);
+  key = hash(std::string(1, '\0') + readFile(source), key);
+  std::ostringstream name;
+  name << source.stem().string() << "-" << std::hex << std::setw(16)
+       << std::setfill('0') << key << ".so";
+  return directory_ / name.str();
+}
+
+fs::path PluginCache::get(const fs::path& source) const {
+  const auto target = path(source);
+  if (fs::exists(target)) {
+    return target;
+  }
+  fs::create_directories(directory_);
+
+  // compiled beside the destination, then moved over it, such that
+  // concurrent jobs never load a partial plugin
+  const auto suffix = ".tmp" + std::to_string(std::random_device()());
+  auto output = target;
+  output += suffix;
+  auto abiSource = target;
+  abiSource += suffix + ".cpp";
+  {
+    std::ofstream file(abiSource);
+    file << "#include \"flashlight/fl/common/Plugin.h\"\n"
+         << "FL_PLUGIN_DEFINE_ABI()\n";
+    if (!file) {
+      throw std::runtime_error(
+          "PluginCache::get - can't write " + abiSource.string());
+    }
+  }
+  const auto command = compileCommand_ + " -o " + quote(output.string()) +
+      " " + quote(source.string()) + " " + quote(abiSource.string());
+  LOG(INFO) << "Compiling plugin " << source << " into " << target;
+  const int status = std::system(command.c_str());
+  fs::remove(abiSource);
+  if (status != 0) {
+    fs::remove(output);
+    throw std::runtime_error(
+        "PluginCache::get - compiling plugin " + source.string() +
+        " failed with status " + std::to_string(status) + ": " + command);
+  }
+  fs::rename(output, target);
+  return target;
+}
+
+const fs::path& PluginCache::directory() const {
+  return directory_;
+}
+
+const std::string& PluginCache::compileCommand() const {
+  return compileCommand_;
+}
+
+fs::path PluginCache::defaultDirectory() {
+  const auto directory = getEnvVar("FL_PLUGIN_CACHE_DIR");
+  if (!directory.empty()) {
+    return directory;
+  }
+  fs::path cache = getEnvVar("XDG_CACHE_HOME");
+  if (cache.empty()) {
+    const auto home = getEnvVar("HOME");
+    cache =
+        home.empty() ? fs::temp_directory_path() : fs::path(home) / ".cache";
+  }
+  return cache / "flashlight" / "plugins";
+}
+
+std::string PluginCache::defaultCompileCommand() {
+  return getEnvVar("FL_PLUGIN_COMPILE_COMMAND", FL_PLUGIN_COMPILE_COMMAND);
+}
+
+std::string PluginCache::buildId() {
+  return FL_PLUGIN_BUILD_ID;
+}
+
+} // namespace runtime
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "flashlight/fl/common/Filesystem.h"
+
+namespace fl {
+namespace pkg {
+namespace runtime {
+
+/**
+ * A content-addressed cache of compiled plugins, e.g. of architectures, such
+ * that jobs on the nodes sharing a cache directory compile each plugin source
+ * once rather than at every start.
+ *
+ * Compiled plugins are keyed by the hash of their source, of the id of the
+ * flashlight build and of the compile command: a plugin is recompiled when
+ * any of them changes, but not when only the headers it includes besides
+ * flashlight's do. Compiled plugins record their ABI, which `fl::Plugin`
+ * checks when loading them.
+ *
+ * Example:
+ * \code
+   PluginCache cache;
+   ModulePlugin plugin(cache.get("arch.cpp")); // compiled on a miss only
+ * \endcode
+ */
+class PluginCache {
+ public:
+  /**
+   * @param directory the directory of the compiled plugins, created if
+   * needed. It may be shared by concurrent jobs, e.g. on a network
+   * filesystem.
+   * @param compileCommand the command compiling a plugin, to which the output
+   * and the sources are appended after `-o`.
+   */
+  explicit PluginCache(
+      fs::path directory = defaultDirectory(),
+      std::string compileCommand = defaultCompileCommand());
+
+  /**
+   * Returns the compiled plugin of a source, compiling it first if it isn't
+   * in the cache.
+   *
+   * @param source the source file of the plugin
+   * @return the path of the shared library of the plugin
+   */
+  fs::path get(const fs::path& source) const;
+
+  /**
+   * @return the path the compiled plugin of a source has in the cache, which
+   * may not exist yet
+   */
+  fs::path path(const fs::path& source) const;
+
+  const fs::path& directory() const;
+
+  const std::string& compileCommand() const;
+
+  /**
+   * @return `$FL_PLUGIN_CACHE_DIR` if set, else `flashlight/plugins` in the
+   * user's cache directory, `$XDG_CACHE_HOME` or `~/.cache`.
+   */
+  static fs::path defaultDirectory();
+
+  /**
+   * @return `$FL_PLUGIN_COMPILE_COMMAND` if set, else a command compiling
+   * with the compiler, compile definitions and include directories of this
+   * flashlight build.
+   */
+  static std::string defaultCompileCommand();
+
+  /** @return the id of this flashlight build: its version and commit. */
+  static std::string buildId();
+
+ private:
+  fs::path directory_;
+  std::string compileCommand_;
+};
+
+} // namespace runtime
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,389 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/runtime/serving/InferenceServer.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "flashlight/fl/autograd/InferenceMode.h"
+#include "flashlight/fl/autograd/Variable.h"
+#include "flashlight/fl/common/threadpool/ThreadPool.h"
+#include "flashlight/fl/runtime/Device.h"
+#include "flashlight/fl/runtime/Stream.h"
+#include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/fl/tensor/Index.h"
+
+namespace fl {
+namespace pkg {
+namespace runtime {
+
+namespace {
+
+// the stream of the worker thread of a server, if any
+thread_local std::shared_ptr<Stream> workerStream;
+
+// Pads a tensor to a shape, but along its last axis, with a value
+Tensor padTo(const Tensor& tensor, const Shape& shape, double value) {
+  std::vector<std::pair<int, int>> padWidths(tensor.ndim(), {0, 0});
+  bool padded = false;
+  for (int d = 0; d + 1 < tensor.ndim(); ++d) {
+    padWidths[d].second = shape[d] - tensor.dim(d);
+    padded = padded || padWidths[d].second > 0;
+  }
+  if (!padded) {
+    return tensor;
+  }
+  auto result = fl::pad(tensor, padWidths);
+  if (value != 0) {
+    // 1 in the padding, 0 elsewhere, such that values are kept exactly
+    auto mask =
+        1 - fl::pad(fl::full(tensor.shape(), 1, tensor.type()), padWidths);
+    result = result + mask * value;
+  }
+  return result;
+}
+
+} // namespace
+
+ModuleInferenceModel::ModuleInferenceModel(
+    std::shared_ptr<Module> module,
+    double padValue /* = 0 */)
+    : module_(std::move(module)), padValue_(padValue) {
+  if (!module_) {
+    throw std::invalid_argument(
+        "ModuleInferenceModel::ModuleInferenceModel - module can't be null");
+  }
+  module_->eval();
+}
+
+std::vector<std::vector<Tensor>> ModuleInferenceModel::run(
+    const std::vector<std::vector<Tensor>>& batch) {
+  if (batch.empty()) {
+    return {};
+  }
+  const size_t numInputs = batch.front().size();
+  for (const auto& request : batch) {
+    if (request.size() != numInputs) {
+      throw std::invalid_argument(
+          "ModuleInferenceModel::run - the requests of a batch must have "
+          "the same number of inputs");
+    }
+  }
+
+  // the number of samples of each request, along the last axis of its inputs
+  std::vector<Dim> sizes;
+  std::vector<Variable> inputs;
+  for (size_t i = 0; i < numInputs; ++i) {
+    const int ndim = batch.front()[i].ndim();
+    if (ndim == 0) {
+      throw std::invalid_argument(
+          "ModuleInferenceModel::run - can't batch scalar inputs");
+    }
+    Shape largest = batch.front()[i].shape();
+    for (const auto& request : batch) {
+      if (request[i].ndim() != ndim) {
+        throw std::invalid_argument(
+            "ModuleInferenceModel::run - the inputs of the requests of a "
+            "batch must have the same number of dimensions");
+      }
+      for (int d = 0; d + 1 < ndim; ++d) {
+        largest[d] = std::max(largest[d], request[i].dim(d));
+      }
+    }
+    std::vector<Tensor> padded;
+    for (size_t r = 0; r < batch.size(); ++r) {
+      const auto& input = batch[r][i];
+      if (i == 0) {
+        sizes.push_back(input.dim(ndim - 1));
+      } else if (input.dim(ndim - 1) != sizes[r]) {
+        throw std::invalid_argument(
+            "ModuleInferenceModel::run - the inputs of a request must have "
+            "the same size along their last axis");
+      }
+      padded.push_back(padTo(input, largest, padValue_));
+    }
+    inputs.emplace_back(
+        padded.size() == 1 ? padded.front()
+                           : fl::concatenate(padded, ndim - 1),
+        false);
+  }
+
+  std::vector<Variable> outputs;
+  {
+    InferenceModeGuard guard;
+    outputs = module_->forward(inputs);
+  }
+
+  std::vector<std::vector<Tensor>> results(batch.size());
+  for (const auto& output : outputs) {
+    const auto& tensor = output.tensor();
+    if (tensor.ndim() == 0) {
+      throw std::invalid_argument(
+          "ModuleInferenceModel::run - can't split scalar outputs");
+    }
+    const auto batchDim = tensor.ndim() - 1;
+    Dim start = 0;
+    for (size_t r = 0; r < batch.size(); ++r) {
+      std::vector<Index> indices(batchDim, fl::span);
+      indices.emplace_back(fl::range(start, start + sizes[r]));
+      results[r].push_back(tensor(indices));
+      start += sizes[r];
+    }
+    if (start != tensor.dim(batchDim)) {
+      throw std::invalid_argument(
+          "ModuleInferenceModel::run - the outputs must have the batch size "
+          "of the inputs along their last axis");
+    }
+  }
+  return results;
+}
+
+InferenceServer::Model::Model(
+    std::string name,
+    std::shared_ptr<InferenceModel> model,
+    ModelOptions options)
+    : name(std::move(name)),
+      model(std::move(model)),
+      options(options),
+      requests(MetricsRegistry::getInstance().counter(
+          "fl_serving_requests_total",
+          "Requests submitted to the inference server",
+          {{"model", this->name}})),
+      rejected(MetricsRegistry::getInstance().counter(
+          "fl_serving_rejected_requests_total",
+          "Requests rejected by the inference server, with a full queue",
+          {{"model", this->name}})),
+      queued(MetricsRegistry::getInstance().gauge(
+          "fl_serving_queued_requests",
+          "Requests queued to the inference server, not running yet",
+          {{"model", this->name}})),
+      runningBatches(MetricsRegistry::getInstance().gauge(
+          "fl_serving_running_batches",
+          "Batches of the inference server running",
+          {{"model", this->name}})),
+      batchSizes(MetricsRegistry::getInstance().histogram(
+          "fl_serving_batch_size",
+          "Number of requests of the batches of the inference server",
+          HistogramMetric::exponentialBounds(1, 2, 10),
+          {{"model", this->name}})),
+      latencies(MetricsRegistry::getInstance().histogram(
+          "fl_serving_latency_seconds",
+          "Time from the submission of requests to their results",
+          HistogramMetric::exponentialBounds(1e-4, 2, 18),
+          {{"model", this->name}})) {}
+
+InferenceServer::InferenceServer(
+    size_t numThreads,
+    std::vector<std::shared_ptr<Stream>> streams /* = {} */)
+    : streams_(std::move(streams)) {
+  if (numThreads == 0) {
+    throw std::invalid_argument(
+        "InferenceServer::InferenceServer - numThreads must be positive");
+  }
+  for (const auto& stream : streams_) {
+    if (!stream) {
+      throw std::invalid_argument(
+          "InferenceServer::InferenceServer - streams can't be null");
+    }
+    // threads select their stream concurrently, with the device only
+    // reading its streams
+    stream->device().addStream(stream);
+  }
+  pool_ = std::make_unique<ThreadPool>(numThreads, [this](size_t id) {
+    if (!streams_.empty()) {
+      workerStream = streams_[id % streams_.size()];
+      workerStream->device().setActive();
+      workerStream->device().setCurrentStream(workerStream);
+    }
+  });
+}
+
+InferenceServer::~InferenceServer() {
+  stop();
+}
+
+void InferenceServer::addModel(
+    const std::string& name,
+    std::shared_ptr<InferenceModel> model,
+    ModelOptions options) {
+  if (!model) {
+    throw std::invalid_argument(
+        "InferenceServer::addModel - model can't be null");
+  }
+  if (options.maxBatchSize == 0 || options.maxConcurrency == 0) {
+    throw std::invalid_argument(
+        "InferenceServer::addModel - the maximum batch size and concurrency "
+        "must be positive");
+  }
+  std::lock_guard<std::mutex> lock(modelsMutex_);
+  if (stopped_) {
+    throw std::runtime_error("InferenceServer::addModel - server is stopped");
+  }
+  if (models_.count(name) != 0) {
+    throw std::invalid_argument(
+        "InferenceServer::addModel - model " + name + " was already added");
+  }
+  auto entry = std::make_unique<Model>(name, std::move(model), options);
+  auto& added = *entry;
+  models_.emplace(name, std::move(entry));
+  added.batcher = std::thread([this, &added]() { batch(added); });
+}
+
+void InferenceServer::addModel(
+    const std::string& name,
+    std::shared_ptr<InferenceModel> model) {
+  addModel(name, std::move(model), ModelOptions());
+}
+
+std::future<std::vector<Tensor>> InferenceServer::submit(
+    const std::string& name,
+    std::vector<Tensor> inputs) {
+  auto& model = getModel(name);
+  Request request;
+  request.inputs = std::move(inputs);
+  request.arrival = Clock::now();
+  auto result = request.promise.get_future();
+  {
+    std::lock_guard<std::mutex> lock(model.mutex);
+    if (model.stopping) {
+      throw std::runtime_error("InferenceServer::submit - server is stopped");
+    }
+    if (model.queue.size() >= model.options.maxQueueSize) {
+      model.rejected.inc();
+      throw std::runtime_error(
+          "InferenceServer::submit - the queue of model " + name +
+          " is full");
+    }
+    model.queue.push_back(std::move(request));
+    model.requests.inc();
+    model.queued.set(model.queue.size());
+  }
+  model.changed.notify_all();
+  return result;
+}
+
+size_t InferenceServer::queueSize(const std::string& name) const {
+  auto& model = getModel(name);
+  std::lock_guard<std::mutex> lock(model.mutex);
+  return model.queue.size();
+}
+
+void InferenceServer::stop() {
+  std::lock_guard<std::mutex> lock(modelsMutex_);
+  stopped_ = true;
+  for (auto& [name, model] : models_) {
+    {
+      std::lock_guard<std::mutex> modelLock(model->mutex);
+      model->stopping = true;
+    }
+    model->changed.notify_all();
+  }
+  // the batchers return once the batches of their model ran
+  for (auto& [name, model] : models_) {
+    if (model->batcher.joinable()) {
+      model->batcher.join();
+    }
+  }
+}
+
+InferenceServer::Model& InferenceServer::getModel(
+    const std::string& name) const {
+  std::lock_guard<std::mutex> lock(modelsMutex_);
+  auto it = models_.find(name);
+  if (it == models_.end()) {
+    throw std::invalid_argument("InferenceServer - unknown model " + name);
+  }
+  return *it->second;
+}
+
+void InferenceServer::batch(Model& model) {
+  const auto& options = model.options;
+  std::unique_lock<std::mutex> lock(model.mutex);
+  while (true) {
+    // requests queue while all the batches the model may run are running
+    model.changed.wait(lock, [&model, &options]() {
+      return model.queue.empty()
+          ? model.stopping
+          : model.running < options.maxConcurrency;
+    });
+    if (model.queue.empty()) {
+      model.changed.wait(lock, [&model]() { return model.running == 0; });
+      return;
+    }
+    // waits for the batch to fill, until its oldest request is due
+    const auto deadline = model.queue.front().arrival + options.maxDelay;
+    model.changed.wait_until(lock, deadline, [&model, &options]() {
+      return model.queue.size() >= options.maxBatchSize || model.stopping;
+    });
+
+    const size_t size = std::min(model.queue.size(), options.maxBatchSize);
+    auto requests = std::make_shared<std::vector<Request>>();
+    requests->reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+      requests->push_back(std::move(model.queue.front()));
+      model.queue.pop_front();
+    }
+    ++model.running;
+    model.queued.set(model.queue.size());
+    model.runningBatches.set(model.running);
+    model.batchSizes.observe(size);
+
+    lock.unlock();
+    pool_->enqueue(
+        [this, &model, requests]() { run(model, std::move(*requests)); });
+    lock.lock();
+  }
+}
+
+void InferenceServer::run(Model& model, std::vector<Request> requests) {
+  std::vector<std::vector<Tensor>> inputs;
+  inputs.reserve(requests.size());
+  for (auto& request : requests) {
+    inputs.push_back(std::move(request.inputs));
+  }
+  try {
+    auto outputs = model.model->run(inputs);
+    if (outputs.size() != requests.size()) {
+      throw std::runtime_error(
+          "InferenceServer - model " + model.name + " returned " +
+          std::to_string(outputs.size()) + " outputs for a batch of " +
+          std::to_string(requests.size()) + " requests");
+    }
+    // such that the outputs can be used on any stream once returned
+    if (workerStream) {
+      workerStream->sync();
+    } else {
+      fl::sync();
+    }
+    for (size_t i = 0; i < requests.size(); ++i) {
+      requests[i].promise.set_value(std::move(outputs[i]));
+    }
+  } catch (...) {
+    const auto error = std::current_exception();
+    for (auto& request : requests) {
+      request.promise.set_exception(error);
+    }
+  }
+
+  const auto now = Clock::now();
+  for (const auto& request : requests) {
+    model.latencies.observe(
+        std::chrono::duration<double>(now - request.arrival).count());
+  }
+  // notified under the lock: the model may be destroyed once the batcher
+  // sees the last batch finish
+  std::lock_guard<std::mutex> lock(model.mutex);
+  --model.running;
+  model.runningBatches.set(model.running);
+  model.changed.notify_all();
+}
+
+} // namespace runtime
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "flashlight/fl/common/Metrics.h"
+#include "flashlight/fl/nn/modules/Module.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+
+class Stream;
+class ThreadPool;
+
+namespace pkg {
+namespace runtime {
+
+/**
+ * A model served by an `InferenceServer`, which runs batches of requests.
+ * Batches of a model may run concurrently, up to its concurrency limit.
+ */
+class InferenceModel {
+ public:
+  virtual ~InferenceModel() = default;
+
+  /**
+   * Runs a batch of requests.
+   *
+   * @param[in] batch the inputs of each request
+   * @return the outputs of each request, in the order of the batch
+   */
+  virtual std::vector<std::vector<Tensor>> run(
+      const std::vector<std::vector<Tensor>>& batch) = 0;
+};
+
+/**
+ * Serves a module whose inputs and outputs are batched along their last axis,
+ * e.g. an image classifier or a language model: the inputs of the requests
+ * are padded to the largest of the batch along the other axes, concatenated
+ * along the last one, and the outputs are sliced back along it. Requests may
+ * hold several samples. The module runs in eval mode, without gradients.
+ */
+class ModuleInferenceModel : public InferenceModel {
+ public:
+  /**
+   * @param[in] module the module to serve, put in eval mode
+   * @param[in] padValue the value the inputs are padded with
+   */
+  explicit ModuleInferenceModel(
+      std::shared_ptr<Module> module,
+      double padValue = 0);
+
+  std::vector<std::vector<Tensor>> run(
+      const std::vector<std::vector<Tensor>>& batch) override;
+
+ private:
+  std::shared_ptr<Module> module_;
+  double padValue_;
+};
+
+/**
+ * Serves several models, e.g. an acoustic model, a language model and an
+ * image classifier, from a process. The requests to each model are queued,
+ * and formed into batches dynamically: a batch runs once it reaches the
+ * maximum batch size of its model, or when its oldest request has waited for
+ * the maximum delay, such that batches are large under load while the latency
+ * stays bounded when idle. Batches run on a pool of threads, each of which
+ * may run on its own device stream, and results are returned as futures.
+ *
+ * Metrics are registered in the `MetricsRegistry` with a `model` label:
+ * requests, rejected requests, queue sizes, batch sizes, batches running and
+ * request latencies.
+ *
+ * Example:
+ * \code
+   auto& device = fl::DeviceManager::getInstance().getActiveDevice(
+       fl::DeviceType::CUDA);
+   InferenceServer server(
+       4, {device.getStreamFromPool(), device.getStreamFromPool()});
+   InferenceServer::ModelOptions options;
+   options.maxBatchSize = 32;
+   options.maxDelay = std::chrono::milliseconds(10);
+   server.addModel(
+       "classifier", std::make_shared<ModuleInferenceModel>(model), options);
+   auto result = server.submit("classifier", {image});
+   auto scores = result.get().front();
+ * \endcode
+ */
+class InferenceServer {
+ public:
+  /** The batching and concurrency limits of a model. */
+  struct ModelOptions {
+    /** The largest number of requests of a batch. */
+    size_t maxBatchSize{8};
+    /** The longest a request waits for its batch to fill before running. */
+    std::chrono::microseconds maxDelay{std::chrono::milliseconds(5)};
+    /** The largest number of batches of the model running at once. */
+    size_t maxConcurrency{1};
+    /** The largest number of queued requests, beyond which they're rejected. */
+    size_t maxQueueSize{1024};
+  };
+
+  /**
+   * @param[in] numThreads the number of threads running batches, shared by
+   * the models.
+   * @param[in] streams the streams the threads run on, assigned round-robin,
+   * e.g. from `Device::getStreamFromPool`. If empty, the threads use the
+   * default stream of the tensor backend.
+   */
+  explicit InferenceServer(
+      size_t numThreads,
+      std::vector<std::shared_ptr<Stream>> streams = {});
+
+  /** Stops the server, after running the queued requests. */
+  ~InferenceServer();
+
+  InferenceServer(const InferenceServer&) = delete;
+  InferenceServer& operator=(const InferenceServer&) = delete;
+
+  /**
+   * Adds a model to serve. Throws if a model of the same name was added.
+   *
+   * @param[in] name the name requests to the model are submitted to
+   * @param[in] model the model
+   * @param[in] options the batching and concurrency limits of the model
+   */
+  void addModel(
+      const std::string& name,
+      std::shared_ptr<InferenceModel> model,
+      ModelOptions options);
+
+  /** Adds a model with the default limits, see above. */
+  void addModel(const std::string& name, std::shared_ptr<InferenceModel> model);
+
+  /**
+   * Queues a request to a model. Throws if the model is unknown, if its queue
+   * is full or if the server is stopped.
+   *
+   * @param[in] name the name of the model
+   * @param[in] inputs the inputs of the request
+   * @return the future outputs of the request, which rethrows the error of
+   * the model, if any. The outputs are computed once it's ready.
+   */
+  std::future<std::vector<Tensor>> submit(
+      const std::string& name,
+      std::vector<Tensor> inputs);
+
+  /** @return the number of requests queued to a model, not running yet. */
+  size_t queueSize(const std::string& name) const;
+
+  /**
+   * Stops accepting requests, and returns once the queued ones ran. Idempotent.
+   */
+  void stop();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Request {
+    std::vector<Tensor> inputs;
+    std::promise<std::vector<Tensor>> promise;
+    Clock::time_point arrival;
+  };
+
+  struct Model {
+    std::string name;
+    std::shared_ptr<InferenceModel> model;
+    ModelOptions options;
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Request> queue;
+    size_t running{0};
+    bool stopping{false};
+    // forms the batches of the model
+    std::thread batcher;
+
+    CounterMetric& requests;
+    CounterMetric& rejected;
+    GaugeMetric& queued;
+    GaugeMetric& runningBatches;
+    HistogramMetric& batchSizes;
+    HistogramMetric& latencies;
+
+    Model(
+        std::string name,
+        std::shared_ptr<InferenceModel> model,
+        ModelOptions options);
+  };
+
+  // Forms the batches of a model until the server stops
+  void batch(Model& model);
+
+  // Runs a batch of a model on a thread of the pool
+  void run(Model& model, std::vector<Request> requests);
+
+  Model& getModel(const std::string& name) const;
+
+  std::vector<std::shared_ptr<Stream>> streams_;
+  std::unique_ptr<ThreadPool> pool_;
+
+  mutable std::mutex modelsMutex_;
+  std::unordered_map<std::string, std::unique_ptr<Model>> models_;
+  bool stopped_{false};
+};
+
+} // namespace runtime
+} // namespace pkg
+} // namespace fl
@@ -5,6 +5,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <limits>
+
 #include <gtest/gtest.h>
 
 #include "flashlight/pkg/runtime/amp/DynamicScaler.h"
@@ -13,7 +15,9 @@
 #include "flashlight/fl/autograd/Utils.h"
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/fl/nn/Init.h"
+#include "flashlight/fl/optim/optim.h"
 #include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Random.h"
 
 TEST(DynamicScalerTest, Scaling) {
   auto dynamicScaler = fl::pkg::runtime::DynamicScaler(
@@ -34,6 +38,69 @@ TEST(DynamicScalerTest, Scaling) {
   ASSERT_TRUE(allClose(loss, scaledLoss.grad()));
 }
 
+TEST(DynamicScalerTest, UnscaleMultipleParams) {
+  auto dynamicScaler = fl::pkg::runtime::DynamicScaler(
+      32, // initFactor
+      32, // maxFactor
+      100 // updateInterval
+  );
+
+  // params of several types, and one without a gradient
+  std::vector<fl::Variable> params{
+      fl::Variable(fl::rand({3, 2}), true),
+      fl::Variable(fl::rand({4}), true),
+      fl::Variable(fl::rand({2, 2}, fl::dtype::f64), true),
+      fl::Variable(fl::rand({5}), true)};
+  std::vector<fl::Tensor> grads;
+  for (size_t i = 0; i < 3; ++i) {
+    grads.push_back(fl::rand(params[i].shape(), params[i].type()));
+    params[i].addGrad(fl::Variable(grads[i] * 32, false));
+  }
+  auto foundInf = dynamicScaler.unscaleAsync(params);
+  ASSERT_TRUE(dynamicScaler.updateFromFoundInf(foundInf));
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(params[i].grad().shape(), params[i].shape());
+    ASSERT_TRUE(allClose(params[i].grad().tensor(), grads[i]));
+  }
+  ASSERT_TRUE(allClose(params[3].grad().tensor(), fl::full({5}, 0.)));
+
+  for (auto& param : params) {
+    param.zeroGrad();
+  }
+  params[1].addGrad(fl::Variable(
+      fl::full({4}, std::numeric_limits<float>::infinity()), false));
+  ASSERT_FALSE(dynamicScaler.unscale(params));
+  ASSERT_EQ(dynamicScaler.getScaleFactor(), 16);
+}
+
+TEST(DynamicScalerTest, MasterWeightsStep) {
+  auto dynamicScaler = fl::pkg::runtime::DynamicScaler(
+      32, // initFactor
+      32, // maxFactor
+      100 // updateInterval
+  );
+
+  auto param = fl::uniform({5, 5});
+  fl::MasterWeightsOptimizer opt(
+      {param}, [](const std::vector<fl::Variable>& params) {
+        return std::make_shared<fl::SGDOptimizer>(params, 1.0);
+      });
+  auto data = param.tensor().copy();
+  auto grad = fl::uniform({5, 5}).tensor();
+  param.addGrad(fl::Variable(grad * 32, false));
+  ASSERT_TRUE(dynamicScaler.step(opt));
+  ASSERT_EQ(opt.getLossScale(), 32);
+  ASSERT_TRUE(allClose(param.tensor(), data - grad));
+
+  opt.zeroGrad();
+  param.addGrad(fl::Variable(
+      fl::full({5, 5}, std::numeric_limits<float>::infinity()), false));
+  data = param.tensor().copy();
+  ASSERT_FALSE(dynamicScaler.step(opt));
+  ASSERT_EQ(dynamicScaler.getScaleFactor(), 16);
+  ASSERT_TRUE(allClose(param.tensor(), data));
+}
+
 TEST(DynamicScalerTest, Serialization) {
   auto dynamicScaler = std::make_shared<fl::pkg::runtime::DynamicScaler>(
       32, // initFactor
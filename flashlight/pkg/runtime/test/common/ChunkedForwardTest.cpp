@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/autograd/autograd.h"
+#include "flashlight/fl/nn/nn.h"
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Random.h"
+#include "flashlight/pkg/runtime/common/ChunkedForward.h"
+
+using namespace fl;
+using namespace fl::pkg::runtime;
+
+namespace {
+
+// Two convolutions over the frames of a {T, 1, 4, 1} input, whose receptive
+// field is at most 10 frames, and whose output is {T / stride, 1, 8, 1}
+std::shared_ptr<Sequential> convModel(int stride) {
+  auto model = std::make_shared<Sequential>();
+  model->add(Conv2D(4, 8, 5, 1, 1, 1, 2, 0));
+  model->add(ReLU());
+  model->add(Conv2D(8, 8, stride + 2, 1, stride, 1, 1, 0));
+  model->eval();
+  return model;
+}
+
+ChunkedForward::ForwardFunction forwardOf(std::shared_ptr<Module> model) {
+  return [model](const Variable& input) {
+    return model->forward({input}).front();
+  };
+}
+
+ChunkedForward::Options chunkOptions(Dim chunkSize, Dim context) {
+  ChunkedForward::Options options;
+  options.inputAxis = 0;
+  options.outputAxis = 0;
+  options.chunkSize = chunkSize;
+  options.leftContext = context;
+  options.rightContext = context;
+  return options;
+}
+
+} // namespace
+
+TEST(ChunkedForwardTest, MatchesWholeInput) {
+  auto model = convModel(1);
+  auto input = fl::randn({100, 1, 4, 1});
+  auto expected = model->forward(noGrad(input));
+
+  // chunks which do and don't divide the input
+  for (Dim chunkSize : {10, 25, 33, 100, 200}) {
+    ChunkedForward chunked(forwardOf(model), chunkOptions(chunkSize, 4));
+    auto output = chunked.forward(input);
+    ASSERT_EQ(output.shape(), expected.shape());
+    ASSERT_TRUE(allClose(output.tensor(), expected.tensor(), 1e-5));
+  }
+}
+
+TEST(ChunkedForwardTest, Strided) {
+  auto model = convModel(2);
+  auto input = fl::randn({64, 1, 4, 1});
+  auto expected = model->forward(noGrad(input));
+  ASSERT_EQ(expected.dim(0), 32);
+
+  ChunkedForward chunked(forwardOf(model), chunkOptions(16, 6));
+  auto output = chunked.forward(input);
+  ASSERT_EQ(output.shape(), expected.shape());
+  ASSERT_TRUE(allClose(output.tensor(), expected.tensor(), 1e-5));
+}
+
+TEST(ChunkedForwardTest, HostInput) {
+  auto model = convModel(1);
+  auto input = fl::randn({50, 1, 4, 1});
+  auto expected = model->forward(noGrad(input));
+  const auto hostInput = input.toHostVector<float>();
+
+  ChunkedForward chunked(forwardOf(model), chunkOptions(12, 4));
+  auto output =
+      chunked.forward(hostInput.data(), input.shape(), fl::dtype::f32);
+  ASSERT_EQ(output.shape(), expected.shape());
+  ASSERT_TRUE(allClose(output.tensor(), expected.tensor(), 1e-5));
+}
+
+TEST(ChunkedForwardTest, ForEachChunk) {
+  auto model = convModel(1);
+  auto input = fl::randn({45, 1, 4, 1});
+  auto expected = model->forward(noGrad(input));
+
+  ChunkedForward chunked(forwardOf(model), chunkOptions(10, 4));
+  std::vector<Dim> offsets;
+  Dim frames = 0;
+  chunked.forEachChunk(input, [&](const Variable& output, Dim offset) {
+    offsets.push_back(offset);
+    ASSERT_TRUE(allClose(
+        output.tensor(),
+        expected.tensor()(fl::range(offset, offset + output.dim(0))),
+        1e-5));
+    frames += output.dim(0);
+  });
+  ASSERT_EQ(offsets, std::vector<Dim>({0, 10, 20, 30, 40}));
+  ASSERT_EQ(frames, 45);
+}
+
+TEST(ChunkedForwardTest, WholeInputWithoutChunkSize) {
+  auto model = convModel(1);
+  auto input = fl::randn({30, 1, 4, 1});
+  int calls = 0;
+  ChunkedForward chunked(
+      [&](const Variable& chunk) {
+        ++calls;
+        return model->forward(chunk);
+      },
+      chunkOptions(0, 4));
+  auto output = chunked.forward(input);
+  ASSERT_EQ(calls, 1);
+  ASSERT_EQ(output.dim(0), 30);
+}
+
+TEST(ChunkedForwardTest, MemoryBudget) {
+  auto model = convModel(1);
+  auto input = fl::randn({100, 1, 4, 1});
+  auto expected = model->forward(noGrad(input));
+
+  auto options = chunkOptions(20, 4);
+  options.memoryBudget = 1 << 20;
+  ChunkedForward chunked(forwardOf(model), options);
+  auto output = chunked.forward(input);
+  // the size is scaled if the backend tracks memory, else kept
+  ASSERT_GT(chunked.chunkSize(), 0);
+  ASSERT_EQ(output.shape(), expected.shape());
+  ASSERT_TRUE(allClose(output.tensor(), expected.tensor(), 1e-5));
+}
+
+TEST(ChunkedForwardTest, InvalidOptions) {
+  auto model = convModel(1);
+  EXPECT_THROW(
+      ChunkedForward(nullptr, chunkOptions(10, 0)), std::invalid_argument);
+  EXPECT_THROW(
+      ChunkedForward(forwardOf(model), chunkOptions(-1, 0)),
+      std::invalid_argument);
+  auto options = chunkOptions(0, 0);
+  options.memoryBudget = 1024;
+  EXPECT_THROW(
+      ChunkedForward(forwardOf(model), options), std::invalid_argument);
+
+  auto input = fl::randn({3, 4});
+  auto badAxis = chunkOptions(10, 0);
+  badAxis.inputAxis = 2;
+  ChunkedForward badChunked(forwardOf(model), badAxis);
+  EXPECT_THROW(badChunked.forward(input), std::invalid_argument);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
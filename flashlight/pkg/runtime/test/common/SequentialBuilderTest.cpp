@@ -10,6 +10,7 @@
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/fl/tensor/Init.h"
 #include "flashlight/fl/tensor/Random.h"
+#include "flashlight/pkg/runtime/common/ExecutionPlan.h"
 #include "flashlight/pkg/runtime/common/SequentialBuilder.h"
 
 using namespace fl;
@@ -74,6 +75,47 @@ TEST(SequentialBuilderTest, Serialization) {
   ASSERT_TRUE(allClose(outputl.tensor(), output.tensor()));
 }
 
+TEST(SequentialBuilderTest, ExecutionPlan) {
+  auto model = std::make_shared<Sequential>();
+  model->add(Conv2D(3, 8, 3, 3, 1, 1, PaddingMode::SAME, PaddingMode::SAME));
+  model->add(ReLU());
+  model->add(Pool2D(2, 2, 2, 2));
+  model->add(View({-1, 0}));
+  model->add(Linear(8 * 4 * 4, 10));
+  // not inferred: run when planning
+  model->add(Transform([](const Variable& in) { return fl::tanh(in); }));
+  model->add(LogSoftmax());
+
+  const Shape inputShape({8, 8, 3, 2});
+  ExecutionPlan plan(model, inputShape);
+  const auto& steps = plan.steps();
+  ASSERT_EQ(steps.size(), model->modules().size());
+  ASSERT_EQ(steps[0].shape, Shape({8, 8, 8, 2}));
+  ASSERT_EQ(steps[2].shape, Shape({4, 4, 8, 2}));
+  ASSERT_EQ(steps[3].shape, Shape({128, 2}));
+  ASSERT_EQ(steps[4].shape, Shape({10, 2}));
+  ASSERT_TRUE(steps[4].inferred);
+  ASSERT_FALSE(steps[5].inferred);
+  ASSERT_EQ(steps[6].shape, Shape({10, 2}));
+
+  // activations live at the same time don't overlap
+  for (size_t i = 0; i + 1 < steps.size(); ++i) {
+    const auto& a = steps[i];
+    const auto& b = steps[i + 1];
+    ASSERT_TRUE(
+        a.offset + a.bytes <= b.offset || b.offset + b.bytes <= a.offset);
+  }
+  ASSERT_LE(plan.arenaBytes(), plan.totalBytes());
+  ASSERT_LT(plan.arenaBytes(), plan.totalBytes());
+
+  auto input = noGrad(fl::randn(inputShape));
+  plan.reserve();
+  auto output = plan.forward(input);
+  ASSERT_TRUE(allClose(output.tensor(), model->forward(input).tensor()));
+  ASSERT_THROW(
+      plan.forward(noGrad(fl::randn({8, 8, 3, 1}))), std::invalid_argument);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
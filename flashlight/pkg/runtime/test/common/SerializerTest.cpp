@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/nn/nn.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/pkg/runtime/common/Serializer.h"
+
+using namespace fl;
+using namespace fl::pkg::runtime;
+
+TEST(SerializerTest, AsyncSave) {
+  const fs::path dir = fs::temp_directory_path() / "async_serializer_test";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  const std::vector<fs::path> paths = {dir / "last.bin", dir / "best.bin"};
+
+  std::shared_ptr<Module> model = std::make_shared<Linear>(4, 3);
+  const auto weight = model->param(0).tensor().copy();
+  int epoch = 7;
+  {
+    AsyncSerializer serializer;
+    serializer.save(paths, "1", model, epoch);
+    // the saved state is a snapshot
+    model->setParams(Variable(fl::full({3, 4}, 1.), true), 0);
+    epoch = 8;
+    serializer.wait();
+    // waits for the previous save
+    serializer.save({dir / "next.bin"}, "2", model, epoch);
+  }
+
+  for (const auto& path : paths) {
+    std::string version;
+    std::shared_ptr<Module> loaded;
+    int loadedEpoch;
+    Serializer::load(path, version, loaded, loadedEpoch);
+    ASSERT_EQ(version, "1");
+    ASSERT_EQ(loadedEpoch, 7);
+    ASSERT_TRUE(allClose(loaded->param(0).tensor(), weight));
+  }
+  std::string version;
+  std::shared_ptr<Module> loaded;
+  int loadedEpoch;
+  Serializer::load(dir / "next.bin", version, loaded, loadedEpoch);
+  ASSERT_EQ(version, "2");
+  ASSERT_EQ(loadedEpoch, 8);
+  // the files are renamed once written
+  ASSERT_EQ(std::distance(fs::directory_iterator(dir), {}), 3);
+  fs::remove_all(dir);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
@@ -12,10 +12,13 @@
 #include "flashlight/fl/contrib/modules/modules.h"
 #include "flashlight/fl/flashlight.h"
 #include "flashlight/pkg/runtime/plugin/ModulePlugin.h"
+#include "flashlight/pkg/runtime/plugin/PluginCache.h"
 
 using namespace fl;
+using fl::pkg::runtime::PluginCache;
 
 fs::path pluginDir;
+fs::path pluginSrcDir;
 
 TEST(ModulePluginTest, ModulePlugin) {
   const fs::path libfile = pluginDir / "test_module_plugin.so";
@@ -39,6 +42,35 @@ TEST(ModulePluginTest, ModulePlugin) {
   ASSERT_EQ(output.shape(), Shape({noutput, batchsize}));
 }
 
+TEST(ModulePluginTest, PluginCache) {
+  const auto cacheDir = fs::temp_directory_path() / "fl_plugin_cache_test";
+  fs::remove_all(cacheDir);
+  const auto source = pluginSrcDir / "test_module_plugin.cpp";
+
+  PluginCache cache(cacheDir);
+  const auto compiled = cache.get(source);
+  ASSERT_EQ(compiled, cache.path(source));
+  ASSERT_TRUE(fs::exists(compiled));
+  // a hit doesn't recompile
+  const auto writeTime = fs::last_write_time(compiled);
+  ASSERT_EQ(cache.get(source), compiled);
+  ASSERT_EQ(fs::last_write_time(compiled), writeTime);
+
+  // the compile command is part of the key
+  PluginCache failing(cacheDir, "false");
+  ASSERT_NE(failing.path(source), compiled);
+  ASSERT_THROW(failing.get(source), std::runtime_error);
+  ASSERT_FALSE(fs::exists(failing.path(source)));
+
+  {
+    fl::pkg::runtime::ModulePlugin plugin(compiled);
+    auto model = plugin.arch(8, 2);
+    auto output = model->forward({noGrad(fl::randn({8, 3}))}).front();
+    ASSERT_EQ(output.shape(), Shape({2, 3}));
+  }
+  fs::remove_all(cacheDir);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
@@ -47,6 +79,9 @@ int main(int argc, char** argv) {
 #ifdef PLUGINDIR
   pluginDir = PLUGINDIR;
 #endif
+#ifdef PLUGINSRCDIR
+  pluginSrcDir = PLUGINSRCDIR;
+#endif
 
   return RUN_ALL_TESTS();
 }
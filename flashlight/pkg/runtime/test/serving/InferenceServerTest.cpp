@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/autograd/autograd.h"
+#include "flashlight/fl/nn/nn.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Random.h"
+#include "flashlight/pkg/runtime/serving/InferenceServer.h"
+
+using namespace fl;
+using namespace fl::pkg::runtime;
+
+namespace {
+
+// Doubles its inputs, recording the sizes of its batches
+class DoublingModel : public InferenceModel {
+ public:
+  std::vector<std::vector<Tensor>> run(
+      const std::vector<std::vector<Tensor>>& batch) override {
+    if (gate) {
+      gate();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      batchSizes.push_back(batch.size());
+    }
+    std::vector<std::vector<Tensor>> outputs;
+    for (const auto& request : batch) {
+      if (request.empty()) {
+        throw std::invalid_argument("DoublingModel - empty request");
+      }
+      outputs.push_back({request.front() * 2});
+    }
+    return outputs;
+  }
+
+  std::function<void()> gate;
+  std::mutex mutex;
+  std::vector<size_t> batchSizes;
+};
+
+} // namespace
+
+TEST(InferenceServerTest, DynamicBatching) {
+  auto model = std::make_shared<DoublingModel>();
+  InferenceServer server(2);
+  InferenceServer::ModelOptions options;
+  options.maxBatchSize = 4;
+  options.maxDelay = std::chrono::seconds(10);
+  server.addModel("double", model, options);
+
+  std::vector<std::future<std::vector<Tensor>>> results;
+  for (int i = 0; i < 8; ++i) {
+    results.push_back(server.submit("double", {fl::full({3}, i)}));
+  }
+  for (int i = 0; i < 8; ++i) {
+    auto outputs = results[i].get();
+    ASSERT_EQ(outputs.size(), 1);
+    ASSERT_TRUE(allClose(outputs.front(), fl::full({3}, 2 * i)));
+  }
+  // full batches run without waiting for the delay
+  ASSERT_EQ(model->batchSizes, std::vector<size_t>({4, 4}));
+}
+
+TEST(InferenceServerTest, MaxDelay) {
+  auto model = std::make_shared<DoublingModel>();
+  InferenceServer server(1);
+  InferenceServer::ModelOptions options;
+  options.maxBatchSize = 64;
+  options.maxDelay = std::chrono::milliseconds(10);
+  server.addModel("double", model, options);
+
+  auto result = server.submit("double", {fl::full({2}, 1.0)});
+  ASSERT_EQ(
+      result.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+  ASSERT_TRUE(allClose(result.get().front(), fl::full({2}, 2.0)));
+  ASSERT_EQ(model->batchSizes, std::vector<size_t>({1}));
+}
+
+TEST(InferenceServerTest, Errors) {
+  auto model = std::make_shared<DoublingModel>();
+  InferenceServer server(1);
+  server.addModel("double", model);
+  ASSERT_THROW(server.addModel("double", model), std::invalid_argument);
+  ASSERT_THROW(server.submit("missing", {}), std::invalid_argument);
+
+  // the error of the model is returned with the results
+  auto failed = server.submit("double", {});
+  ASSERT_THROW(failed.get(), std::invalid_argument);
+
+  server.stop();
+  ASSERT_THROW(
+      server.submit("double", {fl::full({1}, 1.0)}), std::runtime_error);
+}
+
+TEST(InferenceServerTest, QueueLimit) {
+  auto model = std::make_shared<DoublingModel>();
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  model->gate = [released]() { released.wait(); };
+
+  InferenceServer server(1);
+  InferenceServer::ModelOptions options;
+  options.maxBatchSize = 1;
+  options.maxQueueSize = 1;
+  server.addModel("double", model, options);
+
+  // runs, and blocks the only batch the model may run at once
+  auto first = server.submit("double", {fl::full({1}, 1.0)});
+  while (server.queueSize("double") != 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  auto second = server.submit("double", {fl::full({1}, 2.0)});
+  ASSERT_THROW(
+      server.submit("double", {fl::full({1}, 3.0)}), std::runtime_error);
+
+  release.set_value();
+  ASSERT_TRUE(allClose(first.get().front(), fl::full({1}, 2.0)));
+  ASSERT_TRUE(allClose(second.get().front(), fl::full({1}, 4.0)));
+}
+
+TEST(InferenceServerTest, ModuleInferenceModel) {
+  auto module = std::make_shared<Sequential>();
+  module->add(Linear(3, 4));
+  module->add(ReLU());
+  auto model = std::make_shared<ModuleInferenceModel>(module);
+
+  // requests of several samples, batched along the last axis
+  std::vector<Tensor> inputs = {
+      fl::rand({3, 1}), fl::rand({3, 2}), fl::rand({3, 1})};
+  std::vector<std::vector<Tensor>> batch;
+  for (const auto& input : inputs) {
+    batch.push_back({input});
+  }
+  auto outputs = model->run(batch);
+  ASSERT_EQ(outputs.size(), inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    ASSERT_EQ(outputs[i].size(), 1);
+    auto expected = module->forward(noGrad(inputs[i])).tensor();
+    ASSERT_EQ(outputs[i].front().shape(), expected.shape());
+    ASSERT_TRUE(allClose(outputs[i].front(), expected, 1e-5));
+  }
+
+  // inputs are padded along the other axes
+  auto view = std::make_shared<ModuleInferenceModel>(
+      std::make_shared<View>(Shape({-1, 0})));
+  auto padded = view->run({{fl::full({2, 1}, 1.0)}, {fl::full({3, 1}, 2.0)}});
+  ASSERT_EQ(padded[0].front().shape(), Shape({3, 1}));
+  ASSERT_TRUE(allClose(
+      padded[0].front(), Tensor::fromVector<float>({3, 1}, {1, 1, 0})));
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
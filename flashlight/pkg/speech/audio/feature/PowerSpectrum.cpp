@@ -11,6 +11,10 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <exception>
+#include <new>
+#include <numeric>
+#include <stdexcept>
 #include <unordered_map>
 
 #include "flashlight/pkg/speech/audio/feature/SpeechUtils.h"
@@ -19,7 +23,33 @@ namespace fl {
 namespace lib {
 namespace audio {
 
-std::mutex PowerSpectrum::fftPlanMutex_;
+namespace {
+
+// SIMD-aligned input and output buffers of a real-to-complex FFT
+struct FftBuffers {
+  double* in;
+  fftw_complex* out;
+
+  explicit FftBuffers(int nFft)
+      : in(fftw_alloc_real(nFft)), out(fftw_alloc_complex(nFft / 2 + 1)) {
+    if (!in || !out) {
+      fftw_free(in);
+      fftw_free(out);
+      throw std::bad_alloc();
+    }
+    std::fill(in, in + nFft, 0.0);
+  }
+
+  ~FftBuffers() {
+    fftw_free(in);
+    fftw_free(out);
+  }
+
+  FftBuffers(const FftBuffers&) = delete;
+  FftBuffers& operator=(const FftBuffers&) = delete;
+};
+
+} // namespace
 
 PowerSpectrum::PowerSpectrum(const FeatureParams& params)
     : featParams_(params),
@@ -29,14 +59,15 @@ PowerSpectrum::PowerSpectrum(const FeatureParams& params)
   // Need to lock plan creation, which only happens once per instance
   // https://www.fftw.org/fftw3_doc/Thread-safety.html -- multiple threads can
   // use the same plans with fftw_execute
-  std::lock_guard<std::mutex> lock(fftPlanMutex_);
+  std::lock_guard<std::mutex> lock(fftwPlannerMutex());
 
   validatePowSpecParams();
   auto nFFt = featParams_.nFft();
-  inFftBuf_.resize(nFFt, 0.0);
-  outFftBuf_.resize(2 * nFFt);
-  fftPlan_ = std::make_unique<fftw_plan>(std::move(fftw_plan_dft_r2c_1d(
-      nFFt, inFftBuf_.data(), (fftw_complex*)outFftBuf_.data(), FFTW_MEASURE)));
+  // the buffers of the plan are only used to create it; buffers allocated
+  // with fftw_malloc have the same alignment, to execute it on
+  FftBuffers buffers(nFFt);
+  fftPlan_ = std::make_unique<fftw_plan>(fftw_plan_dft_r2c_1d(
+      nFFt, buffers.in, buffers.out, FFTW_MEASURE));
 }
 
 std::vector<float> PowerSpectrum::apply(const std::vector<float>& input) {
@@ -54,6 +85,8 @@ std::vector<float> PowerSpectrum::powSpectrumImpl(std::vector<float>& frames) {
   int K = featParams_.filterFreqResponseLen();
 
   if (featParams_.ditherVal != 0.0) {
+    // the random generator of the dither is shared
+    std::lock_guard<std::mutex> lock(ditherMutex_);
     frames = dither_.apply(frames);
   }
   if (featParams_.zeroMeanFrame) {
@@ -70,25 +103,19 @@ std::vector<float> PowerSpectrum::powSpectrumImpl(std::vector<float>& frames) {
   }
   windowing_.applyInPlace(frames);
   std::vector<float> dft(K * nFrames);
+  // the samples after the frame stay zero: out-of-place r2c transforms
+  // preserve their input
+  FftBuffers buffers(nFft);
   for (size_t f = 0; f < nFrames; ++f) {
     auto begin = frames.data() + f * nSamples;
-    {
-      std::lock_guard<std::mutex> lock(fftMutex_);
-      std::copy(begin, begin + nSamples, inFftBuf_.data());
-      std::fill(outFftBuf_.begin(), outFftBuf_.end(), 0.0);
-      fftw_execute(*fftPlan_);
-
-      // Copy stuff to the redundant part
-      for (size_t i = K; i < nFft; ++i) {
-        outFftBuf_[2 * i] = outFftBuf_[2 * nFft - 2 * i];
-        outFftBuf_[2 * i + 1] = -outFftBuf_[2 * nFft - 2 * i + 1];
-      }
-
-      for (size_t i = 0; i < K; ++i) {
-        dft[f * K + i] = std::sqrt(
-            outFftBuf_[2 * i] * outFftBuf_[2 * i] +
-            outFftBuf_[2 * i + 1] * outFftBuf_[2 * i + 1]);
-      }
+    std::copy(begin, begin + nSamples, buffers.in);
+    fftw_execute_dft_r2c(*fftPlan_, buffers.in, buffers.out);
+
+    const double* out = reinterpret_cast<const double*>(buffers.out);
+    float* magnitudes = dft.data() + f * K;
+    for (size_t i = 0; i < K; ++i) {
+      magnitudes[i] = std::sqrt(
+          out[2 * i] * out[2 * i] + out[2 * i + 1] * out[2 * i + 1]);
     }
   }
   return dft;
@@ -107,16 +134,26 @@ std::vector<float> PowerSpectrum::batchApply(
   int outputSz = outputSize(N);
   std::vector<float> feat(outputSz * batchSz);
 
-#pragma omp parallel for num_threads(batchSz)
+  // exceptions can't leave an OpenMP region
+  std::exception_ptr error;
+#pragma omp parallel for
   for (int b = 0; b < batchSz; ++b) {
-    auto start = input.begin() + b * N;
-    std::vector<float> inputBuf(start, start + N);
-    auto curFeat = apply(inputBuf);
-    if (outputSz != curFeat.size()) {
-      throw std::logic_error("PowerSpectrum: apply() returned wrong size");
+    try {
+      auto start = input.begin() + b * N;
+      std::vector<float> inputBuf(start, start + N);
+      auto curFeat = apply(inputBuf);
+      if (outputSz != curFeat.size()) {
+        throw std::logic_error("PowerSpectrum: apply() returned wrong size");
+      }
+      std::copy(
+          curFeat.begin(), curFeat.end(), feat.begin() + b * curFeat.size());
+    } catch (...) {
+#pragma omp critical
+      error = std::current_exception();
     }
-    std::copy(
-        curFeat.begin(), curFeat.end(), feat.begin() + b * curFeat.size());
+  }
+  if (error) {
+    std::rethrow_exception(error);
   }
   return feat;
 }
@@ -144,6 +181,7 @@ void PowerSpectrum::validatePowSpecParams() const {
 }
 
 PowerSpectrum::~PowerSpectrum() {
+  std::lock_guard<std::mutex> lock(fftwPlannerMutex());
   fftw_destroy_plan(*fftPlan_);
 }
 } // namespace audio
@@ -37,6 +37,7 @@ class PowerSpectrum {
 
   // input - input speech signal (Col Major : T X BATCHSZ)
   // Returns - Output features (Col Major : FEAT X FRAMESZ X BATCHSZ)
+  // The signals of the batch are processed in parallel.
   std::vector<float> batchApply(const std::vector<float>& input, int batchSz);
 
   virtual int outputSize(int inputSz);
@@ -58,10 +59,10 @@ class PowerSpectrum {
   PreEmphasis preEmphasis_;
   Windowing windowing_;
 
+  // The plan is shared by all threads, which execute it on their own buffers
+  // with the new-array execute functions, so FFTs run concurrently
   std::unique_ptr<fftw_plan> fftPlan_; // fftw_plan is an opque pointer type
-  std::vector<double> inFftBuf_, outFftBuf_;
-  std::mutex fftMutex_;
-  static std::mutex fftPlanMutex_;
+  std::mutex ditherMutex_;
 };
 } // namespace audio
 } // namespace lib
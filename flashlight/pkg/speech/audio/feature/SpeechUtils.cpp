@@ -86,6 +86,11 @@ std::vector<float> cblasGemm(
 
   return matC;
 };
+
+std::mutex& fftwPlannerMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
 } // namespace audio
 } // namespace lib
 } // namespace fl
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <mutex>
 #include <vector>
 
 #include "flashlight/pkg/speech/audio/feature/FeatureParams.h"
@@ -28,6 +29,11 @@ std::vector<float> cblasGemm(
     const std::vector<float>& matB,
     int n,
     int k);
+
+// The FFTW planner, which creates and destroys plans, isn't thread-safe: all
+// FFTW plans are created and destroyed under this mutex
+
+std::mutex& fftwPlannerMutex();
 } // namespace audio
 } // namespace lib
 } // namespace fl
@@ -39,6 +39,10 @@ AdditiveNoise::AdditiveNoise(
     const AdditiveNoise::Config& config,
     unsigned int seed /* = 0 */)
     : conf_(config), rng_(seed) {
+  if (NoiseBank::isNoiseBank(conf_.listFilePath_)) {
+    noiseBank_ = std::make_unique<NoiseBank>(conf_.listFilePath_);
+    return;
+  }
   std::ifstream listFile(conf_.listFilePath_);
   if (!listFile) {
     throw std::runtime_error(
@@ -75,6 +79,12 @@ void AdditiveNoise::apply(std::vector<float>& signal) {
 
   std::vector<float> mixedNoise(signal.size(), 0.0f);
   for (int i = 0; i < nClips; ++i) {
+    if (noiseBank_) {
+      auto curClipIdx = rng_.randInt(0, noiseBank_->size() - 1);
+      int shift = rng_.randInt(0, noiseBank_->length(curClipIdx) - 1);
+      noiseBank_->mix(curClipIdx, shift, augStart, augEnd, mixedNoise);
+      continue;
+    }
     auto curNoiseFileIdx = rng_.randInt(0, noiseFiles_.size() - 1);
     auto curNoise = loadSound<float>(noiseFiles_[curNoiseFileIdx]);
     int shift = rng_.randInt(0, curNoise.size() - 1);
@@ -97,6 +107,10 @@ void AdditiveNoise::apply(std::vector<float>& signal) {
   }
 }
 
+void AdditiveNoise::setSeed(unsigned int seed) {
+  rng_ = RandomNumberGenerator(seed);
+}
+
 } // namespace sfx
 } // namespace speech
 } // namespace pkg
@@ -9,10 +9,12 @@
 
 #include "flashlight/pkg/speech/augmentation/SoundEffect.h"
 
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
 
+#include "flashlight/pkg/speech/augmentation/NoiseBank.h"
 #include "flashlight/pkg/speech/augmentation/SoundEffectUtil.h"
 
 namespace fl {
@@ -35,6 +37,10 @@ namespace sfx {
  * rms(signal)/rms(noise) / snrDB. rms(signal) is calculated only on the
  * augmented interval. rms(noise) is calculated on the sum of all noise clipse
  * over the augmented interval.
+ *
+ * listFilePath_ is either a list of noise files, one per line, which are
+ * loaded at every use, or a `NoiseBank` file, from which noise is sliced
+ * without file I/O.
  */
 class AdditiveNoise : public SoundEffect {
  public:
@@ -58,10 +64,12 @@ class AdditiveNoise : public SoundEffect {
   ~AdditiveNoise() override = default;
   void apply(std::vector<float>& signal) override;
   std::string prettyString() const override;
+  void setSeed(unsigned int seed) override;
 
  private:
   const AdditiveNoise::Config conf_;
   std::vector<std::string> noiseFiles_;
+  std::unique_ptr<NoiseBank> noiseBank_;
   RandomNumberGenerator rng_;
 };
 
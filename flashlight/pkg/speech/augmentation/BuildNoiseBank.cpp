@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/pkg/speech/augmentation/NoiseBank.h"
+
+DEFINE_string(input, "", "List of noise sound files, one per line.");
+DEFINE_string(
+    output,
+    "noise.noisebank",
+    "Path of the noise bank file, which must end with .noisebank");
+DEFINE_bool(int16, false, "Store the noise as 16 bit PCM instead of floats");
+
+using ::fl::pkg::speech::sfx::NoiseBank;
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  std::string exec(argv[0]);
+
+  gflags::SetUsageMessage(
+      "Usage: \n " + exec +
+      " --input=[path to noise list file] --output=[path to noise bank]");
+
+  if (argc <= 1) {
+    LOG(FATAL) << gflags::ProgramUsage();
+  }
+
+  gflags::ParseCommandLineFlags(&argc, &argv, false);
+  fl::init();
+
+  if (FLAGS_input.empty()) {
+    LOG(FATAL) << "flag --input must point to noise list file";
+  }
+  if (!NoiseBank::isNoiseBank(FLAGS_output)) {
+    LOG(FATAL) << "flag --output must end with " << NoiseBank::kExtension;
+  }
+
+  std::ifstream listFile(FLAGS_input);
+  if (!listFile) {
+    LOG(FATAL) << "failed to open noise list file=" << FLAGS_input;
+  }
+  std::vector<std::string> noiseFiles;
+  std::string filename;
+  while (std::getline(listFile, filename)) {
+    if (!filename.empty()) {
+      noiseFiles.push_back(filename);
+    }
+  }
+
+  NoiseBank::write(
+      noiseFiles, FLAGS_output, FLAGS_int16 ? fl::dtype::s16 : fl::dtype::f32);
+
+  LOG(INFO) << "Saving noise bank of " << noiseFiles.size()
+            << " files to=" << FLAGS_output;
+
+  return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/speech/augmentation/FftConvolution.h"
+
+#include <fftw3.h>
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+
+#include "flashlight/pkg/speech/audio/feature/SpeechUtils.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+namespace sfx {
+
+namespace {
+
+// the FFT size of blocks fitted to the impulse response is at least
+constexpr int kMinFftSize = 1024;
+
+// SIMD-aligned buffers of a real-to-complex FFT and its inverse
+struct FftBuffers {
+  double* real;
+  fftw_complex* complex;
+
+  explicit FftBuffers(int nFft)
+      : real(fftw_alloc_real(nFft)), complex(fftw_alloc_complex(nFft / 2 + 1)) {
+    if (!real || !complex) {
+      fftw_free(real);
+      fftw_free(complex);
+      throw std::bad_alloc();
+    }
+  }
+
+  ~FftBuffers() {
+    fftw_free(real);
+    fftw_free(complex);
+  }
+
+  FftBuffers(const FftBuffers&) = delete;
+  FftBuffers& operator=(const FftBuffers&) = delete;
+};
+
+int nextPowerOf2(int n) {
+  int p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+
+} // namespace
+
+FftConvolver::FftConvolver(
+    const std::vector<float>& impulseResponse,
+    int blockSize /* = 0 */) {
+  const auto isTap = [](float x) { return x != 0; };
+  const auto first =
+      std::find_if(impulseResponse.begin(), impulseResponse.end(), isTap);
+  firstTap_ = first - impulseResponse.begin();
+  if (first == impulseResponse.end()) {
+    irLength_ = blockSize_ = nFft_ = 0;
+    return;
+  }
+  const auto last =
+      std::find_if(impulseResponse.rbegin(), impulseResponse.rend(), isTap)
+          .base();
+  irLength_ = last - first;
+
+  if (blockSize > 0) {
+    nFft_ = nextPowerOf2(blockSize + irLength_ - 1);
+  } else {
+    nFft_ = std::max(kMinFftSize, nextPowerOf2(2 * irLength_));
+  }
+  // the linear convolution of a block fits in the FFT without aliasing
+  blockSize_ = nFft_ - irLength_ + 1;
+
+  FftBuffers buffers(nFft_);
+  {
+    // planning with FFTW_ESTIMATE leaves the buffers untouched; buffers
+    // allocated with fftw_malloc have the same alignment, to execute on
+    std::lock_guard<std::mutex> lock(lib::audio::fftwPlannerMutex());
+    forwardPlan_ = fftw_plan_dft_r2c_1d(
+        nFft_, buffers.real, buffers.complex, FFTW_ESTIMATE);
+    backwardPlan_ = fftw_plan_dft_c2r_1d(
+        nFft_, buffers.complex, buffers.real, FFTW_ESTIMATE);
+  }
+
+  std::fill(buffers.real, buffers.real + nFft_, 0.0);
+  std::copy(first, last, buffers.real);
+  fftw_execute_dft_r2c(forwardPlan_, buffers.real, buffers.complex);
+  // the inverse FFT is unnormalized
+  const double* bins = reinterpret_cast<const double*>(buffers.complex);
+  irSpectrum_.resize(2 * (nFft_ / 2 + 1));
+  for (size_t i = 0; i < irSpectrum_.size(); ++i) {
+    irSpectrum_[i] = bins[i] / nFft_;
+  }
+}
+
+FftConvolver::~FftConvolver() {
+  std::lock_guard<std::mutex> lock(lib::audio::fftwPlannerMutex());
+  if (forwardPlan_) {
+    fftw_destroy_plan(forwardPlan_);
+  }
+  if (backwardPlan_) {
+    fftw_destroy_plan(backwardPlan_);
+  }
+}
+
+std::vector<float> FftConvolver::apply(const std::vector<float>& signal) const {
+  const int length = signal.size();
+  std::vector<float> output(length, 0.0);
+  if (irLength_ == 0 || firstTap_ >= length) {
+    return output;
+  }
+  // samples of the output from the first tap, which only depend on the
+  // samples of the signal before them
+  const int outLength = length - firstTap_;
+  FftBuffers buffers(nFft_);
+  double* bins = reinterpret_cast<double*>(buffers.complex);
+  for (int start = 0; start < outLength; start += blockSize_) {
+    const int blockLength = std::min(blockSize_, outLength - start);
+    std::copy(
+        signal.begin() + start,
+        signal.begin() + start + blockLength,
+        buffers.real);
+    std::fill(buffers.real + blockLength, buffers.real + nFft_, 0.0);
+    fftw_execute_dft_r2c(forwardPlan_, buffers.real, buffers.complex);
+    for (int k = 0; k <= nFft_ / 2; ++k) {
+      const double re = bins[2 * k], im = bins[2 * k + 1];
+      const double irRe = irSpectrum_[2 * k], irIm = irSpectrum_[2 * k + 1];
+      bins[2 * k] = re * irRe - im * irIm;
+      bins[2 * k + 1] = re * irIm + im * irRe;
+    }
+    fftw_execute_dft_c2r(backwardPlan_, buffers.complex, buffers.real);
+    // overlap-add the convolution of the block
+    const int end = std::min(blockLength + irLength_ - 1, outLength - start);
+    float* out = output.data() + firstTap_ + start;
+    for (int i = 0; i < end; ++i) {
+      out[i] += buffers.real[i];
+    }
+  }
+  return output;
+}
+
+} // namespace sfx
+} // namespace speech
+} // namespace pkg
+} // namespace fl
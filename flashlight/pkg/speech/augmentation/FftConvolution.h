@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <vector>
+
+class fftw_plan_s;
+typedef fftw_plan_s* fftw_plan;
+
+namespace fl {
+namespace pkg {
+namespace speech {
+namespace sfx {
+
+/**
+ * Convolves signals with an impulse response, e.g. a room impulse response
+ * (RIR), by overlap-add of FFTs of fixed-size blocks of the signal, such that
+ * the cost grows as O(length * log(blockSize + irLength)) instead of
+ * O(length * irLength) in the time domain. The spectrum of the impulse
+ * response and the FFTW plans are computed once, on construction, and
+ * `apply` is thread-safe.
+ *
+ * The leading zeros of the impulse response, e.g. the delay before its first
+ * echo, are skipped: the output is exactly zero before the first non-zero tap.
+ */
+class FftConvolver {
+ public:
+  /**
+   * @param[in] impulseResponse The impulse response.
+   * @param[in] blockSize The number of samples of the signal in a block, or 0
+   * to fit the size of the impulse response.
+   */
+  explicit FftConvolver(
+      const std::vector<float>& impulseResponse,
+      int blockSize = 0);
+  ~FftConvolver();
+
+  FftConvolver(const FftConvolver&) = delete;
+  FftConvolver& operator=(const FftConvolver&) = delete;
+
+  // Returns the first signal.size() samples of the convolution of signal
+  // with the impulse response.
+  std::vector<float> apply(const std::vector<float>& signal) const;
+
+ private:
+  // index of the first non-zero tap of the impulse response
+  int firstTap_;
+  // length of the impulse response from the first tap
+  int irLength_;
+  int blockSize_;
+  int nFft_;
+  // nFft / 2 + 1 complex bins of the impulse response, scaled by 1 / nFft
+  std::vector<double> irSpectrum_;
+  fftw_plan forwardPlan_{nullptr};
+  fftw_plan backwardPlan_{nullptr};
+};
+
+} // namespace sfx
+} // namespace speech
+} // namespace pkg
+} // namespace fl
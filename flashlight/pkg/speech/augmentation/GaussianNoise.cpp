@@ -48,6 +48,10 @@ void GaussianNoise::apply(std::vector<float>& signal) {
   }
 }
 
+void GaussianNoise::setSeed(unsigned int seed) {
+  rng_ = RandomNumberGenerator(seed);
+}
+
 } // namespace sfx
 } // namespace speech
 } // namespace pkg
@@ -38,6 +38,7 @@ class GaussianNoise : public SoundEffect {
   ~GaussianNoise() override = default;
   void apply(std::vector<float>& signal) override;
   std::string prettyString() const override;
+  void setSeed(unsigned int seed) override;
 
  private:
   const GaussianNoise::Config conf_;
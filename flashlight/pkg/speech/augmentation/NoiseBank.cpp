@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/speech/augmentation/NoiseBank.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "flashlight/fl/common/Logging.h"
+#include "flashlight/fl/dataset/FileBlobDataset.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/pkg/speech/data/Sound.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+namespace sfx {
+
+namespace {
+
+// the scale of 16 bit PCM samples read as floats by libsndfile
+constexpr float kInt16Scale = 32768.0f;
+
+inline float toFloat(float x) {
+  return x;
+}
+
+inline float toFloat(int16_t x) {
+  return x / kInt16Scale;
+}
+
+template <typename T>
+void mixClip(
+    const T* data,
+    int64_t length,
+    int64_t shift,
+    int64_t start,
+    int64_t end,
+    std::vector<float>& signal) {
+  const int64_t signalSize = signal.size();
+  for (int64_t j = start; j < end; ++j) {
+    signal[j % signalSize] += toFloat(data[(shift + j) % length]);
+  }
+}
+
+} // namespace
+
+NoiseBank::NoiseBank(const std::string& path)
+    : blob_(std::make_unique<fl::MmapBlobDataset>(
+          path,
+          fl::MmapAdvice::Random)) {
+  clips_.reserve(blob_->size());
+  for (int64_t i = 0; i < blob_->size(); ++i) {
+    const auto views = blob_->view(i);
+    if (views.size() != 1 ||
+        (views[0].entry.type != fl::dtype::f32 &&
+         views[0].entry.type != fl::dtype::s16) ||
+        views[0].entry.dims.elements() == 0) {
+      throw std::runtime_error(
+          "NoiseBank::NoiseBank - invalid clip " + std::to_string(i) +
+          " in noise bank " + path);
+    }
+    clips_.push_back(
+        {views[0].data, views[0].entry.dims.elements(), views[0].entry.type});
+  }
+}
+
+int64_t NoiseBank::size() const {
+  return clips_.size();
+}
+
+int64_t NoiseBank::length(int64_t clip) const {
+  return clips_.at(clip).length;
+}
+
+void NoiseBank::mix(
+    int64_t clip,
+    int64_t shift,
+    int64_t start,
+    int64_t end,
+    std::vector<float>& signal) const {
+  if (signal.empty()) {
+    return;
+  }
+  const auto& c = clips_.at(clip);
+  if (c.type == fl::dtype::s16) {
+    const auto* data = static_cast<const int16_t*>(c.data);
+    mixClip(data, c.length, shift, start, end, signal);
+  } else {
+    const auto* data = static_cast<const float*>(c.data);
+    mixClip(data, c.length, shift, start, end, signal);
+  }
+}
+
+bool NoiseBank::isNoiseBank(const std::string& path) {
+  const std::string extension(kExtension);
+  return path.size() > extension.size() &&
+      path.compare(
+          path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+void NoiseBank::write(
+    const std::vector<std::string>& noiseFiles,
+    const std::string& path,
+    fl::dtype type /* = fl::dtype::f32 */) {
+  if (type != fl::dtype::f32 && type != fl::dtype::s16) {
+    throw std::invalid_argument(
+        "NoiseBank::write - noise banks are f32 or s16, not " +
+        std::string(fl::dtypeToString(type)));
+  }
+  fl::FileBlobDataset blob(path, /* rw = */ true, /* truncate = */ true);
+  for (const auto& noiseFile : noiseFiles) {
+    auto noise = loadSound<float>(noiseFile);
+    if (noise.empty()) {
+      FL_LOG(fl::LogLevel::WARNING)
+          << "NoiseBank::write - skipping empty noise file " << noiseFile;
+      continue;
+    }
+    const Dim length = noise.size();
+    if (type == fl::dtype::s16) {
+      std::vector<int16_t> pcm(noise.size());
+      std::transform(noise.begin(), noise.end(), pcm.begin(), [](float x) {
+        return static_cast<int16_t>(
+            std::clamp(std::round(x * kInt16Scale), -kInt16Scale, 32767.0f));
+      });
+      blob.add({Tensor::fromVector({length}, pcm)});
+    } else {
+      blob.add({Tensor::fromVector({length}, noise)});
+    }
+  }
+  blob.writeIndex();
+}
+
+} // namespace sfx
+} // namespace speech
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flashlight/fl/dataset/MmapBlobDataset.h"
+#include "flashlight/fl/tensor/Types.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+namespace sfx {
+
+/**
+ * A bank of noise clips in a single memory-mapped blob file, such that noise
+ * is sliced from the page cache instead of being opened and decoded from its
+ * sound file at every augmented sample. A bank is written once from a list of
+ * noise files with `NoiseBank::write`, e.g. with the `fl_asr_build_noise_bank`
+ * tool, and is used by `AdditiveNoise` as its `listFilePath_`, which is
+ * identified by the `kExtension` of the bank file.
+ *
+ * The clips are stored as `f32`, or as `s16` for half the size with the
+ * precision of 16 bit PCM sound files, in the range [-1, 1] of `loadSound`.
+ */
+class NoiseBank {
+ public:
+  // The extension of noise bank files
+  static constexpr const char* kExtension = ".noisebank";
+
+  /**
+   * Maps a noise bank.
+   * @param[in] path The bank file.
+   */
+  explicit NoiseBank(const std::string& path);
+
+  /**
+   * @return The number of noise clips of the bank.
+   */
+  int64_t size() const;
+
+  /**
+   * @param[in] clip A clip index.
+   * @return The number of samples of the clip.
+   */
+  int64_t length(int64_t clip) const;
+
+  /**
+   * Adds the tiled samples of a clip from an offset to an interval of a
+   * signal, which wraps around: for j in [start, end), adds sample
+   * (shift + j) % length(clip) of the clip to signal[j % signal.size()].
+   * @param[in] clip A clip index.
+   * @param[in] shift The offset of the clip.
+   * @param[in] start The start of the interval.
+   * @param[in] end The end of the interval.
+   * @param[in,out] signal The signal.
+   */
+  void mix(
+      int64_t clip,
+      int64_t shift,
+      int64_t start,
+      int64_t end,
+      std::vector<float>& signal) const;
+
+  /**
+   * @param[in] path A file name.
+   * @return True if the file name has the extension of noise banks.
+   */
+  static bool isNoiseBank(const std::string& path);
+
+  /**
+   * Writes a noise bank from sound files.
+   * @param[in] noiseFiles The noise sound files.
+   * @param[in] path The bank file, which is truncated if it exists.
+   * @param[in] type The type of the samples, `f32` or `s16`.
+   */
+  static void write(
+      const std::vector<std::string>& noiseFiles,
+      const std::string& path,
+      fl::dtype type = fl::dtype::f32);
+
+ private:
+  struct Clip {
+    const void* data;
+    int64_t length;
+    fl::dtype type;
+  };
+
+  std::unique_ptr<fl::MmapBlobDataset> blob_;
+  std::vector<Clip> clips_;
+};
+
+} // namespace sfx
+} // namespace speech
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/speech/augmentation/ParallelSoundEffect.h"
+
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+#include <string>
+
+namespace fl {
+namespace pkg {
+namespace speech {
+namespace sfx {
+
+ParallelSoundEffect::ParallelSoundEffect(
+    const std::vector<SoundEffectConfig>& sfxConfigs,
+    size_t numThreads) {
+  if (numThreads == 0) {
+    throw std::invalid_argument(
+        "ParallelSoundEffect::ParallelSoundEffect - numThreads must be "
+        "positive");
+  }
+  for (size_t i = 0; i < numThreads; ++i) {
+    chains_.push_back(createSoundEffect(sfxConfigs));
+  }
+  threadPool_ = std::make_unique<fl::ThreadPool>(numThreads);
+}
+
+void ParallelSoundEffect::apply(
+    std::vector<std::vector<float>>& signals,
+    const std::vector<unsigned int>& seeds) {
+  if (signals.size() != seeds.size()) {
+    throw std::invalid_argument(
+        "ParallelSoundEffect::apply - " + std::to_string(signals.size()) +
+        " signals but " + std::to_string(seeds.size()) + " seeds");
+  }
+  // contiguous ranges of signals, one per chain, such that each chain is only
+  // used by one thread at a time
+  const size_t numTasks = std::min(chains_.size(), signals.size());
+  std::vector<std::future<void>> futures;
+  for (size_t task = 0; task < numTasks; ++task) {
+    const size_t begin = signals.size() * task / numTasks;
+    const size_t end = signals.size() * (task + 1) / numTasks;
+    futures.push_back(threadPool_->enqueue(
+        [&signals, &seeds, begin, end](SoundEffect* chain) {
+          for (size_t i = begin; i < end; ++i) {
+            chain->setSeed(seeds[i]);
+            chain->apply(signals[i]);
+          }
+        },
+        chains_[task].get()));
+  }
+  // wait for all the tasks before rethrowing, since they use the signals
+  for (auto& future : futures) {
+    future.wait();
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+}
+
+} // namespace sfx
+} // namespace speech
+} // namespace pkg
+} // namespace fl
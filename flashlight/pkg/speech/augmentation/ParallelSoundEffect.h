@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "flashlight/fl/common/threadpool/ThreadPool.h"
+#include "flashlight/pkg/speech/augmentation/SoundEffect.h"
+#include "flashlight/pkg/speech/augmentation/SoundEffectConfig.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+namespace sfx {
+
+/**
+ * Applies a chain of sound effects to batches of signals in parallel, on a
+ * thread pool with one instance of the chain per thread, since sound effects
+ * are not thread-safe.
+ *
+ * The chain is reseeded with the seed of each signal before it is applied, so
+ * the augmentation of a signal only depends on the signal and its seed, e.g.
+ * derived from the sample index and the epoch, and not on the batch or on the
+ * number of threads. Signals are augmented in place, such that a batch of
+ * signals reused across calls keeps its buffers.
+ *
+ * Example:
+ * \code{.cpp}
+ *  ParallelSoundEffect sfx(readSoundEffectConfigFile(configFile), 8);
+ *  std::vector<std::vector<float>> signals = ...;
+ *  std::vector<unsigned int> seeds = ...;
+ *  sfx.apply(signals, seeds);
+ * \endcode
+ */
+class ParallelSoundEffect {
+ public:
+  /**
+   * @param[in] sfxConfigs The configurations of the chain of sound effects.
+   * @param[in] numThreads The number of threads of the pool.
+   */
+  ParallelSoundEffect(
+      const std::vector<SoundEffectConfig>& sfxConfigs,
+      size_t numThreads);
+
+  /**
+   * Augments signals in place.
+   * @param[in,out] signals The signals.
+   * @param[in] seeds The seed of each signal.
+   */
+  void apply(
+      std::vector<std::vector<float>>& signals,
+      const std::vector<unsigned int>& seeds);
+
+ private:
+  std::vector<std::shared_ptr<SoundEffect>> chains_;
+  std::unique_ptr<fl::ThreadPool> threadPool_;
+};
+
+} // namespace sfx
+} // namespace speech
+} // namespace pkg
+} // namespace fl
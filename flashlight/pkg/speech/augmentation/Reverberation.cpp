@@ -9,7 +9,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <fstream>
+#include <numeric>
 #include <sstream>
+#include <stdexcept>
+
+#include "flashlight/pkg/speech/data/Sound.h"
 
 namespace fl {
 namespace pkg {
@@ -27,15 +32,10 @@ void ReverbEcho::applyReverb(
     float firstDelay,
     float rt60) {
   size_t length = source.size();
-  std::vector<float> reverb(length, 0);
+  // the echo trains, as a sparse impulse response convolved with the source
+  std::vector<float> echoes(length, 0);
   for (int i = 0; i < conf_.repeat_; ++i) {
     float frac = 1;
-    // echo = initial * source
-    std::vector<float> echo = source;
-    std::transform(
-        echo.begin(), echo.end(), echo.begin(), [initial](float x) -> float {
-          return x * initial;
-        });
     while (frac > 1e-3) {
       // Add jitter noise for the delay
       float jitter = 1 + rng_.uniform(-conf_.jitter_, conf_.jitter_);
@@ -43,9 +43,7 @@ void ReverbEcho::applyReverb(
       if (delay > length - 1) {
         break;
       }
-      for (int j = 0; j < length - delay - 1; ++j) {
-        reverb[delay + j] += echo[j] * frac;
-      }
+      echoes[delay] += initial * frac;
 
       // Add jitter noise for the attenuation
       jitter = 1 + rng_.uniform(-conf_.jitter_, conf_.jitter_);
@@ -54,6 +52,7 @@ void ReverbEcho::applyReverb(
       frac *= attenuation;
     }
   }
+  const auto reverb = FftConvolver(echoes).apply(source);
   for (int i = 0; i < length; ++i) {
     source[i] += reverb[i];
   }
@@ -71,6 +70,10 @@ void ReverbEcho::apply(std::vector<float>& sound) {
   applyReverb(sound, initial, firstDelay, rt60);
 }
 
+void ReverbEcho::setSeed(unsigned int seed) {
+  rng_ = RandomNumberGenerator(seed);
+}
+
 std::string ReverbEcho::prettyString() const {
   return "ReverbEcho{conf_=" + conf_.prettyString() + "}}";
 }
@@ -85,6 +88,84 @@ std::string ReverbEcho::Config::prettyString() const {
   return ss.str();
 }
 
+ConvolutionReverb::ConvolutionReverb(
+    const ConvolutionReverb::Config& config,
+    unsigned int seed /* = 0 */)
+    : conf_(config), rng_(seed) {
+  std::ifstream listFile(conf_.listFilePath_);
+  if (!listFile) {
+    throw std::runtime_error(
+        "ConvolutionReverb failed to open listFilePath_=" +
+        conf_.listFilePath_);
+  }
+  std::string filename;
+  while (std::getline(listFile, filename)) {
+    if (!filename.empty()) {
+      rirFiles_.push_back(filename);
+    }
+  }
+  if (rirFiles_.empty()) {
+    throw std::runtime_error(
+        "ConvolutionReverb no RIR files in listFilePath_=" +
+        conf_.listFilePath_);
+  }
+  convolvers_.resize(rirFiles_.size());
+}
+
+const FftConvolver& ConvolutionReverb::getConvolver(int rirIdx) {
+  auto& convolver = convolvers_[rirIdx];
+  if (!convolver) {
+    const auto& filename = rirFiles_[rirIdx];
+    const auto info = loadSoundInfo(filename);
+    const auto sound = loadSound<float>(filename);
+    // the first channel of the RIR
+    std::vector<float> rir(info.frames);
+    for (int64_t i = 0; i < info.frames; ++i) {
+      rir[i] = sound[i * info.channels];
+    }
+    // align the reverberated signal with the input on the direct path
+    const auto peak = std::max_element(
+        rir.begin(), rir.end(), [](float lhs, float rhs) {
+          return std::abs(lhs) < std::abs(rhs);
+        });
+    if (peak != rir.end()) {
+      rir.erase(rir.begin(), peak);
+    }
+    const float norm = std::sqrt(std::inner_product(
+        rir.begin(), rir.end(), rir.begin(), 0.0f));
+    if (norm > 0) {
+      for (auto& x : rir) {
+        x /= norm;
+      }
+    }
+    convolver = std::make_unique<FftConvolver>(rir, conf_.blockSize_);
+  }
+  return *convolver;
+}
+
+void ConvolutionReverb::apply(std::vector<float>& sound) {
+  if (rng_.random() >= conf_.proba_) {
+    return;
+  }
+  const int rirIdx = rng_.randInt(0, rirFiles_.size() - 1);
+  sound = getConvolver(rirIdx).apply(sound);
+}
+
+void ConvolutionReverb::setSeed(unsigned int seed) {
+  rng_ = RandomNumberGenerator(seed);
+}
+
+std::string ConvolutionReverb::prettyString() const {
+  return "ConvolutionReverb{conf_=" + conf_.prettyString() + "}}";
+}
+
+std::string ConvolutionReverb::Config::prettyString() const {
+  std::stringstream ss;
+  ss << " proba_=" << proba_ << " listFilePath_=" << listFilePath_
+     << " blockSize_=" << blockSize_;
+  return ss.str();
+}
+
 } // namespace sfx
 } // namespace speech
 } // namespace pkg
@@ -9,10 +9,12 @@
 
 #include "flashlight/pkg/speech/augmentation/SoundEffect.h"
 
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
 
+#include "flashlight/pkg/speech/augmentation/FftConvolution.h"
 #include "flashlight/pkg/speech/augmentation/SoundEffectUtil.h"
 
 namespace fl {
@@ -82,6 +84,7 @@ class ReverbEcho : public SoundEffect {
   ~ReverbEcho() override = default;
   void apply(std::vector<float>& sound) override;
   std::string prettyString() const override;
+  void setSeed(unsigned int seed) override;
 
  private:
   // augments source with reverberation noise
@@ -95,6 +98,53 @@ class ReverbEcho : public SoundEffect {
   RandomNumberGenerator rng_;
 };
 
+/**
+ * Applies reverberation by convolution with room impulse responses (RIR),
+ * e.g. measured or simulated RIRs, chosen at random from a list of sound
+ * files at the sample rate of the input. The convolution is an overlap-add of
+ * FFTs, whose RIR spectra are computed once per RIR file and cached.
+ *
+ * RIRs are aligned on their peak, i.e. the direct path, such that the
+ * reverberated signal is aligned with the input, and normalized to unit
+ * energy. Multi-channel RIRs use their first channel.
+ */
+class ConvolutionReverb : public SoundEffect {
+ public:
+  struct Config {
+    /**
+     * probability of applying reverb.
+     */
+    float proba_ = 1.0;
+    /**
+     * file with the paths of the RIR sound files, one per line.
+     */
+    std::string listFilePath_;
+    /**
+     * number of samples of the input convolved with an FFT, or 0 to fit the
+     * size of the RIRs.
+     */
+    int blockSize_ = 0;
+    std::string prettyString() const;
+  };
+
+  explicit ConvolutionReverb(
+      const ConvolutionReverb::Config& config,
+      unsigned int seed = 0);
+  ~ConvolutionReverb() override = default;
+  void apply(std::vector<float>& sound) override;
+  std::string prettyString() const override;
+  void setSeed(unsigned int seed) override;
+
+ private:
+  // loads and caches the RIR spectrum of a RIR file
+  const FftConvolver& getConvolver(int rirIdx);
+
+  const ConvolutionReverb::Config conf_;
+  std::vector<std::string> rirFiles_;
+  std::vector<std::unique_ptr<FftConvolver>> convolvers_;
+  RandomNumberGenerator rng_;
+};
+
 } // namespace sfx
 } // namespace speech
 } // namespace pkg
@@ -36,6 +36,12 @@ void SoundEffectChain::apply(std::vector<float>& sound) {
   }
 }
 
+void SoundEffectChain::setSeed(unsigned int seed) {
+  for (std::shared_ptr<SoundEffect>& effect : soundEffects_) {
+    effect->setSeed(seed);
+  }
+}
+
 bool SoundEffectChain::empty() {
   return soundEffects_.empty();
 }
@@ -93,6 +99,12 @@ void Amplify::apply(std::vector<float>& sound) {
       });
 }
 
+void Amplify::setSeed(unsigned int seed) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  randomEngine_.seed(seed);
+  randomRatio_.reset();
+}
+
 } // namespace sfx
 } // namespace speech
 } // namespace pkg
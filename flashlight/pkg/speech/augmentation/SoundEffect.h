@@ -28,6 +28,13 @@ class SoundEffect {
   virtual ~SoundEffect() = default;
   virtual void apply(std::vector<float>& sound) = 0;
   virtual std::string prettyString() const = 0;
+
+  /**
+   * Resets the random state of the effect, such that the result of apply()
+   * after setSeed() is a function of the sound and of the seed, e.g. of a
+   * seed derived from the sample. No-op for deterministic effects.
+   */
+  virtual void setSeed(unsigned int /* seed */) {}
 };
 
 /**
@@ -40,6 +47,8 @@ class SoundEffectChain : public SoundEffect {
   ~SoundEffectChain() override = default;
   void apply(std::vector<float>& sound) override;
   std::string prettyString() const override;
+  // Sets the seed of all the sound effects, as createSoundEffect() does.
+  void setSeed(unsigned int seed) override;
   void add(std::shared_ptr<SoundEffect> SoundEffect);
   bool empty();
 
@@ -91,6 +100,7 @@ class Amplify : public SoundEffect {
   ~Amplify() override = default;
   void apply(std::vector<float>& sound) override;
   std::string prettyString() const override;
+  void setSeed(unsigned int seed) override;
 
  private:
   std::mt19937 randomEngine_;
@@ -5,9 +5,16 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/pkg/speech/augmentation/ParallelSoundEffect.h"
 #include "flashlight/pkg/speech/augmentation/SoundEffect.h"
 #include "flashlight/pkg/speech/augmentation/SoundEffectConfig.h"
 #include "flashlight/pkg/speech/data/Sound.h"
@@ -18,6 +25,19 @@ DEFINE_string(
     "augmented.flac",
     "Path to store result of augmenting the input file");
 DEFINE_string(config, "", "Path to a sound effect json config file");
+DEFINE_string(
+    input_list,
+    "",
+    "File of sound files to augment, one per line, instead of --input.");
+DEFINE_string(
+    output_dir,
+    "augmented",
+    "Directory to store the results of augmenting the --input_list files");
+DEFINE_int64(nthread, 1, "Number of threads to augment --input_list with");
+DEFINE_int64(
+    batch_size,
+    64,
+    "Number of --input_list files that are augmented at once");
 
 using namespace ::fl::pkg::speech::sfx;
 using ::fl::pkg::speech::loadSound;
@@ -32,7 +52,10 @@ int main(int argc, char** argv) {
   gflags::SetUsageMessage(
       "Usage: \n " + exec +
       " --input=[path to input file] --output=[path to output file] " +
-      "--config=[path to config file]");
+      "--config=[path to config file]\n " + exec +
+      " --input_list=[path to list of input files] " +
+      "--output_dir=[path to output directory] " +
+      "--config=[path to config file] --nthread=[number of threads]");
 
   if (argc <= 1) {
     LOG(FATAL) << gflags::ProgramUsage();
@@ -43,6 +66,52 @@ int main(int argc, char** argv) {
   if (FLAGS_config.empty()) {
     LOG(FATAL) << "flag --config must point to sound effect config file";
   }
+  if (!FLAGS_input_list.empty()) {
+    std::ifstream listFile(FLAGS_input_list);
+    if (!listFile) {
+      LOG(FATAL) << "failed to open --input_list=" << FLAGS_input_list;
+    }
+    std::vector<std::string> inputs;
+    std::string filename;
+    while (std::getline(listFile, filename)) {
+      if (!filename.empty()) {
+        inputs.push_back(filename);
+      }
+    }
+    fs::create_directories(FLAGS_output_dir);
+
+    ParallelSoundEffect sfx(
+        readSoundEffectConfigFile(FLAGS_config), FLAGS_nthread);
+    // the buffers of a batch are reused by the next batch
+    std::vector<std::vector<float>> sounds;
+    std::vector<unsigned int> seeds;
+    for (size_t start = 0; start < inputs.size(); start += FLAGS_batch_size) {
+      const size_t end =
+          std::min<size_t>(start + FLAGS_batch_size, inputs.size());
+      sounds.resize(end - start);
+      seeds.resize(end - start);
+      for (size_t i = start; i < end; ++i) {
+        sounds[i - start] = loadSound<float>(inputs[i]);
+        seeds[i - start] = i;
+      }
+      sfx.apply(sounds, seeds);
+      for (size_t i = start; i < end; ++i) {
+        auto info = loadSoundInfo(inputs[i]);
+        auto output = fs::path(FLAGS_output_dir) /
+            fs::path(inputs[i]).filename().replace_extension(".flac");
+        saveSound(
+            output,
+            sounds[i - start],
+            info.samplerate,
+            info.channels,
+            fl::pkg::speech::SoundFormat::FLAC,
+            fl::pkg::speech::SoundSubFormat::PCM_16);
+      }
+    }
+    LOG(INFO) << "Saving " << inputs.size()
+              << " augmented files to=" << FLAGS_output_dir;
+    return 0;
+  }
   if (FLAGS_input.empty()) {
     LOG(FATAL) << "flag --input must point to input file";
   }
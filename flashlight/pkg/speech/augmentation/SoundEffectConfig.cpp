@@ -39,6 +39,13 @@ void serialize(Archive& ar, AdditiveNoise::Config& conf) {
      cereal::make_nvp("listFilePath", conf.listFilePath_));
 }
 
+template <class Archive>
+void serialize(Archive& ar, ConvolutionReverb::Config& conf) {
+  ar(cereal::make_nvp("proba", conf.proba_),
+     cereal::make_nvp("listFilePath", conf.listFilePath_),
+     cereal::make_nvp("blockSize", conf.blockSize_));
+}
+
 template <class Archive>
 void serialize(Archive& ar, ReverbEcho::Config& conf) {
   ar(cereal::make_nvp("proba", conf.proba_),
@@ -68,6 +75,9 @@ void serialize(Archive& ar, SoundEffectConfig& conf) {
     ar(cereal::make_nvp("additiveNoiseConfig", conf.additiveNoiseConfig_));
   } else if (conf.type_ == kAmplify) {
     ar(cereal::make_nvp("amplifyConfig", conf.amplifyConfig_));
+  } else if (conf.type_ == kConvolutionReverb) {
+    ar(cereal::make_nvp(
+        "convolutionReverbConfig", conf.convolutionReverbConfig_));
   } else if (conf.type_ == kNormalize) {
     ar(cereal::make_nvp(
         "normalizeOnlyIfTooHigh", conf.normalizeOnlyIfTooHigh_));
@@ -130,6 +140,9 @@ std::shared_ptr<SoundEffect> createSoundEffect(
       sfxChain->add(std::make_shared<Amplify>(conf.amplifyConfig_));
     } else if (conf.type_ == kClampAmplitude) {
       sfxChain->add(std::make_shared<ClampAmplitude>());
+    } else if (conf.type_ == kConvolutionReverb) {
+      sfxChain->add(std::make_shared<ConvolutionReverb>(
+          conf.convolutionReverbConfig_, seed));
     } else if (conf.type_ == kNormalize) {
       sfxChain->add(std::make_shared<Normalize>(conf.normalizeOnlyIfTooHigh_));
     } else if (conf.type_ == kReverbEcho) {
@@ -26,6 +26,7 @@ namespace sfx {
 constexpr const char* const kAdditiveNoise = "AdditiveNoise";
 constexpr const char* const kAmplify = "Amplify";
 constexpr const char* const kClampAmplitude = "ClampAmplitude";
+constexpr const char* const kConvolutionReverb = "ConvolutionReverb";
 constexpr const char* const kNormalize = "Normalize";
 constexpr const char* const kReverbEcho = "ReverbEcho";
 constexpr const char* const kTimeStretch = "TimeStretch";
@@ -38,6 +39,7 @@ struct SoundEffectConfig {
   bool normalizeOnlyIfTooHigh_ = true;
   AdditiveNoise::Config additiveNoiseConfig_;
   Amplify::Config amplifyConfig_;
+  ConvolutionReverb::Config convolutionReverbConfig_;
   ReverbEcho::Config reverbEchoConfig_;
   TimeStretch::Config timeStretchConfig_;
 };
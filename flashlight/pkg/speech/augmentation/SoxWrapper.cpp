@@ -71,6 +71,20 @@ int inputDrain(sox_effect_t* effp, sox_sample_t* obuf, size_t* osamp) {
   return *osamp ? SOX_SUCCESS : SOX_EOF;
 }
 
+struct ChainDeleter {
+  void operator()(sox_effects_chain_t* chain) const {
+    sox_delete_effects_chain(chain);
+  }
+};
+
+// Deletes the effects of a chain, but not the chain, on scope exit.
+struct ClearEffects {
+  sox_effects_chain_t* chain;
+  ~ClearEffects() {
+    sox_delete_effects(chain);
+  }
+};
+
 std::unique_ptr<sox_signalinfo_t> createSignalInfo(size_t sampleRate) {
   auto sigInfo = std::make_unique<sox_signalinfo_t>();
   *sigInfo = {
@@ -96,6 +110,8 @@ SoxWrapper::~SoxWrapper() {
 }
 
 SoxWrapper* SoxWrapper::instance(size_t sampleRate /* =16000*/) {
+  static std::mutex instanceMutex;
+  std::lock_guard<std::mutex> lock(instanceMutex);
   if (!instance_) {
     auto s = new SoxWrapper(sampleRate);
     instance_.reset(s);
@@ -106,17 +122,20 @@ SoxWrapper* SoxWrapper::instance(size_t sampleRate /* =16000*/) {
 void SoxWrapper::applyAndFreeEffect(
     std::vector<float>& signal,
     sox_effect_t* effect) const {
-  sox_effects_chain_t* chain = createChain();
-  addInput(chain, &signal);
-  FL_SOX_CHECK(
-      sox_add_effect(chain, effect, signalInfo_.get(), signalInfo_.get()));
-  free(effect);
-  std::vector<float> augmented;
-  addOutput(chain, &augmented);
-
-  sox_flow_effects(chain, nullptr, nullptr);
-
-  sox_delete_effects_chain(chain);
+  // the storage of the previous input, reused for the next output
+  thread_local std::vector<float> augmented;
+  augmented.clear();
+  augmented.reserve(signal.size());
+
+  sox_effects_chain_t* chain = threadChain();
+  {
+    ClearEffects clear{chain};
+    addInput(chain, &signal);
+    addAndFreeEffect(chain, effect);
+    addOutput(chain, &augmented);
+
+    sox_flow_effects(chain, nullptr, nullptr);
+  }
   signal.swap(augmented);
 }
 
@@ -187,6 +206,12 @@ sox_effects_chain_t* SoxWrapper::createChain() const {
   return chain;
 }
 
+sox_effects_chain_t* SoxWrapper::threadChain() const {
+  thread_local std::unique_ptr<sox_effects_chain_t, ChainDeleter> chain(
+      createChain());
+  return chain.get();
+}
+
 namespace detail {
 
 void check(bool success, const char* msg, const char* file, int line) {
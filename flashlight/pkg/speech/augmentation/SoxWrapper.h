@@ -50,6 +50,10 @@ namespace sfx {
  *  // call applyAndFreeEffect() to stream the signal through the effect.
  *  SoxWrapper::instance()->applyAndFreeEffect(signal, e);
  * \endcode
+ *
+ * Each thread reuses a single effects chain, and the buffer of the previous
+ * output, across calls, such that only the effects, whose options change at
+ * every call, are created per signal.
  */
 class SoxWrapper {
  public:
@@ -66,6 +70,8 @@ class SoxWrapper {
   explicit SoxWrapper(size_t sampleRate);
 
   sox_effects_chain_t* createChain() const;
+  // The chain of the calling thread, without effects.
+  sox_effects_chain_t* threadChain() const;
   void addInput(sox_effects_chain_t* chain, std::vector<float>* signal) const;
   void addOutput(sox_effects_chain_t* chain, std::vector<float>* emptyBuf)
       const;
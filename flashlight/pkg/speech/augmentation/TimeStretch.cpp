@@ -42,6 +42,10 @@ void TimeStretch::apply(std::vector<float>& signal) {
   sox_->applyAndFreeEffect(signal, e);
 }
 
+void TimeStretch::setSeed(unsigned int seed) {
+  rng_ = RandomNumberGenerator(seed);
+}
+
 std::string TimeStretch::Config::prettyString() const {
   std::stringstream ss;
   ss << "TimeStretch::Config{minFactor_=" << minFactor_
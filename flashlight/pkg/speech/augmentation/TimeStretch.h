@@ -45,6 +45,7 @@ class TimeStretch : public SoundEffect {
   ~TimeStretch() override = default;
   void apply(std::vector<float>& data) override;
   std::string prettyString() const override;
+  void setSeed(unsigned int seed) override;
 
  private:
   const TimeStretch::Config conf_;
@@ -55,6 +55,12 @@ DEFINE_int64(
     channels,
     1,
     "Number of input channels in training, validation and test audio data");
+DEFINE_string(
+    feature_store,
+    "",
+    "Directory of a store of input features precomputed from the data lists "
+    "with 'fl_asr_precompute_features', read instead of featurizing audio. "
+    "Training on sound effect augmented audio doesn't use the store");
 DEFINE_string(
     tokens,
     "tokens.txt",
@@ -131,6 +137,11 @@ DEFINE_int64(
     std::numeric_limits<int64_t>::max(),
     "[train] Total number of updates for training");
 DEFINE_bool(itersave, false, "Save model or not at each update");
+DEFINE_bool(
+    asyncsave,
+    false,
+    "[train] Write the saved models in the background, after serializing "
+    "them to host memory, such that training resumes during the writes");
 DEFINE_double(lr, 1.0, "[train] Learning rate for the network parameters");
 DEFINE_double(
     momentum,
@@ -166,6 +177,10 @@ DEFINE_double(
     maxgradnorm,
     0,
     "[train] Maximum gradient norm to which gradients exceeding it will be clipped (0 = no clipping)");
+DEFINE_int64(
+    accumulation_steps,
+    1,
+    "[train] Number of batches whose gradients are accumulated in each update, and reduced once in distributed training");
 DEFINE_double(
     adambeta1,
     0.9,
@@ -290,6 +305,10 @@ DEFINE_int64(
     nthread,
     1,
     "[train] Number of threads for data parallelization (prefetching the data)");
+DEFINE_bool(
+    nthread_numa_affinity,
+    false,
+    "[train] Pin the prefetching threads to cores of the NUMA node closest to the GPU, and allocate their memory from it");
 DEFINE_int64(
     seed,
     0,
@@ -464,6 +483,16 @@ DEFINE_int32(
     beamsizetoken,
     250000,
     "[decode] Maximum beam for tokens selection");
+DEFINE_int32(
+    test_beamsize,
+    0,
+    "[test] Beam size of a batched beam search of 'seq2seq' criterion "
+    "predictions, which are viterbi paths if 0");
+DEFINE_int32(
+    test_batchsize,
+    1,
+    "[test] Number of utterances decoded together by the beam search of "
+    "'test_beamsize'");
 DEFINE_int32(
     nthread_decoder_am_forward,
     1,
@@ -476,11 +505,59 @@ DEFINE_int32(
     lm_memory,
     5000,
     "[decode] Total memory size for batch forming for 'convlm' LM forward pass");
+DEFINE_int32(
+    lm_cache_size,
+    0,
+    "[decode] Number of token prefixes whose 'convlm' LM scores are cached");
+DEFINE_int32(
+    lm_batch_size,
+    0,
+    "[decode] Maximum number of sequences of a batched 'convlm' LM forward "
+    "pass, 0 for no limit");
+DEFINE_int32(
+    lm_batch_wait_us,
+    0,
+    "[decode] Time in microseconds a 'convlm' LM query waits to be batched "
+    "with others. If positive, the decoder threads share the LM of the first "
+    "thread and batch their queries");
 
 DEFINE_int32(
     emission_queue_size,
     3000,
     "[test, decode] Maximum size of emission queue for acoustic model forward pass");
+DEFINE_bool(
+    emission_store,
+    false,
+    "[test] Write the emissions to an emission store of a few shards in "
+    "'emission_dir', instead of a file per sample. 'decode' reads either");
+DEFINE_bool(
+    emission_fp16,
+    false,
+    "[test] Store the emissions of an emission store in half precision");
+DEFINE_int64(
+    decoder_memory_budget,
+    0,
+    "[decode] Budget in MB of the input features of the utterances in flight "
+    "between acoustic model forward and decoding, which bounds the forward "
+    "passes running while the LM decodes on the same device; 0 for no limit");
+DEFINE_int64(
+    am_chunk_frames,
+    0,
+    "[test, decode] Run the acoustic model on chunks of this many input "
+    "frames of an utterance, and stitch the emissions, to bound the memory "
+    "of long utterances; 0 to run whole utterances");
+DEFINE_int64(
+    am_chunk_context,
+    0,
+    "[test, decode] Frames of input context on each side of a chunk, whose "
+    "emissions are dropped; at least half the acoustic model receptive field "
+    "for the emissions of the whole utterance");
+DEFINE_int64(
+    am_chunk_memory_budget,
+    0,
+    "[test, decode] Budget in MB of the memory of the acoustic model forward "
+    "of a chunk, to which the chunk size is scaled after a first chunk of "
+    "'am_chunk_frames' frames; 0 for a fixed chunk size");
 
 DEFINE_double(
     smoothingtemperature,
@@ -661,6 +738,22 @@ DEFINE_string(
     "[train] Shared file path used for setting up rendezvous."
     "If empty, uses MPI to initialize.");
 
+// METRICS
+DEFINE_int64(
+    metrics_port,
+    0,
+    "[train] Port on which to serve the training metrics at /metrics, in "
+    "the Prometheus format; the rank is added to it. 0 disables it");
+DEFINE_string(
+    metrics_file,
+    "",
+    "[train] File to which to dump the training metrics periodically, in the "
+    "Prometheus format; the rank is added to its name. Empty disables it");
+DEFINE_double(
+    metrics_interval,
+    60,
+    "[train] Interval in seconds of the dumps of the training metrics");
+
 // FB SPECIFIC
 DEFINE_bool(everstoredb, false, "use Everstore db for reading data");
 DEFINE_bool(use_memcache, false, "use Memcache for reading data");
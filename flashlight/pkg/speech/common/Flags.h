@@ -74,6 +74,7 @@ DECLARE_int64(batchsize);
 DECLARE_int64(validbatchsize);
 DECLARE_int64(samplerate);
 DECLARE_int64(channels);
+DECLARE_string(feature_store);
 DECLARE_string(tokens);
 DECLARE_string(batching_strategy);
 DECLARE_int64(batching_max_duration);
@@ -95,6 +96,7 @@ DECLARE_bool(lrcosine);
 
 DECLARE_int64(iter);
 DECLARE_bool(itersave);
+DECLARE_bool(asyncsave);
 DECLARE_double(lr);
 DECLARE_double(momentum);
 DECLARE_double(weightdecay);
@@ -105,6 +107,7 @@ DECLARE_int64(saug_start_update);
 DECLARE_int64(lr_decay);
 DECLARE_int64(lr_decay_step);
 DECLARE_double(maxgradnorm);
+DECLARE_int64(accumulation_steps);
 DECLARE_double(adambeta1); // TODO rename into optim beta1
 DECLARE_double(adambeta2); // TODO rename into optim beta2
 DECLARE_double(optimrho);
@@ -151,6 +154,7 @@ DECLARE_string(datadir);
 DECLARE_string(rundir);
 DECLARE_string(flagsfile);
 DECLARE_int64(nthread);
+DECLARE_bool(nthread_numa_affinity);
 DECLARE_int64(seed);
 DECLARE_int64(memstepsize);
 DECLARE_int64(reportiters);
@@ -208,11 +212,22 @@ DECLARE_int32(maxload);
 DECLARE_int32(maxword);
 DECLARE_int32(beamsize);
 DECLARE_int32(beamsizetoken);
+DECLARE_int32(test_beamsize);
+DECLARE_int32(test_batchsize);
 DECLARE_int32(nthread_decoder_am_forward);
 DECLARE_int32(nthread_decoder);
 DECLARE_int32(lm_memory);
+DECLARE_int32(lm_cache_size);
+DECLARE_int32(lm_batch_size);
+DECLARE_int32(lm_batch_wait_us);
 
 DECLARE_int32(emission_queue_size);
+DECLARE_bool(emission_store);
+DECLARE_bool(emission_fp16);
+DECLARE_int64(decoder_memory_budget);
+DECLARE_int64(am_chunk_frames);
+DECLARE_int64(am_chunk_context);
+DECLARE_int64(am_chunk_memory_budget);
 
 DECLARE_double(lmweight_low);
 DECLARE_double(lmweight_high);
@@ -265,6 +280,11 @@ DECLARE_int64(world_size);
 DECLARE_int64(max_devices_per_node);
 DECLARE_string(rndv_filepath);
 
+/* ========== METRICS ========== */
+DECLARE_int64(metrics_port);
+DECLARE_string(metrics_file);
+DECLARE_double(metrics_interval);
+
 /* ========== FB SPECIFIC ========== */
 DECLARE_bool(everstoredb);
 DECLARE_bool(use_memcache);
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace fl {
+namespace lib {
+
+/**
+ * MemoryBudget is a thread-safe counter of the bytes held by the stages of a
+ * pipeline, which blocks the stages acquiring more than the budget until
+ * others release theirs, such that the number of elements in flight adapts to
+ * their size.
+ *
+ * A single request larger than the budget is granted when nothing else is
+ * held, such that the pipeline never deadlocks.
+ *
+ * Sample usage:
+ *
+ *   MemoryBudget budget(1 << 30);
+ *
+ *   // Producer threads
+ *   budget.acquire(bytes);
+ *   queue.add(produce());
+ *
+ *   // Consumer threads
+ *   while (queue.get(obj)) {
+ *     consume(obj);
+ *     budget.release(bytes);
+ *   }
+ */
+class MemoryBudget {
+ public:
+  /*
+   * - Budget of maxBytes, which is unlimited when 0.
+   */
+  explicit MemoryBudget(size_t maxBytes = 0) : maxBytes_(maxBytes) {}
+
+  /*
+   * - Waits until the bytes fit in the budget, or nothing is held.
+   */
+  void acquire(size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this, bytes]() {
+      return maxBytes_ == 0 || usedBytes_ == 0 ||
+          usedBytes_ + bytes <= maxBytes_;
+    });
+    usedBytes_ += bytes;
+  }
+
+  /*
+   * - Returns bytes to the budget.
+   * - Notifies all the waiting threads, whose requests may differ in size.
+   */
+  void release(size_t bytes) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      usedBytes_ -= bytes < usedBytes_ ? bytes : usedBytes_;
+    }
+    condition_.notify_all();
+  }
+
+  size_t usedBytes() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return usedBytes_;
+  }
+
+ private:
+  std::condition_variable condition_;
+  mutable std::mutex mutex_;
+  size_t maxBytes_;
+  size_t usedBytes_{0};
+};
+} // namespace lib
+} // namespace fl
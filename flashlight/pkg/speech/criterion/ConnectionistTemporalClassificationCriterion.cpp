@@ -8,23 +8,14 @@
 
 #include <stdexcept>
 
-#include <flashlight/lib/sequence/criterion/cpu/ConnectionistTemporalClassificationCriterion.h>
-
 #include "flashlight/pkg/runtime/common/DistributedUtils.h"
 
-using CTC = fl::lib::cpu::ConnectionistTemporalClassificationCriterion<float>;
 using namespace fl::pkg::runtime;
 
 namespace {
 
 using namespace fl;
 
-struct CTCContext {
-  std::vector<int> targetVec;
-  std::vector<int> targetSizeVec;
-  std::vector<uint8_t> workspaceVec;
-};
-
 Tensor logSoftmax(const Tensor& input, const int dim) {
   Tensor maxvals = fl::amax(input, {dim}, /* keepDims = */ true);
   Shape tiledims(std::vector<Dim>(input.ndim(), 1));
@@ -76,32 +67,9 @@ Tensor ConnectionistTemporalClassificationCriterion::viterbiPathWithTarget(
         "ConnectionistTemporalClassificationCriterion::viterbiPathWithTarget: "
         "expected input of shape {N x T x B}");
   }
-  int N = input.dim(0);
-  int T = input.dim(1);
-  int B = input.dim(2);
-  int L = target.dim(0);
-
-  const Tensor targetSize = getTargetSizeArray(target, T);
-  std::shared_ptr<CTCContext> ctx = std::make_shared<CTCContext>();
-  Tensor softmax = ::logSoftmax(input, 0);
-  std::vector<float> inputVec = softmax.toHostVector<float>();
-  ctx->targetVec = target.toHostVector<int>();
-  ctx->targetSizeVec = targetSize.toHostVector<int>();
-  ctx->workspaceVec.assign(CTC::getWorkspaceSize(B, T, N, L), 0);
-  std::vector<int> bestPaths(B * T);
-  CTC::viterbi(
-      B,
-      T,
-      N,
-      L,
-      inputVec.data(),
-      ctx->targetVec.data(),
-      ctx->targetSizeVec.data(),
-      bestPaths.data(),
-      ctx->workspaceVec.data());
-  Tensor result =
-      Tensor::fromBuffer({T, B}, bestPaths.data(), MemoryLocation::Host);
-  return result;
+  const Tensor targetSize = getTargetSizeArray(target, input.dim(1));
+  // the alignment runs on the device of the input, and returns its paths there
+  return ctcViterbiPath(::logSoftmax(input, 0), target, targetSize);
 }
 
 std::string ConnectionistTemporalClassificationCriterion::prettyString() const {
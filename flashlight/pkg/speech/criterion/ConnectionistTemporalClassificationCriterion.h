@@ -21,6 +21,13 @@ class ConnectionistTemporalClassificationCriterion : public SequenceCriterion {
       fl::lib::seq::CriterionScaleMode scalemode =
           fl::lib::seq::CriterionScaleMode::NONE);
 
+  /**
+   * @param inputs the {N, T, B} logits, whose blank is N - 1, the {L, B}
+   * targets, padded with -1, and optionally the {B} sizes of the utterances,
+   * e.g. the durations of the batch, relative to the largest, which has T
+   * frames. The frames of an utterance beyond its size are ignored.
+   * @return the {B} losses
+   */
   std::vector<fl::Variable> forward(
       const std::vector<fl::Variable>& inputs) override;
 
@@ -9,6 +9,8 @@
 
 #include <algorithm>
 #include <cmath>
+#include <stdexcept>
+#include <string>
 
 #include "flashlight/fl/tensor/Index.h"
 
@@ -35,6 +37,20 @@ int getTargetSize(const int* labels, int len) {
   return len;
 }
 
+Tensor getInputSizeArray(const Tensor& inputSizes, int T, int B) {
+  if (inputSizes.isEmpty()) {
+    return fl::full({B}, T, fl::dtype::s32);
+  }
+  if (inputSizes.elements() != B) {
+    throw std::invalid_argument(
+        "getInputSizeArray: expected " + std::to_string(B) +
+        " input sizes, got " + inputSizes.shape().toString());
+  }
+  auto sizes = inputSizes.flatten().astype(fl::dtype::f32);
+  sizes = fl::ceil(sizes / fl::amax(sizes, {0}, /* keepDims = */ true) * T);
+  return fl::clip(sizes, 1, T).astype(fl::dtype::s32);
+}
+
 CriterionScaleMode getCriterionScaleMode(
     const std::string& onorm,
     bool sqnorm) {
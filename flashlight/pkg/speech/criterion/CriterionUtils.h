@@ -85,6 +85,12 @@ int getTargetSize(const int* labels, int len);
 
 Tensor getTargetSizeArray(const Tensor& target, int maxSize);
 
+// The number of frames of each of B utterances padded to T frames, from
+// their sizes relative to the largest, as by the attention windows. All
+// utterances have T frames without sizes.
+// Input: inputSizes: B (type: any), Output: B (type: int)
+Tensor getInputSizeArray(const Tensor& inputSizes, int T, int B);
+
 lib::seq::CriterionScaleMode getCriterionScaleMode(
     const std::string& onorm,
     bool sqnorm);
@@ -92,6 +98,14 @@ lib::seq::CriterionScaleMode getCriterionScaleMode(
 // Input: N x T x B (type: float), Output: T x B (type: int)
 Tensor viterbiPath(const Tensor& input, const Tensor& trans);
 
+// Best CTC alignments of targets to log probabilities, whose blank is N - 1
+// Input: N x T x B (type: float), target: L x B, targetSize: B (type: int)
+// Output: T x B (type: int)
+Tensor ctcViterbiPath(
+    const Tensor& input,
+    const Tensor& target,
+    const Tensor& targetSize);
+
 fl::Variable getLinearTarget(const fl::Variable& target, int T);
 
 // apply mask to the input with proper grad.
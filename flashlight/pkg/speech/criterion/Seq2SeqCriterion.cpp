@@ -74,6 +74,29 @@ Seq2SeqState selectState(Seq2SeqState& state, int batchIdx) {
   }
   return newState;
 }
+
+// Gathers the states of a batch along their batch dimension
+Seq2SeqState gatherState(const Seq2SeqState& state, const Tensor& batchIdx) {
+  int nAttnRound = state.hidden.size();
+  Seq2SeqState newState(nAttnRound);
+  newState.step = state.step;
+  newState.peakAttnPos = state.peakAttnPos;
+  newState.isValid = state.isValid;
+  auto gather = [&batchIdx](const Variable& var, int dim) {
+    if (var.isEmpty()) {
+      return var;
+    }
+    std::vector<fl::Index> indices(var.ndim(), fl::span);
+    indices[dim] = batchIdx;
+    return Variable(var.tensor()(indices), false);
+  };
+  newState.alpha = gather(state.alpha, 2);
+  newState.summary = gather(state.summary, 2);
+  for (int i = 0; i < nAttnRound; i++) {
+    newState.hidden[i] = gather(state.hidden[i], 1);
+  }
+  return newState;
+}
 } // namespace detail
 
 Seq2SeqCriterion::Seq2SeqCriterion(
@@ -251,10 +274,25 @@ std::pair<Variable, Variable> Seq2SeqCriterion::decoder(
   std::vector<Variable> alphaVec;
   Seq2SeqState state(nAttnRound_);
   Variable y;
+  // the windows which don't depend on the previous attention are computed
+  // for all the steps at once
+  Variable windows;
+  if (window_ && (!train_ || trainWithWindow_) &&
+      !std::dynamic_pointer_cast<MedianWindow>(window_)) {
+    windows = window_->computeVectorizedWindow(
+        U, input.dim(1), input.dim(2), inputSizes, targetSizes);
+  }
   for (int u = 0; u < U; u++) {
     Variable ox;
-    std::tie(ox, state) =
-        decodeStep(input, y, state, inputSizes, targetSizes, U);
+    std::tie(ox, state) = decodeStep(
+        input,
+        y,
+        state,
+        inputSizes,
+        targetSizes,
+        U,
+        windows.isEmpty() ? Variable()
+                          : windows(fl::range(u, u + 1), fl::span, fl::span));
 
     if (!train_) {
       y = target(fl::range(u, u + 1), fl::span);
@@ -459,13 +497,160 @@ std::vector<Seq2SeqCriterion::CandidateHypo> Seq2SeqCriterion::beamSearch(
   return complete.empty() ? beam : complete;
 }
 
+std::vector<std::vector<int>> Seq2SeqCriterion::batchedBeamPath(
+    const Tensor& input, // H x T x B
+    const Tensor& inputSizes, // 1 x B
+    int beamSize /* = 10 */) {
+  bool wasTrain = train_;
+  eval();
+
+  const int nUtt = input.dim(2);
+  std::vector<std::vector<CandidateHypo>> complete(nUtt);
+  std::vector<std::vector<int>> bestLive(nUtt);
+  auto cmpfn = [](const CandidateHypo& lhs, const CandidateHypo& rhs) {
+    return lhs.score > rhs.score;
+  };
+
+  // Slot h of the a-th active utterance is the column a * beamSize + h of
+  // the batch. Empty slots, of utterances with fewer hypotheses than the
+  // beam, have a score of -inf.
+  std::vector<int> active(nUtt);
+  std::iota(active.begin(), active.end(), 0);
+  std::vector<std::vector<int>> paths(nUtt * beamSize);
+  const float kNegInf = -std::numeric_limits<float>::infinity();
+  std::vector<float> scores(nUtt * beamSize, kNegInf);
+  for (int u = 0; u < nUtt; u++) {
+    scores[u * beamSize] = 0.0;
+  }
+  Seq2SeqState state(nAttnRound_);
+  Variable y, xEncoded;
+  Tensor slotInputSizes;
+  bool compacted = true;
+
+  for (int l = 0; l < maxDecoderOutputLen_ && !active.empty(); l++) {
+    const int nActive = active.size();
+    const int nSlots = nActive * beamSize;
+    if (compacted) {
+      std::vector<int> slotUtt(nSlots);
+      for (int s = 0; s < nSlots; s++) {
+        slotUtt[s] = active[s / beamSize];
+      }
+      auto uttIdx = Tensor::fromVector(slotUtt);
+      xEncoded = Variable(input(fl::span, fl::span, uttIdx), false);
+      if (!inputSizes.isEmpty()) {
+        slotInputSizes = fl::reshape(inputSizes.flatten()(uttIdx), {1, nSlots});
+      }
+      compacted = false;
+    }
+
+    Variable ox;
+    std::tie(ox, state) = decodeStep(
+        xEncoded, y, state, slotInputSizes, Tensor(), input.dim(1));
+    const int nClass = ox.dim(0);
+    // C x 1 x (beam x active) -> (C x beam) x active
+    auto total = logSoftmax(ox, 0).tensor() +
+        Tensor::fromVector({1, 1, nSlots}, scores);
+    total = fl::reshape(total, {nClass * beamSize, nActive});
+    const int k = std::min(2 * beamSize, nClass * beamSize);
+    Tensor topScores, topIdx;
+    fl::topk(topScores, topIdx, total, k, 0);
+    auto topScoreVec = topScores.toHostVector<float>();
+    auto topIdxVec = topIdx.astype(fl::dtype::s32).toHostVector<int>();
+
+    std::vector<int> nextActive, parents, nextY;
+    std::vector<std::vector<int>> nextPaths;
+    std::vector<float> nextScores;
+    for (int a = 0; a < nActive; a++) {
+      const int u = active[a];
+      const int first = nextScores.size();
+      for (int j = 0; j < k; j++) {
+        const float score = topScoreVec[a * k + j];
+        if (score == kNegInf) {
+          break;
+        }
+        const int parent = a * beamSize + topIdxVec[a * k + j] / nClass;
+        const int clsIdx = topIdxVec[a * k + j] % nClass;
+        if (j < beamSize && clsIdx == eos_) {
+          complete[u].emplace_back(score, paths[parent], Seq2SeqState());
+        } else if (clsIdx != eos_) {
+          parents.push_back(parent);
+          nextY.push_back(clsIdx);
+          nextPaths.push_back(paths[parent]);
+          nextPaths.back().push_back(clsIdx);
+          nextScores.push_back(score);
+        }
+        if (static_cast<int>(nextScores.size()) - first >= beamSize) {
+          break;
+        }
+      }
+      const int nNew = static_cast<int>(nextScores.size()) - first;
+      bool done = nNew == 0;
+      if (!done) {
+        bestLive[u] = nextPaths[first];
+      }
+      if (complete[u].size() >= static_cast<size_t>(beamSize)) {
+        std::partial_sort(
+            complete[u].begin(),
+            complete[u].begin() + beamSize,
+            complete[u].end(),
+            cmpfn);
+        complete[u].resize(beamSize);
+        // as in beamSearch, no live hypothesis can replace a complete one
+        done = done || complete[u].back().score > nextScores[first];
+      }
+      if (done) {
+        parents.resize(first);
+        nextY.resize(first);
+        nextPaths.resize(first);
+        nextScores.resize(first);
+        continue;
+      }
+      for (int h = nNew; h < beamSize; h++) {
+        parents.push_back(a * beamSize);
+        nextY.push_back(eos_);
+        nextPaths.emplace_back();
+        nextScores.push_back(kNegInf);
+      }
+      nextActive.push_back(u);
+    }
+
+    if (nextActive.empty()) {
+      break;
+    }
+    compacted = nextActive.size() != active.size();
+    active = std::move(nextActive);
+    paths = std::move(nextPaths);
+    scores = std::move(nextScores);
+    state = detail::gatherState(state, Tensor::fromVector(parents));
+    y = Variable(
+        Tensor::fromVector({1, static_cast<Dim>(nextY.size())}, nextY), false);
+  }
+
+  if (wasTrain) {
+    train();
+  }
+
+  std::vector<std::vector<int>> result(nUtt);
+  for (int u = 0; u < nUtt; u++) {
+    if (complete[u].empty()) {
+      result[u] = std::move(bestLive[u]);
+    } else {
+      result[u] =
+          std::min_element(complete[u].begin(), complete[u].end(), cmpfn)
+              ->path;
+    }
+  }
+  return result;
+}
+
 std::pair<Variable, Seq2SeqState> Seq2SeqCriterion::decodeStep(
     const Variable& xEncoded,
     const Variable& y,
     const Seq2SeqState& inState,
     const Tensor& inputSizes,
     const Tensor& targetSizes,
-    const int maxDecoderSteps) const {
+    const int maxDecoderSteps,
+    const Variable& stepWindow /* = Variable() */) const {
   if (xEncoded.ndim() != 3) {
     throw std::invalid_argument(
         "Seq2SeqCriterion::decodeStep: "
@@ -489,6 +674,25 @@ std::pair<Variable, Seq2SeqState> Seq2SeqCriterion::decodeStep(
   Seq2SeqState outState(nAttnRound_);
   outState.step = inState.step + 1;
 
+  // the window is the same for all the attention rounds
+  Variable windowWeight = stepWindow;
+  // because of the beam search batchsize can be
+  // different for xEncoded and y (xEncoded batch = 1 and y batch = beam
+  // size)
+  int batchsize = y.isEmpty() ? xEncoded.dim(2) : (y.ndim() < 2 ? 1 : y.dim(1));
+  if (windowWeight.isEmpty() && window_ && (!train_ || trainWithWindow_)) {
+    // TODO fix for softpretrain where target size is used
+    // for now force to xEncoded.dim(1)
+    windowWeight = window_->computeWindow(
+        inState.alpha,
+        inState.step,
+        maxDecoderSteps,
+        xEncoded.dim(1),
+        batchsize,
+        inputSizes,
+        targetSizes);
+  }
+
   Variable summaries;
   for (int i = 0; i < nAttnRound_; i++) {
     hy = moddims(hy, {hy.dim(0), -1}); // H x 1 x B -> H x B
@@ -496,24 +700,6 @@ std::pair<Variable, Seq2SeqState> Seq2SeqCriterion::decodeStep(
         decodeRNN(i)->forward(hy, inState.hidden[i]);
     hy = moddims(hy, {hy.dim(0), 1, hy.dim(1)}); // H x B -> H x 1 x B
 
-    Variable windowWeight;
-    // because of the beam search batchsize can be
-    // different for xEncoded and y (xEncoded batch = 1 and y batch = beam
-    // size)
-    int batchsize =
-        y.isEmpty() ? xEncoded.dim(2) : (y.ndim() < 2 ? 1 : y.dim(1));
-    if (window_ && (!train_ || trainWithWindow_)) {
-      // TODO fix for softpretrain where target size is used
-      // for now force to xEncoded.dim(1)
-      windowWeight = window_->computeWindow(
-          inState.alpha,
-          inState.step,
-          maxDecoderSteps,
-          xEncoded.dim(1),
-          batchsize,
-          inputSizes,
-          targetSizes);
-    }
     std::tie(outState.alpha, summaries) = attention(i)->forward(
         hy, xEncoded, inState.alpha, windowWeight, fl::noGrad(inputSizes));
     hy = hy + summaries;
@@ -556,6 +742,38 @@ Seq2SeqCriterion::decodeBatchStep(
   }
   Variable outStateBatched;
 
+  // the windows of all the hypotheses are computed at once, and are the same
+  // for all the attention rounds
+  Variable windowWeight;
+  if (window_ && (!train_ || trainWithWindow_)) {
+    const int step = inStates[0]->step;
+    const int T = xEncoded.dim(1);
+    std::vector<Variable> prevAttn;
+    for (const auto* inState : inStates) {
+      if (inState->step != step) {
+        throw std::invalid_argument(
+            "Seq2SeqCriterion::decodeBatchStep - "
+            "windows require all the hypotheses to be at the same step");
+      }
+      if (!inState->alpha.isEmpty()) {
+        prevAttn.push_back(inState->alpha); // T x 1
+      }
+    }
+    auto window = window_->computeWindow(
+        prevAttn.size() == inStates.size()
+            ? moddims(concatenate(prevAttn, 1), {1, T, batchSize})
+            : Variable(),
+        step,
+        T,
+        T,
+        batchSize);
+    // 1 x T x B -> B x T, as the attention weights of the batched states
+    windowWeight = transpose(moddims(window, {T, batchSize}), {1, 0});
+    if (xEncoded.ndim() > 2) {
+      windowWeight = moddims(windowWeight, {batchSize, T, 1});
+    }
+  }
+
   for (int n = 0; n < nAttnRound_; n++) {
     /* (1) RNN forward */
     if (inStates[0]->hidden[n].isEmpty()) {
@@ -576,17 +794,12 @@ Seq2SeqCriterion::decodeBatchStep(
     }
 
     /* (2) Attention forward */
-    if (window_ && (!train_ || trainWithWindow_)) {
-      throw std::runtime_error(
-          "Batched decoding does not support models with window");
-    }
-
     Variable summaries, alphaBatched;
     // NB:
     // - Third Variable is set to empty since no attention use it.
     // - Only ContentAttention is supported
     std::tie(alphaBatched, summaries) =
-        attention(n)->forward(yBatched, xEncoded, Variable(), Variable());
+        attention(n)->forward(yBatched, xEncoded, Variable(), windowWeight);
     alphaBatched = fl::transpose(alphaBatched, {1, 0, 2}); // B x T -> T x B
     yBatched = yBatched + summaries; // H x B
 
@@ -101,6 +101,16 @@ class Seq2SeqCriterion : public SequenceCriterion {
   std::vector<int>
   beamPath(const Tensor& input, const Tensor& inputSizes, int beamSize = 10);
 
+  /* Beam search over a batch of utterances at once: the hypotheses of all the
+   * utterances are decoded together, in a flattened beam x batch layout with
+   * beamSize slots per utterance, selected with a top-k on the device, and
+   * the utterances whose search is finished are compacted out of the batch.
+   * Returns the best path of each utterance of the H x T x B input. */
+  std::vector<std::vector<int>> batchedBeamPath(
+      const Tensor& input,
+      const Tensor& inputSizes,
+      int beamSize = 10);
+
   std::string prettyString() const override;
 
   std::shared_ptr<fl::Embedding> embedding() const {
@@ -131,13 +141,18 @@ class Seq2SeqCriterion : public SequenceCriterion {
       const int attentionThreshold = std::numeric_limits<int>::infinity(),
       const float smoothingTemperature = 1.0) const;
 
+  /*
+   * `stepWindow` is the window of the step, e.g. a step of a window computed
+   * for all the steps at once, and is computed from `instate` if empty.
+   */
   std::pair<fl::Variable, Seq2SeqState> decodeStep(
       const fl::Variable& xEncoded,
       const fl::Variable& y,
       const Seq2SeqState& instate,
       const Tensor& inputSizes,
       const Tensor& targetSizes,
-      int targetLen) const;
+      int targetLen,
+      const fl::Variable& stepWindow = fl::Variable()) const;
 
   void clearWindow() {
     trainWithWindow_ = false;
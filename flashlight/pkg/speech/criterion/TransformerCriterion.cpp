@@ -13,6 +13,7 @@
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/pkg/speech/common/Defines.h"
 #include "flashlight/pkg/speech/criterion/CriterionUtils.h"
+#include "flashlight/pkg/speech/criterion/attention/MultiHeadAttention.h"
 
 using namespace fl::pkg::runtime;
 
@@ -20,6 +21,17 @@ namespace fl {
 namespace pkg {
 namespace speech {
 
+namespace {
+
+fl::TransformerCache layerCache(const TS2SState& state, int layer) {
+  if (state.batchCaches) {
+    return (*state.batchCaches)[layer].select(state.batchIdx);
+  }
+  return state.caches[layer];
+}
+
+} // namespace
+
 TransformerCriterion::TransformerCriterion(
     int nClass,
     int hiddenDim,
@@ -172,8 +184,9 @@ std::pair<Tensor, Variable> TransformerCriterion::viterbiPathBase(
   int pred;
 
   for (int u = 0; u < maxDecoderOutputLen_; u++) {
+    // the caches of the state are extended in place
     std::tie(ox, state) =
-        decodeStep(Variable(input, false), y, state, inputSizes);
+        decodeStep(Variable(input, false), y, std::move(state), inputSizes);
     max(maxValues, maxIdx, ox.tensor(), 0);
     maxIdx.host(&pred);
     // TODO: saveAttn
@@ -197,7 +210,7 @@ std::pair<Tensor, Variable> TransformerCriterion::viterbiPathBase(
 std::pair<Variable, TS2SState> TransformerCriterion::decodeStep(
     const Variable& xEncoded,
     const Variable& y,
-    const TS2SState& inState,
+    TS2SState inState,
     const Tensor& inputSizes) const {
   Variable hy;
   if (y.isEmpty()) {
@@ -210,20 +223,15 @@ std::pair<Variable, TS2SState> TransformerCriterion::decodeStep(
 
   TS2SState outState;
   outState.step = inState.step + 1;
-  Tensor padMask; // no mask because we are doing step by step decoding here,
-                  // no look in the future
+  // step by step decoding attends to the previous steps only
   for (int i = 0; i < nLayer_; i++) {
-    if (inState.step == 0) {
-      outState.hidden.push_back(hy);
-      hy = layer(i)
-               ->forward(std::vector<Variable>({hy, fl::noGrad(padMask)}))
-               .front();
-    } else {
-      outState.hidden.push_back(concatenate({inState.hidden[i], hy}, 1));
-      hy = layer(i)
-               ->forward({inState.hidden[i], hy, fl::noGrad(padMask)})
-               .front();
+    fl::TransformerCache cache;
+    if (inState.step > 0) {
+      cache = inState.batchCaches ? layerCache(inState, i)
+                                  : std::move(inState.caches[i]);
     }
+    std::tie(hy, cache) = layer(i)->forwardIncremental(hy, std::move(cache));
+    outState.caches.push_back(std::move(cache));
   }
 
   Variable windowWeight, alpha, summary;
@@ -240,8 +248,8 @@ std::pair<Variable, TS2SState> TransformerCriterion::decodeStep(
         Tensor());
   }
 
-  std::tie(alpha, summary) = attention()->forward(
-      hy, xEncoded, Variable(), windowWeight, fl::noGrad(inputSizes));
+  std::tie(alpha, summary) =
+      attend(hy, xEncoded, windowWeight, inputSizes, inState, outState);
 
   hy = hy + summary;
 
@@ -249,6 +257,37 @@ std::pair<Variable, TS2SState> TransformerCriterion::decodeStep(
   return std::make_pair(out, outState);
 }
 
+std::pair<Variable, Variable> TransformerCriterion::attend(
+    const Variable& state,
+    const Variable& xEncoded,
+    const Variable& windowWeight,
+    const Tensor& inputSizes,
+    const TS2SState& inState,
+    TS2SState& outState) const {
+  auto mha = std::dynamic_pointer_cast<MultiHeadContentAttention>(attention());
+  if (!mha) {
+    return attention()->forward(
+        state,
+        xEncoded,
+        Variable(),
+        windowWeight,
+        fl::noGrad(inputSizes));
+  }
+  if (inState.step == 0 || inState.encodedKeys.isEmpty()) {
+    std::tie(outState.encodedKeys, outState.encodedValues) =
+        mha->projectEncoded(xEncoded);
+  } else {
+    outState.encodedKeys = inState.encodedKeys;
+    outState.encodedValues = inState.encodedValues;
+  }
+  return mha->forwardProjected(
+      state,
+      outState.encodedKeys,
+      outState.encodedValues,
+      windowWeight,
+      fl::noGrad(inputSizes));
+}
+
 std::pair<std::vector<std::vector<float>>, std::vector<TS2SStatePtr>>
 TransformerCriterion::decodeBatchStep(
     const fl::Variable& xEncoded,
@@ -275,33 +314,70 @@ TransformerCriterion::decodeBatchStep(
     outstates[i]->step = inStates[i]->step + 1;
   }
 
-  Variable outStateBatched;
-  for (int i = 0; i < nLayer_; i++) {
-    if (inStates[0]->step == 0) {
-      for (int j = 0; j < B; j++) {
-        outstates[j]->hidden.push_back(yBatched(fl::span, fl::span, j));
-      }
-      yBatched = layer(i)->forward(std::vector<Variable>({yBatched})).front();
+  // contiguous states of a same batch are gathered at once, the others are
+  // concatenated
+  std::vector<std::pair<int, int>> runs;
+  for (int j = 0; j < B; j++) {
+    const auto& caches = inStates[j]->batchCaches;
+    if (j == 0 || !caches || caches != inStates[j - 1]->batchCaches) {
+      runs.emplace_back(j, j + 1);
     } else {
-      std::vector<Variable> statesVector(B);
-      for (int j = 0; j < B; j++) {
-        statesVector[j] = inStates[j]->hidden[i];
-      }
-      Variable inStateHiddenBatched = concatenate(statesVector, 2);
-      auto tmp = std::vector<Variable>({inStateHiddenBatched, yBatched});
-      auto tmp2 = concatenate(tmp, 1);
-      for (int j = 0; j < B; j++) {
-        outstates[j]->hidden.push_back(tmp2(fl::span, fl::span, j));
+      runs.back().second = j + 1;
+    }
+  }
+
+  auto outCaches = std::make_shared<std::vector<fl::TransformerCache>>();
+  for (int i = 0; i < nLayer_; i++) {
+    fl::TransformerCache cache;
+    if (inStates[0]->step > 0) {
+      std::vector<fl::TransformerCache> caches;
+      for (const auto& [first, last] : runs) {
+        const auto& batchCaches = inStates[first]->batchCaches;
+        if (!batchCaches) {
+          caches.push_back(inStates[first]->caches[i]);
+          continue;
+        }
+        std::vector<int> batchIdx;
+        for (int j = first; j < last; j++) {
+          batchIdx.push_back(inStates[j]->batchIdx);
+        }
+        caches.push_back(
+            (*batchCaches)[i].gather(Tensor::fromVector(batchIdx)));
       }
-      yBatched = layer(i)->forward(tmp).front();
+      cache = caches.size() == 1 ? std::move(caches[0])
+                                 : fl::TransformerCache::concatenate(caches);
     }
+    std::tie(yBatched, cache) =
+        layer(i)->forwardIncremental(yBatched, std::move(cache));
+    outCaches->push_back(std::move(cache));
+  }
+  for (int j = 0; j < B; j++) {
+    outstates[j]->batchCaches = outCaches;
+    outstates[j]->batchIdx = j;
   }
 
   Variable alpha, summary;
-  yBatched = moddims(yBatched, {yBatched.dim(0), -1});
-  std::tie(alpha, summary) =
-      attention()->forward(yBatched, xEncoded, Variable(), Variable());
-  alpha = fl::transpose(alpha, {1, 0});
+  int D = yBatched.dim(0);
+  yBatched = moddims(yBatched, {D, -1});
+  if (std::dynamic_pointer_cast<MultiHeadContentAttention>(attention())) {
+    // the states are the queries of the single encoder output
+    std::tie(alpha, summary) = attend(
+        moddims(yBatched, {D, B, 1}),
+        moddims(xEncoded, {xEncoded.dim(0), xEncoded.dim(1), 1}),
+        Variable(),
+        Tensor(),
+        *inStates[0],
+        *outstates[0]);
+    summary = moddims(summary, {summary.dim(0), B});
+    for (int j = 1; j < B; j++) {
+      outstates[j]->encodedKeys = outstates[0]->encodedKeys;
+      outstates[j]->encodedValues = outstates[0]->encodedValues;
+    }
+  } else {
+    std::tie(alpha, summary) =
+        attention()->forward(yBatched, xEncoded, Variable(), Variable());
+    alpha = fl::transpose(alpha, {1, 0});
+  }
   yBatched = yBatched + summary;
 
   auto outBatched = linearOut()->forward(yBatched);
@@ -389,7 +465,8 @@ EmittingModelUpdateFunc buildSeq2SeqTransformerUpdateFunction(
         if (prevState &&
             (lastIndexOfStatePtr.find(prevState) == lastIndexOfStatePtr.end() ||
              lastIndexOfStatePtr.find(prevState)->second == i)) {
-          prevState->hidden.clear();
+          prevState->caches.clear();
+          prevState->batchCaches.reset();
         }
       }
       start += step;
@@ -23,7 +23,15 @@ namespace speech {
 
 struct TS2SState {
   fl::Variable alpha;
-  std::vector<fl::Variable> hidden;
+  // the keys and values of the previous steps of each layer
+  std::vector<fl::TransformerCache> caches;
+  // the caches of a batch of states decoded together, of which this state is
+  // the row batchIdx, such that they are gathered without being split
+  std::shared_ptr<std::vector<fl::TransformerCache>> batchCaches;
+  int batchIdx{-1};
+  // the cross-attention keys and values of the encoder output, computed once
+  fl::Variable encodedKeys;
+  fl::Variable encodedValues;
   fl::Variable summary;
   int step;
 
@@ -67,7 +75,7 @@ class TransformerCriterion : public SequenceCriterion {
   std::pair<fl::Variable, TS2SState> decodeStep(
       const fl::Variable& xEncoded,
       const fl::Variable& y,
-      const TS2SState& inState,
+      TS2SState inState,
       const Tensor& inputSizes) const;
 
   std::pair<std::vector<std::vector<float>>, std::vector<TS2SStatePtr>>
@@ -129,6 +137,14 @@ class TransformerCriterion : public SequenceCriterion {
       fl::versioned(pad_, 1))
 
   TransformerCriterion() = default;
+
+  std::pair<fl::Variable, fl::Variable> attend(
+      const fl::Variable& state,
+      const fl::Variable& xEncoded,
+      const fl::Variable& windowWeight,
+      const Tensor& inputSizes,
+      const TS2SState& inState,
+      TS2SState& outState) const;
 };
 
 struct TS2SDecoderBuffer {
@@ -32,18 +32,15 @@ Variable MedianWindow::computeWindow(
   // The definition of "median" is the point where cdf passes 0.5.
 
   int width = std::min(wL_ + wR_, inputSteps);
+  // [1, 1, batchSize], broadcast to the input steps
   Tensor inputNotPaddedSize =
       computeInputNotPaddedSize(inputSizes, inputSteps, batchSize, 0, false);
+  auto indices = fl::arange({1, inputSteps, batchSize}, 1);
 
   if (step == 0 || width == inputSteps) {
-    // [1, inputSteps]
-    auto maskArray = fl::full({1, inputSteps, batchSize}, 0.0);
-    maskArray(fl::span, fl::range(0, width), fl::span) = 1.0;
-    auto indicesAdd = fl::arange({1, inputSteps, batchSize}, 1);
-    maskArray(indicesAdd >= fl::tile(inputNotPaddedSize, {1, inputSteps})) =
-        0.0;
     // [1, inputSteps, batchSize]
-    return Variable(fl::log(maskArray), false);
+    auto maskArray = indices < width && indices < inputNotPaddedSize;
+    return Variable(fl::log(maskArray.astype(fl::dtype::f32)), false);
   }
 
   auto mIdx =
@@ -60,25 +57,16 @@ Variable MedianWindow::computeWindow(
       fl::clip(startIdx + wL_ + wR_ - inputNotPaddedSize, 0, wL_ + wR_));
   startIdx = startIdx - endDiff;
 
-  auto maskArray = fl::full({1, inputSteps, batchSize}, 0.0, fl::dtype::f32);
-  auto indices = fl::arange({width, batchSize}, 0) +
-      fl::tile(fl::reshape(startIdx, {1, batchSize}), {width, 1}) +
-      fl::tile(fl::reshape(
-                   fl::arange(0, batchSize * inputSteps, inputSteps),
-                   {1, batchSize}),
-               {width, 1});
-  maskArray(indices.flatten()) = 1.0;
-  auto indicesAdd = fl::arange({1, inputSteps, batchSize}, 1);
-  maskArray(indicesAdd >= fl::tile(inputNotPaddedSize, {1, inputSteps})) = 0.0;
-
+  // the window of each batch element, compared at once rather than scattered
+  auto inWindow = indices >= startIdx && indices < startIdx + width &&
+      indices < inputNotPaddedSize;
   if (!targetSizes.isEmpty()) {
     Tensor targetNotPaddedSize = computeTargetNotPaddedSize(
-        targetSizes, inputSteps, targetLen, batchSize, 1);
-    maskArray(step >= targetNotPaddedSize) = 0.0;
+        targetSizes, inputSteps, targetLen, batchSize, 1, false);
+    inWindow = inWindow && step < targetNotPaddedSize;
   }
-  maskArray = fl::log(maskArray);
-  // force all -inf values to be kAttentionMaskValue to avoid nan in softmax
-  maskArray(maskArray < kAttentionMaskValue) = kAttentionMaskValue;
+  // masked with kAttentionMaskValue rather than -inf to avoid nan in softmax
+  auto maskArray = (1 - inWindow.astype(fl::dtype::f32)) * kAttentionMaskValue;
   // [1, inputSteps, batchSize]
   return Variable(maskArray, false);
 }
@@ -46,16 +46,16 @@ std::pair<Variable, Variable> MultiHeadContentAttention::forwardBase(
         "MultiHeadContentAttention::forwardBase: "
         "state input must be of shape {H, U, B}");
   }
-  int hEncode = xEncoded.dim(0);
-  int T = xEncoded.dim(1);
-  int hState = state.dim(0);
-  int U = state.dim(1);
-  int B = state.dim(2);
-  auto hiddenDim = hState / numHeads_;
-  if (hEncode != (1 + keyValue_) * hState) {
+  if (xEncoded.dim(0) != (1 + keyValue_) * state.dim(0)) {
     throw std::invalid_argument("Invalid input encoder dimension");
   }
+  auto [key, value] = projectEncoded(xEncoded);
+  return forwardProjected(state, key, value, logAttnWeight, xEncodedSizes);
+}
 
+std::pair<Variable, Variable> MultiHeadContentAttention::projectEncoded(
+    const Variable& xEncoded) {
+  int hEncode = xEncoded.dim(0);
   auto xEncodedKey = keyValue_
       ? xEncoded(fl::arange(0, hEncode / 2), fl::span, fl::span)
       : xEncoded;
@@ -63,20 +63,59 @@ std::pair<Variable, Variable> MultiHeadContentAttention::forwardBase(
       ? xEncoded(fl::arange(hEncode / 2, hEncode), fl::span, fl::span)
       : xEncoded;
 
-  auto query = splitInput_ ? state : module(0)->forward({state})[0];
   auto key = splitInput_ ? xEncodedKey : module(1)->forward({xEncodedKey})[0];
   auto value =
       splitInput_ ? xEncodedValue : module(2)->forward({xEncodedValue})[0];
+  return {fl::transpose(key, {1, 0, 2}), fl::transpose(value, {1, 0, 2})};
+}
 
+std::pair<Variable, Variable> MultiHeadContentAttention::forwardProjected(
+    const Variable& state,
+    const Variable& key,
+    const Variable& value,
+    const Variable& logAttnWeight,
+    const Variable& xEncodedSizes) {
+  int T = key.dim(0);
+  int hState = state.dim(0);
+  int hiddenDim = hState / numHeads_;
+  int B = key.dim(2);
+  if (state.dim(2) != B) {
+    if (B != 1) {
+      throw std::invalid_argument(
+          "MultiHeadContentAttention::forwardProjected: "
+          "state and encoder output have different batch sizes");
+    }
+    // the queries of all the states attend to the same encoder output
+    auto out = forwardProjected(
+        moddims(state, {hState, -1, 1}),
+        key,
+        value,
+        logAttnWeight.isEmpty()
+            ? logAttnWeight
+            : moddims(reorder(logAttnWeight, {0, 2, 1}), {-1, T, 1}),
+        xEncodedSizes.isEmpty() ? xEncodedSizes
+                                : xEncodedSizes(fl::span, fl::range(0, 1)));
+    int U = state.dim(1);
+    int nStates = state.dim(2);
+    return std::make_pair(
+        moddims(
+            reorder(
+                moddims(out.first, {U, nStates, numHeads_, T}),
+                {0, 2, 3, 1}),
+            {U * numHeads_, T, nStates}),
+        moddims(out.second, {out.second.dim(0), U, nStates}));
+  }
+  int U = state.dim(1);
+
+  auto query = splitInput_ ? state : module(0)->forward({state})[0];
   query =
       moddims(fl::transpose(query, {1, 0, 2}), {U, hiddenDim, B * numHeads_});
-  key = moddims(fl::transpose(key, {1, 0, 2}), {T, hiddenDim, B * numHeads_});
-  value =
-      moddims(fl::transpose(value, {1, 0, 2}), {T, hiddenDim, B * numHeads_});
+  auto keys = moddims(key, {T, hiddenDim, B * numHeads_});
+  auto values = moddims(value, {T, hiddenDim, B * numHeads_});
 
   // [U, T, B * numHeads_]
   auto innerProd =
-      matmulNT(query, key) / std::sqrt(static_cast<float>(hiddenDim));
+      matmulNT(query, keys) / std::sqrt(static_cast<float>(hiddenDim));
 
   if (!logAttnWeight.isEmpty()) {
     auto tiledLogAttnWeight = tile(logAttnWeight, {1, 1, numHeads_});
@@ -96,7 +135,7 @@ std::pair<Variable, Variable> MultiHeadContentAttention::forwardBase(
   // [U, T, B * numHeads_]
   auto attention = softmax(innerProd, 1);
   // [U, hiddendim, B * numHeads_]
-  auto summaries = matmul(attention, value);
+  auto summaries = matmul(attention, values);
   // [hiddendim * numHeads_, U, B];
   summaries = reorder(moddims(summaries, {U, hState, B}), {1, 0, 2});
 
@@ -29,6 +29,26 @@ class MultiHeadContentAttention : public AttentionBase {
       const Variable& logAttnWeight,
       const Variable& xEncodedSizes) override;
 
+  /**
+   * Projects the keys and values of an encoder output, which are the same at
+   * every step of a decoding, such that they are computed once.
+   * @param xEncoded encoder output of size [hiddendim, seqlen, batchsize]
+   * Returns <keys, values> of sizes [seqlen, hiddendim, batchsize]
+   */
+  std::pair<Variable, Variable> projectEncoded(const Variable& xEncoded);
+
+  /**
+   * Forward pass with the projected keys and values of `projectEncoded`, of
+   * batch size B or 1, in which case the U queries of the B states of size
+   * [hiddendim, U, B] attend to the same encoder output.
+   */
+  std::pair<Variable, Variable> forwardProjected(
+      const Variable& state,
+      const Variable& key,
+      const Variable& value,
+      const Variable& logAttnWeight,
+      const Variable& xEncodedSizes);
+
   std::string prettyString() const override;
 
  private:
@@ -33,20 +33,22 @@ Variable SoftPretrainWindow::compute(
         false);
   }
 
+  // the sizes of the batch broadcast to all the decoder steps
   Tensor inputNotPaddedSize = computeInputNotPaddedSize(
-      inputSizes, inputSteps, batchSize, decoderStepsDim, true);
+      inputSizes, inputSteps, batchSize, decoderStepsDim, false);
   Tensor targetNotPaddedSize = computeTargetNotPaddedSize(
-      targetSizes, inputSteps, targetLen, batchSize, decoderStepsDim);
+      targetSizes, inputSteps, targetLen, batchSize, decoderStepsDim, false);
 
   auto maskArray =
       -fl::power(
           ts - inputNotPaddedSize / targetNotPaddedSize * decoderSteps, 2) /
       (2 * std_ * std_);
-  maskArray(ts >= inputNotPaddedSize) = -std::numeric_limits<float>::infinity();
-  maskArray(decoderSteps >= targetNotPaddedSize) =
-      -std::numeric_limits<float>::infinity();
-  // force all -inf values to be kAttentionMaskValue to avoid nan in softmax
-  maskArray(maskArray < kAttentionMaskValue) = kAttentionMaskValue;
+  // force the padding and all the values below kAttentionMaskValue to be
+  // kAttentionMaskValue to avoid nan in softmax
+  maskArray = fl::where(
+      ts >= inputNotPaddedSize || decoderSteps >= targetNotPaddedSize,
+      kAttentionMaskValue,
+      fl::maximum(maskArray, kAttentionMaskValue));
   // [decoderStepsDim, inputSteps, batchSize]
   return Variable(maskArray, false);
 }
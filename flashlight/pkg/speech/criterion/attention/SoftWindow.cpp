@@ -27,18 +27,22 @@ Variable SoftWindow::compute(
     Tensor& decoderSteps) const {
   int decoderStepsDim = decoderSteps.dim(0);
   auto ts = fl::arange({decoderStepsDim, inputSteps, batchSize}, 1);
+  // the sizes of the batch broadcast to all the decoder steps
   Tensor inputNotPaddedSize = computeInputNotPaddedSize(
-      inputSizes, inputSteps, batchSize, decoderStepsDim, true);
+      inputSizes, inputSteps, batchSize, decoderStepsDim, false);
 
   Tensor centers = fl::rint(fl::minimum(
       offset_ + decoderSteps * avgRate_, inputNotPaddedSize - avgRate_));
-  auto maskArray = -fl::power(ts - centers, 2) / (2 * std_ * std_);
-  maskArray(ts >= inputNotPaddedSize) = -std::numeric_limits<float>::infinity();
+  auto maskArray = fl::where(
+      ts >= inputNotPaddedSize,
+      -std::numeric_limits<float>::infinity(),
+      -fl::power(ts - centers, 2) / (2 * std_ * std_));
 
   if (!targetSizes.isEmpty()) {
     Tensor targetNotPaddedSize = computeTargetNotPaddedSize(
-        targetSizes, inputSteps, targetLen, batchSize, decoderStepsDim);
-    maskArray(decoderSteps >= targetNotPaddedSize) = kAttentionMaskValue;
+        targetSizes, inputSteps, targetLen, batchSize, decoderStepsDim, false);
+    maskArray = fl::where(
+        decoderSteps >= targetNotPaddedSize, kAttentionMaskValue, maskArray);
   }
   // [decoderStepsDim, inputSteps, batchSize]
   return Variable(maskArray, false);
@@ -26,31 +26,28 @@ Variable StepWindow::compute(
     const Tensor& targetSizes,
     Tensor& decoderSteps) const {
   int decoderStepsDim = decoderSteps.dim(0);
+  // the sizes of the batch broadcast to all the decoder steps
   Tensor inputNotPaddedSize = computeInputNotPaddedSize(
-      inputSizes, inputSteps, batchSize, decoderStepsDim, true);
+      inputSizes, inputSteps, batchSize, decoderStepsDim, false);
   Tensor startIdx = fl::maximum(
       0,
-      fl::rint(
-          fl::minimum(inputNotPaddedSize - vMax_, sMin_ + decoderSteps * vMin_))
-          .astype(fl::dtype::s32));
+      fl::rint(fl::minimum(
+          inputNotPaddedSize - vMax_, sMin_ + decoderSteps * vMin_)));
   auto endIdx = fl::minimum(
-      inputNotPaddedSize,
-      fl::rint(sMax_ + decoderSteps * vMax_).astype(fl::dtype::s32));
+      inputNotPaddedSize, fl::rint(sMax_ + decoderSteps * vMax_));
   Tensor indices =
       fl::iota({1, inputSteps, 1}, {decoderStepsDim, 1, batchSize});
 
   // [decoderStepsDim, inputSteps, batchSize]
-  Tensor maskTensor = fl::full({decoderStepsDim, inputSteps, batchSize}, 1.0);
-  maskTensor(indices < startIdx) = 0.0;
-  maskTensor(indices >= endIdx) = 0.0;
+  Tensor inWindow = indices >= startIdx && indices < endIdx;
   if (!targetSizes.isEmpty()) {
     Tensor targetNotPaddedSize = computeTargetNotPaddedSize(
-        targetSizes, inputSteps, targetLen, batchSize, decoderStepsDim);
-    maskTensor(decoderSteps >= targetNotPaddedSize) = 0.0;
+        targetSizes, inputSteps, targetLen, batchSize, decoderStepsDim, false);
+    inWindow = inWindow && decoderSteps < targetNotPaddedSize;
   }
-  // force all -inf values to be kAttentionMaskValue to avoid nan in softmax
-  maskTensor = fl::log(maskTensor);
-  maskTensor(maskTensor < kAttentionMaskValue) = kAttentionMaskValue;
+  // masked with kAttentionMaskValue rather than -inf to avoid nan in softmax
+  auto maskTensor =
+      (1 - inWindow.astype(fl::dtype::f32)) * kAttentionMaskValue;
   return Variable(maskTensor, false);
 }
 
@@ -29,9 +29,12 @@ Tensor WindowBase::computeInputNotPaddedSize(
     throw std::runtime_error(
         "Attention Window: wrong size of the input sizes vector, doesn't match with batchsize");
   }
+  // the largest size stays on the device, such that nothing is synchronized
+  // with the host at each decoder step
+  auto sizes =
+      fl::reshape(inputSizes, {1, 1, batchSize}).astype(fl::dtype::f32);
   Tensor inputNotPaddedSize = fl::ceil(
-      inputSizes / fl::amax(inputSizes).asScalar<float>() * inputSteps);
-  inputNotPaddedSize = fl::reshape(inputNotPaddedSize, {1, 1, batchSize});
+      sizes / fl::amax(sizes, {2}, /* keepDims = */ true) * inputSteps);
   if (doTile) {
     inputNotPaddedSize =
         fl::tile(inputNotPaddedSize, {decoderStepsDim, inputSteps, 1});
@@ -44,21 +47,28 @@ Tensor WindowBase::computeTargetNotPaddedSize(
     int inputSteps,
     int targetLen,
     int batchSize,
-    int decoderStepsDim) const {
+    int decoderStepsDim,
+    bool doTile /* = true */) const {
   if (targetSizes.isEmpty()) {
-    return fl::full(
-        {decoderStepsDim, inputSteps, batchSize}, targetLen, fl::dtype::f32);
+    if (doTile) {
+      return fl::full(
+          {decoderStepsDim, inputSteps, batchSize}, targetLen, fl::dtype::f32);
+    } else {
+      return fl::full({1, 1, batchSize}, targetLen, fl::dtype::f32);
+    }
   }
   if (targetSizes.elements() != batchSize) {
     throw std::runtime_error(
         "Window Attention: wrong size of the target sizes vector, doesn't match with batchsize");
   }
-  Tensor targetNotPaddedSize = fl::reshape(
-      fl::ceil(
-          targetSizes / fl::amax(targetSizes).asScalar<float>() * targetLen),
-      {1, 1, batchSize});
-  targetNotPaddedSize =
-      fl::tile(targetNotPaddedSize, {decoderStepsDim, inputSteps, 1});
+  auto sizes =
+      fl::reshape(targetSizes, {1, 1, batchSize}).astype(fl::dtype::f32);
+  Tensor targetNotPaddedSize =
+      fl::ceil(sizes / fl::amax(sizes, {2}, /* keepDims = */ true) * targetLen);
+  if (doTile) {
+    targetNotPaddedSize =
+        fl::tile(targetNotPaddedSize, {decoderStepsDim, inputSteps, 1});
+  }
   return targetNotPaddedSize;
 }
 
@@ -74,7 +74,8 @@ class WindowBase {
    * @param batchSize batch size
    * @param decoderStepsDim max decoder steps
    * @param doTile Do necessary tile to (decoderStepsDim, inputSteps, BatchSize)
-   * or return (1, 1, BatchSize) vector (depends on the window we need to use)
+   * or return (1, 1, BatchSize) vector (depends on the window we need to use),
+   * which broadcasts in element-wise ops
    */
   Tensor computeInputNotPaddedSize(
       const Tensor& inputSizes,
@@ -91,14 +92,18 @@ class WindowBase {
    * @param targetLen target size (max in the batch)
    * @param batchSize batch size
    * @param decoderStepsDim max decoder steps
-   * @return A tensor with shape {decoderStepsDim, inputSteps, batchSize}
+   * @param doTile Do necessary tile to (decoderStepsDim, inputSteps, BatchSize)
+   * or return (1, 1, BatchSize) vector
+   * @return A tensor with shape {decoderStepsDim, inputSteps, batchSize}, or
+   * {1, 1, batchSize} without tiling
    */
   Tensor computeTargetNotPaddedSize(
       const Tensor& targetSizes,
       int inputSteps,
       int targetLen,
       int batchSize,
-      int decoderStepsDim) const;
+      int decoderStepsDim,
+      bool doTile = true) const;
 
  private:
   FL_SAVE_LOAD()
@@ -9,6 +9,10 @@
 
 #include "flashlight/pkg/speech/criterion/CriterionUtils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
 #include <flashlight/lib/sequence/criterion/cpu/CriterionUtils.h>
 
 using namespace fl;
@@ -19,10 +23,29 @@ namespace fl {
 namespace pkg {
 namespace speech {
 
+namespace {
+
+// The utterances of a batch, longest target first. The cost of an utterance
+// is linear in its number of states, so the threads of a dynamic schedule
+// over this order take the longest utterances first and balance the short
+// ones among themselves, instead of one thread being left with the longest.
+std::vector<int64_t> balancedOrder(const std::vector<int>& targetSizes) {
+  std::vector<int64_t> order(targetSizes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+    return targetSizes[a] > targetSizes[b];
+  });
+  return order;
+}
+
+} // namespace
+
 std::vector<Variable> ConnectionistTemporalClassificationCriterion::forward(
     const std::vector<Variable>& inputs) {
-  if (inputs.size() != 2) {
-    throw std::invalid_argument("Invalid inputs size");
+  if (inputs.size() < 2 || inputs.size() > 3) {
+    throw std::invalid_argument(
+        "Invalid inputs size; CTC criterion takes input, target, "
+        "inputSizes [optional]");
   }
   const auto& input = inputs[0];
   const auto& target = inputs[1];
@@ -33,6 +56,7 @@ std::vector<Variable> ConnectionistTemporalClassificationCriterion::forward(
   std::vector<float> batchLoss;
   std::vector<float> batchScales;
   std::vector<int> batchTargetSizes;
+  std::vector<int> batchInputSizes;
   {
     const int64_t N = logprobs.dim(0);
     const int64_t T = logprobs.dim(1);
@@ -54,27 +78,42 @@ std::vector<Variable> ConnectionistTemporalClassificationCriterion::forward(
     CriterionUtils::batchTargetSize(
         B, batchL, batchL, batchTargetVec.data(), batchTargetSizes.data());
 
-    CriterionUtils::computeScale(
-        B, T, N, scaleMode_, batchTargetSizes.data(), batchScales.data());
-
-#pragma omp parallel for num_threads(B)
+    // the frames of each utterance, beyond which the input is padding
+    batchInputSizes =
+        getInputSizeArray(
+            inputs.size() > 2 ? inputs[2].tensor() : Tensor(), T, B)
+            .toHostVector<int>();
     for (int64_t b = 0; b < B; ++b) {
+      CriterionUtils::computeScale(
+          1,
+          batchInputSizes[b],
+          N,
+          scaleMode_,
+          batchTargetSizes.data() + b,
+          batchScales.data() + b);
+    }
+
+    const auto order = balancedOrder(batchTargetSizes);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int64_t i = 0; i < B; ++i) {
+      const int64_t b = order[i];
       const float* inputVec = batchInputVec.data() + b * N * T;
       const int* targetVec = batchTargetVec.data() + b * batchL;
 
-      int64_t L = batchTargetSizes[b];
-      const int64_t S = 2 * L + 1;
+      const int64_t uttT = batchInputSizes[b];
+      int64_t L = std::min<int64_t>(batchTargetSizes[b], uttT);
       int64_t R = fl::pkg::speech::countRepeats(targetVec, L);
 
       // A heuristic to modify target length to be able to compute CTC loss
-      L = std::min(L + R, T) - R;
+      L = std::min(L + R, uttT) - R;
       R = fl::pkg::speech::countRepeats(
           targetVec, L); // Recompute repeats as L has changed
+      const int64_t S = 2 * L + 1;
 
       auto& alphas = batchAlphas[b];
-      alphas.resize(T * S, NEG_INFINITY_FLT);
+      alphas.resize(uttT * S, NEG_INFINITY_FLT);
 
-      int64_t start = (T - (L + R)) > 0 ? 0 : 1;
+      int64_t start = (uttT - (L + R)) > 0 ? 0 : 1;
       int64_t end = (S == 1) ? 1 : 2;
 
       // base case
@@ -82,10 +121,22 @@ std::vector<Variable> ConnectionistTemporalClassificationCriterion::forward(
       if (S != 1) {
         alphas[1] = inputVec[targetVec[0]];
       }
-      for (int64_t t = 1; t < T; ++t) {
+
+      // The emitted label and the penalty of the transition from state s - 2
+      // of each state, such that the recursion has no branch on the labels:
+      // the transition is allowed from a label to a different label only.
+      std::vector<int> labels(S);
+      std::vector<float> skipPenalty(S, NEG_INFINITY_FLT);
+      for (int64_t s = 0; s < S; ++s) {
+        labels[s] = (s & 1) ? targetVec[s / 2] : N - 1;
+        if ((s & 1) && s > 1 && targetVec[s / 2] != targetVec[s / 2 - 1]) {
+          skipPenalty[s] = 0.0;
+        }
+      }
+      for (int64_t t = 1; t < uttT; ++t) {
         // At each time frame t, only few states can be reached depending
         // on the labels, their ordering and the current time frame.
-        if (T - t <= L + R) {
+        if (uttT - t <= L + R) {
           if (start & 1 && targetVec[start / 2] != targetVec[start / 2 + 1]) {
             ++start;
           }
@@ -99,21 +150,32 @@ std::vector<Variable> ConnectionistTemporalClassificationCriterion::forward(
           ++end;
         }
         // Use dynamic programming to recursively compute alphas
-        for (int64_t s = start; s < end; ++s) {
-          int64_t ts = t * S + s;
-          int64_t curLabel = t * N + ((s & 1) ? targetVec[s / 2] : N - 1);
-          if (s == 0) {
-            alphas[ts] = alphas[ts - S];
-          } else if (
-              (s % 2 == 0) || s == 1 ||
-              targetVec[s / 2] == targetVec[s / 2 - 1]) {
-            alphas[ts] =
-                fl::pkg::speech::logSumExp(alphas[ts - S], alphas[ts - S - 1]);
-          } else {
-            alphas[ts] = fl::pkg::speech::logSumExp(
-                alphas[ts - S], alphas[ts - S - 1], alphas[ts - S - 2]);
-          }
-          alphas[ts] += inputVec[curLabel];
+        const float* prev = alphas.data() + (t - 1) * S;
+        float* cur = alphas.data() + t * S;
+        const float* frame = inputVec + t * N;
+        int64_t first = start;
+        if (first == 0 && first < end) {
+          cur[0] = prev[0] + frame[N - 1];
+          ++first;
+        }
+        if (first == 1 && first < end) {
+          cur[1] =
+              fl::pkg::speech::logSumExp(prev[1], prev[0]) + frame[labels[1]];
+          ++first;
+        }
+        // The log-sum-exp of the three predecessors of each state, which
+        // has no dependency between states and is vectorized
+#pragma omp simd
+        for (int64_t s = first; s < end; ++s) {
+          const float a0 = prev[s];
+          const float a1 = prev[s - 1];
+          const float a2 = prev[s - 2] + skipPenalty[s];
+          const float m = std::max(a0, std::max(a1, a2));
+          const float sum =
+              std::exp(a0 - m) + std::exp(a1 - m) + std::exp(a2 - m);
+          cur[s] = (m == NEG_INFINITY_FLT ? NEG_INFINITY_FLT
+                                          : m + std::log(sum)) +
+              frame[labels[s]];
         }
       }
       batchLoss[b] = -fl::pkg::speech::logSumExp(
@@ -124,7 +186,10 @@ std::vector<Variable> ConnectionistTemporalClassificationCriterion::forward(
   }
   auto result = Tensor::fromVector(batchLoss);
 
-  auto gradFunc = [batchAlphas, batchScales, batchTargetSizes](
+  auto gradFunc = [batchAlphas,
+                   batchScales,
+                   batchTargetSizes,
+                   batchInputSizes](
                       std::vector<Variable>& moduleInputs,
                       const Variable& gradOutput) {
     const int64_t N = moduleInputs[0].dim(0);
@@ -140,41 +205,44 @@ std::vector<Variable> ConnectionistTemporalClassificationCriterion::forward(
     std::vector<float> batchOutGrad(gradOutput.elements());
     gradOutput.host(batchOutGrad.data());
 
-#pragma omp parallel for num_threads(B)
-    for (int64_t b = 0; b < B; ++b) {
+    const auto order = balancedOrder(batchTargetSizes);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int64_t i = 0; i < B; ++i) {
+      const int64_t b = order[i];
       const int* targetVec = batchTargetVec.data() + b * batchL;
       float* grad = batchInGrad.data() + b * N * T;
 
+      const int64_t uttT = batchInputSizes[b];
       int64_t L = batchTargetSizes[b];
 
-      L = std::min(L, T);
+      L = std::min(L, uttT);
       const int64_t R = fl::pkg::speech::countRepeats(targetVec, L);
-      L = std::min(L + R, T) - R;
+      L = std::min(L + R, uttT) - R;
 
       const int64_t S = 2 * L + 1;
       const auto& alphas = batchAlphas[b];
 
       int64_t start = (S == 1) ? S : S - 1;
       int64_t end = S;
-      std::vector<float> dAlphas(T * S, 0.0);
+      std::vector<float> dAlphas(uttT * S, 0.0);
 
       // Compute dAlphas for the last timeframe
       if (S == 1) {
-        dAlphas[T * S - 1] = -1.0;
+        dAlphas[uttT * S - 1] = -1.0;
       } else {
         fl::pkg::speech::dLogSumExp(
-            alphas[T * S - 2],
-            alphas[T * S - 1],
-            dAlphas[T * S - 2],
-            dAlphas[T * S - 1],
+            alphas[uttT * S - 2],
+            alphas[uttT * S - 1],
+            dAlphas[uttT * S - 2],
+            dAlphas[uttT * S - 1],
             -1.0);
       }
       float gradScale = batchOutGrad[b] * batchScales[b];
 
-      for (int64_t t = T - 1; t >= 0; --t) {
+      for (int64_t t = uttT - 1; t >= 0; --t) {
         // Compute start and end values at time (t) similar to calculation
         // of alpha in CTC forward pass
-        if (T - t <= L + R + 1) {
+        if (uttT - t <= L + R + 1) {
           if (start & 1 && start > 1 &&
               targetVec[start / 2] != targetVec[start / 2 - 1]) {
             --start;
@@ -7,11 +7,13 @@
 
 #include "flashlight/pkg/speech/criterion/CriterionUtils.h"
 
+#include <flashlight/lib/sequence/criterion/cpu/ConnectionistTemporalClassificationCriterion.h>
 #include <flashlight/lib/sequence/criterion/cpu/CriterionUtils.h>
 #include <flashlight/lib/sequence/criterion/cpu/ViterbiPath.h>
 
 #include "flashlight/pkg/runtime/common/DistributedUtils.h"
 
+using CTC = fl::lib::cpu::ConnectionistTemporalClassificationCriterion<float>;
 using CriterionUtils = fl::lib::cpu::CriterionUtils<float>;
 using ViterbiPath = fl::lib::cpu::ViterbiPath<float>;
 
@@ -49,6 +51,35 @@ Tensor viterbiPath(const Tensor& input, const Tensor& trans) {
   return Tensor::fromVector({T, B}, pathVec);
 }
 
+Tensor ctcViterbiPath(
+    const Tensor& input,
+    const Tensor& target,
+    const Tensor& targetSize) {
+  int N = input.dim(0);
+  int T = input.dim(1);
+  int B = input.dim(2);
+  int L = target.dim(0);
+
+  auto inputVec = input.toHostVector<float>();
+  auto targetVec = target.toHostVector<int>();
+  auto targetSizeVec = targetSize.toHostVector<int>();
+  std::vector<uint8_t> workspaceVec(CTC::getWorkspaceSize(B, T, N, L));
+  std::vector<int> pathVec(B * T);
+
+  CTC::viterbi(
+      B,
+      T,
+      N,
+      L,
+      inputVec.data(),
+      targetVec.data(),
+      targetSizeVec.data(),
+      pathVec.data(),
+      workspaceVec.data());
+
+  return Tensor::fromVector({T, B}, pathVec);
+}
+
 Tensor getTargetSizeArray(const Tensor& target, int maxSize) {
   int B = target.dim(1);
   int L = target.dim(0);
@@ -5,42 +5,29 @@
  * LICENSE file in the root directory of this source tree.
  */
 
-#include <ctc.h> // warpctc
-
-#include "flashlight/fl/autograd/autograd.h"
-
 #include "flashlight/pkg/speech/criterion/ConnectionistTemporalClassificationCriterion.h"
-#include "flashlight/pkg/speech/criterion/CriterionUtils.h"
 
+#include <stdexcept>
+
+#include "flashlight/fl/autograd/autograd.h"
 #include "flashlight/fl/common/DevicePtr.h"
 #include "flashlight/fl/runtime/CUDAStream.h"
-#include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/TensorBackend.h"
-#include "flashlight/pkg/runtime/common/DistributedUtils.h"
-
-#include <flashlight/lib/sequence/criterion/cuda/CriterionUtils.cuh>
-
-using namespace fl::pkg::runtime;
+#include "flashlight/pkg/speech/criterion/CriterionUtils.h"
+#include "flashlight/pkg/speech/criterion/backend/cuda/ConnectionistTemporalClassificationKernels.h"
 
-using CriterionUtils = fl::lib::cuda::CriterionUtils<float>;
+using FusedCtc = fl::pkg::speech::FusedCtcCriterion;
 
 namespace fl {
 namespace pkg {
 namespace speech {
 
-namespace {
-inline void throw_on_error(ctcStatus_t status, const char* message) {
-  if (status != CTC_STATUS_SUCCESS) {
-    throw std::runtime_error(
-        message + (", stat = " + std::string(ctcGetStatusString(status))));
-  }
-}
-} // namespace
-
 std::vector<Variable> ConnectionistTemporalClassificationCriterion::forward(
     const std::vector<Variable>& inputs) {
-  if (inputs.size() != 2) {
-    throw std::invalid_argument("Invalid inputs size");
+  if (inputs.size() < 2 || inputs.size() > 3) {
+    throw std::invalid_argument(
+        "Invalid inputs size; CTC criterion takes input, target, "
+        "inputSizes [optional]");
   }
   const auto& input =
       fl::moddims(inputs[0], {0, 0, 0}); // remove trailing singleton dims
@@ -49,124 +36,76 @@ std::vector<Variable> ConnectionistTemporalClassificationCriterion::forward(
   const int N = input.dim(0);
   const int T = input.dim(1);
   const int B = input.dim(2);
-  const int batchL = target.dim(0);
-  cudaStream_t stream = input.tensor().stream().impl<CUDAStream>().handle();
-
-  ctcOptions options;
-  options.loc = CTC_GPU;
-  options.stream = stream;
-  options.blank_label = N - 1;
-
-  Tensor inputarr({N, B, T}, input.type());
-  inputarr(fl::span, fl::span, fl::span) =
-      fl::transpose(input.tensor(), {0, 2, 1});
-
-  Tensor grad;
-  if (input.isCalcGrad()) {
-    grad = fl::full(inputarr.shape(), 0.0, inputarr.type());
-  }
-
-  std::vector<int> inputLengths(B, T);
-  std::vector<int> labels;
-  std::vector<int> labelLengths;
-  std::vector<int> batchTargetVec(target.elements());
-  target.host(batchTargetVec.data());
-
-  Tensor targetSize({B}, fl::dtype::s32);
-  Tensor scale({B}, fl::dtype::f32);
+  const int L = target.dim(0);
+
+  // the kernels compute the log-softmax of the logits themselves
+  const Tensor logits = input.type() == fl::dtype::f32
+      ? input.tensor()
+      : input.tensor().astype(fl::dtype::f32);
+  const Tensor inputSize = getInputSizeArray(
+      inputs.size() > 2 ? inputs[2].tensor() : Tensor(), T, B);
+  const Tensor targetSize = getTargetSizeArray(target.tensor(), L);
+  // the forward variables of every frame are only stored for the gradient
+  const bool calcGrad = input.isCalcGrad();
+  Tensor loss({B}, fl::dtype::f32);
+  Tensor workspace(
+      {static_cast<long long>(
+          FusedCtc::getWorkspaceSize(B, T, L, /* storeAlpha = */ calcGrad))},
+      fl::dtype::u8);
 
   {
+    fl::DevicePtr logitsRaw(logits);
     fl::DevicePtr targetRaw(target.tensor());
     fl::DevicePtr targetSizeRaw(targetSize);
-    fl::DevicePtr scaleRaw(scale);
-
-    CriterionUtils::batchTargetSize(
-        B,
-        batchL,
-        batchL,
-        static_cast<const int*>(targetRaw.get()),
-        static_cast<int*>(targetSizeRaw.get()),
-        stream);
+    fl::DevicePtr inputSizeRaw(inputSize);
+    fl::DevicePtr lossRaw(loss);
+    fl::DevicePtr workspaceRaw(workspace);
 
-    CriterionUtils::computeScale(
+    FusedCtc::forward(
         B,
         T,
         N,
+        L,
         scaleMode_,
+        calcGrad,
+        static_cast<const float*>(logitsRaw.get()),
+        static_cast<const int*>(targetRaw.get()),
         static_cast<const int*>(targetSizeRaw.get()),
-        static_cast<float*>(scaleRaw.get()),
-        stream);
-  }
-
-  auto batchTargetSizeVec = targetSize.toHostVector<int>();
-  auto batchScaleVec = scale.toHostVector<float>();
-
-  for (int b = 0; b < B; ++b) {
-    const int* targetVec = batchTargetVec.data() + b * batchL;
-    int L = batchTargetSizeVec[b];
-
-    // A heuristic to modify target length to be able to compute CTC loss
-    L = std::min(L, T);
-    const int R = fl::pkg::speech::countRepeats(targetVec, L);
-    L = std::min(L + R, T) - R;
-
-    labelLengths.push_back(L);
-    for (int l = 0; l < L; ++l) {
-      labels.push_back(targetVec[l]);
-    }
-  }
-  Tensor batchScales = Tensor::fromVector({B}, batchScaleVec);
-
-  size_t workspace_size;
-  throw_on_error(
-      get_workspace_size(
-          labelLengths.data(),
-          inputLengths.data(),
-          N,
-          B,
-          options,
-          &workspace_size),
-      "Error: get_workspace_size");
-
-  Tensor workspace({static_cast<long long>(workspace_size)}, fl::dtype::b8);
-
-  std::vector<float> costs(B, 0.0);
-  {
-    DevicePtr inputarrraw(inputarr);
-    DevicePtr gradraw(grad);
-    DevicePtr workspaceraw(workspace);
-    throw_on_error(
-        compute_ctc_loss(
-            (float*)inputarrraw.get(),
-            (float*)gradraw.get(),
-            labels.data(),
-            labelLengths.data(),
-            inputLengths.data(),
-            N,
-            B,
-            costs.data(),
-            workspaceraw.get(),
-            options),
-        "Error: compute_ctc_loss");
+        static_cast<const int*>(inputSizeRaw.get()),
+        static_cast<float*>(lossRaw.get()),
+        workspaceRaw.get(),
+        logits.stream().impl<CUDAStream>().handle());
   }
 
-  Tensor result = Tensor::fromVector(costs);
-
-  result = result * batchScales;
-
-  auto gradFunc = [grad, batchScales](
+  auto gradFunc = [logits, workspace, N, T, B, L](
                       std::vector<Variable>& moduleInputs,
-                      const Variable& grad_output) {
-    auto gradScales = grad_output.tensor() * batchScales;
+                      const Variable& gradOutput) {
     auto& in = moduleInputs[0];
-    gradScales = fl::tile(
-        fl::reshape(gradScales, {1, grad_output.dim(0), 1}),
-        {in.dim(0), 1, in.dim(1)});
-    moduleInputs[0].addGrad(
-        Variable(fl::transpose(grad * gradScales, {0, 2, 1}), false));
+    const auto grad = gradOutput.tensor().astype(fl::dtype::f32);
+    Tensor inputGrad({N, T, B}, fl::dtype::f32);
+    {
+      fl::DevicePtr logitsRaw(logits);
+      fl::DevicePtr targetRaw(moduleInputs[1].tensor());
+      fl::DevicePtr gradRaw(grad);
+      fl::DevicePtr inputGradRaw(inputGrad);
+      fl::DevicePtr workspaceRaw(workspace);
+
+      FusedCtc::backward(
+          B,
+          T,
+          N,
+          L,
+          static_cast<const float*>(logitsRaw.get()),
+          static_cast<const int*>(targetRaw.get()),
+          static_cast<const float*>(gradRaw.get()),
+          static_cast<float*>(inputGradRaw.get()),
+          workspaceRaw.get(),
+          logits.stream().impl<CUDAStream>().handle());
+    }
+    in.addGrad(Variable(inputGrad.astype(in.type()), false));
   };
 
-  return {Variable(result, {input, target}, gradFunc)};
+  return {Variable(loss, {input.withoutData(), target}, gradFunc)};
 }
 } // namespace speech
 } // namespace pkg
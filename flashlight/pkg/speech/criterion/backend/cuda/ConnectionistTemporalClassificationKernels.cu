@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/speech/criterion/backend/cuda/ConnectionistTemporalClassificationKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "flashlight/fl/runtime/CUDAUtils.h"
+
+using fl::lib::seq::CriterionScaleMode;
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+namespace {
+
+constexpr int kMaxBlockSize = 256;
+constexpr int kWarpSize = 32;
+
+// The largest number of states of the targets of a batch
+int maxStates(int T, int L) {
+  return 2 * std::min(L, T) + 1;
+}
+
+// The workspace of a batch, of 4-byte values. The forward variables are last,
+// such that the layout does not depend on their number of rows.
+struct Workspace {
+  float* logZ; // {T, B} log normalizers of the frames
+  float* stats; // {2, B}: the log probability of the target and the scale
+  int* sizes; // {2, B}: the number of frames and of labels
+  float* beta; // {S, 2, B} two rows of backward variables
+  float* alpha; // {S, T, B} forward variables, or {S, 2, B}
+
+  Workspace(void* workspace, int B, int T, int L) {
+    const size_t S = maxStates(T, L);
+    logZ = static_cast<float*>(workspace);
+    stats = logZ + static_cast<size_t>(T) * B;
+    sizes = reinterpret_cast<int*>(stats + 2 * B);
+    beta = reinterpret_cast<float*>(sizes + 2 * B);
+    alpha = beta + 2 * S * B;
+  }
+
+  static size_t size(int B, int T, int L, bool storeAlpha) {
+    const size_t S = maxStates(T, L);
+    const size_t rows = storeAlpha ? T : 2;
+    return sizeof(float) *
+        (static_cast<size_t>(T) * B + 4 * B + 2 * S * B + rows * S * B);
+  }
+};
+
+int blockSize(int states) {
+  return std::min(
+      kMaxBlockSize, (states + kWarpSize - 1) / kWarpSize * kWarpSize);
+}
+
+__device__ float
+computeScale(CriterionScaleMode scaleMode, int T, int targetSize) {
+  switch (scaleMode) {
+    case CriterionScaleMode::INPUT_SZ:
+      return T > 0 ? 1.0f / T : 1.0f;
+    case CriterionScaleMode::INPUT_SZ_SQRT:
+      return T > 0 ? rsqrtf(T) : 1.0f;
+    case CriterionScaleMode::TARGET_SZ:
+      return targetSize > 0 ? 1.0f / targetSize : 1.0f;
+    case CriterionScaleMode::TARGET_SZ_SQRT:
+      return targetSize > 0 ? rsqrtf(targetSize) : 1.0f;
+    default:
+      return 1.0f;
+  }
+}
+
+__device__ float logSumExp(float a, float b, float c) {
+  const float m = fmaxf(a, fmaxf(b, c));
+  if (m == -INFINITY) {
+    return -INFINITY;
+  }
+  return m + logf(expf(a - m) + expf(b - m) + expf(c - m));
+}
+
+__device__ float warpMax(float x) {
+  for (int offset = kWarpSize / 2; offset > 0; offset /= 2) {
+    x = fmaxf(x, __shfl_xor_sync(0xffffffff, x, offset));
+  }
+  return x;
+}
+
+__device__ float warpSum(float x) {
+  for (int offset = kWarpSize / 2; offset > 0; offset /= 2) {
+    x += __shfl_xor_sync(0xffffffff, x, offset);
+  }
+  return x;
+}
+
+/**
+ * One block per utterance. The warps of the block compute the log
+ * normalizers of the frames of the utterance, one frame per warp at a time,
+ * then thread s computes state s, in [0, 2L + 1), of each frame: even states
+ * are blanks and odd states the labels of the target. The predecessor of a
+ * state is itself, the previous state, or the label before it, if it is a
+ * different label.
+ */
+__global__ void forwardKernel(
+    int T,
+    int N,
+    int L,
+    CriterionScaleMode scaleMode,
+    bool storeAlpha,
+    const float* input,
+    const int* target,
+    const int* targetSize,
+    const int* inputSize,
+    float* loss,
+    float* logZ,
+    float* stats,
+    int* sizes,
+    float* alpha) {
+  __shared__ int sharedT;
+  __shared__ int sharedL;
+  const int b = blockIdx.x;
+  const int maxS = 2 * min(L, T) + 1;
+  const int* tgt = target + b * L;
+  const float* in = input + static_cast<size_t>(b) * T * N;
+  float* lz = logZ + static_cast<size_t>(b) * T;
+  float* al = alpha + static_cast<size_t>(b) * (storeAlpha ? T : 2) * maxS;
+
+  if (threadIdx.x == 0) {
+    // The target is truncated to be aligned to the frames of the utterance,
+    // as by the criterion
+    const int uttT = min(max(inputSize[b], 1), T);
+    int uttL = min(targetSize[b], uttT);
+    int R = 0;
+    for (int i = 1; i < uttL; ++i) {
+      R += (tgt[i] == tgt[i - 1]);
+    }
+    uttL = min(uttL + R, uttT) - R;
+    sharedT = uttT;
+    sharedL = uttL;
+    sizes[2 * b] = uttT;
+    sizes[2 * b + 1] = uttL;
+  }
+  __syncthreads();
+  const int uttT = sharedT;
+  const int S = 2 * sharedL + 1;
+
+  const int lane = threadIdx.x % kWarpSize;
+  const int warps = blockDim.x / kWarpSize;
+  for (int t = threadIdx.x / kWarpSize; t < uttT; t += warps) {
+    const float* frame = in + static_cast<size_t>(t) * N;
+    float m = -INFINITY;
+    for (int n = lane; n < N; n += kWarpSize) {
+      m = fmaxf(m, frame[n]);
+    }
+    m = warpMax(m);
+    float s = 0.0f;
+    for (int n = lane; n < N; n += kWarpSize) {
+      s += expf(frame[n] - m);
+    }
+    s = warpSum(s);
+    if (lane == 0) {
+      lz[t] = m + logf(s);
+    }
+  }
+  __syncthreads();
+
+  auto label = [&](int s) { return (s & 1) ? tgt[s / 2] : N - 1; };
+  auto row = [&](int t) { return al + (storeAlpha ? t : (t & 1)) * maxS; };
+  auto logProb = [&](int t, int s) {
+    return in[static_cast<size_t>(t) * N + label(s)] - lz[t];
+  };
+
+  float* first = row(0);
+  for (int s = threadIdx.x; s < S; s += blockDim.x) {
+    first[s] = (s < 2) ? logProb(0, s) : -INFINITY;
+  }
+  __syncthreads();
+  for (int t = 1; t < uttT; ++t) {
+    const float* prev = row(t - 1);
+    float* cur = row(t);
+    for (int s = threadIdx.x; s < S; s += blockDim.x) {
+      const float a1 = s > 0 ? prev[s - 1] : -INFINITY;
+      const float a2 = ((s & 1) && s > 1 && tgt[s / 2] != tgt[s / 2 - 1])
+          ? prev[s - 2]
+          : -INFINITY;
+      cur[s] = logSumExp(prev[s], a1, a2) + logProb(t, s);
+    }
+    __syncthreads();
+  }
+
+  if (threadIdx.x == 0) {
+    const float* last = row(uttT - 1);
+    const float lp =
+        logSumExp(last[S - 1], S > 1 ? last[S - 2] : -INFINITY, -INFINITY);
+    const float scale = computeScale(scaleMode, uttT, targetSize[b]);
+    loss[b] = -lp * scale;
+    stats[2 * b] = lp;
+    stats[2 * b + 1] = scale;
+  }
+}
+
+/**
+ * One block per utterance. The gradient of the logits of a frame is their
+ * softmax minus the posteriors of the states which emit each token. Thread s
+ * computes the backward variable of state s of each frame from the next
+ * frame, whose emissions are excluded from it, and adds the posterior of s,
+ * from the forward and backward variables, atomically, as several states may
+ * emit the same token.
+ */
+__global__ void backwardKernel(
+    int T,
+    int N,
+    int L,
+    const float* input,
+    const int* target,
+    const float* grad,
+    float* inputGrad,
+    const float* logZ,
+    const float* stats,
+    const int* sizes,
+    float* beta,
+    const float* alpha) {
+  const int b = blockIdx.x;
+  const int maxS = 2 * min(L, T) + 1;
+  const int* tgt = target + b * L;
+  const size_t offset = static_cast<size_t>(b) * T * N;
+  const float* in = input + offset;
+  float* out = inputGrad + offset;
+  const float* lz = logZ + static_cast<size_t>(b) * T;
+  const float* al = alpha + static_cast<size_t>(b) * T * maxS;
+  const int uttT = sizes[2 * b];
+  const int S = 2 * sizes[2 * b + 1] + 1;
+  const float lp = stats[2 * b];
+  const float g = grad[b] * stats[2 * b + 1];
+  // an impossible target has an infinite loss, and no gradient
+  const bool finite = isfinite(lp);
+
+  for (size_t i = threadIdx.x; i < static_cast<size_t>(T) * N;
+       i += blockDim.x) {
+    const int t = i / N;
+    out[i] = (finite && t < uttT) ? g * expf(in[i] - lz[t]) : 0.0f;
+  }
+  __syncthreads();
+  if (!finite) {
+    return;
+  }
+
+  auto label = [&](int s) { return (s & 1) ? tgt[s / 2] : N - 1; };
+  auto canSkip = [&](int s) {
+    return (s & 1) && s > 1 && tgt[s / 2] != tgt[s / 2 - 1];
+  };
+  auto logProb = [&](int t, int s) {
+    return in[static_cast<size_t>(t) * N + label(s)] - lz[t];
+  };
+  auto addPosterior = [&](int t, int s, float be) {
+    const float post = expf(al[t * maxS + s] + be - lp);
+    atomicAdd(out + static_cast<size_t>(t) * N + label(s), -g * post);
+  };
+
+  float* next = beta + 2 * static_cast<size_t>(b) * maxS;
+  float* cur = next + maxS;
+  for (int s = threadIdx.x; s < S; s += blockDim.x) {
+    cur[s] = (s >= S - 2) ? 0.0f : -INFINITY;
+    addPosterior(uttT - 1, s, cur[s]);
+  }
+  __syncthreads();
+  for (int t = uttT - 2; t >= 0; --t) {
+    float* tmp = next;
+    next = cur;
+    cur = tmp;
+    for (int s = threadIdx.x; s < S; s += blockDim.x) {
+      const float b0 = next[s] + logProb(t + 1, s);
+      const float b1 =
+          s + 1 < S ? next[s + 1] + logProb(t + 1, s + 1) : -INFINITY;
+      const float b2 = (s + 2 < S && canSkip(s + 2))
+          ? next[s + 2] + logProb(t + 1, s + 2)
+          : -INFINITY;
+      cur[s] = logSumExp(b0, b1, b2);
+      addPosterior(t, s, cur[s]);
+    }
+    __syncthreads();
+  }
+}
+
+} // namespace
+
+size_t FusedCtcCriterion::getWorkspaceSize(
+    int B,
+    int T,
+    int L,
+    bool storeAlpha) {
+  return Workspace::size(B, T, L, storeAlpha);
+}
+
+void FusedCtcCriterion::forward(
+    int B,
+    int T,
+    int N,
+    int L,
+    CriterionScaleMode scaleMode,
+    bool storeAlpha,
+    const float* input,
+    const int* target,
+    const int* targetSize,
+    const int* inputSize,
+    float* loss,
+    void* workspace,
+    cudaStream_t stream) {
+  Workspace ws(workspace, B, T, L);
+  // enough threads for the states of the longest target, and a warp per
+  // frame for the normalizers
+  const int threads = blockSize(std::max(maxStates(T, L), N));
+  forwardKernel<<<B, threads, 0, stream>>>(
+      T,
+      N,
+      L,
+      scaleMode,
+      storeAlpha,
+      input,
+      target,
+      targetSize,
+      inputSize,
+      loss,
+      ws.logZ,
+      ws.stats,
+      ws.sizes,
+      ws.alpha);
+  FL_CUDA_CHECK(cudaGetLastError());
+}
+
+void FusedCtcCriterion::backward(
+    int B,
+    int T,
+    int N,
+    int L,
+    const float* input,
+    const int* target,
+    const float* grad,
+    float* inputGrad,
+    void* workspace,
+    cudaStream_t stream) {
+  Workspace ws(workspace, B, T, L);
+  const int threads = blockSize(std::max(maxStates(T, L), N));
+  backwardKernel<<<B, threads, 0, stream>>>(
+      T,
+      N,
+      L,
+      input,
+      target,
+      grad,
+      inputGrad,
+      ws.logZ,
+      ws.stats,
+      ws.sizes,
+      ws.beta,
+      ws.alpha);
+  FL_CUDA_CHECK(cudaGetLastError());
+}
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
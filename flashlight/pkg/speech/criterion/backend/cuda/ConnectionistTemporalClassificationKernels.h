@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <cuda_runtime.h>
+
+#include "flashlight/pkg/speech/criterion/Defines.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+/**
+ * Fused CUDA kernels of the CTC loss of {N, T, B} logits, i.e. unnormalized
+ * scores whose blank is N - 1, and {L, B} targets.
+ *
+ * Each utterance is computed by a single block in a single launch for the
+ * whole batch, forward and backward. The log-softmax of the logits is part of
+ * the kernels: the forward pass computes the log normalizer of each frame and
+ * the recursion reads the logits, such that the log probabilities are never
+ * written, and the backward pass computes the gradient of the logits
+ * directly. A block only runs over the frames and the states of its
+ * utterance, i.e. its number of frames and its target, truncated as by the
+ * criterion, such that padding costs neither compute nor synchronization.
+ *
+ * The workspace, which the caller allocates, stores the log normalizers, the
+ * forward variables if the gradient is computed, two rows of them otherwise,
+ * and a few values per utterance.
+ */
+struct FusedCtcCriterion {
+  static size_t getWorkspaceSize(int B, int T, int L, bool storeAlpha);
+
+  /**
+   * Losses of {N, T, B} logits for {L, B} targets of sizes {B}, of which
+   * utterance b has inputSize[b] frames.
+   */
+  static void forward(
+      int B,
+      int T,
+      int N,
+      int L,
+      fl::lib::seq::CriterionScaleMode scaleMode,
+      bool storeAlpha,
+      const float* input,
+      const int* target,
+      const int* targetSize,
+      const int* inputSize,
+      float* loss,
+      void* workspace,
+      cudaStream_t stream);
+
+  /**
+   * Gradient of the logits from the {B} gradient of the losses, with the
+   * workspace of a forward pass which stored the forward variables.
+   */
+  static void backward(
+      int B,
+      int T,
+      int N,
+      int L,
+      const float* input,
+      const int* target,
+      const float* grad,
+      float* inputGrad,
+      void* workspace,
+      cudaStream_t stream);
+};
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
@@ -12,6 +12,7 @@
 #include "flashlight/fl/common/DevicePtr.h"
 #include "flashlight/fl/runtime/CUDAStream.h"
 #include "flashlight/fl/tensor/TensorBackend.h"
+#include "flashlight/pkg/speech/criterion/backend/cuda/ViterbiKernels.h"
 
 #include <flashlight/lib/sequence/criterion/cuda/CriterionUtils.cuh>
 #include <flashlight/lib/sequence/criterion/cuda/ViterbiPath.cuh>
@@ -46,8 +47,12 @@ Tensor viterbiPath(const Tensor& input, const Tensor& trans) {
   }
 
   Tensor path({T, B}, fl::dtype::s32);
+  // the batched kernels pack back-pointers into uint16
+  const bool batched = N <= BatchedViterbi::kMaxTokens;
   Tensor workspace(
-      {static_cast<long long>(ViterbiPath::getWorkspaceSize(B, T, N))},
+      {static_cast<long long>(
+          batched ? BatchedViterbi::getWorkspaceSize(B, T, N)
+                  : ViterbiPath::getWorkspaceSize(B, T, N))},
       fl::dtype::u8);
 
   {
@@ -55,13 +60,52 @@ Tensor viterbiPath(const Tensor& input, const Tensor& trans) {
     fl::DevicePtr transRaw(trans);
     fl::DevicePtr pathRaw(path);
     fl::DevicePtr workspaceRaw(workspace);
+    const auto* inputPtr = static_cast<const float*>(inputRaw.get());
+    const auto* transPtr = static_cast<const float*>(transRaw.get());
+    auto* pathPtr = static_cast<int*>(pathRaw.get());
+    auto stream = input.stream().impl<CUDAStream>().handle();
+
+    if (batched) {
+      BatchedViterbi::compute(
+          B, T, N, inputPtr, transPtr, pathPtr, workspaceRaw.get(), stream);
+    } else {
+      ViterbiPath::compute(
+          B, T, N, inputPtr, transPtr, pathPtr, workspaceRaw.get(), stream);
+    }
+  }
+
+  return path;
+}
+
+Tensor ctcViterbiPath(
+    const Tensor& input,
+    const Tensor& target,
+    const Tensor& targetSize) {
+  int N = input.dim(0);
+  int T = input.dim(1);
+  int B = input.dim(2);
+  int L = target.dim(0);
+
+  Tensor path({T, B}, fl::dtype::s32);
+  Tensor workspace(
+      {static_cast<long long>(BatchedViterbi::getCtcWorkspaceSize(B, T, L))},
+      fl::dtype::u8);
 
-    ViterbiPath::compute(
+  {
+    fl::DevicePtr inputRaw(input);
+    fl::DevicePtr targetRaw(target);
+    fl::DevicePtr targetSizeRaw(targetSize);
+    fl::DevicePtr pathRaw(path);
+    fl::DevicePtr workspaceRaw(workspace);
+
+    BatchedViterbi::computeCtc(
         B,
         T,
         N,
+        L,
         static_cast<const float*>(inputRaw.get()),
-        static_cast<const float*>(transRaw.get()),
+        static_cast<const int*>(targetRaw.get()),
+        static_cast<const int*>(targetSizeRaw.get()),
         static_cast<int*>(pathRaw.get()),
         workspaceRaw.get(),
         input.stream().impl<CUDAStream>().handle());
@@ -13,10 +13,9 @@
 #include "flashlight/fl/runtime/CUDAStream.h"
 #include "flashlight/fl/tensor/TensorBackend.h"
 #include "flashlight/pkg/speech/criterion/CriterionUtils.h"
+#include "flashlight/pkg/speech/criterion/backend/cuda/FullConnectionKernels.h"
 
-#include <flashlight/lib/sequence/criterion/cuda/FullConnectionCriterion.cuh>
-
-using FCC = fl::lib::cuda::FullConnectionCriterion<float>;
+using FCC = fl::pkg::speech::FusedFullConnectionCriterion;
 
 namespace fl {
 namespace pkg {
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/speech/criterion/backend/cuda/FullConnectionKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "flashlight/fl/runtime/CUDAUtils.h"
+
+using fl::lib::seq::CriterionScaleMode;
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+namespace {
+
+constexpr int kMaxBlockSize = 256;
+// The default shared memory of a block, which holds the transitions of small
+// token sets
+constexpr size_t kMaxSharedBytes = 48 * 1024;
+
+// The workspace of a batch, in floats
+struct Workspace {
+  float* alpha; // {N, T, B} forward variables
+  float* norm; // {N, T, B} log normalizers of the transitions into frames
+  float* stats; // {2, B}: the log partition function and the scale
+  float* transT; // {N, N} transposed transitions
+
+  Workspace(void* workspace, int B, int T, int N) {
+    const size_t frames = static_cast<size_t>(B) * T * N;
+    alpha = static_cast<float*>(workspace);
+    norm = alpha + frames;
+    stats = norm + frames;
+    transT = stats + 2 * B;
+  }
+
+  static size_t size(int B, int T, int N) {
+    return sizeof(float) *
+        (2 * static_cast<size_t>(B) * T * N + 2 * B +
+         static_cast<size_t>(N) * N);
+  }
+};
+
+int blockSize(int N) {
+  return std::min(kMaxBlockSize, (N + 31) / 32 * 32);
+}
+
+__device__ float
+computeScale(CriterionScaleMode scaleMode, int T, int targetSize) {
+  switch (scaleMode) {
+    case CriterionScaleMode::INPUT_SZ:
+      return T > 0 ? 1.0f / T : 1.0f;
+    case CriterionScaleMode::INPUT_SZ_SQRT:
+      return T > 0 ? rsqrtf(T) : 1.0f;
+    case CriterionScaleMode::TARGET_SZ:
+      return targetSize > 0 ? 1.0f / targetSize : 1.0f;
+    case CriterionScaleMode::TARGET_SZ_SQRT:
+      return targetSize > 0 ? rsqrtf(targetSize) : 1.0f;
+    default:
+      return 1.0f;
+  }
+}
+
+// Accumulates x into a running log-sum-exp of max m and sum s
+__device__ void logSumExpAdd(float x, float& m, float& s) {
+  if (x == -INFINITY) {
+    return;
+  }
+  if (x > m) {
+    s = s * expf(m - x) + 1.0f;
+    m = x;
+  } else {
+    s += expf(x - m);
+  }
+}
+
+__global__ void transposeKernel(int N, const float* trans, float* transT) {
+  for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < N * N;
+       i += gridDim.x * blockDim.x) {
+    transT[(i % N) * N + i / N] = trans[i];
+  }
+}
+
+/**
+ * One block per utterance. Thread n computes the state n of each frame from
+ * the previous frame, which is read by all the threads of the block, and the
+ * transitions into n, i.e. column n of the transposed matrix, such that the
+ * reads of a warp are contiguous.
+ */
+template <bool kSharedTrans>
+__global__ void forwardKernel(
+    int T,
+    int N,
+    CriterionScaleMode scaleMode,
+    const float* input,
+    const int* targetSize,
+    const float* transT,
+    float* loss,
+    float* alpha,
+    float* norm,
+    float* stats) {
+  extern __shared__ float sharedTrans[];
+  const int b = blockIdx.x;
+  const float* tr = transT;
+  if (kSharedTrans) {
+    for (int i = threadIdx.x; i < N * N; i += blockDim.x) {
+      sharedTrans[i] = transT[i];
+    }
+    tr = sharedTrans;
+  }
+  const size_t offset = static_cast<size_t>(b) * T * N;
+  const float* in = input + offset;
+  float* al = alpha + offset;
+  float* nm = norm + offset;
+
+  for (int n = threadIdx.x; n < N; n += blockDim.x) {
+    al[n] = in[n];
+    nm[n] = 0.0f;
+  }
+  __syncthreads();
+  for (int t = 1; t < T; ++t) {
+    const float* prev = al + (t - 1) * N;
+    for (int n = threadIdx.x; n < N; n += blockDim.x) {
+      float m = -INFINITY;
+      float s = 0.0f;
+      for (int j = 0; j < N; ++j) {
+        logSumExpAdd(tr[j * N + n] + prev[j], m, s);
+      }
+      const float lse = m + logf(s);
+      nm[t * N + n] = lse;
+      al[t * N + n] = lse + in[t * N + n];
+    }
+    __syncthreads();
+  }
+
+  if (threadIdx.x == 0) {
+    const float* last = al + (T - 1) * N;
+    float m = -INFINITY;
+    float s = 0.0f;
+    for (int n = 0; n < N; ++n) {
+      logSumExpAdd(last[n], m, s);
+    }
+    const float logZ = m + logf(s);
+    const float scale = computeScale(scaleMode, T, targetSize[b]);
+    loss[b] = logZ * scale;
+    stats[2 * b] = logZ;
+    stats[2 * b + 1] = scale;
+  }
+}
+
+/**
+ * One block per utterance. The gradient of a frame is the input gradient,
+ * from which thread j gathers the gradient of state j of the previous frame
+ * over the transitions out of j, i.e. column j of the matrix, recomputing
+ * their weights from the forward variables and normalizers. The transition
+ * gradients of an utterance are accumulated in shared memory when they fit,
+ * and added atomically to the global ones otherwise.
+ */
+template <bool kSharedTrans>
+__global__ void backwardKernel(
+    int T,
+    int N,
+    const float* trans,
+    const float* grad,
+    float* inputGrad,
+    float* transGrad,
+    const float* alpha,
+    const float* norm,
+    const float* stats) {
+  extern __shared__ float sharedTrans[];
+  const int b = blockIdx.x;
+  const float* tr = trans;
+  float* trGrad = transGrad;
+  if (kSharedTrans) {
+    for (int i = threadIdx.x; i < N * N; i += blockDim.x) {
+      sharedTrans[i] = trans[i];
+      sharedTrans[N * N + i] = 0.0f;
+    }
+    tr = sharedTrans;
+    trGrad = sharedTrans + N * N;
+  }
+  const size_t offset = static_cast<size_t>(b) * T * N;
+  const float* al = alpha + offset;
+  const float* nm = norm + offset;
+  float* dAlpha = inputGrad + offset;
+  const float logZ = stats[2 * b];
+  const float g = grad[b] * stats[2 * b + 1];
+
+  for (int n = threadIdx.x; n < N; n += blockDim.x) {
+    dAlpha[(T - 1) * N + n] = g * expf(al[(T - 1) * N + n] - logZ);
+  }
+  __syncthreads();
+  for (int t = T - 1; t > 0; --t) {
+    const float* cur = dAlpha + t * N;
+    const float* curNorm = nm + t * N;
+    for (int j = threadIdx.x; j < N; j += blockDim.x) {
+      const float prev = al[(t - 1) * N + j];
+      float acc = 0.0f;
+      for (int n = 0; n < N; ++n) {
+        const float d = cur[n] * expf(tr[n * N + j] + prev - curNorm[n]);
+        acc += d;
+        if (kSharedTrans) {
+          trGrad[n * N + j] += d;
+        } else {
+          atomicAdd(trGrad + n * N + j, d);
+        }
+      }
+      dAlpha[(t - 1) * N + j] = acc;
+    }
+    __syncthreads();
+  }
+
+  if (kSharedTrans) {
+    for (int i = threadIdx.x; i < N * N; i += blockDim.x) {
+      atomicAdd(transGrad + i, trGrad[i]);
+    }
+  }
+}
+
+} // namespace
+
+size_t FusedFullConnectionCriterion::getWorkspaceSize(int B, int T, int N) {
+  return Workspace::size(B, T, N);
+}
+
+void FusedFullConnectionCriterion::forward(
+    int B,
+    int T,
+    int N,
+    CriterionScaleMode scaleMode,
+    const float* input,
+    const int* targetSize,
+    const float* trans,
+    float* loss,
+    void* workspace,
+    cudaStream_t stream) {
+  Workspace ws(workspace, B, T, N);
+  const int threads = blockSize(N);
+  const int transposeBlocks = (N * N + kMaxBlockSize - 1) / kMaxBlockSize;
+  transposeKernel<<<transposeBlocks, kMaxBlockSize, 0, stream>>>(
+      N, trans, ws.transT);
+  const size_t sharedBytes = sizeof(float) * N * N;
+  if (sharedBytes <= kMaxSharedBytes) {
+    forwardKernel<true><<<B, threads, sharedBytes, stream>>>(
+        T,
+        N,
+        scaleMode,
+        input,
+        targetSize,
+        ws.transT,
+        loss,
+        ws.alpha,
+        ws.norm,
+        ws.stats);
+  } else {
+    forwardKernel<false><<<B, threads, 0, stream>>>(
+        T,
+        N,
+        scaleMode,
+        input,
+        targetSize,
+        ws.transT,
+        loss,
+        ws.alpha,
+        ws.norm,
+        ws.stats);
+  }
+  FL_CUDA_CHECK(cudaGetLastError());
+}
+
+void FusedFullConnectionCriterion::backward(
+    int B,
+    int T,
+    int N,
+    const float* trans,
+    const float* grad,
+    float* inputGrad,
+    float* transGrad,
+    void* workspace,
+    cudaStream_t stream) {
+  Workspace ws(workspace, B, T, N);
+  const int threads = blockSize(N);
+  FL_CUDA_CHECK(cudaMemsetAsync(transGrad, 0, sizeof(float) * N * N, stream));
+  const size_t sharedBytes = 2 * sizeof(float) * N * N;
+  if (sharedBytes <= kMaxSharedBytes) {
+    backwardKernel<true><<<B, threads, sharedBytes, stream>>>(
+        T, N, trans, grad, inputGrad, transGrad, ws.alpha, ws.norm, ws.stats);
+  } else {
+    backwardKernel<false><<<B, threads, 0, stream>>>(
+        T, N, trans, grad, inputGrad, transGrad, ws.alpha, ws.norm, ws.stats);
+  }
+  FL_CUDA_CHECK(cudaGetLastError());
+}
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
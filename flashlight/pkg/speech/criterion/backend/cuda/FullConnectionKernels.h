@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <cuda_runtime.h>
+
+#include "flashlight/pkg/speech/criterion/Defines.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+/**
+ * Fused CUDA kernels of the full connection criterion, i.e. the log of the
+ * partition function of ASG over all the paths of a {N, T, B} input and a
+ * {N, N} transition matrix.
+ *
+ * Each utterance is computed by a single block in a single launch for the
+ * whole batch, forward and backward, with the transition matrix and the
+ * frames of the recursion in shared memory when they fit. The workspace
+ * stores the {N, T, B} forward variables and two floats per utterance only:
+ * the backward pass recomputes the transition weights of each frame from the
+ * forward variables, instead of storing them for every frame.
+ *
+ * The interface mirrors `fl::lib::cuda::FullConnectionCriterion`.
+ */
+struct FusedFullConnectionCriterion {
+  static size_t getWorkspaceSize(int B, int T, int N);
+
+  static void forward(
+      int B,
+      int T,
+      int N,
+      fl::lib::seq::CriterionScaleMode scaleMode,
+      const float* input,
+      const int* targetSize,
+      const float* trans,
+      float* loss,
+      void* workspace,
+      cudaStream_t stream);
+
+  static void backward(
+      int B,
+      int T,
+      int N,
+      const float* trans,
+      const float* grad,
+      float* inputGrad,
+      float* transGrad,
+      void* workspace,
+      cudaStream_t stream);
+};
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/speech/criterion/backend/cuda/ViterbiKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "flashlight/fl/runtime/CUDAUtils.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+namespace {
+
+constexpr int kMaxBlockSize = 256;
+// The default shared memory of a block, which holds the transitions of small
+// token sets
+constexpr size_t kMaxSharedBytes = 48 * 1024;
+
+size_t align(size_t bytes) {
+  return (bytes + 255) / 256 * 256;
+}
+
+int blockSize(int states) {
+  return std::min(kMaxBlockSize, (states + 31) / 32 * 32);
+}
+
+__global__ void transposeKernel(int N, const float* trans, float* transT) {
+  for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < N * N;
+       i += gridDim.x * blockDim.x) {
+    transT[(i % N) * N + i / N] = trans[i];
+  }
+}
+
+/**
+ * One block per utterance, thread n computes token n of each frame from the
+ * transitions into n, i.e. column n of the transposed matrix. The scores of
+ * the two last frames are double buffered.
+ */
+template <bool kSharedTrans>
+__global__ void viterbiKernel(
+    int T,
+    int N,
+    const float* input,
+    const float* transT,
+    int* path,
+    float* scores,
+    uint16_t* backPtrs) {
+  extern __shared__ float sharedTrans[];
+  const int b = blockIdx.x;
+  const float* tr = transT;
+  if (kSharedTrans) {
+    for (int i = threadIdx.x; i < N * N; i += blockDim.x) {
+      sharedTrans[i] = transT[i];
+    }
+    tr = sharedTrans;
+  }
+  const float* in = input + static_cast<size_t>(b) * T * N;
+  uint16_t* bp = backPtrs + static_cast<size_t>(b) * T * N;
+  float* prev = scores + 2 * static_cast<size_t>(b) * N;
+  float* cur = prev + N;
+
+  for (int n = threadIdx.x; n < N; n += blockDim.x) {
+    prev[n] = in[n];
+  }
+  __syncthreads();
+  for (int t = 1; t < T; ++t) {
+    for (int n = threadIdx.x; n < N; n += blockDim.x) {
+      float best = -INFINITY;
+      int bestIdx = 0;
+      for (int j = 0; j < N; ++j) {
+        const float score = tr[j * N + n] + prev[j];
+        if (score > best) {
+          best = score;
+          bestIdx = j;
+        }
+      }
+      cur[n] = best + in[t * N + n];
+      bp[t * N + n] = bestIdx;
+    }
+    __syncthreads();
+    float* tmp = prev;
+    prev = cur;
+    cur = tmp;
+  }
+
+  if (threadIdx.x == 0) {
+    int n = 0;
+    for (int i = 1; i < N; ++i) {
+      if (prev[i] > prev[n]) {
+        n = i;
+      }
+    }
+    for (int t = T - 1; t >= 0; --t) {
+      path[b * T + t] = n;
+      n = bp[t * N + n];
+    }
+  }
+}
+
+/**
+ * One block per utterance, thread s computes state s, in [0, 2L + 1), of each
+ * frame: even states are blanks and odd states the labels of the target. The
+ * predecessor of a state is itself, the previous state, or the label before
+ * it, if it is a different label.
+ */
+__global__ void ctcViterbiKernel(
+    int T,
+    int N,
+    int maxL,
+    const float* input,
+    const int* target,
+    const int* targetSize,
+    int* path,
+    float* scores,
+    uint8_t* backPtrs) {
+  __shared__ int sharedL;
+  const int b = blockIdx.x;
+  const int maxS = 2 * maxL + 1;
+  const int* tgt = target + b * maxL;
+  const float* in = input + static_cast<size_t>(b) * T * N;
+  uint8_t* bp = backPtrs + static_cast<size_t>(b) * T * maxS;
+  float* prev = scores + 2 * static_cast<size_t>(b) * maxS;
+  float* cur = prev + maxS;
+
+  if (threadIdx.x == 0) {
+    // The target is truncated to be aligned to T frames, as by the criterion
+    int L = targetSize[b];
+    int R = 0;
+    for (int i = 1; i < L; ++i) {
+      R += (tgt[i] == tgt[i - 1]);
+    }
+    sharedL = min(L + R, T) - R;
+  }
+  __syncthreads();
+  const int S = 2 * sharedL + 1;
+  auto label = [&](int s) { return (s & 1) ? tgt[s / 2] : N - 1; };
+
+  for (int s = threadIdx.x; s < S; s += blockDim.x) {
+    prev[s] = (s < 2) ? in[label(s)] : -INFINITY;
+  }
+  __syncthreads();
+  for (int t = 1; t < T; ++t) {
+    for (int s = threadIdx.x; s < S; s += blockDim.x) {
+      float best = prev[s];
+      uint8_t offset = 0;
+      if (s > 0 && prev[s - 1] > best) {
+        best = prev[s - 1];
+        offset = 1;
+      }
+      if ((s & 1) && s > 1 && tgt[s / 2] != tgt[s / 2 - 1] &&
+          prev[s - 2] > best) {
+        best = prev[s - 2];
+        offset = 2;
+      }
+      cur[s] = best + in[t * N + label(s)];
+      bp[t * maxS + s] = offset;
+    }
+    __syncthreads();
+    float* tmp = prev;
+    prev = cur;
+    cur = tmp;
+  }
+
+  if (threadIdx.x == 0) {
+    int s = (S == 1 || prev[S - 1] > prev[S - 2]) ? S - 1 : S - 2;
+    for (int t = T - 1; t >= 0; --t) {
+      path[b * T + t] = label(s);
+      s -= bp[t * maxS + s];
+    }
+  }
+}
+
+} // namespace
+
+size_t BatchedViterbi::getWorkspaceSize(int B, int T, int N) {
+  return align(sizeof(float) * 2 * B * N) +
+      align(sizeof(float) * static_cast<size_t>(N) * N) +
+      sizeof(uint16_t) * static_cast<size_t>(B) * T * N;
+}
+
+void BatchedViterbi::compute(
+    int B,
+    int T,
+    int N,
+    const float* input,
+    const float* trans,
+    int* path,
+    void* workspace,
+    cudaStream_t stream) {
+  auto* scores = static_cast<float*>(workspace);
+  auto* transT = reinterpret_cast<float*>(
+      static_cast<char*>(workspace) + align(sizeof(float) * 2 * B * N));
+  auto* backPtrs = reinterpret_cast<uint16_t*>(
+      reinterpret_cast<char*>(transT) +
+      align(sizeof(float) * static_cast<size_t>(N) * N));
+
+  const int transposeBlocks = (N * N + kMaxBlockSize - 1) / kMaxBlockSize;
+  transposeKernel<<<transposeBlocks, kMaxBlockSize, 0, stream>>>(
+      N, trans, transT);
+  const int threads = blockSize(N);
+  const size_t sharedBytes = sizeof(float) * N * N;
+  if (sharedBytes <= kMaxSharedBytes) {
+    viterbiKernel<true><<<B, threads, sharedBytes, stream>>>(
+        T, N, input, transT, path, scores, backPtrs);
+  } else {
+    viterbiKernel<false><<<B, threads, 0, stream>>>(
+        T, N, input, transT, path, scores, backPtrs);
+  }
+  FL_CUDA_CHECK(cudaGetLastError());
+}
+
+size_t BatchedViterbi::getCtcWorkspaceSize(int B, int T, int L) {
+  const size_t maxS = 2 * L + 1;
+  return align(sizeof(float) * 2 * B * maxS) + sizeof(uint8_t) * B * T * maxS;
+}
+
+void BatchedViterbi::computeCtc(
+    int B,
+    int T,
+    int N,
+    int L,
+    const float* input,
+    const int* target,
+    const int* targetSize,
+    int* path,
+    void* workspace,
+    cudaStream_t stream) {
+  const size_t maxS = 2 * L + 1;
+  auto* scores = static_cast<float*>(workspace);
+  auto* backPtrs = static_cast<uint8_t*>(workspace) +
+      align(sizeof(float) * 2 * B * maxS);
+  ctcViterbiKernel<<<B, blockSize(maxS), 0, stream>>>(
+      T, N, L, input, target, targetSize, path, scores, backPtrs);
+  FL_CUDA_CHECK(cudaGetLastError());
+}
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <cuda_runtime.h>
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+/**
+ * Batched CUDA Viterbi kernels, which decode or align a whole batch in a
+ * single launch, with one block per utterance, and back-track on the device
+ * such that the {T, B} paths are copied to the host at most once.
+ *
+ * Back-pointers are packed: the predecessor of a token among N is stored as
+ * uint16 for the transitions of ASG, and the predecessor of a CTC state,
+ * which is one of its three previous states, as a uint8 offset.
+ */
+struct BatchedViterbi {
+  // The largest number of tokens with uint16 back-pointers
+  static constexpr int kMaxTokens = 65536;
+
+  static size_t getWorkspaceSize(int B, int T, int N);
+
+  /**
+   * Best paths over the tokens of {N, T, B} emissions and {N, N} transitions.
+   */
+  static void compute(
+      int B,
+      int T,
+      int N,
+      const float* input,
+      const float* trans,
+      int* path,
+      void* workspace,
+      cudaStream_t stream);
+
+  static size_t getCtcWorkspaceSize(int B, int T, int L);
+
+  /**
+   * Best CTC alignments of {L, B} targets of sizes {B} to {N, T, B} log
+   * probabilities, whose blank is N - 1. Targets which are too long for T
+   * are truncated as by the criterion.
+   */
+  static void computeCtc(
+      int B,
+      int T,
+      int N,
+      int L,
+      const float* input,
+      const int* target,
+      const int* targetSize,
+      int* path,
+      void* workspace,
+      cudaStream_t stream);
+};
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
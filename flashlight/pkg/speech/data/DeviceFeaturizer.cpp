@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/speech/data/DeviceFeaturizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "flashlight/fl/tensor/Index.h"
+#include "flashlight/fl/tensor/Random.h"
+#include "flashlight/pkg/speech/audio/feature/Ceplifter.h"
+#include "flashlight/pkg/speech/audio/feature/Dct.h"
+#include "flashlight/pkg/speech/audio/feature/TriFilterbank.h"
+#include "flashlight/pkg/speech/audio/feature/Windowing.h"
+
+using namespace fl::lib::audio;
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+namespace {
+
+// HTK scaling of the samples, see lib::audio::frameSignal
+constexpr float kSampleScale = 32768.0;
+
+// The derivative of order one of features (FEAT x FRAMES x B) along frames,
+// see lib::audio::Derivatives
+Tensor derivative(const Tensor& feat, int window) {
+  const int nFrames = feat.dim(1);
+  const float denominator = (window * (window + 1) * (2 * window + 1)) / 3.0;
+  Tensor output = fl::full(feat.shape(), 0.0, feat.type());
+  std::vector<int> next(nFrames), prev(nFrames);
+  for (int d = 1; d <= window; ++d) {
+    for (int i = 0; i < nFrames; ++i) {
+      next[i] = std::min(i + d, nFrames - 1);
+      prev[i] = std::max(i - d, 0);
+    }
+    auto nextIdx = Tensor::fromVector(next);
+    auto prevIdx = Tensor::fromVector(prev);
+    output = output +
+        d * (feat(fl::span, nextIdx, fl::span) -
+             feat(fl::span, prevIdx, fl::span));
+  }
+  return output / denominator;
+}
+
+} // namespace
+
+DeviceFeaturizer::DeviceFeaturizer(
+    const FeatureParams& params,
+    FeatureType featureType)
+    : params_(params), featureType_(featureType) {
+  if (featureType_ == FeatureType::NONE) {
+    throw std::invalid_argument(
+        "DeviceFeaturizer::DeviceFeaturizer - no features to compute");
+  }
+  const int N = params_.numFrameSizeSamples();
+  if (N <= 1 || params_.numFrameStrideSamples() <= 0) {
+    throw std::invalid_argument(
+        "DeviceFeaturizer::DeviceFeaturizer - invalid frame size or stride");
+  }
+  if (params_.preemCoef < 0.0 || params_.preemCoef >= 1.0) {
+    throw std::invalid_argument(
+        "DeviceFeaturizer::DeviceFeaturizer - preemCoef must be in [0, 1)");
+  }
+  // the coefficients are the ones of the host implementation
+  window_ = Tensor::fromVector(
+      {N, 1},
+      Windowing(N, params_.windowType).apply(std::vector<float>(N, 1.0)));
+
+  const int nFft = params_.nFft();
+  const int K = params_.filterFreqResponseLen();
+  // the zero padding of frames to nFft samples drops the last columns
+  std::vector<float> dftCos(K * N), dftSin(K * N);
+  for (int n = 0; n < N; ++n) {
+    for (int k = 0; k < K; ++k) {
+      // reduce the angle exactly before converting it
+      const double angle =
+          2 * M_PI * ((static_cast<int64_t>(k) * n) % nFft) / nFft;
+      dftCos[n * K + k] = std::cos(angle);
+      dftSin[n * K + k] = -std::sin(angle);
+    }
+  }
+  dftCos_ = Tensor::fromVector({K, N}, dftCos);
+  dftSin_ = Tensor::fromVector({K, N}, dftSin);
+  if (featureType_ == FeatureType::POW_SPECTRUM) {
+    return;
+  }
+
+  if (params_.numFilterbankChans <= 0 || params_.melFloor <= 0.0) {
+    throw std::invalid_argument(
+        "DeviceFeaturizer::DeviceFeaturizer - invalid filterbank parameters");
+  }
+  const int numFilters = params_.numFilterbankChans;
+  TriFilterbank triFltBank(
+      numFilters,
+      K,
+      params_.samplingFreq,
+      params_.lowFreqFilterbank,
+      params_.highFreqFilterbank,
+      FrequencyScale::MEL);
+  // K x numFilters in row-major order
+  filterbank_ = Tensor::fromVector({numFilters, K}, triFltBank.filterbank());
+  if (featureType_ == FeatureType::MFSC) {
+    return;
+  }
+
+  const int numCeps = params_.numCepstralCoeffs;
+  std::vector<float> identity(numFilters * numFilters, 0.0);
+  for (int f = 0; f < numFilters; ++f) {
+    identity[f * numFilters + f] = 1.0;
+  }
+  // numFilters x numCeps in row-major order
+  dct_ = Tensor::fromVector(
+      {numCeps, numFilters}, Dct(numFilters, numCeps).apply(identity));
+  lifter_ = Tensor::fromVector(
+      {numCeps, 1},
+      Ceplifter(numCeps, params_.lifterParam)
+          .apply(std::vector<float>(numCeps, 1.0)));
+}
+
+Tensor DeviceFeaturizer::apply(const Tensor& input) const {
+  if (input.type() != fl::dtype::f32) {
+    throw std::invalid_argument("DeviceFeaturizer::apply - invalid input type");
+  }
+  if (input.ndim() < 1 || input.ndim() > 2) {
+    throw std::invalid_argument(
+        "DeviceFeaturizer::apply - expected a T x B input");
+  }
+  const int64_t T = input.dim(0);
+  const int64_t B = input.ndim() > 1 ? input.dim(1) : 1;
+  const int64_t nFrames = params_.numFrames(T);
+  if (nFrames == 0) {
+    return Tensor({featureSize(), 0, B}, fl::dtype::f32);
+  }
+  const int64_t N = params_.numFrameSizeSamples();
+
+  // N x (FRAMES * B) frames
+  auto frameIdx = fl::arange({N, nFrames}, 0, fl::dtype::s32) +
+      fl::arange({N, nFrames}, 1, fl::dtype::s32) *
+          static_cast<int>(params_.numFrameStrideSamples());
+  auto frames = fl::reshape(
+      fl::reshape(input, {T, B})(frameIdx.flatten(), fl::span) * kSampleScale,
+      {N, nFrames * B});
+
+  const bool useEnergy =
+      params_.useEnergy && featureType_ != FeatureType::POW_SPECTRUM;
+  Tensor energy;
+  if (useEnergy && params_.rawEnergy) {
+    energy = fl::log(fl::sum(frames * frames, {0}, /* keepDims = */ true));
+  }
+  if (params_.ditherVal != 0.0) {
+    frames = frames + params_.ditherVal * fl::rand(frames.shape());
+  }
+  if (params_.zeroMeanFrame) {
+    frames = frames - fl::mean(frames, {0}, /* keepDims = */ true);
+  }
+  if (params_.preemCoef != 0) {
+    const float a = params_.preemCoef;
+    frames = fl::concatenate(
+        0,
+        frames(fl::range(0, 1)) * (1 - a),
+        frames(fl::range(1, N)) - a * frames(fl::range(0, N - 1)));
+  }
+  frames = frames * window_;
+
+  auto re = fl::matmul(dftCos_, frames);
+  auto im = fl::matmul(dftSin_, frames);
+  // K x (FRAMES * B)
+  auto spectrum = re * re + im * im;
+  Tensor feat;
+  if (featureType_ == FeatureType::POW_SPECTRUM) {
+    feat = fl::sqrt(spectrum);
+  } else {
+    if (!params_.usePower) {
+      spectrum = fl::sqrt(spectrum);
+    }
+    feat = fl::log(
+        fl::maximum(fl::matmul(filterbank_, spectrum), params_.melFloor));
+    if (useEnergy && !params_.rawEnergy) {
+      energy = fl::log(fl::sum(frames * frames, {0}, /* keepDims = */ true));
+    }
+    if (featureType_ == FeatureType::MFSC) {
+      if (useEnergy) {
+        feat = fl::concatenate(0, energy, feat);
+      }
+    } else {
+      feat = fl::matmul(dct_, feat) * lifter_;
+      if (useEnergy) {
+        // replace C0 with energy
+        feat = fl::concatenate(
+            0, energy, feat(fl::range(1, params_.numCepstralCoeffs)));
+      }
+    }
+  }
+  return derivatives(fl::reshape(feat, {feat.dim(0), nFrames, B}));
+}
+
+Tensor DeviceFeaturizer::derivatives(const Tensor& feat) const {
+  // derivatives are not computed if windowsize <= 0
+  if (featureType_ == FeatureType::POW_SPECTRUM || params_.deltaWindow <= 0) {
+    return feat;
+  }
+  auto deltas = derivative(feat, params_.deltaWindow);
+  if (params_.accWindow <= 0) {
+    return fl::concatenate(0, feat, deltas);
+  }
+  return fl::concatenate(
+      0, feat, deltas, derivative(deltas, params_.accWindow));
+}
+
+int64_t DeviceFeaturizer::featureSize() const {
+  switch (featureType_) {
+    case FeatureType::POW_SPECTRUM:
+      return params_.powSpecFeatSz();
+    case FeatureType::MFSC:
+      return params_.mfscFeatSz();
+    case FeatureType::MFCC:
+      return params_.mfccFeatSz();
+    default:
+      return 0;
+  }
+}
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
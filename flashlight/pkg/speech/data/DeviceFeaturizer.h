@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/pkg/speech/audio/feature/FeatureParams.h"
+#include "flashlight/pkg/speech/data/FeatureTransforms.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+/**
+ * Computes the power spectrum, MFSC or MFCC features of a padded batch of
+ * waveforms with batched tensor operations, on the device of the input, e.g.
+ * to featurize batches on the GPU instead of each sample on the host.
+ *
+ * The pipeline is the one of `lib::audio::PowerSpectrum`, `lib::audio::Mfsc`
+ * and `lib::audio::Mfcc`: framing, dither, zero-mean frames, pre-emphasis,
+ * windowing, DFT magnitudes, mel filterbank, log, DCT, liftering and
+ * derivatives. The DFT of the frames is a matrix product with precomputed
+ * cosine and sine bases, so every step maps to dense tensor ops. Without
+ * dither, the features match the ones of the host implementation up to
+ * floating point precision; dither noise is drawn from `fl::rand`.
+ *
+ * Example:
+  \code{.cpp}
+  DeviceFeaturizer featurizer(params, FeatureType::MFCC);
+  // waveforms: T x B, each padded to T samples
+  auto feat = featurizer.apply(waveforms);
+  // feat: FEAT x FRAMES x B, with params.numFrames(len) valid frames for a
+  // waveform of len samples
+  \endcode
+ */
+class DeviceFeaturizer {
+ public:
+  /**
+   * Creates a `DeviceFeaturizer`, whose constant bases are created on the
+   * current device.
+   * @param[in] params The feature parameters.
+   * @param[in] featureType The features to compute, which must not be
+   * `FeatureType::NONE`.
+   */
+  DeviceFeaturizer(
+      const lib::audio::FeatureParams& params,
+      FeatureType featureType);
+
+  /**
+   * Computes the features of a batch of waveforms.
+   * @param[in] input The `f32` waveforms (T x B), in [-1, 1).
+   * @return The features (FEAT x FRAMES x B).
+   */
+  Tensor apply(const Tensor& input) const;
+
+  /**
+   * @return The number of features of a frame.
+   */
+  int64_t featureSize() const;
+
+ private:
+  lib::audio::FeatureParams params_;
+  FeatureType featureType_;
+  // N x 1 window
+  Tensor window_;
+  // K x N cosine and sine bases of the DFT of zero-padded frames
+  Tensor dftCos_;
+  Tensor dftSin_;
+  // numFilters x K mel filterbank
+  Tensor filterbank_;
+  // numCeps x numFilters DCT matrix
+  Tensor dct_;
+  // numCeps x 1 liftering coefficients
+  Tensor lifter_;
+
+  Tensor derivatives(const Tensor& feat) const;
+};
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/speech/data/FeatureStore.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+FeatureStore::FeatureStore(const fs::path& path) {
+  std::ifstream indexFile(path / kIndexFile);
+  if (!indexFile) {
+    throw std::invalid_argument(
+        "FeatureStore::FeatureStore - unable to open the index of store " +
+        path.string());
+  }
+  int numChunks = 0;
+  std::string line;
+  while (std::getline(indexFile, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::istringstream ss(line);
+    std::string id;
+    int chunk;
+    int64_t entry;
+    if (!(ss >> id >> chunk >> entry) || chunk < 0 || entry < 0) {
+      throw std::runtime_error(
+          "FeatureStore::FeatureStore - invalid line in index of store " +
+          path.string() + ": " + line);
+    }
+    index_[id] = {chunk, entry};
+    numChunks = std::max(numChunks, chunk + 1);
+  }
+  for (int chunk = 0; chunk < numChunks; ++chunk) {
+    chunks_.push_back(std::make_unique<fl::MmapBlobDataset>(
+        (path / chunkFile(chunk)).string(), fl::MmapAdvice::Random));
+  }
+}
+
+int64_t FeatureStore::size() const {
+  return index_.size();
+}
+
+bool FeatureStore::contains(const std::string& id) const {
+  return index_.find(id) != index_.end();
+}
+
+Tensor FeatureStore::get(const std::string& id) const {
+  auto keyval = index_.find(id);
+  if (keyval == index_.end()) {
+    throw std::out_of_range(
+        "FeatureStore::get - no features for sample " + id);
+  }
+  const auto [chunk, entry] = keyval->second;
+  const auto views = chunks_[chunk]->view(entry);
+  if (views.size() != 1) {
+    throw std::runtime_error(
+        "FeatureStore::get - invalid features for sample " + id);
+  }
+  const auto& view = views[0];
+  if (view.bytes == 0) {
+    return Tensor(view.entry.dims, fl::dtype::f32);
+  }
+  return Tensor::fromBuffer(
+             view.entry.dims,
+             view.entry.type,
+             static_cast<const uint8_t*>(view.data),
+             MemoryLocation::Host)
+      .astype(fl::dtype::f32);
+}
+
+std::string FeatureStore::chunkFile(int chunk) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "chunk-%05d.blob", chunk);
+  return name;
+}
+
+FeatureStoreWriter::FeatureStoreWriter(
+    const fs::path& path,
+    int64_t chunkSize /* = 10000 */)
+    : path_(path), chunkSize_(chunkSize) {
+  if (chunkSize_ <= 0) {
+    throw std::invalid_argument(
+        "FeatureStoreWriter::FeatureStoreWriter - chunkSize must be positive");
+  }
+  fs::create_directories(path_);
+  index_.open(path_ / FeatureStore::kIndexFile, std::ios::trunc);
+  if (!index_) {
+    throw std::runtime_error(
+        "FeatureStoreWriter::FeatureStoreWriter - unable to create store " +
+        path_.string());
+  }
+}
+
+FeatureStoreWriter::~FeatureStoreWriter() {
+  close();
+}
+
+void FeatureStoreWriter::add(const std::string& id, const Tensor& features) {
+  if (!index_.is_open()) {
+    throw std::logic_error("FeatureStoreWriter::add - the store is closed");
+  }
+  if (id.empty() || id.find_first_of(" \t\n") != std::string::npos) {
+    throw std::invalid_argument(
+        "FeatureStoreWriter::add - invalid sample ID '" + id + "'");
+  }
+  if (!chunk_) {
+    chunk_ = std::make_unique<fl::FileBlobDataset>(
+        (path_ / FeatureStore::chunkFile(numChunks_)).string(),
+        /* rw = */ true,
+        /* truncate = */ true);
+    ++numChunks_;
+  }
+  const int64_t entry = chunk_->size();
+  chunk_->add({features.astype(fl::dtype::f16)});
+  index_ << id << " " << numChunks_ - 1 << " " << entry << "\n";
+  if (chunk_->size() >= chunkSize_) {
+    closeChunk();
+  }
+}
+
+void FeatureStoreWriter::close() {
+  if (!index_.is_open()) {
+    return;
+  }
+  closeChunk();
+  index_.close();
+}
+
+void FeatureStoreWriter::closeChunk() {
+  if (chunk_) {
+    chunk_->writeIndex();
+    chunk_.reset();
+  }
+}
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
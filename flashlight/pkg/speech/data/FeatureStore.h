@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/dataset/FileBlobDataset.h"
+#include "flashlight/fl/dataset/MmapBlobDataset.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+/**
+ * A read-only store of the precomputed input features of the samples of list
+ * files, indexed by sample ID, such that the audio of the samples is neither
+ * decoded nor featurized at every epoch. Stores are written by a
+ * `FeatureStoreWriter`, e.g. with the `fl_asr_precompute_features` tool.
+ *
+ * A store is a directory of chunks, which are blob files of the features of
+ * up to a given number of samples in half precision, and of an index of the
+ * chunk of each sample ID. Chunks are memory-mapped, so features are read
+ * from the page cache without read syscalls or intermediate copies.
+ *
+ * The features are the output of the input transform they were computed
+ * with, so a store must only be used with the same feature parameters, and
+ * without augmentation of the raw audio, e.g. sound effects.
+ *
+ * Example:
+  \code{.cpp}
+  auto store = std::make_shared<FeatureStore>("/tmp/features");
+  ListFileDataset ds("train.lst", inputTransform, targetTransform);
+  ds.setFeatureStore(store);
+  auto sample = ds.get(0); // reads the input features from the store
+  \endcode
+ */
+class FeatureStore {
+ public:
+  /**
+   * Opens a feature store.
+   * @param[in] path The directory of the store.
+   */
+  explicit FeatureStore(const fs::path& path);
+
+  /**
+   * @return The number of samples of the store.
+   */
+  int64_t size() const;
+
+  /**
+   * @param[in] id A sample ID.
+   * @return True if the features of the sample are in the store.
+   */
+  bool contains(const std::string& id) const;
+
+  /**
+   * @param[in] id A sample ID, which must be in the store.
+   * @return The `f32` features of the sample.
+   */
+  Tensor get(const std::string& id) const;
+
+  // The index file of a store, whose lines are 'sample_id chunk entry'
+  static constexpr const char* kIndexFile = "index.txt";
+
+  // The blob file of a chunk of a store
+  static std::string chunkFile(int chunk);
+
+ private:
+  std::vector<std::unique_ptr<fl::MmapBlobDataset>> chunks_;
+  // chunk and entry in the chunk of each sample ID
+  std::unordered_map<std::string, std::pair<int, int64_t>> index_;
+};
+
+/**
+ * Writes a `FeatureStore`. The store is complete once the writer is closed.
+ */
+class FeatureStoreWriter {
+ public:
+  /**
+   * Creates a feature store, truncating any existing store in its directory.
+   * @param[in] path The directory of the store, which is created if needed.
+   * @param[in] chunkSize The number of samples of a chunk.
+   */
+  explicit FeatureStoreWriter(const fs::path& path, int64_t chunkSize = 10000);
+
+  ~FeatureStoreWriter();
+
+  /**
+   * Adds the features of a sample to the store, in half precision.
+   * @param[in] id The ID of the sample, without whitespace.
+   * @param[in] features The features of the sample.
+   */
+  void add(const std::string& id, const Tensor& features);
+
+  /**
+   * Writes the index of the last chunk and of the store.
+   */
+  void close();
+
+ private:
+  void closeChunk();
+
+  fs::path path_;
+  int64_t chunkSize_;
+  int numChunks_{0};
+  std::unique_ptr<fl::FileBlobDataset> chunk_;
+  std::ofstream index_;
+};
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
@@ -7,6 +7,8 @@
 
 #include "flashlight/pkg/speech/data/ListFileDataset.h"
 
+#include <utility>
+
 #include "flashlight/lib/text/String.h"
 #include "flashlight/pkg/speech/data/Sound.h"
 
@@ -33,6 +35,12 @@ ListFileDataset::ListFileDataset(
       tgtFeatFunc_(tgtFeatFunc),
       wrdFeatFunc_(wrdFeatFunc),
       numRows_(0) {
+  if (ListFileIndex::isListFileIndex(filename)) {
+    index_ = std::make_shared<ListFileIndex>(filename);
+    numRows_ = index_->size();
+    targetSizesCache_.resize(numRows_, -1);
+    return;
+  }
   std::ifstream inFile(filename);
   if (!inFile) {
     throw std::invalid_argument("Unable to open file -" + filename);
@@ -68,19 +76,28 @@ int64_t ListFileDataset::size() const {
 std::vector<Tensor> ListFileDataset::get(const int64_t idx) const {
   checkIndexBounds(idx);
 
-  auto audio = loadAudio(inputs_[idx]); // channels x time
   Tensor input;
-  if (inFeatFunc_) {
-    input = inFeatFunc_(
-        static_cast<void*>(audio.first.data()), audio.second, fl::dtype::f32);
+  const auto id = sampleId(idx);
+  const auto handle = sampleInput(idx);
+  const auto transcript = sampleTarget(idx);
+  if (featureStore_ && featureStore_->contains(std::string(id))) {
+    input = featureStore_->get(std::string(id));
   } else {
-    input = Tensor::fromBuffer(
-        {audio.second}, audio.first.data(), MemoryLocation::Host);
+    auto audio = loadAudio(std::string(handle)); // channels x time
+    if (inFeatFunc_) {
+      input = inFeatFunc_(
+          static_cast<void*>(audio.first.data()),
+          audio.second,
+          fl::dtype::f32);
+    } else {
+      input = Tensor::fromBuffer(
+          {audio.second}, audio.first.data(), MemoryLocation::Host);
+    }
   }
 
   Tensor target;
   if (tgtFeatFunc_) {
-    std::vector<char> curTarget(targets_[idx].begin(), targets_[idx].end());
+    std::vector<char> curTarget(transcript.begin(), transcript.end());
     target = tgtFeatFunc_(
         static_cast<void*>(curTarget.data()),
         {static_cast<Dim>(curTarget.size())},
@@ -90,7 +107,7 @@ std::vector<Tensor> ListFileDataset::get(const int64_t idx) const {
 
   Tensor words;
   if (wrdFeatFunc_) {
-    std::vector<char> curTarget(targets_[idx].begin(), targets_[idx].end());
+    std::vector<char> curTarget(transcript.begin(), transcript.end());
     words = wrdFeatFunc_(
         static_cast<void*>(curTarget.data()),
         {static_cast<Dim>(curTarget.size())},
@@ -98,15 +115,16 @@ std::vector<Tensor> ListFileDataset::get(const int64_t idx) const {
   }
 
   Tensor sampleIdx = Tensor::fromBuffer(
-      {static_cast<long long>(ids_[idx].length())},
-      const_cast<char*>(ids_[idx].data()), // fix me post C++-17?
+      {static_cast<long long>(id.length())},
+      const_cast<char*>(id.data()), // fix me post C++-17?
       MemoryLocation::Host);
   Tensor samplePath = Tensor::fromBuffer(
-      {static_cast<long long>(inputs_[idx].length())},
-      inputs_[idx].data(),
+      {static_cast<long long>(handle.length())},
+      const_cast<char*>(handle.data()),
       MemoryLocation::Host);
+  float duration = getInputSize(idx);
   Tensor sampleDuration =
-      Tensor::fromBuffer({1}, inputSizes_.data() + idx, MemoryLocation::Host);
+      Tensor::fromBuffer({1}, &duration, MemoryLocation::Host);
   Tensor sampleTargetSize = fl::full({1}, float(target.elements()));
 
   return {
@@ -125,9 +143,26 @@ std::pair<std::vector<float>, Shape> ListFileDataset::loadAudio(
   return {loadSound<float>(handle.c_str()), {info.channels, info.frames}};
 }
 
+std::string_view ListFileDataset::sampleId(int64_t idx) const {
+  return index_ ? index_->id(idx) : std::string_view(ids_[idx]);
+}
+
+std::string_view ListFileDataset::sampleInput(int64_t idx) const {
+  return index_ ? index_->input(idx) : std::string_view(inputs_[idx]);
+}
+
+std::string_view ListFileDataset::sampleTarget(int64_t idx) const {
+  return index_ ? index_->target(idx) : std::string_view(targets_[idx]);
+}
+
+void ListFileDataset::setFeatureStore(
+    std::shared_ptr<const FeatureStore> featureStore) {
+  featureStore_ = std::move(featureStore);
+}
+
 float ListFileDataset::getInputSize(const int64_t idx) const {
   checkIndexBounds(idx);
-  return inputSizes_[idx];
+  return index_ ? index_->inputSize(idx) : inputSizes_[idx];
 }
 
 int64_t ListFileDataset::getTargetSize(const int64_t idx) const {
@@ -138,7 +173,8 @@ int64_t ListFileDataset::getTargetSize(const int64_t idx) const {
   if (!tgtFeatFunc_) {
     return 0;
   }
-  std::vector<char> curTarget(targets_[idx].begin(), targets_[idx].end());
+  const auto transcript = sampleTarget(idx);
+  std::vector<char> curTarget(transcript.begin(), transcript.end());
   auto tgtSize = tgtFeatFunc_(
                      static_cast<void*>(curTarget.data()),
                      {static_cast<long long>(curTarget.size())},
@@ -7,12 +7,16 @@
 
 #pragma once
 
+#include <memory>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 #include "flashlight/fl/flashlight.h"
 
 #include "flashlight/lib/text/dictionary/Dictionary.h"
+#include "flashlight/pkg/speech/data/FeatureStore.h"
+#include "flashlight/pkg/speech/data/ListFileIndex.h"
 
 namespace fl {
 namespace pkg {
@@ -39,6 +43,9 @@ namespace speech {
  *  train004 /tmp/000000000.flac 999.99  quick brown fox jumped
  *
  *
+ * The input file may also be a `ListFileIndex` compiled from such a list, which
+ * is memory-mapped instead of parsed.
+ *
  * Calling `dataset.get(idx)` returns a Tensor vector of size 4 - `input`,
  * `target`, `word_transcription`, `sample_id` in the same order.
  *
@@ -62,8 +69,22 @@ class ListFileDataset : public fl::Dataset {
   virtual std::pair<std::vector<float>, Shape> loadAudio(
       const std::string& handle) const;
 
+  /**
+   * Read the input features of the samples from a store of features
+   * precomputed with `inFeatFunc`, instead of loading and featurizing their
+   * audio. Samples missing from the store fall back to the live path.
+   */
+  void setFeatureStore(std::shared_ptr<const FeatureStore> featureStore);
+
  protected:
+  // the columns of a row, from the parsed list or from the compiled index
+  std::string_view sampleId(int64_t idx) const;
+  std::string_view sampleInput(int64_t idx) const;
+  std::string_view sampleTarget(int64_t idx) const;
+
   DataTransformFunction inFeatFunc_, tgtFeatFunc_, wrdFeatFunc_;
+  std::shared_ptr<const FeatureStore> featureStore_;
+  std::shared_ptr<const ListFileIndex> index_;
   int64_t numRows_;
   std::vector<std::string> ids_;
   std::vector<std::string> inputs_;
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/speech/data/ListFileIndex.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "flashlight/lib/text/String.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'L', 'L', 'S', 'T', 'I', 'X', '1'};
+constexpr int kColumns = 3; // id, input, target
+
+struct Header {
+  char magic[8];
+  uint64_t numRows;
+  uint64_t numStrings;
+  uint64_t poolBytes;
+};
+
+int64_t indexBytes(const Header& header) {
+  return sizeof(Header) + sizeof(uint64_t) * (header.numStrings + 1) +
+      sizeof(uint32_t) * kColumns * header.numRows +
+      sizeof(float) * header.numRows + header.poolBytes;
+}
+
+} // namespace
+
+ListFileIndex::ListFileIndex(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(
+        "ListFileIndex::ListFileIndex - could not open file " + path + ": " +
+        std::strerror(errno));
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error(
+        "ListFileIndex::ListFileIndex - could not stat file " + path);
+  }
+  mappedSize_ = st.st_size;
+  if (mappedSize_ < static_cast<int64_t>(sizeof(Header))) {
+    ::close(fd);
+    throw std::runtime_error(
+        "ListFileIndex::ListFileIndex - truncated index " + path);
+  }
+  // a shared mapping, whose pages are shared by the processes of a node
+  void* data = ::mmap(nullptr, mappedSize_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error(
+        "ListFileIndex::ListFileIndex - could not map file " + path + ": " +
+        std::strerror(errno));
+  }
+  data_ = static_cast<char*>(data);
+  ::madvise(data_, mappedSize_, MADV_RANDOM);
+
+  Header header;
+  std::memcpy(&header, data_, sizeof(Header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      indexBytes(header) != mappedSize_) {
+    ::munmap(data_, mappedSize_);
+    throw std::runtime_error(
+        "ListFileIndex::ListFileIndex - invalid index " + path);
+  }
+  numRows_ = header.numRows;
+  const char* ptr = data_ + sizeof(Header);
+  stringOffsets_ = reinterpret_cast<const uint64_t*>(ptr);
+  ptr += sizeof(uint64_t) * (header.numStrings + 1);
+  rows_ = reinterpret_cast<const uint32_t*>(ptr);
+  ptr += sizeof(uint32_t) * kColumns * header.numRows;
+  sizes_ = reinterpret_cast<const float*>(ptr);
+  ptr += sizeof(float) * header.numRows;
+  pool_ = ptr;
+}
+
+ListFileIndex::~ListFileIndex() {
+  if (data_) {
+    ::munmap(data_, mappedSize_);
+  }
+}
+
+int64_t ListFileIndex::size() const {
+  return numRows_;
+}
+
+std::string_view ListFileIndex::string(uint32_t idx) const {
+  return std::string_view(
+      pool_ + stringOffsets_[idx],
+      stringOffsets_[idx + 1] - stringOffsets_[idx]);
+}
+
+std::string_view ListFileIndex::id(int64_t row) const {
+  return string(rows_[kColumns * row]);
+}
+
+std::string_view ListFileIndex::input(int64_t row) const {
+  return string(rows_[kColumns * row + 1]);
+}
+
+std::string_view ListFileIndex::target(int64_t row) const {
+  return string(rows_[kColumns * row + 2]);
+}
+
+float ListFileIndex::inputSize(int64_t row) const {
+  return sizes_[row];
+}
+
+bool ListFileIndex::isListFileIndex(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  return file.read(magic, sizeof(magic)) &&
+      std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+int64_t ListFileIndex::compile(
+    const std::string& listFile,
+    const std::string& indexFile) {
+  std::ifstream inFile(listFile);
+  if (!inFile) {
+    throw std::invalid_argument(
+        "ListFileIndex::compile - unable to open file " + listFile);
+  }
+  std::unordered_map<std::string, uint32_t> interned;
+  std::vector<uint64_t> stringOffsets = {0};
+  std::string pool;
+  auto intern = [&](std::string&& str) {
+    auto keyval = interned.find(str);
+    if (keyval != interned.end()) {
+      return keyval->second;
+    }
+    if (interned.size() >= std::numeric_limits<uint32_t>::max()) {
+      throw std::runtime_error(
+          "ListFileIndex::compile - too many strings in " + listFile);
+    }
+    const uint32_t idx = interned.size();
+    pool += str;
+    stringOffsets.push_back(pool.size());
+    interned.emplace(std::move(str), idx);
+    return idx;
+  };
+
+  std::vector<uint32_t> rows;
+  std::vector<float> sizes;
+  std::string line;
+  while (std::getline(inFile, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    auto splits = fl::lib::splitOnWhitespace(line, true);
+    if (splits.size() < 3) {
+      throw std::runtime_error(
+          "ListFileIndex::compile - file " + listFile +
+          " has invalid columns in line (expected 3 columns at least): " +
+          line);
+    }
+    rows.push_back(intern(std::move(splits[0])));
+    rows.push_back(intern(std::move(splits[1])));
+    sizes.push_back(std::stof(splits[2]));
+    rows.push_back(intern(fl::lib::join(
+        " ", std::vector<std::string>(splits.begin() + 3, splits.end()))));
+  }
+
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.numRows = sizes.size();
+  header.numStrings = stringOffsets.size() - 1;
+  header.poolBytes = pool.size();
+  std::ofstream out(indexFile, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error(
+        "ListFileIndex::compile - unable to create file " + indexFile);
+  }
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(
+      reinterpret_cast<const char*>(stringOffsets.data()),
+      sizeof(uint64_t) * stringOffsets.size());
+  out.write(
+      reinterpret_cast<const char*>(rows.data()),
+      sizeof(uint32_t) * rows.size());
+  out.write(
+      reinterpret_cast<const char*>(sizes.data()),
+      sizeof(float) * sizes.size());
+  out.write(pool.data(), pool.size());
+  if (!out) {
+    throw std::runtime_error(
+        "ListFileIndex::compile - failed to write file " + indexFile);
+  }
+  return header.numRows;
+}
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
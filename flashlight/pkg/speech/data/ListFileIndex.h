@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+/**
+ * A compiled, binary index of a list file of `ListFileDataset`, which is
+ * memory-mapped instead of parsed, such that a dataset of a list of millions
+ * of samples is constructed in milliseconds, and the pages of the index are
+ * shared by the processes that read it on a node, e.g. the ranks of a
+ * distributed training, instead of being copied into each of them.
+ *
+ * An index is compiled from a list once, with `ListFileIndex::compile`, e.g.
+ * with the `fl_asr_compile_list_file` tool, and a `ListFileDataset` given the
+ * index file instead of the list reads it. Strings, i.e. the IDs, input
+ * handles and transcriptions, are interned, so repeated transcriptions and
+ * inputs are stored once.
+ *
+ * Layout, in native byte order:
+ *  header: magic (8 bytes), rows, strings, pool bytes (uint64 each)
+ *  string offsets: uint64 x (strings + 1), in the pool
+ *  rows: uint32 x 3 x rows, the ID, input and transcription strings of rows
+ *  sizes: float x rows
+ *  pool: the characters of the strings
+ */
+class ListFileIndex {
+ public:
+  /**
+   * Maps a compiled list index.
+   * @param[in] path The index file.
+   */
+  explicit ListFileIndex(const std::string& path);
+  ~ListFileIndex();
+
+  ListFileIndex(const ListFileIndex&) = delete;
+  ListFileIndex& operator=(const ListFileIndex&) = delete;
+
+  /**
+   * @return The number of rows of the list.
+   */
+  int64_t size() const;
+
+  // The columns of a row of the list, whose views are valid for the lifetime
+  // of the index.
+  std::string_view id(int64_t row) const;
+  std::string_view input(int64_t row) const;
+  std::string_view target(int64_t row) const;
+  float inputSize(int64_t row) const;
+
+  /**
+   * @param[in] path A file name.
+   * @return True if the file is a compiled list index, rather than a list.
+   */
+  static bool isListFileIndex(const std::string& path);
+
+  /**
+   * Compiles a list file into an index.
+   * @param[in] listFile The list file, in the format of `ListFileDataset`.
+   * @param[in] indexFile The index file, which is truncated if it exists.
+   * @return The number of rows of the list.
+   */
+  static int64_t compile(
+      const std::string& listFile,
+      const std::string& indexFile);
+
+ private:
+  std::string_view string(uint32_t idx) const;
+
+  char* data_{nullptr};
+  int64_t mappedSize_{0};
+  int64_t numRows_{0};
+  const uint64_t* stringOffsets_{nullptr};
+  const uint32_t* rows_{nullptr};
+  const float* sizes_{nullptr};
+  const char* pool_{nullptr};
+};
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
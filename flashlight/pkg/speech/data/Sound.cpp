@@ -7,8 +7,12 @@
 
 #include "flashlight/pkg/speech/data/Sound.h"
 
+#include <algorithm>
 #include <fstream>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 
 #include <sndfile.h>
@@ -110,7 +114,12 @@ sf_vio_ro_seek(sf_count_t offset, int whence, void* user_data) {
       throw std::invalid_argument("whence is invalid");
   }
   f->seekg(offset, way);
-  return offset;
+  // the new position, or -1 if the seek failed
+  if (!f->good()) {
+    f->clear();
+    return -1;
+  }
+  return f->tellg();
 }
 
 static sf_count_t sf_vio_ro_read(void* ptr, sf_count_t count, void* user_data) {
@@ -187,6 +196,40 @@ static sf_count_t sf_vio_wo_tell(void* user_data) {
 
 } /* extern "C" */
 
+namespace {
+
+SNDFILE* openSoundRead(std::istream& f, SF_INFO& info, const char* caller) {
+  static SF_VIRTUAL_IO vsf = {sf_vio_ro_get_filelen,
+                              sf_vio_ro_seek,
+                              sf_vio_ro_read,
+                              sf_vio_ro_write,
+                              sf_vio_ro_tell};
+  /* mandatory */
+  info.format = 0;
+  SNDFILE* file = sf_open_virtual(&vsf, SFM_READ, &info, &f);
+  if (!file) {
+    throw std::runtime_error(
+        std::string(caller) + ": unknown format or could not open stream");
+  }
+  return file;
+}
+
+template <typename T>
+sf_count_t readFrames(SNDFILE* file, T* data, sf_count_t frames) {
+  if (std::is_same<T, float>::value) {
+    return sf_readf_float(file, reinterpret_cast<float*>(data), frames);
+  } else if (std::is_same<T, double>::value) {
+    return sf_readf_double(file, reinterpret_cast<double*>(data), frames);
+  } else if (std::is_same<T, int>::value) {
+    return sf_readf_int(file, reinterpret_cast<int*>(data), frames);
+  } else if (std::is_same<T, short>::value) {
+    return sf_readf_short(file, reinterpret_cast<short*>(data), frames);
+  }
+  throw std::logic_error("loadSound: called with unsupported T");
+}
+
+} // namespace
+
 SoundInfo loadSoundInfo(const std::string& filename) {
   std::ifstream f(filename);
   if (!f.is_open()) {
@@ -196,23 +239,8 @@ SoundInfo loadSoundInfo(const std::string& filename) {
 }
 
 SoundInfo loadSoundInfo(std::istream& f) {
-  SF_VIRTUAL_IO vsf = {sf_vio_ro_get_filelen,
-                       sf_vio_ro_seek,
-                       sf_vio_ro_read,
-                       sf_vio_ro_write,
-                       sf_vio_ro_tell};
-
-  SNDFILE* file;
   SF_INFO info;
-
-  /* mandatory */
-  info.format = 0;
-
-  if (!(file = sf_open_virtual(&vsf, SFM_READ, &info, &f))) {
-    throw std::runtime_error(
-        "loadSoundInfo: unknown format or could not open stream");
-  }
-
+  SNDFILE* file = openSoundRead(f, info, "loadSoundInfo");
   sf_close(file);
 
   SoundInfo usrinfo;
@@ -233,36 +261,16 @@ std::vector<T> loadSound(const std::string& filename) {
 
 template <typename T>
 std::vector<T> loadSound(std::istream& f) {
-  SF_VIRTUAL_IO vsf = {sf_vio_ro_get_filelen,
-                       sf_vio_ro_seek,
-                       sf_vio_ro_read,
-                       sf_vio_ro_write,
-                       sf_vio_ro_tell};
-  SNDFILE* file;
   SF_INFO info;
-
-  info.format = 0;
-
-  if (!(file = sf_open_virtual(&vsf, SFM_READ, &info, &f))) {
-    throw std::runtime_error(
-        "loadSound: unknown format or could not open stream");
-  }
+  SNDFILE* file = openSoundRead(f, info, "loadSound");
 
   std::vector<T> in(info.frames * info.channels);
   sf_count_t nframe;
-  if (std::is_same<T, float>::value) {
-    nframe =
-        sf_readf_float(file, reinterpret_cast<float*>(in.data()), info.frames);
-  } else if (std::is_same<T, double>::value) {
-    nframe = sf_readf_double(
-        file, reinterpret_cast<double*>(in.data()), info.frames);
-  } else if (std::is_same<T, int>::value) {
-    nframe = sf_readf_int(file, reinterpret_cast<int*>(in.data()), info.frames);
-  } else if (std::is_same<T, short>::value) {
-    nframe =
-        sf_readf_short(file, reinterpret_cast<short*>(in.data()), info.frames);
-  } else {
-    throw std::logic_error("loadSound: called with unsupported T");
+  try {
+    nframe = readFrames(file, in.data(), info.frames);
+  } catch (...) {
+    sf_close(file);
+    throw;
   }
   sf_close(file);
   if (nframe != info.frames) {
@@ -271,6 +279,114 @@ std::vector<T> loadSound(std::istream& f) {
   return in;
 }
 
+template <typename T>
+std::vector<T> loadSound(
+    const std::string& filename,
+    int64_t offsetFrames,
+    int64_t numFrames) {
+  std::ifstream f(filename);
+  if (!f.is_open()) {
+    throw std::runtime_error("could not open file " + filename);
+  }
+  return loadSound<T>(f, offsetFrames, numFrames);
+}
+
+template <typename T>
+std::vector<T>
+loadSound(std::istream& f, int64_t offsetFrames, int64_t numFrames) {
+  SoundReader<T> reader(f);
+  const auto& info = reader.info();
+  if (offsetFrames < 0 || offsetFrames > info.frames) {
+    throw std::out_of_range("loadSound: offsetFrames out of range");
+  }
+  const int64_t available = info.frames - offsetFrames;
+  numFrames = numFrames < 0 ? available : std::min(numFrames, available);
+  reader.seek(offsetFrames);
+  auto in = reader.read(numFrames);
+  if (static_cast<int64_t>(in.size()) != numFrames * info.channels) {
+    throw std::runtime_error("loadSound: read error");
+  }
+  return in;
+}
+
+template <typename T>
+SoundReader<T>::SoundReader(const std::string& filename)
+    : ownedStream_(std::make_unique<std::ifstream>(filename)) {
+  if (!ownedStream_->is_open()) {
+    throw std::runtime_error("could not open file " + filename);
+  }
+  open(*ownedStream_);
+}
+
+template <typename T>
+SoundReader<T>::SoundReader(std::istream& f) {
+  open(f);
+}
+
+template <typename T>
+void SoundReader<T>::open(std::istream& f) {
+  SF_INFO info;
+  file_ = openSoundRead(f, info, "SoundReader");
+  info_.frames = info.frames;
+  info_.samplerate = info.samplerate;
+  info_.channels = info.channels;
+}
+
+template <typename T>
+SoundReader<T>::~SoundReader() {
+  sf_close(file_);
+}
+
+template <typename T>
+const SoundInfo& SoundReader<T>::info() const {
+  return info_;
+}
+
+template <typename T>
+int64_t SoundReader<T>::position() const {
+  return position_;
+}
+
+template <typename T>
+void SoundReader<T>::seek(int64_t frame) {
+  if (frame < 0 || frame > info_.frames) {
+    throw std::out_of_range("SoundReader::seek - frame out of range");
+  }
+  if (sf_seek(file_, frame, SEEK_SET) != frame) {
+    throw std::runtime_error(
+        "SoundReader::seek - the stream is not seekable: " +
+        std::string(sf_strerror(file_)));
+  }
+  position_ = frame;
+}
+
+template <typename T>
+bool SoundReader<T>::read(int64_t numFrames, std::vector<T>& chunk) {
+  if (numFrames < 0) {
+    throw std::invalid_argument("SoundReader::read - negative numFrames");
+  }
+  numFrames = std::min(numFrames, info_.frames - position_);
+  chunk.resize(numFrames * info_.channels);
+  if (numFrames == 0) {
+    return false;
+  }
+  const auto nframe = readFrames(file_, chunk.data(), numFrames);
+  if (nframe <= 0) {
+    chunk.clear();
+    return false;
+  }
+  chunk.resize(nframe * info_.channels);
+  position_ += nframe;
+  return true;
+}
+
+template <typename T>
+std::vector<T> SoundReader<T>::read(int64_t numFrames) {
+  std::vector<T> chunk;
+  read(numFrames, chunk);
+  return chunk;
+}
+
 template <typename T>
 void saveSound(
     const std::string& filename,
@@ -373,6 +489,21 @@ template std::vector<double> loadSound<double>(std::istream&);
 template std::vector<int> loadSound<int>(std::istream&);
 template std::vector<short> loadSound<short>(std::istream&);
 
+template std::vector<float> loadSound(const std::string&, int64_t, int64_t);
+template std::vector<double> loadSound(const std::string&, int64_t, int64_t);
+template std::vector<int> loadSound(const std::string&, int64_t, int64_t);
+template std::vector<short> loadSound(const std::string&, int64_t, int64_t);
+
+template std::vector<float> loadSound<float>(std::istream&, int64_t, int64_t);
+template std::vector<double> loadSound<double>(std::istream&, int64_t, int64_t);
+template std::vector<int> loadSound<int>(std::istream&, int64_t, int64_t);
+template std::vector<short> loadSound<short>(std::istream&, int64_t, int64_t);
+
+template class SoundReader<float>;
+template class SoundReader<double>;
+template class SoundReader<int>;
+template class SoundReader<short>;
+
 template void saveSound(
     const std::string&,
     const std::vector<float>&,
@@ -8,9 +8,15 @@
 #pragma once
 
 #include <cstdint>
+#include <fstream>
 #include <istream>
+#include <memory>
+#include <string>
 #include <vector>
 
+// libsndfile handle, see sndfile.h
+struct SNDFILE_tag;
+
 namespace fl {
 namespace pkg {
 namespace speech {
@@ -83,6 +89,65 @@ std::vector<T> loadSound(std::istream& f);
 template <typename T>
 std::vector<T> loadSound(const std::string& filename);
 
+// Decodes only numFrames frames from offsetFrames, seeking in the stream
+// instead of decoding the frames before it. Reads to the end of the stream if
+// numFrames is negative or exceeds the remaining frames.
+template <typename T>
+std::vector<T>
+loadSound(std::istream& f, int64_t offsetFrames, int64_t numFrames);
+template <typename T>
+std::vector<T> loadSound(
+    const std::string& filename,
+    int64_t offsetFrames,
+    int64_t numFrames);
+
+/**
+ * Decodes a sound incrementally, e.g. to stream long recordings in chunks of
+ * fixed size with bounded memory. Chunks hold the samples of the channels of
+ * each frame interleaved, as `loadSound`.
+ *
+ * Example:
+  \code{.cpp}
+  SoundReader<float> reader("recording.flac");
+  std::vector<float> chunk;
+  while (reader.read(16000, chunk)) {
+    // process chunk, of up to 16000 frames
+  }
+  \endcode
+ */
+template <typename T>
+class SoundReader {
+ public:
+  explicit SoundReader(const std::string& filename);
+  // the stream must outlive the reader
+  explicit SoundReader(std::istream& f);
+  ~SoundReader();
+
+  SoundReader(const SoundReader&) = delete;
+  SoundReader& operator=(const SoundReader&) = delete;
+
+  const SoundInfo& info() const;
+
+  // The index of the next frame to read
+  int64_t position() const;
+
+  // Moves to a frame, which needs a seekable stream
+  void seek(int64_t frame);
+
+  // Reads the next frames, up to numFrames, into chunk, reusing its memory.
+  // Returns false, with an empty chunk, at the end of the stream.
+  bool read(int64_t numFrames, std::vector<T>& chunk);
+  std::vector<T> read(int64_t numFrames);
+
+ private:
+  void open(std::istream& f);
+
+  std::unique_ptr<std::ifstream> ownedStream_;
+  SNDFILE_tag* file_{nullptr};
+  SoundInfo info_;
+  int64_t position_{0};
+};
+
 template <typename T>
 void saveSound(
     std::ostream& f,
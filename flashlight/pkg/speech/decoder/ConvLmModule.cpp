@@ -7,8 +7,16 @@
 
 #include "flashlight/pkg/speech/decoder/ConvLmModule.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
 #include <string>
+#include <typeinfo>
 
+#include "flashlight/fl/distributed/LRUCache.h"
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 #include "flashlight/pkg/runtime/common/DistributedUtils.h"
@@ -17,53 +25,330 @@ namespace fl {
 namespace pkg {
 namespace speech {
 
-GetConvLmScoreFunc buildGetConvLmScoreFunction(
-    std::shared_ptr<Module> network) {
-  auto getConvLmScoreFunc = [network](
-                                const std::vector<int>& inputs,
-                                const std::vector<int>& lastTokenPositions,
-                                int sampleSize = -1,
-                                int batchSize = 1) {
+namespace {
+
+// the scores of the tokens following the last tokens of a batch of sequences
+std::vector<float> forwardBatch(
+    Module& network,
+    const std::vector<int>& inputs,
+    const std::vector<int>& lastTokenPositions,
+    int sampleSize,
+    int batchSize) {
+  Tensor inputData = Tensor::fromVector({sampleSize, batchSize}, inputs);
+  fl::Variable output = network.forward({fl::input(inputData)})[0];
+
+  if (fl::countNonzero(fl::isnan(output.tensor())).asScalar<int>() != 0) {
+    throw std::runtime_error("[ConvLM] Encountered NaNs in propagation");
+  }
+  int32_t C = output.dim(0), T = output.dim(1), B = output.dim(2);
+  if (B != batchSize) {
+    throw std::logic_error(
+        "[ConvLM]: incorrect predictions: batch should be " +
+        std::to_string(batchSize) + " but it is " + std::to_string(B));
+  }
+  // output (c, t, b)
+  // set global indices: offset by channel
+  Tensor globalIndices = fl::iota({C, 1}, {1, B}, fl::dtype::s32);
+  // set global indices: offset by batch
+  globalIndices =
+      globalIndices + fl::iota({1, B}, {C, 1}, fl::dtype::s32) * T * C;
+  // set global indices: offset by time which we need to take
+  globalIndices = globalIndices +
+      fl::tile(Tensor::fromVector({1, B}, lastTokenPositions), {C, 1}) * C;
+  Tensor preds =
+      fl::reshape(output.tensor().flatten()(globalIndices.flatten()), {C, B});
+  // vector of B X C predictions
+  return preds.toHostVector<float>();
+}
+
+// a causal LM scores the prefix up to the last token, whatever follows it
+std::string prefixKey(const int* tokens, int lastTokenPosition) {
+  return std::string(
+      reinterpret_cast<const char*>(tokens),
+      sizeof(int) * (lastTokenPosition + 1));
+}
+
+// the sequences of tokens calibrating a quantized ConvLM, one per sample
+class TokenSequenceDataset : public Dataset {
+ public:
+  explicit TokenSequenceDataset(const std::vector<std::vector<int>>& sequences)
+      : sequences_(sequences) {}
+
+  int64_t size() const override {
+    return sequences_.size();
+  }
+
+  std::vector<Tensor> get(const int64_t idx) const override {
+    const auto& sequence = sequences_.at(idx);
+    const long long length = sequence.size();
+    return {Tensor::fromVector({length, 1}, sequence)};
+  }
+
+ private:
+  const std::vector<std::vector<int>>& sequences_;
+};
+
+void quantizeContainer(Container& container);
+
+// Returns the quantized module which replaces a module, or the module itself
+ModulePtr quantizeModule(const ModulePtr& module) {
+  // the types are matched exactly, as derived modules compute differently
+  const auto& type = typeid(*module);
+  if (type == typeid(Linear)) {
+    return std::make_shared<QuantizedLinear>(static_cast<Linear&>(*module));
+  }
+  if (type == typeid(Conv2D)) {
+    return std::make_shared<QuantizedConv2D>(static_cast<Conv2D&>(*module));
+  }
+  if (type == typeid(AsymmetricConv1D)) {
+    return std::make_shared<QuantizedAsymmetricConv1D>(
+        static_cast<AsymmetricConv1D&>(*module));
+  }
+  if (type == typeid(AdaptiveSoftMax)) {
+    return std::make_shared<QuantizedAdaptiveSoftMax>(
+        static_cast<AdaptiveSoftMax&>(*module));
+  }
+  if (auto* container = dynamic_cast<Container*>(module.get())) {
+    quantizeContainer(*container);
+  }
+  return module;
+}
+
+void quantizeContainer(Container& container) {
+  std::vector<ModulePtr> modules;
+  for (const auto& child : container.modules()) {
+    modules.push_back(quantizeModule(child));
+  }
+  // also refreshes the parameters of the container from its modules
+  container.setModules(modules);
+}
+
+class ConvLmScorer {
+ public:
+  ConvLmScorer(std::shared_ptr<Module> network, ConvLmScoreOptions options)
+      : network_(std::move(network)),
+        options_(options),
+        device_(fl::getDevice()),
+        cache_(std::max(options.cacheSize, 1)) {}
+
+  std::vector<float> score(
+      const std::vector<int>& inputs,
+      const std::vector<int>& lastTokenPositions,
+      int sampleSize,
+      int batchSize) {
     sampleSize = sampleSize > 0 ? sampleSize : inputs.size();
     if (sampleSize * batchSize > inputs.size()) {
       throw std::invalid_argument(
           "[ConvLM] Incorrect sample size (" + std::to_string(sampleSize) +
           ") or batch size (" + std::to_string(batchSize) + ").");
     }
-    Tensor inputData = Tensor::fromVector({sampleSize, batchSize}, inputs);
-    fl::Variable output = network->forward({fl::input(inputData)})[0];
-
-    if (fl::countNonzero(fl::isnan(output.tensor())).asScalar<int>() != 0) {
-      throw std::runtime_error("[ConvLM] Encountered NaNs in propagation");
-    }
-    int32_t C = output.dim(0), T = output.dim(1), B = output.dim(2);
-    if (B != batchSize) {
-      throw std::logic_error(
-          "[ConvLM]: incorrect predictions: batch should be " +
-          std::to_string(batchSize) + " but it is " + std::to_string(B));
-    }
     if (batchSize != (int)lastTokenPositions.size()) {
       throw std::logic_error(
           "[ConvLM]: incorrect postions for accessing: size should be " +
           std::to_string(batchSize) + " but it is " +
           std::to_string(lastTokenPositions.size()));
     }
-    // output (c, t, b)
-    // set global indices: offset by channel
-    Tensor globalIndices = fl::iota({C, 1}, {1, B}, fl::dtype::s32);
-    // set global indices: offset by batch
-    globalIndices =
-        globalIndices + fl::iota({1, B}, {C, 1}, fl::dtype::s32) * T * C;
-    // set global indices: offset by time which we need to take
-    globalIndices = globalIndices +
-        fl::tile(Tensor::fromVector({1, B}, lastTokenPositions), {C, 1}) * C;
-    Tensor preds =
-        fl::reshape(output.tensor().flatten()(globalIndices.flatten()), {C, B});
+
+    // the sequences whose prefixes aren't cached are forwarded
+    std::vector<std::vector<float>> rowScores(batchSize);
+    Query query;
+    query.sampleSize = sampleSize;
+    std::vector<int> missing;
+    for (int b = 0; b < batchSize; ++b) {
+      const int* tokens = inputs.data() + b * sampleSize;
+      if (options_.cacheSize > 0) {
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        if (auto* cached =
+                cache_.get(prefixKey(tokens, lastTokenPositions[b]))) {
+          rowScores[b] = *cached;
+          continue;
+        }
+      }
+      missing.push_back(b);
+      query.tokens.insert(query.tokens.end(), tokens, tokens + sampleSize);
+      query.positions.push_back(lastTokenPositions[b]);
+    }
+
+    if (!missing.empty()) {
+      auto scores = forwardBatched(query);
+      const size_t C = scores.size() / missing.size();
+      for (size_t i = 0; i < missing.size(); ++i) {
+        const int b = missing[i];
+        rowScores[b].assign(
+            scores.begin() + i * C, scores.begin() + (i + 1) * C);
+        if (options_.cacheSize > 0) {
+          std::lock_guard<std::mutex> lock(cacheMutex_);
+          cache_.put(
+              prefixKey(
+                  inputs.data() + b * sampleSize, lastTokenPositions[b]),
+              std::make_unique<std::vector<float>>(rowScores[b]));
+        }
+      }
+    }
+
     // vector of B X C predictions
-    return preds.toHostVector<float>();
+    std::vector<float> preds;
+    preds.reserve(batchSize * rowScores.front().size());
+    for (const auto& scores : rowScores) {
+      preds.insert(preds.end(), scores.begin(), scores.end());
+    }
+    return preds;
+  }
+
+ private:
+  // the sequences of a call, of sampleSize tokens each
+  struct Query {
+    std::vector<int> tokens;
+    std::vector<int> positions;
+    int sampleSize;
+    std::vector<float> scores;
+    std::exception_ptr error;
+    bool taken{false};
+    bool done{false};
+
+    int rows() const {
+      return positions.size();
+    }
+  };
+
+  std::shared_ptr<Module> network_;
+  ConvLmScoreOptions options_;
+  int device_;
+
+  std::mutex cacheMutex_;
+  fl::detail::LRUCache<std::string, std::vector<float>> cache_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Query*> queue_;
+  int queuedRows_{0};
+  bool forwarding_{false};
+
+  bool isFull() const {
+    return options_.maxBatchSize > 0 && queuedRows_ >= options_.maxBatchSize;
+  }
+
+  // The query waits for others until the batch is full or its time is up,
+  // and then forwards the queries at the front of the queue, unless another
+  // call does
+  std::vector<float> forwardBatched(Query& query) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.push_back(&query);
+    queuedRows_ += query.rows();
+    condition_.notify_all();
+    const auto deadline = std::chrono::steady_clock::now() +
+        std::chrono::microseconds(options_.maxWaitUs);
+    while (!query.done) {
+      if (query.taken || forwarding_) {
+        condition_.wait(lock, [&query, this]() {
+          return query.done || (!query.taken && !forwarding_);
+        });
+        continue;
+      }
+      if (!isFull() && std::chrono::steady_clock::now() < deadline) {
+        condition_.wait_until(lock, deadline, [&query, this]() {
+          return query.taken || forwarding_ || isFull();
+        });
+        continue;
+      }
+      forwardQueue(lock);
+    }
+    if (query.error) {
+      std::rethrow_exception(query.error);
+    }
+    return std::move(query.scores);
+  }
+
+  void forwardQueue(std::unique_lock<std::mutex>& lock) {
+    std::vector<Query*> batch;
+    int rows = 0, sampleSize = 0;
+    while (!queue_.empty() &&
+           (batch.empty() || options_.maxBatchSize <= 0 ||
+            rows + queue_.front()->rows() <= options_.maxBatchSize)) {
+      auto* query = queue_.front();
+      queue_.pop_front();
+      query->taken = true;
+      rows += query->rows();
+      sampleSize = std::max(sampleSize, query->sampleSize);
+      batch.push_back(query);
+    }
+    queuedRows_ -= rows;
+    forwarding_ = true;
+    lock.unlock();
+
+    // the sequences are padded to the longest, after their last tokens
+    std::vector<int> inputs(static_cast<size_t>(rows) * sampleSize, 0);
+    std::vector<int> positions;
+    int row = 0;
+    for (const auto* query : batch) {
+      for (int r = 0; r < query->rows(); ++r, ++row) {
+        std::copy_n(
+            query->tokens.begin() + r * query->sampleSize,
+            query->sampleSize,
+            inputs.begin() + row * sampleSize);
+      }
+      positions.insert(
+          positions.end(), query->positions.begin(), query->positions.end());
+    }
+    std::vector<float> scores;
+    std::exception_ptr error;
+    try {
+      const int device = fl::getDevice();
+      fl::setDevice(device_);
+      scores = forwardBatch(*network_, inputs, positions, sampleSize, rows);
+      fl::setDevice(device);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    lock.lock();
+    const size_t C = error ? 0 : scores.size() / rows;
+    size_t offset = 0;
+    for (auto* query : batch) {
+      const size_t size = query->rows() * C;
+      if (!error) {
+        query->scores.assign(
+            scores.begin() + offset, scores.begin() + offset + size);
+      }
+      offset += size;
+      query->error = error;
+      query->done = true;
+    }
+    forwarding_ = false;
+    condition_.notify_all();
+  }
+};
+
+} // namespace
+
+GetConvLmScoreFunc buildGetConvLmScoreFunction(
+    std::shared_ptr<Module> network,
+    const ConvLmScoreOptions& options /* = {} */) {
+  auto scorer = std::make_shared<ConvLmScorer>(std::move(network), options);
+  return [scorer](
+             const std::vector<int>& inputs,
+             const std::vector<int>& lastTokenPositions,
+             int sampleSize = -1,
+             int batchSize = 1) {
+    return scorer->score(inputs, lastTokenPositions, sampleSize, batchSize);
   };
+}
 
-  return getConvLmScoreFunc;
+void quantizeConvLm(
+    Module& network,
+    const std::vector<std::vector<int>>& calibrationSequences) {
+  auto* container = dynamic_cast<Container*>(&network);
+  if (!container) {
+    throw std::invalid_argument(
+        "quantizeConvLm - the network must be a container of modules");
+  }
+  if (calibrationSequences.empty()) {
+    throw std::invalid_argument(
+        "quantizeConvLm - no sequences to calibrate the network on");
+  }
+  optimizeForInference(network);
+  quantizeContainer(*container);
+  calibrateQuantization(network, TokenSequenceDataset(calibrationSequences));
 }
 } // namespace speech
 } // namespace pkg
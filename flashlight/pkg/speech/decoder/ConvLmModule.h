@@ -17,7 +17,48 @@ namespace speech {
 using GetConvLmScoreFunc = std::function<std::vector<
     float>(const std::vector<int>&, const std::vector<int>&, int, int)>;
 
-GetConvLmScoreFunc buildGetConvLmScoreFunction(std::shared_ptr<Module> network);
+struct ConvLmScoreOptions {
+  // the number of token prefixes whose scores are cached, 0 for no cache
+  int cacheSize{0};
+  // the largest number of sequences of a batched forward, 0 for no limit
+  int maxBatchSize{0};
+  // the time a query waits for others to be batched with, in microseconds
+  int maxWaitUs{0};
+};
+
+/**
+ * Builds the scoring function of a ConvLM, which returns the B x C scores of
+ * the tokens following the last token of B sequences.
+ *
+ * The LM being causal, the scores only depend on the prefix of a sequence up
+ * to its last token, which keys the scores in an LRU cache when `cacheSize` is
+ * positive. The prefixes which aren't cached are forwarded in a batch with
+ * those of the concurrent calls to the function, e.g. by several decoder
+ * threads, which wait up to `maxWaitUs` to be batched. The network runs on
+ * the device which is current when the function is built.
+ */
+GetConvLmScoreFunc buildGetConvLmScoreFunction(
+    std::shared_ptr<Module> network,
+    const ConvLmScoreOptions& options = {});
+
+/**
+ * Quantizes a ConvLM to int8 in place, for decoding on CPU (see
+ * `fl::QuantizedModule`). The network is first optimized for inference, which
+ * folds its `WeightNorm`s, then its `Linear`, `Conv2D` and `AsymmetricConv1D`
+ * modules and its `AdaptiveSoftMax` head, if any, are replaced by quantized
+ * ones, including those nested in containers, e.g. residual blocks, and the
+ * embedding is kept in float32. The input scales are calibrated on sequences
+ * of tokens representative of the decoded text.
+ *
+ * The quantized network is serialized and scored as the original one, by
+ * `buildGetConvLmScoreFunction`.
+ *
+ * @param network the ConvLM, a container taking T x B tokens
+ * @param calibrationSequences sequences of token indices of the LM
+ */
+void quantizeConvLm(
+    Module& network,
+    const std::vector<std::vector<int>>& calibrationSequences);
 } // namespace speech
 } // namespace pkg
 } // namespace fl
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/speech/decoder/EmissionStore.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "flashlight/fl/common/Logging.h"
+#include "flashlight/fl/runtime/Stream.h"
+#include "flashlight/fl/tensor/Compute.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'L', 'E', 'M', 'I', 'X', '0', '1'};
+constexpr const char* kShardPrefix = "emissions.";
+constexpr const char* kIndexExt = ".idx";
+constexpr const char* kDataExt = ".bin";
+
+struct Header {
+  char magic[8];
+  uint32_t fp16;
+  uint32_t padding;
+};
+
+struct Record {
+  uint64_t offset;
+  int32_t nFrames;
+  int32_t nTokens;
+  int32_t idBytes;
+};
+
+fs::path shardPath(const fs::path& dir, int shard, const char* ext) {
+  return dir / (kShardPrefix + std::to_string(shard) + ext);
+}
+
+bool isIndexFile(const fs::path& path) {
+  const auto name = path.filename().string();
+  return path.extension() == kIndexExt &&
+      name.compare(0, std::strlen(kShardPrefix), kShardPrefix) == 0;
+}
+
+// IEEE 754 half to float, for the values of fp16 shards, which are read on
+// the host
+float halfToFloat(const uint16_t half) {
+  const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0x1f) {
+    // inf or nan
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else if (exponent == 0) {
+    if (mantissa == 0) {
+      bits = sign;
+    } else {
+      // subnormal, normalized as a float
+      exponent = 127 - 15 + 1;
+      while ((mantissa & 0x400) == 0) {
+        mantissa <<= 1;
+        --exponent;
+      }
+      bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+  } else {
+    bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  }
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+} // namespace
+
+EmissionStoreWriter::EmissionStoreWriter(
+    const fs::path& dir,
+    const int shard,
+    const bool fp16 /* = false */,
+    const size_t maxPending /* = 8 */)
+    : name_(shardPath(dir, shard, kIndexExt).string()),
+      fp16_(fp16),
+      maxPending_(std::max<size_t>(maxPending, 1)) {
+  const auto dataPath = shardPath(dir, shard, kDataExt);
+  data_.open(dataPath, std::ios::binary | std::ios::trunc);
+  index_.open(name_, std::ios::binary | std::ios::trunc);
+  if (!data_ || !index_) {
+    throw std::runtime_error(
+        "EmissionStoreWriter::EmissionStoreWriter - unable to create shard " +
+        name_);
+  }
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.fp16 = fp16 ? 1 : 0;
+  header.padding = 0;
+  index_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+EmissionStoreWriter::~EmissionStoreWriter() {
+  try {
+    flush();
+  } catch (const std::exception& ex) {
+    FL_LOG(fl::LogLevel::ERROR)
+        << "Error while writing emissions to " << name_ << ": " << ex.what();
+  }
+  for (auto& pending : pending_) {
+    pending.copied->sync();
+    fl::freePinnedHost(pending.host);
+  }
+}
+
+void EmissionStoreWriter::add(
+    const std::string& sampleId,
+    const Tensor& emission) {
+  const Dim nTokens = emission.ndim() > 0 ? emission.dim(0) : 1;
+  const Dim nFrames = emission.ndim() > 1 ? emission.dim(1) : 1;
+  if (emission.elements() != nTokens * nFrames) {
+    throw std::invalid_argument(
+        "EmissionStoreWriter::add - expected an emission of shape "
+        "[nTokens, nFrames], got " +
+        emission.shape().toString());
+  }
+  if (pending_.size() >= maxPending_) {
+    writeFront();
+  }
+  auto values = emission.astype(fp16_ ? fl::dtype::f16 : fl::dtype::f32);
+  if (!values.isContiguous()) {
+    values = values.asContiguousTensor();
+  }
+  Pending pending;
+  pending.sampleId = sampleId;
+  pending.nFrames = nFrames;
+  pending.nTokens = nTokens;
+  pending.bytes = values.bytes();
+  pending.host = fl::allocPinnedHost(pending.bytes);
+  const auto& stream = values.stream();
+  stream.copyAsync(pending.host, values.device<void>(), pending.bytes);
+  values.unlock();
+  pending.copied = stream.recordEvent();
+  pending.values = std::move(values);
+  pending_.push_back(std::move(pending));
+}
+
+void EmissionStoreWriter::flush() {
+  while (!pending_.empty()) {
+    writeFront();
+  }
+  data_.flush();
+  index_.flush();
+}
+
+void EmissionStoreWriter::writeFront() {
+  auto& pending = pending_.front();
+  pending.copied->sync();
+  Record record;
+  record.offset = offset_;
+  record.nFrames = pending.nFrames;
+  record.nTokens = pending.nTokens;
+  record.idBytes = pending.sampleId.size();
+  data_.write(static_cast<const char*>(pending.host), pending.bytes);
+  index_.write(reinterpret_cast<const char*>(&record), sizeof(record));
+  index_.write(pending.sampleId.data(), pending.sampleId.size());
+  fl::freePinnedHost(pending.host);
+  offset_ += pending.bytes;
+  pending_.pop_front();
+  if (!data_ || !index_) {
+    throw std::runtime_error(
+        "EmissionStoreWriter::writeFront - failed to write shard " + name_);
+  }
+}
+
+EmissionStore::EmissionStore(const fs::path& dir) {
+  if (!fs::is_directory(dir)) {
+    throw std::invalid_argument(
+        "EmissionStore::EmissionStore - no directory " + dir.string());
+  }
+  std::vector<fs::path> indexPaths;
+  for (const auto& file : fs::directory_iterator(dir)) {
+    if (isIndexFile(file.path())) {
+      indexPaths.push_back(file.path());
+    }
+  }
+  try {
+    for (const auto& indexPath : indexPaths) {
+      auto dataPath = indexPath;
+      loadShard(indexPath, dataPath.replace_extension(kDataExt));
+    }
+  } catch (...) {
+    for (auto& shard : shards_) {
+      if (shard.data) {
+        ::munmap(shard.data, shard.size);
+      }
+    }
+    throw;
+  }
+}
+
+EmissionStore::~EmissionStore() {
+  for (auto& shard : shards_) {
+    if (shard.data) {
+      ::munmap(shard.data, shard.size);
+    }
+  }
+}
+
+void EmissionStore::loadShard(
+    const fs::path& indexPath,
+    const fs::path& dataPath) {
+  std::ifstream index(indexPath, std::ios::binary);
+  Header header;
+  if (!index.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error(
+        "EmissionStore::loadShard - invalid index " + indexPath.string());
+  }
+
+  Shard shard;
+  shard.fp16 = header.fp16 != 0;
+  const int fd = ::open(dataPath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(
+        "EmissionStore::loadShard - could not open file " + dataPath.string() +
+        ": " + std::strerror(errno));
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error(
+        "EmissionStore::loadShard - could not stat file " + dataPath.string());
+  }
+  shard.size = st.st_size;
+  if (shard.size > 0) {
+    void* data = ::mmap(nullptr, shard.size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error(
+          "EmissionStore::loadShard - could not map file " +
+          dataPath.string() + ": " + std::strerror(errno));
+    }
+    shard.data = static_cast<char*>(data);
+    ::madvise(shard.data, shard.size, MADV_RANDOM);
+  }
+  ::close(fd);
+  shards_.push_back(shard);
+
+  const int shardIdx = shards_.size() - 1;
+  const size_t valueBytes = shard.fp16 ? sizeof(uint16_t) : sizeof(float);
+  Record record;
+  std::string sampleId;
+  // a record cut by an unfinished writer is ignored
+  while (index.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+    sampleId.resize(record.idBytes);
+    if (!index.read(&sampleId[0], record.idBytes)) {
+      break;
+    }
+    const uint64_t bytes =
+        static_cast<uint64_t>(record.nFrames) * record.nTokens * valueBytes;
+    if (record.offset + bytes > static_cast<uint64_t>(shard.size)) {
+      throw std::runtime_error(
+          "EmissionStore::loadShard - truncated shard " + dataPath.string());
+    }
+    entries_[sampleId] =
+        Entry{shardIdx, record.offset, record.nFrames, record.nTokens};
+  }
+}
+
+int64_t EmissionStore::size() const {
+  return entries_.size();
+}
+
+bool EmissionStore::contains(const std::string& sampleId) const {
+  return entries_.find(sampleId) != entries_.end();
+}
+
+EmissionUnit EmissionStore::get(const std::string& sampleId) const {
+  auto entry = entries_.find(sampleId);
+  if (entry == entries_.end()) {
+    throw std::out_of_range(
+        "EmissionStore::get - no emission for sample " + sampleId);
+  }
+  const auto& loc = entry->second;
+  const auto& shard = shards_[loc.shard];
+  const size_t numValues = static_cast<size_t>(loc.nFrames) * loc.nTokens;
+  std::vector<float> emission(numValues);
+  const char* src = shard.data + loc.offset;
+  if (shard.fp16) {
+    for (size_t i = 0; i < numValues; ++i) {
+      uint16_t half;
+      std::memcpy(&half, src + i * sizeof(half), sizeof(half));
+      emission[i] = halfToFloat(half);
+    }
+  } else if (numValues > 0) {
+    std::memcpy(emission.data(), src, numValues * sizeof(float));
+  }
+  return EmissionUnit(emission, sampleId, loc.nFrames, loc.nTokens);
+}
+
+bool EmissionStore::isEmissionStore(const fs::path& dir) {
+  if (!fs::is_directory(dir)) {
+    return false;
+  }
+  for (const auto& file : fs::directory_iterator(dir)) {
+    if (isIndexFile(file.path())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/runtime/Event.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/pkg/speech/decoder/Defines.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+/**
+ * Writes the emissions of a test set into one shard of an emission store,
+ * which holds all emissions in a few large files instead of a file per
+ * utterance, for `EmissionStore` to read. Unlike a `FeatureStoreWriter`, whose
+ * blobs copy each array to the host when it is added, it doesn't synchronize
+ * with the device per emission.
+ *
+ * The emissions are copied from the device into pinned host buffers
+ * asynchronously, on the streams of their tensors. Up to `maxPending` copies
+ * are in flight; they are appended to the shard in the order of `add`, once
+ * complete, so the thread computing emissions doesn't wait for each copy.
+ *
+ * Layout of the shard `i` of a store in its directory, in native byte order:
+ *  emissions.i.bin: the values of the emissions, one after another, each
+ *    column-major of shape [nTokens, nFrames], as float or half
+ *  emissions.i.idx: header: magic (8 bytes), fp16 (uint32), padding (uint32)
+ *    records: offset in the values (uint64), nFrames, nTokens, sample ID bytes
+ *    (int32 each), the characters of the sample ID
+ *
+ * The values of an emission are written before its record, so the records of
+ * a shard whose writer didn't finish refer to complete values.
+ */
+class EmissionStoreWriter {
+ public:
+  /**
+   * Creates a shard of a store, replacing an existing shard with its number.
+   * @param[in] dir The directory of the store.
+   * @param[in] shard The number of the shard, e.g. of the writing thread.
+   * @param[in] fp16 Whether to store the values as half, which halves the
+   * size of the store and of the copies from the device.
+   * @param[in] maxPending The maximum number of copies in flight.
+   */
+  EmissionStoreWriter(
+      const fs::path& dir,
+      int shard,
+      bool fp16 = false,
+      size_t maxPending = 8);
+
+  /** Writes the pending emissions, logging errors, if any. */
+  ~EmissionStoreWriter();
+
+  EmissionStoreWriter(const EmissionStoreWriter&) = delete;
+  EmissionStoreWriter& operator=(const EmissionStoreWriter&) = delete;
+
+  /**
+   * Starts the copy of an emission to the host, after which it is appended.
+   * @param[in] sampleId The ID of the utterance.
+   * @param[in] emission The emission, of shape [nTokens, nFrames], with
+   * optional trailing singleton dimensions.
+   */
+  void add(const std::string& sampleId, const Tensor& emission);
+
+  /**
+   * Waits for the copies in flight, and appends their emissions.
+   */
+  void flush();
+
+ private:
+  struct Pending {
+    std::string sampleId;
+    // the copied tensor, kept until its copy is complete
+    Tensor values;
+    void* host;
+    size_t bytes;
+    int nFrames;
+    int nTokens;
+    std::unique_ptr<Event> copied;
+  };
+
+  void writeFront();
+
+  std::string name_;
+  bool fp16_;
+  size_t maxPending_;
+  std::ofstream data_;
+  std::ofstream index_;
+  uint64_t offset_{0};
+  std::deque<Pending> pending_;
+};
+
+/**
+ * A read-only emission store written by `EmissionStoreWriter`s. The values of
+ * its shards are memory-mapped, so emissions are read from the page cache
+ * without a file and a deserialization per utterance, and only the records of
+ * the indices are loaded. Lookups are thread-safe.
+ */
+class EmissionStore {
+ public:
+  /**
+   * Maps the shards of a store.
+   * @param[in] dir The directory of the store.
+   */
+  explicit EmissionStore(const fs::path& dir);
+  ~EmissionStore();
+
+  EmissionStore(const EmissionStore&) = delete;
+  EmissionStore& operator=(const EmissionStore&) = delete;
+
+  /**
+   * @return The number of emissions of the store.
+   */
+  int64_t size() const;
+
+  /**
+   * @param[in] sampleId The ID of an utterance.
+   * @return True if the store has the emission of the utterance.
+   */
+  bool contains(const std::string& sampleId) const;
+
+  /**
+   * @param[in] sampleId The ID of an utterance of the store.
+   * @return The emission of the utterance, as float.
+   */
+  EmissionUnit get(const std::string& sampleId) const;
+
+  /**
+   * @param[in] dir A directory.
+   * @return True if the directory holds shards of an emission store.
+   */
+  static bool isEmissionStore(const fs::path& dir);
+
+ private:
+  struct Shard {
+    char* data{nullptr};
+    int64_t size{0};
+    bool fp16{false};
+  };
+  struct Entry {
+    int shard;
+    uint64_t offset;
+    int nFrames;
+    int nTokens;
+  };
+
+  void loadShard(const fs::path& indexPath, const fs::path& dataPath);
+
+  std::vector<Shard> shards_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
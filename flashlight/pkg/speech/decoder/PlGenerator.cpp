@@ -9,8 +9,12 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
 #include <thread>
 
+#include "flashlight/fl/tensor/Index.h"
 #include "flashlight/pkg/runtime/common/SequentialBuilder.h"
 #include "flashlight/pkg/speech/common/Defines.h"
 #include "flashlight/pkg/speech/decoder/TranscriptionUtils.h"
@@ -19,6 +23,8 @@
 namespace {
 constexpr const char* kPlDir = "generated_pl/";
 constexpr const char* kPlSubdirPrefix = "epoch_";
+// the pseudo labels of all the processes
+constexpr const char* kPlMergedList = "all.lst";
 } // namespace
 
 using namespace fl::pkg::runtime;
@@ -147,6 +153,56 @@ std::string PlGenerator::regeneratePl(
   if (plUpdateMap_.find(curEpoch) == plUpdateMap_.end()) {
     return "";
   }
+  auto plDir = preparePl(curEpoch);
+  generatePlShard(curEpoch, plDir, ntwrk, criterion, usePlugin);
+  mergePlShards(plDir);
+  return plDir;
+}
+
+bool PlGenerator::startPlRegeneration(
+    int curEpoch,
+    const std::shared_ptr<fl::Module>& ntwrk,
+    const std::shared_ptr<SequenceCriterion>& criterion,
+    const bool usePlugin /* = false */) {
+  if (plUpdateMap_.find(curEpoch) == plUpdateMap_.end()) {
+    return false;
+  }
+  if (asyncPl_.valid()) {
+    throw std::runtime_error(
+        "[PlGenerator] The previous PL regeneration isn't finished");
+  }
+  asyncPlDir_ = preparePl(curEpoch);
+
+  // the snapshot isn't updated by training
+  std::shared_ptr<fl::Module> ntwrkCopy;
+  std::shared_ptr<SequenceCriterion> criterionCopy;
+  {
+    std::stringstream snapshot;
+    fl::save(snapshot, ntwrk, criterion);
+    fl::load(snapshot, ntwrkCopy, criterionCopy);
+  }
+  const int device = fl::getDevice();
+  asyncPl_ = std::async(
+      std::launch::async,
+      [this, curEpoch, ntwrkCopy, criterionCopy, usePlugin, device]() {
+        fl::setDevice(device);
+        generatePlShard(
+            curEpoch, asyncPlDir_, ntwrkCopy, criterionCopy, usePlugin);
+      });
+  return true;
+}
+
+std::string PlGenerator::finishPlRegeneration() {
+  if (!asyncPl_.valid()) {
+    return "";
+  }
+  asyncPl_.get();
+  // collective communication is only done by the training thread
+  mergePlShards(asyncPlDir_);
+  return asyncPlDir_;
+}
+
+fs::path PlGenerator::preparePl(int curEpoch) const {
   if (!fullUnsupDs_) {
     throw std::runtime_error("No unlabeled data is provided");
   }
@@ -166,7 +222,15 @@ std::string PlGenerator::regeneratePl(
     throw std::runtime_error(
         "[PlGenerator] Failed to create " + plDir.string());
   }
+  return plDir;
+}
 
+void PlGenerator::generatePlShard(
+    int curEpoch,
+    const fs::path& plDir,
+    const std::shared_ptr<fl::Module>& ntwrk,
+    const std::shared_ptr<SequenceCriterion>& criterion,
+    bool usePlugin) const {
   /* 1. select data */
   // shuffle
   auto ds1 = std::make_shared<fl::ShuffleDataset>(fullUnsupDs_, curEpoch);
@@ -183,8 +247,28 @@ std::string PlGenerator::regeneratePl(
       fl::partitionByRoundRobin(ds2->size(), worldRank_, worldSize_, 1);
   auto ds3 = std::make_shared<fl::ResampleDataset>(ds2, partitions);
 
+  // batch, such that the model forwards several samples at once
+  int inPad, tgtPad, wrdPad;
+  std::tie(inPad, tgtPad, wrdPad) = padVal_;
+  auto batchFns = std::vector<fl::Dataset::BatchFunction>{
+      [inPad](const std::vector<Tensor>& tensor) {
+        return fl::join(tensor, inPad, 3);
+      },
+      [tgtPad](const std::vector<Tensor>& tensor) {
+        return fl::join(tensor, tgtPad, 1);
+      },
+      [wrdPad](const std::vector<Tensor>& tensor) {
+        return fl::join(tensor, wrdPad, 1);
+      },
+      [](const std::vector<Tensor>& tensor) { return fl::join(tensor, 0, 1); },
+      [](const std::vector<Tensor>& tensor) { return fl::join(tensor, 0, 1); },
+      [](const std::vector<Tensor>& tensor) { return fl::join(tensor, 0, 1); },
+      [](const std::vector<Tensor>& tensor) { return fl::join(tensor, 0, 1); }};
+  auto batchDs = std::make_shared<fl::BatchDataset>(
+      ds3, batchSize_, fl::BatchDatasetPolicy::INCLUDE_LAST, batchFns);
+
   // prefetch
-  auto selectedDs = std::make_shared<fl::PrefetchDataset>(ds3, 3, 3);
+  auto selectedDs = std::make_shared<fl::PrefetchDataset>(batchDs, 3, 3);
 
   logMaster(
       "[PlGenerator] " + std::to_string(nSelectedSamples) + "/" +
@@ -192,43 +276,68 @@ std::string PlGenerator::regeneratePl(
 
   /* 2. pseudo label generation */
   ntwrk->eval();
+  criterion->eval();
+  const bool useExistingPl = useExistingPl_ && seedModelWER_ < currentModelWER_;
   auto newPlFile = plDir / (std::to_string(worldRank_) + ".lst");
   std::ofstream plStream(newPlFile);
-  for (auto& sample : *selectedDs) {
-    auto duration = sample[kDurationIdx].scalar<float>();
-    if (duration < minInputSize_ || duration > maxInputSize_) {
-      continue;
-    }
-
-    std::vector<std::string> words;
-    if (useExistingPl_ && seedModelWER_ < currentModelWER_) {
-      auto tokenTarget = sample[kTargetIdx].toHostVector<int>();
-      words = tokenToWord_(tokenTarget, tokenDict_, false);
-    } else {
+  for (auto& batch : *selectedDs) {
+    auto durations = batch[kDurationIdx].toHostVector<float>();
+    auto sampleIds = readSampleIds(batch[kSampleIdx]);
+    auto inputPaths = readSampleIds(batch[kPathIdx]);
+    const int B = durations.size();
+
+    Tensor emissions;
+    if (!useExistingPl) {
       fl::Variable rawEmission;
       if (usePlugin) {
         rawEmission = ntwrk
                           ->forward(
-                              {fl::input(sample[kInputIdx]),
-                               fl::noGrad(sample[kDurationIdx])})
+                              {fl::input(batch[kInputIdx]),
+                               fl::noGrad(batch[kDurationIdx])})
                           .front();
       } else {
         rawEmission = fl::pkg::runtime::forwardSequentialModuleWithPadMask(
-            fl::input(sample[kInputIdx]), ntwrk, sample[kDurationIdx]);
+            fl::input(batch[kInputIdx]), ntwrk, batch[kDurationIdx]);
       }
-      auto tokenPrediction =
-          criterion->viterbiPath(rawEmission.tensor()).toHostVector<int>();
-      words = tokenToWord_(tokenPrediction, tokenDict_, true);
-    }
-    if (words.size() < minTargetSize_ || words.size() > maxTargetSize_) {
-      continue;
+      emissions = rawEmission.tensor();
     }
+    const float maxDuration =
+        *std::max_element(durations.begin(), durations.end());
 
-    auto sampleId = readSampleIds(sample[kSampleIdx]).front();
-    auto inputPath = readSampleIds(sample[kPathIdx]).front();
-    plStream << sampleId << "\t" << inputPath << "\t"
-             << std::to_string(duration) << "\t" << lib::join(" ", words)
-             << std::endl;
+    for (int b = 0; b < B; ++b) {
+      const float duration = durations[b];
+      if (duration < minInputSize_ || duration > maxInputSize_) {
+        continue;
+      }
+
+      std::vector<std::string> words;
+      if (useExistingPl) {
+        auto tokenTarget = batch[kTargetIdx](fl::span, b).toHostVector<int>();
+        while (!tokenTarget.empty() && tokenTarget.back() == tgtPad) {
+          tokenTarget.pop_back();
+        }
+        words = tokenToWord_(tokenTarget, tokenDict_, false);
+      } else {
+        // the frames of the sample, without the padding of the batch
+        const int T = emissions.dim(1);
+        const int nFrames = maxDuration > 0
+            ? std::min<int>(T, std::ceil(duration * T / maxDuration))
+            : T;
+        auto tokenPrediction =
+            criterion
+                ->viterbiPath(emissions(
+                    fl::span, fl::range(0, nFrames), fl::range(b, b + 1)))
+                .toHostVector<int>();
+        words = tokenToWord_(tokenPrediction, tokenDict_, true);
+      }
+      if (words.size() < minTargetSize_ || words.size() > maxTargetSize_) {
+        continue;
+      }
+
+      plStream << sampleIds[b] << "\t" << inputPaths[b] << "\t"
+               << std::to_string(duration) << "\t" << lib::join(" ", words)
+               << std::endl;
+    }
   }
   plStream.close();
 
@@ -236,10 +345,31 @@ std::string PlGenerator::regeneratePl(
   std::ofstream fnsStream(finishPlFile);
   fnsStream << "done";
   fnsStream.close();
+}
 
+void PlGenerator::mergePlShards(const fs::path& plDir) const {
   /* 3. waiting for all the other processes */
   fl::barrier();
-  return plDir;
+
+  // the shards are merged into a list file, through a temporary file such
+  // that the list is either complete or absent
+  if (isMaster_) {
+    auto mergedPath = plDir / kPlMergedList;
+    auto tmpPath = plDir / (std::string(kPlMergedList) + ".tmp");
+    {
+      std::ofstream merged(tmpPath);
+      for (int i = 0; i < worldSize_; i++) {
+        std::ifstream shard(plDir / (std::to_string(i) + ".lst"));
+        merged << shard.rdbuf();
+      }
+      if (!merged) {
+        throw std::runtime_error(
+            "[PlGenerator] Failed to write " + tmpPath.string());
+      }
+    }
+    fs::rename(tmpPath, mergedPath);
+  }
+  fl::barrier();
 }
 
 std::shared_ptr<fl::Dataset> PlGenerator::createTrainSet(
@@ -252,8 +382,13 @@ std::shared_ptr<fl::Dataset> PlGenerator::createTrainSet(
   for (const auto& file : lib::split(",", trainLists, true)) {
     files.emplace_back(trainDir / file);
   }
-  for (int i = 0; i < worldSize_; i++) {
-    files.emplace_back(trainUnsupDir / (std::to_string(i) + ".lst"));
+  // the shards of each process, unless they were merged
+  if (fs::exists(trainUnsupDir / kPlMergedList)) {
+    files.emplace_back(trainUnsupDir / kPlMergedList);
+  } else {
+    for (int i = 0; i < worldSize_; i++) {
+      files.emplace_back(trainUnsupDir / (std::to_string(i) + ".lst"));
+    }
   }
 
   return createDataset(
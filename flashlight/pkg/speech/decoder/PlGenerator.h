@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <future>
+
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/fl/contrib/contrib.h"
 #include "flashlight/fl/flashlight.h"
@@ -97,6 +99,23 @@ class PlGenerator {
       const std::shared_ptr<SequenceCriterion> criterion,
       const bool usePlugin = false) const;
 
+  /*
+   * To regenerate pseudo labels in the background, with a snapshot of the
+   * current model, while training continues with the previous ones. Returns
+   * whether it's supposed to do relabeling at the current epoch.
+   */
+  bool startPlRegeneration(
+      int curEpoch,
+      const std::shared_ptr<fl::Module>& ntwrk,
+      const std::shared_ptr<SequenceCriterion>& criterion,
+      const bool usePlugin = false);
+
+  /*
+   * To wait for the pseudo labels of `startPlRegeneration` on all the
+   * processes. An empty path is returned if no relabeling was started.
+   */
+  std::string finishPlRegeneration();
+
   /*
    * This function will create a mixture of supervised data and unalabeled data
    * with pseudo labels.
@@ -139,6 +158,21 @@ class PlGenerator {
   std::vector<int> plEpochs_;
   std::unordered_map<int, float> plUpdateMap_;
 
+  // the background relabeling and its directory
+  std::future<void> asyncPl_;
+  fs::path asyncPlDir_;
+
+  // selects the samples to relabel at an epoch and creates their directory
+  fs::path preparePl(int curEpoch) const;
+  // relabels the samples of this process, in batches
+  void generatePlShard(
+      int curEpoch,
+      const fs::path& plDir,
+      const std::shared_ptr<fl::Module>& ntwrk,
+      const std::shared_ptr<SequenceCriterion>& criterion,
+      bool usePlugin) const;
+  // waits for all the processes and merges their shards into a list file
+  void mergePlShards(const fs::path& plDir) const;
   int findLastPlEpoch(int curEpoch) const;
   void logMaster(const std::string& message) const;
 };
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/speech/decoder/StreamingDecoder.h"
+
+#include <stdexcept>
+#include <type_traits>
+
+#include "flashlight/fl/tensor/Index.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+namespace {
+
+int64_t nFrames(const Tensor& features) {
+  return features.isEmpty() ? 0 : features.dim(1);
+}
+
+void appendWords(std::vector<int>& words, const std::vector<int>& newWords) {
+  for (int word : newWords) {
+    if (word >= 0) {
+      words.push_back(word);
+    }
+  }
+}
+
+} // namespace
+
+StreamingAmState StreamingAmState::select(int64_t batchIdx) const {
+  StreamingAmState state;
+  state.frames = frames;
+  for (const auto& module : modules) {
+    state.modules.push_back(std::visit(
+        [batchIdx](const auto& s) -> ModuleState {
+          if constexpr (std::is_same_v<std::decay_t<decltype(s)>,
+                                       std::monostate>) {
+            return s;
+          } else {
+            return s.select(batchIdx);
+          }
+        },
+        module));
+  }
+  return state;
+}
+
+StreamingAmState StreamingAmState::concatenate(
+    const std::vector<StreamingAmState>& states) {
+  if (states.empty()) {
+    throw std::invalid_argument(
+        "StreamingAmState::concatenate - no states to concatenate");
+  }
+  const auto& first = states.front();
+  for (const auto& s : states) {
+    if (s.frames != first.frames || s.modules.size() != first.modules.size()) {
+      throw std::invalid_argument(
+          "StreamingAmState::concatenate - "
+          "states must be at the same position of their streams");
+    }
+  }
+  StreamingAmState state;
+  state.frames = first.frames;
+  for (size_t i = 0; i < first.modules.size(); ++i) {
+    state.modules.push_back(std::visit(
+        [&states, i](const auto& s) -> ModuleState {
+          using State = std::decay_t<decltype(s)>;
+          if constexpr (std::is_same_v<State, std::monostate>) {
+            return s;
+          } else {
+            std::vector<State> moduleStates;
+            for (const auto& other : states) {
+              moduleStates.push_back(std::get<State>(other.modules[i]));
+            }
+            return State::concatenate(moduleStates);
+          }
+        },
+        first.modules[i]));
+  }
+  return state;
+}
+
+std::pair<Variable, StreamingAmState> forwardStreamingAm(
+    const fl::Sequential& network,
+    const Variable& input,
+    StreamingAmState state,
+    bool last) {
+  const auto modules = network.modules();
+  if (state.modules.empty()) {
+    state.modules.resize(modules.size());
+  } else if (state.modules.size() != modules.size()) {
+    throw std::invalid_argument(
+        "forwardStreamingAm - the state doesn't match the network");
+  }
+  state.frames += input.dim(1);
+
+  // a streamed module may hold back all the frames of the chunk, which are
+  // forwarded by the next modules with the next chunks
+  auto x = input;
+  for (size_t i = 0; i < modules.size() && !x.isEmpty(); ++i) {
+    auto& moduleState = state.modules[i];
+    if (auto conformer = std::dynamic_pointer_cast<fl::Conformer>(modules[i])) {
+      if (!std::holds_alternative<fl::ConformerState>(moduleState)) {
+        moduleState = fl::ConformerState();
+      }
+      auto& s = std::get<fl::ConformerState>(moduleState);
+      std::tie(x, s) = conformer->forwardStreaming(x, std::move(s), last);
+    } else if (auto tds = std::dynamic_pointer_cast<fl::TDSBlock>(modules[i])) {
+      if (!std::holds_alternative<fl::TDSBlockState>(moduleState)) {
+        moduleState = fl::TDSBlockState();
+      }
+      auto& s = std::get<fl::TDSBlockState>(moduleState);
+      std::tie(x, s) = tds->forwardStreaming(x, std::move(s), last);
+    } else {
+      x = modules[i]->forward({x}).front();
+    }
+  }
+  return {x, std::move(state)};
+}
+
+StreamingDecoder::StreamingDecoder(
+    std::shared_ptr<fl::Sequential> network,
+    DecoderFactory decoderFactory,
+    StreamingDecoderOptions options)
+    : network_(std::move(network)),
+      decoderFactory_(std::move(decoderFactory)),
+      options_(std::move(options)) {
+  if (!network_ || !decoderFactory_ || !options_.featurize) {
+    throw std::invalid_argument(
+        "StreamingDecoder::StreamingDecoder - "
+        "a network, a decoder factory and a featurizer are required");
+  }
+  if (options_.chunkFrames <= 0 || options_.maxBatchSize <= 0 ||
+      options_.frameSizeSamples <= 0 || options_.frameStrideSamples <= 0) {
+    throw std::invalid_argument(
+        "StreamingDecoder::StreamingDecoder - "
+        "chunk, batch and frame sizes must be positive");
+  }
+}
+
+int64_t StreamingDecoder::openSession() {
+  auto session = std::make_shared<Session>();
+  session->decoder = decoderFactory_();
+  session->decoder->decodeBegin();
+  std::lock_guard<std::mutex> lock(mutex_);
+  sessions_[nextSession_] = std::move(session);
+  return nextSession_++;
+}
+
+std::shared_ptr<StreamingDecoder::Session> StreamingDecoder::getSession(
+    int64_t session) const {
+  auto it = sessions_.find(session);
+  if (it == sessions_.end()) {
+    throw std::invalid_argument(
+        "StreamingDecoder - unknown session " + std::to_string(session));
+  }
+  return it->second;
+}
+
+void StreamingDecoder::addAudio(
+    int64_t sessionId,
+    const std::vector<float>& samples) {
+  std::vector<float> frameSamples;
+  std::shared_ptr<Session> session;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    session = getSession(sessionId);
+    if (session->audioFinished) {
+      throw std::invalid_argument(
+          "StreamingDecoder::addAudio - the audio of the session is finished");
+    }
+    auto& buffer = session->samples;
+    buffer.insert(buffer.end(), samples.begin(), samples.end());
+    const int64_t size = options_.frameSizeSamples;
+    const int64_t stride = options_.frameStrideSamples;
+    if (static_cast<int64_t>(buffer.size()) < size) {
+      return;
+    }
+    // the samples of the whole frames, the next frame starts after them
+    const int64_t frames = (buffer.size() - size) / stride + 1;
+    frameSamples.assign(
+        buffer.begin(), buffer.begin() + (frames - 1) * stride + size);
+    buffer.erase(buffer.begin(), buffer.begin() + frames * stride);
+  }
+
+  // featurizes out of the lock, the session is fed by this thread only
+  auto features = options_.featurize(frameSamples);
+  std::lock_guard<std::mutex> lock(mutex_);
+  session->features = session->features.isEmpty()
+      ? features
+      : fl::concatenate(1, session->features, features);
+  updateReady(*session);
+}
+
+void StreamingDecoder::finishSession(int64_t sessionId) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto session = getSession(sessionId);
+  session->audioFinished = true;
+  session->samples.clear();
+  // chunks hold back a frame until the audio ends, so that the last chunk
+  // isn't empty unless there were no frames at all
+  if (nFrames(session->features) == 0 && !session->busy) {
+    session->decoder->decodeEnd();
+    appendWords(
+        session->result.words, session->decoder->getBestHypothesis().words);
+    session->result.partialWords.clear();
+    session->result.finished = true;
+  }
+  updateReady(*session);
+}
+
+void StreamingDecoder::removeSession(int64_t session) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sessions_.erase(session);
+}
+
+StreamingResult StreamingDecoder::result(int64_t session) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return getSession(session)->result;
+}
+
+int64_t StreamingDecoder::numSessions() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return sessions_.size();
+}
+
+int64_t StreamingDecoder::chunkSize(const Session& session) const {
+  if (session.busy || session.result.finished) {
+    return 0;
+  }
+  const int64_t pending = nFrames(session.features);
+  if (pending > options_.chunkFrames) {
+    return options_.chunkFrames;
+  }
+  return session.audioFinished ? pending : 0;
+}
+
+void StreamingDecoder::updateReady(Session& session) {
+  if (chunkSize(session) == 0) {
+    session.readySeq = -1;
+  } else if (session.readySeq < 0) {
+    session.readySeq = nextReadySeq_++;
+  }
+}
+
+int StreamingDecoder::step() {
+  std::vector<std::shared_ptr<Session>> batch;
+  std::vector<Tensor> chunks;
+  std::vector<StreamingAmState> states;
+  bool last = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // the session which waited the longest sets the position and the size
+    // of the chunks of the batch
+    std::shared_ptr<Session> oldest;
+    for (const auto& [id, session] : sessions_) {
+      if (session->readySeq >= 0 &&
+          (!oldest || session->readySeq < oldest->readySeq)) {
+        oldest = session;
+      }
+    }
+    if (!oldest) {
+      return 0;
+    }
+    const int64_t frames = oldest->amState.frames;
+    const int64_t size = chunkSize(*oldest);
+    last = oldest->audioFinished && size == nFrames(oldest->features);
+    batch.push_back(oldest);
+    for (const auto& [id, session] : sessions_) {
+      if (static_cast<int>(batch.size()) >= options_.maxBatchSize) {
+        break;
+      }
+      if (session != oldest && session->readySeq >= 0 &&
+          session->amState.frames == frames && chunkSize(*session) == size &&
+          (session->audioFinished &&
+           size == nFrames(session->features)) == last) {
+        batch.push_back(session);
+      }
+    }
+
+    for (auto& session : batch) {
+      auto& features = session->features;
+      chunks.push_back(features(fl::span, fl::range(0, size)));
+      features = size == nFrames(features)
+          ? Tensor()
+          : features(fl::span, fl::range(size, nFrames(features)));
+      states.push_back(std::move(session->amState));
+      session->busy = true;
+      session->readySeq = -1;
+    }
+  }
+
+  // the sessions are busy, their states and decoders are used out of the lock
+  const int B = batch.size();
+  auto input = fl::concatenate(chunks, 2);
+  auto state = B == 1 ? std::move(states.front())
+                      : StreamingAmState::concatenate(states);
+  Variable emissions;
+  std::tie(emissions, state) = forwardStreamingAm(
+      *network_, Variable(input, false), std::move(state), last);
+  for (int b = 0; b < B; ++b) {
+    batch[b]->amState = B == 1 ? std::move(state) : state.select(b);
+    decode(
+        *batch[b],
+        emissions.isEmpty() ? Tensor()
+                            : emissions.tensor()(fl::span, fl::span, b),
+        last);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& session : batch) {
+    session->busy = false;
+    updateReady(*session);
+  }
+  return B;
+}
+
+void StreamingDecoder::decode(
+    Session& session,
+    const Tensor& emissions,
+    bool last) {
+  auto& decoder = *session.decoder;
+  if (!emissions.isEmpty()) {
+    // N x T emissions are contiguous by frame
+    const int N = emissions.dim(0);
+    const int T = emissions.dim(1);
+    auto emissionsVec = emissions.toHostVector<float>();
+    decoder.decodeStep(emissionsVec.data(), T, N);
+  }
+
+  StreamingResult result;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    result = session.result;
+  }
+  if (last) {
+    decoder.decodeEnd();
+    appendWords(result.words, decoder.getBestHypothesis().words);
+    result.partialWords.clear();
+    result.finished = true;
+  } else if (!emissions.isEmpty()) {
+    // the words before the look-back are final, and the decoder keeps the
+    // frames after them only
+    appendWords(
+        result.words, decoder.getBestHypothesis(options_.lookBack).words);
+    decoder.prune(options_.lookBack);
+    result.partialWords.clear();
+    appendWords(result.partialWords, decoder.getBestHypothesis().words);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  session.result = std::move(result);
+}
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "flashlight/fl/contrib/modules/Conformer.h"
+#include "flashlight/fl/contrib/modules/TDSBlock.h"
+#include "flashlight/fl/flashlight.h"
+#include "flashlight/lib/text/decoder/Decoder.h"
+
+namespace fl {
+namespace pkg {
+namespace speech {
+
+/**
+ * The state of an acoustic model between the chunks of a stream, see
+ * `forwardStreamingAm`. Default-constructed at the start of a stream.
+ */
+struct StreamingAmState {
+  using ModuleState =
+      std::variant<std::monostate, fl::ConformerState, fl::TDSBlockState>;
+
+  // the state of each module of the model, empty for frame-wise modules
+  std::vector<ModuleState> modules;
+  // the number of input frames of the stream so far
+  int64_t frames{0};
+
+  /**
+   * @return the state of a single batch element, with batch size 1.
+   */
+  StreamingAmState select(int64_t batchIdx) const;
+
+  /**
+   * Batches the states of streams at the same position along the batch
+   * dimension.
+   */
+  static StreamingAmState concatenate(
+      const std::vector<StreamingAmState>& states);
+};
+
+/**
+ * Forwards the next chunk of a stream through an acoustic model. Its
+ * `Conformer` and `TDSBlock` modules are streamed, and the other modules,
+ * e.g. `Linear` or activations, are applied to the chunk as is, i.e. must not
+ * mix frames. Streamed modules hold back frames until their right context is
+ * available, and the last chunk flushes them.
+ *
+ * @param network the acoustic model
+ * @param input the next frames of the stream, of size C x T x B
+ * @param state the state after the previous chunk
+ * @param last whether the chunk ends the stream
+ * @return the emissions of the frames which are ready, of size N x T' x B and
+ * empty if none, and the state for the next chunk
+ */
+std::pair<fl::Variable, StreamingAmState> forwardStreamingAm(
+    const fl::Sequential& network,
+    const fl::Variable& input,
+    StreamingAmState state,
+    bool last);
+
+struct StreamingDecoderOptions {
+  // the number of feature frames of a chunk forwarded by the model
+  int chunkFrames{32};
+  // the largest number of sessions batched in a forward pass
+  int maxBatchSize{256};
+  // the number of the last decoded frames whose words may still change
+  int lookBack{0};
+  // the audio samples of a feature frame, and between two frames
+  int frameSizeSamples{400};
+  int frameStrideSamples{160};
+  // computes the features of size C x T of the samples of T whole frames
+  std::function<Tensor(const std::vector<float>&)> featurize;
+};
+
+/**
+ * The transcription of a session so far.
+ */
+struct StreamingResult {
+  // the words which won't change
+  std::vector<int> words;
+  // the words of the best hypothesis of the frames after them
+  std::vector<int> partialWords;
+  // whether the stream ended and all of its frames were decoded
+  bool finished{false};
+};
+
+/**
+ * StreamingDecoder is a long-running decoder of many concurrent audio
+ * streams, or sessions. The audio of a session is featurized as it arrives
+ * and forwarded by chunks of `chunkFrames` frames with `forwardStreamingAm`,
+ * whose emissions are decoded incrementally by a decoder per session, e.g. a
+ * lexicon beam-search decoder, which yields partial results.
+ *
+ * Each call to `step` forwards a batch of chunks, of the session which waited
+ * the longest and of the other sessions at the same position of their
+ * streams, such that the chunks are batched along with their states. Sessions
+ * fed at the same pace stay in lockstep and are batched together.
+ *
+ * The methods are thread-safe: the audio of a session is fed by one thread at
+ * a time, while the threads of the service, e.g. one per device, call `step`
+ * in a loop.
+ *
+ * Sample usage:
+ *
+ *   StreamingDecoder service(network, makeDecoder, options);
+ *
+ *   // Session threads
+ *   auto id = service.openSession();
+ *   while (...) {
+ *     service.addAudio(id, samples);
+ *     auto result = service.result(id);
+ *   }
+ *   service.finishSession(id);
+ *
+ *   // Service threads
+ *   while (running) {
+ *     if (service.step() == 0) {
+ *       wait();
+ *     }
+ *   }
+ */
+class StreamingDecoder {
+ public:
+  using DecoderFactory =
+      std::function<std::unique_ptr<fl::lib::text::Decoder>()>;
+
+  /**
+   * @param network the acoustic model, in eval mode
+   * @param decoderFactory creates the decoder of a session
+   * @param options the chunking, batching and featurization of the streams
+   */
+  StreamingDecoder(
+      std::shared_ptr<fl::Sequential> network,
+      DecoderFactory decoderFactory,
+      StreamingDecoderOptions options);
+
+  /** @return the id of a new session */
+  int64_t openSession();
+
+  /** Featurizes the next audio samples of a session. */
+  void addAudio(int64_t session, const std::vector<float>& samples);
+
+  /** Ends the audio of a session, whose pending frames are then flushed. */
+  void finishSession(int64_t session);
+
+  /** Removes a session, e.g. once it is finished. */
+  void removeSession(int64_t session);
+
+  StreamingResult result(int64_t session) const;
+
+  /**
+   * Forwards and decodes a batch of chunks.
+   * @return the number of chunks, 0 if no session has a chunk ready
+   */
+  int step();
+
+  int64_t numSessions() const;
+
+ private:
+  struct Session {
+    std::vector<float> samples;
+    // the features which were not forwarded, of size C x T
+    Tensor features;
+    StreamingAmState amState;
+    std::unique_ptr<fl::lib::text::Decoder> decoder;
+    StreamingResult result;
+    bool audioFinished{false};
+    // whether a step is forwarding the session
+    bool busy{false};
+    // the order in which sessions are ready, the oldest first
+    int64_t readySeq{-1};
+  };
+
+  std::shared_ptr<fl::Sequential> network_;
+  DecoderFactory decoderFactory_;
+  StreamingDecoderOptions options_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<int64_t, std::shared_ptr<Session>> sessions_;
+  int64_t nextSession_{0};
+  int64_t nextReadySeq_{0};
+
+  // the number of frames of the next chunk of a session, 0 if not ready
+  int64_t chunkSize(const Session& session) const;
+  void updateReady(Session& session);
+  std::shared_ptr<Session> getSession(int64_t session) const;
+  void decode(Session& session, const Tensor& emissions, bool last);
+};
+
+} // namespace speech
+} // namespace pkg
+} // namespace fl
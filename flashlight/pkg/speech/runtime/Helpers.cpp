@@ -107,7 +107,8 @@ std::shared_ptr<fl::Dataset> createDataset(
     int worldSize /* = 1 */,
     const bool allowEmpty /* = false */,
     const std::string& batchingStrategy /* kBatchStrategyNone */,
-    int maxDurationPerBatch /* = 0 */) {
+    int maxDurationPerBatch /* = 0 */,
+    const std::shared_ptr<const FeatureStore>& featureStore /* = nullptr */) {
   std::vector<std::shared_ptr<const fl::Dataset>> allListDs;
   std::vector<float> sizes;
   for (auto& path : paths) {
@@ -128,6 +129,9 @@ std::shared_ptr<fl::Dataset> createDataset(
       curListDs = std::make_shared<ListFileDataset>(
           rootDir / path, inputTransform, targetTransform, wordTransform);
     }
+    if (featureStore) {
+      curListDs->setFeatureStore(featureStore);
+    }
 
     allListDs.emplace_back(curListDs);
     sizes.reserve(sizes.size() + curListDs->size());
@@ -208,13 +212,17 @@ std::shared_ptr<fl::Dataset> loadPrefetchDataset(
     std::shared_ptr<fl::Dataset> dataset,
     int prefetchThreads,
     bool shuffle,
-    int shuffleSeed /*= 0 */) {
+    int shuffleSeed /*= 0 */,
+    fl::ThreadAffinityPolicy affinity /* = fl::ThreadAffinityPolicy::None */) {
   if (shuffle) {
     dataset = std::make_shared<fl::ShuffleDataset>(dataset, shuffleSeed);
   }
   if (prefetchThreads > 0) {
     dataset = std::make_shared<fl::PrefetchDataset>(
-        dataset, prefetchThreads, prefetchThreads /* prefetch size */);
+        dataset,
+        prefetchThreads,
+        prefetchThreads /* prefetch size */,
+        affinity);
   }
   return dataset;
 }
@@ -234,6 +242,18 @@ std::vector<std::pair<std::string, std::string>> parseValidSets(
   }
   return validTagSets;
 }
+
+fl::pkg::runtime::ChunkedForward::Options getAmChunkOptions() {
+  fl::pkg::runtime::ChunkedForward::Options options;
+  options.inputAxis = 0;
+  options.outputAxis = 1;
+  options.chunkSize = FLAGS_am_chunk_frames;
+  options.leftContext = FLAGS_am_chunk_context;
+  options.rightContext = FLAGS_am_chunk_context;
+  options.memoryBudget = static_cast<size_t>(FLAGS_am_chunk_memory_budget)
+      << 20;
+  return options;
+}
 } // namespace speech
 } // namespace pkg
 } // namespace fl
@@ -23,9 +23,11 @@
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/lib/text/String.h"
 #include "flashlight/lib/text/dictionary/Utils.h"
+#include "flashlight/pkg/runtime/common/ChunkedForward.h"
 #include "flashlight/pkg/speech/common/Defines.h"
 #include "flashlight/pkg/speech/common/Flags.h"
 #include "flashlight/pkg/speech/criterion/criterion.h"
+#include "flashlight/pkg/speech/data/FeatureStore.h"
 #include "flashlight/pkg/speech/data/ListFileDataset.h"
 
 namespace fl {
@@ -67,6 +69,8 @@ std::vector<std::string> readSampleIds(const Tensor& arr);
  * "dynamic"
  * @param maxDurationPerBatch - is used for batchingStrategy="dynamic", max
  * total duration in a batch
+ * @param featureStore - if set, precomputed input features of the samples,
+ * read instead of featurizing their audio with inputTransform
  */
 std::shared_ptr<fl::Dataset> createDataset(
     const std::vector<fs::path>& paths,
@@ -81,13 +85,15 @@ std::shared_ptr<fl::Dataset> createDataset(
     int worldSize = 1,
     const bool allowEmpty = false,
     const std::string& batchingStrategy = kBatchStrategyNone,
-    int maxDurationPerBatch = 0);
+    int maxDurationPerBatch = 0,
+    const std::shared_ptr<const FeatureStore>& featureStore = nullptr);
 
 std::shared_ptr<fl::Dataset> loadPrefetchDataset(
     std::shared_ptr<fl::Dataset> dataset,
     int prefetchThreads,
     bool shuffle,
-    int shuffleSeed = 0);
+    int shuffleSeed = 0,
+    fl::ThreadAffinityPolicy affinity = fl::ThreadAffinityPolicy::None);
 
 /*
  * Function to parse valid set string describing multiple datasets into a vector
@@ -97,6 +103,13 @@ std::shared_ptr<fl::Dataset> loadPrefetchDataset(
 std::vector<std::pair<std::string, std::string>> parseValidSets(
     const std::string& valid);
 
+/**
+ * The options of the chunked forward of an acoustic model from the
+ * `--am_chunk_*` flags: its {T, C, 1, B} input is split in time, and its
+ * {N, T, B} emissions stitched in time.
+ */
+fl::pkg::runtime::ChunkedForward::Options getAmChunkOptions();
+
 } // namespace speech
 } // namespace pkg
 } // namespace fl
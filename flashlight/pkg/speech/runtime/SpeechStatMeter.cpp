@@ -33,6 +33,13 @@ void SpeechStatMeter::add(const Tensor& inputSizes, const Tensor& targetSizes) {
 
   stats_.numSamples_ += inputSizes.dim(1);
   stats_.numBatches_++;
+
+  if (metrics_) {
+    metrics_->samples.inc(inputSizes.dim(1));
+    metrics_->batches.inc();
+    metrics_->inputFrames.inc(curInputSz);
+    metrics_->targetTokens.inc(curTargetSz);
+  }
 }
 
 void SpeechStatMeter::add(const SpeechStats& stats) {
@@ -50,6 +57,23 @@ std::vector<int64_t> SpeechStatMeter::value() const {
   return stats_.toArray();
 }
 
+void SpeechStatMeter::exportMetrics(const MetricLabels& labels /* = {} */) {
+  auto& registry = MetricsRegistry::getInstance();
+  metrics_ = std::shared_ptr<Metrics>(new Metrics{
+      registry.counter(
+          "fl_speech_samples_total", "Speech samples processed", labels),
+      registry.counter(
+          "fl_speech_batches_total", "Speech batches processed", labels),
+      registry.counter(
+          "fl_speech_input_frames_total",
+          "Input frames of the speech samples processed",
+          labels),
+      registry.counter(
+          "fl_speech_target_tokens_total",
+          "Target tokens of the speech samples processed",
+          labels)});
+}
+
 SpeechStats::SpeechStats() {
   reset();
 }
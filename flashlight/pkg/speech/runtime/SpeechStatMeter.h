@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <memory>
+
+#include "flashlight/fl/common/Metrics.h"
 #include "flashlight/fl/flashlight.h"
 
 namespace fl {
@@ -34,8 +37,24 @@ class SpeechStatMeter {
   std::vector<int64_t> value() const;
   void reset();
 
+  /**
+   * Exports the samples, batches, input frames and target tokens added from
+   * size tensors as counters of the `MetricsRegistry`, e.g. labelled by
+   * dataset. Counters are not affected by `reset`, nor by the stats of other
+   * processes merged into the meter.
+   */
+  void exportMetrics(const MetricLabels& labels = {});
+
  private:
   SpeechStats stats_;
+
+  struct Metrics {
+    CounterMetric& samples;
+    CounterMetric& batches;
+    CounterMetric& inputFrames;
+    CounterMetric& targetTokens;
+  };
+  std::shared_ptr<Metrics> metrics_; // shared by copies
 };
 } // namespace speech
 } // namespace pkg
@@ -11,6 +11,7 @@
 #include <iostream>
 #include <iterator>
 #include <sstream>
+#include <thread>
 
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/pkg/speech/audio/feature/FeatureParams.h"
@@ -173,6 +174,37 @@ TEST(MfccTest, BatchingTest2) {
   }
 }
 
+TEST(MfccTest, ConcurrentApplyTest) {
+  // threads share the FFT plan of a featurizer
+  FeatureParams featparams;
+  featparams.frameSizeMs = 25;
+  Mfcc mfcc(featparams);
+  const int numThreads = 8;
+  std::vector<std::vector<float>> inputs, expected;
+  for (int t = 0; t < numThreads; ++t) {
+    inputs.push_back(randVec<float>(4000 + 100 * t));
+    expected.push_back(mfcc.apply(inputs.back()));
+  }
+  std::vector<std::vector<float>> outputs(numThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < 10; ++i) {
+        outputs[t] = mfcc.apply(inputs[t]);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < numThreads; ++t) {
+    ASSERT_EQ(outputs[t].size(), expected[t].size());
+    for (int j = 0; j < outputs[t].size(); ++j) {
+      ASSERT_FLOAT_EQ(outputs[t][j], expected[t][j]);
+    }
+  }
+}
+
 TEST(MfccTest, EmptyTest) {
   std::vector<float> input;
   FeatureParams featparams;
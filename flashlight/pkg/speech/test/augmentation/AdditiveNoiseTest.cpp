@@ -13,6 +13,7 @@
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/fl/tensor/Init.h"
 #include "flashlight/pkg/speech/augmentation/AdditiveNoise.h"
+#include "flashlight/pkg/speech/augmentation/NoiseBank.h"
 #include "flashlight/pkg/speech/augmentation/SoundEffectUtil.h"
 #include "flashlight/pkg/speech/data/Sound.h"
 
@@ -94,6 +95,70 @@ TEST(AdditiveNoise, Snr) {
   }
 }
 
+/**
+ * Test that noise sliced from a noise bank, in f32 and s16, matches the noise
+ * loaded from the sound files of the list the bank was written from.
+ */
+TEST(AdditiveNoise, NoiseBank) {
+  const fs::path tmpDir = fs::temp_directory_path() / "AdditiveNoise";
+  fs::create_directory(tmpDir);
+  const fs::path listFilePath = tmpDir / "bank.lst";
+
+  std::vector<std::string> noiseFiles;
+  for (int i = 0; i < 3; ++i) {
+    std::vector<float> noise(5 + i * 7);
+    for (int j = 0; j < noise.size(); ++j) {
+      noise[j] = std::sin(0.3 * (i + 1) * j) * 0.5;
+    }
+    noiseFiles.push_back(
+        (tmpDir / ("bank" + std::to_string(i) + ".flac")).string());
+    saveSound(
+        noiseFiles.back(),
+        noise,
+        sampleRate,
+        1,
+        fl::pkg::speech::SoundFormat::FLAC,
+        fl::pkg::speech::SoundSubFormat::PCM_16);
+  }
+  {
+    std::ofstream listFile(listFilePath);
+    for (const auto& noiseFile : noiseFiles) {
+      listFile << noiseFile << std::endl;
+    }
+  }
+
+  AdditiveNoise::Config conf;
+  conf.proba_ = 1.0;
+  conf.ratio_ = 0.8;
+  conf.nClipsMin_ = 2;
+  conf.nClipsMax_ = 3;
+  conf.listFilePath_ = listFilePath;
+  std::vector<float> signal(100, 0.25);
+
+  for (auto type : {fl::dtype::f32, fl::dtype::s16}) {
+    const fs::path bankPath =
+        tmpDir / ("noise_" + fl::dtypeToString(type) + NoiseBank::kExtension);
+    NoiseBank::write(noiseFiles, bankPath, type);
+    NoiseBank bank(bankPath);
+    ASSERT_EQ(bank.size(), noiseFiles.size());
+    for (int i = 0; i < bank.size(); ++i) {
+      ASSERT_EQ(bank.length(i), 5 + i * 7);
+    }
+
+    AdditiveNoise listSfx(conf, /* seed = */ 7);
+    auto bankConf = conf;
+    bankConf.listFilePath_ = bankPath;
+    AdditiveNoise bankSfx(bankConf, /* seed = */ 7);
+    for (int i = 0; i < 5; ++i) {
+      auto fromList = signal;
+      listSfx.apply(fromList);
+      auto fromBank = signal;
+      bankSfx.apply(fromBank);
+      EXPECT_THAT(fromBank, Pointwise(FloatNearPointwise(1e-5), fromList));
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
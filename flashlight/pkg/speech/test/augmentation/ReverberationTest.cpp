@@ -8,11 +8,17 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <fstream>
+
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/pkg/speech/augmentation/FftConvolution.h"
 #include "flashlight/pkg/speech/augmentation/Reverberation.h"
 #include "flashlight/pkg/speech/augmentation/SoundEffectUtil.h"
+#include "flashlight/pkg/speech/data/Sound.h"
 #include "flashlight/fl/tensor/Init.h"
 
 using namespace ::fl::pkg::speech::sfx;
+using ::fl::pkg::speech::saveSound;
 using testing::Pointwise;
 
 // Arbitrary audioable signal values.
@@ -115,6 +121,99 @@ TEST(ReverbEcho, SinWaveReverb) {
   EXPECT_THAT(noiseMain, Pointwise(FloatNearPointwise(0.1), noiseSrc));
 }
 
+namespace {
+
+std::vector<float> directConvolution(
+    const std::vector<float>& signal,
+    const std::vector<float>& ir) {
+  std::vector<float> output(signal.size(), 0);
+  for (int i = 0; i < signal.size(); ++i) {
+    for (int j = 0; j < ir.size() && j <= i; ++j) {
+      output[i] += ir[j] * signal[i - j];
+    }
+  }
+  return output;
+}
+
+} // namespace
+
+/**
+ * Test that the overlap-add FFT convolution matches the convolution in the
+ * time domain, for blocks shorter and longer than the impulse response, and
+ * that the output is exactly zero before the first tap.
+ */
+TEST(FftConvolver, DirectConvolution) {
+  RandomNumberGenerator rng;
+  std::vector<float> signal(1000);
+  for (auto& x : signal) {
+    x = rng.uniform(-1, 1);
+  }
+  const int firstTap = 7;
+  std::vector<float> ir(firstTap + 300, 0);
+  for (int i = firstTap; i < ir.size(); ++i) {
+    ir[i] = rng.uniform(-1, 1) / (i + 1);
+  }
+  const auto expected = directConvolution(signal, ir);
+
+  for (int blockSize : {0, 1, 64, 2000}) {
+    FftConvolver convolver(ir, blockSize);
+    const auto output = convolver.apply(signal);
+    ASSERT_EQ(output.size(), signal.size());
+    for (int i = 0; i < firstTap; ++i) {
+      EXPECT_EQ(output[i], 0);
+    }
+    EXPECT_THAT(output, Pointwise(FloatNearPointwise(1e-4), expected));
+  }
+
+  FftConvolver silent(std::vector<float>(10, 0));
+  EXPECT_EQ(silent.apply(signal), std::vector<float>(signal.size(), 0));
+}
+
+/**
+ * Test that RIRs loaded from a list of files are aligned on their peak and
+ * normalized to unit energy.
+ */
+TEST(ConvolutionReverb, AlignedNormalizedRir) {
+  const fs::path tmpDir = fs::temp_directory_path() / "ConvolutionReverb";
+  fs::create_directory(tmpDir);
+  const fs::path listFilePath = tmpDir / "rir.lst";
+  const fs::path rirFilePath = tmpDir / "rir.wav";
+
+  // direct path after 3 samples of leading noise, and a single echo
+  const std::vector<float> rir = {0, 0, 0.1, 0.6, 0, 0, 0.48};
+  saveSound(
+      rirFilePath,
+      rir,
+      sampleRate,
+      1,
+      fl::pkg::speech::SoundFormat::WAV,
+      fl::pkg::speech::SoundSubFormat::FLOAT);
+  {
+    std::ofstream listFile(listFilePath);
+    listFile << rirFilePath.string();
+  }
+
+  ConvolutionReverb::Config conf;
+  conf.proba_ = 1.0;
+  conf.listFilePath_ = listFilePath;
+  ConvolutionReverb sfx(conf);
+
+  std::vector<float> signal =
+      genTestSinWave(numSamples, freq, sampleRate, amplitude);
+  auto augmented = signal;
+  sfx.apply(augmented);
+
+  const float norm = std::sqrt(0.6f * 0.6f + 0.48f * 0.48f);
+  const auto expected =
+      directConvolution(signal, {0.6f / norm, 0, 0, 0.48f / norm});
+  EXPECT_THAT(augmented, Pointwise(FloatNearPointwise(1e-4), expected));
+
+  // the cached RIR gives the same output
+  auto augmentedAgain = signal;
+  sfx.apply(augmentedAgain);
+  EXPECT_EQ(augmented, augmentedAgain);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
@@ -10,6 +10,8 @@
 
 #include "flashlight/pkg/speech/augmentation/SoundEffect.h"
 #include "flashlight/fl/tensor/Init.h"
+#include "flashlight/pkg/speech/augmentation/ParallelSoundEffect.h"
+#include "flashlight/pkg/speech/augmentation/SoundEffectConfig.h"
 #include "flashlight/pkg/speech/augmentation/SoundEffectUtil.h"
 
 using namespace ::fl::pkg::speech::sfx;
@@ -144,6 +146,47 @@ TEST(SoundEffect, SfxChain) {
   EXPECT_THAT(signal, Each(AllOf(Ge(-amplitude), Le(amplitude))));
 }
 
+// Test that the parallel application of a chain to a batch of signals matches
+// the application of the chain reseeded with the seed of each signal, for any
+// number of threads.
+TEST(SoundEffect, ParallelSoundEffect) {
+  SoundEffectConfig amplify;
+  amplify.type_ = kAmplify;
+  amplify.amplifyConfig_.ratioMin_ = 0.1;
+  amplify.amplifyConfig_.ratioMax_ = 10;
+  SoundEffectConfig reverb;
+  reverb.type_ = kReverbEcho;
+  reverb.reverbEchoConfig_.firstDelayMin_ = 0.001;
+  reverb.reverbEchoConfig_.firstDelayMax_ = 0.002;
+  reverb.reverbEchoConfig_.sampleRate_ = sampleRate;
+  const std::vector<SoundEffectConfig> configs = {amplify, reverb};
+
+  std::vector<std::vector<float>> signals;
+  std::vector<unsigned int> seeds;
+  for (int i = 0; i < 13; ++i) {
+    signals.push_back(
+        genTestSinWave(numSamples / 10 + i, freq, sampleRate, 0.5));
+    seeds.push_back(100 + i);
+  }
+  auto expected = signals;
+  auto sfxChain = createSoundEffect(configs);
+  for (int i = 0; i < expected.size(); ++i) {
+    sfxChain->setSeed(seeds[i]);
+    sfxChain->apply(expected[i]);
+  }
+
+  for (size_t numThreads : {1, 4, 20}) {
+    ParallelSoundEffect sfx(configs, numThreads);
+    auto augmented = signals;
+    sfx.apply(augmented, seeds);
+    EXPECT_EQ(augmented, expected);
+    // the same seeds give the same augmentation
+    augmented = signals;
+    sfx.apply(augmented, seeds);
+    EXPECT_EQ(augmented, expected);
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
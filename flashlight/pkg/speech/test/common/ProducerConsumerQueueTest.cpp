@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <atomic>
 #include <future>
 #include <mutex>
 #include <string>
@@ -14,6 +15,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include "flashlight/pkg/speech/common/MemoryBudget.h"
 #include "flashlight/pkg/speech/common/ProducerConsumerQueue.h"
 
 using namespace fl::lib;
@@ -88,6 +90,48 @@ TEST(ProducerConsumerQueueTest, MultiThreads) {
   ASSERT_EQ(predictSum, targetSum);
 }
 
+TEST(ProducerConsumerQueueTest, MemoryBudget) {
+  const int nElements = 1000;
+  const size_t maxBytes = 10;
+  MemoryBudget budget(maxBytes);
+  ProducerConsumerQueue<size_t> queue(nElements);
+
+  // an element larger than the budget is granted when nothing is held
+  budget.acquire(2 * maxBytes);
+  ASSERT_EQ(budget.usedBytes(), 2 * maxBytes);
+  budget.release(2 * maxBytes);
+
+  std::atomic<size_t> maxUsed{0};
+  auto produce = [&]() {
+    for (int i = 0; i < nElements; i++) {
+      size_t bytes = 1 + i % 4;
+      budget.acquire(bytes);
+      size_t used = budget.usedBytes();
+      size_t prev = maxUsed.load();
+      while (used > prev && !maxUsed.compare_exchange_weak(prev, used)) {
+      }
+      queue.add(bytes);
+    }
+    queue.finishAdding();
+  };
+  auto consume = [&]() {
+    size_t bytes;
+    int nConsumed = 0;
+    while (queue.get(bytes)) {
+      budget.release(bytes);
+      ++nConsumed;
+    }
+    return nConsumed;
+  };
+
+  auto producer = std::async(std::launch::async, produce);
+  auto consumer = std::async(std::launch::async, consume);
+  producer.wait();
+  ASSERT_EQ(consumer.get(), nElements);
+  ASSERT_LE(maxUsed.load(), maxBytes);
+  ASSERT_EQ(budget.usedBytes(), 0);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -172,6 +172,43 @@ TEST(CriterionTest, Batching) {
   }
 }
 
+TEST(CriterionTest, CTCInputSizes) {
+  // The frames of an utterance beyond its size are ignored, i.e. its loss is
+  // that of its first frames, which have all its gradient
+  int N = 10, T = 20, L = 6, B = 3;
+  auto in = Variable(fl::log(fl::rand({N, T, B})), true);
+  auto t = fl::abs(fl::rand({L, B}, fl::dtype::s32)) % (N - 2);
+  auto tgt = Variable(t.astype(fl::dtype::s32), false);
+  // relative to the largest, i.e. 20, 10 and 5 frames
+  std::vector<int> sizes = {100, 50, 25};
+  auto inputSizes = Variable(Tensor::fromVector({1, B}, sizes), false);
+  auto l = ConnectionistTemporalClassificationCriterion(
+      CriterionScaleMode::INPUT_SZ);
+  auto output = l.forward({in, tgt, inputSizes}).front();
+  output.backward();
+
+  for (int i = 0; i < B; ++i) {
+    const int uttT = T * sizes[i] / sizes[0];
+    auto inel = Variable(
+        in.tensor()(fl::span, fl::range(0, uttT), fl::range(i, i + 1)), true);
+    auto tgtel = moddims(tgt(fl::span, i), {L, 1});
+    auto outputCur = l.forward({inel, tgtel}).front();
+    outputCur.backward();
+    checkZero(output.tensor()(i) - outputCur.tensor(), 1E-5);
+    auto grad = in.grad().tensor()(fl::span, fl::span, fl::range(i, i + 1));
+    checkZero(
+        grad(fl::span, fl::range(0, uttT)) - inel.grad().tensor(), 1E-5);
+    if (uttT < T) {
+      checkZero(grad(fl::span, fl::range(uttT, T)), 1E-6);
+    }
+  }
+
+  auto funcConvIn = [&](Variable& inp) {
+    return l.forward({inp, tgt, inputSizes}).front();
+  };
+  jacobianTest(funcConvIn, in);
+}
+
 TEST(CriterionTest, CTCCompareTensorflow) {
   // The following test cases are taken from Tensor Flow CTC implementation
   // tinyurl.com/y9du5v5a
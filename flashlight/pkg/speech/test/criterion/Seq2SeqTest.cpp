@@ -142,6 +142,36 @@ TEST(Seq2SeqTest, Seq2SeqBeamSearchViterbi) {
   }
 }
 
+TEST(Seq2SeqTest, Seq2SeqBatchedBeamSearchViterbi) {
+  int nclass = 40;
+  int hiddendim = 256;
+  int inputsteps = 200;
+  int maxoutputlen = 100;
+  int batchsize = 3;
+
+  Seq2SeqCriterion seq2seq(
+      nclass,
+      hiddendim,
+      nclass - 2 /* eos token index */,
+      nclass - 1 /* pad token index */,
+      maxoutputlen,
+      {std::make_shared<ContentAttention>()});
+
+  seq2seq.eval();
+  auto input = fl::randn({hiddendim, inputsteps, batchsize}, fl::dtype::f32);
+
+  auto beampaths = seq2seq.batchedBeamPath(input, Tensor(), 1);
+  ASSERT_EQ(beampaths.size(), batchsize);
+  for (int b = 0; b < batchsize; b++) {
+    auto viterbipath =
+        seq2seq.viterbiPath(input(fl::span, fl::span, fl::range(b, b + 1)));
+    ASSERT_EQ(beampaths[b].size(), viterbipath.elements());
+    for (int idx = 0; idx < beampaths[b].size(); idx++) {
+      ASSERT_EQ(beampaths[b][idx], viterbipath(idx).scalar<int>());
+    }
+  }
+}
+
 TEST(Seq2SeqTest, Seq2SeqMedianWindow) {
   int nclass = 40;
   int hiddendim = 256;
@@ -288,6 +288,37 @@ TEST(WindowTest, SoftPretrainWindow) {
           .scalar<unsigned>() == targetlen / 2 * inputsteps);
 }
 
+TEST(WindowTest, VectorizedWindowMatchesSteps) {
+  int inputsteps = 40;
+  int batchsize = 3;
+  int targetlen = 12;
+
+  std::vector<int> inpSzRaw = {2, 4, 3};
+  Tensor inpSz = Tensor::fromVector({1, batchsize}, inpSzRaw);
+  std::vector<int> tgSzRaw = {1, 3, 2};
+  Tensor tgSz = Tensor::fromVector({1, batchsize}, tgSzRaw);
+
+  Variable inputAttn; // dummy
+  std::vector<std::shared_ptr<WindowBase>> windows = {
+      std::make_shared<StepWindow>(2, 8, 1.5, 4.5),
+      std::make_shared<SoftWindow>(4.0, 3.2, 2),
+      std::make_shared<SoftPretrainWindow>(5.0)};
+  for (const auto& window : windows) {
+    auto maskV = window->computeVectorizedWindow(
+        targetlen, inputsteps, batchsize, inpSz, tgSz);
+    ASSERT_EQ(maskV.shape(), Shape({targetlen, inputsteps, batchsize}));
+    for (int step = 0; step < targetlen; ++step) {
+      auto mask = window->computeWindow(
+          inputAttn, step, targetlen, inputsteps, batchsize, inpSz, tgSz);
+      ASSERT_EQ(mask.shape(), Shape({1, inputsteps, batchsize}));
+      // the padding may be -inf
+      ASSERT_TRUE(allClose(
+          fl::exp(mask.tensor()),
+          fl::exp(maskV.tensor()(fl::range(step, step + 1)))));
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
@@ -12,8 +12,10 @@
 
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Init.h"
+#include "flashlight/pkg/speech/audio/feature/Mfcc.h"
 #include "flashlight/pkg/speech/audio/feature/SpeechUtils.h"
 #include "flashlight/pkg/speech/common/Defines.h"
+#include "flashlight/pkg/speech/data/DeviceFeaturizer.h"
 #include "flashlight/pkg/speech/data/FeatureTransforms.h"
 #include "flashlight/pkg/speech/data/ListFileDataset.h"
 #include "flashlight/pkg/speech/data/Utils.h"
@@ -390,6 +392,56 @@ TEST(FeaturizationTest, inputFeaturizer) {
   }
 }
 
+TEST(FeaturizationTest, DeviceFeaturizer) {
+  const int samplerate = 16000, batchSz = 3, insize = samplerate / 2;
+  std::vector<float> input(insize * batchSz);
+  for (int j = 0; j < input.size(); ++j) {
+    input[j] = 0.5 * std::sin(2 * M_PI * 440 * (j % insize) / samplerate) +
+        0.01 * (j % 17) / 17.0;
+  }
+  auto inArray = Tensor::fromVector({insize, batchSz}, input);
+
+  for (auto featureType :
+       {FeatureType::POW_SPECTRUM, FeatureType::MFSC, FeatureType::MFCC}) {
+    for (bool rawEnergy : {true, false}) {
+      FeatureParams featParams(samplerate);
+      featParams.rawEnergy = rawEnergy;
+      std::shared_ptr<PowerSpectrum> cpuFeaturizer;
+      if (featureType == FeatureType::POW_SPECTRUM) {
+        cpuFeaturizer = std::make_shared<PowerSpectrum>(featParams);
+      } else if (featureType == FeatureType::MFSC) {
+        cpuFeaturizer = std::make_shared<Mfsc>(featParams);
+      } else {
+        cpuFeaturizer = std::make_shared<Mfcc>(featParams);
+      }
+      // FEAT X FRAMES X B (Col Major)
+      auto expected = cpuFeaturizer->batchApply(input, batchSz);
+
+      DeviceFeaturizer featurizer(featParams, featureType);
+      auto feat = featurizer.apply(inArray);
+      ASSERT_EQ(
+          feat.shape(),
+          Shape(
+              {featurizer.featureSize(),
+               featParams.numFrames(insize),
+               batchSz}));
+      auto featVec = feat.toHostVector<float>();
+      ASSERT_EQ(featVec.size(), expected.size());
+      // single precision DFT of the device against double precision FFTW
+      float maxAbs = 0;
+      for (auto e : expected) {
+        maxAbs = std::max(maxAbs, std::abs(e));
+      }
+      for (int i = 0; i < expected.size(); ++i) {
+        ASSERT_NEAR(
+            featVec[i],
+            expected[i],
+            1E-3 * std::max(1.0f, std::abs(expected[i])) + 1E-5 * maxAbs);
+      }
+    }
+  }
+}
+
 TEST(FeaturizationTest, targetFeaturizer) {
   using fl::pkg::speech::kEosToken;
 
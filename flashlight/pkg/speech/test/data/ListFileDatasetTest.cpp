@@ -8,6 +8,7 @@
 #include <cstddef>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include <gtest/gtest.h>
@@ -15,7 +16,9 @@
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/fl/tensor/Init.h"
 #include "flashlight/lib/text/String.h"
+#include "flashlight/pkg/speech/data/FeatureStore.h"
 #include "flashlight/pkg/speech/data/ListFileDataset.h"
+#include "flashlight/pkg/speech/data/ListFileIndex.h"
 
 using namespace fl::lib;
 using namespace fl::pkg::speech;
@@ -34,13 +37,12 @@ auto letterToTarget = [](void* data, Shape dims, fl::dtype /* unused */) {
   }
   return Tensor::fromVector(tgt);
 };
-} // namespace
 
-TEST(ListFileDatasetTest, LoadData) {
+// Writes the test list, with the paths of the test data
+fs::path writeDataList() {
   const fs::path dataPath = loadPath / "data.lst";
   if (!fs::exists(dataPath)) {
-    throw std::runtime_error(
-        "ListFileDatasetTest, LoadData - can't open test data.lst");
+    throw std::runtime_error("ListFileDatasetTest - can't open test data.lst");
   }
   std::vector<std::string> data;
   {
@@ -57,7 +59,12 @@ TEST(ListFileDatasetTest, LoadData) {
     out << d;
     out << "\n";
   }
-  out.close();
+  return rootPath;
+}
+} // namespace
+
+TEST(ListFileDatasetTest, LoadData) {
+  const fs::path rootPath = writeDataList();
   ListFileDataset audiods(rootPath, nullptr, letterToTarget);
   ASSERT_EQ(audiods.size(), 3);
   std::vector<int> expectedTgtLen = {45, 23, 26};
@@ -77,6 +84,67 @@ TEST(ListFileDatasetTest, LoadData) {
   }
 }
 
+TEST(ListFileDatasetTest, FeatureStore) {
+  const fs::path rootPath = writeDataList();
+  ListFileDataset audiods(rootPath, nullptr, letterToTarget);
+  ASSERT_EQ(audiods.size(), 3);
+
+  const fs::path storePath = fs::temp_directory_path() / "feature_store";
+  {
+    // one sample per chunk, without the last sample
+    FeatureStoreWriter writer(storePath, 1);
+    for (int i = 0; i < 2; ++i) {
+      auto sample = audiods.get(i);
+      auto idVec = sample[3].toHostVector<char>();
+      writer.add(std::string(idVec.begin(), idVec.end()), sample[0]);
+    }
+  }
+  auto store = std::make_shared<FeatureStore>(storePath);
+  ASSERT_EQ(store->size(), 2);
+
+  ListFileDataset storeds(rootPath, nullptr, letterToTarget);
+  storeds.setFeatureStore(store);
+  for (int i = 0; i < 3; ++i) {
+    auto expected = audiods.get(i);
+    auto sample = storeds.get(i);
+    ASSERT_EQ(sample.size(), 7);
+    ASSERT_EQ(sample[0].shape(), expected[0].shape());
+    ASSERT_EQ(sample[0].type(), fl::dtype::f32);
+    // stored in half precision, or loaded from audio
+    const float precision = i < 2 ? 1E-3 : 0;
+    ASSERT_LE(
+        fl::amax(fl::abs(sample[0] - expected[0])).scalar<float>(), precision);
+    ASSERT_EQ(sample[1].elements(), expected[1].elements());
+  }
+  fs::remove_all(storePath);
+}
+
+TEST(ListFileDatasetTest, CompiledIndex) {
+  const fs::path rootPath = writeDataList();
+  const fs::path indexPath = fs::temp_directory_path() / "data.lstidx";
+  ASSERT_EQ(ListFileIndex::compile(rootPath, indexPath), 3);
+  ASSERT_TRUE(ListFileIndex::isListFileIndex(indexPath));
+  ASSERT_FALSE(ListFileIndex::isListFileIndex(rootPath));
+
+  ListFileDataset listds(rootPath, nullptr, letterToTarget);
+  ListFileDataset indexds(indexPath, nullptr, letterToTarget);
+  ASSERT_EQ(indexds.size(), listds.size());
+  for (int i = 0; i < listds.size(); ++i) {
+    ASSERT_EQ(indexds.getInputSize(i), listds.getInputSize(i));
+    ASSERT_EQ(indexds.getTargetSize(i), listds.getTargetSize(i));
+    auto expected = listds.get(i);
+    auto sample = indexds.get(i);
+    ASSERT_EQ(sample.size(), expected.size());
+    for (int j = 0; j < sample.size(); ++j) {
+      ASSERT_EQ(sample[j].shape(), expected[j].shape());
+      if (!expected[j].isEmpty()) {
+        ASSERT_TRUE(fl::all(sample[j] == expected[j]).scalar<bool>());
+      }
+    }
+  }
+  fs::remove(indexPath);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
@@ -7,9 +7,12 @@
 
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <fstream>
 #include <functional>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
 
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/fl/tensor/Init.h"
@@ -158,6 +161,52 @@ TEST(SoundTest, StreamReadWrite) {
   }
 }
 
+TEST(SoundTest, PartialRead) {
+  auto audiopath = loadPath / "test_stereo.wav";
+  auto info = loadSoundInfo(audiopath);
+  auto vecFloat = loadSound<float>(audiopath);
+
+  const int64_t offset = 1000, numFrames = 2500;
+  auto partial = loadSound<float>(audiopath, offset, numFrames);
+  ASSERT_EQ(partial.size(), numFrames * info.channels);
+  for (int64_t i = 0; i < partial.size(); ++i) {
+    ASSERT_EQ(partial[i], vecFloat[offset * info.channels + i]);
+  }
+
+  // reads to the end of the file
+  auto tail = loadSound<float>(audiopath, info.frames - 10, -1);
+  ASSERT_EQ(tail.size(), 10 * info.channels);
+  ASSERT_EQ(tail.back(), vecFloat.back());
+  ASSERT_EQ(
+      loadSound<float>(audiopath, info.frames - 10, 100).size(),
+      10 * info.channels);
+  ASSERT_THROW(
+      loadSound<float>(audiopath, info.frames + 1, 1), std::out_of_range);
+}
+
+TEST(SoundTest, StreamingReader) {
+  auto audiopath = loadPath / "test_stereo.wav";
+  auto vecShort = loadSound<short>(audiopath);
+
+  SoundReader<short> reader(audiopath);
+  ASSERT_EQ(reader.info().channels, 2);
+  const int64_t chunkFrames = 1000;
+  std::vector<short> chunk, streamed;
+  while (reader.read(chunkFrames, chunk)) {
+    ASSERT_LE(chunk.size(), chunkFrames * reader.info().channels);
+    streamed.insert(streamed.end(), chunk.begin(), chunk.end());
+  }
+  ASSERT_TRUE(chunk.empty());
+  ASSERT_EQ(reader.position(), reader.info().frames);
+  ASSERT_EQ(streamed, vecShort);
+
+  reader.seek(10);
+  auto frames = reader.read(5);
+  ASSERT_EQ(frames.size(), 5 * reader.info().channels);
+  ASSERT_TRUE(std::equal(frames.begin(), frames.end(), vecShort.begin() + 20));
+  ASSERT_EQ(reader.position(), 15);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
@@ -5,15 +5,21 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <cmath>
+#include <future>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "flashlight/fl/flashlight.h"
 
 #include "flashlight/fl/common/Filesystem.h"
 #include "flashlight/pkg/runtime/common/SequentialBuilder.h"
+#include "flashlight/pkg/speech/decoder/ConvLmModule.h"
 
 using namespace fl;
 using namespace fl::pkg::runtime;
+using namespace fl::pkg::speech;
 
 namespace {
 
@@ -66,6 +72,102 @@ TEST(ConvLmModuleTest, GCNN14BCrossEntropy) {
   ASSERT_EQ(output.shape(), Shape({nclass, inputlength, batchsize}));
 }
 
+TEST(ConvLmModuleTest, CachedBatchedScores) {
+  const fs::path archfile = archDir / "gcnn_14B_lm_arch_ce.txt";
+  int nclass = 30;
+  int batchsize = 3;
+  int inputlength = 8;
+
+  std::shared_ptr<fl::Module> model =
+      buildSequentialModule(archfile, 1, nclass);
+  model->eval();
+  std::vector<int> inputs(inputlength * batchsize);
+  for (int i = 0; i < inputs.size(); ++i) {
+    inputs[i] = (7 * i) % nclass;
+  }
+  std::vector<int> positions = {7, 2, 5};
+  auto expected = buildGetConvLmScoreFunction(model)(
+      inputs, positions, inputlength, batchsize);
+  ASSERT_EQ(expected.size(), nclass * batchsize);
+
+  ConvLmScoreOptions options;
+  options.cacheSize = 100;
+  options.maxBatchSize = 4;
+  options.maxWaitUs = 1000;
+  auto scoreFunc = buildGetConvLmScoreFunction(model, options);
+  // concurrent calls are batched, and then their prefixes are cached, such
+  // that the tokens after the last ones are ignored
+  std::vector<std::future<std::vector<float>>> futures;
+  for (int i = 0; i < 4; ++i) {
+    futures.push_back(std::async(std::launch::async, [&]() {
+      return scoreFunc(inputs, positions, inputlength, batchsize);
+    }));
+  }
+  for (auto& future : futures) {
+    auto scores = future.get();
+    ASSERT_EQ(scores.size(), expected.size());
+    for (int i = 0; i < scores.size(); ++i) {
+      ASSERT_NEAR(scores[i], expected[i], 1e-4);
+    }
+  }
+  auto changedInputs = inputs;
+  changedInputs[inputlength + positions[1] + 1] = 0;
+  auto cached = scoreFunc(changedInputs, positions, inputlength, batchsize);
+  for (int i = 0; i < cached.size(); ++i) {
+    ASSERT_NEAR(cached[i], expected[i], 1e-4);
+  }
+}
+
+TEST(ConvLmModuleTest, QuantizedScores) {
+  if (!FL_BACKEND_CPU) {
+    GTEST_SKIP() << "int8 inference is only supported on CPU";
+  }
+  const fs::path path = fs::temp_directory_path() / "quantized_convlm.mdl";
+  const fs::path archfile = archDir / "gcnn_14B_lm_arch_ce.txt";
+  int nclass = 30;
+  int batchsize = 3;
+  int inputlength = 8;
+
+  std::shared_ptr<fl::Module> model =
+      buildSequentialModule(archfile, 1, nclass);
+  model->eval();
+  std::vector<int> inputs(inputlength * batchsize);
+  std::vector<std::vector<int>> sequences(batchsize);
+  for (int i = 0; i < inputs.size(); ++i) {
+    inputs[i] = (7 * i) % nclass;
+    sequences[i / inputlength].push_back(inputs[i]);
+  }
+  std::vector<int> positions = {7, 2, 5};
+  auto expected = buildGetConvLmScoreFunction(model)(
+      inputs, positions, inputlength, batchsize);
+
+  // quantizes a copy of the model
+  save(path, model);
+  std::shared_ptr<fl::Module> quantized;
+  load(path, quantized);
+  ASSERT_THROW(quantizeConvLm(*quantized, {}), std::invalid_argument);
+  quantizeConvLm(*quantized, sequences);
+  ASSERT_NE(
+      quantized->prettyString().find("QuantizedAsymmetricConv1D"),
+      std::string::npos);
+  ASSERT_NE(
+      quantized->prettyString().find("QuantizedLinear"), std::string::npos);
+
+  // the quantized model is serialized and scored as the original one
+  save(path, quantized);
+  std::shared_ptr<fl::Module> loaded;
+  load(path, loaded);
+  auto scores = buildGetConvLmScoreFunction(loaded)(
+      inputs, positions, inputlength, batchsize);
+  ASSERT_EQ(scores.size(), expected.size());
+  double error = 0, magnitude = 0;
+  for (int i = 0; i < scores.size(); ++i) {
+    error += std::abs(scores[i] - expected[i]);
+    magnitude += std::abs(expected[i]);
+  }
+  ASSERT_LT(error, 5e-2 * magnitude);
+}
+
 TEST(ConvLmModuleTest, SerializationGCNN14BAdaptiveSoftmax) {
   char* user = getenv("USER");
   std::string userstr = "unknown";
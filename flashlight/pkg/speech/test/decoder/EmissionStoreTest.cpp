@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Random.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/pkg/speech/decoder/EmissionStore.h"
+
+using namespace fl;
+using namespace fl::pkg::speech;
+
+namespace {
+
+fs::path createStoreDir(const std::string& name) {
+  const auto dir = fs::temp_directory_path() / name;
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  return dir;
+}
+
+} // namespace
+
+TEST(EmissionStoreTest, WriteAndRead) {
+  const auto dir = createStoreDir("EmissionStoreTest.WriteAndRead");
+  ASSERT_FALSE(EmissionStore::isEmissionStore(dir));
+
+  // a few emissions per shard, with more than the copies in flight
+  std::vector<std::string> ids;
+  std::vector<Tensor> emissions;
+  for (int shard = 0; shard < 2; ++shard) {
+    EmissionStoreWriter writer(dir, shard, /* fp16 = */ false, 2);
+    for (int i = 0; i < 5; ++i) {
+      ids.push_back(
+          "sample_" + std::to_string(shard) + "_" + std::to_string(i));
+      emissions.push_back(fl::rand({7, 3 + i}));
+      writer.add(ids.back(), emissions.back());
+    }
+    // with a trailing singleton dimension, as a batch of one
+    ids.push_back("sample_" + std::to_string(shard) + "_batch");
+    emissions.push_back(fl::rand({7, 4, 1}));
+    writer.add(ids.back(), emissions.back());
+    ASSERT_THROW(writer.add("invalid", fl::rand({7, 4, 2})), std::exception);
+  }
+
+  ASSERT_TRUE(EmissionStore::isEmissionStore(dir));
+  EmissionStore store(dir);
+  ASSERT_EQ(store.size(), ids.size());
+  ASSERT_FALSE(store.contains("invalid"));
+  ASSERT_THROW(store.get("invalid"), std::out_of_range);
+  for (int i = 0; i < ids.size(); ++i) {
+    ASSERT_TRUE(store.contains(ids[i]));
+    auto unit = store.get(ids[i]);
+    ASSERT_EQ(unit.sampleId, ids[i]);
+    ASSERT_EQ(unit.nTokens, emissions[i].dim(0));
+    ASSERT_EQ(unit.nFrames, emissions[i].dim(1));
+    ASSERT_EQ(unit.emission, emissions[i].toHostVector<float>());
+  }
+  fs::remove_all(dir);
+}
+
+TEST(EmissionStoreTest, Half) {
+  const auto dir = createStoreDir("EmissionStoreTest.Half");
+  auto emission = fl::rand({5, 6}) * 20 - 10;
+  {
+    EmissionStoreWriter writer(dir, 0, /* fp16 = */ true);
+    writer.add("sample", emission);
+  }
+  EmissionStore store(dir);
+  auto unit = store.get("sample");
+  auto expected = emission.astype(fl::dtype::f16)
+                      .astype(fl::dtype::f32)
+                      .toHostVector<float>();
+  ASSERT_EQ(unit.emission, expected);
+  fs::remove_all(dir);
+}
+
+TEST(EmissionStoreTest, UnfinishedShard) {
+  const auto dir = createStoreDir("EmissionStoreTest.UnfinishedShard");
+  {
+    EmissionStoreWriter writer(dir, 0);
+    writer.add("complete", fl::rand({3, 4}));
+  }
+  // a record cut short, as by a writer which didn't finish
+  {
+    std::ofstream index(
+        dir / "emissions.0.idx", std::ios::binary | std::ios::app);
+    const char partial[6] = {};
+    index.write(partial, sizeof(partial));
+  }
+  EmissionStore store(dir);
+  ASSERT_EQ(store.size(), 1);
+  ASSERT_TRUE(store.contains("complete"));
+  fs::remove_all(dir);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
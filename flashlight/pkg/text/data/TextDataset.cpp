@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <queue>
 #include <utility>
 
 #include "flashlight/lib/text/String.h"
@@ -72,13 +73,77 @@ TextDataset::TextDataset(
     }
   }
   const int64_t nTokens = data_.size();
+  batchify(
+      0,
+      nTokens,
+      sentenceRanges,
+      tokensPerSample,
+      batchSize,
+      sampleBreakMode,
+      useDynamicBatching);
 
-  /* 2. Batchify */
-  if (batchSize <= 0) {
+  FL_LOG(LogLevel::INFO) << "[TextDataset] (" << reader.getRank() << "/"
+                         << reader.getTotalReaders() << ") Loaded " << nTokens
+                         << " tokens, " << sentenceRanges.size()
+                         << " sentences and " << size() << " batches";
+}
+
+TextDataset::TextDataset(
+    const fs::path& corpusPath,
+    int64_t worldRank,
+    int64_t worldSize,
+    const Dictionary& dictionary,
+    int64_t tokensPerSample /* = 1024 */,
+    int64_t batchSize /* = 1 */,
+    const std::string& sampleBreakMode /* = "none" */,
+    const bool useDynamicBatching /* = false */)
+    : pad_(dictionary.getIndex(fl::lib::text::kPadToken)),
+      corpus_(std::make_shared<TokenCorpus>(corpusPath)) {
+  if (corpus_->dictionarySize() != dictionary.entrySize()) {
     throw std::invalid_argument(
-        "[TextDataset] BatchSize needs to be positive.");
+        "[TextDataset] the corpus " + corpusPath.string() +
+        " was compiled with a dictionary of " +
+        std::to_string(corpus_->dictionarySize()) + " entries, not " +
+        std::to_string(dictionary.entrySize()));
+  }
+  if (worldRank < 0 || worldRank >= worldSize) {
+    throw std::invalid_argument("[TextDataset] invalid rank.");
   }
+  const int64_t nSentences = corpus_->numSentences();
+  const int64_t firstSentence = nSentences * worldRank / worldSize;
+  const int64_t endSentence = nSentences * (worldRank + 1) / worldSize;
+  std::vector<std::pair<int64_t, int64_t>> sentenceRanges;
+  sentenceRanges.reserve(endSentence - firstSentence);
+  for (int64_t i = firstSentence; i < endSentence; ++i) {
+    sentenceRanges.emplace_back(
+        corpus_->sentenceOffset(i), corpus_->sentenceOffset(i + 1));
+  }
+  const int64_t firstToken = corpus_->sentenceOffset(firstSentence);
+  const int64_t endToken = corpus_->sentenceOffset(endSentence) + 1;
+  batchify(
+      firstToken,
+      endToken,
+      sentenceRanges,
+      tokensPerSample,
+      batchSize,
+      sampleBreakMode,
+      useDynamicBatching);
+
+  FL_LOG(LogLevel::INFO) << "[TextDataset] (" << worldRank << "/" << worldSize
+                         << ") Mapped " << endToken - firstToken
+                         << " tokens, " << sentenceRanges.size()
+                         << " sentences and " << size() << " batches";
+}
 
+void TextDataset::batchify(
+    int64_t firstToken,
+    int64_t endToken,
+    std::vector<std::pair<int64_t, int64_t>>& sentenceRanges,
+    int64_t tokensPerSample,
+    int64_t batchSize,
+    const std::string& sampleBreakMode,
+    bool useDynamicBatching) {
+  const int64_t nTokens = endToken - firstToken;
   if (sampleBreakMode == "none") {
     // Sentences are split into equal size (=`tokensPerSample`)
     // Total tokens per batch is `batchSize` * `tokensPerSample`
@@ -90,9 +155,10 @@ TextDataset::TextDataset(
       const int64_t lastSample = std::min((b + 1) * batchSize, nSamples);
       std::vector<SamplePosition> batch;
       for (int64_t s = firstSample; s < lastSample; ++s) {
-        const int64_t firstToken = s * tokensPerSample;
-        const int64_t lastToken = std::min((s + 1) * tokensPerSample, nTokens);
-        batch.emplace_back(SamplePosition{firstToken, lastToken - 1});
+        const int64_t first = firstToken + s * tokensPerSample;
+        const int64_t last =
+            firstToken + std::min((s + 1) * tokensPerSample, nTokens);
+        batch.emplace_back(SamplePosition{first, last - 1});
       }
       batches_.push_back(std::move(batch));
     }
@@ -102,8 +168,10 @@ TextDataset::TextDataset(
     // Total tokens per batch <= `batchSize` * `tokensPerSample`
 
     if (useDynamicBatching) {
-      // sorting samples by length in ascending order
-      std::sort(
+      // sorting samples by length in ascending order, such that each batch
+      // is a bucket of sentences of similar length. A stable sort, such that
+      // the batches are the same on every run.
+      std::stable_sort(
           sentenceRanges.begin(),
           sentenceRanges.end(),
           [](const std::pair<int64_t, int64_t>& p1,
@@ -116,12 +184,17 @@ TextDataset::TextDataset(
     for (int64_t i = 0; i < sentenceRanges.size(); ++i) {
       const auto startPoint = sentenceRanges[i].first;
       const auto endPoint = sentenceRanges[i].second;
-      const int64_t sampleSize = endPoint - startPoint + 1;
       batch.emplace_back(SamplePosition{startPoint, endPoint});
 
       bool isFull;
       if (useDynamicBatching) {
-        isFull = sampleSize * (batch.size() + 1) > batchSize * tokensPerSample;
+        // the batch is full if it can't take the next, longest, sentence
+        // within the budget of `batchSize` * `tokensPerSample` tokens,
+        // padding included
+        const int64_t nextSize = i + 1 < sentenceRanges.size()
+            ? sentenceRanges[i + 1].second - sentenceRanges[i + 1].first + 1
+            : 0;
+        isFull = nextSize * (batch.size() + 1) > batchSize * tokensPerSample;
       } else {
         isFull = batch.size() == batchSize;
       }
@@ -133,16 +206,32 @@ TextDataset::TextDataset(
     if (!batch.empty()) {
       batches_.push_back(std::move(batch));
     }
+  } else if (sampleBreakMode == "stream") {
+    // Tokens are split into `batchSize` contiguous streams, and the b-th
+    // batch holds the b-th `tokensPerSample` tokens of each of them, such that
+    // a stream is continued by the same sample of the next batch. The streams
+    // which end early are left empty, i.e. padded, in the last batches.
+    const int64_t streamLength = (nTokens + batchSize - 1) / batchSize;
+    const int64_t nBatches =
+        (streamLength + tokensPerSample - 1) / tokensPerSample;
+    for (int64_t b = 0; b < nBatches; ++b) {
+      std::vector<SamplePosition> batch;
+      for (int64_t s = 0; s < batchSize; ++s) {
+        const int64_t streamEnd = std::min((s + 1) * streamLength, nTokens);
+        const int64_t first =
+            std::min(s * streamLength + b * tokensPerSample, streamEnd);
+        const int64_t last = std::min(first + tokensPerSample, streamEnd);
+        batch.emplace_back(
+            SamplePosition{firstToken + first, firstToken + last - 1});
+      }
+      batches_.push_back(std::move(batch));
+    }
   } else {
     throw std::invalid_argument(
-        "Invalid sampleBreakMode: should be none or eos, but it is given " +
+        "Invalid sampleBreakMode: should be none, eos or stream, but it is "
+        "given " +
         sampleBreakMode);
   }
-
-  FL_LOG(LogLevel::INFO) << "[TextDataset] (" << reader.getRank() << "/"
-                         << reader.getTotalReaders() << ") Loaded " << nTokens
-                         << " tokens, " << sentenceRanges.size()
-                         << " sentences and " << size() << " batches";
 }
 
 int64_t TextDataset::size() const {
@@ -155,16 +244,85 @@ std::vector<Tensor> TextDataset::get(const int64_t idx) const {
   for (const auto& pos : batch) {
     maxLength = std::max<int64_t>(maxLength, pos.last - pos.first + 1);
   }
+  // samples of equal length which follow each other
+  bool isContiguous = true;
+  for (int64_t i = 0; i < batch.size(); ++i) {
+    isContiguous = isContiguous &&
+        batch[i].first == batch[0].first + i * maxLength &&
+        batch[i].last == batch[i].first + maxLength - 1;
+  }
+  const Shape shape({maxLength, static_cast<long long>(batch.size())});
+  if (corpus_ && isContiguous) {
+    // the samples are a slice of the mapped tokens, e.g. with "none" mode
+    const auto type = corpus_->tokenBytes() == 2 ? dtype::u16 : dtype::u32;
+    const auto* tokens = static_cast<const uint8_t*>(corpus_->tokens()) +
+        corpus_->tokenBytes() * batch[0].first;
+    return {Tensor::fromBuffer(shape, type, tokens, Location::Host)
+                .astype(dtype::s32)};
+  }
   std::vector<int> buffer(batch.size() * maxLength, pad_);
   for (int64_t i = 0; i < batch.size(); ++i) {
     const auto& pos = batch[i];
-    std::memcpy(
-        buffer.data() + i * maxLength,
-        data_.data() + pos.first,
-        sizeof(int) * (pos.last - pos.first + 1));
+    const int64_t length = pos.last - pos.first + 1;
+    if (corpus_) {
+      corpus_->copyTokens(pos.first, length, buffer.data() + i * maxLength);
+    } else {
+      std::memcpy(
+          buffer.data() + i * maxLength,
+          data_.data() + pos.first,
+          sizeof(int) * length);
+    }
+  }
+  return {Tensor::fromVector(shape, buffer)};
+}
+
+fl::PackedBatch TextDataset::getPacked(const int64_t idx) const {
+  const auto& batch = batches_[idx % size()];
+  fl::PackedBatch packed;
+  packed.offsets.reserve(batch.size() + 1);
+  packed.offsets.push_back(0);
+  for (const auto& pos : batch) {
+    packed.offsets.push_back(packed.offsets.back() + pos.last - pos.first + 1);
+  }
+  std::vector<int> buffer(packed.offsets.back());
+  for (int64_t i = 0; i < batch.size(); ++i) {
+    const int64_t first = batch[i].first;
+    const int64_t length = packed.offsets[i + 1] - packed.offsets[i];
+    int* dst = buffer.data() + packed.offsets[i];
+    if (corpus_) {
+      corpus_->copyTokens(first, length, dst);
+    } else {
+      std::memcpy(dst, data_.data() + first, sizeof(int) * length);
+    }
+  }
+  packed.data = Tensor::fromVector({packed.offsets.back(), 1}, buffer);
+  return packed;
+}
+
+void TextDataset::balanceBatches(int64_t numBatches) {
+  if (batches_.empty() || numBatches <= size()) {
+    return;
+  }
+  // the batches with the most samples first
+  std::priority_queue<std::pair<size_t, int64_t>> largest;
+  for (int64_t i = 0; i < size(); ++i) {
+    largest.emplace(batches_[i].size(), i);
+  }
+  while (size() < numBatches && largest.top().first > 1) {
+    const int64_t idx = largest.top().second;
+    largest.pop();
+    auto& batch = batches_[idx];
+    const auto half = batch.begin() + batch.size() / 2;
+    std::vector<SamplePosition> tail(half, batch.end());
+    batch.erase(half, batch.end());
+    batches_.push_back(std::move(tail));
+    largest.emplace(batch.size(), idx);
+    largest.emplace(batches_.back().size(), size() - 1);
+  }
+  // batches of single samples are repeated
+  for (int64_t i = 0; size() < numBatches; ++i) {
+    batches_.push_back(batches_[i]);
   }
-  return {Tensor::fromVector(
-      {maxLength, static_cast<long long>(batch.size())}, buffer)};
 }
 
 void TextDataset::shuffle(uint64_t seed) {
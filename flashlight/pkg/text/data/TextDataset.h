@@ -7,7 +7,9 @@
 
 #pragma once
 
+#include <memory>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "flashlight/fl/common/Filesystem.h"
@@ -15,6 +17,7 @@
 #include "flashlight/lib/text/dictionary/Dictionary.h"
 #include "flashlight/lib/text/tokenizer/PartialFileReader.h"
 #include "flashlight/lib/text/tokenizer/Tokenizer.h"
+#include "flashlight/pkg/text/data/TokenCorpus.h"
 
 namespace fl {
 namespace pkg {
@@ -51,11 +54,22 @@ constexpr size_t kMaxTokenInBuffer = 10000000000;
  * - "eos": Each sentence is a sample padded with <eos> on both ends.
  *          Sentences with length > `tokensPerSample` are skipped;
  *          Total tokens per batch <= `batchSize` * `tokensPerSample`
+ * - "stream": Split tokens into `batchSize` contiguous streams, regardless of
+ *             <eos>, such that each sample continues the same sample of the
+ *             previous batch, e.g. to evaluate with the context of the
+ *             previous batches. Streams which end early are padded with <pad>.
  * @param useDynamicBatching Use dynamic batching when `sampleBreakMode`="eos".
- * In this case, `batchsize` is ignored and as many sentences as possible are
- * included in each batch. All samples are padded with token <pad> to the length
- * of the longest one in a certain batch. To better fit more samples in each
- * batch, samples are sorted by length.
+ * In this case, batches are formed by a budget of `batchSize` *
+ * `tokensPerSample` tokens instead of a number of sentences, and as many
+ * sentences as possible are included in each batch. All samples are padded
+ * with token <pad> to the length of the longest one in a certain batch, which
+ * is counted in the budget. To better fit more samples in each batch, samples
+ * are sorted by length, such that each batch is a bucket of sentences of
+ * similar length.
+ *
+ * A dataset may also be constructed from a `TokenCorpus` compiled from the
+ * files beforehand, which is memory-mapped rather than tokenized on every
+ * rank, and whose samples are copied from the mapped tokens.
  */
 
 class TextDataset : public fl::Dataset {
@@ -72,12 +86,57 @@ class TextDataset : public fl::Dataset {
       const bool useDynamicBatching = false,
       const size_t reserveSpaceSize = kMaxTokenInBuffer);
 
+  /**
+   * Constructs a dataset from a compiled `TokenCorpus`. The sentences of the
+   * corpus are split into `worldSize` contiguous shards, as the lines of each
+   * file with `PartialFileReader`, of which the dataset reads the
+   * `worldRank`-th one.
+   *
+   * @param corpusPath The corpus file, see `TokenCorpus::isTokenCorpus`
+   * @param worldRank The shard of the corpus to read
+   * @param worldSize The number of shards of the corpus
+   * @param dictionary The dictionary the corpus was compiled with
+   *
+   * The other parameters are those of the constructor from text files.
+   */
+  TextDataset(
+      const fs::path& corpusPath,
+      int64_t worldRank,
+      int64_t worldSize,
+      const fl::lib::text::Dictionary& dictionary,
+      int64_t tokensPerSample = 1024,
+      int64_t batchSize = 1,
+      const std::string& sampleBreakMode = "none",
+      const bool useDynamicBatching = false);
+
   int64_t size() const override;
 
   std::vector<Tensor> get(const int64_t idx) const override;
 
+  /**
+   * Returns the samples of a batch packed without padding, i.e. concatenated
+   * into a tensor of size T x 1, where T is the total number of their tokens,
+   * along with the offset of each sample, e.g. for the block-diagonal
+   * attention of `fl::Transformer::forwardPacked`. With dynamic batching,
+   * where the samples of a batch are padded to the longest one, this saves
+   * the padded tokens.
+   */
+  fl::PackedBatch getPacked(const int64_t idx) const;
+
   void shuffle(uint64_t seed);
 
+  /**
+   * Splits the batches with the most samples in halves until the dataset has
+   * `numBatches` batches, or repeats batches if they all have a single sample.
+   * E.g. with dynamic batching, the ranks of a distributed training form
+   * different numbers of batches of their data; balancing them to the largest
+   * number, e.g. with `fl::allGather`, makes every rank run an epoch in the
+   * same number of steps. Does nothing if the dataset has as many batches.
+   *
+   * @param numBatches The number of batches of the dataset
+   */
+  void balanceBatches(int64_t numBatches);
+
  private:
   int pad_;
 
@@ -86,7 +145,19 @@ class TextDataset : public fl::Dataset {
     int64_t last;
   };
 
+  // Forms the batches of the tokens [firstToken, endToken), given the
+  // positions of the <eos> tokens around each sentence
+  void batchify(
+      int64_t firstToken,
+      int64_t endToken,
+      std::vector<std::pair<int64_t, int64_t>>& sentenceRanges,
+      int64_t tokensPerSample,
+      int64_t batchSize,
+      const std::string& sampleBreakMode,
+      bool useDynamicBatching);
+
   std::vector<int> data_; // eos prepended, so all indices shifted by 1
+  std::shared_ptr<TokenCorpus> corpus_; // replaces data_ if mapped
   std::vector<std::vector<SamplePosition>> batches_;
 };
 
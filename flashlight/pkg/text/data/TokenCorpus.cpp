@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/text/data/TokenCorpus.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/lib/text/String.h"
+#include "flashlight/lib/text/dictionary/Defines.h"
+#include "flashlight/lib/text/tokenizer/PartialFileReader.h"
+
+using fl::lib::text::Dictionary;
+using fl::lib::text::PartialFileReader;
+using fl::lib::text::Tokenizer;
+
+namespace fl {
+namespace pkg {
+namespace text {
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'L', 'T', 'O', 'K', 'C', 'P', '1'};
+
+struct Header {
+  char magic[8];
+  uint64_t tokenBytes;
+  uint64_t dictionarySize;
+  uint64_t numTokens;
+  uint64_t numSentences;
+};
+
+int64_t tokensBytes(const Header& header) {
+  // padded, such that the sentence offsets are aligned
+  return (header.tokenBytes * header.numTokens + 7) / 8 * 8;
+}
+
+int64_t corpusBytes(const Header& header) {
+  return sizeof(Header) + tokensBytes(header) +
+      sizeof(uint64_t) * (header.numSentences + 1);
+}
+
+// Buffers the tokens written to a corpus file
+template <typename T>
+class TokenWriter {
+ public:
+  explicit TokenWriter(std::ofstream& out) : out_(out) {
+    buffer_.reserve(kBufferSize);
+  }
+
+  void write(int token) {
+    buffer_.push_back(static_cast<T>(token));
+    if (buffer_.size() == kBufferSize) {
+      flush();
+    }
+  }
+
+  void flush() {
+    out_.write(
+        reinterpret_cast<const char*>(buffer_.data()),
+        sizeof(T) * buffer_.size());
+    buffer_.clear();
+  }
+
+ private:
+  static constexpr size_t kBufferSize = 1 << 20;
+  std::ofstream& out_;
+  std::vector<T> buffer_;
+};
+
+template <typename T>
+void compileTokens(
+    const std::string& dataDirectory,
+    const std::string& filenames,
+    const Tokenizer& tokenizer,
+    const Dictionary& dictionary,
+    std::ofstream& out,
+    std::vector<uint64_t>& sentenceOffsets) {
+  const auto eos = dictionary.getIndex(fl::lib::text::kEosToken);
+  TokenWriter<T> writer(out);
+  uint64_t numTokens = 0;
+  writer.write(eos);
+  sentenceOffsets.push_back(numTokens++);
+  for (const auto& file : lib::split(',', filenames)) {
+    PartialFileReader reader(0, 1);
+    reader.loadFile(fs::path(dataDirectory) / file);
+    while (reader.hasNextLine()) {
+      const auto tokens = tokenizer.tokenize(reader.getLine());
+      for (const auto index : dictionary.mapEntriesToIndices(tokens)) {
+        writer.write(index);
+      }
+      numTokens += tokens.size();
+      writer.write(eos);
+      sentenceOffsets.push_back(numTokens++);
+    }
+  }
+  writer.flush();
+}
+
+} // namespace
+
+TokenCorpus::TokenCorpus(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(
+        "TokenCorpus::TokenCorpus - could not open file " + path + ": " +
+        std::strerror(errno));
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error(
+        "TokenCorpus::TokenCorpus - could not stat file " + path);
+  }
+  mappedSize_ = st.st_size;
+  if (mappedSize_ < static_cast<int64_t>(sizeof(Header))) {
+    ::close(fd);
+    throw std::runtime_error(
+        "TokenCorpus::TokenCorpus - truncated corpus " + path);
+  }
+  // a shared mapping, whose pages are shared by the processes of a node
+  void* data = ::mmap(nullptr, mappedSize_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error(
+        "TokenCorpus::TokenCorpus - could not map file " + path + ": " +
+        std::strerror(errno));
+  }
+  data_ = static_cast<char*>(data);
+  // samples are contiguous ranges of tokens
+  ::madvise(data_, mappedSize_, MADV_WILLNEED);
+
+  Header header;
+  std::memcpy(&header, data_, sizeof(Header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      (header.tokenBytes != 2 && header.tokenBytes != 4) ||
+      corpusBytes(header) != mappedSize_) {
+    ::munmap(data_, mappedSize_);
+    throw std::runtime_error(
+        "TokenCorpus::TokenCorpus - invalid corpus " + path);
+  }
+  numTokens_ = header.numTokens;
+  numSentences_ = header.numSentences;
+  dictionarySize_ = header.dictionarySize;
+  tokenBytes_ = header.tokenBytes;
+  tokens_ = data_ + sizeof(Header);
+  sentenceOffsets_ = reinterpret_cast<const uint64_t*>(
+      data_ + sizeof(Header) + tokensBytes(header));
+}
+
+TokenCorpus::~TokenCorpus() {
+  if (data_) {
+    ::munmap(data_, mappedSize_);
+  }
+}
+
+int64_t TokenCorpus::numTokens() const {
+  return numTokens_;
+}
+
+int64_t TokenCorpus::numSentences() const {
+  return numSentences_;
+}
+
+int64_t TokenCorpus::dictionarySize() const {
+  return dictionarySize_;
+}
+
+int TokenCorpus::tokenBytes() const {
+  return tokenBytes_;
+}
+
+const void* TokenCorpus::tokens() const {
+  return tokens_;
+}
+
+int64_t TokenCorpus::sentenceOffset(int64_t sentence) const {
+  return sentenceOffsets_[sentence];
+}
+
+void TokenCorpus::copyTokens(int64_t first, int64_t count, int* dst) const {
+  if (tokenBytes_ == 2) {
+    const auto* src = static_cast<const uint16_t*>(tokens_) + first;
+    std::copy(src, src + count, dst);
+  } else {
+    const auto* src = static_cast<const uint32_t*>(tokens_) + first;
+    std::copy(src, src + count, dst);
+  }
+}
+
+bool TokenCorpus::isTokenCorpus(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  return file.read(magic, sizeof(magic)) &&
+      std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+int64_t TokenCorpus::compile(
+    const std::string& dataDirectory,
+    const std::string& filenames,
+    const Tokenizer& tokenizer,
+    const Dictionary& dictionary,
+    const std::string& corpusFile) {
+  std::ofstream out(corpusFile, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error(
+        "TokenCorpus::compile - unable to create file " + corpusFile);
+  }
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.dictionarySize = dictionary.entrySize();
+  header.tokenBytes =
+      header.dictionarySize <= std::numeric_limits<uint16_t>::max() + 1 ? 2
+                                                                        : 4;
+  // the header is rewritten once the tokens are counted
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  std::vector<uint64_t> sentenceOffsets;
+  if (header.tokenBytes == 2) {
+    compileTokens<uint16_t>(
+        dataDirectory, filenames, tokenizer, dictionary, out, sentenceOffsets);
+  } else {
+    compileTokens<uint32_t>(
+        dataDirectory, filenames, tokenizer, dictionary, out, sentenceOffsets);
+  }
+  header.numTokens = sentenceOffsets.back() + 1;
+  header.numSentences = sentenceOffsets.size() - 1;
+  const int64_t padding =
+      tokensBytes(header) - header.tokenBytes * header.numTokens;
+  out.write("\0\0\0\0\0\0\0", padding);
+  out.write(
+      reinterpret_cast<const char*>(sentenceOffsets.data()),
+      sizeof(uint64_t) * sentenceOffsets.size());
+  out.seekp(0);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (!out) {
+    throw std::runtime_error(
+        "TokenCorpus::compile - failed to write file " + corpusFile);
+  }
+  return header.numTokens;
+}
+
+} // namespace text
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "flashlight/lib/text/dictionary/Dictionary.h"
+#include "flashlight/lib/text/tokenizer/Tokenizer.h"
+
+namespace fl {
+namespace pkg {
+namespace text {
+
+/**
+ * A pre-tokenized text corpus, i.e. the token indices of its sentences given a
+ * `Dictionary`, which is memory-mapped instead of tokenized, such that a
+ * `TextDataset` of billions of tokens is constructed in milliseconds, and the
+ * pages of the corpus are shared by the processes that read it on a node, e.g.
+ * the ranks of a distributed training, instead of being copied into each of
+ * them.
+ *
+ * A corpus is compiled from text files once, with `TokenCorpus::compile`, e.g.
+ * with the `fl_lm_corpus_builder` tool, and a `TextDataset` given the corpus
+ * file instead of text files reads it.
+ *
+ * The tokens are laid out as in `TextDataset`, i.e. each sentence is
+ * surrounded by <eos> tokens: <eos> sentence <eos> sentence ... <eos>, and
+ * stored as uint16 if the dictionary has at most 65536 entries, or uint32.
+ *
+ * Layout, in native byte order:
+ *  header: magic (8 bytes), token bytes, dictionary size, tokens, sentences
+ *  (uint64 each)
+ *  tokens: (uint16 | uint32) x tokens, padded to 8 bytes
+ *  sentence offsets: uint64 x (sentences + 1), the position of the <eos> token
+ *  before each sentence, and of the last one
+ */
+class TokenCorpus {
+ public:
+  /**
+   * Maps a compiled corpus.
+   * @param[in] path The corpus file.
+   */
+  explicit TokenCorpus(const std::string& path);
+  ~TokenCorpus();
+
+  TokenCorpus(const TokenCorpus&) = delete;
+  TokenCorpus& operator=(const TokenCorpus&) = delete;
+
+  /**
+   * @return The number of tokens of the corpus, including <eos> tokens.
+   */
+  int64_t numTokens() const;
+
+  /**
+   * @return The number of sentences of the corpus.
+   */
+  int64_t numSentences() const;
+
+  /**
+   * @return The size of the dictionary the corpus was compiled with.
+   */
+  int64_t dictionarySize() const;
+
+  /**
+   * @return The size of a token, 2 or 4 bytes.
+   */
+  int tokenBytes() const;
+
+  /**
+   * @return The tokens of the corpus, of `tokenBytes` each, which are valid
+   * for the lifetime of the corpus.
+   */
+  const void* tokens() const;
+
+  /**
+   * @return The position of the <eos> token before a sentence, or after the
+   * last one for `sentence` = `numSentences()`.
+   */
+  int64_t sentenceOffset(int64_t sentence) const;
+
+  /**
+   * Copies tokens into a buffer of indices.
+   * @param[in] first The position of the first token.
+   * @param[in] count The number of tokens.
+   * @param[out] dst The buffer of `count` indices.
+   */
+  void copyTokens(int64_t first, int64_t count, int* dst) const;
+
+  /**
+   * @param[in] path A file name.
+   * @return True if the file is a compiled corpus, rather than text.
+   */
+  static bool isTokenCorpus(const std::string& path);
+
+  /**
+   * Compiles text files into a corpus.
+   * @param[in] dataDirectory A prefix for the files to read
+   * @param[in] filenames A comma separated list of text files
+   * @param[in] tokenizer A tokenizer to tokenize lines of sentences to tokens
+   * @param[in] dictionary A dictionary to map tokens to their indices
+   * @param[in] corpusFile The corpus file, which is truncated if it exists.
+   * @return The number of tokens of the corpus.
+   */
+  static int64_t compile(
+      const std::string& dataDirectory,
+      const std::string& filenames,
+      const fl::lib::text::Tokenizer& tokenizer,
+      const fl::lib::text::Dictionary& dictionary,
+      const std::string& corpusFile);
+
+ private:
+  char* data_{nullptr};
+  int64_t mappedSize_{0};
+  int64_t numTokens_{0};
+  int64_t numSentences_{0};
+  int64_t dictionarySize_{0};
+  int tokenBytes_{0};
+  const void* tokens_{nullptr};
+  const uint64_t* sentenceOffsets_{nullptr};
+};
+
+} // namespace text
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/text/data/TokenCounter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include "flashlight/fl/common/Filesystem.h"
+
+using fl::lib::text::Tokenizer;
+
+namespace fl {
+namespace pkg {
+namespace text {
+
+namespace {
+
+constexpr int64_t kReadBufferSize = 16 << 20; // 16 MB
+
+// Calls `fn` on each line of a file which starts in [begin, end)
+template <typename Fn>
+void forEachLine(const std::string& path, int64_t begin, int64_t end, Fn fn) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("countTokens - unable to open file " + path);
+  }
+  // a line which starts before the range belongs to the previous one
+  int64_t pos = begin;
+  if (begin > 0) {
+    in.seekg(begin - 1);
+    char c;
+    while (in.get(c) && c != '\n') {
+    }
+    if (!in) {
+      return;
+    }
+    pos = in.tellg();
+  }
+
+  std::vector<char> buffer(kReadBufferSize);
+  std::string partialLine;
+  int64_t lineStart = pos;
+  while (lineStart < end) {
+    in.read(buffer.data(), buffer.size());
+    const int64_t n = in.gcount();
+    if (n == 0) {
+      break;
+    }
+    const char* ptr = buffer.data();
+    const char* bufferEnd = ptr + n;
+    while (ptr < bufferEnd && lineStart < end) {
+      const auto* newline =
+          static_cast<const char*>(std::memchr(ptr, '\n', bufferEnd - ptr));
+      if (!newline) {
+        partialLine.append(ptr, bufferEnd);
+        break;
+      }
+      partialLine.append(ptr, newline);
+      fn(partialLine);
+      partialLine.clear();
+      lineStart = pos + (newline - buffer.data()) + 1;
+      ptr = newline + 1;
+    }
+    pos += n;
+  }
+  // the last line of the file may have no newline
+  if (!partialLine.empty() && lineStart < end) {
+    fn(partialLine);
+  }
+}
+
+} // namespace
+
+void TokenCounts::merge(const TokenCounts& other) {
+  for (const auto& [token, count] : other.counts) {
+    counts[token] += count;
+  }
+  numTokens += other.numTokens;
+  numSentences += other.numSentences;
+}
+
+void TokenCounts::save(const std::string& path) const {
+  std::ofstream out(path);
+  if (!out) {
+    throw std::runtime_error(
+        "TokenCounts::save - unable to create file " + path);
+  }
+  out << numTokens << " " << numSentences << "\n";
+  for (const auto& [token, count] : counts) {
+    out << token << " " << count << "\n";
+  }
+  if (!out) {
+    throw std::runtime_error(
+        "TokenCounts::save - failed to write file " + path);
+  }
+}
+
+TokenCounts TokenCounts::load(const std::string& path) {
+  std::ifstream in(path);
+  TokenCounts result;
+  if (!(in >> result.numTokens >> result.numSentences)) {
+    throw std::runtime_error("TokenCounts::load - invalid file " + path);
+  }
+  std::string token;
+  int64_t count;
+  while (in >> token >> count) {
+    result.counts[token] += count;
+  }
+  return result;
+}
+
+std::vector<std::pair<std::string, int64_t>> TokenCounts::prune(
+    int64_t maxSize,
+    int64_t minAppearance) const {
+  std::vector<std::pair<std::string, int64_t>> tokens;
+  for (const auto& tokenCount : counts) {
+    if (tokenCount.second >= minAppearance) {
+      tokens.push_back(tokenCount);
+    }
+  }
+  std::sort(tokens.begin(), tokens.end(), [](const auto& a, const auto& b) {
+    return a.second > b.second || (a.second == b.second && a.first < b.first);
+  });
+  if (maxSize > 0 && tokens.size() > maxSize) {
+    tokens.resize(maxSize);
+  }
+  return tokens;
+}
+
+TokenCounts countTokens(
+    const std::string& path,
+    const Tokenizer& tokenizer,
+    int64_t part /* = 0 */,
+    int64_t numParts /* = 1 */,
+    int numThreads /* = 1 */) {
+  if (part < 0 || part >= numParts || numThreads < 1) {
+    throw std::invalid_argument("countTokens - invalid part or threads");
+  }
+  const int64_t fileSize = fs::file_size(path);
+  const int64_t numRanges = numParts * numThreads;
+  std::vector<TokenCounts> threadCounts(numThreads);
+  std::vector<std::thread> threads;
+  std::vector<std::exception_ptr> errors(numThreads);
+  for (int t = 0; t < numThreads; ++t) {
+    const int64_t range = part * numThreads + t;
+    threads.emplace_back([&, t, range]() {
+      try {
+        forEachLine(
+            path,
+            fileSize * range / numRanges,
+            fileSize * (range + 1) / numRanges,
+            [&](const std::string& line) {
+              auto& result = threadCounts[t];
+              const auto tokens = tokenizer.tokenize(line);
+              for (const auto& token : tokens) {
+                ++result.counts[token];
+              }
+              result.numTokens += tokens.size();
+              ++result.numSentences;
+            });
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  for (int t = 1; t < numThreads; ++t) {
+    threadCounts[0].merge(threadCounts[t]);
+  }
+  return std::move(threadCounts[0]);
+}
+
+} // namespace text
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "flashlight/lib/text/tokenizer/Tokenizer.h"
+
+namespace fl {
+namespace pkg {
+namespace text {
+
+/**
+ * The counts of the tokens of text files, e.g. to build the dictionary of a
+ * language model. Counts of parts of the files, e.g. counted by different
+ * processes, are merged into the counts of the files.
+ */
+struct TokenCounts {
+  std::unordered_map<std::string, int64_t> counts;
+  int64_t numTokens{0};
+  int64_t numSentences{0};
+
+  /**
+   * Adds counts of other parts of the files.
+   */
+  void merge(const TokenCounts& other);
+
+  /**
+   * Saves the counts to a text file, which `load` reads, e.g. to merge the
+   * counts of several processes.
+   */
+  void save(const std::string& path) const;
+
+  static TokenCounts load(const std::string& path);
+
+  /**
+   * @param[in] maxSize The maximum number of tokens, or all if <= 0
+   * @param[in] minAppearance The minimum count of the tokens
+   * @return The most frequent tokens, with their counts, in decreasing order
+   * of counts and in lexicographic order for equal counts.
+   */
+  std::vector<std::pair<std::string, int64_t>> prune(
+      int64_t maxSize,
+      int64_t minAppearance) const;
+};
+
+/**
+ * Counts the tokens of a part of a text file. The file is split into
+ * `numParts` byte ranges, each holding the lines which start in it, and
+ * the `part`-th one is split again between `numThreads` threads, each
+ * counting into its own map, with large buffered reads.
+ *
+ * @param[in] path The text file, of one sentence per line
+ * @param[in] tokenizer A tokenizer to tokenize lines of sentences to tokens
+ * @param[in] part The part of the file to count, e.g. the rank of a process
+ * @param[in] numParts The number of parts of the file
+ * @param[in] numThreads The number of threads counting the part
+ * @return The counts of the tokens of the part
+ */
+TokenCounts countTokens(
+    const std::string& path,
+    const fl::lib::text::Tokenizer& tokenizer,
+    int64_t part = 0,
+    int64_t numParts = 1,
+    int numThreads = 1);
+
+} // namespace text
+} // namespace pkg
+} // namespace fl
@@ -12,6 +12,7 @@
 #include <gtest/gtest.h>
 
 #include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Init.h"
 #include "flashlight/lib/text/String.h"
 #include "flashlight/lib/text/dictionary/Defines.h"
@@ -19,6 +20,7 @@
 #include "flashlight/lib/text/tokenizer/PartialFileReader.h"
 #include "flashlight/lib/text/tokenizer/Tokenizer.h"
 #include "flashlight/pkg/text/data/TextDataset.h"
+#include "flashlight/pkg/text/data/TokenCorpus.h"
 
 using namespace fl::lib;
 using namespace fl::lib::text;
@@ -140,6 +142,190 @@ TEST(TextDatasetTest, EosModeWithDynamicBatching) {
   }
 }
 
+TEST(TextDatasetTest, PackedBatches) {
+  fl::lib::text::Tokenizer tokenizer;
+  fl::lib::text::PartialFileReader partialFileReader(
+      fl::getWorldRank(), fl::getWorldSize());
+  Dictionary dictionary = createDictionary(dataDir / "dictionary.txt");
+
+  TextDataset dataset(
+      dataDir,
+      "train.txt",
+      partialFileReader,
+      tokenizer,
+      dictionary,
+      15,
+      1,
+      "eos",
+      /* useDynamicBatching = */ true,
+      /* reserveSpaceSize = */ 0);
+
+  // the samples of a batch without their padding
+  for (int i = 0; i < dataset.size(); i++) {
+    auto padded = dataset.get(i)[0];
+    auto packed = dataset.getPacked(i);
+    ASSERT_EQ(packed.offsets.size(), padded.dim(1) + 1);
+    ASSERT_EQ(packed.data.shape(), fl::Shape({packed.offsets.back(), 1}));
+    for (int j = 0; j < padded.dim(1); j++) {
+      const auto sample = fl::range(packed.offsets[j], packed.offsets[j + 1]);
+      const int64_t length = packed.offsets[j + 1] - packed.offsets[j];
+      ASSERT_LE(length, padded.dim(0));
+      ASSERT_TRUE(fl::all(
+                      packed.data(sample, 0) ==
+                      padded(fl::range(0, length), j))
+                      .asScalar<bool>());
+    }
+  }
+}
+
+TEST(TextDatasetTest, StreamMode) {
+  fl::lib::text::Tokenizer tokenizer;
+  fl::lib::text::PartialFileReader partialFileReader(0, 1);
+  Dictionary dictionary = createDictionary(dataDir / "dictionary.txt");
+  const int pad = dictionary.getIndex(fl::lib::text::kPadToken);
+
+  // all the tokens in a single sample
+  auto tokens = TextDataset(
+                    dataDir,
+                    "train.txt",
+                    partialFileReader,
+                    tokenizer,
+                    dictionary,
+                    1000,
+                    1,
+                    "none",
+                    /* useDynamicBatching = */ false,
+                    /* reserveSpaceSize = */ 0)
+                    .get(0)[0]
+                    .toHostVector<int>();
+  const int64_t nTokens = tokens.size();
+
+  int tokensPerSample = 4;
+  int batchSize = 3;
+  TextDataset dataset(
+      dataDir,
+      "train.txt",
+      partialFileReader,
+      tokenizer,
+      dictionary,
+      tokensPerSample,
+      batchSize,
+      "stream",
+      /* useDynamicBatching = */ false,
+      /* reserveSpaceSize = */ 0);
+  const int64_t streamLength = (nTokens + batchSize - 1) / batchSize;
+  ASSERT_EQ(
+      dataset.size(), (streamLength + tokensPerSample - 1) / tokensPerSample);
+
+  // each sample continues the same one of the previous batch
+  for (int b = 0; b < dataset.size(); b++) {
+    auto sample = dataset.get(b)[0];
+    ASSERT_EQ(sample.dim(1), batchSize);
+    auto values = sample.toHostVector<int>();
+    for (int s = 0; s < batchSize; s++) {
+      for (int t = 0; t < sample.dim(0); t++) {
+        const int64_t pos = b * tokensPerSample + t;
+        const int64_t token = s * streamLength + pos;
+        const int expected = pos < streamLength && token < nTokens
+            ? tokens[token]
+            : pad;
+        ASSERT_EQ(values[s * sample.dim(0) + t], expected);
+      }
+    }
+  }
+}
+
+TEST(TextDatasetTest, BalanceBatches) {
+  fl::lib::text::Tokenizer tokenizer;
+  fl::lib::text::PartialFileReader partialFileReader(0, 1);
+  Dictionary dictionary = createDictionary(dataDir / "dictionary.txt");
+
+  TextDataset dataset(
+      dataDir,
+      "train.txt",
+      partialFileReader,
+      tokenizer,
+      dictionary,
+      15,
+      1,
+      "eos",
+      /* useDynamicBatching = */ true,
+      /* reserveSpaceSize = */ 0);
+  ASSERT_EQ(dataset.size(), 4);
+  dataset.balanceBatches(3);
+  ASSERT_EQ(dataset.size(), 4);
+
+  // the batch of 3 sentences, then one of 2, are split
+  dataset.balanceBatches(6);
+  ASSERT_EQ(dataset.size(), 6);
+  int64_t numSentences = 0;
+  for (int i = 0; i < dataset.size(); i++) {
+    auto sample = dataset.get(i);
+    ASSERT_LE(sample[0].dim(1), 2);
+    numSentences += sample[0].dim(1);
+  }
+  ASSERT_EQ(numSentences, 8);
+
+  // then sentences are repeated
+  dataset.balanceBatches(10);
+  ASSERT_EQ(dataset.size(), 10);
+  for (int i = 0; i < dataset.size(); i++) {
+    ASSERT_EQ(dataset.get(i)[0].dim(1), 1);
+  }
+}
+
+TEST(TextDatasetTest, TokenCorpus) {
+  fl::lib::text::Tokenizer tokenizer;
+  Dictionary dictionary = createDictionary(dataDir / "dictionary.txt");
+  const fs::path corpusPath = fs::temp_directory_path() / "train.tok";
+  TokenCorpus::compile(
+      dataDir, "train.txt", tokenizer, dictionary, corpusPath);
+  ASSERT_TRUE(TokenCorpus::isTokenCorpus(corpusPath));
+  ASSERT_FALSE(TokenCorpus::isTokenCorpus(dataDir / "train.txt"));
+  {
+    TokenCorpus corpus(corpusPath);
+    ASSERT_EQ(corpus.tokenBytes(), 2);
+    ASSERT_EQ(corpus.dictionarySize(), dictionary.entrySize());
+    ASSERT_EQ(corpus.sentenceOffset(0), 0);
+    ASSERT_EQ(
+        corpus.sentenceOffset(corpus.numSentences()), corpus.numTokens() - 1);
+  }
+
+  // the same batches as from the text, on a single rank
+  for (const std::string mode : {"none", "eos"}) {
+    fl::lib::text::PartialFileReader partialFileReader(0, 1);
+    TextDataset expected(
+        dataDir,
+        "train.txt",
+        partialFileReader,
+        tokenizer,
+        dictionary,
+        5,
+        2,
+        mode,
+        /* useDynamicBatching = */ false,
+        /* reserveSpaceSize = */ 0);
+    TextDataset dataset(corpusPath, 0, 1, dictionary, 5, 2, mode);
+    ASSERT_EQ(dataset.size(), expected.size());
+    for (int i = 0; i < dataset.size(); i++) {
+      auto sample = dataset.get(i);
+      ASSERT_EQ(sample.size(), 1);
+      ASSERT_EQ(sample[0].type(), fl::dtype::s32);
+      ASSERT_TRUE(
+          fl::all(sample[0] == expected.get(i)[0]).asScalar<bool>());
+    }
+  }
+
+  // the sentences are split between ranks
+  int64_t numSentences = 0;
+  for (int rank = 0; rank < 3; ++rank) {
+    TextDataset dataset(corpusPath, rank, 3, dictionary, 100, 1, "eos");
+    numSentences += dataset.size();
+  }
+  ASSERT_EQ(numSentences, TokenCorpus(corpusPath).numSentences());
+  fs::remove(corpusPath);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
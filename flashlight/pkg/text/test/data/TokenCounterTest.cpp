@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/lib/text/tokenizer/Tokenizer.h"
+#include "flashlight/pkg/text/data/TokenCounter.h"
+
+using namespace fl::pkg::text;
+
+TEST(TokenCounterTest, Parts) {
+  const fs::path path = fs::temp_directory_path() / "counts.txt";
+  {
+    std::ofstream out(path);
+    for (int i = 0; i < 100; ++i) {
+      for (int j = 0; j < i % 7; ++j) {
+        out << "w" << (i * j) % 11 << " ";
+      }
+      out << "\n";
+    }
+    // no newline at the end of the file
+    out << "w0 w1";
+  }
+  fl::lib::text::Tokenizer tokenizer;
+  auto counts = countTokens(path, tokenizer);
+  ASSERT_EQ(counts.numSentences, 101);
+  int64_t numTokens = 0;
+  for (const auto& [token, count] : counts.counts) {
+    numTokens += count;
+  }
+  ASSERT_EQ(counts.numTokens, numTokens);
+
+  // the same counts with any number of parts and threads
+  for (int numParts : {2, 3, 16}) {
+    for (int numThreads : {1, 4}) {
+      TokenCounts merged;
+      for (int part = 0; part < numParts; ++part) {
+        merged.merge(
+            countTokens(path, tokenizer, part, numParts, numThreads));
+      }
+      ASSERT_EQ(merged.counts, counts.counts);
+      ASSERT_EQ(merged.numTokens, counts.numTokens);
+      ASSERT_EQ(merged.numSentences, counts.numSentences);
+    }
+  }
+
+  counts.save(path);
+  auto loaded = TokenCounts::load(path);
+  ASSERT_EQ(loaded.counts, counts.counts);
+  ASSERT_EQ(loaded.numTokens, counts.numTokens);
+  fs::remove(path);
+
+  auto pruned = counts.prune(3, 0);
+  ASSERT_EQ(pruned.size(), 3);
+  ASSERT_GE(pruned[0].second, pruned[1].second);
+  ASSERT_GE(pruned[1].second, pruned[2].second);
+  for (const auto& [token, count] : counts.prune(-1, pruned[2].second)) {
+    ASSERT_GE(count, pruned[2].second);
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
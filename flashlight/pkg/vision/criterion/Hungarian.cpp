@@ -6,7 +6,12 @@
  */
 #include "flashlight/pkg/vision/criterion/Hungarian.h"
 
+#include <future>
+#include <utility>
+#include <vector>
+
 #include "flashlight/fl/autograd/Functions.h"
+#include "flashlight/fl/common/threadpool/ThreadPool.h"
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/pkg/vision/criterion/HungarianImpl.h"
 #include "flashlight/pkg/vision/dataset/BoxUtils.h"
@@ -25,19 +30,15 @@ Tensor softmax(const Tensor& input, const int dim) {
   return result;
 }
 
-std::pair<Tensor, Tensor> hungarian(Tensor& cost) {
-  cost = fl::transpose(cost, {1, 0, 2, 3});
-  const int M = cost.dim(0);
-  const int N = cost.dim(1);
-  std::vector<float> costHost(cost.elements());
-  std::vector<int> rowIdxs(M);
-  std::vector<int> colIdxs(M);
-  cost.host(costHost.data());
-  fl::lib::set::hungarian(
-      costHost.data(), rowIdxs.data(), colIdxs.data(), M, N);
-  auto rowIdxsArray = Tensor::fromVector(rowIdxs);
-  auto colIdxsArray = Tensor::fromVector(colIdxs);
-  return {rowIdxsArray, colIdxsArray};
+// First is the target idx of each assignment, second is the pred idx
+using Assignment = std::pair<std::vector<int>, std::vector<int>>;
+
+Assignment hungarian(const std::vector<float>& costs, const int M) {
+  const int N = costs.size() / M;
+  Assignment result{std::vector<int>(M), std::vector<int>(M)};
+  fl::lib::set::linearSumAssignment(
+      costs.data(), result.first.data(), result.second.data(), M, N);
+  return result;
 }
 } // namespace
 
@@ -48,19 +49,19 @@ namespace vision {
 HungarianMatcher::HungarianMatcher(
     const float costClass,
     const float costBbox,
-    const float costGiou)
-    : costClass_(costClass), costBbox_(costBbox), costGiou_(costGiou){};
+    const float costGiou,
+    const int numThreads /* = 4 */)
+    : costClass_(costClass), costBbox_(costBbox), costGiou_(costGiou) {
+  if (numThreads > 1) {
+    threadPool_ = std::make_shared<ThreadPool>(numThreads);
+  }
+}
 
-std::pair<Tensor, Tensor> HungarianMatcher::matchBatch(
+Tensor HungarianMatcher::costMatrix(
     const Tensor& predBoxes,
     const Tensor& predLogits,
     const Tensor& targetBoxes,
     const Tensor& targetClasses) const {
-  // Kind of a hack...
-  if (targetClasses.isEmpty()) {
-    return {fl::fromScalar(0), fl::fromScalar(0)};
-  }
-
   // Create an M X N cost matrix where M is the number of targets and N is the
   // number of preds
   // Class cost
@@ -80,7 +81,7 @@ std::pair<Tensor, Tensor> HungarianMatcher::matchBatch(
 
   auto cost =
       costBbox_ * costBbox + costClass_ * costClass + costGiou_ * costGiou;
-  return ::hungarian(cost);
+  return fl::transpose(cost, {1, 0, 2, 3});
 }
 
 std::vector<std::pair<Tensor, Tensor>> HungarianMatcher::compute(
@@ -88,14 +89,50 @@ std::vector<std::pair<Tensor, Tensor>> HungarianMatcher::compute(
     const Tensor& predLogits,
     const std::vector<Tensor>& targetBoxes,
     const std::vector<Tensor>& targetClasses) const {
-  std::vector<std::pair<Tensor, Tensor>> results;
-  for (int b = 0; b < predBoxes.dim(2); b++) {
-    auto result = matchBatch(
+  const int B = predBoxes.dim(2);
+  // the cost matrices are computed asynchronously, before any host copy
+  std::vector<Tensor> costs(B);
+  for (int b = 0; b < B; b++) {
+    // Kind of a hack...
+    if (targetClasses[b].isEmpty()) {
+      continue;
+    }
+    costs[b] = costMatrix(
         predBoxes(fl::span, fl::span, fl::range(b, b + 1)),
         predLogits(fl::span, fl::span, fl::range(b, b + 1)),
         targetBoxes[b],
         targetClasses[b]);
-    results.emplace_back(result);
+  }
+
+  std::vector<std::future<Assignment>> assignments(B);
+  for (int b = 0; b < B; b++) {
+    if (costs[b].isEmpty()) {
+      continue;
+    }
+    const int M = costs[b].dim(0);
+    auto costsHost = costs[b].toHostVector<float>();
+    if (threadPool_) {
+      assignments[b] = threadPool_->enqueue(
+          [M](const std::vector<float>& c) { return ::hungarian(c, M); },
+          std::move(costsHost));
+    } else {
+      std::promise<Assignment> assignment;
+      assignment.set_value(::hungarian(costsHost, M));
+      assignments[b] = assignment.get_future();
+    }
+  }
+
+  // the tensors are created by this thread, on its device
+  std::vector<std::pair<Tensor, Tensor>> results;
+  for (int b = 0; b < B; b++) {
+    if (!assignments[b].valid()) {
+      results.emplace_back(fl::fromScalar(0), fl::fromScalar(0));
+      continue;
+    }
+    auto assignment = assignments[b].get();
+    results.emplace_back(
+        Tensor::fromVector(assignment.first),
+        Tensor::fromVector(assignment.second));
   }
   return results;
 };
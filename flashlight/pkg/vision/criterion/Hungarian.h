@@ -6,20 +6,40 @@
  */
 #pragma once
 
+#include <memory>
+
 #include "flashlight/fl/tensor/TensorBase.h"
 
+namespace fl {
+class ThreadPool;
+} // namespace fl
+
 namespace fl {
 namespace pkg {
 namespace vision {
 
+/*
+ * Matches the predictions of DETR to the targets of each image, with the
+ * linear sum assignment of a weighted sum of class, box and GIoU costs.
+ *
+ * The cost matrices of all the images are computed first, and each one is
+ * copied to the host and assigned on a thread pool as soon as it is ready,
+ * such that the assignments of the first images overlap with the copies of
+ * the next ones.
+ */
 class HungarianMatcher {
  public:
   HungarianMatcher() = default;
 
+  /*
+   * @param numThreads the threads which assign the images of a batch in
+   * parallel, the images are assigned by the calling thread if not above 1
+   */
   HungarianMatcher(
       const float costClass,
       const float costBbox,
-      const float costGiou);
+      const float costGiou,
+      const int numThreads = 4);
 
   std::vector<std::pair<Tensor, Tensor>> compute(
       const Tensor& predBoxes,
@@ -31,9 +51,12 @@ class HungarianMatcher {
   float costClass_;
   float costBbox_;
   float costGiou_;
+  // shared by the copies of the matcher, e.g. of criterions
+  std::shared_ptr<ThreadPool> threadPool_;
 
-  // First is SrcIdx, second is ColIdx
-  std::pair<Tensor, Tensor> matchBatch(
+  // The M x N cost matrix of an image, where M is the number of targets and N
+  // is the number of preds
+  Tensor costMatrix(
       const Tensor& predBoxes,
       const Tensor& predLogits,
       const Tensor& targetBoxes,
@@ -8,7 +8,10 @@
 #include "flashlight/pkg/vision/criterion/HungarianImpl.h"
 
 #include <assert.h>
+#include <algorithm>
 #include <limits>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -378,6 +381,103 @@ void hungarian(float* costs, int* rowIdxs, int* colIdxs, int M, int N) {
   stepSeven(marks.data(), rowIdxs, colIdxs, M, N);
 }
 
+void linearSumAssignment(
+    const float* costs,
+    int* rowIdxs,
+    int* colIdxs,
+    int M,
+    int N) {
+  if (M > N) {
+    throw std::invalid_argument(
+        "linearSumAssignment - expected at most as many rows as columns");
+  }
+  const double inf = std::numeric_limits<double>::infinity();
+  // the dual variables of the rows and columns
+  std::vector<double> u(M, 0), v(N, 0);
+  std::vector<double> shortestPathCosts(N);
+  std::vector<int> path(N, -1);
+  std::vector<int> col4row(M, -1);
+  std::vector<int> row4col(N, -1);
+  std::vector<int> remaining(N);
+  std::vector<char> rowVisited(M), colVisited(N);
+
+  // assigns one more row at a time, along the shortest augmenting path from
+  // it to an unassigned column, in the costs reduced by the dual variables
+  for (int curRow = 0; curRow < M; curRow++) {
+    double minVal = 0;
+    int i = curRow;
+    int numRemaining = N;
+    for (int it = 0; it < N; it++) {
+      // filled in reverse such that ties pick the first columns
+      remaining[it] = N - it - 1;
+      shortestPathCosts[it] = inf;
+      colVisited[it] = 0;
+    }
+    std::fill(rowVisited.begin(), rowVisited.end(), 0);
+
+    int sink = -1;
+    while (sink == -1) {
+      int index = -1;
+      double lowest = inf;
+      rowVisited[i] = 1;
+      for (int it = 0; it < numRemaining; it++) {
+        const int j = remaining[it];
+        const double r = minVal + costs[j * M + i] - u[i] - v[j];
+        if (r < shortestPathCosts[j]) {
+          path[j] = i;
+          shortestPathCosts[j] = r;
+        }
+        if (shortestPathCosts[j] < lowest ||
+            (shortestPathCosts[j] == lowest && row4col[j] == -1)) {
+          lowest = shortestPathCosts[j];
+          index = it;
+        }
+      }
+      minVal = lowest;
+      if (index == -1) {
+        throw std::invalid_argument(
+            "linearSumAssignment - the costs must be finite");
+      }
+      const int j = remaining[index];
+      if (row4col[j] == -1) {
+        sink = j;
+      } else {
+        i = row4col[j];
+      }
+      colVisited[j] = 1;
+      remaining[index] = remaining[--numRemaining];
+    }
+
+    u[curRow] += minVal;
+    for (int r = 0; r < M; r++) {
+      if (rowVisited[r] && r != curRow) {
+        u[r] += minVal - shortestPathCosts[col4row[r]];
+      }
+    }
+    for (int c = 0; c < N; c++) {
+      if (colVisited[c]) {
+        v[c] -= minVal - shortestPathCosts[c];
+      }
+    }
+
+    // flips the assignments along the path
+    int j = sink;
+    while (true) {
+      const int r = path[j];
+      row4col[j] = r;
+      std::swap(col4row[r], j);
+      if (r == curRow) {
+        break;
+      }
+    }
+  }
+
+  for (int r = 0; r < M; r++) {
+    rowIdxs[r] = r;
+    colIdxs[r] = col4row[r];
+  }
+}
+
 } // namespace set
 } // namespace lib
 } // namespace fl
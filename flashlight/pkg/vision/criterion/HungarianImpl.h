@@ -30,6 +30,19 @@ void hungarian(float* costs, int* rowIdxs, int* colIdxs, int M, int N);
  */
  void hungarian(float* costs, int* assignments, int M, int N);
 
+/*
+ * Same as hungarian(costs, rowIdxs, colIdxs, M, N), with the shortest
+ * augmenting path algorithm of Jonker and Volgenant, in O(M^2 N) time instead
+ * of the O(M^2 N^2) steps of Munkres. It requires M <= N and doesn't modify
+ * costs. rowIdxs is 0, ..., M - 1 and colIdxs the column of each row.
+ */
+void linearSumAssignment(
+    const float* costs,
+    int* rowIdxs,
+    int* colIdxs,
+    int M,
+    int N);
+
 } // namespace set
 } // namespace lib
 } // namespace fl
@@ -10,15 +10,153 @@
 #include <assert.h>
 #include <stdexcept>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include "flashlight/fl/autograd/Functions.h"
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/pkg/vision/dataset/backend/BoxIouPairwise.h"
+
+#if FL_BACKEND_CUDA
+#include "flashlight/fl/common/DevicePtr.h"
+#include "flashlight/fl/runtime/CUDAStream.h"
+#include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/pkg/vision/dataset/backend/cuda/BoxIouKernels.h"
+#endif
 
 namespace fl {
 namespace pkg {
 namespace vision {
 
+namespace {
+
+/*
+ * The pairwise kernels compute the N x M x B result directly from the
+ * [4, N, B] and [4, M, B] boxes, instead of tiling both sets to
+ * [4, N, M, B] with `cartesian`. They support float boxes.
+ */
+bool useBoxIouKernels(const Tensor& bboxes1, const Tensor& bboxes2) {
+  return bboxes1.type() == fl::dtype::f32 &&
+      bboxes2.type() == fl::dtype::f32 && bboxes1.dim(0) >= 4 &&
+      bboxes2.dim(0) >= 4 && bboxes1.dim(2) == bboxes2.dim(2);
+}
+
+detail::BoxIouSets boxIouSets(const Tensor& bboxes1, const Tensor& bboxes2) {
+  detail::BoxIouSets sets;
+  sets.boxes1 = nullptr;
+  sets.boxes2 = nullptr;
+  sets.stride1 = bboxes1.dim(0);
+  sets.stride2 = bboxes2.dim(0);
+  sets.N = bboxes1.dim(1);
+  sets.M = bboxes2.dim(1);
+  sets.B = bboxes1.dim(2);
+  return sets;
+}
+
+// The [N, M, B, 1] iou, or generalized iou, and union
+std::pair<Tensor, Tensor> pairwiseBoxIou(
+    const Tensor& bboxes1,
+    const Tensor& bboxes2,
+    bool generalized) {
+  auto sets = boxIouSets(bboxes1, bboxes2);
+  const Shape shape = {sets.N, sets.M, sets.B, 1};
+#if FL_BACKEND_CUDA
+  Tensor iou(shape, fl::dtype::f32);
+  Tensor uni(shape, fl::dtype::f32);
+  relativeSync(iou.stream(), std::vector<Tensor>{bboxes1, bboxes2});
+  {
+    DevicePtr boxes1Raw(bboxes1);
+    DevicePtr boxes2Raw(bboxes2);
+    DevicePtr iouRaw(iou);
+    DevicePtr uniRaw(uni);
+    sets.boxes1 = static_cast<const float*>(boxes1Raw.get());
+    sets.boxes2 = static_cast<const float*>(boxes2Raw.get());
+    detail::pairwiseBoxIouCuda(
+        sets,
+        generalized,
+        static_cast<float*>(iouRaw.get()),
+        static_cast<float*>(uniRaw.get()),
+        iou.stream().impl<CUDAStream>().handle());
+  }
+  return {iou, uni};
+#else
+  const auto boxes1 = bboxes1.toHostVector<float>();
+  const auto boxes2 = bboxes2.toHostVector<float>();
+  sets.boxes1 = boxes1.data();
+  sets.boxes2 = boxes2.data();
+  std::vector<float> iou(shape.elements());
+  std::vector<float> uni(shape.elements());
+  for (size_t i = 0; i < iou.size(); ++i) {
+    detail::pairwiseBoxIouElement(sets, generalized, i, iou.data(), uni.data());
+  }
+  return {Tensor::fromVector(shape, iou), Tensor::fromVector(shape, uni)};
+#endif
+}
+
+// The gradients of both sets of boxes, of their shapes
+std::pair<Tensor, Tensor> pairwiseBoxIouGrad(
+    const Tensor& bboxes1,
+    const Tensor& bboxes2,
+    const Tensor& gradOutput,
+    bool generalized) {
+  auto sets = boxIouSets(bboxes1, bboxes2);
+  const auto grad = gradOutput.astype(fl::dtype::f32);
+#if FL_BACKEND_CUDA
+  Tensor grad1(bboxes1.shape(), fl::dtype::f32);
+  Tensor grad2(bboxes2.shape(), fl::dtype::f32);
+  relativeSync(grad1.stream(), std::vector<Tensor>{bboxes1, bboxes2, grad});
+  {
+    DevicePtr boxes1Raw(bboxes1);
+    DevicePtr boxes2Raw(bboxes2);
+    DevicePtr gradRaw(grad);
+    DevicePtr grad1Raw(grad1);
+    DevicePtr grad2Raw(grad2);
+    sets.boxes1 = static_cast<const float*>(boxes1Raw.get());
+    sets.boxes2 = static_cast<const float*>(boxes2Raw.get());
+    detail::pairwiseBoxIouGradCuda(
+        sets,
+        static_cast<const float*>(gradRaw.get()),
+        generalized,
+        static_cast<float*>(grad1Raw.get()),
+        static_cast<float*>(grad2Raw.get()),
+        grad1.stream().impl<CUDAStream>().handle());
+  }
+  return {grad1, grad2};
+#else
+  const auto boxes1 = bboxes1.toHostVector<float>();
+  const auto boxes2 = bboxes2.toHostVector<float>();
+  const auto gradHost = grad.toHostVector<float>();
+  sets.boxes1 = boxes1.data();
+  sets.boxes2 = boxes2.data();
+  std::vector<float> grad1(bboxes1.elements());
+  std::vector<float> grad2(bboxes2.elements());
+  for (size_t j = 0; j < static_cast<size_t>(sets.N) * sets.B; ++j) {
+    detail::pairwiseBoxIouGradElement(
+        sets,
+        gradHost.data(),
+        generalized,
+        /* second = */ false,
+        j,
+        grad1.data());
+  }
+  for (size_t j = 0; j < static_cast<size_t>(sets.M) * sets.B; ++j) {
+    detail::pairwiseBoxIouGradElement(
+        sets,
+        gradHost.data(),
+        generalized,
+        /* second = */ true,
+        j,
+        grad2.data());
+  }
+  return {
+      Tensor::fromVector(bboxes1.shape(), grad1),
+      Tensor::fromVector(bboxes2.shape(), grad2)};
+#endif
+}
+
+} // namespace
+
 Tensor cxcywh2xyxy(const Tensor& bboxes) {
   auto xc = bboxes(fl::range(0, 1));
   auto yc = bboxes(fl::range(1, 2));
@@ -129,8 +267,8 @@ Tensor cartesian(const Tensor& x, const Tensor& y, batchFuncArr_t fn) {
   auto yMod = fl::reshape(y, {y.dim(0), 1, y.dim(1), y.dim(2)});
   auto xMod = fl::reshape(x, {x.dim(0), x.dim(1), 1, x.dim(2)});
   Shape outputDims = {x.dim(0), x.dim(1), y.dim(1), x.dim(2)};
-  xMod = detail::tileAs(xMod, outputDims);
-  yMod = detail::tileAs(yMod, outputDims);
+  xMod = fl::detail::tileAs(xMod, outputDims);
+  yMod = fl::detail::tileAs(yMod, outputDims);
   return fn(xMod, yMod);
 }
 
@@ -142,6 +280,11 @@ std::tuple<Tensor, Tensor> boxIou(
         "vision::boxIou - bbox inputs must be of shape "
         "[4, N, B, ...] and [4, M, B, ...]");
   }
+  if (useBoxIouKernels(bboxes1, bboxes2)) {
+    Tensor iou, uni;
+    std::tie(iou, uni) = pairwiseBoxIou(bboxes1, bboxes2, false);
+    return std::tie(iou, uni);
+  }
   auto area1 = boxArea(bboxes1);
   auto area2 = boxArea(bboxes2);
   auto lt = cartesian(
@@ -195,6 +338,19 @@ fl::Variable generalizedBoxIou(
                               bboxes2.tensor()(fl::range(0, 2))))
              .scalar<uint32_t>());
 
+  if (bboxes1.ndim() == 3 && bboxes2.ndim() == 3 &&
+      useBoxIouKernels(bboxes1.tensor(), bboxes2.tensor())) {
+    auto giou = pairwiseBoxIou(bboxes1.tensor(), bboxes2.tensor(), true).first;
+    auto gradFunc = [](std::vector<Variable>& inputs,
+                       const Variable& gradOutput) {
+      auto grads = pairwiseBoxIouGrad(
+          inputs[0].tensor(), inputs[1].tensor(), gradOutput.tensor(), true);
+      inputs[0].addGrad(Variable(grads.first, false));
+      inputs[1].addGrad(Variable(grads.second, false));
+    };
+    return Variable(giou, {bboxes1, bboxes2}, gradFunc);
+  }
+
   Variable iou, uni;
   std::tie(iou, uni) = boxIou(bboxes1, bboxes2);
   auto lt = cartesian(bboxes1(fl::range(0, 2)), bboxes2(fl::range(0, 2)), min);
@@ -214,6 +370,11 @@ Tensor generalizedBoxIou(const Tensor& bboxes1, const Tensor& bboxes2) {
              fl::all(bboxes2(fl::range(2, 4)) >= bboxes2(fl::range(0, 2))))
              .scalar<uint32_t>());
 
+  if (bboxes1.ndim() == 3 && bboxes2.ndim() == 3 &&
+      useBoxIouKernels(bboxes1, bboxes2)) {
+    return pairwiseBoxIou(bboxes1, bboxes2, true).first;
+  }
+
   Tensor iou, uni;
   std::tie(iou, uni) = boxIou(bboxes1, bboxes2);
   auto lt = cartesian(
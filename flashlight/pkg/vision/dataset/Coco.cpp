@@ -10,9 +10,11 @@
 #include <assert.h>
 #include <algorithm>
 #include <map>
+#include <numeric>
 
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/pkg/vision/dataset/BoxUtils.h"
+#include "flashlight/pkg/vision/dataset/CocoIndex.h"
 #include "flashlight/pkg/vision/dataset/CocoTransforms.h"
 #include "flashlight/pkg/vision/dataset/DistributedDataset.h"
 #include "flashlight/pkg/vision/dataset/LoaderDataset.h"
@@ -81,12 +83,66 @@ int64_t getImageId(const std::string& fp) {
   return std::stol(substring);
 }
 
+// image, size, imageId, original_size, boxes and classes
+std::vector<Tensor> loadSample(
+    const std::string& filepath,
+    const float* boxesData,
+    const float* classesData,
+    const int numBoxes) {
+  Tensor image = loadJpeg(filepath);
+
+  std::vector<long> targetSizes = {image.dim(1), image.dim(0)};
+  Tensor targetSize = Tensor::fromVector(targetSizes);
+  Tensor imageId = fl::full({getImageId(filepath)}, 1, fl::dtype::s64);
+
+  Tensor bboxes, classes;
+  if (numBoxes > 0) {
+    bboxes = Tensor::fromBuffer(
+        {kElementsPerBbox, numBoxes}, boxesData, MemoryLocation::Host);
+    classes =
+        Tensor::fromBuffer({1, numBoxes}, classesData, MemoryLocation::Host);
+  } else {
+    // Arrayfire doesn't allow you to create 0 length dimension on
+    // anything other than the first dimension so we need this switch
+    bboxes = Tensor();
+    classes = Tensor();
+  }
+  return std::vector<Tensor>{
+      image, targetSize, imageId, targetSize, bboxes, classes};
+}
+
 } // namespace
 
 namespace fl {
 namespace pkg {
 namespace vision {
 
+CocoDataSample parseCocoListLine(const std::string& line) {
+  // We use tabs a deliminators between the filepath and each bbox
+  // We use spaced to separate the different fields of the bbox
+  const std::string delim = "\t";
+  const std::string bbox_delim = " ";
+  int item = line.find(delim);
+  std::string filepath = line.substr(0, item);
+  std::vector<float> bboxes;
+  std::vector<float> classes;
+  item = line.find(delim, item);
+  while (item != std::string::npos) {
+    int pos = item;
+    int next;
+    for (int i = 0; i < 4; i++) {
+      next = line.find(bbox_delim, pos + 1);
+      assert(next != std::string::npos);
+      bboxes.emplace_back(std::stof(line.substr(pos, next - pos)));
+      pos = next;
+    }
+    next = line.find(bbox_delim, pos + 1);
+    classes.emplace_back(std::stod(line.substr(pos, next - pos)));
+    item = line.find(delim, pos);
+  }
+  return CocoDataSample{filepath, bboxes, classes};
+}
+
 CocoDataset::CocoDataset(
     const std::string& list_file,
     int world_rank,
@@ -95,67 +151,44 @@ CocoDataset::CocoDataset(
     int num_threads,
     int prefetch_size,
     bool val) {
-  // Create vector of CocoDataSample which will be loaded into arrayfire arrays
-  std::vector<CocoDataSample> data;
-  std::ifstream ifs(list_file);
-  if (!ifs) {
-    throw std::runtime_error("Could not open list file: " + list_file);
-  }
-  // We use tabs a deliminators between the filepath and each bbox
-  // We use spaced to separate the different fields of the bbox
-  const std::string delim = "\t";
-  const std::string bbox_delim = " ";
-  std::string line;
-  while (std::getline(ifs, line)) {
-    int item = line.find(delim);
-    std::string filepath = line.substr(0, item);
-    std::vector<float> bboxes;
-    std::vector<float> classes;
-    item = line.find(delim, item);
-    while (item != std::string::npos) {
-      int pos = item;
-      int next;
-      for (int i = 0; i < 4; i++) {
-        next = line.find(bbox_delim, pos + 1);
-        assert(next != std::string::npos);
-        bboxes.emplace_back(std::stof(line.substr(pos, next - pos)));
-        pos = next;
-      }
-      next = line.find(bbox_delim, pos + 1);
-      classes.emplace_back(std::stod(line.substr(pos, next - pos)));
-      item = line.find(delim, pos);
+  std::shared_ptr<Dataset> ds;
+  if (CocoIndex::isCocoIndex(list_file)) {
+    // the annotations are read from the mapped index when the images are
+    auto index = std::make_shared<const CocoIndex>(list_file);
+    std::vector<int64_t> images(index->size());
+    std::iota(images.begin(), images.end(), 0);
+    ds = std::make_shared<LoaderDataset<int64_t>>(
+        images, [index](const int64_t& image) {
+          return loadSample(
+              std::string(index->filepath(image)),
+              index->boxes(image),
+              index->classes(image),
+              index->numBoxes(image));
+        });
+  } else {
+    // Create vector of CocoDataSample which will be loaded into arrayfire
+    // arrays
+    std::vector<CocoDataSample> data;
+    std::ifstream ifs(list_file);
+    if (!ifs) {
+      throw std::runtime_error("Could not open list file: " + list_file);
+    }
+    std::string line;
+    while (std::getline(ifs, line)) {
+      data.emplace_back(parseCocoListLine(line));
     }
-    data.emplace_back(CocoDataSample{filepath, bboxes, classes});
+    assert(data.size() > 0);
+
+    // Now define how to load the data from CocoDataSampoles in arrayfire
+    ds = std::make_shared<LoaderDataset<CocoDataSample>>(
+        data, [](const CocoDataSample& sample) {
+          return loadSample(
+              sample.filepath,
+              sample.bboxes.data(),
+              sample.classes.data(),
+              sample.bboxes.size() / kElementsPerBbox);
+        });
   }
-  assert(data.size() > 0);
-
-  // Now define how to load the data from CocoDataSampoles in arrayfire
-  std::shared_ptr<Dataset> ds = std::make_shared<LoaderDataset<CocoDataSample>>(
-      data, [](const CocoDataSample& sample) {
-        Tensor image = loadJpeg(sample.filepath);
-
-        std::vector<long> targetSizes = {image.dim(1), image.dim(0)};
-        Tensor targetSize = Tensor::fromVector(targetSizes);
-        Tensor imageId =
-            fl::full({getImageId(sample.filepath)}, 1, fl::dtype::s64);
-
-        const int num_elements = sample.bboxes.size();
-        const int num_bboxes = num_elements / kElementsPerBbox;
-        Tensor bboxes, classes;
-        if (num_bboxes > 0) {
-          bboxes =
-              Tensor::fromVector({kElementsPerBbox, num_bboxes}, sample.bboxes);
-          classes = Tensor::fromVector({1, num_bboxes}, sample.classes);
-        } else {
-          // Arrayfire doesn't allow you to create 0 length dimension on
-          // anything other than the first dimension so we need this switch
-          bboxes = Tensor();
-          classes = Tensor();
-        }
-        // image, size, imageId, original_size
-        return std::vector<Tensor>{
-            image, targetSize, imageId, targetSize, bboxes, classes};
-      });
 
   const int maxSize = 1333;
   if (val) {
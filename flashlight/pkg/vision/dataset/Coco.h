@@ -22,6 +22,13 @@ struct CocoDataSample {
   std::vector<float> classes;
 };
 
+/**
+ * Parses a line of the list of a `CocoDataset`: the file path of an image,
+ * followed by a tab separated list of its boxes, each with the space separated
+ * x1, y1, x2, y2 coordinates and class of the box.
+ */
+CocoDataSample parseCocoListLine(const std::string& line);
+
 struct CocoData {
   Tensor images;
   Tensor masks;
@@ -34,6 +41,11 @@ struct CocoData {
 
 class CocoDataset {
  public:
+  /**
+   * @param list_file The list of images and their annotations, see
+   * `parseCocoListLine`, or its compiled `CocoIndex`, which is mapped rather
+   * than parsed.
+   */
   CocoDataset(
       const std::string& list_file,
       int world_rank,
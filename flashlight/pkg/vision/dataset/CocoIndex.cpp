@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/vision/dataset/CocoIndex.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "flashlight/pkg/vision/dataset/Coco.h"
+
+namespace fl {
+namespace pkg {
+namespace vision {
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'L', 'C', 'O', 'C', 'I', 'X', '1'};
+constexpr int kElementsPerBbox = 4;
+
+struct Header {
+  char magic[8];
+  uint64_t numImages;
+  uint64_t numBoxes;
+  uint64_t poolBytes;
+};
+
+int64_t indexBytes(const Header& header) {
+  return sizeof(Header) + 2 * sizeof(uint64_t) * (header.numImages + 1) +
+      sizeof(float) * (kElementsPerBbox + 1) * header.numBoxes +
+      header.poolBytes;
+}
+
+} // namespace
+
+CocoIndex::CocoIndex(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(
+        "CocoIndex::CocoIndex - could not open file " + path + ": " +
+        std::strerror(errno));
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error(
+        "CocoIndex::CocoIndex - could not stat file " + path);
+  }
+  mappedSize_ = st.st_size;
+  if (mappedSize_ < static_cast<int64_t>(sizeof(Header))) {
+    ::close(fd);
+    throw std::runtime_error("CocoIndex::CocoIndex - truncated index " + path);
+  }
+  // a shared mapping, whose pages are shared by the processes of a node
+  void* data = ::mmap(nullptr, mappedSize_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error(
+        "CocoIndex::CocoIndex - could not map file " + path + ": " +
+        std::strerror(errno));
+  }
+  data_ = static_cast<char*>(data);
+  ::madvise(data_, mappedSize_, MADV_RANDOM);
+
+  Header header;
+  std::memcpy(&header, data_, sizeof(Header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      indexBytes(header) != mappedSize_) {
+    ::munmap(data_, mappedSize_);
+    throw std::runtime_error("CocoIndex::CocoIndex - invalid index " + path);
+  }
+  numImages_ = header.numImages;
+  const char* ptr = data_ + sizeof(Header);
+  boxOffsets_ = reinterpret_cast<const uint64_t*>(ptr);
+  ptr += sizeof(uint64_t) * (header.numImages + 1);
+  pathOffsets_ = reinterpret_cast<const uint64_t*>(ptr);
+  ptr += sizeof(uint64_t) * (header.numImages + 1);
+  boxes_ = reinterpret_cast<const float*>(ptr);
+  ptr += sizeof(float) * kElementsPerBbox * header.numBoxes;
+  classes_ = reinterpret_cast<const float*>(ptr);
+  ptr += sizeof(float) * header.numBoxes;
+  pool_ = ptr;
+}
+
+CocoIndex::~CocoIndex() {
+  if (data_) {
+    ::munmap(data_, mappedSize_);
+  }
+}
+
+int64_t CocoIndex::size() const {
+  return numImages_;
+}
+
+std::string_view CocoIndex::filepath(int64_t image) const {
+  return std::string_view(
+      pool_ + pathOffsets_[image],
+      pathOffsets_[image + 1] - pathOffsets_[image]);
+}
+
+int64_t CocoIndex::numBoxes(int64_t image) const {
+  return boxOffsets_[image + 1] - boxOffsets_[image];
+}
+
+const float* CocoIndex::boxes(int64_t image) const {
+  return boxes_ + kElementsPerBbox * boxOffsets_[image];
+}
+
+const float* CocoIndex::classes(int64_t image) const {
+  return classes_ + boxOffsets_[image];
+}
+
+bool CocoIndex::isCocoIndex(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  return file.read(magic, sizeof(magic)) &&
+      std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+int64_t CocoIndex::compile(
+    const std::string& listFile,
+    const std::string& indexFile) {
+  std::ifstream inFile(listFile);
+  if (!inFile) {
+    throw std::invalid_argument(
+        "CocoIndex::compile - unable to open file " + listFile);
+  }
+  std::vector<uint64_t> boxOffsets = {0};
+  std::vector<uint64_t> pathOffsets = {0};
+  std::vector<float> boxes;
+  std::vector<float> classes;
+  std::string pool;
+  std::string line;
+  while (std::getline(inFile, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    auto sample = parseCocoListLine(line);
+    if (sample.bboxes.size() != kElementsPerBbox * sample.classes.size()) {
+      throw std::runtime_error(
+          "CocoIndex::compile - file " + listFile +
+          " has invalid boxes in line: " + line);
+    }
+    boxes.insert(boxes.end(), sample.bboxes.begin(), sample.bboxes.end());
+    classes.insert(classes.end(), sample.classes.begin(), sample.classes.end());
+    boxOffsets.push_back(classes.size());
+    pool += sample.filepath;
+    pathOffsets.push_back(pool.size());
+  }
+
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.numImages = boxOffsets.size() - 1;
+  header.numBoxes = classes.size();
+  header.poolBytes = pool.size();
+  std::ofstream out(indexFile, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error(
+        "CocoIndex::compile - unable to create file " + indexFile);
+  }
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(
+      reinterpret_cast<const char*>(boxOffsets.data()),
+      sizeof(uint64_t) * boxOffsets.size());
+  out.write(
+      reinterpret_cast<const char*>(pathOffsets.data()),
+      sizeof(uint64_t) * pathOffsets.size());
+  out.write(
+      reinterpret_cast<const char*>(boxes.data()),
+      sizeof(float) * boxes.size());
+  out.write(
+      reinterpret_cast<const char*>(classes.data()),
+      sizeof(float) * classes.size());
+  out.write(pool.data(), pool.size());
+  if (!out) {
+    throw std::runtime_error(
+        "CocoIndex::compile - failed to write file " + indexFile);
+  }
+  return header.numImages;
+}
+
+} // namespace vision
+} // namespace pkg
+} // namespace fl
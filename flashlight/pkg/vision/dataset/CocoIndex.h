@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace fl {
+namespace pkg {
+namespace vision {
+
+/**
+ * A compiled, binary index of the list of images and annotations of a
+ * `CocoDataset`, which is memory-mapped instead of parsed, such that the
+ * dataset of millions of annotated images is constructed in milliseconds, and
+ * the pages of the index are shared by the processes that read it on a node,
+ * e.g. the ranks of a distributed training, instead of being copied into each
+ * of them.
+ *
+ * An index is compiled from a list once, with `CocoIndex::compile`, e.g. with
+ * the `fl_img_coco_compile_list` tool, and a `CocoDataset` given the index
+ * file instead of the list reads it.
+ *
+ * Layout, in native byte order:
+ *  header: magic (8 bytes), images, boxes, pool bytes (uint64 each)
+ *  box offsets: uint64 x (images + 1), the first box of each image
+ *  path offsets: uint64 x (images + 1), in the pool
+ *  boxes: float x 4 x boxes, the x1, y1, x2, y2 coordinates of each box
+ *  classes: float x boxes
+ *  pool: the characters of the file paths of the images
+ */
+class CocoIndex {
+ public:
+  /**
+   * Maps a compiled annotation index.
+   * @param[in] path The index file.
+   */
+  explicit CocoIndex(const std::string& path);
+  ~CocoIndex();
+
+  CocoIndex(const CocoIndex&) = delete;
+  CocoIndex& operator=(const CocoIndex&) = delete;
+
+  /**
+   * @return The number of images of the list.
+   */
+  int64_t size() const;
+
+  // The annotations of an image of the list, which are valid for the lifetime
+  // of the index.
+  std::string_view filepath(int64_t image) const;
+  int64_t numBoxes(int64_t image) const;
+  const float* boxes(int64_t image) const;
+  const float* classes(int64_t image) const;
+
+  /**
+   * @param[in] path A file name.
+   * @return True if the file is a compiled annotation index, rather than a
+   * list.
+   */
+  static bool isCocoIndex(const std::string& path);
+
+  /**
+   * Compiles a list file into an index.
+   * @param[in] listFile The list file, in the format of `CocoDataset`.
+   * @param[in] indexFile The index file, which is truncated if it exists.
+   * @return The number of images of the list.
+   */
+  static int64_t compile(
+      const std::string& listFile,
+      const std::string& indexFile);
+
+ private:
+  char* data_{nullptr};
+  int64_t mappedSize_{0};
+  int64_t numImages_{0};
+  const uint64_t* boxOffsets_{nullptr};
+  const uint64_t* pathOffsets_{nullptr};
+  const float* boxes_{nullptr};
+  const float* classes_{nullptr};
+  const char* pool_{nullptr};
+};
+
+} // namespace vision
+} // namespace pkg
+} // namespace fl
@@ -7,10 +7,65 @@
 
 #include "flashlight/pkg/vision/dataset/DistributedDataset.h"
 
+#include <stdexcept>
+#include <string>
+
 namespace fl {
 namespace pkg {
 namespace vision {
 
+namespace {
+
+// SplitMix64, see Steele et al. (2014)
+uint64_t mix(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+} // namespace
+
+IndexPermutation::IndexPermutation(int64_t size, uint64_t seed)
+    : size_(size) {
+  if (size < 0) {
+    throw std::invalid_argument(
+        "IndexPermutation::IndexPermutation - invalid size " +
+        std::to_string(size));
+  }
+  while ((1ULL << (2 * halfBits_)) < static_cast<uint64_t>(size)) {
+    ++halfBits_;
+  }
+  halfMask_ = (1ULL << halfBits_) - 1;
+  for (int r = 0; r < kRounds; ++r) {
+    seed = mix(seed);
+    keys_[r] = seed;
+  }
+}
+
+uint64_t IndexPermutation::permuteDomain(uint64_t x) const {
+  uint64_t left = x >> halfBits_;
+  uint64_t right = x & halfMask_;
+  for (int r = 0; r < kRounds; ++r) {
+    const uint64_t next = left ^ (mix(right ^ keys_[r]) & halfMask_);
+    left = right;
+    right = next;
+  }
+  return (left << halfBits_) | right;
+}
+
+int64_t IndexPermutation::operator()(int64_t idx) const {
+  uint64_t x = idx;
+  do {
+    x = permuteDomain(x);
+  } while (x >= static_cast<uint64_t>(size_));
+  return x;
+}
+
+int64_t IndexPermutation::size() const {
+  return size_;
+}
+
 DistributedDataset::DistributedDataset(
     std::shared_ptr<Dataset> base,
     int64_t worldRank,
@@ -19,34 +74,45 @@ DistributedDataset::DistributedDataset(
     int64_t nRepeated,
     int64_t numThreads,
     int64_t prefetchSize,
-    BatchDatasetPolicy batchPolicy) {
-  shuffle_ = std::make_shared<ShuffleDataset>(base);
-  auto permfn = [worldSize, worldRank, nRepeated](int64_t idx) {
-    return (idx * worldSize + worldRank) / nRepeated;
+    BatchDatasetPolicy batchPolicy,
+    uint64_t seed)
+    : permutation_(std::make_shared<IndexPermutation>(base->size())),
+      seed_(seed) {
+  auto permfn = [worldSize,
+                 worldRank,
+                 nRepeated,
+                 permutation = permutation_](int64_t idx) {
+    return (*permutation)((idx * worldSize + worldRank) / nRepeated);
   };
 
-  int partitionSize = shuffle_->size() / worldSize;
-  int leftOver = shuffle_->size() % worldSize;
+  int partitionSize = base->size() / worldSize;
+  int leftOver = base->size() % worldSize;
   if (worldRank < leftOver) {
     partitionSize++;
   }
-  ds_ = std::make_shared<ResampleDataset>(shuffle_, permfn, partitionSize);
+  ds_ = std::make_shared<ResampleDataset>(base, permfn, partitionSize);
   ds_ = std::make_shared<PrefetchDataset>(ds_, numThreads, prefetchSize);
   ds_ = std::make_shared<BatchDataset>(ds_, batchSize, batchPolicy);
+  resample();
 }
 
 std::vector<Tensor> DistributedDataset::get(const int64_t idx) const {
   checkIndexBounds(idx);
-  return ds_->get(idx);
+  return ds_->get(startBatch_ + idx);
 }
 
-void DistributedDataset::resample(const int seed) {
-  shuffle_->setSeed(seed);
-  shuffle_->resample();
+void DistributedDataset::resample(const int epoch, const int64_t startBatch) {
+  if (startBatch < 0 || startBatch > ds_->size()) {
+    throw std::invalid_argument(
+        "DistributedDataset::resample - invalid start batch " +
+        std::to_string(startBatch));
+  }
+  *permutation_ = IndexPermutation(permutation_->size(), mix(seed_) ^ epoch);
+  startBatch_ = startBatch;
 }
 
 int64_t DistributedDataset::size() const {
-  return ds_->size();
+  return ds_->size() - startBatch_;
 }
 
 } // namespace vision
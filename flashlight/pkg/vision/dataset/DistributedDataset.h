@@ -7,12 +7,58 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
+
 #include "flashlight/fl/dataset/datasets.h"
 
 namespace fl {
 namespace pkg {
 namespace vision {
 
+/**
+ * A pseudo-random permutation of the indices [0, size), evaluated an index at
+ * a time in O(1) memory rather than materialized: a Feistel network permutes
+ * the smallest domain of an even number of bits which holds the indices, and
+ * indices out of [0, size) are permuted again (cycle-walking) until they are
+ * in it, which takes less than 4 rounds of the network on average.
+ */
+class IndexPermutation {
+ public:
+  /**
+   * @param[in] size The number of indices.
+   * @param[in] seed The seed of the keys of the network, the same seed giving
+   * the same permutation.
+   */
+  explicit IndexPermutation(int64_t size = 0, uint64_t seed = 0);
+
+  /**
+   * @return The permuted index of `idx`, in [0, size).
+   */
+  int64_t operator()(int64_t idx) const;
+
+  int64_t size() const;
+
+ private:
+  static constexpr int kRounds = 4;
+
+  int64_t size_;
+  int halfBits_{1};
+  uint64_t halfMask_{1};
+  std::array<uint64_t, kRounds> keys_;
+
+  uint64_t permuteDomain(uint64_t x) const;
+};
+
+/**
+ * The shard of a rank of the batches of a dataset, shuffled at each epoch.
+ *
+ * The plan of an epoch is computed from the seed, the epoch, the rank and the
+ * world size only: the samples are permuted by an `IndexPermutation` and
+ * rank `r` reads the permuted samples `r, r + worldSize, ...`, such that no
+ * rank materializes a permutation, and a resumed training reads the same
+ * batches as the one it resumes.
+ */
 class DistributedDataset : public Dataset {
  public:
   DistributedDataset(
@@ -23,17 +69,30 @@ class DistributedDataset : public Dataset {
       int64_t nRepeated,
       int64_t numThreads,
       int64_t prefetchSize,
-      BatchDatasetPolicy batchpolicy = fl::BatchDatasetPolicy::INCLUDE_LAST);
+      BatchDatasetPolicy batchpolicy = fl::BatchDatasetPolicy::INCLUDE_LAST,
+      uint64_t seed = 0);
 
   std::vector<Tensor> get(const int64_t idx) const override;
 
-  void resample(const int seed = 0);
+  /**
+   * Shuffles the samples for an epoch.
+   *
+   * @param[in] epoch The epoch, whose shuffle depends only on it and the seed
+   * of the dataset.
+   * @param[in] startBatch The number of batches of the epoch to skip, e.g.
+   * those already trained on when resuming from a checkpoint in the middle of
+   * the epoch: `get(i)` then returns the batch `startBatch + i` of the epoch
+   * and `size()` the number of remaining batches.
+   */
+  void resample(const int epoch = 0, const int64_t startBatch = 0);
 
   int64_t size() const override;
 
  private:
   std::shared_ptr<Dataset> ds_;
-  std::shared_ptr<ShuffleDataset> shuffle_;
+  std::shared_ptr<IndexPermutation> permutation_;
+  uint64_t seed_;
+  int64_t startBatch_{0};
 };
 
 } // namespace vision
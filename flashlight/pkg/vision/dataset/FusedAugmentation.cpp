@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/vision/dataset/FusedAugmentation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "flashlight/pkg/vision/dataset/backend/FusedAugmentationPixel.h"
+
+#if FL_BACKEND_CUDA
+#include "flashlight/fl/common/DevicePtr.h"
+#include "flashlight/fl/runtime/CUDAStream.h"
+#include "flashlight/fl/tensor/Compute.h"
+#include "flashlight/pkg/vision/dataset/backend/cuda/FusedAugmentationKernels.h"
+#endif
+
+namespace fl {
+namespace pkg {
+namespace vision {
+
+namespace {
+
+float randomFloat(float a, float b) {
+  float r = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
+  return a + (b - a) * r;
+}
+
+int numChannels(const Tensor& image) {
+  return image.ndim() < 3 ? 1 : image.dim(2);
+}
+
+detail::FusedAugmentMix toPixelMix(const BatchMix& mix) {
+  return {mix.mixupLambda, mix.cutX1, mix.cutX2, mix.cutY1, mix.cutY2};
+}
+
+template <typename T>
+Tensor fusedAugmentHost(
+    const std::vector<Tensor>& images,
+    std::vector<detail::FusedAugmentImage> pixelImages,
+    const int C,
+    const int size,
+    const std::vector<float>& mean,
+    const std::vector<float>& std,
+    const BatchMix& mix) {
+  const int B = images.size();
+  std::vector<std::vector<T>> pixels(B);
+  for (int b = 0; b < B; ++b) {
+    pixels[b] = images[b].toHostVector<T>();
+    pixelImages[b].data = pixels[b].data();
+  }
+  std::vector<float> out(static_cast<size_t>(size) * size * C * B);
+  const auto pixelMix = toPixelMix(mix);
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i] = detail::fusedAugmentElement<T>(
+        pixelImages.data(),
+        B,
+        C,
+        size,
+        mean.data(),
+        std.data(),
+        pixelMix,
+        i);
+  }
+  return Tensor::fromVector({size, size, C, B}, out);
+}
+
+#if FL_BACKEND_CUDA
+Tensor fusedAugmentDevice(
+    const std::vector<Tensor>& images,
+    std::vector<detail::FusedAugmentImage> pixelImages,
+    const int C,
+    const int size,
+    const std::vector<float>& mean,
+    const std::vector<float>& std,
+    const BatchMix& mix) {
+  const int B = images.size();
+  Tensor out({size, size, C, B}, fl::dtype::f32);
+  relativeSync(out.stream(), images);
+
+  std::vector<fl::DevicePtr> imagePtrs;
+  imagePtrs.reserve(B);
+  for (int b = 0; b < B; ++b) {
+    imagePtrs.emplace_back(images[b]);
+    pixelImages[b].data = imagePtrs.back().get();
+  }
+  // the descriptors of the images are copied to the device along with the
+  // normalization, in a single buffer each
+  auto imagesBuffer = Tensor::fromBuffer(
+      {static_cast<Dim>(pixelImages.size() * sizeof(pixelImages[0]))},
+      reinterpret_cast<const uint8_t*>(pixelImages.data()),
+      MemoryLocation::Host);
+  std::vector<float> normalization(mean);
+  normalization.insert(normalization.end(), std.begin(), std.end());
+  auto normalizationBuffer = Tensor::fromVector(normalization);
+
+  {
+    fl::DevicePtr imagesRaw(imagesBuffer);
+    fl::DevicePtr normalizationRaw(normalizationBuffer);
+    fl::DevicePtr outRaw(out);
+    const auto* normalizationPtr =
+        static_cast<const float*>(normalizationRaw.get());
+    detail::fusedAugmentCuda(
+        static_cast<const detail::FusedAugmentImage*>(imagesRaw.get()),
+        B,
+        C,
+        size,
+        normalizationPtr,
+        normalizationPtr + C,
+        toPixelMix(mix),
+        images.front().type() == fl::dtype::f32,
+        static_cast<float*>(outRaw.get()),
+        out.stream().impl<CUDAStream>().handle());
+  }
+  return out;
+}
+#endif // FL_BACKEND_CUDA
+
+} // namespace
+
+ResizeCropFlipParams sampleResizeCropFlip(
+    const int w,
+    const int h,
+    const float scaleLow,
+    const float scaleHigh,
+    const float ratioLow,
+    const float ratioHigh,
+    const float flipP /* = 0.5 */) {
+  // as randomHorizontalFlipTransform
+  const bool flip =
+      static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) > flipP;
+  const float area = w * h;
+  for (int i = 0; i < 10; i++) {
+    const float scale = randomFloat(scaleLow, scaleHigh);
+    const float logRatio = randomFloat(std::log(ratioLow), std::log(ratioHigh));
+    const float targetArea = scale * area;
+    const float targetRatio = std::exp(logRatio);
+    const int tw = std::round(std::sqrt(targetArea * targetRatio));
+    const int th = std::round(std::sqrt(targetArea / targetRatio));
+    if (0 < tw && tw <= w && 0 < th && th <= h) {
+      const int x = std::rand() % (w - tw + 1);
+      const int y = std::rand() % (h - th + 1);
+      return {x, y, tw, th, flip};
+    }
+  }
+  // the center crop of the resized image, as randomResizeCropTransform
+  const int side = std::min(w, h);
+  return {(w - side) / 2, (h - side) / 2, side, side, flip};
+}
+
+float BatchMix::targetLambda(const int size) const {
+  const float cutArea = static_cast<float>(std::max(0, cutX2 - cutX1)) *
+      std::max(0, cutY2 - cutY1) / (static_cast<float>(size) * size);
+  return mixupLambda + (1 - mixupLambda) * cutArea;
+}
+
+BatchMix sampleCutmix(const float lambda, const int size) {
+  BatchMix mix;
+  if (lambda == 0) {
+    return mix;
+  }
+  const float lambdaSqrt = std::sqrt(lambda);
+  const int maskSize = std::round(size * lambdaSqrt);
+  const int centerW = randomFloat(0, size);
+  const int centerH = randomFloat(0, size);
+  mix.cutX1 = std::max(0, centerW - maskSize / 2);
+  mix.cutX2 = std::min(size, centerW + maskSize / 2 + 1);
+  mix.cutY1 = std::max(0, centerH - maskSize / 2);
+  mix.cutY2 = std::min(size, centerH + maskSize / 2 + 1);
+  return mix;
+}
+
+Tensor fusedAugmentBatch(
+    const std::vector<Tensor>& images,
+    const std::vector<ResizeCropFlipParams>& params,
+    const int size,
+    const std::vector<float>& mean,
+    const std::vector<float>& std,
+    const BatchMix& mix /* = BatchMix() */) {
+  if (images.empty() || images.size() != params.size()) {
+    throw std::invalid_argument(
+        "fusedAugmentBatch - expected the parameters of each image");
+  }
+  if (size <= 0) {
+    throw std::invalid_argument("fusedAugmentBatch - size must be positive");
+  }
+  const int C = numChannels(images.front());
+  const auto type = images.front().type();
+  if (type != fl::dtype::u8 && type != fl::dtype::f32) {
+    throw std::invalid_argument(
+        "fusedAugmentBatch - images must be uint8 or float");
+  }
+  if (mean.size() != static_cast<size_t>(C) ||
+      std.size() != static_cast<size_t>(C)) {
+    throw std::invalid_argument(
+        "fusedAugmentBatch - expected the mean and std of each channel");
+  }
+
+  std::vector<detail::FusedAugmentImage> pixelImages(images.size());
+  for (size_t b = 0; b < images.size(); ++b) {
+    const auto& image = images[b];
+    const auto& p = params[b];
+    if (numChannels(image) != C || image.type() != type) {
+      throw std::invalid_argument(
+          "fusedAugmentBatch - images must have the same channels and type");
+    }
+    const int w = image.dim(0);
+    const int h = image.dim(1);
+    if (p.x < 0 || p.y < 0 || p.w <= 0 || p.h <= 0 || p.x + p.w > w ||
+        p.y + p.h > h) {
+      throw std::invalid_argument(
+          "fusedAugmentBatch - the crop of image " + std::to_string(b) +
+          " is out of the image");
+    }
+    pixelImages[b] = {nullptr, w, h, p.x, p.y, p.w, p.h, p.flip ? 1 : 0};
+  }
+
+#if FL_BACKEND_CUDA
+  return fusedAugmentDevice(images, pixelImages, C, size, mean, std, mix);
+#else
+  if (type == fl::dtype::f32) {
+    return fusedAugmentHost<float>(
+        images, pixelImages, C, size, mean, std, mix);
+  }
+  return fusedAugmentHost<uint8_t>(
+      images, pixelImages, C, size, mean, std, mix);
+#endif
+}
+
+} // namespace vision
+} // namespace pkg
+} // namespace fl
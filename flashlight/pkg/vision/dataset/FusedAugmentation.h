@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "flashlight/fl/tensor/TensorBase.h"
+
+namespace fl {
+namespace pkg {
+namespace vision {
+
+/*
+ * The random parameters of the fused augmentation of an image: the crop box
+ * of the image, which is resized to the output size, and a horizontal flip.
+ */
+struct ResizeCropFlipParams {
+  int x;
+  int y;
+  int w;
+  int h;
+  bool flip;
+};
+
+/*
+ * Samples the parameters of `randomResizeCropTransform` followed by
+ * `randomHorizontalFlipTransform(flipP)` for a w x h image.
+ */
+ResizeCropFlipParams sampleResizeCropFlip(
+    const int w,
+    const int h,
+    const float scaleLow,
+    const float scaleHigh,
+    const float ratioLow,
+    const float ratioHigh,
+    const float flipP = 0.5);
+
+/*
+ * The mix of each image of a batch with the image at the mirrored position of
+ * the batch, i.e. of the batch flipped as by `mixupBatch` and `cutmixBatch`:
+ * the pixels in the cutmix box [cutX1, cutX2) x [cutY1, cutY2) of the output
+ * are taken from the mirrored image, and the result is then blended with it
+ * with weight mixupLambda.
+ */
+struct BatchMix {
+  float mixupLambda{0};
+  int cutX1{0};
+  int cutX2{0};
+  int cutY1{0};
+  int cutY2{0};
+
+  /*
+   * The weight of the mirrored targets, for `mixTargets`
+   */
+  float targetLambda(const int size) const;
+};
+
+/*
+ * Samples the cutmix box of a size x size batch as `cutmixBatch`.
+ */
+BatchMix sampleCutmix(const float lambda, const int size);
+
+/*
+ * Augments a batch of images in a single pass over the output: crops each
+ * W x H x C image, resizes the crop bilinearly to size x size, flips it,
+ * normalizes it as `normalizeImage` and mixes it with the mirrored image as
+ * specified by `mix`. With the CUDA backend, it runs as a single kernel over
+ * the images in device memory.
+ *
+ * Replaces `compose({randomResizeCropTransform, randomHorizontalFlipTransform,
+ * normalizeImage})` per image, batching, and `mixupBatch` or `cutmixBatch`,
+ * without intermediate tensors.
+ *
+ * @param images the uint8 or float images, of the same number of channels
+ * @param params the crop and flip of each image
+ * @return the size x size x C x B float batch
+ */
+Tensor fusedAugmentBatch(
+    const std::vector<Tensor>& images,
+    const std::vector<ResizeCropFlipParams>& params,
+    const int size,
+    const std::vector<float>& mean,
+    const std::vector<float>& std,
+    const BatchMix& mix = BatchMix());
+
+} // namespace vision
+} // namespace pkg
+} // namespace fl
@@ -9,9 +9,12 @@
 
 #include <glob.h>
 #include <algorithm>
+#include <cmath>
+#include <numeric>
 
 #include "flashlight/fl/dataset/datasets.h"
 #include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/pkg/vision/dataset/FusedAugmentation.h"
 #include "flashlight/pkg/vision/dataset/Jpeg.h"
 #include "flashlight/pkg/vision/dataset/LoaderDataset.h"
 #include "flashlight/pkg/vision/dataset/Transforms.h"
@@ -32,6 +35,19 @@ std::vector<std::string> fileGlob(const std::string& pattern) {
   return ret;
 }
 
+uint64_t getLabelIdx(
+    const std::string& s,
+    const std::unordered_map<std::string, uint64_t>& labelMap) {
+  std::string parentPath = s.substr(0, s.rfind("/"));
+  std::string label = parentPath.substr(parentPath.rfind("/") + 1);
+  if (labelMap.find(label) != labelMap.end()) {
+    return labelMap.at(label);
+  } else {
+    throw std::runtime_error("Label: " + label + " not found in label map");
+  }
+  return labelMap.at(label);
+}
+
 } // namespace
 namespace fl {
 namespace pkg {
@@ -86,14 +102,7 @@ std::shared_ptr<Dataset> imagenetDataset(
 
   // Create labels from filepaths
   auto getLabelIdxs = [&labelMap](const std::string& s) -> uint64_t {
-    std::string parentPath = s.substr(0, s.rfind("/"));
-    std::string label = parentPath.substr(parentPath.rfind("/") + 1);
-    if (labelMap.find(label) != labelMap.end()) {
-      return labelMap.at(label);
-    } else {
-      throw std::runtime_error("Label: " + label + " not found in label map");
-    }
-    return labelMap.at(label);
+    return getLabelIdx(s, labelMap);
   };
 
   std::vector<uint64_t> labels(filepaths.size());
@@ -108,6 +117,68 @@ std::shared_ptr<Dataset> imagenetDataset(
       MergeDataset({imageDataset, labelDataset}));
 }
 
+std::shared_ptr<Dataset> imagenetEvalDataset(
+    const fs::path& imgDir,
+    const std::unordered_map<std::string, uint64_t>& labelMap,
+    int64_t batchSize,
+    int64_t worldRank,
+    int64_t worldSize,
+    int resizeSize,
+    int cropSize,
+    const std::vector<float>& mean,
+    const std::vector<float>& std) {
+  if (batchSize <= 0 || worldSize <= 0 || worldRank < 0 ||
+      worldRank >= worldSize) {
+    throw std::invalid_argument(
+        "imagenetEvalDataset - invalid batch size or rank");
+  }
+  std::vector<std::string> filepaths = fileGlob(imgDir.string() + "/**/*.JPEG");
+  if (filepaths.empty()) {
+    throw std::runtime_error(
+        "No images were found in imagenet directory: " + imgDir.string());
+  }
+  // glob sorts the paths, so the shards of the ranks are disjoint
+  std::vector<std::vector<std::string>> batches;
+  std::vector<std::vector<uint64_t>> labels;
+  for (size_t i = worldRank; i < filepaths.size(); i += worldSize) {
+    if (batches.empty() ||
+        batches.back().size() == static_cast<size_t>(batchSize)) {
+      batches.emplace_back();
+      labels.emplace_back();
+    }
+    batches.back().push_back(filepaths[i]);
+    labels.back().push_back(getLabelIdx(filepaths[i], labelMap));
+  }
+
+  std::vector<int64_t> batchIdxs(batches.size());
+  std::iota(batchIdxs.begin(), batchIdxs.end(), 0);
+  return std::make_shared<LoaderDataset<int64_t>>(
+      batchIdxs,
+      [batches = std::move(batches),
+       labels = std::move(labels),
+       resizeSize,
+       cropSize,
+       mean,
+       std](const int64_t& idx) {
+        auto images = loadJpegBatch(batches[idx]);
+        // the crop of the center of the image resized to resizeSize on its
+        // smallest side, in the coordinates of the image
+        std::vector<ResizeCropFlipParams> params;
+        for (const auto& image : images) {
+          const int w = image.dim(0);
+          const int h = image.dim(1);
+          const int side = std::min(
+              std::min(w, h),
+              static_cast<int>(
+                  std::round(cropSize * std::min(w, h) / float(resizeSize))));
+          params.push_back({(w - side) / 2, (h - side) / 2, side, side, false});
+        }
+        return std::vector<Tensor>{
+            fusedAugmentBatch(images, params, cropSize, mean, std),
+            Tensor::fromVector(labels[idx])};
+      });
+}
+
 } // namespace vision
 } // namespace pkg
 } // namespace fl
@@ -70,6 +70,29 @@ std::shared_ptr<Dataset> imagenetDataset(
     const std::unordered_map<std::string, uint64_t>& labelMap,
     std::vector<Dataset::TransformFunction> transformfns);
 
+/*
+ * Creates a dataset of the batches of the shard of a rank of the images in
+ * @param[imgDir], for evaluation: rank r reads the images r, r + worldSize,
+ * ... in order, in batches of batchSize. The jpegs of a batch are decoded
+ * with `loadJpegBatch`, and resized to resizeSize on their smallest side,
+ * center cropped to cropSize and normalized in a single pass with
+ * `fusedAugmentBatch`, as `compose({resizeTransform(resizeSize),
+ * centerCropTransform(cropSize), normalizeImage(mean, std)})` up to
+ * interpolation.
+ *
+ * Samples are the cropSize x cropSize x 3 x B images and B labels of a batch.
+ */
+std::shared_ptr<Dataset> imagenetEvalDataset(
+    const fs::path& imgDir,
+    const std::unordered_map<std::string, uint64_t>& labelMap,
+    int64_t batchSize,
+    int64_t worldRank,
+    int64_t worldSize,
+    int resizeSize,
+    int cropSize,
+    const std::vector<float>& mean,
+    const std::vector<float>& std);
+
 constexpr uint64_t kImagenetInputIdx = 0;
 constexpr uint64_t kImagenetTargetIdx = 1;
 
@@ -7,7 +7,9 @@
 
 #include "flashlight/pkg/vision/dataset/Jpeg.h"
 
+#include <fstream>
 #include <memory>
+#include <stdexcept>
 
 #include "flashlight/fl/dataset/datasets.h"
 #include "flashlight/pkg/vision/dataset/LoaderDataset.h"
@@ -15,41 +17,329 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#if FL_VISION_USE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+#if FL_VISION_USE_NVJPEG
+#include <nvjpeg.h>
+
+#include "flashlight/fl/common/DevicePtr.h"
+#include "flashlight/fl/runtime/CUDAStream.h"
+#endif
+
 namespace fl {
 namespace pkg {
 namespace vision {
 
-/*
- * Loads a jpeg from filepath fp. Note: It will automatically convert from any
- * number of channels to create an array with 3 channels
- */
-Tensor loadJpeg(const std::string& fp, int desiredNumberOfChannels /* = 3 */) {
+namespace {
+
+std::vector<unsigned char> readFile(const std::string& fp) {
+  std::ifstream file(fp, std::ios::binary | std::ios::ate);
+  if (!file) {
+    throw std::invalid_argument("Could not load from filepath" + fp);
+  }
+  std::vector<unsigned char> data(file.tellg());
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char*>(data.data()), data.size())) {
+    throw std::invalid_argument("Could not load from filepath" + fp);
+  }
+  return data;
+}
+
+// Creates a W x H x C image from C x W x H interleaved pixels
+Tensor fromInterleaved(
+    const unsigned char* pixels,
+    int width,
+    int height,
+    int channels) {
+  Tensor result = Tensor::fromBuffer(
+      {channels, width, height}, pixels, MemoryLocation::Host);
+  return fl::transpose(result, {1, 2, 0});
+}
+
+Tensor loadJpegStb(const std::string& fp, int desiredNumberOfChannels) {
   int w, h, c;
   // STB image will automatically return desiredNumberOfChannels.
   // NB: c will be the original number of channels
   unsigned char* img =
       stbi_load(fp.c_str(), &w, &h, &c, desiredNumberOfChannels);
   if (img) {
-    // Load array first as C X W X H, since stb has channel along first
-    // dimension
-    Tensor result = Tensor::fromBuffer(
-        {desiredNumberOfChannels, w, h}, img, MemoryLocation::Host);
+    // stb has channel along first dimension
+    auto result = fromInterleaved(img, w, h, desiredNumberOfChannels);
     stbi_image_free(img);
-    // Then reorder to W X H X C
-    return fl::transpose(result, {1, 2, 0});
+    return result;
   } else {
     throw std::invalid_argument("Could not load from filepath" + fp);
   }
 }
 
-std::shared_ptr<Dataset> jpegLoader(std::vector<std::string> fps) {
+#if FL_VISION_USE_TURBOJPEG
+struct TurboJpegDeleter {
+  void operator()(void* handle) const {
+    tjDestroy(handle);
+  }
+};
+
+tjhandle turboJpegHandle() {
+  // handles are not thread-safe, loaders decode from many threads
+  thread_local std::unique_ptr<void, TurboJpegDeleter> handle(
+      tjInitDecompress());
+  return handle.get();
+}
+
+/*
+ * Decodes a jpeg with libjpeg-turbo, at the smallest scale of the DCT whose
+ * sides are at least minSize. Returns an empty tensor if the data isn't a jpeg
+ * or the number of channels isn't supported, such that stb decodes it.
+ */
+Tensor loadJpegTurbo(
+    const std::vector<unsigned char>& data,
+    int desiredNumberOfChannels,
+    int minSize) {
+  int pixelFormat;
+  switch (desiredNumberOfChannels) {
+    case 1:
+      pixelFormat = TJPF_GRAY;
+      break;
+    case 3:
+      pixelFormat = TJPF_RGB;
+      break;
+    case 4:
+      pixelFormat = TJPF_RGBA;
+      break;
+    default:
+      return Tensor();
+  }
+  auto handle = turboJpegHandle();
+  int w, h, subsampling, colorspace;
+  if (!handle ||
+      tjDecompressHeader3(
+          handle,
+          data.data(),
+          data.size(),
+          &w,
+          &h,
+          &subsampling,
+          &colorspace) != 0) {
+    return Tensor();
+  }
+
+  int scaledW = w;
+  int scaledH = h;
+  if (minSize > 0) {
+    int nFactors = 0;
+    const tjscalingfactor* factors = tjGetScalingFactors(&nFactors);
+    for (int i = 0; i < nFactors; ++i) {
+      if (factors[i].num > factors[i].denom) {
+        continue;
+      }
+      const int sw = TJSCALED(w, factors[i]);
+      const int sh = TJSCALED(h, factors[i]);
+      if (sw >= minSize && sh >= minSize && sw * sh < scaledW * scaledH) {
+        scaledW = sw;
+        scaledH = sh;
+      }
+    }
+  }
+
+  std::vector<unsigned char> pixels(
+      static_cast<size_t>(scaledW) * scaledH * desiredNumberOfChannels);
+  if (tjDecompress2(
+          handle,
+          data.data(),
+          data.size(),
+          pixels.data(),
+          scaledW,
+          /* pitch = */ 0,
+          scaledH,
+          pixelFormat,
+          /* flags = */ 0) != 0) {
+    return Tensor();
+  }
+  return fromInterleaved(
+      pixels.data(), scaledW, scaledH, desiredNumberOfChannels);
+}
+#endif // FL_VISION_USE_TURBOJPEG
+
+#if FL_VISION_USE_NVJPEG
+void checkNvJpeg(nvjpegStatus_t status, const char* call) {
+  if (status != NVJPEG_STATUS_SUCCESS) {
+    throw std::runtime_error(
+        std::string("loadJpegBatch - ") + call + " failed with status " +
+        std::to_string(static_cast<int>(status)));
+  }
+}
+
+struct NvJpegDecoder {
+  nvjpegHandle_t handle{nullptr};
+  nvjpegJpegState_t state{nullptr};
+
+  NvJpegDecoder() {
+    checkNvJpeg(nvjpegCreateSimple(&handle), "nvjpegCreateSimple");
+    checkNvJpeg(nvjpegJpegStateCreate(handle, &state), "nvjpegJpegStateCreate");
+  }
+
+  ~NvJpegDecoder() {
+    nvjpegJpegStateDestroy(state);
+    nvjpegDestroy(handle);
+  }
+};
+
+/*
+ * Decodes a batch of jpegs on the GPU, into device tensors. The images which
+ * nvJPEG can't decode are returned empty.
+ */
+std::vector<Tensor> loadJpegBatchNvJpeg(
+    const std::vector<std::vector<unsigned char>>& data,
+    int desiredNumberOfChannels) {
+  // the state of a batched decode is used by a single thread at a time
+  thread_local NvJpegDecoder decoder;
+  const nvjpegOutputFormat_t format =
+      desiredNumberOfChannels == 1 ? NVJPEG_OUTPUT_Y : NVJPEG_OUTPUT_RGBI;
+
+  std::vector<Tensor> pixels(data.size());
+  std::vector<int> widths(data.size());
+  std::vector<int> heights(data.size());
+  std::vector<size_t> batch;
+  for (size_t i = 0; i < data.size(); ++i) {
+    int nComponents;
+    nvjpegChromaSubsampling_t subsampling;
+    int w[NVJPEG_MAX_COMPONENT];
+    int h[NVJPEG_MAX_COMPONENT];
+    if (nvjpegGetImageInfo(
+            decoder.handle,
+            data[i].data(),
+            data[i].size(),
+            &nComponents,
+            &subsampling,
+            w,
+            h) != NVJPEG_STATUS_SUCCESS) {
+      continue;
+    }
+    widths[i] = w[0];
+    heights[i] = h[0];
+    pixels[i] = Tensor(
+        {desiredNumberOfChannels, widths[i], heights[i]}, fl::dtype::u8);
+    batch.push_back(i);
+  }
+  if (batch.empty()) {
+    return std::vector<Tensor>(data.size());
+  }
+
+  std::vector<const unsigned char*> buffers;
+  std::vector<size_t> lengths;
+  std::vector<nvjpegImage_t> destinations(batch.size());
+  std::vector<std::unique_ptr<fl::DevicePtr>> devicePtrs;
+  for (size_t b = 0; b < batch.size(); ++b) {
+    const auto i = batch[b];
+    buffers.push_back(data[i].data());
+    lengths.push_back(data[i].size());
+    devicePtrs.push_back(std::make_unique<fl::DevicePtr>(pixels[i]));
+    // a single interleaved plane, or the luma plane
+    destinations[b].channel[0] =
+        static_cast<unsigned char*>(devicePtrs.back()->get());
+    destinations[b].pitch[0] = widths[i] * desiredNumberOfChannels;
+  }
+
+  auto stream = pixels[batch.front()].stream().impl<CUDAStream>().handle();
+  checkNvJpeg(
+      nvjpegDecodeBatchedInitialize(
+          decoder.handle,
+          decoder.state,
+          batch.size(),
+          /* maxCpuThreads = */ 1,
+          format),
+      "nvjpegDecodeBatchedInitialize");
+  checkNvJpeg(
+      nvjpegDecodeBatched(
+          decoder.handle,
+          decoder.state,
+          buffers.data(),
+          lengths.data(),
+          destinations.data(),
+          stream),
+      "nvjpegDecodeBatched");
+  devicePtrs.clear();
+
+  std::vector<Tensor> result(data.size());
+  for (const auto i : batch) {
+    result[i] = fl::transpose(pixels[i], {1, 2, 0});
+  }
+  return result;
+}
+#endif // FL_VISION_USE_NVJPEG
+
+} // namespace
+
+/*
+ * Loads a jpeg from filepath fp. Note: It will automatically convert from any
+ * number of channels to create an array with 3 channels
+ */
+Tensor loadJpeg(
+    const std::string& fp,
+    int desiredNumberOfChannels /* = 3 */,
+    int minSize /* = 0 */) {
+#if FL_VISION_USE_TURBOJPEG
+  auto result = loadJpegTurbo(readFile(fp), desiredNumberOfChannels, minSize);
+  if (!result.isEmpty()) {
+    return result;
+  }
+#endif
+  return loadJpegStb(fp, desiredNumberOfChannels);
+}
+
+std::vector<Tensor> loadJpegBatch(
+    const std::vector<std::string>& fps,
+    int desiredNumberOfChannels /* = 3 */) {
+  std::vector<Tensor> result;
+#if FL_VISION_USE_NVJPEG
+  if (desiredNumberOfChannels == 1 || desiredNumberOfChannels == 3) {
+    std::vector<std::vector<unsigned char>> data;
+    for (const auto& fp : fps) {
+      data.push_back(readFile(fp));
+    }
+    result = loadJpegBatchNvJpeg(data, desiredNumberOfChannels);
+  }
+#endif
+  result.resize(fps.size());
+  for (size_t i = 0; i < fps.size(); ++i) {
+    if (result[i].isEmpty()) {
+      result[i] = loadJpeg(fps[i], desiredNumberOfChannels);
+    }
+  }
+  return result;
+}
+
+std::shared_ptr<Dataset> jpegLoader(
+    std::vector<std::string> fps,
+    int minSize /* = 0 */) {
   return std::make_shared<LoaderDataset<std::string>>(
-      fps, [](const std::string& fp) {
-        std::vector<Tensor> result = {loadJpeg(fp)};
+      fps, [minSize](const std::string& fp) {
+        std::vector<Tensor> result = {loadJpeg(fp, 3, minSize)};
         return result;
       });
 }
 
+std::shared_ptr<Dataset> jpegBatchLoader(
+    const std::vector<std::string>& fps,
+    int64_t batchSize) {
+  if (batchSize <= 0) {
+    throw std::invalid_argument("jpegBatchLoader - batchSize must be positive");
+  }
+  std::vector<std::vector<std::string>> batches;
+  for (size_t i = 0; i < fps.size(); i += batchSize) {
+    batches.emplace_back(
+        fps.begin() + i,
+        fps.begin() + std::min(fps.size(), i + batchSize));
+  }
+  return std::make_shared<LoaderDataset<std::vector<std::string>>>(
+      batches,
+      [](const std::vector<std::string>& batch) {
+        return loadJpegBatch(batch);
+      });
+}
+
 } // namespace vision
 } // namespace pkg
 } // namespace fl
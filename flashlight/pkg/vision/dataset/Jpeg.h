@@ -8,6 +8,8 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "flashlight/fl/dataset/datasets.h"
 
@@ -15,9 +17,40 @@ namespace fl {
 namespace pkg {
 namespace vision {
 
-Tensor loadJpeg(const std::string& fp, int desiredNumberOfChannels = 3);
+/*
+ * Loads an image of size W x H x C from filepath fp. Jpegs are decoded with
+ * libjpeg-turbo when available, otherwise with stb.
+ *
+ * @param minSize if positive, jpegs may be decoded at a reduced scale of the
+ * DCT (down to 1/8) whose width and height are both at least minSize, which
+ * is much faster when the image is resized to a small size afterwards.
+ * Requires libjpeg-turbo: images are otherwise decoded at full resolution.
+ */
+Tensor loadJpeg(
+    const std::string& fp,
+    int desiredNumberOfChannels = 3,
+    int minSize = 0);
 
-std::shared_ptr<Dataset> jpegLoader(std::vector<std::string> fps);
+/*
+ * Loads a batch of images, of size W x H x C each. With nvJPEG, the jpegs are
+ * decoded in a single batched call on the GPU and returned as device tensors,
+ * while other images, e.g. of another format, are decoded with `loadJpeg`.
+ */
+std::vector<Tensor> loadJpegBatch(
+    const std::vector<std::string>& fps,
+    int desiredNumberOfChannels = 3);
+
+std::shared_ptr<Dataset> jpegLoader(
+    std::vector<std::string> fps,
+    int minSize = 0);
+
+/*
+ * A dataset whose samples are the images of consecutive batches of batchSize
+ * filepaths, decoded with `loadJpegBatch`.
+ */
+std::shared_ptr<Dataset> jpegBatchLoader(
+    const std::vector<std::string>& fps,
+    int64_t batchSize);
 
 } // namespace vision
 } // namespace pkg
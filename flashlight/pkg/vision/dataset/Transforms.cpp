@@ -200,6 +200,20 @@ Tensor oneHot(
   return out;
 }
 
+Tensor mixTargets(
+    const float lambda,
+    const Tensor& target,
+    const int numClasses,
+    const float labelSmoothing) {
+  auto targetOneHot = oneHot(target, numClasses, labelSmoothing);
+  if (lambda == 0) {
+    return targetOneHot;
+  }
+  auto targetOneHotFlipped =
+      oneHot(fl::flip(target, 0), numClasses, labelSmoothing);
+  return lambda * targetOneHotFlipped + (1 - lambda) * targetOneHot;
+}
+
 std::pair<Tensor, Tensor> mixupBatch(
     const float lambda,
     const Tensor& input,
@@ -218,12 +232,7 @@ std::pair<Tensor, Tensor> mixupBatch(
   auto inputMixed = lambda * inputFlipped + (1 - lambda) * input;
 
   // mix target
-  auto targetOneHotFlipped =
-      oneHot(fl::flip(target, 0), numClasses, labelSmoothing);
-  auto targetOneHotMixed =
-      lambda * targetOneHotFlipped + (1 - lambda) * targetOneHot;
-
-  return {inputMixed, targetOneHotMixed};
+  return {inputMixed, mixTargets(lambda, target, numClasses, labelSmoothing)};
 }
 
 std::pair<Tensor, Tensor> cutmixBatch(
@@ -261,12 +270,8 @@ std::pair<Tensor, Tensor> cutmixBatch(
   auto newLambda = static_cast<float>(x2 - x1) * (y2 - y1) / (w * h);
 
   // mix target
-  auto targetOneHotFlipped =
-      oneHot(fl::flip(target, 0), numClasses, labelSmoothing);
-  auto targetOneHotMixed =
-      newLambda * targetOneHotFlipped + (1 - newLambda) * targetOneHot;
-
-  return {inputMixed, targetOneHotMixed};
+  return {
+      inputMixed, mixTargets(newLambda, target, numClasses, labelSmoothing)};
 }
 
 ImageTransform resizeTransform(const uint64_t resize) {
@@ -139,6 +139,16 @@ Tensor posterize(const Tensor& input, const int bitsToKeep);
 Tensor
 oneHot(const Tensor& targets, const int numClasses, const float labelSmoothing);
 
+/*
+ * Mix the one-hot targets of a batch with the targets of the batch flipped,
+ * the latter with weight @param lambda
+ */
+Tensor mixTargets(
+    const float lambda,
+    const Tensor& target,
+    const int numClasses,
+    const float labelSmoothing);
+
 /*
  * Apply mixup for a given batch as in https://arxiv.org/abs/1710.09412
  */
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#ifndef FL_VISION_HOST_DEVICE
+#ifdef __CUDACC__
+#define FL_VISION_HOST_DEVICE __host__ __device__
+#else
+#define FL_VISION_HOST_DEVICE
+#endif
+#endif
+
+namespace fl {
+namespace pkg {
+namespace vision {
+namespace detail {
+
+/**
+ * The sets of boxes of a pairwise iou: S x N x B and S x M x B, whose first 4
+ * rows are the x1, y1, x2, y2 coordinates of each box.
+ */
+struct BoxIouSets {
+  const float* boxes1;
+  const float* boxes2;
+  int stride1;
+  int stride2;
+  int N;
+  int M;
+  int B;
+};
+
+FL_VISION_HOST_DEVICE inline float boxMax(float a, float b) {
+  return a > b ? a : b;
+}
+
+FL_VISION_HOST_DEVICE inline float boxMin(float a, float b) {
+  return a < b ? a : b;
+}
+
+/**
+ * The iou, or generalized iou, of boxes a and c, and their union.
+ */
+FL_VISION_HOST_DEVICE inline float
+boxPairIou(const float* a, const float* c, bool generalized, float* uni) {
+  const float areaA = (a[2] - a[0]) * (a[3] - a[1]);
+  const float areaC = (c[2] - c[0]) * (c[3] - c[1]);
+  const float iw = boxMax(boxMin(a[2], c[2]) - boxMax(a[0], c[0]), 0.f);
+  const float ih = boxMax(boxMin(a[3], c[3]) - boxMax(a[1], c[1]), 0.f);
+  const float inter = iw * ih;
+  *uni = areaA + areaC - inter;
+  const float iou = inter / *uni;
+  if (!generalized) {
+    return iou;
+  }
+  const float ew = boxMax(boxMax(a[2], c[2]) - boxMin(a[0], c[0]), 0.f);
+  const float eh = boxMax(boxMax(a[3], c[3]) - boxMin(a[1], c[1]), 0.f);
+  const float enclosure = ew * eh;
+  return iou - (enclosure - *uni) / enclosure;
+}
+
+/**
+ * Accumulates g times the gradients of the iou, or generalized iou, of boxes
+ * a and c with respect to their coordinates in dA and dC. The gradient of a
+ * max or min of two coordinates goes to a on ties.
+ */
+FL_VISION_HOST_DEVICE inline void boxPairIouGrad(
+    const float* a,
+    const float* c,
+    float g,
+    bool generalized,
+    float* dA,
+    float* dC) {
+  const float aw = a[2] - a[0];
+  const float ah = a[3] - a[1];
+  const float cw = c[2] - c[0];
+  const float ch = c[3] - c[1];
+  const bool aLeft = a[0] >= c[0];
+  const bool aTop = a[1] >= c[1];
+  const bool aRight = a[2] <= c[2];
+  const bool aBottom = a[3] <= c[3];
+  const float iwRaw = (aRight ? a[2] : c[2]) - (aLeft ? a[0] : c[0]);
+  const float ihRaw = (aBottom ? a[3] : c[3]) - (aTop ? a[1] : c[1]);
+  const float iw = boxMax(iwRaw, 0.f);
+  const float ih = boxMax(ihRaw, 0.f);
+  const float inter = iw * ih;
+  const float uni = aw * ah + cw * ch - inter;
+
+  // iou = inter / uni, where uni = areaA + areaC - inter
+  float gInter = g * (uni + inter) / (uni * uni);
+  float gArea = -g * inter / (uni * uni);
+  if (generalized) {
+    // giou = iou - 1 + uni / enclosure
+    const bool aMinX = a[0] <= c[0];
+    const bool aMinY = a[1] <= c[1];
+    const bool aMaxX = a[2] >= c[2];
+    const bool aMaxY = a[3] >= c[3];
+    const float ewRaw = (aMaxX ? a[2] : c[2]) - (aMinX ? a[0] : c[0]);
+    const float ehRaw = (aMaxY ? a[3] : c[3]) - (aMinY ? a[1] : c[1]);
+    const float ew = boxMax(ewRaw, 0.f);
+    const float eh = boxMax(ehRaw, 0.f);
+    const float enclosure = ew * eh;
+    gInter -= g / enclosure;
+    gArea += g / enclosure;
+    const float gEnclosure = -g * uni / (enclosure * enclosure);
+    const float gEw = ewRaw > 0.f ? gEnclosure * eh : 0.f;
+    const float gEh = ehRaw > 0.f ? gEnclosure * ew : 0.f;
+    (aMinX ? dA : dC)[0] -= gEw;
+    (aMaxX ? dA : dC)[2] += gEw;
+    (aMinY ? dA : dC)[1] -= gEh;
+    (aMaxY ? dA : dC)[3] += gEh;
+  }
+
+  dA[0] -= gArea * ah;
+  dA[2] += gArea * ah;
+  dA[1] -= gArea * aw;
+  dA[3] += gArea * aw;
+  dC[0] -= gArea * ch;
+  dC[2] += gArea * ch;
+  dC[1] -= gArea * cw;
+  dC[3] += gArea * cw;
+
+  const float gIw = iwRaw > 0.f ? gInter * ih : 0.f;
+  const float gIh = ihRaw > 0.f ? gInter * iw : 0.f;
+  (aLeft ? dA : dC)[0] -= gIw;
+  (aRight ? dA : dC)[2] += gIw;
+  (aTop ? dA : dC)[1] -= gIh;
+  (aBottom ? dA : dC)[3] += gIh;
+}
+
+/**
+ * Element i of the N x M x B pairwise iou, or generalized iou, and union.
+ */
+FL_VISION_HOST_DEVICE inline void pairwiseBoxIouElement(
+    const BoxIouSets& sets,
+    bool generalized,
+    size_t i,
+    float* iou,
+    float* uni) {
+  const size_t n = i % sets.N;
+  const size_t m = (i / sets.N) % sets.M;
+  const size_t b = i / (static_cast<size_t>(sets.N) * sets.M);
+  const float* a = sets.boxes1 + (b * sets.N + n) * sets.stride1;
+  const float* c = sets.boxes2 + (b * sets.M + m) * sets.stride2;
+  iou[i] = boxPairIou(a, c, generalized, uni + i);
+}
+
+/**
+ * The gradient of box j of the first set, or of the second one, given the
+ * N x M x B gradient of the pairwise iou: the sum of the gradients of its
+ * pairs, in a single pass over the other set.
+ */
+FL_VISION_HOST_DEVICE inline void pairwiseBoxIouGradElement(
+    const BoxIouSets& sets,
+    const float* gradOutput,
+    bool generalized,
+    bool second,
+    size_t j,
+    float* grad) {
+  const int size = second ? sets.M : sets.N;
+  const int other = second ? sets.N : sets.M;
+  const int stride = second ? sets.stride2 : sets.stride1;
+  const size_t k = j % size;
+  const size_t b = j / size;
+  const float* box = (second ? sets.boxes2 : sets.boxes1) + j * stride;
+  float dBox[4] = {0.f, 0.f, 0.f, 0.f};
+  for (int o = 0; o < other; ++o) {
+    float dOther[4] = {0.f, 0.f, 0.f, 0.f};
+    const float* otherBox = second
+        ? sets.boxes1 + (b * sets.N + o) * sets.stride1
+        : sets.boxes2 + (b * sets.M + o) * sets.stride2;
+    const size_t n = second ? o : k;
+    const size_t m = second ? k : o;
+    const float g = gradOutput[(b * sets.M + m) * sets.N + n];
+    if (second) {
+      boxPairIouGrad(otherBox, box, g, generalized, dOther, dBox);
+    } else {
+      boxPairIouGrad(box, otherBox, g, generalized, dBox, dOther);
+    }
+  }
+  for (int r = 0; r < stride; ++r) {
+    grad[j * stride + r] = r < 4 ? dBox[r] : 0.f;
+  }
+}
+
+} // namespace detail
+} // namespace vision
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#ifndef FL_VISION_HOST_DEVICE
+#ifdef __CUDACC__
+#define FL_VISION_HOST_DEVICE __host__ __device__
+#else
+#define FL_VISION_HOST_DEVICE
+#endif
+#endif
+
+namespace fl {
+namespace pkg {
+namespace vision {
+namespace detail {
+
+/**
+ * An image of the fused augmentation, with its W x H x C pixels and its
+ * random crop box and flip.
+ */
+struct FusedAugmentImage {
+  const void* data;
+  int width;
+  int height;
+  int cropX;
+  int cropY;
+  int cropW;
+  int cropH;
+  int flip;
+};
+
+/**
+ * The mix of each image of a batch with the image at the mirrored batch
+ * position: a cutmix box of the output, and a mixup weight.
+ */
+struct FusedAugmentMix {
+  float mixupLambda;
+  int cutX1;
+  int cutX2;
+  int cutY1;
+  int cutY2;
+};
+
+/**
+ * Bilinear sample of pixel (x, y) of channel c of the size x size resized
+ * crop of an image.
+ */
+template <typename T>
+FL_VISION_HOST_DEVICE inline float
+sampleResizedCrop(const FusedAugmentImage& img, int size, int x, int y, int c) {
+  const T* data = static_cast<const T*>(img.data);
+  if (img.flip) {
+    x = size - 1 - x;
+  }
+  // pixel centers are aligned, as the corners of the crop and the output
+  float u = (x + 0.5f) * img.cropW / size - 0.5f;
+  float v = (y + 0.5f) * img.cropH / size - 0.5f;
+  u = u < 0.f ? 0.f : (u > img.cropW - 1.f ? img.cropW - 1.f : u);
+  v = v < 0.f ? 0.f : (v > img.cropH - 1.f ? img.cropH - 1.f : v);
+  const int x0 = static_cast<int>(u);
+  const int y0 = static_cast<int>(v);
+  const int x1 = x0 + 1 < img.cropW ? x0 + 1 : x0;
+  const int y1 = y0 + 1 < img.cropH ? y0 + 1 : y0;
+  const float ax = u - x0;
+  const float ay = v - y0;
+
+  const T* plane = data +
+      static_cast<size_t>(c) * img.width * img.height + img.cropX +
+      static_cast<size_t>(img.cropY) * img.width;
+  const T* row0 = plane + static_cast<size_t>(y0) * img.width;
+  const T* row1 = plane + static_cast<size_t>(y1) * img.width;
+  const float top =
+      (1.f - ax) * static_cast<float>(row0[x0]) + ax * row0[x1];
+  const float bottom =
+      (1.f - ax) * static_cast<float>(row1[x0]) + ax * row1[x1];
+  return (1.f - ay) * top + ay * bottom;
+}
+
+/**
+ * Element i of the size x size x C x B output of the fused augmentation:
+ * crop, resize, flip, normalize and mix.
+ */
+template <typename T>
+FL_VISION_HOST_DEVICE inline float fusedAugmentElement(
+    const FusedAugmentImage* images,
+    int B,
+    int C,
+    int size,
+    const float* mean,
+    const float* std,
+    const FusedAugmentMix& mix,
+    size_t i) {
+  const int x = i % size;
+  const int y = (i / size) % size;
+  const int c = (i / (static_cast<size_t>(size) * size)) % C;
+  const int b = i / (static_cast<size_t>(size) * size * C);
+  const int partner = B - 1 - b;
+  const bool cut =
+      x >= mix.cutX1 && x < mix.cutX2 && y >= mix.cutY1 && y < mix.cutY2;
+
+  // as normalizeImage, of pixels in [0, 255]
+  float out =
+      (sampleResizedCrop<T>(images[cut ? partner : b], size, x, y, c) / 255.f -
+       mean[c]) /
+      std[c];
+  if (mix.mixupLambda != 0.f) {
+    const float other =
+        (sampleResizedCrop<T>(images[partner], size, x, y, c) / 255.f -
+         mean[c]) /
+        std[c];
+    out = mix.mixupLambda * other + (1.f - mix.mixupLambda) * out;
+  }
+  return out;
+}
+
+} // namespace detail
+} // namespace vision
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/vision/dataset/backend/cuda/BoxIouKernels.h"
+
+#include <algorithm>
+
+#include "flashlight/fl/runtime/CUDAUtils.h"
+
+namespace fl {
+namespace pkg {
+namespace vision {
+namespace detail {
+
+namespace {
+
+constexpr int kBlockSize = 256;
+constexpr size_t kMaxBlocks = 65535;
+
+int numBlocks(size_t n) {
+  return std::min(kMaxBlocks, (n + kBlockSize - 1) / kBlockSize);
+}
+
+__global__ void pairwiseBoxIouKernel(
+    BoxIouSets sets,
+    bool generalized,
+    float* iou,
+    float* uni) {
+  const size_t n = static_cast<size_t>(sets.N) * sets.M * sets.B;
+  for (size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+       i < n;
+       i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    pairwiseBoxIouElement(sets, generalized, i, iou, uni);
+  }
+}
+
+__global__ void pairwiseBoxIouGradKernel(
+    BoxIouSets sets,
+    const float* gradOutput,
+    bool generalized,
+    bool second,
+    float* grad) {
+  const size_t n = static_cast<size_t>(second ? sets.M : sets.N) * sets.B;
+  for (size_t j = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+       j < n;
+       j += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    pairwiseBoxIouGradElement(sets, gradOutput, generalized, second, j, grad);
+  }
+}
+
+} // namespace
+
+void pairwiseBoxIouCuda(
+    BoxIouSets sets,
+    bool generalized,
+    float* iou,
+    float* uni,
+    cudaStream_t stream) {
+  const size_t n = static_cast<size_t>(sets.N) * sets.M * sets.B;
+  if (n == 0) {
+    return;
+  }
+  pairwiseBoxIouKernel<<<numBlocks(n), kBlockSize, 0, stream>>>(
+      sets, generalized, iou, uni);
+  FL_CUDA_CHECK(cudaGetLastError());
+}
+
+void pairwiseBoxIouGradCuda(
+    BoxIouSets sets,
+    const float* gradOutput,
+    bool generalized,
+    float* grad1,
+    float* grad2,
+    cudaStream_t stream) {
+  const size_t n1 = static_cast<size_t>(sets.N) * sets.B;
+  const size_t n2 = static_cast<size_t>(sets.M) * sets.B;
+  // the boxes without pairs have zero gradients, which are written too
+  if (n1 > 0) {
+    pairwiseBoxIouGradKernel<<<numBlocks(n1), kBlockSize, 0, stream>>>(
+        sets, gradOutput, generalized, /* second = */ false, grad1);
+    FL_CUDA_CHECK(cudaGetLastError());
+  }
+  if (n2 > 0) {
+    pairwiseBoxIouGradKernel<<<numBlocks(n2), kBlockSize, 0, stream>>>(
+        sets, gradOutput, generalized, /* second = */ true, grad2);
+    FL_CUDA_CHECK(cudaGetLastError());
+  }
+}
+
+} // namespace detail
+} // namespace vision
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include "flashlight/pkg/vision/dataset/backend/BoxIouPairwise.h"
+
+namespace fl {
+namespace pkg {
+namespace vision {
+namespace detail {
+
+/**
+ * Computes the N x M x B pairwise iou, or generalized iou, and union of two
+ * sets of boxes in device memory, with a thread per pair.
+ */
+void pairwiseBoxIouCuda(
+    BoxIouSets sets,
+    bool generalized,
+    float* iou,
+    float* uni,
+    cudaStream_t stream);
+
+/**
+ * Computes the gradients of the two sets of boxes given the gradient of their
+ * pairwise iou, with a thread per box.
+ */
+void pairwiseBoxIouGradCuda(
+    BoxIouSets sets,
+    const float* gradOutput,
+    bool generalized,
+    float* grad1,
+    float* grad2,
+    cudaStream_t stream);
+
+} // namespace detail
+} // namespace vision
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "flashlight/pkg/vision/dataset/backend/cuda/FusedAugmentationKernels.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "flashlight/fl/runtime/CUDAUtils.h"
+
+namespace fl {
+namespace pkg {
+namespace vision {
+namespace detail {
+
+namespace {
+
+constexpr int kBlockSize = 256;
+constexpr size_t kMaxBlocks = 65535;
+
+template <typename T>
+__global__ void fusedAugmentKernel(
+    const FusedAugmentImage* images,
+    int B,
+    int C,
+    int size,
+    const float* mean,
+    const float* std,
+    FusedAugmentMix mix,
+    float* out) {
+  const size_t n = static_cast<size_t>(size) * size * C * B;
+  for (size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+       i < n;
+       i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    out[i] = fusedAugmentElement<T>(images, B, C, size, mean, std, mix, i);
+  }
+}
+
+} // namespace
+
+void fusedAugmentCuda(
+    const FusedAugmentImage* images,
+    int B,
+    int C,
+    int size,
+    const float* mean,
+    const float* std,
+    FusedAugmentMix mix,
+    bool floatPixels,
+    float* out,
+    cudaStream_t stream) {
+  const size_t n = static_cast<size_t>(size) * size * C * B;
+  if (n == 0) {
+    return;
+  }
+  const int blocks = std::min(kMaxBlocks, (n + kBlockSize - 1) / kBlockSize);
+  if (floatPixels) {
+    fusedAugmentKernel<float><<<blocks, kBlockSize, 0, stream>>>(
+        images, B, C, size, mean, std, mix, out);
+  } else {
+    fusedAugmentKernel<uint8_t><<<blocks, kBlockSize, 0, stream>>>(
+        images, B, C, size, mean, std, mix, out);
+  }
+  FL_CUDA_CHECK(cudaGetLastError());
+}
+
+} // namespace detail
+} // namespace vision
+} // namespace pkg
+} // namespace fl
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include "flashlight/pkg/vision/dataset/backend/FusedAugmentationPixel.h"
+
+namespace fl {
+namespace pkg {
+namespace vision {
+namespace detail {
+
+/**
+ * Computes the size x size x C x B batch of the fused augmentation in a single
+ * launch, with a thread per output element. The images, mean and std are in
+ * device memory, and the pixels are uint8 or float.
+ */
+void fusedAugmentCuda(
+    const FusedAugmentImage* images,
+    int B,
+    int C,
+    int size,
+    const float* mean,
+    const float* std,
+    FusedAugmentMix mix,
+    bool floatPixels,
+    float* out,
+    cudaStream_t stream);
+
+} // namespace detail
+} // namespace vision
+} // namespace pkg
+} // namespace fl
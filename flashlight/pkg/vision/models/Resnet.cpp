@@ -187,7 +187,8 @@ ResNetStage::ResNetStage(
     add(ResNetBlock(outC, outC));
   }
 }
-std::shared_ptr<Sequential> resnet34() {
+std::shared_ptr<Sequential> resnet34(
+    MemoryFormat format /* = MemoryFormat::WHCN */) {
   auto model = std::make_shared<Sequential>();
   // conv1 -> 244x244x3 -> 112x112x64
   model->add(ConvBnAct(3, 64, 7, 7, 2, 2));
@@ -204,12 +205,15 @@ std::shared_ptr<Sequential> resnet34() {
   // pool 7x7x512 -> 1x1x512
   model->add(Pool2D(7, 7, 1, 1, 0, 0, fl::PoolingMode::AVG_EXCLUDE_PADDING));
 
+  // the 1 x 1 pooled images are viewed the same in any format
   model->add(View({512, -1}));
   model->add(Linear(512, 1000));
+  setMemoryFormat(*model, format);
   return model;
 };
 
-std::shared_ptr<Sequential> resnet50() {
+std::shared_ptr<Sequential> resnet50(
+    MemoryFormat format /* = MemoryFormat::WHCN */) {
   auto model = std::make_shared<Sequential>();
   // conv1 -> 244x244x3 -> 112x112x64
   model->add(ConvBnAct(3, 64, 7, 7, 2, 2));
@@ -228,6 +232,7 @@ std::shared_ptr<Sequential> resnet50() {
 
   model->add(View({512 * 4, -1}));
   model->add(Linear(512 * 4, 1000));
+  setMemoryFormat(*model, format);
   return model;
 }
 
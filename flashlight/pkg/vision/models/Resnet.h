@@ -91,8 +91,15 @@ class ResNetStage : public fl::Sequential {
   FL_SAVE_LOAD_WITH_BASE(fl::Sequential)
 };
 
-std::shared_ptr<Sequential> resnet34();
-std::shared_ptr<Sequential> resnet50();
+/**
+ * ResNets for 224 x 224 images. Channels-last `MemoryFormat::CWHN` models,
+ * e.g. for tensor-core convolutions in half precision, take inputs of shape
+ * [3, 224, 224, N]. See `fl::setMemoryFormat`.
+ */
+std::shared_ptr<Sequential> resnet34(
+    MemoryFormat format = MemoryFormat::WHCN);
+std::shared_ptr<Sequential> resnet50(
+    MemoryFormat format = MemoryFormat::WHCN);
 
 } // namespace vision
 } // namespace pkg
@@ -64,18 +64,34 @@ ViT::ViT(
 std::vector<fl::Variable> ViT::forward(
     const std::vector<fl::Variable>& inputs) {
   // Patching
-  auto output = patchEmbedding_->forward(inputs[0]); // H x W x C x B
-  output = moddims(output, {-1, 1, 0, 0}); // T x 1 x C x B
-  output = reorder(output, {2, 0, 3, 1}); // C x T x B x 1
-  output = moddims(output, {0, 0, 0}); // C x T x B
+  auto output = patchEmbedding_->forward(inputs[0]); // W x H x C x B
+  output = moddims(output, {-1, 0, 0}); // T x C x B
+  output = reorder(output, {1, 0, 2}); // C x T x B
   auto B = output.dim(2);
 
+  Variable clsToken, posEmb;
+  if (train_) {
+    clsToken = tile(params_[0], {1, 1, B}).astype(output.type()); // C x 1 x B
+    posEmb = tile(params_[1], {1, 1, B}).astype(output.type());
+  } else {
+    // reused while the batch size and type are the same
+    if (evalClsToken_.isEmpty() || evalClsToken_.dim(2) != B ||
+        evalClsToken_.type() != output.type()) {
+      evalClsToken_ = Variable(
+          fl::tile(params_[0].tensor(), {1, 1, B}).astype(output.type()),
+          false);
+      evalPosEmb_ = Variable(
+          fl::tile(params_[1].tensor(), {1, 1, B}).astype(output.type()),
+          false);
+    }
+    clsToken = evalClsToken_;
+    posEmb = evalPosEmb_;
+  }
+
   // Prepending the class token
-  auto clsToken = tile(params_[0], {1, 1, B}).astype(output.type()); // C x 1 x B
   output = concatenate({clsToken, output}, 1);
 
   // Positional embedding
-  auto posEmb = tile(params_[1], {1, 1, B}).astype(output.type());
   output = output + posEmb;
   if (train_) {
     output = dropout(output, pDropout_);
@@ -94,6 +110,24 @@ std::vector<fl::Variable> ViT::forward(
   return {output};
 }
 
+void ViT::train() {
+  Container::train();
+  evalClsToken_ = Variable();
+  evalPosEmb_ = Variable();
+}
+
+void ViT::eval() {
+  Container::eval();
+  evalClsToken_ = Variable();
+  evalPosEmb_ = Variable();
+}
+
+void ViT::setParams(const Variable& var, int position) {
+  Container::setParams(var, position);
+  evalClsToken_ = Variable();
+  evalPosEmb_ = Variable();
+}
+
 std::string ViT::prettyString() const {
   std::ostringstream ss;
   ss << "ViT (" << nClasses_ << " classes) with " << nLayers_
@@ -47,6 +47,10 @@ class ViT : public fl::Container {
   std::shared_ptr<Linear> linearOut_;
   std::shared_ptr<LayerNorm> ln_;
 
+  // the class token and positional embedding, tiled to the batch size and
+  // cast to the type of the last input in eval mode, not serialized
+  Variable evalClsToken_, evalPosEmb_;
+
   ViT() = default;
 
  public:
@@ -61,6 +65,22 @@ class ViT : public fl::Container {
   std::vector<fl::Variable> forward(
       const std::vector<fl::Variable>& inputs) override;
 
+  /**
+   * Switches to train mode, releasing the embeddings tiled in eval mode.
+   */
+  void train() override;
+
+  /**
+   * Switches to eval mode, in which the class token and positional embedding
+   * are tiled once per batch size rather than at each forward, and the
+   * transformers pack their projections, see `VisionTransformer::eval`. These
+   * are constants: in eval mode, gradients reach the input but not all the
+   * parameters.
+   */
+  void eval() override;
+
+  void setParams(const Variable& var, int position) override;
+
   std::string prettyString() const override;
 };
 
@@ -7,8 +7,14 @@
 
 #include "flashlight/pkg/vision/nn/FrozenBatchNorm.h"
 
+#include <stdexcept>
+#include <typeinfo>
+
 #include "flashlight/fl/autograd/Functions.h"
 #include "flashlight/fl/nn/Init.h"
+#include "flashlight/fl/nn/modules/Container.h"
+#include "flashlight/fl/nn/modules/Conv2D.h"
+#include "flashlight/fl/nn/modules/Identity.h"
 
 namespace fl {
 
@@ -41,8 +47,12 @@ FrozenBatchNorm::FrozenBatchNorm(
 Variable FrozenBatchNorm::forward(const Variable& input) {
   auto scale = params_[0] / fl::sqrt(runningVar_ + epsilon_);
   auto bias = params_[1] - runningMean_ * scale;
-  bias = fl::moddims(bias, {1, 1, bias.dim(0), 1}).astype(input.type());
-  scale = fl::moddims(scale, {1, 1, scale.dim(0), 1}).astype(input.type());
+  // the features are along axis 2, or 0 for channels-last images
+  const bool channelsLast = featAxis_.size() == 1 && featAxis_[0] == 0;
+  const Shape affineShape = channelsLast ? Shape({featSize_, 1, 1, 1})
+                                         : Shape({1, 1, featSize_, 1});
+  bias = fl::moddims(bias, affineShape).astype(input.type());
+  scale = fl::moddims(scale, affineShape).astype(input.type());
   return (input * fl::tileAs(scale, input)) + fl::tileAs(bias, input);
 }
 
@@ -74,4 +84,40 @@ std::string FrozenBatchNorm::prettyString() const {
   return ss.str();
 }
 
+int foldFrozenBatchNorm(Module& module) {
+  auto* container = dynamic_cast<Container*>(&module);
+  if (!container) {
+    return 0;
+  }
+  int folded = 0;
+  auto modules = container->modules();
+  for (int i = 0; i < modules.size(); ++i) {
+    folded += foldFrozenBatchNorm(*modules[i]);
+    auto* batchNorm = dynamic_cast<FrozenBatchNorm*>(modules[i].get());
+    if (!batchNorm || i == 0 || typeid(*modules[i - 1]) != typeid(Conv2D)) {
+      continue;
+    }
+    auto& conv = static_cast<Conv2D&>(*modules[i - 1]);
+    const int channelAxis =
+        conv.getMemoryFormat() == MemoryFormat::CWHN ? 0 : 2;
+    const auto featAxis = batchNorm->getFeatAxis();
+    if (featAxis.size() != 1 || featAxis[0] != channelAxis) {
+      continue;
+    }
+    Tensor scale, shift;
+    try {
+      batchNorm->getInferenceAffine(scale, shift);
+    } catch (const std::invalid_argument&) {
+      // no running statistics
+      continue;
+    }
+    conv.foldAffine(scale, shift);
+    modules[i] = std::make_shared<Identity>();
+    ++folded;
+  }
+  // also refreshes the parameters of the container from its modules
+  container->setModules(modules);
+  return folded;
+}
+
 } // namespace fl
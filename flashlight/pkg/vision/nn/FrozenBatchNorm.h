@@ -100,6 +100,25 @@ class FrozenBatchNorm : public BatchNorm {
   std::string prettyString() const override;
 };
 
+/**
+ * Folds each `FrozenBatchNorm` which immediately follows a `Conv2D` in a
+ * container into the weights and bias of the convolution, in place, since its
+ * statistics and affine parameters never change, and replaces it by an
+ * `Identity`, such that containers which index their modules, e.g. residual
+ * blocks, still compute the same function. Nested containers are folded as
+ * well.
+ *
+ * Unlike `fl::optimizeForInference`, the convolutions are left trainable, and
+ * the module can be trained as before, e.g. with a backbone of
+ * `FrozenBatchNorm`s, without their scale and shift passes over the
+ * activations. The folded modules are not restored, and parameters of the
+ * module should be fetched again, e.g. to build optimizers.
+ *
+ * @param module the module to fold
+ * @return the number of folded `FrozenBatchNorm`s
+ */
+int foldFrozenBatchNorm(Module& module);
+
 } // namespace fl
 
 CEREAL_REGISTER_TYPE(fl::FrozenBatchNorm)
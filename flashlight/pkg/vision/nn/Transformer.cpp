@@ -60,24 +60,30 @@ fl::Variable transformerMultiheadAttention(
   int32_t tgtLen = query.dim(2);
   int32_t srcLen = key.dim(2);
 
-  auto q = moddims(query, {headDim, nHead, bsz, tgtLen});
-  auto v = moddims(value, {headDim, nHead, bsz, srcLen});
-  auto k = moddims(key, {headDim, nHead, bsz, srcLen});
-  // Reorder so that the "Sequence" is along the first dimension,
-  // the embedding is along the zeroth dimension
-  q = reorder(q, {0, 3, 1, 2});
-  v = reorder(v, {0, 3, 1, 2});
-  k = reorder(k, {0, 3, 1, 2});
-
-  auto scores = matmulTN(q, k);
-
+  // Reorder so that the "Sequence" is along the first dimension, and
+  // sequences of all heads and samples along the last
+  auto q = moddims(
+      reorder(moddims(query, {headDim, nHead, bsz, tgtLen}), {3, 0, 1, 2}),
+      {tgtLen, headDim, nHead * bsz});
+  auto v = moddims(
+      reorder(moddims(value, {headDim, nHead, bsz, srcLen}), {3, 0, 1, 2}),
+      {srcLen, headDim, nHead * bsz});
+  auto k = moddims(
+      reorder(moddims(key, {headDim, nHead, bsz, srcLen}), {3, 0, 1, 2}),
+      {srcLen, headDim, nHead * bsz});
+
+  fl::Variable mask;
   if (!keyPaddingMask.isEmpty()) {
-    scores = scores +
-        tileAs(moddims(log(keyPaddingMask), {1, srcLen, 1, bsz}), scores);
+    mask = moddims(
+        tileAs(
+            moddims(log(keyPaddingMask), {1, srcLen, 1, bsz}),
+            {1, srcLen, nHead, bsz}),
+        {1, srcLen, nHead * bsz});
   }
 
-  auto attn = dropout(softmax(scores, 1), pDropout);
-  auto result = matmulNT(attn.astype(v.type()), v);
+  // the query is already scaled
+  auto result = scaledDotProductAttention(
+      q, k, v, mask, pDropout, /* scale = */ 1.0);
   result = moddims(result, {tgtLen, modelDim, bsz});
   result = reorder(result, {1, 2, 0});
   return result;
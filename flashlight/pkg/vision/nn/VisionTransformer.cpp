@@ -10,6 +10,7 @@
 #include <cmath>
 
 #include "flashlight/fl/autograd/Functions.h"
+#include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Random.h"
 
 namespace fl {
@@ -73,13 +74,45 @@ Variable VisionTransformer::mlp(const Variable& input) {
   return output;
 }
 
+std::vector<Variable> VisionTransformer::projectQkv(const Variable& x) {
+  if (train_) {
+    return {
+        transpose((*wq_)(x), {1, 0, 2}),
+        transpose((*wk_)(x), {1, 0, 2}),
+        transpose((*wv_)(x), {1, 0, 2})};
+  }
+
+  // a single matmul of the three projections, whose weights are packed, in
+  // the type of the input, once rather than cast at each forward
+  if (qkvWeight_.isEmpty() || qkvWeight_.type() != x.type()) {
+    auto packed = [&x](const std::vector<Tensor>& tensors) {
+      return Variable(fl::concatenate(tensors, 0).astype(x.type()), false);
+    };
+    qkvWeight_ = packed({
+        wq_->param(0).tensor(),
+        wk_->param(0).tensor(),
+        wv_->param(0).tensor()});
+    qkvBias_ = packed({
+        wq_->param(1).tensor(),
+        wk_->param(1).tensor(),
+        wv_->param(1).tensor()});
+  }
+  const int size = headDim_ * nHeads_;
+  auto qkv = transpose(linear(x, qkvWeight_, qkvBias_), {1, 0, 2});
+  return {
+      qkv(fl::span, fl::range(0, size)),
+      qkv(fl::span, fl::range(size, 2 * size)),
+      qkv(fl::span, fl::range(2 * size, 3 * size))};
+}
+
 Variable VisionTransformer::selfAttention(const Variable& x) {
   // x - C x T x B
   double pDrop = train_ ? pDropout_ : 0.0;
 
-  auto q = transpose((*wq_)(x), {1, 0, 2});
-  auto k = transpose((*wk_)(x), {1, 0, 2});
-  auto v = transpose((*wv_)(x), {1, 0, 2});
+  auto qkv = projectQkv(x);
+  const auto& q = qkv[0];
+  const auto& k = qkv[1];
+  const auto& v = qkv[2];
 
   auto result = multiheadAttention(
       q,
@@ -136,6 +169,24 @@ std::vector<Variable> VisionTransformer::forward(
   return {x};
 }
 
+void VisionTransformer::train() {
+  Container::train();
+  qkvWeight_ = Variable();
+  qkvBias_ = Variable();
+}
+
+void VisionTransformer::eval() {
+  Container::eval();
+  qkvWeight_ = Variable();
+  qkvBias_ = Variable();
+}
+
+void VisionTransformer::setParams(const Variable& var, int position) {
+  Container::setParams(var, position);
+  qkvWeight_ = Variable();
+  qkvBias_ = Variable();
+}
+
 std::string VisionTransformer::prettyString() const {
   std::ostringstream ss;
   ss << "VisionTransformer (nHeads: " << nHeads_ << "), "
@@ -33,6 +33,21 @@ class VisionTransformer : public Container {
   std::vector<Variable> forward(const std::vector<Variable>& input) override;
   std::string prettyString() const override;
 
+  /**
+   * Switches to train mode, releasing the packed inference weights.
+   */
+  void train() override;
+
+  /**
+   * Switches to eval mode, in which the query, key and value projections are
+   * computed by a single matmul of weights packed at the first forward. These
+   * are constants: in eval mode, gradients reach the input but not the
+   * weights of the projections.
+   */
+  void eval() override;
+
+  void setParams(const Variable& var, int position) override;
+
  private:
   int32_t modelDim_;
   int32_t headDim_;
@@ -44,10 +59,13 @@ class VisionTransformer : public Container {
   std::shared_ptr<Linear> wq_, wk_, wv_;
   std::shared_ptr<Linear> wf_;
   std::shared_ptr<LayerNorm> norm1_, norm2_;
+  // the packed query, key and value projections of eval mode, not serialized
+  Variable qkvWeight_, qkvBias_;
 
   Variable gelu(const Variable& input);
   Variable mlp(const Variable& input);
   Variable selfAttention(const Variable& input);
+  std::vector<Variable> projectQkv(const Variable& input);
   Variable dropPath(const Variable& input);
 
   FL_SAVE_LOAD_WITH_BASE(
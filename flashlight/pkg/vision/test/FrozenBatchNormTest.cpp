@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/autograd/autograd.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Random.h"
+#include "flashlight/pkg/vision/models/ResnetFrozenBatchNorm.h"
+#include "flashlight/pkg/vision/nn/FrozenBatchNorm.h"
+
+using namespace fl;
+using namespace fl::pkg::vision;
+
+namespace {
+
+void setRandomStatistics(FrozenBatchNorm& batchNorm, int size) {
+  batchNorm.setRunningMean(Variable(fl::randn({size}), false));
+  batchNorm.setRunningVar(Variable(fl::rand({size}) + 0.5, false));
+  batchNorm.setParams(Variable(fl::randn({size}), false), 0);
+  batchNorm.setParams(Variable(fl::randn({size}), false), 1);
+}
+
+} // namespace
+
+TEST(FrozenBatchNormTest, Fold) {
+  // with a downsampling shortcut
+  ResNetBottleneckBlockFrozenBatchNorm block(8, 2, 2);
+  const std::vector<std::pair<ModulePtr, int>> batchNorms = {
+      {block.module(1), 2},
+      {block.module(4), 2},
+      {block.module(7), 8},
+      {std::dynamic_pointer_cast<Sequential>(block.module(9))->module(1), 8}};
+  for (const auto& [module, size] : batchNorms) {
+    setRandomStatistics(static_cast<FrozenBatchNorm&>(*module), size);
+  }
+  block.train();
+  auto input = Variable(fl::rand({6, 6, 8, 2}), false);
+  auto expected = block.forward({input}).front().tensor();
+
+  ASSERT_EQ(foldFrozenBatchNorm(block), 4);
+  ASSERT_EQ(block.modules().size(), 10);
+  for (const auto& param : block.params()) {
+    ASSERT_TRUE(param.isCalcGrad());
+  }
+  auto output = block.forward({input}).front();
+  ASSERT_TRUE(allClose(output.tensor(), expected, 1e-4));
+
+  // the convolutions are still trained
+  fl::sum(output, {0, 1, 2, 3}).backward();
+  ASSERT_TRUE(block.module(0)->param(0).isGradAvailable());
+  ASSERT_EQ(foldFrozenBatchNorm(block), 0);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
@@ -9,6 +9,7 @@
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Random.h"
 #include "flashlight/pkg/vision/nn/PositionalEmbeddingSine.h"
+#include "flashlight/pkg/vision/nn/VisionTransformer.h"
 
 #include <gtest/gtest.h>
 
@@ -268,3 +269,22 @@ TEST(Tranformer, Masked) {
       maskPos};
   auto maskOutput = tr(maskInput)[0];
 }
+
+TEST(Tranformer, VisionTransformerEval) {
+  const int C = 16, T = 5, B = 3, nHeads = 4;
+  VisionTransformer vit(C, C / nHeads, 32, nHeads, 0, 0);
+  auto input = Variable(fl::rand({C, T, B}), false);
+  vit.train();
+  auto expected = vit.forward({input})[0].tensor();
+
+  // with packed projections
+  vit.eval();
+  ASSERT_TRUE(allClose(vit.forward({input})[0].tensor(), expected, 1e-5));
+  ASSERT_TRUE(allClose(vit.forward({input})[0].tensor(), expected, 1e-5));
+
+  // which are packed again with new weights
+  vit.setParams(Variable(fl::rand({C, C}), true), 4);
+  auto output = vit.forward({input})[0].tensor();
+  vit.train();
+  ASSERT_TRUE(allClose(vit.forward({input})[0].tensor(), output, 1e-5));
+}
@@ -5,8 +5,11 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include "flashlight/fl/tensor/Random.h"
 #include "flashlight/fl/tensor/TensorBase.h"
 #include "flashlight/pkg/vision/dataset/CocoTransforms.h"
+#include "flashlight/pkg/vision/dataset/FusedAugmentation.h"
+#include "flashlight/pkg/vision/dataset/Transforms.h"
 
 #include <gtest/gtest.h>
 
@@ -96,3 +99,52 @@ TEST(Crop, CropClip) {
   ASSERT_TRUE(allClose(expOut, outBoxes, 1e-5));
   ASSERT_TRUE(allClose(expClassOut, outClasses, 1e-5));
 }
+
+TEST(FusedAugmentation, MatchesTransforms) {
+  const int size = 8;
+  const std::vector<float> mean = {0.4, 0.5, 0.6};
+  const std::vector<float> std = {0.2, 0.25, 0.3};
+  std::vector<Tensor> images = {
+      fl::rand({size, size, 3}) * 255,
+      fl::rand({size, size, 3}) * 255};
+  for (auto& image : images) {
+    image = image.astype(fl::dtype::u8);
+  }
+  auto normalize = fl::pkg::vision::normalizeImage(mean, std);
+  auto expected = fl::concatenate(
+      {fl::reshape(normalize(images[0]), {size, size, 3, 1}),
+       fl::reshape(normalize(images[1]), {size, size, 3, 1})},
+      3);
+
+  // a crop of the whole image at its size is the identity
+  const std::vector<fl::pkg::vision::ResizeCropFlipParams> params = {
+      {0, 0, size, size, false}, {0, 0, size, size, false}};
+  auto out =
+      fl::pkg::vision::fusedAugmentBatch(images, params, size, mean, std);
+  ASSERT_EQ(out.shape(), Shape({size, size, 3, 2}));
+  ASSERT_TRUE(allClose(out, expected, 1e-5));
+
+  const std::vector<fl::pkg::vision::ResizeCropFlipParams> flipParams = {
+      {0, 0, size, size, true}, {0, 0, size, size, true}};
+  auto flipped =
+      fl::pkg::vision::fusedAugmentBatch(images, flipParams, size, mean, std);
+  ASSERT_TRUE(allClose(flipped, fl::flip(expected, 0), 1e-5));
+
+  fl::pkg::vision::BatchMix mix;
+  mix.mixupLambda = 0.3;
+  auto mixed =
+      fl::pkg::vision::fusedAugmentBatch(images, params, size, mean, std, mix);
+  auto target = Tensor::fromVector<int>({2}, {0, 1});
+  auto expectedMixed = fl::pkg::vision::mixupBatch(0.3, expected, target, 2, 0);
+  ASSERT_TRUE(allClose(mixed, expectedMixed.first, 1e-5));
+}
+
+TEST(FusedAugmentation, InvalidCrop) {
+  std::vector<Tensor> images = {fl::full({4, 4, 3}, 1.)};
+  const std::vector<fl::pkg::vision::ResizeCropFlipParams> params = {
+      {2, 0, 4, 4, false}};
+  ASSERT_THROW(
+      fl::pkg::vision::fusedAugmentBatch(
+          images, params, 4, {0, 0, 0}, {1, 1, 1}),
+      std::invalid_argument);
+}
@@ -9,6 +9,8 @@
 
 #include <gtest/gtest.h>
 
+#include <random>
+
 using namespace fl::lib::set;
 
 TEST(HungarianTest, DiagnalAssignments) {
@@ -215,3 +217,36 @@ TEST(HungarianTest, NonSquare3) {
     EXPECT_EQ(colIdxs[i], colIdxs[i]) << "Assignment differs at index " << i;
   }
 }
+
+TEST(HungarianTest, LinearSumAssignment) {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dist(0, 9);
+  for (int N = 1; N < 8; N++) {
+    for (int M = 1; M <= N; M++) {
+      std::vector<float> costsVec(M * N);
+      for (auto& cost : costsVec) {
+        cost = dist(gen);
+      }
+      std::vector<int> rowIdxs(M);
+      std::vector<int> colIdxs(M);
+      linearSumAssignment(
+          costsVec.data(), rowIdxs.data(), colIdxs.data(), M, N);
+
+      // the same total cost as Munkres, which modifies the costs
+      auto costsCopy = costsVec;
+      std::vector<int> expRowIdxs(M);
+      std::vector<int> expColIdxs(M);
+      hungarian(costsCopy.data(), expRowIdxs.data(), expColIdxs.data(), M, N);
+      float total = 0;
+      float expTotal = 0;
+      std::vector<int> assigned(N);
+      for (int r = 0; r < M; r++) {
+        EXPECT_EQ(rowIdxs[r], r);
+        EXPECT_EQ(assigned[colIdxs[r]]++, 0) << "Column assigned twice";
+        total += costsVec[colIdxs[r] * M + rowIdxs[r]];
+        expTotal += costsVec[expColIdxs[r] * M + expRowIdxs[r]];
+      }
+      EXPECT_EQ(total, expTotal) << "M = " << M << ", N = " << N;
+    }
+  }
+}
@@ -8,6 +8,7 @@
 #include "flashlight/pkg/vision/dataset/BoxUtils.h"
 #include "flashlight/fl/tensor/Index.h"
 #include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/Random.h"
 
 #include <gtest/gtest.h>
 
@@ -157,6 +158,48 @@ TEST(BoxUtils, GIOU) {
       result(0, 0).tensor().scalar<float>(), result(1, 0).scalar<float>());
 }
 
+// The float boxes go through the pairwise kernels, and the double ones through
+// the cartesian product of the two sets
+TEST(BoxUtils, GIOUPairwiseKernels) {
+  auto makeBoxes = [](int n) {
+    auto corners = fl::rand({2, n, 2});
+    auto sizes = fl::rand({2, n, 2}) + 0.1;
+    return fl::concatenate(0, corners, corners + sizes);
+  };
+  auto bboxes1 = makeBoxes(3);
+  auto bboxes2 = makeBoxes(4);
+
+  fl::Variable in1(bboxes1, true);
+  fl::Variable in2(bboxes2, true);
+  auto result = generalizedBoxIou(in1, in2);
+  fl::Variable in1Double(bboxes1.astype(fl::dtype::f64), true);
+  fl::Variable in2Double(bboxes2.astype(fl::dtype::f64), true);
+  auto expected = generalizedBoxIou(in1Double, in2Double);
+  ASSERT_EQ(result.shape(), expected.shape());
+  EXPECT_TRUE(fl::allClose(
+      result.tensor(), expected.tensor().astype(fl::dtype::f32), 1e-5));
+
+  auto gradOutput = fl::rand(result.shape());
+  result.backward(fl::Variable(gradOutput, false));
+  expected.backward(fl::Variable(gradOutput.astype(fl::dtype::f64), false));
+  EXPECT_TRUE(fl::allClose(
+      in1.grad().tensor(),
+      in1Double.grad().tensor().astype(fl::dtype::f32),
+      1e-4));
+  EXPECT_TRUE(fl::allClose(
+      in2.grad().tensor(),
+      in2Double.grad().tensor().astype(fl::dtype::f32),
+      1e-4));
+
+  fl::Tensor iou, uni;
+  std::tie(iou, uni) = boxIou(bboxes1, bboxes2);
+  fl::Tensor expIou, expUni;
+  std::tie(expIou, expUni) = boxIou(
+      bboxes1.astype(fl::dtype::f64), bboxes2.astype(fl::dtype::f64));
+  EXPECT_TRUE(fl::allClose(iou, expIou.astype(fl::dtype::f32), 1e-5));
+  EXPECT_TRUE(fl::allClose(uni, expUni.astype(fl::dtype::f32), 1e-5));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   fl::init();
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/common/Filesystem.h"
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/pkg/vision/dataset/Coco.h"
+#include "flashlight/pkg/vision/dataset/CocoIndex.h"
+
+using namespace fl;
+using namespace fl::pkg::vision;
+
+TEST(CocoIndex, Compile) {
+  const std::vector<std::string> lines = {
+      "/data/000000000009.jpg\t1 2 30 40 7\t5.5 6 70 80.25 12",
+      "/data/000000000025.jpg",
+      "/data/000000000030.jpg\t0 0 10 10 1"};
+  const fs::path listPath = fs::temp_directory_path() / "coco.lst";
+  const fs::path indexPath = fs::temp_directory_path() / "coco.lstidx";
+  {
+    std::ofstream out(listPath);
+    for (const auto& line : lines) {
+      out << line << "\n";
+    }
+  }
+  ASSERT_EQ(CocoIndex::compile(listPath, indexPath), lines.size());
+  ASSERT_TRUE(CocoIndex::isCocoIndex(indexPath));
+  ASSERT_FALSE(CocoIndex::isCocoIndex(listPath));
+
+  CocoIndex index(indexPath);
+  ASSERT_EQ(index.size(), lines.size());
+  for (int i = 0; i < lines.size(); ++i) {
+    auto expected = parseCocoListLine(lines[i]);
+    ASSERT_EQ(index.filepath(i), expected.filepath);
+    ASSERT_EQ(index.numBoxes(i), expected.classes.size());
+    ASSERT_EQ(
+        std::vector<float>(
+            index.boxes(i), index.boxes(i) + 4 * index.numBoxes(i)),
+        expected.bboxes);
+    ASSERT_EQ(
+        std::vector<float>(
+            index.classes(i), index.classes(i) + index.numBoxes(i)),
+        expected.classes);
+  }
+  fs::remove(listPath);
+  fs::remove(indexPath);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flashlight/fl/tensor/Init.h"
+#include "flashlight/fl/tensor/TensorBase.h"
+#include "flashlight/pkg/vision/dataset/DistributedDataset.h"
+
+using namespace fl;
+using namespace fl::pkg::vision;
+
+namespace {
+
+// The samples of the batches of a rank
+std::vector<int> readSamples(const DistributedDataset& ds) {
+  std::vector<int> samples;
+  for (int64_t i = 0; i < ds.size(); ++i) {
+    auto batch = ds.get(i)[0].toHostVector<int>();
+    samples.insert(samples.end(), batch.begin(), batch.end());
+  }
+  return samples;
+}
+
+} // namespace
+
+TEST(IndexPermutation, Bijection) {
+  for (int64_t size : {1, 2, 3, 17, 1000, 4097}) {
+    IndexPermutation permutation(size, 7);
+    std::vector<bool> seen(size, false);
+    for (int64_t i = 0; i < size; ++i) {
+      const auto j = permutation(i);
+      ASSERT_GE(j, 0);
+      ASSERT_LT(j, size);
+      ASSERT_FALSE(seen[j]);
+      seen[j] = true;
+      ASSERT_EQ(IndexPermutation(size, 7)(i), j);
+    }
+  }
+}
+
+TEST(DistributedDataset, Shards) {
+  const int numSamples = 23, worldSize = 3;
+  auto base = std::make_shared<TensorDataset>(std::vector<Tensor>{
+      fl::arange({numSamples}, 0, fl::dtype::s32)});
+  std::vector<std::shared_ptr<DistributedDataset>> shards;
+  for (int rank = 0; rank < worldSize; ++rank) {
+    shards.push_back(std::make_shared<DistributedDataset>(
+        base, rank, worldSize, 2, 1, 0, 0));
+  }
+
+  for (int epoch = 0; epoch < 2; ++epoch) {
+    std::vector<int> samples;
+    for (auto& shard : shards) {
+      shard->resample(epoch);
+      auto shardSamples = readSamples(*shard);
+      samples.insert(samples.end(), shardSamples.begin(), shardSamples.end());
+    }
+    // every sample once, in uneven shards
+    std::sort(samples.begin(), samples.end());
+    ASSERT_EQ(samples.size(), numSamples);
+    for (int i = 0; i < numSamples; ++i) {
+      ASSERT_EQ(samples[i], i);
+    }
+  }
+
+  // resuming in the middle of an epoch
+  auto& shard = *shards[1];
+  shard.resample(1);
+  auto epochSamples = readSamples(shard);
+  ASSERT_FALSE(std::is_sorted(epochSamples.begin(), epochSamples.end()));
+  shard.resample(1, 2);
+  ASSERT_EQ(shard.size(), 2);
+  auto resumed = readSamples(shard);
+  ASSERT_EQ(
+      resumed, std::vector<int>(epochSamples.begin() + 4, epochSamples.end()));
+  ASSERT_THROW(shard.resample(1, 5), std::invalid_argument);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  fl::init();
+  return RUN_ALL_TESTS();
+}